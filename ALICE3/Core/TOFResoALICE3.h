@@ -73,14 +73,61 @@ float TOFResoALICE3Param(const float& momentum, const float& momentumError, cons
   return sqrt(etexp * etexp + parameters[0] * parameters[0] + evtimereso * evtimereso);
 }
 
+/// Mass independent terms of the TOFResoALICE3Param resolution of a track, computed once for all the mass hypotheses
+struct TOFResoALICE3TrackCache {
+  float momentum = 0.f;    ///< Momentum of the track
+  float p2 = 0.f;          ///< Squared momentum
+  float Lc = 0.f;          ///< Track length over the speed of light
+  float ep = 0.f;          ///< Momentum error times the momentum
+  float paramReso2 = 0.f;  ///< Squared time resolution parameter
+  float evtimereso2 = 0.f; ///< Squared event time resolution
+
+  /// Fills the cache from the momentum, its uncertainty, the event time resolution and the track length
+  void Set(const float momentum, const float momentumError, const float evtimereso, const float length, const Parameters& parameters)
+  {
+    this->momentum = momentum;
+    p2 = momentum * momentum;
+    Lc = length / 0.0299792458f;
+    ep = momentumError * momentum;
+    paramReso2 = parameters[0] * parameters[0];
+    evtimereso2 = evtimereso * evtimereso;
+  }
+
+  /// Fills the cache for a track, with the momentum uncertainty from the track covariance
+  template <typename T>
+  void Set(const T& track, const Parameters& parameters)
+  {
+    const float BETA = tan(0.25f * static_cast<float>(M_PI) - 0.5f * atan(track.tgl()));
+    const float sigmaP = sqrt(track.pt() * track.pt() * track.sigma1Pt() * track.sigma1Pt() + (BETA * BETA - 1.f) / (BETA * (BETA * BETA + 1.f)) * (track.tgl() / sqrt(track.tgl() * track.tgl() + 1.f) - 1.f) * track.sigmaTgl() * track.sigmaTgl());
+    // const float sigmaP = std::sqrt( track.getSigma1Pt2() ) * track.pt();
+    Set(track.p(), sigmaP, track.collision().collisionTimeRes() * 1000.f, track.length(), parameters);
+    // Set(track.p(), track.sigma1Pt(), collision.collisionTimeRes() * 1000.f, track.length(), parameters);
+  }
+};
+
+/// Resolution of TOFResoALICE3Param for the mass hypothesis, from the mass independent terms of the track
+inline float TOFResoALICE3Param(const TOFResoALICE3TrackCache& cache, const float mass)
+{
+  if (cache.momentum <= 0) {
+    return -999.f;
+  }
+  const float mass2 = mass * mass;
+  const float etexp = cache.Lc * mass2 / cache.p2 / sqrt(mass2 + cache.p2) * cache.ep;
+  return sqrt(etexp * etexp + cache.paramReso2 + cache.evtimereso2);
+}
+
+template <o2::track::PID::ID id>
+float TOFResoALICE3ParamTrack(const TOFResoALICE3TrackCache& cache)
+{
+  return TOFResoALICE3Param(cache, o2::track::pid_constants::sMasses2Z[id]);
+}
+
 template <o2::track::PID::ID id, typename T>
 float TOFResoALICE3ParamTrack(const T& track, const Parameters& parameters)
 {
-  const float BETA = tan(0.25f * static_cast<float>(M_PI) - 0.5f * atan(track.tgl()));
-  const float sigmaP = sqrt(track.pt() * track.pt() * track.sigma1Pt() * track.sigma1Pt() + (BETA * BETA - 1.f) / (BETA * (BETA * BETA + 1.f)) * (track.tgl() / sqrt(track.tgl() * track.tgl() + 1.f) - 1.f) * track.sigmaTgl() * track.sigmaTgl());
-  // const float sigmaP = std::sqrt( track.getSigma1Pt2() ) * track.pt();
-  return TOFResoALICE3Param(track.p(), sigmaP, track.collision().collisionTimeRes() * 1000.f, track.length(), o2::track::pid_constants::sMasses2Z[id], parameters);
-  // return TOFResoALICE3Param(track.p(), track.sigma1Pt(), collision.collisionTimeRes() * 1000.f, track.length(), o2::track::pid_constants::sMasses[id], parameters);
+  TOFResoALICE3TrackCache cache;
+  cache.Set(track, parameters);
+  return TOFResoALICE3ParamTrack<id>(cache);
 }
 
 } // namespace o2::pid::tof
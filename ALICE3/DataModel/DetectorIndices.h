@@ -0,0 +1,51 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   DetectorIndices.h
+/// \brief  Index of the ALICE3 PID detector entries of each track
+///         One row per track, joinable with the tracks, produced by the alice3-detector-indices task. The index of
+///         a detector is -1 if the track has no entry in it.
+///
+
+#ifndef O2_ANALYSIS_ALICE3_DETECTORINDICES_H_
+#define O2_ANALYSIS_ALICE3_DETECTORINDICES_H_
+
+// O2 includes
+#include "Framework/AnalysisDataModel.h"
+#include "ALICE3/DataModel/ECAL.h"
+#include "ALICE3/DataModel/FTOF.h"
+#include "ALICE3/DataModel/MID.h"
+#include "ALICE3/DataModel/RICH.h"
+
+namespace o2::aod
+{
+namespace alice3detectors
+{
+DECLARE_SOA_INDEX_COLUMN(RICH, rich);   //! Index to the RICH entry of the track
+DECLARE_SOA_INDEX_COLUMN(FRICH, frich); //! Index to the forward RICH entry of the track
+DECLARE_SOA_INDEX_COLUMN(FTOF, ftof);   //! Index to the FTOF entry of the track
+DECLARE_SOA_INDEX_COLUMN(ECAL, ecal);   //! Index to the ECAL entry of the track
+DECLARE_SOA_INDEX_COLUMN(MID, mid);     //! Index to the MID entry of the track
+} // namespace alice3detectors
+
+DECLARE_SOA_TABLE(A3DetectorIndices, "AOD", "A3DETINDICES", //! Indices of the ALICE3 PID detector entries of the tracks
+                  alice3detectors::RICHId,
+                  alice3detectors::FRICHId,
+                  alice3detectors::FTOFId,
+                  alice3detectors::ECALId,
+                  alice3detectors::MIDId);
+
+using A3DetectorIndex = A3DetectorIndices::iterator;
+
+} // namespace o2::aod
+
+#endif // O2_ANALYSIS_ALICE3_DETECTORINDICES_H_
@@ -0,0 +1,95 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   alice3-detector-indices.cxx
+/// \brief  Task producing the index of the ALICE3 PID detector entries of each track.
+///         Each detector table is read once and its entries are scattered into a per-track array with the track
+///         index of the entry, so that the indices of all the detectors are built in one pass linear in the number
+///         of tracks and entries. The first entry of a track is kept if a detector has several.
+///
+
+#include <vector>
+
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/runDataProcessing.h"
+#include "ALICE3/DataModel/DetectorIndices.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct Alice3DetectorIndices {
+  Produces<aod::A3DetectorIndices> detectorIndices;
+
+  std::vector<int> richIndex;
+  std::vector<int> frichIndex;
+  std::vector<int> ftofIndex;
+  std::vector<int> ecalIndex;
+  std::vector<int> midIndex;
+
+  void init(InitContext&)
+  {
+    if (doprocessBarrel == doprocessAll) {
+      LOG(fatal) << "Enable exactly one of processBarrel and processAll";
+    }
+  }
+
+  /// Sets index[trackId] to the row of the first entry of each track in the detector table
+  template <typename T>
+  static void scatter(std::vector<int>& index, const int nTracks, const T& entries)
+  {
+    index.assign(nTracks, -1);
+    for (const auto& entry : entries) {
+      const int trackId = entry.trackId();
+      if (trackId >= 0 && trackId < nTracks && index[trackId] < 0) {
+        index[trackId] = entry.globalIndex();
+      }
+    }
+  }
+
+  void fillTable(const int nTracks)
+  {
+    detectorIndices.reserve(nTracks);
+    for (int i = 0; i < nTracks; i++) {
+      detectorIndices(richIndex[i], frichIndex[i], ftofIndex[i], ecalIndex[i], midIndex[i]);
+    }
+  }
+
+  void processBarrel(aod::Tracks const& tracks, aod::RICHs const& riches, aod::FRICHs const& friches, aod::FTOFs const& ftofs)
+  {
+    const int nTracks = tracks.size();
+    scatter(richIndex, nTracks, riches);
+    scatter(frichIndex, nTracks, friches);
+    scatter(ftofIndex, nTracks, ftofs);
+    ecalIndex.assign(nTracks, -1);
+    midIndex.assign(nTracks, -1);
+    fillTable(nTracks);
+  }
+  PROCESS_SWITCH(Alice3DetectorIndices, processBarrel, "Indices of the RICH, forward RICH and FTOF entries", true);
+
+  void processAll(aod::Tracks const& tracks, aod::RICHs const& riches, aod::FRICHs const& friches, aod::FTOFs const& ftofs, aod::ECALs const& ecals, aod::MIDs const& mids)
+  {
+    const int nTracks = tracks.size();
+    scatter(richIndex, nTracks, riches);
+    scatter(frichIndex, nTracks, friches);
+    scatter(ftofIndex, nTracks, ftofs);
+    scatter(ecalIndex, nTracks, ecals);
+    scatter(midIndex, nTracks, mids);
+    fillTable(nTracks);
+  }
+  PROCESS_SWITCH(Alice3DetectorIndices, processAll, "Indices of the RICH, forward RICH, FTOF, ECAL and MID entries", false);
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<Alice3DetectorIndices>(cfgc, TaskName{"alice3-detector-indices"})};
+}
@@ -25,6 +25,7 @@
 #include "ALICE3/Core/TOFResoALICE3.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Framework/RunningWorkflowInfo.h"
+#include "Common/Core/TableHelper.h"
 #include "Framework/StaticFor.h"
 
 using namespace o2;
@@ -48,15 +49,7 @@ struct ALICE3tofSignal { /// Task that produces the TOF signal from the trackTim
   void init(o2::framework::InitContext& initContext)
   {
     // Checking the tables are requested in the workflow and enabling them
-    auto& workflows = initContext.services().get<RunningWorkflowInfo const>();
-    for (DeviceSpec const& device : workflows.devices) {
-      for (auto const& input : device.inputs) {
-        const std::string table = "TOFSignal";
-        if (input.matcher.binding == table) {
-          enableTable = true;
-        }
-      }
-    }
+    enableTable = isTableRequiredInWorkflow(initContext, "TOFSignal");
   }
   using Trks = soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksCov>;
   void process(Trks const& tracks)
@@ -127,6 +120,17 @@ struct ALICE3pidTOFTask {
                                                                                                                                       track.length())) /
            sigma<id>(track);
   }
+  /// Fills the table of the mass hypothesis id, the resolution is evaluated once from the mass independent terms of the track
+  template <o2::track::PID::ID id, typename T>
+  void fillTable(T& table, Trks::iterator const& track, const o2::pid::tof::TOFResoALICE3TrackCache& cache, const float deltaTime)
+  {
+    const float expSigma = o2::pid::tof::TOFResoALICE3ParamTrack<id>(cache);
+    if (!track.hasTOF()) {
+      table(expSigma, -999.f);
+      return;
+    }
+    table(expSigma, (deltaTime - tof::ExpTimes<Trks::iterator, id>::ComputeExpectedTime(track.tofExpMom() / o2::pid::tof::kCSPEED, track.length())) / expSigma);
+  }
   void process(Trks const& tracks, Coll const&)
   {
     tablePIDEl.reserve(tracks.size());
@@ -138,16 +142,20 @@ struct ALICE3pidTOFTask {
     tablePIDTr.reserve(tracks.size());
     tablePIDHe.reserve(tracks.size());
     tablePIDAl.reserve(tracks.size());
+    o2::pid::tof::TOFResoALICE3TrackCache cache;
     for (auto const& trk : tracks) {
-      tablePIDEl(sigma<PID::Electron>(trk), nsigma<PID::Electron>(trk));
-      tablePIDMu(sigma<PID::Muon>(trk), nsigma<PID::Muon>(trk));
-      tablePIDPi(sigma<PID::Pion>(trk), nsigma<PID::Pion>(trk));
-      tablePIDKa(sigma<PID::Kaon>(trk), nsigma<PID::Kaon>(trk));
-      tablePIDPr(sigma<PID::Proton>(trk), nsigma<PID::Proton>(trk));
-      tablePIDDe(sigma<PID::Deuteron>(trk), nsigma<PID::Deuteron>(trk));
-      tablePIDTr(sigma<PID::Triton>(trk), nsigma<PID::Triton>(trk));
-      tablePIDHe(sigma<PID::Helium3>(trk), nsigma<PID::Helium3>(trk));
-      tablePIDAl(sigma<PID::Alpha>(trk), nsigma<PID::Alpha>(trk));
+      // the kinematics, the collision time and its resolution are read once for the 9 mass hypotheses
+      cache.Set(trk, resoParameters);
+      const float deltaTime = trk.hasTOF() ? (trk.trackTime() - trk.collision().collisionTime()) * 1000.f : 0.f;
+      fillTable<PID::Electron>(tablePIDEl, trk, cache, deltaTime);
+      fillTable<PID::Muon>(tablePIDMu, trk, cache, deltaTime);
+      fillTable<PID::Pion>(tablePIDPi, trk, cache, deltaTime);
+      fillTable<PID::Kaon>(tablePIDKa, trk, cache, deltaTime);
+      fillTable<PID::Proton>(tablePIDPr, trk, cache, deltaTime);
+      fillTable<PID::Deuteron>(tablePIDDe, trk, cache, deltaTime);
+      fillTable<PID::Triton>(tablePIDTr, trk, cache, deltaTime);
+      fillTable<PID::Helium3>(tablePIDHe, trk, cache, deltaTime);
+      fillTable<PID::Alpha>(tablePIDAl, trk, cache, deltaTime);
     }
   }
 };
@@ -19,6 +19,7 @@
 // O2 includes
 #include "Framework/AnalysisTask.h"
 #include "ALICE3/DataModel/ECAL.h"
+#include "ALICE3/DataModel/DetectorIndices.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "ReconstructionDataFormats/PID.h"
 #include "Framework/HistogramRegistry.h"
@@ -34,19 +35,16 @@ namespace o2::aod
 
 namespace indices
 {
-DECLARE_SOA_INDEX_COLUMN(Track, track);
 DECLARE_SOA_INDEX_COLUMN(ECAL, ecal);
 
 DECLARE_SOA_INDEX_COLUMN(McParticle, mcparticle);
 
 } // namespace indices
 
-DECLARE_SOA_INDEX_TABLE_USER(ECALTracksIndex, Tracks, "ECALTRK", indices::TrackId, indices::ECALId);
 DECLARE_SOA_INDEX_TABLE_USER(ECALMcPartIndex, McParticles, "ECALPART", indices::McParticleId, indices::ECALId);
 } // namespace o2::aod
 
-struct ecalIndexBuilder { // Builder of the ECAL-track index linkage
-  Builds<o2::aod::ECALTracksIndex> ind;
+struct ecalIndexBuilder { // Builder of the ECAL-particle index linkage, the track one is produced by alice3-detector-indices
   Builds<o2::aod::ECALMcPartIndex> indPart;
   void init(o2::framework::InitContext&)
   {
@@ -71,7 +69,7 @@ struct ecalQaMc {
     histos.add("PDGs", "Particle PDGs;PDG Code", kTH1D, {{100, 0.f, 100.f}});
   }
 
-  using Trks = soa::Join<aod::Tracks, aod::ECALTracksIndex, aod::TracksExtra>;
+  using Trks = soa::Join<aod::Tracks, aod::A3DetectorIndices, aod::TracksExtra>;
   void process(const soa::Join<aod::McParticles, aod::ECALMcPartIndex>& mcParticles,
                const Trks& tracks,
                const aod::McTrackLabels& labels,
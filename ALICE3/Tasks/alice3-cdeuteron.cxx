@@ -23,6 +23,11 @@
 #include "Common/DataModel/PIDResponse.h"
 #include "Common/Core/trackUtilities.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
@@ -44,9 +49,53 @@ struct Alice3CDeuteron {
   Configurable<float> maxNsigmaDe{"maxNsigmaDe", 3.f, "Maximum Nsigma for deuteron"};
   Configurable<float> maxNsigmaKa{"maxNsigmaKa", 3.f, "Maximum Nsigma for kaon"};
   Configurable<float> maxNsigmaPi{"maxNsigmaPi", 3.f, "Maximum Nsigma for pion"};
+  Configurable<bool> prefilter{"prefilter", false, "Drop the pairs and triplets failing the DCA, pT and mass selections before the vertex fit, they are then missing from all the histograms"};
+  Configurable<float> minInvMass{"minInvMass", 2.5, "Minimum invariant mass of the triplets fitted with the prefilter"};
+  Configurable<float> maxInvMass{"maxInvMass", 4.0, "Maximum invariant mass of the pairs and triplets fitted with the prefilter"};
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
   o2::vertexing::DCAFitterN<3> fitter;
 
+  static constexpr float massDeuteron = 1.8756129;
+  static constexpr float massKaon = 0.493677;
+  static constexpr float massPion = 0.139570;
+
+  using TracksWithPid = soa::Join<o2::aod::Tracks, o2::aod::McTrackLabels, o2::aod::TracksExtra, o2::aod::TracksCov,
+                                  aod::pidTOFFullPi, aod::pidTOFFullKa, aod::pidTOFFullDe>;
+
+  /// Track selected by the PID of a species, with what its pairs and triplets need
+  struct Candidate {
+    TracksWithPid::iterator track;
+    std::array<float, 2> dca;      // DCA to the primary vertex in xy and z
+    o2::track::TrackParCov parCov; // input of the vertex fit
+    bool isCovOk;                  // y-z covariance usable by the vertex fit
+    std::array<float, 4> mom;      // px, py, pz and E with the mass of the species
+  };
+  std::vector<Candidate> deuterons;
+  std::vector<Candidate> kaons;
+  std::vector<Candidate> pions;
+
+  /// Adds a track to the candidates of a species if it can be propagated to the primary vertex
+  bool addCandidate(TracksWithPid::iterator const& track, float mass, math_utils::Point3D<float> const& collPos, std::vector<Candidate>& candidates)
+  {
+    std::array<float, 2> dca{1e10f, 1e10f};
+    if (!getTrackPar(track).propagateParamToDCA(collPos, magField * 10.f, &dca, 100.)) {
+      return false;
+    }
+    auto parCov = getTrackParCov(track);
+    const bool isCovOk = parCov.getSigmaY2() * parCov.getSigmaZ2() - parCov.getSigmaZY() * parCov.getSigmaZY() >= 0.;
+    // same kinematics as the TLorentzVector of the track built from pT, eta and phi
+    const float px = track.pt() * std::cos(track.phi());
+    const float py = track.pt() * std::sin(track.phi());
+    const float pz = track.pt() * std::sinh(track.eta());
+    candidates.push_back({track, dca, parCov, isCovOk, {px, py, pz, std::sqrt(px * px + py * py + pz * pz + mass * mass)}});
+    return true;
+  }
+
+  static float invariantMass(std::array<float, 4> const& mom)
+  {
+    return std::sqrt(std::max(0.f, mom[3] * mom[3] - mom[0] * mom[0] - mom[1] * mom[1] - mom[2] * mom[2]));
+  }
+
   void init(InitContext&)
   {
 
@@ -176,8 +225,7 @@ struct Alice3CDeuteron {
 
   void process(const soa::Join<o2::aod::Collisions, o2::aod::McCollisionLabels>::iterator& coll,
                const o2::aod::McCollisions& Mccoll,
-               const soa::Join<o2::aod::Tracks, o2::aod::McTrackLabels, o2::aod::TracksExtra, o2::aod::TracksCov,
-                               aod::pidTOFFullPi, aod::pidTOFFullKa, aod::pidTOFFullDe>& tracks,
+               const TracksWithPid& tracks,
                const aod::McParticles_000& mcParticles)
   {
     const auto particlesInCollision = mcParticles.sliceBy(perMcCollision, coll.mcCollision().globalIndex());
@@ -221,49 +269,79 @@ struct Alice3CDeuteron {
     }
     histos.fill(HIST("event/multiplicity"), ntrks);
 
-    std::array<float, 2> dca1{1e10f, 1e10f};
-    std::array<float, 2> dca2{1e10f, 1e10f};
-    std::array<float, 2> dca3{1e10f, 1e10f};
-    for (const auto& track1 : tracks) {
-      const auto index1 = track1.globalIndex();
-      int ncand = 0;
-      histos.fill(HIST("event/nsigmaDe"), track1.pt(), track1.tofNSigmaDe());
-      if (usePdg) {
-        if (track1.mcParticle_as<aod::McParticles_000>().pdgCode() != 1000010020) {
-          continue;
+    // the per-species candidates are selected once per collision, with their DCA and covariance
+    deuterons.clear();
+    kaons.clear();
+    pions.clear();
+    for (const auto& track : tracks) {
+      histos.fill(HIST("event/nsigmaDe"), track.pt(), track.tofNSigmaDe());
+      if (usePdg ? track.mcParticle_as<aod::McParticles_000>().pdgCode() == 1000010020 : (abs(track.tofNSigmaDe()) <= maxNsigmaDe && track.sign() >= 0.f)) {
+        histos.fill(HIST("event/nsigmaDecut"), track.pt(), track.tofNSigmaDe());
+        if (addCandidate(track, massDeuteron, collPos, deuterons)) {
+          histos.fill(HIST("event/track1dcaxy"), deuterons.back().dca[0]);
+          histos.fill(HIST("event/track1dcaz"), deuterons.back().dca[1]);
         }
-      } else if (abs(track1.tofNSigmaDe()) > maxNsigmaDe || track1.sign() < 0.f) {
-        continue;
       }
-      histos.fill(HIST("event/nsigmaDecut"), track1.pt(), track1.tofNSigmaDe());
-      if (!getTrackPar(track1).propagateParamToDCA(collPos,
-                                                   magField * 10.f, &dca1, 100.)) {
-        continue;
+      histos.fill(HIST("event/nsigmaKa"), track.pt(), track.tofNSigmaKa());
+      if (usePdg ? track.mcParticle_as<aod::McParticles_000>().pdgCode() == -321 : (abs(track.tofNSigmaKa()) <= maxNsigmaKa && track.sign() <= 0.f)) {
+        histos.fill(HIST("event/nsigmaKacut"), track.pt(), track.tofNSigmaKa());
+        addCandidate(track, massKaon, collPos, kaons);
+      }
+      histos.fill(HIST("event/nsigmaPi"), track.pt(), track.tofNSigmaPi());
+      if (usePdg ? track.mcParticle_as<aod::McParticles_000>().pdgCode() == 211 : (abs(track.tofNSigmaPi()) <= maxNsigmaPi && track.sign() >= 0.f)) {
+        histos.fill(HIST("event/nsigmaPicut"), track.pt(), track.tofNSigmaPi());
+        addCandidate(track, massPion, collPos, pions);
       }
-      histos.fill(HIST("event/track1dcaxy"), dca1[0]);
-      histos.fill(HIST("event/track1dcaz"), dca1[1]);
+    }
+
+    for (const auto& deuteron : deuterons) {
+      const auto& track1 = deuteron.track;
+      const auto& dca1 = deuteron.dca;
+      const auto index1 = track1.globalIndex();
+      int ncand = 0;
 
-      for (const auto& track2 : tracks) {
+      for (const auto& kaon : kaons) {
+        const auto& track2 = kaon.track;
+        const auto& dca2 = kaon.dca;
         const auto index2 = track2.globalIndex();
         if (index1 == index2) {
           continue;
         }
-        histos.fill(HIST("event/nsigmaKa"), track2.pt(), track2.tofNSigmaKa());
-        if (usePdg) {
-          if (track2.mcParticle_as<aod::McParticles_000>().pdgCode() != -321) {
-            continue;
-          }
-        } else if (abs(track2.tofNSigmaKa()) > maxNsigmaKa || track2.sign() > 0.f) {
-          continue;
+        bool isPairCut = false;
+        if (abs(dca1[0]) < minDca || abs(dca1[1]) < minDca) {
+          isPairCut = true;
         }
-        histos.fill(HIST("event/nsigmaKacut"), track2.pt(), track2.tofNSigmaKa());
-        if (!getTrackPar(track2).propagateParamToDCA(collPos,
-                                                     magField * 10.f, &dca2, 100.)) {
-          continue;
+        if (abs(dca1[0]) < minDcaDeuteron || abs(dca1[1]) < minDcaDeuteron) {
+          isPairCut = true;
+        }
+        if (abs(dca1[0]) > maxDca || abs(dca1[1]) > maxDca) {
+          isPairCut = true;
         }
 
-        for (const auto& track3 : tracks) {
+        if (abs(dca2[0]) < minDca || abs(dca2[1]) < minDca) {
+          isPairCut = true;
+        }
+        if (abs(dca2[0]) > maxDca || abs(dca2[1]) > maxDca) {
+          isPairCut = true;
+        }
+        if (abs(dca2[0]) < minDcaPion || abs(dca2[1]) < minDcaPion) {
+          isPairCut = true;
+        }
+        if (track2.pt() < minKaonPt) {
+          isPairCut = true;
+        }
+        std::array<float, 4> pairMom{};
+        for (int i = 0; i < 4; i++) {
+          pairMom[i] = deuteron.mom[i] + kaon.mom[i];
+        }
+        // the pion adds at least its mass to the invariant mass of the pair
+        if (prefilter && (isPairCut || invariantMass(pairMom) > maxInvMass - massPion)) {
+          continue;
+        }
 
+        for (const auto& pion : pions) {
+          const auto& track3 = pion.track;
+          const auto& dca3 = pion.dca;
           const auto index3 = track3.globalIndex();
           if (index2 == index3) {
             continue;
@@ -271,52 +349,27 @@ struct Alice3CDeuteron {
           if (index1 == index3) {
             continue;
           }
-          histos.fill(HIST("event/nsigmaPi"), track3.pt(), track3.tofNSigmaPi());
-          if (usePdg) {
-            if (track3.mcParticle_as<aod::McParticles_000>().pdgCode() != 211) {
-              continue;
-            }
-          } else if (abs(track3.tofNSigmaPi()) > maxNsigmaPi || track3.sign() < 0.f) {
-            continue;
-          }
-          histos.fill(HIST("event/nsigmaPicut"), track3.pt(), track3.tofNSigmaPi());
-          bool iscut = false;
-          if (abs(dca1[0]) < minDca || abs(dca1[1]) < minDca) {
-            iscut = true;
-          }
-          if (abs(dca1[0]) < minDcaDeuteron || abs(dca1[1]) < minDcaDeuteron) {
-            iscut = true;
-          }
-          if (abs(dca1[0]) > maxDca || abs(dca1[1]) > maxDca) {
-            iscut = true;
-          }
-
-          if (abs(dca2[0]) < minDca || abs(dca2[1]) < minDca) {
-            iscut = true;
-          }
-          if (abs(dca2[0]) > maxDca || abs(dca2[1]) > maxDca) {
-            iscut = true;
-          }
-          if (abs(dca2[0]) < minDcaPion || abs(dca2[1]) < minDcaPion) {
-            iscut = true;
-          }
-          if (track2.pt() < minKaonPt) {
-            iscut = true;
-          }
+          bool iscut = isPairCut;
           if (track3.pt() < minPionPt) {
             iscut = true;
           }
-          if (!getTrackPar(track3).propagateParamToDCA(collPos,
-                                                       magField * 10.f, &dca3, 100.)) {
-            continue;
-          }
-
           if (abs(dca3[0]) < minDca || abs(dca3[1]) < minDca) {
             iscut = true;
           }
           if (abs(dca3[0]) > maxDca || abs(dca3[1]) > maxDca) {
             iscut = true;
           }
+          if (prefilter) {
+            // selections known before the vertex fit, from the track momenta
+            std::array<float, 4> mom{};
+            for (int i = 0; i < 4; i++) {
+              mom[i] = pairMom[i] + pion.mom[i];
+            }
+            const float mass = invariantMass(mom);
+            if (iscut || mass < minInvMass || mass > maxInvMass || std::hypot(mom[0], mom[1]) < minMomPt) {
+              continue;
+            }
+          }
 
           const auto mother1 = track1.mcParticle_as<aod::McParticles_000>().mother0_as<aod::McParticles_000>();
           const auto mother2 = track2.mcParticle_as<aod::McParticles_000>().mother0_as<aod::McParticles_000>();
@@ -329,34 +382,31 @@ struct Alice3CDeuteron {
             issig = false;
           }
 
-          auto pc1 = getTrackParCov(track1);
-          auto pc2 = getTrackParCov(track2);
-          auto pc3 = getTrackParCov(track3);
-          if (pc1.getSigmaY2() * pc1.getSigmaZ2() - pc1.getSigmaZY() * pc1.getSigmaZY() < 0.) {
+          if (!deuteron.isCovOk) {
             Printf("Track 1 has issues");
             continue;
           }
-          if (pc2.getSigmaY2() * pc2.getSigmaZ2() - pc2.getSigmaZY() * pc2.getSigmaZY() < 0.) {
+          if (!kaon.isCovOk) {
             Printf("Track 2 has issues");
             continue;
           }
-          if (pc3.getSigmaY2() * pc3.getSigmaZ2() - pc3.getSigmaZY() * pc3.getSigmaZY() < 0.) {
+          if (!pion.isCovOk) {
             Printf("Track 3 has issues");
             continue;
           }
-          const int status = fitter.process(pc1, pc2, pc3);
+          const int status = fitter.process(deuteron.parCov, kaon.parCov, pion.parCov);
           if (status == 0) {
             continue;
           }
 
           TLorentzVector v1{};
-          v1.SetPtEtaPhiM(track1.pt(), track1.eta(), track1.phi(), 1.8756129);
+          v1.SetPtEtaPhiM(track1.pt(), track1.eta(), track1.phi(), massDeuteron);
 
           TLorentzVector v2{};
-          v2.SetPtEtaPhiM(track2.pt(), track2.eta(), track2.phi(), 0.493677);
+          v2.SetPtEtaPhiM(track2.pt(), track2.eta(), track2.phi(), massKaon);
 
           TLorentzVector v3{};
-          v3.SetPtEtaPhiM(track3.pt(), track3.eta(), track3.phi(), 0.139570);
+          v3.SetPtEtaPhiM(track3.pt(), track3.eta(), track3.phi(), massPion);
           v1 += v2;
           v1 += v3;
           if (v1.Pt() < minMomPt) {
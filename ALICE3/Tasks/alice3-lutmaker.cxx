@@ -15,6 +15,7 @@
 
 // O2 includes
 #include "Framework/AnalysisTask.h"
+#include "Framework/HistogramRegistry.h"
 #include "ReconstructionDataFormats/Track.h"
 #include "SimulationDataFormat/MCUtils.h"
 
@@ -32,12 +33,22 @@ void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
     {"lut-pr", VariantType::Int, 1, {"LUT input for the Proton PDG code"}},
     {"lut-tr", VariantType::Int, 0, {"LUT input for the Triton PDG code"}},
     {"lut-de", VariantType::Int, 0, {"LUT input for the Deuteron PDG code"}},
-    {"lut-he", VariantType::Int, 0, {"LUT input for the Helium3 PDG code"}}};
+    {"lut-he", VariantType::Int, 0, {"LUT input for the Helium3 PDG code"}},
+    {"lut-single-pass", VariantType::Int, 0, {"Build the LUTs of the species of the pdg-codes configurable in one task instead of one task per species"}}};
   std::swap(workflowOptions, options);
 }
 
 #include "Framework/runDataProcessing.h"
 
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TProfile2D.h"
+#include "TH3.h"
+
 template <o2::track::pid_constants::ID particle>
 struct Alice3LutMaker {
   static constexpr int nSpecies = 8;
@@ -294,9 +305,268 @@ struct Alice3LutMaker {
   }
 };
 
+/// LUTs of several species in a single pass over the tracks
+/// The covariance matrix elements of the tracks are summed in dense (pT, eta, element) arrays per species, which are
+/// added to the profiles of the species at the end of every data frame instead of filling the 30 profiles per track
+struct Alice3LutMakerSinglePass {
+  static constexpr int nSpecies = 8;
+  static constexpr int PDGs[nSpecies] = {kElectron, kMuonMinus, kPiPlus, kKPlus, kProton, 1000010020, 1000010030, 1000020030};
+  static constexpr const char* speciesNames[nSpecies] = {"electron", "muon", "pion", "kaon", "proton", "deuteron", "triton", "helium3"};
+  static constexpr int nElements = 30;
+  static constexpr const char* elementNames[nElements] = {"sigmaY", "sigmaZ", "sigmaSnp", "sigmaTgl", "sigma1Pt",
+                                                          "rhoZY", "rhoSnpY", "rhoSnpZ", "rhoTglY", "rhoTglZ",
+                                                          "rhoTglSnp", "rho1PtY", "rho1PtZ", "rho1PtSnp", "rho1PtTgl",
+                                                          "cYY", "cZY", "cZZ", "cSnpY", "cSnpZ",
+                                                          "cSnpSnp", "cTglY", "cTglZ", "cTglSnp", "cTglTgl",
+                                                          "c1PtY", "c1PtZ", "c1PtSnp", "c1PtTgl", "c1Pt21Pt2"};
+  // Binning of the QA histograms of the elements, as in Alice3LutMaker
+  static constexpr int elementQABins[nElements] = {300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 321, 300, 375, 300,
+                                                   300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300, 300};
+  static constexpr double elementQAMin[nElements] = {0.0, 0.0, 0.0, 0.0, 0.0, -18.0, -300.0, -10.0, -20.0, -300.0, -15.0, -250.0, -90.0, -300.0, -90.0,
+                                                     0.0, -6e-08, 0.0, -0.0021, -8e-08, 0.0, -2e-07, -0.004, -3.5e-05, 0.0, -0.004, -0.03, -0.015, -0.06, 0.0};
+  static constexpr double elementQAMax[nElements] = {0.04, 0.07, 0.09, 0.15, 5, 18.0, 0.0, 10.0, 20.0, 0.0, 15.0, 250.0, 90.0, 300.0, 90.0,
+                                                     0.0009, 6e-08, 0.003, 0.0, 8e-08, 0.0025, 2e-07, 0.0, 3.5e-05, 0.008, 0.004, 0.03, 0.015, 0.06, 10};
+
+  Configurable<std::vector<int>> pdgCodes{"pdg-codes", std::vector<int>{kElectron, kMuonMinus, kPiPlus, kKPlus, kProton}, "PDG codes of the species of the LUTs"};
+  Configurable<bool> addQA{"add-qa", false, "Flag to use add QA plots to show the covariance matrix elements"};
+  Configurable<bool> selPrim{"sel-prim", false, "If true selects primaries, if not select all particles"};
+
+  Configurable<int> nchBins{"nch-bins", 20, "Number of multiplicity bins"};
+  Configurable<float> nchMin{"nch-min", 0.5f, "Lower limit in multiplicity"};
+  Configurable<float> nchMax{"nch-max", 3.5f, "Upper limit in multiplicity"};
+  Configurable<int> nchLog{"nch-log", 1, "Flag to use a logarithmic multiplicity axis, in this case the Nch limits are the expontents"};
+
+  Configurable<int> etaBins{"eta-bins", 80, "Number of eta bins"};
+  Configurable<float> etaMin{"eta-min", -4.f, "Lower limit in eta"};
+  Configurable<float> etaMax{"eta-max", 4.f, "Upper limit in eta"};
+
+  Configurable<int> ptBins{"pt-bins", 200, "Number of pT bins"};
+  Configurable<float> ptMin{"pt-min", -2.f, "Lower limit in pT"};
+  Configurable<float> ptMax{"pt-max", 2.f, "Upper limit in pT"};
+  Configurable<int> ptLog{"pt-log", 1, "Flag to use a logarithmic pT axis, in this case the pT limits are the expontents"};
+
+  HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
+
+  /// Histograms and accumulated moments of one species
+  struct Species {
+    int pdg = 0;
+    int nTracks = 0;                                             ///< tracks of the species in the data frame
+    std::shared_ptr<TH1> multiplicity;                           ///< tracks per data frame
+    std::shared_ptr<TH1> pt;                                     ///< pT of the tracks
+    std::shared_ptr<TH1> eta;                                    ///< eta of the tracks
+    std::shared_ptr<TProfile2D> efficiency;                      ///< reconstruction efficiency
+    std::array<std::shared_ptr<TProfile2D>, nElements> profiles; ///< covariance matrix elements in (pT, eta)
+    std::array<std::shared_ptr<TH3>, nElements> qa;              ///< distributions of the elements, if addQA
+    std::vector<double> entries;                                 ///< fills per cell
+    std::vector<double> sum;                                     ///< sum of the elements, nElements per cell
+    std::vector<double> sum2;                                    ///< sum of the squared elements, nElements per cell
+    std::vector<int> filled;                                     ///< cells with at least one fill
+    double fills = 0.;                                           ///< all the fills, including the under and overflows
+    std::array<double, 7> kinematicStats{};                      ///< sumw, sumw2, sumwx, sumwx2, sumwy, sumwy2, sumwxy of the in-range fills
+    std::array<double, nElements> sumz{};                        ///< sum of the in-range elements
+    std::array<double, nElements> sumz2{};                       ///< sum of the in-range squared elements
+  };
+  std::vector<Species> species;
+  std::vector<uint8_t> isReconstructed; ///< per MC particle, if it has a selected track of one of the species
+
+  void init(InitContext&)
+  {
+    AxisSpec axisPt{ptBins, ptMin, ptMax, "#it{p}_{T} GeV/#it{c}"};
+    if (ptLog) {
+      axisPt.makeLogarithmic();
+    }
+    AxisSpec axisNch{nchBins, nchMin, nchMax, "N_{Ch}"};
+    if (nchLog) {
+      axisNch.makeLogarithmic();
+    }
+    const AxisSpec axisEta{etaBins, etaMin, etaMax, "#it{#eta}"};
+
+    for (const int pdg : pdgCodes.value) {
+      int index = 0;
+      while (index < nSpecies && PDGs[index] != pdg) {
+        index++;
+      }
+      if (index == nSpecies) {
+        LOG(fatal) << "No LUT for the PDG code " << pdg;
+      }
+      const std::string dir = speciesNames[index];
+      const TString commonTitle = Form(" PDG %i", pdg);
+      Species& s = species.emplace_back();
+      s.pdg = pdg;
+      s.multiplicity = histos.add<TH1>((dir + "/multiplicity").c_str(), "Track multiplicity;Tracks per event;Events", kTH1F, {axisNch});
+      s.pt = histos.add<TH1>((dir + "/pt").c_str(), "pt" + commonTitle, kTH1F, {axisPt});
+      s.eta = histos.add<TH1>((dir + "/eta").c_str(), "eta" + commonTitle, kTH1F, {axisEta});
+      for (int e = 0; e < nElements; e++) {
+        s.profiles[e] = histos.add<TProfile2D>((dir + "/CovMat_" + elementNames[e]).c_str(), elementNames[e] + commonTitle, kTProfile2D, {axisPt, axisEta});
+        if (addQA) {
+          const AxisSpec axisElement{elementQABins[e], elementQAMin[e], elementQAMax[e], elementNames[e]};
+          s.qa[e] = histos.add<TH3>((dir + "/QA/CovMat_" + elementNames[e]).c_str(), elementNames[e] + commonTitle, kTH3F, {axisPt, axisEta, axisElement});
+        }
+      }
+      s.efficiency = histos.add<TProfile2D>((dir + "/Efficiency").c_str(), "Efficiency" + commonTitle, kTProfile2D, {axisPt, axisEta});
+      const int nCells = s.profiles[0]->GetNcells();
+      s.entries.assign(nCells, 0.);
+      s.sum.assign(nCells * nElements, 0.);
+      s.sum2.assign(nCells * nElements, 0.);
+    }
+  }
+
+  /// Index of the species with the PDG code pdg, -1 if it has no LUT
+  int findSpecies(int pdg) const
+  {
+    for (std::size_t i = 0; i < species.size(); i++) {
+      if (species[i].pdg == pdg) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /// Adds the elements of a track at (pt, eta) to the moments of the species, as TProfile2D::Fill with weight 1
+  void fill(Species& s, double pt, double eta, std::array<float, nElements> const& values)
+  {
+    const TProfile2D* h = s.profiles[0].get();
+    const int binX = h->GetXaxis()->FindFixBin(pt);
+    const int binY = h->GetYaxis()->FindFixBin(eta);
+    const int cell = h->GetBin(binX, binY);
+    if (s.entries[cell]++ == 0.) {
+      s.filled.push_back(cell);
+    }
+    double* sum = &s.sum[cell * nElements];
+    double* sum2 = &s.sum2[cell * nElements];
+    for (int e = 0; e < nElements; e++) {
+      sum[e] += values[e];
+      sum2[e] += static_cast<double>(values[e]) * values[e];
+    }
+    s.fills++;
+    if (binX < 1 || binX > h->GetNbinsX() || binY < 1 || binY > h->GetNbinsY()) {
+      return;
+    }
+    std::array<double, 7>& stats = s.kinematicStats;
+    stats[0]++;
+    stats[1]++;
+    stats[2] += pt;
+    stats[3] += pt * pt;
+    stats[4] += eta;
+    stats[5] += eta * eta;
+    stats[6] += pt * eta;
+    for (int e = 0; e < nElements; e++) {
+      s.sumz[e] += values[e];
+      s.sumz2[e] += static_cast<double>(values[e]) * values[e];
+    }
+  }
+
+  /// Adds the moments to the profiles of the species and resets them
+  void flush(Species& s)
+  {
+    if (s.filled.empty()) {
+      return;
+    }
+    for (int e = 0; e < nElements; e++) {
+      TProfile2D* h = s.profiles[e].get();
+      // the statistics are read before the bins change, they are recomputed from the bins when not filled
+      double stats[9];
+      h->GetStats(stats);
+      double* sumwz = h->GetArray();
+      double* sumwz2 = h->GetSumw2()->GetArray();
+      double* binSumw2 = h->GetBinSumw2()->fN ? h->GetBinSumw2()->GetArray() : nullptr;
+      for (const int cell : s.filled) {
+        sumwz[cell] += s.sum[cell * nElements + e];
+        sumwz2[cell] += s.sum2[cell * nElements + e];
+        h->SetBinEntries(cell, h->GetBinEntries(cell) + s.entries[cell]);
+        if (binSumw2) {
+          binSumw2[cell] += s.entries[cell];
+        }
+      }
+      for (int i = 0; i < 7; i++) {
+        stats[i] += s.kinematicStats[i];
+      }
+      stats[7] += s.sumz[e];
+      stats[8] += s.sumz2[e];
+      h->PutStats(stats);
+      h->SetEntries(h->GetEntries() + s.fills);
+    }
+    for (const int cell : s.filled) {
+      s.entries[cell] = 0.;
+      std::fill_n(&s.sum[cell * nElements], nElements, 0.);
+      std::fill_n(&s.sum2[cell * nElements], nElements, 0.);
+    }
+    s.filled.clear();
+    s.fills = 0.;
+    s.kinematicStats = {};
+    s.sumz = {};
+    s.sumz2 = {};
+  }
+
+  void process(const o2::aod::McParticles_000& mcParticles,
+               const o2::soa::Join<o2::aod::Collisions, o2::aod::McCollisionLabels>&,
+               const o2::soa::Join<o2::aod::Tracks, o2::aod::TracksCov, o2::aod::McTrackLabels>& tracks,
+               const o2::aod::McCollisions&)
+  {
+    isReconstructed.assign(mcParticles.size(), 0);
+    for (Species& s : species) {
+      s.nTracks = 0;
+    }
+
+    for (const auto& track : tracks) {
+      if (!track.has_mcParticle()) {
+        continue;
+      }
+      const auto mcParticle = track.mcParticle_as<aod::McParticles_000>();
+      const int index = findSpecies(mcParticle.pdgCode());
+      if (index < 0) {
+        continue;
+      }
+      if (selPrim.value && !mcParticle.isPhysicalPrimary()) { // Requiring is physical primary
+        continue;
+      }
+      Species& s = species[index];
+      s.nTracks++;
+      isReconstructed[mcParticle.globalIndex()] = 1;
+
+      s.pt->Fill(mcParticle.pt());
+      s.eta->Fill(mcParticle.eta());
+
+      const std::array<float, nElements> values = {track.sigmaY(), track.sigmaZ(), track.sigmaSnp(), track.sigmaTgl(), track.sigma1Pt(),
+                                                   track.rhoZY(), track.rhoSnpY(), track.rhoSnpZ(), track.rhoTglY(), track.rhoTglZ(),
+                                                   track.rhoTglSnp(), track.rho1PtY(), track.rho1PtZ(), track.rho1PtSnp(), track.rho1PtTgl(),
+                                                   track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
+                                                   track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
+                                                   track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2()};
+      fill(s, mcParticle.pt(), mcParticle.eta(), values);
+
+      if (!addQA) { // Only if QA histograms are enabled
+        continue;
+      }
+      for (int e = 0; e < nElements; e++) {
+        s.qa[e]->Fill(mcParticle.pt(), mcParticle.eta(), values[e]);
+      }
+    }
+    for (Species& s : species) {
+      s.multiplicity->Fill(s.nTracks);
+      flush(s);
+    }
+
+    for (const auto& mcParticle : mcParticles) {
+      const int index = findSpecies(mcParticle.pdgCode());
+      if (index < 0) {
+        continue;
+      }
+      if (!mcParticle.isPhysicalPrimary()) { // Requiring is physical primary
+        continue;
+      }
+      species[index].efficiency->Fill(mcParticle.pt(), mcParticle.eta(), isReconstructed[mcParticle.globalIndex()] ? 1. : 0.);
+    }
+  }
+};
+
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
 {
   WorkflowSpec w;
+  if (cfgc.options().get<int>("lut-single-pass")) {
+    w.push_back(adaptAnalysisTask<Alice3LutMakerSinglePass>(cfgc, TaskName{"alice3-lutmaker-single-pass"}));
+    return w;
+  }
   if (cfgc.options().get<int>("lut-el")) {
     w.push_back(adaptAnalysisTask<Alice3LutMaker<o2::track::PID::Electron>>(cfgc, TaskName{"alice3-lutmaker-electron"}));
   }
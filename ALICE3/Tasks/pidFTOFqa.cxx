@@ -16,31 +16,13 @@
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/ASoAHelpers.h"
 #include "ALICE3/DataModel/FTOF.h"
+#include "ALICE3/DataModel/DetectorIndices.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 
-namespace o2::aod
-{
-
-namespace indices
-{
-DECLARE_SOA_INDEX_COLUMN(Track, track);
-DECLARE_SOA_INDEX_COLUMN(FTOF, ftof);
-} // namespace indices
-
-DECLARE_SOA_INDEX_TABLE_USER(FTOFTracksIndex, Tracks, "FTOFTRK", indices::TrackId, indices::FTOFId);
-} // namespace o2::aod
-
-struct ftofIndexBuilder {
-  Builds<o2::aod::FTOFTracksIndex> ind;
-  void init(o2::framework::InitContext&)
-  {
-  }
-};
-
 struct ftofPidQaMC {
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::QAObject};
   Configurable<int> pdgCode{"pdgCode", 0, "pdg code of the particles to accept"};
@@ -92,7 +74,7 @@ struct ftofPidQaMC {
     histos.add("qa/nsigmaPr", ";#it{p} (GeV/#it{c});N_{#sigma}^{FTOF}(p)", kTH2F, {momAxis, nsigmaAxis});
   }
 
-  using Trks = soa::Join<aod::Tracks, aod::FTOFTracksIndex, aod::TracksExtra>;
+  using Trks = soa::Join<aod::Tracks, aod::A3DetectorIndices, aod::TracksExtra>;
   void process(const Trks& tracks,
                const aod::McTrackLabels& labels,
                const aod::FTOFs&,
@@ -147,5 +129,6 @@ struct ftofPidQaMC {
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfg)
 {
-  return WorkflowSpec{adaptAnalysisTask<ftofIndexBuilder>(cfg), adaptAnalysisTask<ftofPidQaMC>(cfg)};
+  // The FTOF indices of the tracks are produced by the alice3-detector-indices task
+  return WorkflowSpec{adaptAnalysisTask<ftofPidQaMC>(cfg)};
 }
@@ -18,6 +18,7 @@
 // O2 includes
 #include "Framework/AnalysisTask.h"
 #include "ALICE3/DataModel/RICH.h"
+#include "ALICE3/DataModel/DetectorIndices.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "ReconstructionDataFormats/PID.h"
 
@@ -37,28 +38,6 @@ void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 
 #include "Framework/runDataProcessing.h"
 
-namespace o2::aod
-{
-
-namespace indices
-{
-DECLARE_SOA_INDEX_COLUMN(Track, track);
-DECLARE_SOA_INDEX_COLUMN(RICH, rich);
-DECLARE_SOA_INDEX_COLUMN(FRICH, frich);
-} // namespace indices
-
-DECLARE_SOA_INDEX_TABLE_USER(RICHTracksIndex, Tracks, "RICHTRK", indices::TrackId, indices::RICHId);
-DECLARE_SOA_INDEX_TABLE_USER(FRICHTracksIndex, Tracks, "FRICHTRK", indices::TrackId, indices::FRICHId);
-} // namespace o2::aod
-
-struct richIndexBuilder { // Builder of the RICH-track index linkage
-  Builds<o2::aod::RICHTracksIndex> indB;
-  Builds<o2::aod::FRICHTracksIndex> indF;
-  void init(o2::framework::InitContext&)
-  {
-  }
-};
-
 template <o2::track::PID::ID pid_type>
 struct richPidQaMc {
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::QAObject};
@@ -240,10 +219,10 @@ struct richPidQaMc {
     }
   }
 
-  using Trks = soa::Join<aod::Tracks, aod::RICHTracksIndex, aod::TracksExtra,
+  using Trks = soa::Join<aod::Tracks, aod::A3DetectorIndices, aod::TracksExtra,
                          aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi,
                          aod::pidTOFFullKa, aod::pidTOFFullPr, aod::McTrackLabels>;
-  using TrksfRICH = soa::Join<aod::Tracks, aod::FRICHTracksIndex, aod::TracksExtra, aod::McTrackLabels>;
+  using TrksfRICH = soa::Join<aod::Tracks, aod::A3DetectorIndices, aod::TracksExtra, aod::McTrackLabels>;
   void process(const Trks& tracks,
                const aod::McParticles_000& mcParticles,
                const TrksfRICH& tracksfrich,
@@ -400,7 +379,8 @@ struct richPidQaMc {
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfg)
 {
-  auto workflow = WorkflowSpec{adaptAnalysisTask<richIndexBuilder>(cfg)};
+  // The RICH indices of the tracks are produced by the alice3-detector-indices task
+  WorkflowSpec workflow;
   if (cfg.options().get<int>("qa-el")) {
     workflow.push_back(adaptAnalysisTask<richPidQaMc<PID::Electron>>(cfg, TaskName{"pidRICH-qa-El"}));
   }
@@ -0,0 +1,304 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CCDBObjectCache.h
+/// \brief  Run-keyed cache of CCDB objects shared by all the tasks of a process
+///         Objects are fetched and deserialized once per (path, run) instead of once per task,
+///         and each task accesses them through a typed handle that detects run changes.
+///         Optionally the material LUT is also kept in a node-local snapshot directory, shared by all the jobs of a node:
+///         the LUT is a flat object (one class header and one flat buffer), written once per (path, validity, etag) and
+///         then memory-mapped by the following jobs instead of being downloaded and deserialized. The mapping is private
+///         copy-on-write, so that only the pages with the internal pointers relocated at load are copied by a job, while
+///         the bulk of the buffer stays in the page cache shared by the jobs.
+///
+
+#ifndef COMMON_CORE_CCDBOBJECTCACHE_H_
+#define COMMON_CORE_CCDBOBJECTCACHE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+
+#include "Framework/Logger.h"
+#include "DetectorsBase/MatLayerCylSet.h"
+
+namespace o2::common
+{
+
+class CCDBObjectCache
+{
+ public:
+  /// Process-wide instance
+  static CCDBObjectCache& instance()
+  {
+    static CCDBObjectCache cache;
+    return cache;
+  }
+
+  /// Object valid for a run, fetched from CCDB only the first time it is requested for that run
+  /// \param ccdb is the BasicCCDBManager (or the framework Service wrapping it)
+  /// \param path is the CCDB path of the object
+  /// \param runNumber is the run number, used as key of the cache
+  /// \param timestamp is the timestamp used to fetch the object if it is not in the cache
+  /// \param fatalIfMissing to abort if the object is not available in CCDB
+  /// \return the object, owned by the CCDB manager
+  template <typename T, typename TCCDB>
+  T* get(TCCDB& ccdb, std::string const& path, int runNumber, uint64_t timestamp, bool fatalIfMissing = true)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& entry = mEntries[path];
+    if (entry.object != nullptr && entry.runNumber == runNumber && *entry.type == typeid(T)) {
+      return static_cast<T*>(entry.object);
+    }
+    T* object = ccdb->template getForTimeStamp<T>(path, timestamp);
+    if (object == nullptr && fatalIfMissing) {
+      LOGF(fatal, "CCDB object %s is not available for run %d at timestamp %llu", path.data(), runNumber, timestamp);
+    }
+    entry.runNumber = runNumber;
+    entry.type = &typeid(T);
+    entry.object = object;
+    ++mNFetches;
+    return object;
+  }
+
+  /// Object without time dependence (e.g. geometry), fetched from CCDB only once
+  template <typename T, typename TCCDB>
+  T* get(TCCDB& ccdb, std::string const& path)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& entry = mEntries[path];
+    if (entry.object != nullptr && entry.runNumber == kNoRun && *entry.type == typeid(T)) {
+      return static_cast<T*>(entry.object);
+    }
+    T* object = ccdb->template get<T>(path);
+    if (object == nullptr) {
+      LOGF(fatal, "CCDB object %s is not available", path.data());
+    }
+    entry.runNumber = kNoRun;
+    entry.type = &typeid(T);
+    entry.object = object;
+    ++mNFetches;
+    return object;
+  }
+
+  /// Node-local directory of the material LUT snapshots, empty (default) to disable them
+  void setSnapshotDir(std::string const& dir)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSnapshotDir = dir;
+  }
+
+  /// Material LUT for the propagation, fetched and rectified only once
+  /// If a snapshot directory is set, the LUT is mapped from its snapshot when available, and the snapshot is written otherwise
+  template <typename TCCDB>
+  o2::base::MatLayerCylSet* getMatLUT(TCCDB& ccdb, std::string const& path)
+  {
+    std::string snapshotDir;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      auto lut = mMatLUTs.find(path);
+      if (lut != mMatLUTs.end()) {
+        return lut->second;
+      }
+      snapshotDir = mSnapshotDir;
+    }
+    std::string snapshotFile = snapshotDir.empty() ? "" : getSnapshotFileName(ccdb, snapshotDir, path);
+    o2::base::MatLayerCylSet* lut = snapshotFile.empty() ? nullptr : mapMatLUTSnapshot(snapshotFile);
+    if (lut != nullptr) {
+      LOGF(info, "Material LUT %s mapped from the snapshot %s", path.data(), snapshotFile.data());
+    } else {
+      lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(get<o2::base::MatLayerCylSet>(ccdb, path));
+      if (!snapshotFile.empty()) {
+        writeMatLUTSnapshot(*lut, snapshotFile);
+      }
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMatLUTs[path] = lut;
+    return lut;
+  }
+
+  /// Number of objects actually fetched from CCDB
+  int getNFetches() const { return mNFetches; }
+
+ private:
+  static constexpr int kNoRun = -1;
+
+  struct Entry {
+    int runNumber = kNoRun;
+    const std::type_info* type = nullptr;
+    void* object = nullptr;
+  };
+
+  // layout of a snapshot: header, class of the flat object, padding to the page, flat buffer
+  struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t objectSize;
+    uint64_t bufferOffset;
+    uint64_t bufferSize;
+  };
+  static constexpr char kSnapshotMagic[8] = {'O', '2', 'F', 'L', 'A', 'T', '0', '1'};
+  static constexpr uint32_t kSnapshotVersion = 1;
+  static constexpr uint64_t kSnapshotAlignment = 4096;
+
+  /// Snapshot file of an object, named after its path, validity and etag, empty if they are not available
+  template <typename TCCDB>
+  static std::string getSnapshotFileName(TCCDB& ccdb, std::string const& dir, std::string const& path)
+  {
+    auto headers = ccdb->getCCDBAccessor().retrieveHeaders(path, {}, ccdb->getTimestamp());
+    auto etag = headers.find("ETag");
+    if (etag == headers.end() || etag->second.empty()) {
+      LOGF(warning, "No etag for the CCDB object %s, its snapshot is not used", path.data());
+      return "";
+    }
+    std::string name = path + "_" + headers["Valid-From"] + "_" + headers["Valid-Until"] + "_" + etag->second;
+    for (auto& c : name) {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '.') {
+        c = '_';
+      }
+    }
+    return dir + "/" + name + ".flat";
+  }
+
+  /// Writes the snapshot of a LUT through a temporary file renamed at the end, so that concurrent jobs never see a partial one
+  static void writeMatLUTSnapshot(o2::base::MatLayerCylSet const& lut, std::string const& file)
+  {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.objectSize = sizeof(o2::base::MatLayerCylSet);
+    header.bufferOffset = (sizeof(SnapshotHeader) + header.objectSize + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment;
+    header.bufferSize = lut.getFlatBufferSize();
+    std::string tmpFile = file + ".tmp" + std::to_string(getpid());
+    FILE* out = std::fopen(tmpFile.data(), "wb");
+    if (out == nullptr) {
+      LOGF(warning, "Cannot write the snapshot %s", file.data());
+      return;
+    }
+    std::string padding(header.bufferOffset - sizeof(SnapshotHeader) - header.objectSize, '\0');
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+              std::fwrite(static_cast<const void*>(&lut), header.objectSize, 1, out) == 1 &&
+              std::fwrite(padding.data(), padding.size(), 1, out) == (padding.empty() ? 0u : 1u) &&
+              std::fwrite(lut.getFlatBufferPtr(), header.bufferSize, 1, out) == 1;
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok || std::rename(tmpFile.data(), file.data()) != 0) {
+      LOGF(warning, "Cannot write the snapshot %s", file.data());
+      std::remove(tmpFile.data());
+      return;
+    }
+    LOGF(info, "Snapshot %s written", file.data());
+  }
+
+  /// Maps a LUT snapshot, nullptr if it does not exist or is not valid
+  /// The mapping is kept for the lifetime of the process, as the LUTs of the cache
+  static o2::base::MatLayerCylSet* mapMatLUTSnapshot(std::string const& file)
+  {
+    int fd = open(file.data(), O_RDONLY);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(SnapshotHeader)) {
+      close(fd);
+      return nullptr;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+      return nullptr;
+    }
+    char* data = static_cast<char*>(map);
+    SnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || header.version != kSnapshotVersion ||
+        header.objectSize != sizeof(o2::base::MatLayerCylSet) || header.bufferOffset + header.bufferSize != static_cast<uint64_t>(st.st_size)) {
+      LOGF(warning, "Snapshot %s is not valid, ignored", file.data());
+      munmap(map, st.st_size);
+      return nullptr;
+    }
+    // flat object: the class is copied and then relocated to the mapped buffer
+    auto lut = new o2::base::MatLayerCylSet();
+    std::memcpy(static_cast<void*>(lut), data + sizeof(SnapshotHeader), header.objectSize);
+    lut->setActualBufferAddress(data + header.bufferOffset);
+    return lut;
+  }
+
+  CCDBObjectCache() = default;
+  CCDBObjectCache(CCDBObjectCache const&) = delete;
+  CCDBObjectCache& operator=(CCDBObjectCache const&) = delete;
+
+  std::mutex mMutex;
+  std::map<std::string, Entry> mEntries;
+  std::map<std::string, o2::base::MatLayerCylSet*> mMatLUTs;
+  std::string mSnapshotDir = "";
+  int mNFetches = 0;
+};
+
+/// Typed access to a run-dependent object of the cache
+template <typename T>
+class CCDBObjectHandle
+{
+ public:
+  CCDBObjectHandle() = default;
+  explicit CCDBObjectHandle(std::string const& path) : mPath(path) {}
+
+  void setPath(std::string const& path)
+  {
+    mPath = path;
+    mRunNumber = -1;
+    mObject = nullptr;
+  }
+
+  /// Updates the object on run change
+  /// \return true if the run changed, i.e. if the task has to refresh what depends on the object
+  template <typename TCCDB>
+  bool update(TCCDB& ccdb, int runNumber, uint64_t timestamp)
+  {
+    if (runNumber == mRunNumber) {
+      return false;
+    }
+    mObject = CCDBObjectCache::instance().get<T>(ccdb, mPath, runNumber, timestamp);
+    mRunNumber = runNumber;
+    return true;
+  }
+
+  /// Updates the object on run change, taking run number and timestamp from a bunch crossing
+  template <typename TCCDB, typename TBC>
+  bool update(TCCDB& ccdb, TBC const& bc)
+  {
+    return update(ccdb, bc.runNumber(), bc.timestamp());
+  }
+
+  T* get() const { return mObject; }
+  T* operator->() const { return mObject; }
+  explicit operator bool() const { return mObject != nullptr; }
+  int getRunNumber() const { return mRunNumber; }
+
+ private:
+  std::string mPath = "";
+  int mRunNumber = -1;
+  T* mObject = nullptr;
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_CCDBOBJECTCACHE_H_
@@ -0,0 +1,74 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   CollisionBCIndex.h
+/// \brief  Collisions of a dataframe sorted by the global BC of their most probable bunch crossing
+///         The collisions compatible with a track in time, e.g. those in the compatible BCs of an ambiguous track, are then
+///         found with a binary search on the BC window instead of a loop over all the collisions. The candidates are
+///         returned by increasing global index, i.e. in the order of a loop over the collisions table.
+///         Usage:
+///           CollisionBCIndex index;
+///           index.build(collisions);
+///           for (auto collisionId : index.collisionsInWindow(bcMin, bcMax, candidates)) { ... }
+///
+
+#ifndef COMMON_CORE_COLLISIONBCINDEX_H_
+#define COMMON_CORE_COLLISIONBCINDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace o2::common
+{
+
+class CollisionBCIndex
+{
+ public:
+  /// Sorts the collisions by the global BC of their bunch crossing, the BCs table must be bound to the collisions
+  template <typename Collisions>
+  void build(Collisions const& collisions)
+  {
+    mEntries.clear();
+    mEntries.reserve(collisions.size());
+    for (auto const& collision : collisions) {
+      mEntries.emplace_back(collision.bc().globalBC(), collision.globalIndex());
+    }
+    std::sort(mEntries.begin(), mEntries.end());
+  }
+
+  /// Global indices of the collisions with a global BC in [bcMin, bcMax], by increasing global index
+  /// \param candidates buffer for the result, reused between the calls
+  std::vector<int64_t> const& collisionsInWindow(uint64_t bcMin, uint64_t bcMax, std::vector<int64_t>& candidates) const
+  {
+    candidates.clear();
+    if (bcMax < bcMin) {
+      return candidates;
+    }
+    auto first = std::lower_bound(mEntries.begin(), mEntries.end(), bcMin, [](auto const& entry, uint64_t bc) { return entry.first < bc; });
+    for (auto it = first; it != mEntries.end() && it->first <= bcMax; ++it) {
+      candidates.push_back(it->second);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    return candidates;
+  }
+
+  std::size_t size() const { return mEntries.size(); }
+
+ private:
+  std::vector<std::pair<uint64_t, int64_t>> mEntries; // (global BC, global index) of the collisions, sorted
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_COLLISIONBCINDEX_H_
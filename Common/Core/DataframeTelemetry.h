@@ -0,0 +1,184 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   DataframeTelemetry.h
+/// \brief  Input rows, output rows and wall time of the process calls of a task
+///         A call is recorded with a scope object, e.g. O2_DF_TELEMETRY(telemetry, kProcessFoo) at the top of the process
+///         function, which measures the steady_clock time until the end of the function. The rows of the inputs
+///         (collisions, tracks, candidates...) and of the outputs are given during the call with setInputRows and
+///         addOutputRows, and are filled in histograms with the time when the call ends. The time is also filled
+///         versus the rows of the first input, to correlate the slow calls with the multiplicity.
+///         A call is a dataframe for the process functions without grouping, and a collision otherwise.
+///         Disabled at run time, nothing is recorded and the clock is not read. Like the region timers
+///         (RegionTimers.h), O2_DF_TELEMETRY expands to nothing and the telemetry is always disabled when
+///         O2PHYSICS_DISABLE_REGION_TIMERS is defined. The telemetry is not thread safe.
+///
+
+#ifndef COMMON_CORE_DATAFRAMETELEMETRY_H_
+#define COMMON_CORE_DATAFRAMETELEMETRY_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Framework/HistogramRegistry.h"
+
+namespace o2::common
+{
+
+class DataframeTelemetry
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Records a process call, from its construction to its destruction
+  class Call
+  {
+   public:
+    Call(DataframeTelemetry* telemetry, int process) : mTelemetry(telemetry), mProcess(process)
+    {
+      if (mTelemetry != nullptr) {
+        mStart = Clock::now();
+      }
+    }
+    Call(Call const&) = delete;
+    Call& operator=(Call const&) = delete;
+    ~Call()
+    {
+      if (mTelemetry != nullptr) {
+        mTelemetry->fill(mProcess, std::chrono::duration<double, std::micro>(Clock::now() - mStart).count());
+      }
+    }
+
+   private:
+    DataframeTelemetry* mTelemetry;
+    int mProcess;
+    Clock::time_point mStart;
+  };
+
+  /// Books the histograms in folder, the ids of the process functions, inputs and outputs are their indices in the lists
+  /// \param inputs names of the inputs, the first one is the reference of the time versus rows
+  void init(o2::framework::HistogramRegistry& registry, std::vector<std::string> const& processes, std::vector<std::string> const& inputs,
+            std::vector<std::string> const& outputs, bool enabled, std::string const& folder = "Telemetry")
+  {
+#ifdef O2PHYSICS_DISABLE_REGION_TIMERS
+    enabled = false;
+#endif
+    mEnabled = enabled;
+    if (!mEnabled) {
+      return;
+    }
+    mInputRows.assign(inputs.size(), -1);
+    mOutputRows.assign(outputs.size(), 0);
+    const int nProcesses = processes.size();
+    const int nInputs = inputs.size();
+    const int nOutputs = outputs.size();
+    o2::framework::AxisSpec axisProcess{nProcesses, -0.5, nProcesses - 0.5, "process function"};
+    o2::framework::AxisSpec axisInput{nInputs, -0.5, nInputs - 0.5, "input"};
+    o2::framework::AxisSpec axisOutput{nOutputs, -0.5, nOutputs - 0.5, "output"};
+    // the empty inputs and outputs are in the underflow of the rows
+    o2::framework::AxisSpec axisRows{70, 1., 1.e7, "rows per call"};
+    axisRows.makeLogarithmic();
+    o2::framework::AxisSpec axisReferenceRows{70, 1., 1.e7, inputs.empty() ? "rows per call" : inputs[0] + " per call"};
+    axisReferenceRows.makeLogarithmic();
+    o2::framework::AxisSpec axisTime{140, 0.1, 1.e6, "time per call (#mus)"};
+    axisTime.makeLogarithmic();
+    mTimePerCall = registry.add<TH2>((folder + "/hTimePerCall").c_str(), "Time of the process calls", o2::framework::kTH2F, {axisProcess, axisTime});
+    mTotalTime = registry.add<TH1>((folder + "/hTotalTime").c_str(), "Total time of the process calls;;time (#mus)", o2::framework::kTH1D, {axisProcess});
+    mCalls = registry.add<TH1>((folder + "/hCalls").c_str(), "Process calls;;calls", o2::framework::kTH1D, {axisProcess});
+    mTimeVsRows = registry.add<TH3>((folder + "/hTimeVsRows").c_str(), "Time of the process calls vs rows of the first input", o2::framework::kTH3F, {axisProcess, axisReferenceRows, axisTime});
+    mInputRowsPerCall = registry.add<TH2>((folder + "/hInputRows").c_str(), "Input rows of the process calls", o2::framework::kTH2F, {axisInput, axisRows});
+    mOutputRowsPerCall = registry.add<TH2>((folder + "/hOutputRows").c_str(), "Output rows of the process calls", o2::framework::kTH2F, {axisOutput, axisRows});
+    for (int i = 0; i < nProcesses; i++) {
+      mTimePerCall->GetXaxis()->SetBinLabel(i + 1, processes[i].c_str());
+      mTotalTime->GetXaxis()->SetBinLabel(i + 1, processes[i].c_str());
+      mCalls->GetXaxis()->SetBinLabel(i + 1, processes[i].c_str());
+      mTimeVsRows->GetXaxis()->SetBinLabel(i + 1, processes[i].c_str());
+    }
+    for (int i = 0; i < nInputs; i++) {
+      mInputRowsPerCall->GetXaxis()->SetBinLabel(i + 1, inputs[i].c_str());
+    }
+    for (int i = 0; i < nOutputs; i++) {
+      mOutputRowsPerCall->GetXaxis()->SetBinLabel(i + 1, outputs[i].c_str());
+    }
+  }
+
+  bool isEnabled() const { return mEnabled; }
+
+  Call call(int process) { return Call(mEnabled ? this : nullptr, process); }
+
+  /// Sets the rows of an input of the current call
+  void setInputRows(int input, int64_t rows)
+  {
+    if (mEnabled) {
+      mInputRows[input] = rows;
+    }
+  }
+
+  /// Adds rows to an output of the current call
+  void addOutputRows(int output, int64_t rows)
+  {
+    if (mEnabled) {
+      mOutputRows[output] += rows;
+    }
+  }
+
+  /// Fills the histograms of a call and resets the rows, the inputs not set during the call are not filled
+  void fill(int process, double elapsed)
+  {
+    if (!mEnabled) {
+      return;
+    }
+    mTimePerCall->Fill(process, elapsed);
+    mTotalTime->Fill(process, elapsed);
+    mCalls->Fill(process);
+    if (!mInputRows.empty() && mInputRows[0] >= 0) {
+      mTimeVsRows->Fill(process, mInputRows[0], elapsed);
+    }
+    for (std::size_t i = 0; i < mInputRows.size(); i++) {
+      if (mInputRows[i] >= 0) {
+        mInputRowsPerCall->Fill(i, mInputRows[i]);
+      }
+      mInputRows[i] = -1;
+    }
+    for (std::size_t i = 0; i < mOutputRows.size(); i++) {
+      mOutputRowsPerCall->Fill(i, mOutputRows[i]);
+      mOutputRows[i] = 0;
+    }
+  }
+
+ private:
+  bool mEnabled = false;
+  std::vector<int64_t> mInputRows;         ///< rows of the inputs in the current call, -1 if not set
+  std::vector<int64_t> mOutputRows;        ///< rows of the outputs in the current call
+  std::shared_ptr<TH2> mTimePerCall;       ///< time per call vs process function
+  std::shared_ptr<TH1> mTotalTime;         ///< total time per process function
+  std::shared_ptr<TH1> mCalls;             ///< calls per process function
+  std::shared_ptr<TH3> mTimeVsRows;        ///< time per call vs rows of the first input vs process function
+  std::shared_ptr<TH2> mInputRowsPerCall;  ///< input rows per call vs input
+  std::shared_ptr<TH2> mOutputRowsPerCall; ///< output rows per call vs output
+};
+
+} // namespace o2::common
+
+#define O2_DF_TELEMETRY_CONCAT_IMPL(a, b) a##b
+#define O2_DF_TELEMETRY_CONCAT(a, b) O2_DF_TELEMETRY_CONCAT_IMPL(a, b)
+#ifndef O2PHYSICS_DISABLE_REGION_TIMERS
+/// Records the rest of the enclosing block as a call of process of telemetry
+#define O2_DF_TELEMETRY(telemetry, process) const o2::common::DataframeTelemetry::Call O2_DF_TELEMETRY_CONCAT(dfTelemetryCall, __LINE__) = (telemetry).call(process)
+#else
+#define O2_DF_TELEMETRY(telemetry, process)
+#endif
+
+#endif // COMMON_CORE_DATAFRAMETELEMETRY_H_
@@ -12,6 +12,12 @@
 #ifndef ANALYSIS_CORE_EVENTMIXING_H_
 #define ANALYSIS_CORE_EVENTMIXING_H_
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
 namespace eventmixing
 {
 /// Calculate hash for an element based on 2 properties and their bins.
@@ -33,18 +39,132 @@ static int getMixingBin(const T1& vtxBins, const T1& multBins, const T2& vtx, co
     return -1;
   }
 
-  for (unsigned int i = 1; i < vtxBins.size(); i++) {
-    if (vtx < vtxBins.at(i)) {
-      for (unsigned int j = 1; j < multBins.size(); j++) {
-        if (mult < multBins.at(j)) {
-          return i + j * (vtxBins.size() + 1);
-        }
-      }
-    }
-  }
+  // first bin edges above the values
+  const unsigned int i = std::upper_bound(vtxBins.begin(), vtxBins.end(), vtx) - vtxBins.begin();
+  const unsigned int j = std::upper_bound(multBins.begin(), multBins.end(), mult) - multBins.begin();
   // overflow
-  return -1;
+  if (i == vtxBins.size() || j == multBins.size()) {
+    return -1;
+  }
+  return i + j * (vtxBins.size() + 1);
 }
+
+/// Binning of one mixing variable, with direct arithmetic for uniform bins and binary search otherwise
+/// \tparam T Data type of the bin edges
+template <typename T>
+class MixingAxis
+{
+ public:
+  MixingAxis() = default;
+  explicit MixingAxis(std::vector<T> const& edges) : mEdges(edges)
+  {
+    if (mEdges.size() < 3) {
+      return;
+    }
+    const T width = (mEdges.back() - mEdges.front()) / (mEdges.size() - 1);
+    mIsUniform = width > 0;
+    for (std::size_t i = 1; i < mEdges.size() && mIsUniform; ++i) {
+      mIsUniform = std::abs(mEdges[i] - mEdges[i - 1] - width) <= 1.e-5 * width;
+    }
+    if (mIsUniform) {
+      mInvWidth = 1. / width;
+    }
+  }
+
+  /// \param value Value of the mixing variable
+  /// \return Index of the first bin edge above the value, -1 in case of underflow or overflow
+  template <typename V>
+  int getBin(const V& value) const
+  {
+    if (mEdges.empty() || !(value >= mEdges.front()) || !(value < mEdges.back())) { // also rejects NaN
+      return -1;
+    }
+    if (!mIsUniform) {
+      return std::upper_bound(mEdges.begin(), mEdges.end(), value) - mEdges.begin();
+    }
+    const int nEdges = mEdges.size();
+    int bin = std::clamp(static_cast<int>((value - mEdges.front()) * mInvWidth) + 1, 1, nEdges - 1);
+    // the arithmetic can be off by one bin at the edges because of rounding
+    if (value >= mEdges[bin]) {
+      ++bin;
+    } else if (value < mEdges[bin - 1]) {
+      --bin;
+    }
+    return bin;
+  }
+
+  std::size_t getNEdges() const { return mEdges.size(); }
+  bool isUniform() const { return mIsUniform; }
+
+ private:
+  std::vector<T> mEdges{};
+  bool mIsUniform = false;
+  double mInvWidth = 0.;
+};
+
+/// Calculate hashes of elements based on N properties and their bins.
+/// For two properties the hash is the same as the one of getMixingBin.
+/// \tparam N Number of mixing variables
+/// \tparam T Data type of the bin edges
+template <std::size_t N, typename T = float>
+class MixingBinning
+{
+ public:
+  MixingBinning() = default;
+  explicit MixingBinning(std::array<std::vector<T>, N> const& edges)
+  {
+    int stride = 1;
+    for (std::size_t iAxis = 0; iAxis < N; ++iAxis) {
+      mAxes[iAxis] = MixingAxis<T>(edges[iAxis]);
+      mStrides[iAxis] = stride;
+      stride *= edges[iAxis].size() + 1;
+    }
+  }
+
+  /// \param values Values of the mixing variables of the element, one per axis
+  /// \return Hash of the element, -1 in case of underflow or overflow in any variable
+  template <typename... V>
+  int getBin(const V&... values) const
+  {
+    static_assert(sizeof...(V) == N, "One value per mixing variable is needed");
+    int hash = 0;
+    bool isInRange = true;
+    std::size_t iAxis = 0;
+    ((isInRange = isInRange && addToHash(iAxis++, values, hash)), ...);
+    return isInRange ? hash : -1;
+  }
+
+  /// Calculate the hashes of all the rows of a table
+  /// \param table Table, e.g. of collisions
+  /// \param hashes Vector filled with the hash of each row
+  /// \param getters Callables returning the mixing variables of a row, one per axis
+  template <typename TTable, typename... Getters>
+  void getBins(const TTable& table, std::vector<int>& hashes, const Getters&... getters) const
+  {
+    hashes.clear();
+    hashes.reserve(table.size());
+    for (auto const& row : table) {
+      hashes.push_back(getBin(getters(row)...));
+    }
+  }
+
+  const MixingAxis<T>& getAxis(std::size_t iAxis) const { return mAxes[iAxis]; }
+
+ private:
+  template <typename V>
+  bool addToHash(std::size_t iAxis, const V& value, int& hash) const
+  {
+    const int bin = mAxes[iAxis].getBin(value);
+    if (bin < 0) {
+      return false;
+    }
+    hash += bin * mStrides[iAxis];
+    return true;
+  }
+
+  std::array<MixingAxis<T>, N> mAxes{};
+  std::array<int, N> mStrides{};
+};
 }; // namespace eventmixing
 
 #endif /* ANALYSIS_CORE_EVENTMIXING_H_ */
@@ -0,0 +1,125 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   EventMixingPool.h
+/// \brief  Bounded-memory pools of past events for event mixing
+///         Events are stored per mixing bin in ring buffers, keeping only the compacted particle payloads
+///         needed by the pair kernel. The pools persist across dataframes.
+///
+
+#ifndef COMMON_CORE_EVENTMIXINGPOOL_H_
+#define COMMON_CORE_EVENTMIXINGPOOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace eventmixing
+{
+/// Pools of past events, one ring buffer per mixing bin
+/// \tparam TEventInfo Event-level quantities needed for the mixing (e.g. multiplicity, magnetic field)
+/// \tparam TParticle Compacted particle payload
+template <typename TEventInfo, typename TParticle>
+class MixingPool
+{
+ public:
+  struct Event {
+    TEventInfo info;
+    std::vector<TParticle> particles;
+    uint64_t id;
+  };
+
+  MixingPool() = default;
+  MixingPool(int nBins, int depth, std::size_t maxMemory = 0) { setup(nBins, depth, maxMemory); }
+
+  /// \param nBins Number of mixing bins
+  /// \param depth Maximum number of events kept per bin
+  /// \param maxMemory Maximum memory used by all the pools in bytes, the oldest events are dropped first (0 = no limit)
+  void setup(int nBins, int depth, std::size_t maxMemory = 0)
+  {
+    mPools.assign(nBins, std::deque<Event>{});
+    mDepth = depth;
+    mMaxMemory = maxMemory;
+    mMemory = 0;
+  }
+
+  /// Calls the function for each event of the pool of a bin, from the oldest to the newest
+  /// \param bin Mixing bin, out-of-range bins are skipped
+  /// \param function Callable taking an Event const&
+  template <typename F>
+  void mix(int bin, F&& function) const
+  {
+    if (bin < 0 || bin >= static_cast<int>(mPools.size())) {
+      return;
+    }
+    for (auto const& event : mPools[bin]) {
+      function(event);
+    }
+  }
+
+  /// Stores an event in the pool of its bin, dropping the oldest events beyond the depth or the memory limit
+  /// \param bin Mixing bin, events in out-of-range bins are not stored
+  /// \param info Event-level quantities
+  /// \param particles Compacted particles, moved into the pool
+  void push(int bin, TEventInfo const& info, std::vector<TParticle>&& particles)
+  {
+    if (bin < 0 || bin >= static_cast<int>(mPools.size()) || mDepth <= 0) {
+      return;
+    }
+    auto& pool = mPools[bin];
+    if (static_cast<int>(pool.size()) == mDepth) {
+      popOldest(bin);
+    }
+    pool.push_back(Event{info, std::move(particles), mNextId++});
+    mMemory += getMemory(pool.back());
+
+    // drop the oldest events of all the pools until the memory limit is respected again
+    while (mMaxMemory > 0 && mMemory > mMaxMemory) {
+      int oldestBin = -1;
+      for (int iBin = 0; iBin < static_cast<int>(mPools.size()); ++iBin) {
+        if (!mPools[iBin].empty() && (oldestBin < 0 || mPools[iBin].front().id < mPools[oldestBin].front().id)) {
+          oldestBin = iBin;
+        }
+      }
+      if (oldestBin < 0) {
+        break;
+      }
+      popOldest(oldestBin);
+    }
+  }
+
+  void clear() { setup(mPools.size(), mDepth, mMaxMemory); }
+
+  std::size_t getNEvents(int bin) const { return mPools[bin].size(); }
+  std::size_t getMemory() const { return mMemory; }
+  int getDepth() const { return mDepth; }
+
+ private:
+  static std::size_t getMemory(Event const& event) { return sizeof(Event) + event.particles.capacity() * sizeof(TParticle); }
+
+  void popOldest(int bin)
+  {
+    mMemory -= getMemory(mPools[bin].front());
+    mPools[bin].pop_front();
+  }
+
+  std::vector<std::deque<Event>> mPools{};
+  int mDepth = 0;
+  std::size_t mMaxMemory = 0;
+  std::size_t mMemory = 0;
+  uint64_t mNextId = 0;
+};
+}; // namespace eventmixing
+
+#endif /* COMMON_CORE_EVENTMIXINGPOOL_H_ */
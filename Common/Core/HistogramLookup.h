@@ -0,0 +1,87 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   HistogramLookup.h
+/// \brief  Flat copy of the bin contents of a 1D calibration histogram
+///         The equivalent of h->GetBinContent(h->FindFixBin(x)) with the edges and contents of the histogram
+///         copied into arrays when the calibration is loaded: an index computation for uniform bins and a
+///         binary search of the edges for variable bins, without virtual calls.
+///
+
+#ifndef COMMON_CORE_HISTOGRAMLOOKUP_H_
+#define COMMON_CORE_HISTOGRAMLOOKUP_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "TH1.h"
+
+namespace o2::common
+{
+
+class HistogramLookup
+{
+ public:
+  HistogramLookup() = default;
+  explicit HistogramLookup(TH1 const* h) { set(h); }
+
+  /// Copies the x axis and the contents of h, including the underflow and overflow bins, clears the lookup if h is null
+  void set(TH1 const* h)
+  {
+    mContents.clear();
+    mEdges.clear();
+    if (h == nullptr) {
+      return;
+    }
+    const TAxis* axis = h->GetXaxis();
+    mNBins = axis->GetNbins();
+    mMin = axis->GetXmin();
+    mMax = axis->GetXmax();
+    mContents.resize(mNBins + 2);
+    for (int bin = 0; bin <= mNBins + 1; bin++) {
+      mContents[bin] = h->GetBinContent(bin);
+    }
+    if (axis->GetXbins()->GetSize() > 0) {
+      mEdges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + mNBins + 1);
+    }
+  }
+
+  bool isSet() const { return !mContents.empty(); }
+
+  /// Bin of x as given by TAxis::FindFixBin
+  int findBin(double x) const
+  {
+    if (x < mMin) {
+      return 0;
+    }
+    if (!(x < mMax)) {
+      return mNBins + 1;
+    }
+    if (mEdges.empty()) {
+      return 1 + static_cast<int>(mNBins * (x - mMin) / (mMax - mMin));
+    }
+    return std::distance(mEdges.begin(), std::upper_bound(mEdges.begin(), mEdges.end(), x));
+  }
+
+  double operator()(double x) const { return mContents[findBin(x)]; }
+
+ private:
+  int mNBins = 0;
+  double mMin = 0.;
+  double mMax = 0.;
+  std::vector<double> mContents; ///< contents of the bins 0 to nbins + 1
+  std::vector<double> mEdges;    ///< bin edges, empty if the bins are uniform
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_HISTOGRAMLOOKUP_H_
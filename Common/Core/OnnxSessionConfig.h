@@ -0,0 +1,135 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   OnnxSessionConfig.h
+/// \brief  Configuration of the ONNX runtime sessions of the ML tasks
+///         Graph optimisation level, intra- and inter-op threads, CPU execution providers and quantised model variant.
+///         The execution providers are tried in the given order and the ones not available in the ONNX runtime build are
+///         skipped with a warning, the default CPU provider is always the last resort.
+///         A model variant (e.g. "int8" or "fp16") is a separate model file next to the FP32 reference: its name is the
+///         reference name with "_<variant>" appended before the ".onnx" extension, or at the end of a CCDB path.
+///
+
+#ifndef COMMON_CORE_ONNXSESSIONCONFIG_H_
+#define COMMON_CORE_ONNXSESSIONCONFIG_H_
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
+
+#include "Framework/Logger.h"
+
+namespace o2::common
+{
+
+struct OnnxSessionConfig {
+  int optimizationLevel = 99;          // graph optimisation: 0 disabled, 1 basic, 2 extended, 99 all
+  int intraOpNumThreads = 0;           // threads inside one operator, 0 for the ONNX runtime default
+  int interOpNumThreads = 0;           // threads running independent operators in parallel, 0 for sequential execution
+  std::string executionProviders = ""; // comma-separated execution providers to try, e.g. "XNNPACK,OpenVINO"
+  std::string modelVariant = "";       // quantised variant of the models, e.g. "int8" or "fp16", empty for the FP32 reference
+
+  /// Key identifying sessions created with the same options
+  std::string key() const
+  {
+    return std::to_string(optimizationLevel) + "#" + std::to_string(intraOpNumThreads) + "#" + std::to_string(interOpNumThreads) + "#" + executionProviders;
+  }
+
+  /// Path of the model variant, the path itself without variant
+  std::string variantPath(std::string const& path) const
+  {
+    if (modelVariant.empty()) {
+      return path;
+    }
+    const std::string extension = ".onnx";
+    if (path.size() > extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+      return path.substr(0, path.size() - extension.size()) + "_" + modelVariant + extension;
+    }
+    return path + "_" + modelVariant;
+  }
+
+  Ort::SessionOptions makeSessionOptions() const
+  {
+    Ort::SessionOptions options;
+    switch (optimizationLevel) {
+      case 0:
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+        break;
+      case 1:
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
+        break;
+      case 2:
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+        break;
+      default:
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    }
+    if (intraOpNumThreads > 0) {
+      options.SetIntraOpNumThreads(intraOpNumThreads);
+    }
+    if (interOpNumThreads > 0) {
+      options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+      options.SetInterOpNumThreads(interOpNumThreads);
+    }
+    appendExecutionProviders(options);
+    return options;
+  }
+
+ private:
+  static std::string toLower(std::string s)
+  {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+  }
+
+  void appendExecutionProviders(Ort::SessionOptions& options) const
+  {
+    if (executionProviders.empty()) {
+      return;
+    }
+    // names of the providers of the ONNX runtime build, e.g. XnnpackExecutionProvider
+    std::vector<std::string> available;
+    for (auto const& provider : Ort::GetAvailableProviders()) {
+      available.push_back(toLower(provider));
+    }
+    std::stringstream providers(executionProviders);
+    std::string provider;
+    while (std::getline(providers, provider, ',')) {
+      provider.erase(std::remove_if(provider.begin(), provider.end(), [](unsigned char c) { return std::isspace(c); }), provider.end());
+      if (provider.empty()) {
+        continue;
+      }
+      if (std::find(available.begin(), available.end(), toLower(provider) + "executionprovider") == available.end()) {
+        LOGF(warning, "ONNX execution provider %s is not available, skipped", provider.data());
+        continue;
+      }
+      try {
+        if (toLower(provider) == "openvino") {
+          options.AppendExecutionProvider_OpenVINO(OrtOpenVINOProviderOptions{});
+        } else {
+          options.AppendExecutionProvider(provider);
+        }
+        LOGF(info, "ONNX execution provider %s enabled", provider.data());
+      } catch (const Ort::Exception& exception) {
+        LOGF(warning, "ONNX execution provider %s cannot be enabled, skipped: %s", provider.data(), exception.what());
+      }
+    }
+  }
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_ONNXSESSIONCONFIG_H_
@@ -124,6 +124,49 @@ class TOFResoParams : public o2::pid::PidParameters<5>
   ClassDef(TOFResoParams, 1);
 };
 
+/// \brief Per-track quantities shared by the expected times and resolutions of all mass hypotheses.
+/// Filled once per track, it reduces the evaluation for a given hypothesis to a few operations with the mass.
+struct ExpTimesTrackCache {
+  bool hasTOF = false;          /// Track has a TOF measurement
+  float tofSignal = 0.f;        /// TOF signal
+  float deltaSignal = 0.f;      /// TOF signal minus collision time
+  float expMom2 = 0.f;          /// Squared TOF expected momentum
+  float lengthOverExpMom = 0.f; /// length / (c * TOF expected momentum)
+  float mom = 0.f;              /// Momentum of the track
+  float mom2 = 0.f;             /// Squared momentum of the track
+  float dppBase = 0.f;          /// Mass independent part of the relative momentum resolution
+  float dppMassTerm = 0.f;      /// Coefficient of the mass in the relative momentum resolution
+  float sigmaConst2 = 0.f;      /// Mass independent part of the squared resolution
+
+  /// Fills the cache for a track, given the response parameters and the collision time
+  /// \param parameters Detector response parameters
+  /// \param track Track of interest
+  /// \param collisionTime Collision time
+  /// \param collisionTimeRes Collision time resolution of the track of interest
+  template <typename TrackType>
+  void Set(const TOFResoParams& parameters, const TrackType& track, const float collisionTime, const float collisionTimeRes)
+  {
+    hasTOF = track.hasTOF();
+    tofSignal = track.tofSignal();
+    deltaSignal = tofSignal - collisionTime;
+    const float expMom = track.trackType() == o2::aod::track::Run2Track ? track.tofExpMom() / kCSPEED : track.tofExpMom();
+    expMom2 = expMom * expMom;
+    lengthOverExpMom = track.length() / (kCSPEED * expMom);
+    mom = track.p();
+    if (mom <= 0) {
+      return;
+    }
+    mom2 = mom * mom;
+    dppBase = parameters[0] + parameters[1] * mom;
+    dppMassTerm = parameters[2] / mom;
+    sigmaConst2 = parameters[3] * parameters[3] / mom2 + parameters[4] * parameters[4] + collisionTimeRes * collisionTimeRes;
+  }
+
+  /// Fills the cache for a track, using the event time of the track
+  template <typename TrackType>
+  void Set(const TOFResoParams& parameters, const TrackType& track) { Set(parameters, track, track.tofEvTime(), track.tofEvTimeErr()); }
+};
+
 /// \brief Class to handle the the TOF detector response for the expected time
 template <typename TrackType, o2::track::PID::ID id>
 class ExpTimes
@@ -184,6 +227,26 @@ class ExpTimes
     return std::sqrt(sigma * sigma + parameters[3] * parameters[3] / mom / mom + parameters[4] * parameters[4] + collisionTimeRes * collisionTimeRes);
   }
 
+  /// Gets the expected signal of the track of interest under the PID assumption from the precomputed track quantities
+  /// \param cache Per-track cache
+  static float GetExpectedSignal(const ExpTimesTrackCache& cache) { return cache.hasTOF ? cache.lengthOverExpMom * std::sqrt(mMassZSqared + cache.expMom2) : defaultReturnValue; }
+
+  /// Gets the expected resolution of the t-texp-t0 from the precomputed track quantities
+  /// \param cache Per-track cache, filled with the detector response parameters of interest
+  static float GetExpectedSigma(const ExpTimesTrackCache& cache)
+  {
+    if (cache.mom <= 0) {
+      return -999.f;
+    }
+    const float dpp = cache.dppBase + cache.dppMassTerm * mMassZ; // mean relative pt resolution;
+    const float sigma = dpp * cache.tofSignal / (1.f + cache.mom2 / mMassZSqared);
+    return std::sqrt(sigma * sigma + cache.sigmaConst2);
+  }
+
+  /// Gets the number of sigmas with respect the expected time from the precomputed track quantities
+  /// \param cache Per-track cache, filled with the detector response parameters of interest
+  static float GetSeparation(const ExpTimesTrackCache& cache) { return cache.hasTOF ? (cache.deltaSignal - GetExpectedSignal(cache)) / GetExpectedSigma(cache) : defaultReturnValue; }
+
   /// Gets the expected resolution of the t-texp-t0
   /// \param response Detector response with parameters
   /// \param track Track of interest
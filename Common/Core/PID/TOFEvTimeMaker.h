@@ -0,0 +1,236 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   TOFEvTimeMaker.h
+/// \brief  TOF event time of many collisions from the TOF times of their track samples
+///         The tracks of the samples are stored one after the other, collision after collision, with their event time
+///         candidates (TOF signal minus expected time) and weights for the pion, kaon and proton hypotheses.
+///         The event time of a collision is the weighted mean of the candidates of the combination of hypotheses with the
+///         minimum chi2. The minimum is searched with a branch-and-bound over the hypotheses of the tracks: the chi2 of a
+///         partial combination is a lower bound of the chi2 of all its completions, so that the branches which cannot beat
+///         the best combination found so far are cut. The hypotheses of a track are tried starting from the candidate closest
+///         to the current mean, hence the first complete combination is already a good bound.
+///         Large samples are split into groups of at most maxGroupSize tracks, searched independently.
+///         The collisions are independent of each other and are computed on several threads if requested.
+///
+
+#ifndef COMMON_CORE_PID_TOFEVTIMEMAKER_H_
+#define COMMON_CORE_PID_TOFEVTIMEMAKER_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace o2::pid::tof
+{
+
+class EvTimeMaker
+{
+ public:
+  static constexpr int kNHypotheses = 3; /// pion, kaon, proton
+  static constexpr int kMaxGroupSize = 20;
+
+  struct EvTime {
+    float eventTime = 0.f;
+    float eventTimeError = 0.f;
+    int multiplicity = 0;
+  };
+
+  /// Resolution assigned to the collisions without TOF event time
+  void setDiamondError(float diamondError) { mDiamondError = diamondError; }
+  /// Maximum number of tracks searched together
+  void setMaxGroupSize(int maxGroupSize) { mMaxGroupSize = std::clamp(maxGroupSize, 1, kMaxGroupSize); }
+
+  void clear()
+  {
+    mOffsets.assign(1, 0);
+    for (int h = 0; h < kNHypotheses; h++) {
+      mT0[h].clear();
+      mWeight[h].clear();
+    }
+    mChosenT0.clear();
+    mChosenWeight.clear();
+    mSumOfWeights.clear();
+    mSumOfWeightedT0.clear();
+  }
+
+  /// Starts the track sample of a new collision
+  /// \return index of the collision
+  int newCollision()
+  {
+    mOffsets.push_back(mOffsets.back());
+    return mOffsets.size() - 2;
+  }
+
+  /// Adds a track to the sample of the last collision
+  /// \param tofSignal TOF signal of the track
+  /// \param expTimes expected times for the pion, kaon and proton hypotheses
+  /// \param expSigmas expected resolutions for the pion, kaon and proton hypotheses
+  /// \return index of the track in the sample of its collision, -1 if the track is not usable
+  int addTrack(float tofSignal, std::array<float, kNHypotheses> const& expTimes, std::array<float, kNHypotheses> const& expSigmas)
+  {
+    for (int h = 0; h < kNHypotheses; h++) {
+      if (!(expSigmas[h] > 0.f)) {
+        return -1;
+      }
+    }
+    for (int h = 0; h < kNHypotheses; h++) {
+      mT0[h].push_back(tofSignal - expTimes[h]);
+      mWeight[h].push_back(1.f / (expSigmas[h] * expSigmas[h]));
+    }
+    return mOffsets.back()++ - mOffsets[mOffsets.size() - 2];
+  }
+
+  int nCollisions() const { return mOffsets.size() - 1; }
+
+  /// Computes the event time of all the collisions
+  void compute(int nThreads = 1)
+  {
+    const int nColls = nCollisions();
+    mChosenT0.assign(mOffsets.back(), 0.f);
+    mChosenWeight.assign(mOffsets.back(), 0.f);
+    mSumOfWeights.assign(nColls, 0.);
+    mSumOfWeightedT0.assign(nColls, 0.);
+    const int nWorkers = std::min(std::max(1, nThreads), nColls);
+    if (nWorkers <= 1) {
+      for (int i = 0; i < nColls; i++) {
+        computeCollision(i);
+      }
+      return;
+    }
+    // the collisions are pulled one by one from a shared counter, each writes only to its own results
+    std::atomic<int> nextCollision{0};
+    auto worker = [&]() {
+      for (int i = nextCollision++; i < nColls; i = nextCollision++) {
+        computeCollision(i);
+      }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(nWorkers - 1);
+    for (int iWorker = 1; iWorker < nWorkers; iWorker++) {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+      thread.join();
+    }
+  }
+
+  /// Event time of a collision, without the contribution of one track of its sample to avoid its bias
+  /// \param collision index of the collision
+  /// \param sampleTrack index of the track in the sample of the collision, -1 for the tracks not in the sample
+  /// \param minMultiplicity minimum number of tracks left in the sample to give an event time
+  EvTime getEventTime(int collision, int sampleTrack = -1, int minMultiplicity = 1) const
+  {
+    EvTime evTime;
+    evTime.multiplicity = mOffsets[collision + 1] - mOffsets[collision];
+    double sumOfWeights = mSumOfWeights[collision];
+    double sumOfWeightedT0 = mSumOfWeightedT0[collision];
+    int nTracks = evTime.multiplicity;
+    if (sampleTrack >= 0) {
+      const int i = mOffsets[collision] + sampleTrack;
+      sumOfWeights -= mChosenWeight[i];
+      sumOfWeightedT0 -= mChosenWeight[i] * mChosenT0[i];
+      nTracks--;
+    }
+    if (nTracks < std::max(1, minMultiplicity) || sumOfWeights <= 0.) {
+      evTime.eventTime = 0.f;
+      evTime.eventTimeError = mDiamondError;
+      return evTime;
+    }
+    evTime.eventTime = sumOfWeightedT0 / sumOfWeights;
+    evTime.eventTimeError = 1. / std::sqrt(sumOfWeights);
+    return evTime;
+  }
+
+ private:
+  // state of the search of the best hypotheses of a group of tracks
+  struct Search {
+    int first = 0;
+    int n = 0;
+    double reference = 0.; // subtracted from the candidates to limit the cancellations in the chi2
+    std::array<int, kMaxGroupSize> current{};
+    std::array<int, kMaxGroupSize> best{};
+    double bestChi2 = std::numeric_limits<double>::max();
+  };
+
+  void searchGroup(Search& search, int k, double sumW, double sumWT, double sumWT2) const
+  {
+    if (k == search.n) {
+      search.bestChi2 = sumWT2 - sumWT * sumWT / sumW;
+      search.best = search.current;
+      return;
+    }
+    const int i = search.first + k;
+    std::array<int, kNHypotheses> order;
+    std::array<double, kNHypotheses> distance;
+    for (int h = 0; h < kNHypotheses; h++) {
+      order[h] = h;
+      distance[h] = sumW > 0. ? std::abs(mT0[h][i] - search.reference - sumWT / sumW) : h;
+    }
+    std::sort(order.begin(), order.end(), [&distance](int a, int b) { return distance[a] < distance[b]; });
+    for (auto h : order) {
+      const double w = mWeight[h][i];
+      const double t = mT0[h][i] - search.reference;
+      const double newSumW = sumW + w;
+      const double newSumWT = sumWT + w * t;
+      const double newSumWT2 = sumWT2 + w * t * t;
+      // the chi2 of the tracks so far can only grow with the next tracks
+      if (newSumWT2 - newSumWT * newSumWT / newSumW >= search.bestChi2) {
+        continue;
+      }
+      search.current[k] = h;
+      searchGroup(search, k + 1, newSumW, newSumWT, newSumWT2);
+    }
+  }
+
+  void computeCollision(int collision)
+  {
+    double sumOfWeights = 0.;
+    double sumOfWeightedT0 = 0.;
+    for (int first = mOffsets[collision]; first < mOffsets[collision + 1]; first += mMaxGroupSize) {
+      Search search;
+      search.first = first;
+      search.n = std::min(mMaxGroupSize, mOffsets[collision + 1] - first);
+      search.reference = mT0[0][first];
+      searchGroup(search, 0, 0., 0., 0.);
+      for (int k = 0; k < search.n; k++) {
+        const int h = search.best[k];
+        mChosenT0[first + k] = mT0[h][first + k];
+        mChosenWeight[first + k] = mWeight[h][first + k];
+        sumOfWeights += mWeight[h][first + k];
+        sumOfWeightedT0 += double(mWeight[h][first + k]) * mT0[h][first + k];
+      }
+    }
+    mSumOfWeights[collision] = sumOfWeights;
+    mSumOfWeightedT0[collision] = sumOfWeightedT0;
+  }
+
+  float mDiamondError = 0.f;
+  int mMaxGroupSize = 10;
+  std::vector<int> mOffsets = {0}; // first track of every collision, and total number of tracks at the end
+  std::array<std::vector<float>, kNHypotheses> mT0;
+  std::array<std::vector<float>, kNHypotheses> mWeight;
+  // results
+  std::vector<float> mChosenT0;
+  std::vector<float> mChosenWeight;
+  std::vector<double> mSumOfWeights;
+  std::vector<double> mSumOfWeightedT0;
+};
+
+} // namespace o2::pid::tof
+
+#endif // COMMON_CORE_PID_TOFEVTIMEMAKER_H_
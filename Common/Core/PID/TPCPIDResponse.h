@@ -38,6 +38,50 @@ class Response
   Response() = default;
   ~Response() = default;
 
+  /// \brief Column-wise copy of the track quantities entering the response, used for the batched evaluation
+  struct TrackBatch {
+    std::vector<float> tpcInnerParam;
+    std::vector<float> tpcSignal;
+    std::vector<float> tgl;
+    std::vector<float> signed1Pt;
+    std::vector<float> tpcNClsFound;
+    std::vector<float> multTPC;
+    std::vector<uint8_t> hasTPC;
+
+    std::size_t size() const { return tpcInnerParam.size(); }
+    void reserve(const std::size_t n)
+    {
+      tpcInnerParam.reserve(n);
+      tpcSignal.reserve(n);
+      tgl.reserve(n);
+      signed1Pt.reserve(n);
+      tpcNClsFound.reserve(n);
+      multTPC.reserve(n);
+      hasTPC.reserve(n);
+    }
+    void clear()
+    {
+      tpcInnerParam.clear();
+      tpcSignal.clear();
+      tgl.clear();
+      signed1Pt.clear();
+      tpcNClsFound.clear();
+      multTPC.clear();
+      hasTPC.clear();
+    }
+    template <typename TrackType>
+    void push_back(const TrackType& track, const float mult)
+    {
+      tpcInnerParam.push_back(track.tpcInnerParam());
+      tpcSignal.push_back(track.tpcSignal());
+      tgl.push_back(track.tgl());
+      signed1Pt.push_back(track.signed1Pt());
+      tpcNClsFound.push_back(track.tpcNClsFound());
+      multTPC.push_back(mult);
+      hasTPC.push_back(track.hasTPC());
+    }
+  };
+
   /// Setter and Getter for the private parameters
   void SetBetheBlochParams(const std::array<float, 5>& betheBlochParams) { mBetheBlochParams = betheBlochParams; }
   void SetResolutionParamsDefault(const std::array<float, 2>& resolutionParamsDefault) { mResolutionParamsDefault = resolutionParamsDefault; }
@@ -82,6 +126,9 @@ class Response
   float GetSignalDelta(const TrackType& trk, const o2::track::PID::ID id) const;
   /// Gets relative dEdx resolution contribution due to relative pt resolution
   float GetRelativeResolutiondEdx(const float p, const float mass, const float charge, const float resol) const;
+  /// Gets the number of sigmas (and optionally the expected resolution) for all the tracks of the batch under one mass hypothesis.
+  /// The output arrays must hold batch.size() elements.
+  void GetNumberOfSigma(const TrackBatch& batch, const o2::track::PID::ID id, float* nSigma, float* expSigma = nullptr) const;
 
   void PrintAll() const;
 
@@ -179,6 +226,46 @@ inline float Response::GetRelativeResolutiondEdx(const float p, const float mass
   return deltaRel;
 }
 
+/// Batched evaluation: the expected signal and resolution are computed once per track, the species-dependent terms once per batch
+inline void Response::GetNumberOfSigma(const TrackBatch& batch, const o2::track::PID::ID id, float* nSigma, float* expSigma) const
+{
+  const float mass = o2::track::pid_constants::sMasses[id];
+  const float invMass = 1.f / mass;
+  const float charge = o2::track::pid_constants::sCharges[id];
+  const float chargeFactor = std::pow(charge, mChargeFactor);
+  const std::size_t n = batch.size();
+
+  for (std::size_t i = 0; i < n; i++) {
+    float signal = -999.f;
+    float sigma = -999.f;
+    if (batch.hasTPC[i]) {
+      const float p = batch.tpcInnerParam[i];
+      const float dEdx = o2::tpc::BetheBlochAleph(p * invMass, mBetheBlochParams[0], mBetheBlochParams[1], mBetheBlochParams[2], mBetheBlochParams[3], mBetheBlochParams[4]) * chargeFactor;
+      const float bethe = mMIP * dEdx;
+      signal = bethe >= 0.f ? bethe : -999.f;
+
+      const float ncls = batch.tpcNClsFound[i];
+      if (mUseDefaultResolutionParam) {
+        sigma = batch.tpcSignal[i] * mResolutionParamsDefault[0] * (ncls > 0 ? std::sqrt(1. + mResolutionParamsDefault[1] / ncls) : 1.f);
+      } else {
+        const double invdEdx = 1.f / static_cast<double>(dEdx);
+        const double sqrtNcl = std::sqrt(nClNorm / ncls);
+        const double relReso = GetRelativeResolutiondEdx(p, mass, charge, mResolutionParams[3]);
+        const double mult = batch.multTPC[i] / mMultNormalization;
+        const double invdEdxOverTgl = invdEdx / std::sqrt(1 + batch.tgl[i] * batch.tgl[i]);
+        sigma = std::sqrt(mResolutionParams[0] * mResolutionParams[0] * invdEdx + mResolutionParams[1] * mResolutionParams[1] * (sqrtNcl * mResolutionParams[5]) * std::pow(invdEdxOverTgl, mResolutionParams[2]) + sqrtNcl * relReso * relReso + std::pow(mResolutionParams[4] * batch.signed1Pt[i], 2) + std::pow(mult * mResolutionParams[6], 2) + std::pow(mult * invdEdxOverTgl * mResolutionParams[7], 2)) * dEdx * mMIP;
+      }
+      if (sigma < 0.f) {
+        sigma = -999.f;
+      }
+    }
+    if (expSigma) {
+      expSigma[i] = sigma;
+    }
+    nSigma[i] = (sigma < 0.f || signal < 0.f) ? -999.f : (batch.tpcSignal[i] - signal) / sigma;
+  }
+}
+
 inline void Response::PrintAll() const
 {
   LOGP(info, "==== TPC PID response parameters: ====");
@@ -0,0 +1,88 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   PVContributors.h
+/// \brief  Primary-vertex contributors of all the collisions of a dataframe, built in one pass over the tracks table
+///         The global indices of the contributors are stored collision after collision in one array, with the offset
+///         of every collision in a second array, and a flag tells for every track whether it is a contributor.
+///         This replaces a Partition on the contributor flag sliced for every collision.
+///
+
+#ifndef COMMON_CORE_PVCONTRIBUTORS_H_
+#define COMMON_CORE_PVCONTRIBUTORS_H_
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace o2::common
+{
+
+class PVContributors
+{
+ public:
+  /// Collects the contributors of the full tracks table, nCollisions is the size of the collisions table
+  template <typename Tracks>
+  void build(Tracks const& tracks, int nCollisions)
+  {
+    mIsContributor.assign(tracks.size(), false);
+    mOffsets.assign(nCollisions + 1, 0);
+    // the contributors are counted per collision while they are collected,
+    // then placed collision after collision from the prefix sum of the counts
+    std::vector<int64_t> ids;
+    std::vector<int> collisionIds;
+    for (const auto& track : tracks) {
+      if (!track.isPVContributor() || !track.has_collision()) {
+        continue;
+      }
+      auto collisionId = track.collisionId();
+      if (collisionId >= nCollisions) {
+        continue;
+      }
+      mIsContributor[track.globalIndex()] = true;
+      ids.push_back(track.globalIndex());
+      collisionIds.push_back(collisionId);
+      ++mOffsets[collisionId + 1];
+    }
+    for (int i = 0; i < nCollisions; ++i) {
+      mOffsets[i + 1] += mOffsets[i];
+    }
+    mIds.resize(ids.size());
+    std::vector<int> next(mOffsets.begin(), mOffsets.end() - 1);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      mIds[next[collisionIds[i]]++] = ids[i];
+    }
+  }
+
+  /// Global indices of the contributors of a collision
+  std::span<const int64_t> of(int collisionId) const
+  {
+    if (collisionId < 0 || collisionId + 1 >= static_cast<int>(mOffsets.size())) {
+      return {};
+    }
+    return {mIds.data() + mOffsets[collisionId], static_cast<std::size_t>(mOffsets[collisionId + 1] - mOffsets[collisionId])};
+  }
+
+  /// Whether the track with the given global index is a contributor
+  bool isContributor(int64_t globalIndex) const { return globalIndex >= 0 && globalIndex < static_cast<int64_t>(mIsContributor.size()) && mIsContributor[globalIndex]; }
+
+  int nContributors() const { return mIds.size(); }
+
+ private:
+  std::vector<int> mOffsets;        // position of the first contributor of every collision, and total number at the end
+  std::vector<int64_t> mIds;        // global indices of the contributors, collision after collision
+  std::vector<bool> mIsContributor; // contributor flag of every track, by global index
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_PVCONTRIBUTORS_H_
@@ -0,0 +1,237 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   PVRefitter.h
+/// \brief  Refits of the primary vertex of a collision without some of its contributors
+///         The fit state of a collision is prepared once with prepare(), from the original vertex and its contributors,
+///         then refitWithout() gives the vertex without one or a few of them (e.g. a track or the prongs of a candidate).
+///         Two modes are available:
+///         - PVertexer (default): each refit reruns the PVertexer fit over the remaining contributors, prepared once
+///         - downdate: the contributors are linearised at the original vertex and their weights are summed once into the
+///           normal equations of the fit, a refit subtracts the contributions of the removed tracks and solves the 3x3
+///           system, so that it costs O(removed tracks) instead of O(contributors). This is the one-iteration weighted
+///           least-squares fit without outlier down-weighting nor mean vertex constraint, hence close to but not
+///           identical with the PVertexer refit
+///         The magnetic field of the Propagator must be set before prepare().
+///
+
+#ifndef COMMON_CORE_PVREFITTER_H_
+#define COMMON_CORE_PVREFITTER_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "DetectorsBase/Propagator.h"
+#include "DetectorsVertexing/PVertexer.h"
+#include "ReconstructionDataFormats/PrimaryVertex.h"
+#include "ReconstructionDataFormats/Track.h"
+#include "ReconstructionDataFormats/Vertex.h"
+
+namespace o2::common
+{
+
+class PVRefitter
+{
+ public:
+  using Vertex = o2::dataformats::PrimaryVertex;
+
+  void setUseDowndate(bool useDowndate) { mUseDowndate = useDowndate; }
+  bool useDowndate() const { return mUseDowndate; }
+
+  /// Prepares the refits of a vertex from its contributors, given by global index and track parameters
+  /// \return whether the vertex can be refitted
+  bool prepare(o2::dataformats::VertexBase const& vertex, std::vector<int64_t> const& contributorIds, std::vector<o2::track::TrackParCov> const& contributors)
+  {
+    mVertex = vertex;
+    mEntries.clear();
+    for (std::size_t i = 0; i < contributorIds.size(); ++i) {
+      mEntries[contributorIds[i]] = i;
+    }
+    mIsPrepared = mUseDowndate ? prepareDowndate(contributors) : prepareVertexer(contributors);
+    return mIsPrepared;
+  }
+
+  bool isPrepared() const { return mIsPrepared; }
+  int nContributors() const { return mEntries.size(); }
+
+  /// Position of a track in the contributors, -1 if it is not a contributor
+  int entry(int64_t globalIndex) const
+  {
+    auto it = mEntries.find(globalIndex);
+    return it == mEntries.end() ? -1 : it->second;
+  }
+
+  /// Refit without the tracks with the given global indices, the tracks which are not contributors are ignored
+  /// The refit failed if the chi2 of the returned vertex is negative
+  template <typename Ids>
+  Vertex refitWithout(Ids const& globalIndices)
+  {
+    std::vector<int> removed;
+    for (auto globalIndex : globalIndices) {
+      int i = entry(globalIndex);
+      if (i >= 0) {
+        removed.push_back(i);
+      }
+    }
+    return mUseDowndate ? refitDowndate(removed) : refitVertexer(removed);
+  }
+
+ private:
+  // normal equations of the linearised fit, the 6 elements of the symmetric 3x3 matrix are xx, xy, yy, xz, yz, zz
+  struct NormalEquations {
+    std::array<double, 6> a{};
+    std::array<double, 3> b{};
+    double c = 0.;
+
+    void add(NormalEquations const& other, double sign)
+    {
+      for (int i = 0; i < 6; ++i) {
+        a[i] += sign * other.a[i];
+      }
+      for (int i = 0; i < 3; ++i) {
+        b[i] += sign * other.b[i];
+      }
+      c += sign * other.c;
+    }
+  };
+
+  bool prepareVertexer(std::vector<o2::track::TrackParCov> const& contributors)
+  {
+    // the vertexer takes the magnetic field at initialisation
+    float bz = o2::base::Propagator::Instance()->getNominalBz();
+    if (!mVertexerInitialised || bz != mVertexerBz) {
+      mVertexer.init();
+      mVertexerInitialised = true;
+      mVertexerBz = bz;
+    }
+    mUsed.assign(contributors.size(), true);
+    return mVertexer.prepareVertexRefit(contributors, mVertex);
+  }
+
+  Vertex refitVertexer(std::vector<int> const& removed)
+  {
+    for (auto i : removed) {
+      mUsed[i] = false;
+    }
+    auto vertex = mVertexer.refitVertex(mUsed, mVertex);
+    for (auto i : removed) {
+      mUsed[i] = true;
+    }
+    return vertex;
+  }
+
+  bool prepareDowndate(std::vector<o2::track::TrackParCov> const& contributors)
+  {
+    mTrackEquations.resize(contributors.size());
+    mTotal = NormalEquations{};
+    for (std::size_t i = 0; i < contributors.size(); ++i) {
+      auto& eq = mTrackEquations[i];
+      eq = NormalEquations{};
+      auto track = contributors[i];
+      if (!o2::base::Propagator::Instance()->propagateToDCA(mVertex, track, o2::base::Propagator::Instance()->getNominalBz(), 2.f, o2::base::Propagator::MatCorrType::USEMatCorrNONE)) {
+        continue; // no contribution
+      }
+      // weights of the y and z residuals in the tracking frame
+      double sy2 = track.getSigmaY2(), syz = track.getSigmaZY(), sz2 = track.getSigmaZ2();
+      double det = sy2 * sz2 - syz * syz;
+      if (det <= 0.) {
+        continue;
+      }
+      double wyy = sz2 / det, wyz = -syz / det, wzz = sy2 / det;
+      // straight line around the vertex: y(x) = y0 + tgP (x - x0), z(x) = z0 + tgL / cosP (x - x0),
+      // residuals linear in the vertex position through its coordinates in the tracking frame
+      double snp = track.getSnp();
+      double cosP = std::sqrt((1. - snp) * (1. + snp));
+      double tgP = snp / cosP;
+      double tgLx = track.getTgl() / cosP;
+      double cs = std::cos(track.getAlpha()), sn = std::sin(track.getAlpha());
+      std::array<double, 3> hy = {-sn - tgP * cs, cs - tgP * sn, 0.};
+      std::array<double, 3> hz = {-tgLx * cs, -tgLx * sn, 1.};
+      double my = track.getY() - tgP * track.getX();
+      double mz = track.getZ() - tgLx * track.getX();
+      // H^T W H, H^T W m and m^T W m
+      const int rows[6] = {0, 0, 1, 0, 1, 2};
+      const int cols[6] = {0, 1, 1, 2, 2, 2};
+      for (int k = 0; k < 6; ++k) {
+        int r = rows[k], c = cols[k];
+        eq.a[k] = wyy * hy[r] * hy[c] + wyz * (hy[r] * hz[c] + hz[r] * hy[c]) + wzz * hz[r] * hz[c];
+      }
+      for (int r = 0; r < 3; ++r) {
+        eq.b[r] = hy[r] * (wyy * my + wyz * mz) + hz[r] * (wyz * my + wzz * mz);
+      }
+      eq.c = wyy * my * my + 2. * wyz * my * mz + wzz * mz * mz;
+      mTotal.add(eq, 1.);
+    }
+    return contributors.size() >= 2;
+  }
+
+  Vertex refitDowndate(std::vector<int> const& removed) const
+  {
+    Vertex vertex;
+    vertex.setChi2(-1.);
+    int nContributors = mTrackEquations.size() - removed.size();
+    if (nContributors < 2) {
+      return vertex;
+    }
+    auto eq = mTotal;
+    for (auto i : removed) {
+      eq.add(mTrackEquations[i], -1.);
+    }
+    // inverse of the symmetric matrix from its cofactors
+    const auto& a = eq.a;
+    std::array<double, 6> inv = {a[2] * a[5] - a[4] * a[4],
+                                 a[3] * a[4] - a[1] * a[5],
+                                 a[0] * a[5] - a[3] * a[3],
+                                 a[1] * a[4] - a[2] * a[3],
+                                 a[1] * a[3] - a[0] * a[4],
+                                 a[0] * a[2] - a[1] * a[1]};
+    double det = a[0] * inv[0] + a[1] * inv[1] + a[3] * inv[3];
+    if (det <= 0.) {
+      return vertex;
+    }
+    for (auto& element : inv) {
+      element /= det;
+    }
+    std::array<double, 3> pos = {inv[0] * eq.b[0] + inv[1] * eq.b[1] + inv[3] * eq.b[2],
+                                 inv[1] * eq.b[0] + inv[2] * eq.b[1] + inv[4] * eq.b[2],
+                                 inv[3] * eq.b[0] + inv[4] * eq.b[1] + inv[5] * eq.b[2]};
+    vertex.setXYZ(pos[0], pos[1], pos[2]);
+    vertex.setCov(inv[0], inv[1], inv[2], inv[3], inv[4], inv[5]);
+    vertex.setNContributors(nContributors);
+    // chi2 at the minimum, m^T W m - x^T b
+    vertex.setChi2(std::max(0., eq.c - (pos[0] * eq.b[0] + pos[1] * eq.b[1] + pos[2] * eq.b[2])));
+    return vertex;
+  }
+
+  bool mUseDowndate = false;
+  bool mIsPrepared = false;
+  o2::dataformats::VertexBase mVertex;
+  std::unordered_map<int64_t, int> mEntries; // global index -> position in the contributors
+
+  // PVertexer mode
+  o2::vertexing::PVertexer mVertexer;
+  bool mVertexerInitialised = false;
+  float mVertexerBz = 0.f;
+  std::vector<bool> mUsed;
+
+  // downdate mode
+  std::vector<NormalEquations> mTrackEquations;
+  NormalEquations mTotal;
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_PVREFITTER_H_
@@ -17,6 +17,7 @@
 #ifndef O2_ANALYSIS_RECODECAY_H_
 #define O2_ANALYSIS_RECODECAY_H_
 
+#include <algorithm>
 #include <tuple>
 #include <vector>
 #include <array>
@@ -54,6 +55,123 @@ class RecoDecay
                     Prompt,
                     NonPrompt };
 
+  /// Flattened mother tree of the MC particles of a dataframe.
+  /// Filled once per dataframe, it replaces the walks through the McParticles iterators in the MC matching of many candidates.
+  class MCAncestry
+  {
+   public:
+    /// Fills the index from the MC particles table
+    /// \param particlesMC  table with MC particles
+    template <typename T>
+    void fill(const T& particlesMC)
+    {
+      mOffset = particlesMC.offset();
+      const auto nParticles = particlesMC.size();
+      mPDG.resize(nParticles);
+      mMotherFirst.resize(nParticles);
+      mMotherLast.resize(nParticles);
+      for (const auto& particle : particlesMC) {
+        const auto iPart = particle.globalIndex() - mOffset;
+        mPDG[iPart] = particle.pdgCode();
+        if (particle.has_mothers()) {
+          mMotherFirst[iPart] = particle.mothersIds().front();
+          mMotherLast[iPart] = particle.mothersIds().back();
+        } else {
+          mMotherFirst[iPart] = -1;
+          mMotherLast[iPart] = -1;
+        }
+      }
+      mBeautyHadronAncestor.assign(nParticles, kUnknown);
+    }
+
+    bool isFilled() const { return !mPDG.empty(); }
+
+    /// Same as RecoDecay::getMother, on the flattened mother tree
+    /// \param index  global index of the MC particle
+    int getMother(long index, int PDGMother, bool acceptAntiParticles = false, int8_t* sign = nullptr, int8_t depthMax = -1) const
+    {
+      int8_t sgn = 0;
+      int indexMother = -1;
+      bool motherFound = false;
+      int depth = 0;
+      mStage.assign(1, index);
+      while (!motherFound && !mStage.empty() && (depthMax < 0 || depth < depthMax)) {
+        mNextStage.clear();
+        for (auto iPart : mStage) { // check all the particles that were the mothers at the previous stage
+          if (!isInRange(iPart) || mMotherFirst[iPart - mOffset] < 0) {
+            continue;
+          }
+          for (auto iMother = mMotherFirst[iPart - mOffset]; iMother <= mMotherLast[iPart - mOffset]; ++iMother) {
+            if (std::find(mNextStage.begin(), mNextStage.end(), iMother) != mNextStage.end()) { // if a mother is still present in the vector, do not check it again
+              continue;
+            }
+            auto PDGParticleIMother = getPDG(iMother);
+            if (PDGParticleIMother == PDGMother) { // exact PDG match
+              sgn = 1;
+              indexMother = iMother;
+              motherFound = true;
+              break;
+            } else if (acceptAntiParticles && PDGParticleIMother == -PDGMother) { // antiparticle PDG match
+              sgn = -1;
+              indexMother = iMother;
+              motherFound = true;
+              break;
+            }
+            mNextStage.push_back(iMother);
+          }
+        }
+        std::swap(mStage, mNextStage);
+        ++depth;
+      }
+      if (sign) {
+        *sign = sgn;
+      }
+      return indexMother;
+    }
+
+    /// \param index  global index of the MC particle
+    /// \return true if a beauty hadron is found among the ancestors of the particle, memoised for all the visited ancestors
+    bool hasBeautyHadronAncestor(long index) const
+    {
+      if (!isInRange(index)) {
+        return false;
+      }
+      auto& state = mBeautyHadronAncestor[index - mOffset];
+      if (state != kUnknown) {
+        return state == kYes;
+      }
+      state = kNo; // protects against loops in the mother tree
+      bool isFound = false;
+      if (mMotherFirst[index - mOffset] >= 0) {
+        for (auto iMother = mMotherFirst[index - mOffset]; iMother <= mMotherLast[index - mOffset] && !isFound; ++iMother) {
+          auto PDGParticleIMother = std::abs(getPDG(iMother));
+          isFound = PDGParticleIMother / 100 == 5 || // b mesons
+                    PDGParticleIMother / 1000 == 5 || // b baryons
+                    hasBeautyHadronAncestor(iMother);
+        }
+      }
+      // the particle may have been reached again through a loop, overwrite in any case
+      mBeautyHadronAncestor[index - mOffset] = isFound ? kYes : kNo;
+      return isFound;
+    }
+
+   private:
+    enum : int8_t { kUnknown = -1,
+                    kNo = 0,
+                    kYes = 1 };
+
+    bool isInRange(long index) const { return index >= mOffset && index - mOffset < static_cast<long>(mPDG.size()); }
+    int getPDG(long index) const { return isInRange(index) ? mPDG[index - mOffset] : 0; }
+
+    long mOffset = 0;
+    std::vector<int> mPDG{};
+    std::vector<long> mMotherFirst{};
+    std::vector<long> mMotherLast{};
+    mutable std::vector<int8_t> mBeautyHadronAncestor{};
+    mutable std::vector<long> mStage{};
+    mutable std::vector<long> mNextStage{};
+  };
+
   // Auxiliary functions
 
   /// Sums numbers.
@@ -451,6 +569,116 @@ class RecoDecay
     return std::sqrt(m2(args...));
   }
 
+  /// Calculates invariant masses squared of a candidate for several mass hypotheses at once.
+  /// The momentum magnitudes of the prongs and the total momentum are computed only once for all hypotheses.
+  /// \param N  number of prongs
+  /// \param NHypos  number of mass hypotheses
+  /// \param arrMom  array of N 3-momentum arrays
+  /// \param arrMassHypos  array of NHypos arrays of N masses (in the same order as arrMom)
+  /// \return array of NHypos invariant masses squared
+  template <std::size_t N, std::size_t NHypos, typename T, typename U>
+  static array<double, NHypos> m2Hypos(const array<array<T, 3>, N>& arrMom, const array<array<U, N>, NHypos>& arrMassHypos)
+  {
+    array<double, 3> momTotal{0., 0., 0.}; // candidate momentum vector
+    array<double, N> mom2{};               // prong momenta squared
+    for (std::size_t iProng = 0; iProng < N; ++iProng) {
+      for (std::size_t iMom = 0; iMom < 3; ++iMom) {
+        momTotal[iMom] += arrMom[iProng][iMom];
+      } // loop over momentum components
+      mom2[iProng] = p2(arrMom[iProng]);
+    } // loop over prongs
+    const double mom2Total = p2(momTotal);
+    array<double, NHypos> result{};
+    for (std::size_t iHypo = 0; iHypo < NHypos; ++iHypo) {
+      double energyTot{0.};
+      for (std::size_t iProng = 0; iProng < N; ++iProng) {
+        energyTot += std::sqrt(mom2[iProng] + (double)arrMassHypos[iHypo][iProng] * (double)arrMassHypos[iHypo][iProng]);
+      } // loop over prongs
+      result[iHypo] = energyTot * energyTot - mom2Total;
+    } // loop over hypotheses
+    return result;
+  }
+
+  // Batch calculation of kinematic quantities
+  //
+  // The batch functions process nCandidates N-prong candidates stored as structure of arrays:
+  // the momentum components of the prong iProng of the candidate iCand are px[iProng][iCand], py[iProng][iCand], pz[iProng][iCand].
+  // The loops over candidates have no dependencies between iterations so that the compiler can vectorise them.
+
+  /// Calculates invariant masses squared of a batch of candidates.
+  /// \param nCandidates  number of candidates
+  /// \param px,py,pz  arrays of N pointers to the momentum components of the prongs of all the candidates
+  /// \param arrMass  array of N masses (in the same order as the prongs)
+  /// \param result  output array of nCandidates invariant masses squared
+  template <std::size_t N, typename T, typename U>
+  static void m2Batch(std::size_t nCandidates, const array<const T*, N>& px, const array<const T*, N>& py, const array<const T*, N>& pz, const array<U, N>& arrMass, double* result)
+  {
+    array<double, N> mass2{};
+    for (std::size_t iProng = 0; iProng < N; ++iProng) {
+      mass2[iProng] = (double)arrMass[iProng] * (double)arrMass[iProng];
+    }
+    for (std::size_t iCand = 0; iCand < nCandidates; ++iCand) {
+      double pxTot{0.}, pyTot{0.}, pzTot{0.}, energyTot{0.};
+      for (std::size_t iProng = 0; iProng < N; ++iProng) {
+        const double pxProng = px[iProng][iCand], pyProng = py[iProng][iCand], pzProng = pz[iProng][iCand];
+        pxTot += pxProng;
+        pyTot += pyProng;
+        pzTot += pzProng;
+        energyTot += std::sqrt(pxProng * pxProng + pyProng * pyProng + pzProng * pzProng + mass2[iProng]);
+      } // loop over prongs
+      result[iCand] = energyTot * energyTot - (pxTot * pxTot + pyTot * pyTot + pzTot * pzTot);
+    } // loop over candidates
+  }
+
+  /// Calculates invariant masses of a batch of candidates.
+  /// \param nCandidates  number of candidates
+  /// \param px,py,pz  arrays of N pointers to the momentum components of the prongs of all the candidates
+  /// \param arrMass  array of N masses (in the same order as the prongs)
+  /// \param result  output array of nCandidates invariant masses
+  template <std::size_t N, typename T, typename U>
+  static void mBatch(std::size_t nCandidates, const array<const T*, N>& px, const array<const T*, N>& py, const array<const T*, N>& pz, const array<U, N>& arrMass, double* result)
+  {
+    m2Batch(nCandidates, px, py, pz, arrMass, result);
+    for (std::size_t iCand = 0; iCand < nCandidates; ++iCand) {
+      result[iCand] = std::sqrt(result[iCand]);
+    }
+  }
+
+  /// Calculates total transverse momenta of a batch of candidates.
+  /// \param nCandidates  number of candidates
+  /// \param px,py  arrays of N pointers to the momentum components of the prongs of all the candidates
+  /// \param result  output array of nCandidates transverse momenta
+  template <std::size_t N, typename T>
+  static void ptBatch(std::size_t nCandidates, const array<const T*, N>& px, const array<const T*, N>& py, double* result)
+  {
+    for (std::size_t iCand = 0; iCand < nCandidates; ++iCand) {
+      double pxTot{0.}, pyTot{0.};
+      for (std::size_t iProng = 0; iProng < N; ++iProng) {
+        pxTot += px[iProng][iCand];
+        pyTot += py[iProng][iCand];
+      } // loop over prongs
+      result[iCand] = std::sqrt(pxTot * pxTot + pyTot * pyTot);
+    } // loop over candidates
+  }
+
+  /// Calculates cosines of pointing angle of a batch of candidates w.r.t. a common primary vertex.
+  /// \param nCandidates  number of candidates
+  /// \param posPV  {x, y, z} position of the primary vertex
+  /// \param xSV,ySV,zSV  positions of the secondary vertices of the candidates
+  /// \param px,py,pz  momentum components of the candidates
+  /// \param result  output array of nCandidates cosines of pointing angle
+  template <typename T, typename U, typename V>
+  static void cpaBatch(std::size_t nCandidates, const T& posPV, const U* xSV, const U* ySV, const U* zSV, const V* px, const V* py, const V* pz, double* result)
+  {
+    const double xPV = posPV[0], yPV = posPV[1], zPV = posPV[2];
+    for (std::size_t iCand = 0; iCand < nCandidates; ++iCand) {
+      const double lx = xSV[iCand] - xPV, ly = ySV[iCand] - yPV, lz = zSV[iCand] - zPV;
+      const double pxCand = px[iCand], pyCand = py[iCand], pzCand = pz[iCand];
+      const double cos = (lx * pxCand + ly * pyCand + lz * pzCand) / std::sqrt((lx * lx + ly * ly + lz * lz) * (pxCand * pxCand + pyCand * pyCand + pzCand * pzCand));
+      result[iCand] = std::clamp(cos, -1., 1.);
+    } // loop over candidates
+  }
+
   // Calculation of topological quantities
 
   /// Calculates impact parameter in the bending plane of the particle w.r.t. a point
@@ -573,6 +801,7 @@ class RecoDecay
   /// \param acceptAntiParticles  switch to accept the antiparticle of the expected mother
   /// \param sign  antiparticle indicator of the found mother w.r.t. PDGMother; 1 if particle, -1 if antiparticle, 0 if mother not found
   /// \param depthMax  maximum decay tree level to check; Mothers up to this level will be considered. If -1, all levels are considered.
+  /// \param ancestry  flattened mother tree of the dataframe; if provided and filled, it is used instead of the MC particles table
   /// \return index of the mother particle if found, -1 otherwise
   template <typename T>
   static int getMother(const T& particlesMC,
@@ -580,8 +809,12 @@ class RecoDecay
                        int PDGMother,
                        bool acceptAntiParticles = false,
                        int8_t* sign = nullptr,
-                       int8_t depthMax = -1)
+                       int8_t depthMax = -1,
+                       const MCAncestry* ancestry = nullptr)
   {
+    if (ancestry && ancestry->isFilled()) {
+      return ancestry->getMother(particle.globalIndex(), PDGMother, acceptAntiParticles, sign, depthMax);
+    }
     int8_t sgn = 0;           // 1 if the expected mother is particle, -1 if antiparticle (w.r.t. PDGMother)
     int indexMother = -1;     // index of the final matched mother, if found
     int stage = 0;            // mother tree level (just for debugging)
@@ -712,6 +945,7 @@ class RecoDecay
   /// \param acceptAntiParticles  switch to accept the antiparticle version of the expected decay
   /// \param sign  antiparticle indicator of the found mother w.r.t. PDGMother; 1 if particle, -1 if antiparticle, 0 if mother not found
   /// \param depthMax  maximum decay tree level to check; Daughters up to this level will be considered. If -1, all levels are considered.
+  /// \param ancestry  flattened mother tree of the dataframe, used for the search of the mother if provided
   /// \return index of the mother particle if the mother and daughters are correct, -1 otherwise
   template <std::size_t N, typename T, typename U>
   static int getMatchedMCRec(const T& particlesMC,
@@ -720,7 +954,8 @@ class RecoDecay
                              array<int, N> arrPDGDaughters,
                              bool acceptAntiParticles = false,
                              int8_t* sign = nullptr,
-                             int depthMax = 1)
+                             int depthMax = 1,
+                             const MCAncestry* ancestry = nullptr)
   {
     //Printf("MC Rec: Expected mother PDG: %d", PDGMother);
     int8_t sgn = 0;                        // 1 if the expected mother is particle, -1 if antiparticle (w.r.t. PDGMother)
@@ -741,7 +976,7 @@ class RecoDecay
       if (iProng == 0) {
         // Get the mother index and its sign.
         // PDG code of the first daughter's mother determines whether the expected mother is a particle or antiparticle.
-        indexMother = getMother(particlesMC, particleI, PDGMother, acceptAntiParticles, &sgn, depthMax);
+        indexMother = getMother(particlesMC, particleI, PDGMother, acceptAntiParticles, &sgn, depthMax, ancestry);
         // Check whether mother was found.
         if (indexMother <= -1) {
           //Printf("MC Rec: Rejected: bad mother index or PDG");
@@ -922,12 +1157,17 @@ class RecoDecay
   /// \param particlesMC  table with MC particles
   /// \param particle  MC particle
   /// \param searchUpToQuark if true tag origin based on charm/beauty quark otherwise on b-hadron
+  /// \param ancestry  flattened mother tree of the dataframe; if provided and filled, the b-hadron search is memoised there
   /// \return an integer corresponding to the origin (0: none, 1: prompt, 2: nonprompt) as in OriginType
   template <typename T>
   static int getCharmHadronOrigin(const T& particlesMC,
                                   const typename T::iterator& particle,
-                                  const bool searchUpToQuark = false)
+                                  const bool searchUpToQuark = false,
+                                  const MCAncestry* ancestry = nullptr)
   {
+    if (!searchUpToQuark && ancestry && ancestry->isFilled()) {
+      return ancestry->hasBeautyHadronAncestor(particle.globalIndex()) ? OriginType::NonPrompt : OriginType::Prompt;
+    }
     int stage = 0; // mother tree level (just for debugging)
 
     // vector of vectors with mother indices; each line corresponds to a "stage"
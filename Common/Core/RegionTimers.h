@@ -0,0 +1,156 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   RegionTimers.h
+/// \brief  Wall time spent in the named regions of a task
+///         A region is timed with a scope object, e.g. O2_REGION_TIMER(timers, kBuild) at the top of a block, which
+///         adds the steady_clock time between its construction and destruction to the region. flush(), called at the
+///         end of a process function, fills the time of each region entered since the last flush in a histogram of
+///         the time per call and adds it to the total time and number of calls of the region.
+///         The timers are skipped without reading the clock when disabled at run time, and O2_REGION_TIMER expands
+///         to nothing and the timers are always disabled when O2PHYSICS_DISABLE_REGION_TIMERS is defined.
+///         The timers are not thread safe.
+///
+
+#ifndef COMMON_CORE_REGIONTIMERS_H_
+#define COMMON_CORE_REGIONTIMERS_H_
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Framework/HistogramRegistry.h"
+
+namespace o2::common
+{
+
+class RegionTimers
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Adds the time between its construction and destruction to a region
+  class Scope
+  {
+   public:
+    Scope(RegionTimers* timers, int region) : mTimers(timers), mRegion(region)
+    {
+      if (mTimers != nullptr) {
+        mStart = Clock::now();
+      }
+    }
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+    ~Scope()
+    {
+      if (mTimers != nullptr) {
+        mTimers->add(mRegion, std::chrono::duration<double, std::micro>(Clock::now() - mStart).count());
+      }
+    }
+
+   private:
+    RegionTimers* mTimers;
+    int mRegion;
+    Clock::time_point mStart;
+  };
+
+  /// Flushes the timers when it goes out of scope, to be declared before the regions of a process function with
+  /// several exits
+  class FlushGuard
+  {
+   public:
+    explicit FlushGuard(RegionTimers& timers) : mTimers(timers) {}
+    FlushGuard(FlushGuard const&) = delete;
+    FlushGuard& operator=(FlushGuard const&) = delete;
+    ~FlushGuard() { mTimers.flush(); }
+
+   private:
+    RegionTimers& mTimers;
+  };
+
+  /// Books the histograms of the regions in folder, the region ids are the indices in regions
+  void init(o2::framework::HistogramRegistry& registry, std::vector<std::string> const& regions, bool enabled, std::string const& folder = "Timers")
+  {
+#ifdef O2PHYSICS_DISABLE_REGION_TIMERS
+    enabled = false;
+#endif
+    mEnabled = enabled;
+    if (!mEnabled) {
+      return;
+    }
+    const int n = regions.size();
+    mElapsed.assign(n, 0.);
+    mEntered.assign(n, false);
+    o2::framework::AxisSpec axisRegion{n, -0.5, n - 0.5, "region"};
+    o2::framework::AxisSpec axisTime{140, 0.1, 1.e6, "time per call (#mus)"};
+    axisTime.makeLogarithmic();
+    mTimePerCall = registry.add<TH2>((folder + "/hTimePerCall").c_str(), "Time spent in the regions per process call", o2::framework::kTH2F, {axisRegion, axisTime});
+    mTotalTime = registry.add<TH1>((folder + "/hTotalTime").c_str(), "Total time spent in the regions;;time (#mus)", o2::framework::kTH1D, {axisRegion});
+    mCalls = registry.add<TH1>((folder + "/hCalls").c_str(), "Process calls entering the regions;;calls", o2::framework::kTH1D, {axisRegion});
+    for (int i = 0; i < n; i++) {
+      mTimePerCall->GetXaxis()->SetBinLabel(i + 1, regions[i].c_str());
+      mTotalTime->GetXaxis()->SetBinLabel(i + 1, regions[i].c_str());
+      mCalls->GetXaxis()->SetBinLabel(i + 1, regions[i].c_str());
+    }
+  }
+
+  bool isEnabled() const { return mEnabled; }
+
+  Scope scope(int region) { return Scope(mEnabled ? this : nullptr, region); }
+
+  /// Adds elapsed microseconds to a region
+  void add(int region, double elapsed)
+  {
+    mElapsed[region] += elapsed;
+    mEntered[region] = true;
+  }
+
+  /// Fills the time of the regions entered since the last flush and resets it
+  void flush()
+  {
+    if (!mEnabled) {
+      return;
+    }
+    for (std::size_t i = 0; i < mElapsed.size(); i++) {
+      if (!mEntered[i]) {
+        continue;
+      }
+      mTimePerCall->Fill(i, mElapsed[i]);
+      mTotalTime->Fill(i, mElapsed[i]);
+      mCalls->Fill(i);
+      mElapsed[i] = 0.;
+      mEntered[i] = false;
+    }
+  }
+
+ private:
+  bool mEnabled = false;
+  std::vector<double> mElapsed;      ///< microseconds per region since the last flush
+  std::vector<bool> mEntered;        ///< regions entered since the last flush
+  std::shared_ptr<TH2> mTimePerCall; ///< time per process call vs region
+  std::shared_ptr<TH1> mTotalTime;   ///< total time per region
+  std::shared_ptr<TH1> mCalls;       ///< process calls per region
+};
+
+} // namespace o2::common
+
+#define O2_REGION_TIMER_CONCAT_IMPL(a, b) a##b
+#define O2_REGION_TIMER_CONCAT(a, b) O2_REGION_TIMER_CONCAT_IMPL(a, b)
+#ifndef O2PHYSICS_DISABLE_REGION_TIMERS
+/// Times the rest of the enclosing block as region of timers
+#define O2_REGION_TIMER(timers, region) const o2::common::RegionTimers::Scope O2_REGION_TIMER_CONCAT(regionTimer, __LINE__) = (timers).scope(region)
+#else
+#define O2_REGION_TIMER(timers, region)
+#endif
+
+#endif // COMMON_CORE_REGIONTIMERS_H_
@@ -0,0 +1,115 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   RowBuffer.h
+/// \brief  Rows of a table buffered in typed columns before being written into a Produces<> cursor
+///         A buffer is filled with buffer(values...) with the column values of a row, e.g. in the inner loop of a
+///         candidate search, and its rows are written into the cursor of the table in one block with commit().
+///         The buffers are not thread safe, but several threads can each fill their own buffers, e.g. one per
+///         collision, which are then committed in order by one thread with commitInOrder(), after reserving the
+///         total number of rows in the cursor. The cursor is only called from the thread doing the commit.
+///
+
+#ifndef COMMON_CORE_ROWBUFFER_H_
+#define COMMON_CORE_ROWBUFFER_H_
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace o2::common
+{
+
+template <typename... Ts>
+class RowBuffer
+{
+ public:
+  /// Appends a row
+  void operator()(Ts... values)
+  {
+    push(std::index_sequence_for<Ts...>{}, values...);
+  }
+
+  void reserve(std::size_t nRows)
+  {
+    std::apply([nRows](auto&... columns) { (columns.reserve(nRows), ...); }, mColumns);
+  }
+
+  /// Removes the rows, keeping the memory of the columns for the next fill
+  void clear()
+  {
+    std::apply([](auto&... columns) { (columns.clear(), ...); }, mColumns);
+  }
+
+  std::size_t size() const { return std::get<0>(mColumns).size(); }
+  bool empty() const { return size() == 0; }
+
+  /// Column i of the buffer
+  template <std::size_t i>
+  auto const& column() const
+  {
+    return std::get<i>(mColumns);
+  }
+
+  /// Writes the rows into the cursor, without reserving them
+  template <typename Cursor>
+  void commit(Cursor& cursor) const
+  {
+    commit(cursor, std::index_sequence_for<Ts...>{});
+  }
+
+ private:
+  static_assert(sizeof...(Ts) > 0, "a row has at least one column");
+
+  template <std::size_t... Is>
+  void push(std::index_sequence<Is...>, Ts... values)
+  {
+    (std::get<Is>(mColumns).push_back(values), ...);
+  }
+
+  template <typename Cursor, std::size_t... Is>
+  void commit(Cursor& cursor, std::index_sequence<Is...>) const
+  {
+    const std::size_t nRows = size();
+    for (std::size_t iRow = 0; iRow < nRows; ++iRow) {
+      cursor(std::get<Is>(mColumns)[iRow]...);
+    }
+  }
+
+  std::tuple<std::vector<Ts>...> mColumns;
+};
+
+/// Number of rows of the buffers selected with get from a range of objects holding them
+template <typename Range, typename Getter>
+std::size_t totalRows(Range const& range, Getter get)
+{
+  std::size_t nRows = 0;
+  for (const auto& element : range) {
+    nRows += get(element).size();
+  }
+  return nRows;
+}
+
+/// Reserves the total number of rows in the cursor and writes the buffers selected with get in the order of the range
+template <typename Cursor, typename Range, typename Getter>
+void commitInOrder(Cursor& cursor, Range const& range, Getter get)
+{
+  cursor.reserve(totalRows(range, get));
+  for (const auto& element : range) {
+    get(element).commit(cursor);
+  }
+}
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_ROWBUFFER_H_
@@ -0,0 +1,131 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   ScratchArena.h
+/// \brief  Monotonic arena for the short-lived containers of the analysis loops (per event, per pair, per dataframe)
+///         Allocations advance a pointer in blocks owned by the arena and deallocations are no-ops, the memory is
+///         reclaimed at once by reset(). The blocks are kept between resets, and merged into one block of the total size
+///         when more than one was needed, so that after the first events the arena does not allocate anymore.
+///         The arena is a std::pmr::memory_resource, hence usable by all the std::pmr containers.
+///         Usage:
+///           ScratchArena arena;
+///           arena.reset(); // at the beginning of the event, all the containers of the previous event must be destroyed
+///           auto values = arena.vector<float>(nTracks);
+///
+
+#ifndef COMMON_CORE_SCRATCHARENA_H_
+#define COMMON_CORE_SCRATCHARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace o2::common
+{
+
+template <typename T>
+using ScratchAllocator = std::pmr::polymorphic_allocator<T>;
+template <typename T>
+using ScratchVector = std::pmr::vector<T>;
+
+class ScratchArena : public std::pmr::memory_resource
+{
+ public:
+  explicit ScratchArena(std::size_t blockSize = 64 * 1024) : mBlockSize(blockSize) {}
+  ScratchArena(ScratchArena const&) = delete;
+  ScratchArena& operator=(ScratchArena const&) = delete;
+
+  /// Reclaims all the memory of the arena, the containers allocated from it must not be used anymore
+  void reset()
+  {
+    if (mBlocks.size() > 1) {
+      std::size_t total = 0;
+      for (auto const& block : mBlocks) {
+        total += block.size;
+      }
+      mBlocks.clear();
+      addBlock(total);
+    }
+    mCurrent = 0;
+    mOffset = 0;
+  }
+
+  /// Empty vector allocated from the arena, with the given capacity
+  template <typename T>
+  ScratchVector<T> vector(std::size_t capacity = 0)
+  {
+    ScratchVector<T> v{ScratchAllocator<T>(this)};
+    v.reserve(capacity);
+    return v;
+  }
+
+  /// Vector of n copies of value allocated from the arena
+  template <typename T>
+  ScratchVector<T> vector(std::size_t n, T const& value)
+  {
+    return ScratchVector<T>(n, value, ScratchAllocator<T>(this));
+  }
+
+  /// Memory owned by the arena
+  std::size_t capacity() const
+  {
+    std::size_t total = 0;
+    for (auto const& block : mBlocks) {
+      total += block.size;
+    }
+    return total;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t size = 0;
+  };
+
+  void addBlock(std::size_t size)
+  {
+    mBlocks.push_back({std::make_unique<std::byte[]>(size), size});
+  }
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    while (mCurrent < mBlocks.size()) {
+      auto& block = mBlocks[mCurrent];
+      auto address = reinterpret_cast<std::uintptr_t>(block.data.get()) + mOffset;
+      std::size_t padding = (alignment - address % alignment) % alignment;
+      if (mOffset + padding + bytes <= block.size) {
+        mOffset += padding + bytes;
+        return block.data.get() + mOffset - bytes;
+      }
+      ++mCurrent;
+      mOffset = 0;
+    }
+    addBlock(std::max(mBlockSize, bytes + alignment));
+    return do_allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {} // reclaimed by reset()
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+  std::size_t mBlockSize;
+  std::vector<Block> mBlocks;
+  std::size_t mCurrent = 0; // block of the next allocation
+  std::size_t mOffset = 0;  // position of the next allocation in the current block
+};
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_SCRATCHARENA_H_
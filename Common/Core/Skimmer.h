@@ -0,0 +1,130 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   Skimmer.h
+/// \brief  Helpers to write derived (skimmed) tables from a selection and a projection of the columns of a table
+///         The selection of a table is evaluated first into a SkimIndex, which keeps the rows passing it and the
+///         index of every original row in the derived table. The kept rows are then written in one block into the
+///         cursor of the derived table, with the column values returned by the projection. Tables referring to a
+///         skimmed table are skimmed with skimChildren, which drops the rows whose parent was not kept and gives
+///         the new index of the parent to the projection, so that the index relations survive the skim.
+///         Usage:
+///           SkimIndex jetIndex;
+///           skim(outputJets, jets, [](auto const& jet) { return jet.pt() > 10.f; },
+///                [](auto const& jet) { return std::make_tuple(jet.pt(), jet.eta(), jet.phi()); }, jetIndex);
+///           skimChildren(outputConstituents, constituents, jetIndex, [](auto const& c) { return c.jetId(); },
+///                        [](auto const& c, int jetId) { return std::make_tuple(jetId, c.pt()); });
+///
+
+#ifndef COMMON_CORE_SKIMMER_H_
+#define COMMON_CORE_SKIMMER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace o2::common
+{
+
+/// Rows of a table kept by a skim, by global index, and their index in the derived table
+class SkimIndex
+{
+ public:
+  /// Evaluates the selection on all rows of the table
+  template <typename Table, typename Predicate>
+  void select(Table const& table, Predicate selected)
+  {
+    clear();
+    for (const auto& row : table) {
+      if (selected(row)) {
+        keep(row.globalIndex());
+      }
+    }
+  }
+
+  /// Keeps the row with the given global index as the next row of the derived table
+  void keep(int64_t original)
+  {
+    if (original >= static_cast<int64_t>(mNewIndex.size())) {
+      mNewIndex.resize(original + 1, -1);
+    }
+    mNewIndex[original] = mKept.size();
+    mKept.push_back(original);
+  }
+
+  void clear()
+  {
+    mNewIndex.clear();
+    mKept.clear();
+  }
+
+  /// Index in the derived table of the row with the given global index, -1 if the row was not kept
+  int newIndex(int64_t original) const
+  {
+    return (original >= 0 && original < static_cast<int64_t>(mNewIndex.size())) ? mNewIndex[original] : -1;
+  }
+  bool isKept(int64_t original) const { return newIndex(original) >= 0; }
+
+  /// Global indices of the kept rows, in the order of the derived table
+  std::vector<int64_t> const& kept() const { return mKept; }
+  std::size_t size() const { return mKept.size(); }
+
+ private:
+  std::vector<int> mNewIndex;
+  std::vector<int64_t> mKept;
+};
+
+/// Writes the projection of the rows kept in index into the cursor, in the order of the table
+template <typename Cursor, typename Table, typename Projection>
+void writeSkim(Cursor& cursor, Table const& table, SkimIndex const& index, Projection project)
+{
+  if (index.size() == 0) {
+    return;
+  }
+  cursor.reserve(index.size());
+  for (const auto& row : table) {
+    if (index.isKept(row.globalIndex())) {
+      std::apply(cursor, project(row));
+    }
+  }
+}
+
+/// Selects the rows of the table into index and writes their projection into the cursor
+template <typename Cursor, typename Table, typename Predicate, typename Projection>
+void skim(Cursor& cursor, Table const& table, Predicate selected, Projection project, SkimIndex& index)
+{
+  index.select(table, selected);
+  writeSkim(cursor, table, index, project);
+}
+
+/// Skims the rows of a table referring to a skimmed table, keeping the rows whose parent was kept
+/// parentId(row) returns the index of the parent of a row in the original table,
+/// project(row, newParentId) returns the column values of the row, with the parent index in the derived table
+template <typename Cursor, typename Table, typename ParentId, typename Projection>
+void skimChildren(Cursor& cursor, Table const& table, SkimIndex const& parentIndex, ParentId parentId, Projection project, SkimIndex& index)
+{
+  index.select(table, [&](auto const& row) { return parentIndex.isKept(parentId(row)); });
+  writeSkim(cursor, table, index, [&](auto const& row) { return project(row, parentIndex.newIndex(parentId(row))); });
+}
+
+/// Same as above, for tables which are not referred to themselves
+template <typename Cursor, typename Table, typename ParentId, typename Projection>
+void skimChildren(Cursor& cursor, Table const& table, SkimIndex const& parentIndex, ParentId parentId, Projection project)
+{
+  SkimIndex index;
+  skimChildren(cursor, table, parentIndex, parentId, project, index);
+}
+
+} // namespace o2::common
+
+#endif // COMMON_CORE_SKIMMER_H_
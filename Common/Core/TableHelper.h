@@ -18,25 +18,41 @@
 #ifndef COMMON_CORE_TABLEHELPER_H_
 #define COMMON_CORE_TABLEHELPER_H_
 
+#include <memory>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
+#include "Framework/ArrowTypes.h"
 #include "Framework/InitContext.h"
 #include "Framework/RunningWorkflowInfo.h"
 
-/// Function to check if a table is required in a workflow
+/// Function to get the names of all the tables required in a workflow, i.e. the bindings of the inputs of all its devices
+/// The names are collected at the first call and kept for the following calls of all the tasks of the process
 /// @param initContext initContext of the init function
-/// @param table name of the table to check for
-bool isTableRequiredInWorkflow(o2::framework::InitContext& initContext, const std::string& table)
+inline std::unordered_set<std::string> const& getTablesRequiredInWorkflow(o2::framework::InitContext& initContext)
 {
+  static o2::framework::RunningWorkflowInfo const* cachedWorkflow = nullptr;
+  static std::unordered_set<std::string> tables;
   auto& workflows = initContext.services().get<o2::framework::RunningWorkflowInfo const>();
-  for (auto const& device : workflows.devices) {
-    for (auto const& input : device.inputs) {
-      if (input.matcher.binding == table) {
-        return true;
+  if (cachedWorkflow != &workflows) {
+    tables.clear();
+    for (auto const& device : workflows.devices) {
+      for (auto const& input : device.inputs) {
+        tables.insert(input.matcher.binding);
       }
     }
+    cachedWorkflow = &workflows;
   }
-  return false;
+  return tables;
+}
+
+/// Function to check if a table is required in a workflow
+/// @param initContext initContext of the init function
+/// @param table name of the table to check for
+inline bool isTableRequiredInWorkflow(o2::framework::InitContext& initContext, const std::string& table)
+{
+  return getTablesRequiredInWorkflow(initContext).count(table) > 0;
 }
 
 /// Function to enable or disable a configurable flag, depending on the fact that a table is needed or not
@@ -59,4 +75,24 @@ void enableFlagIfTableRequired(o2::framework::InitContext& initContext, const st
   }
 }
 
+/// Function to copy the values of a numeric column into a flat array, chunk by chunk from the Arrow buffers
+/// @param table table with the column C, e.g. aod::track::CollisionId
+/// @return values of the column, in the order of the rows
+template <typename C, typename T>
+std::vector<typename C::type> getColumnValues(T const& table)
+{
+  using value_t = typename C::type;
+  std::vector<value_t> values;
+  values.reserve(table.size());
+  auto column = table.asArrowTable()->GetColumnByName(C::columnLabel());
+  if (column == nullptr) {
+    LOG(fatal) << "Column " << C::columnLabel() << " not found";
+  }
+  for (auto const& chunk : column->chunks()) {
+    auto array = std::static_pointer_cast<o2::soa::arrow_array_for_t<value_t>>(chunk);
+    values.insert(values.end(), array->raw_values(), array->raw_values() + array->length());
+  }
+  return values;
+}
+
 #endif // COMMON_CORE_TABLEHELPER_H_
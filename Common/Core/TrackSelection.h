@@ -18,6 +18,7 @@
 
 #include "Framework/Logger.h"
 #include "Framework/DataTypes.h"
+#include <cmath>
 #include <set>
 #include <vector>
 #include "Rtypes.h"
@@ -54,85 +55,89 @@ class TrackSelection
 
   static const std::string mCutNames[static_cast<int>(TrackCuts::kNCuts)];
 
+  static constexpr uint16_t kAllCutsMask = (1u << static_cast<int>(TrackCuts::kNCuts)) - 1u;
+
+  static constexpr uint16_t cutBit(const TrackCuts& cut) { return 1u << static_cast<int>(cut); }
+
   // Temporary function to check if track passes selection criteria. To be replaced by framework filters.
   template <typename T>
   bool IsSelected(T const& track)
   {
-    if (!IsSelected(track, TrackCuts::kTrackType)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kPtRange)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kEtaRange)) {
-      return false;
-    }
-    if (!IsSelected(track, TrackCuts::kTPCNCls)) {
-      return false;
+    return EvaluateCuts<kAllCutsMask>(track) == kAllCutsMask;
+  }
+
+  // Temporary function to check if track passes and return a flag. To be replaced by framework filters.
+  template <typename T>
+  uint16_t IsSelectedMask(T const& track)
+  {
+    return EvaluateCuts<kAllCutsMask>(track);
+  }
+
+  // Evaluates the cuts set in CutMask in a single pass and returns the word of passed cuts (bits are ordered as TrackCuts).
+  // The cuts to be checked are resolved at compile time, each column is read once and the bits are combined without branching.
+  template <uint16_t CutMask, typename T>
+  uint16_t EvaluateCuts(T const& track)
+  {
+    auto bit = [](bool passed, const TrackCuts& cut) -> uint16_t { return static_cast<uint16_t>(passed) << static_cast<int>(cut); };
+
+    const auto trackType = track.trackType();
+    const bool isRun2 = trackType == o2::aod::track::Run2Track || trackType == o2::aod::track::Run2Tracklet;
+    uint16_t flag = 0;
+
+    if constexpr ((CutMask & (cutBit(TrackCuts::kPtRange) | cutBit(TrackCuts::kDCAxy))) != 0) {
+      const float pt = track.pt();
+      if constexpr ((CutMask & cutBit(TrackCuts::kPtRange)) != 0) {
+        flag |= bit((pt >= mMinPt) & (pt <= mMaxPt), TrackCuts::kPtRange);
+      }
+      if constexpr ((CutMask & cutBit(TrackCuts::kDCAxy)) != 0) {
+        flag |= bit(std::abs(track.dcaXY()) <= ((mMaxDcaXYPtDep) ? mMaxDcaXYPtDep(pt) : mMaxDcaXY), TrackCuts::kDCAxy);
+      }
     }
-    if (!IsSelected(track, TrackCuts::kTPCCrossedRows)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kTrackType)) != 0) {
+      flag |= bit(trackType == mTrackType, TrackCuts::kTrackType);
     }
-    if (!IsSelected(track, TrackCuts::kTPCCrossedRowsOverNCls)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kEtaRange)) != 0) {
+      const float eta = track.eta();
+      flag |= bit((eta >= mMinEta) & (eta <= mMaxEta), TrackCuts::kEtaRange);
     }
-    if (!IsSelected(track, TrackCuts::kTPCChi2NDF)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kTPCNCls)) != 0) {
+      flag |= bit(track.tpcNClsFound() >= mMinNClustersTPC, TrackCuts::kTPCNCls);
     }
-    if (!IsSelected(track, TrackCuts::kTPCRefit)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kTPCCrossedRows)) != 0) {
+      flag |= bit(track.tpcNClsCrossedRows() >= mMinNCrossedRowsTPC, TrackCuts::kTPCCrossedRows);
     }
-    if (!IsSelected(track, TrackCuts::kITSNCls)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kTPCCrossedRowsOverNCls)) != 0) {
+      flag |= bit(track.tpcCrossedRowsOverFindableCls() >= mMinNCrossedRowsOverFindableClustersTPC, TrackCuts::kTPCCrossedRowsOverNCls);
     }
-    if (!IsSelected(track, TrackCuts::kITSChi2NDF)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kTPCChi2NDF)) != 0) {
+      flag |= bit(track.tpcChi2NCl() <= mMaxChi2PerClusterTPC, TrackCuts::kTPCChi2NDF);
     }
-    if (!IsSelected(track, TrackCuts::kITSRefit)) {
-      return false;
+    if constexpr ((CutMask & (cutBit(TrackCuts::kTPCRefit) | cutBit(TrackCuts::kITSRefit) | cutBit(TrackCuts::kGoldenChi2))) != 0) {
+      const auto flags = track.flags();
+      if constexpr ((CutMask & cutBit(TrackCuts::kTPCRefit)) != 0) {
+        const bool hasTPCRefit = isRun2 ? (flags & o2::aod::track::TPCrefit) != 0 : track.hasTPC();
+        flag |= bit(!mRequireTPCRefit | hasTPCRefit, TrackCuts::kTPCRefit);
+      }
+      if constexpr ((CutMask & cutBit(TrackCuts::kITSRefit)) != 0) {
+        const bool hasITSRefit = isRun2 ? (flags & o2::aod::track::ITSrefit) != 0 : track.hasITS();
+        flag |= bit(!mRequireITSRefit | hasITSRefit, TrackCuts::kITSRefit);
+      }
+      if constexpr ((CutMask & cutBit(TrackCuts::kGoldenChi2)) != 0) {
+        flag |= bit(!(isRun2 & mRequireGoldenChi2) | ((flags & o2::aod::track::GoldenChi2) != 0), TrackCuts::kGoldenChi2);
+      }
     }
-    if (!IsSelected(track, TrackCuts::kITSHits)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kITSNCls)) != 0) {
+      flag |= bit(track.itsNCls() >= mMinNClustersITS, TrackCuts::kITSNCls);
     }
-    if (!IsSelected(track, TrackCuts::kGoldenChi2)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kITSChi2NDF)) != 0) {
+      flag |= bit(track.itsChi2NCl() <= mMaxChi2PerClusterITS, TrackCuts::kITSChi2NDF);
     }
-    if (!IsSelected(track, TrackCuts::kDCAxy)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kITSHits)) != 0) {
+      flag |= bit(mRequiredITSHits.empty() || FulfillsITSHitRequirements(track.itsClusterMap()), TrackCuts::kITSHits);
     }
-    if (!IsSelected(track, TrackCuts::kDCAz)) {
-      return false;
+    if constexpr ((CutMask & cutBit(TrackCuts::kDCAz)) != 0) {
+      flag |= bit(std::abs(track.dcaZ()) <= mMaxDcaZ, TrackCuts::kDCAz);
     }
-    return true;
-  }
-
-  // Temporary function to check if track passes and return a flag. To be replaced by framework filters.
-  template <typename T>
-  uint16_t IsSelectedMask(T const& track)
-  {
-    uint16_t flag = 0;
-
-    auto setFlag = [&](const TrackCuts& cut) {
-      if (IsSelected(track, cut)) {
-        flag |= 1UL << static_cast<int>(cut);
-      }
-    };
-
-    setFlag(TrackCuts::kTrackType);
-    setFlag(TrackCuts::kPtRange);
-    setFlag(TrackCuts::kEtaRange);
-    setFlag(TrackCuts::kTPCNCls);
-    setFlag(TrackCuts::kTPCCrossedRows);
-    setFlag(TrackCuts::kTPCCrossedRowsOverNCls);
-    setFlag(TrackCuts::kTPCChi2NDF);
-    setFlag(TrackCuts::kTPCRefit);
-    setFlag(TrackCuts::kITSNCls);
-    setFlag(TrackCuts::kITSChi2NDF);
-    setFlag(TrackCuts::kITSRefit);
-    setFlag(TrackCuts::kITSHits);
-    setFlag(TrackCuts::kGoldenChi2);
-    setFlag(TrackCuts::kDCAxy);
-    setFlag(TrackCuts::kDCAz);
 
     return flag;
   }
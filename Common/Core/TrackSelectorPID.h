@@ -17,6 +17,9 @@
 #ifndef O2_ANALYSIS_TRACKSELECTORPID_H_
 #define O2_ANALYSIS_TRACKSELECTORPID_H_
 
+#include <cstdint>
+#include <vector>
+
 #include <TPDGCode.h>
 
 #include "Framework/Logger.h"
@@ -111,20 +114,13 @@ class TrackSelectorPID
     return mPtTPCMin <= pt && pt <= mPtTPCMax;
   }
 
-  /// Checks if track is compatible with given particle species hypothesis within given TPC nσ range.
+  /// Returns the TPC nσ of a track for the particle species hypothesis.
   /// \param track  track
-  /// \param conditionalTOF  variable to store the result of selection with looser cuts for conditional accepting of track if combined with TOF
-  /// \return true if track satisfies TPC PID hypothesis for given TPC nσ range
+  /// \return TPC nσ
   template <typename T>
-  bool isSelectedTrackPIDTPC(const T& track, bool& conditionalTOF)
+  float getNSigmaTPC(const T& track)
   {
-    // Accept if selection is disabled via large values.
-    if (mNSigmaTPCMin < -999. && mNSigmaTPCMax > 999.) {
-      return true;
-    }
-
-    // Get nσ for a given particle hypothesis.
-    double nSigma = 100.;
+    float nSigma = 100.;
     switch (mPdg) {
       case kElectron: {
         nSigma = track.tpcNSigmaEl();
@@ -151,6 +147,23 @@ class TrackSelectorPID
         assert(false);
       }
     }
+    return nSigma;
+  }
+
+  /// Checks if track is compatible with given particle species hypothesis within given TPC nσ range.
+  /// \param track  track
+  /// \param conditionalTOF  variable to store the result of selection with looser cuts for conditional accepting of track if combined with TOF
+  /// \return true if track satisfies TPC PID hypothesis for given TPC nσ range
+  template <typename T>
+  bool isSelectedTrackPIDTPC(const T& track, bool& conditionalTOF)
+  {
+    // Accept if selection is disabled via large values.
+    if (mNSigmaTPCMin < -999. && mNSigmaTPCMax > 999.) {
+      return true;
+    }
+
+    // Get nσ for a given particle hypothesis.
+    double nSigma = getNSigmaTPC(track);
 
     if (mNSigmaTPCMinCondTOF < -999. && mNSigmaTPCMaxCondTOF > 999.) {
       conditionalTOF = true;
@@ -213,20 +226,13 @@ class TrackSelectorPID
     return mPtTOFMin <= pt && pt <= mPtTOFMax;
   }
 
-  /// Checks if track is compatible with given particle species hypothesis within given TOF nσ range.
+  /// Returns the TOF nσ of a track for the particle species hypothesis.
   /// \param track  track
-  /// \param conditionalTPC  variable to store the result of selection with looser cuts for conditional accepting of track if combined with TPC
-  /// \return true if track satisfies TOF PID hypothesis for given TOF nσ range
+  /// \return TOF nσ
   template <typename T>
-  bool isSelectedTrackPIDTOF(const T& track, bool& conditionalTPC)
+  float getNSigmaTOF(const T& track)
   {
-    // Accept if selection is disabled via large values.
-    if (mNSigmaTOFMin < -999. && mNSigmaTOFMax > 999.) {
-      return true;
-    }
-
-    // Get nσ for a given particle hypothesis.
-    double nSigma = 100.;
+    float nSigma = 100.;
     switch (mPdg) {
       case kElectron: {
         nSigma = track.tofNSigmaEl();
@@ -253,6 +259,23 @@ class TrackSelectorPID
         assert(false);
       }
     }
+    return nSigma;
+  }
+
+  /// Checks if track is compatible with given particle species hypothesis within given TOF nσ range.
+  /// \param track  track
+  /// \param conditionalTPC  variable to store the result of selection with looser cuts for conditional accepting of track if combined with TPC
+  /// \return true if track satisfies TOF PID hypothesis for given TOF nσ range
+  template <typename T>
+  bool isSelectedTrackPIDTOF(const T& track, bool& conditionalTPC)
+  {
+    // Accept if selection is disabled via large values.
+    if (mNSigmaTOFMin < -999. && mNSigmaTOFMax > 999.) {
+      return true;
+    }
+
+    // Get nσ for a given particle hypothesis.
+    double nSigma = getNSigmaTOF(track);
 
     if (mNSigmaTOFMinCondTPC < -999. && mNSigmaTOFMaxCondTPC > 999.) {
       conditionalTPC = true;
@@ -438,9 +461,15 @@ class TrackSelectorPID
   template <typename T>
   int getStatusTrackPIDAll(const T& track)
   {
-    int statusTPC = getStatusTrackPIDTPC(track);
-    int statusTOF = getStatusTrackPIDTOF(track);
+    return combineStatusTPCAndTOF(getStatusTrackPIDTPC(track), getStatusTrackPIDTOF(track));
+  }
 
+  /// Returns status of combined PID (TPC + TOF) selection from the statuses of the two detectors.
+  /// \param statusTPC  TPC selection status
+  /// \param statusTOF  TOF selection status
+  /// \return status of combined PID (TPC + TOF) (see TrackSelectorPID::Status)
+  static int combineStatusTPCAndTOF(int statusTPC, int statusTOF)
+  {
     if (statusTPC == Status::PIDAccepted || statusTOF == Status::PIDAccepted) {
       return Status::PIDAccepted; // what if we have Accepted for one and Rejected for the other?
     }
@@ -453,6 +482,51 @@ class TrackSelectorPID
     return Status::PIDNotApplicable; // (NotApplicable for one detector) and (NotApplicable or Conditional for the other)
   }
 
+  /// Returns status of a PID selection from the values of pT and nσ, without branches on the ranges.
+  /// Same as getStatusTrackPIDTPC and getStatusTrackPIDTOF with the ranges of the detector.
+  static int getStatusPID(float pt, float nSigma, float ptMin, float ptMax, float nSigmaMin, float nSigmaMax, float nSigmaMinCond, float nSigmaMaxCond)
+  {
+    const int valid = (ptMin <= pt) & (pt <= ptMax);
+    const int selected = ((nSigmaMin < -999.f) & (nSigmaMax > 999.f)) | ((nSigmaMin <= nSigma) & (nSigma <= nSigmaMax));
+    const int conditional = ((nSigmaMinCond < -999.f) & (nSigmaMaxCond > 999.f)) | ((nSigmaMinCond <= nSigma) & (nSigma <= nSigmaMaxCond));
+    // PIDRejected (1), PIDConditional (2) or PIDAccepted (3) if valid, PIDNotApplicable (0) otherwise
+    return valid * (Status::PIDRejected + (selected | conditional) + selected);
+  }
+
+  /// Returns statuses of combined PID (TPC + TOF) selection for a block of tracks.
+  /// \param n  number of tracks
+  /// \param pt  track pT
+  /// \param nSigmaTPC  TPC nσ of the tracks for the species hypothesis
+  /// \param nSigmaTOF  TOF nσ of the tracks for the species hypothesis
+  /// \param status  status of combined PID (TPC + TOF) of the tracks (see TrackSelectorPID::Status)
+  void getStatusTrackPIDAllBatch(std::size_t n, const float* pt, const float* nSigmaTPC, const float* nSigmaTOF, int8_t* status) const
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      const int statusTPC = getStatusPID(pt[i], nSigmaTPC[i], mPtTPCMin, mPtTPCMax, mNSigmaTPCMin, mNSigmaTPCMax, mNSigmaTPCMinCondTOF, mNSigmaTPCMaxCondTOF);
+      const int statusTOF = getStatusPID(pt[i], nSigmaTOF[i], mPtTOFMin, mPtTOFMax, mNSigmaTOFMin, mNSigmaTOFMax, mNSigmaTOFMinCondTPC, mNSigmaTOFMaxCondTPC);
+      status[i] = combineStatusTPCAndTOF(statusTPC, statusTOF);
+    }
+  }
+
+  /// Fills the statuses of combined PID (TPC + TOF) selection of all the tracks of a table,
+  /// to be looked up by track index instead of being recomputed for each candidate using the track.
+  /// \param tracks  tracks
+  /// \param status  status of combined PID (TPC + TOF) of the tracks, in the order of the table (see TrackSelectorPID::Status)
+  template <typename T>
+  void fillStatusTrackPIDAll(const T& tracks, std::vector<int8_t>& status)
+  {
+    mPtBatch.clear();
+    mNSigmaTPCBatch.clear();
+    mNSigmaTOFBatch.clear();
+    for (const auto& track : tracks) {
+      mPtBatch.push_back(track.pt());
+      mNSigmaTPCBatch.push_back(getNSigmaTPC(track));
+      mNSigmaTOFBatch.push_back(getNSigmaTOF(track));
+    }
+    status.resize(mPtBatch.size());
+    getStatusTrackPIDAllBatch(mPtBatch.size(), mPtBatch.data(), mNSigmaTPCBatch.data(), mNSigmaTOFBatch.data(), status.data());
+  }
+
   /// Checks whether a track is identified as electron and rejected as pion by TOF or RICH.
   /// \param track  track
   /// \param useTOF  switch to use TOF
@@ -580,6 +654,11 @@ class TrackSelectorPID
   // Bayesian
   float mPtBayesMin = 0.;   ///< minimum pT for Bayesian PID [GeV/c]
   float mPtBayesMax = 100.; ///< maximum pT for Bayesian PID [GeV/c]
+
+  // buffers of the batch selection
+  std::vector<float> mPtBatch;        ///< pT of the tracks
+  std::vector<float> mNSigmaTPCBatch; ///< TPC nσ of the tracks
+  std::vector<float> mNSigmaTOFBatch; ///< TOF nσ of the tracks
 };
 
 #endif // O2_ANALYSIS_TRACKSELECTORPID_H_
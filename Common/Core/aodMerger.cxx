@@ -24,6 +24,7 @@
 #include <TGrid.h>
 #include <TMap.h>
 #include <TLeaf.h>
+#include <TROOT.h>
 
 const char* removeVersionSuffix(const char* treeName)
 {
@@ -63,6 +64,18 @@ const char* getTableName(const char* branchName, const char* treeName)
   return tableName;
 }
 
+bool hasIndexColumns(TTree* tree)
+{
+  // index columns need to be shifted, the entries of such trees have to be read one by one
+  TObjArray* branches = tree->GetListOfBranches();
+  for (int i = 0; i < branches->GetEntriesFast(); ++i) {
+    if (TString(((TBranch*)branches->UncheckedAt(i))->GetName()).BeginsWith("fIndex")) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // AOD merger with correct index rewriting
 // No need to know the datamodel because the branch names follow a canonical standard (identified by fIndex)
 int main(int argc, char* argv[])
@@ -70,6 +83,10 @@ int main(int argc, char* argv[])
   std::string inputCollection("input.txt");
   std::string outputFileName("AO2D.root");
   long maxDirSize = 100000000;
+  long maxFileSize = 0;
+  long flushSize = 0;
+  int nThreads = 1;
+  bool fastCopy = false;
   bool skipNonExistingFiles = false;
   int exitCode = 0; // 0: success, >0: failure
 
@@ -80,6 +97,10 @@ int main(int argc, char* argv[])
     {"max-size", required_argument, nullptr, 2},
     {"skip-non-existing-files", no_argument, nullptr, 3},
     {"help", no_argument, nullptr, 4},
+    {"threads", required_argument, nullptr, 5},
+    {"fast-copy", no_argument, nullptr, 6},
+    {"max-file-size", required_argument, nullptr, 7},
+    {"flush-size", required_argument, nullptr, 8},
     {nullptr, 0, nullptr, 0}};
 
   while (true) {
@@ -94,12 +115,24 @@ int main(int argc, char* argv[])
       maxDirSize = atol(optarg);
     } else if (c == 3) {
       skipNonExistingFiles = true;
+    } else if (c == 5) {
+      nThreads = atoi(optarg);
+    } else if (c == 6) {
+      fastCopy = true;
+    } else if (c == 7) {
+      maxFileSize = atol(optarg);
+    } else if (c == 8) {
+      flushSize = atol(optarg);
     } else if (c == 4) {
       printf("AO2D merging tool. Options: \n");
       printf("  --input <inputfile.txt>      Contains path to files to be merged. Default: %s\n", inputCollection.c_str());
       printf("  --output <outputfile.root>   Target output ROOT file. Default: %s\n", outputFileName.c_str());
       printf("  --max-size <size in Bytes>   Target directory size. Default: %ld. Set to 0 if file is not self-contained.\n", maxDirSize);
       printf("  --skip-non-existing-files    Flag to allow skipping of non-existing files in the input list.\n");
+      printf("  --threads <n>                Number of threads to (de)compress the baskets, 0 for all cores. Default: %d\n", nThreads);
+      printf("  --fast-copy                  Copy the compressed baskets of the trees without index columns, keeping their compression.\n");
+      printf("  --max-file-size <size in Bytes>  Start a new output file <output>_<n>.root when a folder is closed above this size. Default: %ld (no limit).\n", maxFileSize);
+      printf("  --flush-size <size in Bytes>  Memory bound per tree: baskets are flushed to the output file and input is cached in chunks of this size. Default: %ld (baskets flushed when full).\n", flushSize);
       return -1;
     } else {
       return -2;
@@ -113,11 +146,26 @@ int main(int argc, char* argv[])
   if (skipNonExistingFiles) {
     printf("  WARNING: Skipping non-existing files.\n");
   }
+  if (nThreads != 1) {
+    // baskets are (de)compressed in parallel over the branches of a tree
+    ROOT::EnableImplicitMT(nThreads > 0 ? nThreads : 0);
+    printf("  Threads: %d\n", ROOT::GetThreadPoolSize());
+  }
+  if (fastCopy) {
+    printf("  Fast copy of the trees without index columns\n");
+  }
+  if (maxFileSize > 0) {
+    printf("  Maximal output file size (compressed): %ld\n", maxFileSize);
+  }
+  if (flushSize > 0) {
+    printf("  Flush size per tree (uncompressed): %ld\n", flushSize);
+  }
 
   std::map<std::string, TTree*> trees;
   std::map<std::string, int> offsets;
   std::map<std::string, int> unassignedIndexOffset;
 
+  std::vector<std::string> outputFileNames{outputFileName};
   auto outputFile = TFile::Open(outputFileName.c_str(), "RECREATE", "", 501);
   TDirectory* outputDir = nullptr;
   long currentDirSize = 0;
@@ -244,6 +292,9 @@ int main(int argc, char* argv[])
 
         auto inputTree = (TTree*)inputFile->Get(Form("%s/%s", dfName, treeName));
         printf("    Tree %s has %lld entries\n", treeName, inputTree->GetEntries());
+        if (flushSize > 0) {
+          inputTree->SetCacheSize(flushSize);
+        }
 
         if (trees.count(treeName) == 0) {
           if (mergedDFs > 1) {
@@ -260,7 +311,8 @@ int main(int argc, char* argv[])
           }
           outputDir->cd();
           auto outputTree = inputTree->CloneTree(0);
-          outputTree->SetAutoFlush(0);
+          // a negative value flushes all the baskets each time flushSize bytes are filled
+          outputTree->SetAutoFlush(flushSize > 0 ? -flushSize : 0);
           trees[treeName] = outputTree;
         } else {
           // adjust addresses tree
@@ -268,8 +320,20 @@ int main(int argc, char* argv[])
         }
 
         auto outputTree = trees[treeName];
+
+        // trees without index columns are copied basket by basket, without decompression
+        if (fastCopy && !hasIndexColumns(inputTree)) {
+          auto nbytes = outputTree->CopyEntries(inputTree, -1, "fast");
+          if (nbytes > 0) {
+            currentDirSize += nbytes;
+          }
+          delete inputTree;
+          continue;
+        }
+
         // register index and connect VLA columns
         std::vector<std::pair<int*, int>> indexList;
+        std::vector<int*> vlaIndexList; // only the VLA elements beyond the size of an entry are not overwritten by GetEntry
         std::vector<char*> vlaPointers;
         std::vector<int*> indexPointers;
         TObjArray* branches = inputTree->GetListOfBranches();
@@ -297,6 +361,7 @@ int main(int argc, char* argv[])
             if (branchName.BeginsWith("fIndexArray")) {
               for (int i = 0; i < maximum; i++) {
                 indexList.push_back({reinterpret_cast<int*>(buffer + i * typeSize), offsets[getTableName(branchName, treeName)]});
+                vlaIndexList.push_back(reinterpret_cast<int*>(buffer + i * typeSize));
               }
             }
           } else if (branchName.BeginsWith("fIndexSlice")) {
@@ -325,8 +390,8 @@ int main(int argc, char* argv[])
         int minIndexOffset = unassignedIndexOffset[treeName];
         auto newMinIndexOffset = minIndexOffset;
         for (int i = 0; i < entries; i++) {
-          for (auto& index : indexList) {
-            *(index.first) = 0; // Any positive number will do, in any case it will not be filled in the output. Otherwise the previous entry is used and manipulated in the following.
+          for (auto& index : vlaIndexList) {
+            *index = 0; // Any positive number will do, in any case it will not be filled in the output. Otherwise the previous entry is used and manipulated in the following.
           }
           inputTree->GetEntry(i);
           // shift index columns by offset
@@ -403,6 +468,29 @@ int main(int argc, char* argv[])
         trees.clear();
         offsets.clear();
         mergedDFs = 0;
+
+        // the folders are self-contained, the next ones can be streamed to a new file
+        if (maxFileSize > 0 && outputFile->GetEND() > maxFileSize) {
+          printf("Maximum file size reached: %lld. Closing file %s.\n", outputFile->GetEND(), outputFile->GetName());
+          if (parentFiles) {
+            outputFile->cd();
+            parentFiles->Write("parentFiles", TObject::kSingleKey);
+          }
+          outputFile->Write();
+          outputFile->Close();
+          delete outputFile;
+
+          TString nextName(outputFileName.c_str());
+          nextName.ReplaceAll(".root", "");
+          nextName += Form("_%03zu.root", outputFileNames.size());
+          outputFileNames.emplace_back(nextName.Data());
+          printf("Writing to output file %s\n", nextName.Data());
+          outputFile = TFile::Open(nextName, "RECREATE", "", 501);
+          if (metaData) {
+            outputFile->cd();
+            metaData->Write("metaData", TObject::kSingleKey);
+          }
+        }
       }
     }
     inputFile->Close();
@@ -421,10 +509,12 @@ int main(int argc, char* argv[])
     exitCode = 2;
   }
 
-  // in case of failure, remove the incomplete file
+  // in case of failure, remove the incomplete files
   if (exitCode != 0) {
-    printf("Removing incomplete output file %s.\n", outputFile->GetName());
-    gSystem->Unlink(outputFile->GetName());
+    for (auto const& name : outputFileNames) {
+      printf("Removing incomplete output file %s.\n", name.c_str());
+      gSystem->Unlink(name.c_str());
+    }
   }
 
   printf("AOD merger finished.\n");
@@ -17,6 +17,8 @@
 #ifndef O2_ANALYSIS_TRACKUTILITIES_H_
 #define O2_ANALYSIS_TRACKUTILITIES_H_
 
+#include <vector>
+
 #include "ReconstructionDataFormats/Track.h"
 #include "ReconstructionDataFormats/Vertex.h"
 #include "Common/Core/RecoDecay.h"
@@ -45,6 +47,39 @@ o2::track::TrackParametrizationWithError<TrackPrecision> getTrackParCov(const T&
   return o2::track::TrackParametrizationWithError<TrackPrecision>(track.x(), track.alpha(), std::move(arraypar), std::move(covpar));
 }
 
+/// Track parameters and covariance matrices of the tracks of a dataframe, indexed by global index.
+/// A track is converted at its first use only, so that the tracks shared by many candidates are converted once.
+/// reset() must be called with the size of the tracks table at the beginning of every dataframe.
+template <typename TrackPrecision = float>
+class TrackParCovCache
+{
+ public:
+  void reset(std::size_t nTracks)
+  {
+    mTracks.resize(nTracks);
+    mIsFilled.assign(nTracks, false);
+  }
+
+  template <typename T>
+  const o2::track::TrackParametrizationWithError<TrackPrecision>& get(const T& track)
+  {
+    auto index = track.globalIndex();
+    if (index >= static_cast<int64_t>(mTracks.size())) {
+      mTracks.resize(index + 1);
+      mIsFilled.resize(index + 1, false);
+    }
+    if (!mIsFilled[index]) {
+      mTracks[index] = getTrackParCov<TrackPrecision>(track);
+      mIsFilled[index] = true;
+    }
+    return mTracks[index];
+  }
+
+ private:
+  std::vector<o2::track::TrackParametrizationWithError<TrackPrecision>> mTracks;
+  std::vector<bool> mIsFilled;
+};
+
 /// Extracts primary vertex position and covariance matrix from a collision.
 template <typename T>
 o2::dataformats::VertexBase getPrimaryVertex(const T& collision)
@@ -0,0 +1,73 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   EventObservables.h
+/// \brief  Event observables computed from the tracks, joinable with aod::Collisions
+///         The leading track, the transverse sphericity, the multiplicities in three pseudorapidity classes and the
+///         2nd and 3rd harmonic Q-vectors of each collision are produced by the event-observables task in a single
+///         pass over the tracks of the dataframe, for the tasks which would otherwise loop over the tracks of each
+///         collision to compute them. The track selection and the pseudorapidity limits are configurables of the task.
+///
+
+#ifndef COMMON_DATAMODEL_EVENTOBSERVABLES_H_
+#define COMMON_DATAMODEL_EVENTOBSERVABLES_H_
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace evtobs
+{
+DECLARE_SOA_COLUMN(LeadingTrackId, leadingTrackId, int); //! Global index of the leading track, -1 if there is no selected track
+DECLARE_SOA_COLUMN(LeadingPt, leadingPt, float);         //! pT of the leading track (GeV/c), -1 if there is no selected track
+DECLARE_SOA_COLUMN(LeadingEta, leadingEta, float);       //! Pseudorapidity of the leading track
+DECLARE_SOA_COLUMN(LeadingPhi, leadingPhi, float);       //! Azimuthal angle of the leading track
+DECLARE_SOA_DYNAMIC_COLUMN(HasLeading, hasLeading,       //! Whether the collision has a selected track
+                           [](int leadingTrackId) -> bool { return leadingTrackId >= 0; });
+
+DECLARE_SOA_COLUMN(SphericityT, sphericityT, float); //! Transverse sphericity of the selected tracks, -1 for less than 3 tracks
+
+DECLARE_SOA_COLUMN(MultEtaClass1, multEtaClass1, int); //! Selected tracks with |eta| below the first limit (default 0.5)
+DECLARE_SOA_COLUMN(MultEtaClass2, multEtaClass2, int); //! Selected tracks with |eta| below the second limit (default 0.8)
+DECLARE_SOA_COLUMN(MultEtaClass3, multEtaClass3, int); //! Selected tracks with |eta| below the third limit (default 1.0)
+
+DECLARE_SOA_COLUMN(Q2X, q2X, float);   //! Sum of cos(2 phi) of the selected tracks
+DECLARE_SOA_COLUMN(Q2Y, q2Y, float);   //! Sum of sin(2 phi) of the selected tracks
+DECLARE_SOA_COLUMN(Q3X, q3X, float);   //! Sum of cos(3 phi) of the selected tracks
+DECLARE_SOA_COLUMN(Q3Y, q3Y, float);   //! Sum of sin(3 phi) of the selected tracks
+DECLARE_SOA_COLUMN(QMult, qMult, int); //! Number of tracks in the Q-vectors
+DECLARE_SOA_DYNAMIC_COLUMN(Psi2, psi2, //! 2nd harmonic event plane angle in (-pi/2, pi/2]
+                           [](float q2X, float q2Y) -> float { return 0.5f * std::atan2(q2Y, q2X); });
+DECLARE_SOA_DYNAMIC_COLUMN(Psi3, psi3, //! 3rd harmonic event plane angle in (-pi/3, pi/3]
+                           [](float q3X, float q3Y) -> float { return std::atan2(q3Y, q3X) / 3.f; });
+} // namespace evtobs
+
+DECLARE_SOA_TABLE(EvtLeadings, "AOD", "EVTLEADING", //! Leading track of the collisions, joinable with aod::Collisions
+                  evtobs::LeadingTrackId, evtobs::LeadingPt, evtobs::LeadingEta, evtobs::LeadingPhi,
+                  evtobs::HasLeading<evtobs::LeadingTrackId>);
+using EvtLeading = EvtLeadings::iterator;
+
+DECLARE_SOA_TABLE(EvtShapes, "AOD", "EVTSHAPE", //! Event shape of the collisions, joinable with aod::Collisions
+                  evtobs::SphericityT);
+using EvtShape = EvtShapes::iterator;
+
+DECLARE_SOA_TABLE(EvtEtaMults, "AOD", "EVTETAMULT", //! Multiplicities in pseudorapidity classes, joinable with aod::Collisions
+                  evtobs::MultEtaClass1, evtobs::MultEtaClass2, evtobs::MultEtaClass3);
+using EvtEtaMult = EvtEtaMults::iterator;
+
+DECLARE_SOA_TABLE(EvtQvecs, "AOD", "EVTQVEC", //! 2nd and 3rd harmonic Q-vectors, joinable with aod::Collisions
+                  evtobs::Q2X, evtobs::Q2Y, evtobs::Q3X, evtobs::Q3Y, evtobs::QMult,
+                  evtobs::Psi2<evtobs::Q2X, evtobs::Q2Y>, evtobs::Psi3<evtobs::Q3X, evtobs::Q3Y>);
+using EvtQvec = EvtQvecs::iterator;
+} // namespace o2::aod
+
+#endif // COMMON_DATAMODEL_EVENTOBSERVABLES_H_
@@ -0,0 +1,43 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   PIDDecisions.h
+/// \brief  PID selection decisions of the tracks, joinable with aod::Tracks
+///         The pid-decisions task evaluates a configurable list of named PID selections (species, detectors, pT range
+///         and nsigma windows) once per track from the TPC and TOF PID tables. Bit i of the mask is set if the track
+///         passes the i-th selection of the list, so that the tasks of a train test a bit instead of recomputing the
+///         same selection from the nsigma columns. The names of the selections are printed by the task at init.
+///
+
+#ifndef COMMON_DATAMODEL_PIDDECISIONS_H_
+#define COMMON_DATAMODEL_PIDDECISIONS_H_
+
+#include <cstdint>
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace piddecision
+{
+DECLARE_SOA_COLUMN(PIDDecisionMask, pidDecisionMask, uint32_t); //! Bit i set if the track passes the i-th PID selection
+DECLARE_SOA_DYNAMIC_COLUMN(PassesPID, passesPID,                //! Whether the track passes the PID selection of the given index
+                           [](uint32_t pidDecisionMask, int selection) -> bool { return (pidDecisionMask >> selection) & 1u; });
+} // namespace piddecision
+
+DECLARE_SOA_TABLE(PIDDecisions, "AOD", "PIDDECISION", //! PID selection decisions of the tracks, joinable with aod::Tracks
+                  piddecision::PIDDecisionMask,
+                  piddecision::PassesPID<piddecision::PIDDecisionMask>);
+using PIDDecision = PIDDecisions::iterator;
+} // namespace o2::aod
+
+#endif // COMMON_DATAMODEL_PIDDECISIONS_H_
@@ -19,6 +19,8 @@
 #ifndef COMMON_DATAMODEL_PIDRESPONSE_H_
 #define COMMON_DATAMODEL_PIDRESPONSE_H_
 
+#include <cmath>
+#include <cstdint>
 #include <experimental/type_traits>
 
 // O2 includes
@@ -31,19 +33,120 @@ namespace o2::aod
 {
 namespace pidutils
 {
+// Binnings with their own encoding define static pack(float) and unpack(binned_t) functions,
+// the others are uniform in [binned_min, binned_max] with bins of size bin_width
+template <class binningType>
+using hasCustomPacking = decltype(binningType::unpack(std::declval<typename binningType::binned_t>()));
+
+// Function to pack a float into a binned value
+template <typename binningType>
+typename binningType::binned_t packValue(const float& valueToBin)
+{
+  if constexpr (std::experimental::is_detected<hasCustomPacking, binningType>::value) {
+    return binningType::pack(valueToBin);
+  } else {
+    if (valueToBin <= binningType::binned_min) {
+      return binningType::underflowBin;
+    } else if (valueToBin >= binningType::binned_max) {
+      return binningType::overflowBin;
+    } else if (valueToBin >= 0) {
+      return static_cast<typename binningType::binned_t>((valueToBin / binningType::bin_width) + 0.5f);
+    }
+    return static_cast<typename binningType::binned_t>((valueToBin / binningType::bin_width) - 0.5f);
+  }
+}
+
+// Function to unpack a binned value into a float
+template <typename binningType>
+float unpackValue(const typename binningType::binned_t& binnedValue)
+{
+  if constexpr (std::experimental::is_detected<hasCustomPacking, binningType>::value) {
+    return binningType::unpack(binnedValue);
+  } else {
+    return binningType::bin_width * static_cast<float>(binnedValue);
+  }
+}
+
+// Function to unpack n binned values into an array of floats, e.g. a whole column for a vectorised selection
+template <typename binningType>
+void unpackInArray(const typename binningType::binned_t* binnedValues, std::size_t n, float* values)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    values[i] = unpackValue<binningType>(binnedValues[i]);
+  }
+}
+
 // Function to pack a float into a binned value in table
 template <typename binningType, typename T>
 void packInTable(const float& valueToBin, T& table)
 {
-  if (valueToBin <= binningType::binned_min) {
-    table(binningType::underflowBin);
-  } else if (valueToBin >= binningType::binned_max) {
-    table(binningType::overflowBin);
-  } else if (valueToBin >= 0) {
-    table(static_cast<typename binningType::binned_t>((valueToBin / binningType::bin_width) + 0.5f));
-  } else {
-    table(static_cast<typename binningType::binned_t>((valueToBin / binningType::bin_width) - 0.5f));
+  table(packValue<binningType>(valueToBin));
+}
+
+// Uniform binning in [-maxTimes100 / 100, maxTimes100 / 100], to set a range per species and detector
+template <int maxTimes100, typename binnedType = int8_t>
+struct binningUniform {
+ public:
+  typedef binnedType binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+  static constexpr float binned_max = maxTimes100 / 100.f;
+  static constexpr float binned_min = -binned_max;
+  static constexpr float bin_width = (binned_max - binned_min) / nbins;
+};
+
+// Quadratic binning in [-maxTimes100 / 100, maxTimes100 / 100]: the bins are finer close to zero, where the selections are,
+// with |x| = binned_max * (b / overflowBin)^2. With binned_max = 10 the bins are 0.09 wide at 3 sigma and 0.16 at 10 sigma
+template <int maxTimes100>
+struct binningQuadratic {
+ public:
+  typedef int8_t binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+  static constexpr float binned_max = maxTimes100 / 100.f;
+  static constexpr float binned_min = -binned_max;
+  static binned_t pack(const float& valueToBin)
+  {
+    if (valueToBin <= binned_min) {
+      return underflowBin;
+    } else if (valueToBin >= binned_max) {
+      return overflowBin;
+    }
+    const float binned = std::sqrt(std::abs(valueToBin) / binned_max) * overflowBin + 0.5f;
+    return static_cast<binned_t>(valueToBin >= 0 ? binned : -binned);
+  }
+  static float unpack(const binned_t& binnedValue)
+  {
+    const float x = static_cast<float>(binnedValue) / overflowBin;
+    return binned_max * x * std::abs(x);
   }
+};
+
+// 4 bit binning for selections only: nsigma in steps of 0.5 in [-3.5, 3.5], values outside are in the overflow and underflow bins.
+// Two of them fit in a byte with packNibbles
+struct binningNibble {
+ public:
+  typedef int8_t binned_t;
+  static constexpr int nbins = 14;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+  static constexpr float binned_max = 3.5;
+  static constexpr float binned_min = -3.5;
+  static constexpr float bin_width = (binned_max - binned_min) / nbins;
+};
+
+// Functions to store two 4 bit binned values in a byte
+inline uint8_t packNibbles(const binningNibble::binned_t& low, const binningNibble::binned_t& high)
+{
+  return static_cast<uint8_t>((low & 0xF) | ((high & 0xF) << 4));
+}
+
+inline binningNibble::binned_t unpackNibble(const uint8_t& packed, const bool high)
+{
+  const int nibble = high ? packed >> 4 : packed & 0xF;
+  return static_cast<binningNibble::binned_t>(nibble >= 8 ? nibble - 16 : nibble); // sign extension of the 4 bits
 }
 
 // Checkers for TOF PID hypothesis availability (runtime)
@@ -483,6 +586,11 @@ DECLARE_SOA_COLUMN(TOFNSigmaAl, tofNSigmaAl, float); //! Nsigma separation with
   DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, COLUMN_NAME,        \
                              [](binning::binned_t nsigma_binned) -> float { return binning::bin_width * static_cast<float>(nsigma_binned); });
 
+// Macro to convert the stored Nsigmas to floats with any of the binnings of pidutils
+#define DEFINE_UNWRAP_NSIGMA_COLUMN_WITH_BINNING(COLUMN, COLUMN_NAME, BINNING) \
+  DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, COLUMN_NAME,                              \
+                             [](BINNING::binned_t nsigma_binned) -> float { return o2::aod::pidutils::unpackValue<BINNING>(nsigma_binned); });
+
 namespace pidtof_tiny
 {
 struct binning {
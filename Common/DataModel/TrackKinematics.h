@@ -0,0 +1,44 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   TrackKinematics.h
+/// \brief  Basic kinematics of the tracks stored once per dataframe, joinable with the tracks table
+///         pt, eta, phi, p, px, py and pz of aod::Tracks are dynamic columns, recomputed from signed1Pt, tgl, snp and
+///         alpha at every access. The tasks accessing them many times per track (e.g. in pair loops) can join
+///         aod::TracksKine, produced by the track-kinematics task, and read the stored values instead.
+///
+
+#ifndef COMMON_DATAMODEL_TRACKKINEMATICS_H_
+#define COMMON_DATAMODEL_TRACKKINEMATICS_H_
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace trackkine
+{
+DECLARE_SOA_COLUMN(PtStored, ptStored, float);   //! Transverse momentum (GeV/c)
+DECLARE_SOA_COLUMN(EtaStored, etaStored, float); //! Pseudorapidity
+DECLARE_SOA_COLUMN(PhiStored, phiStored, float); //! Azimuthal angle in [0, 2pi)
+DECLARE_SOA_COLUMN(PStored, pStored, float);     //! Momentum (GeV/c)
+DECLARE_SOA_COLUMN(PxStored, pxStored, float);   //! Momentum along x (GeV/c)
+DECLARE_SOA_COLUMN(PyStored, pyStored, float);   //! Momentum along y (GeV/c)
+DECLARE_SOA_COLUMN(PzStored, pzStored, float);   //! Momentum along z (GeV/c)
+} // namespace trackkine
+
+DECLARE_SOA_TABLE(TracksKine, "AOD", "TRACKKINE", //! Stored kinematics of the tracks, joinable with aod::Tracks
+                  trackkine::PtStored, trackkine::EtaStored, trackkine::PhiStored, trackkine::PStored,
+                  trackkine::PxStored, trackkine::PyStored, trackkine::PzStored);
+using TrackKine = TracksKine::iterator;
+} // namespace o2::aod
+
+#endif // COMMON_DATAMODEL_TRACKKINEMATICS_H_
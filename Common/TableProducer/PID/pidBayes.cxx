@@ -25,6 +25,7 @@
 #include "Common/Core/PID/TPCPIDResponse.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "Common/Core/TableHelper.h"
 #include "pidTOFBase.h"
 
 using namespace o2;
@@ -41,6 +42,13 @@ void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 
 #include "Framework/runDataProcessing.h"
 
+namespace
+{
+static const std::vector<std::string> priorsSpeciesNames{"El", "Mu", "Pi", "Ka", "Pr", "De", "Tr", "He", "Al"};
+static const std::vector<std::string> priorsPtNames{"allPt"};
+static constexpr float defaultPriors[1][PID::NIDs]{{1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f}};
+} // namespace
+
 struct bayesPid {
   using Trks = soa::Join<aod::Tracks, aod::TracksExtra, aod::TOFSignal, aod::TOFEvTime, aod::pidEvTimeFlags>;
   using Coll = soa::Join<aod::Collisions, aod::Mults>;
@@ -101,29 +109,24 @@ struct bayesPid {
   Configurable<int> pidHe{"pid-he", -1, {"Produce PID information for the Helium3 mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidAl{"pid-al", -1, {"Produce PID information for the Alpha mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
 
+  // Prior probabilities
+  Configurable<std::vector<float>> priorsBinsPt{"priorsBinsPt", {0.f, 1000.f}, "Edges of the pT intervals of the prior probabilities, the tracks outside of the edges take the first or last interval"};
+  Configurable<LabeledArray<float>> priors{"priors", {defaultPriors[0], 1, PID::NIDs, priorsPtNames, priorsSpeciesNames}, "Prior probabilities of the species (columns) in the pT intervals (rows)"};
+
   std::array<std::array<float, PID::NIDs>, kNProb> Probability; /// Probabilities for all the cases defined in ProbType
   std::vector<PID::ID> enabledSpecies;                          /// Enabled species
+  std::array<bool, PID::NIDs> isEnabledSpecies{false};          /// Enabled species, indexed with the particle ID
+  float flatProbability = 1.f;                                  /// Probability of the enabled species without decision
+  std::vector<float> priorEdges;                                /// Edges of the pT intervals of the priors
+  std::vector<std::array<float, PID::NIDs>> priorTable;         /// Prior probabilities per pT interval, read once from the configurable
 
-  /// Checker of the species that are enabled and initializer of the probabilities
-  template <ProbType detIndex, o2::track::PID::ID pid>
-  bool checkEnabled()
+  /// Index of the pT interval of the priors
+  int findPriorBin(const float pt) const
   {
-    static_assert(detIndex < kNDet && detIndex >= 0);
-    if (!enabledDet[detIndex]) {
-      LOG(debug) << "Detector " << detectorName[detIndex] << " disabled";
-      return false; // Setting the probability to 1 if the detector is disabled
-    }
-    LOG(debug) << "Detector " << detectorName[detIndex] << " enabled with " << enabledSpecies.size() << " species";
-
-    for (const auto enabledPid : enabledSpecies) { // Checking that the species is enabled
-      LOG(debug) << "Testing " << PID::getName(enabledPid) << " " << static_cast<int>(enabledPid) << " vs " << static_cast<int>(pid);
-      if (enabledPid == pid) {
-        LOG(debug) << "Particle " << PID::getName(enabledPid) << " enabled";
-        Probability[detIndex][pid] = 1.f / enabledSpecies.size(); // set flat distribution (no decision yet)
-        return true;
-      }
+    if (priorTable.size() == 1) {
+      return 0;
     }
-    return false;
+    return std::distance(priorEdges.begin() + 1, std::upper_bound(priorEdges.begin() + 1, priorEdges.end() - 1, pt));
   }
 
   float fRange = 5.f;
@@ -150,36 +153,20 @@ struct bayesPid {
     }
 
     // Checking the tables are requested in the workflow and enabling them
-    auto& workflows = initContext.services().get<RunningWorkflowInfo const>();
-    for (DeviceSpec const& device : workflows.devices) {
-      for (auto const& input : device.inputs) {
-        auto enableFlag = [&input](const PID::ID& id, Configurable<int>& flag) {
-          const std::string particles[PID::NIDs] = {"El", "Mu", "Pi", "Ka", "Pr", "De", "Tr", "He", "Al"};
-          const std::string particle = particles[id];
-          const std::string table = "pidBayes" + particle;
-          if (input.matcher.binding == table) {
-            if (flag < 0) {
-              flag.value = 1;
-              LOG(info) << "Auto-enabling table: " + table;
-            } else if (flag > 0) {
-              flag.value = 1;
-              LOG(info) << "Table enabled: " + table;
-            } else {
-              LOG(info) << "Table disabled: " + table;
-            }
-          }
-        };
-        enableFlag(PID::Electron, pidEl);
-        enableFlag(PID::Muon, pidMu);
-        enableFlag(PID::Pion, pidPi);
-        enableFlag(PID::Kaon, pidKa);
-        enableFlag(PID::Proton, pidPr);
-        enableFlag(PID::Deuteron, pidDe);
-        enableFlag(PID::Triton, pidTr);
-        enableFlag(PID::Helium3, pidHe);
-        enableFlag(PID::Alpha, pidAl);
-      }
-    }
+    auto enableFlag = [&initContext](const PID::ID& id, Configurable<int>& flag) {
+      const std::string particles[PID::NIDs] = {"El", "Mu", "Pi", "Ka", "Pr", "De", "Tr", "He", "Al"};
+      const std::string particle = particles[id];
+      enableFlagIfTableRequired(initContext, "pidBayes" + particle, flag);
+    };
+    enableFlag(PID::Electron, pidEl);
+    enableFlag(PID::Muon, pidMu);
+    enableFlag(PID::Pion, pidPi);
+    enableFlag(PID::Kaon, pidKa);
+    enableFlag(PID::Proton, pidPr);
+    enableFlag(PID::Deuteron, pidDe);
+    enableFlag(PID::Triton, pidTr);
+    enableFlag(PID::Helium3, pidHe);
+    enableFlag(PID::Alpha, pidAl);
 
     // Enabling species (only once) that are requested
     enabledSpecies.reserve(PID::NIDs); // Reserving a space for every particle species
@@ -212,6 +199,22 @@ struct bayesPid {
     } else { // All ok
       LOG(info) << enabledSpecies.size() << " species enabled for the Bayesian PID computation";
     }
+    for (const auto enabledPid : enabledSpecies) {
+      isEnabledSpecies[enabledPid] = true;
+    }
+    flatProbability = 1.f / enabledSpecies.size();
+
+    // Reading the priors
+    priorEdges = priorsBinsPt.value;
+    if (priorEdges.size() < 2 || priors.value.rows() != priorEdges.size() - 1 || priors.value.cols() != PID::NIDs) {
+      LOG(fatal) << "Priors of size " << priors.value.rows() << " x " << priors.value.cols() << " given for " << priorEdges.size() << " pT edges, " << (priorEdges.size() - 1) << " x " << static_cast<int>(PID::NIDs) << " expected";
+    }
+    priorTable.resize(priors.value.rows());
+    for (uint32_t iPt = 0; iPt < priors.value.rows(); iPt++) {
+      for (int j = 0; j < PID::NIDs; j++) {
+        priorTable[iPt][j] = priors.value.get(iPt, j);
+      }
+    }
     // Getting the parametrization parameters
     ccdb->setURL(url.value);
     ccdb->setTimestamp(timestamp.value);
@@ -250,40 +253,29 @@ struct bayesPid {
     }
   }
 
-  /// Computes PID probabilities for the TPC
-  template <o2::track::PID::ID pid>
+  /// Computes PID probabilities for the TPC for all the enabled species
   void ComputeTPCProbability(const Coll::iterator& collision, const Trks::iterator& track)
   {
-
-    if (!checkEnabled<kTPC, pid>()) {
+    if (!enabledDet[kTPC]) {
       return;
     }
 
     const float dedx = track.tpcSignal();
-    bool mismatch = true;
-
     // if (fTuneMConData && ((fTuneMConDataMask & kDetTPC) == kDetTPC)){
     //   dedx = GetTPCsignalTunedOnData(track);
     // }
-    const float bethe = responseTPC.GetExpectedSignal(track, pid);
-    const float sigma = responseTPC.GetExpectedSigma(collision, track, pid);
-    // LOG(info) << "For " << pid_constants::sNames[pid] << " computing bethe " << bethe << " and sigma " << sigma;
-    //  bethe = fTPCResponse.GetExpectedSignal(track, type, AliTPCPIDResponse::kdEdxDefault, fUseTPCEtaCorrection, fUseTPCMultiplicityCorrection, fUseTPCPileupCorrection);
-    //  sigma = fTPCResponse.GetExpectedSigma(track, type, AliTPCPIDResponse::kdEdxDefault, fUseTPCEtaCorrection, fUseTPCMultiplicityCorrection, fUseTPCPileupCorrection);
-
-    if (abs(dedx - bethe) > fRange * sigma) {
-      // Probability[kTPC][pid] = exp(-0.5 * fRange * fRange) / sigma; // BUG fix
-      Probability[kTPC][pid] = exp(-0.5 * fRange * fRange);
-    } else {
-      // Probability[kTPC][pid] = exp(-0.5 * (dedx - bethe) * (dedx - bethe) / (sigma * sigma)) / sigma; //BUG fix
-      Probability[kTPC][pid] = exp(-0.5 * (dedx - bethe) * (dedx - bethe) / (sigma * sigma));
-      mismatch = false;
-    }
-    if (Probability[kTPC][pid] <= 0.f) {
-      Probability[kTPC][pid] = 0.f;
-    }
-    if (mismatch) {
-      Probability[kTPC][pid] = 1.f / Probability[kTPC].size();
+    for (const auto pid : enabledSpecies) {
+      const float bethe = responseTPC.GetExpectedSignal(track, pid);
+      const float sigma = responseTPC.GetExpectedSigma(collision, track, pid);
+      //  bethe = fTPCResponse.GetExpectedSignal(track, type, AliTPCPIDResponse::kdEdxDefault, fUseTPCEtaCorrection, fUseTPCMultiplicityCorrection, fUseTPCPileupCorrection);
+      //  sigma = fTPCResponse.GetExpectedSigma(track, type, AliTPCPIDResponse::kdEdxDefault, fUseTPCEtaCorrection, fUseTPCMultiplicityCorrection, fUseTPCPileupCorrection);
+
+      if (abs(dedx - bethe) > fRange * sigma) { // Mismatch: flat probability in all the species
+        Probability[kTPC][pid] = 1.f / Probability[kTPC].size();
+      } else {
+        // Probability[kTPC][pid] = exp(-0.5 * (dedx - bethe) * (dedx - bethe) / (sigma * sigma)) / sigma; //BUG fix
+        Probability[kTPC][pid] = exp(-0.5 * (dedx - bethe) * (dedx - bethe) / (sigma * sigma));
+      }
     }
   }
 
@@ -297,16 +289,11 @@ struct bayesPid {
   template <o2::track::PID::ID pid>
   using respTOF = tof::ExpTimes<Trks::iterator, pid>;
 
-  /// Compute PID probabilities for TOF
+  /// Compute PID probabilities for TOF, for a track with a TOF signal
   template <o2::track::PID::ID pid>
   void ComputeTOFProbability(const Trks::iterator& track)
   {
-
-    if (!checkEnabled<kTOF, pid>()) {
-      return;
-    }
-
-    if (!track.hasTOF()) {
+    if (!isEnabledSpecies[pid]) {
       return;
     }
     constexpr respTOF<pid> responseTOFPID;
@@ -359,7 +346,6 @@ struct bayesPid {
 
     const float nsigmas = responseTOFPID.GetSeparation(Response[kTOF], track) + meanCorrFactor;
 
-    const float expTime = responseTOFPID.GetExpectedSignal(track);
     const float sig = responseTOFPID.GetExpectedSigma(Response[kTOF], track);
 
     if (nsigmas < fTOFtail) {
@@ -369,48 +355,41 @@ struct bayesPid {
     }
 
     Probability[kTOF][pid] += fgTOFmismatchProb * mismPropagationFactor[pid];
-    LOG(debug) << "For " << pid_constants::sNames[pid] << " with signal " << track.tofSignal() << " computing exp time " << expTime << " and sigma " << sig << " and nsigma " << nsigmas << " probability " << Probability[kTOF][pid];
+    LOG(debug) << "For " << pid_constants::sNames[pid] << " with signal " << track.tofSignal() << " computing sigma " << sig << " and nsigma " << nsigmas << " probability " << Probability[kTOF][pid];
   }
 
-  /// Calculate probabilities from all enabled detectors and species
-  void MergeProbabilities()
+  /// Compute PID probabilities for TOF for all the enabled species
+  void ComputeTOFProbabilities(const Trks::iterator& track)
   {
-    LOG(debug) << "Merging probabilities";
-
-    float probSum[kNDet + 1] = {0.f}; /// Summed probabilities for all detectors + 1 for the sum of all detectors
-
-    for (const auto enabledPid : enabledSpecies) {
-      Probability[kMerged][enabledPid] = 1.f;
-      for (int det = 0; det < kNDet; det++) {
-        probSum[det] += Probability[det][enabledPid];
-        Probability[kMerged][enabledPid] *= Probability[det][enabledPid];
-      }
-      probSum[kNDet] += Probability[kMerged][enabledPid];
-      LOG(debug) << "For " << PID::getName(enabledPid);
-      for (int det = 0; det < kNDet; det++) {
-        if (enabledDet[det]) {
-          LOG(debug) << "\t" << detectorName[det] << " Probability " << Probability[det][enabledPid];
-        }
-      }
-      LOG(debug) << "\tCombined: " << Probability[kMerged][enabledPid];
+    if (!enabledDet[kTOF]) {
+      return;
     }
-    for (int det = 0; det < kNDet; det++) {
-      if (enabledDet[det]) {
-        LOG(debug) << "\tSum " << detectorName[det] << " Probability " << probSum[det];
+    if (!track.hasTOF()) { // No decision without TOF signal
+      for (const auto enabledPid : enabledSpecies) {
+        Probability[kTOF][enabledPid] = flatProbability;
       }
+      return;
     }
-    LOG(debug) << "\tSum combined: " << probSum[kNDet];
+    ComputeTOFProbability<PID::Electron>(track);
+    ComputeTOFProbability<PID::Muon>(track);
+    ComputeTOFProbability<PID::Pion>(track);
+    ComputeTOFProbability<PID::Kaon>(track);
+    ComputeTOFProbability<PID::Proton>(track);
+    ComputeTOFProbability<PID::Deuteron>(track);
+    ComputeTOFProbability<PID::Triton>(track);
+    ComputeTOFProbability<PID::Helium3>(track);
+    ComputeTOFProbability<PID::Alpha>(track);
   }
 
-  /// Calculate Bayesian probabilities
-  void ComputeBayesProbabilities()
+  /// Calculate the merged probabilities of all enabled detectors and the Bayesian probabilities,
+  /// with the priors of the pT interval of the track
+  void ComputeBayesProbabilities(const float pt)
   {
-    LOG(debug) << "Computing bayes probabilities";
-
+    const auto& prior = priorTable[findPriorBin(pt)];
     float sum = 0.;
     for (const auto enabledPid : enabledSpecies) {
-      LOG(debug) << "Adding " << Probability[kMerged][enabledPid] << " with prior " << Probability[kPrior][enabledPid];
-      sum += Probability[kMerged][enabledPid] * Probability[kPrior][enabledPid];
+      Probability[kMerged][enabledPid] = Probability[kTOF][enabledPid] * Probability[kTPC][enabledPid];
+      sum += Probability[kMerged][enabledPid] * prior[enabledPid];
     }
     if (sum <= 0) {
       LOG(warning) << "Invalid probability densities or prior probabilities";
@@ -420,11 +399,10 @@ struct bayesPid {
       return;
     }
     for (const auto enabledPid : enabledSpecies) {
-      Probability[kBayesian][enabledPid] = Probability[kMerged][enabledPid] * Probability[kPrior][enabledPid] / sum;
+      Probability[kBayesian][enabledPid] = Probability[kMerged][enabledPid] * prior[enabledPid] / sum;
       // if (probDensityMism) {
-      //   probDensityMism[enabledPid] *= Probability[kPrior][enabledPid] / sum;
+      //   probDensityMism[enabledPid] *= prior[enabledPid] / sum;
       // }
-      LOG(debug) << "For " << PID::getName(enabledPid) << " merged prob. " << Probability[kMerged][enabledPid] << " prior " << Probability[kPrior][enabledPid] << " sum " << sum << " bayesian Probability: " << Probability[kBayesian][enabledPid];
     }
   }
 
@@ -453,29 +431,9 @@ struct bayesPid {
     for (auto const& trk : tracks) { // Loop on Tracks
 
       auto collision = collisions.iteratorAt(trk.collisionId());
-      ComputeTPCProbability<PID::Electron>(collision, trk);
-      ComputeTPCProbability<PID::Muon>(collision, trk);
-      ComputeTPCProbability<PID::Pion>(collision, trk);
-      ComputeTPCProbability<PID::Kaon>(collision, trk);
-      ComputeTPCProbability<PID::Proton>(collision, trk);
-      ComputeTPCProbability<PID::Deuteron>(collision, trk);
-      ComputeTPCProbability<PID::Triton>(collision, trk);
-      ComputeTPCProbability<PID::Helium3>(collision, trk);
-      ComputeTPCProbability<PID::Alpha>(collision, trk);
-
-      ComputeTOFProbability<PID::Electron>(trk);
-      ComputeTOFProbability<PID::Muon>(trk);
-      ComputeTOFProbability<PID::Pion>(trk);
-      ComputeTOFProbability<PID::Kaon>(trk);
-      ComputeTOFProbability<PID::Proton>(trk);
-      ComputeTOFProbability<PID::Deuteron>(trk);
-      ComputeTOFProbability<PID::Triton>(trk);
-      ComputeTOFProbability<PID::Helium3>(trk);
-      ComputeTOFProbability<PID::Alpha>(trk);
-
-      MergeProbabilities();
-
-      ComputeBayesProbabilities();
+      ComputeTPCProbability(collision, trk);
+      ComputeTOFProbabilities(trk);
+      ComputeBayesProbabilities(trk.pt());
 
       if (pidEl == 1) {
         tablePIDEl(Probability[kBayesian][PID::Electron] * 100.f);
@@ -0,0 +1,173 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   pidDecisions.cxx
+/// \brief  Task producing the PID selection decisions of the tracks, see Common/DataModel/PIDDecisions.h
+///         The nsigma of the tracks are read once per dataframe into arrays, each selection of the list is then
+///         applied with a loop over the arrays and sets its bit in the mask of the tracks.
+///
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/HistogramRegistry.h"
+#include "Framework/runDataProcessing.h"
+#include "ReconstructionDataFormats/PID.h"
+#include "Common/DataModel/PIDDecisions.h"
+#include "Common/DataModel/PIDResponse.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+namespace
+{
+static constexpr int nSpecies = 5; // electron, muon, pion, kaon and proton, in the order of o2::track::PID
+static constexpr int nSelectionVars = 8;
+static constexpr int nDefaultSelections = 4;
+static const std::vector<std::string> selectionVarNames{"species", "detector", "ptMin", "ptMax", "nSigmaTPCMin", "nSigmaTPCMax", "nSigmaTOFMin", "nSigmaTOFMax"};
+static const std::vector<std::string> defaultSelectionNames{"PiTPC3", "KaTPCTOF3", "PrTPCTOF3", "ElTPC3TOFIfAvailable3"};
+static constexpr float defaultSelections[nDefaultSelections][nSelectionVars]{
+  {2.f, 0.f, 0.f, 100.f, -3.f, 3.f, -999.f, 999.f},
+  {3.f, 2.f, 0.f, 100.f, -3.f, 3.f, -3.f, 3.f},
+  {4.f, 2.f, 0.f, 100.f, -3.f, 3.f, -3.f, 3.f},
+  {0.f, 3.f, 0.f, 100.f, -3.f, 3.f, -3.f, 3.f}};
+} // namespace
+
+struct PidDecisions {
+  using Trks = soa::Join<aod::Tracks, aod::TracksExtra,
+                         aod::pidTPCFullEl, aod::pidTPCFullMu, aod::pidTPCFullPi, aod::pidTPCFullKa, aod::pidTPCFullPr,
+                         aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi, aod::pidTOFFullKa, aod::pidTOFFullPr>;
+
+  Produces<aod::PIDDecisions> pidDecisions;
+
+  Configurable<LabeledArray<float>> cfgSelections{"cfgSelections",
+                                                  {defaultSelections[0], nDefaultSelections, nSelectionVars, defaultSelectionNames, selectionVarNames},
+                                                  "PID selections, one per row and bit of the mask. species: index in o2::track::PID (0 el, 1 mu, 2 pi, 3 ka, 4 pr), detector: 0 TPC, 1 TOF, 2 TPC and TOF, 3 TPC and TOF if the track has TOF"};
+
+  HistogramRegistry registry{"registry", {}, OutputObjHandlingPolicy::AnalysisObject};
+
+  enum Detector {
+    kTPC = 0,
+    kTOF,
+    kTPCAndTOF,
+    kTPCAndTOFIfAvailable,
+    kNDetectors
+  };
+
+  struct Selection {
+    int species = 0;
+    int detector = kTPC;
+    float ptMin = 0.f, ptMax = 0.f;
+    float nSigmaTPCMin = 0.f, nSigmaTPCMax = 0.f;
+    float nSigmaTOFMin = 0.f, nSigmaTOFMax = 0.f;
+  };
+  std::vector<Selection> selections;
+
+  // columns of the tracks of the dataframe
+  std::vector<float> pt;
+  std::vector<uint8_t> hasTOF;
+  std::array<std::vector<float>, nSpecies> nSigmaTPC, nSigmaTOF;
+  std::vector<uint32_t> masks;
+
+  void init(InitContext&)
+  {
+    auto const& cuts = cfgSelections.value;
+    if (cuts.cols() != nSelectionVars) {
+      LOGF(fatal, "PID selections with %d variables given, %d expected", cuts.cols(), nSelectionVars);
+    }
+    if (cuts.rows() > 32) {
+      LOGF(fatal, "%d PID selections given, at most 32 supported", cuts.rows());
+    }
+    for (uint32_t iSel = 0; iSel < cuts.rows(); iSel++) {
+      Selection sel{static_cast<int>(cuts.get(iSel, 0u)), static_cast<int>(cuts.get(iSel, 1u)),
+                    cuts.get(iSel, 2u), cuts.get(iSel, 3u), cuts.get(iSel, 4u), cuts.get(iSel, 5u), cuts.get(iSel, 6u), cuts.get(iSel, 7u)};
+      if (sel.species < 0 || sel.species >= nSpecies) {
+        LOGF(fatal, "Invalid species %d of the PID selection %s", sel.species, cuts.getLabelsRows()[iSel]);
+      }
+      if (sel.detector < 0 || sel.detector >= kNDetectors) {
+        LOGF(fatal, "Invalid detector %d of the PID selection %s", sel.detector, cuts.getLabelsRows()[iSel]);
+      }
+      LOGF(info, "PID selection %s is bit %d of the mask", cuts.getLabelsRows()[iSel], iSel);
+      selections.push_back(sel);
+    }
+
+    const int nSelections = selections.size();
+    registry.add("hSelected", "Tracks passing the PID selections", {HistType::kTH1F, {{nSelections + 1, -1.5f, nSelections - 0.5f, "PID selection"}}});
+    registry.get<TH1>(HIST("hSelected"))->GetXaxis()->SetBinLabel(1, "All tracks");
+    for (int iSel = 0; iSel < nSelections; iSel++) {
+      registry.get<TH1>(HIST("hSelected"))->GetXaxis()->SetBinLabel(iSel + 2, cuts.getLabelsRows()[iSel].c_str());
+    }
+  }
+
+  void process(Trks const& tracks)
+  {
+    const std::size_t n = tracks.size();
+    pt.resize(n);
+    hasTOF.resize(n);
+    for (int iSpecies = 0; iSpecies < nSpecies; iSpecies++) {
+      nSigmaTPC[iSpecies].resize(n);
+      nSigmaTOF[iSpecies].resize(n);
+    }
+    std::size_t i = 0;
+    for (auto const& track : tracks) {
+      pt[i] = track.pt();
+      hasTOF[i] = track.hasTOF();
+      nSigmaTPC[o2::track::PID::Electron][i] = track.tpcNSigmaEl();
+      nSigmaTPC[o2::track::PID::Muon][i] = track.tpcNSigmaMu();
+      nSigmaTPC[o2::track::PID::Pion][i] = track.tpcNSigmaPi();
+      nSigmaTPC[o2::track::PID::Kaon][i] = track.tpcNSigmaKa();
+      nSigmaTPC[o2::track::PID::Proton][i] = track.tpcNSigmaPr();
+      nSigmaTOF[o2::track::PID::Electron][i] = track.tofNSigmaEl();
+      nSigmaTOF[o2::track::PID::Muon][i] = track.tofNSigmaMu();
+      nSigmaTOF[o2::track::PID::Pion][i] = track.tofNSigmaPi();
+      nSigmaTOF[o2::track::PID::Kaon][i] = track.tofNSigmaKa();
+      nSigmaTOF[o2::track::PID::Proton][i] = track.tofNSigmaPr();
+      i++;
+    }
+
+    masks.assign(n, 0u);
+    uint32_t* mask = masks.data();
+    registry.fill(HIST("hSelected"), -1, n);
+    for (std::size_t iSel = 0; iSel < selections.size(); iSel++) {
+      auto const& sel = selections[iSel];
+      const float* tpc = nSigmaTPC[sel.species].data();
+      const float* tof = nSigmaTOF[sel.species].data();
+      const bool useTPC = sel.detector != kTOF;
+      const bool useTOF = sel.detector != kTPC;
+      const bool tofIfAvailable = sel.detector == kTPCAndTOFIfAvailable;
+      int nSelected = 0;
+      for (std::size_t j = 0; j < n; j++) {
+        const bool passPt = sel.ptMin <= pt[j] && pt[j] <= sel.ptMax;
+        const bool passTPC = !useTPC || (sel.nSigmaTPCMin <= tpc[j] && tpc[j] <= sel.nSigmaTPCMax);
+        const bool passTOF = !useTOF || (hasTOF[j] ? (sel.nSigmaTOFMin <= tof[j] && tof[j] <= sel.nSigmaTOFMax) : tofIfAvailable);
+        const bool pass = passPt && passTPC && passTOF;
+        mask[j] |= static_cast<uint32_t>(pass) << iSel;
+        nSelected += pass;
+      }
+      registry.fill(HIST("hSelected"), iSel, nSelected);
+    }
+
+    pidDecisions.reserve(n);
+    for (std::size_t j = 0; j < n; j++) {
+      pidDecisions(mask[j]);
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<PidDecisions>(cfgc)};
+}
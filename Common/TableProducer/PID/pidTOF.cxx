@@ -154,6 +154,7 @@ struct tofPid {
     reserveTable(pidHe, tablePIDHe);
     reserveTable(pidAl, tablePIDAl);
 
+    o2::pid::tof::ExpTimesTrackCache trackCache;
     int lastCollisionId = -1;          // Last collision ID analysed
     for (auto const& track : tracks) { // Loop on all tracks
       if (!track.has_collision()) {    // Track was not assigned, cannot compute NSigma (no event time) -> filling with empty table
@@ -192,12 +193,13 @@ struct tofPid {
 
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
       for (auto const& trkInColl : tracksInCollision) { // Loop on tracks
+        trackCache.Set(mRespParams, trkInColl); // Per-track quantities shared by all mass hypotheses
         // Check and fill enabled tables
-        auto makeTable = [&trkInColl, this](const Configurable<int>& flag, auto& table, const auto& responsePID) {
+        auto makeTable = [&trackCache](const Configurable<int>& flag, auto& table, const auto& responsePID) {
           if (flag.value != 1) {
             return;
           }
-          aod::pidutils::packInTable<aod::pidtof_tiny::binning>(responsePID.GetSeparation(mRespParams, trkInColl),
+          aod::pidutils::packInTable<aod::pidtof_tiny::binning>(responsePID.GetSeparation(trackCache),
                                                                 table);
         };
 
@@ -244,6 +246,7 @@ struct tofPid {
     reserveTable(pidHe, tablePIDHe);
     reserveTable(pidAl, tablePIDAl);
 
+    o2::pid::tof::ExpTimesTrackCache trackCache;
     int lastCollisionId = -1;          // Last collision ID analysed
     for (auto const& track : tracks) { // Loop on all tracks
       if (!track.has_collision()) {    // Track was not assigned, cannot compute NSigma (no event time) -> filling with empty table
@@ -275,12 +278,13 @@ struct tofPid {
         mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
       }
 
+      trackCache.Set(mRespParams, track); // Per-track quantities shared by all mass hypotheses
       // Check and fill enabled tables
-      auto makeTable = [&track, this](const Configurable<int>& flag, auto& table, const auto& responsePID) {
+      auto makeTable = [&trackCache](const Configurable<int>& flag, auto& table, const auto& responsePID) {
         if (flag.value != 1) {
           return;
         }
-        aod::pidutils::packInTable<aod::pidtof_tiny::binning>(responsePID.GetSeparation(mRespParams, track),
+        aod::pidutils::packInTable<aod::pidtof_tiny::binning>(responsePID.GetSeparation(trackCache),
                                                               table);
       };
 
@@ -15,6 +15,7 @@
 /// \brief  Base to build tasks for TOF PID tasks.
 ///
 
+#include <optional>
 #include <utility>
 #include <vector>
 #include <string>
@@ -30,6 +31,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/FT0Corrected.h"
 #include "DPG/Tasks/AOTTrack/PID/qaPIDTOF.h"
+#include "Common/Core/PID/TOFEvTimeMaker.h"
 #include "TableHelper.h"
 #include "pidTOFBase.h"
 
@@ -117,6 +119,14 @@ struct tofEventTime {
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
   Configurable<std::string> ccdbPath{"ccdbPath", "Analysis/PID/TOF", "Path of the TOF parametrization on the CCDB"};
   Configurable<int64_t> timestamp{"ccdb-timestamp", -1, "timestamp of the object"};
+  Configurable<bool> useFastEvTimeMaker{"useFastEvTimeMaker", false, "Compute the TOF event time with the branch-and-bound search of the O2Physics event time maker instead of the O2 one"};
+  Configurable<int> fastEvTimeMaxGroupSize{"fastEvTimeMaxGroupSize", 10, "Maximum number of tracks of the sample searched together in the O2Physics event time maker"};
+  Configurable<int> nThreads{"nThreads", 1, "Number of threads computing the event time of the collisions in the O2Physics event time maker"};
+
+  // O2Physics event time maker, with the position of every track in it
+  o2::pid::tof::EvTimeMaker fastEvTimeMaker;
+  std::vector<int> fastEvTimeCollision; // index of the collision of the track in the event time maker, by track global index
+  std::vector<int> fastEvTimeSample;    // index of the track in the sample of its collision, -1 if not in the sample
 
   void init(o2::framework::InitContext& initContext)
   {
@@ -176,6 +186,8 @@ struct tofEventTime {
       LOG(info) << "Loading exp. sigma parametrization from CCDB, using path: " << path << " for timestamp " << timestamp.value;
       response.LoadParam(DetectorResponse::kSigma, ccdb->getForTimeStamp<Parametrization>(path, timestamp.value));
     }
+    fastEvTimeMaker.setDiamondError(diamond * 33.356409f);
+    fastEvTimeMaker.setMaxGroupSize(fastEvTimeMaxGroupSize);
   }
 
   ///
@@ -209,6 +221,47 @@ struct tofEventTime {
   Preslice<TrksEvTime> perCollision = aod::track::collisionId;
   template <o2::track::PID::ID pid>
   using ResponseImplementationEvTime = o2::pid::tof::ExpTimes<TrksEvTime::iterator, pid>;
+
+  /// Computes the TOF event time of all the collisions with the O2Physics event time maker
+  /// The sample tracks of every collision are collected with their expected times, then the collisions are computed in parallel
+  template <typename TrackType>
+  void computeFastEvTime(TrackType const& tracks)
+  {
+    fastEvTimeMaker.clear();
+    fastEvTimeCollision.assign(tracks.size(), -1);
+    fastEvTimeSample.assign(tracks.size(), -1);
+    int lastCollisionId = -1;
+    int collision = -1;
+    for (auto const& trk : tracks) {
+      if (!trk.has_collision()) {
+        continue;
+      }
+      if (trk.collisionId() != lastCollisionId) {
+        lastCollisionId = trk.collisionId();
+        collision = fastEvTimeMaker.newCollision();
+      }
+      fastEvTimeCollision[trk.globalIndex()] = collision;
+      if (!filterForTOFEventTime(trk)) {
+        continue;
+      }
+      const float tofSignal = trk.tofSignal();
+      fastEvTimeSample[trk.globalIndex()] = fastEvTimeMaker.addTrack(tofSignal,
+                                                                    {ResponseImplementationEvTime<PID::Pion>::GetExpectedSignal(trk),
+                                                                     ResponseImplementationEvTime<PID::Kaon>::GetExpectedSignal(trk),
+                                                                     ResponseImplementationEvTime<PID::Proton>::GetExpectedSignal(trk)},
+                                                                    {ResponseImplementationEvTime<PID::Pion>::GetExpectedSigma(response, trk, tofSignal, 0.f),
+                                                                     ResponseImplementationEvTime<PID::Kaon>::GetExpectedSigma(response, trk, tofSignal, 0.f),
+                                                                     ResponseImplementationEvTime<PID::Proton>::GetExpectedSigma(response, trk, tofSignal, 0.f)});
+    }
+    fastEvTimeMaker.compute(nThreads);
+  }
+
+  /// TOF event time of the collision of a track from the O2Physics event time maker, without the bias of the track
+  o2::pid::tof::EvTimeMaker::EvTime getFastEvTime(int64_t globalIndex) const
+  {
+    const int sample = removeTOFEvTimeBias ? fastEvTimeSample[globalIndex] : -1;
+    return fastEvTimeMaker.getEventTime(fastEvTimeCollision[globalIndex], sample, sample >= 0 ? 2 : 1);
+  }
   void processNoFT0(TrksEvTime const& tracks,
                     aod::Collisions const&)
   {
@@ -221,6 +274,9 @@ struct tofEventTime {
     if (enableTableTOFOnly) {
       tableEvTimeTOFOnly.reserve(tracks.size());
     }
+    if (useFastEvTimeMaker) {
+      computeFastEvTime(tracks);
+    }
 
     int lastCollisionId = -1;      // Last collision ID analysed
     for (auto const& t : tracks) { // Loop on collisions
@@ -240,6 +296,19 @@ struct tofEventTime {
 
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
 
+      if (useFastEvTimeMaker) {
+        const float errDiamond = diamond * 33.356409f;
+        for (auto const& trk : tracksInCollision) { // Loop on Tracks
+          const auto evTime = getFastEvTime(trk.globalIndex());
+          tableFlags(evTime.eventTimeError < errDiamond ? o2::aod::pidflags::enums::PIDFlags::EvTimeTOF : 0);
+          tableEvTime(evTime.eventTime, evTime.eventTimeError);
+          if (enableTableTOFOnly) {
+            tableEvTimeTOFOnly((uint8_t)filterForTOFEventTime(trk), evTime.eventTime, evTime.eventTimeError, evTime.multiplicity);
+          }
+        }
+        continue;
+      }
+
       // First make table for event time
       const auto evTimeTOF = evTimeMakerForTracks<TrksEvTime::iterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, response, diamond);
       int nGoodTracksForTOF = 0;
@@ -284,6 +353,9 @@ struct tofEventTime {
     if (enableTableTOFOnly) {
       tableEvTimeTOFOnly.reserve(tracks.size());
     }
+    if (useFastEvTimeMaker) {
+      computeFastEvTime(tracks);
+    }
 
     int lastCollisionId = -1;      // Last collision ID analysed
     for (auto const& t : tracks) { // Loop on collisions
@@ -304,11 +376,17 @@ struct tofEventTime {
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
       const auto& collision = t.collision_as<EvTimeCollisions>();
 
-      // Compute the TOF event time
-      const auto evTimeTOF = evTimeMakerForTracks<TrksEvTime::iterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, response, diamond);
-
-      float t0AC[2] = {.0f, 999.f};                                       // Value and error of T0A or T0C or T0AC
-      float t0TOF[2] = {evTimeTOF.mEventTime, evTimeTOF.mEventTimeError}; // Value and error of TOF
+      // Compute the TOF event time, with the O2 event time maker unless the O2Physics one is used
+      std::optional<o2::tof::eventTimeContainer> evTimeTOF;
+      float t0AC[2] = {.0f, 999.f};  // Value and error of T0A or T0C or T0AC
+      float t0TOF[2] = {.0f, 999.f}; // Value and error of TOF
+      int multiplicityTOF = 0;
+      if (!useFastEvTimeMaker) {
+        evTimeTOF.emplace(evTimeMakerForTracks<TrksEvTime::iterator, filterForTOFEventTime, o2::pid::tof::ExpTimes>(tracksInCollision, response, diamond));
+        t0TOF[0] = evTimeTOF->mEventTime;
+        t0TOF[1] = evTimeTOF->mEventTimeError;
+        multiplicityTOF = evTimeTOF->mEventTimeMultiplicity;
+      }
 
       uint8_t flags = 0;
       int nGoodTracksForTOF = 0;
@@ -326,8 +404,13 @@ struct tofEventTime {
         sumOfWeights = 0.f;
         weight = 0.f;
         // Remove the bias on TOF ev. time
-        if constexpr (removeTOFEvTimeBias) {
-          evTimeTOF.removeBias<TrksEvTime::iterator, filterForTOFEventTime>(trk, nGoodTracksForTOF, t0TOF[0], t0TOF[1], 2);
+        if (useFastEvTimeMaker) {
+          const auto evTime = getFastEvTime(trk.globalIndex());
+          t0TOF[0] = evTime.eventTime;
+          t0TOF[1] = evTime.eventTimeError;
+          multiplicityTOF = evTime.multiplicity;
+        } else if constexpr (removeTOFEvTimeBias) {
+          evTimeTOF->removeBias<TrksEvTime::iterator, filterForTOFEventTime>(trk, nGoodTracksForTOF, t0TOF[0], t0TOF[1], 2);
         }
         if (t0TOF[1] < errDiamond) {
           flags |= o2::aod::pidflags::enums::PIDFlags::EvTimeTOF;
@@ -359,7 +442,7 @@ struct tofEventTime {
         }
         tableEvTime(eventTime / sumOfWeights, sqrt(1. / sumOfWeights));
         if (enableTableTOFOnly) {
-          tableEvTimeTOFOnly((uint8_t)filterForTOFEventTime(trk), t0TOF[0], t0TOF[1], evTimeTOF.mEventTimeMultiplicity);
+          tableEvTimeTOFOnly((uint8_t)filterForTOFEventTime(trk), t0TOF[0], t0TOF[1], multiplicityTOF);
         }
       }
     }
@@ -157,6 +157,7 @@ struct tofPidFull {
     reserveTable(pidHe, tablePIDHe);
     reserveTable(pidAl, tablePIDAl);
 
+    o2::pid::tof::ExpTimesTrackCache trackCache;
     int lastCollisionId = -1;          // Last collision ID analysed
     for (auto const& track : tracks) { // Loop on all tracks
       if (!track.has_collision()) {    // Track was not assigned, cannot compute NSigma (no event time) -> filling with empty table
@@ -194,13 +195,14 @@ struct tofPidFull {
 
       const auto& tracksInCollision = tracks.sliceBy(perCollision, lastCollisionId);
       for (auto const& trkInColl : tracksInCollision) { // Loop on tracks
+        trackCache.Set(mRespParams, trkInColl); // Per-track quantities shared by all mass hypotheses
         // Check and fill enabled tables
-        auto makeTable = [&trkInColl, this](const Configurable<int>& flag, auto& table, const auto& responsePID) {
+        auto makeTable = [&trackCache](const Configurable<int>& flag, auto& table, const auto& responsePID) {
           if (flag.value != 1) {
             return;
           }
-          table(responsePID.GetExpectedSigma(mRespParams, trkInColl),
-                responsePID.GetSeparation(mRespParams, trkInColl));
+          table(responsePID.GetExpectedSigma(trackCache),
+                responsePID.GetSeparation(trackCache));
         };
 
         makeTable(pidEl, tablePIDEl, responseEl);
@@ -246,6 +248,7 @@ struct tofPidFull {
     reserveTable(pidHe, tablePIDHe);
     reserveTable(pidAl, tablePIDAl);
 
+    o2::pid::tof::ExpTimesTrackCache trackCache;
     int lastCollisionId = -1;          // Last collision ID analysed
     for (auto const& track : tracks) { // Loop on all tracks
       if (!track.has_collision()) {    // Track was not assigned, cannot compute NSigma (no event time) -> filling with empty table
@@ -276,13 +279,14 @@ struct tofPidFull {
         mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
       }
 
+      trackCache.Set(mRespParams, track); // Per-track quantities shared by all mass hypotheses
       // Check and fill enabled tables
-      auto makeTable = [&track, this](const Configurable<int>& flag, auto& table, const auto& responsePID) {
+      auto makeTable = [&trackCache](const Configurable<int>& flag, auto& table, const auto& responsePID) {
         if (flag.value != 1) {
           return;
         }
-        table(responsePID.GetExpectedSigma(mRespParams, track),
-              responsePID.GetSeparation(mRespParams, track));
+        table(responsePID.GetExpectedSigma(trackCache),
+              responsePID.GetSeparation(trackCache));
       };
 
       makeTable(pidEl, tablePIDEl, responseEl);
@@ -327,6 +331,7 @@ struct tofPidFull {
 
 #undef doReserveTable
 
+    o2::pid::tof::ExpTimesTrackCache trackCache;
     int lastCollisionId = -1;          // Last collision ID analysed
     for (auto const& track : tracks) { // Loop on all tracks
       if (!track.has_collision()) {    // Track was not assigned, cannot compute NSigma (no event time) -> filling with empty table
@@ -359,11 +364,13 @@ struct tofPidFull {
         mRespParams.SetParameters(ccdb->getForTimeStamp<o2::pid::tof::TOFResoParams>(parametrizationPath, timestamp));
       }
 
+      trackCache.Set(mRespParams, track); // Per-track quantities shared by all mass hypotheses
+
 // Check and fill enabled tables
-#define doFillTable(Particle)                                                   \
-  if (pid##Particle.value == 1) {                                               \
-    tablePID##Particle(response##Particle.GetExpectedSigma(mRespParams, track), \
-                       response##Particle.GetSeparation(mRespParams, track));   \
+#define doFillTable(Particle)                                           \
+  if (pid##Particle.value == 1) {                                       \
+    tablePID##Particle(response##Particle.GetExpectedSigma(trackCache), \
+                       response##Particle.GetSeparation(trackCache));   \
   }
 
       doFillTable(El);
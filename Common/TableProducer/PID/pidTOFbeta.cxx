@@ -68,11 +68,14 @@ struct tofPidBeta {
     for (auto const& trk : tracks) {
       beta = responseBeta.GetBeta(trk);
       if (enableTableBeta) {
+        // Quantities shared by the columns are computed once, the separation is the one of responseBeta.GetSeparation
+        const float expSigma = responseBeta.GetExpectedSigma(trk);
+        const float expBetaEl = responseBeta.GetExpectedSignal<o2::track::PID::Electron>(trk);
         tablePIDBeta(beta,
-                     responseBeta.GetExpectedSigma(trk),
-                     responseBeta.GetExpectedSignal<o2::track::PID::Electron>(trk),
-                     responseBeta.GetExpectedSigma(trk),
-                     responseBeta.GetSeparation<o2::track::PID::Electron>(trk));
+                     expSigma,
+                     expBetaEl,
+                     expSigma,
+                     (beta - expBetaEl) / expSigma);
       }
       if (enableTableMass) {
         tablePIDTOFMass(o2::pid::tof::TOFMass<Trks::iterator>::GetTOFMass(trk, beta));
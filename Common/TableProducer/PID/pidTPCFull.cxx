@@ -86,6 +86,7 @@ struct tpcPidFull {
   Configurable<bool> enableNetworkOptimizations{"enableNetworkOptimizations", 1, "(bool) If the neural network correction is used, this enables GraphOptimizationLevel::ORT_ENABLE_EXTENDED in the ONNX session"};
   Configurable<std::string> networkPathCCDB{"networkPathCCDB", "Analysis/PID/TPC/ML", "Path on CCDB"};
   Configurable<int> networkSetNumThreads{"networkSetNumThreads", 0, "Especially important for running on a SLURM cluster. Sets the number of threads used for execution."};
+  Configurable<int> networkBatchSize{"networkBatchSize", 4096, "Number of tracks evaluated by the network in one inference call (0: all tracks of the dataframe at once)"};
   // Configuration flags to include and exclude particle hypotheses
   Configurable<int> pidEl{"pid-el", -1, {"Produce PID information for the Electron mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidMu{"pid-mu", -1, {"Produce PID information for the Muon mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
@@ -96,6 +97,7 @@ struct tpcPidFull {
   Configurable<int> pidTr{"pid-tr", -1, {"Produce PID information for the Triton mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidHe{"pid-he", -1, {"Produce PID information for the Helium3 mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
   Configurable<int> pidAl{"pid-al", -1, {"Produce PID information for the Alpha mass hypothesis, overrides the automatic setup: the corresponding table can be set off (0) or on (1)"}};
+  Configurable<bool> useBatchedResponse{"useBatchedResponse", true, "Evaluate the response column-wise for all the tracks sharing the same parametrization (ignored when the network correction is used)"};
 
   // Thread configuration
   int activeThreads = networkSetNumThreads.value;
@@ -103,6 +105,14 @@ struct tpcPidFull {
   // Paramatrization configuration
   bool useCCDBParam = false;
 
+  // Input buffer of the network, reused across dataframes
+  std::vector<float> network_input;
+
+  // Buffers of the batched evaluation
+  o2::pid::tpc::Response::TrackBatch trackBatch;
+  std::vector<float> nSigmaBatch;
+  std::vector<float> expSigmaBatch;
+
   void init(o2::framework::InitContext& initContext)
   {
     // Checking the tables are requested in the workflow and enabling them
@@ -188,6 +198,7 @@ struct tpcPidFull {
                              enableNetworkOptimizations.value,
                              activeThreads);
             network = temp_net;
+            network.setBatchSize(networkBatchSize);
             network.evalNetwork(std::vector<float>(network.getInputDimensions(), 1.)); // This is an initialisation and might reduce the overhead of the model
           } else {
             LOG(fatal) << "Error encountered while fetching/loading the network from CCDB! Maybe the network doesn't exist yet for this runnumber/timestamp?";
@@ -202,6 +213,7 @@ struct tpcPidFull {
                            enableNetworkOptimizations.value,
                            activeThreads);
           network = temp_net;
+          network.setBatchSize(networkBatchSize);
           network.evalNetwork(std::vector<float>(network.getInputDimensions(), 1.)); // This is an initialisation and might reduce the overhead of the model
         }
       } else {
@@ -233,6 +245,58 @@ struct tpcPidFull {
     reserveTable(pidHe, tablePIDHe);
     reserveTable(pidAl, tablePIDAl);
 
+    if (useBatchedResponse && !useNetworkCorrection) {
+      // Tracks are collected column-wise and evaluated in one go for each enabled mass hypothesis.
+      // The batch is closed whenever the parametrization changes, each table is filled in the track order.
+      auto flushBatch = [&]() {
+        nSigmaBatch.resize(trackBatch.size());
+        expSigmaBatch.resize(trackBatch.size());
+        auto fillTable = [&](const Configurable<int>& flag, auto& table, const o2::track::PID::ID pid) {
+          if (flag.value != 1) {
+            return;
+          }
+          response.GetNumberOfSigma(trackBatch, pid, nSigmaBatch.data(), expSigmaBatch.data());
+          for (std::size_t i = 0; i < trackBatch.size(); i++) {
+            table(expSigmaBatch[i], nSigmaBatch[i]);
+          }
+        };
+        fillTable(pidEl, tablePIDEl, o2::track::PID::Electron);
+        fillTable(pidMu, tablePIDMu, o2::track::PID::Muon);
+        fillTable(pidPi, tablePIDPi, o2::track::PID::Pion);
+        fillTable(pidKa, tablePIDKa, o2::track::PID::Kaon);
+        fillTable(pidPr, tablePIDPr, o2::track::PID::Proton);
+        fillTable(pidDe, tablePIDDe, o2::track::PID::Deuteron);
+        fillTable(pidTr, tablePIDTr, o2::track::PID::Triton);
+        fillTable(pidHe, tablePIDHe, o2::track::PID::Helium3);
+        fillTable(pidAl, tablePIDAl, o2::track::PID::Alpha);
+        trackBatch.clear();
+      };
+
+      trackBatch.clear();
+      trackBatch.reserve(tracks_size);
+      const o2::pid::tpc::Response* lastResponse = nullptr;
+      int lastCollisionId = -1;
+      float multTPC = 0.f;
+      for (auto const& trk : tracks) {
+        if (trk.has_collision() && trk.collisionId() != lastCollisionId) {
+          lastCollisionId = trk.collisionId();
+          const auto& collision = collisions.iteratorAt(trk.collisionId());
+          multTPC = collision.multTPC();
+          if (useCCDBParam && ccdbTimestamp.value == 0) { // Updating parametrization only if the initial timestamp is 0
+            const auto* ccdbResponse = ccdb->getForTimeStamp<o2::pid::tpc::Response>(ccdbPath.value, collision.bc_as<aod::BCsWithTimestamps>().timestamp());
+            if (ccdbResponse != lastResponse) {
+              flushBatch();
+              response.SetParameters(ccdbResponse);
+              lastResponse = ccdbResponse;
+            }
+          }
+        }
+        trackBatch.push_back(trk, multTPC);
+      }
+      flushBatch();
+      return;
+    }
+
     std::vector<float> network_prediction;
 
     if (useNetworkCorrection) {
@@ -261,6 +325,7 @@ struct tpcPidFull {
                              enableNetworkOptimizations.value,
                              activeThreads);
             network = temp_net;
+            network.setBatchSize(networkBatchSize);
             network.evalNetwork(std::vector<float>(network.getInputDimensions(), 1.)); // This is an initialisation and might reduce the overhead of the model
           } else {
             LOG(fatal) << "Error encountered while fetching/loading the network from CCDB! Maybe the network doesn't exist yet for this runnumber/timestamp?";
@@ -276,39 +341,32 @@ struct tpcPidFull {
 
       network_prediction = std::vector<float>(prediction_size * 9); // For each mass hypotheses
       const float nNclNormalization = response.GetNClNormalization();
-      float duration_network = 0;
 
-      std::vector<float> track_properties(track_prop_size);
+      // Filling one buffer with the inputs of all the mass hypotheses, only the mass differs between the hypotheses.
+      // The buffer is kept across dataframes and the network evaluates it in batches writing directly into network_prediction
+      network_input.assign(track_prop_size * 9, 0.f);
       uint64_t counter_track_props = 0;
-      int loop_counter = 0;
-
-      // Filling a std::vector<float> to be evaluated by the network
-      // Evaluation on single tracks brings huge overhead: Thus evaluation is done on one large vector
+      for (auto const& trk : tracks) {
+        network_input[counter_track_props] = trk.tpcInnerParam();
+        network_input[counter_track_props + 1] = trk.tgl();
+        network_input[counter_track_props + 2] = trk.signed1Pt();
+        network_input[counter_track_props + 4] = collisions.iteratorAt(trk.collisionId()).multTPC() / 11000.;
+        network_input[counter_track_props + 5] = std::sqrt(nNclNormalization / trk.tpcNClsFound());
+        counter_track_props += input_dimensions;
+      }
       for (int i = 0; i < 9; i++) { // Loop over particle number for which network correction is used
-        for (auto const& trk : tracks) {
-          track_properties[counter_track_props] = trk.tpcInnerParam();
-          track_properties[counter_track_props + 1] = trk.tgl();
-          track_properties[counter_track_props + 2] = trk.signed1Pt();
-          track_properties[counter_track_props + 3] = o2::track::pid_constants::sMasses[i];
-          track_properties[counter_track_props + 4] = collisions.iteratorAt(trk.collisionId()).multTPC() / 11000.;
-          track_properties[counter_track_props + 5] = std::sqrt(nNclNormalization / trk.tpcNClsFound());
-          counter_track_props += input_dimensions;
+        if (i > 0) {
+          std::copy(network_input.begin(), network_input.begin() + track_prop_size, network_input.begin() + track_prop_size * i);
         }
-
-        auto start_network_eval = std::chrono::high_resolution_clock::now();
-        float* output_network = network.evalNetwork(track_properties);
-        auto stop_network_eval = std::chrono::high_resolution_clock::now();
-        duration_network += std::chrono::duration<float, std::ratio<1, 1000000000>>(stop_network_eval - start_network_eval).count();
-        for (uint64_t i = 0; i < prediction_size; i += output_dimensions) {
-          for (int j = 0; j < output_dimensions; j++) {
-            network_prediction[i + j + prediction_size * loop_counter] = output_network[i + j];
-          }
+        for (uint64_t j = track_prop_size * i + 3; j < track_prop_size * (i + 1); j += input_dimensions) {
+          network_input[j] = o2::track::pid_constants::sMasses[i];
         }
-
-        counter_track_props = 0;
-        loop_counter += 1;
       }
-      track_properties.clear();
+
+      auto start_network_eval = std::chrono::high_resolution_clock::now();
+      network.evalNetwork(network_input.data(), tracks_size * 9, network_prediction.data());
+      auto stop_network_eval = std::chrono::high_resolution_clock::now();
+      const float duration_network = std::chrono::duration<float, std::ratio<1, 1000000000>>(stop_network_eval - start_network_eval).count();
 
       auto stop_network_total = std::chrono::high_resolution_clock::now();
       LOG(info) << "Neural Network for the TPC PID response correction: Time per track (eval ONNX): " << duration_network / (tracks_size * 9) << "ns ; Total time (eval ONNX): " << duration_network / 1000000000 << " s";
@@ -20,6 +20,8 @@
 
 // C++ and system includes
 #include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
+#include <algorithm>
+#include <array>
 #include <vector>
 
 // ROOT includes
@@ -161,6 +163,7 @@ Network& Network::operator=(Network& inst)
 
   valid_from = inst.valid_from;
   valid_until = inst.valid_until;
+  mBatchSize = inst.mBatchSize;
 
   LOG(debug) << "Network copied!";
 
@@ -202,9 +205,9 @@ float* Network::evalNetwork(std::vector<Ort::Value> input)
   try {
     LOG(debug) << "Shape of input (tensor): " << printShape(input[0].GetTensorTypeAndShapeInfo().GetShape());
 
-    auto outputTensors = mSession->Run(mInputNames, input, mOutputNames);
-    float* output_values = outputTensors[0].GetTensorMutableData<float>();
-    LOG(debug) << "Shape of output (tensor): " << printShape(outputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
+    mOutputTensors = mSession->Run(mInputNames, input, mOutputNames);
+    float* output_values = mOutputTensors[0].GetTensorMutableData<float>();
+    LOG(debug) << "Shape of output (tensor): " << printShape(mOutputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
 
     // std::vector<float> output_vals(std::begin(output_values), std::end(output_values));
 
@@ -238,9 +241,9 @@ float* Network::evalNetwork(std::vector<float> input)
   try {
 
     LOG(debug) << "Shape of input (vector): " << printShape(input_shape);
-    auto outputTensors = mSession->Run(mInputNames, inputTensors, mOutputNames);
-    LOG(debug) << "Shape of output (tensor): " << printShape(outputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
-    float* output_values = outputTensors[0].GetTensorMutableData<float>();
+    mOutputTensors = mSession->Run(mInputNames, inputTensors, mOutputNames);
+    LOG(debug) << "Shape of output (tensor): " << printShape(mOutputTensors[0].GetTensorTypeAndShapeInfo().GetShape());
+    float* output_values = mOutputTensors[0].GetTensorMutableData<float>();
 
     return output_values;
 
@@ -253,4 +256,42 @@ float* Network::evalNetwork(std::vector<float> input)
 
 } // function Network::evalNetwork(std::vector<float>)
 
+void Network::evalNetwork(const float* input, int64_t nInputs, float* output)
+{
+
+  /*
+ Function: Evaluating the network for nInputs contiguous inputs in batches of mBatchSize inputs
+ - Input:
+   -- input:         const float*   ; nInputs x input_nodes values, not copied;
+   -- nInputs:       int64_t        ; Number of inputs to evaluate;
+   -- output:        float*         ; Preallocated buffer of nInputs x output_nodes values, the network writes directly into it;
+ */
+
+  const int64_t inputDimensions = getInputDimensions();
+  const int64_t outputDimensions = getOutputDimensions();
+  const int64_t batchSize = mBatchSize > 0 ? mBatchSize : nInputs;
+
+  try {
+
+    // Input and output tensors are views on the caller buffers, bound once per batch: no allocation nor copy of the data
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::IoBinding binding{*mSession};
+    for (int64_t first = 0; first < nInputs; first += batchSize) {
+      const int64_t n = std::min(batchSize, nInputs - first);
+      const std::array<int64_t, 2> inputShape{n, inputDimensions};
+      const std::array<int64_t, 2> outputShape{n, outputDimensions};
+      Ort::Value inputTensor = Ort::Value::CreateTensor<float>(memoryInfo, const_cast<float*>(input + first * inputDimensions), n * inputDimensions, inputShape.data(), inputShape.size());
+      Ort::Value outputTensor = Ort::Value::CreateTensor<float>(memoryInfo, output + first * outputDimensions, n * outputDimensions, outputShape.data(), outputShape.size());
+      binding.BindInput(mInputNames[0].c_str(), inputTensor);
+      binding.BindOutput(mOutputNames[0].c_str(), outputTensor);
+      mSession->Run(Ort::RunOptions{nullptr}, binding);
+    }
+
+  } catch (const Ort::Exception& exception) {
+
+    LOG(error) << "Error running model inference: " << exception.what();
+  }
+
+} // function Network::evalNetwork(const float*, int64_t, float*)
+
 } // namespace o2::pid::tpc
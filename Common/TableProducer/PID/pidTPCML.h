@@ -50,6 +50,7 @@ class Network
   std::vector<Ort::Value> createTensor(std::array<float, 6>) const; // create a std::vector<Ort::Value> (= ONNX tensor) for model input
   float* evalNetwork(std::vector<Ort::Value>);                      // evaluate the network on a std::vector<Ort::Value> (= ONNX tensor)
   float* evalNetwork(std::vector<float>);                           // evaluate the network on a std::vector<float>
+  void evalNetwork(const float*, int64_t, float*);                  // evaluate the network on n contiguous inputs in batches, writing into a preallocated output
 
   // Getters & Setters
   int getInputDimensions() const { return mInputShapes[0][1]; }
@@ -58,6 +59,8 @@ class Network
   uint64_t getValidityUntil() const { return valid_until; }
   void setValidityFrom(uint64_t t) { valid_from = t; }
   void setValidityUntil(uint64_t t) { valid_until = t; }
+  int64_t getBatchSize() const { return mBatchSize; }
+  void setBatchSize(int64_t batchSize) { mBatchSize = batchSize; }
 
  private:
   // Range of validity in timestamps
@@ -69,6 +72,12 @@ class Network
   std::shared_ptr<Ort::Experimental::Session> mSession = nullptr;
   Ort::SessionOptions sessionOptions;
 
+  // Number of inputs per inference call of the batched evaluation (all inputs at once if <= 0)
+  int64_t mBatchSize = 4096;
+
+  // Output of the last evaluation, kept alive for the pointer returned by evalNetwork
+  std::vector<Ort::Value> mOutputTensors;
+
   // Input & Output specifications of the loaded network
   std::vector<std::string> mInputNames;
   std::vector<std::vector<int64_t>> mInputShapes;
@@ -9,6 +9,13 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "Framework/ConfigParamSpec.h"
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
@@ -36,23 +43,34 @@ struct caloClusterProducerTask {
   Configurable<std::string> calorimeter{"caloType", "BOTH", "PHOS, EMCAL, BOTH"};
   Configurable<bool> isMC{"isMC", 0, "0 - data, 1 - MC"};
   Configurable<bool> useCoreE{"coreE", 0, "0 - full energy, 1 - core energy"};
+  Configurable<int> nThreads{"nThreads", 1, "Number of threads clusterizing the PHOS trigger records of a dataframe (output order is preserved)"};
 
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
+  // clusterizer and output of one thread, for a contiguous range of trigger records
+  struct PHOSClusterizerWorker {
+    std::unique_ptr<o2::phos::Clusterer> clusterizer;
+    std::vector<o2::phos::CluElement> outputCluElements;
+    std::vector<o2::phos::Cluster> outputClusters;
+    std::vector<o2::phos::TriggerRecord> outputClusterTrigRecs;
+    o2::dataformats::MCTruthContainer<o2::phos::MCLabel> outputTruthCont;
+  };
+
   std::unique_ptr<o2::phos::Geometry> geomPHOS;
-  std::unique_ptr<o2::phos::Clusterer> clusterizerPHOS;
+  std::vector<PHOSClusterizerWorker> phosWorkers;
   std::vector<o2::phos::Cell> phosCells;
   std::vector<o2::phos::TriggerRecord> phosCellTRs;
-  std::vector<o2::phos::CluElement> outputCluElements;
-  std::vector<o2::phos::Cluster> outputPHOSClusters;
-  std::vector<o2::phos::TriggerRecord> outputPHOSClusterTrigRecs;
 
   void init(o2::framework::InitContext&)
   {
     ccdb->setURL(o2::base::NameConf::getCCDBServer());
     if (calorimeter->compare("PHOS") == 0 || calorimeter->compare("BOTH") == 0) {
       geomPHOS = std::make_unique<o2::phos::Geometry>("PHOS");
-      clusterizerPHOS = std::make_unique<o2::phos::Clusterer>();
+      // the clusterizers are created here, the geometry and the clusterizer setup are not thread safe
+      phosWorkers.resize(std::max(1, nThreads.value));
+      for (auto& worker : phosWorkers) {
+        worker.clusterizer = std::make_unique<o2::phos::Clusterer>();
+      }
     }
   }
 
@@ -74,117 +92,90 @@ struct caloClusterProducerTask {
     if (calorimeter->compare("PHOS") == 0 || calorimeter->compare("BOTH") == 0) {
       const int kPHOS = 0;
       // Fill list of cells and cell TrigRecs per TF as an input for clusterizer
-      // clusterize
-      // Fill output table
-
-      // calibration may be updated by CCDB fetcher
-      const o2::phos::BadChannelsMap* badMap = ccdb->get<o2::phos::BadChannelsMap>("PHS/Calib/BadMap");
-      const o2::phos::CalibParams* calibParams = ccdb->get<o2::phos::CalibParams>("PHS/Calib/CalibParams");
-      if (badMap) {
-        clusterizerPHOS->setBadMap(badMap);
-      } else {
-        LOG(fatal) << "Can not get PHOS Bad Map";
-      }
-      if (calibParams) {
-        clusterizerPHOS->setCalibration(calibParams);
-      } else {
-        LOG(fatal) << "Can not get PHOS calibration";
-      }
-
-      phosCells.clear();
-      phosCells.reserve(cells.size());
-      phosCellTRs.clear();
-      phosCellTRs.reserve(bcs.size());
-      outputCluElements.clear();
-      outputPHOSClusters.clear();
-      outputPHOSClusterTrigRecs.clear();
-
-      o2::InteractionRecord ir;
-      for (auto& c : cells) {
-        if (c.caloType() != kPHOS) // PHOS
-          continue;
-        if (phosCellTRs.size() == 0) { // first cell, first TrigRec
-          ir.setFromLong(c.bc().globalBC());
-          phosCellTRs.emplace_back(ir, 0, 0); // BC,first cell, ncells
-        }
-        if (static_cast<uint64_t>(phosCellTRs.back().getBCData().toLong()) != c.bc().globalBC()) { // switch to new BC
-          // switch to another BC: set size and create next TriRec
-          phosCellTRs.back().setNumberOfObjects(phosCells.size() - phosCellTRs.back().getFirstEntry());
-          // Next event/trig rec.
-          ir.setFromLong(c.bc().globalBC());
-          phosCellTRs.emplace_back(ir, phosCells.size(), 0);
-        }
-        phosCells.emplace_back(c.cellNumber(), c.amplitude(), c.time(),
-                               static_cast<o2::phos::ChannelType_t>(c.cellType()));
-        // TODO process MC info
+      // clusterize, each thread takes a contiguous range of trigger records so that
+      // the outputs of the threads concatenated in order follow the order of the BCs
+      const int nTrigRecs = phosCellTRs.size();
+      const int nWorkers = std::max(1, std::min<int>(phosWorkers.size(), nTrigRecs));
+      auto clusterize = [&](int iWorker) {
+        auto& worker = phosWorkers[iWorker];
+        const int firstTR = static_cast<int64_t>(iWorker) * nTrigRecs / nWorkers;
+        const int lastTR = static_cast<int64_t>(iWorker + 1) * nTrigRecs / nWorkers;
+        // the trigger records refer to the cells by their position in the full list
+        gsl::span<const o2::phos::TriggerRecord> trigRecs(phosCellTRs.data() + firstTR, lastTR - firstTR);
+        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> cellTruth;
+        worker.outputTruthCont.clear();
+        worker.clusterizer->processCells(phosCells, trigRecs, isMC ? &cellTruth : nullptr,
+                                         worker.outputClusters, worker.outputCluElements, worker.outputClusterTrigRecs, worker.outputTruthCont);
+      };
+      std::vector<std::thread> threads;
+      threads.reserve(nWorkers - 1);
+      for (int iWorker = 1; iWorker < nWorkers; ++iWorker) {
+        threads.emplace_back(clusterize, iWorker);
       }
-      // Set number of cells in last TrigRec
-      if (phosCellTRs.size() > 0) {
-        phosCellTRs.back().setNumberOfObjects(phosCells.size() - phosCellTRs.back().getFirstEntry());
+      clusterize(0);
+      for (auto& thread : threads) {
+        thread.join();
       }
 
-      // clusterize
-      if (isMC) {
-        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> cellTruth;
-        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> outputTruthCont;
-        clusterizerPHOS->processCells(phosCells, phosCellTRs, &cellTruth,
-                                      outputPHOSClusters, outputCluElements, outputPHOSClusterTrigRecs, outputTruthCont);
-      } else {
-        o2::dataformats::MCTruthContainer<o2::phos::MCLabel> dummyMC;
-        clusterizerPHOS->processCells(phosCells, phosCellTRs, nullptr,
-                                      outputPHOSClusters, outputCluElements, outputPHOSClusterTrigRecs, dummyMC);
+      std::size_t nClusters = 0;
+      for (int iWorker = 0; iWorker < nWorkers; ++iWorker) {
+        nClusters += phosWorkers[iWorker].outputClusters.size();
       }
+      clusters.reserve(nClusters);
 
       // Fill output
-      for (auto& cluTR : outputPHOSClusterTrigRecs) {
-        int firstClusterInEvent = cluTR.getFirstEntry();
-        int lastClusterInEvent = firstClusterInEvent + cluTR.getNumberOfObjects();
-        // find collision corresponding to current BC
-        auto clvtx = colls.begin() + (bcMap[cluTR.getBCData().toLong()]);
-
-        // Extract primary vertex
-        TVector3 vtx = {clvtx.posX(), clvtx.posY(), clvtx.posZ()};
-
-        for (int i = firstClusterInEvent; i < lastClusterInEvent; i++) {
-          o2::phos::Cluster& clu = outputPHOSClusters[i];
-          float e = (useCoreE) ? clu.getCoreEnergy() : clu.getEnergy();
-          if (e == 0) {
-            continue;
+      for (int iWorker = 0; iWorker < nWorkers; ++iWorker) {
+        auto& outputPHOSClusters = phosWorkers[iWorker].outputClusters;
+        for (auto& cluTR : phosWorkers[iWorker].outputClusterTrigRecs) {
+          int firstClusterInEvent = cluTR.getFirstEntry();
+          int lastClusterInEvent = firstClusterInEvent + cluTR.getNumberOfObjects();
+          // find collision corresponding to current BC
+          auto clvtx = colls.begin() + (bcMap[cluTR.getBCData().toLong()]);
+
+          // Extract primary vertex
+          TVector3 vtx = {clvtx.posX(), clvtx.posY(), clvtx.posZ()};
+
+          for (int i = firstClusterInEvent; i < lastClusterInEvent; i++) {
+            o2::phos::Cluster& clu = outputPHOSClusters[i];
+            float e = (useCoreE) ? clu.getCoreEnergy() : clu.getEnergy();
+            if (e == 0) {
+              continue;
+            }
+            float posX, posZ;
+            clu.getLocalPosition(posX, posZ);
+
+            // Correction for the depth of the shower starting point (TDR p 127)
+            const float para = 0.925;
+            const float parb = 6.52;
+            float depth = para * TMath::Log(e) + parb;
+            posX -= posX * depth / 460.;
+            posZ -= (posZ - vtx.Z()) * depth / 460.;
+
+            int mod = clu.module();
+            TVector3 globaPos;
+            geomPHOS->local2Global(mod, posX, posZ, globaPos);
+
+            TVector3 mom = globaPos - vtx;
+            if (mom.Mag() == 0) { // should not happpen
+              continue;
+            }
+
+            e = Nonlinearity(e);
+
+            mom.SetMag(e);
+
+            // Track/CPV match will be done in independent task
+            float trackdist = 999.;
+            int trackindex = -1;
+
+            float lambdaShort = 0., lambdaLong = 0.;
+            clu.getElipsAxis(lambdaShort, lambdaLong);
+
+            clusters(bcMap[cluTR.getBCData().toLong()], kPHOS, mom.X(), mom.Y(), mom.Z(), e,
+                     mod, clu.getMultiplicity(), globaPos.X(), globaPos.Y(), globaPos.Z(),
+                     clu.getTime(), clu.getNExMax(), lambdaShort, lambdaLong, trackdist, trackindex,
+                     clu.firedTrigger(), clu.getDistanceToBadChannel());
           }
-          float posX, posZ;
-          clu.getLocalPosition(posX, posZ);
-
-          // Correction for the depth of the shower starting point (TDR p 127)
-          const float para = 0.925;
-          const float parb = 6.52;
-          float depth = para * TMath::Log(e) + parb;
-          posX -= posX * depth / 460.;
-          posZ -= (posZ - vtx.Z()) * depth / 460.;
-
-          int mod = clu.module();
-          TVector3 globaPos;
-          geomPHOS->local2Global(mod, posX, posZ, globaPos);
-
-          TVector3 mom = globaPos - vtx;
-          if (mom.Mag() == 0) { // should not happpen
-            continue;
-          }
-
-          e = Nonlinearity(e);
-
-          mom.SetMag(e);
-
-          // Track/CPV match will be done in independent task
-          float trackdist = 999.;
-          int trackindex = -1;
-
-          float lambdaShort = 0., lambdaLong = 0.;
-          clu.getElipsAxis(lambdaShort, lambdaLong);
-
-          clusters(bcMap[cluTR.getBCData().toLong()], kPHOS, mom.X(), mom.Y(), mom.Z(), e,
-                   mod, clu.getMultiplicity(), globaPos.X(), globaPos.Y(), globaPos.Z(),
-                   clu.getTime(), clu.getNExMax(), lambdaShort, lambdaLong, trackdist, trackindex,
-                   clu.firedTrigger(), clu.getDistanceToBadChannel());
         }
       }
     } // end isPHOS
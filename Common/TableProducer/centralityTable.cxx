@@ -18,6 +18,8 @@
 #include "Framework/RunningWorkflowInfo.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/Centrality.h"
+#include "Common/Core/HistogramLookup.h"
+#include "Common/Core/TableHelper.h"
 #include <CCDB/BasicCCDBManager.h>
 #include <TH1F.h>
 #include <TFormula.h>
@@ -58,32 +60,45 @@ struct CentralityTable {
     TH1* mhVtxAmpCorrV0A = nullptr;
     TH1* mhVtxAmpCorrV0C = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    o2::common::HistogramLookup mVtxAmpCorrV0A;
+    o2::common::HistogramLookup mVtxAmpCorrV0C;
+    o2::common::HistogramLookup mMultSelCalib;
   } Run2V0MInfo;
   struct tagRun2SPDTrackletsCalibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorr = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    o2::common::HistogramLookup mVtxAmpCorr;
+    o2::common::HistogramLookup mMultSelCalib;
   } Run2SPDTksInfo;
   struct tagRun2SPDClustersCalibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorrCL0 = nullptr;
     TH1* mhVtxAmpCorrCL1 = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    o2::common::HistogramLookup mVtxAmpCorrCL0;
+    o2::common::HistogramLookup mVtxAmpCorrCL1;
+    o2::common::HistogramLookup mMultSelCalib;
   } Run2SPDClsInfo;
   struct tagRun2CL0Calibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorr = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    o2::common::HistogramLookup mVtxAmpCorr;
+    o2::common::HistogramLookup mMultSelCalib;
   } Run2CL0Info;
   struct tagRun2CL1Calibration {
     bool mCalibrationStored = false;
     TH1* mhVtxAmpCorr = nullptr;
     TH1* mhMultSelCalib = nullptr;
+    o2::common::HistogramLookup mVtxAmpCorr;
+    o2::common::HistogramLookup mMultSelCalib;
   } Run2CL1Info;
   struct calibrationInfo {
     std::string name = "";
     bool mCalibrationStored = false;
     TH1* mhMultSelCalib = nullptr;
+    o2::common::HistogramLookup mMultSelCalib;
     float mMCScalePars[6] = {0.0};
     TFormula* mMCScale = nullptr;
     calibrationInfo(std::string name)
@@ -110,34 +125,29 @@ struct CentralityTable {
     }
 
     /* Checking the tables which are requested in the workflow and enabling them */
-    auto& workflows = context.services().get<RunningWorkflowInfo const>();
-    for (DeviceSpec const& device : workflows.devices) {
-      for (auto const& input : device.inputs) {
-        auto enable = [&input](const std::string detector, Configurable<int>& flag) {
-          const std::string table = "Cent" + detector + "s";
-          if (input.matcher.binding == table) {
-            if (flag < 0) {
-              flag.value = 1;
-              LOGF(info, "Auto-enabling table: %s", table.c_str());
-            } else if (flag > 0) {
-              flag.value = 1;
-              LOGF(info, "Table %s already enabled", table.c_str());
-            } else {
-              LOGF(info, "Table %s disabled", table.c_str());
-            }
-          }
-        };
-        enable("Run2V0M", estRun2V0M);
-        enable("Run2SPDTrk", estRun2SPDTrklets);
-        enable("Run2SPDCls", estRun2SPDClusters);
-        enable("Run2CL0", estRun2CL0);
-        enable("Run2CL1", estRun2CL1);
-        enable("FV0A", estFV0A);
-        enable("FT0M", estFT0M);
-        enable("FDDM", estFDDM);
-        enable("NTPV", estNTPV);
+    auto enable = [&context](const std::string detector, Configurable<int>& flag) {
+      const std::string table = "Cent" + detector + "s";
+      if (isTableRequiredInWorkflow(context, table)) {
+        if (flag < 0) {
+          flag.value = 1;
+          LOGF(info, "Auto-enabling table: %s", table.c_str());
+        } else if (flag > 0) {
+          flag.value = 1;
+          LOGF(info, "Table %s already enabled", table.c_str());
+        } else {
+          LOGF(info, "Table %s disabled", table.c_str());
+        }
       }
-    }
+    };
+    enable("Run2V0M", estRun2V0M);
+    enable("Run2SPDTrk", estRun2SPDTrklets);
+    enable("Run2SPDCls", estRun2SPDClusters);
+    enable("Run2CL0", estRun2CL0);
+    enable("Run2CL1", estRun2CL1);
+    enable("FV0A", estFV0A);
+    enable("FT0M", estFT0M);
+    enable("FDDM", estFDDM);
+    enable("NTPV", estNTPV);
     ccdb->setURL(ccdbUrl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
@@ -184,6 +194,10 @@ struct CentralityTable {
                 LOGF(fatal, "MC Scale information from V0M for run %d not available", bc.runNumber());
               }
             }
+            // flat copies of the calibrations for the per collision lookups
+            Run2V0MInfo.mVtxAmpCorrV0A.set(Run2V0MInfo.mhVtxAmpCorrV0A);
+            Run2V0MInfo.mVtxAmpCorrV0C.set(Run2V0MInfo.mhVtxAmpCorrV0C);
+            Run2V0MInfo.mMultSelCalib.set(Run2V0MInfo.mhMultSelCalib);
             Run2V0MInfo.mCalibrationStored = true;
           } else {
             LOGF(fatal, "Calibration information from V0M for run %d corrupted", bc.runNumber());
@@ -194,6 +208,8 @@ struct CentralityTable {
           Run2SPDTksInfo.mhVtxAmpCorr = getccdb("hVtx_fnTracklets_Normalized");
           Run2SPDTksInfo.mhMultSelCalib = getccdb("hMultSelCalib_SPDTracklets");
           if ((Run2SPDTksInfo.mhVtxAmpCorr != nullptr) and (Run2SPDTksInfo.mhMultSelCalib != nullptr)) {
+            Run2SPDTksInfo.mVtxAmpCorr.set(Run2SPDTksInfo.mhVtxAmpCorr);
+            Run2SPDTksInfo.mMultSelCalib.set(Run2SPDTksInfo.mhMultSelCalib);
             Run2SPDTksInfo.mCalibrationStored = true;
           } else {
             LOGF(fatal, "Calibration information from SPD tracklets for run %d corrupted", bc.runNumber());
@@ -205,6 +221,9 @@ struct CentralityTable {
           Run2SPDClsInfo.mhVtxAmpCorrCL1 = getccdb("hVtx_fnSPDClusters1_Normalized");
           Run2SPDClsInfo.mhMultSelCalib = getccdb("hMultSelCalib_SPDClusters");
           if ((Run2SPDClsInfo.mhVtxAmpCorrCL0 != nullptr) and (Run2SPDClsInfo.mhVtxAmpCorrCL1 != nullptr) and (Run2SPDClsInfo.mhMultSelCalib != nullptr)) {
+            Run2SPDClsInfo.mVtxAmpCorrCL0.set(Run2SPDClsInfo.mhVtxAmpCorrCL0);
+            Run2SPDClsInfo.mVtxAmpCorrCL1.set(Run2SPDClsInfo.mhVtxAmpCorrCL1);
+            Run2SPDClsInfo.mMultSelCalib.set(Run2SPDClsInfo.mhMultSelCalib);
             Run2SPDClsInfo.mCalibrationStored = true;
           } else {
             LOGF(fatal, "Calibration information from SPD clusters for run %d corrupted", bc.runNumber());
@@ -215,6 +234,8 @@ struct CentralityTable {
           Run2CL0Info.mhVtxAmpCorr = getccdb("hVtx_fnSPDClusters0_Normalized");
           Run2CL0Info.mhMultSelCalib = getccdb("hMultSelCalib_CL0");
           if ((Run2CL0Info.mhVtxAmpCorr != nullptr) and (Run2CL0Info.mhMultSelCalib != nullptr)) {
+            Run2CL0Info.mVtxAmpCorr.set(Run2CL0Info.mhVtxAmpCorr);
+            Run2CL0Info.mMultSelCalib.set(Run2CL0Info.mhMultSelCalib);
             Run2CL0Info.mCalibrationStored = true;
           } else {
             LOGF(fatal, "Calibration information from CL0 multiplicity for run %d corrupted", bc.runNumber());
@@ -225,6 +246,8 @@ struct CentralityTable {
           Run2CL1Info.mhVtxAmpCorr = getccdb("hVtx_fnSPDClusters1_Normalized");
           Run2CL1Info.mhMultSelCalib = getccdb("hMultSelCalib_CL1");
           if ((Run2CL1Info.mhVtxAmpCorr != nullptr) and (Run2CL1Info.mhMultSelCalib != nullptr)) {
+            Run2CL1Info.mVtxAmpCorr.set(Run2CL1Info.mhVtxAmpCorr);
+            Run2CL1Info.mMultSelCalib.set(Run2CL1Info.mhMultSelCalib);
             Run2CL1Info.mCalibrationStored = true;
           } else {
             LOGF(fatal, "Calibration information from CL1 multiplicity for run %d corrupted", bc.runNumber());
@@ -250,10 +273,10 @@ struct CentralityTable {
           v0m = scaleMC(collision.multFV0M(), Run2V0MInfo.mMCScalePars);
           LOGF(debug, "Unscaled v0m: %f, scaled v0m: %f", collision.multFV0M(), v0m);
         } else {
-          v0m = collision.multFV0A() * Run2V0MInfo.mhVtxAmpCorrV0A->GetBinContent(Run2V0MInfo.mhVtxAmpCorrV0A->FindFixBin(collision.posZ())) +
-                collision.multFV0C() * Run2V0MInfo.mhVtxAmpCorrV0C->GetBinContent(Run2V0MInfo.mhVtxAmpCorrV0C->FindFixBin(collision.posZ()));
+          v0m = collision.multFV0A() * Run2V0MInfo.mVtxAmpCorrV0A(collision.posZ()) +
+                collision.multFV0C() * Run2V0MInfo.mVtxAmpCorrV0C(collision.posZ());
         }
-        cV0M = Run2V0MInfo.mhMultSelCalib->GetBinContent(Run2V0MInfo.mhMultSelCalib->FindFixBin(v0m));
+        cV0M = Run2V0MInfo.mMultSelCalib(v0m);
       }
       LOGF(debug, "centRun2V0M=%.0f", cV0M);
       // fill centrality columns
@@ -262,8 +285,8 @@ struct CentralityTable {
     if (estRun2SPDTrklets == 1) {
       float cSPD = 105.0f;
       if (Run2SPDTksInfo.mCalibrationStored) {
-        float spdm = collision.multTracklets() * Run2SPDTksInfo.mhVtxAmpCorr->GetBinContent(Run2SPDTksInfo.mhVtxAmpCorr->FindFixBin(collision.posZ()));
-        cSPD = Run2SPDTksInfo.mhMultSelCalib->GetBinContent(Run2SPDTksInfo.mhMultSelCalib->FindFixBin(spdm));
+        float spdm = collision.multTracklets() * Run2SPDTksInfo.mVtxAmpCorr(collision.posZ());
+        cSPD = Run2SPDTksInfo.mMultSelCalib(spdm);
       }
       LOGF(debug, "centSPDTracklets=%.0f", cSPD);
       centRun2SPDTracklets(cSPD);
@@ -271,9 +294,9 @@ struct CentralityTable {
     if (estRun2SPDClusters == 1) {
       float cSPD = 105.0f;
       if (Run2SPDClsInfo.mCalibrationStored) {
-        float spdm = bc.spdClustersL0() * Run2SPDClsInfo.mhVtxAmpCorrCL0->GetBinContent(Run2SPDClsInfo.mhVtxAmpCorrCL0->FindFixBin(collision.posZ())) +
-                     bc.spdClustersL1() * Run2SPDClsInfo.mhVtxAmpCorrCL1->GetBinContent(Run2SPDClsInfo.mhVtxAmpCorrCL1->FindFixBin(collision.posZ()));
-        cSPD = Run2SPDClsInfo.mhMultSelCalib->GetBinContent(Run2SPDClsInfo.mhMultSelCalib->FindFixBin(spdm));
+        float spdm = bc.spdClustersL0() * Run2SPDClsInfo.mVtxAmpCorrCL0(collision.posZ()) +
+                     bc.spdClustersL1() * Run2SPDClsInfo.mVtxAmpCorrCL1(collision.posZ());
+        cSPD = Run2SPDClsInfo.mMultSelCalib(spdm);
       }
       LOGF(debug, "centSPDClusters=%.0f", cSPD);
       centRun2SPDClusters(cSPD);
@@ -281,8 +304,8 @@ struct CentralityTable {
     if (estRun2CL0 == 1) {
       float cCL0 = 105.0f;
       if (Run2CL0Info.mCalibrationStored) {
-        float cl0m = bc.spdClustersL0() * Run2CL0Info.mhVtxAmpCorr->GetBinContent(Run2CL0Info.mhVtxAmpCorr->FindFixBin(collision.posZ()));
-        cCL0 = Run2CL0Info.mhMultSelCalib->GetBinContent(Run2CL0Info.mhMultSelCalib->FindFixBin(cl0m));
+        float cl0m = bc.spdClustersL0() * Run2CL0Info.mVtxAmpCorr(collision.posZ());
+        cCL0 = Run2CL0Info.mMultSelCalib(cl0m);
       }
       LOGF(debug, "centCL0=%.0f", cCL0);
       centRun2CL0(cCL0);
@@ -290,8 +313,8 @@ struct CentralityTable {
     if (estRun2CL1 == 1) {
       float cCL1 = 105.0f;
       if (Run2CL1Info.mCalibrationStored) {
-        float cl1m = bc.spdClustersL1() * Run2CL1Info.mhVtxAmpCorr->GetBinContent(Run2CL1Info.mhVtxAmpCorr->FindFixBin(collision.posZ()));
-        cCL1 = Run2CL1Info.mhMultSelCalib->GetBinContent(Run2CL1Info.mhMultSelCalib->FindFixBin(cl1m));
+        float cl1m = bc.spdClustersL1() * Run2CL1Info.mVtxAmpCorr(collision.posZ());
+        cCL1 = Run2CL1Info.mMultSelCalib(cl1m);
       }
       LOGF(debug, "centCL1=%.0f", cCL1);
       centRun2CL1(cCL1);
@@ -328,6 +351,7 @@ struct CentralityTable {
                 LOGF(warning, "MC Scale information from %s for run %d not available", estimator.name.c_str(), bc.runNumber());
               }
             }
+            estimator.mMultSelCalib.set(estimator.mhMultSelCalib);
             estimator.mCalibrationStored = true;
           } else {
             LOGF(error, "Calibration information from %s for run %d not available", estimator.name.c_str(), bc.runNumber());
@@ -363,7 +387,7 @@ struct CentralityTable {
           scaledMultiplicity = scaleMC(multiplicity, estimator.mMCScalePars);
           LOGF(debug, "Unscaled %s multiplicity: %f, scaled %s multiplicity: %f", estimator.name.c_str(), multiplicity, estimator.name.c_str(), scaledMultiplicity);
         }
-        percentile = estimator.mhMultSelCalib->GetBinContent(estimator.mhMultSelCalib->FindFixBin(scaledMultiplicity));
+        percentile = estimator.mMultSelCalib(scaledMultiplicity);
       }
       LOGF(debug, "%s centrality/multiplicity percentile = %.0f for a zvtx eq %s value %.0f", estimator.name.c_str(), percentile, estimator.name.c_str(), scaledMultiplicity);
       table(percentile);
@@ -0,0 +1,146 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+//
+// Task producing the event observables computed from the tracks, see Common/DataModel/EventObservables.h
+// The tracks of the dataframe are read once and accumulated into the collision they belong to.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/runDataProcessing.h"
+#include "Common/DataModel/EventObservables.h"
+#include "Common/DataModel/TrackSelectionTables.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct EventObservables {
+  Produces<aod::EvtLeadings> evtLeadings;
+  Produces<aod::EvtShapes> evtShapes;
+  Produces<aod::EvtEtaMults> evtEtaMults;
+  Produces<aod::EvtQvecs> evtQvecs;
+
+  Configurable<bool> requireGlobalTrack{"requireGlobalTrack", true, "Select the global tracks only"};
+  Configurable<float> ptMin{"ptMin", 0.15f, "Minimum pT of the selected tracks (GeV/c)"};
+  Configurable<float> ptMax{"ptMax", 1000.f, "Maximum pT of the selected tracks (GeV/c)"};
+  Configurable<float> etaMax{"etaMax", 0.8f, "Maximum |eta| of the tracks of the leading track, sphericity and Q-vectors"};
+  Configurable<std::vector<float>> etaClasses{"etaClasses", {0.5f, 0.8f, 1.0f}, "Maximum |eta| of the three multiplicity classes"};
+
+  // Observables of a collision, accumulated over its tracks
+  struct Accumulator {
+    int leadingTrackId = -1;
+    float leadingPt = -1.f;
+    float leadingEta = 0.f;
+    float leadingPhi = 0.f;
+    int nSphericity = 0;
+    double sumPt = 0.;
+    double sxx = 0., sxy = 0., syy = 0.; // linearised transverse momentum tensor, sum of p_i p_j / pT
+    int multEta[3] = {0, 0, 0};
+    double q2x = 0., q2y = 0., q3x = 0., q3y = 0.;
+    int qMult = 0;
+  };
+  std::vector<Accumulator> accumulators;
+
+  void init(InitContext&)
+  {
+    if (etaClasses->size() != 3) {
+      LOGF(fatal, "etaClasses must have 3 entries, %d given", etaClasses->size());
+    }
+  }
+
+  void process(aod::Collisions const& collisions, soa::Join<aod::Tracks, aod::TrackSelection> const& tracks)
+  {
+    accumulators.assign(collisions.size(), Accumulator{});
+    const float etaClass[3] = {etaClasses->at(0), etaClasses->at(1), etaClasses->at(2)};
+
+    for (auto const& track : tracks) {
+      if (track.collisionId() < 0 || track.collisionId() >= collisions.size()) {
+        continue;
+      }
+      if (requireGlobalTrack && !track.isGlobalTrack()) {
+        continue;
+      }
+      const float pt = track.pt();
+      if (pt < ptMin || pt > ptMax) {
+        continue;
+      }
+      auto& acc = accumulators[track.collisionId()];
+      const float absEta = std::abs(track.eta());
+      for (int c = 0; c < 3; c++) {
+        acc.multEta[c] += absEta < etaClass[c];
+      }
+      if (absEta >= etaMax) {
+        continue;
+      }
+
+      const float phi = track.phi();
+      if (pt > acc.leadingPt) {
+        acc.leadingTrackId = track.globalIndex();
+        acc.leadingPt = pt;
+        acc.leadingEta = track.eta();
+        acc.leadingPhi = phi;
+      }
+
+      const double cosPhi = std::cos(phi);
+      const double sinPhi = std::sin(phi);
+      acc.nSphericity++;
+      acc.sumPt += pt;
+      acc.sxx += pt * cosPhi * cosPhi;
+      acc.sxy += pt * cosPhi * sinPhi;
+      acc.syy += pt * sinPhi * sinPhi;
+
+      // cos(2 phi), sin(2 phi) and cos(3 phi), sin(3 phi) from the ones of phi
+      const double cos2Phi = cosPhi * cosPhi - sinPhi * sinPhi;
+      const double sin2Phi = 2. * sinPhi * cosPhi;
+      acc.q2x += cos2Phi;
+      acc.q2y += sin2Phi;
+      acc.q3x += cos2Phi * cosPhi - sin2Phi * sinPhi;
+      acc.q3y += sin2Phi * cosPhi + cos2Phi * sinPhi;
+      acc.qMult++;
+    }
+
+    evtLeadings.reserve(collisions.size());
+    evtShapes.reserve(collisions.size());
+    evtEtaMults.reserve(collisions.size());
+    evtQvecs.reserve(collisions.size());
+    for (auto const& acc : accumulators) {
+      evtLeadings(acc.leadingTrackId, acc.leadingPt, acc.leadingEta, acc.leadingPhi);
+      evtShapes(sphericityT(acc));
+      evtEtaMults(acc.multEta[0], acc.multEta[1], acc.multEta[2]);
+      evtQvecs(acc.q2x, acc.q2y, acc.q3x, acc.q3y, acc.qMult);
+    }
+  }
+
+  // S_T = 2 lambda_2 / (lambda_1 + lambda_2), with lambda_1 > lambda_2 the eigenvalues of the normalised tensor
+  static float sphericityT(Accumulator const& acc)
+  {
+    if (acc.nSphericity < 3 || acc.sumPt <= 0.) {
+      return -1.f;
+    }
+    const double xx = acc.sxx / acc.sumPt;
+    const double xy = acc.sxy / acc.sumPt;
+    const double yy = acc.syy / acc.sumPt;
+    const double trace = xx + yy;
+    const double root = std::sqrt(std::max(0., trace * trace - 4. * (xx * yy - xy * xy)));
+    const double lambda2 = 0.5 * (trace - root);
+    return trace > 0. ? 2. * lambda2 / trace : -1.f;
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<EventObservables>(cfgc)};
+}
@@ -24,6 +24,10 @@ using namespace o2::framework;
 #include "Framework/HistogramRegistry.h"
 #include "DataFormatsFT0/Digit.h"
 #include "TH1F.h"
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
 using namespace evsel;
 
 using BCsWithRun2InfosTimestampsAndMatches = soa::Join<aod::BCs, aod::Run2BCInfos, aod::Timestamps, aod::Run2MatchedToBCSparse>;
@@ -35,6 +39,12 @@ struct BcSelectionTask {
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
 
+  // Run 2 CCDB objects of the current run, with the trigger aliases compiled into the trigger class masks of every alias
+  int mRun2RunNumber = -1;
+  EventSelectionParams* mRun2Par = nullptr;
+  std::array<uint64_t, kNaliases> mAliasTriggerMask{};
+  std::array<uint64_t, kNaliases> mAliasTriggerMaskNext50{};
+
   void init(InitContext&)
   {
     // ccdb->setURL("http://ccdb-test.cern.ch:8080");
@@ -55,17 +65,26 @@ struct BcSelectionTask {
   {
 
     for (auto& bc : bcs) {
-      EventSelectionParams* par = ccdb->getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", bc.timestamp());
-      TriggerAliases* aliases = ccdb->getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", bc.timestamp());
+      if (bc.runNumber() != mRun2RunNumber) {
+        mRun2RunNumber = bc.runNumber();
+        mRun2Par = ccdb->getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", bc.timestamp());
+        TriggerAliases* aliases = ccdb->getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", bc.timestamp());
+        mAliasTriggerMask.fill(0);
+        mAliasTriggerMaskNext50.fill(0);
+        for (auto& al : aliases->GetAliasToTriggerMaskMap()) {
+          mAliasTriggerMask[al.first] |= al.second;
+        }
+        for (auto& al : aliases->GetAliasToTriggerMaskNext50Map()) {
+          mAliasTriggerMaskNext50[al.first] |= al.second;
+        }
+      }
+      EventSelectionParams* par = mRun2Par;
       // fill fired aliases
       int32_t alias[kNaliases] = {0};
       uint64_t triggerMask = bc.triggerMask();
-      for (auto& al : aliases->GetAliasToTriggerMaskMap()) {
-        alias[al.first] |= (triggerMask & al.second) > 0;
-      }
       uint64_t triggerMaskNext50 = bc.triggerMaskNext50();
-      for (auto& al : aliases->GetAliasToTriggerMaskNext50Map()) {
-        alias[al.first] |= (triggerMaskNext50 & al.second) > 0;
+      for (int i = 0; i < kNaliases; i++) {
+        alias[i] = (triggerMask & mAliasTriggerMask[i]) > 0 || (triggerMaskNext50 & mAliasTriggerMaskNext50[i]) > 0;
       }
       alias[kALL] = 1;
 
@@ -189,7 +208,9 @@ struct BcSelectionTask {
                    aod::FT0s const&,
                    aod::FDDs const&)
   {
-    std::map<int64_t, int32_t> mapBcToZDCindex;
+    // (shifted globalBC, ZDC row) sorted in BC, the BCs are visited in increasing globalBC
+    // and the ZDC of each BC is found by advancing a single position in this array
+    std::vector<std::pair<uint64_t, int32_t>> bcToZDCindex;
     int run = bcs.iteratorAt(0).runNumber();
     if (run == 529403 || run == 529418) {
       int64_t orbitShift = 0;
@@ -198,10 +219,14 @@ struct BcSelectionTask {
       if (run == 529418)
         orbitShift = 28756480;
       int64_t shift = (orbitShift - 1) * 3564 + 1;
+      bcToZDCindex.reserve(zdcs.size());
       for (const auto& zdc : zdcs) {
-        mapBcToZDCindex[zdc.bc_as<BCsWithRun3Matchings>().globalBC() + shift] = zdc.globalIndex();
+        bcToZDCindex.emplace_back(zdc.bc_as<BCsWithRun3Matchings>().globalBC() + shift, zdc.globalIndex());
       }
+      // the last ZDC of a BC wins, as for a map filled in the order of the rows
+      std::stable_sort(bcToZDCindex.begin(), bcToZDCindex.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
     }
+    auto nextZDC = bcToZDCindex.begin();
 
     for (auto bc : bcs) {
       EventSelectionParams* par = ccdb->getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", bc.timestamp());
@@ -215,9 +240,13 @@ struct BcSelectionTask {
       aod::Zdcs::iterator foundZDC;
       if (zdcs.size() > 0) {
         foundZDC = zdcs.iteratorAt(0);
-        auto it = mapBcToZDCindex.find(bc.globalBC());
-        if (it != mapBcToZDCindex.end()) {
-          foundZDCId = it->second;
+        while (nextZDC != bcToZDCindex.end() && nextZDC->first < bc.globalBC()) {
+          ++nextZDC;
+        }
+        for (; nextZDC != bcToZDCindex.end() && nextZDC->first == bc.globalBC(); ++nextZDC) {
+          foundZDCId = nextZDC->second;
+        }
+        if (foundZDCId >= 0) {
           foundZDC = zdcs.iteratorAt(foundZDCId);
         }
       }
@@ -339,6 +368,73 @@ struct EventSelectionTask {
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
 
+  // BCs with a FIT signal in the current data frame, built once and binary searched for the BC window of each collision
+  struct FlaggedBCs {
+    std::vector<int64_t> rows;       // rows of the flagged BCs, in increasing order
+    std::vector<uint64_t> globalBCs; // their globalBCs, sorted as the rows
+
+    void clear()
+    {
+      rows.clear();
+      globalBCs.clear();
+    }
+    void add(int64_t row, uint64_t globalBC)
+    {
+      rows.push_back(row);
+      globalBCs.push_back(globalBC);
+    }
+    // first flagged row from row on, as found by moving forward while in [minBC, maxBC], -1 if none
+    int64_t forward(int64_t row, uint64_t rowBC, uint64_t minBC, uint64_t maxBC) const
+    {
+      if (rowBC < minBC || rowBC > maxBC) {
+        return -1;
+      }
+      auto it = std::lower_bound(rows.begin(), rows.end(), row);
+      if (it == rows.end() || globalBCs[std::distance(rows.begin(), it)] > maxBC) {
+        return -1;
+      }
+      return *it;
+    }
+    // last flagged row before row with globalBC in [minBC, maxBC], as found by moving backward, -1 if none
+    int64_t backward(int64_t row, uint64_t rowBC, uint64_t minBC, uint64_t maxBC) const
+    {
+      if (row == 0 || rowBC < minBC) {
+        return -1;
+      }
+      auto limit = globalBCs.begin() + std::distance(rows.begin(), std::lower_bound(rows.begin(), rows.end(), row));
+      auto it = std::upper_bound(globalBCs.begin(), limit, maxBC);
+      if (it == globalBCs.begin() || *(--it) < minBC) {
+        return -1;
+      }
+      return rows[std::distance(globalBCs.begin(), it)];
+    }
+  };
+  FlaggedBCs tvxBCs;   // BCs with TVX trigger
+  FlaggedBCs ft0orBCs; // BCs with FT0A or FT0C beam-beam timing
+  const void* flaggedBCsTable = nullptr;
+  std::size_t flaggedBCsSize = 0;
+
+  // fills the flagged BCs when a new data frame is seen, the process function is called per collision
+  template <typename T>
+  void flagBCs(T const& bcs)
+  {
+    if (flaggedBCsTable == bcs.asArrowTable().get() && flaggedBCsSize == (std::size_t)bcs.size()) {
+      return;
+    }
+    flaggedBCsTable = bcs.asArrowTable().get();
+    flaggedBCsSize = bcs.size();
+    tvxBCs.clear();
+    ft0orBCs.clear();
+    for (auto const& bc : bcs) {
+      if (bc.selection()[kIsTriggerTVX]) {
+        tvxBCs.add(bc.globalIndex(), bc.globalBC());
+      }
+      if (bc.selection()[kIsBBT0A] || bc.selection()[kIsBBT0C]) {
+        ft0orBCs.add(bc.globalIndex(), bc.globalBC());
+      }
+    }
+  }
+
   void init(InitContext&)
   {
     // ccdb->setURL("http://ccdb-test.cern.ch:8080");
@@ -523,55 +619,26 @@ struct EventSelectionTask {
 
     LOGP(debug, "meanBC={} minBC={} maxBC={} collisionTimeRes={}", meanBC, minBC, maxBC, col.collisionTimeRes());
 
-    // search TVX in forward direction starting from the current bc
-    while (bc != bcs.end() && bc.globalBC() <= maxBC && bc.globalBC() >= minBC) {
-      if (bc.selection()[kIsTriggerTVX]) {
-        forwardTvxBC = bc.globalBC();
-        break;
-      }
-      bc++;
-      forwardMoveCountTvx++;
+    // search TVX and FT0-OR in forward and backward direction from the current bc
+    flagBCs(bcs);
+    int64_t row = bc.globalIndex();
+    uint64_t rowBC = bc.globalBC();
+    if (auto found = tvxBCs.forward(row, rowBC, minBC, maxBC); found >= 0) {
+      forwardTvxBC = bcs.iteratorAt(found).globalBC();
+      forwardMoveCountTvx = found - row;
     }
-    bc.moveByIndex(-forwardMoveCountTvx);
-
-    // search TVX in backward direction
-    while (bc.globalIndex() > 0 && bc.globalBC() >= minBC) {
-      bc--;
-      backwardMoveCountTvx--;
-      if (bc.globalBC() > maxBC || bc.globalBC() < minBC) {
-        continue;
-      }
-      if (bc.selection()[kIsTriggerTVX]) {
-        backwardTvxBC = bc.globalBC();
-        break;
-      }
+    if (auto found = tvxBCs.backward(row, rowBC, minBC, maxBC); found >= 0) {
+      backwardTvxBC = bcs.iteratorAt(found).globalBC();
+      backwardMoveCountTvx = found - row;
     }
-    bc.moveByIndex(-backwardMoveCountTvx);
-
-    // search FT0-OR in forward direction starting from the current bc
-    while (bc != bcs.end() && bc.globalBC() <= maxBC && bc.globalBC() >= minBC) {
-      if (bc.selection()[kIsBBT0A] || bc.selection()[kIsBBT0C]) {
-        forwardBC = bc.globalBC();
-        break;
-      }
-      bc++;
-      forwardMoveCount++;
+    if (auto found = ft0orBCs.forward(row, rowBC, minBC, maxBC); found >= 0) {
+      forwardBC = bcs.iteratorAt(found).globalBC();
+      forwardMoveCount = found - row;
     }
-    bc.moveByIndex(-forwardMoveCount);
-
-    // search FT0-OR in backward direction
-    while (bc.globalIndex() > 0 && bc.globalBC() >= minBC) {
-      bc--;
-      backwardMoveCount--;
-      if (bc.globalBC() > maxBC || bc.globalBC() < minBC) {
-        continue;
-      }
-      if (bc.selection()[kIsBBT0A] || bc.selection()[kIsBBT0C]) {
-        backwardBC = bc.globalBC();
-        break;
-      }
+    if (auto found = ft0orBCs.backward(row, rowBC, minBC, maxBC); found >= 0) {
+      backwardBC = bcs.iteratorAt(found).globalBC();
+      backwardMoveCount = found - row;
     }
-    bc.moveByIndex(-backwardMoveCount);
 
     // first check for found TVX signal. If TVX is not found, search for FT0-OR
     if (forwardTvxBC <= maxBC && backwardTvxBC >= minBC) {
@@ -22,6 +22,7 @@ using namespace o2::framework;
 #include "Common/DataModel/FT0Corrected.h"
 #include "DataFormatsFT0/Digit.h"
 #include <bitset>
+#include <vector>
 
 using namespace o2::aod;
 struct FT0CorrectedTable {
@@ -29,28 +30,38 @@ struct FT0CorrectedTable {
   using BCsWithMatchings = soa::Join<aod::BCs, aod::Run3MatchedToBCSparse>;
   using CollisionEvSel = soa::Join<aod::Collisions, aod::EvSels>::iterator;
 
+  // FT0 times of the dataframe, 1e10 when the side did not fire
+  std::vector<float> ft0TimeA;
+  std::vector<float> ft0TimeC;
+
   void process(BCsWithMatchings const& bcs, soa::Join<aod::Collisions, aod::EvSels> const& collisions, aod::FT0s const& ft0s)
   {
+    // gather the FT0 times once, the collisions only read them through the FT0 index
+    ft0TimeA.resize(ft0s.size());
+    ft0TimeC.resize(ft0s.size());
+    int iFT0 = 0;
+    for (auto& ft0 : ft0s) {
+      std::bitset<8> triggers = ft0.triggerMask();
+      ft0TimeA[iFT0] = triggers[o2::ft0::Triggers::bitA] ? ft0.timeA() : 1e10;
+      ft0TimeC[iFT0] = triggers[o2::ft0::Triggers::bitC] ? ft0.timeC() : 1e10;
+      iFT0++;
+    }
+
+    table.reserve(collisions.size());
     for (auto& collision : collisions) {
-      float vertexPV = collision.posZ();
-      float vertex_corr = vertexPV / o2::constants::physics::LightSpeedCm2NS;
+      float vertex_corr = collision.posZ() / o2::constants::physics::LightSpeedCm2NS;
       float t0A = 1e10;
       float t0C = 1e10;
-      if (collision.has_foundFT0()) {
-        auto ft0 = collision.foundFT0();
-        std::bitset<8> triggers = ft0.triggerMask();
-        bool ora = triggers[o2::ft0::Triggers::bitA];
-        bool orc = triggers[o2::ft0::Triggers::bitC];
-        LOGF(debug, "triggers OrA %i OrC %i ", ora, orc);
-        LOGF(debug, " T0A = %f, T0C %f, vertex_corr %f", ft0.timeA(), ft0.timeC(), vertex_corr);
-        if (ora) {
-          t0A = ft0.timeA() + vertex_corr;
+      int ft0Id = collision.foundFT0Id();
+      if (ft0Id >= 0) {
+        if (ft0TimeA[ft0Id] < 1e10) {
+          t0A = ft0TimeA[ft0Id] + vertex_corr;
         }
-        if (orc) {
-          t0C = ft0.timeC() - vertex_corr;
+        if (ft0TimeC[ft0Id] < 1e10) {
+          t0C = ft0TimeC[ft0Id] - vertex_corr;
         }
       }
-      LOGF(debug, " T0 collision time T0A = %f, T0C = %f", t0A, t0C);
+      LOGF(debug, " T0 collision time T0A = %f, T0C = %f, vertex_corr %f", t0A, t0C, vertex_corr);
       table(t0A, t0C);
     }
   }
@@ -11,6 +11,7 @@
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
+#include "Common/Core/TableHelper.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -20,26 +21,37 @@ using namespace o2::framework;
 struct McConverter {
   Produces<aod::StoredMcParticles_001> mcParticles_001;
 
+  std::vector<int> mothers; // reused for all the particles
+
   void process(aod::StoredMcParticles_000 const& mcParticles_000)
   {
+    // the index columns to be converted are copied as whole columns from the Arrow buffers
+    const auto mother0Ids = getColumnValues<aod::mcparticle::Mother0Id>(mcParticles_000);
+    const auto mother1Ids = getColumnValues<aod::mcparticle::Mother1Id>(mcParticles_000);
+    const auto daughter0Ids = getColumnValues<aod::mcparticle::Daughter0Id>(mcParticles_000);
+    const auto daughter1Ids = getColumnValues<aod::mcparticle::Daughter1Id>(mcParticles_000);
+    mcParticles_001.reserve(mcParticles_000.size());
+
+    std::size_t i = 0;
     for (auto& p : mcParticles_000) {
 
-      std::vector<int> mothers;
-      if (p.mother0Id() >= 0) {
-        mothers.push_back(p.mother0Id());
+      mothers.clear();
+      if (mother0Ids[i] >= 0) {
+        mothers.push_back(mother0Ids[i]);
       }
-      if (p.mother1Id() >= 0) {
-        mothers.push_back(p.mother1Id());
+      if (mother1Ids[i] >= 0) {
+        mothers.push_back(mother1Ids[i]);
       }
 
       int daughters[2] = {-1, -1};
-      if (p.daughter0Id() >= 0 && p.daughter1Id() >= 0) {
-        daughters[0] = p.daughter0Id();
-        daughters[1] = p.daughter1Id();
-      } else if (p.daughter0Id() >= 0) {
-        daughters[0] = p.daughter0Id();
-        daughters[1] = p.daughter0Id();
+      if (daughter0Ids[i] >= 0 && daughter1Ids[i] >= 0) {
+        daughters[0] = daughter0Ids[i];
+        daughters[1] = daughter1Ids[i];
+      } else if (daughter0Ids[i] >= 0) {
+        daughters[0] = daughter0Ids[i];
+        daughters[1] = daughter0Ids[i];
       }
+      i++;
 
       mcParticles_001(p.mcCollisionId(), p.pdgCode(), p.statusCode(), p.flags(),
                       mothers, daughters, p.weight(), p.px(), p.py(), p.pz(), p.e(),
@@ -20,6 +20,9 @@ using namespace o2::framework;
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "iostream"
+#include <cmath>
+#include <numeric>
+#include <vector>
 
 struct MultiplicityTableTaskIndexed {
   Produces<aod::Mults> mult;
@@ -28,10 +31,24 @@ struct MultiplicityTableTaskIndexed {
   //For vertex-Z corrections in calibration
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
-  Partition<soa::Join<aod::Tracks, aod::TracksExtra>> run2tracklets = (aod::track::trackType == static_cast<uint8_t>(o2::aod::track::TrackTypeEnum::Run2Tracklet));
-  Partition<soa::Join<aod::Tracks, aod::TracksExtra>> tracksWithTPC = (aod::track::tpcNClsFindable > (uint8_t)0);
-  Partition<soa::Join<aod::Tracks, aod::TracksExtra>> pvContribTracks = (nabs(aod::track::eta) < 0.8f) && ((aod::track::flags & (uint32_t)o2::aod::track::PVContributor) == (uint32_t)o2::aod::track::PVContributor);
-  Partition<soa::Join<aod::Tracks, aod::TracksExtra>> pvContribTracksEta1 = (nabs(aod::track::eta) < 1.0f) && ((aod::track::flags & (uint32_t)o2::aod::track::PVContributor) == (uint32_t)o2::aod::track::PVContributor);
+  // Track counts of each collision, filled in a single pass over the collision index of the tracks
+  // the first time a data frame is seen, instead of one slice per collision of four partitions
+  struct TrackCounts {
+    int tracklets = 0;      // Run 2 tracklets
+    int tpc = 0;            // tracks with findable TPC clusters
+    int pvContribs = 0;     // PV contributors with |eta| < 0.8
+    int pvContribsEta1 = 0; // PV contributors with |eta| < 1
+  };
+  std::vector<TrackCounts> trackCounts;
+  const void* countedTracks = nullptr;
+  std::size_t countedTracksSize = 0;
+
+  // Sums of the FIT amplitudes of each row of the FIT tables, computed once per data frame
+  std::vector<float> sumsFT0A, sumsFT0C, sumsFDDA, sumsFDDC, sumsFV0A, sumsFV0C;
+  const void* summedFT0s = nullptr;
+  const void* summedFDDs = nullptr;
+  const void* summedFV0As = nullptr;
+  const void* summedFV0Cs = nullptr;
 
   //Configurable
   Configurable<int> doVertexZeq{"doVertexZeq", 1, "if 1: do vertex Z eq mult table"};
@@ -71,6 +88,69 @@ struct MultiplicityTableTaskIndexed {
     ccdb->setFatalWhenNull(false); //don't fatal, please - exception is caught explicitly (as it should)
   }
 
+  // the process functions are called per collision with the same tables for all the collisions of a data frame
+  template <typename T>
+  bool isNewDataFrame(T const& table, const void*& seen, std::size_t nFilled)
+  {
+    if (seen == table.asArrowTable().get() && nFilled == (std::size_t)table.size()) {
+      return false;
+    }
+    seen = table.asArrowTable().get();
+    return true;
+  }
+
+  template <typename T>
+  void countTracks(T const& tracks)
+  {
+    if (!isNewDataFrame(tracks, countedTracks, countedTracksSize)) {
+      return;
+    }
+    countedTracksSize = tracks.size();
+    trackCounts.clear();
+    for (auto const& track : tracks) {
+      if (track.collisionId() < 0) {
+        continue;
+      }
+      if ((std::size_t)track.collisionId() >= trackCounts.size()) {
+        trackCounts.resize(track.collisionId() + 1);
+      }
+      auto& counts = trackCounts[track.collisionId()];
+      const bool isPVContrib = (track.flags() & (uint32_t)o2::aod::track::PVContributor) == (uint32_t)o2::aod::track::PVContributor;
+      const float absEta = std::abs(track.eta());
+      counts.tracklets += track.trackType() == static_cast<uint8_t>(o2::aod::track::TrackTypeEnum::Run2Tracklet);
+      counts.tpc += track.tpcNClsFindable() > (uint8_t)0;
+      counts.pvContribs += isPVContrib && absEta < 0.8f;
+      counts.pvContribsEta1 += isPVContrib && absEta < 1.0f;
+    }
+  }
+
+  TrackCounts const& tracksOf(int64_t collisionId) const
+  {
+    static const TrackCounts noTracks{};
+    return (std::size_t)collisionId < trackCounts.size() ? trackCounts[collisionId] : noTracks;
+  }
+
+  // sums of the amplitude array returned by amplitudes(row) for each row of table, summed in the same order as the array
+  template <typename T, typename F>
+  void sumPerRow(T const& table, std::vector<float>& sums, F&& amplitudes)
+  {
+    sums.resize(table.size());
+    std::size_t i = 0;
+    for (auto const& row : table) {
+      auto values = amplitudes(row);
+      sums[i++] = std::accumulate(values.begin(), values.end(), 0.f);
+    }
+  }
+
+  template <typename T>
+  void sumFT0s(T const& ft0s)
+  {
+    if (isNewDataFrame(ft0s, summedFT0s, sumsFT0A.size())) {
+      sumPerRow(ft0s, sumsFT0A, [](auto const& ft0) { return ft0.amplitudeA(); });
+      sumPerRow(ft0s, sumsFT0C, [](auto const& ft0) { return ft0.amplitudeC(); });
+    }
+  }
+
   void processRun2(aod::Run2MatchedSparse::iterator const& collision, soa::Join<aod::Tracks, aod::TracksExtra> const& tracksExtra, aod::BCs const&, aod::Zdcs const&, aod::FV0As const& fv0as, aod::FV0Cs const& fv0cs, aod::FT0s const& ft0s)
   {
     float multFV0A = 0.f;
@@ -82,31 +162,29 @@ struct MultiplicityTableTaskIndexed {
     float multZNA = 0.f;
     float multZNC = 0.f;
 
-    auto trackletsGrouped = run2tracklets->sliceByCached(aod::track::collisionId, collision.globalIndex());
-    auto tracksGrouped = tracksWithTPC->sliceByCached(aod::track::collisionId, collision.globalIndex());
-    int multTracklets = trackletsGrouped.size();
-    int multTPC = tracksGrouped.size();
+    countTracks(tracksExtra);
+    auto const& counts = tracksOf(collision.globalIndex());
+    int multTracklets = counts.tracklets;
+    int multTPC = counts.tpc;
     int multNContribs = 0;
     int multNContribsEta1 = 0;
 
+    sumFT0s(ft0s);
+    if (isNewDataFrame(fv0as, summedFV0As, sumsFV0A.size())) {
+      sumPerRow(fv0as, sumsFV0A, [](auto const& fv0a) { return fv0a.amplitude(); });
+    }
+    if (isNewDataFrame(fv0cs, summedFV0Cs, sumsFV0C.size())) {
+      sumPerRow(fv0cs, sumsFV0C, [](auto const& fv0c) { return fv0c.amplitude(); });
+    }
     if (collision.has_fv0a()) {
-      for (auto amplitude : collision.fv0a().amplitude()) {
-        multFV0A += amplitude;
-      }
+      multFV0A = sumsFV0A[collision.fv0aId()];
     }
     if (collision.has_fv0c()) {
-      for (auto amplitude : collision.fv0c().amplitude()) {
-        multFV0C += amplitude;
-      }
+      multFV0C = sumsFV0C[collision.fv0cId()];
     }
     if (collision.has_ft0()) {
-      auto ft0 = collision.ft0();
-      for (auto amplitude : ft0.amplitudeA()) {
-        multFT0A += amplitude;
-      }
-      for (auto amplitude : ft0.amplitudeC()) {
-        multFT0C += amplitude;
-      }
+      multFT0A = sumsFT0A[collision.ft0Id()];
+      multFT0C = sumsFT0C[collision.ft0Id()];
     }
     if (collision.has_zdc()) {
       auto zdc = collision.zdc();
@@ -138,12 +216,11 @@ struct MultiplicityTableTaskIndexed {
     float multZeqFDDC = 0.f;
     float multZeqNContribs = 0.f;
 
-    auto tracksGrouped = tracksWithTPC->sliceByCached(aod::track::collisionId, collision.globalIndex());
-    auto pvContribsGrouped = pvContribTracks->sliceByCached(aod::track::collisionId, collision.globalIndex());
-    auto pvContribsEta1Grouped = pvContribTracksEta1->sliceByCached(aod::track::collisionId, collision.globalIndex());
-    int multTPC = tracksGrouped.size();
-    int multNContribs = pvContribsGrouped.size();
-    int multNContribsEta1 = pvContribsEta1Grouped.size();
+    countTracks(tracksExtra);
+    auto const& counts = tracksOf(collision.globalIndex());
+    int multTPC = counts.tpc;
+    int multNContribs = counts.pvContribs;
+    int multNContribsEta1 = counts.pvContribsEta1;
 
     /* check the previous run number */
     auto bc = collision.bc_as<soa::Join<aod::BCs, aod::Timestamps>>();
@@ -170,32 +247,27 @@ struct MultiplicityTableTaskIndexed {
         }
       }
     }
+    sumFT0s(ft0s);
+    if (isNewDataFrame(fdds, summedFDDs, sumsFDDA.size())) {
+      sumPerRow(fdds, sumsFDDA, [](auto const& fdd) { return fdd.chargeA(); });
+      sumPerRow(fdds, sumsFDDC, [](auto const& fdd) { return fdd.chargeC(); });
+    }
+    if (isNewDataFrame(fv0as, summedFV0As, sumsFV0A.size())) {
+      sumPerRow(fv0as, sumsFV0A, [](auto const& fv0) { return fv0.amplitude(); });
+    }
     // using FT0 row index from event selection task
     if (collision.has_foundFT0()) {
-      auto ft0 = collision.foundFT0();
-      for (auto amplitude : ft0.amplitudeA()) {
-        multFT0A += amplitude;
-      }
-      for (auto amplitude : ft0.amplitudeC()) {
-        multFT0C += amplitude;
-      }
+      multFT0A = sumsFT0A[collision.foundFT0Id()];
+      multFT0C = sumsFT0C[collision.foundFT0Id()];
     }
     // using FDD row index from event selection task
     if (collision.has_foundFDD()) {
-      auto fdd = collision.foundFDD();
-      for (auto amplitude : fdd.chargeA()) {
-        multFDDA += amplitude;
-      }
-      for (auto amplitude : fdd.chargeC()) {
-        multFDDC += amplitude;
-      }
+      multFDDA = sumsFDDA[collision.foundFDDId()];
+      multFDDC = sumsFDDC[collision.foundFDDId()];
     }
     // using FV0 row index from event selection task
     if (collision.has_foundFV0()) {
-      auto fv0 = collision.foundFV0();
-      for (auto amplitude : fv0.amplitude()) {
-        multFV0A += amplitude;
-      }
+      multFV0A = sumsFV0A[collision.foundFV0Id()];
     }
     if (fabs(collision.posZ()) < 15.0f && lCalibLoaded) {
       multZeqFV0A = hVtxZFV0A->Interpolate(0.0) * multFV0A / hVtxZFV0A->Interpolate(collision.posZ());
@@ -18,9 +18,11 @@
 ///
 #include <vector>
 #include <map>
+#include <memory>
+#include <future>
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
-#include "CCDB/BasicCCDBManager.h"
+#include "CCDB/CcdbApi.h"
 #include "CommonDataFormat/InteractionRecord.h"
 #include "DetectorsRaw/HBFUtils.h"
 
@@ -29,12 +31,12 @@ using namespace o2::header;
 using namespace o2;
 
 struct TimestampTask {
-  Produces<aod::Timestamps> timestampTable;  /// Table with SOR timestamps produced by the task
-  Service<o2::ccdb::BasicCCDBManager> ccdb;  /// CCDB manager to access orbit-reset timestamp
-  o2::ccdb::CcdbApi ccdb_api;                /// API to access CCDB headers
-  std::map<int, int64_t> mapRunToOrbitReset; /// Cache of orbit reset timestamps
-  int lastRunNumber = 0;                     /// Last run number processed
-  int64_t orbitResetTimestamp = 0;           /// Orbit-reset timestamp in us
+  Produces<aod::Timestamps> timestampTable;               /// Table with SOR timestamps produced by the task
+  o2::ccdb::CcdbApi ccdb_api;                             /// API to access CCDB headers and orbit-reset objects
+  std::map<int, int64_t> mapRunToOrbitReset;              /// Cache of orbit reset timestamps
+  std::map<int, std::future<int64_t>> pendingOrbitResets; /// Orbit-reset timestamps being fetched by the prefetch stage
+  int lastRunNumber = 0;                                  /// Last run number processed
+  int64_t orbitResetTimestamp = 0;                        /// Orbit-reset timestamp in us
 
   // Configurables
   Configurable<bool> verbose{"verbose", false, "verbose mode"};
@@ -42,74 +44,123 @@ struct TimestampTask {
   Configurable<std::string> orbit_reset_path{"orbit-reset-path", "CTP/Calib/OrbitReset", "path to the ccdb orbit-reset objects"};
   Configurable<std::string> url{"ccdb-url", "http://alice-ccdb.cern.ch", "URL of the CCDB database"};
   Configurable<bool> isRun2MC{"isRun2MC", false, "Running mode: enable only for Run 2 MC. Timestamps are set to SOR timestamp"};
+  Configurable<bool> prefetch{"prefetch", true, "Query the orbit-reset timestamps of all the new runs of a dataframe in background threads before filling the table"};
 
   void init(o2::framework::InitContext&)
   {
     LOGF(info, "Initializing TimestampTask");
-    ccdb->setURL(url.value); // Setting URL of CCDB manager from configuration
     ccdb_api.init(url.value);
     if (!ccdb_api.isHostReachable()) {
       LOGF(fatal, "CCDB host %s is not reacheable, cannot go forward", url.value.data());
     }
   }
 
-  void process(aod::BC const& bc)
+  /// Orbit-reset timestamp of a run, queried from the CCDB headers of the run and the orbit-reset object
+  /// \param api is the CCDB API used for the queries, not shared between threads
+  /// \param runNumber is the run number
+  /// \return the orbit-reset timestamp in us
+  int64_t queryOrbitReset(o2::ccdb::CcdbApi& api, int runNumber) const
   {
-    int runNumber = bc.runNumber();
-    // We need to set the orbit-reset timestamp for the run number.
-    // This is done with caching if the run number was already processed before.
-    // If not the orbit-reset timestamp for the run number is queried from CCDB and added to the cache
-    if (runNumber == lastRunNumber) { // The run number coincides to the last run processed
-      LOGF(debug, "Using orbit-reset timestamp from last call");
-    } else if (mapRunToOrbitReset.count(runNumber)) { // The run number was already requested before: getting it from cache!
-      LOGF(debug, "Getting orbit-reset timestamp from cache");
-      orbitResetTimestamp = mapRunToOrbitReset[runNumber];
-    } else { // The run was not requested before: need to acccess CCDB!
-      LOGF(debug, "Getting start-of-run and end-of-run timestamps from CCDB");
-      std::map<std::string, std::string> metadata, headers;
-      const std::string run_path = Form("%s/%i", rct_path.value.data(), runNumber);
-      headers = ccdb_api.retrieveHeaders(run_path, metadata, -1);
-      if (headers.count("SOR") == 0) {
-        LOGF(fatal, "Cannot find start-of-run timestamp for run number in path '%s'.", run_path.data());
+    LOGF(debug, "Getting start-of-run and end-of-run timestamps from CCDB");
+    std::map<std::string, std::string> metadata, headers;
+    const std::string run_path = rct_path.value + "/" + std::to_string(runNumber);
+    headers = api.retrieveHeaders(run_path, metadata, -1);
+    if (headers.count("SOR") == 0) {
+      LOGF(fatal, "Cannot find start-of-run timestamp for run number in path '%s'.", run_path.data());
+    }
+    if (headers.count("EOR") == 0) {
+      LOGF(fatal, "Cannot find end-of-run timestamp for run number in path '%s'.", run_path.data());
+    }
+
+    int64_t sorTimestamp = atol(headers["SOR"].c_str()); // timestamp of the SOR in ms
+    int64_t eorTimestamp = atol(headers["EOR"].c_str()); // timestamp of the EOR in ms
+
+    bool isUnanchoredRun3MC = runNumber >= 300000 && runNumber < 500000;
+    if (isRun2MC || isUnanchoredRun3MC) {
+      // isRun2MC: bc/orbit distributions are not simulated in Run2 MC. All bcs are set to 0.
+      // isUnanchoredRun3MC: assuming orbit-reset is done in the beginning of each run
+      // Setting orbit-reset timestamp to start-of-run timestamp
+      return sorTimestamp * 1000; // from ms to us
+    }
+    int64_t ctpTimestamp = eorTimestamp;
+    if (runNumber < 300000) { // Run 2
+      LOGF(debug, "Getting orbit-reset timestamp using start-of-run timestamp from CCDB");
+      ctpTimestamp = sorTimestamp;
+    } else {
+      // sometimes orbit is reset after SOR. Using EOR timestamps for orbitReset query is more reliable
+      LOGF(debug, "Getting orbit-reset timestamp using end-of-run timestamp from CCDB");
+    }
+    std::unique_ptr<std::vector<Long64_t>> ctp{api.retrieveFromTFileAny<std::vector<Long64_t>>(orbit_reset_path.value, metadata, ctpTimestamp)};
+    if (!ctp) {
+      LOGF(fatal, "Cannot find orbit-reset object in path '%s' for run number %i", orbit_reset_path.value.data(), runNumber);
+    }
+    return (*ctp)[0];
+  }
+
+  /// Scans the BCs of the dataframe and starts the CCDB queries of the runs not in the cache in background threads
+  void prefetchOrbitResets(aod::BCs const& bcs)
+  {
+    int previousRunNumber = lastRunNumber;
+    for (auto const& bc : bcs) {
+      const int runNumber = bc.runNumber();
+      if (runNumber == previousRunNumber) {
+        continue;
       }
-      if (headers.count("EOR") == 0) {
-        LOGF(fatal, "Cannot find end-of-run timestamp for run number in path '%s'.", run_path.data());
+      previousRunNumber = runNumber;
+      if (mapRunToOrbitReset.count(runNumber) || pendingOrbitResets.count(runNumber)) {
+        continue;
       }
+      LOGF(debug, "Prefetching orbit-reset timestamp of run %i", runNumber);
+      pendingOrbitResets.emplace(runNumber, std::async(std::launch::async, [this, runNumber]() {
+                                   o2::ccdb::CcdbApi api;
+                                   api.init(url.value);
+                                   return queryOrbitReset(api, runNumber);
+                                 }));
+    }
+  }
+
+  void process(aod::BCs const& bcs)
+  {
+    timestampTable.reserve(bcs.size());
+    if (prefetch) {
+      prefetchOrbitResets(bcs);
+    }
 
-      int64_t sorTimestamp = atol(headers["SOR"].c_str()); // timestamp of the SOR in ms
-      int64_t eorTimestamp = atol(headers["EOR"].c_str()); // timestamp of the EOR in ms
+    for (auto const& bc : bcs) {
+      int runNumber = bc.runNumber();
+      // We need to set the orbit-reset timestamp for the run number.
+      // This is done with caching if the run number was already processed before.
+      // If not the orbit-reset timestamp for the run number is queried from CCDB and added to the cache
+      if (runNumber == lastRunNumber) { // The run number coincides to the last run processed
+        LOGF(debug, "Using orbit-reset timestamp from last call");
+      } else if (mapRunToOrbitReset.count(runNumber)) { // The run number was already requested before: getting it from cache!
+        LOGF(debug, "Getting orbit-reset timestamp from cache");
+        orbitResetTimestamp = mapRunToOrbitReset[runNumber];
+      } else { // The run was not requested before: need to acccess CCDB!
+        auto pending = pendingOrbitResets.find(runNumber);
+        if (pending != pendingOrbitResets.end()) { // The query was started by the prefetch stage: waiting for it
+          orbitResetTimestamp = pending->second.get();
+          pendingOrbitResets.erase(pending);
+        } else {
+          orbitResetTimestamp = queryOrbitReset(ccdb_api, runNumber);
+        }
 
-      bool isUnanchoredRun3MC = runNumber >= 300000 && runNumber < 500000;
-      if (isRun2MC || isUnanchoredRun3MC) {
-        // isRun2MC: bc/orbit distributions are not simulated in Run2 MC. All bcs are set to 0.
-        // isUnanchoredRun3MC: assuming orbit-reset is done in the beginning of each run
-        // Setting orbit-reset timestamp to start-of-run timestamp
-        orbitResetTimestamp = sorTimestamp * 1000; // from ms to us
-      } else if (runNumber < 300000) {             // Run 2
-        LOGF(debug, "Getting orbit-reset timestamp using start-of-run timestamp from CCDB");
-        auto ctp = ccdb->getForTimeStamp<std::vector<Long64_t>>(orbit_reset_path.value.data(), sorTimestamp);
-        orbitResetTimestamp = (*ctp)[0];
-      } else {
-        // sometimes orbit is reset after SOR. Using EOR timestamps for orbitReset query is more reliable
-        LOGF(debug, "Getting orbit-reset timestamp using end-of-run timestamp from CCDB");
-        auto ctp = ccdb->getForTimeStamp<std::vector<Long64_t>>(orbit_reset_path.value.data(), eorTimestamp);
-        orbitResetTimestamp = (*ctp)[0];
+        // Adding the timestamp to the cache map
+        std::pair<std::map<int, int64_t>::iterator, bool> check;
+        check = mapRunToOrbitReset.insert(std::pair<int, int64_t>(runNumber, orbitResetTimestamp));
+        if (!check.second) {
+          LOGF(fatal, "Run number %i already existed with a orbit-reset timestamp of %llu", runNumber, check.first->second);
+        }
+        LOGF(info, "Add new run number %i with orbit-reset timestamp %llu to cache", runNumber, orbitResetTimestamp);
       }
+      lastRunNumber = runNumber;
 
-      // Adding the timestamp to the cache map
-      std::pair<std::map<int, int64_t>::iterator, bool> check;
-      check = mapRunToOrbitReset.insert(std::pair<int, int64_t>(runNumber, orbitResetTimestamp));
-      if (!check.second) {
-        LOGF(fatal, "Run number %i already existed with a orbit-reset timestamp of %llu", runNumber, check.first->second);
+      if (verbose.value) {
+        LOGF(info, "Orbit-reset timestamp for run number %i found: %llu us", runNumber, orbitResetTimestamp);
       }
-      LOGF(info, "Add new run number %i with orbit-reset timestamp %llu to cache", runNumber, orbitResetTimestamp);
-    }
 
-    if (verbose.value) {
-      LOGF(info, "Orbit-reset timestamp for run number %i found: %llu us", runNumber, orbitResetTimestamp);
+      timestampTable((orbitResetTimestamp + int64_t(bc.globalBC() * o2::constants::lhc::LHCBunchSpacingNS * 1e-3)) / 1000); // us -> ms
     }
-
-    timestampTable((orbitResetTimestamp + int64_t(bc.globalBC() * o2::constants::lhc::LHCBunchSpacingNS * 1e-3)) / 1000); // us -> ms
   }
 };
 
@@ -0,0 +1,40 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+//
+// Task storing the basic kinematics of the tracks, see Common/DataModel/TrackKinematics.h
+//
+
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/runDataProcessing.h"
+#include "Common/DataModel/TrackKinematics.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct TrackKinematics {
+  Produces<aod::TracksKine> tracksKine;
+
+  void process(aod::Tracks const& tracks)
+  {
+    // every dynamic column is evaluated once per track here, the consumers read the stored values
+    tracksKine.reserve(tracks.size());
+    for (auto const& track : tracks) {
+      tracksKine(track.pt(), track.eta(), track.phi(), track.p(), track.px(), track.py(), track.pz());
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<TrackKinematics>(cfgc)};
+}
@@ -19,6 +19,8 @@
 #include "Framework/RunningWorkflowInfo.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/CCDBObjectCache.h"
+#include "Common/Core/TableHelper.h"
 #include "ReconstructionDataFormats/DCA.h"
 #include "DetectorsBase/Propagator.h"
 #include "DetectorsBase/GeometryManager.h"
@@ -31,6 +33,13 @@
 #include "DataFormatsCalibration/MeanVertexObject.h"
 #include "CommonConstants/GeomConstants.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
 // The Run 3 AO2D stores the tracks at the point of innermost update. For a track with ITS this is the innermost (or second innermost)
 // ITS layer. For a track without ITS, this is the TPC inner wall or for loopers in the TPC even a radius beyond that.
 // In order to use the track parameters, the tracks have to be propagated to the collision vertex which is done by this task.
@@ -59,8 +68,8 @@ struct TrackPropagation {
 
   o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
 
-  const o2::dataformats::MeanVertexObject* mVtx = nullptr;
-  o2::parameters::GRPMagField* grpmag = nullptr;
+  o2::common::CCDBObjectHandle<o2::dataformats::MeanVertexObject> mVtx;
+  o2::common::CCDBObjectHandle<o2::parameters::GRPMagField> grpmag;
   o2::base::MatLayerCylSet* lut = nullptr;
 
   Configurable<std::string> ccdburl{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
@@ -68,32 +77,43 @@ struct TrackPropagation {
   Configurable<std::string> geoPath{"geoPath", "GLO/Config/GeometryAligned", "Path of the geometry file"};
   Configurable<std::string> grpmagPath{"grpmagPath", "GLO/Config/GRPMagField", "CCDB path of the GRPMagField object"};
   Configurable<std::string> mVtxPath{"mVtxPath", "GLO/Calib/MeanVertex", "Path of the mean vertex file"};
+  Configurable<std::string> lutSnapshotDir{"lutSnapshotDir", "", "Node-local directory where the material LUT is snapshotted and memory-mapped from by the jobs of the node, empty to disable"};
   Configurable<float> minPropagationRadius{"minPropagationDistance", o2::constants::geom::XTPCInnerRef + 0.1, "Only tracks which are at a smaller radius will be propagated, defaults to TPC inner wall"};
+  Configurable<bool> useBatchedPropagation{"useBatchedPropagation", false, "Unpack the tracks of a dataframe in blocks, propagate each block to per-dataframe cached vertices and fill the output tables in bulk"};
+  Configurable<int> batchSize{"batchSize", 1024, "Number of tracks per block in the batched propagation mode"};
+  Configurable<int> nThreads{"nThreads", 1, "Number of threads propagating a block in the batched propagation mode (output order is preserved)"};
+  Configurable<int> threadChunkSize{"threadChunkSize", 64, "Number of tracks a thread takes at once from a block in the batched propagation mode"};
+
+  // Batched mode: vertices of the current dataframe indexed by collision global index, the last element is the mean vertex
+  std::vector<o2::dataformats::VertexBase> vertexCache;
 
   void init(o2::framework::InitContext& initContext)
   {
     if (doprocessCovariance == true && doprocessStandard == true) {
       LOGF(fatal, "Cannot enable processStandard and processCovariance at the same time. Please choose one.");
     }
+    if (nThreads > 1 && !useBatchedPropagation) {
+      LOGF(warning, "nThreads = %d is only used in the batched propagation mode, tracks will be propagated on a single thread", nThreads.value);
+    }
 
     // Checking if the tables are requested in the workflow and enabling them
-    auto& workflows = initContext.services().get<RunningWorkflowInfo const>();
-    for (DeviceSpec const& device : workflows.devices) {
-      for (auto const& input : device.inputs) {
-        if (input.matcher.binding == "TracksDCA") {
-          fillTracksDCA = true;
-        }
-      }
+    if (isTableRequiredInWorkflow(initContext, "TracksDCA")) {
+      fillTracksDCA = true;
     }
 
     ccdb->setURL(ccdburl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
 
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(lutPath));
+    if (!lutSnapshotDir.value.empty()) {
+      o2::common::CCDBObjectCache::instance().setSnapshotDir(lutSnapshotDir);
+    }
+    lut = o2::common::CCDBObjectCache::instance().getMatLUT(ccdb, lutPath);
     if (!o2::base::GeometryManager::isGeometryLoaded()) {
       ccdb->get<TGeoManager>(geoPath);
     }
+    grpmag.setPath(grpmagPath);
+    mVtx.setPath(mVtxPath);
   }
 
   void initCCDB(aod::BCsWithTimestamps::iterator const& bc)
@@ -101,28 +121,173 @@ struct TrackPropagation {
     if (runNumber == bc.runNumber()) {
       return;
     }
-    grpmag = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(grpmagPath, bc.timestamp());
+    grpmag.update(ccdb, bc);
     LOG(info) << "Setting magnetic field to current " << grpmag->getL3Current() << " A for run " << bc.runNumber() << " from its GRPMagField CCDB object";
-    o2::base::Propagator::initFieldFromGRP(grpmag);
+    o2::base::Propagator::initFieldFromGRP(grpmag.get());
     o2::base::Propagator::Instance()->setMatLUT(lut);
-    mVtx = ccdb->getForTimeStamp<o2::dataformats::MeanVertexObject>(mVtxPath, bc.timestamp());
+    mVtx.update(ccdb, bc);
     runNumber = bc.runNumber();
   }
 
-  template <typename TTrack, typename TTrackPar>
-  void FillTracksPar(TTrack& track, aod::track::TrackTypeEnum trackType, TTrackPar& trackPar)
+  template <typename TTrackPar>
+  void FillTracksPar(int collisionId, aod::track::TrackTypeEnum trackType, TTrackPar& trackPar)
   {
-    tracksParPropagated(track.collisionId(), trackType, trackPar.getX(), trackPar.getAlpha(), trackPar.getY(), trackPar.getZ(), trackPar.getSnp(), trackPar.getTgl(), trackPar.getQ2Pt());
+    tracksParPropagated(collisionId, trackType, trackPar.getX(), trackPar.getAlpha(), trackPar.getY(), trackPar.getZ(), trackPar.getSnp(), trackPar.getTgl(), trackPar.getQ2Pt());
     tracksParExtensionPropagated(trackPar.getPt(), trackPar.getP(), trackPar.getEta(), trackPar.getPhi());
   }
 
-  void processStandard(aod::StoredTracksIU const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const& bcs)
+  void FillTracksCov(o2::track::TrackParCov const& trackParCov)
+  {
+    // TODO do we keep the rho as 0? Also the sigma's are duplicated information
+    tracksParCovPropagated(std::sqrt(trackParCov.getSigmaY2()), std::sqrt(trackParCov.getSigmaZ2()), std::sqrt(trackParCov.getSigmaSnp2()),
+                           std::sqrt(trackParCov.getSigmaTgl2()), std::sqrt(trackParCov.getSigma1Pt2()), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    tracksParCovExtensionPropagated(trackParCov.getSigmaY2(), trackParCov.getSigmaZY(), trackParCov.getSigmaZ2(), trackParCov.getSigmaSnpY(),
+                                    trackParCov.getSigmaSnpZ(), trackParCov.getSigmaSnp2(), trackParCov.getSigmaTglY(), trackParCov.getSigmaTglZ(), trackParCov.getSigmaTglSnp(),
+                                    trackParCov.getSigmaTgl2(), trackParCov.getSigma1PtY(), trackParCov.getSigma1PtZ(), trackParCov.getSigma1PtSnp(), trackParCov.getSigma1PtTgl(),
+                                    trackParCov.getSigma1Pt2());
+  }
+
+  // Fills the vertex cache once per dataframe so that the batched mode does not dereference the collision of every track
+  void fillVertexCache(aod::Collisions const& collisions)
+  {
+    vertexCache.clear();
+    vertexCache.reserve(collisions.size() + 1);
+    for (auto const& collision : collisions) {
+      auto& vtx = vertexCache.emplace_back();
+      vtx.setPos({collision.posX(), collision.posY(), collision.posZ()});
+      vtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
+    }
+    auto& meanVtx = vertexCache.emplace_back();
+    meanVtx.setPos({mVtx->getX(), mVtx->getY(), mVtx->getZ()});
+    meanVtx.setCov(mVtx->getSigmaX() * mVtx->getSigmaX(), 0.0f, mVtx->getSigmaY() * mVtx->getSigmaY(), 0.0f, 0.0f, mVtx->getSigmaZ() * mVtx->getSigmaZ());
+  }
+
+  // Batched propagation: the tracks are unpacked into contiguous blocks of track parameters (stage 1),
+  // the block is propagated in one tight loop against the cached vertices (stage 2) and the output tables,
+  // which are reserved for the full dataframe upfront, are filled in bulk (stage 3). The row order is the one of the input.
+  template <bool withCov, typename TTracks>
+  void propagateBatched(TTracks const& tracks)
+  {
+    using TTrackPar = std::conditional_t<withCov, o2::track::TrackParCov, o2::track::TrackPar>;
+
+    const size_t blockSize = std::max(1, batchSize.value);
+    const size_t chunkSize = std::max(1, threadChunkSize.value);
+    const int meanVertexIndex = vertexCache.size() - 1;
+
+    tracksParPropagated.reserve(tracks.size());
+    tracksParExtensionPropagated.reserve(tracks.size());
+    if (fillTracksDCA) {
+      tracksDCA.reserve(tracks.size());
+    }
+    if constexpr (withCov) {
+      tracksParCovPropagated.reserve(tracks.size());
+      tracksParCovExtensionPropagated.reserve(tracks.size());
+    }
+
+    std::vector<TTrackPar> blockPar;
+    std::vector<int> blockCollisionId;
+    std::vector<aod::track::TrackTypeEnum> blockTrackType;
+    std::vector<std::array<float, 2>> blockDCA;
+    blockPar.reserve(blockSize);
+    blockCollisionId.reserve(blockSize);
+    blockTrackType.reserve(blockSize);
+    blockDCA.reserve(blockSize);
+
+    // Propagates the block entries [first, last); entries are independent so that disjoint ranges can run concurrently
+    auto propagateRange = [&](size_t first, size_t last) {
+      gpu::gpustd::array<float, 2> dcaInfo;
+      o2::dataformats::DCA dcaInfoCov;
+      for (size_t i = first; i < last; i++) {
+        if (blockTrackType[i] != aod::track::Track) {
+          continue;
+        }
+        auto const& vtx = vertexCache[blockCollisionId[i] >= 0 ? blockCollisionId[i] : meanVertexIndex];
+        if constexpr (withCov) {
+          dcaInfoCov.set(999, 999, 999, 999, 999);
+          o2::base::Propagator::Instance()->propagateToDCABxByBz(vtx, blockPar[i], 2.f, matCorr, &dcaInfoCov);
+          blockDCA[i] = {dcaInfoCov.getY(), dcaInfoCov.getZ()};
+        } else {
+          dcaInfo[0] = 999;
+          dcaInfo[1] = 999;
+          o2::base::Propagator::Instance()->propagateToDCABxByBz(vtx.getXYZ(), blockPar[i], 2.f, matCorr, &dcaInfo);
+          blockDCA[i] = {dcaInfo[0], dcaInfo[1]};
+        }
+      }
+    };
+
+    auto flushBlock = [&]() {
+      const size_t nWorkers = std::min<size_t>(std::max(1, nThreads.value), (blockPar.size() + chunkSize - 1) / chunkSize);
+      if (nWorkers <= 1) {
+        propagateRange(0, blockPar.size());
+      } else {
+        // Workers pull chunks from a shared counter, so that faster threads pick up the remaining work.
+        // Each chunk writes only to its own slice of the block, the filling below keeps the input order.
+        std::atomic<size_t> nextChunk{0};
+        auto worker = [&]() {
+          for (size_t first = nextChunk.fetch_add(chunkSize); first < blockPar.size(); first = nextChunk.fetch_add(chunkSize)) {
+            propagateRange(first, std::min(first + chunkSize, blockPar.size()));
+          }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(nWorkers - 1);
+        for (size_t iWorker = 1; iWorker < nWorkers; iWorker++) {
+          workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers) {
+          thread.join();
+        }
+      }
+      for (size_t i = 0; i < blockPar.size(); i++) {
+        FillTracksPar(blockCollisionId[i], blockTrackType[i], blockPar[i]);
+        if (fillTracksDCA) {
+          tracksDCA(blockDCA[i][0], blockDCA[i][1]);
+        }
+        if constexpr (withCov) {
+          FillTracksCov(blockPar[i]);
+        }
+      }
+      blockPar.clear();
+      blockCollisionId.clear();
+      blockTrackType.clear();
+      blockDCA.clear();
+    };
+
+    for (auto const& track : tracks) {
+      if constexpr (withCov) {
+        blockPar.emplace_back(getTrackParCov(track));
+      } else {
+        blockPar.emplace_back(getTrackPar(track));
+      }
+      blockCollisionId.emplace_back(track.collisionId());
+      // Only propagate tracks which have passed the innermost wall of the TPC (e.g. skipping loopers etc). Others fill unpropagated.
+      // Tracks to be propagated are marked with their final type already here.
+      if (track.trackType() == aod::track::TrackIU && track.x() < minPropagationRadius) {
+        blockTrackType.emplace_back(aod::track::Track);
+      } else {
+        blockTrackType.emplace_back((aod::track::TrackTypeEnum)track.trackType());
+      }
+      blockDCA.push_back({999.f, 999.f});
+      if (blockPar.size() == blockSize) {
+        flushBlock();
+      }
+    }
+    flushBlock();
+  }
+
+  void processStandard(aod::StoredTracksIU const& tracks, aod::Collisions const& collisions, aod::BCsWithTimestamps const& bcs)
   {
     if (bcs.size() == 0) {
       return;
     }
     initCCDB(bcs.begin());
 
+    if (useBatchedPropagation) {
+      fillVertexCache(collisions);
+      propagateBatched<false>(tracks);
+      return;
+    }
+
     gpu::gpustd::array<float, 2> dcaInfo;
 
     for (auto& track : tracks) {
@@ -140,7 +305,7 @@ struct TrackPropagation {
         }
         trackType = aod::track::Track;
       }
-      FillTracksPar(track, trackType, trackPar);
+      FillTracksPar(track.collisionId(), trackType, trackPar);
       if (fillTracksDCA) {
         tracksDCA(dcaInfo[0], dcaInfo[1]);
       }
@@ -148,13 +313,19 @@ struct TrackPropagation {
   }
   PROCESS_SWITCH(TrackPropagation, processStandard, "Process without covariance", true);
 
-  void processCovariance(soa::Join<aod::StoredTracksIU, aod::TracksCovIU> const& tracks, aod::Collisions const&, aod::BCsWithTimestamps const& bcs)
+  void processCovariance(soa::Join<aod::StoredTracksIU, aod::TracksCovIU> const& tracks, aod::Collisions const& collisions, aod::BCsWithTimestamps const& bcs)
   {
     if (bcs.size() == 0) {
       return;
     }
     initCCDB(bcs.begin());
 
+    if (useBatchedPropagation) {
+      fillVertexCache(collisions);
+      propagateBatched<true>(tracks);
+      return;
+    }
+
     o2::dataformats::DCA dcaInfoCov;
     o2::dataformats::VertexBase vtx;
 
@@ -176,17 +347,11 @@ struct TrackPropagation {
         }
         trackType = aod::track::Track;
       }
-      FillTracksPar(track, trackType, trackParCov);
+      FillTracksPar(track.collisionId(), trackType, trackParCov);
       if (fillTracksDCA) {
         tracksDCA(dcaInfoCov.getY(), dcaInfoCov.getZ());
       }
-      // TODO do we keep the rho as 0? Also the sigma's are duplicated information
-      tracksParCovPropagated(std::sqrt(trackParCov.getSigmaY2()), std::sqrt(trackParCov.getSigmaZ2()), std::sqrt(trackParCov.getSigmaSnp2()),
-                             std::sqrt(trackParCov.getSigmaTgl2()), std::sqrt(trackParCov.getSigma1Pt2()), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
-      tracksParCovExtensionPropagated(trackParCov.getSigmaY2(), trackParCov.getSigmaZY(), trackParCov.getSigmaZ2(), trackParCov.getSigmaSnpY(),
-                                      trackParCov.getSigmaSnpZ(), trackParCov.getSigmaSnp2(), trackParCov.getSigmaTglY(), trackParCov.getSigmaTglZ(), trackParCov.getSigmaTglSnp(),
-                                      trackParCov.getSigmaTgl2(), trackParCov.getSigma1PtY(), trackParCov.getSigma1PtZ(), trackParCov.getSigma1PtSnp(), trackParCov.getSigma1PtTgl(),
-                                      trackParCov.getSigma1Pt2());
+      FillTracksCov(trackParCov);
     }
   }
   PROCESS_SWITCH(TrackPropagation, processCovariance, "Process with covariance", false);
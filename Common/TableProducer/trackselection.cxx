@@ -97,6 +97,7 @@ struct TrackSelectionTask {
 
   void process(soa::Join<aod::FullTracks, aod::TracksDCA> const& tracks)
   {
+    filterTable.reserve(tracks.size());
     if (isRun3) {
       for (auto& track : tracks) {
         filterTable((uint8_t)0,
@@ -11,6 +11,7 @@
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
+#include "Common/Core/TableHelper.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -18,16 +19,24 @@ using namespace o2::framework;
 // Converts V0 and cascade version 000 to 001
 // Build indices to group V0s and cascades to collisions
 
+// The track indices and the collision index of the tracks are copied as whole columns from the Arrow buffers,
+// the collision of each decay is then gathered from the flat arrays instead of one track iterator per daughter
+
 struct WeakDecayIndicesV0 {
   Produces<aod::V0s_001> v0s_001;
 
   void process(aod::V0s_000 const& v0s, aod::Tracks const& tracks)
   {
-    for (auto& v0 : v0s) {
-      if (v0.posTrack().collisionId() != v0.negTrack().collisionId()) {
-        LOGF(fatal, "V0 %d has inconsistent collision information (%d, %d)", v0.globalIndex(), v0.posTrack().collisionId(), v0.negTrack().collisionId());
+    const auto trackCollisionIds = getColumnValues<aod::track::CollisionId>(tracks);
+    const auto posTrackIds = getColumnValues<aod::v0::PosTrackId>(v0s);
+    const auto negTrackIds = getColumnValues<aod::v0::NegTrackId>(v0s);
+    for (std::size_t i = 0; i < posTrackIds.size(); i++) {
+      const auto posCollisionId = trackCollisionIds[posTrackIds[i]];
+      const auto negCollisionId = trackCollisionIds[negTrackIds[i]];
+      if (posCollisionId != negCollisionId) {
+        LOGF(fatal, "V0 %d has inconsistent collision information (%d, %d)", (int)i, posCollisionId, negCollisionId);
       }
-      v0s_001(v0.posTrack().collisionId(), v0.posTrackId(), v0.negTrackId());
+      v0s_001(posCollisionId, posTrackIds[i], negTrackIds[i]);
     }
   }
 };
@@ -38,12 +47,20 @@ struct WeakDecayIndicesCascades {
 
   void process(aod::V0s const& v0s, aod::Cascades_000 const& cascades, aod::Tracks const& tracks)
   {
-    for (auto& cascade : cascades) {
-      if (cascade.bachelor().collisionId() != cascade.v0().posTrack().collisionId() || cascade.v0().posTrack().collisionId() != cascade.v0().negTrack().collisionId()) {
-        LOGF(fatal, "Cascade %d has inconsistent collision information (%d, %d, %d) track ids %d %d %d", cascade.globalIndex(), cascade.bachelor().collisionId(),
-             cascade.v0().posTrack().collisionId(), cascade.v0().negTrack().collisionId(), cascade.bachelorId(), cascade.v0().posTrackId(), cascade.v0().negTrackId());
+    const auto trackCollisionIds = getColumnValues<aod::track::CollisionId>(tracks);
+    const auto posTrackIds = getColumnValues<aod::v0::PosTrackId>(v0s);
+    const auto negTrackIds = getColumnValues<aod::v0::NegTrackId>(v0s);
+    const auto v0Ids = getColumnValues<aod::cascade::V0Id>(cascades);
+    const auto bachelorIds = getColumnValues<aod::cascade::BachelorId>(cascades);
+    for (std::size_t i = 0; i < v0Ids.size(); i++) {
+      const auto bachelorCollisionId = trackCollisionIds[bachelorIds[i]];
+      const auto posCollisionId = trackCollisionIds[posTrackIds[v0Ids[i]]];
+      const auto negCollisionId = trackCollisionIds[negTrackIds[v0Ids[i]]];
+      if (bachelorCollisionId != posCollisionId || posCollisionId != negCollisionId) {
+        LOGF(fatal, "Cascade %d has inconsistent collision information (%d, %d, %d) track ids %d %d %d", (int)i, bachelorCollisionId,
+             posCollisionId, negCollisionId, bachelorIds[i], posTrackIds[v0Ids[i]], negTrackIds[v0Ids[i]]);
       }
-      cascades_001(cascade.bachelor().collisionId(), cascade.v0Id(), cascade.bachelorId());
+      cascades_001(bachelorCollisionId, v0Ids[i], bachelorIds[i]);
     }
   }
 };
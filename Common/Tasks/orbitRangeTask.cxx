@@ -22,12 +22,22 @@ using namespace o2::framework;
 
 struct OrbitRangeTask {
   OutputObj<OrbitRange> orbitRange{OrbitRange("orbitRange")};
-  void process(aod::BC const& bc)
+  void process(aod::BCs const& bcs)
   {
-    uint32_t orbit = bc.globalBC() / o2::constants::lhc::LHCMaxBunches;
-    orbitRange->SetRunNumber(bc.runNumber());
-    orbitRange->SetMinOrbit(TMath::Min(orbit, orbitRange->GetMinOrbit()));
-    orbitRange->SetMaxOrbit(TMath::Max(orbit, orbitRange->GetMaxOrbit()));
+    // the range of the dataframe is found in one loop, the output object is updated once
+    if (bcs.size() == 0) {
+      return;
+    }
+    uint32_t minOrbit = orbitRange->GetMinOrbit();
+    uint32_t maxOrbit = orbitRange->GetMaxOrbit();
+    for (auto const& bc : bcs) {
+      uint32_t orbit = bc.globalBC() / o2::constants::lhc::LHCMaxBunches;
+      minOrbit = TMath::Min(orbit, minOrbit);
+      maxOrbit = TMath::Max(orbit, maxOrbit);
+    }
+    orbitRange->SetRunNumber(bcs.begin().runNumber());
+    orbitRange->SetMinOrbit(minOrbit);
+    orbitRange->SetMaxOrbit(maxOrbit);
   }
 };
 
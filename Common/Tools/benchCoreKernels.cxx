@@ -0,0 +1,228 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   benchCoreKernels.cxx
+/// \brief  Micro-benchmarks of the Common/Core helpers called per track or per track pair
+///         The kernels run on synthetic events with the multiplicity of pp and Pb-Pb collisions. Each kernel is
+///         repeated until it has run for at least the given time and its throughput is printed in tracks (or
+///         pairs) per second. The generator is seeded, so the numbers of two builds can be compared.
+///         Usage: o2-bench-analysis-core-kernels [min time per kernel in s] [seed]
+///
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/Core/RecoDecay.h"
+#include "Common/Core/TrackSelection.h"
+#include "Common/Core/TrackSelectionDefaults.h"
+#include "Common/Core/PID/TPCPIDResponse.h"
+
+namespace
+{
+
+/// Track with the columns read by the benchmarked kernels
+struct BenchTrack {
+  float ptValue, etaValue, phiValue, tglValue, signed1PtValue, dcaXYValue, dcaZValue;
+  float tpcInnerParamValue, tpcSignalValue, tpcCrossedRowsOverFindableClsValue, tpcChi2NClValue, itsChi2NClValue;
+  int16_t tpcNClsFoundValue, tpcNClsCrossedRowsValue;
+  uint8_t itsNClsValue, itsClusterMapValue;
+  uint32_t flagsValue;
+  std::array<float, 3> pVecValue;
+
+  float pt() const { return ptValue; }
+  float eta() const { return etaValue; }
+  float phi() const { return phiValue; }
+  float tgl() const { return tglValue; }
+  float signed1Pt() const { return signed1PtValue; }
+  float dcaXY() const { return dcaXYValue; }
+  float dcaZ() const { return dcaZValue; }
+  float tpcInnerParam() const { return tpcInnerParamValue; }
+  float tpcSignal() const { return tpcSignalValue; }
+  float tpcCrossedRowsOverFindableCls() const { return tpcCrossedRowsOverFindableClsValue; }
+  float tpcChi2NCl() const { return tpcChi2NClValue; }
+  float itsChi2NCl() const { return itsChi2NClValue; }
+  int16_t tpcNClsFound() const { return tpcNClsFoundValue; }
+  int16_t tpcNClsCrossedRows() const { return tpcNClsCrossedRowsValue; }
+  uint8_t itsNCls() const { return itsNClsValue; }
+  uint8_t itsClusterMap() const { return itsClusterMapValue; }
+  uint32_t flags() const { return flagsValue; }
+  uint8_t trackType() const { return o2::aod::track::Track; }
+  bool hasTPC() const { return tpcNClsFoundValue > 0; }
+  bool hasITS() const { return itsNClsValue > 0; }
+};
+
+struct BenchCollision {
+  float multTPCValue;
+  float multTPC() const { return multTPCValue; }
+};
+
+struct BenchEvent {
+  BenchCollision collision;
+  std::vector<BenchTrack> tracks;
+};
+
+/// Events with a Poisson number of tracks, exponential pT spectrum and uniform eta and phi in the barrel
+std::vector<BenchEvent> generateEvents(int nEvents, double meanMultiplicity, std::mt19937_64& rng)
+{
+  std::poisson_distribution<int> multiplicity(meanMultiplicity);
+  std::exponential_distribution<float> ptSpectrum(2.f);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  std::vector<BenchEvent> events(nEvents);
+  for (auto& event : events) {
+    const int nTracks = multiplicity(rng);
+    event.collision.multTPCValue = 2.f * nTracks;
+    event.tracks.resize(nTracks);
+    for (auto& t : event.tracks) {
+      t.ptValue = 0.1f + ptSpectrum(rng);
+      t.etaValue = -1.f + 2.f * uniform(rng);
+      t.phiValue = 2.f * static_cast<float>(M_PI) * uniform(rng);
+      t.tglValue = std::sinh(t.etaValue);
+      t.signed1PtValue = (uniform(rng) < 0.5f ? -1.f : 1.f) / t.ptValue;
+      t.dcaXYValue = 0.01f * gauss(rng);
+      t.dcaZValue = 0.02f * gauss(rng);
+      t.tpcInnerParamValue = t.ptValue * std::cosh(t.etaValue);
+      t.tpcSignalValue = 50.f * (1.f + 0.07f * gauss(rng)) * (1.f + 1.f / (t.tpcInnerParamValue * t.tpcInnerParamValue));
+      t.tpcNClsFoundValue = 60 + static_cast<int16_t>(99 * uniform(rng));
+      t.tpcNClsCrossedRowsValue = t.tpcNClsFoundValue + static_cast<int16_t>(5 * uniform(rng));
+      t.tpcCrossedRowsOverFindableClsValue = 0.7f + 0.4f * uniform(rng);
+      t.tpcChi2NClValue = 4.f * uniform(rng);
+      t.itsNClsValue = static_cast<uint8_t>(7 * uniform(rng));
+      t.itsClusterMapValue = static_cast<uint8_t>((1u << t.itsNClsValue) - 1u);
+      t.itsChi2NClValue = 36.f * uniform(rng);
+      t.flagsValue = 0;
+      t.pVecValue = {t.ptValue * std::cos(t.phiValue), t.ptValue * std::sin(t.phiValue), t.ptValue * t.tglValue};
+    }
+  }
+  return events;
+}
+
+/// Runs kernel, which processes nItems items per call, until minTime seconds have passed and prints the throughput
+void runBenchmark(std::string const& name, double minTime, double nItems, std::function<double()> const& kernel)
+{
+  using Clock = std::chrono::steady_clock;
+  double sink = 0.;
+  long nCalls = 0;
+  const auto start = Clock::now();
+  double elapsed = 0.;
+  do {
+    sink += kernel();
+    nCalls++;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < minTime);
+  const double items = nItems * nCalls;
+  std::printf("%-45s %12.3g items/s %10.2f ns/item   (checksum %g)\n", name.c_str(), items / elapsed, 1.e9 * elapsed / items, sink);
+}
+
+void benchmarkSystem(std::string const& system, std::vector<BenchEvent> const& events, double minTime)
+{
+  double nTracks = 0.;
+  double nPairs = 0.;
+  for (const auto& event : events) {
+    nTracks += event.tracks.size();
+    nPairs += 0.5 * event.tracks.size() * (event.tracks.size() - 1.);
+  }
+  std::printf("%s: %zu events, %.0f tracks, %.0f pairs\n", system.c_str(), events.size(), nTracks, nPairs);
+
+  TrackSelection selection = getGlobalTrackSelection();
+  runBenchmark(system + " TrackSelection::IsSelected", minTime, nTracks, [&]() {
+    double n = 0.;
+    for (const auto& event : events) {
+      for (const auto& track : event.tracks) {
+        n += selection.IsSelected(track);
+      }
+    }
+    return n;
+  });
+  runBenchmark(system + " TrackSelection::IsSelectedMask", minTime, nTracks, [&]() {
+    double n = 0.;
+    for (const auto& event : events) {
+      for (const auto& track : event.tracks) {
+        n += selection.IsSelectedMask(track);
+      }
+    }
+    return n;
+  });
+
+  o2::pid::tpc::Response response;
+  runBenchmark(system + " tpc::Response::GetNumberOfSigma (pion)", minTime, nTracks, [&]() {
+    double sum = 0.;
+    for (const auto& event : events) {
+      for (const auto& track : event.tracks) {
+        sum += response.GetNumberOfSigma(event.collision, track, o2::track::PID::Pion);
+      }
+    }
+    return sum;
+  });
+  o2::pid::tpc::Response::TrackBatch batch;
+  std::vector<float> nSigma;
+  runBenchmark(system + " tpc::Response::GetNumberOfSigma batch (pion)", minTime, nTracks, [&]() {
+    double sum = 0.;
+    for (const auto& event : events) {
+      batch.clear();
+      batch.reserve(event.tracks.size());
+      for (const auto& track : event.tracks) {
+        batch.push_back(track, event.collision.multTPC());
+      }
+      nSigma.resize(event.tracks.size());
+      response.GetNumberOfSigma(batch, o2::track::PID::Pion, nSigma.data());
+      for (const float value : nSigma) {
+        sum += value;
+      }
+    }
+    return sum;
+  });
+
+  runBenchmark(system + " RecoDecay::eta, phi, pt", minTime, nTracks, [&]() {
+    double sum = 0.;
+    for (const auto& event : events) {
+      for (const auto& track : event.tracks) {
+        sum += RecoDecay::eta(track.pVecValue) + RecoDecay::phi(track.pVecValue) + RecoDecay::pt(track.pVecValue);
+      }
+    }
+    return sum;
+  });
+  const std::array<double, 2> massesPiK{o2::track::pid_constants::sMasses[o2::track::PID::Pion], o2::track::pid_constants::sMasses[o2::track::PID::Kaon]};
+  runBenchmark(system + " RecoDecay::m of the track pairs", minTime, nPairs, [&]() {
+    double sum = 0.;
+    for (const auto& event : events) {
+      const auto& tracks = event.tracks;
+      for (std::size_t i = 0; i < tracks.size(); i++) {
+        for (std::size_t j = i + 1; j < tracks.size(); j++) {
+          sum += RecoDecay::m(std::array{tracks[i].pVecValue, tracks[j].pVecValue}, massesPiK);
+        }
+      }
+    }
+    return sum;
+  });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const double minTime = argc > 1 ? std::atof(argv[1]) : 0.5;
+  const unsigned long seed = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+  std::mt19937_64 rng(seed);
+
+  // pp with the charged particle multiplicity of minimum bias events at 13.6 TeV, Pb-Pb in the 0-10% class
+  benchmarkSystem("pp", generateEvents(10000, 15., rng), minTime);
+  benchmarkSystem("Pb-Pb", generateEvents(20, 2500., rng), minTime);
+  return 0;
+}
@@ -0,0 +1,208 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   skimSampling.h
+/// \brief  Sampling of the tracks and events written by the DPG skim producers
+///         SkimRandom is a small xoshiro256+ generator, cheap enough to be called per track and owned by the task
+///         instead of a heap allocated TRandom3 or the global rand(). TsallisDownsampler flattens the pT spectrum
+///         of a species with the Tsallis/Hagedorn fit of the charged particle spectra. BinnedReservoir keeps a
+///         uniform random subset of at most a given number of candidates per (pT, eta) bin, e.g. per collision,
+///         so that the skims are not dominated by the most populated bins.
+///
+
+#ifndef DPG_CORE_SKIMSAMPLING_H_
+#define DPG_CORE_SKIMSAMPLING_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace o2::dpg
+{
+
+/// xoshiro256+ pseudo random number generator, see https://prng.di.unimi.it
+class SkimRandom
+{
+ public:
+  explicit SkimRandom(uint64_t seed = 0) { setSeed(seed); }
+
+  /// Seeds the state with splitmix64, a seed of 0 takes a random seed
+  void setSeed(uint64_t seed)
+  {
+    if (seed == 0) {
+      std::random_device device;
+      seed = (static_cast<uint64_t>(device()) << 32) | device();
+    }
+    for (uint64_t& s : mState) {
+      seed += 0x9e3779b97f4a7c15ULL;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t next()
+  {
+    const uint64_t result = mState[0] + mState[3];
+    const uint64_t t = mState[1] << 17;
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= t;
+    mState[3] = (mState[3] << 45) | (mState[3] >> 19);
+    return result;
+  }
+
+  /// Uniform number in [0, 1)
+  double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+  /// Uniform integer in [0, n), with the multiply-shift reduction of the 64 bit output
+  uint64_t below(uint64_t n) { return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * n) >> 64); }
+
+  /// True with probability fraction, without drawing a number if fraction >= 1
+  bool keep(double fraction) { return fraction >= 1. || uniform() < fraction; }
+
+ private:
+  std::array<uint64_t, 4> mState{};
+};
+
+/// Random downsampling with the Tsallis/Hagedorn fit of the charged particle spectra (sqrt(s) = 62.4 GeV to 13 TeV)
+/// as in https://iopscience.iop.org/article/10.1088/2399-6528/aab00f/pdf
+/// A particle is kept if u * w(pT) < factor, with u uniform in [0, 1) and w(pT) = pT^3 f(pT) / f(1 GeV/c), which
+/// flattens the pT spectrum above the pT where w(pT) = factor
+class TsallisDownsampler
+{
+ public:
+  /// Sets the fit parameters for sqrts in GeV and the particle mass, the constants of w are computed once here
+  void init(double factor, double sqrts, double mass)
+  {
+    const double a = 6.81, b = 59.24;
+    const double c = 0.082, d = 0.151;
+    mFactor = factor;
+    mMass2 = mass * mass;
+    mN = a + b / sqrts;
+    mP0 = mN * (c + d / sqrts);
+    mNorm = 1. + std::sqrt(mMass2 + 1.) / mP0;
+  }
+
+  double factor() const { return mFactor; }
+
+  /// w(pT), the inverse of the relative probability to keep a particle
+  double weight(double pt) const
+  {
+    const double mt = std::sqrt(mMass2 + pt * pt);
+    return std::pow((1. + mt / mP0) / mNorm, -mN) * pt * pt * pt;
+  }
+
+  bool accept(double pt, SkimRandom& rng) const { return rng.uniform() * weight(pt) < mFactor; }
+
+ private:
+  double mFactor = -1.; ///< downsampling factor
+  double mMass2 = 0.;   ///< squared mass
+  double mN = 0.;       ///< Tsallis exponent
+  double mP0 = 0.;      ///< Tsallis n * T
+  double mNorm = 1.;    ///< 1 + mT(1 GeV/c) / p0
+};
+
+/// Reservoir sampling of at most a fixed number of candidates per (pT, eta) bin, the candidates outside the edges
+/// are sampled in the underflow and overflow bins of each axis
+template <typename T>
+class BinnedReservoir
+{
+ public:
+  /// Sets the bin edges and the number of candidates kept per bin, a capacity <= 0 disables the sampling
+  void init(std::vector<double> const& ptEdges, std::vector<double> const& etaEdges, int capacity)
+  {
+    mPtEdges = ptEdges;
+    mEtaEdges = etaEdges;
+    mCapacity = std::max(capacity, 0);
+    const std::size_t nBins = (mPtEdges.size() + 1) * (mEtaEdges.size() + 1);
+    mItems.resize(mCapacity > 0 ? nBins * mCapacity : 0);
+    mSeen.assign(mCapacity > 0 ? nBins : 0, 0);
+    mFilled.clear();
+  }
+
+  bool isEnabled() const { return mCapacity > 0; }
+
+  /// Offers a candidate, it replaces a random one of its bin once the bin is full (Algorithm R)
+  void add(double pt, double eta, T const& item, SkimRandom& rng)
+  {
+    const std::size_t bin = findBin(pt, eta);
+    const int64_t seen = mSeen[bin]++;
+    if (seen == 0) {
+      mFilled.push_back(bin);
+    }
+    if (seen < mCapacity) {
+      mItems[bin * mCapacity + seen] = item;
+      return;
+    }
+    const uint64_t slot = rng.below(seen + 1);
+    if (slot < static_cast<uint64_t>(mCapacity)) {
+      mItems[bin * mCapacity + slot] = item;
+    }
+  }
+
+  /// Number of candidates kept
+  std::size_t size() const
+  {
+    std::size_t n = 0;
+    for (const std::size_t bin : mFilled) {
+      n += std::min<int64_t>(mSeen[bin], mCapacity);
+    }
+    return n;
+  }
+
+  /// Calls f on the kept candidates, in the order of the first candidate of their bin
+  template <typename F>
+  void forEach(F&& f) const
+  {
+    for (const std::size_t bin : mFilled) {
+      const int64_t n = std::min<int64_t>(mSeen[bin], mCapacity);
+      for (int64_t i = 0; i < n; i++) {
+        f(mItems[bin * mCapacity + i]);
+      }
+    }
+  }
+
+  /// Empties the bins, e.g. at the start of a collision
+  void reset()
+  {
+    for (const std::size_t bin : mFilled) {
+      mSeen[bin] = 0;
+    }
+    mFilled.clear();
+  }
+
+ private:
+  std::size_t findBin(double pt, double eta) const
+  {
+    const std::size_t iPt = std::distance(mPtEdges.begin(), std::upper_bound(mPtEdges.begin(), mPtEdges.end(), pt));
+    const std::size_t iEta = std::distance(mEtaEdges.begin(), std::upper_bound(mEtaEdges.begin(), mEtaEdges.end(), eta));
+    return iPt * (mEtaEdges.size() + 1) + iEta;
+  }
+
+  std::vector<double> mPtEdges;     ///< pT bin edges
+  std::vector<double> mEtaEdges;    ///< eta bin edges
+  int64_t mCapacity = 0;            ///< candidates kept per bin
+  std::vector<T> mItems;            ///< kept candidates, mCapacity per bin
+  std::vector<int64_t> mSeen;       ///< candidates offered per bin
+  std::vector<std::size_t> mFilled; ///< bins with at least one candidate
+};
+
+} // namespace o2::dpg
+
+#endif // DPG_CORE_SKIMSAMPLING_H_
@@ -182,19 +182,26 @@ struct tofPidQa {
     bool enableFullHistos = false;
     int enabledProcesses = 0;
     switch (id) { // Skipping disabled particles
-#define particleCase(particleId)                                 \
-  case PID::particleId:                                          \
-    if (!doprocess##particleId && !doprocessFull##particleId) {  \
-      return;                                                    \
-    }                                                            \
-    if (doprocess##particleId) {                                 \
-      enabledProcesses++;                                        \
-    }                                                            \
-    if (doprocessFull##particleId) {                             \
-      enableFullHistos = true;                                   \
-      enabledProcesses++;                                        \
-    }                                                            \
-    LOGF(info, "Enabled TOF QA for %s %s", #particleId, pT[id]); \
+#define particleCase(particleId)                                                                      \
+  case PID::particleId:                                                                               \
+    if (!doprocess##particleId && !doprocessFull##particleId && !doprocessAll && !doprocessFullAll) { \
+      return;                                                                                         \
+    }                                                                                                 \
+    if (doprocess##particleId) {                                                                      \
+      enabledProcesses++;                                                                             \
+    }                                                                                                 \
+    if (doprocessFull##particleId) {                                                                  \
+      enableFullHistos = true;                                                                        \
+      enabledProcesses++;                                                                             \
+    }                                                                                                 \
+    if (doprocessAll) {                                                                               \
+      enabledProcesses++;                                                                             \
+    }                                                                                                 \
+    if (doprocessFullAll) {                                                                           \
+      enableFullHistos = true;                                                                        \
+      enabledProcesses++;                                                                             \
+    }                                                                                                 \
+    LOGF(info, "Enabled TOF QA for %s %s", #particleId, pT[id]);                                      \
     break;
 
       particleCase(Electron);
@@ -504,117 +511,135 @@ struct tofPidQa {
     }
   }
 
+  /// Fills the histograms of the particle hypothesis id for a selected track
   template <o2::track::PID::ID id, bool fillFullHistograms,
             typename TrackType>
-  void processSingleParticle(CollisionCandidate const& collision,
-                             TrackType const& tracks)
+  void fillParticleHistograms(TrackType const& t)
   {
-    if (!isEventSelected<false>(collision, tracks)) {
-      return;
-    }
-
-    for (auto t : tracks) {
-      if (!isTrackSelected<false>(collision, t)) {
-        continue;
+    if (applyRapidityCut) {
+      if (abs(t.rapidity(PID::getMass(id))) > 0.5) {
+        return;
       }
+    }
 
-      if (applyRapidityCut) {
-        if (abs(t.rapidity(PID::getMass(id))) > 0.5) {
-          continue;
+    const auto nsigma = o2::aod::pidutils::tofNSigma<id>(t);
+    histos.fill(HIST(hnsigma[id]), t.p(), nsigma);
+    histos.fill(HIST(hnsigma_pt[id]), t.pt(), nsigma);
+    if (t.sign() > 0) {
+      histos.fill(HIST(hnsigma_pt_pos[id]), t.pt(), nsigma);
+    } else {
+      histos.fill(HIST(hnsigma_pt_neg[id]), t.pt(), nsigma);
+    }
+    // Filling info split per ev. time
+    if (enableEvTimeSplitting) {
+      if (t.isEvTimeTOF() && t.isEvTimeT0AC()) { // TOF + FT0 Ev. Time
+        histos.fill(HIST(hnsigma_evtime_tofft0[id]), t.p(), nsigma);
+        histos.fill(HIST(hnsigma_pt_evtime_tofft0[id]), t.pt(), nsigma);
+        if (t.sign() > 0) {
+          histos.fill(HIST(hnsigma_pt_pos_evtime_tofft0[id]), t.pt(), nsigma);
+        } else {
+          histos.fill(HIST(hnsigma_pt_neg_evtime_tofft0[id]), t.pt(), nsigma);
+        }
+      } else if (t.isEvTimeT0AC()) { // FT0 Ev. Time
+        histos.fill(HIST(hnsigma_evtime_ft0[id]), t.p(), nsigma);
+        histos.fill(HIST(hnsigma_pt_evtime_ft0[id]), t.pt(), nsigma);
+        if (t.sign() > 0) {
+          histos.fill(HIST(hnsigma_pt_pos_evtime_ft0[id]), t.pt(), nsigma);
+        } else {
+          histos.fill(HIST(hnsigma_pt_neg_evtime_ft0[id]), t.pt(), nsigma);
+        }
+      } else if (t.isEvTimeTOF()) { // TOF Ev. Time
+        histos.fill(HIST(hnsigma_evtime_tof[id]), t.p(), nsigma);
+        histos.fill(HIST(hnsigma_pt_evtime_tof[id]), t.pt(), nsigma);
+        if (t.sign() > 0) {
+          histos.fill(HIST(hnsigma_pt_pos_evtime_tof[id]), t.pt(), nsigma);
+        } else {
+          histos.fill(HIST(hnsigma_pt_neg_evtime_tof[id]), t.pt(), nsigma);
+        }
+      } else { // No Ev. Time -> Fill Ev. Time
+        histos.fill(HIST(hnsigma_evtime_fill[id]), t.p(), nsigma);
+        histos.fill(HIST(hnsigma_pt_evtime_fill[id]), t.pt(), nsigma);
+        if (t.sign() > 0) {
+          histos.fill(HIST(hnsigma_pt_pos_evtime_fill[id]), t.pt(), nsigma);
+        } else {
+          histos.fill(HIST(hnsigma_pt_neg_evtime_fill[id]), t.pt(), nsigma);
         }
       }
-
-      const auto nsigma = o2::aod::pidutils::tofNSigma<id>(t);
-      histos.fill(HIST(hnsigma[id]), t.p(), nsigma);
-      histos.fill(HIST(hnsigma_pt[id]), t.pt(), nsigma);
+    }
+    if constexpr (fillFullHistograms) {
+      const float tof = t.tofSignal() - t.tofEvTime();
+      const auto diff = o2::aod::pidutils::tofExpSignalDiff<id>(t);
+      histos.fill(HIST(hexpected[id]), t.p(), tof - diff);
+      histos.fill(HIST(hdelta[id]), t.p(), diff);
       if (t.sign() > 0) {
-        histos.fill(HIST(hnsigma_pt_pos[id]), t.pt(), nsigma);
+        histos.fill(HIST(hdelta_pt_pos[id]), t.p(), diff);
       } else {
-        histos.fill(HIST(hnsigma_pt_neg[id]), t.pt(), nsigma);
+        histos.fill(HIST(hdelta_pt_neg[id]), t.p(), diff);
       }
       // Filling info split per ev. time
       if (enableEvTimeSplitting) {
         if (t.isEvTimeTOF() && t.isEvTimeT0AC()) { // TOF + FT0 Ev. Time
-          histos.fill(HIST(hnsigma_evtime_tofft0[id]), t.p(), nsigma);
-          histos.fill(HIST(hnsigma_pt_evtime_tofft0[id]), t.pt(), nsigma);
+          histos.fill(HIST(hdelta_evtime_tofft0[id]), t.p(), diff);
           if (t.sign() > 0) {
-            histos.fill(HIST(hnsigma_pt_pos_evtime_tofft0[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_pos_evtime_tofft0[id]), t.p(), diff);
           } else {
-            histos.fill(HIST(hnsigma_pt_neg_evtime_tofft0[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_neg_evtime_tofft0[id]), t.p(), diff);
           }
         } else if (t.isEvTimeT0AC()) { // FT0 Ev. Time
-          histos.fill(HIST(hnsigma_evtime_ft0[id]), t.p(), nsigma);
-          histos.fill(HIST(hnsigma_pt_evtime_ft0[id]), t.pt(), nsigma);
+          histos.fill(HIST(hdelta_evtime_ft0[id]), t.p(), diff);
           if (t.sign() > 0) {
-            histos.fill(HIST(hnsigma_pt_pos_evtime_ft0[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_pos_evtime_ft0[id]), t.p(), diff);
           } else {
-            histos.fill(HIST(hnsigma_pt_neg_evtime_ft0[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_neg_evtime_ft0[id]), t.p(), diff);
           }
         } else if (t.isEvTimeTOF()) { // TOF Ev. Time
-          histos.fill(HIST(hnsigma_evtime_tof[id]), t.p(), nsigma);
-          histos.fill(HIST(hnsigma_pt_evtime_tof[id]), t.pt(), nsigma);
+          histos.fill(HIST(hdelta_evtime_tof[id]), t.p(), diff);
           if (t.sign() > 0) {
-            histos.fill(HIST(hnsigma_pt_pos_evtime_tof[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_pos_evtime_tof[id]), t.p(), diff);
           } else {
-            histos.fill(HIST(hnsigma_pt_neg_evtime_tof[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_neg_evtime_tof[id]), t.p(), diff);
           }
         } else { // No Ev. Time -> Fill Ev. Time
-          histos.fill(HIST(hnsigma_evtime_fill[id]), t.p(), nsigma);
-          histos.fill(HIST(hnsigma_pt_evtime_fill[id]), t.pt(), nsigma);
+          histos.fill(HIST(hdelta_evtime_fill[id]), t.p(), diff);
           if (t.sign() > 0) {
-            histos.fill(HIST(hnsigma_pt_pos_evtime_fill[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_pos_evtime_fill[id]), t.p(), diff);
           } else {
-            histos.fill(HIST(hnsigma_pt_neg_evtime_fill[id]), t.pt(), nsigma);
+            histos.fill(HIST(hdelta_pt_neg_evtime_fill[id]), t.p(), diff);
           }
         }
       }
-      if constexpr (fillFullHistograms) {
-        const float tof = t.tofSignal() - t.tofEvTime();
-        const auto diff = o2::aod::pidutils::tofExpSignalDiff<id>(t);
-        histos.fill(HIST(hexpected[id]), t.p(), tof - diff);
-        histos.fill(HIST(hdelta[id]), t.p(), diff);
-        if (t.sign() > 0) {
-          histos.fill(HIST(hdelta_pt_pos[id]), t.p(), diff);
-        } else {
-          histos.fill(HIST(hdelta_pt_neg[id]), t.p(), diff);
-        }
-        // Filling info split per ev. time
-        if (enableEvTimeSplitting) {
-          if (t.isEvTimeTOF() && t.isEvTimeT0AC()) { // TOF + FT0 Ev. Time
-            histos.fill(HIST(hdelta_evtime_tofft0[id]), t.p(), diff);
-            if (t.sign() > 0) {
-              histos.fill(HIST(hdelta_pt_pos_evtime_tofft0[id]), t.p(), diff);
-            } else {
-              histos.fill(HIST(hdelta_pt_neg_evtime_tofft0[id]), t.p(), diff);
-            }
-          } else if (t.isEvTimeT0AC()) { // FT0 Ev. Time
-            histos.fill(HIST(hdelta_evtime_ft0[id]), t.p(), diff);
-            if (t.sign() > 0) {
-              histos.fill(HIST(hdelta_pt_pos_evtime_ft0[id]), t.p(), diff);
-            } else {
-              histos.fill(HIST(hdelta_pt_neg_evtime_ft0[id]), t.p(), diff);
-            }
-          } else if (t.isEvTimeTOF()) { // TOF Ev. Time
-            histos.fill(HIST(hdelta_evtime_tof[id]), t.p(), diff);
-            if (t.sign() > 0) {
-              histos.fill(HIST(hdelta_pt_pos_evtime_tof[id]), t.p(), diff);
-            } else {
-              histos.fill(HIST(hdelta_pt_neg_evtime_tof[id]), t.p(), diff);
-            }
-          } else { // No Ev. Time -> Fill Ev. Time
-            histos.fill(HIST(hdelta_evtime_fill[id]), t.p(), diff);
-            if (t.sign() > 0) {
-              histos.fill(HIST(hdelta_pt_pos_evtime_fill[id]), t.p(), diff);
-            } else {
-              histos.fill(HIST(hdelta_pt_neg_evtime_fill[id]), t.p(), diff);
-            }
-          }
-        }
-        histos.fill(HIST(hexpsigma[id]), t.p(), o2::aod::pidutils::tofExpSigma<id>(t));
+      histos.fill(HIST(hexpsigma[id]), t.p(), o2::aod::pidutils::tofExpSigma<id>(t));
+    }
+  }
+
+  /// Fills the histograms of all the particle hypotheses ids with a single loop over the tracks,
+  /// the event and track selections are evaluated once for all of them
+  template <bool fillFullHistograms,
+            o2::track::PID::ID... ids,
+            typename TrackType>
+  void processParticles(CollisionCandidate const& collision,
+                        TrackType const& tracks)
+  {
+    if (!isEventSelected<false>(collision, tracks)) {
+      return;
+    }
+
+    for (auto t : tracks) {
+      if (!isTrackSelected<false>(collision, t)) {
+        continue;
       }
+      (fillParticleHistograms<ids, fillFullHistograms>(t), ...);
     }
   }
 
+  template <o2::track::PID::ID id, bool fillFullHistograms,
+            typename TrackType>
+  void processSingleParticle(CollisionCandidate const& collision,
+                             TrackType const& tracks)
+  {
+    processParticles<fillFullHistograms, id>(collision, tracks);
+  }
+
   // QA of nsigma only tables
 #define makeProcessFunction(inputPid, particleId)                                         \
   void process##particleId(CollisionCandidate const& collision,                           \
@@ -658,6 +683,29 @@ struct tofPidQa {
   makeProcessFunction(aod::pidTOFFullHe, Helium3);
   makeProcessFunction(aod::pidTOFFullAl, Alpha);
 #undef makeProcessFunction
+
+  // QA of all the particle hypotheses in a single pass over the tracks
+  void processAll(CollisionCandidate const& collision,
+                  soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection,
+                            aod::pidEvTimeFlags, aod::TOFSignal, aod::TOFEvTime,
+                            aod::pidTOFEl, aod::pidTOFMu, aod::pidTOFPi,
+                            aod::pidTOFKa, aod::pidTOFPr, aod::pidTOFDe,
+                            aod::pidTOFTr, aod::pidTOFHe, aod::pidTOFAl> const& tracks)
+  {
+    processParticles<false, PID::Electron, PID::Muon, PID::Pion, PID::Kaon, PID::Proton, PID::Deuteron, PID::Triton, PID::Helium3, PID::Alpha>(collision, tracks);
+  }
+  PROCESS_SWITCH(tofPidQa, processAll, "Process for all the hypotheses for TOF NSigma QA", false);
+
+  void processFullAll(CollisionCandidate const& collision,
+                      soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection,
+                                aod::pidEvTimeFlags, aod::TOFSignal, aod::TOFEvTime,
+                                aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi,
+                                aod::pidTOFFullKa, aod::pidTOFFullPr, aod::pidTOFFullDe,
+                                aod::pidTOFFullTr, aod::pidTOFFullHe, aod::pidTOFFullAl> const& tracks)
+  {
+    processParticles<true, PID::Electron, PID::Muon, PID::Pion, PID::Kaon, PID::Proton, PID::Deuteron, PID::Triton, PID::Helium3, PID::Alpha>(collision, tracks);
+  }
+  PROCESS_SWITCH(tofPidQa, processFullAll, "Process for all the hypotheses for full TOF PID QA", false);
 };
 
 #endif // DPG_TASKS_AOTTRACK_PID_QAPIDTOF_H_
@@ -119,7 +119,8 @@ struct tpcPidQa {
     switch (id) { // Skipping disabled particles
 #define particleCase(particleId)                                                                     \
   case PID::particleId:                                                                              \
-    if (!doprocess##particleId && !doprocessFull##particleId && !doprocessFullWithTOF##particleId) { \
+    if (!doprocess##particleId && !doprocessFull##particleId && !doprocessFullWithTOF##particleId && \
+        !doprocessAll && !doprocessFullAll && !doprocessFullWithTOFAll) {                            \
       return;                                                                                        \
     }                                                                                                \
     if (doprocess##particleId) {                                                                     \
@@ -134,6 +135,18 @@ struct tpcPidQa {
       enableTOFHistos = true;                                                                        \
       enabledProcesses++;                                                                            \
     }                                                                                                \
+    if (doprocessAll) {                                                                              \
+      enabledProcesses++;                                                                            \
+    }                                                                                                \
+    if (doprocessFullAll) {                                                                          \
+      enableFullHistos = true;                                                                       \
+      enabledProcesses++;                                                                            \
+    }                                                                                                \
+    if (doprocessFullWithTOFAll) {                                                                   \
+      enableFullHistos = true;                                                                       \
+      enableTOFHistos = true;                                                                        \
+      enabledProcesses++;                                                                            \
+    }                                                                                                \
     LOGF(info, "Enabled TPC QA for %s %s", #particleId, pT[id]);                                     \
     break;
 
@@ -342,67 +355,86 @@ struct tpcPidQa {
     }
   }
 
+  /// Fills the histograms of the particle hypothesis id for a selected track
   template <o2::track::PID::ID id, bool fillFullHistograms,
             bool fillWithTOFHistograms,
             typename TrackType>
-  void processSingleParticle(CollisionCandidate const& collision,
-                             TrackType const& tracks)
+  void fillParticleHistograms(TrackType const& t)
   {
-    if (!isEventSelected<false>(collision, tracks)) {
-      return;
-    }
-
-    for (auto t : tracks) {
-      if (!isTrackSelected<false>(collision, t)) {
-        continue;
+    if (applyRapidityCut) {
+      if (abs(t.rapidity(PID::getMass(id))) > 0.5) {
+        return;
       }
+    }
 
-      if (applyRapidityCut) {
-        if (abs(t.rapidity(PID::getMass(id))) > 0.5) {
-          continue;
-        }
-      }
+    const auto nsigma = o2::aod::pidutils::tpcNSigma<id>(t);
+    histos.fill(HIST(hnsigma[id]), t.p(), nsigma);
+    histos.fill(HIST(hnsigma_pt[id]), t.pt(), nsigma);
+    if (t.sign() > 0) {
+      histos.fill(HIST(hnsigma_pt_pos[id]), t.pt(), nsigma);
+    } else {
+      histos.fill(HIST(hnsigma_pt_neg[id]), t.pt(), nsigma);
+    }
 
-      const auto nsigma = o2::aod::pidutils::tpcNSigma<id>(t);
-      histos.fill(HIST(hnsigma[id]), t.p(), nsigma);
-      histos.fill(HIST(hnsigma_pt[id]), t.pt(), nsigma);
+    if constexpr (fillFullHistograms) {
+      const auto& diff = o2::aod::pidutils::tpcExpSignalDiff<id>(t);
+      // Fill histograms
+      histos.fill(HIST(hexpected[id]), t.tpcInnerParam(), t.tpcSignal() - diff);
+      histos.fill(HIST(hdelta[id]), t.tpcInnerParam(), diff);
       if (t.sign() > 0) {
-        histos.fill(HIST(hnsigma_pt_pos[id]), t.pt(), nsigma);
+        histos.fill(HIST(hdelta_pt_pos[id]), t.pt(), diff);
       } else {
-        histos.fill(HIST(hnsigma_pt_neg[id]), t.pt(), nsigma);
+        histos.fill(HIST(hdelta_pt_neg[id]), t.pt(), diff);
       }
-
-      if constexpr (fillFullHistograms) {
-        const auto& diff = o2::aod::pidutils::tpcExpSignalDiff<id>(t);
-        // Fill histograms
-        histos.fill(HIST(hexpected[id]), t.tpcInnerParam(), t.tpcSignal() - diff);
-        histos.fill(HIST(hdelta[id]), t.tpcInnerParam(), diff);
-        if (t.sign() > 0) {
-          histos.fill(HIST(hdelta_pt_pos[id]), t.pt(), diff);
-        } else {
-          histos.fill(HIST(hdelta_pt_neg[id]), t.pt(), diff);
-        }
-        histos.fill(HIST(hexpsigma[id]), t.tpcInnerParam(), o2::aod::pidutils::tpcExpSigma<id>(t));
-        if constexpr (fillWithTOFHistograms) {
-          if (std::abs(o2::aod::pidutils::tofNSigma<id>(t)) < 3.f) {
-            histos.fill(HIST(hexpected_wTOF[id]), t.tpcInnerParam(), t.tpcSignal() - diff);
-            histos.fill(HIST(hdelta_wTOF[id]), t.tpcInnerParam(), diff);
-            histos.fill(HIST(hexpsigma_wTOF[id]), t.p(), o2::aod::pidutils::tpcExpSigma<id>(t));
-          }
+      histos.fill(HIST(hexpsigma[id]), t.tpcInnerParam(), o2::aod::pidutils::tpcExpSigma<id>(t));
+      if constexpr (fillWithTOFHistograms) {
+        if (std::abs(o2::aod::pidutils::tofNSigma<id>(t)) < 3.f) {
+          histos.fill(HIST(hexpected_wTOF[id]), t.tpcInnerParam(), t.tpcSignal() - diff);
+          histos.fill(HIST(hdelta_wTOF[id]), t.tpcInnerParam(), diff);
+          histos.fill(HIST(hexpsigma_wTOF[id]), t.p(), o2::aod::pidutils::tpcExpSigma<id>(t));
         }
       }
-      if constexpr (fillWithTOFHistograms) { // Filling nsigma (common to full and tiny)
-        const auto& nsigmatof = o2::aod::pidutils::tofNSigma<id>(t);
-        if (std::abs(nsigmatof) < 3.f) {
-          histos.fill(HIST(hnsigma_wTOF[id]), t.p(), nsigma);
-          histos.fill(HIST(hnsigma_pt_wTOF[id]), t.pt(), nsigma);
-          histos.fill(HIST(hsignal_wTOF[id]), t.tpcInnerParam(), t.tpcSignal());
-          // histos.fill(HIST("event/signedtpcsignal"), t.tpcInnerParam() * t.sign(), t.tpcSignal());
-        }
+    }
+    if constexpr (fillWithTOFHistograms) { // Filling nsigma (common to full and tiny)
+      const auto& nsigmatof = o2::aod::pidutils::tofNSigma<id>(t);
+      if (std::abs(nsigmatof) < 3.f) {
+        histos.fill(HIST(hnsigma_wTOF[id]), t.p(), nsigma);
+        histos.fill(HIST(hnsigma_pt_wTOF[id]), t.pt(), nsigma);
+        histos.fill(HIST(hsignal_wTOF[id]), t.tpcInnerParam(), t.tpcSignal());
+        // histos.fill(HIST("event/signedtpcsignal"), t.tpcInnerParam() * t.sign(), t.tpcSignal());
+      }
+    }
+  }
+
+  /// Fills the histograms of all the particle hypotheses ids with a single loop over the tracks,
+  /// the event and track selections are evaluated once for all of them
+  template <bool fillFullHistograms, bool fillWithTOFHistograms,
+            o2::track::PID::ID... ids,
+            typename TrackType>
+  void processParticles(CollisionCandidate const& collision,
+                        TrackType const& tracks)
+  {
+    if (!isEventSelected<false>(collision, tracks)) {
+      return;
+    }
+
+    for (auto t : tracks) {
+      if (!isTrackSelected<false>(collision, t)) {
+        continue;
       }
+      (fillParticleHistograms<ids, fillFullHistograms, fillWithTOFHistograms>(t), ...);
     }
   }
 
+  template <o2::track::PID::ID id, bool fillFullHistograms,
+            bool fillWithTOFHistograms,
+            typename TrackType>
+  void processSingleParticle(CollisionCandidate const& collision,
+                             TrackType const& tracks)
+  {
+    processParticles<fillFullHistograms, fillWithTOFHistograms, id>(collision, tracks);
+  }
+
   // QA of nsigma only tables
 #define makeProcessFunction(inputPid, particleId)                                        \
   void process##particleId(CollisionCandidate const& collision,                          \
@@ -464,4 +496,38 @@ struct tpcPidQa {
   makeProcessFunction(aod::pidTPCFullHe, aod::pidTOFFullHe, Helium3);
   makeProcessFunction(aod::pidTPCFullAl, aod::pidTOFFullAl, Alpha);
 #undef makeProcessFunction
+
+  // QA of all the particle hypotheses in a single pass over the tracks
+  void processAll(CollisionCandidate const& collision,
+                  soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection,
+                            aod::pidTPCEl, aod::pidTPCMu, aod::pidTPCPi,
+                            aod::pidTPCKa, aod::pidTPCPr, aod::pidTPCDe,
+                            aod::pidTPCTr, aod::pidTPCHe, aod::pidTPCAl> const& tracks)
+  {
+    processParticles<false, false, PID::Electron, PID::Muon, PID::Pion, PID::Kaon, PID::Proton, PID::Deuteron, PID::Triton, PID::Helium3, PID::Alpha>(collision, tracks);
+  }
+  PROCESS_SWITCH(tpcPidQa, processAll, "Process for all the hypotheses for TPC NSigma QA", false);
+
+  void processFullAll(CollisionCandidate const& collision,
+                      soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection,
+                                aod::pidTPCFullEl, aod::pidTPCFullMu, aod::pidTPCFullPi,
+                                aod::pidTPCFullKa, aod::pidTPCFullPr, aod::pidTPCFullDe,
+                                aod::pidTPCFullTr, aod::pidTPCFullHe, aod::pidTPCFullAl> const& tracks)
+  {
+    processParticles<true, false, PID::Electron, PID::Muon, PID::Pion, PID::Kaon, PID::Proton, PID::Deuteron, PID::Triton, PID::Helium3, PID::Alpha>(collision, tracks);
+  }
+  PROCESS_SWITCH(tpcPidQa, processFullAll, "Process for all the hypotheses for full TPC PID QA", false);
+
+  void processFullWithTOFAll(CollisionCandidate const& collision,
+                             soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection,
+                                       aod::pidTPCFullEl, aod::pidTPCFullMu, aod::pidTPCFullPi,
+                                       aod::pidTPCFullKa, aod::pidTPCFullPr, aod::pidTPCFullDe,
+                                       aod::pidTPCFullTr, aod::pidTPCFullHe, aod::pidTPCFullAl,
+                                       aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi,
+                                       aod::pidTOFFullKa, aod::pidTOFFullPr, aod::pidTOFFullDe,
+                                       aod::pidTOFFullTr, aod::pidTOFFullHe, aod::pidTOFFullAl> const& tracks)
+  {
+    processParticles<true, true, PID::Electron, PID::Muon, PID::Pion, PID::Kaon, PID::Proton, PID::Deuteron, PID::Triton, PID::Helium3, PID::Alpha>(collision, tracks);
+  }
+  PROCESS_SWITCH(tpcPidQa, processFullWithTOFAll, "Process for all the hypotheses for full TPC PID QA with TOF", false);
 };
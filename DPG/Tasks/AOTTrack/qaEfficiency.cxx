@@ -26,6 +26,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "qaHistogramBuffers.h"
 
 // ROOT includes
 #include "TPDGCode.h"
@@ -419,6 +420,44 @@ struct QaEfficiency {
                                                                     "MC/tr/neg/pteta/generated", "MC/he/neg/pteta/generated", "MC/al/neg/pteta/generated",
                                                                     "MC/all/neg/pteta/generated"};
 
+  // Buffers of the 1D MC histograms per particle and charge, the histograms with the same axis are selected by bitmask
+  enum PtHistogram {
+    kPtIts = 0,
+    kPtTpc,
+    kPtItsTpc,
+    kPtItsTof,
+    kPtTpcTof,
+    kPtItsTpcTof,
+    kPtTrkItsTpc,
+    kPtGenerated,
+    kPtItsPrm,
+    kPtItsTpcPrm,
+    kPtTrkItsTpcPrm,
+    kPtItsTpcTofPrm,
+    kPtGeneratedPrm,
+    kPtItsTpcStr,
+    kPtTrkItsTpcStr,
+    kPtItsTpcTofStr,
+    kPtGeneratedStr,
+    kPtItsTpcMat,
+    kPtTrkItsTpcMat,
+    kPtItsTpcTofMat,
+    kPtGeneratedMat,
+    kNPtHistograms
+  };
+  enum KineHistogram { // p, eta, y and phi, not all of them have the reconstructed track histogram
+    kItsTpc = 0,
+    kTrkItsTpc,
+    kItsTpcTof,
+    kGenerated,
+    kNKineHistograms
+  };
+  std::array<o2::dpg::SharedAxisHistograms<kNPtHistograms>, nHistograms> ptHistograms;
+  std::array<o2::dpg::SharedAxisHistograms<kNKineHistograms>, nHistograms> pHistograms;
+  std::array<o2::dpg::SharedAxisHistograms<kNKineHistograms>, nHistograms> etaHistograms;
+  std::array<o2::dpg::SharedAxisHistograms<kNKineHistograms>, nHistograms> yHistograms;
+  std::array<o2::dpg::SharedAxisHistograms<kNKineHistograms>, nHistograms> phiHistograms;
+
   static const char* particleName(int charge, o2::track::PID::ID id)
   {
     return Form("%s %s", charge == 0 ? "Positive" : "Negative", id == o2::track::PID::NIDs ? "All" : o2::track::PID::getName(id));
@@ -542,6 +581,47 @@ struct QaEfficiency {
       registry->add(hPtEtaGenerated[histogramIndex].data(), "Generated " + tagPtEta, kTH2D, {axisPt, axisEta});
     }
 
+    auto setHistogram = [&](auto& buffer, int bufferId, auto histogramName) {
+      buffer.set(bufferId, registry->get<TH1>(histogramName).get());
+    };
+    auto& pt = ptHistograms[histogramIndex];
+    setHistogram(pt, kPtIts, HIST(hPtIts[histogramIndex]));
+    setHistogram(pt, kPtTpc, HIST(hPtTpc[histogramIndex]));
+    setHistogram(pt, kPtItsTpc, HIST(hPtItsTpc[histogramIndex]));
+    setHistogram(pt, kPtItsTof, HIST(hPtItsTof[histogramIndex]));
+    setHistogram(pt, kPtTpcTof, HIST(hPtTpcTof[histogramIndex]));
+    setHistogram(pt, kPtItsTpcTof, HIST(hPtItsTpcTof[histogramIndex]));
+    setHistogram(pt, kPtTrkItsTpc, HIST(hPtTrkItsTpc[histogramIndex]));
+    setHistogram(pt, kPtGenerated, HIST(hPtGenerated[histogramIndex]));
+    setHistogram(pt, kPtItsPrm, HIST(hPtItsPrm[histogramIndex]));
+    setHistogram(pt, kPtItsTpcPrm, HIST(hPtItsTpcPrm[histogramIndex]));
+    setHistogram(pt, kPtTrkItsTpcPrm, HIST(hPtTrkItsTpcPrm[histogramIndex]));
+    setHistogram(pt, kPtItsTpcTofPrm, HIST(hPtItsTpcTofPrm[histogramIndex]));
+    setHistogram(pt, kPtGeneratedPrm, HIST(hPtGeneratedPrm[histogramIndex]));
+    setHistogram(pt, kPtItsTpcStr, HIST(hPtItsTpcStr[histogramIndex]));
+    setHistogram(pt, kPtTrkItsTpcStr, HIST(hPtTrkItsTpcStr[histogramIndex]));
+    setHistogram(pt, kPtItsTpcTofStr, HIST(hPtItsTpcTofStr[histogramIndex]));
+    setHistogram(pt, kPtGeneratedStr, HIST(hPtGeneratedStr[histogramIndex]));
+    setHistogram(pt, kPtItsTpcMat, HIST(hPtItsTpcMat[histogramIndex]));
+    setHistogram(pt, kPtTrkItsTpcMat, HIST(hPtTrkItsTpcMat[histogramIndex]));
+    setHistogram(pt, kPtItsTpcTofMat, HIST(hPtItsTpcTofMat[histogramIndex]));
+    setHistogram(pt, kPtGeneratedMat, HIST(hPtGeneratedMat[histogramIndex]));
+    setHistogram(pHistograms[histogramIndex], kItsTpc, HIST(hPItsTpc[histogramIndex]));
+    setHistogram(pHistograms[histogramIndex], kTrkItsTpc, HIST(hPTrkItsTpc[histogramIndex]));
+    setHistogram(pHistograms[histogramIndex], kItsTpcTof, HIST(hPItsTpcTof[histogramIndex]));
+    setHistogram(pHistograms[histogramIndex], kGenerated, HIST(hPGenerated[histogramIndex]));
+    setHistogram(etaHistograms[histogramIndex], kItsTpc, HIST(hEtaItsTpc[histogramIndex]));
+    setHistogram(etaHistograms[histogramIndex], kTrkItsTpc, HIST(hEtaTrkItsTpc[histogramIndex]));
+    setHistogram(etaHistograms[histogramIndex], kItsTpcTof, HIST(hEtaItsTpcTof[histogramIndex]));
+    setHistogram(etaHistograms[histogramIndex], kGenerated, HIST(hEtaGenerated[histogramIndex]));
+    setHistogram(yHistograms[histogramIndex], kItsTpc, HIST(hYItsTpc[histogramIndex]));
+    setHistogram(yHistograms[histogramIndex], kItsTpcTof, HIST(hYItsTpcTof[histogramIndex]));
+    setHistogram(yHistograms[histogramIndex], kGenerated, HIST(hYGenerated[histogramIndex]));
+    setHistogram(phiHistograms[histogramIndex], kItsTpc, HIST(hPhiItsTpc[histogramIndex]));
+    setHistogram(phiHistograms[histogramIndex], kTrkItsTpc, HIST(hPhiTrkItsTpc[histogramIndex]));
+    setHistogram(phiHistograms[histogramIndex], kItsTpcTof, HIST(hPhiItsTpcTof[histogramIndex]));
+    setHistogram(phiHistograms[histogramIndex], kGenerated, HIST(hPhiGenerated[histogramIndex]));
+
     LOG(info) << "Done with particle: " << partName;
   }
 
@@ -963,23 +1043,23 @@ struct QaEfficiency {
 
     histos.fill(HIST("MC/trackSelection"), 19 + id);
 
+    uint32_t ptMask = 0;    // histograms of the pT of the particle
+    uint32_t ptTrkMask = 0; // histograms of the pT of the track
+    uint32_t kineMask = 0;  // histograms of p, eta, y and phi of the particle
     if (passedITS) {
-      h->fill(HIST(hPtIts[histogramIndex]), mcParticle.pt());
+      ptMask |= BIT(kPtIts);
     }
     if (passedTPC) {
-      h->fill(HIST(hPtTpc[histogramIndex]), mcParticle.pt());
+      ptMask |= BIT(kPtTpc);
     }
     if (passedITS && passedTPC) {
-      h->fill(HIST(hPItsTpc[histogramIndex]), mcParticle.p());
-      h->fill(HIST(hPtItsTpc[histogramIndex]), mcParticle.pt());
-      h->fill(HIST(hEtaItsTpc[histogramIndex]), mcParticle.eta());
-      h->fill(HIST(hYItsTpc[histogramIndex]), mcParticle.y());
-      h->fill(HIST(hPhiItsTpc[histogramIndex]), mcParticle.phi());
+      ptMask |= BIT(kPtItsTpc);
+      ptTrkMask |= BIT(kPtTrkItsTpc);
+      kineMask |= BIT(kItsTpc);
 
-      h->fill(HIST(hPTrkItsTpc[histogramIndex]), track.p());
-      h->fill(HIST(hPtTrkItsTpc[histogramIndex]), track.pt());
-      h->fill(HIST(hEtaTrkItsTpc[histogramIndex]), track.eta());
-      h->fill(HIST(hPhiTrkItsTpc[histogramIndex]), track.phi());
+      pHistograms[histogramIndex].fill(BIT(kTrkItsTpc), track.p());
+      etaHistograms[histogramIndex].fill(BIT(kTrkItsTpc), track.eta());
+      phiHistograms[histogramIndex].fill(BIT(kTrkItsTpc), track.phi());
 
       if (doPtEta) {
         h->fill(HIST(hPtEtaItsTpc[histogramIndex]), mcParticle.pt(), mcParticle.eta());
@@ -990,47 +1070,51 @@ struct QaEfficiency {
       }
     }
     if (passedITS && passedTOF) {
-      h->fill(HIST(hPtItsTof[histogramIndex]), mcParticle.pt());
+      ptMask |= BIT(kPtItsTof);
     }
     if (passedTPC && passedTOF) {
-      h->fill(HIST(hPtTpcTof[histogramIndex]), mcParticle.pt());
+      ptMask |= BIT(kPtTpcTof);
     }
     if (passedITS && passedTPC && passedTOF) {
-      h->fill(HIST(hPItsTpcTof[histogramIndex]), mcParticle.p());
-      h->fill(HIST(hPtItsTpcTof[histogramIndex]), mcParticle.pt());
-      h->fill(HIST(hEtaItsTpcTof[histogramIndex]), mcParticle.eta());
-      h->fill(HIST(hYItsTpcTof[histogramIndex]), mcParticle.y());
-      h->fill(HIST(hPhiItsTpcTof[histogramIndex]), mcParticle.phi());
+      ptMask |= BIT(kPtItsTpcTof);
+      kineMask |= BIT(kItsTpcTof);
     }
 
     if (mcParticle.isPhysicalPrimary()) {
       if (passedITS) {
-        h->fill(HIST(hPtItsPrm[histogramIndex]), mcParticle.pt());
+        ptMask |= BIT(kPtItsPrm);
       }
       if (passedITS && passedTPC) {
-        h->fill(HIST(hPtItsTpcPrm[histogramIndex]), mcParticle.pt());
-        h->fill(HIST(hPtTrkItsTpcPrm[histogramIndex]), track.pt());
+        ptMask |= BIT(kPtItsTpcPrm);
+        ptTrkMask |= BIT(kPtTrkItsTpcPrm);
         if (passedTOF) {
-          h->fill(HIST(hPtItsTpcTofPrm[histogramIndex]), mcParticle.pt());
+          ptMask |= BIT(kPtItsTpcTofPrm);
         }
       }
     } else if (mcParticle.getProcess() == 4) { // Particle decay
       if (passedITS && passedTPC) {
-        h->fill(HIST(hPtItsTpcStr[histogramIndex]), mcParticle.pt());
-        h->fill(HIST(hPtTrkItsTpcStr[histogramIndex]), track.pt());
+        ptMask |= BIT(kPtItsTpcStr);
+        ptTrkMask |= BIT(kPtTrkItsTpcStr);
         if (passedTOF) {
-          h->fill(HIST(hPtItsTpcTofStr[histogramIndex]), mcParticle.pt());
+          ptMask |= BIT(kPtItsTpcTofStr);
         }
       }
     } else { // Material
       if (passedITS && passedTPC) {
-        h->fill(HIST(hPtItsTpcMat[histogramIndex]), mcParticle.pt());
-        h->fill(HIST(hPtTrkItsTpcMat[histogramIndex]), track.pt());
+        ptMask |= BIT(kPtItsTpcMat);
+        ptTrkMask |= BIT(kPtTrkItsTpcMat);
         if (passedTOF) {
-          h->fill(HIST(hPtItsTpcTofMat[histogramIndex]), mcParticle.pt());
+          ptMask |= BIT(kPtItsTpcTofMat);
         }
       }
     }
+
+    ptHistograms[histogramIndex].fill(ptMask, mcParticle.pt());
+    ptHistograms[histogramIndex].fill(ptTrkMask, track.pt());
+    pHistograms[histogramIndex].fill(kineMask, mcParticle.p());
+    etaHistograms[histogramIndex].fill(kineMask, mcParticle.eta());
+    yHistograms[histogramIndex].fill(kineMask, mcParticle.y());
+    phiHistograms[histogramIndex].fill(kineMask, mcParticle.phi());
   }
 
   template <int charge, o2::track::PID::ID id, typename particleType>
@@ -1063,22 +1147,21 @@ struct QaEfficiency {
     }
     histos.fill(HIST("MC/particleSelection"), 7 + id);
 
-    h->fill(HIST(hPGenerated[histogramIndex]), mcParticle.p());
-    h->fill(HIST(hPtGenerated[histogramIndex]), mcParticle.pt());
-
+    uint32_t ptMask = BIT(kPtGenerated);
     if (mcParticle.isPhysicalPrimary()) {
-      h->fill(HIST(hPtGeneratedPrm[histogramIndex]), mcParticle.pt());
+      ptMask |= BIT(kPtGeneratedPrm);
     } else {
       if (mcParticle.getProcess() == 4) { // Particle deday
-        h->fill(HIST(hPtGeneratedStr[histogramIndex]), mcParticle.pt());
+        ptMask |= BIT(kPtGeneratedStr);
       } else { // Material
-        h->fill(HIST(hPtGeneratedMat[histogramIndex]), mcParticle.pt());
+        ptMask |= BIT(kPtGeneratedMat);
       }
     }
-
-    h->fill(HIST(hEtaGenerated[histogramIndex]), mcParticle.eta());
-    h->fill(HIST(hYGenerated[histogramIndex]), mcParticle.y());
-    h->fill(HIST(hPhiGenerated[histogramIndex]), mcParticle.phi());
+    ptHistograms[histogramIndex].fill(ptMask, mcParticle.pt());
+    pHistograms[histogramIndex].fill(BIT(kGenerated), mcParticle.p());
+    etaHistograms[histogramIndex].fill(BIT(kGenerated), mcParticle.eta());
+    yHistograms[histogramIndex].fill(BIT(kGenerated), mcParticle.y());
+    phiHistograms[histogramIndex].fill(BIT(kGenerated), mcParticle.phi());
     if (doPtEta) {
       h->fill(HIST(hPtEtaGenerated[histogramIndex]), mcParticle.pt(), mcParticle.eta());
     }
@@ -1439,6 +1522,15 @@ struct QaEfficiency {
     }
     histos.fill(HIST("MC/eventMultiplicity"), dNdEta * 0.5f / 2.f);
 
+    // Add the buffered fills to the histograms before they are copied to the efficiencies
+    for (int i = 0; i < nHistograms; i++) {
+      ptHistograms[i].flush();
+      pHistograms[i].flush();
+      etaHistograms[i].flush();
+      yHistograms[i].flush();
+      phiHistograms[i].flush();
+    }
+
     // Fill TEfficiencies
     static_for<0, 1>([&](auto charge) {
       fillMCEfficiency<charge, o2::track::PID::Electron>(doEl);
@@ -21,6 +21,7 @@
 ///
 
 #include "qaEventTrack.h"
+#include "qaHistogramBuffers.h"
 
 #include "Framework/AnalysisTask.h"
 #include "Framework/HistogramRegistry.h"
@@ -107,6 +108,18 @@ struct qaEventTrack {
 
   HistogramRegistry histos;
 
+  // buffered per-track histograms, added to the registry at the end of each collision
+  enum PtHistogram {
+    kKinePt = 0,
+    kHasITS,
+    kHasTPC,
+    kHasITSANDhasTPC,
+    kNPtHistograms
+  };
+  o2::dpg::SharedAxisHistograms<kNPtHistograms> ptHistograms;
+  o2::dpg::BitCounter<42> trackSelectionCounts; // bins of Tracks/selection
+  o2::dpg::BitCounter<66> trackFlagCounts;      // bins of Tracks/flags
+
   Preslice<aod::McParticles> perMcCollision = aod::mcparticle::mcCollisionId;
   Preslice<aod::Tracks> perRecoCollision = aod::track::collisionId;
 
@@ -314,6 +327,10 @@ struct qaEventTrack {
     histos.add("Tracks/TPC/tpcCrossedRowsOverFindableCls", "crossed TPC rows over findable clusters;crossed rows / findable clusters TPC", kTH1D, {{60, 0.7, 1.3}});
     histos.add("Tracks/TPC/tpcChi2NCl", "chi2 per cluster in TPC;chi2 / cluster TPC", kTH1D, {{100, 0, 10}});
     histos.add("Tracks/TPC/hasTPC", "pt distribution of tracks crossing TPC", kTH1D, {axisPt});
+    ptHistograms.set(kKinePt, histos.get<TH1>(HIST("Tracks/Kine/pt")).get());
+    ptHistograms.set(kHasITS, histos.get<TH1>(HIST("Tracks/ITS/hasITS")).get());
+    ptHistograms.set(kHasTPC, histos.get<TH1>(HIST("Tracks/TPC/hasTPC")).get());
+    ptHistograms.set(kHasITSANDhasTPC, histos.get<TH1>(HIST("Tracks/ITS/hasITSANDhasTPC")).get());
 
     // tracks vs tracks @ IU
     if (doprocessDataIU) {
@@ -846,140 +863,26 @@ void qaEventTrack::fillRecoHistogramsGroupedTracks(const C& collision, const T&
 
   int nTracks = 0;
   for (const auto& track : tracks) {
-    histos.fill(HIST("Tracks/selection"), 1.f);
+    // bin 1: tracks read, bin 2: tracks selected
     if (!isSelectedTrack<IS_MC>(track)) {
+      trackSelectionCounts.addBits(BIT(1), 0);
       continue;
     }
-    histos.fill(HIST("Tracks/selection"), 2.f);
     ++nTracks;
-    if (track.passedTrackType()) {
-      histos.fill(HIST("Tracks/selection"), 3.f);
-    }
-    if (track.passedPtRange()) {
-      histos.fill(HIST("Tracks/selection"), 4.f);
-    }
-    if (track.passedEtaRange()) {
-      histos.fill(HIST("Tracks/selection"), 5.f);
-    }
-    if (track.passedTPCNCls()) {
-      histos.fill(HIST("Tracks/selection"), 6.f);
-    }
-    if (track.passedTPCCrossedRows()) {
-      histos.fill(HIST("Tracks/selection"), 7.f);
-    }
-    if (track.passedTPCCrossedRowsOverNCls()) {
-      histos.fill(HIST("Tracks/selection"), 8.f);
-    }
-    if (track.passedTPCChi2NDF()) {
-      histos.fill(HIST("Tracks/selection"), 9.f);
-    }
-    if (track.passedTPCRefit()) {
-      histos.fill(HIST("Tracks/selection"), 10.f);
-    }
-    if (track.passedITSNCls()) {
-      histos.fill(HIST("Tracks/selection"), 11.f);
-    }
-    if (track.passedITSChi2NDF()) {
-      histos.fill(HIST("Tracks/selection"), 12.f);
-    }
-    if (track.passedITSRefit()) {
-      histos.fill(HIST("Tracks/selection"), 13.f);
-    }
-    if (track.passedITSHits()) {
-      histos.fill(HIST("Tracks/selection"), 14.f);
-    }
-    if (track.passedGoldenChi2()) {
-      histos.fill(HIST("Tracks/selection"), 15.f);
-    }
-    if (track.passedDCAxy()) {
-      histos.fill(HIST("Tracks/selection"), 16.f);
-    }
-    if (track.passedDCAz()) {
-      histos.fill(HIST("Tracks/selection"), 17.f);
-    }
-    if (track.isGlobalTrack()) {
-      histos.fill(HIST("Tracks/selection"), 18.f);
-    }
-    // Filling combined cuts
-    if (track.passedTrackType()) {
-      histos.fill(HIST("Tracks/selection"), 20.f);
-    } else {
-      continue;
-    }
-    if (track.passedPtRange()) {
-      histos.fill(HIST("Tracks/selection"), 21.f);
-    } else {
-      continue;
-    }
-    if (track.passedEtaRange()) {
-      histos.fill(HIST("Tracks/selection"), 22.f);
-    } else {
-      continue;
-    }
-    if (track.passedTPCNCls()) {
-      histos.fill(HIST("Tracks/selection"), 23.f);
-    } else {
-      continue;
-    }
-    if (track.passedTPCCrossedRows()) {
-      histos.fill(HIST("Tracks/selection"), 24.f);
-    } else {
-      continue;
-    }
-    if (track.passedTPCCrossedRowsOverNCls()) {
-      histos.fill(HIST("Tracks/selection"), 25.f);
-    } else {
-      continue;
-    }
-    if (track.passedTPCChi2NDF()) {
-      histos.fill(HIST("Tracks/selection"), 26.f);
-    } else {
-      continue;
-    }
-    if (track.passedTPCRefit()) {
-      histos.fill(HIST("Tracks/selection"), 27.f);
-    } else {
-      continue;
-    }
-    if (track.passedITSNCls()) {
-      histos.fill(HIST("Tracks/selection"), 28.f);
-    } else {
-      continue;
-    }
-    if (track.passedITSChi2NDF()) {
-      histos.fill(HIST("Tracks/selection"), 29.f);
-    } else {
-      continue;
-    }
-    if (track.passedITSRefit()) {
-      histos.fill(HIST("Tracks/selection"), 30.f);
-    } else {
-      continue;
-    }
-    if (track.passedITSHits()) {
-      histos.fill(HIST("Tracks/selection"), 31.f);
-    } else {
-      continue;
-    }
-    if (track.passedGoldenChi2()) {
-      histos.fill(HIST("Tracks/selection"), 32.f);
-    } else {
-      continue;
-    }
-    if (track.passedDCAxy()) {
-      histos.fill(HIST("Tracks/selection"), 33.f);
-    } else {
-      continue;
-    }
-    if (track.passedDCAz()) {
-      histos.fill(HIST("Tracks/selection"), 34.f);
-    } else {
-      continue;
-    }
-    if (track.isGlobalTrack()) {
-      histos.fill(HIST("Tracks/selection"), 35.f);
-    }
+    // the cuts in the order of the bins 3 to 18, and of the combined cuts in the bins 20 to 35
+    const bool cuts[16] = {track.passedTrackType(), track.passedPtRange(), track.passedEtaRange(), track.passedTPCNCls(),
+                           track.passedTPCCrossedRows(), track.passedTPCCrossedRowsOverNCls(), track.passedTPCChi2NDF(), track.passedTPCRefit(),
+                           track.passedITSNCls(), track.passedITSChi2NDF(), track.passedITSRefit(), track.passedITSHits(),
+                           track.passedGoldenChi2(), track.passedDCAxy(), track.passedDCAz(), track.isGlobalTrack()};
+    uint64_t passed = 0;
+    for (int i = 0; i < 16; i++) {
+      passed |= static_cast<uint64_t>(cuts[i]) << i;
+    }
+    // a combined cut is counted if all the previous cuts are passed
+    const int nCombined = __builtin_ctzll(~passed);
+    trackSelectionCounts.addBits(BIT(1) | BIT(2) | (passed << 3) | ((BIT(nCombined) - 1) << 20), 0);
   }
+  trackSelectionCounts.flush(histos.get<TH1>(HIST("Tracks/selection")).get());
 
   histos.fill(HIST("Events/posX"), collision.posX());
   histos.fill(HIST("Events/posY"), collision.posY());
@@ -1043,7 +946,6 @@ void qaEventTrack::fillRecoHistogramsGroupedTracks(const C& collision, const T&
       continue;
     }
     // fill kinematic variables
-    histos.fill(HIST("Tracks/Kine/pt"), track.pt());
     histos.fill(HIST("Tracks/Kine/eta"), track.eta());
     histos.fill(HIST("Tracks/Kine/phi"), track.phi());
     histos.fill(HIST("Tracks/Kine/etavsphi"), track.eta(), track.phi());
@@ -1060,11 +962,7 @@ void qaEventTrack::fillRecoHistogramsGroupedTracks(const C& collision, const T&
     histos.fill(HIST("Tracks/signed1Pt"), track.signed1Pt());
     histos.fill(HIST("Tracks/snp"), track.snp());
     histos.fill(HIST("Tracks/tgl"), track.tgl());
-    for (unsigned int i = 0; i < 64; i++) {
-      if (track.flags() & (1 << i)) {
-        histos.fill(HIST("Tracks/flags"), i);
-      }
-    }
+    trackFlagCounts.addBits(track.flags());
     histos.fill(HIST("Tracks/dcaXY"), track.dcaXY());
     histos.fill(HIST("Tracks/dcaZ"), track.dcaZ());
     histos.fill(HIST("Tracks/dcaXYvsPt"), track.dcaXY(), track.pt());
@@ -1111,14 +1009,18 @@ void qaEventTrack::fillRecoHistogramsGroupedTracks(const C& collision, const T&
     }
 
     // ITS-TPC matching pt-distributions
+    uint32_t ptMask = BIT(kKinePt);
     if (track.hasITS()) {
-      histos.fill(HIST("Tracks/ITS/hasITS"), track.pt());
+      ptMask |= BIT(kHasITS);
     }
     if (track.hasTPC()) {
-      histos.fill(HIST("Tracks/TPC/hasTPC"), track.pt());
+      ptMask |= BIT(kHasTPC);
     }
     if (track.hasITS() && track.hasTPC()) {
-      histos.fill(HIST("Tracks/ITS/hasITSANDhasTPC"), track.pt());
+      ptMask |= BIT(kHasITSANDhasTPC);
     }
+    ptHistograms.fill(ptMask, track.pt());
   }
+  ptHistograms.flush();
+  trackFlagCounts.flush(histos.get<TH1>(HIST("Tracks/flags")).get());
 }
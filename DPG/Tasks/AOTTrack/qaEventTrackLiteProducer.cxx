@@ -30,6 +30,7 @@
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/TableProducer/PID/pidTOFBase.h"
+#include "DPG/Core/skimSampling.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -52,6 +53,7 @@ struct qaEventTrackLiteProducer {
   Configurable<float> selectMaxVtxZ{"selectMaxVtxZ", 100.f, "Derived data option: select collision in a given Z window"};
   Configurable<int> targetNumberOfEvents{"targetNumberOfEvents", 10000000, "Derived data option: target number of collisions, if the target is met, future collisions will be skipped"};
   Configurable<float> fractionOfSampledEvents{"fractionOfSampledEvents", 1.f, "Derived data option: fraction of events to sample"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "Derived data option: seed of the event sampling, 0 for a random seed"};
 
   // options to select only specific tracks
   Configurable<int> trackSelection{"trackSelection", 1, "Track selection: 0 -> No Cut, 1 -> kGlobalTrack, 2 -> kGlobalTrackWoPtEta, 3 -> kGlobalTrackWoDCA, 4 -> kQualityTracks, 5 -> kInAcceptanceTracks"};
@@ -107,6 +109,7 @@ struct qaEventTrackLiteProducer {
     if (doprocessTableData == false && doprocessTableMC == false) {
       LOGF(fatal, "No process function enabled. Enable either processTableData or processTableMC");
     }
+    rng.setSeed(static_cast<uint64_t>(samplingSeed.value));
   }
 
   // Function to select tracks
@@ -188,6 +191,7 @@ struct qaEventTrackLiteProducer {
    */
   //**************************************************************************************************
   int nTableEventCounter = 0; // Number of processed events
+  o2::dpg::SkimRandom rng;    // Random numbers of the event sampling
   template <bool IS_MC, typename C, typename T, typename P>
   void fillDerivedTable(const C& collision, const T& tracks, const P& particles, const aod::BCs&)
   {
@@ -197,7 +201,7 @@ struct qaEventTrackLiteProducer {
     if (abs(collision.posZ()) > selectMaxVtxZ) {
       return;
     }
-    if (fractionOfSampledEvents < 1.f && (static_cast<float>(rand()) / static_cast<float>(RAND_MAX)) > fractionOfSampledEvents) { // Skip events that are not sampled
+    if (!rng.keep(fractionOfSampledEvents)) { // Skip events that are not sampled
       return;
     }
     if (nTableEventCounter > targetNumberOfEvents) { // Skip events if target is reached
@@ -0,0 +1,186 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+///
+/// \file   qaHistogramBuffers.h
+/// \brief  Bulk filling of the per-track histograms of the QA tasks
+///         The fills are counted in dense per-bin arrays and added to the histograms of the HistogramRegistry when
+///         flushed, e.g. at the end of a collision or before the histograms are read.
+///         SharedAxisHistograms fills one value into the histograms with the same binning selected by a bitmask:
+///         the bin is found once instead of once per histogram. BitCounter counts the set bits of a mask into the
+///         bins of a single histogram, e.g. the passed selections of a track.
+///         The statistics (entries, sum of weights and moments) are kept as in TH1::Fill with weight 1.
+///
+
+#ifndef DPG_TASKS_AOTTRACK_QAHISTOGRAMBUFFERS_H_
+#define DPG_TASKS_AOTTRACK_QAHISTOGRAMBUFFERS_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "TH1.h"
+
+namespace o2::dpg
+{
+
+/// Up to N 1D histograms with the same x axis, addressed with their index in the bitmask of a fill
+template <int N>
+class SharedAxisHistograms
+{
+  static_assert(N <= 32, "the histograms are selected by a 32 bit mask");
+
+ public:
+  /// Sets the histogram with index id, all the histograms must have the binning of the first one
+  void set(int id, TH1* h)
+  {
+    if (mAxis == nullptr) {
+      mAxis = h->GetXaxis();
+      mNBins = mAxis->GetNbins() + 2;
+      mCounts.assign(N * mNBins, 0.);
+    }
+    mHists[id] = h;
+  }
+
+  bool isSet() const { return mAxis != nullptr; }
+
+  /// Fills x into the histograms of the set bits of mask
+  void fill(uint32_t mask, double x)
+  {
+    if (mask == 0) {
+      return;
+    }
+    const int bin = mAxis->FindFixBin(x);
+    const bool inRange = bin > 0 && bin < mNBins - 1;
+    for (; mask != 0; mask &= mask - 1) {
+      const int id = __builtin_ctz(mask);
+      const int index = id * mNBins + bin;
+      if (mCounts[index]++ == 0.) {
+        mFilled.push_back(index);
+      }
+      Stats& stats = mStats[id];
+      stats.entries++;
+      if (inRange) {
+        stats.sumw++;
+        stats.sumwx += x;
+        stats.sumwx2 += x * x;
+      }
+    }
+  }
+
+  /// Adds the counts to the histograms and resets them
+  void flush()
+  {
+    if (mFilled.empty()) {
+      return;
+    }
+    // the statistics are read before the bins change, TH1::GetStats recomputes them from the bins when not filled
+    std::array<double, 4> before[N];
+    for (int id = 0; id < N; id++) {
+      if (mStats[id].entries > 0) {
+        mHists[id]->GetStats(before[id].data());
+      }
+    }
+    for (const int index : mFilled) {
+      TH1* h = mHists[index / mNBins];
+      const int bin = index % mNBins;
+      h->AddBinContent(bin, mCounts[index]);
+      if (h->GetSumw2N() > 0) {
+        (*h->GetSumw2())[bin] += mCounts[index];
+      }
+      mCounts[index] = 0.;
+    }
+    mFilled.clear();
+    for (int id = 0; id < N; id++) {
+      Stats& stats = mStats[id];
+      if (stats.entries == 0) {
+        continue;
+      }
+      std::array<double, 4>& s = before[id];
+      s[0] += stats.sumw;
+      s[1] += stats.sumw;
+      s[2] += stats.sumwx;
+      s[3] += stats.sumwx2;
+      mHists[id]->PutStats(s.data());
+      mHists[id]->SetEntries(mHists[id]->GetEntries() + stats.entries);
+      stats = Stats{};
+    }
+  }
+
+ private:
+  struct Stats {
+    double entries = 0.;
+    double sumw = 0.;
+    double sumwx = 0.;
+    double sumwx2 = 0.;
+  };
+
+  const TAxis* mAxis = nullptr;  ///< x axis of the first histogram
+  int mNBins = 0;                ///< number of bins including the underflow and overflow bins
+  std::array<TH1*, N> mHists{};  ///< histograms, owned by the registry
+  std::vector<double> mCounts;   ///< counts per histogram and bin
+  std::vector<int> mFilled;      ///< indices of the non-zero counts
+  std::array<Stats, N> mStats{}; ///< statistics of the in-range fills per histogram
+};
+
+/// Counts of the set bits of a mask in the first N bins of a 1D histogram
+template <int N>
+class BitCounter
+{
+ public:
+  /// Counts once every set bit of mask, bit i goes to bin i + offset
+  void addBits(uint64_t mask, int offset = 1)
+  {
+    for (; mask != 0; mask &= mask - 1) {
+      mCounts[__builtin_ctzll(mask) + offset]++;
+    }
+  }
+
+  /// Adds the counts to h and resets them, the values of the fills are the bin centres
+  void flush(TH1* h)
+  {
+    std::array<double, 4> s;
+    h->GetStats(s.data());
+    double entries = 0.;
+    const int nBins = h->GetXaxis()->GetNbins();
+    for (int bin = 0; bin < N; bin++) {
+      const double count = mCounts[bin];
+      if (count == 0.) {
+        continue;
+      }
+      mCounts[bin] = 0.;
+      entries += count;
+      const int target = bin <= nBins ? bin : nBins + 1;
+      h->AddBinContent(target, count);
+      if (h->GetSumw2N() > 0) {
+        (*h->GetSumw2())[target] += count;
+      }
+      if (target > 0 && target <= nBins) {
+        const double x = h->GetXaxis()->GetBinCenter(target);
+        s[0] += count;
+        s[1] += count;
+        s[2] += count * x;
+        s[3] += count * x * x;
+      }
+    }
+    if (entries > 0.) {
+      h->PutStats(s.data());
+      h->SetEntries(h->GetEntries() + entries);
+    }
+  }
+
+ private:
+  std::array<double, N> mCounts{}; ///< counts per bin, including the underflow bin 0
+};
+
+} // namespace o2::dpg
+
+#endif // DPG_TASKS_AOTTRACK_QAHISTOGRAMBUFFERS_H_
@@ -28,7 +28,7 @@
 #include "CommonUtils/NameConf.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Common/Core/TrackSelection.h"
-#include "DetectorsVertexing/PVertexer.h"
+#include "Common/Core/PVRefitter.h"
 #include "ReconstructionDataFormats/Vertex.h"
 #include "CCDB/BasicCCDBManager.h"
 #include "DataFormatsParameters/GRPMagField.h"
@@ -102,6 +102,7 @@ struct QaImpactPar {
   Configurable<uint16_t> maxPVcontrib{"maxPVcontrib", 10000, "Maximum number of PV contributors"};
   Configurable<bool> removeDiamondConstraint{"removeDiamondConstraint", true, "Remove the diamond constraint for the PV refit"};
   Configurable<bool> keepAllTracksPVrefit{"keepAllTracksPVrefit", false, "Keep all tracks for PV refit (for debug)"};
+  Configurable<bool> useDowndatePVrefit{"useDowndatePVrefit", false, "PV refit by removing the track from the linearised fit of the collision instead of rerunning the PVertexer"};
   Configurable<bool> use_customITSHitMap{"use_customITSHitMap", false, "Use custom ITS hitmap selection"};
   Configurable<int> customITShitmap{"customITShitmap", 0, "Custom ITS hitmap (consider the binary representation)"};
   Configurable<int> n_customMinITShits{"n_customMinITShits", 0, "Minimum number of layers crossed by a track among those in \"customITShitmap\""};
@@ -136,6 +137,7 @@ struct QaImpactPar {
   o2::base::MatLayerCylSet* lut = nullptr;
   // o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
   int mRunNumber;
+  o2::common::PVRefitter pvRefitter; // fit state of the current collision, the PVertexer is initialised once per magnetic field
 
   /////////////////////////////////////////////////////////////
   ///                   Process functions                   ///
@@ -227,6 +229,10 @@ struct QaImpactPar {
       ccdb->get<TGeoManager>(ccdbpath_geo);
     }
     mRunNumber = -1;
+    if (removeDiamondConstraint) {
+      o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); // we want to refit w/o MeanVertex constraint
+    }
+    pvRefitter.setUseDowndate(useDowndatePVrefit);
 
     /// Custom cut selection objects
     std::set<uint8_t> set_customITShitmap; // = {};
@@ -379,8 +385,6 @@ struct QaImpactPar {
       return;
     }
 
-    std::vector<bool> vec_useTrk_PVrefit(vec_globID_contr.size(), true);
-
     /// Prepare the vertex refitting
     // Get the magnetic field for the Propagator
     o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
@@ -402,13 +406,8 @@ struct QaImpactPar {
     Pvtx.setY(collision.posY());
     Pvtx.setZ(collision.posZ());
     Pvtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
-    // configure PVertexer
-    o2::vertexing::PVertexer vertexer;
-    if (removeDiamondConstraint) {
-      o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); // we want to refit w/o MeanVertex constraint
-    }
-    vertexer.init();
-    bool PVrefit_doable = vertexer.prepareVertexRefit(vec_TrkContributos, Pvtx);
+    // prepare the refits of all the tracks of the collision
+    bool PVrefit_doable = pvRefitter.prepare(Pvtx, vec_globID_contr, vec_TrkContributos);
     if (!PVrefit_doable) {
       LOG(info) << "Not enough tracks accepted for the refit";
       if (doPVrefit) {
@@ -535,18 +534,13 @@ struct QaImpactPar {
       bool recalc_imppar = false;
       if (doPVrefit && PVrefit_doable) {
         recalc_imppar = true;
-        auto it_trk = std::find(vec_globID_contr.begin(), vec_globID_contr.end(), track.globalIndex()); /// track global index
-        // if( it_trk==vec_globID_contr.end() ) {
-        //   /// not found: this track did not contribute to the initial PV fitting
-        //   continue;
-        // }
-        if (it_trk != vec_globID_contr.end()) {
+        if (pvRefitter.entry(track.globalIndex()) >= 0) {
           /// this track contributed to the PV fit: let's do the refit without it
-          const int entry = std::distance(vec_globID_contr.begin(), it_trk);
+          std::vector<int64_t> removedTracks;
           if (!keepAllTracksPVrefit) {
-            vec_useTrk_PVrefit[entry] = false; /// remove the track from the PV refitting
+            removedTracks.push_back(track.globalIndex()); /// remove the track from the PV refitting
           }
-          auto Pvtx_refitted = vertexer.refitVertex(vec_useTrk_PVrefit, Pvtx); // vertex refit
+          auto Pvtx_refitted = pvRefitter.refitWithout(removedTracks); // vertex refit
           if (fDebug) {
             LOG(info) << "refit " << cnt << "/" << ntr << " result = " << Pvtx_refitted.asString();
           }
@@ -562,9 +556,7 @@ struct QaImpactPar {
             histograms.fill(HIST("Reco/vertices_perTrack"), 3);
           }
           // histograms.fill(HIST("Reco/nContrib_vs_Chi2PVrefit"), /*Pvtx_refitted.getNContributors()*/collision.numContrib()-1, Pvtx_refitted.getChi2());
-          histograms.fill(HIST("Reco/nContrib_vs_Chi2PVrefit"), vec_useTrk_PVrefit.size() - 1, Pvtx_refitted.getChi2());
-
-          vec_useTrk_PVrefit[entry] = true; /// restore the track for the next PV refitting
+          histograms.fill(HIST("Reco/nContrib_vs_Chi2PVrefit"), pvRefitter.nContributors() - 1, Pvtx_refitted.getChi2());
 
           if (recalc_imppar) {
             // fill the histograms for refitted PV with good Chi2
@@ -25,8 +25,10 @@
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/EventSelection.h"
+#include "DPG/Core/skimSampling.h"
 
 #include "tofSkimsTableCreator.h"
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -49,45 +51,105 @@ struct tofSimsTableCreator {
   Configurable<int> applyEvSel{"applyEvSel", 2, "Flag to apply rapidity cut: 0 -> no event selection, 1 -> Run 2 event selection, 2 -> Run 3 event selection"};
   Configurable<int> applyTrkSel{"applyTrkSel", 1, "Flag to apply track selection: 0 -> no track selection, 1 -> track selection"};
   Configurable<float> fractionOfEvents{"fractionOfEvents", 0.1, "Fractions of events to keep"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "Seed of the random numbers of the sampling, 0 for a random seed"};
+  Configurable<std::vector<double>> reservoirBinsPt{"reservoirBinsPt", {0.5, 1., 2., 5.}, "pT bin edges of the reservoir sampling of the tracks"};
+  Configurable<std::vector<double>> reservoirBinsEta{"reservoirBinsEta", {-0.8, 0., 0.8}, "eta bin edges of the reservoir sampling of the tracks"};
+  Configurable<int> reservoirSize{"reservoirSize", -1, "Maximum number of tracks kept per collision in each (pT, eta) bin, <= 0 keeps all"};
+  Configurable<bool> requireTOF{"requireTOF", false, "Keep only the tracks with a TOF signal"};
+  Configurable<int> minEvTimeTOFMult{"minEvTimeTOFMult", 0, "Minimum number of tracks used for the TOF event time of the track, 0 for no requirement"};
+
+  o2::dpg::SkimRandom rng;
+  o2::dpg::BinnedReservoir<int64_t> reservoir; ///< indices of the sampled tracks of the collision
+  std::vector<uint8_t> selectedCollisions;     ///< decision of the event sampling and selection for each collision of the dataframe
+  std::vector<int64_t> selectedTracks;         ///< indices of the tracks to be written, in the order of the rows
 
   void init(o2::framework::InitContext& initContext)
   {
+    rng.setSeed(static_cast<uint64_t>(samplingSeed.value));
+    reservoir.init(reservoirBinsPt, reservoirBinsEta, reservoirSize);
   }
 
-  void process(Coll::iterator const& collision, Trks const& tracks)
+  template <typename T>
+  void fillTable(T const& trk)
   {
-    if (fractionOfEvents < 1.f && (static_cast<float>(rand()) / static_cast<float>(RAND_MAX)) > fractionOfEvents) { // Skip events that are not sampled
-      return;
-    }
+    tableRow(trk.p(),
+             trk.pt(),
+             trk.eta(),
+             trk.phi(),
+             trk.pidForTracking(),
+             trk.tofExpMom(),
+             trk.length(),
+             trk.tofChi2(),
+             trk.tofSignal());
+  }
 
+  bool isEventSelected(Coll::iterator const& collision)
+  {
     switch (applyEvSel.value) {
       case 0:
-        break;
+        return true;
       case 1:
-        if (!collision.sel7()) {
-          return;
-        }
-        break;
+        return collision.sel7();
       case 2:
-        if (!collision.sel8()) {
-          return;
-        }
-        break;
+        return collision.sel8();
       default:
         LOG(fatal) << "Invalid event selection flag: " << applyEvSel.value;
         break;
     }
-    tableRow.reserve(tracks.size());
+    return false;
+  }
+
+  /// Prefilter on the TOF matching and event time of the track
+  template <typename T>
+  bool isTrackSelected(T const& trk)
+  {
+    if (requireTOF && !trk.hasTOF()) {
+      return false;
+    }
+    if (minEvTimeTOFMult > 0 && trk.evTimeTOFMult() < minEvTimeTOFMult) {
+      return false;
+    }
+    return true;
+  }
+
+  /// Moves the tracks kept by the reservoir sampling of a collision to the tracks to be written
+  void flushReservoir()
+  {
+    reservoir.forEach([&](int64_t trackIndex) { selectedTracks.push_back(trackIndex); });
+    reservoir.reset();
+  }
+
+  void process(Coll const& collisions, Trks const& tracks)
+  {
+    // one decision per collision, the events which are not sampled are skipped before looking at their tracks
+    selectedCollisions.assign(collisions.size(), 0);
+    for (auto const& collision : collisions) {
+      selectedCollisions[collision.globalIndex()] = rng.keep(fractionOfEvents) && isEventSelected(collision);
+    }
+
+    // single pass over the tracks of the dataframe, which are grouped by collision: the reservoir is emptied at each new collision
+    selectedTracks.clear();
+    int64_t currentCollision = -1;
     for (auto const& trk : tracks) {
-      tableRow(trk.p(),
-               trk.pt(),
-               trk.eta(),
-               trk.phi(),
-               trk.pidForTracking(),
-               trk.tofExpMom(),
-               trk.length(),
-               trk.tofChi2(),
-               trk.tofSignal());
+      const int64_t collisionId = trk.collisionId();
+      if (collisionId < 0 || !selectedCollisions[collisionId] || !isTrackSelected(trk)) {
+        continue;
+      }
+      if (!reservoir.isEnabled()) {
+        selectedTracks.push_back(trk.globalIndex());
+        continue;
+      }
+      if (collisionId != currentCollision) {
+        flushReservoir();
+        currentCollision = collisionId;
+      }
+      reservoir.add(trk.pt(), trk.eta(), trk.globalIndex(), rng);
+    }
+    flushReservoir();
+
+    tableRow.reserve(selectedTracks.size());
+    for (const int64_t trackIndex : selectedTracks) {
+      fillTable(tracks.iteratorAt(trackIndex));
     }
   }
 };
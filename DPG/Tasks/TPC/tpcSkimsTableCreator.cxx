@@ -27,11 +27,12 @@
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/EventSelection.h"
+#include "DPG/Core/skimSampling.h"
 
 #include "tpcSkimsTableCreator.h"
-/// ROOT
-#include "TRandom3.h"
+#include <array>
 #include <cmath>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -60,6 +61,13 @@ struct TreeWriterTpcV0 {
   Configurable<float> downsamplingTsalisPions{"downsamplingTsalisPions", -1., "Downsampling factor to reduce the number of pions"};
   Configurable<float> downsamplingTsalisProtons{"downsamplingTsalisProtons", -1., "Downsampling factor to reduce the number of protons"};
   Configurable<float> downsamplingTsalisElectrons{"downsamplingTsalisElectrons", -1., "Downsampling factor to reduce the number of electrons"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "Seed of the random numbers of the downsampling, 0 for a random seed"};
+  /// Configurables reservoir sampling
+  Configurable<std::vector<double>> reservoirBinsPt{"reservoirBinsPt", {0.2, 0.5, 1., 2., 5.}, "pT bin edges of the reservoir sampling of the daughter tracks"};
+  Configurable<std::vector<double>> reservoirBinsEta{"reservoirBinsEta", {-0.8, 0., 0.8}, "eta bin edges of the reservoir sampling of the daughter tracks"};
+  Configurable<int> reservoirSize_Pi{"reservoirSize_Pi", -1, "Maximum number of pions kept per collision in each (pT, eta) bin, <= 0 keeps all"};
+  Configurable<int> reservoirSize_Pr{"reservoirSize_Pr", -1, "Maximum number of protons kept per collision in each (pT, eta) bin, <= 0 keeps all"};
+  Configurable<int> reservoirSize_El{"reservoirSize_El", -1, "Maximum number of electrons kept per collision in each (pT, eta) bin, <= 0 keeps all"};
   /// Configurables kaon
   Configurable<float> invariantMassCutK0Short{"invariantMassCutK0Short", 0.5, "Mass cut for K0short"};
   Configurable<float> cutQTK0min{"cutQTK0min", 0.1075, "Minimum qt for K0short"};
@@ -90,6 +98,20 @@ struct TreeWriterTpcV0 {
   Configurable<float> cutAlphaG2max{"cutAlphaG2max", 0.8, "maximum alpha gamma decay cut 2"};
   Configurable<float> cutQTG{"cutQTG", 0.04, "maximum qt gamma decay"};
 
+  /// Daughter track kept by the reservoir sampling until the end of the collision
+  struct V0Candidate {
+    int64_t v0Index = 0;  ///< index of the V0 in the V0s of the collision
+    bool positive = true; ///< positive or negative daughter
+    float nSigmaTPC = 0.f;
+    float nSigmaTOF = 0.f;
+    float dEdxExp = 0.f;
+    o2::track::PID::ID id = o2::track::PID::Pion;
+  };
+
+  o2::dpg::SkimRandom rng;
+  o2::dpg::TsallisDownsampler tsallisPions, tsallisProtons, tsallisElectrons;
+  std::array<o2::dpg::BinnedReservoir<V0Candidate>, o2::track::PID::NIDs> reservoirs; ///< per species
+
   /// Kaon selection
   template <typename C, typename V0>
   bool selectionKaon(C const& collision, V0 const& v0)
@@ -124,7 +146,7 @@ struct TreeWriterTpcV0 {
       return false;
     }
     /// Pion downsampling
-    if (downsamplingTsalisPions > 0. && downsampleTsalisCharged(track.pt(), downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion]) == 0) {
+    if (downsamplingTsalisPions > 0. && !tsallisPions.accept(track.pt(), rng)) {
       return false;
     }
     return true;
@@ -165,7 +187,7 @@ struct TreeWriterTpcV0 {
       return false;
     }
     /// Proton downsampling
-    if (downsamplingTsalisProtons > 0. && downsampleTsalisCharged(track.pt(), downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton]) == 0) {
+    if (downsamplingTsalisProtons > 0. && !tsallisProtons.accept(track.pt(), rng)) {
       return false;
     }
     return true;
@@ -235,15 +257,29 @@ struct TreeWriterTpcV0 {
   bool selectionElectron(T const& track)
   {
     /// Electron downsampling
-    if (downsamplingTsalisElectrons > 0. && downsampleTsalisCharged(track.pt(), downsamplingTsalisElectrons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Electron]) == 0) {
+    if (downsamplingTsalisElectrons > 0. && !tsallisElectrons.accept(track.pt(), rng)) {
       return false;
     }
     return true;
   }
 
-  /// Funktion to fill skimmed tables
+  /// Funktion to fill skimmed tables, the tracks are either written or offered to the reservoir of their species
   template <typename T, typename C, typename V0>
   void fillSkimmedV0Table(V0 const& v0, T const& track, C const& collision, const float nSigmaTPC, const float nSigmaTOF, const float dEdxExp, const o2::track::PID::ID id, double dwnSmplFactor)
+  {
+    if (!rng.keep(dwnSmplFactor)) {
+      return;
+    }
+    auto& reservoir = reservoirs[id];
+    if (reservoir.isEnabled()) {
+      reservoir.add(track.pt(), track.eta(), V0Candidate{v0.index(), track.globalIndex() == v0.posTrackId(), nSigmaTPC, nSigmaTOF, dEdxExp, id}, rng);
+      return;
+    }
+    writeSkimmedV0Row(v0, track, collision, nSigmaTPC, nSigmaTOF, dEdxExp, id);
+  };
+
+  template <typename T, typename C, typename V0>
+  void writeSkimmedV0Row(V0 const& v0, T const& track, C const& collision, const float nSigmaTPC, const float nSigmaTOF, const float dEdxExp, const o2::track::PID::ID id)
   {
 
     const double ncl = track.tpcNClsFound();
@@ -259,57 +295,27 @@ struct TreeWriterTpcV0 {
     const float v0radius = v0.v0radius();
     const float gammapsipair = v0.psipair();
 
-    const double pseudoRndm = track.pt() * 1000. - (long)(track.pt() * 1000);
-    if (pseudoRndm < dwnSmplFactor) {
-      rowTPCTree(track.tpcSignal(),
-                 1. / dEdxExp,
-                 track.tpcInnerParam(),
-                 track.tgl(),
-                 track.signed1Pt(),
-                 track.eta(),
-                 track.phi(),
-                 track.y(),
-                 mass,
-                 bg,
-                 multTPC / 11000.,
-                 std::sqrt(nClNorm / ncl),
-                 id,
-                 nSigmaTPC,
-                 nSigmaTOF,
-                 alpha,
-                 qt,
-                 cosPA,
-                 pT,
-                 v0radius,
-                 gammapsipair);
-    }
-  };
-
-  double tsalisCharged(double pt, double mass, double sqrts)
-  {
-    const double a = 6.81, b = 59.24;
-    const double c = 0.082, d = 0.151;
-    const double mt = std::sqrt(mass * mass + pt * pt);
-    const double n = a + b / sqrts;
-    const double T = c + d / sqrts;
-    const double p0 = n * T;
-    const double result = std::pow((1. + mt / p0), -n);
-    return result;
-  };
-
-  /// Random downsampling trigger function using Tsalis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
-  /// as in https://iopscience.iop.org/article/10.1088/2399-6528/aab00f/pdf
-  TRandom3* fRndm = new TRandom3(0);
-  int downsampleTsalisCharged(double pt, double factor1Pt, double sqrts, double mass)
-  {
-    const double prob = tsalisCharged(pt, mass, sqrts) * pt;
-    const double probNorm = tsalisCharged(1., mass, sqrts);
-    int triggerMask = 0;
-    if ((fRndm->Rndm() * ((prob / probNorm) * pt * pt)) < factor1Pt) {
-      triggerMask = 1;
-    }
-
-    return triggerMask;
+    rowTPCTree(track.tpcSignal(),
+               1. / dEdxExp,
+               track.tpcInnerParam(),
+               track.tgl(),
+               track.signed1Pt(),
+               track.eta(),
+               track.phi(),
+               track.y(),
+               mass,
+               bg,
+               multTPC / 11000.,
+               std::sqrt(nClNorm / ncl),
+               id,
+               nSigmaTPC,
+               nSigmaTOF,
+               alpha,
+               qt,
+               cosPA,
+               pT,
+               v0radius,
+               gammapsipair);
   };
 
   /// Event selection
@@ -330,6 +336,13 @@ struct TreeWriterTpcV0 {
 
   void init(o2::framework::InitContext& initContext)
   {
+    rng.setSeed(static_cast<uint64_t>(samplingSeed.value));
+    tsallisPions.init(downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion]);
+    tsallisProtons.init(downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton]);
+    tsallisElectrons.init(downsamplingTsalisElectrons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Electron]);
+    reservoirs[o2::track::PID::Pion].init(reservoirBinsPt, reservoirBinsEta, reservoirSize_Pi);
+    reservoirs[o2::track::PID::Proton].init(reservoirBinsPt, reservoirBinsEta, reservoirSize_Pr);
+    reservoirs[o2::track::PID::Electron].init(reservoirBinsPt, reservoirBinsEta, reservoirSize_El);
   }
 
   void process(Coll::iterator const& collision, Trks const& tracks, aod::V0Datas const& v0s)
@@ -382,8 +395,17 @@ struct TreeWriterTpcV0 {
         }
       }
     } /// Loop V0 candidates
-  }   /// process
-};    /// struct TreeWriterTpcV0
+
+    /// Write the daughter tracks kept by the reservoir sampling
+    for (auto& reservoir : reservoirs) {
+      reservoir.forEach([&](V0Candidate const& candidate) {
+        const auto& v0 = v0s.iteratorAt(candidate.v0Index);
+        writeSkimmedV0Row(v0, candidate.positive ? v0.posTrack_as<Trks>() : v0.negTrack_as<Trks>(), collision, candidate.nSigmaTPC, candidate.nSigmaTOF, candidate.dEdxExp, candidate.id);
+      });
+      reservoir.reset();
+    }
+  } /// process
+};  /// struct TreeWriterTpcV0
 
 struct TreeWriterTPCTOF {
   using Trks = soa::Join<aod::Tracks, aod::TracksExtra, aod::pidTPCFullEl, aod::pidTPCFullPi, aod::pidTPCFullKa, aod::pidTPCFullPr, aod::pidTOFFullEl, aod::pidTOFFullPi, aod::pidTOFFullKa, aod::pidTOFFullPr, aod::TrackSelection>;
@@ -419,65 +441,72 @@ struct TreeWriterTPCTOF {
   Configurable<float> downsamplingTsalisProtons{"downsamplingTsalisProtons", -1., "Downsampling factor to reduce the number of protons"};
   Configurable<float> downsamplingTsalisKaons{"downsamplingTsalisKaons", -1., "Downsampling factor to reduce the number of kaons"};
   Configurable<float> downsamplingTsalisPions{"downsamplingTsalisPions", -1., "Downsampling factor to reduce the number of pions"};
+  Configurable<int> samplingSeed{"samplingSeed", 0, "Seed of the random numbers of the downsampling, 0 for a random seed"};
+  /// Reservoir sampling
+  Configurable<std::vector<double>> reservoirBinsPt{"reservoirBinsPt", {0.2, 0.5, 1., 2., 5.}, "pT bin edges of the reservoir sampling of the tracks"};
+  Configurable<std::vector<double>> reservoirBinsEta{"reservoirBinsEta", {-0.8, 0., 0.8}, "eta bin edges of the reservoir sampling of the tracks"};
+  Configurable<int> reservoirSize_Pr{"reservoirSize_Pr", -1, "Maximum number of protons kept per collision in each (pT, eta) bin, <= 0 keeps all"};
+  Configurable<int> reservoirSize_Ka{"reservoirSize_Ka", -1, "Maximum number of kaons kept per collision in each (pT, eta) bin, <= 0 keeps all"};
+  Configurable<int> reservoirSize_Pi{"reservoirSize_Pi", -1, "Maximum number of pions kept per collision in each (pT, eta) bin, <= 0 keeps all"};
+
+  /// Track kept by the reservoir sampling until the end of the collision
+  struct TrackCandidate {
+    int64_t trackIndex = 0; ///< index of the track in the tracks table
+    float nSigmaTPC = 0.f;
+    float nSigmaTOF = 0.f;
+    float dEdxExp = 0.f;
+    o2::track::PID::ID id = o2::track::PID::Pion;
+  };
 
-  double tsalisCharged(double pt, double mass, double sqrts)
+  o2::dpg::SkimRandom rng;
+  o2::dpg::TsallisDownsampler tsallisProtons, tsallisKaons, tsallisPions;
+  std::array<o2::dpg::BinnedReservoir<TrackCandidate>, o2::track::PID::NIDs> reservoirs; ///< per species
+  std::vector<uint8_t> selectedCollisions;                                                  ///< event selection decision of each collision of the dataframe
+
+  /// Random pT dependent downsampling, a negative factor keeps all the tracks
+  bool downsampleTsalisCharged(double pt, o2::dpg::TsallisDownsampler const& downsampler)
   {
-    const double a = 6.81, b = 59.24;
-    const double c = 0.082, d = 0.151;
-    double mt = std::sqrt(mass * mass + pt * pt);
-    double n = a + b / sqrts;
-    double T = c + d / sqrts;
-    double p0 = n * T;
-    double result = pow((1. + mt / p0), -n);
-    return result;
+    return downsampler.factor() < 0. || downsampler.accept(pt, rng);
   };
 
-  /// Random downsampling trigger function using Tsalis/Hagedorn spectra fit (sqrt(s) = 62.4 GeV to 13 TeV)
-  /// as in https://iopscience.iop.org/article/10.1088/2399-6528/aab00f/pdf
-  TRandom3* fRndm = new TRandom3(0);
-  bool downsampleTsalisCharged(double pt, float factor1Pt, double sqrts, double mass)
+  /// Function to fill trees, the tracks are either written or offered to the reservoir of their species
+  template <typename T>
+  void fillSkimmedTPCTOFTable(T const& track, const int multTPC, const float nSigmaTPC, const float nSigmaTOF, const float dEdxExp, const o2::track::PID::ID id, double dwnSmplFactor)
   {
-    if (factor1Pt < 0.) {
-      return true;
+    if (!rng.keep(dwnSmplFactor)) {
+      return;
     }
-    const double prob = tsalisCharged(pt, mass, sqrts) * pt;
-    const double probNorm = tsalisCharged(1., mass, sqrts);
-    if ((fRndm->Rndm() * ((prob / probNorm) * pt * pt)) > factor1Pt) {
-      return false;
-    } else {
-      return true;
+    auto& reservoir = reservoirs[id];
+    if (reservoir.isEnabled()) {
+      reservoir.add(track.pt(), track.eta(), TrackCandidate{track.globalIndex(), nSigmaTPC, nSigmaTOF, dEdxExp, id}, rng);
+      return;
     }
+    writeSkimmedTPCTOFRow(track, multTPC, nSigmaTPC, nSigmaTOF, dEdxExp, id);
   };
 
-  /// Function to fill trees
-  template <typename T, typename C>
-  void fillSkimmedTPCTOFTable(T const& track, C const& collision, const float nSigmaTPC, const float nSigmaTOF, const float dEdxExp, const o2::track::PID::ID id, double dwnSmplFactor)
+  template <typename T>
+  void writeSkimmedTPCTOFRow(T const& track, const int multTPC, const float nSigmaTPC, const float nSigmaTOF, const float dEdxExp, const o2::track::PID::ID id)
   {
-
     const double ncl = track.tpcNClsFound();
     const double p = track.tpcInnerParam();
     const double mass = o2::track::pid_constants::sMasses[id];
     const double bg = p / mass;
-    const int multTPC = collision.multTPC();
 
-    const double pseudoRndm = track.pt() * 1000. - (long)(track.pt() * 1000);
-    if (pseudoRndm < dwnSmplFactor) {
-      rowTPCTOFTree(track.tpcSignal(),
-                    1. / dEdxExp,
-                    track.tpcInnerParam(),
-                    track.tgl(),
-                    track.signed1Pt(),
-                    track.eta(),
-                    track.phi(),
-                    track.y(),
-                    mass,
-                    bg,
-                    multTPC / 11000.,
-                    std::sqrt(nClNorm / ncl),
-                    id,
-                    nSigmaTPC,
-                    nSigmaTOF);
-    }
+    rowTPCTOFTree(track.tpcSignal(),
+                  1. / dEdxExp,
+                  track.tpcInnerParam(),
+                  track.tgl(),
+                  track.signed1Pt(),
+                  track.eta(),
+                  track.phi(),
+                  track.y(),
+                  mass,
+                  bg,
+                  multTPC / 11000.,
+                  std::sqrt(nClNorm / ncl),
+                  id,
+                  nSigmaTPC,
+                  nSigmaTOF);
   };
 
   /// Event selection
@@ -497,8 +526,8 @@ struct TreeWriterTPCTOF {
   };
 
   /// Track selection
-  template <typename CollisionType, typename TrackType>
-  bool isTrackSelected(const CollisionType& collision, const TrackType& track)
+  template <typename TrackType>
+  bool isTrackSelected(const TrackType& track)
   {
     if (!track.isGlobalTrack()) { // Skipping non global tracks
       return false;
@@ -514,41 +543,78 @@ struct TreeWriterTPCTOF {
 
   void init(o2::framework::InitContext& initContext)
   {
+    rng.setSeed(static_cast<uint64_t>(samplingSeed.value));
+    tsallisProtons.init(downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton]);
+    tsallisKaons.init(downsamplingTsalisKaons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Kaon]);
+    tsallisPions.init(downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion]);
+    reservoirs[o2::track::PID::Proton].init(reservoirBinsPt, reservoirBinsEta, reservoirSize_Pr);
+    reservoirs[o2::track::PID::Kaon].init(reservoirBinsPt, reservoirBinsEta, reservoirSize_Ka);
+    reservoirs[o2::track::PID::Pion].init(reservoirBinsPt, reservoirBinsEta, reservoirSize_Pi);
+  }
+
+  /// Writes the tracks kept by the reservoir sampling of a collision
+  template <typename TrackType>
+  void flushReservoirs(TrackType const& tracks, const int multTPC)
+  {
+    for (auto& reservoir : reservoirs) {
+      reservoir.forEach([&](TrackCandidate const& candidate) {
+        const auto& trk = tracks.iteratorAt(candidate.trackIndex);
+        writeSkimmedTPCTOFRow(trk, multTPC, candidate.nSigmaTPC, candidate.nSigmaTOF, candidate.dEdxExp, candidate.id);
+      });
+      reservoir.reset();
+    }
   }
-  void process(Coll::iterator const& collision, Trks const& tracks)
+
+  void process(Coll const& collisions, Trks const& tracks)
   {
-    /// Check event selection
-    if (!isEventSelected(collision, tracks)) {
-      return;
+    /// Event selection of all the collisions of the dataframe, before the pass over the tracks
+    selectedCollisions.assign(collisions.size(), 0);
+    for (auto const& collision : collisions) {
+      selectedCollisions[collision.globalIndex()] = isEventSelected(collision, tracks);
     }
+
+    /// Single pass over the tracks, which are grouped by collision: the reservoirs are written at each new collision
     rowTPCTOFTree.reserve(tracks.size());
+    int64_t currentCollision = -1;
+    int multTPC = 0;
     for (auto const& trk : tracks) {
+      const int64_t collisionId = trk.collisionId();
+      if (collisionId < 0 || !selectedCollisions[collisionId]) {
+        continue;
+      }
+      if (collisionId != currentCollision) {
+        flushReservoirs(tracks, multTPC);
+        currentCollision = collisionId;
+        multTPC = collisions.iteratorAt(collisionId).multTPC();
+      }
 
       /// Check track selection
-      if (applyTrkSel == 1 && !isTrackSelected(collision, trk)) {
+      if (applyTrkSel == 1 && !isTrackSelected(trk)) {
         continue;
       }
       /// Fill tree for protons
-      if (trk.tpcInnerParam() < maxMomTPCOnlyPr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPCOnlyPr && downsampleTsalisCharged(trk.pt(), downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton])) {
-        fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPr(), trk.tofNSigmaPr(), trk.tpcExpSignalPr(trk.tpcSignal()), o2::track::PID::Proton, dwnSmplFactor_Pr);
-      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPr && std::abs(trk.tofNSigmaPr()) < nSigmaTOF_TPCTOF_Pr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPC_TPCTOF_Pr && downsampleTsalisCharged(trk.pt(), downsamplingTsalisProtons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Proton])) {
-        fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPr(), trk.tofNSigmaPr(), trk.tpcExpSignalPr(trk.tpcSignal()), o2::track::PID::Proton, dwnSmplFactor_Pr);
+      if (trk.tpcInnerParam() < maxMomTPCOnlyPr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPCOnlyPr && downsampleTsalisCharged(trk.pt(), tsallisProtons)) {
+        fillSkimmedTPCTOFTable(trk, multTPC, trk.tpcNSigmaPr(), trk.tofNSigmaPr(), trk.tpcExpSignalPr(trk.tpcSignal()), o2::track::PID::Proton, dwnSmplFactor_Pr);
+      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPr && std::abs(trk.tofNSigmaPr()) < nSigmaTOF_TPCTOF_Pr && std::abs(trk.tpcNSigmaPr()) < nSigmaTPC_TPCTOF_Pr && downsampleTsalisCharged(trk.pt(), tsallisProtons)) {
+        fillSkimmedTPCTOFTable(trk, multTPC, trk.tpcNSigmaPr(), trk.tofNSigmaPr(), trk.tpcExpSignalPr(trk.tpcSignal()), o2::track::PID::Proton, dwnSmplFactor_Pr);
       }
       /// Fill tree for kaons
-      if (trk.tpcInnerParam() < maxMomTPCOnlyKa && std::abs(trk.tpcNSigmaKa()) < nSigmaTPCOnlyKa && downsampleTsalisCharged(trk.pt(), downsamplingTsalisKaons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Kaon])) {
-        fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaKa(), trk.tofNSigmaKa(), trk.tpcExpSignalKa(trk.tpcSignal()), o2::track::PID::Kaon, dwnSmplFactor_Ka);
-      } else if (trk.tpcInnerParam() > maxMomTPCOnlyKa && std::abs(trk.tofNSigmaKa()) < nSigmaTOF_TPCTOF_Ka && std::abs(trk.tpcNSigmaKa()) < nSigmaTPC_TPCTOF_Ka && downsampleTsalisCharged(trk.pt(), downsamplingTsalisKaons, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Kaon])) {
-        fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaKa(), trk.tofNSigmaKa(), trk.tpcExpSignalKa(trk.tpcSignal()), o2::track::PID::Kaon, dwnSmplFactor_Ka);
+      if (trk.tpcInnerParam() < maxMomTPCOnlyKa && std::abs(trk.tpcNSigmaKa()) < nSigmaTPCOnlyKa && downsampleTsalisCharged(trk.pt(), tsallisKaons)) {
+        fillSkimmedTPCTOFTable(trk, multTPC, trk.tpcNSigmaKa(), trk.tofNSigmaKa(), trk.tpcExpSignalKa(trk.tpcSignal()), o2::track::PID::Kaon, dwnSmplFactor_Ka);
+      } else if (trk.tpcInnerParam() > maxMomTPCOnlyKa && std::abs(trk.tofNSigmaKa()) < nSigmaTOF_TPCTOF_Ka && std::abs(trk.tpcNSigmaKa()) < nSigmaTPC_TPCTOF_Ka && downsampleTsalisCharged(trk.pt(), tsallisKaons)) {
+        fillSkimmedTPCTOFTable(trk, multTPC, trk.tpcNSigmaKa(), trk.tofNSigmaKa(), trk.tpcExpSignalKa(trk.tpcSignal()), o2::track::PID::Kaon, dwnSmplFactor_Ka);
       }
       /// Fill tree pions
-      if (trk.tpcInnerParam() < maxMomTPCOnlyPi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPCOnlyPi && downsampleTsalisCharged(trk.pt(), downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion])) {
-        fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPi(), trk.tofNSigmaPi(), trk.tpcExpSignalPi(trk.tpcSignal()), o2::track::PID::Pion, dwnSmplFactor_Pi);
-      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPi && std::abs(trk.tofNSigmaPi()) < nSigmaTOF_TPCTOF_Pi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPC_TPCTOF_Pi && downsampleTsalisCharged(trk.pt(), downsamplingTsalisPions, sqrtSNN, o2::track::pid_constants::sMasses[o2::track::PID::Pion])) {
-        fillSkimmedTPCTOFTable(trk, collision, trk.tpcNSigmaPi(), trk.tofNSigmaPi(), trk.tpcExpSignalPi(trk.tpcSignal()), o2::track::PID::Pion, dwnSmplFactor_Pi);
+      if (trk.tpcInnerParam() < maxMomTPCOnlyPi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPCOnlyPi && downsampleTsalisCharged(trk.pt(), tsallisPions)) {
+        fillSkimmedTPCTOFTable(trk, multTPC, trk.tpcNSigmaPi(), trk.tofNSigmaPi(), trk.tpcExpSignalPi(trk.tpcSignal()), o2::track::PID::Pion, dwnSmplFactor_Pi);
+      } else if (trk.tpcInnerParam() > maxMomTPCOnlyPi && std::abs(trk.tofNSigmaPi()) < nSigmaTOF_TPCTOF_Pi && std::abs(trk.tpcNSigmaPi()) < nSigmaTPC_TPCTOF_Pi && downsampleTsalisCharged(trk.pt(), tsallisPions)) {
+        fillSkimmedTPCTOFTable(trk, multTPC, trk.tpcNSigmaPi(), trk.tofNSigmaPi(), trk.tpcExpSignalPi(trk.tpcSignal()), o2::track::PID::Pion, dwnSmplFactor_Pi);
       }
     } /// Loop tracks
-  }   /// process
-};    /// struct TreeWriterTPCTOF
+
+    flushReservoirs(tracks, multTPC);
+  } /// process
+};  /// struct TreeWriterTPCTOF
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
 {
@@ -36,6 +36,7 @@
 
 #include <string>
 #include <bitset>
+#include <vector>
 
 namespace
 {
@@ -88,6 +89,7 @@ struct CFFilter {
   Configurable<bool> performCPR{"performCPR", true, "Perform or not the close pair rejection"};
   Configurable<float> ldeltaPhiMax{"ldeltaPhiMax", 0.010, "Max limit of delta phi"};
   Configurable<float> ldeltaEtaMax{"ldeltaEtaMax", 0.010, "Max limit of delta eta"};
+  Configurable<bool> pruneTriplets{"pruneTriplets", false, "Search the triplets from the pairs below the Q3 limit and stop at the first triplet found; the Q3 and close pair rejection histograms then only contain the triplets below the limit"};
 
   // Obtain particle and antiparticle candidates of protons and lambda hyperons for current femto collision
   Partition<o2::aod::FemtoDreamParticles> partsProton0Part = (o2::aod::femtodreamparticle::partType == Track) && ((o2::aod::femtodreamparticle::cut & kSignPlusMask) > kValue0); // Consider later: && ((o2::aod::femtodreamparticle::pidcut & knSigmaProton) > kValue0);
@@ -178,6 +180,133 @@ struct CFFilter {
   float mMassProton = TDatabasePDG::Instance()->GetParticle(2212)->Mass();
   float mMassLambda = TDatabasePDG::Instance()->GetParticle(3122)->Mass();
 
+  /// Four-momentum of a particle, computed as in FemtoDreamMath::getQ3
+  template <typename T>
+  static ROOT::Math::PxPyPzEVector getFourMomentum(T const& part, const float mass)
+  {
+    float E = sqrt(pow(part.px(), 2) + pow(part.py(), 2) + pow(part.pz(), 2) + pow(mass, 2));
+    return ROOT::Math::PxPyPzEVector(part.px(), part.py(), part.pz(), E);
+  }
+
+  /// Selected particles of one species of a collision with their four-momenta
+  template <typename TParts>
+  struct TripletCandidates {
+    std::vector<typename TParts::iterator> particles;
+    std::vector<ROOT::Math::PxPyPzEVector> momenta;
+  };
+
+  template <typename TParts, typename TSelection>
+  TripletCandidates<TParts> getTripletCandidates(TParts const& parts, const float mass, TSelection isSelected)
+  {
+    TripletCandidates<TParts> candidates;
+    for (auto& part : parts) {
+      if (isSelected(part)) {
+        candidates.particles.push_back(part);
+        candidates.momenta.push_back(getFourMomentum(part, mass));
+      }
+    }
+    return candidates;
+  }
+
+  /// q_ij^2 of all the pairs of particles of two lists, [i * n2 + j]
+  static std::vector<double> getPairQ2(std::vector<ROOT::Math::PxPyPzEVector> const& momenta1, std::vector<ROOT::Math::PxPyPzEVector> const& momenta2)
+  {
+    std::vector<double> pairQ2(momenta1.size() * momenta2.size());
+    for (size_t i = 0; i < momenta1.size(); i++) {
+      for (size_t j = 0; j < momenta2.size(); j++) {
+        pairQ2[i * momenta2.size() + j] = FemtoDreamMath::getqij(momenta1[i], momenta2[j]).M2();
+      }
+    }
+    return pairQ2;
+  }
+
+  /// Looks for a triplet of particles of the lists 1, 2 and 3 with Q3 below the limit and passing isGoodTriplet.
+  /// Q3^2 = -(q12^2 + q23^2 + q31^2) is a sum of non-negative pair terms, so a pair above the limit is not extended
+  /// with a third particle and the Q3 of a triplet is the sum of the precomputed pair terms.
+  /// Lists 1 and 2 (2 and 3) are the same list, combined without repetition, if same12 (same23) is set.
+  template <typename TGoodTriplet>
+  bool hasLowQ3Triplet(std::vector<double> const& q12, std::vector<double> const& q23, std::vector<double> const& q13, int n1, int n2, int n3, bool same12, bool same23, float limit, std::shared_ptr<TH1> hQ3, TGoodTriplet isGoodTriplet)
+  {
+    const double limit2 = limit * limit;
+    for (int i = 0; i < n1; i++) {
+      for (int j = same12 ? i + 1 : 0; j < n2; j++) {
+        const double q2Pair = q12[i * n2 + j];
+        if (-q2Pair >= limit2) {
+          continue;
+        }
+        for (int k = same23 ? j + 1 : 0; k < n3; k++) {
+          if (-(q2Pair + q23[j * n3 + k]) >= limit2) {
+            continue;
+          }
+          float Q32 = q2Pair + q23[j * n3 + k] + q13[i * n3 + k];
+          float Q3 = sqrt(-Q32);
+          if (Q3 < limit && isGoodTriplet(i, j, k)) {
+            hQ3->Fill(Q3);
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  /// Trigger decisions of pruneTriplets, with the same selections as the nested loops of process
+  template <typename TParts>
+  void searchTripletsPruned(TParts const& partsProton0, TParts const& partsLambda0, TParts const& partsProton1, TParts const& partsLambda1, o2::aod::FemtoDreamParticles const& partsFemto, float magneticField, std::vector<float> const& Q3TriggerLimit, int* lowQ3Triplets)
+  {
+    auto isProton = [&](auto const& part) { return isFullPIDSelectedProton(part.pidcut(), part.p()); };
+    auto isLambda = [&](auto const& part) { return pairCleanerTV.isCleanPair(part, part, partsFemto); };
+    const bool runPPP = Q3Trigger == 0 || Q3Trigger == 1111 || Q3Trigger == 11;
+    const bool runPPL = Q3Trigger == 1 || Q3Trigger == 1111 || Q3Trigger == 11;
+    const bool runPLL = Q3Trigger == 2 || Q3Trigger == 1111;
+    const bool runLLL = Q3Trigger == 3 || Q3Trigger == 1111;
+
+    // index 0 for the particles, 1 for the antiparticles, which are only looked at if no particle triplet is found
+    TParts const* partsProton[2] = {&partsProton0, &partsProton1};
+    TParts const* partsLambda[2] = {&partsLambda0, &partsLambda1};
+
+    for (int iCharge = 0; iCharge < 2; iCharge++) {
+      auto protons = getTripletCandidates(*partsProton[iCharge], mMassProton, isProton);
+      auto lambdas = getTripletCandidates(*partsLambda[iCharge], mMassLambda, isLambda);
+      const int nP = protons.particles.size();
+      const int nL = lambdas.particles.size();
+      const auto qPP = getPairQ2(protons.momenta, protons.momenta);
+      const auto qPL = getPairQ2(protons.momenta, lambdas.momenta);
+      const auto qLL = getPairQ2(lambdas.momenta, lambdas.momenta);
+      auto isClosePP = [&](int i, int j) { return performCPR && closePairRejectionTT.isClosePair(protons.particles[i], protons.particles[j], partsFemto, magneticField); };
+      auto isClosePL = [&](int i, int j) { return performCPR && closePairRejectionTV0.isClosePair(protons.particles[i], lambdas.particles[j], partsFemto, magneticField); };
+
+      if (runPPP && lowQ3Triplets[0] == 0 && nP >= 3) {
+        auto isGood = [&](int i, int j, int k) { return !isClosePP(i, j) && !isClosePP(i, k) && !isClosePP(j, k); };
+        lowQ3Triplets[0] += hasLowQ3Triplet(qPP, qPP, qPP, nP, nP, nP, true, true, Q3TriggerLimit.at(0), iCharge == 0 ? registry.get<TH1>(HIST("fSameEventPartPPP")) : registry.get<TH1>(HIST("fSameEventAntiPartPPP")), isGood);
+      }
+      if (runPPL && lowQ3Triplets[1] == 0 && nP >= 2 && partsLambda[iCharge]->size() >= 1) {
+        for (auto& partLambda : *partsLambda[iCharge]) {
+          if (iCharge == 0) {
+            registry.get<TH1>(HIST("fPtPPL"))->Fill(partLambda.pt());
+            registry.get<TH1>(HIST("fMinvLambda"))->Fill(partLambda.mLambda());
+          } else {
+            registry.get<TH1>(HIST("fPtAntiPPL"))->Fill(partLambda.pt());
+            registry.get<TH1>(HIST("fMinvAntiLambda"))->Fill(partLambda.mAntiLambda());
+          }
+        }
+      }
+      if (runPPL && lowQ3Triplets[1] == 0 && nP >= 2 && nL >= 1) {
+        // q_23 and q_31 of a (p, p, Lambda) triplet are proton-Lambda terms
+        auto isGood = [&](int i, int j, int k) { return !isClosePP(i, j) && !isClosePL(i, k) && !isClosePL(j, k); };
+        lowQ3Triplets[1] += hasLowQ3Triplet(qPP, qPL, qPL, nP, nP, nL, true, false, Q3TriggerLimit.at(1), iCharge == 0 ? registry.get<TH1>(HIST("fSameEventPartPPL")) : registry.get<TH1>(HIST("fSameEventAntiPartPPL")), isGood);
+      }
+      if (runPLL && lowQ3Triplets[2] == 0 && nP >= 1 && nL >= 2) {
+        auto isGood = [&](int i, int j, int k) { return !isClosePL(i, j) && !isClosePL(i, k); };
+        lowQ3Triplets[2] += hasLowQ3Triplet(qPL, qLL, qPL, nP, nL, nL, false, true, Q3TriggerLimit.at(2), iCharge == 0 ? registry.get<TH1>(HIST("fSameEventPartPLL")) : registry.get<TH1>(HIST("fSameEventAntiPartPLL")), isGood);
+      }
+      if (runLLL && lowQ3Triplets[3] == 0 && nL >= 3) {
+        auto isGood = [&](int, int, int) { return true; };
+        lowQ3Triplets[3] += hasLowQ3Triplet(qLL, qLL, qLL, nL, nL, nL, true, true, Q3TriggerLimit.at(3), iCharge == 0 ? registry.get<TH1>(HIST("fSameEventPartLLL")) : registry.get<TH1>(HIST("fSameEventAntiPartLLL")), isGood);
+      }
+    }
+  }
+
   void process(o2::aod::FemtoDreamCollision& col, o2::aod::FemtoDreamParticles& partsFemto)
   {
     auto partsProton0 = partsProton0Part->sliceByCached(aod::femtodreamparticle::femtoDreamCollisionId, col.globalIndex());
@@ -215,9 +344,12 @@ struct CFFilter {
       registry.get<TH1>(HIST("fMultiplicityAfter"))->Fill(col.multV0M());
       registry.get<TH1>(HIST("fZvtxAfter"))->Fill(col.posZ());
       auto Q3TriggerLimit = (std::vector<float>)confQ3TriggerLimit;
+      if (pruneTriplets) {
+        searchTripletsPruned(partsProton0, partsLambda0, partsProton1, partsLambda1, partsFemto, magneticField, Q3TriggerLimit, lowQ3Triplets);
+      }
       // __________________________________________________________________________________________________________
       // TRIGGER FOR PPP TRIPLETS
-      if (Q3Trigger == 0 || Q3Trigger == 1111 || Q3Trigger == 11) {
+      if (!pruneTriplets && (Q3Trigger == 0 || Q3Trigger == 1111 || Q3Trigger == 11)) {
         if (prot >= 3) {
           // test default combinations options
           for (auto& [p1, p2, p3] : combinations(partsProton0, partsProton0, partsProton0)) {
@@ -277,7 +409,7 @@ struct CFFilter {
       }
       // __________________________________________________________________________________________________________
       // TRIGGER FOR PPL TRIPLETS
-      if (Q3Trigger == 1 || Q3Trigger == 1111 || Q3Trigger == 11) {
+      if (!pruneTriplets && (Q3Trigger == 1 || Q3Trigger == 1111 || Q3Trigger == 11)) {
         if (partsLambda0.size() >= 1 && prot >= 2) {
           for (auto& partLambda : partsLambda0) {
             registry.get<TH1>(HIST("fPtPPL"))->Fill(partLambda.pt());
@@ -345,7 +477,7 @@ struct CFFilter {
 
       // __________________________________________________________________________________________________________
       // TRIGGER FOR PLL TRIPLETS
-      if (Q3Trigger == 2 || Q3Trigger == 1111) {
+      if (!pruneTriplets && (Q3Trigger == 2 || Q3Trigger == 1111)) {
         if (partsLambda0.size() >= 2 && prot >= 1) {
           for (auto& p1 : partsProton0) {
             if (!isFullPIDSelectedProton(p1.pidcut(), p1.p())) {
@@ -415,7 +547,7 @@ struct CFFilter {
 
       // __________________________________________________________________________________________________________
       // TRIGGER FOR LLL TRIPLETS
-      if (Q3Trigger == 3 || Q3Trigger == 1111) {
+      if (!pruneTriplets && (Q3Trigger == 3 || Q3Trigger == 1111)) {
         if (partsLambda0.size() >= 3) {
           // test default combinations options
           for (auto& [partLambda1, partLambda2, partLambda3] : combinations(partsLambda0, partsLambda0, partsLambda0)) {
@@ -111,6 +111,13 @@ struct HfFilter { // Main struct for HF triggers
 
   // parameters for ML application with ONNX
   Configurable<bool> applyML{"applyML", false, "Flag to enable or disable ML application"};
+  Configurable<bool> applyMLBatched{"applyMLBatched", false, "Flag to run the ML inference once per charm species on all the preselected candidates of the collision"};
+  Configurable<int> mlOptimizationLevel{"mlOptimizationLevel", 99, "ONNX graph optimisation level: 0 disabled, 1 basic, 2 extended, 99 all"};
+  Configurable<int> mlIntraOpNumThreads{"mlIntraOpNumThreads", 1, "Number of threads used by ONNX runtime inside one operator (0: ONNX runtime default)"};
+  Configurable<int> mlInterOpNumThreads{"mlInterOpNumThreads", 0, "Number of threads used by ONNX runtime to run independent operators in parallel (0: sequential execution)"};
+  Configurable<std::string> mlExecutionProviders{"mlExecutionProviders", "", "Comma-separated ONNX execution providers to try, e.g. XNNPACK, the unavailable ones are skipped"};
+  Configurable<std::string> mlModelVariant{"mlModelVariant", "", "Quantised variant of the models, e.g. int8 or fp16, read from the ONNX files and CCDB paths with the _<variant> suffix (empty for FP32)"};
+  Configurable<bool> mlValidateModelVariant{"mlValidateModelVariant", false, "Run also the FP32 reference models and fill the difference of the scores of the model variant (batched ML application only)"};
   Configurable<std::vector<double>> pTBinsBDT{"pTBinsBDT", std::vector<double>{hf_cuts_bdt_multiclass::vecBinsPt}, "track pT bin limits for BDT cut"};
 
   Configurable<std::string> onnxFileD0ToKPiConf{"onnxFileD0ToKPiConf", "XGBoostModel.onnx", "ONNX file for ML model for D0 candidates"};
@@ -156,6 +163,7 @@ struct HfFilter { // Main struct for HF triggers
   std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTScoreBkg{};
   std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTScorePrompt{};
   std::array<std::shared_ptr<TH1>, kNCharmParticles> hBDTScoreNonPrompt{};
+  std::array<std::shared_ptr<TH2>, kNCharmParticles> hBDTScoreVariantDiff{};
 
   // ONNX
   std::array<std::vector<std::string>, kNCharmParticles> inputNamesML{};
@@ -163,6 +171,22 @@ struct HfFilter { // Main struct for HF triggers
   std::array<std::vector<std::string>, kNCharmParticles> outputNamesML{};
   std::array<std::shared_ptr<Ort::Experimental::Session>, kNCharmParticles> sessionML = {nullptr, nullptr, nullptr, nullptr, nullptr};
   std::array<int, kNCharmParticles> dataTypeML{};
+  // batched ML application: input features and output scores of the preselected candidates of the collision
+  std::array<std::vector<float>, kNCharmParticles> featuresML{};
+  std::array<std::vector<double>, kNCharmParticles> featuresMLDouble{};
+  std::array<std::vector<float>, kNCharmParticles> scoresML{};
+  std::array<std::vector<double>, kNCharmParticles> scoresMLDouble{};
+  std::array<std::size_t, kNCharmParticles> nCandidatesML{};
+  // validation of a model variant against the FP32 reference models
+  o2::common::OnnxSessionConfig sessionConfigML;
+  bool validateModelVariant = false;
+  std::array<std::vector<std::string>, kNCharmParticles> inputNamesMLRef{};
+  std::array<std::vector<std::vector<int64_t>>, kNCharmParticles> inputShapesMLRef{};
+  std::array<std::vector<std::string>, kNCharmParticles> outputNamesMLRef{};
+  std::array<std::shared_ptr<Ort::Experimental::Session>, kNCharmParticles> sessionMLRef = {nullptr, nullptr, nullptr, nullptr, nullptr};
+  std::array<int, kNCharmParticles> dataTypeMLRef{};
+  std::array<std::vector<float>, kNCharmParticles> scoresMLRef{};
+  std::array<std::vector<double>, kNCharmParticles> scoresMLDoubleRef{};
 
   void init(o2::framework::InitContext&)
   {
@@ -216,18 +240,51 @@ struct HfFilter { // Main struct for HF triggers
       onnxFileXicToPiKPConf};
 
     // init ONNX runtime session
-    if (applyML && (!loadModelsFromCCDB || timestampCCDB != 0)) {
-      for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
-        if (onnxFiles[iCharmPart] != "") {
-          sessionML[iCharmPart] = InitONNXSession(onnxFiles[iCharmPart], charmParticleNames[iCharmPart], inputNamesML[iCharmPart], inputShapesML[iCharmPart], outputNamesML[iCharmPart], dataTypeML[iCharmPart], loadModelsFromCCDB, ccdbApi, mlModelPathCCDB.value, timestampCCDB);
-        }
+    sessionConfigML.optimizationLevel = mlOptimizationLevel;
+    sessionConfigML.intraOpNumThreads = mlIntraOpNumThreads;
+    sessionConfigML.interOpNumThreads = mlInterOpNumThreads;
+    sessionConfigML.executionProviders = mlExecutionProviders;
+    sessionConfigML.modelVariant = mlModelVariant;
+    validateModelVariant = applyML && mlValidateModelVariant && !sessionConfigML.modelVariant.empty();
+    if (validateModelVariant && !applyMLBatched) {
+      LOG(warning) << "The validation of the model variant is only available with the batched ML application, it is disabled.";
+      validateModelVariant = false;
+    }
+    if (validateModelVariant) {
+      for (int iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+        hBDTScoreVariantDiff[iCharmPart] = registry.add<TH2>(Form("f%sBDTScoreVariantDiff", charmParticleNames[iCharmPart].data()), Form("BDT scores of the %s model minus FP32 reference for %s;score class;score difference;counts", sessionConfigML.modelVariant.data(), charmParticleNames[iCharmPart].data()), HistType::kTH2F, {{3, -0.5, 2.5}, {200, -0.1, 0.1}});
       }
     }
+    if (applyML && (!loadModelsFromCCDB || timestampCCDB != 0)) {
+      initSessionsML();
+    }
     // safety for optimisation tree
     if (applyOptimisation && !applyML) {
       LOG(fatal) << "Can't apply optimisation if ML is not applied.";
     }
   }
+
+  /// Initialisation of the ONNX sessions of the charm-hadron species, and of the FP32 reference ones when a model variant is validated
+  void initSessionsML()
+  {
+    auto referenceConfig = sessionConfigML;
+    referenceConfig.modelVariant = "";
+    for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+      if (onnxFiles[iCharmPart] == "") {
+        continue;
+      }
+      sessionML[iCharmPart] = InitONNXSession(onnxFiles[iCharmPart], charmParticleNames[iCharmPart], inputNamesML[iCharmPart], inputShapesML[iCharmPart], outputNamesML[iCharmPart], dataTypeML[iCharmPart], loadModelsFromCCDB, ccdbApi, mlModelPathCCDB.value, timestampCCDB, sessionConfigML);
+      if (validateModelVariant) {
+        sessionMLRef[iCharmPart] = InitONNXSession(onnxFiles[iCharmPart], charmParticleNames[iCharmPart], inputNamesMLRef[iCharmPart], inputShapesMLRef[iCharmPart], outputNamesMLRef[iCharmPart], dataTypeMLRef[iCharmPart], loadModelsFromCCDB, ccdbApi, mlModelPathCCDB.value, timestampCCDB, referenceConfig);
+        // the features are collected once, in the input type of the model variant
+        if (dataTypeMLRef[iCharmPart] != dataTypeML[iCharmPart]) {
+          LOG(warning) << "Input type of the " << sessionConfigML.modelVariant << " model for " << charmParticleNames[iCharmPart].data() << " differs from the FP32 reference, it is not validated.";
+          sessionMLRef[iCharmPart] = nullptr;
+        }
+      }
+    }
+  }
+
   /// Single-track cuts for bachelor track of beauty candidates
   /// \param track is a track
   /// \param candType candidate type (3-prong or 4-prong beauty candidate)
@@ -622,6 +679,93 @@ struct HfFilter { // Main struct for HF triggers
   Filter trackFilter = requireGlobalTrackWoDCAInFilter();
   using BigTracksPID = soa::Filtered<soa::Join<aod::BigTracksExtended, aod::TrackSelection, aod::pidTPCFullPi, aod::pidTOFFullPi, aod::pidTPCFullKa, aod::pidTOFFullKa, aod::pidTPCFullPr, aod::pidTOFFullPr>>;
 
+  /// Preselection of 3-prong candidates for each charm-hadron hypothesis
+  /// \param cand3Prong is the 3-prong candidate
+  /// \return array with the preselection flags for D+, Ds+, Lc+ and Xic+
+  template <typename T>
+  std::array<int8_t, kNCharmParticles - 1> get3ProngPreselection(const T& cand3Prong)
+  {
+    std::array<int8_t, kNCharmParticles - 1> is3Prong = {
+      TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::DplusToPiKPi),
+      TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::DsToKKPi),
+      TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::LcToPKPi),
+      TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::XicToPKPi)};
+    if (!std::accumulate(is3Prong.begin(), is3Prong.end(), 0)) { // check if it's a D+, Ds+, Lc+ or Xic+
+      return is3Prong;
+    }
+
+    auto trackFirst = cand3Prong.template prong0_as<BigTracksPID>();
+    auto trackSecond = cand3Prong.template prong1_as<BigTracksPID>();
+    auto trackThird = cand3Prong.template prong2_as<BigTracksPID>();
+
+    std::array<float, 3> pVecFirst = {trackFirst.px(), trackFirst.py(), trackFirst.pz()};
+    std::array<float, 3> pVecSecond = {trackSecond.px(), trackSecond.py(), trackSecond.pz()};
+    std::array<float, 3> pVecThird = {trackThird.px(), trackThird.py(), trackThird.pz()};
+
+    if (is3Prong[0]) { // D+ preselections
+      is3Prong[0] = isDplusPreselected(trackSecond);
+    }
+    if (is3Prong[1]) { // Ds preselections
+      is3Prong[1] = isDsPreselected(pVecFirst, pVecThird, pVecSecond, trackSecond);
+    }
+    if (is3Prong[2] || is3Prong[3]) { // charm baryon preselections
+      auto presel = isCharmBaryonPreselected(trackFirst, trackThird, trackSecond);
+      if (is3Prong[2]) {
+        is3Prong[2] = presel;
+      }
+      if (is3Prong[3]) {
+        is3Prong[3] = presel;
+      }
+    }
+
+    return is3Prong;
+  }
+
+  /// Appends the ML input features of a candidate to the features of the collision for batched ML application
+  /// \param iCharmPart is the charm-hadron species
+  /// \param prongs are the daughter tracks of the candidate
+  template <typename... T>
+  void collectFeaturesML(const int iCharmPart, const T&... prongs)
+  {
+    // TODO: add more feature configurations
+    if (dataTypeML[iCharmPart] == 11) {
+      (featuresMLDouble[iCharmPart].insert(featuresMLDouble[iCharmPart].end(), {static_cast<double>(prongs.pt()), static_cast<double>(prongs.dcaXY()), static_cast<double>(prongs.dcaZ())}), ...);
+    } else {
+      (featuresML[iCharmPart].insert(featuresML[iCharmPart].end(), {prongs.pt(), prongs.dcaXY(), prongs.dcaZ()}), ...);
+    }
+    ++nCandidatesML[iCharmPart];
+  }
+
+  /// Runs the ML inference once on all the candidates of a charm-hadron species collected in the collision
+  /// \param iCharmPart is the charm-hadron species
+  void predictBatchML(const int iCharmPart)
+  {
+    if (dataTypeML[iCharmPart] == 1) {
+      PredictONNXBatch(featuresML[iCharmPart], nCandidatesML[iCharmPart], sessionML[iCharmPart], inputNamesML[iCharmPart], inputShapesML[iCharmPart], outputNamesML[iCharmPart], scoresML[iCharmPart]);
+    } else if (dataTypeML[iCharmPart] == 11) {
+      PredictONNXBatch(featuresMLDouble[iCharmPart], nCandidatesML[iCharmPart], sessionML[iCharmPart], inputNamesML[iCharmPart], inputShapesML[iCharmPart], outputNamesML[iCharmPart], scoresMLDouble[iCharmPart]);
+      scoresML[iCharmPart].assign(scoresMLDouble[iCharmPart].begin(), scoresMLDouble[iCharmPart].end());
+    } else {
+      scoresML[iCharmPart].assign(3 * nCandidatesML[iCharmPart], -1.);
+      if (iCharmPart == kD0) {
+        LOG(fatal) << "Error running model inference for D0: Unexpected input data type.";
+      }
+      LOG(error) << "Error running model inference for " << charmParticleNames[iCharmPart].data() << ": Unexpected input data type.";
+    }
+
+    if (validateModelVariant && sessionMLRef[iCharmPart]) {
+      if (dataTypeMLRef[iCharmPart] == 1) {
+        PredictONNXBatch(featuresML[iCharmPart], nCandidatesML[iCharmPart], sessionMLRef[iCharmPart], inputNamesMLRef[iCharmPart], inputShapesMLRef[iCharmPart], outputNamesMLRef[iCharmPart], scoresMLRef[iCharmPart]);
+      } else {
+        PredictONNXBatch(featuresMLDouble[iCharmPart], nCandidatesML[iCharmPart], sessionMLRef[iCharmPart], inputNamesMLRef[iCharmPart], inputShapesMLRef[iCharmPart], outputNamesMLRef[iCharmPart], scoresMLDoubleRef[iCharmPart]);
+        scoresMLRef[iCharmPart].assign(scoresMLDoubleRef[iCharmPart].begin(), scoresMLDoubleRef[iCharmPart].end());
+      }
+      for (std::size_t iScore{0}; iScore < scoresML[iCharmPart].size(); ++iScore) {
+        hBDTScoreVariantDiff[iCharmPart]->Fill(iScore % 3, scoresML[iCharmPart][iScore] - scoresMLRef[iCharmPart][iScore]);
+      }
+    }
+  }
+
   void process(aod::Collision const& collision,
                aod::BCsWithTimestamps const&,
                HfTrackIndexProng2withColl const& cand2Prongs,
@@ -633,15 +777,53 @@ struct HfFilter { // Main struct for HF triggers
     }
 
     if (applyML && (loadModelsFromCCDB && timestampCCDB == 0) && inputNamesML[kD0].size() == 0) {
+      initSessionsML();
+    }
+
+    hProcessedEvents->Fill(0);
+
+    // batched ML application: the features of all the preselected candidates are collected first and each model is run once per collision
+    std::array<std::size_t, kNCharmParticles> iCandML{};
+    if (applyML && applyMLBatched) {
+      for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
+        featuresML[iCharmPart].clear();
+        featuresMLDouble[iCharmPart].clear();
+        nCandidatesML[iCharmPart] = 0;
+      }
+      if (onnxFiles[kD0] != "") {
+        for (const auto& cand2Prong : cand2Prongs) {
+          if (!TESTBIT(cand2Prong.hfflag(), o2::aod::hf_cand_2prong::DecayType::D0ToPiK)) {
+            continue;
+          }
+          auto trackPos = cand2Prong.prong0_as<BigTracksPID>();
+          auto trackNeg = cand2Prong.prong1_as<BigTracksPID>();
+          if (!isDzeroPreselected(trackPos, trackNeg)) {
+            continue;
+          }
+          collectFeaturesML(kD0, trackPos, trackNeg);
+        }
+      }
+      for (const auto& cand3Prong : cand3Prongs) {
+        auto is3Prong = get3ProngPreselection(cand3Prong);
+        if (!std::accumulate(is3Prong.begin(), is3Prong.end(), 0)) {
+          continue;
+        }
+        auto trackFirst = cand3Prong.prong0_as<BigTracksPID>();
+        auto trackSecond = cand3Prong.prong1_as<BigTracksPID>();
+        auto trackThird = cand3Prong.prong2_as<BigTracksPID>();
+        for (auto iCharmPart{0}; iCharmPart < kNCharmParticles - 1; ++iCharmPart) {
+          if (is3Prong[iCharmPart] && onnxFiles[iCharmPart + 1] != "") {
+            collectFeaturesML(iCharmPart + 1, trackFirst, trackSecond, trackThird);
+          }
+        }
+      }
       for (auto iCharmPart{0}; iCharmPart < kNCharmParticles; ++iCharmPart) {
-        if (onnxFiles[iCharmPart] != "") {
-          sessionML[iCharmPart] = InitONNXSession(onnxFiles[iCharmPart], charmParticleNames[iCharmPart], inputNamesML[iCharmPart], inputShapesML[iCharmPart], outputNamesML[iCharmPart], dataTypeML[iCharmPart], loadModelsFromCCDB, ccdbApi, mlModelPathCCDB.value, timestampCCDB);
+        if (nCandidatesML[iCharmPart] > 0) {
+          predictBatchML(iCharmPart);
         }
       }
     }
 
-    hProcessedEvents->Fill(0);
-
     // collision process loop
     bool keepEvent[kNtriggersHF]{false};
     //
@@ -676,7 +858,13 @@ struct HfFilter { // Main struct for HF triggers
         std::vector<float> inputFeaturesD0{trackPos.pt(), trackPos.dcaXY(), trackPos.dcaZ(), trackNeg.pt(), trackNeg.dcaXY(), trackNeg.dcaZ()};
         std::vector<double> inputFeaturesDoD0{trackPos.pt(), trackPos.dcaXY(), trackPos.dcaZ(), trackNeg.pt(), trackNeg.dcaXY(), trackNeg.dcaZ()};
 
-        if (dataTypeML[kD0] == 1) {
+        if (applyMLBatched) { // candidates are visited in the same order as when the features were collected
+          auto scores = &scoresML[kD0][3 * iCandML[kD0]++];
+          tagBDT = isBDTSelected(scores, kD0);
+          for (int iScore{0}; iScore < 3; ++iScore) {
+            scoresToFill[iScore] = scores[iScore];
+          }
+        } else if (dataTypeML[kD0] == 1) {
           auto scores = PredictONNX(inputFeaturesD0, sessionML[kD0], inputNamesML[kD0], inputShapesML[kD0], outputNamesML[kD0]);
           tagBDT = isBDTSelected(scores, kD0);
           for (int iScore{0}; iScore < 3; ++iScore) {
@@ -796,12 +984,8 @@ struct HfFilter { // Main struct for HF triggers
 
     std::vector<std::vector<long>> indicesDau3Prong{};
     for (const auto& cand3Prong : cand3Prongs) { // start loop over 3 prongs
-      std::array<int8_t, kNCharmParticles - 1> is3Prong = {
-        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::DplusToPiKPi),
-        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::DsToKKPi),
-        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::LcToPKPi),
-        TESTBIT(cand3Prong.hfflag(), o2::aod::hf_cand_3prong::DecayType::XicToPKPi)};
-      if (!std::accumulate(is3Prong.begin(), is3Prong.end(), 0)) { // check if it's a D+, Ds+, Lc+ or Xic+
+      auto is3Prong = get3ProngPreselection(cand3Prong);
+      if (!std::accumulate(is3Prong.begin(), is3Prong.end(), 0)) { // check if it's a preselected D+, Ds+, Lc+ or Xic+
         continue;
       }
 
@@ -813,22 +997,6 @@ struct HfFilter { // Main struct for HF triggers
       std::array<float, 3> pVecSecond = {trackSecond.px(), trackSecond.py(), trackSecond.pz()};
       std::array<float, 3> pVecThird = {trackThird.px(), trackThird.py(), trackThird.pz()};
 
-      if (is3Prong[0]) { // D+ preselections
-        is3Prong[0] = isDplusPreselected(trackSecond);
-      }
-      if (is3Prong[1]) { // Ds preselections
-        is3Prong[1] = isDsPreselected(pVecFirst, pVecThird, pVecSecond, trackSecond);
-      }
-      if (is3Prong[2] || is3Prong[3]) { // charm baryon preselections
-        auto presel = isCharmBaryonPreselected(trackFirst, trackThird, trackSecond);
-        if (is3Prong[2]) {
-          is3Prong[2] = presel;
-        }
-        if (is3Prong[3]) {
-          is3Prong[3] = presel;
-        }
-      }
-
       std::array<int8_t, kNCharmParticles - 1> isCharmTagged = is3Prong;
       std::array<int8_t, kNCharmParticles - 1> isBeautyTagged = is3Prong;
 
@@ -850,7 +1018,13 @@ struct HfFilter { // Main struct for HF triggers
           }
 
           int tagBDT = 0;
-          if (dataTypeML[iCharmPart + 1] == 1) {
+          if (applyMLBatched) { // candidates are visited in the same order as when the features were collected
+            auto scores = &scoresML[iCharmPart + 1][3 * iCandML[iCharmPart + 1]++];
+            tagBDT = isBDTSelected(scores, iCharmPart + 1);
+            for (int iScore{0}; iScore < 3; ++iScore) {
+              scoresToFill[iCharmPart][iScore] = scores[iScore];
+            }
+          } else if (dataTypeML[iCharmPart + 1] == 1) {
             auto scores = PredictONNX(inputFeatures, sessionML[iCharmPart + 1], inputNamesML[iCharmPart + 1], inputShapesML[iCharmPart + 1], outputNamesML[iCharmPart + 1]);
             tagBDT = isBDTSelected(scores, iCharmPart + 1);
             for (int iScore{0}; iScore < 3; ++iScore) {
@@ -24,9 +24,11 @@
 #include "Framework/DataTypes.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Common/Core/RecoDecay.h"
+#include "Common/Core/OnnxSessionConfig.h"
 
 #include <vector>
 #include <array>
+#include <algorithm>
 #include <string>
 #include <cmath>
 
@@ -185,23 +187,22 @@ int computeNumberOfCandidates(std::vector<std::vector<T>> indices)
 /// \param ccdbApi is the CCDB API
 /// \param mlModelPathCCDB is the model path in CCDB
 /// \param timestampCCDB is the CCDB timestamp
+/// \param sessionConfig are the session options and the model variant (the model file and CCDB path are those of the variant)
 /// \return the ONNX Ort::Experimental::Session
-std::shared_ptr<Ort::Experimental::Session> InitONNXSession(std::string& onnxFile, std::string partName, std::vector<std::string>& inputNames, std::vector<std::vector<int64_t>>& inputShapes, std::vector<std::string>& outputNames, int& dataType, bool loadModelsFromCCDB, o2::ccdb::CcdbApi& ccdbApi, std::string mlModelPathCCDB, long timestampCCDB)
+std::shared_ptr<Ort::Experimental::Session> InitONNXSession(std::string& onnxFile, std::string partName, std::vector<std::string>& inputNames, std::vector<std::vector<int64_t>>& inputShapes, std::vector<std::string>& outputNames, int& dataType, bool loadModelsFromCCDB, o2::ccdb::CcdbApi& ccdbApi, std::string mlModelPathCCDB, long timestampCCDB, o2::common::OnnxSessionConfig const& sessionConfig)
 {
-  // hard coded, we do not let the user change this
   Ort::Env env{ORT_LOGGING_LEVEL_ERROR, Form("ml-model-%s-triggers", partName.data())};
-  Ort::SessionOptions sessionOpt{Ort::SessionOptions()};
+  Ort::SessionOptions sessionOpt = sessionConfig.makeSessionOptions();
   std::shared_ptr<Ort::Experimental::Session> session = nullptr;
-  sessionOpt.SetIntraOpNumThreads(1);
-  sessionOpt.SetInterOpNumThreads(1);
+  std::string modelFile = sessionConfig.variantPath(onnxFile);
 
   std::map<std::string, std::string> metadata;
   bool retrieveSuccess = true;
   if (loadModelsFromCCDB && timestampCCDB > 0) {
-    retrieveSuccess = ccdbApi.retrieveBlob(mlModelPathCCDB + partName, ".", metadata, timestampCCDB, false, onnxFile);
+    retrieveSuccess = ccdbApi.retrieveBlob(sessionConfig.variantPath(mlModelPathCCDB + partName), ".", metadata, timestampCCDB, false, modelFile);
   }
   if (retrieveSuccess) {
-    session.reset(new Ort::Experimental::Session{env, onnxFile, sessionOpt});
+    session.reset(new Ort::Experimental::Session{env, modelFile, sessionOpt});
     inputNames = session->GetInputNames();
     inputShapes = session->GetInputShapes();
     if (inputShapes[0][0] < 0) {
@@ -255,6 +256,47 @@ std::array<T, 3> PredictONNX(std::vector<T>& inputFeatures, std::shared_ptr<Ort:
 
   return scores;
 };
+
+/// Batched inference of ONNX session
+/// \param inputFeatures is the vector with the input features of all the candidates, one candidate after the other
+/// \param nCandidates is the number of candidates
+/// \param session is the ONNX Ort::Experimental::Session
+/// \param inputNames is a vector of input names
+/// \param inputShapes is a vector of input shapes
+/// \param outputNames is a vector of output names
+/// \param scores is the vector filled with the three output scores of each candidate (-1 if the inference failed)
+template <typename T>
+void PredictONNXBatch(std::vector<T>& inputFeatures, std::size_t nCandidates, std::shared_ptr<Ort::Experimental::Session>& session, std::vector<std::string>& inputNames, std::vector<std::vector<int64_t>>& inputShapes, std::vector<std::string>& outputNames, std::vector<T>& scores)
+{
+  scores.assign(3 * nCandidates, -1.);
+  if (nCandidates == 0) {
+    return;
+  }
+  const int64_t nFeatures = inputFeatures.size() / nCandidates;
+
+  // models with a fixed batch dimension can only be evaluated one candidate at a time
+  if (session->GetInputShapes()[0][0] > 0) {
+    std::vector<T> features(nFeatures);
+    for (std::size_t iCand{0}; iCand < nCandidates; ++iCand) {
+      std::copy_n(inputFeatures.begin() + iCand * nFeatures, nFeatures, features.begin());
+      auto scoresCand = PredictONNX(features, session, inputNames, inputShapes, outputNames);
+      std::copy(scoresCand.begin(), scoresCand.end(), scores.begin() + 3 * iCand);
+    }
+    return;
+  }
+
+  std::vector<Ort::Value> inputTensor;
+  inputTensor.push_back(Ort::Experimental::Value::CreateTensor<T>(inputFeatures.data(), inputFeatures.size(), std::vector<int64_t>{static_cast<int64_t>(nCandidates), nFeatures}));
+  try {
+    auto outputTensor = session->Run(inputNames, inputTensor, outputNames);
+    assert(outputTensor.size() == outputNames.size() && outputTensor[1].IsTensor());
+    auto typeInfo = outputTensor[1].GetTensorTypeAndShapeInfo();
+    assert(typeInfo.GetElementCount() == 3 * nCandidates); // we need multiclass
+    std::copy_n(outputTensor[1].GetTensorMutableData<T>(), 3 * nCandidates, scores.begin());
+  } catch (const Ort::Exception& exception) {
+    // scores left to -1, as in PredictONNX
+  }
+};
 } // namespace hffilters
 
 /// definition of tables
@@ -14,6 +14,8 @@
 #include <TMath.h>
 #include <cmath>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include "Framework/ASoA.h"
 #include "Framework/ASoAHelpers.h"
@@ -65,6 +67,17 @@ struct jetFilter {
   Configurable<float> cfgJetPtMin{
     "cfgJetPtMin", 0.05,
     "minimum jet pT constituent cut"}; // minimum jet constituent pT
+  Configurable<bool> cfgFastTrigger{
+    "cfgFastTrigger", false,
+    "skip the jet finding in events without enough track pT for a jet above "
+    "the threshold"};
+  Configurable<float> cfgTowerSize{
+    "cfgTowerSize", 0.1,
+    "eta and phi size of the towers of the fast trigger"};
+  Configurable<float> cfgPatchSize{
+    "cfgPatchSize", 1.5,
+    "half-width in eta and phi of the patches of the fast trigger, in units of "
+    "the jet R; 0 to only require the summed pT of the constituents"};
 
   HistogramRegistry spectra{
     "spectra",
@@ -77,6 +90,64 @@ struct jetFilter {
   std::vector<fastjet::PseudoJet> jetReclustered;
   JetFinder jetReclusterer;
 
+  // eta-phi towers of the constituent pT, [iEta * nTowersPhi + iPhi], and
+  // buffer of their sums over the phi window of a patch
+  int nTowersEta = 0;
+  int nTowersPhi = 0;
+  std::vector<float> towers;
+  std::vector<float> towersPhiWindow;
+
+  void fillTower(float eta, float phi, float pt)
+  {
+    int iEta = static_cast<int>((eta + cfgTPCVolume) / (2 * cfgTPCVolume) * nTowersEta);
+    int iPhi = static_cast<int>(phi / TMath::TwoPi() * nTowersPhi);
+    iEta = std::clamp(iEta, 0, nTowersEta - 1);
+    iPhi = ((iPhi % nTowersPhi) + nTowersPhi) % nTowersPhi;
+    towers[iEta * nTowersPhi + iPhi] += pt;
+  }
+
+  // maximum constituent pT in an eta-phi patch of the towers, the phi window
+  // wraps around and the eta window is cut at the acceptance
+  float getMaxPatchPt()
+  {
+    const float towerSizeEta = 2 * cfgTPCVolume / nTowersEta;
+    const float towerSizePhi = TMath::TwoPi() / nTowersPhi;
+    const int halfEta = std::ceil(cfgPatchSize * cfgJetR / towerSizeEta);
+    const int halfPhi = std::min(static_cast<int>(std::ceil(cfgPatchSize * cfgJetR / towerSizePhi)), (nTowersPhi - 1) / 2);
+
+    // running sums over the phi window
+    for (int iEta = 0; iEta < nTowersEta; ++iEta) {
+      const float* row = &towers[iEta * nTowersPhi];
+      float sum = 0;
+      for (int d = -halfPhi; d <= halfPhi; ++d) {
+        sum += row[(d + nTowersPhi) % nTowersPhi];
+      }
+      for (int iPhi = 0; iPhi < nTowersPhi; ++iPhi) {
+        towersPhiWindow[iEta * nTowersPhi + iPhi] = sum;
+        sum += row[(iPhi + halfPhi + 1) % nTowersPhi] - row[(iPhi - halfPhi + nTowersPhi) % nTowersPhi];
+      }
+    }
+
+    // sums over the eta window
+    float maxPt = 0;
+    for (int iPhi = 0; iPhi < nTowersPhi; ++iPhi) {
+      float sum = 0;
+      for (int iEta = 0; iEta < std::min(halfEta, nTowersEta); ++iEta) {
+        sum += towersPhiWindow[iEta * nTowersPhi + iPhi];
+      }
+      for (int iEta = 0; iEta < nTowersEta; ++iEta) {
+        if (iEta + halfEta < nTowersEta) {
+          sum += towersPhiWindow[(iEta + halfEta) * nTowersPhi + iPhi];
+        }
+        if (iEta - halfEta - 1 >= 0) {
+          sum -= towersPhiWindow[(iEta - halfEta - 1) * nTowersPhi + iPhi];
+        }
+        maxPt = std::max(maxPt, sum);
+      }
+    }
+    return maxPt;
+  }
+
   void init(o2::framework::InitContext&)
   {
 
@@ -109,6 +180,18 @@ struct jetFilter {
       scalers->GetXaxis()->SetBinLabel(iS, highPtObjectsNames[iS - 1].data());
     }
 
+    spectra.add("fFastTrigger", ";;Number of events", HistType::kTH1F,
+                {{3, -0.5, 2.5}});
+    auto hFastTrigger = spectra.get<TH1>(HIST("fFastTrigger"));
+    hFastTrigger->GetXaxis()->SetBinLabel(1, "rejected by constituent pT sum");
+    hFastTrigger->GetXaxis()->SetBinLabel(2, "rejected by patch pT");
+    hFastTrigger->GetXaxis()->SetBinLabel(3, "clustered");
+
+    nTowersEta = std::max(1, static_cast<int>(std::ceil(2 * cfgTPCVolume / cfgTowerSize)));
+    nTowersPhi = std::max(1, static_cast<int>(std::ceil(TMath::TwoPi() / cfgTowerSize)));
+    towers.resize(nTowersEta * nTowersPhi);
+    towersPhiWindow.resize(nTowersEta * nTowersPhi);
+
     jetReclusterer.isReclustering = true;
     jetReclusterer.algorithm = fastjet::JetAlgorithm::antikt_algorithm;
     jetReclusterer.jetR = cfgJetR;
@@ -133,6 +216,10 @@ struct jetFilter {
 
     jetConstituents.clear();
     jetReclustered.clear();
+    float sumPtConstituents = 0;
+    if (cfgFastTrigger) {
+      std::fill(towers.begin(), towers.end(), 0.f);
+    }
 
     for (auto& trk : tracks) {
       if (!trk.isQualityTrack()) {
@@ -149,14 +236,40 @@ struct jetFilter {
                            jetConstituents); // ./PWGJE/Core/JetFinder.h
                                              // recombination scheme is assumed
                                              // to be Escheme with pion mass
+          if (cfgFastTrigger) {
+            sumPtConstituents += trk.pt();
+            fillTower(trk.eta(), trk.phi(), trk.pt());
+          }
         }
       }
     }
 
+    // The pT of a jet is at most the summed pT of its constituents, so the
+    // events without enough constituent pT are not clustered. The constituent
+    // pT sum of the whole event is an exact bound, the one of the patches
+    // assumes that the constituents are within cfgPatchSize * R of the axis.
+    // The events outside of the vertex cut are not kept anyway.
+    bool findJets = true;
+    if (cfgFastTrigger) {
+      if (fabs(collision.posZ()) > cfgVertexCut) {
+        findJets = false;
+      } else if (sumPtConstituents < selectionJetChHighPt) {
+        spectra.fill(HIST("fFastTrigger"), 0);
+        findJets = false;
+      } else if (cfgPatchSize > 0 && getMaxPatchPt() < selectionJetChHighPt) {
+        spectra.fill(HIST("fFastTrigger"), 1);
+        findJets = false;
+      } else {
+        spectra.fill(HIST("fFastTrigger"), 2);
+      }
+    }
+
     // Reconstruct jet from tracks
-    fastjet::ClusterSequenceArea clusterSeq(
-      jetReclusterer.findJets(jetConstituents, jetReclustered));
-    jetReclustered = sorted_by_pt(jetReclustered);
+    if (findJets) {
+      fastjet::ClusterSequenceArea clusterSeq(
+        jetReclusterer.findJets(jetConstituents, jetReclustered));
+      jetReclustered = sorted_by_pt(jetReclustered);
+    }
 
     // Check whether there is a high pT charged jet
     for (auto& jet : jetReclustered) { // start loop over charged jets
@@ -23,6 +23,7 @@
 
 #include "Framework/HistogramRegistry.h"
 
+#include <array>
 #include <cmath>
 #include <string>
 
@@ -66,11 +67,21 @@ struct nucleiFilter {
   Configurable<float> cfgCutEta{"cfgCutEta", 0.8f, "Eta range for tracks"};
 
   Configurable<LabeledArray<float>> cfgCutsPID{"nucleiCutsPID", {cutsPID[0], nNuclei, nCutsPID, nucleiNames, cutsNames}, "Nuclei PID selections"};
+  Configurable<int> qaDownsampling{"qaDownsampling", 1, "Fill the track QA histograms for one collision out of N, never if 0"};
 
   HistogramRegistry spectra{"spectra", {}, OutputObjHandlingPolicy::AnalysisObject, true, true};
 
+  std::array<std::array<float, nCutsPID>, nNuclei> cuts{}; ///< PID selections, read once from the configurable
+  int64_t collisionCounter{0};                               ///< processed collisions, for the QA downsampling
+
   void init(o2::framework::InitContext&)
   {
+    for (int iN{0}; iN < nNuclei; ++iN) {
+      for (int iC{0}; iC < nCutsPID; ++iC) {
+        cuts[iN][iC] = cfgCutsPID->get(iN, iC);
+      }
+    }
+
     std::vector<double> ptBinning = {0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1, 1.2, 1.3, 1.4, 1.5, 1.6, 1.8, 2.0, 2.2, 2.4, 2.8, 3.2, 3.6, 4., 5.};
     std::vector<double> centBinning = {0., 1., 5., 10., 20., 30., 40., 50., 70., 100.};
 
@@ -94,9 +105,11 @@ struct nucleiFilter {
   {
     // collision process loop
     bool keepEvent[nNuclei]{false};
+    int nFired{0};
     //
     spectra.fill(HIST("fCollZpos"), collision.posZ());
     //
+    const bool fillQA{qaDownsampling > 0 && collisionCounter++ % qaDownsampling == 0};
 
     for (auto& track : tracks) { // start loop over tracks
 
@@ -106,22 +119,34 @@ struct nucleiFilter {
         track.tofNSigmaDe(), track.tofNSigmaTr(), track.tofNSigmaHe(), track.tofNSigmaAl()};
 
       for (int iN{0}; iN < nNuclei; ++iN) {
-        float y{rapidity(track.pt() * charges[iN], track.eta(), masses[iN])};
-        if (y < yMin + yBeam || y > yMax + yBeam) {
+        // the decision of a species is taken at its first candidate, the cheap PID cuts go before the rapidity
+        if (keepEvent[iN]) {
           continue;
         }
-        if (nSigmaTPC[iN] < cfgCutsPID->get(iN, 0u) || nSigmaTPC[iN] > cfgCutsPID->get(iN, 1u)) {
+        if (nSigmaTPC[iN] < cuts[iN][0] || nSigmaTPC[iN] > cuts[iN][1]) {
           continue;
         }
-        if (track.pt() > cfgCutsPID->get(iN, 4u) && (nSigmaTOF[iN] < cfgCutsPID->get(iN, 2u) || nSigmaTOF[iN] > cfgCutsPID->get(iN, 3u))) {
+        if (track.pt() > cuts[iN][4] && (nSigmaTOF[iN] < cuts[iN][2] || nSigmaTOF[iN] > cuts[iN][3])) {
+          continue;
+        }
+        float y{rapidity(track.pt() * charges[iN], track.eta(), masses[iN])};
+        if (y < yMin + yBeam || y > yMax + yBeam) {
           continue;
         }
         keepEvent[iN] = true;
+        nFired++;
       }
 
       //
       // fill QA histograms
       //
+      if (!fillQA) {
+        // nothing left to decide for this collision
+        if (nFired == nNuclei) {
+          break;
+        }
+        continue;
+      }
       spectra.fill(HIST("fTPCsignal"), track.tpcInnerParam(), track.tpcSignal());
       spectra.fill(HIST("fTPCcounts"), track.tpcInnerParam(), track.tpcNSigmaHe());
 
@@ -92,11 +92,14 @@ struct strangenessFilter {
   Configurable<bool> sel7{"sel7", 0, "Apply sel7 event selection"};
   Configurable<bool> sel8{"sel8", 0, "Apply sel8 event selection"};
   Configurable<bool> globaltrk{"globaltrk", 1, "Apply global track selection"};
+  Configurable<int> qaDownsampling{"qaDownsampling", 1, "Fill the candidate QA histograms for one collision out of N, never if 0"};
 
   // Selections criteria for tracks
   Configurable<float> hEta{"hEta", 0.9f, "Eta range for trigger particles"};
   Configurable<float> hMinPt{"hMinPt", 1.0f, "Min pt for trigger particles"};
 
+  int64_t collisionCounter{0}; // processed collisions, for the QA downsampling
+
   void init(o2::framework::InitContext&)
   {
     std::vector<double> centBinning = {0., 1., 5., 10., 20., 30., 40., 50., 70., 100.};
@@ -204,6 +207,26 @@ struct strangenessFilter {
   using DaughterTracks = soa::Join<aod::Tracks, aod::TracksCov, aod::TracksExtra, aod::TracksDCA, aod::TrackSelection, aod::pidTOFPi, aod::pidTPCPi, aod::pidTOFPr, aod::pidTPCPr, aod::pidTPCKa, aod::pidTOFKa>;
   using Cascades = aod::CascDataExt;
 
+  /// Selections of a cascade required by all the triggers, on its own columns only.
+  /// Applied before the V0 and the daughter tracks are dereferenced in the collisions without QA.
+  template <typename TCascade>
+  bool isCascadePreselected(TCascade const& casc)
+  {
+    const float dcaMesonToPV = casc.sign() == 1 ? casc.dcapostopv() : casc.dcanegtopv();
+    const float dcaBaryonToPV = casc.sign() == 1 ? casc.dcanegtopv() : casc.dcapostopv();
+    return (TMath::Abs(dcaMesonToPV) >= dcamesontopv) &&
+           (TMath::Abs(dcaBaryonToPV) >= dcabaryontopv) &&
+           (TMath::Abs(casc.dcabachtopv()) >= dcabachtopv) &&
+           (casc.v0radius() >= v0radius && casc.v0radius() <= v0radiusupperlimit) &&
+           (casc.cascradius() >= cascradius && casc.cascradius() <= cascradiusupperlimit) &&
+           (casc.dcaV0daughters() <= dcav0dau) &&
+           (casc.dcacascdaughters() <= dcacascdau) &&
+           (TMath::Abs(casc.mLambda() - constants::physics::MassLambda) <= masslambdalimit) &&
+           (TMath::Abs(casc.eta()) <= eta) &&
+           ((TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < ximasswindow) ||
+            (TMath::Abs(casc.mOmega() - RecoDecay::getMassPDG(3334)) < omegamasswindow));
+  }
+
   ////////////////////////////////////////////////////////
   ////////// Strangeness Filter - Run 2 conv /////////////
   ////////////////////////////////////////////////////////
@@ -230,6 +253,9 @@ struct strangenessFilter {
 
     // Is event good? [0] = Omega, [1] = high-pT hadron + Xi, [2] = 2Xi, [3] = 3Xi, [4] = 4Xi, [5] single-Xi
     bool keepEvent[6]{false};
+    // the QA histograms are filled for a downsampled fraction of the collisions,
+    // in the others the cascades are preselected on their columns and the loop stops once all the triggers fired
+    const bool fillQA = qaDownsampling > 0 && collisionCounter++ % qaDownsampling == 0;
 
     // constants
     const float ctauxi = 4.91;     // from PDG
@@ -248,6 +274,9 @@ struct strangenessFilter {
 
     for (auto& casc : fullCasc) { // loop over cascades
       triggcounterForEstimates = 0;
+      if (!fillQA && !isCascadePreselected(casc)) {
+        continue;
+      }
       auto v0index = casc.v0_as<o2::aod::V0sLinked>();
       if (!(v0index.has_v0Data())) {
         continue; // skip those cascades for which V0 doesn't exist
@@ -262,8 +291,10 @@ struct strangenessFilter {
       bool isOmega = false;
 
       // QA
-      QAHistos.fill(HIST("hMassXiBefSel"), casc.mXi());
-      QAHistos.fill(HIST("hMassOmegaBefSel"), casc.mOmega());
+      if (fillQA) {
+        QAHistos.fill(HIST("hMassXiBefSel"), casc.mXi());
+        QAHistos.fill(HIST("hMassOmegaBefSel"), casc.mOmega());
+      }
 
       // Position
       xipos = std::hypot(casc.x() - collision.posX(), casc.y() - collision.posY(), casc.z() - collision.posZ());
@@ -286,16 +317,20 @@ struct strangenessFilter {
         if (TMath::Abs(negdau.tpcNSigmaPr()) > nsigmatpc) {
           continue;
         };
-        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), negdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), posdau.tofNSigmaPi());
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), negdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), posdau.tofNSigmaPi());
+        }
         if (
           (TMath::Abs(posdau.tofNSigmaPi()) > nsigmatof) &&
           (TMath::Abs(negdau.tofNSigmaPr()) > nsigmatof) &&
           (TMath::Abs(bachelor.tofNSigmaPi()) > nsigmatof)) {
           continue;
         };
-        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), negdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), posdau.tofNSigmaPi());
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), negdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), posdau.tofNSigmaPi());
+        }
       } else {
         if (TMath::Abs(casc.dcanegtopv()) < dcamesontopv) {
           continue;
@@ -309,16 +344,20 @@ struct strangenessFilter {
         if (TMath::Abs(negdau.tpcNSigmaPi()) > nsigmatpc) {
           continue;
         };
-        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), posdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), negdau.tofNSigmaPi());
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), posdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), negdau.tofNSigmaPi());
+        }
         if ( // bachelor to be fixed
           (TMath::Abs(posdau.tofNSigmaPr()) > nsigmatof) &&
           (TMath::Abs(negdau.tofNSigmaPi()) > nsigmatof) &&
           (TMath::Abs(bachelor.tofNSigmaPi()) > nsigmatof)) {
           continue;
         };
-        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), posdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), negdau.tofNSigmaPi());
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), posdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), negdau.tofNSigmaPi());
+        }
       }
       // these selection differ for Xi and Omegas:
       if (TMath::Abs(posdau.eta()) > etadau) {
@@ -377,44 +416,54 @@ struct strangenessFilter {
                 (TMath::Abs(casc.yOmega()) < rapidity); // add PID on bachelor
 
       if (isXi) {
-        QAHistos.fill(HIST("hMassXiAfterSel"), casc.mXi());
-        QAHistos.fill(HIST("hMassXiAfterSelvsPt"), casc.mXi(), casc.pt());
-        QAHistos.fill(HIST("hPtXi"), casc.pt());
-        QAHistos.fill(HIST("hEtaXi"), casc.eta());
-
-        QAHistosTopologicalVariables.fill(HIST("CascCosPA"), casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()));
-        QAHistosTopologicalVariables.fill(HIST("V0CosPA"), casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()));
-        QAHistosTopologicalVariables.fill(HIST("CascRadius"), casc.cascradius());
-        QAHistosTopologicalVariables.fill(HIST("V0Radius"), casc.v0radius());
-        QAHistosTopologicalVariables.fill(HIST("DCAV0ToPV"), casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
-        QAHistosTopologicalVariables.fill(HIST("DCAV0Daughters"), casc.dcaV0daughters());
-        QAHistosTopologicalVariables.fill(HIST("DCACascDaughters"), casc.dcacascdaughters());
-        QAHistosTopologicalVariables.fill(HIST("DCABachToPV"), TMath::Abs(casc.dcabachtopv()));
-        QAHistosTopologicalVariables.fill(HIST("DCAPosToPV"), TMath::Abs(casc.dcapostopv()));
-        QAHistosTopologicalVariables.fill(HIST("DCANegToPV"), TMath::Abs(casc.dcanegtopv()));
-        QAHistosTopologicalVariables.fill(HIST("InvMassLambda"), casc.mLambda());
+        if (fillQA) {
+          QAHistos.fill(HIST("hMassXiAfterSel"), casc.mXi());
+          QAHistos.fill(HIST("hMassXiAfterSelvsPt"), casc.mXi(), casc.pt());
+          QAHistos.fill(HIST("hPtXi"), casc.pt());
+          QAHistos.fill(HIST("hEtaXi"), casc.eta());
+
+          QAHistosTopologicalVariables.fill(HIST("CascCosPA"), casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()));
+          QAHistosTopologicalVariables.fill(HIST("V0CosPA"), casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()));
+          QAHistosTopologicalVariables.fill(HIST("CascRadius"), casc.cascradius());
+          QAHistosTopologicalVariables.fill(HIST("V0Radius"), casc.v0radius());
+          QAHistosTopologicalVariables.fill(HIST("DCAV0ToPV"), casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
+          QAHistosTopologicalVariables.fill(HIST("DCAV0Daughters"), casc.dcaV0daughters());
+          QAHistosTopologicalVariables.fill(HIST("DCACascDaughters"), casc.dcacascdaughters());
+          QAHistosTopologicalVariables.fill(HIST("DCABachToPV"), TMath::Abs(casc.dcabachtopv()));
+          QAHistosTopologicalVariables.fill(HIST("DCAPosToPV"), TMath::Abs(casc.dcapostopv()));
+          QAHistosTopologicalVariables.fill(HIST("DCANegToPV"), TMath::Abs(casc.dcanegtopv()));
+          QAHistosTopologicalVariables.fill(HIST("InvMassLambda"), casc.mLambda());
+        }
         // Count number of Xi candidates
         xicounter++;
 
-        // Plot for estimates
-        if (tracks.size() > 0)
-          triggcounterForEstimates = 1;
-        if (triggcounterForEstimates && (TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < 0.01))
-          hhXiPairsvsPt->Fill(casc.pt()); // Fill the histogram with all the Xis produced in events with a trigger particle
-        // End plot for estimates
+        if (fillQA) {
+          // Plot for estimates
+          if (tracks.size() > 0)
+            triggcounterForEstimates = 1;
+          if (triggcounterForEstimates && (TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < 0.01))
+            hhXiPairsvsPt->Fill(casc.pt()); // Fill the histogram with all the Xis produced in events with a trigger particle
+          // End plot for estimates
+        }
       }
       if (isXiYN) {
         // Xis for YN interactions
         xicounterYN++;
       }
       if (isOmega) {
-        QAHistos.fill(HIST("hMassOmegaAfterSel"), casc.mOmega());
-        QAHistos.fill(HIST("hMassOmegaAfterSelvsPt"), casc.mOmega(), casc.pt());
-        QAHistos.fill(HIST("hPtOmega"), casc.pt());
-        QAHistos.fill(HIST("hEtaOmega"), casc.eta());
+        if (fillQA) {
+          QAHistos.fill(HIST("hMassOmegaAfterSel"), casc.mOmega());
+          QAHistos.fill(HIST("hMassOmegaAfterSelvsPt"), casc.mOmega(), casc.pt());
+          QAHistos.fill(HIST("hPtOmega"), casc.pt());
+          QAHistos.fill(HIST("hEtaOmega"), casc.eta());
+        }
         // Count number of Omega candidates
         omegacounter++;
       }
+      // the remaining cascades cannot change the decision
+      if (!fillQA && omegacounter > 0 && xicounter > 3 && xicounterYN > 0) {
+        break;
+      }
     } // end loop over cascades
 
     // Omega trigger definition
@@ -424,6 +473,9 @@ struct strangenessFilter {
 
     // High-pT hadron + Xi trigger definition
     if (xicounter > 0) {
+      keepEvent[1] = tracks.size() > 0;
+    }
+    if (xicounter > 0 && fillQA) {
       for (auto track : tracks) { // start loop over tracks
         triggcounter++;
         QAHistosTriggerParticles.fill(HIST("hPtTrigger"), track.pt());
@@ -431,7 +483,6 @@ struct strangenessFilter {
         QAHistosTriggerParticles.fill(HIST("hEtaTrigger"), track.eta());
         QAHistosTriggerParticles.fill(HIST("hDCAxyTrigger"), track.dcaXY());
         QAHistosTriggerParticles.fill(HIST("hDCAzTrigger"), track.dcaZ());
-        keepEvent[1] = true;
       } // end loop over tracks
       QAHistosTriggerParticles.fill(HIST("hTriggeredParticles"), triggcounter);
     }
@@ -508,6 +559,9 @@ struct strangenessFilter {
 
     // Is event good? [0] = Omega, [1] = high-pT hadron + Xi, [2] = 2Xi, [3] = 3Xi, [4] = 4Xi, [5] single-Xi
     bool keepEvent[6]{false};
+    // the QA histograms are filled for a downsampled fraction of the collisions,
+    // in the others the cascades are preselected on their columns and the loop stops once all the triggers fired
+    const bool fillQA = qaDownsampling > 0 && collisionCounter++ % qaDownsampling == 0;
 
     // constants
     const float ctauxi = 4.91;     // from PDG
@@ -523,16 +577,24 @@ struct strangenessFilter {
     int omegacounter = 0;
     int triggcounter = 0;
     int triggcounterForEstimates = 0;
+    auto fillCutFlow = [&](float bin) {
+      if (fillQA) {
+        hCandidate->Fill(bin);
+      }
+    };
 
     for (auto& casc : fullCasc) { // loop over cascades
       triggcounterForEstimates = 0;
-      hCandidate->Fill(0.5);
+      if (!fillQA && !isCascadePreselected(casc)) {
+        continue;
+      }
+      fillCutFlow(0.5);
 
       auto v0index = casc.v0_as<o2::aod::V0sLinked>();
       if (!(v0index.has_v0Data())) {
         continue; // skip those cascades for which V0 doesn't exist
       }
-      hCandidate->Fill(1.5);
+      fillCutFlow(1.5);
       auto v0 = v0index.v0Data(); // de-reference index to correct v0data in case it exists
       auto bachelor = casc.bachelor_as<DaughterTracks>();
       auto posdau = v0.posTrack_as<DaughterTracks>();
@@ -543,8 +605,10 @@ struct strangenessFilter {
       bool isOmega = false;
 
       // QA
-      QAHistos.fill(HIST("hMassXiBefSel"), casc.mXi());
-      QAHistos.fill(HIST("hMassOmegaBefSel"), casc.mOmega());
+      if (fillQA) {
+        QAHistos.fill(HIST("hMassXiBefSel"), casc.mXi());
+        QAHistos.fill(HIST("hMassOmegaBefSel"), casc.mOmega());
+      }
 
       // Position
       xipos = std::hypot(casc.x() - collision.posX(), casc.y() - collision.posY(), casc.z() - collision.posZ());
@@ -558,23 +622,25 @@ struct strangenessFilter {
         if (TMath::Abs(casc.dcapostopv()) < dcamesontopv) {
           continue;
         };
-        hCandidate->Fill(2.5);
+        fillCutFlow(2.5);
         if (TMath::Abs(casc.dcanegtopv()) < dcabaryontopv) {
           continue;
         };
-        hCandidate->Fill(3.5);
+        fillCutFlow(3.5);
         if (TMath::Abs(posdau.tpcNSigmaPi()) > nsigmatpc) {
           continue;
         };
-        hCandidate->Fill(4.5);
+        fillCutFlow(4.5);
         if (TMath::Abs(negdau.tpcNSigmaPr()) > nsigmatpc) {
           continue;
         };
-        hCandidate->Fill(5.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), negdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), posdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachKBefSel"), bachelor.tofNSigmaKa());
+        fillCutFlow(5.5);
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), negdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), posdau.tofNSigmaPi());
+          QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigmaPi());
+          QAHistos.fill(HIST("hTOFnsigmaBachKBefSel"), bachelor.tofNSigmaKa());
+        }
         if (
           (TMath::Abs(posdau.tofNSigmaPi()) > nsigmatof) &&
           (TMath::Abs(negdau.tofNSigmaPr()) > nsigmatof) &&
@@ -582,45 +648,51 @@ struct strangenessFilter {
           (TMath::Abs(bachelor.tofNSigmaPi()) > nsigmatof)) {
           continue;
         };
-        hCandidate->Fill(6.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), negdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), posdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachKAfterSel"), bachelor.tofNSigmaKa());
+        fillCutFlow(6.5);
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), negdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), posdau.tofNSigmaPi());
+          QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigmaPi());
+          QAHistos.fill(HIST("hTOFnsigmaBachKAfterSel"), bachelor.tofNSigmaKa());
+        }
       } else {
         if (TMath::Abs(casc.dcanegtopv()) < dcamesontopv) {
           continue;
         };
-        hCandidate->Fill(2.5);
+        fillCutFlow(2.5);
         if (TMath::Abs(casc.dcapostopv()) < dcabaryontopv) {
           continue;
         };
-        hCandidate->Fill(3.5);
+        fillCutFlow(3.5);
         if (TMath::Abs(posdau.tpcNSigmaPr()) > nsigmatpc) {
           continue;
         };
-        hCandidate->Fill(5.5);
+        fillCutFlow(5.5);
         if (TMath::Abs(negdau.tpcNSigmaPi()) > nsigmatpc) {
           continue;
         };
-        hCandidate->Fill(4.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), posdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), negdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigmaPi());
+        fillCutFlow(4.5);
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrBefSel"), posdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiBefSel"), negdau.tofNSigmaPi());
+          QAHistos.fill(HIST("hTOFnsigmaBachPiBefSel"), bachelor.tofNSigmaPi());
+        }
         if (
           (TMath::Abs(posdau.tofNSigmaPr()) > nsigmatof) &&
           (TMath::Abs(negdau.tofNSigmaPi()) > nsigmatof) &&
           (TMath::Abs(bachelor.tofNSigmaPi()) > nsigmatof)) {
           continue;
         };
-        hCandidate->Fill(6.5);
-        QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), posdau.tofNSigmaPr());
-        QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), negdau.tofNSigmaPi());
-        QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigmaPi());
+        fillCutFlow(6.5);
+        if (fillQA) {
+          QAHistos.fill(HIST("hTOFnsigmaPrAfterSel"), posdau.tofNSigmaPr());
+          QAHistos.fill(HIST("hTOFnsigmaV0PiAfterSel"), negdau.tofNSigmaPi());
+          QAHistos.fill(HIST("hTOFnsigmaBachPiAfterSel"), bachelor.tofNSigmaPi());
+        }
       }
       // this selection differes for Xi and Omegas:
 
-      hCandidate->Fill(7.5);
+      fillCutFlow(7.5);
       if (TMath::Abs(posdau.eta()) > etadau) {
         continue;
       };
@@ -630,49 +702,49 @@ struct strangenessFilter {
       if (TMath::Abs(bachelor.eta()) > etadau) {
         continue;
       };
-      hCandidate->Fill(8.5);
+      fillCutFlow(8.5);
       if (TMath::Abs(casc.dcabachtopv()) < dcabachtopv) {
         continue;
       };
-      hCandidate->Fill(9.5);
+      fillCutFlow(9.5);
       if (casc.v0radius() > v0radiusupperlimit || casc.v0radius() < v0radius) {
         continue;
       };
-      hCandidate->Fill(10.5);
+      fillCutFlow(10.5);
       if (casc.cascradius() > cascradiusupperlimit || casc.cascradius() < cascradius) {
         continue;
       }; //
-      hCandidate->Fill(11.5);
+      fillCutFlow(11.5);
       if (casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) < v0cospa) {
         continue;
       };
-      hCandidate->Fill(12.5);
+      fillCutFlow(12.5);
       if (casc.dcaV0daughters() > dcav0dau) {
         continue;
       };
-      hCandidate->Fill(13.5);
+      fillCutFlow(13.5);
       if (casc.dcacascdaughters() > dcacascdau) {
         continue;
       };
-      hCandidate->Fill(14.5);
+      fillCutFlow(14.5);
       if (TMath::Abs(casc.mLambda() - constants::physics::MassLambda) > masslambdalimit) {
         continue;
       };
-      hCandidate->Fill(15.5);
+      fillCutFlow(15.5);
       if (TMath::Abs(casc.eta()) > eta) {
         continue;
       };
-      hCandidate->Fill(16.5);
+      fillCutFlow(16.5);
 
       // TOREMOVE
-      if (casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()) > casccospa) {
-        hCandidate->Fill(17.5);
+      if (fillQA && casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()) > casccospa) {
+        fillCutFlow(17.5);
         if (casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()) > dcav0topv) {
-          hCandidate->Fill(18.5);
+          fillCutFlow(18.5);
           if (xiproperlifetime < properlifetimefactor * ctauxi) {
-            hCandidate->Fill(19.5);
+            fillCutFlow(19.5);
             if (TMath::Abs(casc.yXi()) < rapidity) {
-              hCandidate->Fill(20.5);
+              fillCutFlow(20.5);
             }
           }
         }
@@ -700,45 +772,55 @@ struct strangenessFilter {
                 (TMath::Abs(casc.yOmega()) < rapidity); // add PID on bachelor
 
       if (isXi) {
-        QAHistos.fill(HIST("hMassXiAfterSel"), casc.mXi());
-        QAHistos.fill(HIST("hMassXiAfterSelvsPt"), casc.mXi(), casc.pt());
-        QAHistos.fill(HIST("hPtXi"), casc.pt());
-        QAHistos.fill(HIST("hEtaXi"), casc.eta());
-
-        QAHistosTopologicalVariables.fill(HIST("CascCosPA"), casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()));
-        QAHistosTopologicalVariables.fill(HIST("V0CosPA"), casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()));
-        QAHistosTopologicalVariables.fill(HIST("CascRadius"), casc.cascradius());
-        QAHistosTopologicalVariables.fill(HIST("V0Radius"), casc.v0radius());
-        QAHistosTopologicalVariables.fill(HIST("DCAV0ToPV"), casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
-        QAHistosTopologicalVariables.fill(HIST("DCAV0Daughters"), casc.dcaV0daughters());
-        QAHistosTopologicalVariables.fill(HIST("DCACascDaughters"), casc.dcacascdaughters());
-        QAHistosTopologicalVariables.fill(HIST("DCABachToPV"), TMath::Abs(casc.dcabachtopv()));
-        QAHistosTopologicalVariables.fill(HIST("DCAPosToPV"), TMath::Abs(casc.dcapostopv()));
-        QAHistosTopologicalVariables.fill(HIST("DCANegToPV"), TMath::Abs(casc.dcanegtopv()));
-        QAHistosTopologicalVariables.fill(HIST("InvMassLambda"), casc.mLambda());
+        if (fillQA) {
+          QAHistos.fill(HIST("hMassXiAfterSel"), casc.mXi());
+          QAHistos.fill(HIST("hMassXiAfterSelvsPt"), casc.mXi(), casc.pt());
+          QAHistos.fill(HIST("hPtXi"), casc.pt());
+          QAHistos.fill(HIST("hEtaXi"), casc.eta());
+
+          QAHistosTopologicalVariables.fill(HIST("CascCosPA"), casc.casccosPA(collision.posX(), collision.posY(), collision.posZ()));
+          QAHistosTopologicalVariables.fill(HIST("V0CosPA"), casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ()));
+          QAHistosTopologicalVariables.fill(HIST("CascRadius"), casc.cascradius());
+          QAHistosTopologicalVariables.fill(HIST("V0Radius"), casc.v0radius());
+          QAHistosTopologicalVariables.fill(HIST("DCAV0ToPV"), casc.dcav0topv(collision.posX(), collision.posY(), collision.posZ()));
+          QAHistosTopologicalVariables.fill(HIST("DCAV0Daughters"), casc.dcaV0daughters());
+          QAHistosTopologicalVariables.fill(HIST("DCACascDaughters"), casc.dcacascdaughters());
+          QAHistosTopologicalVariables.fill(HIST("DCABachToPV"), TMath::Abs(casc.dcabachtopv()));
+          QAHistosTopologicalVariables.fill(HIST("DCAPosToPV"), TMath::Abs(casc.dcapostopv()));
+          QAHistosTopologicalVariables.fill(HIST("DCANegToPV"), TMath::Abs(casc.dcanegtopv()));
+          QAHistosTopologicalVariables.fill(HIST("InvMassLambda"), casc.mLambda());
+        }
 
         // Count number of Xi candidates
         xicounter++;
 
-        // Plot for estimates
-        if (tracks.size() > 0)
-          triggcounterForEstimates++;
-        if (triggcounterForEstimates && (TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < 0.01))
-          hhXiPairsvsPt->Fill(casc.pt()); // Fill the histogram with all the Xis produced in events with a trigger particle
-        // End plot for estimates
+        if (fillQA) {
+          // Plot for estimates
+          if (tracks.size() > 0)
+            triggcounterForEstimates++;
+          if (triggcounterForEstimates && (TMath::Abs(casc.mXi() - RecoDecay::getMassPDG(3312)) < 0.01))
+            hhXiPairsvsPt->Fill(casc.pt()); // Fill the histogram with all the Xis produced in events with a trigger particle
+          // End plot for estimates
+        }
       }
       if (isXiYN) {
         // Xis for YN interactions
         xicounterYN++;
       }
       if (isOmega) {
-        QAHistos.fill(HIST("hMassOmegaAfterSel"), casc.mOmega());
-        QAHistos.fill(HIST("hMassOmegaAfterSelvsPt"), casc.mOmega(), casc.pt());
-        QAHistos.fill(HIST("hPtOmega"), casc.pt());
-        QAHistos.fill(HIST("hEtaOmega"), casc.eta());
+        if (fillQA) {
+          QAHistos.fill(HIST("hMassOmegaAfterSel"), casc.mOmega());
+          QAHistos.fill(HIST("hMassOmegaAfterSelvsPt"), casc.mOmega(), casc.pt());
+          QAHistos.fill(HIST("hPtOmega"), casc.pt());
+          QAHistos.fill(HIST("hEtaOmega"), casc.eta());
+        }
         // Count number of Omega candidates
         omegacounter++;
       }
+      // the remaining cascades cannot change the decision
+      if (!fillQA && omegacounter > 0 && xicounter > 3 && xicounterYN > 0) {
+        break;
+      }
     } // end loop over cascades
 
     // Omega trigger definition
@@ -755,6 +837,9 @@ struct strangenessFilter {
 
     // High-pT hadron + Xi trigger definition
     if (xicounter > 0) {
+      keepEvent[1] = tracks.size() > 0;
+    }
+    if (xicounter > 0 && fillQA) {
       for (auto track : tracks) { // start loop over tracks
         triggcounter++;
         QAHistosTriggerParticles.fill(HIST("hPtTrigger"), track.pt());
@@ -766,7 +851,6 @@ struct strangenessFilter {
           if (track.pt() > ThrdPt[i])
             EvtwhMinPt[i] = 1;
         }
-        keepEvent[1] = true;
       } // end loop over tracks
       QAHistosTriggerParticles.fill(HIST("hTriggeredParticles"), triggcounter);
     }
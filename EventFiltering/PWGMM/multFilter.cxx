@@ -8,8 +8,10 @@
 // In applying this license CERN does not waive the privileges and immunities
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
+#include <array>
 #include <cmath>
 #include <string>
+#include <vector>
 
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
@@ -24,6 +26,10 @@
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/Core/TrackSelection.h"
 
+#include "PWGMM/Core/histogramBuffers.h"
+
+#include <TProfile.h>
+
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
@@ -42,6 +48,7 @@ struct multFilter {
          kNtriggersMM };
   // my track selection, discussed with Mesut and Matia
   TrackSelection myTrackSelection();
+  TrackSelection mTrackSelection;
   // event selection cuts
   Configurable<float> selHTrkMult{"selHTrkMult", 45., "global trk multiplicity threshold"};
   Configurable<float> selHMFv0{"selHMFv0", 33559.5, "FV0-amplitude threshold"};
@@ -76,6 +83,8 @@ struct multFilter {
     float lowEdgeEst[8] = {-0.5, -0.5, -0.01, -0.5, -0.01, -0.5, -0.01, .0};
     float upEdgeEst[8] = {99.5, 49999.5, 1.01, 499.5, 1.01, 499.5, 1.01, 150.0};
 
+    mTrackSelection = myTrackSelection();
+
     // QA event level
     multiplicity.add("fCollZpos", "Vtx_z", HistType::kTH1F, {{200, -20., +20., "#it{z}_{vtx} position (cm)"}});
 
@@ -140,28 +149,6 @@ struct multFilter {
   Filter trackFilter = (nabs(aod::track::eta) < cfgTrkEtaCut) && (aod::track::pt > cfgTrkLowPtCut);
   using TrackCandidates = soa::Filtered<soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksDCA, aod::TrackSelection>>;
 
-  int getT0ASector(int i_ch)
-  {
-    int i_sec_t0a = -1;
-    for (int i_sec = 0; i_sec < 24; ++i_sec) {
-      if (i_ch >= 4 * i_sec && i_ch <= 3 + 4 * i_sec) {
-        i_sec_t0a = i_sec;
-        break;
-      }
-    }
-    return i_sec_t0a;
-  }
-  int getT0CSector(int i_ch)
-  {
-    int i_sec_t0c = -1;
-    for (int i_sec = 0; i_sec < 28; ++i_sec) {
-      if (i_ch >= 4 * i_sec && i_ch <= 3 + 4 * i_sec) {
-        i_sec_t0c = i_sec;
-        break;
-      }
-    }
-    return i_sec_t0c;
-  }
   float GetFlatenicity(float signals[], int entries)
   {
     float flat = 9999;
@@ -186,33 +173,33 @@ struct multFilter {
     }
     return flat;
   }
-  void process(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, TrackCandidates const& tracks, aod::FT0s const& ft0s, aod::FV0As const& fv0s)
+  // per-dataframe estimators and trigger decisions, [estimator][collision]
+  std::array<std::vector<float>, kNtriggersMM> estimators;
+  std::array<std::vector<uint8_t>, kNtriggersMM> keepEvents;
+  std::vector<int> multTracks;
+  std::vector<float> leadingPts;
+
+  // per-dataframe histogram accumulators
+  o2::analysis::mm::HistogramBuffer1D bufCollZpos, bufFT0A, bufFT0C, bufEtaGlobal, bufPhiGlobal, bufDCAxyGlobal, bufEstimator;
+  o2::analysis::mm::HistogramBuffer2D bufAmpT0AVsCh, bufAmpT0CVsCh, bufAmpT0AvsVtx, bufAmpT0CvsVtx, bufEstimatorProfile;
+  o2::analysis::mm::BinCounter<kNtriggersMM + 3> cntProcessed, cntOverlap1, cntOverlap2, cntOverlap3;
+  std::vector<double> estimatorValues, trackMultValues;
+
+  // FV0 and FT0 estimators of one collision, the track estimators are set from the track pass
+  template <typename C>
+  void computeFitEstimators(C const& collision, int iColl)
   {
-
-    bool keepEvent[kNtriggersMM]{false};
     auto vtxZ = collision.posZ();
-    multiplicity.fill(HIST("fProcessedEvents"), 0);
-    multiplicity.fill(HIST("fCollZpos"), collision.posZ());
-    // global observables
-    int multTrack = 0;
-    float flPt = 0; // leading pT
     double flatenicity_fv0 = 9999;
 
     float sumAmpFV0 = 0;
-    // float sumAmpFV01to4Ch = 0;
     int innerFV0 = 32;
     const int nCells = 48; // 48 sectors in FV0
 
     if (collision.has_foundFV0()) {
-      float RhoLattice[nCells];
-      for (Int_t iCh = 0; iCh < nCells; iCh++) {
-        RhoLattice[iCh] = 0;
-      }
-
+      float RhoLattice[nCells]{0};
       auto fv0 = collision.foundFV0();
-      // LOGP(info, "amplitude.size()={}", fv0.amplitude().size());
       for (std::size_t ich = 0; ich < fv0.amplitude().size(); ich++) {
-
         int channelv0 = fv0.channel()[ich];
         float ampl_ch = fv0.amplitude()[ich];
         sumAmpFV0 += ampl_ch;
@@ -222,177 +209,193 @@ struct multFilter {
           RhoLattice[channelv0] = ampl_ch / 2.0; // two channels per bin
         }
       }
-
       flatenicity_fv0 = GetFlatenicity(RhoLattice, nCells);
     }
 
-    // FT0
+    // FT0, four channels per sector
     float sumAmpFT0A = 0.f;
     float sumAmpFT0C = 0.f;
     const int nCellsT0A = 24;
-    float RhoLatticeT0A[nCellsT0A];
-    for (int iCh = 0; iCh < nCellsT0A; iCh++) {
-      RhoLatticeT0A[iCh] = 0.0;
-    }
+    float RhoLatticeT0A[nCellsT0A]{0};
     const int nCellsT0C = 28;
-    float RhoLatticeT0C[nCellsT0C];
-    for (int iCh = 0; iCh < nCellsT0C; iCh++) {
-      RhoLatticeT0C[iCh] = 0.0;
-    }
+    float RhoLatticeT0C[nCellsT0C]{0};
 
     if (collision.has_foundFT0()) {
       auto ft0 = collision.foundFT0();
       for (std::size_t i_a = 0; i_a < ft0.amplitudeA().size(); i_a++) {
         float amplitude = ft0.amplitudeA()[i_a];
-        uint8_t channel = ft0.channelA()[i_a];
-        int sector = getT0ASector(channel);
-        if (sector >= 0 && sector < 24) {
+        int sector = ft0.channelA()[i_a] / 4;
+        if (sector < nCellsT0A) {
           RhoLatticeT0A[sector] += amplitude;
-          multiplicity.fill(HIST("hAmpT0AVsCh"), sector, amplitude);
+          bufAmpT0AVsCh.push(sector, amplitude);
         }
         sumAmpFT0A += amplitude;
-        multiplicity.fill(HIST("hFT0A"), amplitude);
+        bufFT0A.push(amplitude);
       }
       for (std::size_t i_c = 0; i_c < ft0.amplitudeC().size(); i_c++) {
         float amplitude = ft0.amplitudeC()[i_c];
         sumAmpFT0C += amplitude;
-        uint8_t channel = ft0.channelC()[i_c];
-        int sector = getT0CSector(channel);
-        if (sector >= 0 && sector < 28) {
+        int sector = ft0.channelC()[i_c] / 4;
+        if (sector < nCellsT0C) {
           RhoLatticeT0C[sector] += amplitude;
-          multiplicity.fill(HIST("hAmpT0CVsCh"), sector, amplitude);
+          bufAmpT0CVsCh.push(sector, amplitude);
         }
-        multiplicity.fill(HIST("hFT0C"), amplitude);
+        bufFT0C.push(amplitude);
       }
-      multiplicity.fill(HIST("hAmpT0AvsVtx"), vtxZ, sumAmpFT0A);
-      multiplicity.fill(HIST("hAmpT0CvsVtx"), vtxZ, sumAmpFT0C);
+      bufAmpT0AvsVtx.push(vtxZ, sumAmpFT0A);
+      bufAmpT0CvsVtx.push(vtxZ, sumAmpFT0C);
     }
     float flatenicity_t0a = GetFlatenicity(RhoLatticeT0A, nCellsT0A);
     float flatenicity_t0c = GetFlatenicity(RhoLatticeT0C, nCellsT0C);
 
-    // Globaltracks
+    // option 5: FT0C + FT0A
+    // float weigthsEta5[nEta5] = {0.0569502, 0.014552069};// values for pilot run, 900 GeV
+    float combined_estimator5 = 0;
+    if (sumAmpFT0C > 0 && sumAmpFT0A > 0) {
+      combined_estimator5 = sumAmpFT0C * 0.0490638f + sumAmpFT0A * 0.010958415f;
+    }
+    // option 6: FT0C + FV0
+    // float weigthsEta6[nEta6] = {0.0569502, 0.00535717};
+    float combined_estimator6 = 0;
+    if (sumAmpFT0C > 0 && sumAmpFV0 > 0) {
+      combined_estimator6 = sumAmpFT0C * 0.0490638f + sumAmpFV0 * 0.00353962f;
+    }
 
+    estimators[kHighFv0Mult][iColl] = sumAmpFV0;
+    estimators[kHighFv0Flat][iColl] = 1.0 - flatenicity_fv0;
+    estimators[kHighFt0Mult][iColl] = combined_estimator5;
+    float flatenicity_ft0 = (flatenicity_t0a + flatenicity_t0c) / 2.0;
+    estimators[kHighFt0Flat][iColl] = 1.0 - flatenicity_ft0;
+    estimators[kHighFt0cFv0Mult][iColl] = combined_estimator6;
+    estimators[kHighFt0cFv0Flat][iColl] = 1.0 - (flatenicity_fv0 + flatenicity_t0c) / 2.0;
+  }
+
+  // The collisions of a dataframe are processed together: the track estimators are computed in one pass over the
+  // tracks, the thresholds are applied estimator by estimator over all collisions and the histograms are filled
+  // once per dataframe from the buffered values.
+  void process(soa::Join<aod::Collisions, aod::EvSels> const& collisions, TrackCandidates const& tracks, aod::FT0s const& ft0s, aod::FV0As const& fv0s)
+  {
+    const int nColl = collisions.size();
+    for (int i_e = 0; i_e < kNtriggersMM; ++i_e) {
+      estimators[i_e].assign(nColl, 0.f);
+      keepEvents[i_e].resize(nColl);
+    }
+    multTracks.assign(nColl, 0);
+    leadingPts.assign(nColl, 0.f);
+
+    // Globaltracks
+    bufEtaGlobal.clear();
+    bufPhiGlobal.clear();
+    bufDCAxyGlobal.clear();
     for (auto& track : tracks) {
-      if (!myTrackSelection().IsSelected(track)) {
+      const int iColl = track.collisionId();
+      if (iColl < 0 || !mTrackSelection.IsSelected(track)) {
         continue;
       }
-      float eta_a = track.eta();
-      float phi_a = track.phi();
       float pt_a = track.pt();
-      multTrack++;
-      multiplicity.fill(HIST("hdNdetaGlobal"), eta_a);
-      multiplicity.fill(HIST("hPhiGlobal"), phi_a);
-      multiplicity.fill(HIST("hDCAxyGlobal"), track.dcaXY());
-      if (flPt < pt_a) {
-        flPt = pt_a;
+      multTracks[iColl]++;
+      bufEtaGlobal.push(track.eta());
+      bufPhiGlobal.push(track.phi());
+      bufDCAxyGlobal.push(track.dcaXY());
+      if (leadingPts[iColl] < pt_a) {
+        leadingPts[iColl] = pt_a;
       }
     }
-    bool isOK_estimator5 = false;
-    bool isOK_estimator6 = false;
 
-    float combined_estimator5 = 0;
-    float combined_estimator6 = 0;
-    float estimator[8];
-    float cut[8];
-    for (int i_e = 0; i_e < 8; ++i_e) {
-      estimator[i_e] = 0;
-      cut[i_e] = 0;
-    }
-    cut[0] = selHTrkMult;
-    cut[1] = selHMFv0;
-    cut[2] = sel1Ffv0;
-    cut[3] = sel1Mft0;
-    cut[4] = sel1Fft0;
-    cut[5] = sel1Mft0cFv0;
-    cut[6] = sel1Fft0cFv0;
-    cut[7] = selPtTrig;
-    // option 5
-    const int nEta5 = 2; // FT0C + FT0A
-    // float weigthsEta5[nEta5] = {0.0569502, 0.014552069};// values for pilot run, 900 GeV
-    float weigthsEta5[nEta5] = {0.0490638, 0.010958415};
-    float ampl5[nEta5] = {0, 0};
-    ampl5[0] = sumAmpFT0C;
-    ampl5[1] = sumAmpFT0A;
-    if (sumAmpFT0C > 0 && sumAmpFT0A > 0) {
-      isOK_estimator5 = true;
+    // FIT
+    bufCollZpos.clear();
+    bufFT0A.clear();
+    bufFT0C.clear();
+    bufAmpT0AVsCh.clear();
+    bufAmpT0CVsCh.clear();
+    bufAmpT0AvsVtx.clear();
+    bufAmpT0CvsVtx.clear();
+    for (auto& collision : collisions) {
+      bufCollZpos.push(collision.posZ());
+      computeFitEstimators(collision, collision.globalIndex());
     }
-    if (isOK_estimator5) {
-      for (int i_5 = 0; i_5 < nEta5; ++i_5) {
-        combined_estimator5 += ampl5[i_5] * weigthsEta5[i_5];
-      }
-    }
-    // option 6
-    const int nEta6 = 2; //  FT0C + FV0
-    // float weigthsEta6[nEta6] = {0.0569502, 0.00535717};
-    float weigthsEta6[nEta6] = {0.0490638, 0.00353962};
-    float ampl6[nEta6] = {0, 0};
-    ampl6[0] = sumAmpFT0C;
-    ampl6[1] = sumAmpFV0;
-    if (sumAmpFT0C > 0 && sumAmpFV0 > 0) {
-      isOK_estimator6 = true;
+    for (int iColl = 0; iColl < nColl; ++iColl) {
+      estimators[kHighTrackMult][iColl] = multTracks[iColl];
+      estimators[kLeadingPtTrack][iColl] = leadingPts[iColl];
     }
-    if (isOK_estimator6) {
-      for (int i_6 = 0; i_6 < nEta6; ++i_6) {
-        combined_estimator6 += ampl6[i_6] * weigthsEta6[i_6];
+
+    // thresholds
+    const float cut[kNtriggersMM] = {selHTrkMult, selHMFv0, sel1Ffv0, sel1Mft0, sel1Fft0, sel1Mft0cFv0, sel1Fft0cFv0, selPtTrig};
+    for (int i_e = 0; i_e < kNtriggersMM; ++i_e) {
+      const float* est = estimators[i_e].data();
+      uint8_t* keep = keepEvents[i_e].data();
+      const float c = cut[i_e];
+      for (int iColl = 0; iColl < nColl; ++iColl) {
+        keep[iColl] = est[iColl] > c;
       }
     }
 
-    estimator[0] = multTrack;
-    estimator[1] = sumAmpFV0;
-    estimator[2] = 1.0 - flatenicity_fv0;
-    estimator[3] = combined_estimator5;
-    float flatenicity_ft0 = (flatenicity_t0a + flatenicity_t0c) / 2.0;
-    estimator[4] = 1.0 - flatenicity_ft0;
-    estimator[5] = combined_estimator6;
-    estimator[6] = 1.0 - (flatenicity_fv0 + flatenicity_t0c) / 2.0;
-    estimator[7] = flPt;
-
-    static_for<0, 7>([&](auto i) {
-      constexpr int index = i.value;
-      multiplicity.fill(HIST(npEst[index]), estimator[index], estimator[0]);
-      multiplicity.fill(HIST(nhEst_before[index]), estimator[index]);
-    });
-
-    static_for<0, 7>([&](auto i) {
-      constexpr int index = i.value;
-      if (estimator[index] > cut[index]) {
-        multiplicity.fill(HIST(nhEst_after[index]), estimator[index]);
-        keepEvent[index] = true;
+    for (int iColl = 0; iColl < nColl; ++iColl) {
+      bool keepEvent[kNtriggersMM];
+      bool keepAny = false;
+      for (int iTrigger{0}; iTrigger < kNtriggersMM; iTrigger++) {
+        keepEvent[iTrigger] = keepEvents[iTrigger][iColl];
+        keepAny |= keepEvent[iTrigger];
       }
-    });
+      tags(keepEvent[kHighTrackMult], keepEvent[kHighFv0Mult], keepEvent[kHighFv0Flat], keepEvent[kHighFt0Mult], keepEvent[kHighFt0Flat], keepEvent[kHighFt0cFv0Mult], keepEvent[kHighFt0cFv0Flat], keepEvent[kLeadingPtTrack]);
 
-    tags(keepEvent[kHighTrackMult], keepEvent[kHighFv0Mult], keepEvent[kHighFv0Flat], keepEvent[kHighFt0Mult], keepEvent[kHighFt0Flat], keepEvent[kHighFt0cFv0Mult], keepEvent[kHighFt0cFv0Flat], keepEvent[kLeadingPtTrack]);
-
-    if (!keepEvent[kHighTrackMult] && !keepEvent[kHighFv0Mult] && !keepEvent[kHighFv0Flat] && !keepEvent[kHighFt0Mult] && !keepEvent[kHighFt0Flat] && !keepEvent[kHighFt0cFv0Mult] && !keepEvent[kHighFt0cFv0Flat] && !keepEvent[kLeadingPtTrack]) {
-      multiplicity.fill(HIST("fProcessedEvents"), 1);
-    } else {
+      // bin i + 1 of the scalers holds the events of value i
+      cntProcessed.add(1);
+      if (!keepAny) {
+        cntProcessed.add(2);
+        continue;
+      }
       for (int iTrigger{0}; iTrigger < kNtriggersMM; iTrigger++) {
-        if (keepEvent[iTrigger]) {
-          multiplicity.fill(HIST("fProcessedEvents"), iTrigger + 2);
+        if (!keepEvent[iTrigger]) {
+          continue;
         }
-      }
-      if (keepEvent[kHighTrackMult]) {
-        for (int iTrigger{0}; iTrigger < kNtriggersMM; iTrigger++) {
-          if (keepEvent[iTrigger]) {
-            multiplicity.fill(HIST("fProcessedEvents_overlap1"), iTrigger + 2);
-          }
+        cntProcessed.add(iTrigger + 3);
+        if (keepEvent[kHighTrackMult]) {
+          cntOverlap1.add(iTrigger + 3);
         }
-      }
-      if (keepEvent[kHighFt0cFv0Mult]) {
-        for (int iTrigger{0}; iTrigger < kNtriggersMM; iTrigger++) {
-          if (keepEvent[iTrigger]) {
-            multiplicity.fill(HIST("fProcessedEvents_overlap2"), iTrigger + 2);
-          }
+        if (keepEvent[kHighFt0cFv0Mult]) {
+          cntOverlap2.add(iTrigger + 3);
         }
-      }
-      if (keepEvent[kHighFt0Mult]) {
-        for (int iTrigger{0}; iTrigger < kNtriggersMM; iTrigger++) {
-          if (keepEvent[iTrigger]) {
-            multiplicity.fill(HIST("fProcessedEvents_overlap3"), iTrigger + 2);
-          }
+        if (keepEvent[kHighFt0Mult]) {
+          cntOverlap3.add(iTrigger + 3);
         }
       }
     }
+
+    // histograms
+    bufCollZpos.fill(multiplicity.get<TH1>(HIST("fCollZpos")).get());
+    bufAmpT0AVsCh.fill(multiplicity.get<TH2>(HIST("hAmpT0AVsCh")).get());
+    bufAmpT0CVsCh.fill(multiplicity.get<TH2>(HIST("hAmpT0CVsCh")).get());
+    bufFT0A.fill(multiplicity.get<TH1>(HIST("hFT0A")).get());
+    bufFT0C.fill(multiplicity.get<TH1>(HIST("hFT0C")).get());
+    bufAmpT0AvsVtx.fill(multiplicity.get<TH2>(HIST("hAmpT0AvsVtx")).get());
+    bufAmpT0CvsVtx.fill(multiplicity.get<TH2>(HIST("hAmpT0CvsVtx")).get());
+    bufEtaGlobal.fill(multiplicity.get<TH1>(HIST("hdNdetaGlobal")).get());
+    bufPhiGlobal.fill(multiplicity.get<TH1>(HIST("hPhiGlobal")).get());
+    bufDCAxyGlobal.fill(multiplicity.get<TH1>(HIST("hDCAxyGlobal")).get());
+
+    trackMultValues.assign(multTracks.begin(), multTracks.end());
+    static_for<0, 7>([&](auto i) {
+      constexpr int index = i.value;
+      const auto& est = estimators[index];
+      if (nColl > 0) {
+        estimatorValues.assign(est.begin(), est.end());
+        multiplicity.get<TProfile>(HIST(npEst[index]))->FillN(nColl, estimatorValues.data(), trackMultValues.data(), nullptr);
+        multiplicity.get<TH1>(HIST(nhEst_before[index]))->FillN(nColl, estimatorValues.data(), nullptr);
+      }
+      bufEstimator.clear();
+      for (int iColl = 0; iColl < nColl; ++iColl) {
+        if (keepEvents[index][iColl]) {
+          bufEstimator.push(est[iColl]);
+        }
+      }
+      bufEstimator.fill(multiplicity.get<TH1>(HIST(nhEst_after[index])).get());
+    });
+
+    cntProcessed.flush(multiplicity.get<TH1>(HIST("fProcessedEvents")).get());
+    cntOverlap1.flush(multiplicity.get<TH1>(HIST("fProcessedEvents_overlap1")).get());
+    cntOverlap2.flush(multiplicity.get<TH1>(HIST("fProcessedEvents_overlap2")).get());
+    cntOverlap3.flush(multiplicity.get<TH1>(HIST("fProcessedEvents_overlap3")).get());
   }
 };
 TrackSelection multFilter::myTrackSelection()
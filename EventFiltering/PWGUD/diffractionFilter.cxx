@@ -77,6 +77,10 @@ struct DGFilterRun3 {
   // DG selector
   DGSelector dgSelector;
 
+  // sorted index and FIT activity of the BCs, built once per data frame
+  udhelpers::BCIndex bcIndex;
+  udhelpers::FITActivity fitActivity;
+
   // histograms with cut statistics
   // bin:
   //   1: All collisions
@@ -128,6 +132,11 @@ struct DGFilterRun3 {
                aod::FV0As& fv0as,
                aod::FDDs& fdds)
   {
+    // process is called per collision, update the BC information only for a new data frame
+    if (!bcIndex.isBuiltFor(bcs)) {
+      bcIndex.build(bcs);
+      fitActivity.build(bcs);
+    }
 
     // loop over 4 cases
     bool ccs[4]{false};
@@ -156,11 +165,11 @@ struct DGFilterRun3 {
       }
 
       // obtain slice of compatible BCs
-      auto bcRange = udhelpers::compatibleBCs(collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+      auto bcRange = udhelpers::compatibleBCs(bcIndex, collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
       LOGF(debug, "  Number of compatible BCs in +- %i / %i dtcoll: %i", diffCuts.NDtcoll(), diffCuts.minNBCs(), bcRange.size());
 
       // apply DG selection
-      auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bcRange, tracks, fwdtracks);
+      auto isDGEvent = dgSelector.IsSelected(diffCuts, fitActivity, collision, bcRange, tracks, fwdtracks);
 
       // save decision
       if (isDGEvent == 0) {
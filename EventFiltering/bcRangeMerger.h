@@ -0,0 +1,97 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file bcRangeMerger.h
+/// \brief Union of the BC ranges of the selected events of a data frame
+///
+/// The first and last BCs of the ranges are collected in two arrays which are sorted independently. A sweep over
+/// both arrays gives the union of the ranges in O(n log n), whatever the number of overlapping ranges. The merged
+/// ranges are sorted and disjoint, the range containing a BC is found with a binary search.
+
+#ifndef EVENTFILTERING_BCRANGEMERGER_H_
+#define EVENTFILTERING_BCRANGEMERGER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace o2::analysis::filtering
+{
+
+class BCRangeMerger
+{
+ public:
+  using Range = std::pair<int64_t, int64_t>;
+
+  void reset()
+  {
+    mFirst.clear();
+    mLast.clear();
+    mMerged.clear();
+  }
+
+  /// Adds the range [first, last]
+  void add(int64_t first, int64_t last)
+  {
+    mFirst.push_back(first);
+    mLast.push_back(last);
+  }
+
+  /// Merges the overlapping and adjacent ranges added since the last reset
+  /// \return merged ranges, sorted in first BC
+  std::vector<Range> const& merge()
+  {
+    mMerged.clear();
+    std::sort(mFirst.begin(), mFirst.end());
+    std::sort(mLast.begin(), mLast.end());
+    // a merged range starts with a first BC seen while no range is open and ends with the last BC which closes
+    // all the open ranges, adjacent ranges are kept open
+    std::size_t iLast = 0;
+    int nOpen = 0;
+    for (std::size_t iFirst = 0; iFirst < mFirst.size(); iFirst++) {
+      while (nOpen > 0 && mLast[iLast] + 1 < mFirst[iFirst]) {
+        if (--nOpen == 0) {
+          mMerged.back().second = mLast[iLast];
+        }
+        iLast++;
+      }
+      if (nOpen++ == 0) {
+        mMerged.emplace_back(mFirst[iFirst], mFirst[iFirst]);
+      }
+    }
+    if (!mMerged.empty()) {
+      mMerged.back().second = mLast.back();
+    }
+    return mMerged;
+  }
+
+  std::vector<Range> const& list() const { return mMerged; }
+
+  /// Index of the merged range containing bc, -1 if bc is in none of them
+  int64_t find(int64_t bc) const
+  {
+    auto it = std::upper_bound(mMerged.begin(), mMerged.end(), bc, [](int64_t value, Range const& range) { return value < range.first; });
+    if (it == mMerged.begin() || (--it)->second < bc) {
+      return -1;
+    }
+    return std::distance(mMerged.begin(), it);
+  }
+
+ private:
+  std::vector<int64_t> mFirst; ///< first BCs of the added ranges
+  std::vector<int64_t> mLast;  ///< last BCs of the added ranges
+  std::vector<Range> mMerged;  ///< union of the added ranges
+};
+
+} // namespace o2::analysis::filtering
+
+#endif // EVENTFILTERING_BCRANGEMERGER_H_
@@ -10,6 +10,10 @@
 // or submit itself to any jurisdiction.
 // O2 includes
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <cstdio>
 #include <random>
@@ -64,6 +68,28 @@ bool readJsonFile(std::string& config, Document& d)
   return true;
 }
 
+// Calls f(first, word) for each group of 64 values of a bit-packed buffer, as the values of an arrow::BooleanArray.
+// Bit i of word is the value first + i, the bits beyond length are 0.
+template <typename F>
+void forEachWord(const uint8_t* bits, int64_t offset, int64_t length, F&& f)
+{
+  for (int64_t first{0}; first < length; first += 64) {
+    const int64_t n{std::min<int64_t>(64, length - first)};
+    const int64_t bitPos{offset + first};
+    const int64_t shift{bitPos & 7};
+    uint8_t bytes[16] = {0};
+    std::memcpy(bytes, bits + (bitPos >> 3), (shift + n + 7) >> 3);
+    uint64_t low, high;
+    std::memcpy(&low, bytes, 8);
+    std::memcpy(&high, bytes + 8, 8);
+    uint64_t word{shift ? (low >> shift) | (high << (64 - shift)) : low};
+    if (n < 64) {
+      word &= (uint64_t(1) << n) - 1;
+    }
+    f(first, word);
+  }
+}
+
 std::unordered_map<std::string, std::unordered_map<std::string, float>> mDownscaling;
 static const std::vector<std::string> downscalingName{"Downscaling"};
 static const float defaultDownscaling[128][1]{
@@ -253,6 +279,9 @@ struct centralEventFilterTask {
         mScalers->GetXaxis()->SetBinLabel(bin, column.first.data());
         mFiltered->GetXaxis()->SetBinLabel(bin++, column.first.data());
       }
+      if (bin > 66) {
+        LOG(fatal) << "More than 64 trigger columns, they do not fit in the 64 bit trigger words.";
+      }
       if (!initc.options().isSet(table.first.data())) {
         continue;
       }
@@ -262,6 +291,8 @@ struct centralEventFilterTask {
         col.second = filterOpt.get(col.first.data(), 0u);
       }
     }
+    mScalerCounts.assign(nCols + 2, 0u);
+    mFilteredCounts.assign(nCols + 2, 0u);
   }
 
   void run(ProcessingContext& pc)
@@ -289,33 +320,59 @@ struct centralEventFilterTask {
         outTrigger.resize(nEvents, 0u);
       }
 
-      auto schema{tablePtr->schema()};
       for (auto& colName : tableName.second) {
         int bin{mScalers->GetXaxis()->FindBin(colName.first.data())};
-        double binCenter{mScalers->GetXaxis()->GetBinCenter(bin)};
         uint64_t triggerBit{BIT(bin - 2)};
         auto column{tablePtr->GetColumnByName(colName.first)};
         double downscaling{colName.second};
         if (column) {
-          int entry = 0;
+          int64_t entry{0};
           for (int64_t iC{0}; iC < column->num_chunks(); ++iC) {
-            auto chunk{column->chunk(iC)};
-            auto boolArray = std::static_pointer_cast<arrow::BooleanArray>(chunk);
-            for (int64_t iS{0}; iS < chunk->length(); ++iS) {
-              if (boolArray->Value(iS)) {
-                mScalers->Fill(binCenter);
-                outTrigger[entry] |= triggerBit;
-                if (mUniformGenerator(mGeneratorEngine) < downscaling) {
-                  mFiltered->Fill(binCenter);
-                  outDecision[entry] |= triggerBit;
+            auto boolArray = std::static_pointer_cast<arrow::BooleanArray>(column->chunk(iC));
+            // the values are read 64 at a time from the bit-packed buffer
+            forEachWord(boolArray->values()->data(), boolArray->offset(), boolArray->length(), [&](int64_t first, uint64_t fired) {
+              if (!fired) {
+                return;
+              }
+              const int nFired{__builtin_popcountll(fired)};
+              mScalerCounts[bin] += nFired;
+              // downscaling decisions, no random numbers are needed for channels which are all kept or all rejected
+              uint64_t accepted{downscaling >= 1. ? fired : 0u};
+              if (downscaling > 0. && downscaling < 1.) {
+                for (int i{0}; i < nFired; ++i) {
+                  mUniforms[i] = mUniformGenerator(mGeneratorEngine);
                 }
+                int i{0};
+                for (uint64_t bits{fired}; bits; bits &= bits - 1, ++i) {
+                  accepted |= static_cast<uint64_t>(mUniforms[i] < downscaling) << __builtin_ctzll(bits);
+                }
+              }
+              mFilteredCounts[bin] += __builtin_popcountll(accepted);
+              for (uint64_t bits{fired}; bits; bits &= bits - 1) {
+                outTrigger[entry + first + __builtin_ctzll(bits)] |= triggerBit;
+              }
+              for (uint64_t bits{accepted}; bits; bits &= bits - 1) {
+                outDecision[entry + first + __builtin_ctzll(bits)] |= triggerBit;
               }
-              entry++;
-            }
+            });
+            entry += boolArray->length();
           }
         }
       }
     }
+    // scalers are pushed to the histograms once per data frame
+    for (std::size_t bin{2}; bin < mScalerCounts.size(); ++bin) {
+      if (mScalerCounts[bin]) {
+        mScalers->AddBinContent(bin, mScalerCounts[bin]);
+        mScalers->SetEntries(mScalers->GetEntries() + mScalerCounts[bin]);
+      }
+      if (mFilteredCounts[bin]) {
+        mFiltered->AddBinContent(bin, mFilteredCounts[bin]);
+        mFiltered->SetEntries(mFiltered->GetEntries() + mFilteredCounts[bin]);
+      }
+      mScalerCounts[bin] = 0u;
+      mFilteredCounts[bin] = 0u;
+    }
     mScalers->SetBinContent(1, mScalers->GetBinContent(1) + nEvents);
     mFiltered->SetBinContent(1, mFiltered->GetBinContent(1) + nEvents);
 
@@ -361,6 +418,9 @@ struct centralEventFilterTask {
     }
   }
 
+  std::vector<uint64_t> mScalerCounts;   // accepted events per scaler bin in the current data frame
+  std::vector<uint64_t> mFilteredCounts; // filtered events per scaler bin in the current data frame
+  std::array<double, 64> mUniforms;      // random numbers of the downscaling of a group of 64 events
   std::mt19937_64 mGeneratorEngine;
   std::uniform_real_distribution<double> mUniformGenerator = std::uniform_real_distribution<double>(0., 1.);
 };
@@ -93,6 +93,18 @@ DECLARE_SOA_COLUMN(CefpSelected, hasCefpSelected, uint64_t);   //! CEFP decision
 
 } // namespace decision
 
+namespace skimindex
+{
+
+DECLARE_SOA_COLUMN(GlobalBCFirst, globalBCFirst, uint64_t);  //! first BC of the selected range
+DECLARE_SOA_COLUMN(GlobalBCLast, globalBCLast, uint64_t);    //! last BC of the selected range
+DECLARE_SOA_COLUMN(BCFirst, bcFirst, int64_t);               //! row of the first BC of the range in the BCs table
+DECLARE_SOA_COLUMN(NBCs, nBCs, int64_t);                     //! number of rows of the range in the BCs table
+DECLARE_SOA_COLUMN(CollisionFirst, collisionFirst, int64_t); //! first row of the Collisions table with found BC in the range, -1 if none
+DECLARE_SOA_COLUMN(NCollisions, nCollisions, int64_t);       //! number of rows of the Collisions table from collisionFirst up to the last collision of the range
+
+} // namespace skimindex
+
 // nuclei
 DECLARE_SOA_TABLE(NucleiFilters, "AOD", "NucleiFilters", //!
                   filtering::H2, filtering::H3, filtering::He3, filtering::He4);
@@ -147,6 +159,11 @@ DECLARE_SOA_TABLE(CefpDecisions, "AOD", "CefpDecision", //!
                   decision::BCId, decision::CefpTriggered, decision::CefpSelected);
 using CefpDecision = CefpDecisions::iterator;
 
+// index of the selected BC ranges of a data frame, written by the BC range selector
+DECLARE_SOA_TABLE(BCRangeIndices, "AOD", "BCRangeIndex", //!
+                  skimindex::GlobalBCFirst, skimindex::GlobalBCLast, skimindex::BCFirst, skimindex::NBCs, skimindex::CollisionFirst, skimindex::NCollisions);
+using BCRangeIndex = BCRangeIndices::iterator;
+
 /// List of the available filters, the description of their tables and the name of the tasks
 constexpr int NumberOfFilters{9};
 constexpr std::array<char[32], NumberOfFilters> AvailableFilters{"NucleiFilters", "DiffractionFilters", "DqFilters", "HfFilters", "CFFiltersTwoN", "CFFilters", "JetFilters", "StrangenessFilters", "MultFilters"};
@@ -179,6 +196,16 @@ static std::vector<std::string> ColumnsNames(o2::framework::pack<C...>)
   return {C::columnLabel()...};
 }
 
+/// Rows [first, first + n) of table, e.g. the rows of a selected BC range given by BCRangeIndices,
+/// to process only the selected part of a data frame
+template <typename T>
+T selectedRows(T const& table, int64_t first, int64_t n)
+{
+  T slice{{table.asArrowTable()->Slice(first, n)}, static_cast<uint64_t>(first)};
+  table.copyIndexBindings(slice);
+  return slice;
+}
+
 template <typename T>
 unsigned int NumberOfColumns()
 {
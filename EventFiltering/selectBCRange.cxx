@@ -17,11 +17,13 @@
 #include "CommonDataFormat/IRFrame.h"
 #include "ReconstructionDataFormats/BCRange.h"
 #include "filterTables.h"
+#include "bcRangeMerger.h"
 #include "PWGUD/Core/UDHelpers.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::filtering;
 
 // .............................................................................
 // Run 3
@@ -40,13 +42,20 @@ struct BCRangeSelector {
   uint64_t nBCs, nCompBCs, nNotCompBCs;
   uint64_t clast, cnew;
   o2::dataformats::bcRanges cbcrs = o2::dataformats::bcRanges("Initial list"); // ranges of compatible BCs
+  udhelpers::BCIndex bcIndex;                                                  // sorted globalBCs of the data frame
+  BCRangeMerger merger;                                                        // union of the ranges of the selected collisions
 
   // buffer for task output
   std::vector<o2::dataformats::IRFrame> res;
 
+  // index of the selected ranges, allows the skimming to read only the selected rows of the data frame
+  Produces<aod::BCRangeIndices> bcRangeIndices;
+  std::vector<int64_t> rangeBCFirst, rangeNBCs, rangeCollFirst, rangeCollLast;
+
   void init(o2::framework::InitContext&)
   {
     cbcrs.reset();
+    merger.reset();
     res.clear();
   }
 
@@ -70,22 +79,29 @@ struct BCRangeSelector {
     }
 
     // 1. loop over collisions
+    bcIndex.build(bcs);
     auto filt = fdecs.begin();
     for (auto collision : cols) {
-      if (filt.hasCefpSelected()) {
+      if (filt.hasCefpSelected() && collision.has_foundBC()) {
 
-        // get range of compatible BCs
-        auto bcRange = udhelpers::compatibleBCs(collision, nTimeRes, bcs, nMinBSs);
+        // get range of compatible BCs, the rows of the BC window are found with a binary search
+        uint64_t meanBC = bcIndex.bc(collision.foundBCId()) + std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
+        int deltaBC = std::max(nMinBSs.value, (int)std::ceil(collision.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * nTimeRes));
+        auto [first, last] = bcIndex.range((uint64_t)deltaBC < meanBC ? meanBC - (uint64_t)deltaBC : 0, meanBC + (uint64_t)deltaBC);
 
-        // update list of ranges
-        auto bcfirst = bcRange.rawIteratorAt(0);
-        auto bclast = bcRange.rawIteratorAt(bcRange.size());
-        cbcrs.add(bcfirst.globalIndex(), bclast.globalIndex());
+        // update list of ranges, rows [first, last)
+        if (last > first) {
+          merger.add(first, last - 1);
+        }
       }
       filt++;
     }
 
-    // 2. sort, merge, and extend ranges of compatible BCs
+    // 2. merge the ranges of compatible BCs with a sweep over the sorted first and last rows,
+    // the merged ranges are disjoint and sorted, their extension is left to bcRanges
+    for (auto const& range : merger.merge()) {
+      cbcrs.add(range.first, range.second + 1);
+    }
     cbcrs.compact(bcs, fillFac);
 
     // fill res
@@ -100,8 +116,45 @@ struct BCRangeSelector {
     // make res an output
     pc.outputs().snapshot({"PPF", "IFRAMES", 0, Lifetime::Timeframe}, res);
 
+    // 3. rows of the BCs and collisions of the selected ranges
+    rangeBCFirst.clear();
+    rangeNBCs.clear();
+    for (auto limit : cbcrs.list()) {
+      auto [first, last] = bcIndex.range(limit.first, limit.second);
+      rangeBCFirst.push_back(first);
+      rangeNBCs.push_back(last - first);
+    }
+    rangeCollFirst.assign(rangeBCFirst.size(), -1);
+    rangeCollLast.assign(rangeBCFirst.size(), -1);
+    for (auto collision : cols) {
+      if (!collision.has_foundBC()) {
+        continue;
+      }
+      // the ranges are disjoint and sorted, the range of the found BC is the last one starting before it
+      int64_t row = collision.foundBCId();
+      auto it = std::upper_bound(rangeBCFirst.begin(), rangeBCFirst.end(), row);
+      if (it == rangeBCFirst.begin()) {
+        continue;
+      }
+      auto ind = std::distance(rangeBCFirst.begin(), it) - 1;
+      if (row >= rangeBCFirst[ind] + rangeNBCs[ind]) {
+        continue;
+      }
+      if (rangeCollFirst[ind] < 0) {
+        rangeCollFirst[ind] = collision.globalIndex();
+      }
+      rangeCollLast[ind] = collision.globalIndex();
+    }
+    auto ind = 0;
+    for (auto limit : cbcrs.list()) {
+      auto nColls = rangeCollFirst[ind] < 0 ? 0 : rangeCollLast[ind] - rangeCollFirst[ind] + 1;
+      bcRangeIndices(limit.first, limit.second, rangeBCFirst[ind], rangeNBCs[ind], rangeCollFirst[ind], nColls);
+      ind++;
+    }
+
     // clean up
     cbcrs.reset();
+    merger.reset();
     res.clear();
   }
 
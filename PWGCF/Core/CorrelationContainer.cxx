@@ -57,7 +57,9 @@ CorrelationContainer::CorrelationContainer() : TNamed(),
                                                mSkipScaleMixedEvent(kFALSE),
                                                mCache(nullptr),
                                                mGetMultCacheOn(kFALSE),
-                                               mGetMultCache(nullptr)
+                                               mGetMultCache(nullptr),
+                                               mProjectionCacheOn(kFALSE),
+                                               mProjectionCache(nullptr)
 {
   // Default constructor
 }
@@ -84,7 +86,9 @@ CorrelationContainer::CorrelationContainer(const char* name, const char* objTitl
                                                                                                    mSkipScaleMixedEvent(kFALSE),
                                                                                                    mCache(nullptr),
                                                                                                    mGetMultCacheOn(kFALSE),
-                                                                                                   mGetMultCache(nullptr)
+                                                                                                   mGetMultCache(nullptr),
+                                                                                                   mProjectionCacheOn(kFALSE),
+                                                                                                   mProjectionCache(nullptr)
 {
   // correlationAxis has to provide a 6 length list of AxisSpec which contain:
   //   delta_eta, pt_assoc, pt_trig, multiplicity/centrality, delta_phi, vertex
@@ -139,7 +143,9 @@ CorrelationContainer::CorrelationContainer(const CorrelationContainer& c) : TNam
                                                                             mSkipScaleMixedEvent(kFALSE),
                                                                             mCache(nullptr),
                                                                             mGetMultCacheOn(kFALSE),
-                                                                            mGetMultCache(nullptr)
+                                                                            mGetMultCache(nullptr),
+                                                                            mProjectionCacheOn(kFALSE),
+                                                                            mProjectionCache(nullptr)
 {
   //
   // CorrelationContainer copy constructor
@@ -177,6 +183,8 @@ CorrelationContainer::~CorrelationContainer()
     delete mCache;
     mCache = nullptr;
   }
+
+  clearProjectionCache();
 }
 
 //____________________________________________________________________
@@ -222,6 +230,8 @@ void CorrelationContainer::Copy(TObject& c) const
   target.mTrackEtaCut = mTrackEtaCut;
   target.mWeightPerEvent = mWeightPerEvent;
   target.mSkipScaleMixedEvent = mSkipScaleMixedEvent;
+
+  target.clearProjectionCache();
 }
 
 //____________________________________________________________________
@@ -239,48 +249,50 @@ Long64_t CorrelationContainer::Merge(TCollection* list)
     return 1;
   }
 
-  TIterator* iter = list->MakeIterator();
-  TObject* obj = nullptr;
-
-  // collections of objects
-  const UInt_t kMaxLists = 4;
-  TList** lists = new TList*[kMaxLists];
-
-  for (UInt_t i = 0; i < kMaxLists; i++) {
-    lists[i] = new TList;
-  }
+  // the histograms are collected per kind and merged once per kind, StepTHn::Merge adds the raw bin arrays of the
+  // filled steps only (the arrays of the steps and the sumw2 are allocated at their first fill)
+  TList pairHists;
+  TList triggerHists;
+  TList efficiencyHists;
+  TList eventCounts;
 
   Int_t count = 0;
-  while ((obj = iter->Next())) {
-
+  TIter next(list);
+  while (TObject* obj = next()) {
     CorrelationContainer* entry = dynamic_cast<CorrelationContainer*>(obj);
     if (entry == nullptr) {
       continue;
     }
 
     if (entry->mPairHist) {
-      lists[0]->Add(entry->mPairHist);
+      pairHists.Add(entry->mPairHist);
+    }
+    if (entry->mTriggerHist) {
+      triggerHists.Add(entry->mTriggerHist);
+    }
+    if (entry->mTrackHistEfficiency) {
+      efficiencyHists.Add(entry->mTrackHistEfficiency);
+    }
+    if (entry->mEventCount) {
+      eventCounts.Add(entry->mEventCount);
     }
-
-    lists[1]->Add(entry->mTriggerHist);
-    lists[2]->Add(entry->mTrackHistEfficiency);
-    lists[3]->Add(entry->mEventCount);
 
     count++;
   }
-  if (mPairHist) {
-    mPairHist->Merge(lists[0]);
+  if (mPairHist && !pairHists.IsEmpty()) {
+    mPairHist->Merge(&pairHists);
   }
-
-  mTriggerHist->Merge(lists[1]);
-  mTrackHistEfficiency->Merge(lists[2]);
-  mEventCount->Merge(lists[3]);
-
-  for (UInt_t i = 0; i < kMaxLists; i++) {
-    delete lists[i];
+  if (mTriggerHist && !triggerHists.IsEmpty()) {
+    mTriggerHist->Merge(&triggerHists);
+  }
+  if (mTrackHistEfficiency && !efficiencyHists.IsEmpty()) {
+    mTrackHistEfficiency->Merge(&efficiencyHists);
+  }
+  if (mEventCount && !eventCounts.IsEmpty()) {
+    mEventCount->Merge(&eventCounts);
   }
 
-  delete[] lists;
+  clearProjectionCache();
 
   return count + 1;
 }
@@ -388,6 +400,19 @@ void CorrelationContainer::getHistsZVtxMult(CorrelationContainer::CFStep step, F
   // a 2d histogram on event level (as fct of zvtx, multiplicity)
   // Histograms has to be deleted by the caller of the function
 
+  TString cacheKey;
+  if (mProjectionCacheOn) {
+    cacheKey.Form("proj_%d_%g_%g_%g_%g_%g_%g", step, ptTriggerMin, ptTriggerMax, mEtaMin, mEtaMax, mPtMin, mPtMax);
+    auto cachedTrackHist = mProjectionCache ? dynamic_cast<THnBase*>(mProjectionCache->FindObject(cacheKey + "_track")) : nullptr;
+    auto cachedEventHist = mProjectionCache ? dynamic_cast<TH2*>(mProjectionCache->FindObject(cacheKey + "_event")) : nullptr;
+    if (cachedTrackHist && cachedEventHist) {
+      *trackHist = dynamic_cast<THnBase*>(cachedTrackHist->Clone());
+      *eventHist = dynamic_cast<TH2*>(cachedEventHist->Clone());
+      (*eventHist)->SetDirectory(nullptr);
+      return;
+    }
+  }
+
   THnBase* sparse = mPairHist->getTHn(step);
   if (mGetMultCacheOn) {
     if (!mGetMultCache) {
@@ -418,6 +443,33 @@ void CorrelationContainer::getHistsZVtxMult(CorrelationContainer::CFStep step, F
 
   resetBinLimits(sparse, 6);
   resetBinLimits(mTriggerHist->getTHn(step), 3);
+
+  if (mProjectionCacheOn) {
+    if (!mProjectionCache) {
+      mProjectionCache = new TList;
+      mProjectionCache->SetOwner(kTRUE);
+    }
+    mProjectionCache->Add((*trackHist)->Clone(cacheKey + "_track"));
+    auto cachedEventHist = dynamic_cast<TH2*>((*eventHist)->Clone(cacheKey + "_event"));
+    cachedEventHist->SetDirectory(nullptr);
+    mProjectionCache->Add(cachedEventHist);
+  }
+}
+
+void CorrelationContainer::setProjectionCache(Bool_t flag)
+{
+  mProjectionCacheOn = flag;
+  if (!flag) {
+    clearProjectionCache();
+  }
+}
+
+void CorrelationContainer::clearProjectionCache()
+{
+  if (mProjectionCache) {
+    delete mProjectionCache;
+    mProjectionCache = nullptr;
+  }
 }
 
 TH2* CorrelationContainer::getPerTriggerYield(CorrelationContainer::CFStep step, Float_t ptTriggerMin, Float_t ptTriggerMax, Bool_t normalizePerTrigger)
@@ -1624,6 +1676,8 @@ void CorrelationContainer::Reset()
 {
   // resets all contained histograms
 
+  clearProjectionCache();
+
   for (Int_t step = 0; step < mPairHist->getNSteps(); step++) {
     mPairHist->getTHn(step)->Reset();
   }
@@ -1649,3 +1703,9 @@ void CorrelationContainer::fillEvent(Float_t centrality, CFStep step)
   // Fill per-event information
   mEventCount->Fill(step, centrality);
 }
+
+void CorrelationContainer::mergePairFillBuffer(PairFillBuffer& buffer)
+{
+  // Fill the entries of the buffer into the pair histogram and clear the buffer
+  buffer.flush(mPairHist);
+}
@@ -18,6 +18,11 @@
 #include "TString.h"
 #include "Framework/HistogramSpec.h"
 
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 class TH1;
 class TH1F;
 class TH3;
@@ -27,10 +32,55 @@ class TH1D;
 class TH2;
 class TH2D;
 class TCollection;
+class TList;
 class THnSparse;
 class THnBase;
 class StepTHn;
 
+// Buffer of the fills of a StepTHn with N axes
+// Each thread fills its own buffer, the buffers are then merged into the histogram by the thread owning it, without locking.
+// The entries are replayed in their order of filling, so merging the buffers in a fixed order gives the same histogram as a serial fill.
+template <int N>
+class StepTHnFillBuffer
+{
+ public:
+  void fill(int step, std::array<float, N> const& values, float weight)
+  {
+    mSteps.push_back(step);
+    mValues.insert(mValues.end(), values.begin(), values.end());
+    mWeights.push_back(weight);
+  }
+
+  // fills the buffered entries into the histogram and clears the buffer
+  template <typename THist>
+  void flush(THist* hist)
+  {
+    for (size_t i = 0; i < mSteps.size(); i++) {
+      flushEntry(hist, i, std::make_index_sequence<N>{});
+    }
+    clear();
+  }
+
+  void clear()
+  {
+    mSteps.clear();
+    mValues.clear();
+    mWeights.clear();
+  }
+  size_t size() const { return mSteps.size(); }
+
+ private:
+  template <typename THist, size_t... Is>
+  void flushEntry(THist* hist, size_t i, std::index_sequence<Is...>)
+  {
+    hist->Fill(mSteps[i], mValues[i * N + Is]..., mWeights[i]);
+  }
+
+  std::vector<int8_t> mSteps;  // step of each entry
+  std::vector<float> mValues;  // N values per entry
+  std::vector<float> mWeights; // weight of each entry
+};
+
 class CorrelationContainer : public TNamed
 {
  public:
@@ -71,6 +121,10 @@ class CorrelationContainer : public TNamed
   void setTriggerHist(StepTHn* hist) { mTriggerHist = hist; }
   void setTrackHistEfficiency(StepTHn* hist) { mTrackHistEfficiency = hist; }
 
+  // buffered fills of the pair histogram: delta eta, pT associated, pT trigger, multiplicity, delta phi, z-vtx
+  using PairFillBuffer = StepTHnFillBuffer<6>;
+  void mergePairFillBuffer(PairFillBuffer& buffer);
+
   void deepCopy(CorrelationContainer* from);
 
   void getHistsZVtxMult(CorrelationContainer::CFStep step, Float_t ptTriggerMin, Float_t ptTriggerMax, THnBase** trackHist, TH2** eventHist);
@@ -139,6 +193,10 @@ class CorrelationContainer : public TNamed
   void resetBinLimits(THnBase* grid, int max_dimension = -1);
 
   void setGetMultCache(Bool_t flag = kTRUE) { mGetMultCacheOn = flag; }
+  // memoizes the projections of getHistsZVtxMult per step, trigger pT range and associated eta and pT limits, for
+  // post-processing which extracts several centrality or vertex ranges; the container must not be filled anymore
+  void setProjectionCache(Bool_t flag = kTRUE);
+  void clearProjectionCache();
 
   CorrelationContainer(const CorrelationContainer& c);
   CorrelationContainer& operator=(const CorrelationContainer& corr);
@@ -178,6 +236,9 @@ class CorrelationContainer : public TNamed
   Bool_t mGetMultCacheOn; //! cache for getHistsZVtxMult function active
   THnBase* mGetMultCache; //! cache for getHistsZVtxMult function
 
+  Bool_t mProjectionCacheOn; //! memoization of the getHistsZVtxMult projections active
+  TList* mProjectionCache;   //! memoized getHistsZVtxMult projections, named by their step and ranges
+
   ClassDef(CorrelationContainer, 2) // underlying event histogram container
 };
 
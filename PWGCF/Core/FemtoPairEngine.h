@@ -0,0 +1,201 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file FemtoPairEngine.h
+/// \brief FemtoPairEngine - Same-event and mixed-event pair loops shared by the FemtoDream and FemtoWorld pair tasks
+
+#ifndef PWGCF_CORE_FEMTOPAIRENGINE_H_
+#define PWGCF_CORE_FEMTOPAIRENGINE_H_
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Framework/ASoAHelpers.h"
+
+namespace o2::analysis::femtoPair
+{
+
+/// \class FemtoPairEngine
+/// \brief Builds the same-event and mixed-event pairs of two particle types, whatever their types (T-T, T-V0, V0-V0, ...)
+/// The selected particles of a collision are compacted once, instead of being selected again for every pair,
+/// and all the pairs go through the same close pair rejection, pair cleaning and container filling
+/// \tparam TSameEventCont Correlation container for the same event
+/// \tparam TMixedEventCont Correlation container for the mixed event
+/// \tparam TPairCleaner Pair cleaner of the two particle types
+/// \tparam TCloseRejection Close pair rejection of the two particle types
+/// \tparam HasPhiStarCache Whether TCloseRejection provides cachePhiStar and isClosePairCached
+template <typename TSameEventCont, typename TMixedEventCont, typename TPairCleaner, typename TCloseRejection, bool HasPhiStarCache = false>
+class FemtoPairEngine
+{
+ public:
+  /// Selected particle of a collision and its position in the collision slice
+  template <typename TIterator>
+  struct SelectedParticle {
+    TIterator part;
+    int position;
+  };
+
+  /// Setting the objects used for the pairs, owned by the task
+  /// \param useCPR whether the close pair rejection is applied
+  /// \param cachePhiStar whether the phi* of the particles are computed once per event for the close pair rejection
+  void init(TSameEventCont* sameEventCont, TMixedEventCont* mixedEventCont, TPairCleaner* pairCleaner, TCloseRejection* closeRejection, bool useCPR, bool cachePhiStar = false)
+  {
+    mSameEventCont = sameEventCont;
+    mMixedEventCont = mixedEventCont;
+    mPairCleaner = pairCleaner;
+    mCloseRejection = closeRejection;
+    mUseCPR = useCPR;
+    mCachePhiStar = HasPhiStarCache && useCPR && cachePhiStar;
+  }
+
+  /// Selected particles of a collision slice
+  /// \param isSelected returns whether a particle is used for the pairs
+  template <typename TParts, typename TSelection>
+  auto selectParticles(TParts const& parts, TSelection&& isSelected)
+  {
+    std::vector<SelectedParticle<std::decay_t<decltype(parts.begin())>>> selected;
+    selected.reserve(parts.size());
+    int position = 0;
+    for (auto& part : parts) {
+      if (isSelected(part)) {
+        selected.push_back({part, position});
+      }
+      position++;
+    }
+    return selected;
+  }
+
+  /// Prepare the phi* cache of the close pair rejection for the pairs of two collision slices
+  template <typename TPartsOne, typename TPartsTwo>
+  void cachePhiStar(TPartsOne const& partsOne, TPartsTwo const& partsTwo, float magField)
+  {
+    if constexpr (HasPhiStarCache) {
+      if (mCachePhiStar) {
+        mCloseRejection->cachePhiStar(partsOne, magField, 0);
+        mCloseRejection->cachePhiStar(partsTwo, magField, 1);
+      }
+    }
+  }
+
+  /// Close pair rejection of a pair
+  template <typename TPartOne, typename TPartTwo, typename TParts>
+  bool isClosePair(TPartOne const& p1, TPartTwo const& p2, TParts const& parts, float magField)
+  {
+    if (!mUseCPR) {
+      return false;
+    }
+    if constexpr (HasPhiStarCache) {
+      if (mCachePhiStar) {
+        return mCloseRejection->isClosePairCached(p1, p2);
+      }
+    }
+    return mCloseRejection->isClosePair(p1, p2, parts, magField);
+  }
+
+  /// Same-event pair: close pair rejection, pair cleaning and filling of the container
+  template <typename TPartOne, typename TPartTwo, typename TParts>
+  void fillSameEventPair(TPartOne const& p1, TPartTwo const& p2, TParts const& parts, float magField, int mult)
+  {
+    if (isClosePair(p1, p2, parts, magField)) {
+      return;
+    }
+    // track cleaning
+    if (!mPairCleaner->isCleanPair(p1, p2, parts)) {
+      return;
+    }
+    mSameEventCont->setPair(p1, p2, mult);
+  }
+
+  /// Mixed-event pair: close pair rejection and filling of the container
+  template <typename TPartOne, typename TPartTwo, typename TParts>
+  void fillMixedEventPair(TPartOne const& p1, TPartTwo const& p2, TParts const& parts, float magField, int mult)
+  {
+    if (isClosePair(p1, p2, parts, magField)) {
+      return;
+    }
+    mMixedEventCont->setPair(p1, p2, mult);
+  }
+
+  /// Same-event pairs of two slices of the same collision, with the pairs of the strictly upper index combinations()
+  /// \param selOne returns whether a particle one is used for the pairs
+  /// \param selTwo returns whether a particle two is used for the pairs
+  template <typename TPartsOne, typename TPartsTwo, typename TParts, typename TSelOne, typename TSelTwo>
+  void processSameEvent(TPartsOne const& groupPartsOne, TPartsTwo const& groupPartsTwo, TParts const& parts, float magField, int mult, TSelOne&& selOne, TSelTwo&& selTwo)
+  {
+    const auto particlesOne = selectParticles(groupPartsOne, selOne);
+    const auto particlesTwo = selectParticles(groupPartsTwo, selTwo);
+    cachePhiStar(groupPartsOne, groupPartsTwo, magField);
+    auto first = particlesTwo.begin();
+    for (auto const& p1 : particlesOne) {
+      while (first != particlesTwo.end() && first->position <= p1.position) {
+        ++first;
+      }
+      for (auto p2 = first; p2 != particlesTwo.end(); ++p2) {
+        fillSameEventPair(p1.part, p2->part, parts, magField, mult);
+      }
+    }
+  }
+
+  /// Mixed-event pairs of two slices of different collisions, all the combinations
+  /// \param selOne returns whether a particle one is used for the pairs
+  /// \param selTwo returns whether a particle two is used for the pairs
+  template <typename TPartsOne, typename TPartsTwo, typename TParts, typename TSelOne, typename TSelTwo>
+  void processMixedEvent(TPartsOne const& groupPartsOne, TPartsTwo const& groupPartsTwo, TParts const& parts, float magField, int mult, TSelOne&& selOne, TSelTwo&& selTwo)
+  {
+    const auto particlesOne = selectParticles(groupPartsOne, selOne);
+    const auto particlesTwo = selectParticles(groupPartsTwo, selTwo);
+    if (particlesOne.empty() || particlesTwo.empty()) {
+      return;
+    }
+    cachePhiStar(groupPartsOne, groupPartsTwo, magField);
+    for (auto const& p1 : particlesOne) {
+      for (auto const& p2 : particlesTwo) {
+        fillMixedEventPair(p1.part, p2.part, parts, magField, mult);
+      }
+    }
+  }
+
+  /// Mixing back-end: calls mixCollisions for the pairs of collisions of the same mixing bin and magnetic field
+  /// \param binning mixing binning policy of the collisions
+  /// \param nEventsMix number of events for mixing
+  /// \param mixCollisions called with the two collisions
+  /// \param onCollisions called with the two collisions before the magnetic field check, e.g. for QA
+  template <typename TBinning, typename TCollisions, typename TMix, typename TOnCollisions>
+  void mixEvents(TBinning const& binning, int nEventsMix, TCollisions const& cols, TMix&& mixCollisions, TOnCollisions&& onCollisions)
+  {
+    for (auto& [collision1, collision2] : o2::soa::selfCombinations(binning, nEventsMix, -1, cols, cols)) {
+      onCollisions(collision1, collision2);
+      if (collision1.magField() != collision2.magField()) {
+        continue;
+      }
+      mixCollisions(collision1, collision2);
+    }
+  }
+
+  template <typename TBinning, typename TCollisions, typename TMix>
+  void mixEvents(TBinning const& binning, int nEventsMix, TCollisions const& cols, TMix&& mixCollisions)
+  {
+    mixEvents(binning, nEventsMix, cols, std::forward<TMix>(mixCollisions), [](auto const&, auto const&) {});
+  }
+
+ private:
+  TSameEventCont* mSameEventCont = nullptr;   ///< same-event correlation container
+  TMixedEventCont* mMixedEventCont = nullptr; ///< mixed-event correlation container
+  TPairCleaner* mPairCleaner = nullptr;       ///< pair cleaner
+  TCloseRejection* mCloseRejection = nullptr; ///< close pair rejection
+  bool mUseCPR = false;                       ///< whether the close pair rejection is applied
+  bool mCachePhiStar = false;                 ///< whether the phi* of the particles are computed once per event
+};
+
+} // namespace o2::analysis::femtoPair
+
+#endif // PWGCF_CORE_FEMTOPAIRENGINE_H_
@@ -13,6 +13,7 @@
 #define O2_ANALYSIS_PAIRCUTS_H
 
 #include <cmath>
+#include <vector>
 
 #include "Framework/Logger.h"
 #include "Framework/HistogramRegistry.h"
@@ -53,6 +54,12 @@ class PairCuts
     mTwoTrackDistance = distance;
     mTwoTrackRadius = radius;
 
+    // radii at which the minimum of dphistar is searched, accumulated as in the original scan
+    mTwoTrackRadii.clear();
+    for (double rad = mTwoTrackRadius; rad < 2.51; rad += 0.01) {
+      mTwoTrackRadii.push_back(rad);
+    }
+
     if (histogramRegistry != nullptr && histogramRegistry->contains(HIST("TwoTrackDistancePt_0")) == false) {
       histogramRegistry->add("TwoTrackDistancePt_0", "", {HistType::kTH3F, {{100, -0.15, 0.15, "#Delta#eta"}, {100, -0.05, 0.05, "#Delta#varphi^{*}_{min}"}, {20, 0, 10, "#Delta p_{T}"}}});
       histogramRegistry->addClone("TwoTrackDistancePt_0", "TwoTrackDistancePt_1");
@@ -62,27 +69,55 @@ class PairCuts
   template <typename T>
   bool conversionCuts(T const& track1, T const& track2);
 
+  /// Track quantities entering the two-track cut, which can be computed once per track
+  struct TwoTrackKinematics {
+    float eta = 0;
+    float phi = 0;
+    float pt = 0;
+    double curvature = 0; // charge * 0.015 * B / pT, the bending at radius r is asin(curvature * r)
+  };
+
   template <typename T>
-  bool twoTrackCut(T const& track1, T const& track2, int magField);
+  static TwoTrackKinematics getTwoTrackKinematics(T const& track, int magField)
+  {
+    return {track.eta(), track.phi(), track.pt(), track.sign() * 0.015 * magField / track.pt()};
+  }
+
+  template <typename T>
+  bool twoTrackCut(T const& track1, T const& track2, int magField)
+  {
+    return twoTrackCut(getTwoTrackKinematics(track1, magField), getTwoTrackKinematics(track2, magField));
+  }
+
+  bool twoTrackCut(TwoTrackKinematics const& track1, TwoTrackKinematics const& track2);
 
  protected:
+  /// Terms of the approximate invariant mass squared of a pair which do not depend on the mass hypotheses
+  struct PairMassTerms {
+    float p1Squared = 0; // squared momentum of the first track
+    float p2Squared = 0; // squared momentum of the second track
+    float pTimesCos = 0; // product of the momenta times the cosine of the opening angle
+  };
+
   float mCuts[ParticlesLastEntry] = {-1};
-  float mTwoTrackDistance = -1; // distance below which the pair is flagged as to be removed
-  float mTwoTrackRadius = 0.8f; // radius at which the two track cuts are applied
+  float mTwoTrackDistance = -1;      // distance below which the pair is flagged as to be removed
+  float mTwoTrackRadius = 0.8f;      // radius at which the two track cuts are applied
+  std::vector<float> mTwoTrackRadii; // radii of the search of the minimum dphistar
 
   HistogramRegistry* histogramRegistry = nullptr; // if set, control histograms are stored here
 
   template <typename T>
-  bool conversionCut(T const& track1, T const& track2, Particle conv, double cut);
+  bool conversionCut(T const& track1, T const& track2, PairMassTerms const& terms, Particle conv, double cut);
 
   template <typename T>
   double getInvMassSquared(T const& track1, double m0_1, T const& track2, double m0_2);
 
   template <typename T>
-  double getInvMassSquaredFast(T const& track1, double m0_1, T const& track2, double m0_2);
+  PairMassTerms getPairMassTermsFast(T const& track1, T const& track2);
 
-  template <typename T>
-  float getDPhiStar(T const& track1, T const& track2, float radius, int magField);
+  double getInvMassSquaredFast(PairMassTerms const& terms, double m0_1, double m0_2);
+
+  float getDPhiStar(TwoTrackKinematics const& track1, TwoTrackKinematics const& track2, float radius);
 };
 
 template <typename T>
@@ -93,14 +128,22 @@ bool PairCuts::conversionCuts(T const& track1, T const& track2)
     return false;
   }
 
+  // the kinematic terms of the approximate mass are computed once for all the hypotheses
+  bool termsComputed = false;
+  PairMassTerms terms;
+
   for (int i = 0; i < static_cast<int>(ParticlesLastEntry); i++) {
     Particle particle = static_cast<Particle>(i);
     if (mCuts[i] > 0) {
-      if (conversionCut(track1, track2, particle, mCuts[i])) {
+      if (!termsComputed) {
+        terms = getPairMassTermsFast(track1, track2);
+        termsComputed = true;
+      }
+      if (conversionCut(track1, track2, terms, particle, mCuts[i])) {
         return true;
       }
       if (particle == Lambda) {
-        if (conversionCut(track2, track1, particle, mCuts[i])) {
+        if (conversionCut(track2, track1, {terms.p2Squared, terms.p1Squared, terms.pTimesCos}, particle, mCuts[i])) {
           return true;
         }
       }
@@ -110,49 +153,88 @@ bool PairCuts::conversionCuts(T const& track1, T const& track2)
   return false;
 }
 
-template <typename T>
-bool PairCuts::twoTrackCut(T const& track1, T const& track2, int magField)
+inline bool PairCuts::twoTrackCut(TwoTrackKinematics const& track1, TwoTrackKinematics const& track2)
 {
   // the variables & cut have been developed in Run 1 by the CF - HBT group
-  //
-  // Parameters:
-  //   magField: B field in kG
 
-  auto deta = track1.eta() - track2.eta();
+  auto deta = track1.eta - track2.eta;
 
   // optimization
   if (std::fabs(deta) < mTwoTrackDistance * 2.5 * 3) {
     // check first boundaries to see if is worth to loop and find the minimum
-    float dphistar1 = getDPhiStar(track1, track2, mTwoTrackRadius, magField);
-    float dphistar2 = getDPhiStar(track1, track2, 2.5, magField);
+    float dphistar1 = getDPhiStar(track1, track2, mTwoTrackRadius);
+    float dphistar2 = getDPhiStar(track1, track2, 2.5);
 
     const float kLimit = mTwoTrackDistance * 3;
 
     if (std::fabs(dphistar1) < kLimit || std::fabs(dphistar2) < kLimit || dphistar1 * dphistar2 < 0) {
-      float dphistarminabs = 1e5;
+      // without histograms, a pair separated in eta is kept whatever dphistar
+      if (histogramRegistry == nullptr && std::fabs(deta) >= mTwoTrackDistance) {
+        return false;
+      }
+
+      // dphistar is a monotonic function of the radius, since d/dr asin(c r) = c / sqrt(1 - c^2 r^2) increases with c,
+      // and its folding onto -pi...pi keeps the sign, such that the minimum of |dphistar| over the radii is at the
+      // first or last radius, or next to the sign change, which is found by bisection instead of a scan of all radii
+      const int nRadii = mTwoTrackRadii.size();
+      float dphistarFirst = 0;
+      float dphistarLast = 0;
+      if (nRadii > 0) {
+        dphistarFirst = getDPhiStar(track1, track2, mTwoTrackRadii.front());
+        dphistarLast = getDPhiStar(track1, track2, mTwoTrackRadii.back());
+      }
       float dphistarmin = 1e5;
-      for (Double_t rad = mTwoTrackRadius; rad < 2.51; rad += 0.01) {
-        float dphistar = getDPhiStar(track1, track2, rad, magField);
+      float dphistarminabs = 1e5;
+
+      if (nRadii == 0 || std::isnan(dphistarFirst) || std::isnan(dphistarLast)) {
+        // no radii, or the curvature radius of a track is reached within the radii: scan them
+        for (int i = 0; i < nRadii; i++) {
+          float dphistar = getDPhiStar(track1, track2, mTwoTrackRadii[i]);
 
-        float dphistarabs = std::fabs(dphistar);
+          float dphistarabs = std::fabs(dphistar);
 
-        if (dphistarabs < dphistarminabs) {
-          dphistarmin = dphistar;
-          dphistarminabs = dphistarabs;
+          if (dphistarabs < dphistarminabs) {
+            dphistarmin = dphistar;
+            dphistarminabs = dphistarabs;
+          }
         }
+      } else {
+        int iLow = 0;
+        int iHigh = nRadii - 1;
+        float dphistarLow = dphistarFirst;
+        float dphistarHigh = dphistarLast;
+        if (dphistarFirst * dphistarLast < 0) {
+          while (iHigh - iLow > 1) {
+            int iMid = (iLow + iHigh) / 2;
+            float dphistarMid = getDPhiStar(track1, track2, mTwoTrackRadii[iMid]);
+            if (dphistarMid * dphistarFirst > 0) {
+              iLow = iMid;
+              dphistarLow = dphistarMid;
+            } else {
+              iHigh = iMid;
+              dphistarHigh = dphistarMid;
+            }
+          }
+        }
+        // the first radius is kept in case of equal distances, as in the scan
+        if (std::fabs(dphistarLow) <= std::fabs(dphistarHigh)) {
+          dphistarmin = dphistarLow;
+        } else {
+          dphistarmin = dphistarHigh;
+        }
+        dphistarminabs = std::fabs(dphistarmin);
       }
 
       if (histogramRegistry != nullptr) {
-        histogramRegistry->fill(HIST("TwoTrackDistancePt_0"), deta, dphistarmin, std::fabs(track1.pt() - track2.pt()));
+        histogramRegistry->fill(HIST("TwoTrackDistancePt_0"), deta, dphistarmin, std::fabs(track1.pt - track2.pt));
       }
 
       if (dphistarminabs < mTwoTrackDistance && std::fabs(deta) < mTwoTrackDistance) {
-        //LOGF(debug, "Removed track pair %ld %ld with %f %f %f %f %d %f %f %d %d", track1.index(), track2.index(), deta, dphistarminabs, track1.phi2(), track1.pt(), track1.sign(), track2.phi2(), track2.pt(), track2.sign(), magField);
         return true;
       }
 
       if (histogramRegistry != nullptr) {
-        histogramRegistry->fill(HIST("TwoTrackDistancePt_1"), deta, dphistarmin, std::fabs(track1.pt() - track2.pt()));
+        histogramRegistry->fill(HIST("TwoTrackDistancePt_1"), deta, dphistarmin, std::fabs(track1.pt - track2.pt));
       }
     }
   }
@@ -161,7 +243,7 @@ bool PairCuts::twoTrackCut(T const& track1, T const& track2, int magField)
 }
 
 template <typename T>
-bool PairCuts::conversionCut(T const& track1, T const& track2, Particle conv, double cut)
+bool PairCuts::conversionCut(T const& track1, T const& track2, PairMassTerms const& terms, Particle conv, double cut)
 {
   //LOGF(info, "pt is %f %f", track1.pt(), track2.pt());
 
@@ -203,7 +285,7 @@ bool PairCuts::conversionCut(T const& track1, T const& track2, Particle conv, do
       break;
   }
 
-  auto massC = getInvMassSquaredFast(track1, massD1, track2, massD2);
+  auto massC = getInvMassSquaredFast(terms, massD1, massD2);
 
   if (std::fabs(massC - massM * massM) > cut * 5) {
     return false;
@@ -257,9 +339,9 @@ double PairCuts::getInvMassSquared(T const& track1, double m0_1, T const& track2
 }
 
 template <typename T>
-double PairCuts::getInvMassSquaredFast(T const& track1, double m0_1, T const& track2, double m0_2)
+PairCuts::PairMassTerms PairCuts::getPairMassTermsFast(T const& track1, T const& track2)
 {
-  // calculate inv mass squared approximately
+  // calculate the terms of the approximate inv mass squared which do not depend on the masses
 
   const float eta1 = track1.eta();
   const float eta2 = track2.eta();
@@ -281,8 +363,9 @@ double PairCuts::getInvMassSquaredFast(T const& track1, double m0_1, T const& tr
     tantheta2 = 2.0f * expTmp / (1.0f - expTmp * expTmp);
   }
 
-  float e1squ = m0_1 * m0_1 + pt1 * pt1 * (1.0f + 1.0f / tantheta1 / tantheta1);
-  float e2squ = m0_2 * m0_2 + pt2 * pt2 * (1.0f + 1.0f / tantheta2 / tantheta2);
+  PairMassTerms terms;
+  terms.p1Squared = pt1 * pt1 * (1.0f + 1.0f / tantheta1 / tantheta1);
+  terms.p2Squared = pt2 * pt2 * (1.0f + 1.0f / tantheta2 / tantheta2);
 
   // fold onto 0...pi
   float deltaPhi = std::fabs(phi1 - phi2);
@@ -302,29 +385,32 @@ double PairCuts::getInvMassSquaredFast(T const& track1, double m0_1, T const& tr
     cosDeltaPhi = -1.0f + 1.0f / 2.0f * (deltaPhi - PI) * (deltaPhi - PI) - 1.0f / 24.0f * std::pow(deltaPhi - PI, 4.0f);
   }
 
-  double mass2 = m0_1 * m0_1 + m0_2 * m0_2 + 2.0f * (std::sqrt(e1squ * e2squ) - (pt1 * pt2 * (cosDeltaPhi + 1.0f / tantheta1 / tantheta2)));
+  terms.pTimesCos = pt1 * pt2 * (cosDeltaPhi + 1.0f / tantheta1 / tantheta2);
+
+  return terms;
+}
+
+inline double PairCuts::getInvMassSquaredFast(PairMassTerms const& terms, double m0_1, double m0_2)
+{
+  // calculate inv mass squared approximately
+
+  float e1squ = m0_1 * m0_1 + terms.p1Squared;
+  float e2squ = m0_2 * m0_2 + terms.p2Squared;
 
-  //LOGF(debug, "%f %f %f %f %f %f %f %f %f", pt1, eta1, phi1, pt2, eta2, phi2, m0_1, m0_2, mass2);
+  double mass2 = m0_1 * m0_1 + m0_2 * m0_2 + 2.0f * (std::sqrt(e1squ * e2squ) - terms.pTimesCos);
+
+  //LOGF(debug, "%f %f %f", m0_1, m0_2, mass2);
 
   return mass2;
 }
 
-template <typename T>
-float PairCuts::getDPhiStar(T const& track1, T const& track2, float radius, int magField)
+inline float PairCuts::getDPhiStar(TwoTrackKinematics const& track1, TwoTrackKinematics const& track2, float radius)
 {
   //
   // calculates dphistar
   //
 
-  auto phi1 = track1.phi();
-  auto pt1 = track1.pt();
-  auto charge1 = track1.sign();
-
-  auto phi2 = track2.phi();
-  auto pt2 = track2.pt();
-  auto charge2 = track2.sign();
-
-  float dphistar = phi1 - phi2 - charge1 * std::asin(0.015 * magField * radius / pt1) + charge2 * std::asin(0.015 * magField * radius / pt2);
+  float dphistar = track1.phi - track2.phi - std::asin(track1.curvature * radius) + std::asin(track2.curvature * radius);
 
   if (dphistar > PI) {
     dphistar = TwoPI - dphistar;
@@ -20,7 +20,9 @@
 #include "Framework/Expressions.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/PIDResponse.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace o2::aod
 {
@@ -137,6 +139,96 @@ DECLARE_SOA_TABLE(FemtoDreamParticles, "AOD", "FEMTODREAMPARTS",
                   femtodreamparticle::P<femtodreamparticle::Pt, femtodreamparticle::Eta>);
 using FemtoDreamParticle = FemtoDreamParticles::iterator;
 
+/// FemtoDreamParticlesPacked: reduced-precision variant of FemtoDreamParticles
+/// Kinematics and invariant masses are quantized to 16 bits, the PID container is compacted to 16 bits
+/// and the collision index is replaced by the number of particles per collision (FemtoDreamCollNParts)
+/// The femtodream-packed-converter unpacks it into FemtoDreamParticles for the pair tasks
+namespace femtodreampacked
+{
+/// Quantization of the float columns: value = binned_min + bin_width * binned, clamped to the range of binned_t
+struct binningPt {
+  typedef uint16_t binned_t;
+  static constexpr float binned_min = 0.f;
+  static constexpr float bin_width = 0.001f; // 1 MeV/c, up to 65.5 GeV/c
+};
+struct binningEta {
+  typedef uint16_t binned_t;
+  static constexpr float binned_min = -3.2768f;
+  static constexpr float bin_width = 0.0001f;
+};
+struct binningPhi {
+  typedef uint16_t binned_t;
+  static constexpr float binned_min = 0.f;
+  static constexpr float bin_width = static_cast<float>(2. * M_PI / 65535.);
+};
+struct binningMass {
+  typedef uint16_t binned_t;
+  static constexpr float binned_min = 0.f;
+  static constexpr float bin_width = 0.0001f; // 0.1 MeV/c^2, up to 6.5 GeV/c^2
+};
+using pidCutStoreType = uint16_t; //! Data type of the compacted PID container
+
+/// Quantized value of a float column
+template <typename binningType>
+typename binningType::binned_t pack(float value)
+{
+  constexpr float maxBin = static_cast<float>(std::numeric_limits<typename binningType::binned_t>::max());
+  const float bin = std::round((value - binningType::binned_min) / binningType::bin_width);
+  return static_cast<typename binningType::binned_t>(std::clamp(bin, 0.f, maxBin));
+}
+
+/// Float value of a quantized column
+template <typename binningType>
+float unpack(typename binningType::binned_t binned)
+{
+  return binningType::binned_min + binningType::bin_width * static_cast<float>(binned);
+}
+
+DECLARE_SOA_COLUMN(PtStore, ptStore, binningPt::binned_t);                     //! Quantized p_T
+DECLARE_SOA_COLUMN(EtaStore, etaStore, binningEta::binned_t);                  //! Quantized eta
+DECLARE_SOA_COLUMN(PhiStore, phiStore, binningPhi::binned_t);                  //! Quantized phi
+DECLARE_SOA_COLUMN(PIDCutStore, pidcutStore, pidCutStoreType);                 //! Compacted bit-wise container for the different PID selection criteria
+DECLARE_SOA_COLUMN(MLambdaStore, mLambdaStore, binningMass::binned_t);         //! Quantized invariant mass of V0 candidate, assuming lambda
+DECLARE_SOA_COLUMN(MAntiLambdaStore, mAntiLambdaStore, binningMass::binned_t); //! Quantized invariant mass of V0 candidate, assuming antilambda
+DECLARE_SOA_COLUMN(NParts, nParts, int);                                       //! Number of particles of the collision in FemtoDreamParticlesPacked
+
+DECLARE_SOA_DYNAMIC_COLUMN(Pt, pt, //! p_T (GeV/c)
+                           [](binningPt::binned_t binned) -> float { return unpack<binningPt>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(Eta, eta, //! Eta
+                           [](binningEta::binned_t binned) -> float { return unpack<binningEta>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(Phi, phi, //! Phi
+                           [](binningPhi::binned_t binned) -> float { return unpack<binningPhi>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(PIDCut, pidcut, //! Bit-wise container for the different PID selection criteria
+                           [](pidCutStoreType pidcut) -> femtodreamparticle::cutContainerType { return pidcut; });
+DECLARE_SOA_DYNAMIC_COLUMN(MLambda, mLambda, //! The invariant mass of V0 candidate, assuming lambda
+                           [](binningMass::binned_t binned) -> float { return unpack<binningMass>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(MAntiLambda, mAntiLambda, //! The invariant mass of V0 candidate, assuming antilambda
+                           [](binningMass::binned_t binned) -> float { return unpack<binningMass>(binned); });
+} // namespace femtodreampacked
+
+DECLARE_SOA_TABLE(FemtoDreamParticlesPacked, "AOD", "FEMTODREAMPACK",
+                  o2::soa::Index<>,
+                  femtodreampacked::PtStore,
+                  femtodreampacked::EtaStore,
+                  femtodreampacked::PhiStore,
+                  femtodreamparticle::PartType,
+                  femtodreamparticle::Cut,
+                  femtodreampacked::PIDCutStore,
+                  femtodreamparticle::TempFitVar,
+                  femtodreamparticle::Indices,
+                  femtodreampacked::MLambdaStore,
+                  femtodreampacked::MAntiLambdaStore,
+                  femtodreampacked::Pt<femtodreampacked::PtStore>,
+                  femtodreampacked::Eta<femtodreampacked::EtaStore>,
+                  femtodreampacked::Phi<femtodreampacked::PhiStore>,
+                  femtodreampacked::PIDCut<femtodreampacked::PIDCutStore>,
+                  femtodreampacked::MLambda<femtodreampacked::MLambdaStore>,
+                  femtodreampacked::MAntiLambda<femtodreampacked::MAntiLambdaStore>);
+using FemtoDreamParticlePacked = FemtoDreamParticlesPacked::iterator;
+
+DECLARE_SOA_TABLE(FemtoDreamCollNParts, "AOD", "FEMTODREAMCOLNP", //! Joinable with FemtoDreamCollisions
+                  femtodreampacked::NParts);
+
 DECLARE_SOA_TABLE(FemtoDreamDebugParticles, "AOD", "FEMTODEBUGPARTS",
                   femtodreamparticle::Sign,
                   femtodreamparticle::TPCNClsFound,
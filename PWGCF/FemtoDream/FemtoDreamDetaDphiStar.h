@@ -18,7 +18,10 @@
 
 #include "PWGCF/DataModel/FemtoDerived.h"
 #include "Framework/HistogramRegistry.h"
+#include <algorithm>
+#include <array>
 #include <string>
+#include <vector>
 
 namespace o2::analysis
 {
@@ -118,6 +121,58 @@ class FemtoDreamDetaDphiStar
     }
   }
 
+  /// Compute the phi* of the particles of one event at all the radii, once per particle, for isClosePairCached
+  /// \param parts particles of the event, sorted by index as the collision slices
+  /// \param lmagfield magnetic field in Tesla
+  /// \param slot 0 for the particles one and 1 for the particles two, which can belong to different events when mixing
+  template <typename Parts>
+  void cachePhiStar(Parts const& parts, float lmagfield, int slot)
+  {
+    magfield = lmagfield;
+    auto& cache = phiStarCache[slot];
+    cache.firstIndex = 0;
+    cache.phiStar.clear();
+    cache.isCached.clear();
+    if (parts.size() == 0) {
+      return;
+    }
+    int lastIndex = parts.begin().index();
+    cache.firstIndex = lastIndex;
+    for (auto const& part : parts) {
+      cache.firstIndex = std::min(cache.firstIndex, static_cast<int>(part.index()));
+      lastIndex = std::max(lastIndex, static_cast<int>(part.index()));
+    }
+    const int size = lastIndex - cache.firstIndex + 1;
+    cache.phiStar.resize(size);
+    cache.isCached.assign(size, false);
+    for (auto const& part : parts) {
+      const int i = part.index() - cache.firstIndex;
+      PhiAtRadiiTPC(part, cache.phiStar[i]);
+      cache.isCached[i] = true;
+    }
+  }
+
+  ///  Check if pair is close or not, with the phi* of the particles filled by cachePhiStar for the current event(s)
+  /// Only the Track-Track combination is supported, the particles not in the cache are computed on the fly
+  template <typename Part1, typename Part2>
+  bool isClosePairCached(Part1 const& part1, Part2 const& part2)
+  {
+    static_assert(mPartOneType == o2::aod::femtodreamparticle::ParticleType::kTrack && mPartTwoType == o2::aod::femtodreamparticle::ParticleType::kTrack,
+                  "FemtoDreamDetaDphiStar: the phi* cache is only available for the Track-Track combination");
+    std::array<float, NRadii> tmpPhiStar1, tmpPhiStar2;
+    const float* phiStar1 = cachedPhiStar(part1, 0, tmpPhiStar1);
+    const float* phiStar2 = cachedPhiStar(part2, 1, tmpPhiStar2);
+    auto deta = part1.eta() - part2.eta();
+    auto dphiAvg = AveragePhiStar(phiStar1, phiStar2, deta, 0);
+    histdetadpi[0][0]->Fill(deta, dphiAvg);
+    if (pow(dphiAvg, 2) / pow(deltaPhiMax, 2) + pow(deta, 2) / pow(deltaEtaMax, 2) < 1.) {
+      return true;
+    } else {
+      histdetadpi[0][1]->Fill(deta, dphiAvg);
+      return false;
+    }
+  }
+
  private:
   HistogramRegistry* mHistogramRegistry = nullptr;   ///< For main output
   HistogramRegistry* mHistogramRegistryQA = nullptr; ///< For QA output
@@ -135,7 +190,8 @@ class FemtoDreamDetaDphiStar
   static constexpr o2::aod::femtodreamparticle::ParticleType mPartOneType = partOne; ///< Type of particle 1
   static constexpr o2::aod::femtodreamparticle::ParticleType mPartTwoType = partTwo; ///< Type of particle 2
 
-  static constexpr float tmpRadiiTPC[9] = {85., 105., 125., 145., 165., 185., 205., 225., 245.};
+  static constexpr int NRadii = 9;
+  static constexpr float tmpRadiiTPC[NRadii] = {85., 105., 125., 145., 165., 185., 205., 225., 245.};
 
   static constexpr uint32_t kSignMinusMask = 1;
   static constexpr uint32_t kSignPlusMask = 1 << 1;
@@ -149,10 +205,18 @@ class FemtoDreamDetaDphiStar
   std::array<std::array<std::shared_ptr<TH2>, 2>, 2> histdetadpi{};
   std::array<std::array<std::shared_ptr<TH2>, 9>, 2> histdetadpiRadii{};
 
+  /// phi* of the particles of an event at all the radii, indexed by particle index - firstIndex
+  struct PhiStarCache {
+    int firstIndex = 0;
+    std::vector<std::array<float, NRadii>> phiStar;
+    std::vector<bool> isCached;
+  };
+  std::array<PhiStarCache, 2> phiStarCache{}; ///< for the particles one and two
+
   ///  Calculate phi at all required radii stored in tmpRadiiTPC
   /// Magnetic field to be provided in Tesla
   template <typename T>
-  void PhiAtRadiiTPC(const T& part, std::vector<float>& tmpVec)
+  void PhiAtRadiiTPC(const T& part, std::array<float, NRadii>& phiStar)
   {
 
     float phi0 = part.phi();
@@ -169,30 +233,51 @@ class FemtoDreamDetaDphiStar
     }
     // End: Get the charge from cutcontainer using masks
     float pt = part.pt();
-    for (size_t i = 0; i < 9; i++) {
-      tmpVec.push_back(phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
+    for (int i = 0; i < NRadii; i++) {
+      phiStar[i] = phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt));
+    }
+  }
+
+  /// phi* of a particle at all the radii, from the cache of the slot if present, computed in tmp otherwise
+  template <typename T>
+  const float* cachedPhiStar(const T& part, int slot, std::array<float, NRadii>& tmp)
+  {
+    auto const& cache = phiStarCache[slot];
+    const int i = part.index() - cache.firstIndex;
+    if (i >= 0 && i < static_cast<int>(cache.isCached.size()) && cache.isCached[i]) {
+      return cache.phiStar[i].data();
     }
+    PhiAtRadiiTPC(part, tmp);
+    return tmp.data();
   }
 
   ///  Calculate average phi
   template <typename T1, typename T2>
   float AveragePhiStar(const T1& part1, const T2& part2, int iHist)
   {
-    std::vector<float> tmpVec1;
-    std::vector<float> tmpVec2;
-    PhiAtRadiiTPC(part1, tmpVec1);
-    PhiAtRadiiTPC(part2, tmpVec2);
-    const int num = tmpVec1.size();
+    std::array<float, NRadii> phiStar1, phiStar2;
+    PhiAtRadiiTPC(part1, phiStar1);
+    PhiAtRadiiTPC(part2, phiStar2);
+    return AveragePhiStar(phiStar1.data(), phiStar2.data(), part1.eta() - part2.eta(), iHist);
+  }
+
+  ///  Calculate average phi from the phi* of both particles at all the radii
+  float AveragePhiStar(const float* phiStar1, const float* phiStar2, float deta, int iHist)
+  {
+    std::array<float, NRadii> dphi;
+    for (int i = 0; i < NRadii; i++) {
+      dphi[i] = TVector2::Phi_mpi_pi(phiStar1[i] - phiStar2[i]);
+    }
     float dPhiAvg = 0;
-    for (int i = 0; i < num; i++) {
-      float dphi = tmpVec1.at(i) - tmpVec2.at(i);
-      dphi = TVector2::Phi_mpi_pi(dphi);
-      dPhiAvg += dphi;
-      if (plotForEveryRadii) {
-        histdetadpiRadii[iHist][i]->Fill(part1.eta() - part2.eta(), dphi);
+    for (int i = 0; i < NRadii; i++) {
+      dPhiAvg += dphi[i];
+    }
+    if (plotForEveryRadii) {
+      for (int i = 0; i < NRadii; i++) {
+        histdetadpiRadii[iHist][i]->Fill(deta, dphi[i]);
       }
     }
-    return (dPhiAvg / (float)num);
+    return (dPhiAvg / (float)NRadii);
   }
 };
 
@@ -27,6 +27,7 @@
 #include "Framework/HistogramRegistry.h"
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 using namespace o2::framework;
 
@@ -143,6 +144,17 @@ class FemtoDreamTrackSelection : public FemtoDreamObjectSelection<float, femtoDr
   template <typename cutContainerType, typename T>
   std::array<cutContainerType, 2> getCutContainer(T const& track);
 
+  /// Batch version of isSelectedMinimal and getCutContainer, for the production without QA
+  /// The selection variables of all the tracks are first stored column-wise, then each selection of the cut table is evaluated over a whole column
+  /// 	param cutContainerType Data type of the bit-wise container for the selections
+  /// 	param T Data type of the tracks
+  /// \param tracks Tracks, e.g. those of a collision
+  /// \param isSelected Whether the most open combination of all selection criteria is fulfilled, for each track
+  /// \param cuts Bit-wise container for all selection criteria but the PID, for each track
+  /// \param pid Bit-wise container for the PID, for each track
+  template <typename cutContainerType, typename T>
+  void getCutContainers(T const& tracks, std::vector<uint8_t>& isSelected, std::vector<cutContainerType>& cuts, std::vector<cutContainerType>& pid);
+
   /// Some basic QA histograms
   /// \tparam part Type of the particle for proper naming of the folders for QA
   /// \tparam tracktype Type of track (track, positive child, negative child) for proper naming of the folders for QA
@@ -242,6 +254,14 @@ class FemtoDreamTrackSelection : public FemtoDreamObjectSelection<float, femtoDr
   float nSigmaPIDOffsetTOF;
   std::vector<o2::track::PID> mPIDspecies; ///< All the particle species for which the n_sigma values need to be stored
   static constexpr int kNtrackSelection = 14;
+
+  /// Sets the bit of a selection for all the entries of a column
+  template <typename cutContainerType>
+  static void setSelectionBits(FemtoDreamSelection<float, femtoDreamTrackSelection::TrackSel>& sel, std::vector<float> const& column, std::vector<cutContainerType>& cutContainers, size_t counter);
+
+  std::array<std::vector<float>, kNtrackSelection> mColumns; ///< Selection variables of the tracks of a batch, indexed by the selection
+  std::vector<std::vector<float>> mColumnsTPC;               ///< n_sigma_TPC - offset of the tracks of a batch, for each species
+  std::vector<std::vector<float>> mColumnsComb;              ///< Combined n_sigma of the tracks of a batch, for each species
   static constexpr std::string_view mSelectionNames[kNtrackSelection] = {"Sign",
                                                                          "PtMin",
                                                                          "PtMax",
@@ -543,6 +563,142 @@ std::array<cutContainerType, 2> FemtoDreamTrackSelection::getCutContainer(T cons
   return {output, outputPID};
 }
 
+template <typename cutContainerType>
+void FemtoDreamTrackSelection::setSelectionBits(FemtoDreamSelection<float, femtoDreamTrackSelection::TrackSel>& sel, std::vector<float> const& column, std::vector<cutContainerType>& cutContainers, size_t counter)
+{
+  /// same comparisons as FemtoDreamSelection::isSelected, with the type of the selection resolved once per column
+  const cutContainerType bit = 1UL << counter;
+  const float selVal = sel.getSelectionValue();
+  const size_t nEntries = column.size();
+  switch (sel.getSelectionType()) {
+    case (femtoDreamSelection::SelectionType::kUpperLimit):
+      for (size_t i = 0; i < nEntries; ++i) {
+        cutContainers[i] |= (column[i] < selVal) ? bit : 0;
+      }
+      break;
+    case (femtoDreamSelection::SelectionType::kAbsUpperLimit):
+      for (size_t i = 0; i < nEntries; ++i) {
+        cutContainers[i] |= (std::abs(column[i]) < selVal) ? bit : 0;
+      }
+      break;
+    case (femtoDreamSelection::SelectionType::kLowerLimit):
+      for (size_t i = 0; i < nEntries; ++i) {
+        cutContainers[i] |= (column[i] > selVal) ? bit : 0;
+      }
+      break;
+    case (femtoDreamSelection::SelectionType::kAbsLowerLimit):
+      for (size_t i = 0; i < nEntries; ++i) {
+        cutContainers[i] |= (std::abs(column[i]) > selVal) ? bit : 0;
+      }
+      break;
+    case (femtoDreamSelection::SelectionType::kEqual): {
+      const auto tolerance = std::abs(selVal * 1e-6);
+      for (size_t i = 0; i < nEntries; ++i) {
+        cutContainers[i] |= (std::abs(column[i] - selVal) < tolerance) ? bit : 0;
+      }
+      break;
+    }
+  }
+}
+
+template <typename cutContainerType, typename T>
+void FemtoDreamTrackSelection::getCutContainers(T const& tracks, std::vector<uint8_t>& isSelected, std::vector<cutContainerType>& cuts, std::vector<cutContainerType>& pid)
+{
+  const size_t nTracks = tracks.size();
+  const size_t nSpecies = mPIDspecies.size();
+  for (auto& column : mColumns) {
+    column.resize(nTracks);
+  }
+  mColumnsTPC.resize(nSpecies);
+  mColumnsComb.resize(nSpecies);
+  for (size_t iSpecies = 0; iSpecies < nSpecies; ++iSpecies) {
+    mColumnsTPC[iSpecies].resize(nTracks);
+    mColumnsComb[iSpecies].resize(nTracks);
+  }
+
+  /// the selection variables are read once per track, the same way as in getCutContainer
+  size_t iTrack = 0;
+  for (auto& track : tracks) {
+    const auto pT = track.pt();
+    const auto dcaXY = track.dcaXY();
+    const auto dcaZ = track.dcaZ();
+    mColumns[femtoDreamTrackSelection::kSign][iTrack] = track.sign();
+    mColumns[femtoDreamTrackSelection::kpTMin][iTrack] = pT;
+    mColumns[femtoDreamTrackSelection::kpTMax][iTrack] = pT;
+    mColumns[femtoDreamTrackSelection::kEtaMax][iTrack] = track.eta();
+    mColumns[femtoDreamTrackSelection::kTPCnClsMin][iTrack] = track.tpcNClsFound();
+    mColumns[femtoDreamTrackSelection::kTPCfClsMin][iTrack] = track.tpcCrossedRowsOverFindableCls();
+    mColumns[femtoDreamTrackSelection::kTPCcRowsMin][iTrack] = track.tpcNClsCrossedRows();
+    mColumns[femtoDreamTrackSelection::kTPCsClsMax][iTrack] = track.tpcNClsShared();
+    mColumns[femtoDreamTrackSelection::kITSnClsMin][iTrack] = track.itsNCls();
+    mColumns[femtoDreamTrackSelection::kITSnClsIbMin][iTrack] = track.itsNClsInnerBarrel();
+    mColumns[femtoDreamTrackSelection::kDCAxyMax][iTrack] = dcaXY;
+    mColumns[femtoDreamTrackSelection::kDCAzMax][iTrack] = dcaZ;
+    mColumns[femtoDreamTrackSelection::kDCAMin][iTrack] = std::sqrt(pow(dcaXY, 2.) + pow(dcaZ, 2.));
+    for (size_t iSpecies = 0; iSpecies < nSpecies; ++iSpecies) {
+      const float pidTPCVal = getNsigmaTPC(track, mPIDspecies[iSpecies]) - nSigmaPIDOffsetTPC;
+      const float pidTOFVal = getNsigmaTOF(track, mPIDspecies[iSpecies]) - nSigmaPIDOffsetTOF;
+      mColumnsTPC[iSpecies][iTrack] = pidTPCVal;
+      mColumnsComb[iSpecies][iTrack] = std::sqrt(pidTPCVal * pidTPCVal + pidTOFVal * pidTOFVal);
+    }
+    ++iTrack;
+  }
+
+  /// most open selection, see isSelectedMinimal
+  isSelected.assign(nTracks, 1);
+  auto applyMinimal = [&](int nSel, femtoDreamTrackSelection::TrackSel iSel, auto&& isRejected) {
+    if (nSel == 0) {
+      return;
+    }
+    const auto& column = mColumns[iSel];
+    for (size_t i = 0; i < nTracks; ++i) {
+      isSelected[i] &= !isRejected(column[i]);
+    }
+  };
+  applyMinimal(nPtMinSel, femtoDreamTrackSelection::kpTMin, [this](float pT) { return pT < pTMin; });
+  applyMinimal(nPtMaxSel, femtoDreamTrackSelection::kpTMax, [this](float pT) { return pT > pTMax; });
+  applyMinimal(nEtaSel, femtoDreamTrackSelection::kEtaMax, [this](float eta) { return std::abs(eta) > etaMax; });
+  applyMinimal(nTPCnMinSel, femtoDreamTrackSelection::kTPCnClsMin, [this](float tpcNClsF) { return tpcNClsF < nClsMin; });
+  applyMinimal(nTPCfMinSel, femtoDreamTrackSelection::kTPCfClsMin, [this](float tpcRClsC) { return tpcRClsC < fClsMin; });
+  applyMinimal(nTPCcMinSel, femtoDreamTrackSelection::kTPCcRowsMin, [this](float tpcNClsC) { return tpcNClsC < cTPCMin; });
+  applyMinimal(nTPCsMaxSel, femtoDreamTrackSelection::kTPCsClsMax, [this](float tpcNClsS) { return tpcNClsS > sTPCMax; });
+  applyMinimal(nITScMinSel, femtoDreamTrackSelection::kITSnClsMin, [this](float itsNCls) { return itsNCls < nITSclsMin; });
+  applyMinimal(nITScIbMinSel, femtoDreamTrackSelection::kITSnClsIbMin, [this](float itsNClsIB) { return itsNClsIB < nITSclsIbMin; });
+  applyMinimal(nDCAxyMaxSel, femtoDreamTrackSelection::kDCAxyMax, [this](float dcaXY) { return std::abs(dcaXY) > dcaXYMax; });
+  applyMinimal(nDCAzMaxSel, femtoDreamTrackSelection::kDCAzMax, [this](float dcaZ) { return std::abs(dcaZ) > dcaZMax; });
+  // only dcaXY enters the minimal selection, as in isSelectedMinimal
+  applyMinimal(nDCAMinSel, femtoDreamTrackSelection::kDCAxyMax, [this](float dcaXY) { return std::abs(dcaXY) < dcaMin; });
+  applyMinimal(nRejectNotPropagatedTracks, femtoDreamTrackSelection::kDCAxyMax, [](float dcaXY) { return std::abs(dcaXY) > 1e3; });
+  if (nPIDnSigmaSel > 0) {
+    std::vector<uint8_t> isPIDFulfilled(nTracks, 0);
+    for (const auto& column : mColumnsTPC) {
+      for (size_t i = 0; i < nTracks; ++i) {
+        isPIDFulfilled[i] |= std::abs(column[i]) < nSigmaPIDMax;
+      }
+    }
+    for (size_t i = 0; i < nTracks; ++i) {
+      isSelected[i] &= isPIDFulfilled[i];
+    }
+  }
+
+  /// the cut table, in the order of the bits of getCutContainer
+  cuts.assign(nTracks, 0);
+  pid.assign(nTracks, 0);
+  size_t counter = 0;
+  size_t counterPID = 0;
+  for (auto& sel : mSelections) {
+    const auto selVariable = sel.getSelectionVariable();
+    if (selVariable == femtoDreamTrackSelection::kPIDnSigmaMax) {
+      for (size_t iSpecies = 0; iSpecies < nSpecies; ++iSpecies) {
+        setSelectionBits(sel, mColumnsTPC[iSpecies], pid, counterPID++);
+        setSelectionBits(sel, mColumnsComb[iSpecies], pid, counterPID++);
+      }
+    } else {
+      setSelectionBits(sel, mColumns[selVariable], cuts, counter++);
+    }
+  }
+}
+
 template <o2::aod::femtodreamparticle::ParticleType part, o2::aod::femtodreamparticle::TrackType tracktype, typename T>
 void FemtoDreamTrackSelection::fillQA(T const& track)
 {
@@ -0,0 +1,48 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file femtoDreamPackedConverter.cxx
+/// \brief Task that unpacks the reduced-precision FemtoDreamParticlesPacked into FemtoDreamParticles,
+/// so that the pair tasks run unchanged on both formats of the derived data
+
+#include "PWGCF/DataModel/FemtoDerived.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/runDataProcessing.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct femtoDreamPackedConverter {
+
+  Produces<aod::FemtoDreamParticles> outputParts;
+
+  void process(soa::Join<aod::FemtoDreamCollisions, aod::FemtoDreamCollNParts> const& cols, aod::FemtoDreamParticlesPacked const& parts)
+  {
+    /// the particles are stored collision after collision, the collision index is recovered from the number of particles per collision
+    outputParts.reserve(parts.size());
+    auto part = parts.begin();
+    for (auto const& col : cols) {
+      for (int iPart = 0; iPart < col.nParts(); ++iPart, ++part) {
+        if (part == parts.end()) {
+          LOGF(fatal, "FemtoDreamCollNParts does not match FemtoDreamParticlesPacked - quitting!");
+        }
+        int indices[2] = {part.indices()[0], part.indices()[1]};
+        outputParts(col.globalIndex(), part.pt(), part.eta(), part.phi(), part.partType(), part.cut(), part.pidcut(), part.tempFitVar(), indices, part.mLambda(), part.mAntiLambda());
+      }
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  WorkflowSpec workflow{adaptAnalysisTask<femtoDreamPackedConverter>(cfgc)};
+  return workflow;
+}
@@ -27,6 +27,13 @@
 #include "FemtoDreamContainer.h"
 #include "FemtoDreamDetaDphiStar.h"
 #include "FemtoUtils.h"
+#include "PWGCF/Core/FemtoPairEngine.h"
+#include "Common/Core/EventMixingPool.h"
+#include "TDatabasePDG.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace o2;
 using namespace o2::analysis::femtoDream;
@@ -98,18 +105,53 @@ struct femtoDreamPairTaskTrackTrack {
   ConfigurableAxis CfgkTBins{"CfgkTBins", {150, 0., 9.}, "binning kT"};
   ConfigurableAxis CfgmTBins{"CfgmTBins", {225, 0., 7.5}, "binning mT"};
   Configurable<int> ConfNEventsMix{"ConfNEventsMix", 5, "Number of events for mixing"};
+  Configurable<float> ConfMixingPoolMaxMemory{"ConfMixingPoolMaxMemory", 512.f, "Mixing pools: maximum memory in MB, the oldest events are dropped first (0 = no limit)"};
   Configurable<bool> ConfIsCPR{"ConfIsCPR", true, "Close Pair Rejection"};
   Configurable<bool> ConfCPRPlotPerRadii{"ConfCPRPlotPerRadii", false, "Plot CPR per radii"};
+  Configurable<float> ConfKstarMaxPairSearch{"ConfKstarMaxPairSearch", -1.f, "Pair search: only build the pairs with k* below this value (GeV/c), by searching the particles sorted in rapidity. <= 0: all the pairs, needed for the full range QA"};
+  Configurable<bool> ConfCPRCachePhiStar{"ConfCPRCachePhiStar", true, "Close Pair Rejection: compute the phi* of each particle once per event instead of once per pair"};
 
   FemtoDreamContainer<femtoDreamContainer::EventType::same, femtoDreamContainer::Observable::kstar> sameEventCont;
   FemtoDreamContainer<femtoDreamContainer::EventType::mixed, femtoDreamContainer::Observable::kstar> mixedEventCont;
   FemtoDreamPairCleaner<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kTrack> pairCleaner;
   FemtoDreamDetaDphiStar<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::ParticleType::kTrack> pairCloseRejection;
+  o2::analysis::femtoPair::FemtoPairEngine<decltype(sameEventCont), decltype(mixedEventCont), decltype(pairCleaner), decltype(pairCloseRejection), true> pairEngine;
   /// Histogram output
   HistogramRegistry qaRegistry{"TrackQA", {}, OutputObjHandlingPolicy::AnalysisObject};
   HistogramRegistry resultRegistry{"Correlations", {}, OutputObjHandlingPolicy::AnalysisObject};
   HistogramRegistry MixQaRegistry{"MixQaRegistry", {}, OutputObjHandlingPolicy::AnalysisObject};
 
+  /// Mixing pools: compacted particle with the quantities needed by the pair kernels
+  struct MixingParticle {
+    float mPt, mEta, mPhi;
+    aod::femtodreamparticle::cutContainerType mCut;
+    uint8_t mPartType;
+    float pt() const { return mPt; }
+    float eta() const { return mEta; }
+    float phi() const { return mPhi; }
+    aod::femtodreamparticle::cutContainerType cut() const { return mCut; }
+    uint8_t partType() const { return mPartType; }
+  };
+  struct MixingEventInfo {
+    float multV0M;
+    float magField;
+  };
+  eventmixing::MixingPool<MixingEventInfo, MixingParticle> mixingPool; /// particles one of the past events of each bin
+
+  /// Pair search in a k* window: the k* of a pair grows with the relative rapidity xi of its two particles,
+  /// cosh(xi) = (E1 E2 - p1.p2) / (m1 m2), which is at least the difference of their rapidities along the beam.
+  /// Sorting the particles two in rapidity hence bounds the candidates of each particle one, and the pairs
+  /// beyond the k* window are rejected from cosh(xi) before any boost
+  template <typename TIterator>
+  struct PairSearchParticle {
+    TIterator part;
+    int position; /// position in the collision slice, for the strictly upper index combinations
+    float y, px, py, pz, e;
+  };
+  float massOne = 0.f, massTwo = 0.f;
+  float maxRapidityPairSearch = 0.f;
+  float maxCoshXiPairSearch = 0.f;
+
   void init(InitContext&)
   {
     eventHisto.init(&qaRegistry);
@@ -129,13 +171,98 @@ struct femtoDreamPairTaskTrackTrack {
     if (ConfIsCPR) {
       pairCloseRejection.init(&resultRegistry, &qaRegistry, 0.01, 0.01, ConfCPRPlotPerRadii); /// \todo add config for Δη and ΔΦ cut values
     }
+    pairEngine.init(&sameEventCont, &mixedEventCont, &pairCleaner, &pairCloseRejection, ConfIsCPR, ConfCPRCachePhiStar);
 
     vPIDPartOne = ConfPIDPartOne;
     vPIDPartTwo = ConfPIDPartTwo;
+
+    massOne = TDatabasePDG::Instance()->GetParticle(ConfPDGCodePartOne)->Mass();
+    massTwo = TDatabasePDG::Instance()->GetParticle(ConfPDGCodePartTwo)->Mass();
+    if (ConfKstarMaxPairSearch > 0.f) {
+      /// invert k* = m1 m2 sinh(xi) / M, with M^2 = m1^2 + m2^2 + 2 m1 m2 cosh(xi), with a margin for the rounding
+      const double k2 = ConfKstarMaxPairSearch * ConfKstarMaxPairSearch;
+      const double m1m2 = massOne * massTwo;
+      const double coshXi = (k2 + std::sqrt(k2 * k2 + k2 * (massOne * massOne + massTwo * massTwo) + m1m2 * m1m2)) / m1m2;
+      maxCoshXiPairSearch = coshXi * 1.001;
+      maxRapidityPairSearch = std::acosh(coshXi) + 0.001;
+      LOGF(info, "Pair search in the k* window below %f GeV/c: maximum relative rapidity %f", ConfKstarMaxPairSearch.value, maxRapidityPairSearch);
+    }
+
+    if (doprocessMixedEventPool) {
+      const int nBins = (CfgVtxBins.value.size() + 1) * (CfgMultBins.value.size() + 1);
+      mixingPool.setup(nBins, ConfNEventsMix, static_cast<std::size_t>(ConfMixingPoolMaxMemory * 1024.f * 1024.f));
+    }
+  }
+
+  /// Selection of the particles for the pairing
+  /// \param part particle
+  /// \param partName name of the particle in the cut table
+  /// \param vPID PID selection of the particle
+  template <typename T>
+  bool isSelectedForPairing(T const& part, const char* partName, std::vector<int> const& vPID)
+  {
+    if (part.p() > cfgCutTable->get(partName, "MaxP") || part.pt() > cfgCutTable->get(partName, "MaxPt")) {
+      return false;
+    }
+    return isFullPIDSelected(part.pidcut(), part.p(), cfgCutTable->get(partName, "PIDthr"), vPID, cfgNspecies, kNsigma, cfgCutTable->get(partName, "nSigmaTPC"), cfgCutTable->get(partName, "nSigmaTPCTOF"));
+  }
+
+  /// Selected particles of a collision for the pair search in a k* window, sorted in rapidity
+  /// \param parts particles of the collision
+  /// \param mass mass of the particles
+  /// \param partName name of the particle in the cut table
+  /// \param vPID PID selection of the particle
+  template <typename T>
+  auto getPairSearchParticles(T const& parts, float mass, const char* partName, std::vector<int> const& vPID)
+  {
+    std::vector<PairSearchParticle<std::decay_t<decltype(parts.begin())>>> particles;
+    particles.reserve(parts.size());
+    int position = 0;
+    for (auto& part : parts) {
+      if (isSelectedForPairing(part, partName, vPID)) {
+        const float px = part.pt() * std::cos(part.phi());
+        const float py = part.pt() * std::sin(part.phi());
+        const float pz = part.pt() * std::sinh(part.eta());
+        const float e = std::sqrt(part.pt() * part.pt() + pz * pz + mass * mass);
+        particles.push_back({part, position, 0.5f * std::log((e + pz) / (e - pz)), px, py, pz, e});
+      }
+      position++;
+    }
+    std::sort(particles.begin(), particles.end(), [](auto const& a, auto const& b) { return a.y < b.y; });
+    return particles;
+  }
+
+  /// Calls pairFunction for the pairs of the k* window
+  /// \param strictlyUpper whether only the pairs with the particle two after the particle one in the slices are built
+  template <typename TParticlesOne, typename TParticlesTwo, typename TFunction>
+  void forEachPairInKstarWindow(TParticlesOne const& particlesOne, TParticlesTwo const& particlesTwo, bool strictlyUpper, TFunction&& pairFunction)
+  {
+    const float m1m2 = massOne * massTwo;
+    for (auto const& p1 : particlesOne) {
+      auto p2 = std::lower_bound(particlesTwo.begin(), particlesTwo.end(), p1.y - maxRapidityPairSearch, [](auto const& p, float y) { return p.y < y; });
+      for (; p2 != particlesTwo.end() && p2->y < p1.y + maxRapidityPairSearch; ++p2) {
+        if (strictlyUpper && p2->position <= p1.position) {
+          continue;
+        }
+        if (p1.e * p2->e - p1.px * p2->px - p1.py * p2->py - p1.pz * p2->pz > maxCoshXiPairSearch * m1m2) {
+          continue;
+        }
+        pairFunction(p1.part, p2->part);
+      }
+    }
+  }
+
+  /// Selections of the particles one and two for the pairing
+  auto isSelectedPartOne()
+  {
+    return [this](auto const& part) { return isSelectedForPairing(part, "PartOne", vPIDPartOne); };
+  }
+  auto isSelectedPartTwo()
+  {
+    return [this](auto const& part) { return isSelectedForPairing(part, "PartTwo", vPIDPartTwo); };
   }
 
   /// This function processes the same event and takes care of all the histogramming
-  /// \todo the trivial loops over the tracks should be factored out since they will be common to all combinations of T-T, T-V0, V0-V0, ...
   void processSameEvent(o2::aod::FemtoDreamCollision& col,
                         o2::aod::FemtoDreamParticles& parts)
   {
@@ -170,72 +297,93 @@ struct femtoDreamPairTaskTrackTrack {
       }
     }
     /// Now build the combinations
-    for (auto& [p1, p2] : combinations(groupPartsOne, groupPartsTwo)) {
-      if (p1.p() > cfgCutTable->get("PartOne", "MaxP") || p1.pt() > cfgCutTable->get("PartOne", "MaxPt") || p2.p() > cfgCutTable->get("PartTwo", "MaxP") || p2.pt() > cfgCutTable->get("PartTwo", "MaxPt")) {
-        continue;
-      }
-      if (!isFullPIDSelected(p1.pidcut(), p1.p(), cfgCutTable->get("PartOne", "PIDthr"), vPIDPartOne, cfgNspecies, kNsigma, cfgCutTable->get("PartOne", "nSigmaTPC"), cfgCutTable->get("PartOne", "nSigmaTPCTOF")) || !isFullPIDSelected(p2.pidcut(), p2.p(), cfgCutTable->get("PartTwo", "PIDthr"), vPIDPartTwo, cfgNspecies, kNsigma, cfgCutTable->get("PartTwo", "nSigmaTPC"), cfgCutTable->get("PartTwo", "nSigmaTPCTOF"))) {
-        continue;
-      }
-
-      if (ConfIsCPR) {
-        if (pairCloseRejection.isClosePair(p1, p2, parts, magFieldTesla)) {
-          continue;
-        }
-      }
-
-      // track cleaning
-      if (!pairCleaner.isCleanPair(p1, p2, parts)) {
-        continue;
-      }
-      sameEventCont.setPair(p1, p2, multCol);
+    if (ConfKstarMaxPairSearch > 0.f) {
+      pairEngine.cachePhiStar(groupPartsOne, groupPartsTwo, magFieldTesla);
+      forEachPairInKstarWindow(getPairSearchParticles(groupPartsOne, massOne, "PartOne", vPIDPartOne), getPairSearchParticles(groupPartsTwo, massTwo, "PartTwo", vPIDPartTwo), true, [&](auto const& p1, auto const& p2) {
+        pairEngine.fillSameEventPair(p1, p2, parts, magFieldTesla, multCol);
+      });
+      return;
     }
+    pairEngine.processSameEvent(groupPartsOne, groupPartsTwo, parts, magFieldTesla, multCol, isSelectedPartOne(), isSelectedPartTwo());
   }
 
   PROCESS_SWITCH(femtoDreamPairTaskTrackTrack, processSameEvent, "Enable processing same event", true);
 
   /// This function processes the mixed event
-  /// \todo the trivial loops over the collisions and tracks should be factored out since they will be common to all combinations of T-T, T-V0, V0-V0, ...
   void processMixedEvent(o2::aod::FemtoDreamCollisions& cols,
                          o2::aod::FemtoDreamParticles& parts)
   {
-
-    for (auto& [collision1, collision2] : soa::selfCombinations(colBinning, 5, -1, cols, cols)) {
-
-      MixQaRegistry.fill(HIST("MixingQA/hMECollisionBins"), colBinning.getBin({collision1.posZ(), collision1.multV0M()}));
-
+    auto mixCollisions = [&](auto const& collision1, auto const& collision2) {
       auto groupPartsOne = partsOne->sliceByCached(aod::femtodreamparticle::femtoDreamCollisionId, collision1.globalIndex());
       auto groupPartsTwo = partsTwo->sliceByCached(aod::femtodreamparticle::femtoDreamCollisionId, collision2.globalIndex());
+      const float magFieldTesla = collision1.magField();
+      const int multCol = collision1.multV0M();
+
+      if (ConfKstarMaxPairSearch > 0.f) {
+        pairEngine.cachePhiStar(groupPartsOne, groupPartsTwo, magFieldTesla);
+        forEachPairInKstarWindow(getPairSearchParticles(groupPartsOne, massOne, "PartOne", vPIDPartOne), getPairSearchParticles(groupPartsTwo, massTwo, "PartTwo", vPIDPartTwo), false, [&](auto const& p1, auto const& p2) {
+          pairEngine.fillMixedEventPair(p1, p2, parts, magFieldTesla, multCol);
+        });
+        return;
+      }
+      pairEngine.processMixedEvent(groupPartsOne, groupPartsTwo, parts, magFieldTesla, multCol, isSelectedPartOne(), isSelectedPartTwo());
+    };
+    pairEngine.mixEvents(colBinning, ConfNEventsMix, cols, mixCollisions, [&](auto const& collision1, auto const&) {
+      MixQaRegistry.fill(HIST("MixingQA/hMECollisionBins"), colBinning.getBin({collision1.posZ(), collision1.multV0M()}));
+    });
+  }
 
-      const auto& magFieldTesla1 = collision1.magField();
-      const auto& magFieldTesla2 = collision2.magField();
+  PROCESS_SWITCH(femtoDreamPairTaskTrackTrack, processMixedEvent, "Enable processing mixed events", true);
 
-      if (magFieldTesla1 != magFieldTesla2) {
-        continue;
-      }
+  /// This function processes the mixed event with the mixing pools: the selected particles one are compacted and kept
+  /// in per-bin ring buffers across dataframes, instead of re-iterating the collision table
+  void processMixedEventPool(o2::aod::FemtoDreamCollision& col,
+                             o2::aod::FemtoDreamParticles& parts)
+  {
+    const int bin = colBinning.getBin({col.posZ(), col.multV0M()});
+    if (bin < 0) {
+      return;
+    }
+    const float magFieldTesla = col.magField();
 
-      /// \todo before mixing we should check whether both collisions contain a pair of particles!
-      // if (partsOne.size() == 0 || nPart2Evt1 == 0 || nPart1Evt2 == 0 || partsTwo.size() == 0 ) continue;
+    auto groupPartsOne = partsOne->sliceByCached(aod::femtodreamparticle::femtoDreamCollisionId, col.globalIndex());
+    auto groupPartsTwo = partsTwo->sliceByCached(aod::femtodreamparticle::femtoDreamCollisionId, col.globalIndex());
 
-      for (auto& [p1, p2] : combinations(CombinationsFullIndexPolicy(groupPartsOne, groupPartsTwo))) {
-        if (p1.p() > cfgCutTable->get("PartOne", "MaxP") || p1.pt() > cfgCutTable->get("PartOne", "MaxPt") || p2.p() > cfgCutTable->get("PartTwo", "MaxP") || p2.pt() > cfgCutTable->get("PartTwo", "MaxPt")) {
-          continue;
-        }
-        if (!isFullPIDSelected(p1.pidcut(), p1.p(), cfgCutTable->get("PartOne", "PIDthr"), vPIDPartOne, cfgNspecies, kNsigma, cfgCutTable->get("PartOne", "nSigmaTPC"), cfgCutTable->get("PartOne", "nSigmaTPCTOF")) || !isFullPIDSelected(p2.pidcut(), p2.p(), cfgCutTable->get("PartTwo", "PIDthr"), vPIDPartTwo, cfgNspecies, kNsigma, cfgCutTable->get("PartTwo", "nSigmaTPC"), cfgCutTable->get("PartTwo", "nSigmaTPCTOF"))) {
-          continue;
-        }
+    std::vector<MixingParticle> particlesOne, particlesTwo;
+    particlesOne.reserve(groupPartsOne.size());
+    particlesTwo.reserve(groupPartsTwo.size());
+    for (auto& part : groupPartsOne) {
+      if (isSelectedForPairing(part, "PartOne", vPIDPartOne)) {
+        particlesOne.push_back({part.pt(), part.eta(), part.phi(), part.cut(), part.partType()});
+      }
+    }
+    for (auto& part : groupPartsTwo) {
+      if (isSelectedForPairing(part, "PartTwo", vPIDPartTwo)) {
+        particlesTwo.push_back({part.pt(), part.eta(), part.phi(), part.cut(), part.partType()});
+      }
+    }
 
-        if (ConfIsCPR) {
-          if (pairCloseRejection.isClosePair(p1, p2, parts, magFieldTesla1)) {
-            continue;
+    /// pairs of the particles one of the past events with the particles two of this event
+    mixingPool.mix(bin, [&](auto const& event) {
+      MixQaRegistry.fill(HIST("MixingQA/hMECollisionBins"), bin);
+      if (event.info.magField != magFieldTesla) {
+        return;
+      }
+      for (auto const& p1 : event.particles) {
+        for (auto const& p2 : particlesTwo) {
+          if (ConfIsCPR) {
+            if (pairCloseRejection.isClosePair(p1, p2, parts, event.info.magField)) {
+              continue;
+            }
           }
+          mixedEventCont.setPair(p1, p2, event.info.multV0M);
         }
-        mixedEventCont.setPair(p1, p2, collision1.multV0M());
       }
-    }
+    });
+    mixingPool.push(bin, {col.multV0M(), magFieldTesla}, std::move(particlesOne));
   }
 
-  PROCESS_SWITCH(femtoDreamPairTaskTrackTrack, processMixedEvent, "Enable processing mixed events", true);
+  PROCESS_SWITCH(femtoDreamPairTaskTrackTrack, processMixedEventPool, "Enable processing mixed events with the mixing pools", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
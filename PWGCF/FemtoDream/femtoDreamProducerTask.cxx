@@ -14,6 +14,7 @@
 /// \author Laura Serksnyte, TU München, laura.serksnyte@tum.de
 
 #include <CCDB/BasicCCDBManager.h>
+#include <algorithm>
 #include <cstdint>
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/AnalysisTask.h"
@@ -84,11 +85,18 @@ struct femtoDreamProducerTask {
 
   Produces<aod::FemtoDreamCollisions> outputCollision;
   Produces<aod::FemtoDreamParticles> outputParts;
+  Produces<aod::FemtoDreamParticlesPacked> outputPartsPacked;
+  Produces<aod::FemtoDreamCollNParts> outputCollNParts;
   Produces<aod::FemtoDreamParticlesMC> outputPartsMC;
   Produces<aod::FemtoDreamDebugParticles> outputDebugParts;
   Produces<aod::FemtoDreamDebugParticlesMC> outputDebugPartsMC;
 
   Configurable<bool> ConfDebugOutput{"ConfDebugOutput", true, "Debug output"};
+  Configurable<bool> ConfPackedOutput{"ConfPackedOutput", false, "Store the particles in the reduced-precision FemtoDreamParticlesPacked instead of FemtoDreamParticles"};
+
+  // Production mode: track selections evaluated for all the tracks of a collision at once, QA histograms for a fraction of the collisions only
+  Configurable<bool> ConfTrkBatchSelection{"ConfTrkBatchSelection", false, "Evaluate the track selections column-wise for all the tracks of a collision, without the per-track QA"};
+  Configurable<float> ConfQAFraction{"ConfQAFraction", 1.f, "Fraction of the selected collisions for which the track and V0 QA histograms are filled"};
 
   // Choose if filtering or skimming version is run
 
@@ -167,6 +175,11 @@ struct femtoDreamProducerTask {
 
   int mRunNumber;
   float mMagField;
+  float mQASampling = 0.f; ///< accumulated ConfQAFraction, the QA is filled whenever it reaches one
+  int mNPartsCollision = 0; ///< number of particles of the current collision in FemtoDreamParticlesPacked
+  std::vector<uint8_t> mTrkIsSelected;
+  std::vector<aod::femtodreamparticle::cutContainerType> mTrkCuts;
+  std::vector<aod::femtodreamparticle::cutContainerType> mTrkPID;
   Service<o2::ccdb::BasicCCDBManager> ccdb; /// Accessing the CCDB
 
   void init(InitContext&)
@@ -237,6 +250,15 @@ struct femtoDreamProducerTask {
       }
     }
 
+    if (ConfPackedOutput) {
+      /// every selection of ConfTrkPIDnSigmaMax sets a TPC and a combined bit for each species
+      const size_t nPIDBitsTrack = 2 * ConfTrkTPIDspecies->size() * ConfTrkPIDnSigmaMax->size();
+      const size_t nPIDBitsV0Child = 2 * ConfV0DaughTPIDspecies->size() * ConfV0DaughPIDnSigmaMax->size();
+      if (std::max(nPIDBitsTrack, nPIDBitsV0Child) > 8 * sizeof(aod::femtodreampacked::pidCutStoreType)) {
+        LOGF(fatal, "Number of PID selections too large for the packed PID container - quitting!");
+      }
+    }
+
     mRunNumber = 0;
     mMagField = 0.0;
     /// Initializing CCDB
@@ -327,6 +349,33 @@ struct femtoDreamProducerTask {
                        particle.mK0Short()); // QA for v0
     }
   }
+  /// Fills a particle in FemtoDreamParticles, or in FemtoDreamParticlesPacked for ConfPackedOutput
+  void fillParticle(float pt, float eta, float phi, aod::femtodreamparticle::ParticleType partType, aod::femtodreamparticle::cutContainerType cut, aod::femtodreamparticle::cutContainerType pidcut, float tempFitVar, int* indices, float mLambda, float mAntiLambda)
+  {
+    if (ConfPackedOutput) {
+      using namespace aod::femtodreampacked;
+      outputPartsPacked(pack<binningPt>(pt), pack<binningEta>(eta), pack<binningPhi>(phi), partType, cut, static_cast<pidCutStoreType>(pidcut), tempFitVar, indices, pack<binningMass>(mLambda), pack<binningMass>(mAntiLambda));
+      mNPartsCollision++;
+    } else {
+      outputParts(outputCollision.lastIndex(), pt, eta, phi, partType, cut, pidcut, tempFitVar, indices, mLambda, mAntiLambda);
+    }
+  }
+
+  /// Row of the last particle filled, the same in both formats
+  int lastParticleIndex()
+  {
+    return ConfPackedOutput ? outputPartsPacked.lastIndex() : outputParts.lastIndex();
+  }
+
+  /// Number of particles of the collision for the packed format, to be called once per stored collision
+  void fillCollisionNParts()
+  {
+    if (ConfPackedOutput) {
+      outputCollNParts(mNPartsCollision);
+    }
+    mNPartsCollision = 0;
+  }
+
   template <typename ParticleType>
   void fillMCParticle(ParticleType const& particle)
   {
@@ -336,14 +385,14 @@ struct femtoDreamProducerTask {
       auto pdgCode = particleMC.pdgCode();
       bool isPrimary = particleMC.isPhysicalPrimary();
       if (isPrimary) {
-        outputPartsMC(outputParts.lastIndex(), aod::femtodreamparticleMC::ParticleOriginMCTruth::kPrimary, pdgCode);
+        outputPartsMC(lastParticleIndex(), aod::femtodreamparticleMC::ParticleOriginMCTruth::kPrimary, pdgCode);
       } else {
-        outputPartsMC(outputParts.lastIndex(), aod::femtodreamparticleMC::ParticleOriginMCTruth::kNotPrimary, pdgCode);
+        outputPartsMC(lastParticleIndex(), aod::femtodreamparticleMC::ParticleOriginMCTruth::kNotPrimary, pdgCode);
       }
       // fill with correct values, this is currently placeholder
       outputDebugPartsMC(-999);
     } else {
-      outputPartsMC(outputParts.lastIndex(), -999, -999);
+      outputPartsMC(lastParticleIndex(), -999, -999);
       outputDebugPartsMC(-999);
     }
   }
@@ -363,6 +412,7 @@ struct femtoDreamProducerTask {
     if (!colCuts.isSelected(col)) {
       if (ConfIsTrigger) {
         outputCollision(vtxZ, mult, spher, mMagField);
+        fillCollisionNParts();
       }
       return;
     }
@@ -370,28 +420,57 @@ struct femtoDreamProducerTask {
     colCuts.fillQA(col);
     outputCollision(vtxZ, mult, spher, mMagField);
 
+    // the particle QA is filled for a deterministic fraction ConfQAFraction of the collisions
+    bool fillParticleQA = true;
+    if (ConfQAFraction < 1.f) {
+      mQASampling += ConfQAFraction;
+      fillParticleQA = mQASampling >= 1.f;
+      if (fillParticleQA) {
+        mQASampling -= 1.f;
+      }
+    }
+    const bool batchSelection = ConfTrkBatchSelection && !fillParticleQA;
+    if (batchSelection) {
+      trackCuts.getCutContainers(tracks, mTrkIsSelected, mTrkCuts, mTrkPID);
+    }
+
     int childIDs[2] = {0, 0};    // these IDs are necessary to keep track of the children
     std::vector<int> tmpIDtrack; // this vector keeps track of the matching of the primary track table row <-> aod::track table global index
 
+    size_t iTrack = 0;
     for (auto& track : tracks) {
-      /// if the most open selection criteria are not fulfilled there is no point looking further at the track
-      if (!trackCuts.isSelectedMinimal(track)) {
-        continue;
+      aod::femtodreamparticle::cutContainerType cutsTrack = 0;
+      aod::femtodreamparticle::cutContainerType pidTrack = 0;
+      if (batchSelection) {
+        const size_t iSel = iTrack++;
+        if (!mTrkIsSelected[iSel]) {
+          continue;
+        }
+        cutsTrack = mTrkCuts[iSel];
+        pidTrack = mTrkPID[iSel];
+      } else {
+        /// if the most open selection criteria are not fulfilled there is no point looking further at the track
+        if (!trackCuts.isSelectedMinimal(track)) {
+          continue;
+        }
+        if (fillParticleQA) {
+          trackCuts.fillQA<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::TrackType::kNoChild>(track);
+        }
+        // the bit-wise container of the systematic variations is obtained
+        auto cutContainer = trackCuts.getCutContainer<aod::femtodreamparticle::cutContainerType>(track);
+        cutsTrack = cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kCuts);
+        pidTrack = cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kPID);
       }
-      trackCuts.fillQA<aod::femtodreamparticle::ParticleType::kTrack, aod::femtodreamparticle::TrackType::kNoChild>(track);
-      // the bit-wise container of the systematic variations is obtained
-      auto cutContainer = trackCuts.getCutContainer<aod::femtodreamparticle::cutContainerType>(track);
 
       // now the table is filled
-      outputParts(outputCollision.lastIndex(),
-                  track.pt(),
-                  track.eta(),
-                  track.phi(),
-                  aod::femtodreamparticle::ParticleType::kTrack,
-                  cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kCuts),
-                  cutContainer.at(femtoDreamTrackSelection::TrackContainerPosition::kPID),
-                  track.dcaXY(),
-                  childIDs, 0, 0);
+      fillParticle(track.pt(),
+                   track.eta(),
+                   track.phi(),
+                   aod::femtodreamparticle::ParticleType::kTrack,
+                   cutsTrack,
+                   pidTrack,
+                   track.dcaXY(),
+                   childIDs, 0, 0);
       tmpIDtrack.push_back(track.globalIndex());
       if (ConfDebugOutput) {
         fillDebugParticle<true>(track);
@@ -409,7 +488,9 @@ struct femtoDreamProducerTask {
         // const auto dcaXYpos = postrack.dcaXY();
         // const auto dcaZpos = postrack.dcaZ();
         // const auto dcapos = std::sqrt(pow(dcaXYpos, 2.) + pow(dcaZpos, 2.));
-        v0Cuts.fillLambdaQA(col, v0, postrack, negtrack);
+        if (fillParticleQA) {
+          v0Cuts.fillLambdaQA(col, v0, postrack, negtrack);
+        }
 
         if (!v0Cuts.isSelectedMinimal(col, v0, postrack, negtrack)) {
           continue;
@@ -421,7 +502,9 @@ struct femtoDreamProducerTask {
           // bool itsHit = o2PhysicsTrackSelection->IsSelected(negtrack, TrackSelection::TrackCuts::kITSHits);
         }
 
-        v0Cuts.fillQA<aod::femtodreamparticle::ParticleType::kV0, aod::femtodreamparticle::ParticleType::kV0Child>(col, v0, postrack, negtrack); ///\todo fill QA also for daughters
+        if (fillParticleQA) {
+          v0Cuts.fillQA<aod::femtodreamparticle::ParticleType::kV0, aod::femtodreamparticle::ParticleType::kV0Child>(col, v0, postrack, negtrack); ///\todo fill QA also for daughters
+        }
         auto cutContainerV0 = v0Cuts.getCutContainer<aod::femtodreamparticle::cutContainerType>(col, v0, postrack, negtrack);
 
         if ((cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kV0) > 0) && (cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosCuts) > 0) && (cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegCuts) > 0)) {
@@ -430,8 +513,8 @@ struct femtoDreamProducerTask {
           rowInPrimaryTrackTablePos = getRowDaughters(postrackID, tmpIDtrack);
           childIDs[0] = rowInPrimaryTrackTablePos;
           childIDs[1] = 0;
-          outputParts(outputCollision.lastIndex(), v0.positivept(), v0.positiveeta(), v0.positivephi(), aod::femtodreamparticle::ParticleType::kV0Child, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosCuts), cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosPID), 0., childIDs, 0, 0);
-          const int rowOfPosTrack = outputParts.lastIndex();
+          fillParticle(v0.positivept(), v0.positiveeta(), v0.positivephi(), aod::femtodreamparticle::ParticleType::kV0Child, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosCuts), cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kPosPID), 0., childIDs, 0, 0);
+          const int rowOfPosTrack = lastParticleIndex();
           if constexpr (isMC) {
             fillMCParticle(postrack);
           }
@@ -440,13 +523,13 @@ struct femtoDreamProducerTask {
           rowInPrimaryTrackTableNeg = getRowDaughters(negtrackID, tmpIDtrack);
           childIDs[0] = 0;
           childIDs[1] = rowInPrimaryTrackTableNeg;
-          outputParts(outputCollision.lastIndex(), v0.negativept(), v0.negativeeta(), v0.negativephi(), aod::femtodreamparticle::ParticleType::kV0Child, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegCuts), cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegPID), 0., childIDs, 0, 0);
-          const int rowOfNegTrack = outputParts.lastIndex();
+          fillParticle(v0.negativept(), v0.negativeeta(), v0.negativephi(), aod::femtodreamparticle::ParticleType::kV0Child, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegCuts), cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kNegPID), 0., childIDs, 0, 0);
+          const int rowOfNegTrack = lastParticleIndex();
           if constexpr (isMC) {
             fillMCParticle(negtrack);
           }
           int indexChildID[2] = {rowOfPosTrack, rowOfNegTrack};
-          outputParts(outputCollision.lastIndex(), v0.pt(), v0.eta(), v0.phi(), aod::femtodreamparticle::ParticleType::kV0, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kV0), 0, v0.v0cosPA(col.posX(), col.posY(), col.posZ()), indexChildID, v0.mLambda(), v0.mAntiLambda());
+          fillParticle(v0.pt(), v0.eta(), v0.phi(), aod::femtodreamparticle::ParticleType::kV0, cutContainerV0.at(femtoDreamV0Selection::V0ContainerPosition::kV0), 0, v0.v0cosPA(col.posX(), col.posY(), col.posZ()), indexChildID, v0.mLambda(), v0.mAntiLambda());
           if (ConfDebugOutput) {
             fillDebugParticle<true>(postrack); // QA for positive daughter
             fillDebugParticle<true>(negtrack); // QA for negative daughter
@@ -458,6 +541,7 @@ struct femtoDreamProducerTask {
         }
       }
     }
+    fillCollisionNParts();
   }
 
   void processData(aod::FemtoFullCollision const& col, aod::BCsWithTimestamps const&, aod::FemtoFullTracks const& tracks,
@@ -20,6 +20,7 @@
 #include "PWGCF/FemtoWorld/DataModel/FemtoWorldDerived.h"
 
 #include "Framework/HistogramRegistry.h"
+#include "Common/Core/ScratchArena.h"
 #include <string>
 
 namespace o2::analysis
@@ -156,10 +157,12 @@ class FemtoWorldDetaDphiStar
   std::array<std::array<std::shared_ptr<TH2>, 2>, 2> histdetadpi{};
   std::array<std::array<std::shared_ptr<TH2>, 9>, 2> histdetadpiRadii{};
 
+  o2::common::ScratchArena scratch{1024}; ///< per-pair buffers of AveragePhiStar
+
   ///  Calculate phi at all required radii stored in tmpRadiiTPC
   /// Magnetic field to be provided in Tesla
-  template <typename T>
-  void PhiAtRadiiTPC(const T& part, std::vector<float>& tmpVec)
+  template <typename T, typename V>
+  void PhiAtRadiiTPC(const T& part, V& tmpVec)
   {
 
     float phi0 = part.phi();
@@ -185,8 +188,9 @@ class FemtoWorldDetaDphiStar
   template <typename T1, typename T2>
   float AveragePhiStar(const T1& part1, const T2& part2, int iHist)
   {
-    std::vector<float> tmpVec1;
-    std::vector<float> tmpVec2;
+    scratch.reset();
+    auto tmpVec1 = scratch.vector<float>(9);
+    auto tmpVec2 = scratch.vector<float>(9);
     PhiAtRadiiTPC(part1, tmpVec1);
     PhiAtRadiiTPC(part2, tmpVec2);
     const int num = tmpVec1.size();
@@ -28,6 +28,7 @@
 #include "PWGCF/FemtoWorld/Core/FemtoWorldContainer.h"
 #include "PWGCF/FemtoWorld/Core/FemtoWorldDetaDphiStar.h"
 #include "PWGCF/FemtoWorld/Core/FemtoWorldUtils.h"
+#include "PWGCF/Core/FemtoPairEngine.h"
 
 using namespace o2;
 using namespace o2::analysis::femtoWorld;
@@ -156,6 +157,7 @@ struct femtoWorldPairTaskTrackTrack {
   FemtoWorldContainer<femtoWorldContainer::EventType::mixed, femtoWorldContainer::Observable::kstar> mixedEventCont;
   FemtoWorldPairCleaner<aod::femtoworldparticle::ParticleType::kTrack, aod::femtoworldparticle::ParticleType::kTrack> pairCleaner;
   FemtoWorldDetaDphiStar<aod::femtoworldparticle::ParticleType::kTrack, aod::femtoworldparticle::ParticleType::kTrack> pairCloseRejection;
+  o2::analysis::femtoPair::FemtoPairEngine<decltype(sameEventCont), decltype(mixedEventCont), decltype(pairCleaner), decltype(pairCloseRejection)> pairEngine;
   /// Histogram output
   HistogramRegistry qaRegistry{"TrackQA", {}, OutputObjHandlingPolicy::AnalysisObject};
   // HistogramRegistry qaRegistryFail{"TrackQAFailed", {}, OutputObjHandlingPolicy::AnalysisObject};
@@ -183,6 +185,7 @@ struct femtoWorldPairTaskTrackTrack {
     if (ConfIsCPR) {
       pairCloseRejection.init(&resultRegistry, &qaRegistry, 0.01, 0.01, ConfCPRPlotPerRadii); /// \todo add config for Δη and ΔΦ cut values
     }
+    pairEngine.init(&sameEventCont, &mixedEventCont, &pairCleaner, &pairCloseRejection, ConfIsCPR);
 
     vPIDPartOne = ConfPIDPartOne;
     vPIDPartTwo = ConfPIDPartTwo;
@@ -228,8 +231,13 @@ struct femtoWorldPairTaskTrackTrack {
     return false;
   }
 
+  /// Selection of the particles for the pairing
+  auto isSelectedKaon()
+  {
+    return [this](auto const& part) { return IsKaonNSigma(part.p(), part.tpcNSigmaKa(), part.tofNSigmaKa()); };
+  }
+
   /// This function processes the same event and takes care of all the histogramming
-  /// \todo the trivial loops over the tracks should be factored out since they will be common to all combinations of T-T, T-V0, V0-V0, ...
   void processSameEvent(o2::aod::FemtoWorldCollision& col,
                         o2::aod::FemtoWorldParticlesMerged& parts)
   {
@@ -269,66 +277,23 @@ struct femtoWorldPairTaskTrackTrack {
       }
     }
     /// Now build the combinations
-    for (auto& [p1, p2] : combinations(groupPartsOne, groupPartsTwo)) {
-      if (!(IsKaonNSigma(p1.p(), p1.tpcNSigmaKa(), p1.tofNSigmaKa()))) {
-        continue;
-      }
-      if (!(IsKaonNSigma(p2.p(), p2.tpcNSigmaKa(), p2.tofNSigmaKa()))) {
-        continue;
-      }
-      if (ConfIsCPR) {
-        if (pairCloseRejection.isClosePair(p1, p2, parts, magFieldTesla)) {
-          continue;
-        }
-      }
-      // track cleaning
-      if (!pairCleaner.isCleanPair(p1, p2, parts)) {
-        continue;
-      }
-      sameEventCont.setPair(p1, p2, multCol);
-    }
+    pairEngine.processSameEvent(groupPartsOne, groupPartsTwo, parts, magFieldTesla, multCol, isSelectedKaon(), isSelectedKaon());
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackTrack, processSameEvent, "Enable processing same event", true);
 
   /// This function processes the mixed event
-  /// \todo the trivial loops over the collisions and tracks should be factored out since they will be common to all combinations of T-T, T-V0, V0-V0, ...
   void processMixedEvent(o2::aod::FemtoWorldCollisions& cols,
                          o2::aod::FemtoWorldParticlesMerged& parts)
   {
-
-    for (auto& [collision1, collision2] : soa::selfCombinations(colBinning, 5, -1, cols, cols)) {
-
-      MixQaRegistry.fill(HIST("MixingQA/hMECollisionBins"), colBinning.getBin({collision1.posZ(), collision1.multV0M()}));
-
+    auto mixCollisions = [&](auto const& collision1, auto const& collision2) {
       auto groupPartsOne = partsOne->sliceByCached(aod::femtoworldparticle::femtoWorldCollisionId, collision1.globalIndex());
       auto groupPartsTwo = partsTwo->sliceByCached(aod::femtoworldparticle::femtoWorldCollisionId, collision2.globalIndex());
-
-      const auto& magFieldTesla1 = collision1.magField();
-      const auto& magFieldTesla2 = collision2.magField();
-
-      if (magFieldTesla1 != magFieldTesla2) {
-        continue;
-      }
-
-      /// \todo before mixing we should check whether both collisions contain a pair of particles!
-      // if (partsOne.size() == 0 || nPart2Evt1 == 0 || nPart1Evt2 == 0 || partsTwo.size() == 0 ) continue;
-
-      for (auto& [p1, p2] : combinations(CombinationsFullIndexPolicy(groupPartsOne, groupPartsTwo))) {
-        if (!(IsKaonNSigma(p1.p(), p1.tpcNSigmaKa(), p1.tofNSigmaKa()))) {
-          continue;
-        }
-        if (!(IsKaonNSigma(p2.p(), p2.tpcNSigmaKa(), p2.tofNSigmaKa()))) {
-          continue;
-        }
-        if (ConfIsCPR) {
-          if (pairCloseRejection.isClosePair(p1, p2, parts, magFieldTesla1)) {
-            continue;
-          }
-        }
-        mixedEventCont.setPair(p1, p2, collision1.multV0M());
-      }
-    }
+      pairEngine.processMixedEvent(groupPartsOne, groupPartsTwo, parts, collision1.magField(), collision1.multV0M(), isSelectedKaon(), isSelectedKaon());
+    };
+    pairEngine.mixEvents(colBinning, ConfNEventsMix, cols, mixCollisions, [&](auto const& collision1, auto const&) {
+      MixQaRegistry.fill(HIST("MixingQA/hMECollisionBins"), colBinning.getBin({collision1.posZ(), collision1.multV0M()}));
+    });
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackTrack, processMixedEvent, "Enable processing mixed events", true);
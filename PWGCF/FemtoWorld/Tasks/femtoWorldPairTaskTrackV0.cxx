@@ -27,6 +27,7 @@
 #include "PWGCF/FemtoWorld/Core/FemtoWorldContainer.h"
 #include "PWGCF/FemtoWorld/Core/FemtoWorldDetaDphiStar.h"
 #include "PWGCF/FemtoWorld/Core/FemtoWorldUtils.h"
+#include "PWGCF/Core/FemtoPairEngine.h"
 
 using namespace o2;
 using namespace o2::analysis::femtoWorld;
@@ -100,6 +101,7 @@ struct femtoWorldPairTaskTrackV0 {
   FemtoWorldContainer<femtoWorldContainer::EventType::mixed, femtoWorldContainer::Observable::kstar> mixedEventCont;
   FemtoWorldPairCleaner<aod::femtoworldparticle::ParticleType::kTrack, aod::femtoworldparticle::ParticleType::kV0> pairCleaner;
   FemtoWorldDetaDphiStar<aod::femtoworldparticle::ParticleType::kTrack, aod::femtoworldparticle::ParticleType::kV0> pairCloseRejection;
+  o2::analysis::femtoPair::FemtoPairEngine<decltype(sameEventCont), decltype(mixedEventCont), decltype(pairCleaner), decltype(pairCloseRejection)> pairEngine;
   /// Histogram output
   HistogramRegistry qaRegistry{"TrackQA", {}, OutputObjHandlingPolicy::AnalysisObject};
   HistogramRegistry resultRegistry{"Correlations", {}, OutputObjHandlingPolicy::AnalysisObject};
@@ -118,12 +120,27 @@ struct femtoWorldPairTaskTrackV0 {
     if (ConfIsCPR) {
       pairCloseRejection.init(&resultRegistry, &qaRegistry, 0.01, 0.01, ConfCPRPlotPerRadii); /// \todo add config for Δη and ΔΦ cut values
     }
+    pairEngine.init(&sameEventCont, &mixedEventCont, &pairCleaner, &pairCloseRejection, ConfIsCPR);
 
     vPIDPartOne = ConfPIDPartOne;
   }
 
+  /// Selections of the particles one and two for the pairing
+  auto isSelectedPartOne()
+  {
+    return [this](auto const& part) {
+      if (part.p() > cfgCutTable->get("PartOne", "MaxP") || part.pt() > cfgCutTable->get("PartOne", "MaxPt")) {
+        return false;
+      }
+      return isFullPIDSelected(part.pidcut(), part.p(), cfgCutTable->get("PartOne", "PIDthr"), vPIDPartOne, cfgNspecies, kNsigma, cfgCutTable->get("PartOne", "nSigmaTPC"), cfgCutTable->get("PartOne", "nSigmaTPCTOF"));
+    };
+  }
+  auto isSelectedPartTwo()
+  {
+    return [](auto const&) { return true; };
+  }
+
   /// This function processes the same event and takes care of all the histogramming
-  /// \todo the trivial loops over the tracks should be factored out since they will be common to all combinations of T-T, T-V0, V0-V0, ...
   void processSameEvent(o2::aod::FemtoWorldCollision& col,
                         o2::aod::FemtoWorldParticles& parts)
   {
@@ -147,64 +164,22 @@ struct femtoWorldPairTaskTrackV0 {
       trackHistoPartTwo.fillQA(part);
     }
     /// Now build the combinations
-    for (auto& [p1, p2] : combinations(groupPartsOne, groupPartsTwo)) {
-      if (p1.p() > cfgCutTable->get("PartOne", "MaxP") || p1.pt() > cfgCutTable->get("PartOne", "MaxPt")) {
-        continue;
-      }
-      if (!isFullPIDSelected(p1.pidcut(), p1.p(), cfgCutTable->get("PartOne", "PIDthr"), vPIDPartOne, cfgNspecies, kNsigma, cfgCutTable->get("PartOne", "nSigmaTPC"), cfgCutTable->get("PartOne", "nSigmaTPCTOF"))) {
-        continue;
-      }
-
-      if (ConfIsCPR) {
-        if (pairCloseRejection.isClosePair(p1, p2, parts, magFieldTesla)) {
-          continue;
-        }
-      }
-
-      // track cleaning
-      if (!pairCleaner.isCleanPair(p1, p2, parts)) {
-        continue;
-      }
-      sameEventCont.setPair(p1, p2, multCol);
-    }
+    pairEngine.processSameEvent(groupPartsOne, groupPartsTwo, parts, magFieldTesla, multCol, isSelectedPartOne(), isSelectedPartTwo());
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackV0, processSameEvent, "Enable processing same event", true);
 
   /// This function processes the mixed event
-  /// \todo the trivial loops over the collisions and tracks should be factored out since they will be common to all combinations of T-T, T-V0, V0-V0, ...
   void processMixedEvent(o2::aod::FemtoWorldCollisions& cols,
                          o2::aod::FemtoWorldParticles& parts)
   {
     ColumnBinningPolicy<aod::collision::PosZ, aod::femtoworldcollision::MultV0M> colBinning{{CfgVtxBins, CfgMultBins}, true};
 
-    for (auto& [collision1, collision2] : soa::selfCombinations(colBinning, 5, -1, cols, cols)) {
-
+    pairEngine.mixEvents(colBinning, ConfNEventsMix, cols, [&](auto const& collision1, auto const& collision2) {
       auto groupPartsOne = partsOne->sliceByCached(aod::femtoworldparticle::femtoWorldCollisionId, collision1.globalIndex());
       auto groupPartsTwo = partsTwo->sliceByCached(aod::femtoworldparticle::femtoWorldCollisionId, collision2.globalIndex());
-
-      const auto& magFieldTesla1 = collision1.magField();
-      const auto& magFieldTesla2 = collision2.magField();
-
-      if (magFieldTesla1 != magFieldTesla2) {
-        continue;
-      }
-
-      for (auto& [p1, p2] : combinations(CombinationsFullIndexPolicy(groupPartsOne, groupPartsTwo))) {
-        if (p1.p() > cfgCutTable->get("PartOne", "MaxP") || p1.pt() > cfgCutTable->get("PartOne", "MaxPt")) {
-          continue;
-        }
-        if (!isFullPIDSelected(p1.pidcut(), p1.p(), cfgCutTable->get("PartOne", "PIDthr"), vPIDPartOne, cfgNspecies, kNsigma, cfgCutTable->get("PartOne", "nSigmaTPC"), cfgCutTable->get("PartOne", "nSigmaTPCTOF"))) {
-          continue;
-        }
-        if (ConfIsCPR) {
-          if (pairCloseRejection.isClosePair(p1, p2, parts, magFieldTesla1)) {
-            continue;
-          }
-        }
-        mixedEventCont.setPair(p1, p2, collision1.multV0M());
-      }
-    }
+      pairEngine.processMixedEvent(groupPartsOne, groupPartsTwo, parts, collision1.magField(), collision1.multV0M(), isSelectedPartOne(), isSelectedPartTwo());
+    });
   }
 
   PROCESS_SWITCH(femtoWorldPairTaskTrackV0, processMixedEvent, "Enable processing mixed events", true);
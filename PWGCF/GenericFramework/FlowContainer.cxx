@@ -10,6 +10,10 @@
 // or submit itself to any jurisdiction.
 
 #include "FlowContainer.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "TROOT.h"
 
 ClassImp(FlowContainer);
 
@@ -149,6 +153,74 @@ int FlowContainer::FillProfile(const char* hname, double multi, double corr, dou
   };
   return 0;
 };
+int FlowContainer::GetProfileIndex(const char* hname)
+{
+  if (!fProf)
+    return -1;
+  int yin = fProf->GetYaxis()->FindBin(hname);
+  if (!yin) {
+    printf("Could not find bin %s\n", hname);
+    return -1;
+  };
+  return yin;
+};
+int FlowContainer::FillProfile(int yin, double multi, double corr, double w, double rn)
+{
+  return FillProfiles(1, &yin, multi, &corr, &w, rn);
+};
+int FlowContainer::FillProfiles(int n, const int* yin, double multi, const double* corr, const double* w, double rn)
+{
+  if (!fProf)
+    return -1;
+  // The multiplicity bin is the same for all correlators and subsamples, so only look it up once
+  int xbin = fProf->GetXaxis()->FindFixBin(multi);
+  AddToProfileBins(fProf, multi, xbin, n, yin, corr, w);
+  if (fNRandom) {
+    double rnind = rn * fNRandom;
+    AddToProfileBins((TProfile2D*)fProfRand->At((int)rnind), multi, xbin, n, yin, corr, w);
+  };
+  return 0;
+};
+void FlowContainer::AddToProfileBins(TProfile2D* prof, double multi, int xbin, int n, const int* yin, const double* corr, const double* w)
+{
+  // Equivalent to prof->Fill(multi, yin[i], corr[i], w[i]) for each correlator, but adding directly to the bin storage
+  // (sum w*y, sum w*y^2, sum w, sum w^2) and updating the statistics once
+  int nBinsY = prof->GetNbinsY();
+  bool xInRange = xbin > 0 && xbin <= prof->GetNbinsX();
+  double* sumwy = prof->GetArray();
+  double* sumwy2 = prof->GetSumw2()->GetArray();
+  double* sumw2 = prof->GetBinSumw2()->fN ? prof->GetBinSumw2()->GetArray() : 0;
+  double stats[9];
+  if (xInRange)
+    prof->GetStats(stats);
+  int nFilled = 0;
+  for (int i = 0; i < n; i++) {
+    if (yin[i] < 1 || yin[i] > nBinsY)
+      continue;
+    int bin = prof->GetBin(xbin, yin[i]);
+    double wy = w[i] * corr[i];
+    sumwy[bin] += wy;
+    sumwy2[bin] += wy * corr[i];
+    prof->SetBinEntries(bin, prof->GetBinEntries(bin) + w[i]);
+    if (sumw2)
+      sumw2[bin] += w[i] * w[i];
+    ++nFilled;
+    if (!xInRange)
+      continue;
+    stats[0] += w[i];
+    stats[1] += w[i] * w[i];
+    stats[2] += w[i] * multi;
+    stats[3] += w[i] * multi * multi;
+    stats[4] += w[i] * yin[i];
+    stats[5] += w[i] * yin[i] * yin[i];
+    stats[6] += w[i] * multi * yin[i];
+    stats[7] += wy;
+    stats[8] += wy * corr[i];
+  };
+  if (xInRange && nFilled)
+    prof->PutStats(stats);
+  prof->SetEntries(prof->GetEntries() + nFilled);
+};
 void FlowContainer::OverrideProfileErrors(TProfile2D* inpf)
 {
   int nBinsX = fProf->GetNbinsX();
@@ -189,55 +261,76 @@ Long64_t FlowContainer::Merge(TCollection* collist)
   FlowContainer* l_FC = 0;
   TIter all_FC(collist);
   while ((l_FC = ((FlowContainer*)all_FC()))) {
-    TProfile2D* tpro = GetProfile();
-    TProfile2D* spro = l_FC->GetProfile();
-    if (!tpro) {
-      fProf = (TProfile2D*)spro->Clone(spro->GetName());
-      fProf->SetDirectory(0);
-    } else
-      tpro->Add(spro);
-    nmerged++;
-    TObjArray* tarr = l_FC->GetSubProfiles();
-    if (!tarr)
+    if (!l_FC->GetProfile())
       continue;
-    if (!fProfRand) {
-      fProfRand = new TObjArray();
-      fProfRand->SetOwner(kTRUE);
-    };
-    for (int i = 0; i < tarr->GetEntries(); i++) {
-      if (!(fProfRand->FindObject(tarr->At(i)->GetName()))) {
-        fProfRand->Add((TProfile2D*)tarr->At(i)->Clone(tarr->At(i)->GetName()));
-        ((TProfile2D*)fProfRand->At(fProfRand->GetEntries() - 1))->SetDirectory(0);
-      } else {
-        ((TProfile2D*)fProfRand->FindObject(tarr->At(i)->GetName()))->Add((TProfile2D*)tarr->At(i));
-      };
-    };
+    MergeContainer(l_FC, kFALSE);
+    nmerged++;
   };
   return nmerged;
 };
-void FlowContainer::ReadAndMerge(const char* filelist)
+void FlowContainer::ReadAndMerge(const char* filelist, int nThreads)
 {
   FILE* flist = fopen(filelist, "r");
-  char str[150];
-  int nFiles = 0;
-  while (fscanf(flist, "%s\n", str) == 1)
-    nFiles++;
-  rewind(flist);
+  if (!flist) {
+    printf("Could not open file list %s!\n", filelist);
+    return;
+  };
+  char str[1024];
+  std::vector<TString> files;
+  while (fscanf(flist, "%1023s\n", str) == 1)
+    files.push_back(str);
+  fclose(flist);
+  int nFiles = (int)files.size();
   if (nFiles == 0) {
     printf("No files to read!\n");
     return;
   };
-  for (int i = 0; i < nFiles; i++) {
-    fscanf(flist, "%s\n", str);
-    TFile* tf = new TFile(str, "READ");
-    if (tf->IsZombie()) {
-      printf("Could not open file %s!\n", str);
-      tf->Close();
-      continue;
-    };
-    PickAndMerge(tf);
-    tf->Close();
+  if (nThreads > nFiles)
+    nThreads = nFiles;
+  if (nThreads < 2) {
+    for (int i = 0; i < nFiles; i++)
+      ReadAndMergeFile(files[i].Data());
+    return;
+  };
+  // Each thread merges a contiguous range of files into its own container, then the containers are merged pairwise
+  ROOT::EnableThreadSafety();
+  std::vector<FlowContainer*> partials(nThreads);
+  std::vector<std::thread> workers;
+  for (int iThread = 0; iThread < nThreads; iThread++) {
+    partials[iThread] = new FlowContainer(GetName());
+    workers.emplace_back([&files, &partials, iThread, nThreads, nFiles]() {
+      for (int i = iThread * nFiles / nThreads; i < (iThread + 1) * nFiles / nThreads; i++)
+        partials[iThread]->ReadAndMergeFile(files[i].Data());
+    });
   };
+  for (auto& worker : workers)
+    worker.join();
+  for (int step = 1; step < nThreads; step *= 2) {
+    workers.clear();
+    for (int i = 0; i + step < nThreads; i += 2 * step)
+      workers.emplace_back([&partials, i, step]() {
+        if (partials[i + step]->GetProfile())
+          partials[i]->MergeContainer(partials[i + step], kTRUE);
+      });
+    for (auto& worker : workers)
+      worker.join();
+  };
+  if (partials[0]->GetProfile())
+    MergeContainer(partials[0], kTRUE);
+  for (auto& partial : partials)
+    delete partial;
+};
+void FlowContainer::ReadAndMergeFile(const char* infile)
+{
+  TFile* tf = new TFile(infile, "READ");
+  if (tf->IsZombie()) {
+    printf("Could not open file %s!\n", infile);
+    delete tf;
+    return;
+  };
+  PickAndMerge(tf);
+  tf->Close();
+  delete tf;
 };
 void FlowContainer::PickAndMerge(TFile* tfi)
 {
@@ -246,29 +339,82 @@ void FlowContainer::PickAndMerge(TFile* tfi)
     printf("Could not pick up the %s from %s\n", this->GetName(), tfi->GetName());
     return;
   };
+  if (lfc->GetProfile())
+    MergeContainer(lfc, kTRUE);
+  delete lfc;
+};
+void FlowContainer::MergeContainer(FlowContainer* lfc, bool takeProfiles)
+{
+  // If takeProfiles, the profiles missing here are moved from lfc rather than copied, leaving lfc incomplete
   TProfile2D* spro = lfc->GetProfile();
-  TProfile2D* tpro = GetProfile();
-  if (!tpro) {
-    fProf = (TProfile2D*)spro->Clone(spro->GetName());
+  if (!fProf) {
+    if (takeProfiles) {
+      fProf = spro;
+      lfc->fProf = 0;
+    } else
+      fProf = (TProfile2D*)spro->Clone(spro->GetName());
     fProf->SetDirectory(0);
   } else
-    tpro->Add(spro);
+    AddProfile(fProf, spro);
   TObjArray* tarr = lfc->GetSubProfiles();
-  if (!tarr) {
+  if (!tarr)
     return;
-  };
   if (!fProfRand) {
     fProfRand = new TObjArray();
     fProfRand->SetOwner(kTRUE);
   };
-  for (int i = 0; i < tarr->GetEntries(); i++) {
-    if (!(fProfRand->FindObject(tarr->At(i)->GetName()))) {
-      fProfRand->Add((TProfile2D*)tarr->At(i)->Clone(tarr->At(i)->GetName()));
-      ((TProfile2D*)fProfRand->At(fProfRand->GetEntries() - 1))->SetDirectory(0);
-    } else {
-      ((TProfile2D*)fProfRand->FindObject(tarr->At(i)->GetName()))->Add((TProfile2D*)tarr->At(i));
+  for (int i = 0; i < tarr->GetEntriesFast(); i++) {
+    TProfile2D* ssub = (TProfile2D*)tarr->At(i);
+    if (!ssub)
+      continue;
+    // Subsamples are at the same position in all the containers of a production; only look them up by name otherwise
+    TProfile2D* tsub = 0;
+    if (i < fProfRand->GetEntriesFast() && fProfRand->At(i) && !strcmp(fProfRand->At(i)->GetName(), ssub->GetName()))
+      tsub = (TProfile2D*)fProfRand->At(i);
+    else
+      tsub = (TProfile2D*)fProfRand->FindObject(ssub->GetName());
+    if (tsub) {
+      AddProfile(tsub, ssub);
+      continue;
     };
+    if (takeProfiles)
+      tarr->RemoveAt(i);
+    else
+      ssub = (TProfile2D*)ssub->Clone(ssub->GetName());
+    ssub->SetDirectory(0);
+    fProfRand->Add(ssub);
+  };
+};
+void FlowContainer::AddProfile(TProfile2D* target, TProfile2D* source)
+{
+  // Same as target->Add(source), adding the bin arrays in place when the binnings match
+  int nCells = target->GetNcells();
+  bool hasBinSumw2 = target->GetBinSumw2()->fN;
+  if (source->GetNcells() != nCells || source->GetNbinsX() != target->GetNbinsX() || source->GetNbinsY() != target->GetNbinsY() || source->GetSumw2()->fN != nCells || target->GetSumw2()->fN != nCells || (bool)source->GetBinSumw2()->fN != hasBinSumw2) {
+    target->Add(source);
+    return;
+  };
+  // Statistics are taken before adding the bins, as they are recalculated from the bins if empty
+  double tStats[9], sStats[9];
+  target->GetStats(tStats);
+  source->GetStats(sStats);
+  double* tArr = target->GetArray();
+  double* tSumw2 = target->GetSumw2()->GetArray();
+  double* tBinSumw2 = hasBinSumw2 ? target->GetBinSumw2()->GetArray() : 0;
+  const double* sArr = source->GetArray();
+  const double* sSumw2 = source->GetSumw2()->GetArray();
+  const double* sBinSumw2 = hasBinSumw2 ? source->GetBinSumw2()->GetArray() : 0;
+  for (int bin = 0; bin < nCells; bin++) {
+    tArr[bin] += sArr[bin];
+    tSumw2[bin] += sSumw2[bin];
+    if (hasBinSumw2)
+      tBinSumw2[bin] += sBinSumw2[bin];
+    target->SetBinEntries(bin, target->GetBinEntries(bin) + source->GetBinEntries(bin));
   };
+  for (int i = 0; i < 9; i++)
+    tStats[i] += sStats[i];
+  target->PutStats(tStats);
+  target->SetEntries(target->GetEntries() + source->GetEntries());
 };
 bool FlowContainer::OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2)
 {
@@ -50,10 +50,16 @@ class FlowContainer : public TNamed
   int GetNMultiBins() { return fProf->GetNbinsX(); };
   double GetMultiAtBin(int bin) { return fProf->GetXaxis()->GetBinCenter(bin); };
   int FillProfile(const char* hname, double multi, double y, double w, double rn);
+  int GetProfileIndex(const char* hname);                                                             // Index of a correlator, to be used in place of its name when filling
+  int FillProfile(int yin, double multi, double y, double w, double rn);                              // Fill by index, without looking up the name
+  int FillProfiles(int n, const int* yin, double multi, const double* y, const double* w, double rn); // Fill n correlators of one event, by index
   TProfile2D* GetProfile() { return fProf; };
   void OverrideProfileErrors(TProfile2D* inpf);
-  void ReadAndMerge(const char* infile);
+  void ReadAndMerge(const char* infile, int nThreads = 1); // infile is a list of files; with nThreads > 1 the files are read in parallel
+  void ReadAndMergeFile(const char* infile);
   void PickAndMerge(TFile* tfi);
+  void MergeContainer(FlowContainer* lfc, bool takeProfiles);
+  static void AddProfile(TProfile2D* target, TProfile2D* source);
   bool OverrideBinsWithZero(int xb1, int yb1, int xb2, int yb2);
   bool OverrideMainWithSub(int subind, bool ExcludeChosen);
   bool RandomizeProfile(int nSubsets = 0);
@@ -149,6 +155,7 @@ class FlowContainer : public TNamed
   TH1D* GetCN6(TH1D* corrN6, TH1D* corrN4, TH1D* corrN2);
   TH1D* GetCN8(TH1D* corrN8, TH1D* corrN6, TH1D* corrN4, TH1D* corrN2);
   TH1D* ProfToHist(TProfile* inpf);
+  void AddToProfileBins(TProfile2D* prof, double multi, int xbin, int n, const int* yin, const double* y, const double* w);
   TProfile2D* fProf;
   TObjArray* fProfRand;
   int fNRandom;
@@ -10,7 +10,7 @@
 // or submit itself to any jurisdiction.
 
 #include "GFW.h"
-GFW::GFW() : fInitialized(kFALSE){};
+GFW::GFW() : fEventCounter(1), fInitialized(kFALSE){};
 
 GFW::~GFW()
 {
@@ -103,6 +103,7 @@ void GFW::Fill(double eta, int ptin, double phi, double weight, int mask, double
     CreateRegions();
   if (!fInitialized)
     return;
+  ++fEventCounter; // Q-vectors change, so the memoized terms are outdated
   for (int i = 0; i < (int)fRegions.size(); ++i) {
     if (fRegions.at(i).EtaMin < eta && fRegions.at(i).EtaMax > eta && (fRegions.at(i).BitMask & mask))
       fCumulants.at(i).FillArray(eta, ptin, phi, weight, SecondWeight);
@@ -133,6 +134,10 @@ TComplex GFW::RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* q
     return qpoi->Vec(hars.at(0), pows.at(0), ptbin);
   if (hars.size() < 3)
     return TwoRec(hars.at(0), hars.at(1), pows.at(0), pows.at(1), ptbin, qpoi, qref, qol);
+  // Return the term if it was already calculated in this event
+  int termId = FindTerm(qpoi, qref, qol, ptbin, hars, pows);
+  if (fTermEvents[termId] == fEventCounter)
+    return fTermValues[termId];
   int harlast = hars.at(hars.size() - 1);
   int powlast = pows.at(pows.size() - 1);
   hars.erase(hars.end() - 1);
@@ -166,12 +171,34 @@ TComplex GFW::RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* q
   };
   hars.push_back(harlast);
   pows.push_back(powlast);
+  fTermValues[termId] = formula;
+  fTermEvents[termId] = fEventCounter;
   return formula;
 };
+int GFW::FindTerm(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars, vector<int>& pows)
+{
+  // Key: region indices (-1 if no overlap), pT bin, harmonics and powers. Harmonics and powers have the same size, so the key is unique
+  fTermKey.clear();
+  fTermKey.push_back(qpoi - fCumulants.data());
+  fTermKey.push_back(qref - fCumulants.data());
+  fTermKey.push_back(qol ? qol - fCumulants.data() : -1);
+  fTermKey.push_back(ptbin);
+  fTermKey.insert(fTermKey.end(), hars.begin(), hars.end());
+  fTermKey.insert(fTermKey.end(), pows.begin(), pows.end());
+  auto lTerm = fTermIds.find(fTermKey);
+  if (lTerm != fTermIds.end())
+    return lTerm->second;
+  int termId = (int)fTermValues.size();
+  fTermIds.emplace(fTermKey, termId);
+  fTermValues.push_back(TComplex(0, 0));
+  fTermEvents.push_back(0);
+  return termId;
+};
 void GFW::Clear()
 {
   for (auto ptr = fCumulants.begin(); ptr != fCumulants.end(); ++ptr)
     ptr->ResetQs();
+  ++fEventCounter;
   fCalculatedNames.clear();
   fCalculatedQs.clear();
 };
@@ -15,6 +15,7 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <map>
 #include "TString.h"
 #include "TObjArray.h"
 using std::vector;
@@ -89,6 +90,13 @@ class GFW
   vector<TString> fCalculatedNames;
   vector<TComplex> fCalculatedQs;
   int FindCalculated(TString identifier);
+  // Recursive correlators memoized per event: terms with the same regions, pT bin, harmonics and powers are only calculated once
+  std::map<vector<int>, int> fTermIds; // Term id of regions, pT bin, harmonics and powers
+  vector<int> fTermKey;                // Buffer of the key being looked up
+  vector<TComplex> fTermValues;        // Value of each term
+  vector<unsigned long> fTermEvents;   // Counter of the event for which the term value was calculated
+  unsigned long fEventCounter;         // Incremented whenever the Q-vectors change
+  int FindTerm(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, vector<int>& hars, vector<int>& pows);
   // Calculateing functions:
   TComplex Calculate(int poi, int ref, vector<int> hars, int ptbin = 0); // For differential, need POI and reference
   TComplex Calculate(int poi, vector<int> hars);                         // For integrated case
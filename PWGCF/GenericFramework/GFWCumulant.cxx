@@ -10,8 +10,9 @@
 // or submit itself to any jurisdiction.
 
 #include "GFWCumulant.h"
+#include <algorithm>
 
-GFWCumulant::GFWCumulant() : fQvector(0),
+GFWCumulant::GFWCumulant() : fNQ(0),
                              fUsed(kBlank),
                              fNEntries(-1),
                              fN(1),
@@ -33,52 +34,56 @@ void GFWCumulant::FillArray(double eta, int ptin, double phi, double weight, dou
   else if (ptin < 0 || ptin >= fPt)
     return;
   fFilledPts[ptin] = kTRUE;
+  // Powers of the weight, each by one multiplication from the previous one
+  // If second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
+  // this is important when POIs are a subset of REFs and have different weights than REFs
+  double* lPowers = fWgtPowers.data();
+  lPowers[0] = 1;
+  for (int lPow = 1; lPow < (int)fWgtPowers.size(); lPow++)
+    lPowers[lPow] = lPowers[lPow - 1] * ((SecondWeight > 0 && lPow > 1) ? SecondWeight : weight);
+  // Higher harmonics from the angle addition formulas, such that sin and cos are computed only once
+  const double lSin1 = TMath::Sin(phi);
+  const double lCos1 = TMath::Cos(phi);
+  double lSin = 0;
+  double lCos = 1;
+  double* lRe = fQRe.data() + ptin * fNQ;
+  double* lIm = fQIm.data() + ptin * fNQ;
   for (int lN = 0; lN < fN; lN++) {
-    double lSin = TMath::Sin(lN * phi); // No need to recalculate for each power
-    double lCos = TMath::Cos(lN * phi); // No need to recalculate for each power
-    for (int lPow = 0; lPow < PW(lN); lPow++) {
-      double lPrefactor = 0;
-      // Dont calculate it twice; multiplication is cheaper that power
-      // Also, if second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
-      // this is important when POIs are a subset of REFs and have different weights than REFs
-      if (SecondWeight > 0 && lPow > 1)
-        lPrefactor = TMath::Power(SecondWeight, lPow - 1) * weight;
-      else
-        lPrefactor = TMath::Power(weight, lPow);
-      double qsin = lPrefactor * lSin;
-      double qcos = lPrefactor * lCos;
-      fQvector[ptin][lN][lPow](fQvector[ptin][lN][lPow].Re() + qcos, fQvector[ptin][lN][lPow].Im() + qsin); //+=TComplex(qcos,qsin);
+    const int lOffset = fHarOffset[lN];
+    const int lNPow = PW(lN);
+    for (int lPow = 0; lPow < lNPow; lPow++) {
+      lRe[lOffset + lPow] += lPowers[lPow] * lCos;
+      lIm[lOffset + lPow] += lPowers[lPow] * lSin;
     };
+    const double lCosNext = lCos * lCos1 - lSin * lSin1;
+    lSin = lSin * lCos1 + lCos * lSin1;
+    lCos = lCosNext;
   };
   Inc();
 };
+void GFWCumulant::FillArrays(const double* eta, const int* ptin, const double* phi, const double* weight, int n)
+{
+  for (int i = 0; i < n; i++)
+    FillArray(eta[i], ptin ? ptin[i] : 0, phi[i], weight ? weight[i] : 1.);
+};
 void GFWCumulant::ResetQs()
 {
   if (!fNEntries)
     return; // If 0 entries, then no need to reset. Otherwise, if -1, then just initialized and need to set to 0.
-  for (int i = 0; i < fPt; i++) {
+  for (int i = 0; i < fPt; i++)
     fFilledPts[i] = kFALSE;
-    for (int lN = 0; lN < fN; lN++) {
-      for (int lPow = 0; lPow < PW(lN); lPow++) {
-        fQvector[i][lN][lPow](0., 0.);
-      };
-    };
-  };
+  std::fill(fQRe.begin(), fQRe.end(), 0.);
+  std::fill(fQIm.begin(), fQIm.end(), 0.);
   fNEntries = 0;
 };
 void GFWCumulant::DestroyComplexVectorArray()
 {
   if (!fInitialized)
     return;
-  for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      delete[] fQvector[i][l_n];
-    };
-  };
-  for (int i = 0; i < fPt; i++) {
-    delete[] fQvector[i];
-  };
-  delete[] fQvector;
+  fQRe.clear();
+  fQIm.clear();
+  fHarOffset.clear();
+  fNQ = 0;
   delete[] fFilledPts;
   fInitialized = kFALSE;
   fNEntries = -1;
@@ -100,15 +105,17 @@ void GFWCumulant::CreateComplexVectorArrayVarPower(int N, vector<int> PowVec, in
   fPt = Pt;
   fFilledPts = new bool[Pt];
   fPowVec = PowVec;
-  fQvector = new TComplex**[fPt];
-  for (int i = 0; i < fPt; i++) {
-    fQvector[i] = new TComplex*[fN];
-  };
+  int lMaxPow = 1;
+  fHarOffset.resize(fN);
+  fNQ = 0;
   for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      fQvector[i][l_n] = new TComplex[PW(l_n)];
-    };
+    fHarOffset[l_n] = fNQ;
+    fNQ += PW(l_n);
+    lMaxPow = std::max(lMaxPow, PW(l_n));
   };
+  fQRe.assign(fPt * fNQ, 0.);
+  fQIm.assign(fPt * fNQ, 0.);
+  fWgtPowers.assign(lMaxPow, 1.);
   ResetQs();
   fInitialized = kTRUE;
 };
@@ -119,6 +126,6 @@ TComplex GFWCumulant::Vec(int n, int p, int ptbin)
   if (ptbin >= fPt || ptbin < 0)
     ptbin = 0;
   if (n >= 0)
-    return fQvector[ptbin][n][p];
-  return TComplex::Conjugate(fQvector[ptbin][-n][p]);
+    return TComplex(fQRe[QIndex(ptbin, n, p)], fQIm[QIndex(ptbin, n, p)]);
+  return TComplex(fQRe[QIndex(ptbin, -n, p)], -fQIm[QIndex(ptbin, -n, p)]);
 };
\ No newline at end of file
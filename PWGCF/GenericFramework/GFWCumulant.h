@@ -15,6 +15,7 @@
 #include "TNamed.h"
 #include "TMath.h"
 #include "TAxis.h"
+#include <vector>
 using std::vector;
 class GFWCumulant
 {
@@ -23,6 +24,7 @@ class GFWCumulant
   ~GFWCumulant();
   void ResetQs();
   void FillArray(double eta, int ptin, double phi, double weight = 1, double SecondWeight = -1);
+  void FillArrays(const double* eta, const int* ptin, const double* phi, const double* weight, int n); // ptin and weight can be null (pT bin 0, unit weights)
   enum UsedFlags_t { kBlank = 0,
                      kFull = 1,
                      kPt = 2 };
@@ -34,7 +36,12 @@ class GFWCumulant
   void Inc() { fNEntries++; };
   int GetN() { return fNEntries; };
   // protected:
-  TComplex*** fQvector;
+  vector<double> fQRe;       //! Real parts of the Q-vectors, contiguous in pT bin, harmonic and power, see QIndex
+  vector<double> fQIm;       //! Imaginary parts of the Q-vectors
+  vector<int> fHarOffset;    //! Index of the first power of each harmonic within a pT bin
+  int fNQ;                   //! Number of Q-vectors per pT bin
+  vector<double> fWgtPowers; //! Powers of the weight of the particle being filled
+  int QIndex(int ptbin, int n, int p) { return ptbin * fNQ + fHarOffset[n] + p; };
   unsigned int fUsed;
   int fNEntries;
   // Q-vectors. Could be done recursively, but maybe defining each one of them explicitly is easier to read
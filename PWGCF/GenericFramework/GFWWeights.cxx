@@ -11,6 +11,7 @@
 
 #include "GFWWeights.h"
 #include "TMath.h"
+#include <algorithm>
 GFWWeights::GFWWeights() : fDataFilled(kFALSE),
                            fMCFilled(kFALSE),
                            fW_data(0),
@@ -20,7 +21,8 @@ GFWWeights::GFWWeights() : fDataFilled(kFALSE),
                            fIntEff(0),
                            fAccInt(0),
                            fNbinsPt(0),
-                           fbinsPt(0){};
+                           fbinsPt(0),
+                           fFillHist{0, 0, 0} {};
 GFWWeights::~GFWWeights()
 {
   delete fW_data;
@@ -76,6 +78,10 @@ void GFWWeights::Init(bool AddData, bool AddMC)
 
 void GFWWeights::Fill(double phi, double eta, double vz, double pt, double cent, int htype, double weight)
 {
+  if (htype >= 0 && htype < 3 && fFillHist[htype]) {
+    fFillHist[htype]->Fill(htype ? pt : phi, eta, vz, weight);
+    return;
+  };
   TObjArray* tar = 0;
   const char* pf = "";
   if (htype == 0) {
@@ -98,6 +104,7 @@ void GFWWeights::Fill(double phi, double eta, double vz, double pt, double cent,
       tar->Add(new TH3D(GetBinName(0, 0, pf), ";#varphi;#eta;v_{z}", 60, 0, TMath::TwoPi(), 64, -1.6, 1.6, 40, -10, 10)); // 0,0 since all integrated
     th3 = (TH3D*)tar->At(tar->GetEntries() - 1);
   };
+  fFillHist[htype] = th3;
   th3->Fill(htype ? pt : phi, eta, vz, weight);
 };
 double GFWWeights::GetWeight(double phi, double eta, double vz, double pt, double cent, int htype)
@@ -131,27 +138,75 @@ double GFWWeights::GetWeight(double phi, double eta, double vz, double pt, doubl
 };
 double GFWWeights::GetNUA(double phi, double eta, double vz)
 {
-  if (!fAccInt)
+  if (!fAccMap.IsBuilt())
     CreateNUA();
-  int xind = fAccInt->GetXaxis()->FindBin(phi);
-  int etaind = fAccInt->GetYaxis()->FindBin(eta);
-  int vzind = fAccInt->GetZaxis()->FindBin(vz);
-  double weight = fAccInt->GetBinContent(xind, etaind, vzind);
-  if (weight != 0)
-    return 1. / weight;
-  return 1;
+  if (!fAccMap.IsBuilt())
+    return 1;
+  return fAccMap.Get(phi, eta, vz);
 }
 double GFWWeights::GetNUE(double pt, double eta, double vz)
 {
-  if (!fEffInt)
+  if (!fEffMap.IsBuilt())
     CreateNUE();
-  int xind = fEffInt->GetXaxis()->FindBin(pt);
-  int etaind = fEffInt->GetYaxis()->FindBin(eta);
-  int vzind = fEffInt->GetZaxis()->FindBin(vz);
-  double weight = fEffInt->GetBinContent(xind, etaind, vzind);
-  if (weight != 0)
-    return 1. / weight;
-  return 1;
+  if (!fEffMap.IsBuilt())
+    return 1;
+  return fEffMap.Get(pt, eta, vz);
+}
+void GFWWeights::GetNUA(int n, const float* phi, const float* eta, double vz, float* weights)
+{
+  if (!fAccMap.IsBuilt())
+    CreateNUA();
+  if (!fAccMap.IsBuilt()) {
+    std::fill(weights, weights + n, 1.f);
+    return;
+  };
+  for (int i = 0; i < n; i++)
+    weights[i] = fAccMap.Get(phi[i], eta[i], vz);
+}
+void GFWWeights::GetNUE(int n, const float* pt, const float* eta, double vz, float* weights)
+{
+  if (!fEffMap.IsBuilt())
+    CreateNUE();
+  if (!fEffMap.IsBuilt()) {
+    std::fill(weights, weights + n, 1.f);
+    return;
+  };
+  for (int i = 0; i < n; i++)
+    weights[i] = fEffMap.Get(pt[i], eta[i], vz);
+}
+int GFWWeights::WeightMap::Axis::FindBin(double v) const
+{
+  // same bin as TAxis::FindBin, 0 for the underflow and fN + 1 for the overflow
+  if (!(v >= fMin))
+    return 0;
+  if (v >= fMax)
+    return fN + 1;
+  if (fEdges.empty()) {
+    int bin = 1 + static_cast<int>((v - fMin) * fScale);
+    return bin > fN ? fN : bin;
+  };
+  return std::upper_bound(fEdges.begin(), fEdges.end(), v) - fEdges.begin();
+}
+void GFWWeights::WeightMap::Build(TH3D* inh)
+{
+  TAxis* axes[3] = {inh->GetXaxis(), inh->GetYaxis(), inh->GetZaxis()};
+  for (int i = 0; i < 3; i++) {
+    Axis& axis = fAxes[i];
+    axis.fN = axes[i]->GetNbins();
+    axis.fMin = axes[i]->GetXmin();
+    axis.fMax = axes[i]->GetXmax();
+    axis.fScale = axis.fN / (axis.fMax - axis.fMin);
+    axis.fEdges.clear();
+    if (axes[i]->GetXbins()->GetSize() > 0)
+      axis.fEdges.assign(axes[i]->GetXbins()->GetArray(), axes[i]->GetXbins()->GetArray() + axis.fN + 1);
+  };
+  fWeights.resize((fAxes[0].fN + 2) * (fAxes[1].fN + 2) * (fAxes[2].fN + 2));
+  for (int k = 0; k <= fAxes[2].fN + 1; k++)
+    for (int j = 0; j <= fAxes[1].fN + 1; j++)
+      for (int i = 0; i <= fAxes[0].fN + 1; i++) {
+        double weight = inh->GetBinContent(i, j, k);
+        fWeights[(k * (fAxes[1].fN + 2) + j) * (fAxes[0].fN + 2) + i] = weight != 0 ? 1. / weight : 1.;
+      };
 }
 double GFWWeights::FindMax(TH3D* inh, int& ix, int& iy, int& iz)
 {
@@ -181,6 +236,7 @@ void GFWWeights::MCToEfficiency()
     hr->Divide(hg);
   };
   fW_mcgen->Clear();
+  fFillHist[2] = 0;
 };
 void GFWWeights::RebinNUA(int nX, int nY, int nZ)
 {
@@ -225,6 +281,7 @@ void GFWWeights::CreateNUA(bool IntegrateOverCentAndPt)
       fAccInt->GetZaxis()->SetRange(1, fAccInt->GetNbinsZ());
     };
     fAccInt->GetYaxis()->SetRange(1, fAccInt->GetNbinsY());
+    fAccMap.Build(fAccInt);
     return;
   };
 };
@@ -266,6 +323,7 @@ void GFWWeights::CreateNUE(bool IntegrateOverCentrality)
     den->RebinZ(5);
     fEffInt = (TH3D*)num->Clone("Efficiency_Integrated");
     fEffInt->Divide(den);
+    fEffMap.Build(fEffInt);
     return;
   };
 };
@@ -348,6 +406,9 @@ void GFWWeights::OverwriteNUA()
   delete trash;
   fW_data->Add((TH3D*)fAccInt->Clone(ts.Data()));
   delete fAccInt;
+  fAccInt = 0;
+  fAccMap.Clear();
+  fFillHist[0] = 0;
 }
 Long64_t GFWWeights::Merge(TCollection* collist)
 {
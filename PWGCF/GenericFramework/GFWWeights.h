@@ -19,6 +19,7 @@
 #include "TFile.h"
 #include "TCollection.h"
 #include "TString.h"
+#include <vector>
 
 class GFWWeights : public TNamed
 {
@@ -30,6 +31,8 @@ class GFWWeights : public TNamed
   double GetWeight(double phi, double eta, double vz, double pt, double cent, int htype);             // htype: 0 for data, 1 for mc rec, 2 for mc gen
   double GetNUA(double phi, double eta, double vz);                                                   // This just fetches correction from integrated NUA, should speed up
   double GetNUE(double pt, double eta, double vz);                                                    // fetches weight from fEffInt
+  void GetNUA(int n, const float* phi, const float* eta, double vz, float* weights);                  // NUA weights of n tracks of an event
+  void GetNUE(int n, const float* pt, const float* eta, double vz, float* weights);                   // NUE weights of n tracks of an event
   bool IsDataFilled() { return fDataFilled; };
   bool IsMCFilled() { return fMCFilled; };
   double FindMax(TH3D* inh, int& ix, int& iy, int& iz);
@@ -53,16 +56,44 @@ class GFWWeights : public TNamed
   TH1D* GetEfficiency(double etamin, double etamax, double vzmin, double vzmax);
 
  private:
+  // Inverse bin contents of a TH3D in a contiguous array, including under- and overflow bins, so that a weight is
+  // looked up with arithmetic bin indexing on uniform axes instead of TAxis::FindBin and TH3::GetBinContent
+  class WeightMap
+  {
+   public:
+    void Build(TH3D* inh);
+    void Clear() { fWeights.clear(); };
+    bool IsBuilt() const { return !fWeights.empty(); };
+    float Get(double x, double y, double z) const
+    {
+      return fWeights[(fAxes[2].FindBin(z) * (fAxes[1].fN + 2) + fAxes[1].FindBin(y)) * (fAxes[0].fN + 2) + fAxes[0].FindBin(x)];
+    };
+
+   private:
+    struct Axis {
+      int fN = 0;
+      double fMin = 0;
+      double fMax = 0;
+      double fScale = 0;          // number of bins per unit, for uniform axes
+      std::vector<double> fEdges; // bin edges, for variable axes only
+      int FindBin(double v) const;
+    };
+    Axis fAxes[3];
+    std::vector<float> fWeights;
+  };
   bool fDataFilled;
   bool fMCFilled;
   TObjArray* fW_data;
   TObjArray* fW_mcrec;
   TObjArray* fW_mcgen;
-  TH3D* fEffInt;   //!
-  TH1D* fIntEff;   //!
-  TH3D* fAccInt;   //!
-  int fNbinsPt;    //! do not store
-  double* fbinsPt; //! do not store
+  TH3D* fEffInt;      //!
+  TH1D* fIntEff;      //!
+  TH3D* fAccInt;      //!
+  int fNbinsPt;       //! do not store
+  double* fbinsPt;    //! do not store
+  WeightMap fAccMap;  //! compiled fAccInt
+  WeightMap fEffMap;  //! compiled fEffInt
+  TH3D* fFillHist[3]; //! histogram filled for each htype, cached to avoid the name lookup in Fill
   void AddArray(TObjArray* targ, TObjArray* sour);
   const char* GetBinName(double ptv, double v0mv, const char* pf = "")
   {
@@ -126,6 +126,18 @@ void JFFlucAnalysis::Init()
   //
 }
 //________________________________________________________________________
+void JFFlucAnalysis::SetQvectorsQC(const double* re, const double* im, const double* reGap, const double* imGap)
+{
+  for (UInt_t ih = 0; ih < kNH; ih++) {
+    for (UInt_t ik = 0; ik < nKL; ik++) {
+      UInt_t i = ih * nKL + ik;
+      QvectorQC[ih][ik] = TComplex(re[i], im[i]);
+      for (UInt_t isub = 0; isub < 2; isub++)
+        QvectorQCgap[isub][ih][ik] = TComplex(reGap[isub * kNH * nKL + i], imGap[isub * kNH * nKL + i]);
+    }
+  }
+}
+//________________________________________________________________________
 void JFFlucAnalysis::UserCreateOutputObjects()
 {
   fHMG = new JHistManager("JFFlucHistManager", "jfluc");
@@ -141,7 +153,7 @@ void JFFlucAnalysis::UserCreateOutputObjects()
   fHistCentBin.Set("CentBin", "CentBin", "Cent:%d", JBin::kSingle).SetBin(numBins);
 
   fVertexBin.Set("Vtx", "Vtx", "Vtx:%d", JBin::kSingle).SetBin(3);
-  fCorrBin.Set("C", "C", "C:%d", JBin::kSingle).SetBin(28);
+  fCorrBin.Set("C", "C", "C:%d", JBin::kSingle).SetBin(kNCorr);
 
   fBin_Nptbins.Set("PtBin", "PtBin", "Pt:%d", JBin::kSingle).SetBin(N_ptbins);
 
@@ -291,6 +303,8 @@ void JFFlucAnalysis::UserCreateOutputObjects()
     << "END"; // fBin_h > not stand for harmonics, only for v2, v3, v4, v5*/
   // JTH1D set done.
 
+  fCentBinHistograms.assign(numBins, CentBinHistograms());
+
   fHMG->Print();
   // fHMG->WriteConfig();
 }
@@ -353,15 +367,23 @@ TComplex JFFlucAnalysis::Four(int n1, int n2, int n3, int n4)
 //________________________________________________________________________
 void JFFlucAnalysis::UserExec(Option_t*)
 {
+  CentBinHistograms& hists = fCentBinHistograms[fCBin];
   for (UInt_t ih = 2; ih < kNH; ih++) {
-    fh_cos_n_phi[ih][fCBin]->Fill(QvectorQC[ih][1].Re() / QvectorQC[0][1].Re());
-    fh_sin_n_phi[ih][fCBin]->Fill(QvectorQC[ih][1].Im() / QvectorQC[0][1].Re());
+    if (!hists.cos_n_phi[ih]) {
+      hists.cos_n_phi[ih] = fh_cos_n_phi[ih][fCBin];
+      hists.sin_n_phi[ih] = fh_sin_n_phi[ih][fCBin];
+      hists.psi_n[ih] = fh_psi_n[ih][fCBin];
+      hists.cos_n_psi_n[ih] = fh_cos_n_psi_n[ih][fCBin];
+      hists.sin_n_psi_n[ih] = fh_sin_n_psi_n[ih][fCBin];
+    }
+    hists.cos_n_phi[ih]->Fill(QvectorQC[ih][1].Re() / QvectorQC[0][1].Re());
+    hists.sin_n_phi[ih]->Fill(QvectorQC[ih][1].Im() / QvectorQC[0][1].Re());
     //
     //
     Double_t psi = QvectorQC[ih][1].Theta();
-    fh_psi_n[ih][fCBin]->Fill(psi);
-    fh_cos_n_psi_n[ih][fCBin]->Fill(TMath::Cos((Double_t)ih * psi));
-    fh_sin_n_psi_n[ih][fCBin]->Fill(TMath::Sin((Double_t)ih * psi));
+    hists.psi_n[ih]->Fill(psi);
+    hists.cos_n_psi_n[ih]->Fill(TMath::Cos((Double_t)ih * psi));
+    hists.sin_n_psi_n[ih]->Fill(TMath::Sin((Double_t)ih * psi));
   }
 
   Double_t vn2[kNH][nKL];
@@ -438,12 +460,19 @@ void JFFlucAnalysis::UserExec(Option_t*)
     for (UInt_t ih = 2; ih < kNH; ih++) {
       for (UInt_t ik = 1; ik < nKL; ik++) { // 2k(0) =1, 2k(1) =2, 2k(2)=4....
         vn2[ih][ik] = corr[ih][ik].Re() / ref_2Np[ik - 1];
-        fh_vn[ih][ik][fCBin]->Fill(vn2[ih][ik], ebe_2Np_weight[ik - 1]);
-        fh_vna[ih][ik][fCBin]->Fill(ncorr[ih][ik].Re() / ref_2Np[ik - 1], ebe_2Np_weight[ik - 1]);
+        if (!hists.vn[ih][ik]) {
+          hists.vn[ih][ik] = fh_vn[ih][ik][fCBin];
+          hists.vna[ih][ik] = fh_vna[ih][ik][fCBin];
+        }
+        hists.vn[ih][ik]->Fill(vn2[ih][ik], ebe_2Np_weight[ik - 1]);
+        hists.vna[ih][ik]->Fill(ncorr[ih][ik].Re() / ref_2Np[ik - 1], ebe_2Np_weight[ik - 1]);
         for (UInt_t ihh = 2; ihh < kcNH; ihh++) {
           for (UInt_t ikk = 1; ikk < nKL; ikk++) {
             vn2_vn2[ih][ik][ihh][ikk] = ncorr2[ih][ik][ihh][ikk] / ref_2Np[ik + ikk - 1];
-            fh_vn_vn[ih][ik][ihh][ikk][fCBin]->Fill(vn2_vn2[ih][ik][ihh][ikk], ebe_2Np_weight[ik + ikk - 1]);
+            TH1D*& h = hists.vn_vn[ih][ik][ihh][ikk];
+            if (!h)
+              h = fh_vn_vn[ih][ik][ihh][ikk][fCBin];
+            h->Fill(vn2_vn2[ih][ik][ihh][ikk], ebe_2Np_weight[ik + ikk - 1]);
           }
         }
       }
@@ -482,41 +511,48 @@ void JFFlucAnalysis::UserExec(Option_t*)
     TComplex nV5V5V3V3 = FourGap22(pQq, i, 5, 3, 5, 3) / ref_4p;
     TComplex nV4V4V3V3 = FourGap22(pQq, i, 4, 3, 4, 3) / ref_4p;
 
-    fh_correlator[0][fCBin]->Fill(V4V2starv2_2.Re());
-    fh_correlator[1][fCBin]->Fill(V4V2starv2_4.Re());
-    fh_correlator[2][fCBin]->Fill(V4V2star_2.Re(), ebe_3p_weight); // added 2015.3.18
-    fh_correlator[3][fCBin]->Fill(V5V2starV3starv2_2.Re());
-    fh_correlator[4][fCBin]->Fill(V5V2starV3star.Re(), ebe_3p_weight);
-    fh_correlator[5][fCBin]->Fill(V5V2starV3startv3_2.Re());
-    fh_correlator[6][fCBin]->Fill(V6V2star_3.Re(), ebe_4p_weightB);
-    fh_correlator[7][fCBin]->Fill(V6V3star_2.Re(), ebe_3p_weight);
-    fh_correlator[8][fCBin]->Fill(V7V2star_2V3star.Re(), ebe_4p_weightB);
-
-    fh_correlator[9][fCBin]->Fill(nV4V2star_2.Re(), ebe_3p_weight); // added 2015.6.10
-    fh_correlator[10][fCBin]->Fill(nV5V2starV3star.Re(), ebe_3p_weight);
-    fh_correlator[11][fCBin]->Fill(nV6V3star_2.Re(), ebe_3p_weight);
-
-    // use this to avoid self-correlation 4p correlation (2 particles from A, 2 particles from B) -> MA(MA-1)MB(MB-1) : evt weight..
-    fh_correlator[12][fCBin]->Fill(nV4V4V2V2.Re(), ebe_2Np_weight[1]);
-    fh_correlator[13][fCBin]->Fill(nV3V3V2V2.Re(), ebe_2Np_weight[1]);
-
-    fh_correlator[14][fCBin]->Fill(nV5V5V2V2.Re(), ebe_2Np_weight[1]);
-    fh_correlator[15][fCBin]->Fill(nV5V5V3V3.Re(), ebe_2Np_weight[1]);
-    fh_correlator[16][fCBin]->Fill(nV4V4V3V3.Re(), ebe_2Np_weight[1]);
-
-    // higher order correlators, added 2017.8.10
-    fh_correlator[17][fCBin]->Fill(V8V2starV3star_2.Re(), ebe_4p_weightB);
-    fh_correlator[18][fCBin]->Fill(V8V2star_4.Re()); // 5p weight
-    fh_correlator[19][fCBin]->Fill(nV6V2star_3.Re(), ebe_4p_weightB);
-    fh_correlator[20][fCBin]->Fill(nV7V2star_2V3star.Re(), ebe_4p_weightB);
-    fh_correlator[21][fCBin]->Fill(nV8V2starV3star_2.Re(), ebe_4p_weightB);
-
-    fh_correlator[22][fCBin]->Fill(V6V2starV4star.Re(), ebe_3p_weight);
-    fh_correlator[23][fCBin]->Fill(V7V2starV5star.Re(), ebe_3p_weight);
-    fh_correlator[24][fCBin]->Fill(V7V3starV4star.Re(), ebe_3p_weight);
-    fh_correlator[25][fCBin]->Fill(nV6V2starV4star.Re(), ebe_3p_weight);
-    fh_correlator[26][fCBin]->Fill(nV7V2starV5star.Re(), ebe_3p_weight);
-    fh_correlator[27][fCBin]->Fill(nV7V3starV4star.Re(), ebe_3p_weight);
+    // value and weight of each correlator of fh_correlator
+    const Double_t correlators[kNCorr][2] = {
+      {V4V2starv2_2.Re(), 1.0},
+      {V4V2starv2_4.Re(), 1.0},
+      {V4V2star_2.Re(), ebe_3p_weight}, // added 2015.3.18
+      {V5V2starV3starv2_2.Re(), 1.0},
+      {V5V2starV3star.Re(), ebe_3p_weight},
+      {V5V2starV3startv3_2.Re(), 1.0},
+      {V6V2star_3.Re(), ebe_4p_weightB},
+      {V6V3star_2.Re(), ebe_3p_weight},
+      {V7V2star_2V3star.Re(), ebe_4p_weightB},
+
+      {nV4V2star_2.Re(), ebe_3p_weight}, // added 2015.6.10
+      {nV5V2starV3star.Re(), ebe_3p_weight},
+      {nV6V3star_2.Re(), ebe_3p_weight},
+
+      // use this to avoid self-correlation 4p correlation (2 particles from A, 2 particles from B) -> MA(MA-1)MB(MB-1) : evt weight..
+      {nV4V4V2V2.Re(), ebe_2Np_weight[1]},
+      {nV3V3V2V2.Re(), ebe_2Np_weight[1]},
+
+      {nV5V5V2V2.Re(), ebe_2Np_weight[1]},
+      {nV5V5V3V3.Re(), ebe_2Np_weight[1]},
+      {nV4V4V3V3.Re(), ebe_2Np_weight[1]},
+
+      // higher order correlators, added 2017.8.10
+      {V8V2starV3star_2.Re(), ebe_4p_weightB},
+      {V8V2star_4.Re(), 1.0}, // 5p weight
+      {nV6V2star_3.Re(), ebe_4p_weightB},
+      {nV7V2star_2V3star.Re(), ebe_4p_weightB},
+      {nV8V2starV3star_2.Re(), ebe_4p_weightB},
+
+      {V6V2starV4star.Re(), ebe_3p_weight},
+      {V7V2starV5star.Re(), ebe_3p_weight},
+      {V7V3starV4star.Re(), ebe_3p_weight},
+      {nV6V2starV4star.Re(), ebe_3p_weight},
+      {nV7V2starV5star.Re(), ebe_3p_weight},
+      {nV7V3starV4star.Re(), ebe_3p_weight}};
+    for (UInt_t ic = 0; ic < kNCorr; ic++) {
+      if (!hists.correlator[ic])
+        hists.correlator[ic] = fh_correlator[ic][fCBin];
+      hists.correlator[ic]->Fill(correlators[ic][0], correlators[ic][1]);
+    }
   }
 
   enum { kSubA,
@@ -536,14 +572,20 @@ void JFFlucAnalysis::UserExec(Option_t*)
     for (UInt_t ihh = 2, mm = (ih < kcNH ? ih : kcNH); ihh < mm; ihh++) {
       TComplex scfour = Four(ih, ihh, -ih, -ihh) / Four(0, 0, 0, 0).Re();
 
-      fh_SC_with_QC_4corr[ih][ihh][fCBin]->Fill(scfour.Re(), event_weight_four);
+      if (!hists.SC_with_QC_4corr[ih][ihh])
+        hists.SC_with_QC_4corr[ih][ihh] = fh_SC_with_QC_4corr[ih][ihh][fCBin];
+      hists.SC_with_QC_4corr[ih][ihh]->Fill(scfour.Re(), event_weight_four);
     }
 
+    if (!hists.SC_with_QC_2corr[ih]) {
+      hists.SC_with_QC_2corr[ih] = fh_SC_with_QC_2corr[ih][fCBin];
+      hists.SC_with_QC_2corr_gap[ih] = fh_SC_with_QC_2corr_gap[ih][fCBin];
+    }
     TComplex sctwo = Two(ih, -ih) / Two(0, 0).Re();
-    fh_SC_with_QC_2corr[ih][fCBin]->Fill(sctwo.Re(), event_weight_two);
+    hists.SC_with_QC_2corr[ih]->Fill(sctwo.Re(), event_weight_two);
 
     TComplex sctwoGap = (QvectorQCgap[kSubA][ih][1] * TComplex::Conjugate(QvectorQCgap[kSubB][ih][1])) / (QvectorQCgap[kSubA][0][1] * QvectorQCgap[kSubB][0][1]).Re();
-    fh_SC_with_QC_2corr_gap[ih][fCBin]->Fill(sctwoGap.Re(), event_weight_two_gap);
+    hists.SC_with_QC_2corr_gap[ih]->Fill(sctwoGap.Re(), event_weight_two_gap);
   }
 }
 
@@ -17,6 +17,7 @@
 
 #include "JHistManager.h"
 #include <TComplex.h>
+#include <vector>
 
 class JFFlucAnalysis
 {
@@ -84,13 +85,7 @@ class JFFlucAnalysis
   template <class JInputClass>
   inline void FillQA(JInputClass& inputInst)
   {
-    fh_ntracks[fCBin]->Fill(inputInst.size());
-    fh_ImpactParameter->Fill(fImpactParameter);
-    fh_cent->Fill(fCent);
-
-    fh_TrkQA_TPCvsCent->Fill(fCent, fTPCtrks);
-    fh_TrkQA_TPCvsGlob->Fill(fGlbtrks, fTPCtrks);
-    fh_TrkQA_FB32_vs_FB32TOF->Fill(fFB32trks, fFB32TOFtrks);
+    FillEventQA(inputInst.size());
 
     for (auto& track : inputInst) {
       if (!(flags & kFlucPhiCorrection)) {
@@ -108,6 +103,18 @@ class JFFlucAnalysis
       fh_pt[fCBin]->Fill(track.pt(), effCorrInv);
       fh_phi[fCBin][(UInt_t)(track.eta() > 0.0)]->Fill(track.phi(), effCorrInv / phiNUACorr);
     }
+  };
+
+  // event QA, the part of FillQA available without the tracks
+  inline void FillEventQA(UInt_t ntracks)
+  {
+    fh_ntracks[fCBin]->Fill(ntracks);
+    fh_ImpactParameter->Fill(fImpactParameter);
+    fh_cent->Fill(fCent);
+
+    fh_TrkQA_TPCvsCent->Fill(fCent, fTPCtrks);
+    fh_TrkQA_TPCvsGlob->Fill(fGlbtrks, fTPCtrks);
+    fh_TrkQA_FB32_vs_FB32TOF->Fill(fFB32trks, fFB32TOFtrks);
 
     for (UInt_t iaxis = 0; iaxis < 3; iaxis++)
       fh_vertex[iaxis]->Fill(fVertex[iaxis]);
@@ -117,36 +124,9 @@ class JFFlucAnalysis
   inline void CalculateQvectorsQC(JInputClass& inputInst)
   {
     // calculate Q-vector for QC method ( no subgroup )
-    for (UInt_t ih = 0; ih < kNH; ih++) {
-      for (UInt_t ik = 0; ik < nKL; ++ik) {
-        QvectorQC[ih][ik] = TComplex(0, 0);
-        for (UInt_t isub = 0; isub < 2; isub++)
-          QvectorQCgap[isub][ih][ik] = TComplex(0, 0);
-      }
-    } // for max harmonics
-    for (auto& track : inputInst) {
-      // pt cuts already applied in task.
-      if (track.eta() < -fEta_max || track.eta() > fEta_max)
-        continue;
-
-      Double_t effCorr = 1.0;    // itrack->GetTrackEff();//fEfficiency->GetCorrection( track.pt(), fEffFilterBit, fCent); //XXXXXX
-      Double_t phiNUACorr = 1.0; // itrack->GetWeight(); //XXXXXX
-
-      UInt_t isub = (UInt_t)(track.eta() > 0.0);
-      for (UInt_t ih = 0; ih < kNH; ih++) {
-        Double_t tf = 1.0;
-        TComplex q[nKL];
-        for (UInt_t ik = 0; ik < nKL; ik++) {
-          q[ik] = TComplex(tf * TMath::Cos(ih * track.phi()), tf * TMath::Sin(ih * track.phi()));
-          QvectorQC[ih][ik] += q[ik];
-
-          if (TMath::Abs(track.eta()) > fEta_min)
-            QvectorQCgap[isub][ih][ik] += q[ik];
-
-          tf *= 1.0 / (phiNUACorr * effCorr);
-        }
-      }
-    }
+    ResetQvectorsQC(QvectorQC, QvectorQCgap);
+    for (auto& track : inputInst)
+      AddToQvectorsQC(track.eta(), track.phi(), fEta_min, fEta_max, QvectorQC, QvectorQCgap);
   };
 
   static Double_t pttJacek[74];
@@ -173,7 +153,76 @@ class JFFlucAnalysis
          kK4,
          nKL };  // order
 #define kcNH kH6 // max second dimension + 1
+  enum { kNCorr = 28 }; // number of correlators in fh_correlator
+
+  static inline void ResetQvectorsQC(TComplex (&qvector)[kNH][nKL], TComplex (&qvectorGap)[2][kNH][nKL])
+  {
+    for (UInt_t ih = 0; ih < kNH; ih++) {
+      for (UInt_t ik = 0; ik < nKL; ++ik) {
+        qvector[ih][ik] = TComplex(0, 0);
+        for (UInt_t isub = 0; isub < 2; isub++)
+          qvectorGap[isub][ih][ik] = TComplex(0, 0);
+      }
+    } // for max harmonics
+  };
+
+  // adds a track to the Q-vectors of the QC method, shared with the producer of the event-level Q-vectors
+  static inline void AddToQvectorsQC(Double_t eta, Double_t phi, Double_t etaMin, Double_t etaMax, TComplex (&qvector)[kNH][nKL], TComplex (&qvectorGap)[2][kNH][nKL])
+  {
+    // pt cuts already applied in task.
+    if (eta < -etaMax || eta > etaMax)
+      return;
+
+    Double_t effCorr = 1.0;    // itrack->GetTrackEff();//fEfficiency->GetCorrection( track.pt(), fEffFilterBit, fCent); //XXXXXX
+    Double_t phiNUACorr = 1.0; // itrack->GetWeight(); //XXXXXX
+
+    UInt_t isub = (UInt_t)(eta > 0.0);
+    bool isGap = TMath::Abs(eta) > etaMin;
+    Double_t tf[nKL];
+    tf[0] = 1.0;
+    for (UInt_t ik = 1; ik < nKL; ik++)
+      tf[ik] = tf[ik - 1] / (phiNUACorr * effCorr);
+    // cos(ih*phi) and sin(ih*phi) from the angle addition formulas, so phi goes through cos and sin only once
+    const Double_t cos1 = TMath::Cos(phi);
+    const Double_t sin1 = TMath::Sin(phi);
+    Double_t cosn = 1.0;
+    Double_t sinn = 0.0;
+    for (UInt_t ih = 0; ih < kNH; ih++) {
+      for (UInt_t ik = 0; ik < nKL; ik++) {
+        TComplex q(tf[ik] * cosn, tf[ik] * sinn);
+        qvector[ih][ik] += q;
+
+        if (isGap)
+          qvectorGap[isub][ih][ik] += q;
+      }
+      const Double_t cosNext = cosn * cos1 - sinn * sin1;
+      sinn = sinn * cos1 + cosn * sin1;
+      cosn = cosNext;
+    }
+  };
+
+  // sets the Q-vectors of the QC method from their real and imaginary parts, [ih][ik] and [isub][ih][ik] flattened
+  void SetQvectorsQC(const double* re, const double* im, const double* reGap, const double* imGap);
+
  private:
+  // Histograms of the JTH1 arrays filled in UserExec, for one centrality bin.
+  // They are resolved from the arrays on their first fill and reused afterwards.
+  struct CentBinHistograms {
+    TH1D* cos_n_phi[kNH] = {};
+    TH1D* sin_n_phi[kNH] = {};
+    TH1D* psi_n[kNH] = {};
+    TH1D* cos_n_psi_n[kNH] = {};
+    TH1D* sin_n_psi_n[kNH] = {};
+    TH1D* vn[kNH][nKL] = {};
+    TH1D* vna[kNH][nKL] = {};
+    TH1D* vn_vn[kNH][nKL][kcNH][nKL] = {};
+    TH1D* correlator[kNCorr] = {};
+    TH1D* SC_with_QC_4corr[kNH][kcNH] = {};
+    TH1D* SC_with_QC_2corr[kNH] = {};
+    TH1D* SC_with_QC_2corr_gap[kNH] = {};
+  };
+  std::vector<CentBinHistograms> fCentBinHistograms; //! [numBins]
+
   const Double_t* fVertex; //!
   Float_t fCent;
   Float_t fImpactParameter;
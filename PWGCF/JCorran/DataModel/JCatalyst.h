@@ -14,6 +14,8 @@
 #ifndef JFLUC_CATALYST_H
 #define JFLUC_CATALYST_H
 
+static constexpr int jflucNQvectors = 13 * 5; // harmonics x powers of the QC Q-vectors, JFFlucAnalysis::kNH x JFFlucAnalysis::nKL
+
 namespace o2::aod
 {
 namespace particleTrack
@@ -33,6 +35,15 @@ DECLARE_SOA_COLUMN(Cent, cent, float); //! Collision centrality
 DECLARE_SOA_COLUMN(CBin, cbin, Int_t); //! Centrality bin
 } // namespace collisionData
 
+namespace collisionQvectors
+{
+DECLARE_SOA_COLUMN(NTracks, ntracks, int);                      //! Number of tracks entering the Q-vectors, 0 for rejected events
+DECLARE_SOA_COLUMN(QRe, qRe, double[jflucNQvectors]);           //! Re(Q) [ih][ik]
+DECLARE_SOA_COLUMN(QIm, qIm, double[jflucNQvectors]);           //! Im(Q) [ih][ik]
+DECLARE_SOA_COLUMN(QGapRe, qGapRe, double[2 * jflucNQvectors]); //! Re(Q) of the eta-gap subevents [isub][ih][ik]
+DECLARE_SOA_COLUMN(QGapIm, qGapIm, double[2 * jflucNQvectors]); //! Im(Q) of the eta-gap subevents [isub][ih][ik]
+} // namespace collisionQvectors
+
 DECLARE_SOA_TABLE(ParticleTrack, "AOD", "PARTICLETRACK",
                   particleTrack::CollisionId,
                   particleTrack::Pt, particleTrack::Eta, particleTrack::Phi,
@@ -41,6 +52,12 @@ DECLARE_SOA_TABLE(CollisionData, "AOD", "COLLISIONDATA",
                   collisionData::CollisionId,
                   collisionData::Cent,
                   collisionData::CBin);
+DECLARE_SOA_TABLE(CollisionQvectors, "AOD", "COLLISIONQVEC", //! Event Q-vectors, joinable with CollisionData
+                  collisionQvectors::NTracks,
+                  collisionQvectors::QRe,
+                  collisionQvectors::QIm,
+                  collisionQvectors::QGapRe,
+                  collisionQvectors::QGapIm);
 } // namespace o2::aod
 
 static float jflucCentBins[] = {0.0f, 1.0f, 2.0f, 5.0f, 10.0f, 20.0f, 30.0f, 40.0f, 50.0f, 60.0f};
@@ -39,6 +39,10 @@
 #include <TRandom.h>
 
 #include "PWGCF/JCorran/DataModel/JCatalyst.h"
+#include "JFFlucAnalysis.h"
+
+#include <algorithm>
+#include <iterator>
 
 using namespace o2;
 using namespace o2::framework;
@@ -58,6 +62,10 @@ struct JCatalyst {
   O2_DEFINE_CONFIGURABLE(trackingMode, int, 0, "Tracking mode: 0 = global; 1 = hybrid");
   O2_DEFINE_CONFIGURABLE(centEst, int, 0, "Centrality estimator: 0 = V0M; 1 = CL0; 2 = CL1");
   Configurable<bool> cutOutliers{"cutOutliers", false, "Cut outlier events"};
+  O2_DEFINE_CONFIGURABLE(saveTracks, bool, true, "Store the selected tracks in ParticleTrack");
+  O2_DEFINE_CONFIGURABLE(saveQvectors, bool, false, "Store the Q-vectors of each event in CollisionQvectors");
+  O2_DEFINE_CONFIGURABLE(etamin, double, 0.4, "Minimal |eta| of the eta-gap Q-vectors, as in the analysis task");
+  O2_DEFINE_CONFIGURABLE(etamax, double, 0.8, "Maximal |eta| of the Q-vectors, as in the analysis task");
 
   Service<ccdb::BasicCCDBManager> ccdb;
   Configurable<std::string> url{"ccdb-url", "http://ccdb-test.cern.ch:8080", "CCDB repository URL"};
@@ -70,15 +78,39 @@ struct JCatalyst {
 
   Produces<aod::ParticleTrack> particleTrack;
   Produces<aod::CollisionData> collisionData;
+  Produces<aod::CollisionQvectors> collisionQvectors;
+
+  TComplex qvector[JFFlucAnalysis::kNH][JFFlucAnalysis::nKL];
+  TComplex qvectorGap[2][JFFlucAnalysis::kNH][JFFlucAnalysis::nKL];
+  double qRe[jflucNQvectors];
+  double qIm[jflucNQvectors];
+  double qGapRe[2 * jflucNQvectors];
+  double qGapIm[2 * jflucNQvectors];
+  static_assert(JFFlucAnalysis::kNH * JFFlucAnalysis::nKL == jflucNQvectors, "jflucNQvectors does not match the Q-vectors of JFFlucAnalysis");
 
   Int_t GetCentBin(Double_t cent)
   {
-    for (Int_t i = 1, bins = sizeof(jflucCentBins) / sizeof(jflucCentBins[0]);
-         i < bins; ++i) {
-      if (cent < jflucCentBins[i])
-        return i - 1;
+    // first bin edge above cent, the lowest edge is not an upper edge
+    const float* edge = std::upper_bound(std::begin(jflucCentBins) + 1, std::end(jflucCentBins), cent);
+    if (edge == std::end(jflucCentBins))
+      return -1;
+    return edge - std::begin(jflucCentBins) - 1;
+  }
+
+  void WriteQvectors(int ntracks)
+  {
+    for (UInt_t ih = 0; ih < JFFlucAnalysis::kNH; ih++) {
+      for (UInt_t ik = 0; ik < JFFlucAnalysis::nKL; ik++) {
+        UInt_t i = ih * JFFlucAnalysis::nKL + ik;
+        qRe[i] = qvector[ih][ik].Re();
+        qIm[i] = qvector[ih][ik].Im();
+        for (UInt_t isub = 0; isub < 2; isub++) {
+          qGapRe[isub * jflucNQvectors + i] = qvectorGap[isub][ih][ik].Re();
+          qGapIm[isub * jflucNQvectors + i] = qvectorGap[isub][ih][ik].Im();
+        }
+      }
     }
-    return -1;
+    collisionQvectors(ntracks, qRe, qIm, qGapRe, qGapIm);
   }
 
   void init(InitContext const& ic)
@@ -107,27 +139,20 @@ struct JCatalyst {
     }
   }
 
-  void process(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms, aod::CentRun2CL0s, aod::CentRun2CL1s>::iterator const& collision, soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection> const& tracks)
+  template <typename TCollision>
+  bool IsEventSelected(TCollision const& collision, const Double_t* cent, Int_t cbin)
   {
-    Double_t cent[3] = {
-      collision.centRun2V0M(),
-      collision.centRun2CL0(),
-      collision.centRun2CL1()};
-    Int_t cbin = GetCentBin(cent[centEst]);
-
-    collisionData(collision.globalIndex(), cent[centEst], cbin);
-
     if (cbin < 0)
-      return;
+      return false;
     if (!collision.alias()[kINT7] || !collision.sel7())
-      return;
+      return false;
     if (std::abs(collision.posZ()) > zvertex)
-      return;
+      return false;
 
     if (pcentFlatteningMap) {
       Int_t bin = pcentFlatteningMap->GetXaxis()->FindBin(cent[centEst]);
       if (gRandom->Uniform(0, 1) > pcentFlatteningMap->GetBinContent(bin))
-        return;
+        return false;
     }
 
     // TODO: outlier cutting
@@ -137,37 +162,63 @@ struct JCatalyst {
       double center = 0.973488 * centCL0 + 0.0157497;
       double sigma = 0.673612 + centCL0 * (0.0290718 + centCL0 * (-0.000546728 + centCL0 * 5.82749e-06));
       if (cent[0] < center - 5.0 * sigma || cent[0] > center + 5.5 * sigma || cent[0] < 0.0 || cent[0] > 60.0)
-        return;
+        return false;
     }
+    return true;
+  }
 
-    auto bc = collision.bc_as<aod::BCsWithTimestamps>();
-    TH1* pweightMap = pnuaMapList ? (TH1*)pnuaMapList->FindObject(Form("PhiWeights_%u_%02u", bc.runNumber(), cbin)) : 0;
-
-    for (auto& track : tracks) {
-      if (trackingMode == 0 && !track.isGlobalTrack())
-        continue;
-      else if (trackingMode == 1 && !track.isGlobalTrackSDD())
-        continue;
-
-      Double_t pt = track.pt();
-      if (pt < ptmin || pt > ptmax)
-        continue;
-
-      Int_t ch = track.sign();
-      if (charge != 0 && charge * ch < 0)
-        continue;
+  void process(soa::Join<aod::Collisions, aod::EvSels, aod::CentRun2V0Ms, aod::CentRun2CL0s, aod::CentRun2CL1s>::iterator const& collision, soa::Join<aod::Tracks, aod::TracksExtra, aod::TrackSelection> const& tracks)
+  {
+    Double_t cent[3] = {
+      collision.centRun2V0M(),
+      collision.centRun2CL0(),
+      collision.centRun2CL1()};
+    Int_t cbin = GetCentBin(cent[centEst]);
 
-      Double_t eta = track.eta();
-      Double_t phi = track.phi();
+    collisionData(collision.globalIndex(), cent[centEst], cbin);
 
-      Double_t phiWeight = 1.0;
-      if (pweightMap) {
-        Int_t bin = pweightMap->FindBin(phi, eta, zvertex);
-        phiWeight = pweightMap->GetBinContent(bin);
+    if (saveQvectors)
+      JFFlucAnalysis::ResetQvectorsQC(qvector, qvectorGap);
+    int ntracks = 0;
+
+    if (IsEventSelected(collision, cent, cbin)) {
+      auto bc = collision.bc_as<aod::BCsWithTimestamps>();
+      TH1* pweightMap = pnuaMapList ? (TH1*)pnuaMapList->FindObject(Form("PhiWeights_%u_%02u", bc.runNumber(), cbin)) : 0;
+
+      for (auto& track : tracks) {
+        if (trackingMode == 0 && !track.isGlobalTrack())
+          continue;
+        else if (trackingMode == 1 && !track.isGlobalTrackSDD())
+          continue;
+
+        Double_t pt = track.pt();
+        if (pt < ptmin || pt > ptmax)
+          continue;
+
+        Int_t ch = track.sign();
+        if (charge != 0 && charge * ch < 0)
+          continue;
+
+        Double_t eta = track.eta();
+        Double_t phi = track.phi();
+
+        Double_t phiWeight = 1.0;
+        if (pweightMap) {
+          Int_t bin = pweightMap->FindBin(phi, eta, zvertex);
+          phiWeight = pweightMap->GetBinContent(bin);
+        }
+
+        if (saveTracks)
+          particleTrack(track.collisionId(), pt, eta, phi, phiWeight, 1.0f);
+        if (saveQvectors)
+          JFFlucAnalysis::AddToQvectorsQC(eta, phi, etamin, etamax, qvector, qvectorGap);
+        ++ntracks;
       }
-
-      particleTrack(track.collisionId(), pt, eta, phi, phiWeight, 1.0f);
     }
+
+    // one row per collision, also for the rejected ones, to stay joinable with CollisionData
+    if (saveQvectors)
+      WriteQvectors(ntracks);
     // LOGF(info,"event %u processed with %u tracks.",collisionId,tracks.size());
   }
 };
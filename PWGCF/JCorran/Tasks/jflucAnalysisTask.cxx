@@ -57,7 +57,7 @@ struct jflucAnalysisTask {
     pcf->UserCreateOutputObjects();
   }
 
-  void process(soa::Join<aod::Collisions, aod::CollisionData>::iterator const& collision, aod::ParticleTrack const& tracks)
+  void processTracks(soa::Join<aod::Collisions, aod::CollisionData>::iterator const& collision, aod::ParticleTrack const& tracks)
   {
     if (tracks.size() == 0)
       return; // rejected event
@@ -72,6 +72,26 @@ struct jflucAnalysisTask {
     pcf->SetEtaRange(etamin, etamax);
     pcf->UserExec("");
   }
+  PROCESS_SWITCH(jflucAnalysisTask, processTracks, "Process the tracks of ParticleTrack", true);
+
+  // event-level analysis of the Q-vectors stored by JCatalyst with the same eta range, without reading the tracks
+  void processQvectors(soa::Join<aod::Collisions, aod::CollisionData, aod::CollisionQvectors>::iterator const& collision)
+  {
+    if (collision.ntracks() == 0)
+      return; // rejected event
+
+    const double fVertex[3] = {collision.posX(), collision.posY(), collision.posZ()};
+
+    pcf->Init();
+    pcf->SetEventCentralityAndBin(collision.cent(), collision.cbin());
+    pcf->SetEventVertex(fVertex);
+    pcf->FillEventQA(collision.ntracks());
+    pcf->SetQvectorsQC(collision.qRe(), collision.qIm(), collision.qGapRe(), collision.qGapIm());
+    pcf->SetEtaRange(etamin, etamax);
+    pcf->UserExec("");
+  }
+  PROCESS_SWITCH(jflucAnalysisTask, processQvectors, "Process the event Q-vectors of CollisionQvectors", false);
+
   JFFlucAnalysis* pcf;
 };
 
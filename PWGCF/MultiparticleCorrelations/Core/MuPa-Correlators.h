@@ -0,0 +1,358 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MuPa-Correlators.h
+/// \brief Q-vectors and generic multiparticle correlators, shared by the multiparticle correlations tasks
+
+#ifndef PWGCF_MULTIPARTICLECORRELATIONS_CORE_MUPA_CORRELATORS_H_
+#define PWGCF_MULTIPARTICLECORRELATIONS_CORE_MUPA_CORRELATORS_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Framework/Logger.h"
+
+namespace o2::analysis::mupa
+{
+/// Q-vectors Q(h, p) = sum_i w_i^p exp(i h phi_i) for the harmonics 0 <= h < NHarmonics and the weight powers 0 <= p < NPowers,
+/// stored contiguously, and the generic multiparticle correlators calculated from them.
+/// An n-particle correlator with harmonics h1..hn needs |h1 + ... + hn| < NHarmonics for all its subsets, and n < NPowers.
+template <int NHarmonics, int NPowers>
+class Qvectors
+{
+ public:
+  /// Sets all the Q-vectors to zero
+  void reset()
+  {
+    mRe.fill(0.);
+    mIm.fill(0.);
+    mMemo.clear();
+  }
+
+  /// Adds one particle
+  /// \param phi is the azimuthal angle
+  /// \param weight is the particle weight
+  void fill(double phi, double weight = 1.)
+  {
+    std::array<double, NPowers> wToPowerP;
+    wToPowerP[0] = 1.;
+    for (int p = 1; p < NPowers; p++) {
+      wToPowerP[p] = wToPowerP[p - 1] * weight;
+    }
+    // cos(h phi) and sin(h phi) from the angle addition formulas, so that phi goes through cos and sin only once
+    const double cos1 = std::cos(phi);
+    const double sin1 = std::sin(phi);
+    double cosH = 1.;
+    double sinH = 0.;
+    for (int h = 0; h < NHarmonics; h++) {
+      double* re = &mRe[h * NPowers];
+      double* im = &mIm[h * NPowers];
+      for (int p = 0; p < NPowers; p++) {
+        re[p] += wToPowerP[p] * cosH;
+        im[p] += wToPowerP[p] * sinH;
+      }
+      const double cosNext = cosH * cos1 - sinH * sin1;
+      sinH = sinH * cos1 + cosH * sin1;
+      cosH = cosNext;
+    }
+    mMemo.clear();
+  }
+
+  /// Adds n particles
+  /// \param phis are the azimuthal angles
+  /// \param weights are the particle weights, unit weights if null
+  void fill(const double* phis, const double* weights, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; i++) {
+      fill(phis[i], weights ? weights[i] : 1.);
+    }
+  }
+
+  /// Adds the tracks of a table
+  /// \param weight returns the weight of a track
+  template <typename TTracks, typename TWeight>
+  void fillTracks(TTracks const& tracks, TWeight&& weight)
+  {
+    for (auto const& track : tracks) {
+      fill(track.phi(), weight(track));
+    }
+  }
+
+  /// Q-vector of harmonic h and weight power p, using Q(-h, p) = Q(h, p)^*
+  std::complex<double> q(int h, int p) const
+  {
+    if (std::abs(h) >= NHarmonics || p < 0 || p >= NPowers) {
+      LOGF(fatal, "Q-vector of harmonic %d and power %d requested, but only %d harmonics and %d powers are available", h, p, NHarmonics, NPowers);
+    }
+    const int i = std::abs(h) * NPowers + p;
+    return {mRe[i], h >= 0 ? mIm[i] : -mIm[i]};
+  }
+
+  /// Generic correlator sum over distinct particles of w_1...w_n exp(i(h_1 phi_1 + ... + h_n phi_n)), not normalised.
+  /// The normalisation is the correlator with all harmonics set to zero.
+  std::complex<double> correlator(std::vector<int> harmonics)
+  {
+    if (harmonics.empty()) {
+      return {1., 0.};
+    }
+    return recursion(harmonics.size(), harmonics.data(), 1, 0);
+  }
+
+ private:
+  /// Recursion of K. Gulbrandsen (gulbrand@nbi.dk). Its value only depends on n, the first n harmonics, mult and skip,
+  /// so the terms with at least 3 harmonics are kept until the Q-vectors change: higher-order correlators reuse them many times
+  std::complex<double> recursion(int n, int* harmonic, int mult, int skip)
+  {
+    int nm1 = n - 1;
+    std::complex<double> c(q(harmonic[nm1], mult));
+    if (nm1 == 0) {
+      return c;
+    }
+    std::vector<int> key;
+    if (n > 2) {
+      mKey.assign({n, mult, skip});
+      mKey.insert(mKey.end(), harmonic, harmonic + n);
+      auto memo = mMemo.find(mKey);
+      if (memo != mMemo.end()) {
+        return memo->second;
+      }
+      key = mKey;
+    }
+    c *= recursion(nm1, harmonic, 1, 0);
+    if (nm1 == skip) {
+      return remember(key, c);
+    }
+    int multp1 = mult + 1;
+    int nm2 = n - 2;
+    int counter1 = 0;
+    int hhold = harmonic[counter1];
+    harmonic[counter1] = harmonic[nm2];
+    harmonic[nm2] = hhold + harmonic[nm1];
+    std::complex<double> c2(recursion(nm1, harmonic, multp1, nm2));
+    int counter2 = n - 3;
+    while (counter2 >= skip) {
+      harmonic[nm2] = harmonic[counter1];
+      harmonic[counter1] = hhold;
+      ++counter1;
+      hhold = harmonic[counter1];
+      harmonic[counter1] = harmonic[nm2];
+      harmonic[nm2] = hhold + harmonic[nm1];
+      c2 += recursion(nm1, harmonic, multp1, counter2);
+      --counter2;
+    }
+    harmonic[nm2] = harmonic[counter1];
+    harmonic[counter1] = hhold;
+    return remember(key, c - double(mult) * c2);
+  }
+
+  std::complex<double> remember(std::vector<int>& key, std::complex<double> value)
+  {
+    if (!key.empty()) {
+      mMemo.emplace(std::move(key), value);
+    }
+    return value;
+  }
+
+  std::array<double, NHarmonics * NPowers> mRe{};         ///< real parts of the Q-vectors, [harmonic][power]
+  std::array<double, NHarmonics * NPowers> mIm{};         ///< imaginary parts of the Q-vectors
+  std::map<std::vector<int>, std::complex<double>> mMemo; ///< terms of the recursion of the current Q-vectors
+  std::vector<int> mKey;                                  ///< buffer of the key of the term being looked up
+};
+
+/// Sums of a correlator over the tuples of distinct particles visited by the nested loops
+struct NestedLoopSums {
+  std::complex<double> value{0., 0.}; ///< sum of w_1...w_n exp(i(h_1 phi_1 + ... + h_n phi_n))
+  double weight = 0.;                 ///< sum of w_1...w_n, the normalisation of the value
+  bool sampled = false;               ///< only a random subset of the particles was taken in the outer loop
+};
+
+/// Nested loops over distinct particles, the direct evaluation of the generic correlators used to cross-check the
+/// correlators of the Q-vectors. The angles and weights of the event are stored as arrays, with w cos(h phi) and
+/// w sin(h phi) precomputed for the harmonics 0 <= h < NHarmonics, so that the loops only multiply and add.
+/// The outer loop is shared among threads, each summing its outer particles separately, and can be limited to a random
+/// subset of the particles so that the number of tuples stays below a budget: the ratio of the sums is then an
+/// estimate of the correlator, instead of its exact value. The cost is N^n per correlator of n particles otherwise.
+template <int NHarmonics>
+class NestedLoops
+{
+ public:
+  /// Removes all the particles
+  void reset()
+  {
+    mN = 0;
+    mWeight.clear();
+    mWCos.clear();
+    mWSin.clear();
+  }
+
+  /// Sets the particles of the event
+  /// \param phis are the azimuthal angles
+  /// \param weights are the particle weights, unit weights if null
+  void fill(const double* phis, const double* weights, std::size_t n)
+  {
+    mN = n;
+    if (weights) {
+      mWeight.assign(weights, weights + n);
+    } else {
+      mWeight.assign(n, 1.);
+    }
+    mWCos.resize(NHarmonics * n);
+    mWSin.resize(NHarmonics * n);
+    for (std::size_t i = 0; i < n; i++) {
+      const double cos1 = std::cos(phis[i]);
+      const double sin1 = std::sin(phis[i]);
+      double cosH = 1.;
+      double sinH = 0.;
+      for (int h = 0; h < NHarmonics; h++) {
+        mWCos[h * n + i] = mWeight[i] * cosH;
+        mWSin[h * n + i] = mWeight[i] * sinH;
+        const double cosNext = cosH * cos1 - sinH * sin1;
+        sinH = sinH * cos1 + cosH * sin1;
+        cosH = cosNext;
+      }
+    }
+  }
+
+  /// Number of particles
+  std::size_t size() const { return mN; }
+
+  /// Seed of the random choice of the outer particles when the tuples are sampled
+  void setSeed(unsigned int seed) { mRandom.seed(seed); }
+
+  /// Generic correlator from the nested loops, not normalised
+  /// \param harmonics are the harmonics h_1...h_n, |h_i| < NHarmonics
+  /// \param nThreads is the number of threads sharing the outer loop
+  /// \param maxTuples is the budget of tuples, the outer loop is limited to a random subset of the particles beyond, 0 for all the tuples
+  NestedLoopSums correlator(std::vector<int> const& harmonics, int nThreads = 1, double maxTuples = 0.)
+  {
+    NestedLoopSums sums;
+    const std::size_t n = harmonics.size();
+    if (n == 0 || mN < n) {
+      return sums;
+    }
+    std::vector<Row> rows(n);
+    for (std::size_t d = 0; d < n; d++) {
+      const int h = std::abs(harmonics[d]);
+      if (h >= NHarmonics) {
+        LOGF(fatal, "Nested loops for harmonic %d requested, but only %d harmonics are available", harmonics[d], NHarmonics);
+      }
+      rows[d] = {&mWCos[h * mN], &mWSin[h * mN], harmonics[d] < 0 ? -1. : 1.};
+    }
+
+    // outer particles, a random subset of them if there are more tuples than the budget
+    mOuter.resize(mN);
+    for (std::size_t i = 0; i < mN; i++) {
+      mOuter[i] = i;
+    }
+    std::size_t nOuter = mN;
+    if (maxTuples > 0.) {
+      double tuplesPerOuter = 1.;
+      for (std::size_t d = 1; d < n; d++) {
+        tuplesPerOuter *= static_cast<double>(mN - d);
+      }
+      if (tuplesPerOuter * mN > maxTuples) {
+        nOuter = std::clamp<std::size_t>(static_cast<std::size_t>(std::ceil(maxTuples / tuplesPerOuter)), 1, mN);
+        // partial Fisher-Yates shuffle of the first nOuter particles
+        for (std::size_t i = 0; i < nOuter; i++) {
+          std::uniform_int_distribution<std::size_t> pick(i, mN - 1);
+          std::swap(mOuter[i], mOuter[pick(mRandom)]);
+        }
+        sums.sampled = true;
+      }
+    }
+
+    // the outer particles are interleaved among the threads, which have similar amounts of tuples
+    const std::size_t nWorkers = std::clamp<std::size_t>(nThreads, 1, nOuter);
+    std::vector<NestedLoopSums> partial(nWorkers);
+    auto work = [&](std::size_t worker) {
+      std::vector<std::size_t> chosen(n);
+      for (std::size_t o = worker; o < nOuter; o += nWorkers) {
+        const std::size_t i = mOuter[o];
+        chosen[0] = i;
+        const double re = rows[0].wCos[i];
+        const double im = rows[0].sign * rows[0].wSin[i];
+        if (n == 1) {
+          partial[worker].value += std::complex<double>(re, im);
+          partial[worker].weight += mWeight[i];
+        } else {
+          loop(rows, chosen, 1, re, im, mWeight[i], partial[worker]);
+        }
+      }
+    };
+    if (nWorkers == 1) {
+      work(0);
+    } else {
+      std::vector<std::thread> threads;
+      threads.reserve(nWorkers);
+      for (std::size_t worker = 0; worker < nWorkers; worker++) {
+        threads.emplace_back(work, worker);
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    }
+    // the partial sums are added in a fixed order, the result does not depend on the scheduling of the threads
+    for (auto const& p : partial) {
+      sums.value += p.value;
+      sums.weight += p.weight;
+    }
+    return sums;
+  }
+
+ private:
+  /// Particle factors of one position of the correlator
+  struct Row {
+    const double* wCos;
+    const double* wSin;
+    double sign; ///< sign of the harmonic, sin(-h phi) = -sin(h phi)
+  };
+
+  /// Loop of position depth over the particles not taken by the outer positions
+  void loop(std::vector<Row> const& rows, std::vector<std::size_t>& chosen, std::size_t depth, double re, double im, double weight, NestedLoopSums& sums) const
+  {
+    const Row& row = rows[depth];
+    const bool last = depth + 1 == rows.size();
+    for (std::size_t j = 0; j < mN; j++) {
+      if (std::find(chosen.begin(), chosen.begin() + depth, j) != chosen.begin() + depth) {
+        continue;
+      }
+      const double c = row.wCos[j];
+      const double s = row.sign * row.wSin[j];
+      const double reNext = re * c - im * s;
+      const double imNext = re * s + im * c;
+      if (last) {
+        sums.value += std::complex<double>(reNext, imNext);
+        sums.weight += weight * mWeight[j];
+      } else {
+        chosen[depth] = j;
+        loop(rows, chosen, depth + 1, reNext, imNext, weight * mWeight[j], sums);
+      }
+    }
+  }
+
+  std::size_t mN = 0;              ///< number of particles
+  std::vector<double> mWeight;     ///< particle weights
+  std::vector<double> mWCos;       ///< w cos(h phi), [harmonic][particle]
+  std::vector<double> mWSin;       ///< w sin(h phi), [harmonic][particle]
+  std::vector<std::size_t> mOuter; ///< particles of the outer loop, the first ones are taken when sampling
+  std::mt19937 mRandom{0};         ///< random choice of the outer particles
+};
+} // namespace o2::analysis::mupa
+
+#endif // PWGCF_MULTIPARTICLECORRELATIONS_CORE_MUPA_CORRELATORS_H_
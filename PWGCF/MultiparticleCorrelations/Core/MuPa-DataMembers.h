@@ -65,8 +65,8 @@ TList* fQvectorList = NULL;        // list to hold all Q-vector objects
 TProfile* fQvectorFlagsPro = NULL; // profile to hold all flags for Q-vector
 Bool_t fCalculateQvector = kTRUE;  // to calculate or not to calculate Q-vectors, that's a Boolean...
 struct Qvector_Arrays {
-  TComplex fQ[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}};       //! generic Q-vector
-  TComplex fQvector[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}}; //! "integrated" Q-vector
+  TComplex fQ[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}};    //! generic Q-vector
+  o2::analysis::mupa::Qvectors<gMaxHarmonic * gMaxCorrelator + 1, gMaxCorrelator + 1> fQvector; //! "integrated" Q-vector
 } qv_a;
 
 // *) Multiparticle correlations (standard, isotropic, same harmonic):
@@ -550,12 +550,7 @@ void ResetEventByEventQuantities()
   // c) Q-vectors:
   if (fCalculateQvector) {
     ResetQ(); // generic Q-vector
-    for (Int_t h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
-      for (Int_t wp = 0; wp < gMaxCorrelator + 1; wp++) // weight power
-      {
-        qv_a.fQvector[h][wp] = TComplex(0., 0.);
-      }
-    }
+    qv_a.fQvector.reset();
   } // if(fCalculateQvector)
 
   // ... TBI 20220809 port the rest ...
@@ -658,7 +653,8 @@ void CalculateCorrelations()
   for (Int_t h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
     for (Int_t wp = 0; wp < gMaxCorrelator + 1; wp++) // weight power
     {
-      qv_a.fQ[h][wp] = qv_a.fQvector[h][wp];
+      std::complex<double> q = qv_a.fQvector.q(h, wp);
+      qv_a.fQ[h][wp] = TComplex(q.real(), q.imag());
     }
   }
 
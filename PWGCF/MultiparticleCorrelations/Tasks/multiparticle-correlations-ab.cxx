@@ -32,6 +32,9 @@ using namespace std;
 // *) Global constants:
 #include "PWGCF/MultiparticleCorrelations/Core/MuPa-GlobalConstants.h"
 
+// *) Q-vectors and correlators:
+#include "PWGCF/MultiparticleCorrelations/Core/MuPa-Correlators.h"
+
 // *) Main task:
 struct MultiparticleCorrelationsAB // this name is used in lower-case format to name the TDirectoryFile in AnalysisResults.root
 {
@@ -113,7 +116,7 @@ struct MultiparticleCorrelationsAB // this name is used in lower-case format to
     // *) Main loop over particles:
     Double_t dPhi = 0.; //, dPt = 0., dEta = 0.;
     // Double_t wPhi = 1., wPt = 1., wEta = 1.;
-    Double_t wToPowerP = 1.; // final particle weight raised to power p
+    Double_t wPhi = 1.; // final particle weight
     for (auto& track : tracks) {
 
       // *) Fill particle histograms for reconstructed data before particle cuts:
@@ -131,14 +134,10 @@ struct MultiparticleCorrelationsAB // this name is used in lower-case format to
       dPhi = track.phi();
       // dPt  = track.pt();
       // dEta = track.eta();
-      for (Int_t h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
-        for (Int_t wp = 0; wp < gMaxCorrelator + 1; wp++) { // weight power
-          // if (fUseWeights[0]||fUseWeights[1]||fUseWeights[2]) {
-          //   wToPowerP = pow(wPhi*wPt*wEta,wp);
-          // }
-          qv_a.fQvector[h][wp] += TComplex(wToPowerP * TMath::Cos(h * dPhi), wToPowerP * TMath::Sin(h * dPhi));
-        } // for(Int_t wp=0;wp<gMaxCorrelator+1;wp++)
-      }   // for(Int_t h=0;h<gMaxHarmonic*gMaxCorrelator+1;h++)
+      // if (fUseWeights[0]||fUseWeights[1]||fUseWeights[2]) {
+      //   wPhi = wPhi*wPt*wEta;
+      // }
+      qv_a.fQvector.fill(dPhi, wPhi); // all harmonics and weight powers
 
       fResultsHist->Fill(pw_a.fWeightsHist[wPHI]->GetBinContent(pw_a.fWeightsHist[wPHI]->FindBin(track.phi()))); // TBI 20220713 meaningless, only temporarily here to check if this is feasible
 
@@ -16,6 +16,7 @@
 #include <TMath.h>
 #include "fairlogger/Logger.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <string_view>
@@ -30,6 +31,7 @@
 #include "Common/DataModel/Centrality.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "PWGCF/MultiparticleCorrelations/Core/MuPa-Correlators.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -448,6 +450,12 @@ struct MultiParticleCorrelationsARTask {
   // the actual value of the symmetric cumulant is computed in the post processing by parsing the output
   Configurable<std::vector<int>> cfgSC = {"SymmetricCumulants", {23, 24, 34}, "Symmetric Cumulants to be computed"};
 
+  // configurables for cross-checking the correlators of the events with nested loops
+  Configurable<bool> cfgNestedLoops = {"NestedLoops", false, "Cross-check the correlators of the events with nested loops"};
+  Configurable<int> cfgNestedLoopsThreads = {"NestedLoopsThreads", 1, "Number of threads sharing the outer nested loop"};
+  Configurable<double> cfgNestedLoopsMaxTuples = {"NestedLoopsMaxTuples", 0., "Maximum number of particle tuples per correlator and event, a random subset of the outer particles is taken beyond, 0 for all"};
+  Configurable<double> cfgNestedLoopsTolerance = {"NestedLoopsTolerance", 1.e-5, "Maximum difference between the correlators of the nested loops and of the Q-vectors, for the events without sampling"};
+
   // declare histogram registry
   HistogramRegistry fRegistry{
     "MultiParticleCorrelationsARTask",
@@ -458,7 +466,9 @@ struct MultiParticleCorrelationsARTask {
 
   // declare objects for computing qvectors
   // global object holding the qvectors
-  std::array<std::array<TComplex, AR::MaxHarmonic>, AR::MaxPower> fQvectors;
+  o2::analysis::mupa::Qvectors<AR::MaxHarmonic, AR::MaxPower> fQvectors;
+  // object for computing the correlators with nested loops
+  o2::analysis::mupa::NestedLoops<AR::MaxHarmonic> fNestedLoops;
   // global object holding all azimuthal angles and weights, used for computing correlators as a function of event variables
   std::vector<double> fAzimuthalAnglesAll;
   std::vector<double> fWeightsAll;
@@ -555,6 +565,14 @@ struct MultiParticleCorrelationsARTask {
     GetCorreltors();
     // book a list for each correlator, containing a TProfile for each track and event variable used as an dependency
     BookCorrelators();
+
+    // difference between the correlators of the nested loops and of the Q-vectors, for each correlator
+    if (cfgNestedLoops.value) {
+      fRegistry.add("NestedLoops/Difference", "nested loops - Q-vectors", HistType::kTH2D, {{static_cast<int>(fCorrelators.size()), -0.5, fCorrelators.size() - 0.5}, {200, -0.01, 0.01}});
+      for (std::size_t i = 0; i < fCorrelators.size(); i++) {
+        fRegistry.get<TH2>(HIST("NestedLoops/Difference"))->GetXaxis()->SetBinLabel(i + 1, fCorrelatorList->At(i)->GetName());
+      }
+    }
   }
 
   std::vector<std::vector<int>>
@@ -807,29 +825,12 @@ struct MultiParticleCorrelationsARTask {
   }
 
   // Calculate all Q-vectors
-  void CalculateQvectors(std::vector<double> AzimuthalAngles, std::vector<double> Weights)
+  void CalculateQvectors(std::vector<double> const& AzimuthalAngles, std::vector<double> const& Weights)
   {
     // Make sure all Q-vectors are initially zero
-    for (int h = 0; h < AR::MaxHarmonic; h++) {
-      for (int p = 0; p < AR::MaxPower; p++) {
-        fQvectors[h][p] = TComplex(0., 0.);
-      }
-    }
+    fQvectors.reset();
     // Calculate Q-vectors for available angles and weights
-    double dPhi = 0.;
-    double wPhi = 1.;         // particle weight
-    double wPhiToPowerP = 1.; // particle weight raised to power p
-    for (std::size_t i = 0; i < AzimuthalAngles.size(); i++) {
-      dPhi = AzimuthalAngles.at(i);
-      wPhi = Weights.at(i);
-      for (int h = 0; h < AR::MaxHarmonic; h++) {
-        for (int p = 0; p < AR::MaxPower; p++) {
-          wPhiToPowerP = TMath::Power(wPhi, p);
-          fQvectors[h][p] += TComplex(wPhiToPowerP * TMath::Cos(h * dPhi),
-                                      wPhiToPowerP * TMath::Sin(h * dPhi));
-        }
-      }
-    }
+    fQvectors.fill(AzimuthalAngles.data(), Weights.data(), AzimuthalAngles.size());
   }
 
   void FillCorrelators(double Centrality)
@@ -864,6 +865,11 @@ struct MultiParticleCorrelationsARTask {
       }
     }
 
+    // cross-check the correlators of the event, while the Q-vectors are those of all the angles
+    if (cfgNestedLoops.value) {
+      CheckWithNestedLoops();
+    }
+
     // loop over all track variables
     for (int trackDep = 0; trackDep < AR::kLAST_CorTrackDep; trackDep++) {
       // loop over all bins of the track variable
@@ -899,6 +905,31 @@ struct MultiParticleCorrelationsARTask {
     }
   };
 
+  void CheckWithNestedLoops()
+  {
+    // compare the correlators of the Q-vectors of all the angles of the event with the ones of the nested loops
+    // with sampling of the tuples, the nested loops only give an estimate and the difference is not checked against the tolerance
+    double corr = 0.;
+    double weight = 1.;
+    fNestedLoops.reset();
+    fNestedLoops.fill(fAzimuthalAnglesAll.data(), fWeightsAll.data(), fAzimuthalAnglesAll.size());
+    for (auto correlator : fCorrelators) {
+      if (fAzimuthalAnglesAll.size() <= correlator.size()) {
+        continue;
+      }
+      ComputeCorrelator(correlator, &corr, &weight);
+      auto sums = fNestedLoops.correlator(correlator, cfgNestedLoopsThreads.value, cfgNestedLoopsMaxTuples.value);
+      if (sums.weight <= 0.) {
+        continue;
+      }
+      double difference = sums.value.real() / sums.weight - corr;
+      fRegistry.fill(HIST("NestedLoops/Difference"), fMapCorToIndex[correlator], difference);
+      if (!sums.sampled && std::abs(difference) > cfgNestedLoopsTolerance.value) {
+        LOG(error) << "Correlator " << fCorrelatorList->At(fMapCorToIndex[correlator])->GetName() << ": nested loops give " << sums.value.real() / sums.weight << ", Q-vectors give " << corr;
+      }
+    }
+  }
+
   void ComputeCorrelator(std::vector<int> Correlator, double* value, double* weight)
   {
     // compute a correlator
@@ -926,9 +957,8 @@ struct MultiParticleCorrelationsARTask {
         Weight = Six(0, 0, 0, 0, 0, 0).Re();
         break;
       default:
-        Value = Recursion(Correlator.size(), Correlator.data()).Re();
-        Weight =
-          Recursion(Correlator.size(), std::vector<int>(Correlator.size(), 0).data()).Re();
+        Value = fQvectors.correlator(Correlator).real();
+        Weight = fQvectors.correlator(std::vector<int>(Correlator.size(), 0)).real();
     }
     // correlators are not normalized yet
     Value /= Weight;
@@ -939,14 +969,9 @@ struct MultiParticleCorrelationsARTask {
 
   TComplex Q(int n, int p)
   {
-    // return Qvector from fQvectors array
-    if (n > AR::MaxHarmonic || p > AR::MaxPower) {
-      LOG(fatal) << "Harmonic " << n << ">" << AR::MaxHarmonic << "(MaxHarmonic) or the power " << p << ">" << AR::MaxPower << "(MaxPower)";
-    }
-    if (n >= 0) {
-      return fQvectors[n][p];
-    }
-    return TComplex::Conjugate(fQvectors[-n][p]);
+    // return Qvector from fQvectors, which checks the harmonic and the power
+    std::complex<double> q = fQvectors.q(n, p);
+    return TComplex(q.real(), q.imag());
   }
 
   TComplex Two(int n1, int n2)
@@ -1253,43 +1278,6 @@ struct MultiParticleCorrelationsARTask {
     return six;
   }
 
-  TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
-  {
-    // Calculate multi-particle correlators by using recursion (an improved
-    // faster version) originally developed by Kristjan Gulbrandsen
-    // (gulbrand@nbi.dk).
-    int nm1 = n - 1;
-    TComplex c(Q(harmonic[nm1], mult));
-    if (nm1 == 0)
-      return c;
-    c *= Recursion(nm1, harmonic);
-    if (nm1 == skip)
-      return c;
-    int multp1 = mult + 1;
-    int nm2 = n - 2;
-    int counter1 = 0;
-    int hhold = harmonic[counter1];
-    harmonic[counter1] = harmonic[nm2];
-    harmonic[nm2] = hhold + harmonic[nm1];
-    TComplex c2(Recursion(nm1, harmonic, multp1, nm2));
-    int counter2 = n - 3;
-    while (counter2 >= skip) {
-      harmonic[nm2] = harmonic[counter1];
-      harmonic[counter1] = hhold;
-      ++counter1;
-      hhold = harmonic[counter1];
-      harmonic[counter1] = harmonic[nm2];
-      harmonic[nm2] = hhold + harmonic[nm1];
-      c2 += Recursion(nm1, harmonic, multp1, counter2);
-      --counter2;
-    }
-    harmonic[nm2] = harmonic[counter1];
-    harmonic[counter1] = hhold;
-    if (mult == 1)
-      return c - c2;
-    return c - double(mult) * c2;
-  }
-
   using CollisionsInstance = soa::Join<aod::Collisions, aod::CentRun2V0Ms, aod::Mults>;
   using TracksInstance = soa::Join<aod::Tracks, aod::TracksDCA, aod::TracksExtra>;
 
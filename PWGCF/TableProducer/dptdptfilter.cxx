@@ -296,31 +296,16 @@ struct DptDptFilter {
         nsigmas[kDptDptProton] = track.tpcNSigmaPr();
       }
     }
-    float min_nsigma = 999.0f;
-    MatchRecoGenSpecies sp_min_nsigma = kWrongSpecies;
+    /* the track is identified if it is within 3 sigmas of only one species, which is then the closest one */
+    int nmatches = 0;
+    MatchRecoGenSpecies sp_match = kWrongSpecies;
     for (int sp = 0; sp < kDptDptNoOfSpecies; ++sp) {
-      if (nsigmas[sp] < min_nsigma) {
-        min_nsigma = nsigmas[sp];
-        sp_min_nsigma = MatchRecoGenSpecies(sp);
+      if (nsigmas[sp] < 3.0) {
+        nmatches++;
+        sp_match = MatchRecoGenSpecies(sp);
       }
     }
-    bool doublematch = false;
-    if (min_nsigma < 3.0) {
-      for (int sp = 0; (sp < kDptDptNoOfSpecies) and not doublematch; ++sp) {
-        if (sp != sp_min_nsigma) {
-          if (nsigmas[sp] < 3.0) {
-            doublematch = true;
-          }
-        }
-      }
-      if (doublematch) {
-        return kWrongSpecies;
-      } else {
-        return sp_min_nsigma;
-      }
-    } else {
-      return kWrongSpecies;
-    }
+    return (nmatches == 1) ? sp_match : kWrongSpecies;
   }
 
   template <typename ParticleObject>
@@ -21,6 +21,7 @@
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "PWGCF/Core/AnalysisConfigurableCuts.h"
 #include <TDatabasePDG.h>
+#include <vector>
 
 namespace o2
 {
@@ -552,6 +553,81 @@ inline void AcceptParticle(ParticleObject& particle, MCCollisionObject const& co
   }
 }
 
+/// \brief Association of the reconstructed tracks to their generated particles for a whole dataframe
+/// The tracks of each particle are stored contiguously, in the order of the tracks table,
+/// instead of in one vector per particle, and the map is built with two passes over the tracks
+class RecoGenMap
+{
+ public:
+  /// Builds the map for nparticles particles
+  /// \param tracks the tracks table
+  /// \param nparticles the number of generated particles
+  /// \param particleOf the function giving the particle index of a track, negative if the track is not mapped
+  template <typename TracksObject, typename ParticleIndexFunction>
+  void build(TracksObject const& tracks, int64_t nparticles, ParticleIndexFunction particleOf)
+  {
+    mOffsets.assign(nparticles + 1, 0);
+    mTrackParticle.resize(tracks.size());
+    int64_t ntrack = 0;
+    for (auto const& track : tracks) {
+      int64_t ixpart = particleOf(track);
+      mTrackParticle[ntrack++] = ixpart;
+      if (not(ixpart < 0)) {
+        mOffsets[ixpart + 1]++;
+      }
+    }
+    for (int64_t ixpart = 0; ixpart < nparticles; ++ixpart) {
+      mOffsets[ixpart + 1] += mOffsets[ixpart];
+    }
+    mTracks.resize(mOffsets[nparticles]);
+    mFill.assign(mOffsets.begin(), mOffsets.end() - 1);
+    for (int64_t ixtrack = 0; ixtrack < ntrack; ++ixtrack) {
+      if (not(mTrackParticle[ixtrack] < 0)) {
+        mTracks[mFill[mTrackParticle[ixtrack]]++] = ixtrack;
+      }
+    }
+  }
+
+  /// Removes the associations, keeping the memory for the next dataframe
+  void clear()
+  {
+    mOffsets.assign(1, 0);
+    mTracks.clear();
+    mTrackParticle.clear();
+  }
+
+  /// The number of tracks associated to the particle
+  int size(int64_t ixpart) const { return mOffsets[ixpart + 1] - mOffsets[ixpart]; }
+  /// The index, in the tracks table, of the i-th track associated to the particle
+  int64_t track(int64_t ixpart, int i) const { return mTracks[mOffsets[ixpart] + i]; }
+  /// The particle associated to the track, negative if the track is not mapped
+  int64_t particle(int64_t ixtrack) const { return mTrackParticle[ixtrack]; }
+  /// The total number of mapped tracks
+  int64_t ntracks() const { return mTracks.size(); }
+
+ private:
+  std::vector<int64_t> mOffsets;       ///< the tracks of particle i are at [mOffsets[i], mOffsets[i+1]) in mTracks
+  std::vector<int64_t> mTracks;        ///< the track indices grouped by particle
+  std::vector<int64_t> mTrackParticle; ///< the particle of each track
+  std::vector<int64_t> mFill;          ///< the filling positions while building
+};
+
+/// \brief The number of charged generated particles in a dataframe
+template <typename ParticlesObject>
+inline size_t countChargedParticles(ParticlesObject const& particles)
+{
+  size_t ngen = 0;
+  for (auto const& part : particles) {
+    auto pdgpart = fPDG->GetParticle(part.pdgCode());
+    if (pdgpart != nullptr) {
+      if ((pdgpart->Charge() >= 3) or (pdgpart->Charge() <= -3)) {
+        ngen++;
+      }
+    }
+  }
+  return ngen;
+}
+
 } // namespace dptdptfilter
 } // namespace analysis
 } // namespace o2
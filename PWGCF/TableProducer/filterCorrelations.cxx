@@ -18,6 +18,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/Centrality.h"
+#include "Common/Core/ScratchArena.h"
 
 #include <TH3F.h>
 #include <TDatabasePDG.h>
@@ -73,6 +74,8 @@ struct FilterCF {
   Produces<aod::CFMcCollisions> outputMcCollisions;
   Produces<aod::CFMcParticles> outputMcParticles;
 
+  o2::common::ScratchArena scratch; // per MC collision or dataframe buffers of the MC processes
+
   template <typename TCollision>
   bool keepCollision(TCollision& collision)
   {
@@ -153,10 +156,8 @@ struct FilterCF {
       LOGF(info, "processMC2: Particles for MC collision: %d | Vertex: %.1f", particles.size(), mcCollision.posZ());
     }
 
-    bool* reconstructed = new bool[particles.size()];
-    for (int i = 0; i < particles.size(); i++) {
-      reconstructed[i] = false;
-    }
+    scratch.reset();
+    auto reconstructed = scratch.vector<bool>(particles.size(), false);
     for (auto& collision : collisions) {
       auto groupedTracks = tracks.sliceBy(perCollision, collision.globalIndex());
       if (cfgVerbosity > 0) {
@@ -192,8 +193,6 @@ struct FilterCF {
     }
 
     outputMcCollisions(mcCollision.posZ(), multiplicity);
-
-    delete[] reconstructed;
   }
   PROCESS_SWITCH(FilterCF, processMC2, "Process MC: MC part", false);
 
@@ -204,12 +203,9 @@ struct FilterCF {
                  soa::Filtered<soa::Join<aod::Tracks, aod::McTrackLabels, aod::TrackSelection>> const& tracks,
                  aod::BCsWithTimestamps const&)
   {
-    bool* reconstructed = new bool[allParticles.size()];
-    int* mcParticleLabels = new int[allParticles.size()];
-    for (int i = 0; i < allParticles.size(); i++) {
-      reconstructed[i] = false;
-      mcParticleLabels[i] = -1;
-    }
+    scratch.reset();
+    auto reconstructed = scratch.vector<bool>(allParticles.size(), false);
+    auto mcParticleLabels = scratch.vector<int>(allParticles.size(), -1);
 
     // PASS 1 on collisions: check which particles are kept
     for (auto& collision : allCollisions) {
@@ -305,9 +301,6 @@ struct FilterCF {
         etaphi->Fill(collision.multiplicity(), track.eta(), track.phi());
       }
     }
-
-    delete[] reconstructed;
-    delete[] mcParticleLabels;
   }
   PROCESS_SWITCH(FilterCF, processMC, "Process MC", false);
 };
@@ -25,11 +25,17 @@
 #include "PWGCF/DataModel/CorrelationsDerived.h"
 #include "PWGCF/Core/CorrelationContainer.h"
 #include "PWGCF/Core/PairCuts.h"
+#include "Common/Core/ScratchArena.h"
 #include "DataFormatsParameters/GRPObject.h"
 #include "DataFormatsParameters/GRPMagField.h"
 
+#include <TAxis.h>
 #include <TH1F.h>
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <thread>
+#include <vector>
 #include <TDirectory.h>
 #include <THn.h>
 
@@ -68,6 +74,10 @@ struct CorrelationTask {
   O2_DEFINE_CONFIGURABLE(cfgTwoTrackCut, float, -1, "Two track cut: -1 = off; >0 otherwise distance value (suggested: 0.02)");
   O2_DEFINE_CONFIGURABLE(cfgTwoTrackCutMinRadius, float, 0.8f, "Two track cut: radius in m from which two track cuts are applied");
 
+  O2_DEFINE_CONFIGURABLE(cfgBinnedCorrelations, bool, false, "Correlate tracks in different pT bins via (eta, phi) cells instead of pairs, not applied when pair cuts or the two track cut are enabled");
+  O2_DEFINE_CONFIGURABLE(cfgBinnedCellsPerBin, int, 2, "Binned correlations: number of (eta, phi) cells per delta eta and delta phi bin");
+  O2_DEFINE_CONFIGURABLE(cfgNThreads, int, 1, "Number of threads filling the pairs of an event (1 = serial), not applied when pair cuts or the two track cut are enabled");
+
   // Suggested values: Photon: 0.004; K0 and Lambda: 0.005
   Configurable<LabeledArray<float>> cfgPairCut{"cfgPairCut", {cfgPairCutDefaults[0], 5, {"Photon", "K0", "Lambda", "Phi", "Rho"}}, "Pair cuts on various particles"};
 
@@ -106,13 +116,136 @@ struct CorrelationTask {
   OutputObj<CorrelationContainer> same{"sameEvent"};
   OutputObj<CorrelationContainer> mixed{"mixedEvent"};
 
+  // Dense copy of a 4-dimensional efficiency histogram (eta, pT, multiplicity, z-vtx), including the under- and overflow bins
+  // The bins are found like TAxis::FindBin, with index arithmetic for the axes with fixed bin widths
+  struct EfficiencyLookup {
+    struct Axis {
+      int nBins = 0;
+      double min = 0.;
+      double max = 0.;
+      std::vector<double> edges; // empty for the axes with fixed bin widths
+      int findBin(double x) const
+      {
+        if (x < min) {
+          return 0;
+        }
+        if (!(x < max)) {
+          return nBins + 1;
+        }
+        if (edges.empty()) {
+          return 1 + static_cast<int>(nBins * (x - min) / (max - min));
+        }
+        return static_cast<int>(std::upper_bound(edges.begin(), edges.end(), x) - edges.begin());
+      }
+    };
+
+    std::array<Axis, 4> axes;
+    std::vector<float> contents;
+
+    void fill(THn* eff)
+    {
+      if (eff->GetNdimensions() != 4) {
+        LOGF(fatal, "Efficiency histogram %s has %d dimensions instead of 4", eff->GetName(), eff->GetNdimensions());
+      }
+      int nCells = 1;
+      for (int i = 0; i < 4; i++) {
+        const TAxis* axis = eff->GetAxis(i);
+        axes[i].nBins = axis->GetNbins();
+        axes[i].min = axis->GetXmin();
+        axes[i].max = axis->GetXmax();
+        axes[i].edges.clear();
+        if (axis->GetXbins()->GetSize() > 0) {
+          axes[i].edges.assign(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + axis->GetXbins()->GetSize());
+        }
+        nCells *= axes[i].nBins + 2;
+      }
+      contents.resize(nCells);
+      int bins[4];
+      for (int index = 0; index < nCells; index++) {
+        int rest = index;
+        for (int i = 3; i >= 0; i--) {
+          bins[i] = rest % (axes[i].nBins + 2);
+          rest /= axes[i].nBins + 2;
+        }
+        contents[index] = eff->GetBinContent(bins);
+      }
+    }
+
+    float get(float eta, float pt, float multiplicity, float posZ) const
+    {
+      int index = axes[0].findBin(eta);
+      index = index * (axes[1].nBins + 2) + axes[1].findBin(pt);
+      index = index * (axes[2].nBins + 2) + axes[2].findBin(multiplicity);
+      index = index * (axes[3].nBins + 2) + axes[3].findBin(posZ);
+      return contents[index];
+    }
+  };
+
   struct Config {
     bool mPairCuts = false;
     THn* mEfficiencyTrigger = nullptr;
     THn* mEfficiencyAssociated = nullptr;
+    EfficiencyLookup mEfficiencyTriggerLookup;
+    EfficiencyLookup mEfficiencyAssociatedLookup;
     bool efficiencyLoaded = false;
   } cfg;
 
+  // (eta, phi) cells per pT bin and charge of the binned correlations, see fillCorrelationsBinned
+  struct BinnedCells {
+    struct CellTrack {
+      int64_t globalIndex;
+      float eta;
+      float phi;
+      float pt;
+      int sign;
+      float weight;
+    };
+
+    std::vector<double> ptEdges;                           // union of the trigger and associated pT bin edges
+    std::vector<float> ptCentres;                          // centres of the pT bins
+    float etaCellWidth = 0.f;                              // width of the cells in eta
+    float phiCellWidth = 0.f;                              // width of the cells in phi
+    int nEtaCells = 0;                                     // number of associated cells in eta, the trigger cells have one more
+    int nPhiCells = 0;                                     // number of cells in phi
+    std::vector<float> triggerCells;                       // summed weights of the trigger cells
+    std::vector<float> associatedCells;                    // summed weights of the associated cells
+    std::vector<int> filledTriggerCells;                   // indices of the non-empty trigger cells
+    std::vector<int> filledAssociatedCells;                // indices of the non-empty associated cells
+    std::vector<std::vector<CellTrack>> triggersInPtBin;   // trigger tracks per pT bin
+    std::vector<std::vector<CellTrack>> associatedInPtBin; // associated tracks per pT bin
+
+    int cellIndex(int ptBin, bool positive, int etaCell, int phiCell) const { return ((ptBin * 2 + positive) * (nEtaCells + 1) + etaCell) * nPhiCells + phiCell; }
+    int cellPhi(int index) const { return index % nPhiCells; }
+    int cellEta(int index) const { return (index / nPhiCells) % (nEtaCells + 1); }
+    int cellSign(int index) const { return (index / (nPhiCells * (nEtaCells + 1))) % 2 ? 1 : -1; }
+    int cellPtBin(int index) const { return index / (nPhiCells * (nEtaCells + 1) * 2); }
+
+    void addToCell(std::vector<float>& cells, std::vector<int>& filledCells, int index, float weight)
+    {
+      if (weight == 0.f) {
+        return;
+      }
+      if (cells[index] == 0.f) {
+        filledCells.push_back(index);
+      }
+      cells[index] += weight;
+    }
+    void clearCells()
+    {
+      for (const auto index : filledTriggerCells) {
+        triggerCells[index] = 0.f;
+      }
+      for (const auto index : filledAssociatedCells) {
+        associatedCells[index] = 0.f;
+      }
+      filledTriggerCells.clear();
+      filledAssociatedCells.clear();
+    }
+  } mBinnedCells;
+
+  std::vector<CorrelationContainer::PairFillBuffer> mPairFillBuffers; // per-thread pair fills, see fillCorrelations
+  o2::common::ScratchArena mScratch;                                  // per-event buffers of fillCorrelations
+
   HistogramRegistry registry{"registry"};
   PairCuts mPairCuts;
 
@@ -148,6 +281,10 @@ struct CorrelationTask {
       mPairCuts.SetTwoTrackCuts(cfgTwoTrackCut, cfgTwoTrackCutMinRadius);
     }
 
+    if (cfgBinnedCorrelations) {
+      setupBinnedCells();
+    }
+
     // --- OBJECT INIT ---
 
     std::vector<AxisSpec> corrAxis = {{axisDeltaEta, "#Delta#eta"},
@@ -175,6 +312,52 @@ struct CorrelationTask {
     ccdb->setCreatedNotAfter(now); // TODO must become global parameter from the train creation time
   }
 
+  // bin edges of a ConfigurableAxis, given either with fixed or with variable bin widths
+  static std::vector<double> getBinEdges(std::vector<double> const& axis)
+  {
+    if (axis[0] == VARIABLE_WIDTH) {
+      return std::vector<double>(axis.begin() + 1, axis.end());
+    }
+    std::vector<double> edges;
+    const int nBins = static_cast<int>(axis[0]);
+    for (int i = 0; i <= nBins; i++) {
+      edges.push_back(axis[1] + i * (axis[2] - axis[1]) / nBins);
+    }
+    return edges;
+  }
+
+  void setupBinnedCells()
+  {
+    if (axisDeltaEta.value[0] == VARIABLE_WIDTH || axisDeltaPhi.value[0] == VARIABLE_WIDTH) {
+      LOGF(fatal, "The binned correlations require fixed-width delta eta and delta phi axes");
+    }
+    if (cfgBinnedCellsPerBin < 1) {
+      LOGF(fatal, "Invalid number of cells per bin for the binned correlations: %d", cfgBinnedCellsPerBin.value);
+    }
+    auto& bc = mBinnedCells;
+    bc.ptEdges = getBinEdges(axisPtTrigger.value);
+    auto ptEdgesAssoc = getBinEdges(axisPtAssoc.value);
+    bc.ptEdges.insert(bc.ptEdges.end(), ptEdgesAssoc.begin(), ptEdgesAssoc.end());
+    std::sort(bc.ptEdges.begin(), bc.ptEdges.end());
+    bc.ptEdges.erase(std::unique(bc.ptEdges.begin(), bc.ptEdges.end()), bc.ptEdges.end());
+    const int nPtBins = bc.ptEdges.size() - 1;
+    for (int i = 0; i < nPtBins; i++) {
+      bc.ptCentres.push_back(0.5 * (bc.ptEdges[i] + bc.ptEdges[i + 1]));
+    }
+
+    bc.etaCellWidth = (axisDeltaEta.value[2] - axisDeltaEta.value[1]) / axisDeltaEta.value[0] / cfgBinnedCellsPerBin;
+    bc.nEtaCells = static_cast<int>(std::ceil(2 * cfgCutEta / bc.etaCellWidth));
+    bc.nPhiCells = static_cast<int>(axisDeltaPhi.value[0]) * cfgBinnedCellsPerBin;
+    bc.phiCellWidth = TwoPI / bc.nPhiCells;
+
+    const int nCells = nPtBins * 2 * (bc.nEtaCells + 1) * bc.nPhiCells;
+    bc.triggerCells.assign(nCells, 0.f);
+    bc.associatedCells.assign(nCells, 0.f);
+    bc.triggersInPtBin.resize(nPtBins);
+    bc.associatedInPtBin.resize(nPtBins);
+    LOGF(info, "Binned correlations with %d pT bins, %d x %d (eta, phi) cells", nPtBins, bc.nEtaCells, bc.nPhiCells);
+  }
+
   int getMagneticField(uint64_t timestamp)
   {
     // TODO done only once (and not per run). Will be replaced by CCDBConfigurable
@@ -229,21 +412,96 @@ struct CorrelationTask {
     return true;
   }
 
+  /// Pairs of a trigger particle with the associated particles
+  /// \param fill is called with delta eta, pT associated, pT trigger, delta phi and the weight of each accepted pair
+  template <CorrelationContainer::CFStep step, typename TTrack, typename TTracks, typename TFill>
+  void fillPairs(TTrack const& track1, TTracks& tracks2, float const* efficiencyAssociated, float triggerWeight, int magField, TFill&& fill)
+  {
+    for (auto& track2 : tracks2) {
+      if (track1.globalIndex() == track2.globalIndex()) {
+        // LOGF(info, "Track identical: %f | %f | %f || %f | %f | %f", track1.eta(), track1.phi(), track1.pt(),  track2.eta(), track2.phi(), track2.pt());
+        continue;
+      }
+
+      if constexpr (step <= CorrelationContainer::kCFStepTracked) {
+        if (!checkObject<step>(track2)) {
+          continue;
+        }
+      }
+
+      if (cfgPtOrder != 0 && track2.pt() >= track1.pt()) {
+        continue;
+      }
+
+      if (cfgAssociatedCharge != 0 && cfgAssociatedCharge * track2.sign() < 0) {
+        continue;
+      }
+      if (cfgPairCharge != 0 && cfgPairCharge * track1.sign() * track2.sign() < 0) {
+        continue;
+      }
+
+      if constexpr (step >= CorrelationContainer::kCFStepReconstructed) {
+        if (cfg.mPairCuts && mPairCuts.conversionCuts(track1, track2)) {
+          continue;
+        }
+
+        if (cfgTwoTrackCut > 0 && mPairCuts.twoTrackCut(track1, track2, magField)) {
+          continue;
+        }
+      }
+
+      float associatedWeight = triggerWeight;
+      if constexpr (step == CorrelationContainer::kCFStepCorrected) {
+        if (cfg.mEfficiencyAssociated) {
+          associatedWeight *= efficiencyAssociated[track2.filteredIndex()];
+        }
+      }
+
+      float deltaPhi = track1.phi() - track2.phi();
+      if (deltaPhi > 1.5f * PI) {
+        deltaPhi -= TwoPI;
+      }
+      if (deltaPhi < -PIHalf) {
+        deltaPhi += TwoPI;
+      }
+
+      fill(track1.eta() - track2.eta(), track2.pt(), track1.pt(), deltaPhi, associatedWeight);
+    }
+  }
+
   template <CorrelationContainer::CFStep step, typename TTarget, typename TTracks>
   void fillCorrelations(TTarget target, TTracks& tracks1, TTracks& tracks2, float multiplicity, float posZ, int magField, float eventWeight)
   {
+    bool pairCutsApplied = false;
+    if constexpr (step >= CorrelationContainer::kCFStepReconstructed) {
+      pairCutsApplied = cfg.mPairCuts || cfgTwoTrackCut > 0;
+    }
+    if (cfgBinnedCorrelations && !pairCutsApplied) {
+      fillCorrelationsBinned<step>(target, tracks1, tracks2, multiplicity, posZ, eventWeight);
+      return;
+    }
+
+    mScratch.reset();
+
     // Cache efficiency for particles (too many FindBin lookups)
+    auto efficiencyAssociatedBuffer = mScratch.vector<float>();
     float* efficiencyAssociated = nullptr;
     if constexpr (step == CorrelationContainer::kCFStepCorrected) {
       if (cfg.mEfficiencyAssociated) {
-        efficiencyAssociated = new float[tracks2.size()];
+        efficiencyAssociatedBuffer.resize(tracks2.size());
+        efficiencyAssociated = efficiencyAssociatedBuffer.data();
         int i = 0;
         for (auto& track : tracks2) {
-          efficiencyAssociated[i++] = getEfficiencyCorrection(cfg.mEfficiencyAssociated, track.eta(), track.pt(), multiplicity, posZ);
+          efficiencyAssociated[i++] = getEfficiencyCorrection(cfg.mEfficiencyAssociatedLookup, track.eta(), track.pt(), multiplicity, posZ);
         }
       }
     }
 
+    // the pair cuts fill histograms of the registry, so the pairs are filled in parallel only without them
+    const bool fillInParallel = cfgNThreads > 1 && !pairCutsApplied;
+    auto triggers = mScratch.vector<typename std::decay_t<TTracks>::iterator>();
+    auto triggerWeights = mScratch.vector<float>();
+
     for (auto& track1 : tracks1) {
       // LOGF(info, "Track %f | %f | %f  %d %d", track1.eta(), track1.phi(), track1.pt(), track1.isGlobalTrack(), track1.isGlobalTrackSDD());
 
@@ -260,66 +518,186 @@ struct CorrelationTask {
       float triggerWeight = eventWeight;
       if constexpr (step == CorrelationContainer::kCFStepCorrected) {
         if (cfg.mEfficiencyTrigger) {
-          triggerWeight *= getEfficiencyCorrection(cfg.mEfficiencyTrigger, track1.eta(), track1.pt(), multiplicity, posZ);
+          triggerWeight *= getEfficiencyCorrection(cfg.mEfficiencyTriggerLookup, track1.eta(), track1.pt(), multiplicity, posZ);
         }
       }
 
       target->getTriggerHist()->Fill(step, track1.pt(), multiplicity, posZ, triggerWeight);
 
-      for (auto& track2 : tracks2) {
-        if (track1.globalIndex() == track2.globalIndex()) {
-          // LOGF(info, "Track identical: %f | %f | %f || %f | %f | %f", track1.eta(), track1.phi(), track1.pt(),  track2.eta(), track2.phi(), track2.pt());
-          continue;
-        }
+      if (fillInParallel) {
+        triggers.push_back(track1);
+        triggerWeights.push_back(triggerWeight);
+        continue;
+      }
+      fillPairs<step>(track1, tracks2, efficiencyAssociated, triggerWeight, magField, [&](float deltaEta, float ptAssoc, float ptTrigger, float deltaPhi, float weight) {
+        target->getPairHist()->Fill(step, deltaEta, ptAssoc, ptTrigger, multiplicity, deltaPhi, posZ, weight);
+      });
+    }
 
-        if constexpr (step <= CorrelationContainer::kCFStepTracked) {
-          if (!checkObject<step>(track2)) {
-            continue;
-          }
+    if (fillInParallel && !triggers.empty()) {
+      // each thread fills the pairs of a contiguous range of triggers into its own buffer,
+      // the buffers are merged in the order of the triggers, such that the histogram is the same as with the serial fill
+      const int nTriggers = triggers.size();
+      const int nWorkers = std::min(cfgNThreads.value, nTriggers);
+      const int nTriggersPerWorker = (nTriggers + nWorkers - 1) / nWorkers;
+      if (static_cast<int>(mPairFillBuffers.size()) < nWorkers) {
+        mPairFillBuffers.resize(nWorkers);
+      }
+      auto worker = [&](int iWorker) {
+        auto& buffer = mPairFillBuffers[iWorker];
+        const int last = std::min(nTriggers, (iWorker + 1) * nTriggersPerWorker);
+        for (int i = iWorker * nTriggersPerWorker; i < last; i++) {
+          fillPairs<step>(triggers[i], tracks2, efficiencyAssociated, triggerWeights[i], magField, [&](float deltaEta, float ptAssoc, float ptTrigger, float deltaPhi, float weight) {
+            buffer.fill(step, {deltaEta, ptAssoc, ptTrigger, multiplicity, deltaPhi, posZ}, weight);
+          });
         }
+      };
+      std::vector<std::thread> threads;
+      threads.reserve(nWorkers - 1);
+      for (int iWorker = 1; iWorker < nWorkers; iWorker++) {
+        threads.emplace_back(worker, iWorker);
+      }
+      worker(0);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      for (int iWorker = 0; iWorker < nWorkers; iWorker++) {
+        target->mergePairFillBuffer(mPairFillBuffers[iWorker]);
+      }
+    }
+  }
+
+  /// Correlations from (eta, phi) cells per pT bin, instead of track pairs
+  /// The pT bins are the union of the trigger and associated pT axes, such that the pT of the pairs is binned exactly.
+  /// The pairs of tracks in the same pT bin are filled one by one, which also takes care of the pT ordering and of the identical tracks.
+  /// For the pairs of tracks in different pT bins, the trigger and associated cells are correlated once per cell pair.
+  /// The trigger cells are shifted by half a cell, so that the delta eta and delta phi of the cell centres never fall on a bin edge;
+  /// the angular resolution of the filled pairs is then one cell (cfgBinnedCellsPerBin cells per delta eta and delta phi bin).
+  /// The pair cuts are not supported, fillCorrelations falls back to the pair loop when they are enabled.
+  template <CorrelationContainer::CFStep step, typename TTarget, typename TTracks>
+  void fillCorrelationsBinned(TTarget target, TTracks& tracks1, TTracks& tracks2, float multiplicity, float posZ, float eventWeight)
+  {
+    auto& bc = mBinnedCells;
+    const int nPtBins = bc.ptEdges.size() - 1;
+    auto getPtBin = [&](float pt) {
+      return static_cast<int>(std::upper_bound(bc.ptEdges.begin(), bc.ptEdges.end(), pt) - bc.ptEdges.begin()) - 1;
+    };
+    for (auto& tracksInPtBin : bc.triggersInPtBin) {
+      tracksInPtBin.clear();
+    }
+    for (auto& tracksInPtBin : bc.associatedInPtBin) {
+      tracksInPtBin.clear();
+    }
 
-        if (cfgPtOrder != 0 && track2.pt() >= track1.pt()) {
+    for (auto& track1 : tracks1) {
+      if constexpr (step <= CorrelationContainer::kCFStepTracked) {
+        if (!checkObject<step>(track1)) {
           continue;
         }
+      }
+      if (cfgTriggerCharge != 0 && cfgTriggerCharge * track1.sign() < 0) {
+        continue;
+      }
 
-        if (cfgAssociatedCharge != 0 && cfgAssociatedCharge * track2.sign() < 0) {
-          continue;
+      float triggerWeight = eventWeight;
+      if constexpr (step == CorrelationContainer::kCFStepCorrected) {
+        if (cfg.mEfficiencyTrigger) {
+          triggerWeight *= getEfficiencyCorrection(cfg.mEfficiencyTriggerLookup, track1.eta(), track1.pt(), multiplicity, posZ);
         }
-        if (cfgPairCharge != 0 && cfgPairCharge * track1.sign() * track2.sign() < 0) {
+      }
+
+      target->getTriggerHist()->Fill(step, track1.pt(), multiplicity, posZ, triggerWeight);
+
+      int ptBin = getPtBin(track1.pt());
+      if (ptBin < 0 || ptBin >= nPtBins) {
+        continue; // outside of the pT axes, no pair is filled
+      }
+      bc.triggersInPtBin[ptBin].push_back({track1.globalIndex(), track1.eta(), track1.phi(), track1.pt(), track1.sign(), triggerWeight});
+      int etaCell = static_cast<int>(std::floor((track1.eta() + cfgCutEta) / bc.etaCellWidth + 0.5f));
+      int phiCell = static_cast<int>(std::floor(track1.phi() / bc.phiCellWidth + 0.5f)) % bc.nPhiCells;
+      etaCell = std::clamp(etaCell, 0, bc.nEtaCells);
+      if (phiCell < 0) {
+        phiCell += bc.nPhiCells;
+      }
+      bc.addToCell(bc.triggerCells, bc.filledTriggerCells, bc.cellIndex(ptBin, track1.sign() > 0, etaCell, phiCell), triggerWeight);
+    }
+
+    for (auto& track2 : tracks2) {
+      if constexpr (step <= CorrelationContainer::kCFStepTracked) {
+        if (!checkObject<step>(track2)) {
           continue;
         }
+      }
+      if (cfgAssociatedCharge != 0 && cfgAssociatedCharge * track2.sign() < 0) {
+        continue;
+      }
 
-        if constexpr (step >= CorrelationContainer::kCFStepReconstructed) {
-          if (cfg.mPairCuts && mPairCuts.conversionCuts(track1, track2)) {
+      float associatedWeight = 1.0f;
+      if constexpr (step == CorrelationContainer::kCFStepCorrected) {
+        if (cfg.mEfficiencyAssociated) {
+          associatedWeight = getEfficiencyCorrection(cfg.mEfficiencyAssociatedLookup, track2.eta(), track2.pt(), multiplicity, posZ);
+        }
+      }
+
+      int ptBin = getPtBin(track2.pt());
+      if (ptBin < 0 || ptBin >= nPtBins) {
+        continue;
+      }
+      bc.associatedInPtBin[ptBin].push_back({track2.globalIndex(), track2.eta(), track2.phi(), track2.pt(), track2.sign(), associatedWeight});
+      int etaCell = std::clamp(static_cast<int>(std::floor((track2.eta() + cfgCutEta) / bc.etaCellWidth)), 0, bc.nEtaCells - 1);
+      int phiCell = std::clamp(static_cast<int>(std::floor(track2.phi() / bc.phiCellWidth)), 0, bc.nPhiCells - 1);
+      bc.addToCell(bc.associatedCells, bc.filledAssociatedCells, bc.cellIndex(ptBin, track2.sign() > 0, etaCell, phiCell), associatedWeight);
+    }
+
+    auto fillPair = [&](float deltaEta, float ptAssoc, float ptTrigger, float deltaPhi, float weight) {
+      if (deltaPhi > 1.5f * PI) {
+        deltaPhi -= TwoPI;
+      }
+      if (deltaPhi < -PIHalf) {
+        deltaPhi += TwoPI;
+      }
+      target->getPairHist()->Fill(step, deltaEta, ptAssoc, ptTrigger, multiplicity, deltaPhi, posZ, weight);
+    };
+
+    // pairs in the same pT bin, one by one
+    for (int ptBin = 0; ptBin < nPtBins; ptBin++) {
+      for (const auto& trigger : bc.triggersInPtBin[ptBin]) {
+        for (const auto& associated : bc.associatedInPtBin[ptBin]) {
+          if (trigger.globalIndex == associated.globalIndex) {
             continue;
           }
-
-          if (cfgTwoTrackCut > 0 && mPairCuts.twoTrackCut(track1, track2, magField)) {
+          if (cfgPtOrder != 0 && associated.pt >= trigger.pt) {
             continue;
           }
-        }
-
-        float associatedWeight = triggerWeight;
-        if constexpr (step == CorrelationContainer::kCFStepCorrected) {
-          if (cfg.mEfficiencyAssociated) {
-            associatedWeight *= efficiencyAssociated[track2.filteredIndex()];
+          if (cfgPairCharge != 0 && cfgPairCharge * trigger.sign * associated.sign < 0) {
+            continue;
           }
+          fillPair(trigger.eta - associated.eta, associated.pt, trigger.pt, trigger.phi - associated.phi, trigger.weight * associated.weight);
         }
+      }
+    }
 
-        float deltaPhi = track1.phi() - track2.phi();
-        if (deltaPhi > 1.5f * PI) {
-          deltaPhi -= TwoPI;
+    // pairs in different pT bins, one per pair of cells
+    for (const auto iTrigger : bc.filledTriggerCells) {
+      const int ptBinTrigger = bc.cellPtBin(iTrigger);
+      const int signTrigger = bc.cellSign(iTrigger);
+      const int etaCellTrigger = bc.cellEta(iTrigger);
+      const int phiCellTrigger = bc.cellPhi(iTrigger);
+      const float weightTrigger = bc.triggerCells[iTrigger];
+      for (const auto iAssociated : bc.filledAssociatedCells) {
+        const int ptBinAssociated = bc.cellPtBin(iAssociated);
+        if (ptBinAssociated == ptBinTrigger || (cfgPtOrder != 0 && ptBinAssociated > ptBinTrigger)) {
+          continue;
         }
-        if (deltaPhi < -PIHalf) {
-          deltaPhi += TwoPI;
+        if (cfgPairCharge != 0 && cfgPairCharge * signTrigger * bc.cellSign(iAssociated) < 0) {
+          continue;
         }
-
-        target->getPairHist()->Fill(step,
-                                    track1.eta() - track2.eta(), track2.pt(), track1.pt(), multiplicity, deltaPhi, posZ, associatedWeight);
+        fillPair((etaCellTrigger - bc.cellEta(iAssociated) - 0.5f) * bc.etaCellWidth, bc.ptCentres[ptBinAssociated], bc.ptCentres[ptBinTrigger],
+                 (phiCellTrigger - bc.cellPhi(iAssociated) - 0.5f) * bc.phiCellWidth, weightTrigger * bc.associatedCells[iAssociated]);
       }
     }
 
-    delete[] efficiencyAssociated;
+    bc.clearCells();
   }
 
   void loadEfficiency(uint64_t timestamp)
@@ -333,6 +711,7 @@ struct CorrelationTask {
         LOGF(fatal, "Could not load efficiency histogram for trigger particles from %s", cfgEfficiencyTrigger.value.c_str());
       }
       LOGF(info, "Loaded efficiency histogram for trigger particles from %s (%p)", cfgEfficiencyTrigger.value.c_str(), (void*)cfg.mEfficiencyTrigger);
+      cfg.mEfficiencyTriggerLookup.fill(cfg.mEfficiencyTrigger);
     }
     if (cfgEfficiencyAssociated.value.empty() == false) {
       cfg.mEfficiencyAssociated = ccdb->getForTimeStamp<THnT<float>>(cfgEfficiencyAssociated, timestamp);
@@ -340,18 +719,14 @@ struct CorrelationTask {
         LOGF(fatal, "Could not load efficiency histogram for associated particles from %s", cfgEfficiencyAssociated.value.c_str());
       }
       LOGF(info, "Loaded efficiency histogram for associated particles from %s (%p)", cfgEfficiencyAssociated.value.c_str(), (void*)cfg.mEfficiencyAssociated);
+      cfg.mEfficiencyAssociatedLookup.fill(cfg.mEfficiencyAssociated);
     }
     cfg.efficiencyLoaded = true;
   }
 
-  double getEfficiencyCorrection(THn* eff, float eta, float pt, float multiplicity, float posZ)
+  double getEfficiencyCorrection(EfficiencyLookup const& eff, float eta, float pt, float multiplicity, float posZ)
   {
-    int effVars[4];
-    effVars[0] = eff->GetAxis(0)->FindBin(eta);
-    effVars[1] = eff->GetAxis(1)->FindBin(pt);
-    effVars[2] = eff->GetAxis(2)->FindBin(multiplicity);
-    effVars[3] = eff->GetAxis(3)->FindBin(posZ);
-    return eff->GetBinContent(effVars);
+    return eff.get(eta, pt, multiplicity, posZ);
   }
 
   // Version with explicit nested loop
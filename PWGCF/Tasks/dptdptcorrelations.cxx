@@ -34,8 +34,10 @@
 #include <TH3.h>
 #include <TProfile3D.h>
 
+#include <algorithm>
 #include <cmath>
 #include <ctime>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -60,6 +62,7 @@ float deltaphilow = 0.0 - deltaphibinwidth / 2.0;
 float deltaphiup = constants::math::TwoPI - deltaphibinwidth / 2.0;
 
 bool processpairs = false;
+bool binnedpairs = true; /* accumulate the pairs from the (eta,phi) binned tracks instead of pair by pair */
 std::string fTaskConfigurationString = "PendingToConfigure";
 
 PairCuts fPairCuts;              // pair suppression engine
@@ -112,6 +115,45 @@ struct DptDptCorrelationsTask {
       nTrackPairs ///< the number of track pairs
     } trackpairs;
 
+    /// \brief The tracks of a collision binned in (eta,phi) cells and in pT, for the pair accumulation by bin pairs
+    ///
+    /// As the differential pair histograms only depend on the cells of the two tracks,
+    /// the pair sums factorize in the products of the cell sums of each track. The self
+    /// pair terms are kept to remove the autocorrelations when both tracks are of the same species
+    struct BinnedTracks {
+      std::vector<int> cells;         ///< the occupied (eta,phi) cells
+      std::vector<bool> occupied;     ///< whether an (eta,phi) cell is occupied
+      std::vector<double> n1;         ///< weighted number of tracks per cell
+      std::vector<double> sum1Pt;     ///< sum of weighted \f$p_T\f$ per cell
+      std::vector<double> sum1Dpt;    ///< sum of weighted \f$p_T - <p_T>\f$ per cell
+      std::vector<double> self2;      ///< sum of squared weights per cell
+      std::vector<double> self2Pt;    ///< sum of squared weighted \f$p_T\f$ per cell
+      std::vector<double> self2Dpt;   ///< sum of squared weighted \f$p_T - <p_T>\f$ per cell
+      std::vector<double> n1Pt;       ///< weighted number of tracks per \f$p_T\f$ bin
+      std::vector<double> self2PtBin; ///< sum of squared weights per \f$p_T\f$ bin
+      double n1nw = 0;                ///< not weighted number of tracks
+      double sum1Ptnw = 0;            ///< sum of not weighted \f$p_T\f$
+      double sum1Dptnw = 0;           ///< sum of not weighted \f$p_T - <p_T>\f$
+      double self2Ptnw = 0;           ///< sum of squared not weighted \f$p_T\f$
+      double self2Dptnw = 0;          ///< sum of squared not weighted \f$p_T - <p_T>\f$
+
+      void init(int ncells, int nptbins)
+      {
+        cells.reserve(ncells);
+        occupied.assign(ncells, false);
+        for (auto v : {&n1, &sum1Pt, &sum1Dpt, &self2, &self2Pt, &self2Dpt}) {
+          v->assign(ncells, 0.0);
+        }
+        n1Pt.assign(nptbins, 0.0);
+        self2PtBin.assign(nptbins, 0.0);
+      }
+    };
+    BinnedTracks fBinnedTracks[2];   ///< the binned tracks one and two of the current collision
+    std::vector<double> fN2;         ///< pair accumulator for \f$n_2\f$ vs \f$\Delta\eta,\;\Delta\phi\f$
+    std::vector<double> fSum2PtPt;   ///< pair accumulator for \f$\sum {p_T}_1 {p_T}_2\f$ vs \f$\Delta\eta,\;\Delta\phi\f$
+    std::vector<double> fSum2DptDpt; ///< pair accumulator for \f$\sum ({p_T}_1- <{p_T}_1>) ({p_T}_2 - <{p_T}_2>)\f$ vs \f$\Delta\eta,\;\Delta\phi\f$
+    std::vector<double> fN2PtPt;     ///< pair accumulator for \f$n_2\f$ vs \f${p_T}_1, {p_T}_2\f$
+
     const char* tname[2] = {"1", "2"}; ///< the external track names, one and two, for histogram creation
     const char* trackPairsNames[4] = {"OO", "OT", "TO", "TT"};
     bool ccdbstored = false;
@@ -363,6 +405,161 @@ struct DptDptCorrelationsTask {
       fhSupPt1Pt1_vsDEtaDPhi[pix]->SetEntries(fhSupPt1Pt1_vsDEtaDPhi[pix]->GetEntries() + n2sup);
     }
 
+    /// \brief bins the tracks in (eta,phi) cells and in pT for the pair accumulation by bin pairs
+    /// \param tracks filtered table with the tracks to bin
+    /// \param corrs the tracks corrections
+    /// \param ptavgs the tracks average \f$p_T\f$
+    /// \param binned receives the binned tracks
+    template <typename TrackListObject>
+    void binTracks(TrackListObject const& tracks, std::vector<float>* corrs, std::vector<float>* ptavgs, BinnedTracks& binned)
+    {
+      using namespace correlationstask;
+      using namespace o2::analysis::dptdptfilter;
+
+      /* clean the previous collision content, only the occupied cells */
+      for (int cell : binned.cells) {
+        binned.n1[cell] = binned.sum1Pt[cell] = binned.sum1Dpt[cell] = 0;
+        binned.self2[cell] = binned.self2Pt[cell] = binned.self2Dpt[cell] = 0;
+        binned.occupied[cell] = false;
+      }
+      binned.cells.clear();
+      std::fill(binned.n1Pt.begin(), binned.n1Pt.end(), 0.0);
+      std::fill(binned.self2PtBin.begin(), binned.self2PtBin.end(), 0.0);
+      binned.n1nw = binned.sum1Ptnw = binned.sum1Dptnw = binned.self2Ptnw = binned.self2Dptnw = 0;
+
+      float ptbinwidth = (ptup - ptlow) / float(ptbins);
+      int index = 0;
+      for (auto& track : tracks) {
+        double corr = (*corrs)[index];
+        double ptavg = (*ptavgs)[index];
+        double pt = track.pt();
+        double dpt = corr * pt - ptavg;
+        double dptnw = pt - ptavg;
+        int cell = GetEtaPhiIndex(track);
+        if (not binned.occupied[cell]) {
+          binned.occupied[cell] = true;
+          binned.cells.push_back(cell);
+        }
+        binned.n1[cell] += corr;
+        binned.sum1Pt[cell] += corr * pt;
+        binned.sum1Dpt[cell] += dpt;
+        binned.self2[cell] += corr * corr;
+        binned.self2Pt[cell] += corr * pt * corr * pt;
+        binned.self2Dpt[cell] += dpt * dpt;
+        int ptix = std::min(int((pt - ptlow) / ptbinwidth), ptbins - 1);
+        binned.n1Pt[ptix] += corr;
+        binned.self2PtBin[ptix] += corr * corr;
+        binned.n1nw += 1;
+        binned.sum1Ptnw += pt;
+        binned.sum1Dptnw += dptnw;
+        binned.self2Ptnw += pt * pt;
+        binned.self2Dptnw += dptnw * dptnw;
+        index++;
+      }
+    }
+
+    /// \brief fills the pair histograms in pair execution mode from the binned tracks
+    /// \param bin1 the binned tracks associated to the first track in the pair
+    /// \param bin2 the binned tracks associated to the second track in the pair
+    /// \param pix index, in the track combination histogram bank, for the passed binned tracks
+    /// \param cmul centrality - multiplicity for the collision being analyzed
+    /// The pair sums are accumulated by (eta,phi) cell pairs, and pT bin pairs,
+    /// instead of by track pairs, so no pair cut can be applied here
+    template <trackpairs pix>
+    void processBinnedTrackPairs(BinnedTracks const& bin1, BinnedTracks const& bin2, float cmul)
+    {
+      using namespace correlationstask;
+      using namespace o2::analysis::dptdptfilter;
+
+      std::fill(fN2.begin(), fN2.end(), 0.0);
+      std::fill(fSum2PtPt.begin(), fSum2PtPt.end(), 0.0);
+      std::fill(fSum2DptDpt.begin(), fSum2DptDpt.end(), 0.0);
+      std::fill(fN2PtPt.begin(), fN2PtPt.end(), 0.0);
+
+      /* process pair magnitudes */
+      double n2 = 0;           ///< weighted number of track 1 track 2 pairs for current collision
+      double sum2PtPt = 0;     ///< accumulated sum of weighted track 1 track 2 \f${p_T}_1 {p_T}_2\f$ for current collision
+      double sum2DptDpt = 0;   ///< accumulated sum of weighted number of track 1 tracks times weighted track 2 \f$p_T\f$ for current collision
+      double n2nw = bin1.n1nw * bin2.n1nw;
+      double sum2PtPtnw = bin1.sum1Ptnw * bin2.sum1Ptnw;
+      double sum2DptDptnw = bin1.sum1Dptnw * bin2.sum1Dptnw;
+
+      /* rule: ix are always zero based while bins are always one based */
+      for (int cell1 : bin1.cells) {
+        int etaix_1 = cell1 / phibins;
+        int phiix_1 = cell1 % phibins;
+        double n1_1 = bin1.n1[cell1];
+        double sum1Pt_1 = bin1.sum1Pt[cell1];
+        double sum1Dpt_1 = bin1.sum1Dpt[cell1];
+        for (int cell2 : bin2.cells) {
+          int deltaeta_ix = etaix_1 - cell2 / phibins + etabins - 1;
+          int deltaphi_ix = phiix_1 - cell2 % phibins;
+          if (deltaphi_ix < 0) {
+            deltaphi_ix += phibins;
+          }
+          int ix = deltaeta_ix * deltaphibins + deltaphi_ix;
+          fN2[ix] += n1_1 * bin2.n1[cell2];
+          fSum2PtPt[ix] += sum1Pt_1 * bin2.sum1Pt[cell2];
+          fSum2DptDpt[ix] += sum1Dpt_1 * bin2.sum1Dpt[cell2];
+        }
+      }
+      for (int ptix_1 = 0; ptix_1 < ptbins; ++ptix_1) {
+        for (int ptix_2 = 0; ptix_2 < ptbins; ++ptix_2) {
+          fN2PtPt[ptix_1 * ptbins + ptix_2] += bin1.n1Pt[ptix_1] * bin2.n1Pt[ptix_2];
+        }
+      }
+      if constexpr (pix == kOO or pix == kTT) {
+        /* exclude autocorrelations, they all go to the zero delta eta, delta phi bin */
+        int ix = (etabins - 1) * deltaphibins;
+        for (int cell : bin1.cells) {
+          fN2[ix] -= bin1.self2[cell];
+          fSum2PtPt[ix] -= bin1.self2Pt[cell];
+          fSum2DptDpt[ix] -= bin1.self2Dpt[cell];
+        }
+        for (int ptix = 0; ptix < ptbins; ++ptix) {
+          fN2PtPt[ptix * ptbins + ptix] -= bin1.self2PtBin[ptix];
+        }
+        n2nw -= bin1.n1nw;
+        sum2PtPtnw -= bin1.self2Ptnw;
+        sum2DptDptnw -= bin1.self2Dptnw;
+      }
+
+      /* transfer to the histograms */
+      for (int deltaeta_ix = 0; deltaeta_ix < deltaetabins; ++deltaeta_ix) {
+        for (int deltaphi_ix = 0; deltaphi_ix < deltaphibins; ++deltaphi_ix) {
+          int ix = deltaeta_ix * deltaphibins + deltaphi_ix;
+          if (fN2[ix] != 0 or fSum2PtPt[ix] != 0 or fSum2DptDpt[ix] != 0) {
+            int globalbin = fhN2_vsDEtaDPhi[pix]->GetBin(deltaeta_ix + 1, deltaphi_ix + 1);
+            fhN2_vsDEtaDPhi[pix]->AddBinContent(globalbin, fN2[ix]);
+            fhSum2DptDpt_vsDEtaDPhi[pix]->AddBinContent(globalbin, fSum2DptDpt[ix]);
+            fhSum2PtPt_vsDEtaDPhi[pix]->AddBinContent(globalbin, fSum2PtPt[ix]);
+            n2 += fN2[ix];
+            sum2PtPt += fSum2PtPt[ix];
+            sum2DptDpt += fSum2DptDpt[ix];
+          }
+        }
+      }
+      for (int ptix_1 = 0; ptix_1 < ptbins; ++ptix_1) {
+        for (int ptix_2 = 0; ptix_2 < ptbins; ++ptix_2) {
+          double value = fN2PtPt[ptix_1 * ptbins + ptix_2];
+          if (value != 0) {
+            fhN2_vsPtPt[pix]->AddBinContent(fhN2_vsPtPt[pix]->GetBin(ptix_1 + 1, ptix_2 + 1), value);
+          }
+        }
+      }
+      fhN2_vsC[pix]->Fill(cmul, n2);
+      fhSum2PtPt_vsC[pix]->Fill(cmul, sum2PtPt);
+      fhSum2DptDpt_vsC[pix]->Fill(cmul, sum2DptDpt);
+      fhN2nw_vsC[pix]->Fill(cmul, n2nw);
+      fhSum2PtPtnw_vsC[pix]->Fill(cmul, sum2PtPtnw);
+      fhSum2DptDptnw_vsC[pix]->Fill(cmul, sum2DptDptnw);
+      /* let's also update the number of entries in the differential histograms */
+      fhN2_vsDEtaDPhi[pix]->SetEntries(fhN2_vsDEtaDPhi[pix]->GetEntries() + n2);
+      fhSum2DptDpt_vsDEtaDPhi[pix]->SetEntries(fhSum2DptDpt_vsDEtaDPhi[pix]->GetEntries() + n2);
+      fhSum2PtPt_vsDEtaDPhi[pix]->SetEntries(fhSum2PtPt_vsDEtaDPhi[pix]->GetEntries() + n2);
+      fhN2_vsPtPt[pix]->SetEntries(fhN2_vsPtPt[pix]->GetEntries() + n2nw);
+    }
+
     template <typename TrackOneListObject, typename TrackTwoListObject>
     void processCollision(TrackOneListObject const& Tracks1, TrackTwoListObject const& Tracks2, float zvtx, float centmult, int bfield)
     {
@@ -384,10 +581,19 @@ struct DptDptCorrelationsTask {
         processTracks(Tracks1, corrs1, 0, centmult); /* track one */
         processTracks(Tracks2, corrs2, 1, centmult); /* track one */
         /* process pair magnitudes */
-        processTrackPairs<kOO>(Tracks1, Tracks1, corrs1, corrs1, ptavgs1, ptavgs1, centmult, bfield);
-        processTrackPairs<kOT>(Tracks1, Tracks2, corrs1, corrs2, ptavgs1, ptavgs2, centmult, bfield);
-        processTrackPairs<kTO>(Tracks2, Tracks1, corrs2, corrs1, ptavgs2, ptavgs1, centmult, bfield);
-        processTrackPairs<kTT>(Tracks2, Tracks2, corrs2, corrs2, ptavgs2, ptavgs2, centmult, bfield);
+        if (binnedpairs and not(fUseConversionCuts or fUseTwoTrackCut)) {
+          binTracks(Tracks1, corrs1, ptavgs1, fBinnedTracks[0]);
+          binTracks(Tracks2, corrs2, ptavgs2, fBinnedTracks[1]);
+          processBinnedTrackPairs<kOO>(fBinnedTracks[0], fBinnedTracks[0], centmult);
+          processBinnedTrackPairs<kOT>(fBinnedTracks[0], fBinnedTracks[1], centmult);
+          processBinnedTrackPairs<kTO>(fBinnedTracks[1], fBinnedTracks[0], centmult);
+          processBinnedTrackPairs<kTT>(fBinnedTracks[1], fBinnedTracks[1], centmult);
+        } else {
+          processTrackPairs<kOO>(Tracks1, Tracks1, corrs1, corrs1, ptavgs1, ptavgs1, centmult, bfield);
+          processTrackPairs<kOT>(Tracks1, Tracks2, corrs1, corrs2, ptavgs1, ptavgs2, centmult, bfield);
+          processTrackPairs<kTO>(Tracks2, Tracks1, corrs2, corrs1, ptavgs2, ptavgs1, centmult, bfield);
+          processTrackPairs<kTT>(Tracks2, Tracks2, corrs2, corrs2, ptavgs2, ptavgs2, centmult, bfield);
+        }
 
         delete ptavgs1;
         delete ptavgs2;
@@ -523,6 +729,14 @@ struct DptDptCorrelationsTask {
           fOutputList->Add(fhSum2PtPtnw_vsC[i]);
           fOutputList->Add(fhSum2DptDptnw_vsC[i]);
         }
+        /* the pair accumulation by bin pairs */
+        for (int i = 0; i < 2; ++i) {
+          fBinnedTracks[i].init(etabins * phibins, ptbins);
+        }
+        fN2.assign(deltaetabins * deltaphibins, 0.0);
+        fSum2PtPt.assign(deltaetabins * deltaphibins, 0.0);
+        fSum2DptDpt.assign(deltaetabins * deltaphibins, 0.0);
+        fN2PtPt.assign(ptbins * ptbins, 0.0);
       }
       TH1::AddDirectory(oldstatus);
     }
@@ -551,6 +765,7 @@ struct DptDptCorrelationsTask {
   Configurable<float> cfgTwoTrackCutMinRadius{"twotrackcutminradius", 0.8f, "Two-tracks cut: radius in m from which two-tracks cut is applied"};
 
   Configurable<bool> cfgProcessPairs{"processpairs", false, "Process pairs: false = no, just singles, true = yes, process pairs"};
+  Configurable<bool> cfgBinnedPairs{"binnedpairs", true, "Accumulate the pairs by (eta,phi) bin pairs: false = no, pair by pair, true = yes. Pair cuts force the pair by pair accumulation"};
   Configurable<std::string> cfgCentSpec{"centralities", "00-05,05-10,10-20,20-30,30-40,40-50,50-60,60-70,70-80", "Centrality/multiplicity ranges in min-max separated by commas"};
 
   Configurable<o2::analysis::DptDptBinningCuts> cfgBinning{"binning",
@@ -584,6 +799,7 @@ struct DptDptCorrelationsTask {
     phiup = constants::math::TwoPI;
     phibinshift = cfgBinning->mPhibinshift;
     processpairs = cfgProcessPairs.value;
+    binnedpairs = cfgBinnedPairs.value;
     loadfromccdb = cfginputfile.cfgCCDBPathName->length() > 0;
     /* update the potential binning change */
     etabinwidth = (etaup - etalow) / float(etabins);
@@ -666,6 +882,9 @@ struct DptDptCorrelationsTask {
       fPairCuts.SetTwoTrackCuts(cfgTwoTrackCut, cfgTwoTrackCutMinRadius);
       fUseTwoTrackCut = true;
     }
+    if (processpairs and binnedpairs and (fUseConversionCuts or fUseTwoTrackCut)) {
+      LOGF(info, "Pair cuts are active, the pairs will be accumulated pair by pair");
+    }
 
     /* initialize access to the CCDB */
     ccdb->setURL(cfginputfile.cfgCCDBUrl);
@@ -71,6 +71,10 @@ struct GenericFramework {
   // define global variables
   GFW* fGFW = new GFW();
   std::vector<GFW::CorrConfig> corrconfigs;
+  std::vector<int> corrIndices; // index of each correlator in the FlowContainer
+  std::vector<int> fillIndices; // correlators of the event, filled at once
+  std::vector<double> fillValues;
+  std::vector<double> fillWeights;
   TRandom3* fRndm = new TRandom3(0);
 
   void init(InitContext const&)
@@ -120,9 +124,11 @@ struct GenericFramework {
     corrconfigs.push_back(fGFW->GetCorrelatorConfig("refP {4} refN {-4}", "ChGap42", kFALSE));
     corrconfigs.push_back(fGFW->GetCorrelatorConfig("refP {2 4} refN {-2 -4}", "ChSC244", kFALSE));
     corrconfigs.push_back(fGFW->GetCorrelatorConfig("refP {2 3} refN {-2 -3}", "ChSC234", kFALSE));
+    for (const auto& corrconf : corrconfigs)
+      corrIndices.push_back(fFC->GetProfileIndex(corrconf.Head.Data()));
   }
 
-  void FillFC(const GFW::CorrConfig& corrconf, const double& cent, const double& rndm)
+  void FillFC(const GFW::CorrConfig& corrconf, const int& corrIndex)
   {
     double dnx, val;
     dnx = fGFW->Calculate(corrconf, 0, kTRUE).Re();
@@ -130,8 +136,11 @@ struct GenericFramework {
       return;
     if (!corrconf.pTDif) {
       val = fGFW->Calculate(corrconf, 0, kFALSE).Re() / dnx;
-      if (TMath::Abs(val) < 1)
-        fFC->FillProfile(corrconf.Head.Data(), cent, val, 1, rndm);
+      if (TMath::Abs(val) < 1) {
+        fillIndices.push_back(corrIndex);
+        fillValues.push_back(val);
+        fillWeights.push_back(1);
+      }
       return;
     }
     return;
@@ -182,9 +191,13 @@ struct GenericFramework {
 
       fGFW->Fill(track.eta(), 1, track.phi(), wacc * weff, 3);
     }
+    fillIndices.clear();
+    fillValues.clear();
+    fillWeights.clear();
     for (unsigned long int l_ind = 0; l_ind < corrconfigs.size(); l_ind++) {
-      FillFC(corrconfigs.at(l_ind), centrality, l_Random);
+      FillFC(corrconfigs.at(l_ind), corrIndices.at(l_ind));
     };
+    fFC->FillProfiles(fillIndices.size(), fillIndices.data(), centrality, fillValues.data(), fillWeights.data(), l_Random);
   }
 };
 
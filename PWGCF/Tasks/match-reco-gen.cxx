@@ -45,8 +45,8 @@ using namespace o2::framework::expressions;
 
 namespace o2::analysis::recogenmap
 {
-std::vector<std::vector<int64_t>> mclabelpos[2];
-std::vector<std::vector<int64_t>> mclabelneg[2];
+o2::analysis::dptdptfilter::RecoGenMap mclabelpos[2];
+o2::analysis::dptdptfilter::RecoGenMap mclabelneg[2];
 } // namespace o2::analysis::recogenmap
 
 /// \brief Checks the correspondence generator level <=> detector level
@@ -198,15 +198,14 @@ struct CheckGeneratorLevelVsDetectorLevel {
     static constexpr std::string_view colldir[] = {"positivecolid/", "negativecolid/"};
 
     int nrec_poslabel = 0;
-    int nrec_neglabel = 0;
     int nrec_poslabel_crosscoll = 0;
+    int nrec_neglabel = mclabelneg[collsign].ntracks();
 
     for (int ixpart = 0; ixpart < mcParticles.size(); ++ixpart) {
       auto particle = mcParticles.iteratorAt(ixpart);
       /* multireconstructed tracks only for positive labels */
-      int nrec = mclabelpos[collsign][ixpart].size();
-      nrec_poslabel += mclabelpos[collsign][ixpart].size();
-      nrec_neglabel += mclabelneg[collsign][ixpart].size();
+      int nrec = mclabelpos[collsign].size(ixpart);
+      nrec_poslabel += nrec;
 
       if (nrec > 1) {
         /* multireconstruction only from positive labels */
@@ -215,10 +214,10 @@ struct CheckGeneratorLevelVsDetectorLevel {
         if (collsign == kPOSITIVE) {
           /* check the cross collision reconstruction */
           bool crosscollfound = false;
-          for (unsigned int i = 0; (i < mclabelpos[collsign][ixpart].size()) and not crosscollfound; ++i) {
-            for (unsigned int j = i + 1; (j < mclabelpos[collsign][ixpart].size()) and not crosscollfound; ++j) {
-              auto track1 = tracks.iteratorAt(mclabelpos[collsign][ixpart][i]);
-              auto track2 = tracks.iteratorAt(mclabelpos[collsign][ixpart][j]);
+          for (int i = 0; (i < mclabelpos[collsign].size(ixpart)) and not crosscollfound; ++i) {
+            for (int j = i + 1; (j < mclabelpos[collsign].size(ixpart)) and not crosscollfound; ++j) {
+              auto track1 = tracks.iteratorAt(mclabelpos[collsign].track(ixpart, i));
+              auto track2 = tracks.iteratorAt(mclabelpos[collsign].track(ixpart, j));
 
               if (track1.collisionId() != track2.collisionId()) {
                 nrec_poslabel_crosscoll++;
@@ -232,8 +231,8 @@ struct CheckGeneratorLevelVsDetectorLevel {
               LOGF(info, "Particle with index %d and pdg code %d assigned to MC collision %d, pT: %f, phi: %f, eta: %f",
                    particle.globalIndex(), particle.pdgCode(), particle.mcCollisionId(), particle.pt(), particle.phi(), particle.eta());
               LOGF(info, "With status %d and flags %0X and multi-reconstructed as: ==================================", particle.statusCode(), particle.flags());
-              for (unsigned int i = 0; i < mclabelpos[collsign][ixpart].size(); ++i) {
-                auto track = tracks.iteratorAt(mclabelpos[collsign][ixpart][i]);
+              for (int i = 0; i < mclabelpos[collsign].size(ixpart); ++i) {
+                auto track = tracks.iteratorAt(mclabelpos[collsign].track(ixpart, i));
                 auto coll = colls.iteratorAt(track.collisionId());
                 LOGF(info, "Track with index %d and label %d assigned to collision %d, with associated MC collision %d",
                      track.globalIndex(), ixpart, track.collisionId(), coll.mcCollisionId());
@@ -244,10 +243,10 @@ struct CheckGeneratorLevelVsDetectorLevel {
           }
         }
 
-        for (unsigned int i = 0; i < mclabelpos[collsign][ixpart].size(); ++i) {
-          auto track1 = tracks.iteratorAt(mclabelpos[collsign][ixpart][i]);
-          for (unsigned int j = i + 1; j < mclabelpos[collsign][ixpart].size(); ++j) {
-            auto track2 = tracks.iteratorAt(mclabelpos[collsign][ixpart][j]);
+        for (int i = 0; i < mclabelpos[collsign].size(ixpart); ++i) {
+          auto track1 = tracks.iteratorAt(mclabelpos[collsign].track(ixpart, i));
+          for (int j = i + 1; j < mclabelpos[collsign].size(ixpart); ++j) {
+            auto track2 = tracks.iteratorAt(mclabelpos[collsign].track(ixpart, j));
 
             float deltaeta = track1.eta() - track2.eta();
             float deltaphi = track1.phi() - track2.phi();
@@ -285,7 +284,7 @@ struct CheckGeneratorLevelVsDetectorLevel {
           }
         }
       } else if (nrec > 0) {
-        auto track = tracks.iteratorAt(mclabelpos[collsign][ixpart][0]);
+        auto track = tracks.iteratorAt(mclabelpos[collsign].track(ixpart, 0));
         histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("genrecoeta"), track.eta(), particle.eta());
         histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("genrecophi"), track.phi(), particle.phi());
         histos.fill(HIST(dir[ba]) + HIST(colldir[collsign]) + HIST("genrecopt"), track.pt(), particle.pt());
@@ -323,53 +322,28 @@ struct CheckGeneratorLevelVsDetectorLevel {
   }
 
   template <typename TracksObject, typename CollisionsObject>
-  void processMapChecksBeforeCuts(TracksObject const& tracks, CollisionsObject const& collisions, aod::McParticles const& mcParticles)
+  void processMapChecksBeforeCuts(TracksObject const& tracks, CollisionsObject const& collisions, aod::McParticles const& mcParticles, size_t ngen)
   {
     using namespace o2::analysis::recogenmap;
     using namespace o2::analysis::dptdptfilter;
 
-    for (int i = 0; i < 2; ++i) {
-      mclabelpos[i].clear();
-      mclabelneg[i].clear();
-      mclabelpos[i].resize(mcParticles.size());
-      mclabelneg[i].resize(mcParticles.size());
-    }
-
     size_t nreco = tracks.size();
-    size_t ngen = 0;
-
-    for (auto& part : mcParticles) {
-      auto pdgpart = fPDG->GetParticle(part.pdgCode());
-      if (pdgpart != nullptr) {
-        float charge = (pdgpart->Charge() >= 3) ? 1.0 : ((pdgpart->Charge() <= -3) ? -1.0 : 0.0);
-        if (charge != 0.0) {
-          ngen++;
-        }
-      }
-    }
 
     // Let's go through the reco-gen mapping to detect multi-reconstructed particles
     // For the time being we are only interested in the information based on the reconstructed tracks
     LOGF(info, "New dataframe (DF) with %d generated charged particles and %d reconstructed tracks", ngen, nreco);
 
     for (auto& track : tracks) {
-      int64_t recix = track.globalIndex();
-      int32_t label = track.mcParticleId();
-
-      LOGF(MATCHRECGENLOGTRACKS, "Track with global Id %d and collision Id %d has label %d associated to MC collision %d", recix, track.collisionId(), label, track.template mcParticle_as<aod::McParticles>().mcCollisionId());
-      if (track.collisionId() < 0) {
-        if (label >= 0) {
-          mclabelpos[kNEGATIVE][label].push_back(recix);
-        } else {
-          mclabelneg[kNEGATIVE][-label].push_back(recix);
-        }
-      } else {
-        if (label >= 0) {
-          mclabelpos[kPOSITIVE][label].push_back(recix);
-        } else {
-          mclabelneg[kPOSITIVE][-label].push_back(recix);
-        }
-      }
+      LOGF(MATCHRECGENLOGTRACKS, "Track with global Id %d and collision Id %d has label %d associated to MC collision %d", track.globalIndex(), track.collisionId(), track.mcParticleId(), track.template mcParticle_as<aod::McParticles>().mcCollisionId());
+    }
+    /* the maps for tracks with positive and negative collision Id, the negative labels are mapped to their absolute value */
+    for (int collsign : {kPOSITIVE, kNEGATIVE}) {
+      mclabelpos[collsign].build(tracks, mcParticles.size(), [collsign](auto const& track) -> int64_t {
+        return ((track.collisionId() < 0) == (collsign == kNEGATIVE) and not(track.mcParticleId() < 0)) ? track.mcParticleId() : -1;
+      });
+      mclabelneg[collsign].build(tracks, mcParticles.size(), [collsign](auto const& track) -> int64_t {
+        return ((track.collisionId() < 0) == (collsign == kNEGATIVE) and (track.mcParticleId() < 0)) ? -track.mcParticleId() : -1;
+      });
     }
 
     collectData<kBEFORE, kPOSITIVE>(tracks, mcParticles, collisions);
@@ -377,34 +351,17 @@ struct CheckGeneratorLevelVsDetectorLevel {
   }
 
   template <typename TracksObject, typename CollisionsObject>
-  void processMapChecksAfterCuts(TracksObject const& tracks, CollisionsObject const& collisions, aod::McParticles const& mcParticles)
+  void processMapChecksAfterCuts(TracksObject const& tracks, CollisionsObject const& collisions, aod::McParticles const& mcParticles, size_t ngen)
   {
     using namespace o2::analysis::recogenmap;
     using namespace o2::analysis::dptdptfilter;
 
-    for (int i = 0; i < 2; ++i) {
-      mclabelpos[i].clear();
-      mclabelneg[i].clear();
-      mclabelpos[i].resize(mcParticles.size());
-      mclabelneg[i].resize(mcParticles.size());
-    }
-
     size_t nreco = 0;
-    size_t ngen = 0;
-
-    for (auto& part : mcParticles) {
-      auto pdgpart = fPDG->GetParticle(part.pdgCode());
-      if (pdgpart != nullptr) {
-        float charge = (pdgpart->Charge() >= 3) ? 1.0 : ((pdgpart->Charge() <= -3) ? -1.0 : 0.0);
-        if (charge != 0.0) {
-          ngen++;
-        }
-      }
-    }
 
+    /* only the accepted tracks with positive labels are considered */
+    mclabelneg[kPOSITIVE].clear();
     // Let's go through the reco-gen mapping to detect multi-reconstructed particles
-    for (auto& track : tracks) {
-      int64_t recix = track.globalIndex();
+    mclabelpos[kPOSITIVE].build(tracks, mcParticles.size(), [&](auto const& track) -> int64_t {
       int32_t label = track.mcParticleId();
       if (not(label < 0)) {
         if (not(track.collisionId() < 0)) {
@@ -419,13 +376,14 @@ struct CheckGeneratorLevelVsDetectorLevel {
             if ((asone == uint8_t(true)) or (astwo == uint8_t(true))) {
               /* the track has been accepted */
               nreco++;
-              LOGF(MATCHRECGENLOGTRACKS, "Accepted track with global Id %d and collision Id %d has label %d associated to MC collision %d", recix, track.collisionId(), label, track.template mcParticle_as<aod::McParticles>().mcCollisionId());
-              mclabelpos[kPOSITIVE][label].push_back(recix);
+              LOGF(MATCHRECGENLOGTRACKS, "Accepted track with global Id %d and collision Id %d has label %d associated to MC collision %d", track.globalIndex(), track.collisionId(), label, track.template mcParticle_as<aod::McParticles>().mcCollisionId());
+              return label;
             }
           }
         }
       }
-    }
+      return -1;
+    });
     LOGF(info, "New dataframe (DF) with %d generated charged particles and %d reconstructed accepted tracks", ngen, nreco);
 
     collectData<kAFTER, kPOSITIVE>(tracks, mcParticles, collisions);
@@ -435,8 +393,9 @@ struct CheckGeneratorLevelVsDetectorLevel {
                                 soa::Join<aod::CollisionsEvSelCent, aod::McCollisionLabels> const& collisions,
                                 aod::McParticles const& mcParticles)
   {
-    processMapChecksBeforeCuts(tracks, collisions, mcParticles);
-    processMapChecksAfterCuts(tracks, collisions, mcParticles);
+    size_t ngen = o2::analysis::dptdptfilter::countChargedParticles(mcParticles);
+    processMapChecksBeforeCuts(tracks, collisions, mcParticles, ngen);
+    processMapChecksAfterCuts(tracks, collisions, mcParticles, ngen);
   }
   PROCESS_SWITCH(CheckGeneratorLevelVsDetectorLevel, processMapChecksWithCent, "Process detector <=> generator levels with centrality/multiplicity information", false);
 
@@ -444,8 +403,9 @@ struct CheckGeneratorLevelVsDetectorLevel {
                                    soa::Join<aod::CollisionsEvSel, aod::McCollisionLabels> const& collisions,
                                    aod::McParticles const& mcParticles)
   {
-    processMapChecksBeforeCuts(tracks, collisions, mcParticles);
-    processMapChecksAfterCuts(tracks, collisions, mcParticles);
+    size_t ngen = o2::analysis::dptdptfilter::countChargedParticles(mcParticles);
+    processMapChecksBeforeCuts(tracks, collisions, mcParticles, ngen);
+    processMapChecksAfterCuts(tracks, collisions, mcParticles, ngen);
   }
   PROCESS_SWITCH(CheckGeneratorLevelVsDetectorLevel, processMapChecksWithoutCent, "Process detector <=> generator levels without centrality/multiplicity information", true);
 };
@@ -769,6 +769,15 @@ std::vector<bool> CutBrickSelectorMultipleRanges<TValueToFilter>::Filter(const T
   return std::vector<bool>(mActive);
 }
 
+/// \brief Appends the flat form of the brick components, one per range
+template <typename TValueToFilter>
+void CutBrickSelectorMultipleRanges<TValueToFilter>::Compile(std::vector<CompiledCutBrick<TValueToFilter>>& compiled)
+{
+  for (unsigned int i = 0; i < mActive.size(); ++i) {
+    compiled.push_back({CompiledCutBrick<TValueToFilter>::kBIN, mEdges[i], mEdges[i + 1]});
+  }
+}
+
 templateClassImp(CutBrickSelectorMultipleRanges);
 template class o2::analysis::PWGCF::CutBrickSelectorMultipleRanges<int>;
 template class o2::analysis::PWGCF::CutBrickSelectorMultipleRanges<float>;
@@ -987,6 +996,18 @@ std::vector<bool> CutWithVariations<TValueToFilter>::Filter(const TValueToFilter
   return res;
 }
 
+/// \brief Appends the flat form of the default and variation bricks, in the order used by Filter
+template <typename TValueToFilter>
+void CutWithVariations<TValueToFilter>::Compile(std::vector<CompiledCutBrick<TValueToFilter>>& compiled)
+{
+  for (int i = 0; i < mDefaultBricks.GetEntries(); ++i) {
+    ((CutBrick<TValueToFilter>*)mDefaultBricks.At(i))->Compile(compiled);
+  }
+  for (int i = 0; i < mVariationBricks.GetEntries(); ++i) {
+    ((CutBrick<TValueToFilter>*)mVariationBricks.At(i))->Compile(compiled);
+  }
+}
+
 /// Return the length needed to code the cut
 /// The length is in brick units. The actual length is implementation dependent
 /// \returns Cut length in units of bricks
@@ -32,6 +32,24 @@ namespace analysis
 {
 namespace PWGCF
 {
+/// \struct CompiledCutBrick
+/// \brief Flat form of a basic cut brick component, as used by the CutBrickEvaluator
+template <typename TValueToFilter>
+struct CompiledCutBrick {
+  /// \enum CompiledCutType
+  /// \brief The condition for the component to be active
+  enum CompiledCutType {
+    kLIMIT,      ///< value < up
+    kTHRESHOLD,  ///< low < value
+    kRANGE,      ///< low < value < up
+    kEXTTORANGE, ///< value < low or up < value
+    kBIN         ///< low <= value < up
+  };
+  CompiledCutType mType; ///< the condition of the component
+  TValueToFilter mLow;   ///< the lower value of the condition
+  TValueToFilter mUp;    ///< the upper value of the condition
+};
+
 /// \class CutBrick
 /// \brief Virtual class which implements the base component of the selection cuts
 ///
@@ -57,6 +75,9 @@ class CutBrick : public TNamed
   /// fits within the brick or brick components scope
   /// \returns a vector of booleans with true on the component for which the value activated the component brick
   virtual std::vector<bool> Filter(const TValueToFilter&) = 0;
+  /// Pure virtual function. Appends to the passed list the flat form of the brick components
+  /// in the order of the ones returned by Filter, this is, one per brick unit of Length()
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) = 0;
   /// Pure virtual function. Return the length needed to code the brick status
   /// The length is in brick units. The actual length is implementation dependent
   /// \returns Brick length in units of bricks
@@ -113,6 +134,7 @@ class CutBrickLimit : public CutBrick<TValueToFilter>
 
   virtual std::vector<bool> IsArmed() override;
   virtual std::vector<bool> Filter(const TValueToFilter&) override;
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>& compiled) override { compiled.push_back({CompiledCutBrick<TValueToFilter>::kLIMIT, mLimit, mLimit}); }
   virtual int Length() override { return 1; }
 
  private:
@@ -161,6 +183,12 @@ class CutBrickFnLimit : public CutBrickLimit<TValueToFilter>
     this->mLimit = TValueToFilter(mFunction.Eval(x));
   }
 
+  /// the limit change with the independent variable so the brick cannot be compiled
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) override
+  {
+    LOGF(fatal, "CutBrickFnLimit::Compile(). Function based bricks cannot be compiled, %s", this->GetName());
+  }
+
  private:
   void ConstructCutFromString(const TString&);
 
@@ -184,6 +212,7 @@ class CutBrickThreshold : public CutBrick<TValueToFilter>
 
   virtual std::vector<bool> IsArmed() override;
   virtual std::vector<bool> Filter(const TValueToFilter&) override;
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>& compiled) override { compiled.push_back({CompiledCutBrick<TValueToFilter>::kTHRESHOLD, mThreshold, mThreshold}); }
   virtual int Length() override { return 1; }
 
  private:
@@ -232,6 +261,12 @@ class CutBrickFnThreshold : public CutBrickThreshold<TValueToFilter>
     this->mThreshold = TValueToFilter(mFunction.Eval(x));
   }
 
+  /// the threshold change with the independent variable so the brick cannot be compiled
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) override
+  {
+    LOGF(fatal, "CutBrickFnThreshold::Compile(). Function based bricks cannot be compiled, %s", this->GetName());
+  }
+
  private:
   void ConstructCutFromString(const TString&);
 
@@ -255,6 +290,7 @@ class CutBrickRange : public CutBrick<TValueToFilter>
 
   virtual std::vector<bool> IsArmed() override;
   virtual std::vector<bool> Filter(const TValueToFilter&) override;
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>& compiled) override { compiled.push_back({CompiledCutBrick<TValueToFilter>::kRANGE, mLow, mUp}); }
   virtual int Length() override { return 1; }
 
  private:
@@ -305,6 +341,12 @@ class CutBrickFnRange : public CutBrickRange<TValueToFilter>
     this->mUp = TValueToFilter(mUpFunction.Eval(x));
   }
 
+  /// the limits change with the independent variable so the brick cannot be compiled
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) override
+  {
+    LOGF(fatal, "CutBrickFnRange::Compile(). Function based bricks cannot be compiled, %s", this->GetName());
+  }
+
  private:
   void ConstructCutFromString(const TString&);
 
@@ -329,6 +371,7 @@ class CutBrickExtToRange : public CutBrick<TValueToFilter>
 
   virtual std::vector<bool> IsArmed() override;
   virtual std::vector<bool> Filter(const TValueToFilter&) override;
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>& compiled) override { compiled.push_back({CompiledCutBrick<TValueToFilter>::kEXTTORANGE, mLow, mUp}); }
   virtual int Length() override { return 1; }
 
  private:
@@ -379,6 +422,12 @@ class CutBrickFnExtToRange : public CutBrickExtToRange<TValueToFilter>
     this->mUp = TValueToFilter(mUpFunction.Eval(x));
   }
 
+  /// the limits change with the independent variable so the brick cannot be compiled
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) override
+  {
+    LOGF(fatal, "CutBrickFnExtToRange::Compile(). Function based bricks cannot be compiled, %s", this->GetName());
+  }
+
  private:
   void ConstructCutFromString(const TString&);
 
@@ -405,6 +454,7 @@ class CutBrickSelectorMultipleRanges : public CutBrick<TValueToFilter>
 
   virtual std::vector<bool> IsArmed() override;
   virtual std::vector<bool> Filter(const TValueToFilter&) override;
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) override;
   /// Return the length needed to code the brick status
   /// The length is in brick units. The actual length is implementation dependent
   /// \returns Brick length in units of bricks
@@ -439,6 +489,7 @@ class CutWithVariations : public CutBrick<TValueToFilter>
   TList& getVariantBricks() { return mVariationBricks; }
   virtual std::vector<bool> IsArmed() override;
   virtual std::vector<bool> Filter(const TValueToFilter&) override;
+  virtual void Compile(std::vector<CompiledCutBrick<TValueToFilter>>&) override;
   virtual int Length() override;
   virtual int getArmedIndex() override;
 
@@ -451,6 +502,66 @@ class CutWithVariations : public CutBrick<TValueToFilter>
   ClassDef(CutWithVariations, 1);
 };
 
+/// \class CutBrickEvaluator
+/// \brief Flat evaluator of a cut brick over whole columns of values
+/// The brick is compiled once at construction. The evaluation neither allocates nor goes through
+/// virtual calls, and it does not change the status of the brick
+template <typename TValueToFilter>
+class CutBrickEvaluator
+{
+ public:
+  CutBrickEvaluator() = default;
+  explicit CutBrickEvaluator(CutBrick<TValueToFilter>* brick)
+  {
+    if (brick != nullptr) {
+      brick->Compile(mCuts);
+    }
+  }
+
+  /// The number of bits the brick takes in the mask, the brick Length()
+  int Length() const { return mCuts.size(); }
+
+  /// Filters a column of values
+  /// \param values the values to filter
+  /// \param n the number of values
+  /// \param masks the masks of the values, the bit firstbit + i is set if the brick component i is active
+  /// \param firstbit the bit of the first brick component
+  void Filter(const TValueToFilter* values, size_t n, uint64_t* masks, int firstbit) const
+  {
+    for (unsigned int icut = 0; icut < mCuts.size(); ++icut) {
+      const auto& cut = mCuts[icut];
+      const uint64_t bit = 1UL << (firstbit + icut);
+      auto setbits = [&](auto isactive) {
+        for (size_t i = 0; i < n; ++i) {
+          masks[i] |= isactive(values[i]) ? bit : 0UL;
+        }
+      };
+      const TValueToFilter low = cut.mLow;
+      const TValueToFilter up = cut.mUp;
+      switch (cut.mType) {
+        case CompiledCutBrick<TValueToFilter>::kLIMIT:
+          setbits([up](TValueToFilter value) { return value < up; });
+          break;
+        case CompiledCutBrick<TValueToFilter>::kTHRESHOLD:
+          setbits([low](TValueToFilter value) { return low < value; });
+          break;
+        case CompiledCutBrick<TValueToFilter>::kRANGE:
+          setbits([low, up](TValueToFilter value) { return (low < value) and (value < up); });
+          break;
+        case CompiledCutBrick<TValueToFilter>::kEXTTORANGE:
+          setbits([low, up](TValueToFilter value) { return (value < low) or (up < value); });
+          break;
+        case CompiledCutBrick<TValueToFilter>::kBIN:
+          setbits([low, up](TValueToFilter value) { return (low <= value) and (value < up); });
+          break;
+      }
+    }
+  }
+
+ private:
+  std::vector<CompiledCutBrick<TValueToFilter>> mCuts; ///< the flat brick components
+};
+
 /// \class SpecialCutBrick
 /// \brief Virtual class which implements the base component of the special selection cuts
 /// Special selection cuts are needed because the tables access seems cannot be
@@ -119,6 +119,7 @@ TrackSelectionFilterAndAnalysis::TrackSelectionFilterAndAnalysis()
   /* at least we initialize by default pT and eta cuts */
   mPtRange = CutBrick<float>::constructBrick("pT", "rg{0.2,10}", std::set<std::string>{"rg"});
   mEtaRange = CutBrick<float>::constructBrick("eta", "rg{-0.8,0.8}", std::set<std::string>{"rg"});
+  CompileBricks();
 }
 
 /// \brief Constructor from regular expression
@@ -258,6 +259,7 @@ void TrackSelectionFilterAndAnalysis::SetPtRange(const TString& regex)
   }
   mPtRange = CutBrick<float>::constructBrick("pT", regex.Data(), std::set<std::string>{"rg", "th", "lim", "xrg"});
   mMaskLength = CalculateMaskLength();
+  CompileBricks();
 }
 
 void TrackSelectionFilterAndAnalysis::SetEtaRange(const TString& regex)
@@ -267,6 +269,7 @@ void TrackSelectionFilterAndAnalysis::SetEtaRange(const TString& regex)
   }
   mEtaRange = CutBrick<float>::constructBrick("eta", regex.Data(), std::set<std::string>{"rg", "th", "lim", "xrg"});
   mMaskLength = CalculateMaskLength();
+  CompileBricks();
 }
 
 void TrackSelectionFilterAndAnalysis::ConstructCutFromString(const TString& cutstr)
@@ -391,6 +394,26 @@ void TrackSelectionFilterAndAnalysis::ConstructCutFromString(const TString& cuts
     }
   }
   mMaskLength = CalculateMaskLength();
+  CompileBricks();
+}
+
+/// \brief Compiles the cut bricks into the flat evaluators of the batch filter
+void TrackSelectionFilterAndAnalysis::CompileBricks()
+{
+  mTrackSignEvaluators.clear();
+  for (int i = 0; i < mTrackSign.GetEntries(); ++i) {
+    mTrackSignEvaluators.emplace_back((CutBrick<float>*)mTrackSign.At(i));
+  }
+  mNClustersTPCEvaluator = CutBrickEvaluator<int>(mNClustersTPC);
+  mNCrossedRowsTPCEvaluator = CutBrickEvaluator<int>(mNCrossedRowsTPC);
+  mNClustersITSEvaluator = CutBrickEvaluator<int>(mNClustersITS);
+  mMaxChi2PerClusterTPCEvaluator = CutBrickEvaluator<float>(mMaxChi2PerClusterTPC);
+  mMaxChi2PerClusterITSEvaluator = CutBrickEvaluator<float>(mMaxChi2PerClusterITS);
+  mMinNCrossedRowsOverFindableClustersTPCEvaluator = CutBrickEvaluator<float>(mMinNCrossedRowsOverFindableClustersTPC);
+  mMaxDcaXYEvaluator = CutBrickEvaluator<float>(mMaxDcaXY);
+  mMaxDcaZEvaluator = CutBrickEvaluator<float>(mMaxDcaZ);
+  mPtRangeEvaluator = CutBrickEvaluator<float>(mPtRange);
+  mEtaRangeEvaluator = CutBrickEvaluator<float>(mEtaRange);
 }
 
 /// \brief Fills the filter cuts mask
@@ -102,11 +102,14 @@ class TrackSelectionFilterAndAnalysis : public SelectionFilterAndAnalysis
 
   template <typename TrackToFilter>
   uint64_t Filter(TrackToFilter const& track);
+  template <typename TracksToFilter>
+  void Filter(TracksToFilter const& tracks, std::vector<uint64_t>& masks);
 
  private:
   void ConstructCutFromString(const TString&);
   int CalculateMaskLength();
   void StoreArmedMask();
+  void CompileBricks();
 
   TList mTrackSign;                                         /// the track charge sign list
   TList mTrackTypes;                                        /// the track types to select list
@@ -121,6 +124,22 @@ class TrackSelectionFilterAndAnalysis : public SelectionFilterAndAnalysis
   CutBrick<float>* mPtRange;                                //! the pT range cuts
   CutBrick<float>* mEtaRange;                               //! the eta range cuts
 
+  /* the compiled bricks for the batch filter */
+  std::vector<CutBrickEvaluator<float>> mTrackSignEvaluators;                //! the track charge sign cuts
+  CutBrickEvaluator<int> mNClustersTPCEvaluator;                             //! the number of TPC clusters cuts
+  CutBrickEvaluator<int> mNCrossedRowsTPCEvaluator;                          //! the number of TPC crossed rows cuts
+  CutBrickEvaluator<int> mNClustersITSEvaluator;                             //! the number of ITS clusters cuts
+  CutBrickEvaluator<float> mMaxChi2PerClusterTPCEvaluator;                   //! the max Chi2 per TPC cluster cuts
+  CutBrickEvaluator<float> mMaxChi2PerClusterITSEvaluator;                   //! the max Chi2 per ITS cluster cuts
+  CutBrickEvaluator<float> mMinNCrossedRowsOverFindableClustersTPCEvaluator; //! the min ration crossed TPC rows over findable TPC clusters cuts
+  CutBrickEvaluator<float> mMaxDcaXYEvaluator;                               //! the DCAxy cuts
+  CutBrickEvaluator<float> mMaxDcaZEvaluator;                                //! the DCAz cuts
+  CutBrickEvaluator<float> mPtRangeEvaluator;                                //! the pT range cuts
+  CutBrickEvaluator<float> mEtaRangeEvaluator;                               //! the eta range cuts
+  std::vector<int> mIntColumn;                                               //! the values of an integer column of the filtered tracks
+  std::vector<float> mFloatColumn;                                           //! the values of a float column of the filtered tracks
+  std::vector<uint64_t> mRangeMask;                                          //! the pT and eta range masks of the filtered tracks
+
   ClassDef(TrackSelectionFilterAndAnalysis, 1)
 };
 
@@ -194,13 +213,75 @@ uint64_t TrackSelectionFilterAndAnalysis::Filter(TrackToFilter const& track)
     }
   }
   if (mEtaRange != nullptr) {
-    if (not filterBrickValueNoMask(mEtaRange, track.pt())) {
+    if (not filterBrickValueNoMask(mEtaRange, track.eta())) {
       selectedMask = 0UL;
     }
   }
   return mSelectedMask = selectedMask;
 }
 
+/// \brief Fills the filter cuts masks of a whole table of tracks
+/// Same masks as the track by track filter, but each cut goes once over the column of its variable
+/// \param tracks the tracks to filter
+/// \param masks the filter cuts masks, one per track
+template <typename TracksToFilter>
+void TrackSelectionFilterAndAnalysis::Filter(TracksToFilter const& tracks, std::vector<uint64_t>& masks)
+{
+  const size_t ntracks = tracks.size();
+  masks.assign(ntracks, 0UL);
+  int bit = 0;
+
+  auto filterColumn = [&](auto const& evaluator, auto& column, auto getvalue, uint64_t* colmasks, int firstbit) {
+    column.resize(ntracks);
+    size_t i = 0;
+    for (auto const& track : tracks) {
+      column[i++] = getvalue(track);
+    }
+    evaluator.Filter(column.data(), ntracks, colmasks, firstbit);
+  };
+  auto filterBrickColumn = [&](auto const& evaluator, auto& column, auto getvalue) {
+    if (evaluator.Length() != 0) {
+      filterColumn(evaluator, column, getvalue, masks.data(), bit);
+      bit += evaluator.Length();
+    }
+  };
+  auto filterRangeColumn = [&](auto const& evaluator, auto getvalue) {
+    if (evaluator.Length() != 0) {
+      mRangeMask.assign(ntracks, 0UL);
+      filterColumn(evaluator, mFloatColumn, getvalue, mRangeMask.data(), 0);
+      for (size_t i = 0; i < ntracks; ++i) {
+        masks[i] = (mRangeMask[i] != 0UL) ? masks[i] : 0UL;
+      }
+    }
+  };
+
+  for (auto const& evaluator : mTrackSignEvaluators) {
+    filterBrickColumn(evaluator, mFloatColumn, [](auto const& track) -> float { return track.sign(); });
+  }
+  for (int itype = 0; itype < mTrackTypes.GetEntries(); ++itype) {
+    TrackSelectionBrick* ttype = (TrackSelectionBrick*)mTrackTypes.At(itype);
+    size_t i = 0;
+    for (auto const& track : tracks) {
+      if (ttype->Filter(track)) {
+        SETBIT(masks[i], bit);
+      }
+      i++;
+    }
+    bit++;
+  }
+  filterBrickColumn(mNClustersTPCEvaluator, mIntColumn, [](auto const& track) -> int { return track.tpcNClsFound(); });
+  filterBrickColumn(mNCrossedRowsTPCEvaluator, mIntColumn, [](auto const& track) -> int { return track.tpcNClsCrossedRows(); });
+  filterBrickColumn(mNClustersITSEvaluator, mIntColumn, [](auto const& track) -> int { return track.itsNCls(); });
+  filterBrickColumn(mMaxChi2PerClusterTPCEvaluator, mFloatColumn, [](auto const& track) -> float { return track.tpcChi2NCl(); });
+  filterBrickColumn(mMaxChi2PerClusterITSEvaluator, mFloatColumn, [](auto const& track) -> float { return track.itsChi2NCl(); });
+  filterBrickColumn(mMinNCrossedRowsOverFindableClustersTPCEvaluator, mFloatColumn, [](auto const& track) -> float { return track.tpcCrossedRowsOverFindableCls(); });
+  filterBrickColumn(mMaxDcaXYEvaluator, mFloatColumn, [](auto const& track) -> float { return track.dcaXY(); });
+  filterBrickColumn(mMaxDcaZEvaluator, mFloatColumn, [](auto const& track) -> float { return track.dcaZ(); });
+  /* the pT and eta ranges don't go to the mask but reject the track */
+  filterRangeColumn(mPtRangeEvaluator, [](auto const& track) -> float { return track.pt(); });
+  filterRangeColumn(mEtaRangeEvaluator, [](auto const& track) -> float { return track.eta(); });
+}
+
 } // namespace PWGCF
 } // namespace analysis
 } // namespace o2
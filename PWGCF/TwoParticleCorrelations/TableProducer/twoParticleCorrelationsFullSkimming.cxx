@@ -103,6 +103,7 @@ struct TwoParticleCorrelationsSkimming {
 #include "PWGCF/TwoParticleCorrelations/TableProducer/Productions/skimmingconf_20221115.cxx" // NOLINT
 
   int nReportedTracks;
+  std::vector<uint64_t> trkmasks; /// the track filter masks of the current collision
   int runNumber = 0;
   int bfield = 0;
   HistogramRegistry historeg;
@@ -225,8 +226,10 @@ struct TwoParticleCorrelationsSkimming {
       skimmedcollision(collision.posZ(), bc.runNumber(), bc.timestamp(), colmask, fFilterFramework->GetCollisionMultiplicities());
       int nFilteredTracks = 0;
       int nCollisionReportedTracks = 0;
+      fFilterFramework->FilterTracks(tracks, trkmasks);
+      int itrack = 0;
       for (auto const& track : tracks) {
-        auto trkmask = fFilterFramework->FilterTrack(track);
+        auto trkmask = trkmasks[itrack++];
         auto pidmask = fFilterFramework->FilterTrackPID(track);
         if (trkmask != 0UL) {
           skimmedtrack(skimmedcollision.lastIndex(), trkmask, track.pt(), track.eta(), track.phi());
@@ -262,8 +265,10 @@ struct TwoParticleCorrelationsSkimming {
       skimmedcollision(collision.posZ(), bc.runNumber(), bc.timestamp(), colmask, fFilterFramework->GetCollisionMultiplicities());
       int nFilteredTracks = 0;
       int nCollisionReportedTracks = 0;
+      fFilterFramework->FilterTracks(tracks, trkmasks);
+      int itrack = 0;
       for (auto const& track : tracks) {
-        auto trkmask = fFilterFramework->FilterTrack(track);
+        auto trkmask = trkmasks[itrack++];
         auto pidmask = fFilterFramework->FilterTrackPID(track);
         if (trkmask != 0UL) {
           skimmedtrack(skimmedcollision.lastIndex(), trkmask, track.pt(), track.eta(), track.phi());
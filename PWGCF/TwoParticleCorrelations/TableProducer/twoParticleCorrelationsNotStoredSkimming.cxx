@@ -231,6 +231,8 @@ struct TwoParticleCorrelationsTrackSkimming {
 
 #include "PWGCF/TwoParticleCorrelations/TableProducer/Productions/skimmingconf_20221115.cxx" // NOLINT
 
+  std::vector<uint64_t> trkmasks; /// the track filter masks of the current dataframe
+
   void init(InitContext const&)
   {
     using namespace cfskim;
@@ -267,13 +269,15 @@ struct TwoParticleCorrelationsTrackSkimming {
     skimmtrackpid.reserve(tracks.size());
 
     int nfilteredtracks = 0;
+    fFilterFramework->FilterTracks(tracks, trkmasks);
+    int itrack = 0;
     for (auto const& track : tracks) {
+      auto trkmask = trkmasks[itrack++];
       if (!track.has_collision()) {
         /* track not assigned to any collision */
         trackmask(0UL);
         skimmtrackpid(0UL);
       } else {
-        auto trkmask = fFilterFramework->FilterTrack(track);
         auto pidmask = fFilterFramework->FilterTrackPID(track);
         trackmask(trkmask);
         skimmtrackpid(pidmask);
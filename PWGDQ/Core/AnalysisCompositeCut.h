@@ -41,6 +41,8 @@ class AnalysisCompositeCut : public AnalysisCut
 
   bool GetUseAND() const { return fOptionUseAND; }
   int GetNCuts() const { return fCutList.size() + fCompositeCutList.size(); }
+  std::vector<AnalysisCut>& GetCutList() { return fCutList; }
+  std::vector<AnalysisCompositeCut>& GetCompositeCutList() { return fCompositeCutList; }
 
   bool IsSelected(float* values) override;
 
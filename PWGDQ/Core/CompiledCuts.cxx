@@ -0,0 +1,61 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "PWGDQ/Core/CompiledCuts.h"
+
+#include <iostream>
+
+using std::cout;
+using std::endl;
+
+//____________________________________________________________________________
+bool CompiledCuts::AddCut(AnalysisCut* cut)
+{
+  //
+  // flatten a cut and add it to the list of evaluated cuts
+  //
+  if (fOutputs.size() >= kMaxNCuts) {
+    cout << "Warning in CompiledCuts::AddCut(): Cannot add more than " << kMaxNCuts << " cuts, cut " << cut->GetName() << " not added" << endl;
+    return false;
+  }
+  fOutputs.push_back(AddNode(cut));
+  return true;
+}
+
+//____________________________________________________________________________
+int CompiledCuts::AddNode(AnalysisCut* cut)
+{
+  //
+  // add the node of a cut, after the nodes of its sub-cuts, and return its index
+  //
+  Node node = {kRanges, 0, 0};
+  if (cut->IsA() == AnalysisCompositeCut::Class()) {
+    auto* composite = static_cast<AnalysisCompositeCut*>(cut);
+    // same order as in AnalysisCompositeCut::IsSelected(): the simple cuts first, then the composite ones
+    std::vector<int> children;
+    for (auto& subCut : composite->GetCutList()) {
+      children.push_back(AddNode(&subCut));
+    }
+    for (auto& subCut : composite->GetCompositeCutList()) {
+      children.push_back(AddNode(&subCut));
+    }
+    node.fType = composite->GetUseAND() ? kAnd : kOr;
+    node.fBegin = fChildren.size();
+    fChildren.insert(fChildren.end(), children.begin(), children.end());
+    node.fEnd = fChildren.size();
+  } else {
+    node.fBegin = fRanges.size();
+    fRanges.insert(fRanges.end(), cut->GetCuts().begin(), cut->GetCuts().end());
+    node.fEnd = fRanges.size();
+  }
+  fNodes.push_back(node);
+  return fNodes.size() - 1;
+}
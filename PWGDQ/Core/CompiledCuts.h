@@ -0,0 +1,143 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Class evaluating a list of AnalysisCut / AnalysisCompositeCut objects at once.
+// The cut trees are flattened at configuration time into contiguous arrays of range checks and of AND/OR nodes,
+//   such that the evaluation needs no virtual calls and no copies of the cut objects,
+//   and returns the decisions of all the cuts (up to 64) as a bit map.
+//
+
+#ifndef CompiledCuts_H
+#define CompiledCuts_H
+
+#include "PWGDQ/Core/AnalysisCut.h"
+#include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include <cstdint>
+#include <vector>
+
+//_________________________________________________________________________
+class CompiledCuts
+{
+ public:
+  CompiledCuts() = default;
+  ~CompiledCuts() = default;
+
+  static constexpr int kMaxNCuts = 64;
+
+  // add a cut, its decision is given by the bit GetNCuts()-1 of the evaluated map
+  // NOTE: the cut is copied, later changes to the cut object have no effect
+  bool AddCut(AnalysisCut* cut);
+  int GetNCuts() const { return fOutputs.size(); }
+
+  // decisions of all the cuts for one array of values
+  uint64_t Evaluate(const float* values) const;
+  // decisions of all the cuts for a batch of arrays of values
+  void Evaluate(int nRows, const float* const* rows, uint64_t* decisions) const;
+
+ private:
+  enum NodeTypes {
+    kRanges = 0, // AND of the range checks [fBegin, fEnd) in fRanges
+    kAnd,        // AND of the nodes [fBegin, fEnd) in fChildren
+    kOr          // OR of the nodes [fBegin, fEnd) in fChildren
+  };
+
+  struct Node {
+    int fType;
+    int fBegin;
+    int fEnd;
+  };
+
+  int AddNode(AnalysisCut* cut);
+  bool EvaluateNode(int node, const float* values) const;
+  static bool EvaluateRange(const AnalysisCut::CutContainer& range, const float* values);
+
+  std::vector<AnalysisCut::CutContainer> fRanges; // range checks of all the cuts
+  std::vector<Node> fNodes;                       // nodes of all the cut trees, children are added before their parent
+  std::vector<int> fChildren;                     // children of the composite nodes
+  std::vector<int> fOutputs;                      // root node of each cut
+};
+
+//____________________________________________________________________________
+inline bool CompiledCuts::EvaluateRange(const AnalysisCut::CutContainer& range, const float* values)
+{
+  //
+  // same selection as in AnalysisCut::IsSelected(), for one range check
+  //
+  // a dependent variable outside its range (or inside, for exclusion) disables the check
+  if (range.fDepVar != -1) {
+    bool inRange = (values[range.fDepVar] > range.fDepLow && values[range.fDepVar] <= range.fDepHigh);
+    if (inRange == range.fDepExclude) {
+      return true;
+    }
+  }
+  if (range.fDepVar2 != -1) {
+    bool inRange = (values[range.fDepVar2] > range.fDep2Low && values[range.fDepVar2] <= range.fDep2High);
+    if (inRange == range.fDep2Exclude) {
+      return true;
+    }
+  }
+  float cutLow = range.fFuncLow ? range.fFuncLow->Eval(values[range.fDepVar]) : range.fLow;
+  float cutHigh = range.fFuncHigh ? range.fFuncHigh->Eval(values[range.fDepVar]) : range.fHigh;
+  bool inRange = (values[range.fVar] >= cutLow && values[range.fVar] <= cutHigh);
+  return inRange != range.fExclude;
+}
+
+//____________________________________________________________________________
+inline bool CompiledCuts::EvaluateNode(int node, const float* values) const
+{
+  //
+  // evaluate a node, stopping as soon as its decision is known
+  //
+  const Node& n = fNodes[node];
+  if (n.fType == kRanges) {
+    for (int i = n.fBegin; i < n.fEnd; ++i) {
+      if (!EvaluateRange(fRanges[i], values)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool useAND = (n.fType == kAnd);
+  for (int i = n.fBegin; i < n.fEnd; ++i) {
+    if (EvaluateNode(fChildren[i], values) != useAND) {
+      return !useAND;
+    }
+  }
+  return useAND;
+}
+
+//____________________________________________________________________________
+inline uint64_t CompiledCuts::Evaluate(const float* values) const
+{
+  //
+  // evaluate all the cuts
+  //
+  uint64_t decisions = 0;
+  for (unsigned int icut = 0; icut < fOutputs.size(); ++icut) {
+    if (EvaluateNode(fOutputs[icut], values)) {
+      decisions |= (uint64_t(1) << icut);
+    }
+  }
+  return decisions;
+}
+
+//____________________________________________________________________________
+inline void CompiledCuts::Evaluate(int nRows, const float* const* rows, uint64_t* decisions) const
+{
+  //
+  // evaluate all the cuts for each array of values
+  //
+  for (int irow = 0; irow < nRows; ++irow) {
+    decisions[irow] = Evaluate(rows[irow]);
+  }
+}
+
+#endif
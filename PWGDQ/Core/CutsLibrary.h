@@ -15,7 +15,9 @@
 #ifndef PWGDQ_CORE_CUTSLIBRARY_H_
 #define PWGDQ_CORE_CUTSLIBRARY_H_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include "PWGDQ/Core/AnalysisCut.h"
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
 #include "PWGDQ/Core/VarManager.h"
@@ -24,12 +26,42 @@ namespace o2::aod
 {
 namespace dqcuts
 {
+// NOTE: each cut is built only once from the definitions below and then copied, the caller owns the returned cut
 AnalysisCompositeCut* GetCompositeCut(const char* cutName);
 AnalysisCut* GetAnalysisCut(const char* cutName);
+// build a cut from its definition
+AnalysisCompositeCut* BuildCompositeCut(const char* cutName);
+AnalysisCut* BuildAnalysisCut(const char* cutName);
 } // namespace dqcuts
 } // namespace o2::aod
 
 AnalysisCompositeCut* o2::aod::dqcuts::GetCompositeCut(const char* cutName)
+{
+  //
+  // get a copy of a composite cut, which is built at the first request
+  //
+  static std::unordered_map<std::string, std::unique_ptr<AnalysisCompositeCut>> cache;
+  auto it = cache.find(cutName);
+  if (it == cache.end()) {
+    it = cache.emplace(cutName, std::unique_ptr<AnalysisCompositeCut>(BuildCompositeCut(cutName))).first;
+  }
+  return it->second ? new AnalysisCompositeCut(*(it->second)) : nullptr;
+}
+
+AnalysisCut* o2::aod::dqcuts::GetAnalysisCut(const char* cutName)
+{
+  //
+  // get a copy of a cut, which is built at the first request
+  //
+  static std::unordered_map<std::string, std::unique_ptr<AnalysisCut>> cache;
+  auto it = cache.find(cutName);
+  if (it == cache.end()) {
+    it = cache.emplace(cutName, std::unique_ptr<AnalysisCut>(BuildAnalysisCut(cutName))).first;
+  }
+  return it->second ? new AnalysisCut(*(it->second)) : nullptr;
+}
+
+AnalysisCompositeCut* o2::aod::dqcuts::BuildCompositeCut(const char* cutName)
 {
   //
   // define composie cuts, typically combinations of all the ingredients needed for a full cut
@@ -608,7 +640,7 @@ AnalysisCompositeCut* o2::aod::dqcuts::GetCompositeCut(const char* cutName)
   return nullptr;
 }
 
-AnalysisCut* o2::aod::dqcuts::GetAnalysisCut(const char* cutName)
+AnalysisCut* o2::aod::dqcuts::BuildAnalysisCut(const char* cutName)
 {
   //
   // define here cuts which are likely to be used often
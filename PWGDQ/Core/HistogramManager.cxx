@@ -11,6 +11,7 @@
 
 #include "PWGDQ/Core/HistogramManager.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 using namespace std;
@@ -37,6 +38,10 @@ HistogramManager::HistogramManager() : TNamed("", ""),
                                        fNVars(0),
                                        fUsedVars(nullptr),
                                        fVariablesMap(),
+                                       fClassIndices(),
+                                       fFillPlans(),
+                                       fClassLists(),
+                                       fDeferredAllocation(false),
                                        fUseDefaultVariableNames(false),
                                        fBinsAllocated(0),
                                        fVariableNames(nullptr),
@@ -53,6 +58,10 @@ HistogramManager::HistogramManager(const char* name, const char* title, const in
                                                                                               fNVars(maxNVars),
                                                                                               fUsedVars(),
                                                                                               fVariablesMap(),
+                                                                                              fClassIndices(),
+                                                                                              fFillPlans(),
+                                                                                              fClassLists(),
+                                                                                              fDeferredAllocation(false),
                                                                                               fUseDefaultVariableNames(kFALSE),
                                                                                               fBinsAllocated(0),
                                                                                               fVariableNames(),
@@ -92,15 +101,16 @@ void HistogramManager::SetDefaultVarNames(TString* vars, TString* units)
 };
 
 //__________________________________________________________________
-void HistogramManager::AddHistClass(const char* histClass)
+int HistogramManager::AddHistClass(const char* histClass)
 {
   //
   // Add a new histogram list
+  // Returns the index of the class, to be used with FillHistClass(int, float*)
   //
   if (fMainList->FindObject(histClass)) {
     cout << "Warning in HistogramManager::AddHistClass(): Cannot add histogram class " << histClass
          << " because it already exists." << endl;
-    return;
+    return GetHistClassIndex(histClass);
   }
   TList* hList = new TList;
   hList->SetOwner(kTRUE);
@@ -108,8 +118,127 @@ void HistogramManager::AddHistClass(const char* histClass)
   fMainList->Add(hList);
   std::list<std::vector<int>> varList;
   fVariablesMap[histClass] = varList;
+  fClassIndices[histClass] = fFillPlans.size();
+  fFillPlans.emplace_back();
+  fClassLists.push_back(hList);
   cout << "Adding histogram class " << histClass << endl;
   cout << "Variable map size :: " << fVariablesMap.size() << endl;
+  return fClassIndices[histClass];
+}
+
+//__________________________________________________________________
+int HistogramManager::GetHistClassIndex(const char* histClass) const
+{
+  //
+  // Get the index of a histogram class, or -1 if it does not exist
+  //
+  auto it = fClassIndices.find(histClass);
+  return (it == fClassIndices.end() ? -1 : it->second);
+}
+
+//__________________________________________________________________
+int HistogramManager::FillDimension(bool isProfile, int dimension, int varT)
+{
+  //
+  // Dimension of the histogram created from the dimension deduced from the variables:
+  // the profiles have one dimension less than the number of variables, except the TProfile3D
+  //
+  if (!isProfile || dimension == 1) {
+    return dimension;
+  }
+  if (dimension == 3 && varT > kNothing) {
+    return 3;
+  }
+  return dimension - 1;
+}
+
+//__________________________________________________________________
+bool HistogramManager::HasHistogram(const char* histClass, const char* hname) const
+{
+  //
+  // Whether a histogram with this name was defined in the class, created or not
+  //
+  auto it = fClassIndices.find(histClass);
+  if (it == fClassIndices.end()) {
+    return false;
+  }
+  for (const auto& entry : fFillPlans[it->second]) {
+    if (entry.fName == hname) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//__________________________________________________________________
+void HistogramManager::AddFillEntry(const char* histClass, const char* hname, std::function<TObject*()> create, const std::vector<int>& varVector, int dimension)
+{
+  //
+  // Add a histogram to the fill plan of its class
+  // The kind of histogram and its variables are decoded here once, instead of at every fill
+  // The histogram is created here, unless the allocation is deferred to its first fill
+  //
+  const int classIndex = fClassIndices[histClass];
+  FillEntry entry;
+  entry.fName = hname;
+  entry.fVarW = varVector[2];
+  if (varVector[1] > 0) { // THn
+    entry.fKind = kFillTHn;
+    entry.fNDims = std::min(varVector[1], static_cast<int>(kMaxFillDimensions));
+    for (int i = 0; i < entry.fNDims; i++) {
+      entry.fVars[i] = varVector[3 + i];
+    }
+  } else {
+    const bool isProfile = (varVector[0] == 1);
+    entry.fKind = isProfile ? kFillProfile1D + dimension - 1 : kFillTH1 + dimension - 1;
+    entry.fNDims = dimension;
+    for (int i = 0; i < 4; i++) {
+      entry.fVars[i] = varVector[3 + i];
+    }
+  }
+  entry.fCreate = std::move(create);
+  fFillPlans[classIndex].push_back(std::move(entry));
+  if (!fDeferredAllocation) {
+    Materialize(classIndex, fFillPlans[classIndex].size() - 1);
+  }
+}
+
+//__________________________________________________________________
+TObject* HistogramManager::Materialize(int classIndex, int entryIndex)
+{
+  //
+  // Create the histogram of a fill plan entry and insert it in the list of its class,
+  // at the position given by the order in which the histograms were defined
+  //
+  auto& plan = fFillPlans[classIndex];
+  FillEntry& entry = plan[entryIndex];
+  if (entry.fHist) {
+    return entry.fHist;
+  }
+  int position = 0;
+  for (int i = 0; i < entryIndex; ++i) {
+    if (plan[i].fHist) {
+      ++position;
+    }
+  }
+  TObject* h = entry.fCreate();
+  entry.fCreate = nullptr; // release the captured parameters
+  entry.fHist = h;
+  fClassLists[classIndex]->AddAt(h, position);
+  return h;
+}
+
+//__________________________________________________________________
+void HistogramManager::MaterializeHistograms()
+{
+  //
+  // Create all the histograms not created yet, so that the output contains all the defined histograms
+  //
+  for (std::size_t classIndex = 0; classIndex < fFillPlans.size(); ++classIndex) {
+    for (std::size_t entryIndex = 0; entryIndex < fFillPlans[classIndex].size(); ++entryIndex) {
+      Materialize(classIndex, entryIndex);
+    }
+  }
 }
 
 //_________________________________________________________________
@@ -133,7 +262,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
     return;
   }
   // check whether this histogram name was used before
-  if (hList->FindObject(hname)) {
+  if (HasHistogram(histClass, hname)) {
     cout << "Warning in HistogramManager::AddHistogram(): Histogram " << hname << " already exists" << endl;
     return;
   }
@@ -148,9 +277,8 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
     dimension = 3;
   }
 
-  // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+  // the title string may include axis titles which will overwrite the defaults
   TString titleStr(title);
-  std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
   // mark required variables as being used
   if (varX > kNothing) {
     fUsedVars[varX] = kTRUE;
@@ -184,131 +312,137 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   fVariablesMap[histClass] = varList;
 
   // create and configure histograms according to required options
-  TH1* h = nullptr;
-  switch (dimension) {
-    case 1: // TH1F
-      h = new TH1F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax);
-      fBinsAllocated += nXbins + 2;
-      // TODO: possibly make the call of Sumw2() optional for all histograms
-      h->Sumw2();
-      if (fVariableNames[varX][0]) {
-        h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
-                                     (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
-      }
-      if (arr->At(1)) {
-        h->GetXaxis()->SetTitle(arr->At(1)->GetName());
-      }
-      if (xLabels[0] != '\0') {
-        MakeAxisLabels(h->GetXaxis(), xLabels);
-      }
-      hList->Add(h);
-      h->SetDirectory(nullptr);
-      break;
-
-    case 2: // either TH2F or TProfile
-      if (isProfile) {
-        h = new TProfile(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax);
+  // the histogram is created now, or at its first fill if the allocation is deferred
+  auto create = [this, hname = TString(hname), titleStr, isProfile, dimension,
+                 nXbins, xmin, xmax, varX, nYbins, ymin, ymax, varY, nZbins, zmin, zmax, varZ, varT,
+                 xLabels = TString(xLabels), yLabels = TString(yLabels), zLabels = TString(zLabels)]() -> TObject* {
+    // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+    std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
+    TH1* h = nullptr;
+    switch (dimension) {
+      case 1: // TH1F
+        h = new TH1F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax);
         fBinsAllocated += nXbins + 2;
+        // TODO: possibly make the call of Sumw2() optional for all histograms
         h->Sumw2();
-        // if requested, build the profile using the profile widths instead of stat errors
-        // TODO: make this option more transparent to the user ?
-        if (titleStr.Contains("--s--")) {
-          ((TProfile*)h)->BuildOptions(0., 0., "s");
-        }
-      } else {
-        h = new TH2F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax);
-        fBinsAllocated += (nXbins + 2) * (nYbins + 2);
-        h->Sumw2();
-      }
-      if (fVariableNames[varX][0]) {
-        h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
-                                     (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
-      }
-      if (arr->At(1)) {
-        h->GetXaxis()->SetTitle(arr->At(1)->GetName());
-      }
-      if (xLabels[0] != '\0') {
-        MakeAxisLabels(h->GetXaxis(), xLabels);
-      }
-
-      if (fVariableNames[varY][0]) {
-        h->GetYaxis()->SetTitle(Form("%s %s", fVariableNames[varY].Data(),
-                                     (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
-      }
-      if (fVariableNames[varY][0] && isProfile) {
-        h->GetYaxis()->SetTitle(Form("<%s> %s", fVariableNames[varY].Data(),
-                                     (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
-      }
-      if (arr->At(2)) {
-        h->GetYaxis()->SetTitle(arr->At(2)->GetName());
-      }
-      if (yLabels[0] != '\0') {
-        MakeAxisLabels(h->GetYaxis(), yLabels);
-      }
-      hList->Add(h);
-      h->SetDirectory(nullptr);
-      break;
+        if (fVariableNames[varX][0]) {
+          h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
+                                       (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
+        }
+        if (arr->At(1)) {
+          h->GetXaxis()->SetTitle(arr->At(1)->GetName());
+        }
+        if (xLabels[0] != '\0') {
+          MakeAxisLabels(h->GetXaxis(), xLabels);
+        }
+        h->SetDirectory(nullptr);
+        break;
 
-    case 3: // TH3F, TProfile2D or TProfile3D
-      if (isProfile) {
-        if (varT > kNothing) { // TProfile3D
-          h = new TProfile3D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax, nZbins, zmin, zmax);
-          fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
+      case 2: // either TH2F or TProfile
+        if (isProfile) {
+          h = new TProfile(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax);
+          fBinsAllocated += nXbins + 2;
           h->Sumw2();
+          // if requested, build the profile using the profile widths instead of stat errors
+          // TODO: make this option more transparent to the user ?
           if (titleStr.Contains("--s--")) {
-            ((TProfile3D*)h)->BuildOptions(0., 0., "s");
+            ((TProfile*)h)->BuildOptions(0., 0., "s");
           }
-        } else { // TProfile2D
-          h = new TProfile2D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax);
+        } else {
+          h = new TH2F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax);
           fBinsAllocated += (nXbins + 2) * (nYbins + 2);
           h->Sumw2();
-          if (titleStr.Contains("--s--")) {
-            ((TProfile2D*)h)->BuildOptions(0., 0., "s");
+        }
+        if (fVariableNames[varX][0]) {
+          h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
+                                       (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
+        }
+        if (arr->At(1)) {
+          h->GetXaxis()->SetTitle(arr->At(1)->GetName());
+        }
+        if (xLabels[0] != '\0') {
+          MakeAxisLabels(h->GetXaxis(), xLabels);
+        }
+
+        if (fVariableNames[varY][0]) {
+          h->GetYaxis()->SetTitle(Form("%s %s", fVariableNames[varY].Data(),
+                                       (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
+        }
+        if (fVariableNames[varY][0] && isProfile) {
+          h->GetYaxis()->SetTitle(Form("<%s> %s", fVariableNames[varY].Data(),
+                                       (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
+        }
+        if (arr->At(2)) {
+          h->GetYaxis()->SetTitle(arr->At(2)->GetName());
+        }
+        if (yLabels[0] != '\0') {
+          MakeAxisLabels(h->GetYaxis(), yLabels);
+        }
+        h->SetDirectory(nullptr);
+        break;
+
+      case 3: // TH3F, TProfile2D or TProfile3D
+        if (isProfile) {
+          if (varT > kNothing) { // TProfile3D
+            h = new TProfile3D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax, nZbins, zmin, zmax);
+            fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
+            h->Sumw2();
+            if (titleStr.Contains("--s--")) {
+              ((TProfile3D*)h)->BuildOptions(0., 0., "s");
+            }
+          } else { // TProfile2D
+            h = new TProfile2D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax);
+            fBinsAllocated += (nXbins + 2) * (nYbins + 2);
+            h->Sumw2();
+            if (titleStr.Contains("--s--")) {
+              ((TProfile2D*)h)->BuildOptions(0., 0., "s");
+            }
           }
+        } else { // TH3F
+          h = new TH3F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax, nZbins, zmin, zmax);
+          fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
+          h->Sumw2();
         }
-      } else { // TH3F
-        h = new TH3F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xmin, xmax, nYbins, ymin, ymax, nZbins, zmin, zmax);
-        fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
-        h->Sumw2();
-      }
-      if (fVariableNames[varX][0]) {
-        h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
-                                     (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
-      }
-      if (arr->At(1)) {
-        h->GetXaxis()->SetTitle(arr->At(1)->GetName());
-      }
-      if (xLabels[0] != '\0') {
-        MakeAxisLabels(h->GetXaxis(), xLabels);
-      }
-      if (fVariableNames[varY][0]) {
-        h->GetYaxis()->SetTitle(Form("%s %s", fVariableNames[varY].Data(),
-                                     (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
-      }
-      if (arr->At(2)) {
-        h->GetYaxis()->SetTitle(arr->At(2)->GetName());
-      }
-      if (yLabels[0] != '\0') {
-        MakeAxisLabels(h->GetYaxis(), yLabels);
-      }
-      if (fVariableNames[varZ][0]) {
-        h->GetZaxis()->SetTitle(Form("%s %s", fVariableNames[varZ].Data(),
-                                     (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
-      }
-      if (fVariableNames[varZ][0] && isProfile && varT < 0) { // for TProfile2D
-        h->GetZaxis()->SetTitle(Form("<%s> %s", fVariableNames[varZ].Data(),
-                                     (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
-      }
-      if (arr->At(3)) {
-        h->GetZaxis()->SetTitle(arr->At(3)->GetName());
-      }
-      if (zLabels[0] != '\0') {
-        MakeAxisLabels(h->GetZaxis(), zLabels);
-      }
-      h->SetDirectory(nullptr);
-      hList->Add(h);
-      break;
-  } // end switch
+        if (fVariableNames[varX][0]) {
+          h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
+                                       (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
+        }
+        if (arr->At(1)) {
+          h->GetXaxis()->SetTitle(arr->At(1)->GetName());
+        }
+        if (xLabels[0] != '\0') {
+          MakeAxisLabels(h->GetXaxis(), xLabels);
+        }
+        if (fVariableNames[varY][0]) {
+          h->GetYaxis()->SetTitle(Form("%s %s", fVariableNames[varY].Data(),
+                                       (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
+        }
+        if (arr->At(2)) {
+          h->GetYaxis()->SetTitle(arr->At(2)->GetName());
+        }
+        if (yLabels[0] != '\0') {
+          MakeAxisLabels(h->GetYaxis(), yLabels);
+        }
+        if (fVariableNames[varZ][0]) {
+          h->GetZaxis()->SetTitle(Form("%s %s", fVariableNames[varZ].Data(),
+                                       (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
+        }
+        if (fVariableNames[varZ][0] && isProfile && varT < 0) { // for TProfile2D
+          h->GetZaxis()->SetTitle(Form("<%s> %s", fVariableNames[varZ].Data(),
+                                       (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
+        }
+        if (arr->At(3)) {
+          h->GetZaxis()->SetTitle(arr->At(3)->GetName());
+        }
+        if (zLabels[0] != '\0') {
+          MakeAxisLabels(h->GetZaxis(), zLabels);
+        }
+        h->SetDirectory(nullptr);
+        break;
+    } // end switch
+    return h;
+  };
+  AddFillEntry(histClass, hname, create, varVector, FillDimension(isProfile, dimension, varT));
 }
 
 //_________________________________________________________________
@@ -331,7 +465,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
     return;
   }
   // check whether this histogram name was used before
-  if (hList->FindObject(hname)) {
+  if (HasHistogram(histClass, hname)) {
     cout << "Warning in HistogramManager::AddHistogram(): Histogram " << hname << " already exists" << endl;
     return;
   }
@@ -363,9 +497,8 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
     fUsedVars[varW] = kTRUE;
   }
 
-  // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+  // the title string may include axis titles which will overwrite the defaults
   TString titleStr(title);
-  std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
 
   // encode needed variable identifiers in a vector and push it to the std::list corresponding to the current histogram list
   std::vector<int> varVector;
@@ -382,128 +515,138 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
 
-  TH1* h = nullptr;
-  switch (dimension) {
-    case 1:
-      h = new TH1F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins);
-      fBinsAllocated += nXbins + 2;
-      h->Sumw2();
-      if (fVariableNames[varX][0]) {
-        h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
-                                     (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
-      }
-      if (arr->At(1)) {
-        h->GetXaxis()->SetTitle(arr->At(1)->GetName());
-      }
-      if (xLabels[0] != '\0') {
-        MakeAxisLabels(h->GetXaxis(), xLabels);
-      }
-      h->SetDirectory(nullptr);
-      hList->Add(h);
-      break;
-
-    case 2:
-      if (isProfile) {
-        h = new TProfile(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins);
+  // create and configure histograms according to required options
+  // the histogram is created now, or at its first fill if the allocation is deferred
+  // the bin limits are copied, since the arrays of the caller may not outlive a deferred creation
+  auto create = [this, hname = TString(hname), titleStr, isProfile, dimension,
+                 nXbins, xbins = std::vector<double>(xbins, xbins + nXbins + 1), varX,
+                 nYbins, ybins = (ybins ? std::vector<double>(ybins, ybins + nYbins + 1) : std::vector<double>()), varY,
+                 nZbins, zbins = (zbins ? std::vector<double>(zbins, zbins + nZbins + 1) : std::vector<double>()), varZ, varT,
+                 xLabels = TString(xLabels), yLabels = TString(yLabels), zLabels = TString(zLabels)]() -> TObject* {
+    // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+    std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
+    TH1* h = nullptr;
+    switch (dimension) {
+      case 1:
+        h = new TH1F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins.data());
         fBinsAllocated += nXbins + 2;
         h->Sumw2();
-        if (titleStr.Contains("--s--")) {
-          ((TProfile*)h)->BuildOptions(0., 0., "s");
+        if (fVariableNames[varX][0]) {
+          h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
+                                       (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
         }
-      } else {
-        h = new TH2F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins, nYbins, ybins);
-        fBinsAllocated += (nXbins + 2) * (nYbins + 2);
-        h->Sumw2();
-      }
-      if (fVariableNames[varX][0]) {
-        h->GetXaxis()->SetTitle(Form("%s (%s)", fVariableNames[varX].Data(),
-                                     (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
-      }
-      if (arr->At(1)) {
-        h->GetXaxis()->SetTitle(arr->At(1)->GetName());
-      }
-      if (xLabels[0] != '\0') {
-        MakeAxisLabels(h->GetXaxis(), xLabels);
-      }
-      if (fVariableNames[varY][0]) {
-        h->GetYaxis()->SetTitle(Form("%s (%s)", fVariableNames[varY].Data(),
-                                     (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
-      }
-      if (fVariableNames[varY][0] && isProfile) {
-        h->GetYaxis()->SetTitle(Form("<%s> (%s)", fVariableNames[varY].Data(),
-                                     (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
-      }
-
-      if (arr->At(2)) {
-        h->GetYaxis()->SetTitle(arr->At(2)->GetName());
-      }
-      if (yLabels[0] != '\0') {
-        MakeAxisLabels(h->GetYaxis(), yLabels);
-      }
-      h->SetDirectory(nullptr);
-      hList->Add(h);
-      break;
+        if (arr->At(1)) {
+          h->GetXaxis()->SetTitle(arr->At(1)->GetName());
+        }
+        if (xLabels[0] != '\0') {
+          MakeAxisLabels(h->GetXaxis(), xLabels);
+        }
+        h->SetDirectory(nullptr);
+        break;
 
-    case 3:
-      if (isProfile) {
-        if (varT > kNothing) {
-          h = new TProfile3D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins, nYbins, ybins, nZbins, zbins);
-          fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
+      case 2:
+        if (isProfile) {
+          h = new TProfile(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins.data());
+          fBinsAllocated += nXbins + 2;
           h->Sumw2();
           if (titleStr.Contains("--s--")) {
-            ((TProfile3D*)h)->BuildOptions(0., 0., "s");
+            ((TProfile*)h)->BuildOptions(0., 0., "s");
           }
         } else {
-          h = new TProfile2D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins, nYbins, ybins);
+          h = new TH2F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins.data(), nYbins, ybins.data());
           fBinsAllocated += (nXbins + 2) * (nYbins + 2);
           h->Sumw2();
-          if (titleStr.Contains("--s--")) {
-            ((TProfile2D*)h)->BuildOptions(0., 0., "s");
+        }
+        if (fVariableNames[varX][0]) {
+          h->GetXaxis()->SetTitle(Form("%s (%s)", fVariableNames[varX].Data(),
+                                       (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
+        }
+        if (arr->At(1)) {
+          h->GetXaxis()->SetTitle(arr->At(1)->GetName());
+        }
+        if (xLabels[0] != '\0') {
+          MakeAxisLabels(h->GetXaxis(), xLabels);
+        }
+        if (fVariableNames[varY][0]) {
+          h->GetYaxis()->SetTitle(Form("%s (%s)", fVariableNames[varY].Data(),
+                                       (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
+        }
+        if (fVariableNames[varY][0] && isProfile) {
+          h->GetYaxis()->SetTitle(Form("<%s> (%s)", fVariableNames[varY].Data(),
+                                       (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
+        }
+
+        if (arr->At(2)) {
+          h->GetYaxis()->SetTitle(arr->At(2)->GetName());
+        }
+        if (yLabels[0] != '\0') {
+          MakeAxisLabels(h->GetYaxis(), yLabels);
+        }
+        h->SetDirectory(nullptr);
+        break;
+
+      case 3:
+        if (isProfile) {
+          if (varT > kNothing) {
+            h = new TProfile3D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins.data(), nYbins, ybins.data(), nZbins, zbins.data());
+            fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
+            h->Sumw2();
+            if (titleStr.Contains("--s--")) {
+              ((TProfile3D*)h)->BuildOptions(0., 0., "s");
+            }
+          } else {
+            h = new TProfile2D(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins.data(), nYbins, ybins.data());
+            fBinsAllocated += (nXbins + 2) * (nYbins + 2);
+            h->Sumw2();
+            if (titleStr.Contains("--s--")) {
+              ((TProfile2D*)h)->BuildOptions(0., 0., "s");
+            }
           }
+        } else {
+          h = new TH3F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins.data(), nYbins, ybins.data(), nZbins, zbins.data());
+          fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
+          h->Sumw2();
+        }
+        if (fVariableNames[varX][0]) {
+          h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
+                                       (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
+        }
+        if (arr->At(1)) {
+          h->GetXaxis()->SetTitle(arr->At(1)->GetName());
+        }
+        if (xLabels[0] != '\0') {
+          MakeAxisLabels(h->GetXaxis(), xLabels);
+        }
+        if (fVariableNames[varY][0]) {
+          h->GetYaxis()->SetTitle(Form("%s %s", fVariableNames[varY].Data(),
+                                       (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
+        }
+        if (arr->At(2)) {
+          h->GetYaxis()->SetTitle(arr->At(2)->GetName());
+        }
+        if (yLabels[0] != '\0') {
+          MakeAxisLabels(h->GetYaxis(), yLabels);
+        }
+        if (fVariableNames[varZ][0]) {
+          h->GetZaxis()->SetTitle(Form("%s %s", fVariableNames[varZ].Data(),
+                                       (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
+        }
+        if (fVariableNames[varZ][0] && isProfile && varT < 0) { // TProfile2D
+          h->GetZaxis()->SetTitle(Form("<%s> %s", fVariableNames[varZ].Data(),
+                                       (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
         }
-      } else {
-        h = new TH3F(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nXbins, xbins, nYbins, ybins, nZbins, zbins);
-        fBinsAllocated += (nXbins + 2) * (nYbins + 2) * (nZbins + 2);
-        h->Sumw2();
-      }
-      if (fVariableNames[varX][0]) {
-        h->GetXaxis()->SetTitle(Form("%s %s", fVariableNames[varX].Data(),
-                                     (fVariableUnits[varX][0] ? Form("(%s)", fVariableUnits[varX].Data()) : "")));
-      }
-      if (arr->At(1)) {
-        h->GetXaxis()->SetTitle(arr->At(1)->GetName());
-      }
-      if (xLabels[0] != '\0') {
-        MakeAxisLabels(h->GetXaxis(), xLabels);
-      }
-      if (fVariableNames[varY][0]) {
-        h->GetYaxis()->SetTitle(Form("%s %s", fVariableNames[varY].Data(),
-                                     (fVariableUnits[varY][0] ? Form("(%s)", fVariableUnits[varY].Data()) : "")));
-      }
-      if (arr->At(2)) {
-        h->GetYaxis()->SetTitle(arr->At(2)->GetName());
-      }
-      if (yLabels[0] != '\0') {
-        MakeAxisLabels(h->GetYaxis(), yLabels);
-      }
-      if (fVariableNames[varZ][0]) {
-        h->GetZaxis()->SetTitle(Form("%s %s", fVariableNames[varZ].Data(),
-                                     (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
-      }
-      if (fVariableNames[varZ][0] && isProfile && varT < 0) { // TProfile2D
-        h->GetZaxis()->SetTitle(Form("<%s> %s", fVariableNames[varZ].Data(),
-                                     (fVariableUnits[varZ][0] ? Form("(%s)", fVariableUnits[varZ].Data()) : "")));
-      }
 
-      if (arr->At(3)) {
-        h->GetZaxis()->SetTitle(arr->At(3)->GetName());
-      }
-      if (zLabels[0] != '\0') {
-        MakeAxisLabels(h->GetZaxis(), zLabels);
-      }
-      hList->Add(h);
-      break;
-  } // end switch(dimension)
+        if (arr->At(3)) {
+          h->GetZaxis()->SetTitle(arr->At(3)->GetName());
+        }
+        if (zLabels[0] != '\0') {
+          MakeAxisLabels(h->GetZaxis(), zLabels);
+        }
+        break;
+    } // end switch(dimension)
+    return h;
+  };
+  AddFillEntry(histClass, hname, create, varVector, FillDimension(isProfile, dimension, varT));
 }
 
 //_________________________________________________________________
@@ -523,14 +666,13 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
     return;
   }
   // check whether this histogram name was used before
-  if (hList->FindObject(hname)) {
+  if (HasHistogram(histClass, hname)) {
     cout << "Warning in HistogramManager::AddHistogram(): Histogram " << hname << " already exists" << endl;
     return;
   }
 
-  // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+  // the title string may include axis titles which will overwrite the defaults
   TString titleStr(title);
-  std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
 
   if (varW > kNothing) {
     fUsedVars[varW] = kTRUE;
@@ -550,39 +692,48 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
 
-  unsigned long int nbins = 1;
-  THnBase* h = nullptr;
-  if (useSparse) {
-    h = new THnSparseF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins, xmin, xmax);
-  } else {
-    h = new THnF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins, xmin, xmax);
-  }
-  h->Sumw2();
-
-  // configure the THn histogram and count the allocated bins
-  for (int idim = 0; idim < nDimensions; ++idim) {
-    nbins *= (nBins[idim] + 2);
-    TAxis* axis = h->GetAxis(idim);
-    if (fVariableNames[vars[idim]][0]) {
-      axis->SetTitle(Form("%s %s", fVariableNames[vars[idim]].Data(),
-                          (fVariableUnits[vars[idim]][0] ? Form("(%s)", fVariableUnits[vars[idim]].Data()) : "")));
-    }
-    if (arr->At(1 + idim)) {
-      axis->SetTitle(arr->At(1 + idim)->GetName());
+  // create and configure the histogram
+  // the histogram is created now, or at its first fill if the allocation is deferred
+  auto create = [this, hname = TString(hname), titleStr, nDimensions, useSparse,
+                 vars = std::vector<int>(vars, vars + nDimensions),
+                 nBins = std::vector<int>(nBins, nBins + nDimensions),
+                 xmin = std::vector<double>(xmin, xmin + nDimensions),
+                 xmax = std::vector<double>(xmax, xmax + nDimensions),
+                 axLabels = (axLabels ? std::vector<TString>(axLabels, axLabels + nDimensions) : std::vector<TString>())]() -> TObject* {
+    // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+    std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
+    unsigned long int nbins = 1;
+    THnBase* h = nullptr;
+    if (useSparse) {
+      h = new THnSparseF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins.data(), xmin.data(), xmax.data());
+    } else {
+      h = new THnF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins.data(), xmin.data(), xmax.data());
     }
-    if (axLabels && !axLabels[idim].IsNull()) {
-      MakeAxisLabels(axis, axLabels[idim].Data());
+    h->Sumw2();
+
+    // configure the THn histogram and count the allocated bins
+    for (int idim = 0; idim < nDimensions; ++idim) {
+      nbins *= (nBins[idim] + 2);
+      TAxis* axis = h->GetAxis(idim);
+      if (fVariableNames[vars[idim]][0]) {
+        axis->SetTitle(Form("%s %s", fVariableNames[vars[idim]].Data(),
+                            (fVariableUnits[vars[idim]][0] ? Form("(%s)", fVariableUnits[vars[idim]].Data()) : "")));
+      }
+      if (arr->At(1 + idim)) {
+        axis->SetTitle(arr->At(1 + idim)->GetName());
+      }
+      if (!axLabels.empty() && !axLabels[idim].IsNull()) {
+        MakeAxisLabels(axis, axLabels[idim].Data());
+      }
     }
 
+    fBinsAllocated += nbins;
+    return h;
+  };
+  for (int idim = 0; idim < nDimensions; ++idim) {
     fUsedVars[vars[idim]] = kTRUE;
   }
-  if (useSparse) {
-    hList->Add((THnSparseF*)h);
-  } else {
-    hList->Add((THnF*)h);
-  }
-
-  fBinsAllocated += nbins;
+  AddFillEntry(histClass, hname, create, varVector, nDimensions);
 }
 
 //_________________________________________________________________
@@ -602,14 +753,13 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
     return;
   }
   // check whether this histogram name was used before
-  if (hList->FindObject(hname)) {
+  if (HasHistogram(histClass, hname)) {
     cout << "Warning in HistogramManager::AddHistogram(): Histogram " << hname << " already exists" << endl;
     return;
   }
 
-  // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+  // the title string may include axis titles which will overwrite the defaults
   TString titleStr(title);
-  std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
 
   if (varW > kNothing) {
     fUsedVars[varW] = kTRUE;
@@ -629,52 +779,60 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   cout << "size of array :: " << varList.size() << endl;
   fVariablesMap[histClass] = varList;
 
-  // get the min and max for each axis
-  double* xmin = new double[nDimensions];
-  double* xmax = new double[nDimensions];
-  int* nBins = new int[nDimensions];
-  for (int idim = 0; idim < nDimensions; ++idim) {
-    nBins[idim] = binLimits[idim].GetSize() - 1;
-    xmin[idim] = binLimits[idim][0];
-    xmax[idim] = binLimits[idim][nBins[idim]];
-  }
-
-  // initialize the THn with equal spaced bins
-  THnBase* h = nullptr;
-  if (useSparse) {
-    h = new THnSparseF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins, xmin, xmax);
-  } else {
-    h = new THnF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins, xmin, xmax);
-  }
-  // rebin the axes according to the user requested binning
-  for (int idim = 0; idim < nDimensions; ++idim) {
-    TAxis* axis = h->GetAxis(idim);
-    axis->Set(nBins[idim], binLimits[idim].GetArray());
-  }
-  h->Sumw2();
+  // create and configure the histogram
+  // the histogram is created now, or at its first fill if the allocation is deferred
+  auto create = [this, hname = TString(hname), titleStr, nDimensions, useSparse,
+                 vars = std::vector<int>(vars, vars + nDimensions),
+                 binLimits = std::vector<TArrayD>(binLimits, binLimits + nDimensions),
+                 axLabels = (axLabels ? std::vector<TString>(axLabels, axLabels + nDimensions) : std::vector<TString>())]() -> TObject* {
+    // tokenize the title string; the user may include in it axis titles which will overwrite the defaults
+    std::unique_ptr<TObjArray> arr(titleStr.Tokenize(";"));
+    // get the min and max for each axis
+    std::vector<double> xmin(nDimensions);
+    std::vector<double> xmax(nDimensions);
+    std::vector<int> nBins(nDimensions);
+    for (int idim = 0; idim < nDimensions; ++idim) {
+      nBins[idim] = binLimits[idim].GetSize() - 1;
+      xmin[idim] = binLimits[idim][0];
+      xmax[idim] = binLimits[idim][nBins[idim]];
+    }
 
-  unsigned long int bins = 1;
-  for (int idim = 0; idim < nDimensions; ++idim) {
-    bins *= (nBins[idim] + 2);
-    TAxis* axis = h->GetAxis(idim);
-    if (fVariableNames[vars[idim]][0]) {
-      axis->SetTitle(Form("%s %s", fVariableNames[vars[idim]].Data(),
-                          (fVariableUnits[vars[idim]][0] ? Form("(%s)", fVariableUnits[vars[idim]].Data()) : "")));
+    // initialize the THn with equal spaced bins
+    THnBase* h = nullptr;
+    if (useSparse) {
+      h = new THnSparseF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins.data(), xmin.data(), xmax.data());
+    } else {
+      h = new THnF(hname, (arr->At(0) ? arr->At(0)->GetName() : ""), nDimensions, nBins.data(), xmin.data(), xmax.data());
     }
-    if (arr->At(1 + idim)) {
-      axis->SetTitle(arr->At(1 + idim)->GetName());
+    // rebin the axes according to the user requested binning
+    for (int idim = 0; idim < nDimensions; ++idim) {
+      TAxis* axis = h->GetAxis(idim);
+      axis->Set(nBins[idim], binLimits[idim].GetArray());
     }
-    if (axLabels && !axLabels[idim].IsNull()) {
-      MakeAxisLabels(axis, axLabels[idim].Data());
+    h->Sumw2();
+
+    unsigned long int bins = 1;
+    for (int idim = 0; idim < nDimensions; ++idim) {
+      bins *= (nBins[idim] + 2);
+      TAxis* axis = h->GetAxis(idim);
+      if (fVariableNames[vars[idim]][0]) {
+        axis->SetTitle(Form("%s %s", fVariableNames[vars[idim]].Data(),
+                            (fVariableUnits[vars[idim]][0] ? Form("(%s)", fVariableUnits[vars[idim]].Data()) : "")));
+      }
+      if (arr->At(1 + idim)) {
+        axis->SetTitle(arr->At(1 + idim)->GetName());
+      }
+      if (!axLabels.empty() && !axLabels[idim].IsNull()) {
+        MakeAxisLabels(axis, axLabels[idim].Data());
+      }
     }
+    fBinsAllocated += bins;
+    return h;
+  };
+  for (int idim = 0; idim < nDimensions; ++idim) {
     fUsedVars[vars[idim]] = kTRUE;
   }
-  if (useSparse) {
-    hList->Add((THnSparseF*)h);
-  } else {
-    hList->Add((THnF*)h);
-  }
-  fBinsAllocated += bins;
+  AddFillEntry(histClass, hname, create, varVector, nDimensions);
 }
 
 //__________________________________________________________________
@@ -683,124 +841,89 @@ void HistogramManager::FillHistClass(const char* className, Float_t* values)
   //
   //  fill a class of histograms
   //
-
-  // get the needed histogram list
-  TList* hList = (TList*)fMainList->FindObject(className);
-  if (!hList) {
+  int classIndex = GetHistClassIndex(className);
+  if (classIndex < 0) {
     // TODO: add some meaningfull error message
     /*cout << "Warning in HistogramManager::FillHistClass(): Histogram list " << className << " not found!" << endl;
     cout << "         Histogram list not filled" << endl; */
     return;
   }
+  FillHistClass(classIndex, values);
+}
 
-  // get the corresponding std::list containng identifiers to the needed variables to be filled
-  list varList = fVariablesMap[className];
-
-  TIter next(hList);
-
-  TObject* h = nullptr;
-  bool isProfile;
-  bool isTHn;
-  int dimension = 0;
-  bool isSparse = kFALSE;
-  // TODO: At the moment, maximum 20 dimensions are foreseen for the THn histograms. We should make this more dynamic
-  //       But maybe its better to have it like to avoid dynamically allocating this array in the histogram loop
-  double fillValues[20] = {0.0};
-  int varX = -1, varY = -1, varZ = -1, varT = -1, varW = -1;
-
-  // loop over the histogram and std::list
-  // NOTE: these two should contain the same number of elements and be synchronized, otherwise its a mess
-  for (auto varIter = varList.begin(); varIter != varList.end(); varIter++) {
-    h = next(); // get the histogram
-    // decode information from the vector of indices
-    isProfile = (varIter->at(0) == 1 ? true : false);
-    isTHn = (varIter->at(1) > 0 ? true : false);
-    if (isTHn) {
-      dimension = varIter->at(1);
-    } else {
-      dimension = ((TH1*)h)->GetDimension();
-    }
-
-    // get the various variable indices
-    varW = varIter->at(2);
-    if (isTHn) {
-      for (int i = 0; i < dimension; i++) {
-        fillValues[i] = values[varIter->at(3 + i)];
-      }
-    } else {
-      varX = varIter->at(3);
-      varY = varIter->at(4);
-      varZ = varIter->at(5);
-      varT = varIter->at(6);
-    }
-
-    if (!isTHn) {
-      switch (dimension) {
-        case 1:
-          if (isProfile) {
-            if (varW > kNothing) {
-              ((TProfile*)h)->Fill(values[varX], values[varY], values[varW]);
-            } else {
-              ((TProfile*)h)->Fill(values[varX], values[varY]);
-            }
-          } else {
-            if (varW > kNothing) {
-              ((TH1F*)h)->Fill(values[varX], values[varW]);
-            } else {
-              ((TH1F*)h)->Fill(values[varX]);
-            }
-          }
-          break;
-        case 2:
-          if (isProfile) {
-            if (varW > kNothing) {
-              ((TProfile2D*)h)->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              ((TProfile2D*)h)->Fill(values[varX], values[varY], values[varZ]);
-            }
-          } else {
-            if (varW > kNothing) {
-              ((TH2F*)h)->Fill(values[varX], values[varY], values[varW]);
-            } else {
-              ((TH2F*)h)->Fill(values[varX], values[varY]);
-            }
-          }
-          break;
-        case 3:
-          if (isProfile) {
-            if (varW > kNothing) {
-              ((TProfile3D*)h)->Fill(values[varX], values[varY], values[varZ], values[varT], values[varW]);
-            } else {
-              ((TProfile3D*)h)->Fill(values[varX], values[varY], values[varZ], values[varT]);
-            }
-          } else {
-            if (varW > kNothing) {
-              ((TH3F*)h)->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              ((TH3F*)h)->Fill(values[varX], values[varY], values[varZ]);
-            }
-          }
-          break;
-
-        default:
-          break;
-      } // end switch
-    }   // end if(!isTHn)
-    else {
-      if (varW > kNothing) {
-        if (isSparse) {
-          ((THnSparseF*)h)->Fill(fillValues, values[varW]);
+//__________________________________________________________________
+void HistogramManager::FillHistClass(int classIndex, Float_t* values)
+{
+  //
+  //  fill a class of histograms, using the index returned by AddHistClass() or GetHistClassIndex()
+  //
+  if (classIndex < 0) {
+    return;
+  }
+  double fillValues[kMaxFillDimensions] = {0.0};
+  auto& plan = fFillPlans[classIndex];
+  for (std::size_t entryIndex = 0; entryIndex < plan.size(); ++entryIndex) {
+    const auto& entry = plan[entryIndex];
+    const int* vars = entry.fVars;
+    const int varW = entry.fVarW;
+    TObject* h = entry.fHist ? entry.fHist : Materialize(classIndex, entryIndex);
+    switch (entry.fKind) {
+      case kFillTH1:
+        if (varW > kNothing) {
+          ((TH1F*)h)->Fill(values[vars[0]], values[varW]);
         } else {
-          ((THnF*)h)->Fill(fillValues, values[varW]);
+          ((TH1F*)h)->Fill(values[vars[0]]);
         }
-      } else {
-        if (isSparse) {
-          ((THnSparseF*)h)->Fill(fillValues);
+        break;
+      case kFillTH2:
+        if (varW > kNothing) {
+          ((TH2F*)h)->Fill(values[vars[0]], values[vars[1]], values[varW]);
         } else {
-          ((THnF*)h)->Fill(fillValues);
+          ((TH2F*)h)->Fill(values[vars[0]], values[vars[1]]);
         }
-      }
-    } // end else
+        break;
+      case kFillTH3:
+        if (varW > kNothing) {
+          ((TH3F*)h)->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[varW]);
+        } else {
+          ((TH3F*)h)->Fill(values[vars[0]], values[vars[1]], values[vars[2]]);
+        }
+        break;
+      case kFillProfile1D:
+        if (varW > kNothing) {
+          ((TProfile*)h)->Fill(values[vars[0]], values[vars[1]], values[varW]);
+        } else {
+          ((TProfile*)h)->Fill(values[vars[0]], values[vars[1]]);
+        }
+        break;
+      case kFillProfile2D:
+        if (varW > kNothing) {
+          ((TProfile2D*)h)->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[varW]);
+        } else {
+          ((TProfile2D*)h)->Fill(values[vars[0]], values[vars[1]], values[vars[2]]);
+        }
+        break;
+      case kFillProfile3D:
+        if (varW > kNothing) {
+          ((TProfile3D*)h)->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[vars[3]], values[varW]);
+        } else {
+          ((TProfile3D*)h)->Fill(values[vars[0]], values[vars[1]], values[vars[2]], values[vars[3]]);
+        }
+        break;
+      case kFillTHn:
+        // THnF and THnSparseF are both filled through THnBase
+        for (int i = 0; i < entry.fNDims; i++) {
+          fillValues[i] = values[vars[i]];
+        }
+        if (varW > kNothing) {
+          ((THnBase*)h)->Fill(fillValues, values[varW]);
+        } else {
+          ((THnBase*)h)->Fill(fillValues);
+        }
+        break;
+      default:
+        break;
+    } // end switch
   }   // end loop over histograms
 }
 
@@ -24,8 +24,10 @@
 #include <TAxis.h>
 #include <TArrayD.h>
 
+#include <functional>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <list>
 
@@ -50,7 +52,10 @@ class HistogramManager : public TNamed
   }
 
   // Create a new histogram class
-  void AddHistClass(const char* histClass);
+  // The returned index can be used with FillHistClass(int, float*) to fill the class without a lookup by name
+  int AddHistClass(const char* histClass);
+  // Get the index of a histogram class, or -1 if the class does not exist
+  int GetHistClassIndex(const char* histClass) const;
   // Create a new histogram in the class <histClass> with name <name> and title <title>
   // The type of histogram is deduced from the parameters specified by the user
   // The binning for at least one dimension needs to be specified, namely: nXbins, xmin, xmax, varX which will result in a TH1F histogram
@@ -85,6 +90,13 @@ class HistogramManager : public TNamed
                     TString* axLabels = nullptr, int varW = -1, bool useSparse = kFALSE);
 
   void FillHistClass(const char* className, float* values);
+  void FillHistClass(int classIndex, float* values);
+
+  // Defer the creation of the histograms to their first fill, to be set before adding histograms
+  // The histograms of classes which are rarely or never filled then do not allocate their bins
+  // MaterializeHistograms() creates the histograms not filled yet, so that the output lists contain all the defined histograms
+  void SetDeferredAllocation(bool flag) { fDeferredAllocation = flag; }
+  void MaterializeHistograms();
 
   void SetUseDefaultVariableNames(bool flag) { fUseDefaultVariableNames = flag; };
   void SetDefaultVarNames(TString* vars, TString* units);
@@ -102,6 +114,32 @@ class HistogramManager : public TNamed
   bool* fUsedVars;                                                  //! flags of used variables
   std::map<std::string, std::list<std::vector<int>>> fVariablesMap; //!  map holding identifiers for all variables needed by histograms
 
+  // fill plan of a histogram: kind and variables decoded once when the histogram is added
+  enum FillKind {
+    kFillTH1 = 0,
+    kFillTH2,
+    kFillTH3,
+    kFillProfile1D,
+    kFillProfile2D,
+    kFillProfile3D,
+    kFillTHn
+  };
+  // TODO: At the moment, maximum 20 dimensions are foreseen for the THn histograms
+  static constexpr int kMaxFillDimensions = 20;
+  struct FillEntry {
+    TObject* fHist = nullptr;          //! histogram, nullptr until it is created
+    std::function<TObject*()> fCreate; //! creates the histogram, with the parameters given when it was added
+    TString fName;                     //! name of the histogram
+    int fKind = kFillTH1;
+    int fNDims = 0;
+    int fVarW = kNothing;
+    int fVars[kMaxFillDimensions] = {};
+  };
+  std::unordered_map<std::string, int> fClassIndices; //! index of each histogram class in fFillPlans
+  std::vector<std::vector<FillEntry>> fFillPlans;     //! fill plans of the histograms of each class, in the order of the histogram lists
+  std::vector<TList*> fClassLists;                    //! histogram list of each class
+  bool fDeferredAllocation;                           //! create the histograms at their first fill
+
   // various
   bool fUseDefaultVariableNames;    //! toggle the usage of default variable names and units
   unsigned long int fBinsAllocated; //! number of allocated bins
@@ -109,6 +147,10 @@ class HistogramManager : public TNamed
   TString* fVariableUnits;          //! variable units
 
   void MakeAxisLabels(TAxis* ax, const char* labels);
+  void AddFillEntry(const char* histClass, const char* hname, std::function<TObject*()> create, const std::vector<int>& varVector, int dimension);
+  bool HasHistogram(const char* histClass, const char* hname) const;
+  TObject* Materialize(int classIndex, int entryIndex);
+  static int FillDimension(bool isProfile, int dimension, int varT);
 
   HistogramManager& operator=(const HistogramManager& c);
   HistogramManager(const HistogramManager& c);
@@ -59,6 +59,9 @@ process(aod::McParticles const& mcTracks) {
 #include "MCProng.h"
 #include "TNamed.h"
 
+#include <array>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 using std::cout;
@@ -84,6 +87,14 @@ class MCSignal : public TNamed
   {
     return fProngs[0].fNGenerations;
   }
+  int GetNGenerations(int i) const
+  {
+    return fProngs[i].fNGenerations;
+  }
+  short GetCommonAncestorIdx(int i) const
+  {
+    return fCommonAncestorIdxs[i];
+  }
 
   template <typename U, typename... T>
   bool CheckSignal(bool checkSources, const U& mcStack, const T&... args)
@@ -96,6 +107,15 @@ class MCSignal : public TNamed
     return CheckMC(0, checkSources, mcStack, args...);
   };
 
+  // Check one particle against the prong i, without the common ancestor requirement.
+  // The index of the particle at the common ancestor generation of the prong is returned in ancestorLabel (-1 if there is none)
+  template <typename U, typename T>
+  bool CheckSingleProng(int i, bool checkSources, const U& mcStack, const T& track, int& ancestorLabel)
+  {
+    ancestorLabel = -1;
+    return CheckProng(i, checkSources, mcStack, track, &ancestorLabel);
+  }
+
   void PrintConfig();
 
  private:
@@ -105,7 +125,7 @@ class MCSignal : public TNamed
   int fTempAncestorLabel;
 
   template <typename U, typename T>
-  bool CheckProng(int i, bool checkSources, const U& mcStack, const T& track);
+  bool CheckProng(int i, bool checkSources, const U& mcStack, const T& track, int* ancestorLabel = nullptr);
 
   template <typename U>
   bool CheckMC(int, bool, U)
@@ -128,7 +148,7 @@ class MCSignal : public TNamed
 };
 
 template <typename U, typename T>
-bool MCSignal::CheckProng(int i, bool checkSources, const U& mcStack, const T& track)
+bool MCSignal::CheckProng(int i, bool checkSources, const U& mcStack, const T& track, int* ancestorLabel)
 {
   auto currentMCParticle = track;
   // loop over the generations specified for this prong
@@ -139,7 +159,10 @@ bool MCSignal::CheckProng(int i, bool checkSources, const U& mcStack, const T& t
     }
     // check the common ancestor (if specified)
     if (fNProngs > 1 && fCommonAncestorIdxs[i] == j) {
-      if (i == 0) {
+      if (ancestorLabel) {
+        // the common ancestor is compared by the caller
+        *ancestorLabel = currentMCParticle.globalIndex();
+      } else if (i == 0) {
         fTempAncestorLabel = currentMCParticle.globalIndex();
       } else {
         if (currentMCParticle.globalIndex() != fTempAncestorLabel) {
@@ -265,4 +288,94 @@ bool MCSignal::CheckProng(int i, bool checkSources, const U& mcStack, const T& t
   return true;
 }
 
+//_________________________________________________________________________
+// Decisions of a list of MC signals for tuples of particles of one MC stack.
+// Each particle is checked once against all the prongs of all the signals, and the decisions are reused for all the tuples
+//   the particle is part of, instead of walking its history again for every tuple and signal.
+// NOTE: the particles are identified by their global index, Reset() must be called when the MC stack changes
+class MCSignalCache
+{
+ public:
+  MCSignalCache() = default;
+
+  void Reset(std::vector<MCSignal>* signals, bool checkSources = false)
+  {
+    fSignals = signals;
+    fCheckSources = checkSources;
+    fSignalOffsets.clear();
+    int offset = 0;
+    for (auto& sig : *fSignals) {
+      fSignalOffsets.push_back(offset);
+      offset += sig.GetNProngs();
+    }
+    Clear();
+  }
+  // forget the decisions of the particles, keeping the signals
+  void Clear()
+  {
+    fRows.clear();
+    fDecisions.clear();
+  }
+
+  // bit map of the signals matched by the tuple of particles, same as MCSignal::CheckSignal() for each signal
+  template <typename U, typename T, typename... Ts>
+  uint32_t CheckSignals(const U& mcStack, const T& particle, const Ts&... particles)
+  {
+    constexpr int nParticles = 1 + sizeof...(particles);
+    std::array<int, nParticles> rows = {GetRow(mcStack, particle), GetRow(mcStack, particles)...};
+    uint32_t decisions = 0;
+    for (unsigned int isig = 0; isig < fSignals->size(); isig++) {
+      const MCSignal& sig = (*fSignals)[isig];
+      if (sig.GetNProngs() != nParticles) {
+        continue;
+      }
+      bool pass = true;
+      for (int i = 0; i < nParticles && pass; i++) {
+        const ProngDecision& decision = fDecisions[rows[i] + fSignalOffsets[isig] + i];
+        pass = decision.fPass;
+        // same common ancestor as the first prong, if required
+        if (pass && i > 0 && sig.GetCommonAncestorIdx(i) >= 0 && sig.GetCommonAncestorIdx(i) < sig.GetNGenerations(i)) {
+          pass = (decision.fAncestorLabel == fDecisions[rows[0] + fSignalOffsets[isig]].fAncestorLabel);
+        }
+      }
+      if (pass) {
+        decisions |= (uint32_t(1) << isig);
+      }
+    }
+    return decisions;
+  }
+
+ private:
+  struct ProngDecision {
+    bool fPass;
+    int fAncestorLabel;
+  };
+
+  // offset of the decisions of a particle, computed at the first request
+  template <typename U, typename T>
+  int GetRow(const U& mcStack, const T& particle)
+  {
+    auto it = fRows.find(particle.globalIndex());
+    if (it != fRows.end()) {
+      return it->second;
+    }
+    int row = fDecisions.size();
+    fRows.emplace(particle.globalIndex(), row);
+    for (auto& sig : *fSignals) {
+      for (int i = 0; i < sig.GetNProngs(); i++) {
+        ProngDecision decision;
+        decision.fPass = sig.CheckSingleProng(i, fCheckSources, mcStack, particle, decision.fAncestorLabel);
+        fDecisions.push_back(decision);
+      }
+    }
+    return row;
+  }
+
+  std::vector<MCSignal>* fSignals = nullptr; // signals to be checked
+  bool fCheckSources = false;                // check the source bits of the prongs
+  std::vector<int> fSignalOffsets;           // offset of the prongs of each signal in a row of decisions
+  std::unordered_map<int64_t, int> fRows;    // offset of the decisions of each particle, by global index
+  std::vector<ProngDecision> fDecisions;     // decisions of all the checked particles
+};
+
 #endif
@@ -15,7 +15,9 @@
 #ifndef PWGDQ_CORE_MCSIGNALLIBRARY_H_
 #define PWGDQ_CORE_MCSIGNALLIBRARY_H_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include "PWGDQ/Core/MCProng.h"
 #include "PWGDQ/Core/MCSignal.h"
 
@@ -23,11 +25,27 @@ namespace o2::aod
 {
 namespace dqmcsignals
 {
+// NOTE: each signal is built only once from the definitions below and then copied, the caller owns the returned signal
 MCSignal* GetMCSignal(const char* signalName);
-}
+// build a signal from its definition
+MCSignal* BuildMCSignal(const char* signalName);
+} // namespace dqmcsignals
 } // namespace o2::aod
 
 MCSignal* o2::aod::dqmcsignals::GetMCSignal(const char* name)
+{
+  //
+  // get a copy of a signal, which is built at the first request
+  //
+  static std::unordered_map<std::string, std::unique_ptr<MCSignal>> cache;
+  auto it = cache.find(name);
+  if (it == cache.end()) {
+    it = cache.emplace(name, std::unique_ptr<MCSignal>(BuildMCSignal(name))).first;
+  }
+  return it->second ? new MCSignal(*(it->second)) : nullptr;
+}
+
+MCSignal* o2::aod::dqmcsignals::BuildMCSignal(const char* name)
 {
   std::string nameStr = name;
   MCSignal* signal;
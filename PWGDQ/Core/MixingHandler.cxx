@@ -12,6 +12,7 @@
 #include "PWGDQ/Core/MixingHandler.h"
 #include "PWGDQ/Core/VarManager.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 using namespace std;
@@ -63,29 +64,26 @@ void MixingHandler::AddMixingVariable(int var, int nBins, float* binLims)
   varBins.Set(nBins, binLims);
   fVariableLimits.push_back(varBins);
   VarManager::SetUseVariable(var);
+  fIsInitialized = kFALSE; // the category lookup needs to be compiled again
 }
 
 //_________________________________________________________________________
 void MixingHandler::AddMixingVariable(int var, int nBins, std::vector<float> binLims)
 {
 
-  float* bins = new float[nBins];
-  for (int i = 0; i < nBins; ++i) {
-    bins[i] = binLims[i];
-  }
-  AddMixingVariable(var, nBins, bins);
+  AddMixingVariable(var, nBins, binLims.data());
 }
 
 //_________________________________________________________________________
 int MixingHandler::GetMixingVariable(VarManager::Variables var)
 {
-  int i = 0;
-  for (auto v = fVariables.begin(); v != fVariables.end(); v++, i++) {
-    if (*v == var) {
-      return i;
-    }
+  if (!fIsInitialized) {
+    Init();
   }
-  return -1;
+  if (var < 0 || var >= static_cast<int>(fVariablePositions.size())) {
+    return -1;
+  }
+  return fVariablePositions[var];
 }
 
 //_________________________________________________________________________
@@ -110,15 +108,61 @@ void MixingHandler::Init()
   //
   // Initialization of pools
   //       The correct event category will be retrieved using the function FindEventCategory()
+  //       The lookup is compiled here: category strides, and bin widths for the variables with uniform bins
   //
-  int size = 1;
-  for (auto v : fVariableLimits) {
-    size *= (v.GetSize() - 1);
+  const int nVars = fVariables.size();
+  fVariablePositions.assign(VarManager::kNVars, -1);
+  fStrides.assign(nVars, 1);
+  fNBins.assign(nVars, 0);
+  fLowEdges.assign(nVars, 0.f);
+  fInvBinWidths.assign(nVars, 0.f);
+  for (int iVar = nVars - 1; iVar >= 0; --iVar) {
+    const TArrayF& limits = fVariableLimits[iVar];
+    if (fVariables[iVar] >= 0 && fVariables[iVar] < VarManager::kNVars) { // looping backwards, the first occurrence is kept
+      fVariablePositions[fVariables[iVar]] = iVar;
+    }
+    fNBins[iVar] = limits.GetSize() - 1;
+    if (iVar < nVars - 1) {
+      fStrides[iVar] = fStrides[iVar + 1] * fNBins[iVar + 1];
+    }
+    if (fNBins[iVar] < 1) {
+      continue;
+    }
+    fLowEdges[iVar] = limits.At(0);
+    const float width = (limits.At(fNBins[iVar]) - limits.At(0)) / fNBins[iVar];
+    bool isUniform = width > 0.f;
+    for (int iBin = 1; iBin <= fNBins[iVar] && isUniform; ++iBin) {
+      isUniform = TMath::Abs(limits.At(iBin) - limits.At(iBin - 1) - width) <= 1.e-5 * width;
+    }
+    fInvBinWidths[iVar] = isUniform ? 1.f / width : 0.f;
   }
-  (void)size;
   fIsInitialized = kTRUE;
 }
 
+//_________________________________________________________________________
+int MixingHandler::FindBin(int iVar, float value) const
+{
+  //
+  // Find the bin of a mixing variable, -1 if outside the limits
+  //
+  const TArrayF& limits = fVariableLimits[iVar];
+  const int nBins = fNBins[iVar];
+  if (nBins < 1 || !(value >= limits.At(0)) || !(value < limits.At(nBins))) {
+    return -1; // all variables must be inside limits
+  }
+  if (fInvBinWidths[iVar] == 0.f) {
+    return TMath::BinarySearch(limits.GetSize(), limits.GetArray(), value);
+  }
+  int bin = TMath::Min(static_cast<int>((value - fLowEdges[iVar]) * fInvBinWidths[iVar]), nBins - 1);
+  // the arithmetic can be off by one bin at the limits because of rounding
+  if (value >= limits.At(bin + 1)) {
+    ++bin;
+  } else if (bin > 0 && value < limits.At(bin)) {
+    --bin;
+  }
+  return bin;
+}
+
 //_________________________________________________________________________
 int MixingHandler::FindEventCategory(float* values)
 {
@@ -132,33 +176,42 @@ int MixingHandler::FindEventCategory(float* values)
     Init();
   }
 
-  std::vector<int> bin;
-  int iVar = 0;
-  for (auto v = fVariableLimits.begin(); v != fVariableLimits.end(); v++, iVar++) {
-    int binValue = TMath::BinarySearch((*v).GetSize(), (*v).GetArray(), values[fVariables[iVar]]);
-    bin.push_back(binValue);
-    if (bin[iVar] == -1 || bin[iVar] == (*v).GetSize() - 1) {
-      return -1; // all variables must be inside limits
+  int category = 0;
+  for (unsigned int iVar = 0; iVar < fVariables.size(); ++iVar) {
+    const int bin = FindBin(iVar, values[fVariables[iVar]]);
+    if (bin < 0) {
+      return -1;
     }
+    category += bin * fStrides[iVar];
   }
+  return category;
+}
 
-  int category = 0;
-  int tempCategory = 1;
-  int iv1 = 0;
-  int iv2 = 0;
-  for (auto v1 = fVariables.begin(); v1 != fVariables.end(); v1++, iv1++) {
-    tempCategory = 1;
-    iv2 = iv1;
-    for (auto v2 = v1; v2 != fVariables.end(); v2++, iv2++) {
-      if (iv2 == iv1) {
-        tempCategory *= bin[iv2];
-      } else {
-        tempCategory *= (fVariableLimits[iv2].GetSize() - 1);
+//_________________________________________________________________________
+void MixingHandler::FindEventCategories(int nEvents, const float* values, int valuesStride, int* categories)
+{
+  //
+  // Find the event categories of a whole table of events, variable by variable
+  //
+  if (fVariables.size() == 0) {
+    std::fill_n(categories, nEvents, -1);
+    return;
+  }
+  if (!fIsInitialized) {
+    Init();
+  }
+
+  std::fill_n(categories, nEvents, 0);
+  for (unsigned int iVar = 0; iVar < fVariables.size(); ++iVar) {
+    const float* varValues = values + fVariables[iVar];
+    for (int iEvent = 0; iEvent < nEvents; ++iEvent) {
+      if (categories[iEvent] < 0) {
+        continue;
       }
+      const int bin = FindBin(iVar, varValues[static_cast<std::size_t>(iEvent) * valuesStride]);
+      categories[iEvent] = bin < 0 ? -1 : categories[iEvent] + bin * fStrides[iVar];
     }
-    category += tempCategory;
   }
-  return category;
 }
 
 //_________________________________________________________________________
@@ -46,6 +46,7 @@ class MixingHandler : public TNamed
 
   void Init();
   int FindEventCategory(float* values);
+  void FindEventCategories(int nEvents, const float* values, int valuesStride, int* categories); // categories of nEvents events, with the variables of event i starting at values[i * valuesStride]
   int GetBinFromCategory(VarManager::Variables var, int category) const;
 
  private:
@@ -58,6 +59,15 @@ class MixingHandler : public TNamed
   std::vector<TArrayF> fVariableLimits;
   std::vector<int> fVariables;
 
+  // Compiled category lookup, filled in Init()
+  std::vector<int> fVariablePositions; //! position of each VarManager variable in fVariables, -1 if not a mixing variable
+  std::vector<int> fStrides;           //! category stride of each mixing variable
+  std::vector<int> fNBins;             //! number of bins of each mixing variable
+  std::vector<float> fLowEdges;        //! lowest limit of each mixing variable
+  std::vector<float> fInvBinWidths;    //! inverse bin width of each mixing variable with uniform bins, 0 otherwise
+
+  int FindBin(int iVar, float value) const;
+
   ClassDef(MixingHandler, 1);
 };
 
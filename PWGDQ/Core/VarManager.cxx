@@ -10,21 +10,34 @@
 // or submit itself to any jurisdiction.
 
 #include "PWGDQ/Core/VarManager.h"
+#include "Framework/Logger.h"
 
+#include <algorithm>
 #include <cmath>
+#include <initializer_list>
 
 ClassImp(VarManager);
 
 TString VarManager::fgVariableNames[VarManager::kNVars] = {""};
 TString VarManager::fgVariableUnits[VarManager::kNVars] = {""};
 bool VarManager::fgUsedVars[VarManager::kNVars] = {kFALSE};
+std::vector<int> VarManager::fgUsedVarsList;
+uint32_t VarManager::fgUsedVarGroups = 0;
 float VarManager::fgValues[VarManager::kNVars] = {0.0f};
 std::map<int, int> VarManager::fgRunMap;
 TString VarManager::fgRunStr = "";
+std::map<int, VarManager::TPCPostCalibMaps> VarManager::fgTPCPostCalibRunMaps;
+VarManager::TPCPostCalibMaps VarManager::fgTPCPostCalibMaps = {0.0f};
+int VarManager::fgTPCPostCalibRun = -1;
+bool VarManager::fgTPCPostCalibActive = false;
 o2::vertexing::DCAFitterN<2> VarManager::fgFitterTwoProngBarrel;
 o2::vertexing::DCAFitterN<3> VarManager::fgFitterThreeProngBarrel;
 o2::vertexing::FwdDCAFitterN<2> VarManager::fgFitterTwoProngFwd;
 o2::vertexing::FwdDCAFitterN<3> VarManager::fgFitterThreeProngFwd;
+bool VarManager::fgUseDileptonTrackCache = false;
+VarManager::DileptonTrackVertexingCache VarManager::fgDileptonTrackCache;
+bool VarManager::fgUseFwdTrackCache = false;
+std::unordered_map<int64_t, o2::track::TrackParCovFwd> VarManager::fgFwdTrackCache;
 
 //__________________________________________________________________
 VarManager::VarManager() : TObject()
@@ -50,6 +63,42 @@ void VarManager::SetVariableDependencies()
   }
 }
 
+//__________________________________________________________________
+void VarManager::UpdateUsedVarsList()
+{
+  //
+  // rebuild the list of used variables and the used groups of variables from the flags
+  //
+  fgUsedVarsList.clear();
+  for (int i = 0; i < kNVars; ++i) {
+    if (fgUsedVars[i]) {
+      fgUsedVarsList.push_back(i);
+    }
+  }
+
+  auto anyUsed = [](std::initializer_list<int> vars) {
+    for (const auto& var : vars) {
+      if (fgUsedVars[var]) {
+        return true;
+      }
+    }
+    return false;
+  };
+  fgUsedVarGroups = 0;
+  if (anyUsed({kIsITSrefit, kTrackTimeResIsRange, kIsTPCrefit, kPVContributor, kIsGoldenChi2, kOrphanTrack, kIsSPDfirst, kIsSPDboth, kIsSPDany, kITSClusterMap})) {
+    fgUsedVarGroups |= kVarGroupBarrelFlags;
+  }
+  if (anyUsed({kTrackDCAsigXY, kTrackDCAsigZ, kTrackDCAresXY, kTrackDCAresZ})) {
+    fgUsedVarGroups |= kVarGroupDCAsigRes;
+  }
+  if (anyUsed({kTPCsignalRandomized, kTPCnSigmaElRandomized, kTPCnSigmaPiRandomized, kTPCnSigmaPrRandomized})) {
+    fgUsedVarGroups |= kVarGroupTPCRandomized;
+  }
+  if (anyUsed({kTPCnSigmaEl_Corr, kTPCnSigmaPi_Corr, kTPCnSigmaPr_Corr})) {
+    fgUsedVarGroups |= kVarGroupTPCPostCalib;
+  }
+}
+
 //__________________________________________________________________
 void VarManager::ResetValues(int startValue, int endValue, float* values)
 {
@@ -64,6 +113,20 @@ void VarManager::ResetValues(int startValue, int endValue, float* values)
   }
 }
 
+//__________________________________________________________________
+void VarManager::ResetUsedValues(float* values)
+{
+  //
+  // reset the used variables to the same value as in ResetValues()
+  // NOTE: the variables which are not used keep their last value, since they are not read by the histograms, cuts or tables
+  if (!values) {
+    values = fgValues;
+  }
+  for (const auto& var : fgUsedVarsList) {
+    values[var] = -9999.;
+  }
+}
+
 //__________________________________________________________________
 void VarManager::SetRunNumbers(int n, int* runs)
 {
@@ -111,54 +174,65 @@ void VarManager::FillTrackDerived(float* values)
   }
 }
 //_________________________________________________________________________________________________________________________________________________________________________________
-float VarManager::GetTPCPostCalibMap(float pin, float eta, int particle_type, TString period)
+void VarManager::SetTPCPostCalibParams(int run, const std::vector<float>& params)
 {
-  if (period.Contains("LHC22m_pass1_subset")) {
-    float El_mean_curve_pin = (pin < 0.3) ? 1.74338 : ((pin < 3.5) ? 1 / (0.694318 - 5.66879 * pin) + 2.73696 + 0.000483342 * pin : 2.70321);
-    float Pi_mean_curve_pin = (pin < 0.3) ? 1.95561 : ((pin < 3) ? -0.0606029 / pin + 2.18796 - 0.101135 * pin : 1.86435);
-    float Pr_mean_curve_pin = (pin < 0.4) ? 1.94664 : ((pin < 5) ? 1 / (-0.495484 - 1.03622 * pin) + 3.0513 - 0.0143036 * pin : 2.80362);
-    float El_mean_curve_eta = (std::abs(eta) < 0.9) ? -1.17942e-01 + -1.51932e-01 * std::cos(4.32572e+00 * eta) : 0.0;
-    float Pi_mean_curve_eta = (std::abs(eta) < 0.9) ? -5.21188e-02 + -3.35413e-01 * std::cos(4.16710e+00 * eta) : 0.0;
-    float Pr_mean_curve_eta = (std::abs(eta) < 0.9) ? -1.33413e-02 + -3.83269e-01 * std::cos(3.95128e+00 * eta) : 0.0;
-
-    float pin_map = (particle_type == 0) ? El_mean_curve_pin : ((particle_type == 1) ? Pi_mean_curve_pin : Pr_mean_curve_pin);
-    float eta_map = (particle_type == 0) ? El_mean_curve_eta : ((particle_type == 1) ? Pi_mean_curve_eta : Pr_mean_curve_eta);
-    float map = pin_map + eta_map;
-    return map;
-  } else if (period.Contains("LHC22f_pass1")) {
-    float El_mean_curve_pin = (pin < 0.3) ? 0.24335236 : ((pin < 3.5) ? 1 / (0.0113621 - 2.44516 * pin) + 1.63907 - 0.0367754 * pin : 1.3933518);
-    float Pi_mean_curve_pin = (pin < 0.3) ? -0.30059726 : ((pin < 3.5) ? 1 / (-4.51007e+06 - 5.52635e+06 * pin) - 0.349193 + 0.171139 * pin - 0.0305089 * pin * pin : -0.12394057);
-    float Pr_mean_curve_pin = (pin < 0.3) ? 0.1 : ((pin < 3.5) ? 1 / (0.482973 - 3.55557 * pin) + 1.38574 - 0.627066 * pin + 0.103612 * pin * pin : 0.37665460);
-    float El_mean_curve_eta = (std::abs(eta) < 0.9) ? -0.25877 + -0.136459 * eta : 0.0;
-    float Pi_mean_curve_eta = (std::abs(eta) < 0.9) ? -0.250769 + -0.321296 * eta + 0.509874 * eta * eta + 0.445708 * eta * eta * eta : 0.0;
-    float Pr_mean_curve_eta = (std::abs(eta) < 0.9) ? -0.330935 + -0.395157 * eta + 0.582457 * eta * eta + 0.501215 * eta * eta * eta : 0.0;
-
-    float pin_map = (particle_type == 0) ? El_mean_curve_pin : ((particle_type == 1) ? Pi_mean_curve_pin : Pr_mean_curve_pin);
-    float eta_map = (particle_type == 0) ? El_mean_curve_eta : ((particle_type == 1) ? Pi_mean_curve_eta : Pr_mean_curve_eta);
+  //
+  // set the TPC post-calibration maps of a run, which take precedence over the built-in ones
+  //
+  if (params.size() != fgTPCPostCalibMaps.size()) {
+    LOGF(fatal, "TPC post-calibration of run %d has %zu parameters, expected %zu", run, params.size(), fgTPCPostCalibMaps.size());
+  }
+  std::copy(params.begin(), params.end(), fgTPCPostCalibRunMaps[run].begin());
+  if (run == fgTPCPostCalibRun) {
+    fgTPCPostCalibRun = -1; // resolve again at the next track
+  }
+}
 
-    float map = pin_map + eta_map;
-    return map;
-  } else {
-    float map = 0.0;
-    return map;
+//__________________________________________________________________
+void VarManager::SetupTPCPostCalib(int run)
+{
+  //
+  // resolve the TPC post-calibration maps of a run, such that the tracks only evaluate them
+  //
+  fgTPCPostCalibRun = run;
+  fgTPCPostCalibActive = true;
+  auto runMaps = fgTPCPostCalibRunMaps.find(run);
+  if (runMaps != fgTPCPostCalibRunMaps.end()) {
+    fgTPCPostCalibMaps = runMaps->second;
+    return;
+  }
+  // built-in maps, for electrons, pions and protons
+  // pinLow, valueLow, pinHigh, valueHigh, invN, invA, invB, p0, p1, p2, etaMax, eta0, etaCosAmp, etaCosFreq, eta1, eta2, eta3
+  switch (GetRunPeriod(run)) {
+    case kRunPeriodLHC22mPass1Subset:
+      fgTPCPostCalibMaps = {0.3, 1.74338, 3.5, 2.70321, 1.0, 0.694318, -5.66879, 2.73696, 0.000483342, 0.0, 0.9, -1.17942e-01, -1.51932e-01, 4.32572e+00, 0.0, 0.0, 0.0,
+                            0.3, 1.95561, 3.0, 1.86435, -0.0606029, 0.0, 1.0, 2.18796, -0.101135, 0.0, 0.9, -5.21188e-02, -3.35413e-01, 4.16710e+00, 0.0, 0.0, 0.0,
+                            0.4, 1.94664, 5.0, 2.80362, 1.0, -0.495484, -1.03622, 3.0513, -0.0143036, 0.0, 0.9, -1.33413e-02, -3.83269e-01, 3.95128e+00, 0.0, 0.0, 0.0};
+      break;
+    case kRunPeriodLHC22fPass1:
+      fgTPCPostCalibMaps = {0.3, 0.24335236, 3.5, 1.3933518, 1.0, 0.0113621, -2.44516, 1.63907, -0.0367754, 0.0, 0.9, -0.25877, 0.0, 0.0, -0.136459, 0.0, 0.0,
+                            0.3, -0.30059726, 3.5, -0.12394057, 1.0, -4.51007e+06, -5.52635e+06, -0.349193, 0.171139, -0.0305089, 0.9, -0.250769, 0.0, 0.0, -0.321296, 0.509874, 0.445708,
+                            0.3, 0.1, 3.5, 0.37665460, 1.0, 0.482973, -3.55557, 1.38574, -0.627066, 0.103612, 0.9, -0.330935, 0.0, 0.0, -0.395157, 0.582457, 0.501215};
+      break;
+    default:
+      fgTPCPostCalibActive = false;
   }
 }
+
 //__________________________________________________________________
-TString VarManager::GetRunPeriod(float runNumber)
+int VarManager::GetRunPeriod(float runNumber)
 {
+  // NOTE: the period of the built-in TPC post-calibration maps, only looked up when the run changes
   int runlist_22f[2] = {520259, 520473};
   int runlist_22m[2] = {523393, 523397};
 
   if (runNumber >= runlist_22f[0] && runNumber <= runlist_22f[1]) {
-    TString runperiod = "LHC22f_pass1";
-    return runperiod;
+    return kRunPeriodLHC22fPass1;
   } else if (runNumber >= runlist_22m[0] && runNumber <= runlist_22m[1]) {
-    TString runperiod = "LHC22m_pass1_subset";
-    return runperiod;
+    return kRunPeriodLHC22mPass1Subset;
   } else {
-    TString runperiod = "none";
     // LOGF(info, "can't find run period for run %.0d", runNumber);
-    return runperiod;
+    return kRunPeriodNone;
   }
 };
 //__________________________________________________________________
@@ -17,8 +17,10 @@
 #ifndef PWGDQ_CORE_VARMANAGER_H_
 #define PWGDQ_CORE_VARMANAGER_H_
 
+#include <array>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <iostream>
 #include <utility>
@@ -338,6 +340,7 @@ class VarManager : public TObject
       fgUsedVars[var] = kTRUE;
     }
     SetVariableDependencies();
+    UpdateUsedVarsList();
   }
   static void SetUseVars(const bool* usedVars)
   {
@@ -347,12 +350,14 @@ class VarManager : public TObject
       }
     }
     SetVariableDependencies();
+    UpdateUsedVarsList();
   }
   static void SetUseVars(const std::vector<int> usedVars)
   {
     for (auto& var : usedVars) {
       fgUsedVars[var] = true;
     }
+    UpdateUsedVarsList();
   }
   static bool GetUsedVar(int var)
   {
@@ -361,6 +366,11 @@ class VarManager : public TObject
     }
     return false;
   }
+  // list of the indices of the used variables, in increasing order
+  static const std::vector<int>& GetUsedVarsList()
+  {
+    return fgUsedVarsList;
+  }
 
   static void SetRunNumbers(int n, int* runs);
   static void SetRunNumbers(std::vector<int> runs);
@@ -373,6 +383,35 @@ class VarManager : public TObject
     return fgRunStr;
   }
 
+  // parameters of the TPC post-calibration map of one particle species, the map is the sum of
+  //   pin < PinLow ? ValueLow : (pin < PinHigh ? InvN / (InvA + InvB * pin) + P0 + P1 * pin + P2 * pin^2 : ValueHigh)
+  //   |eta| < EtaMax ? Eta0 + EtaCosAmp * cos(EtaCosFreq * eta) + Eta1 * eta + Eta2 * eta^2 + Eta3 * eta^3 : 0
+  enum TPCPostCalibParams {
+    kTPCPostCalibPinLow = 0,
+    kTPCPostCalibValueLow,
+    kTPCPostCalibPinHigh,
+    kTPCPostCalibValueHigh,
+    kTPCPostCalibInvN,
+    kTPCPostCalibInvA,
+    kTPCPostCalibInvB,
+    kTPCPostCalibP0,
+    kTPCPostCalibP1,
+    kTPCPostCalibP2,
+    kTPCPostCalibEtaMax,
+    kTPCPostCalibEta0,
+    kTPCPostCalibEtaCosAmp,
+    kTPCPostCalibEtaCosFreq,
+    kTPCPostCalibEta1,
+    kTPCPostCalibEta2,
+    kTPCPostCalibEta3,
+    kNTPCPostCalibParams
+  };
+  static constexpr int kNTPCPostCalibSpecies = 3; // electron, pion, proton
+
+  // Sets the TPC post-calibration maps of a run, e.g. from CCDB, replacing the built-in ones
+  // params holds the kNTPCPostCalibParams parameters of the electron, pion and proton maps, in this order
+  static void SetTPCPostCalibParams(int run, const std::vector<float>& params);
+
   // Setup the 2 prong DCAFitterN
   static void SetupTwoProngDCAFitter(float magField, bool propagateToPCA, float maxR, float maxDZIni, float minParamChange, float minRelChi2Change, bool useAbsDCA)
   {
@@ -395,6 +434,30 @@ class VarManager : public TObject
     fgFitterTwoProngFwd.setMinRelChi2Change(minRelChi2Change);
     fgFitterTwoProngFwd.setUseAbsDCA(useAbsDCA);
   }
+  // Reuse the dilepton legs and their two-prong fit in FillDileptonTrackVertexing for consecutive calls with the same dilepton
+  static void SetUseDileptonTrackVertexingCache(bool useCache)
+  {
+    fgUseDileptonTrackCache = useCache;
+    ResetDileptonTrackVertexingCache();
+  }
+  // The cache is identified by the indices of the legs, so it must be reset whenever these may point to different tracks (e.g. new time frame)
+  static void ResetDileptonTrackVertexingCache()
+  {
+    fgDileptonTrackCache.leg1 = -1;
+    fgDileptonTrackCache.leg2 = -1;
+  }
+  // Build the forward track parameters of a muon once and reuse them in FillPairVertexing for all the pairs of the muon
+  static void SetUseFwdTrackCache(bool useCache)
+  {
+    fgUseFwdTrackCache = useCache;
+    ResetFwdTrackCache();
+  }
+  // The cached muons are identified by their global index, so the cache must be reset at every event
+  static void ResetFwdTrackCache()
+  {
+    fgFwdTrackCache.clear();
+  }
+
   static auto getEventPlane(int harm, float qnxa, float qnya)
   {
     // Compute event plane angle from qn vector components for the sub-event A
@@ -428,18 +491,123 @@ class VarManager : public TObject
 
   static float fgValues[kNVars]; // array holding all variables computed during analysis
   static void ResetValues(int startValue = 0, int endValue = kNVars, float* values = nullptr);
+  static void ResetUsedValues(float* values = nullptr); // reset only the used variables, the others are never read
+
+  // Array of variables owned by a task (or a thread), to be passed to the Fill* functions instead of fgValues,
+  // such that different tasks and threads do not share the values being computed
+  // NOTE: the vertexing functions still share the static DCA fitters
+  class ValuesContext
+  {
+   public:
+    ValuesContext() { VarManager::ResetValues(0, kNVars, fValues); }
+    float* Data() { return fValues; }
+    const float* Data() const { return fValues; }
+    float& operator[](int var) { return fValues[var]; }
+    float operator[](int var) const { return fValues[var]; }
+    void Reset() { VarManager::ResetUsedValues(fValues); }
+
+   private:
+    float fValues[kNVars];
+  };
+
+  // Variables of a batch of objects (e.g. the pairs of an event), stored as one contiguous column per used variable (struct of arrays).
+  // The columns are defined from the used variables at the first Clear() call, after the histograms and cuts have been configured
+  class ValuesBatch
+  {
+   public:
+    void Clear()
+    {
+      if (fColumnOfVar.empty()) {
+        fVars = VarManager::GetUsedVarsList();
+        fColumnOfVar.assign(kNVars, -1);
+        for (unsigned int icol = 0; icol < fVars.size(); ++icol) {
+          fColumnOfVar[fVars[icol]] = icol;
+        }
+        fColumns.resize(fVars.size());
+      }
+      for (auto& column : fColumns) {
+        column.clear();
+      }
+      fSize = 0;
+    }
+    int Size() const { return fSize; }
+    // append the used variables of a full array of values as a new entry
+    void Push(const float* values)
+    {
+      for (unsigned int icol = 0; icol < fVars.size(); ++icol) {
+        fColumns[icol].push_back(values[fVars[icol]]);
+      }
+      fSize++;
+    }
+    // column of a variable over all entries, nullptr if the variable is not used
+    const float* Column(int var) const
+    {
+      int icol = fColumnOfVar.empty() ? -1 : fColumnOfVar[var];
+      return icol < 0 ? nullptr : fColumns[icol].data();
+    }
+    // copy the used variables of an entry back into a full array of values
+    void Get(int entry, float* values) const
+    {
+      for (unsigned int icol = 0; icol < fVars.size(); ++icol) {
+        values[fVars[icol]] = fColumns[icol][entry];
+      }
+    }
+
+   private:
+    std::vector<int> fVars;                   // used variables, one per column
+    std::vector<int> fColumnOfVar;            // column of each variable, -1 if not used
+    std::vector<std::vector<float>> fColumns; // values of each used variable over the entries
+    int fSize = 0;                            // number of entries
+  };
 
  private:
-  static bool fgUsedVars[kNVars];        // holds flags for when the corresponding variable is needed (e.g., in the histogram manager, in cuts, mixing handler, etc.)
-  static void SetVariableDependencies(); // toggle those variables on which other used variables might depend
+  static bool fgUsedVars[kNVars];         // holds flags for when the corresponding variable is needed (e.g., in the histogram manager, in cuts, mixing handler, etc.)
+  static std::vector<int> fgUsedVarsList; // indices of the used variables, kept in sync with fgUsedVars
+  static uint32_t fgUsedVarGroups;        // groups of variables with at least one used variable, see VarGroups
+  static void SetVariableDependencies();  // toggle those variables on which other used variables might depend
+  static void UpdateUsedVarsList();
+
+  // groups of optional variables which are filled together, such that the Fill functions check a single flag when none of them is used
+  enum VarGroups {
+    kVarGroupBarrelFlags = BIT(0),   // track flags and ITS cluster map bits
+    kVarGroupDCAsigRes = BIT(1),     // DCA significances and resolutions
+    kVarGroupTPCRandomized = BIT(2), // randomized TPC signal and n-sigmas
+    kVarGroupTPCPostCalib = BIT(3)   // post-calibrated TPC n-sigmas
+  };
+
+  // periods with a TPC post-calibration map
+  enum RunPeriods {
+    kRunPeriodNone = 0,
+    kRunPeriodLHC22fPass1,
+    kRunPeriodLHC22mPass1Subset
+  };
 
   static std::map<int, int> fgRunMap; // map of runs to be used in histogram axes
   static TString fgRunStr;            // semi-colon separated list of runs, to be used for histogram axis labels
 
   static void FillEventDerived(float* values = nullptr);
   static void FillTrackDerived(float* values = nullptr);
-  static float GetTPCPostCalibMap(float pin, float eta, int particle_type, TString period);
-  static TString GetRunPeriod(float runNumber);
+  static int GetRunPeriod(float runNumber);
+
+  // TPC post-calibration maps, resolved once per run by SetupTPCPostCalib
+  using TPCPostCalibMaps = std::array<float, kNTPCPostCalibSpecies * kNTPCPostCalibParams>;
+  static std::map<int, TPCPostCalibMaps> fgTPCPostCalibRunMaps; // maps set for given runs
+  static TPCPostCalibMaps fgTPCPostCalibMaps;                  // maps of the current run
+  static int fgTPCPostCalibRun;                                // run of the current maps
+  static bool fgTPCPostCalibActive;                            // whether the current run has maps
+  static void SetupTPCPostCalib(int run);
+  static float GetTPCPostCalibMap(float pin, float eta, const float* params)
+  {
+    float pinMap = (pin < params[kTPCPostCalibPinLow]) ? params[kTPCPostCalibValueLow] : ((pin < params[kTPCPostCalibPinHigh]) ? params[kTPCPostCalibInvN] / (params[kTPCPostCalibInvA] + params[kTPCPostCalibInvB] * pin) + params[kTPCPostCalibP0] + pin * (params[kTPCPostCalibP1] + pin * params[kTPCPostCalibP2]) : params[kTPCPostCalibValueHigh]);
+    float etaMap = 0.0;
+    if (std::abs(eta) < params[kTPCPostCalibEtaMax]) {
+      etaMap = params[kTPCPostCalibEta0] + eta * (params[kTPCPostCalibEta1] + eta * (params[kTPCPostCalibEta2] + eta * params[kTPCPostCalibEta3]));
+      if (params[kTPCPostCalibEtaCosAmp] != 0.0f) {
+        etaMap += params[kTPCPostCalibEtaCosAmp] * std::cos(params[kTPCPostCalibEtaCosFreq] * eta);
+      }
+    }
+    return pinMap + etaMap;
+  }
   template <typename T, typename U, typename V>
   static auto getRotatedCovMatrixXX(const T& matrix, U phi, V theta);
 
@@ -448,6 +616,27 @@ class VarManager : public TObject
   static o2::vertexing::FwdDCAFitterN<2> fgFitterTwoProngFwd;
   static o2::vertexing::FwdDCAFitterN<3> fgFitterThreeProngFwd;
 
+  // dilepton legs and two-prong fit of the last call of FillDileptonTrackVertexing
+  struct DileptonTrackVertexingCache {
+    int candidateType = -1;               // candidate type of the cached legs
+    int64_t leg1 = -1;                    // global index of the first lepton, -1 if the cache is empty
+    int64_t leg2 = -1;                    // global index of the second lepton
+    int procCodeJpsi = 0;                 // result of the two-prong fit of the legs
+    o2::track::TrackParCov barrelLegs[2]; // legs, for the barrel candidates
+    o2::track::TrackParCovFwd fwdLegs[2]; // legs, for the forward candidates
+  };
+  static bool fgUseDileptonTrackCache;
+  static DileptonTrackVertexingCache fgDileptonTrackCache;
+
+  // forward track parameters of the muons of the current event, by global index
+  static bool fgUseFwdTrackCache;
+  static std::unordered_map<int64_t, o2::track::TrackParCovFwd> fgFwdTrackCache;
+
+  template <typename T>
+  static o2::track::TrackParCovFwd getTrackParCovFwd(T const& muon);
+  template <typename T>
+  static o2::track::TrackParCovFwd const& getCachedTrackParCovFwd(T const& muon);
+
   VarManager& operator=(const VarManager& c);
   VarManager(const VarManager& c);
 
@@ -469,6 +658,28 @@ auto VarManager::getRotatedCovMatrixXX(const T& matrix, U phi, V theta)
          + matrix[5] * st * st;               // covZZ
 }
 
+template <typename T>
+o2::track::TrackParCovFwd VarManager::getTrackParCovFwd(T const& muon)
+{
+  double chi2 = muon.chi2();
+  SMatrix5 tpars(muon.x(), muon.y(), muon.phi(), muon.tgl(), muon.signed1Pt());
+  std::vector<double> v{muon.cXX(), muon.cXY(), muon.cYY(), muon.cPhiX(), muon.cPhiY(),
+                        muon.cPhiPhi(), muon.cTglX(), muon.cTglY(), muon.cTglPhi(), muon.cTglTgl(),
+                        muon.c1PtX(), muon.c1PtY(), muon.c1PtPhi(), muon.c1PtTgl(), muon.c1Pt21Pt2()};
+  SMatrix55 tcovs(v.begin(), v.end());
+  return o2::track::TrackParCovFwd{muon.z(), tpars, tcovs, chi2};
+}
+
+template <typename T>
+o2::track::TrackParCovFwd const& VarManager::getCachedTrackParCovFwd(T const& muon)
+{
+  auto it = fgFwdTrackCache.find(muon.globalIndex());
+  if (it == fgFwdTrackCache.end()) {
+    it = fgFwdTrackCache.emplace(muon.globalIndex(), getTrackParCovFwd(muon)).first;
+  }
+  return it->second;
+}
+
 template <uint32_t fillMap, typename T>
 void VarManager::FillEvent(T const& event, float* values)
 {
@@ -686,35 +897,37 @@ void VarManager::FillTrack(T const& track, float* values)
   // Quantities based on the barrel tables
   if constexpr ((fillMap & TrackExtra) > 0 || (fillMap & ReducedTrackBarrel) > 0) {
     values[kPin] = track.tpcInnerParam();
-    if (fgUsedVars[kIsITSrefit]) {
-      values[kIsITSrefit] = (track.flags() & o2::aod::track::ITSrefit) > 0; // NOTE: This is just for Run-2
-    }
-    if (fgUsedVars[kTrackTimeResIsRange]) {
-      values[kTrackTimeResIsRange] = (track.flags() & o2::aod::track::TrackTimeResIsRange) > 0; // NOTE: This is NOT for Run-2
-    }
-    if (fgUsedVars[kIsTPCrefit]) {
-      values[kIsTPCrefit] = (track.flags() & o2::aod::track::TPCrefit) > 0; // NOTE: This is just for Run-2
-    }
-    if (fgUsedVars[kPVContributor]) {
-      values[kPVContributor] = (track.flags() & o2::aod::track::PVContributor) > 0; // NOTE: This is NOT for Run-2
-    }
-    if (fgUsedVars[kIsGoldenChi2]) {
-      values[kIsGoldenChi2] = (track.flags() & o2::aod::track::GoldenChi2) > 0; // NOTE: This is just for Run-2
-    }
-    if (fgUsedVars[kOrphanTrack]) {
-      values[kOrphanTrack] = (track.flags() & o2::aod::track::OrphanTrack) > 0; // NOTE: This is NOT for Run-2
-    }
-    if (fgUsedVars[kIsSPDfirst]) {
-      values[kIsSPDfirst] = (track.itsClusterMap() & uint8_t(1)) > 0;
-    }
-    if (fgUsedVars[kIsSPDboth]) {
-      values[kIsSPDboth] = (track.itsClusterMap() & uint8_t(3)) > 0;
-    }
-    if (fgUsedVars[kIsSPDany]) {
-      values[kIsSPDany] = (track.itsClusterMap() & uint8_t(1)) || (track.itsClusterMap() & uint8_t(2));
-    }
-    if (fgUsedVars[kITSClusterMap]) {
-      values[kITSClusterMap] = track.itsClusterMap();
+    if (fgUsedVarGroups & kVarGroupBarrelFlags) {
+      if (fgUsedVars[kIsITSrefit]) {
+        values[kIsITSrefit] = (track.flags() & o2::aod::track::ITSrefit) > 0; // NOTE: This is just for Run-2
+      }
+      if (fgUsedVars[kTrackTimeResIsRange]) {
+        values[kTrackTimeResIsRange] = (track.flags() & o2::aod::track::TrackTimeResIsRange) > 0; // NOTE: This is NOT for Run-2
+      }
+      if (fgUsedVars[kIsTPCrefit]) {
+        values[kIsTPCrefit] = (track.flags() & o2::aod::track::TPCrefit) > 0; // NOTE: This is just for Run-2
+      }
+      if (fgUsedVars[kPVContributor]) {
+        values[kPVContributor] = (track.flags() & o2::aod::track::PVContributor) > 0; // NOTE: This is NOT for Run-2
+      }
+      if (fgUsedVars[kIsGoldenChi2]) {
+        values[kIsGoldenChi2] = (track.flags() & o2::aod::track::GoldenChi2) > 0; // NOTE: This is just for Run-2
+      }
+      if (fgUsedVars[kOrphanTrack]) {
+        values[kOrphanTrack] = (track.flags() & o2::aod::track::OrphanTrack) > 0; // NOTE: This is NOT for Run-2
+      }
+      if (fgUsedVars[kIsSPDfirst]) {
+        values[kIsSPDfirst] = (track.itsClusterMap() & uint8_t(1)) > 0;
+      }
+      if (fgUsedVars[kIsSPDboth]) {
+        values[kIsSPDboth] = (track.itsClusterMap() & uint8_t(3)) > 0;
+      }
+      if (fgUsedVars[kIsSPDany]) {
+        values[kIsSPDany] = (track.itsClusterMap() & uint8_t(1)) || (track.itsClusterMap() & uint8_t(2));
+      }
+      if (fgUsedVars[kITSClusterMap]) {
+        values[kITSClusterMap] = track.itsClusterMap();
+      }
     }
     values[kITSchi2] = track.itsChi2NCl();
     values[kTPCncls] = track.tpcNClsFound();
@@ -738,6 +951,30 @@ void VarManager::FillTrack(T const& track, float* values)
       values[kTrackDCAxy] = track.dcaXY();
       values[kTrackDCAz] = track.dcaZ();
       if constexpr ((fillMap & ReducedTrackBarrelCov) > 0) {
+        if (fgUsedVarGroups & kVarGroupDCAsigRes) {
+          if (fgUsedVars[kTrackDCAsigXY]) {
+            values[kTrackDCAsigXY] = track.dcaXY() / std::sqrt(track.cYY());
+          }
+          if (fgUsedVars[kTrackDCAsigZ]) {
+            values[kTrackDCAsigZ] = track.dcaZ() / std::sqrt(track.cZZ());
+          }
+          if (fgUsedVars[kTrackDCAresXY]) {
+            values[kTrackDCAresXY] = std::sqrt(track.cYY());
+          }
+          if (fgUsedVars[kTrackDCAresZ]) {
+            values[kTrackDCAresZ] = std::sqrt(track.cZZ());
+          }
+        }
+      }
+    }
+  }
+
+  // Quantities based on the barrel track selection table
+  if constexpr ((fillMap & TrackDCA) > 0) {
+    values[kTrackDCAxy] = track.dcaXY();
+    values[kTrackDCAz] = track.dcaZ();
+    if constexpr ((fillMap & TrackCov) > 0) {
+      if (fgUsedVarGroups & kVarGroupDCAsigRes) {
         if (fgUsedVars[kTrackDCAsigXY]) {
           values[kTrackDCAsigXY] = track.dcaXY() / std::sqrt(track.cYY());
         }
@@ -754,26 +991,6 @@ void VarManager::FillTrack(T const& track, float* values)
     }
   }
 
-  // Quantities based on the barrel track selection table
-  if constexpr ((fillMap & TrackDCA) > 0) {
-    values[kTrackDCAxy] = track.dcaXY();
-    values[kTrackDCAz] = track.dcaZ();
-    if constexpr ((fillMap & TrackCov) > 0) {
-      if (fgUsedVars[kTrackDCAsigXY]) {
-        values[kTrackDCAsigXY] = track.dcaXY() / std::sqrt(track.cYY());
-      }
-      if (fgUsedVars[kTrackDCAsigZ]) {
-        values[kTrackDCAsigZ] = track.dcaZ() / std::sqrt(track.cZZ());
-      }
-      if (fgUsedVars[kTrackDCAresXY]) {
-        values[kTrackDCAresXY] = std::sqrt(track.cYY());
-      }
-      if (fgUsedVars[kTrackDCAresZ]) {
-        values[kTrackDCAresZ] = std::sqrt(track.cZZ());
-      }
-    }
-  }
-
   // Quantities based on the barrel track selection table
   if constexpr ((fillMap & TrackSelection) > 0) {
     values[kIsGlobalTrack] = track.isGlobalTrack();
@@ -804,7 +1021,7 @@ void VarManager::FillTrack(T const& track, float* values)
     values[kTPCsignal] = track.tpcSignal();
     values[kTRDsignal] = track.trdSignal();
     values[kTOFbeta] = track.beta();
-    if (fgUsedVars[kTPCsignalRandomized] || fgUsedVars[kTPCnSigmaElRandomized] || fgUsedVars[kTPCnSigmaPiRandomized] || fgUsedVars[kTPCnSigmaPrRandomized]) {
+    if (fgUsedVarGroups & kVarGroupTPCRandomized) {
       // NOTE: this is needed temporarily for the study of the impact of TPC pid degradation on the quarkonium triggers in high lumi pp
       //     This study involves a degradation from a dE/dx resolution of 5% to one of 6% (20% worsening)
       //     For this we smear the dE/dx and n-sigmas using a gaus distribution with a width of 3.3%
@@ -819,10 +1036,21 @@ void VarManager::FillTrack(T const& track, float* values)
       values[kTPCnSigmaPrRandomized] = values[kTPCnSigmaPr] * (1.0 + randomX);
       values[kTPCnSigmaPrRandomizedDelta] = values[kTPCnSigmaPr] * randomX;
     }
-    if (fgUsedVars[kTPCnSigmaEl_Corr] || fgUsedVars[kTPCnSigmaPi_Corr] || fgUsedVars[kTPCnSigmaPr_Corr]) {
-      values[kTPCnSigmaEl_Corr] = values[kTPCnSigmaEl] - GetTPCPostCalibMap(values[kPin], values[kEta], 0, GetRunPeriod(values[kRunNo]));
-      values[kTPCnSigmaPi_Corr] = values[kTPCnSigmaPi] - GetTPCPostCalibMap(values[kPin], values[kEta], 1, GetRunPeriod(values[kRunNo]));
-      values[kTPCnSigmaPr_Corr] = values[kTPCnSigmaPr] - GetTPCPostCalibMap(values[kPin], values[kEta], 2, GetRunPeriod(values[kRunNo]));
+    if (fgUsedVarGroups & kVarGroupTPCPostCalib) {
+      int run = static_cast<int>(values[kRunNo]);
+      if (run != fgTPCPostCalibRun) {
+        SetupTPCPostCalib(run);
+      }
+      const float* maps = fgTPCPostCalibMaps.data();
+      if (fgUsedVars[kTPCnSigmaEl_Corr]) {
+        values[kTPCnSigmaEl_Corr] = values[kTPCnSigmaEl] - (fgTPCPostCalibActive ? GetTPCPostCalibMap(values[kPin], values[kEta], maps) : 0.0f);
+      }
+      if (fgUsedVars[kTPCnSigmaPi_Corr]) {
+        values[kTPCnSigmaPi_Corr] = values[kTPCnSigmaPi] - (fgTPCPostCalibActive ? GetTPCPostCalibMap(values[kPin], values[kEta], maps + kNTPCPostCalibParams) : 0.0f);
+      }
+      if (fgUsedVars[kTPCnSigmaPr_Corr]) {
+        values[kTPCnSigmaPr_Corr] = values[kTPCnSigmaPr] - (fgTPCPostCalibActive ? GetTPCPostCalibMap(values[kPin], values[kEta], maps + 2 * kNTPCPostCalibParams) : 0.0f);
+      }
     }
   }
 
@@ -1082,21 +1310,11 @@ void VarManager::FillPairVertexing(C const& collision, T const& t1, T const& t2,
     procCode = fgFitterTwoProngBarrel.process(pars1, pars2);
   } else if constexpr ((pairType == kDecayToMuMu) && muonHasCov) {
     // Initialize track parameters for forward
-    double chi21 = t1.chi2();
-    double chi22 = t2.chi2();
-    SMatrix5 t1pars(t1.x(), t1.y(), t1.phi(), t1.tgl(), t1.signed1Pt());
-    std::vector<double> v1{t1.cXX(), t1.cXY(), t1.cYY(), t1.cPhiX(), t1.cPhiY(),
-                           t1.cPhiPhi(), t1.cTglX(), t1.cTglY(), t1.cTglPhi(), t1.cTglTgl(),
-                           t1.c1PtX(), t1.c1PtY(), t1.c1PtPhi(), t1.c1PtTgl(), t1.c1Pt21Pt2()};
-    SMatrix55 t1covs(v1.begin(), v1.end());
-    o2::track::TrackParCovFwd pars1{t1.z(), t1pars, t1covs, chi21};
-    SMatrix5 t2pars(t2.x(), t2.y(), t2.phi(), t2.tgl(), t2.signed1Pt());
-    std::vector<double> v2{t2.cXX(), t2.cXY(), t2.cYY(), t2.cPhiX(), t2.cPhiY(),
-                           t2.cPhiPhi(), t2.cTglX(), t2.cTglY(), t2.cTglPhi(), t2.cTglTgl(),
-                           t2.c1PtX(), t2.c1PtY(), t2.c1PtPhi(), t2.c1PtTgl(), t2.c1Pt21Pt2()};
-    SMatrix55 t2covs(v2.begin(), v2.end());
-    o2::track::TrackParCovFwd pars2{t2.z(), t2pars, t2covs, chi22};
-    procCode = fgFitterTwoProngFwd.process(pars1, pars2);
+    if (fgUseFwdTrackCache) {
+      procCode = fgFitterTwoProngFwd.process(getCachedTrackParCovFwd(t1), getCachedTrackParCovFwd(t2));
+    } else {
+      procCode = fgFitterTwoProngFwd.process(getTrackParCovFwd(t1), getTrackParCovFwd(t2));
+    }
   } else {
     return;
   }
@@ -1224,51 +1442,78 @@ void VarManager::FillDileptonTrackVertexing(C const& collision, T1 const& lepton
     mlepton = fgkMuonMass;
     mtrack = fgkMuonMass;
 
-    double chi21 = lepton1.chi2();
-    double chi22 = lepton2.chi2();
-    double chi23 = track.chi2();
-    SMatrix5 t1pars(lepton1.x(), lepton1.y(), lepton1.phi(), lepton1.tgl(), lepton1.signed1Pt());
-    std::vector<double> v1{lepton1.cXX(), lepton1.cXY(), lepton1.cYY(), lepton1.cPhiX(), lepton1.cPhiY(),
-                           lepton1.cPhiPhi(), lepton1.cTglX(), lepton1.cTglY(), lepton1.cTglPhi(), lepton1.cTglTgl(),
-                           lepton1.c1PtX(), lepton1.c1PtY(), lepton1.c1PtPhi(), lepton1.c1PtTgl(), lepton1.c1Pt21Pt2()};
-    SMatrix55 t1covs(v1.begin(), v1.end());
-    o2::track::TrackParCovFwd pars1{lepton1.z(), t1pars, t1covs, chi21};
-
-    SMatrix5 t2pars(lepton2.x(), lepton2.y(), lepton2.phi(), lepton2.tgl(), lepton2.signed1Pt());
-    std::vector<double> v2{lepton2.cXX(), lepton2.cXY(), lepton2.cYY(), lepton2.cPhiX(), lepton2.cPhiY(),
-                           lepton2.cPhiPhi(), lepton2.cTglX(), lepton2.cTglY(), lepton2.cTglPhi(), lepton2.cTglTgl(),
-                           lepton2.c1PtX(), lepton2.c1PtY(), lepton2.c1PtPhi(), lepton2.c1PtTgl(), lepton2.c1Pt21Pt2()};
-    SMatrix55 t2covs(v2.begin(), v2.end());
-    o2::track::TrackParCovFwd pars2{lepton2.z(), t2pars, t2covs, chi22};
+    auto& cache = fgDileptonTrackCache;
+    const bool isCached = fgUseDileptonTrackCache && cache.candidateType == candidateType && cache.leg1 == lepton1.globalIndex() && cache.leg2 == lepton2.globalIndex();
+    if (!isCached) {
+      double chi21 = lepton1.chi2();
+      double chi22 = lepton2.chi2();
+      SMatrix5 t1pars(lepton1.x(), lepton1.y(), lepton1.phi(), lepton1.tgl(), lepton1.signed1Pt());
+      std::vector<double> v1{lepton1.cXX(), lepton1.cXY(), lepton1.cYY(), lepton1.cPhiX(), lepton1.cPhiY(),
+                             lepton1.cPhiPhi(), lepton1.cTglX(), lepton1.cTglY(), lepton1.cTglPhi(), lepton1.cTglTgl(),
+                             lepton1.c1PtX(), lepton1.c1PtY(), lepton1.c1PtPhi(), lepton1.c1PtTgl(), lepton1.c1Pt21Pt2()};
+      SMatrix55 t1covs(v1.begin(), v1.end());
+      o2::track::TrackParCovFwd pars1{lepton1.z(), t1pars, t1covs, chi21};
+
+      SMatrix5 t2pars(lepton2.x(), lepton2.y(), lepton2.phi(), lepton2.tgl(), lepton2.signed1Pt());
+      std::vector<double> v2{lepton2.cXX(), lepton2.cXY(), lepton2.cYY(), lepton2.cPhiX(), lepton2.cPhiY(),
+                             lepton2.cPhiPhi(), lepton2.cTglX(), lepton2.cTglY(), lepton2.cTglPhi(), lepton2.cTglTgl(),
+                             lepton2.c1PtX(), lepton2.c1PtY(), lepton2.c1PtPhi(), lepton2.c1PtTgl(), lepton2.c1Pt21Pt2()};
+      SMatrix55 t2covs(v2.begin(), v2.end());
+      o2::track::TrackParCovFwd pars2{lepton2.z(), t2pars, t2covs, chi22};
+      cache.fwdLegs[0] = pars1;
+      cache.fwdLegs[1] = pars2;
+      cache.procCodeJpsi = fgFitterTwoProngFwd.process(pars1, pars2);
+      cache.candidateType = candidateType;
+      cache.leg1 = lepton1.globalIndex();
+      cache.leg2 = lepton2.globalIndex();
+    }
+    procCodeJpsi = cache.procCodeJpsi;
 
+    double chi23 = track.chi2();
     SMatrix5 t3pars(track.x(), track.y(), track.phi(), track.tgl(), track.signed1Pt());
     std::vector<double> v3{track.cXX(), track.cXY(), track.cYY(), track.cPhiX(), track.cPhiY(),
                            track.cPhiPhi(), track.cTglX(), track.cTglY(), track.cTglPhi(), track.cTglTgl(),
                            track.c1PtX(), track.c1PtY(), track.c1PtPhi(), track.c1PtTgl(), track.c1Pt21Pt2()};
     SMatrix55 t3covs(v3.begin(), v3.end());
     o2::track::TrackParCovFwd pars3{track.z(), t3pars, t3covs, chi23};
-    procCode = VarManager::fgFitterThreeProngFwd.process(pars1, pars2, pars3);
-    procCodeJpsi = VarManager::fgFitterTwoProngFwd.process(pars1, pars2);
+    // with the cache, the three-prong fit is skipped for the dileptons without a vertex, since the candidate is rejected anyway
+    if (!fgUseDileptonTrackCache || procCodeJpsi != 0) {
+      procCode = VarManager::fgFitterThreeProngFwd.process(cache.fwdLegs[0], cache.fwdLegs[1], pars3);
+    }
   } else if constexpr ((candidateType == kBtoJpsiEEK) && trackHasCov) {
     mlepton = fgkElectronMass;
     mtrack = fgkKaonMass;
-    std::array<float, 5> lepton1pars = {lepton1.y(), lepton1.z(), lepton1.snp(), lepton1.tgl(), lepton1.signed1Pt()};
-    std::array<float, 15> lepton1covs = {lepton1.cYY(), lepton1.cZY(), lepton1.cZZ(), lepton1.cSnpY(), lepton1.cSnpZ(),
-                                         lepton1.cSnpSnp(), lepton1.cTglY(), lepton1.cTglZ(), lepton1.cTglSnp(), lepton1.cTglTgl(),
-                                         lepton1.c1PtY(), lepton1.c1PtZ(), lepton1.c1PtSnp(), lepton1.c1PtTgl(), lepton1.c1Pt21Pt2()};
-    o2::track::TrackParCov pars1{lepton1.x(), lepton1.alpha(), lepton1pars, lepton1covs};
-    std::array<float, 5> lepton2pars = {lepton2.y(), lepton2.z(), lepton2.snp(), lepton2.tgl(), lepton2.signed1Pt()};
-    std::array<float, 15> lepton2covs = {lepton2.cYY(), lepton2.cZY(), lepton2.cZZ(), lepton2.cSnpY(), lepton2.cSnpZ(),
-                                         lepton2.cSnpSnp(), lepton2.cTglY(), lepton2.cTglZ(), lepton2.cTglSnp(), lepton2.cTglTgl(),
-                                         lepton2.c1PtY(), lepton2.c1PtZ(), lepton2.c1PtSnp(), lepton2.c1PtTgl(), lepton2.c1Pt21Pt2()};
-    o2::track::TrackParCov pars2{lepton2.x(), lepton2.alpha(), lepton2pars, lepton2covs};
+    auto& cache = fgDileptonTrackCache;
+    const bool isCached = fgUseDileptonTrackCache && cache.candidateType == candidateType && cache.leg1 == lepton1.globalIndex() && cache.leg2 == lepton2.globalIndex();
+    if (!isCached) {
+      std::array<float, 5> lepton1pars = {lepton1.y(), lepton1.z(), lepton1.snp(), lepton1.tgl(), lepton1.signed1Pt()};
+      std::array<float, 15> lepton1covs = {lepton1.cYY(), lepton1.cZY(), lepton1.cZZ(), lepton1.cSnpY(), lepton1.cSnpZ(),
+                                           lepton1.cSnpSnp(), lepton1.cTglY(), lepton1.cTglZ(), lepton1.cTglSnp(), lepton1.cTglTgl(),
+                                           lepton1.c1PtY(), lepton1.c1PtZ(), lepton1.c1PtSnp(), lepton1.c1PtTgl(), lepton1.c1Pt21Pt2()};
+      o2::track::TrackParCov pars1{lepton1.x(), lepton1.alpha(), lepton1pars, lepton1covs};
+      std::array<float, 5> lepton2pars = {lepton2.y(), lepton2.z(), lepton2.snp(), lepton2.tgl(), lepton2.signed1Pt()};
+      std::array<float, 15> lepton2covs = {lepton2.cYY(), lepton2.cZY(), lepton2.cZZ(), lepton2.cSnpY(), lepton2.cSnpZ(),
+                                           lepton2.cSnpSnp(), lepton2.cTglY(), lepton2.cTglZ(), lepton2.cTglSnp(), lepton2.cTglTgl(),
+                                           lepton2.c1PtY(), lepton2.c1PtZ(), lepton2.c1PtSnp(), lepton2.c1PtTgl(), lepton2.c1Pt21Pt2()};
+      o2::track::TrackParCov pars2{lepton2.x(), lepton2.alpha(), lepton2pars, lepton2covs};
+      cache.barrelLegs[0] = pars1;
+      cache.barrelLegs[1] = pars2;
+      cache.procCodeJpsi = fgFitterTwoProngBarrel.process(pars1, pars2);
+      cache.candidateType = candidateType;
+      cache.leg1 = lepton1.globalIndex();
+      cache.leg2 = lepton2.globalIndex();
+    }
+    procCodeJpsi = cache.procCodeJpsi;
+
     std::array<float, 5> lepton3pars = {track.y(), track.z(), track.snp(), track.tgl(), track.signed1Pt()};
     std::array<float, 15> lepton3covs = {track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
                                          track.cSnpSnp(), track.cTglY(), track.cTglZ(), track.cTglSnp(), track.cTglTgl(),
                                          track.c1PtY(), track.c1PtZ(), track.c1PtSnp(), track.c1PtTgl(), track.c1Pt21Pt2()};
     o2::track::TrackParCov pars3{track.x(), track.alpha(), lepton3pars, lepton3covs};
-    procCode = VarManager::fgFitterThreeProngBarrel.process(pars1, pars2, pars3);
-    procCodeJpsi = VarManager::fgFitterTwoProngBarrel.process(pars1, pars2);
+    // with the cache, the three-prong fit is skipped for the dileptons without a vertex, since the candidate is rejected anyway
+    if (!fgUseDileptonTrackCache || procCodeJpsi != 0) {
+      procCode = VarManager::fgFitterThreeProngBarrel.process(cache.barrelLegs[0], cache.barrelLegs[1], pars3);
+    }
   } else {
     return;
   }
@@ -79,6 +79,19 @@ DECLARE_SOA_TABLE(ReducedEventsQvector, "AOD", "REQVECTOR", //!    Event Q-vecto
                   reducedevent::Q3X0A, reducedevent::Q3Y0A, reducedevent::Q3X0B, reducedevent::Q3Y0B,
                   reducedevent::Q3X0C, reducedevent::Q3Y0C);
 
+namespace reducedeventqvectorcut
+{
+DECLARE_SOA_INDEX_COLUMN(Collision, collision); //!
+DECLARE_SOA_COLUMN(CutIndex, cutIndex, uint8_t); //!  Index of the barrel track cut in the list of cuts of the Q-vector task
+} // namespace reducedeventqvectorcut
+
+DECLARE_SOA_TABLE(ReducedEventsQvectorCuts, "AOD", "REQVECTORCUT", //!    Event Q-vector information, one row per barrel track cut
+                  reducedeventqvectorcut::CollisionId, reducedeventqvectorcut::CutIndex,
+                  reducedevent::Q2X0A, reducedevent::Q2Y0A, reducedevent::Q2X0B, reducedevent::Q2Y0B,
+                  reducedevent::Q2X0C, reducedevent::Q2Y0C, reducedevent::MultA, reducedevent::MultB, reducedevent::MultC,
+                  reducedevent::Q3X0A, reducedevent::Q3Y0A, reducedevent::Q3X0B, reducedevent::Q3Y0B,
+                  reducedevent::Q3X0C, reducedevent::Q3Y0C);
+
 // TODO and NOTE: This table is just an extension of the ReducedEvents table
 //       There is no explicit accounting for MC events which were not reconstructed!!!
 //       However, for analysis which will require these events, a special skimming process function
@@ -92,6 +105,7 @@ using ReducedEvent = ReducedEvents::iterator;
 using ReducedEventExtended = ReducedEventsExtended::iterator;
 using ReducedEventVtxCov = ReducedEventsVtxCov::iterator;
 using ReducedEventQvector = ReducedEventsQvector::iterator;
+using ReducedEventQvectorCut = ReducedEventsQvectorCuts::iterator;
 using ReducedMCEvent = ReducedMCEvents::iterator;
 
 namespace reducedeventlabel
@@ -165,10 +179,80 @@ DECLARE_SOA_TABLE(ReducedTracksBarrelPID, "AOD", "RTBARRELPID", //!
                   pidtof::TOFNSigmaPi, pidtof::TOFNSigmaKa, pidtof::TOFNSigmaPr,
                   track::TRDSignal);
 
+namespace reducedtrackpidtiny
+{
+// same 8 bit binning as the pidtof_tiny tables, n-sigmas beyond the range end up in the under- and overflow bins
+struct binning {
+ public:
+  typedef int8_t binned_t;
+  static constexpr int nbins = (1 << 8 * sizeof(binned_t)) - 2;
+  static constexpr binned_t overflowBin = nbins >> 1;
+  static constexpr binned_t underflowBin = -(nbins >> 1);
+  static constexpr float binned_max = 6.35;
+  static constexpr float binned_min = -6.35;
+  static constexpr float bin_width = (binned_max - binned_min) / nbins;
+};
+
+//! Bins an n-sigma value for the tiny PID table
+inline binning::binned_t binNSigma(float nSigma)
+{
+  if (nSigma <= binning::binned_min) {
+    return binning::underflowBin;
+  }
+  if (nSigma >= binning::binned_max) {
+    return binning::overflowBin;
+  }
+  return static_cast<binning::binned_t>(std::lround(nSigma / binning::bin_width));
+}
+
+DECLARE_SOA_COLUMN(TPCNSigmaStoreEl, tpcNSigmaStoreEl, binning::binned_t); //! Stored binned nsigma with the TPC detector for electron
+DECLARE_SOA_COLUMN(TPCNSigmaStoreMu, tpcNSigmaStoreMu, binning::binned_t); //! Stored binned nsigma with the TPC detector for muon
+DECLARE_SOA_COLUMN(TPCNSigmaStorePi, tpcNSigmaStorePi, binning::binned_t); //! Stored binned nsigma with the TPC detector for pion
+DECLARE_SOA_COLUMN(TPCNSigmaStoreKa, tpcNSigmaStoreKa, binning::binned_t); //! Stored binned nsigma with the TPC detector for kaon
+DECLARE_SOA_COLUMN(TPCNSigmaStorePr, tpcNSigmaStorePr, binning::binned_t); //! Stored binned nsigma with the TPC detector for proton
+DECLARE_SOA_COLUMN(TOFNSigmaStoreEl, tofNSigmaStoreEl, binning::binned_t); //! Stored binned nsigma with the TOF detector for electron
+DECLARE_SOA_COLUMN(TOFNSigmaStoreMu, tofNSigmaStoreMu, binning::binned_t); //! Stored binned nsigma with the TOF detector for muon
+DECLARE_SOA_COLUMN(TOFNSigmaStorePi, tofNSigmaStorePi, binning::binned_t); //! Stored binned nsigma with the TOF detector for pion
+DECLARE_SOA_COLUMN(TOFNSigmaStoreKa, tofNSigmaStoreKa, binning::binned_t); //! Stored binned nsigma with the TOF detector for kaon
+DECLARE_SOA_COLUMN(TOFNSigmaStorePr, tofNSigmaStorePr, binning::binned_t); //! Stored binned nsigma with the TOF detector for proton
+// the unwrapped columns have the getter names of the full PID tables, so the VarManager fills them in the same way
+DEFINE_UNWRAP_NSIGMA_COLUMN(TPCNSigmaEl, tpcNSigmaEl); //! Unwrapped (float) nsigma with the TPC detector for electron
+DEFINE_UNWRAP_NSIGMA_COLUMN(TPCNSigmaMu, tpcNSigmaMu); //! Unwrapped (float) nsigma with the TPC detector for muon
+DEFINE_UNWRAP_NSIGMA_COLUMN(TPCNSigmaPi, tpcNSigmaPi); //! Unwrapped (float) nsigma with the TPC detector for pion
+DEFINE_UNWRAP_NSIGMA_COLUMN(TPCNSigmaKa, tpcNSigmaKa); //! Unwrapped (float) nsigma with the TPC detector for kaon
+DEFINE_UNWRAP_NSIGMA_COLUMN(TPCNSigmaPr, tpcNSigmaPr); //! Unwrapped (float) nsigma with the TPC detector for proton
+DEFINE_UNWRAP_NSIGMA_COLUMN(TOFNSigmaEl, tofNSigmaEl); //! Unwrapped (float) nsigma with the TOF detector for electron
+DEFINE_UNWRAP_NSIGMA_COLUMN(TOFNSigmaMu, tofNSigmaMu); //! Unwrapped (float) nsigma with the TOF detector for muon
+DEFINE_UNWRAP_NSIGMA_COLUMN(TOFNSigmaPi, tofNSigmaPi); //! Unwrapped (float) nsigma with the TOF detector for pion
+DEFINE_UNWRAP_NSIGMA_COLUMN(TOFNSigmaKa, tofNSigmaKa); //! Unwrapped (float) nsigma with the TOF detector for kaon
+DEFINE_UNWRAP_NSIGMA_COLUMN(TOFNSigmaPr, tofNSigmaPr); //! Unwrapped (float) nsigma with the TOF detector for proton
+} // namespace reducedtrackpidtiny
+
+// barrel PID information with the n-sigmas binned in 8 bits, to be joined instead of ReducedTracksBarrelPID
+DECLARE_SOA_TABLE(ReducedTracksBarrelPIDTiny, "AOD", "RTBARRELPIDT", //!
+                  track::TPCSignal,
+                  reducedtrackpidtiny::TPCNSigmaStoreEl, reducedtrackpidtiny::TPCNSigmaStoreMu,
+                  reducedtrackpidtiny::TPCNSigmaStorePi, reducedtrackpidtiny::TPCNSigmaStoreKa, reducedtrackpidtiny::TPCNSigmaStorePr,
+                  pidtofbeta::Beta,
+                  reducedtrackpidtiny::TOFNSigmaStoreEl, reducedtrackpidtiny::TOFNSigmaStoreMu,
+                  reducedtrackpidtiny::TOFNSigmaStorePi, reducedtrackpidtiny::TOFNSigmaStoreKa, reducedtrackpidtiny::TOFNSigmaStorePr,
+                  track::TRDSignal,
+                  reducedtrackpidtiny::TPCNSigmaEl<reducedtrackpidtiny::TPCNSigmaStoreEl>,
+                  reducedtrackpidtiny::TPCNSigmaMu<reducedtrackpidtiny::TPCNSigmaStoreMu>,
+                  reducedtrackpidtiny::TPCNSigmaPi<reducedtrackpidtiny::TPCNSigmaStorePi>,
+                  reducedtrackpidtiny::TPCNSigmaKa<reducedtrackpidtiny::TPCNSigmaStoreKa>,
+                  reducedtrackpidtiny::TPCNSigmaPr<reducedtrackpidtiny::TPCNSigmaStorePr>,
+                  reducedtrackpidtiny::TOFNSigmaEl<reducedtrackpidtiny::TOFNSigmaStoreEl>,
+                  reducedtrackpidtiny::TOFNSigmaMu<reducedtrackpidtiny::TOFNSigmaStoreMu>,
+                  reducedtrackpidtiny::TOFNSigmaPi<reducedtrackpidtiny::TOFNSigmaStorePi>,
+                  reducedtrackpidtiny::TOFNSigmaKa<reducedtrackpidtiny::TOFNSigmaStoreKa>,
+                  reducedtrackpidtiny::TOFNSigmaPr<reducedtrackpidtiny::TOFNSigmaStorePr>);
+
 using ReducedTrack = ReducedTracks::iterator;
 using ReducedTrackBarrel = ReducedTracksBarrel::iterator;
 using ReducedTrackBarrelCov = ReducedTracksBarrelCov::iterator;
 using ReducedTrackBarrelPID = ReducedTracksBarrelPID::iterator;
+using ReducedTrackBarrelPIDTiny = ReducedTracksBarrelPIDTiny::iterator;
 
 namespace reducedtrackMC
 {
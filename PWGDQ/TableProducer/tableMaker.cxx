@@ -26,6 +26,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Centrality.h"
 #include "Common/CCDB/TriggerAliases.h"
+#include "CCDB/BasicCCDBManager.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "PWGDQ/DataModel/ReducedInfoTables.h"
@@ -33,6 +34,7 @@
 #include "PWGDQ/Core/HistogramManager.h"
 #include "PWGDQ/Core/AnalysisCut.h"
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/CompiledCuts.h"
 #include "PWGDQ/Core/HistogramsLibrary.h"
 #include "PWGDQ/Core/CutsLibrary.h"
 
@@ -93,6 +95,7 @@ struct TableMaker {
   Produces<ReducedTracksBarrel> trackBarrel;
   Produces<ReducedTracksBarrelCov> trackBarrelCov;
   Produces<ReducedTracksBarrelPID> trackBarrelPID;
+  Produces<ReducedTracksBarrelPIDTiny> trackBarrelPIDTiny;
   Produces<ReducedMuons> muonBasic;
   Produces<ReducedMuonsExtra> muonExtra;
   Produces<ReducedMuonsCov> muonCov;
@@ -115,10 +118,18 @@ struct TableMaker {
   Configurable<bool> fConfigDetailedQA{"cfgDetailedQA", false, "If true, include more QA histograms (BeforeCuts classes)"};
   Configurable<bool> fIsRun2{"cfgIsRun2", false, "Whether we analyze Run-2 or Run-3 data"};
   Configurable<bool> fIsAmbiguous{"cfgIsAmbiguous", false, "Whether we enable QA plots for ambiguous tracks"};
+  Configurable<bool> fConfigTinyPID{"cfgTinyPID", false, "If true, fill also the barrel PID table with the n-sigmas binned in 8 bits (RTBARRELPIDT)"};
+  Configurable<std::string> fConfigCcdbUrl{"ccdb-url", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
+  Configurable<std::string> fConfigTPCPostCalibPath{"cfgTPCPostCalibPath", "", "CCDB path of the TPC post-calibration maps (std::vector<float>, see VarManager::TPCPostCalibParams), empty to use the built-in maps"};
+
+  Service<o2::ccdb::BasicCCDBManager> fCCDB;
+  int fCurrentRun = -1; // run of the TPC post-calibration maps loaded from CCDB
 
   AnalysisCompositeCut* fEventCut;              //! Event selection cut
   std::vector<AnalysisCompositeCut> fTrackCuts; //! Barrel track cuts
   std::vector<AnalysisCompositeCut> fMuonCuts;  //! Muon track cuts
+  CompiledCuts fTrackCutsCompiled;              //! Barrel track cuts, evaluated at once
+  CompiledCuts fMuonCutsCompiled;               //! Muon track cuts, evaluated at once
 
   bool fDoDetailedQA = false; // Bool to set detailed QA true, if QA is set true
 
@@ -131,6 +142,12 @@ struct TableMaker {
   {
     DefineCuts();
 
+    if (!fConfigTPCPostCalibPath.value.empty()) {
+      fCCDB->setURL(fConfigCcdbUrl.value);
+      fCCDB->setCaching(true);
+      fCCDB->setLocalObjectValidityChecking();
+    }
+
     VarManager::SetDefaultVarNames();
     fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
     fHistMan->SetUseDefaultVariableNames(kTRUE);
@@ -222,6 +239,13 @@ struct TableMaker {
       }
     }
 
+    for (auto& cut : fTrackCuts) {
+      fTrackCutsCompiled.AddCut(&cut);
+    }
+    for (auto& cut : fMuonCuts) {
+      fMuonCutsCompiled.AddCut(&cut);
+    }
+
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
   }
 
@@ -229,6 +253,18 @@ struct TableMaker {
   template <uint32_t TEventFillMap, uint32_t TTrackFillMap, uint32_t TMuonFillMap, typename TEvent, typename TTracks, typename TMuons, typename TAmbiTracks, typename TAmbiMuons>
   void fullSkimming(TEvent const& collision, aod::BCs const& bcs, TTracks const& tracksBarrel, TMuons const& tracksMuon, TAmbiTracks const& ambiTracksMid, TAmbiMuons const& ambiTracksFwd)
   {
+    // load the TPC post-calibration maps of a new run, VarManager resolves them once for the tracks of the run
+    if (!fConfigTPCPostCalibPath.value.empty() && collision.bc().runNumber() != fCurrentRun) {
+      fCurrentRun = collision.bc().runNumber();
+      auto runDuration = o2::ccdb::BasicCCDBManager::getRunDuration(fCurrentRun);
+      auto maps = fCCDB->getForTimeStamp<std::vector<float>>(fConfigTPCPostCalibPath.value, runDuration.first);
+      if (maps != nullptr) {
+        VarManager::SetTPCPostCalibParams(fCurrentRun, *maps);
+      } else {
+        LOGF(info, "No TPC post-calibration maps in %s for run %d, using the built-in ones", fConfigTPCPostCalibPath.value.data(), fCurrentRun);
+      }
+    }
+
     // get the trigger aliases
     uint32_t triggerAliases = 0;
     for (int i = 0; i < kNaliases; i++) {
@@ -291,6 +327,9 @@ struct TableMaker {
         trackBarrelCov.reserve(tracksBarrel.size());
       }
       trackBarrelPID.reserve(tracksBarrel.size());
+      if (fConfigTinyPID) {
+        trackBarrelPIDTiny.reserve(tracksBarrel.size());
+      }
 
       // loop over tracks
       for (auto& track : tracksBarrel) {
@@ -317,9 +356,10 @@ struct TableMaker {
           }
         }
         // apply track cuts and fill stats histogram
+        uint64_t trackCutDecisions = fTrackCutsCompiled.Evaluate(VarManager::fgValues);
         int i = 0;
         for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); cut++, i++) {
-          if ((*cut).IsSelected(VarManager::fgValues)) {
+          if (trackCutDecisions & (uint64_t(1) << i)) {
             trackTempFilterMap |= (uint8_t(1) << i);
             if (fConfigQA) {
               fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut).GetName()), VarManager::fgValues);
@@ -371,6 +411,15 @@ struct TableMaker {
                        track.tofNSigmaEl(), track.tofNSigmaMu(),
                        track.tofNSigmaPi(), track.tofNSigmaKa(), track.tofNSigmaPr(),
                        track.trdSignal());
+        if (fConfigTinyPID) {
+          trackBarrelPIDTiny(track.tpcSignal(),
+                             reducedtrackpidtiny::binNSigma(track.tpcNSigmaEl()), reducedtrackpidtiny::binNSigma(track.tpcNSigmaMu()),
+                             reducedtrackpidtiny::binNSigma(track.tpcNSigmaPi()), reducedtrackpidtiny::binNSigma(track.tpcNSigmaKa()), reducedtrackpidtiny::binNSigma(track.tpcNSigmaPr()),
+                             track.beta(),
+                             reducedtrackpidtiny::binNSigma(track.tofNSigmaEl()), reducedtrackpidtiny::binNSigma(track.tofNSigmaMu()),
+                             reducedtrackpidtiny::binNSigma(track.tofNSigmaPi()), reducedtrackpidtiny::binNSigma(track.tofNSigmaKa()), reducedtrackpidtiny::binNSigma(track.tofNSigmaPr()),
+                             track.trdSignal());
+        }
       }
     } // end if constexpr (TTrackFillMap)
 
@@ -399,11 +448,7 @@ struct TableMaker {
         idxPrev = muon.index();
 
         // check the cuts and filters
-        int i = 0;
-        for (auto cut = fMuonCuts.begin(); cut != fMuonCuts.end(); cut++, i++) {
-          if ((*cut).IsSelected(VarManager::fgValues))
-            trackTempFilterMap |= (uint8_t(1) << i);
-        }
+        trackTempFilterMap |= uint8_t(fMuonCutsCompiled.Evaluate(VarManager::fgValues));
 
         if (!trackTempFilterMap) { // does not pass the cuts
           nDel++;
@@ -438,9 +483,10 @@ struct TableMaker {
           }
         }
         // apply the muon selection cuts and fill the stats histogram
+        uint64_t muonCutDecisions = fMuonCutsCompiled.Evaluate(VarManager::fgValues);
         int i = 0;
         for (auto cut = fMuonCuts.begin(); cut != fMuonCuts.end(); cut++, i++) {
-          if ((*cut).IsSelected(VarManager::fgValues)) {
+          if (muonCutDecisions & (uint64_t(1) << i)) {
             trackTempFilterMap |= (uint8_t(1) << i);
             if (fConfigQA) {
               fHistMan->FillHistClass(Form("Muons_%s", (*cut).GetName()), VarManager::fgValues);
@@ -115,6 +115,7 @@ struct TableMakerMC {
   Configurable<bool> fIsRun2{"cfgIsRun2", false, "Whether we analyze Run-2 or Run-3 data"};
   Configurable<bool> fConfigQA{"cfgQA", false, "If true, fill QA histograms"};
   Configurable<bool> fConfigDetailedQA{"cfgDetailedQA", false, "If true, include more QA histograms (BeforeCuts classes)"};
+  Configurable<int> fConfigMCMotherGenerations{"cfgMCMotherGenerations", 0, "Number of generations of mothers of the selected MC particles also written in the skimmed MC stack"};
 
   AnalysisCompositeCut* fEventCut;              //! Event selection cut
   std::vector<AnalysisCompositeCut> fTrackCuts; //! Barrel track cuts
@@ -249,17 +250,34 @@ struct TableMakerMC {
     // 2.1) MC collision labels
     // 3) all selected tracks
     // 4) MC track labels
-    //   Maps of indices are stored for all selected MC tracks (selected MC signals + MC truth particles for selected tracks)
-    //   The MC particles table is generated in a separate loop over McParticles, after the indices for all MC particles we want
-    //     to store are fed into the ordered std maps
+    //   All selected MC tracks (selected MC signals + MC truth particles for selected tracks) are flagged in arrays indexed
+    //     by the global index of the MC particle. The indices in the skimmed MC stack are given by the prefix sum of the flags,
+    //     after the loop over collisions, and the skimmed MC stack and the MC labels of the tracks are then written in one go
 
     // temporary variables used for the indexing of the skimmed MC stack
-    std::map<uint64_t, int> fNewLabels;
-    std::map<uint64_t, int> fNewLabelsReversed;
-    std::map<uint64_t, uint16_t> fMCFlags;
-    std::map<uint64_t, int> fEventIdx;
-    std::map<uint64_t, int> fEventLabels;
-    int fCounters[2] = {0, 0}; //! [0] - particle counter, [1] - event counter
+    std::vector<bool> fKeepMC(mcTracks.size(), false);  // whether the MC particle is written in the skimmed MC stack
+    std::vector<uint16_t> fMCFlags(mcTracks.size(), 0); // MC signal decisions of the written MC particles
+    std::vector<int> fEventIdx(mcTracks.size(), -1);    // index of the skimmed MC event of the written MC particles
+    std::vector<int> fEventLabels(mcEvents.size(), -1); // index of the MC events in the skimmed MC events table
+    int fEventCounter = 0;
+    // MC labels of the written barrel tracks and muons, with the MC particle given by its original global index
+    struct MCLabel {
+      int64_t fMCParticle;
+      uint16_t fMCMask;
+      uint16_t fMCFlags;
+    };
+    std::vector<MCLabel> fTrackLabels;
+    std::vector<MCLabel> fMuonLabels;
+    // flags an MC particle to be written, with the MC signal decisions of its first selection
+    auto keepMCParticle = [&](int64_t mcIdx, uint16_t flags, int eventIdx) {
+      if (fKeepMC[mcIdx]) {
+        return false;
+      }
+      fKeepMC[mcIdx] = true;
+      fMCFlags[mcIdx] = flags;
+      fEventIdx[mcIdx] = eventIdx;
+      return true;
+    };
 
     uint16_t mcflags = 0;
     uint64_t trackFilteringTag = 0;
@@ -323,13 +341,14 @@ struct TableMakerMC {
       eventExtended(collision.bc().globalBC(), collision.bc().triggerMask(), 0, triggerAliases, VarManager::fgValues[VarManager::kCentVZERO]);
       eventVtxCov(collision.covXX(), collision.covXY(), collision.covXZ(), collision.covYY(), collision.covYZ(), collision.covZZ(), collision.chi2());
       // make an entry for this MC event only if it was not already added to the table
-      if (!(fEventLabels.find(mcCollision.globalIndex()) != fEventLabels.end())) {
+      if (fEventLabels[mcCollision.globalIndex()] < 0) {
         eventMC(mcCollision.generatorsID(), mcCollision.posX(), mcCollision.posY(), mcCollision.posZ(),
                 mcCollision.t(), mcCollision.weight(), mcCollision.impactParameter());
-        fEventLabels[mcCollision.globalIndex()] = fCounters[1];
-        fCounters[1]++;
+        fEventLabels[mcCollision.globalIndex()] = fEventCounter;
+        fEventCounter++;
       }
-      eventMClabels(fEventLabels.find(mcCollision.globalIndex())->second, collision.mcMask());
+      int mcEventIdx = fEventLabels[mcCollision.globalIndex()];
+      eventMClabels(mcEventIdx, collision.mcMask());
 
       // loop over the MC truth tracks and find those that need to be written
       auto groupedMcTracks = mcTracks.sliceBy(perMcCollision, mcCollision.globalIndex());
@@ -347,13 +366,7 @@ struct TableMakerMC {
           continue;
         }
 
-        if (!(fNewLabels.find(mctrack.globalIndex()) != fNewLabels.end())) {
-          fNewLabels[mctrack.globalIndex()] = fCounters[0];
-          fNewLabelsReversed[fCounters[0]] = mctrack.globalIndex();
-          fMCFlags[mctrack.globalIndex()] = mcflags;
-          fEventIdx[mctrack.globalIndex()] = fEventLabels.find(mcCollision.globalIndex())->second;
-          fCounters[0]++;
-
+        if (keepMCParticle(mctrack.globalIndex(), mcflags, mcEventIdx)) {
           // if any of the MC signals was matched, then fill histograms and write that MC particle into the new stack
           // fill histograms for each of the signals, if found
           if (fConfigQA) {
@@ -373,7 +386,6 @@ struct TableMakerMC {
         trackBasic.reserve(tracksBarrel.size());
         trackBarrel.reserve(tracksBarrel.size());
         trackBarrelPID.reserve(tracksBarrel.size());
-        trackBarrelLabels.reserve(tracksBarrel.size());
         if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
           trackBarrelCov.reserve(tracksBarrel.size());
         }
@@ -450,13 +462,7 @@ struct TableMakerMC {
 
           // if the MC truth particle corresponding to this reconstructed track is not already written,
           //   add it to the skimmed stack
-          if (!(fNewLabels.find(mctrack.globalIndex()) != fNewLabels.end())) {
-            fNewLabels[mctrack.globalIndex()] = fCounters[0];
-            fNewLabelsReversed[fCounters[0]] = mctrack.globalIndex();
-            fMCFlags[mctrack.globalIndex()] = mcflags;
-            fEventIdx[mctrack.globalIndex()] = fEventLabels.find(mcCollision.globalIndex())->second;
-            fCounters[0]++;
-          }
+          keepMCParticle(mctrack.globalIndex(), mcflags, mcEventIdx);
 
           trackBasic(event.lastIndex(), trackFilteringTag, track.pt(), track.eta(), track.phi(), track.sign(), 0);
           trackBarrel(track.tpcInnerParam(), track.flags(), track.itsClusterMap(), track.itsChi2NCl(),
@@ -471,7 +477,7 @@ struct TableMakerMC {
                          track.tofNSigmaEl(), track.tofNSigmaMu(),
                          track.tofNSigmaPi(), track.tofNSigmaKa(), track.tofNSigmaPr(),
                          track.trdSignal());
-          trackBarrelLabels(fNewLabels.find(mctrack.index())->second, track.mcMask(), mcflags);
+          fTrackLabels.push_back({mctrack.globalIndex(), track.mcMask(), mcflags});
           if constexpr (static_cast<bool>(TTrackFillMap & VarManager::ObjTypes::TrackCov)) {
             trackBarrelCov(track.x(), track.alpha(), track.y(), track.z(), track.snp(), track.tgl(), track.signed1Pt(),
                            track.cYY(), track.cZY(), track.cZZ(), track.cSnpY(), track.cSnpZ(),
@@ -488,7 +494,6 @@ struct TableMakerMC {
         if constexpr (static_cast<bool>(TMuonFillMap & VarManager::ObjTypes::MuonCov)) {
           muonCov.reserve(tracksMuon.size());
         }
-        muonLabels.reserve(tracksMuon.size()); // TODO: enable this once we have fwdtrack labels
 
         auto groupedMuons = tracksMuon.sliceBy(perCollisionMuons, collision.globalIndex());
         // loop over muons
@@ -587,13 +592,7 @@ struct TableMakerMC {
 
           // if the MC truth particle corresponding to this reconstructed track is not already written,
           //   add it to the skimmed stack
-          if (!(fNewLabels.find(mctrack.globalIndex()) != fNewLabels.end())) {
-            fNewLabels[mctrack.globalIndex()] = fCounters[0];
-            fNewLabelsReversed[fCounters[0]] = mctrack.globalIndex();
-            fMCFlags[mctrack.globalIndex()] = mcflags;
-            fEventIdx[mctrack.globalIndex()] = fEventLabels.find(mcCollision.globalIndex())->second;
-            fCounters[0]++;
-          }
+          keepMCParticle(mctrack.globalIndex(), mcflags, mcEventIdx);
 
           // update the matching MCH/MFT index
 
@@ -628,22 +627,70 @@ struct TableMakerMC {
                     muon.cTglX(), muon.cTglY(), muon.cTglPhi(), muon.cTglTgl(), muon.c1PtX(), muon.c1PtY(),
                     muon.c1PtPhi(), muon.c1PtTgl(), muon.c1Pt21Pt2());
           }
-          muonLabels(fNewLabels.find(mctrack.index())->second, muon.mcMask(), mcflags);
+          fMuonLabels.push_back({mctrack.globalIndex(), muon.mcMask(), mcflags});
         }
       } // end if constexpr (static_cast<bool>(TMuonFillMap))
     }   // end loop over collisions
 
-    // Loop over the label map, create the mother/daughter relationships if these exist and write the skimmed MC stack
-    for (const auto& [newLabel, oldLabel] : fNewLabelsReversed) {
-      auto mctrack = mcTracks.iteratorAt(oldLabel);
-      uint16_t mcflags = fMCFlags.find(oldLabel)->second;
+    // Flag the mothers of the written MC particles, for the requested number of generations
+    std::vector<int64_t> generation;
+    if (fConfigMCMotherGenerations > 0) {
+      for (int64_t mcIdx = 0; mcIdx < mcTracks.size(); mcIdx++) {
+        if (fKeepMC[mcIdx]) {
+          generation.push_back(mcIdx);
+        }
+      }
+    }
+    for (int igen = 0; igen < fConfigMCMotherGenerations && !generation.empty(); igen++) {
+      std::vector<int64_t> mothersOfGeneration;
+      for (auto mcIdx : generation) {
+        auto mctrack = mcTracks.iteratorAt(mcIdx);
+        if (!mctrack.has_mothers()) {
+          continue;
+        }
+        for (auto& m : mctrack.mothersIds()) {
+          if (m >= 0 && m < mcTracks.size() && keepMCParticle(m, 0, fEventIdx[mcIdx])) {
+            mothersOfGeneration.push_back(m);
+          }
+        }
+      }
+      generation.swap(mothersOfGeneration);
+    }
+
+    // Indices of the written MC particles in the skimmed MC stack, from the prefix sum of the flags
+    std::vector<int> fNewLabels(mcTracks.size(), -1);
+    int nMCParticles = 0;
+    for (int64_t mcIdx = 0; mcIdx < mcTracks.size(); mcIdx++) {
+      if (fKeepMC[mcIdx]) {
+        fNewLabels[mcIdx] = nMCParticles++;
+      }
+    }
+
+    // Write the MC labels of the skimmed tracks
+    trackBarrelLabels.reserve(fTrackLabels.size());
+    for (const auto& label : fTrackLabels) {
+      trackBarrelLabels(fNewLabels[label.fMCParticle], label.fMCMask, label.fMCFlags);
+    }
+    muonLabels.reserve(fMuonLabels.size());
+    for (const auto& label : fMuonLabels) {
+      muonLabels(fNewLabels[label.fMCParticle], label.fMCMask, label.fMCFlags);
+    }
+
+    // Loop over the flagged MC particles, create the mother/daughter relationships if these exist and write the skimmed MC stack
+    trackMC.reserve(nMCParticles);
+    for (int64_t mcIdx = 0; mcIdx < mcTracks.size(); mcIdx++) {
+      if (!fKeepMC[mcIdx]) {
+        continue;
+      }
+      auto mctrack = mcTracks.iteratorAt(mcIdx);
+      uint16_t mcflags = fMCFlags[mcIdx];
 
       std::vector<int> mothers;
       if (mctrack.has_mothers()) {
         for (auto& m : mctrack.mothersIds()) {
           if (m < mcTracks.size()) { // protect against bad mother indices
-            if (fNewLabels.find(m) != fNewLabels.end()) {
-              mothers.push_back(fNewLabels.find(m)->second);
+            if (m >= 0 && fNewLabels[m] >= 0) {
+              mothers.push_back(fNewLabels[m]);
             }
           } else {
             cout << "Mother label (" << m << ") exceeds the McParticles size (" << mcTracks.size() << ")" << endl;
@@ -659,8 +706,8 @@ struct TableMakerMC {
         for (int d = mctrack.daughtersIds()[0]; d <= mctrack.daughtersIds()[1]; ++d) {
           // TODO: remove this check as soon as issues with MC production are fixed
           if (d < mcTracks.size()) { // protect against bad daughter indices
-            if (fNewLabels.find(d) != fNewLabels.end()) {
-              daughters.push_back(fNewLabels.find(d)->second);
+            if (d >= 0 && fNewLabels[d] >= 0) {
+              daughters.push_back(fNewLabels[d]);
             }
           } else {
             cout << "Daughter label (" << d << ") exceeds the McParticles size (" << mcTracks.size() << ")" << endl;
@@ -674,7 +721,7 @@ struct TableMakerMC {
         daughterRange[1] = daughters[daughters.size() - 1];
       }
 
-      trackMC(fEventIdx.find(oldLabel)->second, mctrack.pdgCode(), mctrack.statusCode(), mctrack.flags(),
+      trackMC(fEventIdx[mcIdx], mctrack.pdgCode(), mctrack.statusCode(), mctrack.flags(),
               mothers, daughterRange,
               mctrack.weight(), mctrack.pt(), mctrack.eta(), mctrack.phi(), mctrack.e(),
               mctrack.vx(), mctrack.vy(), mctrack.vz(), mctrack.vt(), mcflags);
@@ -686,15 +733,7 @@ struct TableMakerMC {
       if (mcflags == 0) {
         ((TH1I*)fStatsList->At(3))->Fill(float(fMCSignals.size()));
       }
-    } // end loop over labels
-
-    fCounters[0] = 0;
-    fCounters[1] = 0;
-    fNewLabels.clear();
-    fNewLabelsReversed.clear();
-    fMCFlags.clear();
-    fEventIdx.clear();
-    fEventLabels.clear();
+    } // end loop over MC particles
   }
 
   void DefineHistograms(TString histClasses)
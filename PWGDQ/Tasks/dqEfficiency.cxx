@@ -489,6 +489,7 @@ struct AnalysisSameEventPairing {
   Configurable<std::string> fConfigMCRecSignals{"cfgBarrelMCRecSignals", "", "Comma separated list of MC signals (reconstructed)"};
   Configurable<std::string> fConfigMCGenSignals{"cfgBarrelMCGenSignals", "", "Comma separated list of MC signals (generated)"};
   Configurable<bool> fConfigFlatTables{"cfgFlatTables", false, "Produce a single flat tables with all relevant information of the pairs and single tracks"};
+  Configurable<bool> fConfigUseFwdTrackCache{"cfgUseFwdTrackCache", false, "If true, build the forward track parameters of a muon once per event and not once per muon pair in the pair vertexing"};
   // TODO: here we specify signals, however signal decisions are precomputed and stored in mcReducedFlags
   // TODO: The tasks based on skimmed MC could/should rely ideally just on these flags
   // TODO:   special AnalysisCuts to be prepared in this direction
@@ -501,8 +502,16 @@ struct AnalysisSameEventPairing {
   std::vector<std::vector<TString>> fMuonHistNamesMCmatched;
   std::vector<std::vector<TString>> fBarrelMuonHistNames;
   std::vector<std::vector<TString>> fBarrelMuonHistNamesMCmatched;
+  // indices of the histogram classes above, used to fill them in the pairing without a lookup by name
+  std::vector<std::vector<int>> fBarrelHistIds;
+  std::vector<std::vector<int>> fBarrelHistIdsMCmatched;
+  std::vector<std::vector<int>> fMuonHistIds;
+  std::vector<std::vector<int>> fMuonHistIdsMCmatched;
+  std::vector<std::vector<int>> fBarrelMuonHistIds;
+  std::vector<std::vector<int>> fBarrelMuonHistIdsMCmatched;
   std::vector<MCSignal> fRecMCSignals;
   std::vector<MCSignal> fGenMCSignals;
+  MCSignalCache fRecMCSignalsCache; // decisions of the reconstructed signals per MC particle, reused for all the pairs of an event
 
   void init(o2::framework::InitContext& context)
   {
@@ -644,27 +653,37 @@ struct AnalysisSameEventPairing {
     VarManager::SetUseVars(fHistMan->GetUsedVars()); // provide the list of required variables so that VarManager knows what to fill
     fOutputList.setObject(fHistMan->GetMainHistogramList());
 
+    auto getHistIds = [&](const std::vector<std::vector<TString>>& namesPerCut) {
+      std::vector<std::vector<int>> ids;
+      for (const auto& names : namesPerCut) {
+        std::vector<int> idsCut;
+        for (const auto& name : names) {
+          idsCut.push_back(fHistMan->GetHistClassIndex(name.Data()));
+        }
+        ids.push_back(idsCut);
+      }
+      return ids;
+    };
+    fBarrelHistIds = getHistIds(fBarrelHistNames);
+    fBarrelHistIdsMCmatched = getHistIds(fBarrelHistNamesMCmatched);
+    fMuonHistIds = getHistIds(fMuonHistNames);
+    fMuonHistIdsMCmatched = getHistIds(fMuonHistNamesMCmatched);
+    fBarrelMuonHistIds = getHistIds(fBarrelMuonHistNames);
+    fBarrelMuonHistIdsMCmatched = getHistIds(fBarrelMuonHistNamesMCmatched);
+    fRecMCSignalsCache.Reset(&fRecMCSignals);
+
     VarManager::SetupTwoProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true); // TODO: get these parameters from Configurables
     VarManager::SetupTwoProngFwdDCAFitter(5.0f, true, 200.0f, 1.0e-3f, 0.9f, true);
+    VarManager::SetUseFwdTrackCache(fConfigUseFwdTrackCache.value);
   }
 
   template <int TPairType, uint32_t TEventFillMap, uint32_t TEventMCFillMap, uint32_t TTrackFillMap, typename TEvent, typename TTracks1, typename TTracks2, typename TEventsMC, typename TTracksMC>
   void runPairing(TEvent const& event, TTracks1 const& tracks1, TTracks2 const& tracks2, TEventsMC const& eventsMC, TTracksMC const& tracksMC)
   {
     // establish the right histogram classes to be filled depending on TPairType (ee,mumu,emu)
-    unsigned int ncuts = fBarrelHistNames.size();
-    std::vector<std::vector<TString>> histNames = fBarrelHistNames;
-    std::vector<std::vector<TString>> histNamesMCmatched = fBarrelHistNamesMCmatched;
-    if constexpr (TPairType == VarManager::kDecayToMuMu) {
-      ncuts = fMuonHistNames.size();
-      histNames = fMuonHistNames;
-      histNamesMCmatched = fMuonHistNamesMCmatched;
-    }
-    if constexpr (TPairType == VarManager::kElectronMuon) {
-      ncuts = fBarrelMuonHistNames.size();
-      histNames = fBarrelMuonHistNames;
-      histNamesMCmatched = fBarrelMuonHistNamesMCmatched;
-    }
+    const auto& histIds = (TPairType == VarManager::kDecayToMuMu ? fMuonHistIds : (TPairType == VarManager::kElectronMuon ? fBarrelMuonHistIds : fBarrelHistIds));
+    const auto& histIdsMCmatched = (TPairType == VarManager::kDecayToMuMu ? fMuonHistIdsMCmatched : (TPairType == VarManager::kElectronMuon ? fBarrelMuonHistIdsMCmatched : fBarrelHistIdsMCmatched));
+    unsigned int ncuts = histIds.size();
 
     // Loop over two track combinations
     uint8_t twoTrackFilter = 0;
@@ -675,6 +694,10 @@ struct AnalysisSameEventPairing {
     if (fConfigFlatTables.value) {
       dimuonAllList.reserve(1);
     }
+    fRecMCSignalsCache.Clear();
+    if constexpr (TPairType == VarManager::kDecayToMuMu) {
+      VarManager::ResetFwdTrackCache();
+    }
 
     for (auto& [t1, t2] : combinations(tracks1, tracks2)) {
       if constexpr (TPairType == VarManager::kDecayToEE) {
@@ -695,21 +718,14 @@ struct AnalysisSameEventPairing {
         VarManager::FillPairVertexing<TPairType, TEventFillMap, TTrackFillMap>(event, t1, t2, VarManager::fgValues);
       }
 
-      // run MC matching for this pair
+      // run MC matching for this pair, the history of each MC particle is checked only once per event
       uint32_t mcDecision = 0;
-      int isig = 0;
-      for (auto sig = fRecMCSignals.begin(); sig != fRecMCSignals.end(); sig++, isig++) {
-        if constexpr (TTrackFillMap & VarManager::ObjTypes::ReducedTrack || TTrackFillMap & VarManager::ObjTypes::ReducedMuon) { // for skimmed DQ model
-          if ((*sig).CheckSignal(false, tracksMC, t1.reducedMCTrack(), t2.reducedMCTrack())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
-        if constexpr (TTrackFillMap & VarManager::ObjTypes::Track || TTrackFillMap & VarManager::ObjTypes::Muon) { // for Framework data model
-          if ((*sig).CheckSignal(false, tracksMC, t1.template mcParticle_as<aod::McParticles_001>(), t2.template mcParticle_as<aod::McParticles_001>())) {
-            mcDecision |= (uint32_t(1) << isig);
-          }
-        }
-      } // end loop over MC signals
+      if constexpr (TTrackFillMap & VarManager::ObjTypes::ReducedTrack || TTrackFillMap & VarManager::ObjTypes::ReducedMuon) { // for skimmed DQ model
+        mcDecision |= fRecMCSignalsCache.CheckSignals(tracksMC, t1.reducedMCTrack(), t2.reducedMCTrack());
+      }
+      if constexpr (TTrackFillMap & VarManager::ObjTypes::Track || TTrackFillMap & VarManager::ObjTypes::Muon) { // for Framework data model
+        mcDecision |= fRecMCSignalsCache.CheckSignals(tracksMC, t1.template mcParticle_as<aod::McParticles_001>(), t2.template mcParticle_as<aod::McParticles_001>());
+      }
 
       dileptonFilterMap = twoTrackFilter;
       dileptonMcDecision = mcDecision;
@@ -726,17 +742,17 @@ struct AnalysisSameEventPairing {
       for (unsigned int icut = 0; icut < ncuts; icut++) {
         if (twoTrackFilter & (uint8_t(1) << icut)) {
           if (t1.sign() * t2.sign() < 0) {
-            fHistMan->FillHistClass(histNames[icut][0].Data(), VarManager::fgValues);
+            fHistMan->FillHistClass(histIds[icut][0], VarManager::fgValues);
             for (unsigned int isig = 0; isig < fRecMCSignals.size(); isig++) {
               if (mcDecision & (uint32_t(1) << isig)) {
-                fHistMan->FillHistClass(histNamesMCmatched[icut][isig].Data(), VarManager::fgValues);
+                fHistMan->FillHistClass(histIdsMCmatched[icut][isig], VarManager::fgValues);
               }
             }
           } else {
             if (t1.sign() > 0) {
-              fHistMan->FillHistClass(histNames[icut][1].Data(), VarManager::fgValues);
+              fHistMan->FillHistClass(histIds[icut][1], VarManager::fgValues);
             } else {
-              fHistMan->FillHistClass(histNames[icut][2].Data(), VarManager::fgValues);
+              fHistMan->FillHistClass(histIds[icut][2], VarManager::fgValues);
             }
           }
         }
@@ -872,6 +888,7 @@ struct AnalysisDileptonTrack {
   // TODO: For now this is only used to determine the position in the filter bit map for the hadron cut
   Configurable<string> fConfigTrackCuts{"cfgLeptonCuts", "", "Comma separated list of barrel track cuts"};
   Configurable<bool> fConfigFillCandidateTable{"cfgFillCandidateTable", false, "Produce a single flat tables with all relevant information dilepton-track candidates"};
+  Configurable<bool> fConfigUseVertexingCache{"cfgUseVertexingCache", false, "If true, fit the dilepton legs once per dilepton and not once per dilepton-track combination"};
   Filter eventFilter = aod::dqanalysisflags::isEventSelected == 1;
   // Filter dileptonFilter = aod::reducedpair::mass > 2.92f && aod::reducedpair::mass < 3.16f && aod::reducedpair::sign == 0;
   // Filter dileptonFilter = aod::reducedpair::mass > 2.6f && aod::reducedpair::mass < 3.5f && aod::reducedpair::sign == 0;
@@ -972,6 +989,7 @@ struct AnalysisDileptonTrack {
     } else {
       fNHadronCutBit = 0;
     }
+    VarManager::SetUseDileptonTrackVertexingCache(fConfigUseVertexingCache.value);
   }
 
   // Template function to run pair - track combinations
@@ -982,6 +1000,7 @@ struct AnalysisDileptonTrack {
     VarManager::ResetValues(0, VarManager::kNVars, fValuesDilepton);
     VarManager::FillEvent<TEventFillMap>(event, fValuesTrack);
     VarManager::FillEvent<TEventFillMap>(event, fValuesDilepton);
+    VarManager::ResetDileptonTrackVertexingCache();
 
     // Set the global index offset to find the proper lepton
     // TO DO: remove it once the issue with lepton index is solved
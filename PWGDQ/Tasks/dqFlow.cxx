@@ -27,6 +27,7 @@
 #include "PWGDQ/Core/MixingHandler.h"
 #include "PWGDQ/Core/AnalysisCut.h"
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/CompiledCuts.h"
 #include "PWGDQ/Core/HistogramsLibrary.h"
 #include "PWGDQ/Core/CutsLibrary.h"
 #include "PWGDQ/Core/MixingLibrary.h"
@@ -82,11 +83,13 @@ void DefineHistograms(HistogramManager* histMan, TString histClasses);
 
 struct AnalysisQvector {
   Produces<ReducedEventsQvector> eventQvector;
+  Produces<ReducedEventsQvectorCuts> eventQvectorCuts;
 
   Configurable<std::string> fConfigEventCuts{"cfgEventCuts", "eventStandard", "Event selection"};
   Configurable<std::string> fConfigTrackCuts{"cfgBarrelTrackCuts", "jpsiPID1", "Comma separated list of barrel track cuts"};
   Configurable<std::string> fConfigMuonCuts{"cfgMuonCuts", "muonQualityCuts", "Comma separated list of muon cuts"};
   Configurable<bool> fConfigQA{"cfgQA", true, "If true, fill QA histograms"};
+  Configurable<bool> fConfigQvectorPerTrackCut{"cfgQvectorPerTrackCut", false, "If true, compute also the Q vectors of the tracks of each barrel track cut, in the same track loop"};
 
   // Configurable<float> fConfigVtxCut{"cfgVtxCut", 12.0, "Z vertex cut"};
   Configurable<float> fConfigCutPtMin{"cfgCutPtMin", 0.2f, "Minimal pT for tracks"};
@@ -121,6 +124,14 @@ struct AnalysisQvector {
   // Define output
   HistogramManager* fHistMan = nullptr;
   AnalysisCompositeCut* fEventCut;
+  std::vector<AnalysisCompositeCut> fTrackCuts; //! Barrel track cuts, with one set of GFW regions each
+  CompiledCuts fTrackCutsCompiled;              //! Barrel track cuts, evaluated at once
+  VarManager::ValuesContext fCutQvectorValues;  //! Q vectors of the tracks of one track cut
+
+  // GFW regions: refN, refP and full of all the tracks, with the bits 0 and 1 of the fill mask,
+  // then the same three regions for each track cut, with the bit kFirstCutBit + icut
+  static constexpr int kFirstCutBit = 2;
+  static constexpr int kMaxTrackCuts = 31 - kFirstCutBit;
   OutputObj<THashList> fOutputList{"outputQA"};
   // OutputObj<FlowContainer> fFC{FlowContainer("FlowContainer")};  // Need to add a dictionary for FlowContainer output
 
@@ -140,6 +151,21 @@ struct AnalysisQvector {
         fEventCut->AddCut(dqcuts::GetAnalysisCut(objArray->At(icut)->GetName()));
       }
     }
+    if (fConfigQvectorPerTrackCut) {
+      TString trackCutStr = fConfigTrackCuts.value;
+      if (!trackCutStr.IsNull()) {
+        std::unique_ptr<TObjArray> objArray(trackCutStr.Tokenize(","));
+        for (int icut = 0; icut < objArray->GetEntries(); ++icut) {
+          fTrackCuts.push_back(*dqcuts::GetCompositeCut(objArray->At(icut)->GetName()));
+        }
+      }
+      if (fTrackCuts.size() > kMaxTrackCuts) {
+        LOGF(fatal, "Q vectors of at most %d barrel track cuts can be computed, %d requested", kMaxTrackCuts, fTrackCuts.size());
+      }
+      for (auto& cut : fTrackCuts) {
+        fTrackCutsCompiled.AddCut(&cut);
+      }
+    }
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
 
     ccdb->setURL(fConfigURL.value);
@@ -185,6 +211,12 @@ struct AnalysisQvector {
     fGFW->AddRegion("refN", 7, pows, -fConfigCutEta, -fConfigEtaLimit, 1, 1);
     fGFW->AddRegion("refP", 7, pows, fConfigEtaLimit, fConfigCutEta, 1, 1);
     fGFW->AddRegion("full", 7, powsFull, -fConfigCutEta, fConfigCutEta, 1, 2);
+    for (unsigned int icut = 0; icut < fTrackCuts.size(); icut++) {
+      int cutBit = 1 << (kFirstCutBit + icut);
+      fGFW->AddRegion(Form("refN_%s", fTrackCuts[icut].GetName()), 7, pows, -fConfigCutEta, -fConfigEtaLimit, 1, cutBit);
+      fGFW->AddRegion(Form("refP_%s", fTrackCuts[icut].GetName()), 7, pows, fConfigEtaLimit, fConfigCutEta, 1, cutBit);
+      fGFW->AddRegion(Form("full_%s", fTrackCuts[icut].GetName()), 7, powsFull, -fConfigCutEta, fConfigCutEta, 1, cutBit);
+    }
 
     //corrconfigs.push_back(fGFW->GetCorrelatorConfig("refP {2} refN {-2}", "ChGap22", kFALSE));
     //corrconfigs.push_back(fGFW->GetCorrelatorConfig("refP {2 2} refN {-2 -2}", "ChGap24", kFALSE));
@@ -272,10 +304,14 @@ struct AnalysisQvector {
       } else {
         wacc = 1;
       }
-      // VarManager::FillTrack<TTrackFillMap>(track);
 
-      // Fill the GFW for each track to compute Q vector
-      fGFW->Fill(track.eta(), 0, track.phi(), wacc * weff, 3); // using default values for ptin=0 and mask=3
+      // Fill the GFW for each track to compute Q vector, the regions of all the track cuts passed by the track are filled at once
+      int mask = 3; // using default values for ptin=0 and mask=3
+      if (fTrackCutsCompiled.GetNCuts() > 0) {
+        VarManager::FillTrack<TTrackFillMap>(track);
+        mask |= static_cast<int>(fTrackCutsCompiled.Evaluate(VarManager::fgValues) << kFirstCutBit);
+      }
+      fGFW->Fill(track.eta(), 0, track.phi(), wacc * weff, mask);
     }
 
     //    float l_Random = fRndm->Rndm(); // used only to compute correlators
@@ -329,6 +365,24 @@ struct AnalysisQvector {
 
     // Fill the tree for the reduced event table with Q vector quantities
     if (fEventCut->IsSelected(VarManager::fgValues)) {
+      // Q vectors of each track cut, for the dilepton flow analyses using several track definitions
+      if (fTrackCuts.size() > 0) {
+        eventQvectorCuts.reserve(fTrackCuts.size());
+      }
+      for (unsigned int icut = 0; icut < fTrackCuts.size(); icut++) {
+        GFWCumulant gfwCumN = fGFW->GetCumulant(3 * (icut + 1));
+        GFWCumulant gfwCumP = fGFW->GetCumulant(3 * (icut + 1) + 1);
+        GFWCumulant gfwCumFull = fGFW->GetCumulant(3 * (icut + 1) + 2);
+        VarManager::FillQVectorFromGFW(collision, gfwCumFull.Vec(2, fConfigNPow), gfwCumN.Vec(2, fConfigNPow), gfwCumP.Vec(2, fConfigNPow),
+                                       gfwCumFull.Vec(3, fConfigNPow), gfwCumN.Vec(3, fConfigNPow), gfwCumP.Vec(3, fConfigNPow),
+                                       gfwCumFull.GetN(), gfwCumN.GetN(), gfwCumP.GetN(), fCutQvectorValues.Data());
+        auto& v = fCutQvectorValues;
+        eventQvectorCuts(collision.globalIndex(), icut,
+                         v[VarManager::kQ2X0A], v[VarManager::kQ2Y0A], v[VarManager::kQ2X0B], v[VarManager::kQ2Y0B], v[VarManager::kQ2X0C], v[VarManager::kQ2Y0C],
+                         v[VarManager::kMultA], v[VarManager::kMultB], v[VarManager::kMultC],
+                         v[VarManager::kQ3X0A], v[VarManager::kQ3Y0A], v[VarManager::kQ3X0B], v[VarManager::kQ3Y0B], v[VarManager::kQ3X0C], v[VarManager::kQ3Y0C]);
+      }
+
       eventQvector(VarManager::fgValues[VarManager::kQ2X0A], VarManager::fgValues[VarManager::kQ2Y0A], VarManager::fgValues[VarManager::kQ2X0B], VarManager::fgValues[VarManager::kQ2Y0B], VarManager::fgValues[VarManager::kQ2X0C], VarManager::fgValues[VarManager::kQ2Y0C], VarManager::fgValues[VarManager::kMultA], VarManager::fgValues[VarManager::kMultC], VarManager::fgValues[VarManager::kMultC], VarManager::fgValues[VarManager::kQ3X0A], VarManager::fgValues[VarManager::kQ3Y0A], VarManager::fgValues[VarManager::kQ3X0B], VarManager::fgValues[VarManager::kQ3Y0B], VarManager::fgValues[VarManager::kQ3X0C], VarManager::fgValues[VarManager::kQ3Y0C]);
     }
   }
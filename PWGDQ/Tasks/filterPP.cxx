@@ -479,6 +479,24 @@ struct DQFilterPPTask {
     }
   }
 
+  // Returns the bit map of the selections with pairing which can still fire, i.e. with at least the required number of opposite-sign pairs
+  //   The counters of all the selections with pairing are reset, since these count the pairs instead of the legs
+  uint32_t getPairingMask(int nCuts, std::vector<bool> const& runPairing, std::vector<int> const& nReqObjs, std::vector<int>& counters, std::vector<int> const& posCounters)
+  {
+    uint32_t pairingMask = 0;
+    for (int i = 0; i < nCuts; i++) {
+      if (!runPairing[i]) {
+        continue;
+      }
+      int nPairsMax = posCounters[i] * (counters[i] - posCounters[i]);
+      if (nPairsMax > 0 && nPairsMax >= nReqObjs[i]) {
+        pairingMask |= (uint32_t(1) << i);
+      }
+      counters[i] = 0;
+    }
+    return pairingMask;
+  }
+
   template <uint32_t TEventFillMap, uint32_t TTrackFillMap, uint32_t TMuonFillMap, typename TEvent, typename TTracks, typename TMuons>
   void runFilterPP(TEvent const& collision, aod::BCs const& bcs, TTracks const& tracksBarrel, TMuons const& muons)
   {
@@ -497,41 +515,52 @@ struct DQFilterPPTask {
       return;
     }
 
-    // Reset the values array and compute event quantities
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<TEventFillMap>(collision);
-
+    // Stage 1: count the legs of each selection, separately for the positive charges, using only the cut bits
     std::vector<int> objCountersBarrel(fNBarrelCuts, 0); // init all counters to zero
-    // count the number of barrel tracks fulfilling each cut
+    std::vector<int> posCountersBarrel(fNBarrelCuts, 0);
     for (auto track : tracksBarrel) {
       for (int i = 0; i < fNBarrelCuts; ++i) {
         if (track.isDQBarrelSelected() & (uint32_t(1) << i)) {
           objCountersBarrel[i] += 1;
+          if (track.sign() > 0) {
+            posCountersBarrel[i] += 1;
+          }
         }
       }
     }
-
-    // check which selections require pairing
-    uint32_t pairingMask = 0; // in order to know which of the selections actually require pairing
-    for (int i = 0; i < fNBarrelCuts; i++) {
-      if (fBarrelRunPairing[i]) {
-        if (objCountersBarrel[i] > 1) { // pairing has to be enabled and at least two tracks are needed
-          pairingMask |= (uint32_t(1) << i);
+    std::vector<int> objCountersMuon(fNMuonCuts, 0); // init all counters to zero
+    std::vector<int> posCountersMuon(fNMuonCuts, 0);
+    for (auto muon : muons) {
+      for (int i = 0; i < fNMuonCuts; ++i) {
+        if (muon.isDQMuonSelected() & (uint32_t(1) << i)) {
+          objCountersMuon[i] += 1;
+          if (muon.sign() > 0) {
+            posCountersMuon[i] += 1;
+          }
         }
-        objCountersBarrel[i] = 0; // reset counters for selections where pairing is needed (count pairs instead)
       }
     }
 
-    // run pairing if there is at least one selection that requires it
+    // Stage 2: keep for pairing only the selections which have enough opposite-sign pairs to fire
+    uint32_t barrelPairingMask = getPairingMask(fNBarrelCuts, fBarrelRunPairing, fBarrelNreqObjs, objCountersBarrel, posCountersBarrel);
+    uint32_t muonPairingMask = getPairingMask(fNMuonCuts, fMuonRunPairing, fMuonNreqObjs, objCountersMuon, posCountersMuon);
+
+    // Stage 3: fill the VarManager and run the pairing only if at least one selection requires it
+    if (barrelPairingMask > 0 || muonPairingMask > 0) {
+      // Reset the values array and compute event quantities
+      VarManager::ResetValues(0, VarManager::kNVars);
+      VarManager::FillEvent<TEventFillMap>(collision);
+    }
+
     uint32_t pairFilter = 0;
-    if (pairingMask > 0) {
+    if (barrelPairingMask > 0) {
       for (auto& [t1, t2] : combinations(tracksBarrel, tracksBarrel)) {
         // keep just opposite-sign pairs
         if (t1.sign() * t2.sign() > 0) {
           continue;
         }
         // check the pairing mask and that the tracks share a cut bit
-        pairFilter = pairingMask & t1.isDQBarrelSelected() & t2.isDQBarrelSelected();
+        pairFilter = barrelPairingMask & t1.isDQBarrelSelected() & t2.isDQBarrelSelected();
         if (pairFilter == 0) {
           continue;
         }
@@ -547,42 +576,25 @@ struct DQFilterPPTask {
           objCountersBarrel[icut] += 1; // count the pair
           if (fConfigQA) {              // fill histograms if QA is enabled
             fHistMan->FillHistClass(fBarrelPairHistNames[icut].Data(), VarManager::fgValues);
+          } else if (objCountersBarrel[icut] >= fBarrelNreqObjs[icut]) {
+            barrelPairingMask &= ~(uint32_t(1) << icut); // the selection fired, no need to count further pairs
           }
         }
-      }
-    }
-
-    std::vector<int> objCountersMuon(fNMuonCuts, 0); // init all counters to zero
-    // count the number of muon tracks fulfilling each selection
-    for (auto muon : muons) {
-      for (int i = 0; i < fNMuonCuts; ++i) {
-        if (muon.isDQMuonSelected() & (uint32_t(1) << i)) {
-          objCountersMuon[i] += 1;
-        }
-      }
-    }
-
-    // check which muon selections require pairing
-    pairingMask = 0; // reset the mask for the muons
-    for (int i = 0; i < fNMuonCuts; i++) {
-      if (fMuonRunPairing[i]) { // pairing has to be enabled and at least two tracks are needed
-        if (objCountersMuon[i] > 1) {
-          pairingMask |= (uint32_t(1) << i);
+        if (barrelPairingMask == 0) {
+          break;
         }
-        objCountersMuon[i] = 0; // reset counters for selections where pairing is needed (count pairs instead)
       }
     }
 
-    // run pairing if there is at least one selection that requires it
     pairFilter = 0;
-    if (pairingMask > 0) {
+    if (muonPairingMask > 0) {
       for (auto& [t1, t2] : combinations(muons, muons)) {
         // keep just opposite-sign pairs
         if (t1.sign() * t2.sign() > 0) {
           continue;
         }
         // check the pairing mask and that the tracks share a cut bit
-        pairFilter = pairingMask & t1.isDQMuonSelected() & t2.isDQMuonSelected();
+        pairFilter = muonPairingMask & t1.isDQMuonSelected() & t2.isDQMuonSelected();
         if (pairFilter == 0) {
           continue;
         }
@@ -598,8 +610,13 @@ struct DQFilterPPTask {
           objCountersMuon[icut] += 1;
           if (fConfigQA) {
             fHistMan->FillHistClass(fMuonPairHistNames[icut].Data(), VarManager::fgValues);
+          } else if (objCountersMuon[icut] >= fMuonNreqObjs[icut]) {
+            muonPairingMask &= ~(uint32_t(1) << icut); // the selection fired, no need to count further pairs
           }
         }
+        if (muonPairingMask == 0) {
+          break;
+        }
       }
     }
 
@@ -73,9 +73,12 @@ using MyEventsQvector = soa::Join<aod::ReducedEvents, aod::ReducedEventsExtended
 using MyEventsHashSelectedQvector = soa::Join<aod::ReducedEvents, aod::ReducedEventsExtended, aod::EventCuts, aod::MixingHashes, aod::ReducedEventsQvector>;
 
 using MyBarrelTracks = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelPID>;
+using MyBarrelTracksTinyPID = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelPIDTiny>;
 using MyBarrelTracksWithCov = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelCov, aod::ReducedTracksBarrelPID>;
 using MyBarrelTracksSelected = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelPID, aod::BarrelTrackCuts>;
 using MyBarrelTracksSelectedWithCov = soa::Join<aod::ReducedTracks, aod::ReducedTracksBarrel, aod::ReducedTracksBarrelCov, aod::ReducedTracksBarrelPID, aod::BarrelTrackCuts>;
+// only the kinematics and the selection bits, for the pairing tasks which do not need the detector information
+using MyBarrelTracksSelectedKine = soa::Join<aod::ReducedTracks, aod::BarrelTrackCuts>;
 
 using MyMuonTracks = soa::Join<aod::ReducedMuons, aod::ReducedMuonsExtra>;
 using MyMuonTracksSelected = soa::Join<aod::ReducedMuons, aod::ReducedMuonsExtra, aod::MuonTrackCuts>;
@@ -89,6 +92,7 @@ constexpr static uint32_t gkEventFillMapWithQvector = VarManager::ObjTypes::Redu
 constexpr static uint32_t gkEventFillMapWithCovQvector = VarManager::ObjTypes::ReducedEvent | VarManager::ObjTypes::ReducedEventExtended | VarManager::ObjTypes::ReducedEventVtxCov | VarManager::ObjTypes::ReducedEventQvector;
 
 constexpr static uint32_t gkTrackFillMap = VarManager::ObjTypes::ReducedTrack | VarManager::ObjTypes::ReducedTrackBarrel | VarManager::ObjTypes::ReducedTrackBarrelPID;
+constexpr static uint32_t gkTrackFillMapKine = VarManager::ObjTypes::ReducedTrack;
 // constexpr static uint32_t gkTrackFillMapWithCov = VarManager::ObjTypes::ReducedTrack | VarManager::ObjTypes::ReducedTrackBarrel | VarManager::ObjTypes::ReducedTrackBarrelCov | VarManager::ObjTypes::ReducedTrackBarrelPID;
 constexpr static uint32_t gkMuonFillMap = VarManager::ObjTypes::ReducedMuon | VarManager::ObjTypes::ReducedMuonExtra;
 constexpr static uint32_t gkMuonFillMapWithCov = VarManager::ObjTypes::ReducedMuon | VarManager::ObjTypes::ReducedMuonExtra | VarManager::ObjTypes::ReducedMuonCov;
@@ -260,12 +264,18 @@ struct AnalysisTrackSelection {
   {
     runTrackSelection<gkEventFillMap, gkTrackFillMap>(event, tracks);
   }
+  // the binned n-sigmas of the tiny PID table are unwrapped with the getters of the full PID table, so the same fill map applies
+  void processSkimmedTinyPID(MyEvents::iterator const& event, MyBarrelTracksTinyPID const& tracks)
+  {
+    runTrackSelection<gkEventFillMap, gkTrackFillMap>(event, tracks);
+  }
   void processDummy(MyEvents&)
   {
     // do nothing
   }
 
   PROCESS_SWITCH(AnalysisTrackSelection, processSkimmed, "Run barrel track selection on DQ skimmed tracks", false);
+  PROCESS_SWITCH(AnalysisTrackSelection, processSkimmedTinyPID, "Run barrel track selection on DQ skimmed tracks, with the 8 bit binned PID table", false);
   PROCESS_SWITCH(AnalysisTrackSelection, processDummy, "Dummy function", false);
 };
 
@@ -361,6 +371,7 @@ struct AnalysisEventMixing {
   Configurable<string> fConfigMuonCuts{"cfgMuonCuts", "", "Comma separated list of muon cuts"};
   Configurable<int> fConfigMixingDepth{"cfgMixingDepth", 100, "Number of Events stored for event mixing"};
   Configurable<std::string> fConfigAddEventMixingHistogram{"cfgAddEventMixingHistogram", "", "Comma separated list of histograms"};
+  Configurable<bool> fConfigDeferHistograms{"cfgDeferHistograms", false, "Create the histograms at their first fill, the histograms never filled are then not in the output"};
 
   Filter filterEventSelected = aod::dqanalysisflags::isEventSelected == 1;
   Filter filterTrackSelected = aod::dqanalysisflags::isBarrelSelected > 0;
@@ -373,6 +384,10 @@ struct AnalysisEventMixing {
   std::vector<std::vector<TString>> fTrackHistNames;
   std::vector<std::vector<TString>> fMuonHistNames;
   std::vector<std::vector<TString>> fTrackMuonHistNames;
+  // indices of the histogram classes above, used to fill them in the pairing without a lookup by name
+  std::vector<std::vector<int>> fTrackHistIds;
+  std::vector<std::vector<int>> fMuonHistIds;
+  std::vector<std::vector<int>> fTrackMuonHistIds;
 
   NoBinningPolicy<aod::dqanalysisflags::MixingHash> hashBin;
 
@@ -382,6 +397,7 @@ struct AnalysisEventMixing {
     fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
     fHistMan->SetUseDefaultVariableNames(kTRUE);
     fHistMan->SetDefaultVarNames(VarManager::fgVariableNames, VarManager::fgVariableUnits);
+    fHistMan->SetDeferredAllocation(fConfigDeferHistograms);
 
     // Keep track of all the histogram class names to avoid composing strings in the event mixing pairing
     TString histNames = "";
@@ -439,22 +455,25 @@ struct AnalysisEventMixing {
     DefineHistograms(fHistMan, histNames.Data(), fConfigAddEventMixingHistogram); // define all histograms
     VarManager::SetUseVars(fHistMan->GetUsedVars());                              // provide the list of required variables so that VarManager knows what to fill
     fOutputList.setObject(fHistMan->GetMainHistogramList());
+
+    auto getHistIds = [&](const std::vector<std::vector<TString>>& namesPerCut) {
+      std::vector<std::vector<int>> ids;
+      for (const auto& names : namesPerCut) {
+        ids.push_back({fHistMan->GetHistClassIndex(names[0].Data()), fHistMan->GetHistClassIndex(names[1].Data()), fHistMan->GetHistClassIndex(names[2].Data())});
+      }
+      return ids;
+    };
+    fTrackHistIds = getHistIds(fTrackHistNames);
+    fMuonHistIds = getHistIds(fMuonHistNames);
+    fTrackMuonHistIds = getHistIds(fTrackMuonHistNames);
   }
 
   template <int TPairType, typename TTracks1, typename TTracks2>
   void runMixedPairing(TTracks1 const& tracks1, TTracks2 const& tracks2)
   {
 
-    unsigned int ncuts = fTrackHistNames.size();
-    std::vector<std::vector<TString>> histNames = fTrackHistNames;
-    if constexpr (TPairType == pairTypeMuMu) {
-      ncuts = fMuonHistNames.size();
-      histNames = fMuonHistNames;
-    }
-    if constexpr (TPairType == pairTypeEMu) {
-      ncuts = fTrackMuonHistNames.size();
-      histNames = fTrackMuonHistNames;
-    }
+    const auto& histIds = (TPairType == pairTypeMuMu ? fMuonHistIds : (TPairType == pairTypeEMu ? fTrackMuonHistIds : fTrackHistIds));
+    unsigned int ncuts = histIds.size();
 
     uint32_t twoTrackFilter = 0;
     for (auto& track1 : tracks1) {
@@ -482,12 +501,12 @@ struct AnalysisEventMixing {
         for (unsigned int icut = 0; icut < ncuts; icut++) {
           if (twoTrackFilter & (uint32_t(1) << icut)) {
             if (track1.sign() * track2.sign() < 0) {
-              fHistMan->FillHistClass(histNames[icut][0].Data(), VarManager::fgValues);
+              fHistMan->FillHistClass(histIds[icut][0], VarManager::fgValues);
             } else {
               if (track1.sign() > 0) {
-                fHistMan->FillHistClass(histNames[icut][1].Data(), VarManager::fgValues);
+                fHistMan->FillHistClass(histIds[icut][1], VarManager::fgValues);
               } else {
-                fHistMan->FillHistClass(histNames[icut][2].Data(), VarManager::fgValues);
+                fHistMan->FillHistClass(histIds[icut][2], VarManager::fgValues);
               }
             }
           } // end if (filter bits)
@@ -613,6 +632,8 @@ struct AnalysisSameEventPairing {
   Configurable<string> ccdbPath{"ccdb-path", "Users/lm", "base path to the ccdb object"};
   Configurable<int64_t> nolaterthan{"ccdb-no-later-than", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), "latest acceptable timestamp of creation for the object"};
   Configurable<std::string> fConfigAddSEPHistogram{"cfgAddSEPHistogram", "", "Comma separated list of histograms"};
+  Configurable<bool> fConfigDeferHistograms{"cfgDeferHistograms", false, "Create the histograms at their first fill, the histograms never filled are then not in the output"};
+  Configurable<bool> fConfigUseFwdTrackCache{"cfgUseFwdTrackCache", false, "If true, build the forward track parameters of a muon once per event and not once per muon pair in the pair vertexing"};
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   Filter filterEventSelected = aod::dqanalysisflags::isEventSelected == 1;
   // NOTE: the barrel filter map contains decisions for both electrons and hadrons used in the correlation task
@@ -629,6 +650,13 @@ struct AnalysisSameEventPairing {
   std::vector<std::vector<TString>> fTrackHistNames;
   std::vector<std::vector<TString>> fMuonHistNames;
   std::vector<std::vector<TString>> fTrackMuonHistNames;
+  // indices of the histogram classes above, used to fill them in the pairing without a lookup by name
+  std::vector<std::vector<int>> fTrackHistIds;
+  std::vector<std::vector<int>> fMuonHistIds;
+  std::vector<std::vector<int>> fTrackMuonHistIds;
+  VarManager::ValuesContext fValues; // variables of the event and of the current pair, owned by this task
+  std::vector<uint32_t> fPairCutBits1; // cut bits of the first track list of the pairing, masked with the pairing cuts
+  std::vector<uint32_t> fPairCutBits2; // cut bits of the second track list of the pairing
 
   void init(o2::framework::InitContext& context)
   {
@@ -636,10 +664,11 @@ struct AnalysisSameEventPairing {
     fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
     fHistMan->SetUseDefaultVariableNames(kTRUE);
     fHistMan->SetDefaultVarNames(VarManager::fgVariableNames, VarManager::fgVariableUnits);
+    fHistMan->SetDeferredAllocation(fConfigDeferHistograms);
 
     // Keep track of all the histogram class names to avoid composing strings in the event mixing pairing
     TString histNames = "";
-    if (context.mOptions.get<bool>("processDecayToEESkimmed") || context.mOptions.get<bool>("processVnDecayToEESkimmed") || context.mOptions.get<bool>("processAllSkimmed")) {
+    if (context.mOptions.get<bool>("processDecayToEESkimmed") || context.mOptions.get<bool>("processDecayToEESkimmedKine") || context.mOptions.get<bool>("processVnDecayToEESkimmed") || context.mOptions.get<bool>("processAllSkimmed")) {
       TString cutNames = fConfigTrackCuts.value;
       if (!cutNames.IsNull()) {
         std::unique_ptr<TObjArray> objArray(cutNames.Tokenize(","));
@@ -700,8 +729,20 @@ struct AnalysisSameEventPairing {
     VarManager::SetUseVars(fHistMan->GetUsedVars());                      // provide the list of required variables so that VarManager knows what to fill
     fOutputList.setObject(fHistMan->GetMainHistogramList());
 
+    auto getHistIds = [&](const std::vector<std::vector<TString>>& namesPerCut) {
+      std::vector<std::vector<int>> ids;
+      for (const auto& names : namesPerCut) {
+        ids.push_back({fHistMan->GetHistClassIndex(names[0].Data()), fHistMan->GetHistClassIndex(names[1].Data()), fHistMan->GetHistClassIndex(names[2].Data())});
+      }
+      return ids;
+    };
+    fTrackHistIds = getHistIds(fTrackHistNames);
+    fMuonHistIds = getHistIds(fMuonHistNames);
+    fTrackMuonHistIds = getHistIds(fTrackMuonHistNames);
+
     VarManager::SetupTwoProngDCAFitter(5.0f, true, 200.0f, 4.0f, 1.0e-3f, 0.9f, true); // TODO: get these parameters from Configurables
     VarManager::SetupTwoProngFwdDCAFitter(5.0f, true, 200.0f, 1.0e-3f, 0.9f, true);
+    VarManager::SetUseFwdTrackCache(fConfigUseFwdTrackCache.value);
   }
 
   // Template function to run same event pairing (barrel-barrel, muon-muon, barrel-muon)
@@ -709,122 +750,154 @@ struct AnalysisSameEventPairing {
   void runSameEventPairing(TEvent const& event, TTracks1 const& tracks1, TTracks2 const& tracks2)
   {
 
-    unsigned int ncuts = fTrackHistNames.size();
-    std::vector<std::vector<TString>> histNames = fTrackHistNames;
-    if constexpr (TPairType == pairTypeMuMu) {
-      ncuts = fMuonHistNames.size();
-      histNames = fMuonHistNames;
-    }
-    if constexpr (TPairType == pairTypeEMu) {
-      ncuts = fTrackMuonHistNames.size();
-      histNames = fTrackMuonHistNames;
-    }
+    const auto& histIds = (TPairType == pairTypeMuMu ? fMuonHistIds : (TPairType == pairTypeEMu ? fTrackMuonHistIds : fTrackHistIds));
+    unsigned int ncuts = histIds.size();
 
     uint32_t twoTrackFilter = 0;
     uint32_t dileptonFilterMap = 0;
     uint32_t dileptonMcDecision = 0; // placeholder, copy of the dqEfficiency.cxx one
     dileptonList.reserve(1);
     dileptonExtraList.reserve(1);
-    for (auto& [t1, t2] : combinations(tracks1, tracks2)) {
-      if constexpr (TPairType == VarManager::kDecayToEE) {
-        twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isBarrelSelected()) & fTwoTrackFilterMask;
-      }
+    if constexpr (TPairType == pairTypeMuMu) {
+      VarManager::ResetFwdTrackCache();
+    }
+
+    // compact the cut bits of the two track lists, such that the pairs without common cut bits are rejected
+    //   in a tight loop over integers, without going through the table iterators
+    std::vector<typename TTracks1::iterator> compactTracks1;
+    std::vector<typename TTracks2::iterator> compactTracks2;
+    fPairCutBits1.clear();
+    fPairCutBits2.clear();
+    compactTracks1.reserve(tracks1.size());
+    compactTracks2.reserve(tracks2.size());
+    const uint32_t mask = (TPairType == VarManager::kDecayToMuMu ? fTwoMuonFilterMask : fTwoTrackFilterMask);
+    for (auto& track : tracks1) {
+      compactTracks1.push_back(track);
       if constexpr (TPairType == VarManager::kDecayToMuMu) {
-        twoTrackFilter = uint32_t(t1.isMuonSelected()) & uint32_t(t2.isMuonSelected()) & fTwoMuonFilterMask;
+        fPairCutBits1.push_back(uint32_t(track.isMuonSelected()) & mask);
+      } else {
+        fPairCutBits1.push_back(uint32_t(track.isBarrelSelected()) & mask);
       }
-      if constexpr (TPairType == VarManager::kElectronMuon) {
-        twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isMuonSelected()) & fTwoTrackFilterMask;
+    }
+    for (auto& track : tracks2) {
+      compactTracks2.push_back(track);
+      if constexpr (TPairType == VarManager::kDecayToEE) {
+        fPairCutBits2.push_back(uint32_t(track.isBarrelSelected()) & mask);
+      } else {
+        fPairCutBits2.push_back(uint32_t(track.isMuonSelected()) & mask);
       }
-      if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
+    }
+
+    // same pairs and same order as combinations(tracks1, tracks2), i.e. strictly increasing positions in the two lists
+    const int n1 = fPairCutBits1.size();
+    const int n2 = fPairCutBits2.size();
+    for (int i1 = 0; i1 < n1; ++i1) {
+      if (!fPairCutBits1[i1]) {
         continue;
       }
-      constexpr bool eventHasQvector = ((TEventFillMap & VarManager::ObjTypes::ReducedEventQvector) > 0);
-
-      // TODO: FillPair functions need to provide a template argument to discriminate between cases when cov matrix is available or not
-      VarManager::FillPair<TPairType, TTrackFillMap>(t1, t2);
-      if constexpr ((TPairType == pairTypeEE) || (TPairType == pairTypeMuMu)) { // call this just for ee or mumu pairs
-        VarManager::FillPairVertexing<TPairType, TEventFillMap, TTrackFillMap>(event, t1, t2);
-        if constexpr (eventHasQvector) {
-          VarManager::FillPairVn<TPairType>(t1, t2);
+      for (int i2 = i1 + 1; i2 < n2; ++i2) {
+        twoTrackFilter = fPairCutBits1[i1] & fPairCutBits2[i2];
+        if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
+          continue;
+        }
+        auto const& t1 = compactTracks1[i1];
+        auto const& t2 = compactTracks2[i2];
+        constexpr bool eventHasQvector = ((TEventFillMap & VarManager::ObjTypes::ReducedEventQvector) > 0);
+
+        // TODO: FillPair functions need to provide a template argument to discriminate between cases when cov matrix is available or not
+        VarManager::FillPair<TPairType, TTrackFillMap>(t1, t2, fValues.Data());
+        if constexpr ((TPairType == pairTypeEE) || (TPairType == pairTypeMuMu)) { // call this just for ee or mumu pairs
+          VarManager::FillPairVertexing<TPairType, TEventFillMap, TTrackFillMap>(event, t1, t2, fValues.Data());
+          if constexpr (eventHasQvector) {
+            VarManager::FillPairVn<TPairType>(t1, t2, fValues.Data());
+          }
         }
-      }
 
-      // TODO: provide the type of pair to the dilepton table (e.g. ee, mumu, emu...)
-      dileptonFilterMap = twoTrackFilter;
-      dileptonList(event, VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt], VarManager::fgValues[VarManager::kEta], VarManager::fgValues[VarManager::kPhi], t1.sign() + t2.sign(), dileptonFilterMap, dileptonMcDecision);
+        // TODO: provide the type of pair to the dilepton table (e.g. ee, mumu, emu...)
+        dileptonFilterMap = twoTrackFilter;
+        dileptonList(event, fValues[VarManager::kMass], fValues[VarManager::kPt], fValues[VarManager::kEta], fValues[VarManager::kPhi], t1.sign() + t2.sign(), dileptonFilterMap, dileptonMcDecision);
 
-      constexpr bool muonHasCov = ((TTrackFillMap & VarManager::ObjTypes::MuonCov) > 0 || (TTrackFillMap & VarManager::ObjTypes::ReducedMuonCov) > 0);
-      if constexpr ((TPairType == pairTypeMuMu) && muonHasCov) {
-        dileptonExtraList(t1.globalIndex(), t2.globalIndex(), VarManager::fgValues[VarManager::kVertexingTauz], VarManager::fgValues[VarManager::kVertexingLz], VarManager::fgValues[VarManager::kVertexingLxy]);
-      }
+        constexpr bool muonHasCov = ((TTrackFillMap & VarManager::ObjTypes::MuonCov) > 0 || (TTrackFillMap & VarManager::ObjTypes::ReducedMuonCov) > 0);
+        if constexpr ((TPairType == pairTypeMuMu) && muonHasCov) {
+          dileptonExtraList(t1.globalIndex(), t2.globalIndex(), fValues[VarManager::kVertexingTauz], fValues[VarManager::kVertexingLz], fValues[VarManager::kVertexingLxy]);
+        }
 
-      if constexpr (eventHasQvector) {
-        dileptonFlowList(VarManager::fgValues[VarManager::kU2Q2], VarManager::fgValues[VarManager::kU3Q3], VarManager::fgValues[VarManager::kCos2DeltaPhi], VarManager::fgValues[VarManager::kCos3DeltaPhi]);
-      }
+        if constexpr (eventHasQvector) {
+          dileptonFlowList(fValues[VarManager::kU2Q2], fValues[VarManager::kU3Q3], fValues[VarManager::kCos2DeltaPhi], fValues[VarManager::kCos3DeltaPhi]);
+        }
 
-      for (unsigned int icut = 0; icut < ncuts; icut++) {
-        if (twoTrackFilter & (uint32_t(1) << icut)) {
-          if (t1.sign() * t2.sign() < 0) {
-            fHistMan->FillHistClass(histNames[icut][0].Data(), VarManager::fgValues);
-          } else {
-            if (t1.sign() > 0) {
-              fHistMan->FillHistClass(histNames[icut][1].Data(), VarManager::fgValues);
+        for (unsigned int icut = 0; icut < ncuts; icut++) {
+          if (twoTrackFilter & (uint32_t(1) << icut)) {
+            if (t1.sign() * t2.sign() < 0) {
+              fHistMan->FillHistClass(histIds[icut][0], fValues.Data());
             } else {
-              fHistMan->FillHistClass(histNames[icut][2].Data(), VarManager::fgValues);
+              if (t1.sign() > 0) {
+                fHistMan->FillHistClass(histIds[icut][1], fValues.Data());
+              } else {
+                fHistMan->FillHistClass(histIds[icut][2], fValues.Data());
+              }
             }
-          }
-        } // end if (filter bits)
-      }   // end for (cuts)
-    }     // end loop over pairs
+          } // end if (filter bits)
+        }   // end for (cuts)
+      }     // end loop over the second track
+    }       // end loop over pairs
   }
 
   void processDecayToEESkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyBarrelTracksSelected> const& tracks)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMap>(event, fValues.Data());
     runSameEventPairing<VarManager::kDecayToEE, gkEventFillMap, gkTrackFillMap>(event, tracks, tracks);
   }
+  // reads only the kinematics and the selection bits of the tracks, the pair variables needing the detector information are not filled
+  void processDecayToEESkimmedKine(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyBarrelTracksSelectedKine> const& tracks)
+  {
+    // Reset the fValues array
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMap>(event, fValues.Data());
+    runSameEventPairing<VarManager::kDecayToEE, gkEventFillMap, gkTrackFillMapKine>(event, tracks, tracks);
+  }
   void processDecayToMuMuSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyMuonTracksSelected> const& muons)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMap>(event, fValues.Data());
     runSameEventPairing<VarManager::kDecayToMuMu, gkEventFillMap, gkMuonFillMap>(event, muons, muons);
   }
   void processDecayToMuMuVertexingSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyMuonTracksSelectedWithCov> const& muons)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMap>(event, fValues.Data());
     runSameEventPairing<VarManager::kDecayToMuMu, gkEventFillMapWithCov, gkMuonFillMapWithCov>(event, muons, muons);
   }
   void processVnDecayToEESkimmed(soa::Filtered<MyEventsVtxCovSelectedQvector>::iterator const& event, soa::Filtered<MyBarrelTracksSelected> const& tracks)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMapWithCovQvector>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMapWithCovQvector>(event, fValues.Data());
     runSameEventPairing<VarManager::kDecayToEE, gkEventFillMapWithCovQvector, gkTrackFillMap>(event, tracks, tracks);
   }
   void processVnDecayToMuMuSkimmed(soa::Filtered<MyEventsVtxCovSelectedQvector>::iterator const& event, soa::Filtered<MyMuonTracksSelected> const& muons)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMapWithCovQvector>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMapWithCovQvector>(event, fValues.Data());
     runSameEventPairing<VarManager::kDecayToMuMu, gkEventFillMapWithCovQvector, gkMuonFillMap>(event, muons, muons);
   }
   void processElectronMuonSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyBarrelTracksSelected> const& tracks, soa::Filtered<MyMuonTracksSelected> const& muons)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMap>(event, fValues.Data());
     runSameEventPairing<VarManager::kElectronMuon, gkEventFillMap, gkTrackFillMap>(event, tracks, muons);
   }
   void processAllSkimmed(soa::Filtered<MyEventsVtxCovSelected>::iterator const& event, soa::Filtered<MyBarrelTracksSelected> const& tracks, soa::Filtered<MyMuonTracksSelected> const& muons)
   {
     // Reset the fValues array
-    VarManager::ResetValues(0, VarManager::kNVars);
-    VarManager::FillEvent<gkEventFillMap>(event, VarManager::fgValues);
+    fValues.Reset();
+    VarManager::FillEvent<gkEventFillMap>(event, fValues.Data());
     runSameEventPairing<VarManager::kDecayToEE, gkEventFillMap, gkTrackFillMap>(event, tracks, tracks);
     runSameEventPairing<VarManager::kDecayToMuMu, gkEventFillMap, gkMuonFillMap>(event, muons, muons);
     runSameEventPairing<VarManager::kElectronMuon, gkEventFillMap, gkTrackFillMap>(event, tracks, muons);
@@ -836,6 +909,7 @@ struct AnalysisSameEventPairing {
   }
 
   PROCESS_SWITCH(AnalysisSameEventPairing, processDecayToEESkimmed, "Run electron-electron pairing, with skimmed tracks", false);
+  PROCESS_SWITCH(AnalysisSameEventPairing, processDecayToEESkimmedKine, "Run electron-electron pairing, with skimmed tracks, reading only their kinematics and selection bits", false);
   PROCESS_SWITCH(AnalysisSameEventPairing, processDecayToMuMuSkimmed, "Run muon-muon pairing, with skimmed muons", false);
   PROCESS_SWITCH(AnalysisSameEventPairing, processDecayToMuMuVertexingSkimmed, "Run muon-muon pairing and vertexing, with skimmed muons", false);
   PROCESS_SWITCH(AnalysisSameEventPairing, processVnDecayToEESkimmed, "Run electron-electron pairing, with skimmed tracks for vn", false);
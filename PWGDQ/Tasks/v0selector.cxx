@@ -18,7 +18,7 @@
 //    Please write to: daiki.sekihata@cern.ch
 //
 #include <array>
-#include <map>
+#include <vector>
 #include "Math/Vector4D.h"
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
@@ -167,9 +167,12 @@ struct v0selector {
 
   int checkV0(const array<float, 3>& ppos, const array<float, 3>& pneg)
   {
-    float alpha = alphav0(ppos, pneg);
-    float qt = qtarmv0(ppos, pneg);
+    return checkV0(alphav0(ppos, pneg), qtarmv0(ppos, pneg));
+  }
 
+  // V0 hypothesis from the Armenteros-Podolanski variables
+  int checkV0(const float alpha, const float qt)
+  {
     // Gamma cuts
     const float cutAlphaG = 0.4;
     const float cutQTG = 0.03;
@@ -220,6 +223,100 @@ struct v0selector {
     return kUndef;
   }
 
+  template <typename TTrack>
+  bool isSelectedV0Daughter(TTrack const& track)
+  {
+    return fabs(track.eta()) < 0.9 && track.tpcNClsCrossedRows() >= mincrossedrows && track.tpcChi2NCl() <= maxchi2tpc &&
+           fabs(track.dcaXY()) >= dcamin && fabs(track.dcaXY()) <= dcamax && fabs(track.dcaZ()) <= 3.2;
+  }
+
+  template <typename TTrack>
+  bool isSelectedCascadeDaughter(TTrack const& track)
+  {
+    return fabs(track.eta()) < 0.9 && track.tpcNClsCrossedRows() >= mincrossedrows && track.tpcChi2NCl() <= maxchi2tpc &&
+           fabs(track.dcaXY()) >= 0.05 && fabs(track.dcaXY()) <= 2.4 && fabs(track.dcaZ()) <= 3.2;
+  }
+
+  // Tags the daughters of a V0 of hypothesis v0id passing the mass window and the TPC PID of the daughters,
+  // returns true for a clean photon conversion
+  template <typename TTrack>
+  bool tagV0(int v0id, TTrack const& pos, TTrack const& neg, float V0radius, float mGamma, float mK0S, float mLambda, float mAntiLambda)
+  {
+    if (v0id == kGamma) { // photon conversion
+      registry.fill(HIST("hMassGamma"), V0radius, mGamma);
+      if (mGamma < 0.04 && TMath::Abs(pos.tpcNSigmaEl()) < 5 && TMath::Abs(neg.tpcNSigmaEl()) < 5) {
+        pidmap[pos.globalIndex()] |= (uint8_t(1) << kGamma);
+        pidmap[neg.globalIndex()] |= (uint8_t(1) << kGamma);
+        return true;
+      }
+    } else if (v0id == kK0S) { // K0S-> pi pi
+      registry.fill(HIST("hMassK0S"), V0radius, mK0S);
+      if ((0.48 < mK0S && mK0S < 0.51) && TMath::Abs(pos.tpcNSigmaPi()) < 5 && TMath::Abs(neg.tpcNSigmaPi()) < 5) {
+        pidmap[pos.globalIndex()] |= (uint8_t(1) << kK0S);
+        pidmap[neg.globalIndex()] |= (uint8_t(1) << kK0S);
+      }
+    } else if (v0id == kLambda) { // L->p + pi-
+      registry.fill(HIST("hMassLambda"), V0radius, mLambda);
+      if ((1.110 < mLambda && mLambda < 1.120) && TMath::Abs(pos.tpcNSigmaPr()) < 5 && TMath::Abs(neg.tpcNSigmaPi()) < 5) {
+        pidmap[pos.globalIndex()] |= (uint8_t(1) << kLambda);
+        pidmap[neg.globalIndex()] |= (uint8_t(1) << kLambda);
+      }
+    } else if (v0id == kAntiLambda) { // Lbar -> pbar + pi+
+      registry.fill(HIST("hMassAntiLambda"), V0radius, mAntiLambda);
+      if ((1.110 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(pos.tpcNSigmaPi()) < 5 && TMath::Abs(neg.tpcNSigmaPr()) < 5) {
+        pidmap[pos.globalIndex()] |= (uint8_t(1) << kAntiLambda);
+        pidmap[neg.globalIndex()] |= (uint8_t(1) << kAntiLambda);
+      }
+    }
+    return false;
+  }
+
+  // Tags the bachelor of an Omega candidate whose V0 is of hypothesis v0id
+  template <typename TTrack>
+  void tagCascade(int v0id, TTrack const& pos, TTrack const& neg, TTrack const& bachelor, float mLambda, float mAntiLambda, float mXi, float mOmega)
+  {
+    // for Lambda->p + pi-
+    if (v0id == kLambda) {
+      registry.fill(HIST("hMassLambda_Casc"), mLambda);
+      if ((1.110 < mLambda && mLambda < 1.120) && TMath::Abs(pos.tpcNSigmaPr()) < 5 && TMath::Abs(neg.tpcNSigmaPi()) < 5) {
+        if (bachelor.sign() < 0) {
+          if (TMath::Abs(bachelor.tpcNSigmaPi()) < 5) {
+            registry.fill(HIST("hMassXiMinus"), mXi);
+          }
+
+          if (TMath::Abs(mXi - 1.321) > 0.006) {
+            if (TMath::Abs(bachelor.tpcNSigmaKa()) < 5) {
+              registry.fill(HIST("hMassOmegaMinus"), mOmega);
+              if (TMath::Abs(mOmega - 1.672) < 0.006) {
+                pidmap[bachelor.globalIndex()] |= (uint8_t(1) << kOmega);
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // for AntiLambda->pbar + pi+
+    if (v0id == kAntiLambda) {
+      registry.fill(HIST("hMassAntiLambda_Casc"), mAntiLambda);
+      if ((1.110 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(pos.tpcNSigmaPi()) < 5 && TMath::Abs(neg.tpcNSigmaPr()) < 5) {
+        if (bachelor.sign() > 0) {
+          if (TMath::Abs(bachelor.tpcNSigmaPi()) < 5) {
+            registry.fill(HIST("hMassXiPlus"), mXi);
+          }
+          if (TMath::Abs(mXi - 1.321) > 0.006) {
+            if (TMath::Abs(bachelor.tpcNSigmaKa()) < 5) {
+              registry.fill(HIST("hMassOmegaPlus"), mOmega);
+              if (TMath::Abs(mOmega - 1.672) < 0.006) {
+                pidmap[bachelor.globalIndex()] |= (uint8_t(1) << kOmega);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
   // Basic checks
   HistogramRegistry registry{
     "registry",
@@ -273,6 +370,7 @@ struct v0selector {
 
   int mRunNumber;
   float d_bz;
+  std::vector<uint8_t> pidmap; // V0 bits per track of the dataframe
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
   void init(InitContext& context)
@@ -318,76 +416,32 @@ struct v0selector {
     }
   }
 
-  void process(aod::Collisions const&, aod::BCsWithTimestamps const&, FullTracksExt const& tracks, aod::V0s const& V0s, aod::Cascades const& Cascades)
+  void processRefit(aod::Collisions const&, aod::BCsWithTimestamps const&, FullTracksExt const& tracks, aod::V0s const& V0s, aod::Cascades const& Cascades)
   {
     registry.fill(HIST("hEventCounter"), 0.5);
 
-    std::map<int, uint8_t> pidmap;
+    pidmap.assign(tracks.size(), 0);
 
     for (auto& V0 : V0s) {
-      // if (!(V0.posTrack_as<FullTracksExt>().trackType() & o2::aod::track::TPCrefit)) {
-      //   continue;
-      // }
-      // if (!(V0.negTrack_as<FullTracksExt>().trackType() & o2::aod::track::TPCrefit)) {
-      //   continue;
-      // }
+      auto const& posTrack = V0.posTrack_as<FullTracksExt>();
+      auto const& negTrack = V0.negTrack_as<FullTracksExt>();
 
-      // printf("V0.collisionId = %d , collision.globalIndex = %d\n",V0.collisionId(),collision.globalIndex());
-
-      if (fabs(V0.posTrack_as<FullTracksExt>().eta()) > 0.9) {
-        continue;
-      }
-      if (fabs(V0.negTrack_as<FullTracksExt>().eta()) > 0.9) {
+      if (!isSelectedV0Daughter(posTrack) || !isSelectedV0Daughter(negTrack)) {
         continue;
       }
 
-      if (V0.posTrack_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
-        continue;
-      }
-      if (V0.negTrack_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
+      if (posTrack.sign() * negTrack.sign() > 0) { // reject same sign pair
         continue;
       }
 
-      if (V0.posTrack_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
-        continue;
-      }
-      if (V0.negTrack_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
-        continue;
-      }
-
-      if (fabs(V0.posTrack_as<FullTracksExt>().dcaXY()) < dcamin) {
-        continue;
-      }
-      if (fabs(V0.negTrack_as<FullTracksExt>().dcaXY()) < dcamin) {
+      if (posTrack.collisionId() != negTrack.collisionId()) {
         continue;
       }
 
-      if (fabs(V0.posTrack_as<FullTracksExt>().dcaXY()) > dcamax) {
+      if (!posTrack.has_collision() || !negTrack.has_collision()) {
         continue;
       }
-      if (fabs(V0.negTrack_as<FullTracksExt>().dcaXY()) > dcamax) {
-        continue;
-      }
-
-      if (fabs(V0.posTrack_as<FullTracksExt>().dcaZ()) > 3.2) {
-        continue;
-      }
-      if (fabs(V0.negTrack_as<FullTracksExt>().dcaZ()) > 3.2) {
-        continue;
-      }
-
-      if (V0.posTrack_as<FullTracksExt>().sign() * V0.negTrack_as<FullTracksExt>().sign() > 0) { // reject same sign pair
-        continue;
-      }
-
-      if (V0.posTrack_as<FullTracksExt>().collisionId() != V0.negTrack_as<FullTracksExt>().collisionId()) {
-        continue;
-      }
-
-      if (!V0.posTrack_as<FullTracksExt>().has_collision() || !V0.negTrack_as<FullTracksExt>().has_collision()) {
-        continue;
-      }
-      auto const& collision = V0.posTrack_as<FullTracksExt>().collision();
+      auto const& collision = posTrack.collision();
       auto bc = collision.bc_as<aod::BCsWithTimestamps>();
       CheckAndUpdate(bc.runNumber(), bc.timestamp());
       // Define o2 fitter, 2-prong
@@ -411,15 +465,15 @@ struct v0selector {
       std::array<float, 3> pvec0 = {0.};
       std::array<float, 3> pvec1 = {0.};
 
-      int cpos = V0.posTrack_as<FullTracksExt>().sign();
-      int cneg = V0.negTrack_as<FullTracksExt>().sign();
+      int cpos = posTrack.sign();
+      int cneg = negTrack.sign();
 
-      auto pTrack = getTrackParCov(V0.posTrack_as<FullTracksExt>());
-      auto nTrack = getTrackParCov(V0.negTrack_as<FullTracksExt>());
+      auto pTrack = getTrackParCov(posTrack);
+      auto nTrack = getTrackParCov(negTrack);
 
       if (cpos < 0) { // swap charge
-        nTrack = getTrackParCov(V0.posTrack_as<FullTracksExt>());
-        pTrack = getTrackParCov(V0.negTrack_as<FullTracksExt>());
+        nTrack = getTrackParCov(posTrack);
+        pTrack = getTrackParCov(negTrack);
       }
 
       int nCand = fitter.process(pTrack, nTrack);
@@ -448,10 +502,10 @@ struct v0selector {
 
       registry.fill(HIST("hV0Pt"), pt);
       registry.fill(HIST("hV0EtaPhi"), phi, eta);
-      registry.fill(HIST("hDCAxyPosToPV"), V0.posTrack_as<FullTracksExt>().dcaXY());
-      registry.fill(HIST("hDCAxyNegToPV"), V0.negTrack_as<FullTracksExt>().dcaXY());
-      registry.fill(HIST("hDCAzPosToPV"), V0.posTrack_as<FullTracksExt>().dcaZ());
-      registry.fill(HIST("hDCAzNegToPV"), V0.negTrack_as<FullTracksExt>().dcaZ());
+      registry.fill(HIST("hDCAxyPosToPV"), posTrack.dcaXY());
+      registry.fill(HIST("hDCAxyNegToPV"), negTrack.dcaXY());
+      registry.fill(HIST("hDCAzPosToPV"), posTrack.dcaZ());
+      registry.fill(HIST("hDCAzNegToPV"), negTrack.dcaZ());
 
       registry.fill(HIST("hV0Radius"), V0radius);
       registry.fill(HIST("hV0CosPA"), V0CosinePA);
@@ -471,120 +525,38 @@ struct v0selector {
 
       float alpha = alphav0(pvec0, pvec1);
       float qtarm = qtarmv0(pvec0, pvec1);
-      float phiv = phivv0(pvec0, pvec1, cpos, cneg, d_bz);
-      float psipair = psipairv0(pvec0, pvec1, d_bz);
 
       registry.fill(HIST("hV0APplot"), alpha, qtarm);
 
-      float mGamma = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kElectron), RecoDecay::getMassPDG(kElectron)});
-      float mK0S = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kPiPlus)});
-      float mLambda = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
-      float mAntiLambda = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
-
-      int v0id = checkV0(pvec0, pvec1);
+      int v0id = checkV0(alpha, qtarm);
       if (v0id < 0) {
         // printf("This is not [Gamma/K0S/Lambda/AntiLambda] candidate.\n");
         continue;
       }
 
-      if (v0id == kGamma) { // photon conversion
-        registry.fill(HIST("hMassGamma"), V0radius, mGamma);
-        if (mGamma < 0.04 && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaEl()) < 5 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaEl()) < 5) {
-          pidmap[V0.posTrackId()] |= (uint8_t(1) << kGamma);
-          pidmap[V0.negTrackId()] |= (uint8_t(1) << kGamma);
-          registry.fill(HIST("hV0PhiV"), phiv, mGamma);
-          registry.fill(HIST("hV0Psi"), psipair, mGamma);
-          v0Gamma(V0.negTrack_as<FullTracksExt>().collisionId(), pt, eta, phi, mGamma);
-        }
-      } else if (v0id == kK0S) { // K0S-> pi pi
-        registry.fill(HIST("hMassK0S"), V0radius, mK0S);
-        if ((0.48 < mK0S && mK0S < 0.51) && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaPi()) < 5 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaPi()) < 5) {
-          pidmap[V0.posTrackId()] |= (uint8_t(1) << kK0S);
-          pidmap[V0.negTrackId()] |= (uint8_t(1) << kK0S);
-        }
-      } else if (v0id == kLambda) { // L->p + pi-
-        registry.fill(HIST("hMassLambda"), V0radius, mLambda);
-        if (v0id == kLambda && (1.110 < mLambda && mLambda < 1.120) && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaPr()) < 5 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaPi()) < 5) {
-          pidmap[V0.posTrackId()] |= (uint8_t(1) << kLambda);
-          pidmap[V0.negTrackId()] |= (uint8_t(1) << kLambda);
-        }
-      } else if (v0id == kAntiLambda) { // Lbar -> pbar + pi+
-        registry.fill(HIST("hMassAntiLambda"), V0radius, mAntiLambda);
-        if ((1.110 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(V0.posTrack_as<FullTracksExt>().tpcNSigmaPi()) < 5 && TMath::Abs(V0.negTrack_as<FullTracksExt>().tpcNSigmaPr()) < 5) {
-          pidmap[V0.posTrackId()] |= (uint8_t(1) << kAntiLambda);
-          pidmap[V0.negTrackId()] |= (uint8_t(1) << kAntiLambda);
-        }
-      }
-
-      // printf("posTrackId = %d\n",V0.posTrackId());
-      // printf("negTrackId = %d\n",V0.negTrackId());
+      float mGamma = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kElectron), RecoDecay::getMassPDG(kElectron)});
+      float mK0S = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kPiPlus)});
+      float mLambda = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
+      float mAntiLambda = RecoDecay::m(array{pvec0, pvec1}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
 
+      if (tagV0(v0id, posTrack, negTrack, V0radius, mGamma, mK0S, mLambda, mAntiLambda)) {
+        registry.fill(HIST("hV0PhiV"), phivv0(pvec0, pvec1, cpos, cneg, d_bz), mGamma);
+        registry.fill(HIST("hV0Psi"), psipairv0(pvec0, pvec1, d_bz), mGamma);
+        v0Gamma(negTrack.collisionId(), pt, eta, phi, mGamma);
+      }
     } // end of V0 loop
 
     // cascade loop
     for (auto& casc : Cascades) {
       registry.fill(HIST("hCascCandidate"), 0.5);
       auto v0 = casc.v0_as<aod::V0s>();
-      if (v0.posTrack_as<FullTracksExt>().sign() * v0.negTrack_as<FullTracksExt>().sign() > 0) { // reject same sign pair
+      auto const& posTrack = v0.posTrack_as<FullTracksExt>();
+      auto const& negTrack = v0.negTrack_as<FullTracksExt>();
+      auto const& bachelor = casc.bachelor_as<FullTracksExt>();
+      if (posTrack.sign() * negTrack.sign() > 0) { // reject same sign pair
         continue;
       }
-      if (v0.posTrack_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
-        continue;
-      }
-      if (v0.negTrack_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
-        continue;
-      }
-      if (casc.bachelor_as<FullTracksExt>().tpcNClsCrossedRows() < mincrossedrows) {
-        continue;
-      }
-
-      if (v0.posTrack_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
-        continue;
-      }
-      if (v0.negTrack_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
-        continue;
-      }
-      if (casc.bachelor_as<FullTracksExt>().tpcChi2NCl() > maxchi2tpc) {
-        continue;
-      }
-
-      if (fabs(v0.posTrack_as<FullTracksExt>().dcaXY()) < 0.05) {
-        continue;
-      }
-      if (fabs(v0.negTrack_as<FullTracksExt>().dcaXY()) < 0.05) {
-        continue;
-      }
-      if (fabs(casc.bachelor_as<FullTracksExt>().dcaXY()) < 0.05) {
-        continue;
-      }
-
-      if (fabs(v0.posTrack_as<FullTracksExt>().dcaXY()) > 2.4) {
-        continue;
-      }
-      if (fabs(v0.negTrack_as<FullTracksExt>().dcaXY()) > 2.4) {
-        continue;
-      }
-      if (fabs(casc.bachelor_as<FullTracksExt>().dcaXY()) > 2.4) {
-        continue;
-      }
-
-      if (fabs(v0.posTrack_as<FullTracksExt>().dcaZ()) > 3.2) {
-        continue;
-      }
-      if (fabs(v0.negTrack_as<FullTracksExt>().dcaZ()) > 3.2) {
-        continue;
-      }
-      if (fabs(casc.bachelor_as<FullTracksExt>().dcaZ()) > 3.2) {
-        continue;
-      }
-
-      if (fabs(v0.posTrack_as<FullTracksExt>().eta()) > 0.9) {
-        continue;
-      }
-      if (fabs(v0.negTrack_as<FullTracksExt>().eta()) > 0.9) {
-        continue;
-      }
-      if (fabs(casc.bachelor_as<FullTracksExt>().eta()) > 0.9) {
+      if (!isSelectedCascadeDaughter(posTrack) || !isSelectedCascadeDaughter(negTrack) || !isSelectedCascadeDaughter(bachelor)) {
         continue;
       }
 
@@ -592,11 +564,11 @@ struct v0selector {
         continue;
       }
 
-      if (!v0.posTrack_as<FullTracksExt>().has_collision() || !v0.negTrack_as<FullTracksExt>().has_collision() || !casc.bachelor_as<FullTracksExt>().has_collision()) {
+      if (!posTrack.has_collision() || !negTrack.has_collision() || !bachelor.has_collision()) {
         continue;
       }
 
-      auto const& collision = casc.bachelor_as<FullTracksExt>().collision();
+      auto const& collision = bachelor.collision();
       if (casc.collisionId() != collision.globalIndex()) {
         continue;
       }
@@ -630,20 +602,15 @@ struct v0selector {
       std::array<float, 3> pvecneg = {0.};
       std::array<float, 3> pvecbach = {0.};
 
-      int cpos = casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>().sign();
-      int cneg = casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>().sign();
+      int cpos = posTrack.sign();
 
-      if (cpos * cneg > 0) { // reject same sign pair
-        continue;
-      }
-
-      auto pTrack = getTrackParCov(casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>());
-      auto nTrack = getTrackParCov(casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>());
-      auto bTrack = getTrackParCov(casc.bachelor_as<FullTracksExt>());
+      auto pTrack = getTrackParCov(posTrack);
+      auto nTrack = getTrackParCov(negTrack);
+      auto bTrack = getTrackParCov(bachelor);
 
       if (cpos < 0) { // swap charge
-        pTrack = getTrackParCov(casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>());
-        nTrack = getTrackParCov(casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>());
+        pTrack = getTrackParCov(negTrack);
+        nTrack = getTrackParCov(posTrack);
       }
 
       int nCand = fitterV0.process(pTrack, nTrack);
@@ -730,54 +697,149 @@ struct v0selector {
       float mXi = RecoDecay::m(array{pvecv0, pvecbach}, array{RecoDecay::getMassPDG(kLambda0), RecoDecay::getMassPDG(kPiPlus)});
       float mOmega = RecoDecay::m(array{pvecv0, pvecbach}, array{RecoDecay::getMassPDG(kLambda0), RecoDecay::getMassPDG(kKPlus)});
 
-      // for Lambda->p + pi-
-      if (v0id == kLambda) {
-        registry.fill(HIST("hMassLambda_Casc"), mLambda);
-        if ((1.110 < mLambda && mLambda < 1.120) && TMath::Abs(casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>().tpcNSigmaPr()) < 5 && TMath::Abs(casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>().tpcNSigmaPi()) < 5) {
-          if (casc.bachelor_as<FullTracksExt>().sign() < 0) {
-            if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaPi()) < 5) {
-              registry.fill(HIST("hMassXiMinus"), mXi);
-            }
+      tagCascade(v0id, posTrack, negTrack, bachelor, mLambda, mAntiLambda, mXi, mOmega);
+    } // end of cascades loop
 
-            if (TMath::Abs(mXi - 1.321) > 0.006) {
-              if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaKa()) < 5) {
-                registry.fill(HIST("hMassOmegaMinus"), mOmega);
-                if (TMath::Abs(mOmega - 1.672) < 0.006) {
-                  pidmap[casc.bachelorId()] |= (uint8_t(1) << kOmega);
-                }
-              }
-            }
-          }
-        }
+    for (auto& track : tracks) {
+      v0bits(pidmap[track.globalIndex()]);
+    } // end of track loop
+
+  } // end of process
+
+  // Same selection on the V0s and cascades of the LF builders, without refitting them: the V0 cuts of the builders
+  // apply in addition to the ones of this task
+  void processV0Datas(aod::Collisions const&, aod::BCsWithTimestamps const&, FullTracksExt const& tracks, aod::V0Datas const& V0s, aod::CascDataExt const& Cascades)
+  {
+    registry.fill(HIST("hEventCounter"), 0.5);
+
+    pidmap.assign(tracks.size(), 0);
+
+    for (auto& V0 : V0s) {
+      auto const& posTrack = V0.posTrack_as<FullTracksExt>();
+      auto const& negTrack = V0.negTrack_as<FullTracksExt>();
+
+      if (!isSelectedV0Daughter(posTrack) || !isSelectedV0Daughter(negTrack)) {
+        continue;
       }
+      if (posTrack.sign() * negTrack.sign() > 0) { // reject same sign pair
+        continue;
+      }
+      if (posTrack.collisionId() != negTrack.collisionId() || V0.collisionId() != posTrack.collisionId() || !posTrack.has_collision()) {
+        continue;
+      }
+      registry.fill(HIST("hV0Candidate"), 0.5);
 
-      // for AntiLambda->pbar + pi+
-      if (v0id == kAntiLambda) {
-        registry.fill(HIST("hMassAntiLambda_Casc"), mAntiLambda);
-        if ((1.110 < mAntiLambda && mAntiLambda < 1.120) && TMath::Abs(casc.v0_as<aod::V0s>().posTrack_as<FullTracksExt>().tpcNSigmaPi()) < 5 && TMath::Abs(casc.v0_as<aod::V0s>().negTrack_as<FullTracksExt>().tpcNSigmaPr()) < 5) {
-          if (casc.bachelor_as<FullTracksExt>().sign() > 0) {
-            if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaPi()) < 5) {
-              registry.fill(HIST("hMassXiPlus"), mXi);
-            }
-            if (TMath::Abs(mXi - 1.321) > 0.006) {
-              if (TMath::Abs(casc.bachelor_as<FullTracksExt>().tpcNSigmaKa()) < 5) {
-                registry.fill(HIST("hMassOmegaPlus"), mOmega);
-                if (TMath::Abs(mOmega - 1.672) < 0.006) {
-                  pidmap[casc.bachelorId()] |= (uint8_t(1) << kOmega);
-                }
-              }
-            }
-          }
-        }
+      auto const& collision = V0.collision();
+      const float pt = V0.pt();
+      const float eta = V0.eta();
+      const float phi = V0.phi();
+      const float V0dca = V0.dcaV0daughters();
+      const float V0CosinePA = V0.v0cosPA(collision.posX(), collision.posY(), collision.posZ());
+      const float V0radius = V0.v0radius();
+
+      registry.fill(HIST("hV0Pt"), pt);
+      registry.fill(HIST("hV0EtaPhi"), phi, eta);
+      registry.fill(HIST("hDCAxyPosToPV"), posTrack.dcaXY());
+      registry.fill(HIST("hDCAxyNegToPV"), negTrack.dcaXY());
+      registry.fill(HIST("hDCAzPosToPV"), posTrack.dcaZ());
+      registry.fill(HIST("hDCAzNegToPV"), negTrack.dcaZ());
+
+      registry.fill(HIST("hV0Radius"), V0radius);
+      registry.fill(HIST("hV0CosPA"), V0CosinePA);
+      registry.fill(HIST("hDCAV0Dau"), V0dca);
+
+      if (V0dca > dcav0dau || V0CosinePA < v0cospa || V0radius < v0Rmin || v0Rmax < V0radius) {
+        continue;
       }
+
+      const float alpha = V0.alpha();
+      const float qtarm = V0.qtarm();
+      registry.fill(HIST("hV0APplot"), alpha, qtarm);
+
+      int v0id = checkV0(alpha, qtarm);
+      if (v0id < 0) {
+        continue;
+      }
+
+      const float mGamma = V0.mGamma();
+      if (v0id == kGamma) { // the field is only needed for phiV
+        auto bc = collision.bc_as<aod::BCsWithTimestamps>();
+        CheckAndUpdate(bc.runNumber(), bc.timestamp());
+      }
+      if (tagV0(v0id, posTrack, negTrack, V0radius, mGamma, V0.mK0Short(), V0.mLambda(), V0.mAntiLambda())) {
+        const std::array<float, 3> pvec0 = {V0.pxpos(), V0.pypos(), V0.pzpos()};
+        const std::array<float, 3> pvec1 = {V0.pxneg(), V0.pyneg(), V0.pzneg()};
+        registry.fill(HIST("hV0PhiV"), phivv0(pvec0, pvec1, posTrack.sign(), negTrack.sign(), d_bz), mGamma);
+        registry.fill(HIST("hV0Psi"), psipairv0(pvec0, pvec1, d_bz), mGamma);
+        v0Gamma(negTrack.collisionId(), pt, eta, phi, mGamma);
+      }
+    } // end of V0 loop
+
+    // cascade loop
+    for (auto& casc : Cascades) {
+      registry.fill(HIST("hCascCandidate"), 0.5);
+      auto v0 = casc.v0_as<aod::V0s>();
+      auto const& posTrack = v0.posTrack_as<FullTracksExt>();
+      auto const& negTrack = v0.negTrack_as<FullTracksExt>();
+      auto const& bachelor = casc.bachelor_as<FullTracksExt>();
+      if (posTrack.sign() * negTrack.sign() > 0) { // reject same sign pair
+        continue;
+      }
+      if (!isSelectedCascadeDaughter(posTrack) || !isSelectedCascadeDaughter(negTrack) || !isSelectedCascadeDaughter(bachelor)) {
+        continue;
+      }
+      if (v0.collisionId() != casc.collisionId() || bachelor.collisionId() != casc.collisionId() || !bachelor.has_collision()) {
+        continue;
+      }
+
+      auto const& collision = casc.collision();
+      const float V0dca = casc.dcaV0daughters();
+      registry.fill(HIST("hDCAV0Dau_Casc"), V0dca);
+      if (V0dca > 1.5) {
+        continue;
+      }
+      registry.fill(HIST("hCascCandidate"), 1.5);
+
+      int v0id = checkV0(array{casc.pxpos(), casc.pypos(), casc.pzpos()}, array{casc.pxneg(), casc.pyneg(), casc.pzneg()});
+      if (v0id != kLambda && v0id != kAntiLambda) {
+        continue;
+      }
+
+      const float V0CosinePA = casc.v0cosPA(collision.posX(), collision.posY(), collision.posZ());
+      registry.fill(HIST("hV0CosPA_Casc"), V0CosinePA);
+      if (V0CosinePA < 0.97) {
+        continue;
+      }
+      registry.fill(HIST("hCascCandidate"), 2.5);
+
+      const float Cascdca = casc.dcacascdaughters();
+      registry.fill(HIST("hDCACascDau"), Cascdca);
+      if (Cascdca > 1.5) {
+        continue;
+      }
+
+      const float CascCosinePA = casc.casccosPA(collision.posX(), collision.posY(), collision.posZ());
+      registry.fill(HIST("hCascCosPA"), CascCosinePA);
+      if (CascCosinePA < 0.98) {
+        continue;
+      }
+
+      // the Lambda mass of the cascade tables follows the bachelor charge, the hypothesis here follows the V0
+      const std::array<float, 3> pvecpos = {casc.pxpos(), casc.pypos(), casc.pzpos()};
+      const std::array<float, 3> pvecneg = {casc.pxneg(), casc.pyneg(), casc.pzneg()};
+      float mLambda = RecoDecay::m(array{pvecpos, pvecneg}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
+      float mAntiLambda = RecoDecay::m(array{pvecpos, pvecneg}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
+
+      tagCascade(v0id, posTrack, negTrack, bachelor, mLambda, mAntiLambda, casc.mXi(), casc.mOmega());
     } // end of cascades loop
 
     for (auto& track : tracks) {
-      // printf("setting pidmap[%lld] = %d\n",track.globalIndex(),pidmap[track.globalIndex()]);
       v0bits(pidmap[track.globalIndex()]);
     } // end of track loop
+  }
 
-  } // end of process
+  PROCESS_SWITCH(v0selector, processRefit, "Select the V0s and cascades refitting them", true);
+  PROCESS_SWITCH(v0selector, processV0Datas, "Select the V0s and cascades of the LF V0 and cascade builders", false);
 };
 
 struct trackPIDQA {
@@ -40,6 +40,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Centrality.h"
 #include "Common/CCDB/TriggerAliases.h"
+#include "PWGEM/Dilepton/Utils/pairEfficiencyMap.h"
 
 using std::cout;
 using std::endl;
@@ -49,6 +50,7 @@ using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 using namespace o2::aod;
+using o2::analysis::dilepton::PairEfficiencyMap;
 
 // Some definitions
 namespace o2::aod
@@ -800,7 +802,7 @@ struct AnalysisTrackSelection {
           continue;
         }
         for (unsigned int j = 0; j < fTrackCuts.size(); j++) {
-          if (filterMap & (uint8_t(1) << j)) {
+          if (filterMap & (uint32_t(1) << j)) {
             if (track.sign() < 0) {
               dynamic_cast<TH3D*>(fHistRecNegPart.at(j * fMCSignals.size() + i))->Fill(track.pt(), track.eta(), track.phi());
             } else {
@@ -936,6 +938,12 @@ struct AnalysisSameEventPairing {
   Configurable<double> fConfigMaxMee{"cfgMaxMee", 3.5, "max Mee in 2D histos"};
   Configurable<int> fConfigStepMee{"cfgStepMee", 600, "Nb of steps in Mee in 2D histos"};
 
+  // Pair efficiency maps: all the cuts and MC signals in a single histogram, with the pair DCA
+  Configurable<bool> fConfigPairEffMap{"cfgPairEffMap", false, "If true, fill the pair efficiency maps (cut, signal, pair type, mee, ptee, DCAee) instead of the 2D histos per cut and signal"};
+  Configurable<double> fConfigMinDCAee{"cfgMinDCAee", 0., "min DCAee in the pair efficiency maps"};
+  Configurable<double> fConfigMaxDCAee{"cfgMaxDCAee", 1., "max DCAee in the pair efficiency maps"};
+  Configurable<int> fConfigStepDCAee{"cfgStepDCAee", 50, "Nb of steps in DCAee in the pair efficiency maps"};
+
   // output lists
   OutputObj<THashList> fOutputList{"output"};
   THashList* fMainList;   // Main list
@@ -952,9 +960,15 @@ struct AnalysisSameEventPairing {
   std::vector<TH2D*> fHistGenSmearedPair;
   std::vector<TH2D*> fHistRecPair;
   std::vector<TH2D*> fHistRecPairMC;
+  // Pair efficiency maps
+  PairEfficiencyMap fGenPairMap;
+  PairEfficiencyMap fRecPairMap;
+  PairEfficiencyMap fRecPairMCMap;
+  uint32_t fTrackCutsMask = 0; // bits of the configured track cuts
   // Binning
   std::vector<double> fPteeBins;
   std::vector<double> fMeeBins;
+  std::vector<double> fDCAeeBins;
 
   // QA: to be defined
 
@@ -990,6 +1004,10 @@ struct AnalysisSameEventPairing {
         fTrackCuts.push_back(*dqcuts::GetCompositeCut(objArray->At(icut)->GetName()));
       }
     }
+    if (fTrackCuts.size() > 32) {
+      LOGF(fatal, "%d track cuts given, at most 32 supported by the track selection bit map", fTrackCuts.size());
+    }
+    fTrackCutsMask = fTrackCuts.size() == 32 ? ~uint32_t(0) : (uint32_t(1) << fTrackCuts.size()) - 1;
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
     VarManager::SetDefaultVarNames();
 
@@ -1005,6 +1023,30 @@ struct AnalysisSameEventPairing {
         // List of signal to be checked
       }
     }
+    if (fMCSignals.size() > 32) {
+      LOGF(fatal, "%d MC signals given, at most 32 supported by the MC decision bit map", fMCSignals.size());
+    }
+
+    if (fConfigPairEffMap) {
+      SetBinsLinear(fDCAeeBins, fConfigMinDCAee, fConfigMaxDCAee, fConfigStepDCAee);
+      std::vector<TString> cutNames;
+      for (auto& cut : fTrackCuts) {
+        cutNames.push_back(cut.GetName());
+      }
+      std::vector<TString> signalNames;
+      for (auto& sig : fMCSignals) {
+        signalNames.push_back(sig.GetName());
+      }
+      TList* maps = new TList();
+      maps->SetName("PairEfficiencyMaps");
+      maps->SetOwner();
+      maps->Add(fGenPairMap.create("Ngen_Pair", {"generated"}, signalNames, fMeeBins, fPteeBins));
+      maps->Add(fRecPairMap.create("Nrec_Pair", cutNames, signalNames, fMeeBins, fPteeBins, fDCAeeBins));
+      if (fConfigRecWithMC) {
+        maps->Add(fRecPairMCMap.create("Nrec_Pair_MCVars", cutNames, signalNames, fMeeBins, fPteeBins, fDCAeeBins));
+      }
+      fPairList->Add(maps);
+    }
 
     // Configure 2D histograms
     // Create List with generated particles
@@ -1044,8 +1086,8 @@ struct AnalysisSameEventPairing {
     fPairList->Add(Generated);
     fPairList->Add(GeneratedSmeared);
 
-    // Rec with reconstructed variables
-    for (unsigned int list_i = 0; list_i < fTrackCuts.size(); ++list_i) {
+    // Rec with reconstructed variables, replaced by the pair efficiency maps if enabled
+    for (unsigned int list_i = 0; list_i < (fConfigPairEffMap ? 0 : fTrackCuts.size()); ++list_i) {
       TList* list = new TList();
       list->SetName(fTrackCuts.at(list_i).GetName());
       list->SetOwner();
@@ -1068,7 +1110,7 @@ struct AnalysisSameEventPairing {
     }
 
     // Rec with MC variables
-    if (fConfigRecWithMC) {
+    if (fConfigRecWithMC && !fConfigPairEffMap) {
       for (unsigned int list_i = 0; list_i < fTrackCuts.size(); ++list_i) {
         TList* list = new TList();
         list->SetName(Form("%s_MCVars", fTrackCuts.at(list_i).GetName()));
@@ -1178,8 +1220,10 @@ struct AnalysisSameEventPairing {
         genfidcut = kFALSE;
 
       int isig = 0;
+      uint32_t mcDecision = 0;
       for (auto sig = fMCSignals.begin(); sig != fMCSignals.end(); sig++, isig++) {
         if ((*sig).CheckSignal(true, groupedMCTracks, t1, t2)) {
+          mcDecision |= (uint32_t(1) << isig);
 
           // not smeared after fiducial cuts
           if (genfidcut) {
@@ -1196,6 +1240,9 @@ struct AnalysisSameEventPairing {
           // need to implement smeared
         }
       }
+      if (fConfigPairEffMap && genfidcut) {
+        fGenPairMap.fill(1u, mcDecision, t1.pdgCode() * t2.pdgCode() < 0 ? PairEfficiencyMap::kULS : PairEfficiencyMap::kLS, mass, pairpt);
+      }
     } // end of true pairing loop
   }   // end runMCGen
   template <uint32_t TTrackFillMap, typename TTracks, typename TTracksMC>
@@ -1206,7 +1253,7 @@ struct AnalysisSameEventPairing {
     Bool_t uls = kTRUE;
 
     // Loop over two track combinations
-    uint8_t twoTrackFilter = 0;
+    uint32_t twoTrackFilter = 0;
     // uint32_t dileptonFilterMap = 0;
     // uint32_t dileptonMcDecision = 0;
     // dileptonList.reserve(1);
@@ -1214,7 +1261,7 @@ struct AnalysisSameEventPairing {
     for (auto& [t1, t2] : combinations(soa::CombinationsStrictlyUpperIndexPolicy(tracks, tracks))) {
       // for (auto& [t1, t2] : combinations(tracks, tracks)) {
 
-      twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isBarrelSelected());
+      twoTrackFilter = uint32_t(t1.isBarrelSelected()) & uint32_t(t2.isBarrelSelected()) & fTrackCutsMask;
 
       if (!twoTrackFilter) { // the tracks must have at least one filter bit in common to continue
         continue;
@@ -1253,13 +1300,39 @@ struct AnalysisSameEventPairing {
       // dileptonMcDecision = mcDecision;
       // dileptonList(event, VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt], VarManager::fgValues[VarManager::kEta], VarManager::fgValues[VarManager::kPhi], t1.sign() + t2.sign(), dileptonFilterMap, dileptonMcDecision);
 
+      // all the cuts and signals of the pair at once
+      if (fConfigPairEffMap) {
+        if (!mcDecision) {
+          continue;
+        }
+        const int pairType = uls ? PairEfficiencyMap::kULS : PairEfficiencyMap::kLS;
+        const double pairDCA = std::sqrt((t1.dcaXY() * t1.dcaXY() + t2.dcaXY() * t2.dcaXY()) / 2.);
+        if (recfidcut) {
+          fRecPairMap.fill(twoTrackFilter, mcDecision, pairType, VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt], pairDCA);
+        }
+        if (fConfigRecWithMC) {
+          if constexpr ((TTrackFillMap & VarManager::ObjTypes::ReducedTrack) > 0) {
+            auto mctrack1 = t1.reducedMCTrack();
+            auto mctrack2 = t2.reducedMCTrack();
+            TLorentzVector Lvec2, Lvec1;
+            Lvec1.SetPtEtaPhiM(mctrack1.pt(), mctrack1.eta(), mctrack1.phi(), masse);
+            Lvec2.SetPtEtaPhiM(mctrack2.pt(), mctrack2.eta(), mctrack2.phi(), masse);
+            TLorentzVector LvecM = Lvec1 + Lvec2;
+            if (!((mctrack1.eta() > fConfigMaxEta) || (mctrack2.eta() > fConfigMaxEta) || (mctrack1.eta() < fConfigMinEta) || (mctrack2.eta() < fConfigMinEta) || (mctrack1.pt() > fConfigMaxPt) || (mctrack2.pt() > fConfigMaxPt) || (mctrack1.pt() < fConfigMinPt) || (mctrack2.pt() < fConfigMinPt))) {
+              fRecPairMCMap.fill(twoTrackFilter, mcDecision, pairType, LvecM.M(), LvecM.Pt(), pairDCA);
+            }
+          }
+        }
+        continue;
+      }
+
       for (unsigned int i = 0; i < fMCSignals.size(); i++) {
         if (!(mcDecision & (uint32_t(1) << i))) {
           continue;
         }
         if (recfidcut) {
           for (unsigned int j = 0; j < fTrackCuts.size(); j++) {
-            if (twoTrackFilter & (uint8_t(1) << j)) {
+            if (twoTrackFilter & (uint32_t(1) << j)) {
               if (!fConfigFillLS) {
                 dynamic_cast<TH2D*>(fHistRecPair.at(j * fMCSignals.size() + i))->Fill(VarManager::fgValues[VarManager::kMass], VarManager::fgValues[VarManager::kPt]);
               } else {
@@ -1292,7 +1365,7 @@ struct AnalysisSameEventPairing {
           }
           if (genfidcut) {
             for (unsigned int j = 0; j < fTrackCuts.size(); j++) {
-              if (twoTrackFilter & (uint8_t(1) << j)) {
+              if (twoTrackFilter & (uint32_t(1) << j)) {
                 if (!fConfigFillLS) {
                   dynamic_cast<TH2D*>(fHistRecPairMC.at(j * fMCSignals.size() + i))->Fill(mass, pairpt);
                 } else {
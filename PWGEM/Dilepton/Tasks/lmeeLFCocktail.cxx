@@ -19,14 +19,15 @@
 #include "Framework/Logger.h"
 #include "Math/Vector4D.h"
 #include "Math/Vector3D.h"
+#include "Math/Boost.h"
 #include "TFile.h"
 #include "TF1.h"
-#include "TRandom.h"
 #include "TDatabasePDG.h"
-#include "TGenPhaseSpace.h"
+#include "PWGEM/Dilepton/Utils/cocktailSampler.h"
 
 using namespace o2;
 using namespace o2::framework;
+using namespace o2::analysis::dilepton;
 using namespace ROOT::Math;
 
 namespace o2::aod
@@ -101,19 +102,19 @@ struct lmeelfcocktail {
   TH1F* fhwMultpT2;
   TH1F* fhwMultmT2;
   TH1F* fhKW;
-  TF1* ffVPHpT;
-  TObjArray* fArr;
-  TObjArray* fArrResoPt;
-  TObjArray* fArrResoEta;
-  TObjArray* fArrResoPhi_Pos;
-  TObjArray* fArrResoPhi_Neg;
+  TF1* ffVPHpT = nullptr;
+  TObjArray* fArr = nullptr;
+  TObjArray* fArrResoPt = nullptr;
+  TObjArray* fArrResoEta = nullptr;
+  TObjArray* fArrResoPhi_Pos = nullptr;
+  TObjArray* fArrResoPhi_Neg = nullptr;
 
   std::vector<std::shared_ptr<TH1>> fmee_orig, fmotherpT_orig, fphi_orig, frap_orig, fmee_orig_wALT, fmotherpT_orig_wALT, fmee, fphi, frap, fmee_wALT;
   std::vector<std::shared_ptr<TH2>> fpteevsmee_wALT, fpteevsmee_orig_wALT, fpteevsmee_orig, fpteevsmee;
 
   std::vector<double> DCATemplateEdges;
   int nbDCAtemplate;
-  TH1F** fh_DCAtemplates;
+  TH1F** fh_DCAtemplates = nullptr;
 
   Configurable<int> fCollisionSystem{"cfgCollisionSystem", 200, "set the collision system"};
   Configurable<bool> fConfigWriteTTree{"cfgWriteTTree", false, "whether tree output should be written"};
@@ -158,6 +159,8 @@ struct lmeelfcocktail {
   Configurable<std::string> fConfigPhotonPtFileName{"cfgPhotonPtFileName", "", "file name for photon pT parametrization"};
   Configurable<std::string> fConfigPhotonPtDirName{"cfgPhotonPtDirName", "7TeV_Comb", "directory name for photon pT parametrization"};
   Configurable<std::string> fConfigPhotonPtFuncName{"cfgPhotonPtFuncName", "111_pt", "function name for photon pT parametrization"};
+  Configurable<int> fConfigNPointsPhotonPt{"cfgNPointsPhotonPt", 1000, "number of points of the sampling table of the photon pT parametrization"};
+  Configurable<int> fConfigSamplerSeed{"cfgSamplerSeed", 0, "seed of the random numbers, the draws of a collision only depend on the seed and on the collision index"};
 
   ConfigurableAxis fConfigPtBins{"cfgPtBins", {0., 0.5, 1, 1.5, 2., 2.5, 3., 3.5, 4., 4.5, 5., 5.5, 6., 6.5, 7., 7.5, 8.}, "pT bins"};
   ConfigurableAxis fConfigMBins{"cfgMBins", {0., 0.08, 0.14, 0.2, 1.1, 2.7, 2.8, 3.2, 5.0}, "mee bins"};
@@ -185,13 +188,55 @@ struct lmeelfcocktail {
     GetMultHisto(TString(fConfigMultFileName), TString(fConfigMultHistPtName), TString(fConfigMultHistPt2Name), TString(fConfigMultHistMtName), TString(fConfigMultHistMt2Name));
     GetPhotonPtParametrization(TString(fConfigPhotonPtFileName), TString(fConfigPhotonPtDirName), TString(fConfigPhotonPtFuncName));
     fillKrollWada();
+
+    // sampling tables of the templates, resolution maps and parametrizations, built once
+    fSampler.rng().setSeed(fConfigSamplerSeed);
+    fSampler.setResolutionType(fConfigResolType);
+    if (fConfigResolType == CocktailSampler::kMomentumSmearing) {
+      fSampler.setMomentumResolution(fArr);
+    } else if (fConfigResolType == CocktailSampler::kPtEtaPhiSmearing) {
+      fSampler.setPtEtaPhiResolution(fArrResoPt, fArrResoEta, fArrResoPhi_Pos, fArrResoPhi_Neg);
+    }
+    if (fh_DCAtemplates) {
+      fSampler.setDcaTemplates(DCATemplateEdges, std::vector<TH1*>(fh_DCAtemplates, fh_DCAtemplates + nbDCAtemplate));
+    }
+    if (!fVPHpTTable.build(ffVPHpT, fConfigNPointsPhotonPt)) {
+      LOGP(error, "No photon pT parametrization, no virtual photon is generated");
+    }
+    fKWTable.build(fhKW);
   }
 
-  void processCocktail(aod::McCollision const&, aod::McParticles const& mcParticles)
+  /// Dielectron decay of a cocktail mother, or virtual photon, before the smearing of its legs
+  struct CocktailDecay {
+    PxPyPzEVector dau1, dau2; // legs before resolution effects
+    std::size_t iLeg1, iLeg2; // legs in fLeptons
+    Int_t hindex[3];
+    int dectyp;
+    int dau3pdg;
+    double weight;
+    double motherpt, motherm, motherp, mothereta, motherphi;
+    int ID;
+    bool isVirtualPhoton;
+  };
+  std::vector<CocktailDecay> fDecays;
+  LeptonStore fLeptons;
+  CocktailSampler fSampler;
+  InverseCdf fVPHpTTable;
+  InverseCdf fKWTable;
+
+  void processCocktail(aod::McCollision const& mcCollision, aod::McParticles const& mcParticles)
   {
 
-    double fwEffpT, fd1origpt, fd1origp, fd1origeta, fd1origphi, fd2origpt, fd2origp, fd2origeta, fd2origphi, feeorigpt, feeorigp, feeorigm, feeorigeta, feeorigphi, feeorigphiv, fpairDCA, fd1DCA, fd2DCA, fd1pt, fd1p, fd1eta, fd1phi, fd2pt, fd2p, fd2eta, fd2phi, feept, feemt, feep, feem, feeeta, feephi, feephiv, fmotherpt, fmothermt, fmotherp, fmotherm, fmothereta, fmotherphi, fID, fweight, fwMultpT, fwMultpT2, fwMultmT, fwMultmT2;
+    double fwEffpT, fd1origpt, fd1origp, fd1origeta, fd1origphi, fd2origpt, fd2origp, fd2origeta, fd2origphi, feeorigpt, feeorigp, feeorigm, feeorigeta, feeorigphi, feeorigphiv, fpairDCA, fd1DCA = 0., fd2DCA = 0., fd1pt, fd1p, fd1eta, fd1phi, fd2pt, fd2p, fd2eta, fd2phi, feept, feemt, feep, feem, feeeta, feephi, feephiv, fmotherpt, fmothermt, fmotherp, fmotherm, fmothereta, fmotherphi, fID, fweight, fwMultpT = 0., fwMultpT2 = 0., fwMultmT, fwMultmT2 = 0.;
     bool fpass;
+    int fdectyp = 0;
+    int fdau3pdg = 0;
+
+    // the draws of a collision only depend on the seed and on the collision
+    fSampler.rng().setStream(mcCollision.globalIndex());
+    fDecays.clear();
+    fLeptons.clear();
+    const double emass = (TDatabasePDG::Instance()->GetParticle(11))->Mass();
 
     Partition<aod::McParticles> Mothers = ((aod::mcparticle::pdgCode == 111) || (aod::mcparticle::pdgCode == 221) || (aod::mcparticle::pdgCode == 331) || (aod::mcparticle::pdgCode == 113) || (aod::mcparticle::pdgCode == 223) || (aod::mcparticle::pdgCode == 333) || (aod::mcparticle::pdgCode == 443));
     Mothers.bindTable(mcParticles);
@@ -202,29 +247,30 @@ struct lmeelfcocktail {
       if (mother.has_mothers())
         continue;
 
-      int fdectyp = 0;
-      int fdau3pdg = 0;
+      CocktailDecay decay{};
+      decay.dectyp = 0;
+      decay.dau3pdg = 0;
       bool has_e = false;
       bool has_p = false;
-      PxPyPzEVector dau1, dau2, ee, ee_orig;
+      PxPyPzEVector dau1, dau2;
 
       for (auto& d : mother.daughters_as<aod::McParticles>()) {
-        fdectyp++;
+        decay.dectyp++;
         if (d.pdgCode() == 11) {
           has_e = true;
           dau1.SetPxPyPzE(d.px(), d.py(), d.pz(), d.e());
-          fweight = d.weight(); // get particle weight from generator
+          decay.weight = d.weight(); // get particle weight from generator
         } else if (d.pdgCode() == -11) {
           has_p = true;
           dau2.SetPxPyPzE(d.px(), d.py(), d.pz(), d.e());
         } else {
-          fdau3pdg = d.pdgCode();
+          decay.dau3pdg = d.pdgCode();
         }
       }
       if ((!has_e) || (!has_p))
         continue;
 
-      if (fdectyp > 4)
+      if (decay.dectyp > 4)
         continue; // here dectype==4 is included, but when filling histograms it is excluded?
 
       // Not sure about this cut. From GammaConv group. Harmless a priori.
@@ -244,12 +290,8 @@ struct lmeelfcocktail {
           continue;
       }
 
-      // create dielectron before resolution effects:
-      ee = dau1 + dau2;
-      ee_orig = ee;
-
       // get index for histograms
-      Int_t hindex[3];
+      Int_t* hindex = decay.hindex;
       for (Int_t jj = 0; jj < 3; jj++) {
         hindex[jj] = -1;
       }
@@ -262,9 +304,9 @@ struct lmeelfcocktail {
           break;
         case 331:
           hindex[0] = 2;
-          if (fdectyp == 3 && fdau3pdg == 22)
+          if (decay.dectyp == 3 && decay.dau3pdg == 22)
             hindex[1] = 3;
-          if (fdectyp == 3 && fdau3pdg == 223)
+          if (decay.dectyp == 3 && decay.dau3pdg == 223)
             hindex[1] = 4;
           break;
         case 113:
@@ -272,25 +314,25 @@ struct lmeelfcocktail {
           break;
         case 223:
           hindex[0] = 6;
-          if (fdectyp == 2)
+          if (decay.dectyp == 2)
             hindex[1] = 7;
-          if (fdectyp == 3 && fdau3pdg == 111)
+          if (decay.dectyp == 3 && decay.dau3pdg == 111)
             hindex[1] = 8;
           break;
         case 333:
           hindex[0] = 9;
-          if (fdectyp == 2)
+          if (decay.dectyp == 2)
             hindex[1] = 10;
-          if (fdectyp == 3 && fdau3pdg == 221)
+          if (decay.dectyp == 3 && decay.dau3pdg == 221)
             hindex[1] = 11;
-          if (fdectyp == 3 && fdau3pdg == 111)
+          if (decay.dectyp == 3 && decay.dau3pdg == 111)
             hindex[1] = 12;
           break;
         case 443:
           hindex[0] = 13;
-          if (fdectyp == 2)
+          if (decay.dectyp == 2)
             hindex[1] = 14;
-          if (fdectyp == 3 && fdau3pdg == 22)
+          if (decay.dectyp == 3 && decay.dau3pdg == 22)
             hindex[1] = 15;
           break;
       }
@@ -302,6 +344,76 @@ struct lmeelfcocktail {
         continue;
       }
 
+      decay.dau1 = dau1;
+      decay.dau2 = dau2;
+      decay.iLeg1 = fLeptons.push(dau1, -1);
+      decay.iLeg2 = fLeptons.push(dau2, 1);
+      decay.motherpt = mother.pt();
+      decay.motherm = sqrt(pow(mother.e(), 2) + pow(mother.p(), 2)); // run2: GetCalcMass() ??
+      decay.motherp = mother.p();
+      decay.mothereta = mother.eta();
+      decay.motherphi = mother.phi();
+      decay.ID = mother.pdgCode();
+      decay.isVirtualPhoton = false;
+      fDecays.push_back(decay);
+
+      // Virtual photon generation
+      //-------------------------
+      // We will generate one virtual photon per histogrammed pion
+      if (mother.pdgCode() == 111 && !fVPHpTTable.empty()) {
+        // get mass and pt from histos and flat eta and phi
+        auto& rng = fSampler.rng();
+        Double_t VPHpT = fVPHpTTable.sample(rng.uniform());
+        Double_t VPHmass = fKWTable.sample(rng.uniform());
+        Double_t VPHeta = -1. + rng.uniform() * 2.;
+        Double_t VPHphi = 2.0 * TMath::ACos(-1.) * rng.uniform();
+        PxPyPzEVector beam(PtEtaPhiMVector(VPHpT, VPHeta, VPHphi, VPHmass));
+        if (VPHmass < 2. * emass) {
+          LOGP(error, "decay not permitted by kinematics");
+        }
+        // isotropic two-body decay in the rest frame, of weight 1
+        Double_t pStar = sqrt(std::max(0.25 * VPHmass * VPHmass - emass * emass, 0.));
+        Double_t cosTheta = 2. * rng.uniform() - 1.;
+        Double_t sinTheta = sqrt(1. - cosTheta * cosTheta);
+        Double_t phiStar = 2.0 * TMath::ACos(-1.) * rng.uniform();
+        PxPyPzEVector decay1(pStar * sinTheta * cos(phiStar), pStar * sinTheta * sin(phiStar), pStar * cosTheta, 0.5 * VPHmass);
+        PxPyPzEVector decay2(-decay1.Px(), -decay1.Py(), -decay1.Pz(), 0.5 * VPHmass);
+        Boost toLab(beam.Px() / beam.E(), beam.Py() / beam.E(), beam.Pz() / beam.E());
+
+        CocktailDecay photon{};
+        photon.dau1 = toLab(decay1);
+        photon.dau2 = toLab(decay2);
+        photon.iLeg1 = fLeptons.push(photon.dau1, 1);
+        photon.iLeg2 = fLeptons.push(photon.dau2, -1);
+        // get index for histograms
+        photon.hindex[0] = nInputParticles - 1;
+        photon.hindex[1] = -1;
+        photon.hindex[2] = -1;
+        photon.weight = 1.;
+        photon.motherpt = beam.Pt();
+        photon.motherm = beam.M();
+        photon.motherp = beam.P();
+        photon.mothereta = beam.Eta();
+        photon.motherphi = beam.Phi();
+        photon.ID = 0; // set ID to Zero for VPH
+        photon.isVirtualPhoton = true;
+        fDecays.push_back(photon);
+      }
+    }
+
+    // Resolution and DCA of all the legs of the collision (DCA based on smeared pT)
+    fSampler.smear(fLeptons);
+    fSampler.drawDca(fLeptons);
+
+    for (auto const& decay : fDecays) {
+      const Int_t* hindex = decay.hindex;
+      PxPyPzEVector dau1 = decay.dau1;
+      PxPyPzEVector dau2 = decay.dau2;
+
+      // create dielectron before resolution effects:
+      PxPyPzEVector ee = dau1 + dau2;
+      PxPyPzEVector ee_orig = ee;
+
       // Fill tree words before resolution/acceptance
       fd1origpt = dau1.Pt();
       fd1origp = dau1.P();
@@ -325,8 +437,10 @@ struct lmeelfcocktail {
       fwEffpT = fwEffpT * fhwEffpT->GetBinContent(effbin);
 
       // Resolution and acceptance
-      dau1 = ApplyResolution(dau1, -1, fConfigResolType);
-      dau2 = ApplyResolution(dau2, 1, fConfigResolType);
+      if (fConfigResolType != CocktailSampler::kNoSmearing) {
+        dau1 = fLeptons.get(decay.iLeg1, emass);
+        dau2 = fLeptons.get(decay.iLeg2, emass);
+      }
       fpass = true;
       if (dau1.Pt() < fConfigMinPt || dau2.Pt() < fConfigMinPt)
         fpass = false; // leg pT cut
@@ -337,16 +451,16 @@ struct lmeelfcocktail {
       if (TMath::Abs(dau1.Eta()) > fConfigMaxEta || TMath::Abs(dau2.Eta()) > fConfigMaxEta)
         fpass = false;
 
-      // get the pair DCA (based in smeared pT)
-      for (int jj = 0; jj < nbDCAtemplate; jj++) { // loop over DCA templates
-        if (dau1.Pt() >= DCATemplateEdges[jj] && dau1.Pt() < DCATemplateEdges[jj + 1]) {
-          fd1DCA = fh_DCAtemplates[jj]->GetRandom();
-        }
-        if (dau2.Pt() >= DCATemplateEdges[jj] && dau2.Pt() < DCATemplateEdges[jj + 1]) {
-          fd2DCA = fh_DCAtemplates[jj]->GetRandom();
-        }
+      // get the pair DCA
+      if (!decay.isVirtualPhoton) {
+        fd1DCA = fLeptons.dca[decay.iLeg1];
+        fd2DCA = fLeptons.dca[decay.iLeg2];
+        fpairDCA = sqrt((pow(fd1DCA, 2) + pow(fd2DCA, 2)) / 2);
+        fdectyp = decay.dectyp;
+        fdau3pdg = decay.dau3pdg;
+      } else {
+        fpairDCA = 10000.; // ??
       }
-      fpairDCA = sqrt((pow(fd1DCA, 2) + pow(fd2DCA, 2)) / 2);
 
       // Fill tree words after resolution/acceptance
       ee = dau1 + dau2;
@@ -365,13 +479,41 @@ struct lmeelfcocktail {
       feeeta = ee.Eta();
       feephi = ee.Phi();
       feephiv = PhiV(dau1, dau2);
-      fmotherpt = mother.pt();
-      fmotherm = sqrt(pow(mother.e(), 2) + pow(mother.p(), 2)); // run2: GetCalcMass() ??
+      fmotherpt = decay.motherpt;
+      fmotherm = decay.motherm;
       fmothermt = sqrt(pow(fmotherm, 2) + pow(fmotherpt, 2));
-      fmotherp = mother.p();
-      fmothereta = mother.eta();
-      fmotherphi = mother.phi();
-      fID = mother.pdgCode();
+      fmotherp = decay.motherp;
+      fmothereta = decay.mothereta;
+      fmotherphi = decay.motherphi;
+      fID = decay.ID;
+      fweight = decay.weight;
+
+      if (decay.isVirtualPhoton) {
+        // get multiplicity based weight:
+        fwMultmT = 1; // no weight for photons so far
+
+        // Fill the tree
+        if (fConfigWriteTTree) { // many parameters not set for photons: d1DCA,fd2DCA, fdectyp,fdau3pdg,fwMultpT,fwMultpT2,fwMultmT2
+          tree(fd1DCA, fd2DCA, fpairDCA, fd1origpt, fd1origp, fd1origeta, fd1origphi, fd2origpt, fd2origp, fd2origeta, fd2origphi, fd1pt, fd1p, fd1eta, fd1phi, fd2pt, fd2p, fd2eta, fd2phi, feeorigpt, feeorigp, feeorigm, feeorigeta, feeorigphi, feeorigphiv, feept, feemt, feep, feem, feeeta, feephi, feephiv, fmotherpt, fmothermt, fmotherp, fmotherm, fmothereta, fmotherphi, fID, fdectyp, fdau3pdg, fweight, fwEffpT, fwMultpT, fwMultmT, fwMultpT2, fwMultmT2, fpass);
+        }
+
+        // Fill the histograms
+        for (Int_t jj = 0; jj < 3; jj++) { // fill the different hindex -> particles
+          if (hindex[jj] > -1) {
+            fmee_orig[hindex[jj]]->Fill(ee_orig.M(), fweight);
+            fpteevsmee_orig[hindex[jj]]->Fill(ee_orig.M(), ee.Pt(), fweight);
+            fphi_orig[hindex[jj]]->Fill(ee_orig.Phi(), fweight);
+            frap_orig[hindex[jj]]->Fill(ee_orig.Rapidity(), fweight);
+            if (fpass) {
+              fmee[hindex[jj]]->Fill(ee.M(), fweight);
+              fpteevsmee[hindex[jj]]->Fill(ee.M(), ee.Pt(), fweight);
+              fphi[hindex[jj]]->Fill(ee.Phi(), fweight);
+              frap[hindex[jj]]->Fill(ee.Rapidity(), fweight);
+            }
+          }
+        }
+        continue;
+      }
 
       // get multiplicity based weight:
       int iwbin = fhwMultpT->FindBin(fmotherpt);
@@ -437,129 +579,6 @@ struct lmeelfcocktail {
           }
         }
       }
-
-      // Virtual photon generation
-      //-------------------------
-      // We will generate one virtual photon per histogrammed pion
-      if (mother.pdgCode() == 111) {
-        // get mass and pt from histos and flat eta and phi
-        Double_t VPHpT = ffVPHpT->GetRandom();
-        Double_t VPHmass = fhKW->GetRandom();
-        Double_t VPHeta = -1. + gRandom->Rndm() * 2.;
-        Double_t VPHphi = 2.0 * TMath::ACos(-1.) * gRandom->Rndm();
-        TLorentzVector beam;
-        beam.SetPtEtaPhiM(VPHpT, VPHeta, VPHphi, VPHmass);
-        Double_t decaymasses[2] = {(TDatabasePDG::Instance()->GetParticle(11))->Mass(), (TDatabasePDG::Instance()->GetParticle(11))->Mass()};
-        TGenPhaseSpace VPHgen;
-        Bool_t SetDecay;
-        SetDecay = VPHgen.SetDecay(beam, 2, decaymasses);
-        if (SetDecay == 0) {
-          LOGP(error, "decay not permitted by kinematics");
-        }
-        Double_t VPHweight = VPHgen.Generate();
-        // get electrons from the decay
-        TLorentzVector *decay1, *decay2;
-        decay1 = VPHgen.GetDecay(0);
-        decay2 = VPHgen.GetDecay(1);
-        dau1.SetPxPyPzE(decay1->Px(), decay1->Py(), decay1->Pz(), decay1->E());
-        dau2.SetPxPyPzE(decay2->Px(), decay2->Py(), decay2->Pz(), decay2->E());
-
-        // create dielectron before resolution effects:
-        ee = dau1 + dau2;
-        ee_orig = ee;
-
-        // get index for histograms
-        hindex[0] = nInputParticles - 1;
-        hindex[1] = -1;
-        hindex[2] = -1;
-
-        // Fill tree words before resolution/acceptance
-        fd1origpt = dau1.Pt();
-        fd1origp = dau1.P();
-        fd1origeta = dau1.Eta();
-        fd1origphi = dau1.Phi();
-        fd2origpt = dau2.Pt();
-        fd2origp = dau2.P();
-        fd2origeta = dau2.Eta();
-        fd2origphi = dau2.Phi();
-        feeorigpt = ee.Pt();
-        feeorigp = ee.P();
-        feeorigm = ee.M();
-        feeorigeta = ee.Eta();
-        feeorigphi = ee.Phi();
-        feeorigphiv = PhiV(dau1, dau2);
-
-        // get the efficiency weight
-        Int_t effbin = fhwEffpT->FindBin(dau1.Pt());
-        fwEffpT = fhwEffpT->GetBinContent(effbin);
-        effbin = fhwEffpT->FindBin(dau2.Pt());
-        fwEffpT = fwEffpT * fhwEffpT->GetBinContent(effbin);
-
-        // Resolution and acceptance
-        //-------------------------
-        dau1 = ApplyResolution(dau1, 1, fConfigResolType);
-        dau2 = ApplyResolution(dau2, -1, fConfigResolType);
-        fpass = true;
-        if (dau1.Pt() < fConfigMinPt || dau2.Pt() < fConfigMinPt)
-          fpass = false; // leg pT cut
-        if (dau1.Pt() > fConfigMaxPt || dau2.Pt() > fConfigMaxPt)
-          fpass = false; // leg pT cut
-        if (dau1.Vect().Unit().Dot(dau2.Vect().Unit()) > TMath::Cos(fConfigMinOpAng))
-          fpass = false; // opening angle cut
-        if (TMath::Abs(dau1.Eta()) > fConfigMaxEta || TMath::Abs(dau2.Eta()) > fConfigMaxEta)
-          fpass = false;
-
-        fpairDCA = 10000.; // ??
-
-        // Fill tree words after resolution/acceptance
-        ee = dau1 + dau2;
-        fd1pt = dau1.Pt();
-        fd1p = dau1.P();
-        fd1eta = dau1.Eta();
-        fd1phi = dau1.Phi();
-        fd2pt = dau2.Pt();
-        fd2p = dau2.P();
-        fd2eta = dau2.Eta();
-        fd2phi = dau2.Phi();
-        feept = ee.Pt();
-        feemt = ee.Mt();
-        feep = ee.P();
-        feem = ee.M();
-        feeeta = ee.Eta();
-        feephi = ee.Phi();
-        feephiv = PhiV(dau1, dau2);
-        fmotherpt = beam.Pt();
-        fmothermt = sqrt(pow(beam.M(), 2) + pow(beam.Pt(), 2));
-        fmotherp = beam.P();
-        fmotherm = beam.M();
-        fmothereta = beam.Eta();
-        fmotherphi = beam.Phi();
-        fID = 0; // set ID to Zero for VPH
-        fweight = VPHweight;
-        // get multiplicity based weight:
-        fwMultmT = 1; // no weight for photons so far
-
-        // Fill the tree
-        if (fConfigWriteTTree) { // many parameters not set for photons: d1DCA,fd2DCA, fdectyp,fdau3pdg,fwMultpT,fwMultpT2,fwMultmT2
-          tree(fd1DCA, fd2DCA, fpairDCA, fd1origpt, fd1origp, fd1origeta, fd1origphi, fd2origpt, fd2origp, fd2origeta, fd2origphi, fd1pt, fd1p, fd1eta, fd1phi, fd2pt, fd2p, fd2eta, fd2phi, feeorigpt, feeorigp, feeorigm, feeorigeta, feeorigphi, feeorigphiv, feept, feemt, feep, feem, feeeta, feephi, feephiv, fmotherpt, fmothermt, fmotherp, fmotherm, fmothereta, fmotherphi, fID, fdectyp, fdau3pdg, fweight, fwEffpT, fwMultpT, fwMultmT, fwMultpT2, fwMultmT2, fpass);
-        }
-
-        // Fill the histograms
-        for (Int_t jj = 0; jj < 3; jj++) { // fill the different hindex -> particles
-          if (hindex[jj] > -1) {
-            fmee_orig[hindex[jj]]->Fill(ee_orig.M(), VPHweight);
-            fpteevsmee_orig[hindex[jj]]->Fill(ee_orig.M(), ee.Pt(), VPHweight);
-            fphi_orig[hindex[jj]]->Fill(ee_orig.Phi(), VPHweight);
-            frap_orig[hindex[jj]]->Fill(ee_orig.Rapidity(), VPHweight);
-            if (fpass) {
-              fmee[hindex[jj]]->Fill(ee.M(), VPHweight);
-              fpteevsmee[hindex[jj]]->Fill(ee.M(), ee.Pt(), VPHweight);
-              fphi[hindex[jj]]->Fill(ee.Phi(), VPHweight);
-              frap[hindex[jj]]->Fill(ee.Rapidity(), VPHweight);
-            }
-          }
-        }
-      }
     }
   }
 
@@ -634,97 +653,6 @@ struct lmeelfcocktail {
     fpteevsmee_orig_wALT.push_back(registry.add<TH2>("pteevsmee_orig_wALT", "pteevsmee_orig_wALT", HistType::kTH2F, {mAxis, ptAxis}, true));
   }
 
-  PxPyPzEVector ApplyResolution(PxPyPzEVector vec, Char_t ch = 0, Int_t Run = 2)
-  {
-
-    Double_t theta, phi, pt, p, px, py, pz, E, mass, eta;
-    PxPyPzEVector resvec;
-
-    mass = 0.51099906e-3;
-    pt = vec.Pt();
-    p = vec.P();
-    theta = vec.Theta();
-    phi = vec.Phi();
-    eta = vec.Eta();
-
-    if (Run == 0) {
-      resvec = vec;
-    } else if (Run == 1) {
-      TH1D* hisSlice(nullptr);
-      if (fArr) {
-        TH2D* hDeltaPtvsPt = static_cast<TH2D*>(fArr->At(0));
-        // Get the momentum slice histogram for sampling of the smearing
-        // (in some input file versions this also contains a landau fit )
-        // since histogram bins start at 1, we can use the bin number directly for the array index (first slice stored in position 1).
-        Int_t histIndex = hDeltaPtvsPt->GetXaxis()->FindBin(pt);
-        if (histIndex < 1)
-          histIndex = 1; // in case some track is below the first p-bin (which currently starts at 100 MeV).
-        if (histIndex > fArr->GetLast()) {
-          histIndex = fArr->GetLast();
-        }
-        hisSlice = static_cast<TH1D*>(fArr->At(histIndex));
-      }
-      // get smear parameter via random selection from the p slices retreived from the deltaP/P plot
-      Double_t SmearingPPercent(0.);
-      if (hisSlice) {
-        SmearingPPercent = hisSlice->GetRandom();
-      } else {
-        SmearingPPercent = gRandom->Gaus(0, p * sqrt(0.004 * 0.004 + (0.012 * p) * (0.012 * p))) / p; // for B=0.5 Tesla
-      }
-
-      Double_t SmearingP = p * SmearingPPercent;
-      p -= SmearingP;
-      px = p * sin(theta) * cos(phi);
-      py = p * sin(theta) * sin(phi);
-      pz = p * cos(theta);
-      E = sqrt(p * p + mass * mass);
-
-      resvec.SetPxPyPzE(px, py, pz, E);
-
-    } else if (Run == 2) {
-      // smear pt
-      Int_t ptbin = reinterpret_cast<TH2D*>(fArrResoPt->At(0))->GetXaxis()->FindBin(pt);
-      if (ptbin < 1)
-        ptbin = 1;
-      if (ptbin > fArrResoPt->GetLast())
-        ptbin = fArrResoPt->GetLast();
-      Double_t smearing = reinterpret_cast<TH1D*>(fArrResoPt->At(ptbin))->GetRandom() * pt;
-      Double_t sPt = pt - smearing;
-
-      // smear eta
-      ptbin = reinterpret_cast<TH2D*>(fArrResoEta->At(0))->GetXaxis()->FindBin(pt);
-      if (ptbin < 1)
-        ptbin = 1;
-      if (ptbin > fArrResoEta->GetLast())
-        ptbin = fArrResoEta->GetLast();
-      smearing = reinterpret_cast<TH1D*>(fArrResoEta->At(ptbin))->GetRandom();
-      Double_t sEta = eta - smearing;
-
-      // smear phi
-      ptbin = reinterpret_cast<TH2D*>(fArrResoPhi_Pos->At(0))->GetXaxis()->FindBin(pt);
-      if (ptbin < 1)
-        ptbin = 1;
-      if (ptbin > fArrResoPhi_Pos->GetLast())
-        ptbin = fArrResoPhi_Pos->GetLast();
-      if (ch > 0) {
-        smearing = reinterpret_cast<TH1D*>(fArrResoPhi_Pos->At(ptbin))->GetRandom();
-      } else if (ch < 0) {
-        smearing = reinterpret_cast<TH1D*>(fArrResoPhi_Neg->At(ptbin))->GetRandom();
-      }
-      Double_t sPhi = phi - smearing;
-
-      Double_t sPx = sPt * cos(sPhi);
-      Double_t sPy = sPt * sin(sPhi);
-      Double_t sPz = sPt * sinh(sEta);
-      Double_t sP = sPt * cosh(sEta);
-      Double_t sE = sqrt(sP * sP + mass * mass);
-
-      resvec.SetPxPyPzE(sPx, sPy, sPz, sE);
-    }
-
-    return resvec;
-  }
-
   void GetEffHisto(TString filename, TString histname)
   {
     // get efficiency histo
@@ -845,7 +773,7 @@ struct lmeelfcocktail {
       LOGP(error, "Could not open DCATemplate file {}", fFileNameLocal.Data());
       return;
     }
-    fh_DCAtemplates = new TH1F*[nbDCAtemplate];
+    fh_DCAtemplates = new TH1F*[nbDCAtemplate]();
     for (int jj = 0; jj < nbDCAtemplate; jj++) {
       if (fFile->GetListOfKeys()->Contains(Form("%s%d", histname.Data(), jj + 1))) {
         fh_DCAtemplates[jj] = reinterpret_cast<TH1F*>(fFile->Get(Form("%s%d", histname.Data(), jj + 1)));
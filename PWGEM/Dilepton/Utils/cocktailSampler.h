@@ -0,0 +1,366 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file cocktailSampler.h
+/// \brief Random sampling of the lepton smearing and DCA for the dilepton cocktail
+///
+/// The DCA templates, the resolution maps and the parametrizations of the cocktail are converted once into
+/// inverse-CDF tables, so that a draw is a binary search in a cumulative array instead of a TH1::GetRandom or
+/// TF1::GetRandom call. The random numbers come from a counter-based generator: the n-th number of a stream only
+/// depends on the seed, the stream (e.g. the collision index) and n, so that the output is reproducible whatever
+/// the thread or the order in which the collisions are processed. The legs of all the decays of a collision are
+/// smeared together over contiguous arrays, with the uniform numbers drawn in batches.
+
+#ifndef PWGEM_DILEPTON_UTILS_COCKTAILSAMPLER_H_
+#define PWGEM_DILEPTON_UTILS_COCKTAILSAMPLER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Framework/Logger.h"
+#include "Math/Vector4D.h"
+#include "TF1.h"
+#include "TH1.h"
+#include "TObjArray.h"
+
+namespace o2::analysis::dilepton
+{
+
+/// Counter-based random number generator, the numbers of a stream are hashes of (seed, stream, counter)
+class CounterRng
+{
+ public:
+  void setSeed(uint64_t seed) { mSeed = seed; }
+
+  /// Starts the stream with the given key, e.g. the index of the collision
+  void setStream(uint64_t stream)
+  {
+    mStreamKey = mix(mSeed ^ mix(stream + kGolden));
+    mCounter = 0;
+  }
+
+  uint64_t next() { return mix(mStreamKey + kGolden * ++mCounter); }
+
+  /// Uniform number in [0, 1)
+  double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+  void uniform(double* values, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; i++) {
+      values[i] = uniform();
+    }
+  }
+
+  /// Gaussian number, Box-Muller
+  double gaus(double mean, double sigma)
+  {
+    const double u1 = 1. - uniform(); // in (0, 1]
+    const double u2 = uniform();
+    return mean + sigma * std::sqrt(-2. * std::log(u1)) * std::cos(2. * M_PI * u2);
+  }
+
+ private:
+  static constexpr uint64_t kGolden = 0x9e3779b97f4a7c15ULL;
+
+  /// SplitMix64 finalizer
+  static uint64_t mix(uint64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t mSeed{0};
+  uint64_t mStreamKey{0};
+  uint64_t mCounter{0};
+};
+
+/// Inverse cumulative distribution of a binned density, sampled as TH1::GetRandom: bin from the cumulative sum,
+/// then uniform inside the bin
+class InverseCdf
+{
+ public:
+  /// \param edges n + 1 bin edges
+  /// \param weights n non-negative bin contents
+  /// \return false if there is no positive content
+  bool build(std::vector<double> const& edges, std::vector<double> const& weights)
+  {
+    mEdges = edges;
+    mCdf.assign(weights.size() + 1, 0.);
+    for (std::size_t i = 0; i < weights.size(); i++) {
+      mCdf[i + 1] = mCdf[i] + std::max(weights[i], 0.);
+    }
+    const double integral = mCdf.back();
+    if (!(integral > 0.)) {
+      mCdf.clear();
+      return false;
+    }
+    for (auto& value : mCdf) {
+      value /= integral;
+    }
+    return true;
+  }
+
+  /// Table of the bin contents of a histogram, without under- and overflow
+  bool build(TH1 const* histogram)
+  {
+    if (!histogram) {
+      return false;
+    }
+    const int nBins = histogram->GetNbinsX();
+    std::vector<double> edges(nBins + 1);
+    std::vector<double> weights(nBins);
+    for (int iBin = 1; iBin <= nBins; iBin++) {
+      edges[iBin - 1] = histogram->GetXaxis()->GetBinLowEdge(iBin);
+      weights[iBin - 1] = histogram->GetBinContent(iBin);
+    }
+    edges[nBins] = histogram->GetXaxis()->GetBinUpEdge(nBins);
+    return build(edges, weights);
+  }
+
+  /// Table of a function over its range, evaluated at the centres of nPoints equal intervals
+  bool build(TF1* function, int nPoints)
+  {
+    if (!function || nPoints < 1) {
+      return false;
+    }
+    double xMin = 0., xMax = 0.;
+    function->GetRange(xMin, xMax);
+    const double width = (xMax - xMin) / nPoints;
+    std::vector<double> edges(nPoints + 1);
+    std::vector<double> weights(nPoints);
+    for (int i = 0; i < nPoints; i++) {
+      edges[i] = xMin + i * width;
+      weights[i] = function->Eval(edges[i] + 0.5 * width) * width;
+    }
+    edges[nPoints] = xMax;
+    return build(edges, weights);
+  }
+
+  bool empty() const { return mCdf.empty(); }
+
+  /// Value for a uniform number u in [0, 1)
+  double sample(double u) const
+  {
+    const std::size_t nBins = mCdf.size() - 1;
+    std::size_t iBin = std::upper_bound(mCdf.begin() + 1, mCdf.end(), u) - (mCdf.begin() + 1);
+    iBin = std::min(iBin, nBins - 1);
+    const double content = mCdf[iBin + 1] - mCdf[iBin];
+    const double fraction = content > 0. ? (u - mCdf[iBin]) / content : 0.;
+    return mEdges[iBin] + (mEdges[iBin + 1] - mEdges[iBin]) * fraction;
+  }
+
+ private:
+  std::vector<double> mEdges; ///< bin edges
+  std::vector<double> mCdf;   ///< normalised cumulative contents, mCdf[i] up to the lower edge of bin i
+};
+
+/// Inverse-CDF tables in bins of a variable, e.g. the resolution slices in bins of pT
+class BinnedInverseCdf
+{
+ public:
+  /// Slices of a resolution map: the TH2 at position 0 defines the bins, the TH1 at position i is the slice of bin i
+  bool build(TObjArray const* slices)
+  {
+    clear();
+    if (!slices || !slices->At(0)) {
+      return false;
+    }
+    const TAxis* axis = static_cast<TH1*>(slices->At(0))->GetXaxis();
+    for (int iBin = 1; iBin <= axis->GetNbins(); iBin++) {
+      mEdges.push_back(axis->GetBinLowEdge(iBin));
+    }
+    mEdges.push_back(axis->GetBinUpEdge(axis->GetNbins()));
+    for (int iSlice = 1; iSlice <= slices->GetLast(); iSlice++) {
+      mTables.emplace_back();
+      if (!mTables.back().build(static_cast<TH1*>(slices->At(iSlice)))) {
+        LOGF(warning, "Empty or missing slice %d of %s, it is not smeared", iSlice, slices->GetName());
+      }
+    }
+    return !mTables.empty();
+  }
+
+  /// Templates between consecutive edges, templates[i] for edges[i] <= x < edges[i + 1]
+  bool build(std::vector<double> const& edges, std::vector<TH1*> const& templates)
+  {
+    clear();
+    mEdges = edges;
+    for (auto const* histogram : templates) {
+      mTables.emplace_back();
+      mTables.back().build(histogram);
+    }
+    return !mTables.empty();
+  }
+
+  void clear()
+  {
+    mEdges.clear();
+    mTables.clear();
+  }
+
+  bool empty() const { return mTables.empty(); }
+
+  /// Table of the bin of x, the first and last ones outside the bins
+  InverseCdf const& table(double x) const
+  {
+    const int iBin = static_cast<int>(std::upper_bound(mEdges.begin(), mEdges.end(), x) - mEdges.begin()) - 1;
+    return mTables[std::clamp(iBin, 0, static_cast<int>(mTables.size()) - 1)];
+  }
+
+  /// Value in the bin of x for a uniform number u, 0 if the table of the bin is empty
+  double sample(double x, double u) const
+  {
+    auto const& lookup = table(x);
+    return lookup.empty() ? 0. : lookup.sample(u);
+  }
+
+ private:
+  std::vector<double> mEdges;      ///< bin edges
+  std::vector<InverseCdf> mTables; ///< table per bin
+};
+
+/// Leptons of the decays of a collision
+struct LeptonStore {
+  std::vector<double> pt;     ///< transverse momentum (GeV/c)
+  std::vector<double> eta;    ///<
+  std::vector<double> phi;    ///<
+  std::vector<int8_t> charge; ///< charge used for the azimuthal smearing
+  std::vector<double> dca;    ///< DCA drawn from the templates, after the smearing
+
+  std::size_t size() const { return pt.size(); }
+
+  void clear()
+  {
+    pt.clear();
+    eta.clear();
+    phi.clear();
+    charge.clear();
+    dca.clear();
+  }
+
+  /// \return index of the lepton
+  std::size_t push(ROOT::Math::PxPyPzEVector const& lepton, int8_t sign)
+  {
+    pt.push_back(lepton.Pt());
+    eta.push_back(lepton.Eta());
+    phi.push_back(lepton.Phi());
+    charge.push_back(sign);
+    dca.push_back(0.);
+    return pt.size() - 1;
+  }
+
+  ROOT::Math::PxPyPzEVector get(std::size_t i, double mass) const
+  {
+    const double px = pt[i] * std::cos(phi[i]);
+    const double py = pt[i] * std::sin(phi[i]);
+    const double pz = pt[i] * std::sinh(eta[i]);
+    const double p = pt[i] * std::cosh(eta[i]);
+    return ROOT::Math::PxPyPzEVector(px, py, pz, std::sqrt(p * p + mass * mass));
+  }
+};
+
+/// Smearing of the cocktail leptons and DCA sampling
+class CocktailSampler
+{
+ public:
+  enum ResolutionType {
+    kNoSmearing = 0,
+    kMomentumSmearing = 1, // relative momentum smearing, or the B = 0.5 T parametrization without maps
+    kPtEtaPhiSmearing = 2  // relative pT, eta and charge-dependent phi smearing
+  };
+
+  CounterRng& rng() { return mRng; }
+
+  void setResolutionType(int type) { mResolutionType = type; }
+
+  /// Maps of the relative momentum smearing in bins of pT, for kMomentumSmearing
+  void setMomentumResolution(TObjArray const* slices) { mResoP.build(slices); }
+
+  /// Maps in bins of pT, for kPtEtaPhiSmearing
+  void setPtEtaPhiResolution(TObjArray const* slicesPt, TObjArray const* slicesEta, TObjArray const* slicesPhiPos, TObjArray const* slicesPhiNeg)
+  {
+    mResoPt.build(slicesPt);
+    mResoEta.build(slicesEta);
+    mResoPhiPos.build(slicesPhiPos);
+    mResoPhiNeg.build(slicesPhiNeg);
+  }
+
+  void setDcaTemplates(std::vector<double> const& edges, std::vector<TH1*> const& templates) { mDca.build(edges, templates); }
+
+  /// Smears the leptons in place
+  void smear(LeptonStore& leptons)
+  {
+    const std::size_t n = leptons.size();
+    if (mResolutionType == kMomentumSmearing) {
+      if (mResoP.empty()) {
+        for (std::size_t i = 0; i < n; i++) {
+          const double p = leptons.pt[i] * std::cosh(leptons.eta[i]);
+          const double relSmearing = mRng.gaus(0., p * std::sqrt(0.004 * 0.004 + (0.012 * p) * (0.012 * p))) / p;
+          leptons.pt[i] *= 1. - relSmearing;
+        }
+        return;
+      }
+      drawBatch(n);
+      for (std::size_t i = 0; i < n; i++) {
+        leptons.pt[i] *= 1. - mResoP.sample(leptons.pt[i], mUniform[i]);
+      }
+    } else if (mResolutionType == kPtEtaPhiSmearing) {
+      // the bins of all the maps are looked up with the unsmeared pT
+      drawBatch(3 * n);
+      const double* uPt = mUniform.data();
+      const double* uEta = uPt + n;
+      const double* uPhi = uEta + n;
+      for (std::size_t i = 0; i < n; i++) {
+        const double pt = leptons.pt[i];
+        auto const& resoPhi = leptons.charge[i] > 0 ? mResoPhiPos : mResoPhiNeg;
+        leptons.eta[i] -= mResoEta.sample(pt, uEta[i]);
+        leptons.phi[i] -= resoPhi.sample(pt, uPhi[i]);
+        leptons.pt[i] = pt - mResoPt.sample(pt, uPt[i]) * pt;
+      }
+    }
+  }
+
+  /// Draws the DCA of the leptons from the templates of their pT
+  void drawDca(LeptonStore& leptons)
+  {
+    const std::size_t n = leptons.size();
+    if (mDca.empty()) {
+      return;
+    }
+    drawBatch(n);
+    for (std::size_t i = 0; i < n; i++) {
+      leptons.dca[i] = mDca.sample(leptons.pt[i], mUniform[i]);
+    }
+  }
+
+ private:
+  void drawBatch(std::size_t n)
+  {
+    mUniform.resize(n);
+    mRng.uniform(mUniform.data(), n);
+  }
+
+  CounterRng mRng;
+  int mResolutionType{kNoSmearing};
+  BinnedInverseCdf mResoP;      ///< relative momentum smearing, kMomentumSmearing
+  BinnedInverseCdf mResoPt;     ///< relative pT smearing, kPtEtaPhiSmearing
+  BinnedInverseCdf mResoEta;    ///< eta smearing, kPtEtaPhiSmearing
+  BinnedInverseCdf mResoPhiPos; ///< phi smearing of the positive leptons, kPtEtaPhiSmearing
+  BinnedInverseCdf mResoPhiNeg; ///< phi smearing of the negative leptons, kPtEtaPhiSmearing
+  BinnedInverseCdf mDca;        ///< DCA templates in bins of the smeared pT
+  std::vector<double> mUniform; ///< uniform numbers of the current batch
+};
+
+} // namespace o2::analysis::dilepton
+
+#endif // PWGEM_DILEPTON_UTILS_COCKTAILSAMPLER_H_
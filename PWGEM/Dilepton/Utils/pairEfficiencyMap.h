@@ -0,0 +1,115 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file pairEfficiencyMap.h
+/// \brief Pair counts for all the track cuts and MC signals of an efficiency task in a single histogram
+///
+/// The pairs are accumulated in one THnD with axes (cut, MC signal, pair type, mass, pT and optionally DCA).
+/// A pair is filled once with the bitmask of the cuts passed by both tracks and the bitmask of its MC signals:
+/// the kinematic bins are found once per pair and only the set bits are visited, instead of one 2D histogram
+/// lookup and fill per cut and signal.
+
+#ifndef PWGEM_DILEPTON_UTILS_PAIREFFICIENCYMAP_H_
+#define PWGEM_DILEPTON_UTILS_PAIREFFICIENCYMAP_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "THn.h"
+#include "TString.h"
+
+namespace o2::analysis::dilepton
+{
+
+class PairEfficiencyMap
+{
+ public:
+  enum Axis {
+    kCut = 0,
+    kSignal,
+    kPairType,
+    kMass,
+    kPt,
+    kDCA,
+    kNAxes
+  };
+
+  enum PairType {
+    kULS = 0,
+    kLS,
+    kNPairTypes
+  };
+
+  /// Creates the histogram, owned by the caller (e.g. added to an output list)
+  /// \param cutNames, signalNames labels of the cut and signal axes, at most 32 each
+  /// \param dcaEdges bins of the pair DCA, no DCA axis if empty
+  THnD* create(const char* name, std::vector<TString> const& cutNames, std::vector<TString> const& signalNames,
+               std::vector<double> const& massEdges, std::vector<double> const& ptEdges, std::vector<double> const& dcaEdges = {})
+  {
+    mNDims = dcaEdges.empty() ? kDCA : kNAxes;
+    std::array<Int_t, kNAxes> nBins = {static_cast<Int_t>(cutNames.size()), static_cast<Int_t>(signalNames.size()), kNPairTypes,
+                                       static_cast<Int_t>(massEdges.size()) - 1, static_cast<Int_t>(ptEdges.size()) - 1, static_cast<Int_t>(dcaEdges.size()) - 1};
+    std::array<Double_t, kNAxes> xMin = {0., 0., 0., 0., 0., 0.};
+    std::array<Double_t, kNAxes> xMax = {static_cast<Double_t>(nBins[kCut]), static_cast<Double_t>(nBins[kSignal]), static_cast<Double_t>(kNPairTypes), 1., 1., 1.};
+    mHist = new THnD(name, ";cut;MC signal;pair type;m_{ee} (GeV/c^{2});p_{T,ee} (GeV/c);DCA_{ee} (cm)", mNDims, nBins.data(), xMin.data(), xMax.data());
+    mHist->Sumw2();
+    mHist->GetAxis(kMass)->Set(nBins[kMass], massEdges.data());
+    mHist->GetAxis(kPt)->Set(nBins[kPt], ptEdges.data());
+    if (mNDims == kNAxes) {
+      mHist->GetAxis(kDCA)->Set(nBins[kDCA], dcaEdges.data());
+    }
+    for (std::size_t i = 0; i < cutNames.size(); i++) {
+      mHist->GetAxis(kCut)->SetBinLabel(i + 1, cutNames[i]);
+    }
+    for (std::size_t i = 0; i < signalNames.size(); i++) {
+      mHist->GetAxis(kSignal)->SetBinLabel(i + 1, signalNames[i]);
+    }
+    mHist->GetAxis(kPairType)->SetBinLabel(kULS + 1, "ULS");
+    mHist->GetAxis(kPairType)->SetBinLabel(kLS + 1, "LS");
+    return mHist;
+  }
+
+  /// Adds a pair to all the cuts of cutMask and the signals of signalMask
+  void fill(uint32_t cutMask, uint32_t signalMask, int pairType, double mass, double pt, double dca = 0., double weight = 1.)
+  {
+    if (!cutMask || !signalMask) {
+      return;
+    }
+    Int_t bins[kNAxes];
+    bins[kPairType] = pairType + 1;
+    bins[kMass] = mHist->GetAxis(kMass)->FindFixBin(mass);
+    bins[kPt] = mHist->GetAxis(kPt)->FindFixBin(pt);
+    if (mNDims == kNAxes) {
+      bins[kDCA] = mHist->GetAxis(kDCA)->FindFixBin(dca);
+    }
+    Long64_t nFilled = 0;
+    for (uint32_t signals = signalMask; signals != 0; signals &= signals - 1) {
+      bins[kSignal] = __builtin_ctz(signals) + 1;
+      for (uint32_t cuts = cutMask; cuts != 0; cuts &= cuts - 1) {
+        bins[kCut] = __builtin_ctz(cuts) + 1;
+        const Long64_t bin = mHist->GetBin(bins);
+        mHist->AddBinContent(bin, weight);
+        mHist->AddBinError2(bin, weight * weight);
+        nFilled++;
+      }
+    }
+    mHist->SetEntries(mHist->GetEntries() + nFilled);
+  }
+
+ private:
+  THnD* mHist = nullptr; ///< counts, owned by the output list of the task
+  Int_t mNDims = kNAxes;
+};
+
+} // namespace o2::analysis::dilepton
+
+#endif // PWGEM_DILEPTON_UTILS_PAIREFFICIENCYMAP_H_
@@ -9,6 +9,9 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#ifndef PWGEM_PHOTONMESON_DATAMODEL_GAMMATABLES_H_
+#define PWGEM_PHOTONMESON_DATAMODEL_GAMMATABLES_H_
+
 #include "Framework/AnalysisDataModel.h"
 #include "Common/DataModel/PIDResponse.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
@@ -133,4 +136,82 @@ DECLARE_SOA_TABLE(McGammasTrue, "AOD", "MCGATRUE",
                   mcparticle::GetGenStatusCode<mcparticle::Flags, mcparticle::StatusCode>,
                   mcparticle::GetProcess<mcparticle::Flags, mcparticle::StatusCode>,
                   mcparticle::IsPhysicalPrimary<mcparticle::Flags>);
-} // namespace o2::aod
\ No newline at end of file
+
+// MC truth of the reconstructed V0s, one row per V0 in the order of V0Recalculated, filled once by the skimmer so that
+// the analysis reads the MC photon and the MC particles of the legs directly instead of slicing the MC tables per V0
+namespace gammav0mc
+{
+// decay class of a V0 from the PDG codes of the MC particles of its legs
+enum class eV0Decays {
+  ee1,         // Electron - Positron with same mother (true V0)
+  ee2,         // Electron - Positron with different mother
+  epi,         // Electron/Positron - Pion
+  ek,          // Electron/Positron - Kaon
+  ep,          // Electron/Positron - Proton/Antiproton
+  emu,         // Electron/Positron - Muon
+  pipi,        // Pion - Pion
+  pik,         // Pion - Kaon
+  pip,         // Pion - Proton/Antiproton
+  pimu,        // Pion - Muon
+  pKmu,        // Proton/Antiproton - Kaon/Muon
+  other,       // other
+  nomcparticle // no mc particle was found for this track
+};
+
+inline eV0Decays getV0DecayClass(int pdgPos, int pdgNeg, bool sameMother)
+{
+  if (pdgPos == 0) {
+    return eV0Decays::nomcparticle;
+  } else if (sameMother && ((pdgPos == 11 && pdgNeg == -11) || (pdgPos == -11 && pdgNeg == 11))) {
+    return eV0Decays::ee1;
+  } else if (!sameMother && ((pdgPos == 11 && pdgNeg == -11) || (pdgPos == -11 && pdgNeg == 11))) {
+    return eV0Decays::ee2;
+  } else if ((pdgPos == 11 && pdgNeg == 211) || (pdgPos == -11 && pdgNeg == -211)) {
+    return eV0Decays::epi;
+  } else if ((pdgPos == 11 && pdgNeg == 321) || (pdgPos == -11 && pdgNeg == -321)) {
+    return eV0Decays::ek;
+  } else if ((pdgPos == 11 && pdgNeg == 2212) || (pdgPos == -11 && pdgNeg == -2212)) {
+    return eV0Decays::ep;
+  } else if ((pdgPos == 11 && pdgNeg == -13) || (pdgPos == -11 && pdgNeg == 13)) {
+    return eV0Decays::emu;
+  } else if ((pdgPos == 211 && pdgNeg == -211) || (pdgPos == -211 && pdgNeg == 211)) {
+    return eV0Decays::pipi;
+  } else if ((pdgPos == 211 && pdgNeg == -321) || (pdgPos == -211 && pdgNeg == 321)) {
+    return eV0Decays::pik;
+  } else if ((pdgPos == 211 && pdgNeg == -2212) || (pdgPos == -211 && pdgNeg == 2212)) {
+    return eV0Decays::pip;
+  } else if ((pdgPos == 211 && pdgNeg == 13) || (pdgPos == -211 && pdgNeg == -13)) {
+    return eV0Decays::pimu;
+  } else if ((pdgPos == 2212 && pdgNeg == -321) || (pdgPos == -2212 && pdgNeg == 321) || (pdgPos == 2212 && pdgNeg == 13) || (pdgPos == -2212 && pdgNeg == -13)) {
+    return eV0Decays::pKmu;
+  }
+  return eV0Decays::other;
+}
+
+DECLARE_SOA_INDEX_COLUMN_FULL(McGammaTrue, mcGammaTrue, int, McGammasTrue, ""); //! MC photon the V0 comes from, -1 if none
+DECLARE_SOA_COLUMN(PdgCodePos, pdgCodePos, int);                                 //! PDG code of the MC particle of the positive leg, 0 if a leg has none
+DECLARE_SOA_COLUMN(PdgCodeNeg, pdgCodeNeg, int);                                 //! PDG code of the MC particle of the negative leg, 0 if a leg has none
+DECLARE_SOA_COLUMN(McPxPos, mcPxPos, float);                                     //! MC momentum of the positive leg in GeV/c
+DECLARE_SOA_COLUMN(McPyPos, mcPyPos, float);                                     //!
+DECLARE_SOA_COLUMN(McPzPos, mcPzPos, float);                                     //!
+DECLARE_SOA_COLUMN(McPxNeg, mcPxNeg, float);                                     //! MC momentum of the negative leg in GeV/c
+DECLARE_SOA_COLUMN(McPyNeg, mcPyNeg, float);                                     //!
+DECLARE_SOA_COLUMN(McPzNeg, mcPzNeg, float);                                     //!
+DECLARE_SOA_COLUMN(DecayClass, decayClass, int8_t);                              //! eV0Decays of the legs
+} // namespace gammav0mc
+
+DECLARE_SOA_TABLE(V0McInfo, "AOD", "V0MCINFO",
+                  gammav0mc::McGammaTrueId,
+                  gammav0mc::PdgCodePos,
+                  gammav0mc::PdgCodeNeg,
+                  gammav0mc::McPxPos,
+                  gammav0mc::McPyPos,
+                  gammav0mc::McPzPos,
+                  gammav0mc::McPxNeg,
+                  gammav0mc::McPyNeg,
+                  gammav0mc::McPzNeg,
+                  MCTracksTrue::SameMother,
+                  gammav0mc::DecayClass);
+} // namespace o2::aod
+
+#endif // PWGEM_PHOTONMESON_DATAMODEL_GAMMATABLES_H_
@@ -103,6 +103,7 @@ struct skimmerGammaConversions {
   Produces<aod::V0Recalculated> fFuncTableV0Recalculated;
   Produces<aod::V0DaughterMcParticles> fFuncTableMCTrackInformation;
   Produces<aod::MCParticleIndex> fIndexTableMCTrackIndex;
+  Produces<aod::V0McInfo> fFuncTableV0McInfo;
 
   Service<o2::ccdb::BasicCCDBManager> ccdb;
 
@@ -186,6 +187,35 @@ struct skimmerGammaConversions {
       sameMother);
   }
 
+  // MC truth of a V0 for the analysis: the index of its MC photon and the MC particles of its legs, one row per V0
+  template <typename TTRACK>
+  void fillV0McInfoTable(TTRACK const& theTrackPos, TTRACK const& theTrackNeg, int theMcGammaIndex, bool theSameMother)
+  {
+    int lPdgCode[2]{0, 0};
+    float lMomentum[6]{0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    if (theTrackPos.has_mcParticle() && theTrackNeg.has_mcParticle()) {
+      auto lMcPos = theTrackPos.mcParticle();
+      auto lMcNeg = theTrackNeg.mcParticle();
+      lPdgCode[0] = lMcPos.pdgCode();
+      lPdgCode[1] = lMcNeg.pdgCode();
+      lMomentum[0] = lMcPos.px();
+      lMomentum[1] = lMcPos.py();
+      lMomentum[2] = lMcPos.pz();
+      lMomentum[3] = lMcNeg.px();
+      lMomentum[4] = lMcNeg.py();
+      lMomentum[5] = lMcNeg.pz();
+    } else {
+      theSameMother = false;
+    }
+    fFuncTableV0McInfo(
+      theMcGammaIndex,
+      lPdgCode[0], lPdgCode[1],
+      lMomentum[0], lMomentum[1], lMomentum[2],
+      lMomentum[3], lMomentum[4], lMomentum[5],
+      theSameMother,
+      static_cast<int8_t>(aod::gammav0mc::getV0DecayClass(lPdgCode[0], lPdgCode[1], theSameMother)));
+  }
+
   // ============================ FUNCTION DEFINITIONS ====================================================
 
   void processRec(aod::Collisions::iterator const& theCollision,
@@ -248,9 +278,13 @@ struct skimmerGammaConversions {
         auto lTrackPos = lV0.template posTrack_as<tracksAndTPCInfoMC>(); // positive daughter
         auto lTrackNeg = lV0.template negTrack_as<tracksAndTPCInfoMC>(); // negative daughter
 
+        int lMcGammaIndex = -1;
+        bool lSameMother = false;
         eV0Confirmation lV0Status = isTrueV0(lV0,
                                              lTrackPos,
-                                             lTrackNeg);
+                                             lTrackNeg,
+                                             lMcGammaIndex,
+                                             lSameMother);
 
         fRegistry.get<TH1>(HIST("hV0Confirmation"))->Fill(lV0Status);
 
@@ -260,6 +294,7 @@ struct skimmerGammaConversions {
         fillTrackTable(lV0, lTrackPos, true);
         fillTrackTable(lV0, lTrackNeg, false);
         fillV0RecalculatedTable(lV0, recalculatedVtx);
+        fillV0McInfoTable(lTrackPos, lTrackNeg, lMcGammaIndex, lSameMother);
       }
     }
   }
@@ -268,7 +303,9 @@ struct skimmerGammaConversions {
   template <typename TV0, typename TTRACK>
   eV0Confirmation isTrueV0(TV0 const& theV0,
                            TTRACK const& theTrackPos,
-                           TTRACK const& theTrackNeg)
+                           TTRACK const& theTrackNeg,
+                           int& theMcGammaIndex,
+                           bool& theSameMother)
   {
     auto getMothersIndeces = [&](auto const& theMcParticle) {
       std::vector<int> lMothersIndeces{};
@@ -324,6 +361,8 @@ struct skimmerGammaConversions {
       MCTrackInformationHasEntry = true;
     }
 
+    theSameMother = hasSameMother;
+
     if (MCTrackInformationHasEntry) {
       fillfFuncTableMCTrackInformation(theTrackPos, hasSameMother);
       lPosEntryInMCTrack = fFuncTableMCTrackInformation.lastIndex();
@@ -367,6 +406,7 @@ struct skimmerGammaConversions {
         lDaughter0Vx, lDaughter0Vy, lDaughter0Vz,
         lV0Radius,
         -1, -1);
+      theMcGammaIndex = fFuncTableMcGammasFromConfirmedV0s.lastIndex();
       break; // because we only want to look at the first mother. If there are more it will show up in fMotherSizesHisto
     }
     return kGoodMcMother;
@@ -35,8 +35,7 @@
 
 #include "CommonDataFormat/InteractionRecord.h"
 
-#include "TLorentzVector.h"
-#include "TVector3.h"
+#include "PWGEM/PhotonMeson/Utils/caloMesonEngine.h"
 
 // \struct Pi0QCTask
 /// \brief Simple monitoring task for EMCal clusters
@@ -51,54 +50,13 @@
 
 using namespace o2::framework;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::photonmeson;
 using collisionEvSelIt = o2::soa::Join<o2::aod::Collisions, o2::aod::EvSels>::iterator;
 using selectedClusters = o2::soa::Filtered<o2::aod::EMCALClusters>;
 using selectedCluster = o2::soa::Filtered<o2::aod::EMCALCluster>;
 using selectedAmbiguousClusters = o2::soa::Filtered<o2::aod::EMCALAmbiguousClusters>;
 using selectedAmbiguousCluster = o2::soa::Filtered<o2::aod::EMCALAmbiguousCluster>;
 
-struct Photon {
-  Photon(float eta_tmp, float phi_tmp, float energy_tmp, int clusid = 0)
-  {
-    eta = eta_tmp;
-    phi = phi_tmp;
-    energy = energy_tmp;
-    theta = 2 * std::atan2(std::exp(-eta), 1);
-    px = energy * std::sin(theta) * std::cos(phi);
-    py = energy * std::sin(theta) * std::sin(phi);
-    pz = energy * std::cos(theta);
-    pt = std::sqrt(px * px + py * py);
-    photon.SetPxPyPzE(px, py, pz, energy);
-    id = clusid;
-  }
-
-  TLorentzVector photon;
-  float pt;
-  float px;
-  float py;
-  float pz;
-  float eta;
-  float phi;
-  float energy;
-  float theta;
-  int id;
-};
-
-struct Meson {
-  Meson(Photon p1, Photon p2) : pgamma1(p1),
-                                pgamma2(p2)
-  {
-    pMeson = p1.photon + p2.photon;
-  }
-  Photon pgamma1;
-  Photon pgamma2;
-  TLorentzVector pMeson;
-
-  float getMass() const { return pMeson.M(); };
-  float getPt() const { return pMeson.Pt(); };
-  float getOpeningAngle() const { return pgamma1.photon.Angle(pgamma2.photon.Vect()); };
-};
-
 struct Pi0QCTask {
   HistogramRegistry mHistManager{"NeutralMesonHistograms"};
   o2::emcal::Geometry* mGeometry = nullptr;
@@ -116,6 +74,11 @@ struct Pi0QCTask {
   Configurable<float> mMinEnergyCut{"MinEnergyCut", 0.7, "apply min cluster energy cut"};
   Configurable<int> mMinNCellsCut{"MinNCellsCut", 1, "apply min cluster number of cell cut"};
   Configurable<std::string> mClusterDefinition{"clusterDefinition", "kV3Default", "cluster definition to be selected, e.g. V3Default"};
+  Configurable<float> mMinOpenAngleCut{"OpeningAngleCut", 0., "apply min opening angle cut on the photon pairs (in rad)"};
+  Configurable<bool> mDoEventMixing{"doEventMixing", false, "fill the invariant mass of mixed-event pairs"};
+  Configurable<int> mMixingDepth{"mixingDepth", 5, "number of collisions kept per mixing bin"};
+  ConfigurableAxis mMixingVertexBins{"mixingVertexBins", {VARIABLE_WIDTH, -10.f, -5.f, 0.f, 5.f, 10.f}, "mixing bins - z-vertex (cm)"};
+  ConfigurableAxis mMixingMultBins{"mixingMultBins", {VARIABLE_WIDTH, 2.f, 5.f, 10.f, 20.f, 1000.f}, "mixing bins - number of selected photons"};
   std::vector<int> mVetoBCIDs;
   std::vector<int> mSelectBCIDs;
 
@@ -125,8 +88,10 @@ struct Pi0QCTask {
   o2::aod::EMCALClusterDefinition clusDef = o2::aod::emcalcluster::getClusterDefinitionFromString(mClusterDefinition.value);
   Filter clusterDefinitionSelection = o2::aod::emcalcluster::definition == static_cast<int>(clusDef);
 
-  // define container for photons
-  std::vector<Photon> mPhotons;
+  // define container for photons, the pair builder and the pools of photons for the event mixing
+  PhotonStore mPhotons;
+  CaloMesonEngine mMesonEngine;
+  PhotonMixingPool mMixingPool;
 
   /// \brief Create output histograms and initialize geometry
   void init(InitContext const&)
@@ -164,6 +129,13 @@ struct Pi0QCTask {
     // meson related histograms
     mHistManager.add("invMassVsPt", "invariant mass and pT of meson candidates", o2HistType::kTH2F, {{400, 0, 0.8}, {energyAxis}});
     mHistManager.add("invMassVsPtBackground", "invariant mass and pT of background meson candidates", o2HistType::kTH2F, {{400, 0, 0.8}, {energyAxis}});
+    if (mDoEventMixing) {
+      mHistManager.add("invMassVsPtMixedBackground", "invariant mass and pT of mixed background meson candidates", o2HistType::kTH2F, {{400, 0, 0.8}, {energyAxis}});
+      mMixingPool.init(mMixingVertexBins.value, mMixingMultBins.value, mMixingDepth);
+    }
+
+    mMesonEngine.setMinOpeningAngle(mMinOpenAngleCut);
+    mMesonEngine.setRotationAngle(M_PI / 2.0); // rotaion angle 90°
 
     if (mVetoBCID->length()) {
       std::stringstream parser(mVetoBCID.value);
@@ -283,73 +255,43 @@ struct Pi0QCTask {
 
       // put clusters in photon vector
       // ToDo: At the moment, the eta and phi values are not corrected for a shift of the primary vertex! Should only be a small effect but has to be corrected
-      mPhotons.push_back(Photon(cluster.eta(), cluster.phi(), cluster.energy(), cluster.id()));
+      mPhotons.pushFromEtaPhi(cluster.energy(), cluster.eta(), cluster.phi());
     }
   }
 
   /// \brief Process meson candidates, calculate invariant mass and pT and fill histograms
+  /// The rotation background (both photons of a pair rotated by 90 degrees around the pair momentum and paired
+  /// with the other photons of the event) is built in the same pass over the photon pairs.
   template <typename Clusters>
   void ProcessMesons(collisionEvSelIt const& theCollision, Clusters const& clusters, o2::aod::BCs const& bcs)
   {
-    // if less then 2 clusters are found, skip event
-    if (mPhotons.size() < 2) {
-      return;
-    }
-
-    // loop over all photon combinations and build meson candidates
-    for (unsigned int ig1 = 0; ig1 < mPhotons.size(); ++ig1) {
-      for (unsigned int ig2 = ig1 + 1; ig2 < mPhotons.size(); ++ig2) {
-
-        // build meson from photons
-        Meson meson(mPhotons[ig1], mPhotons[ig2]);
-        mHistManager.fill(HIST("invMassVsPt"), meson.getMass(), meson.getPt());
-
-        // calculate background candidates (rotation background)
-        CalculateBackground(meson, ig1, ig2);
+    if (mDoEventMixing) {
+      // mixed background with the photons of the previous events of the same z-vertex and photon multiplicity
+      const int bin = mMixingPool.getBin(theCollision.posZ(), mPhotons.size());
+      if (bin >= 0) {
+        mMixingPool.mix(bin, [&](PhotonStore const& pooled) {
+          mMesonEngine.processMixedEvent(mPhotons, pooled, [&](MesonCandidate const& meson) {
+            mHistManager.fill(HIST("invMassVsPtMixedBackground"), meson.mass, meson.pt);
+          });
+        });
+        mMixingPool.push(bin, mPhotons);
       }
     }
-  }
 
-  /// \brief Calculate background (using rotation background method)
-  void CalculateBackground(const Meson& meson, unsigned int ig1, unsigned int ig2)
-  {
-    // if less than 3 clusters are present, skip event
-    if (mPhotons.size() < 3) {
+    // if less then 2 clusters are found, skip event
+    if (mPhotons.size() < 2) {
       return;
     }
-    const double rotationAngle = M_PI / 2.0; //0.78539816339; // rotaion angle 90°
-
-    TLorentzVector lvRotationPhoton1; // photon candidates which get rotated
-    TLorentzVector lvRotationPhoton2; // photon candidates which get rotated
-    TVector3 lvRotationPion;          // rotation axis
-    for (unsigned int ig3 = 0; ig3 < mPhotons.size(); ++ig3) {
-      // continue if photons are identical
-      if (ig3 == ig1 || ig3 == ig2) {
-        continue;
-      }
-      // calculate rotation axis
-      lvRotationPion = (meson.pMeson).Vect();
-
-      // initialize photons for rotation
-      lvRotationPhoton1.SetPxPyPzE(mPhotons[ig1].px, mPhotons[ig1].py, mPhotons[ig1].pz, mPhotons[ig1].energy);
-      lvRotationPhoton2.SetPxPyPzE(mPhotons[ig2].px, mPhotons[ig2].py, mPhotons[ig2].pz, mPhotons[ig2].energy);
-
-      // rotate photons around rotation axis
-      lvRotationPhoton1.Rotate(rotationAngle, lvRotationPion);
-      lvRotationPhoton2.Rotate(rotationAngle, lvRotationPion);
 
-      // initialize Photon objects for rotated photons
-      Photon rotPhoton1(lvRotationPhoton1.Eta(), lvRotationPhoton1.Phi(), lvRotationPhoton1.E(), mPhotons[ig1].id);
-      Photon rotPhoton2(lvRotationPhoton2.Eta(), lvRotationPhoton2.Phi(), lvRotationPhoton2.E(), mPhotons[ig2].id);
-
-      // build meson from rotated photons
-      Meson mesonRotated1(rotPhoton1, mPhotons[ig3]);
-      Meson mesonRotated2(rotPhoton2, mPhotons[ig3]);
-
-      // Fill histograms
-      mHistManager.fill(HIST("invMassVsPtBackground"), mesonRotated1.getMass(), mesonRotated1.getPt());
-      mHistManager.fill(HIST("invMassVsPtBackground"), mesonRotated2.getMass(), mesonRotated2.getPt());
-    }
+    // build meson candidates from all photon combinations, and the rotation background if at least 3 photons are present
+    mMesonEngine.processSameEvent(
+      mPhotons,
+      [&](MesonCandidate const& meson) {
+        mHistManager.fill(HIST("invMassVsPt"), meson.mass, meson.pt);
+      },
+      [&](MesonCandidate const& meson) {
+        mHistManager.fill(HIST("invMassVsPtBackground"), meson.mass, meson.pt);
+      });
   }
 
   /// \brief Create binning for cluster energy/pT axis (variable bin size)
@@ -30,7 +30,7 @@ using namespace o2::framework;
 using namespace o2::framework::expressions;
 
 using V0DatasAdditional = soa::Join<aod::V0Datas, aod::V0Recalculated>;
-using V0DaughterTracksWithMC = soa::Join<aod::V0DaughterTracks, aod::MCParticleIndex>;
+using V0DatasAdditionalMC = soa::Join<aod::V0Datas, aod::V0Recalculated, aod::V0McInfo>;
 
 // using collisionEvSelIt = soa::Join<aod::Collisions, aod::EvSels>::iterator;
 struct GammaConversions {
@@ -317,7 +317,7 @@ struct GammaConversions {
                                           TV0 const& theV0,
                                           float const& theV0CosinePA,
                                           int PDGCode[],
-                                          bool const& sameMother,
+                                          eV0Decays theDecayClass,
                                           float McTrackmomentum[])
   {
     fillV0Histograms(
@@ -331,8 +331,7 @@ struct GammaConversions {
 
     lfillDecaysHist(
       fMyRegistry.mV0.mRejectedByMc[theRejReason].mBeforeAfterRecCuts[theBefAftRec].mV0Kind[kRec].mContainer,
-      PDGCode,
-      sameMother,
+      theDecayClass,
       McTrackmomentum);
 
     fillTruePhotonHistogramsForRejectedByMc(theRejReason,
@@ -344,7 +343,7 @@ struct GammaConversions {
   }
 
   template <typename TV0, typename TMCGAMMA>
-  bool v0IsGoodValidatedMcPhoton(TMCGAMMA const& theMcPhoton, TV0 const& theV0, float const& theV0CosinePA, bool theV0PassesRecCuts, int PDGCode[], bool const& sameMother, float McTrackmomentum[])
+  bool v0IsGoodValidatedMcPhoton(TMCGAMMA const& theMcPhoton, TV0 const& theV0, float const& theV0CosinePA, bool theV0PassesRecCuts, int PDGCode[], eV0Decays theDecayClass, float McTrackmomentum[])
   {
     auto fillRejectedV0HistosI = [&](eMcRejectedSaved theRejReason) {
       fillAllV0HistogramsForRejectedByMc(static_cast<int>(theRejReason),
@@ -353,7 +352,7 @@ struct GammaConversions {
                                          theV0,
                                          theV0CosinePA,
                                          PDGCode,
-                                         sameMother,
+                                         theDecayClass,
                                          McTrackmomentum);
       if (theV0PassesRecCuts) {
         fillAllV0HistogramsForRejectedByMc(static_cast<int>(theRejReason),
@@ -362,7 +361,7 @@ struct GammaConversions {
                                            theV0,
                                            theV0CosinePA,
                                            PDGCode,
-                                           sameMother,
+                                           theDecayClass,
                                            McTrackmomentum);
       }
     };
@@ -391,30 +390,29 @@ struct GammaConversions {
     return true;
   }
 
-  template <typename TV0, typename TMCGAMMATABLE>
-  void processMcPhoton(TMCGAMMATABLE const& theMcPhotonForThisV0AsTable,
-                       TV0 const& theV0,
+  template <typename TV0>
+  void processMcPhoton(TV0 const& theV0,
                        float const& theV0CosinePA,
                        bool theV0PassesRecCuts,
                        int PDGCode[],
-                       bool const& sameMother,
+                       eV0Decays theDecayClass,
                        float McTrackmomentum[])
   {
     fillV0McValidationHisto(eV0McValidation::kV0in);
 
-    // is a table that might be empty
-    if (theMcPhotonForThisV0AsTable.begin() == theMcPhotonForThisV0AsTable.end()) {
+    // the skimmer stores no MC photon for V0s not confirmed as a conversion
+    if (!theV0.has_mcGammaTrue()) {
       fillV0McValidationHisto(eV0McValidation::kFakeV0);
       return;
     }
-    auto const lMcPhoton = theMcPhotonForThisV0AsTable.begin();
+    auto const lMcPhoton = theV0.template mcGammaTrue_as<aod::McGammasTrue>();
 
     if (!v0IsGoodValidatedMcPhoton(lMcPhoton,
                                    theV0,
                                    theV0CosinePA,
                                    theV0PassesRecCuts,
                                    PDGCode,
-                                   sameMother,
+                                   theDecayClass,
                                    McTrackmomentum)) {
       return;
     }
@@ -436,23 +434,21 @@ struct GammaConversions {
   }
 
   void processPDGHistos(int const PDGCode[],
-                        bool const& sameMother,
+                        eV0Decays theDecayClass,
                         float const McTrackmomentum[],
                         int const& theV0PassesRecCuts)
   {
     lfillPDGHist(fMyRegistry.mV0.mBeforeAfterRecCuts[kBeforeRecCuts].mV0Kind[kRec].mContainer,
                  PDGCode);
     lfillDecaysHist(fMyRegistry.mV0.mBeforeAfterRecCuts[kBeforeRecCuts].mV0Kind[kRec].mContainer,
-                    PDGCode,
-                    sameMother,
+                    theDecayClass,
                     McTrackmomentum);
 
     if (theV0PassesRecCuts) {
       lfillPDGHist(fMyRegistry.mV0.mBeforeAfterRecCuts[kAfterRecCuts].mV0Kind[kRec].mContainer,
                    PDGCode);
       lfillDecaysHist(fMyRegistry.mV0.mBeforeAfterRecCuts[kAfterRecCuts].mV0Kind[kRec].mContainer,
-                      PDGCode,
-                      sameMother,
+                      theDecayClass,
                       McTrackmomentum);
     }
   }
@@ -465,39 +461,15 @@ struct GammaConversions {
   }
 
   void lfillDecaysHist(mapStringHistPtr& theContainer,
-                       int const PDGCode[],
-                       int const& sameMother,
+                       eV0Decays theDecayClass,
                        float const McTrackmomentum[])
   {
-    float MCV0p = RecoDecay::sqrtSumOfSquares(McTrackmomentum[0] + McTrackmomentum[3], McTrackmomentum[1] + McTrackmomentum[4]);
-
-    if (PDGCode[0] == 0) {
+    if (theDecayClass == eV0Decays::nomcparticle) {
       fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::nomcparticle), 0);
-    } else if (sameMother && ((PDGCode[0] == 11 && PDGCode[1] == -11) || (PDGCode[0] == -11 && PDGCode[1] == 11))) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::ee1), MCV0p);
-    } else if (!sameMother && ((PDGCode[0] == 11 && PDGCode[1] == -11) || (PDGCode[0] == -11 && PDGCode[1] == 11))) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::ee2), MCV0p);
-    } else if ((PDGCode[0] == 11 && PDGCode[1] == 211) || (PDGCode[0] == -11 && PDGCode[1] == -211)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::epi), MCV0p);
-    } else if ((PDGCode[0] == 11 && PDGCode[1] == 321) || (PDGCode[0] == -11 && PDGCode[1] == -321)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::ek), MCV0p);
-    } else if ((PDGCode[0] == 11 && PDGCode[1] == 2212) || (PDGCode[0] == -11 && PDGCode[1] == -2212)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::ep), MCV0p);
-    } else if ((PDGCode[0] == 11 && PDGCode[1] == -13) || (PDGCode[0] == -11 && PDGCode[1] == 13)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::emu), MCV0p);
-    } else if ((PDGCode[0] == 211 && PDGCode[1] == -211) || (PDGCode[0] == -211 && PDGCode[1] == 211)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::pipi), MCV0p);
-    } else if ((PDGCode[0] == 211 && PDGCode[1] == -321) || (PDGCode[0] == -211 && PDGCode[1] == 321)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::pik), MCV0p);
-    } else if ((PDGCode[0] == 211 && PDGCode[1] == -2212) || (PDGCode[0] == -211 && PDGCode[1] == 2212)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::pip), MCV0p);
-    } else if ((PDGCode[0] == 211 && PDGCode[1] == 13) || (PDGCode[0] == -211 && PDGCode[1] == -13)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::pimu), MCV0p);
-    } else if ((PDGCode[0] == 2212 && PDGCode[1] == -321) || (PDGCode[0] == -2212 && PDGCode[1] == 321) || (PDGCode[0] == 2212 && PDGCode[1] == 13) || (PDGCode[0] == -2212 && PDGCode[1] == -13)) {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::pKmu), MCV0p);
-    } else {
-      fillTH2(theContainer, "hDecays", static_cast<int>(eV0Decays::other), MCV0p);
+      return;
     }
+    float MCV0p = RecoDecay::sqrtSumOfSquares(McTrackmomentum[0] + McTrackmomentum[3], McTrackmomentum[1] + McTrackmomentum[4]);
+    fillTH2(theContainer, "hDecays", static_cast<int>(theDecayClass), MCV0p);
   }
 
   template <typename TV0, typename TMCGAMMA>
@@ -568,37 +540,6 @@ struct GammaConversions {
       theV0);
   }
 
-  template <typename TTRACKS>
-  void fillV0MCDaughterParticlesArrays(TTRACKS lTwoV0Daughters,
-                                       int PDGCode[],
-                                       float McParticleMomentum[],
-                                       bool& sameMother)
-  {
-    if ((lTwoV0Daughters.iteratorAt(0).has_v0DaughterMcParticle()) && (lTwoV0Daughters.iteratorAt(1).has_v0DaughterMcParticle())) {
-      auto MCDaughterParticleOne = lTwoV0Daughters.iteratorAt(0).v0DaughterMcParticle();
-      auto MCDaughterParticleTwo = lTwoV0Daughters.iteratorAt(1).v0DaughterMcParticle();
-      PDGCode[0] = MCDaughterParticleOne.pdgCode();
-      PDGCode[1] = MCDaughterParticleTwo.pdgCode();
-      McParticleMomentum[0] = MCDaughterParticleOne.px();
-      McParticleMomentum[1] = MCDaughterParticleOne.py();
-      McParticleMomentum[2] = MCDaughterParticleOne.pz();
-      McParticleMomentum[3] = MCDaughterParticleTwo.px();
-      McParticleMomentum[4] = MCDaughterParticleTwo.py();
-      McParticleMomentum[5] = MCDaughterParticleTwo.pz();
-      sameMother = MCDaughterParticleOne.sameMother();
-    } else {
-      PDGCode[0] = 0;
-      PDGCode[1] = 0;
-      McParticleMomentum[0] = 0;
-      McParticleMomentum[1] = 0;
-      McParticleMomentum[2] = 0;
-      McParticleMomentum[3] = 0;
-      McParticleMomentum[4] = 0;
-      McParticleMomentum[5] = 0;
-      sameMother = false;
-    }
-  }
-
   Preslice<aod::V0DaughterTracks> perV0 = aod::v0data::v0Id;
 
   void processRec(aod::Collisions::iterator const& theCollision,
@@ -621,13 +562,10 @@ struct GammaConversions {
   }
   PROCESS_SWITCH(GammaConversions, processRec, "process reconstructed info", true);
 
-  Preslice<aod::McGammasTrue> gperV0 = aod::v0data::v0Id;
-
   void processMc(aod::Collisions::iterator const& theCollision,
-                 V0DatasAdditional const& theV0s,
-                 V0DaughterTracksWithMC const& theAllTracks,
-                 aod::V0DaughterMcParticles const& TheAllTracksMC,
-                 aod::McGammasTrue const& theV0sTrue)
+                 V0DatasAdditionalMC const& theV0s,
+                 aod::V0DaughterTracks const& theAllTracks,
+                 aod::McGammasTrue const&)
   {
     fillTH1(fMyRegistry.mCollision.mBeforeAfterRecCuts[kBeforeRecCuts].mV0Kind[kRec].mContainer,
             "hCollisionZ",
@@ -641,25 +579,23 @@ struct GammaConversions {
       // check if V0 passes rec cuts and fill beforeRecCuts,afterRecCuts [kRec]
       bool lV0PassesRecCuts = processV0(lV0, lV0CosinePA, lTwoV0Daughters);
 
-      int PDGCode[2];              // Pos, then Neg
-      float McParticleMomentum[6]; // Mc momentum of the two daughter tracks, 0-2 = one 3-5 = two, no need to check the charges
-      bool sameMother;
-      fillV0MCDaughterParticlesArrays(lTwoV0Daughters, PDGCode, McParticleMomentum, sameMother); // pointers are passed so they can be later on used here
+      // MC truth of the legs as stored by the skimmer, 0 if a leg has no MC particle
+      int PDGCode[2]{lV0.pdgCodePos(), lV0.pdgCodeNeg()};
+      float McParticleMomentum[6]{lV0.mcPxPos(), lV0.mcPyPos(), lV0.mcPzPos(), lV0.mcPxNeg(), lV0.mcPyNeg(), lV0.mcPzNeg()}; // 0-2 = pos 3-5 = neg
+      eV0Decays lDecayClass = static_cast<eV0Decays>(lV0.decayClass());
 
       // this process function has to exist seperatly because it is only for MC Rec
       processPDGHistos(PDGCode,
-                       sameMother,
+                       lDecayClass,
                        McParticleMomentum,
                        lV0PassesRecCuts);
 
-      // check if it comes from a true photon (lMcPhotonForThisV0AsTable is a table that might be empty)
-      auto lMcPhotonForThisV0AsTable = theV0sTrue.sliceBy(gperV0, lV0.v0Id());
-      processMcPhoton(lMcPhotonForThisV0AsTable,
-                      lV0,
+      // check if it comes from a true photon
+      processMcPhoton(lV0,
                       lV0CosinePA,
                       lV0PassesRecCuts,
                       PDGCode,
-                      sameMother,
+                      lDecayClass,
                       McParticleMomentum);
     }
   }
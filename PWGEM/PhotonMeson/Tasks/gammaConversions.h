@@ -13,6 +13,7 @@
 /// \author stephan.friedrich.stiefelmaier@cern.ch
 
 #include "Framework/AnalysisTask.h"
+#include "PWGEM/PhotonMeson/DataModel/gammaTables.h"
 
 using namespace o2::framework;
 
@@ -58,21 +59,7 @@ enum class eV0McValidation {
   kMcValAfterRecCuts     // the kMcValidatedPhotonOut which also pass reconstruction cuts.
 };
 
-enum class eV0Decays {
-  ee1,         // Electron - Positron with same mother (true V0)
-  ee2,         // Electron - Positron with different mother
-  epi,         // Electron/Positron - Pion
-  ek,          // Electron/Positron - Kaon
-  ep,          // Electron/Positron - Proton/Antiproton
-  emu,         // Electron/Positron - Muon
-  pipi,        // Pion - Pion
-  pik,         // Pion - Kaon
-  pip,         // Pion - Proton/Antiproton
-  pimu,        // Pion - Muon
-  pKmu,        // Proton/Antiproton - Kaon/Muon
-  other,       // other
-  nomcparticle // no mc particle was found for this track
-};
+using eV0Decays = o2::aod::gammav0mc::eV0Decays;
 
 enum eBeforeAfterRecCuts { kBeforeRecCuts,
                            kAfterRecCuts };
@@ -0,0 +1,311 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file caloMesonEngine.h
+/// \brief Two-photon meson candidates from calorimeter clusters: same event, rotation background and event mixing
+///
+/// The selected photons of a collision are stored once in contiguous arrays (energy, momentum, cluster flags).
+/// The pair kinematics of a photon with all its partners is computed in a branch-free loop, followed by the
+/// invariant-mass and opening-angle selections, so that the pair loop is not a chain of per-pair objects.
+/// The rotation background is built in the same pass as the same-event pairs, and the photons of the previous
+/// collisions are kept in memory per mixing bin for the mixed-event pairs.
+
+#ifndef PWGEM_PHOTONMESON_UTILS_CALOMESONENGINE_H_
+#define PWGEM_PHOTONMESON_UTILS_CALOMESONENGINE_H_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Framework/HistogramSpec.h"
+#include "Framework/Logger.h"
+
+namespace o2::analysis::photonmeson
+{
+
+/// Selected photons of one collision
+struct PhotonStore {
+  std::vector<float> e;       ///< energy (GeV)
+  std::vector<float> px;      ///< momentum components (GeV/c)
+  std::vector<float> py;      ///<
+  std::vector<float> pz;      ///<
+  std::vector<float> p;       ///< momentum magnitude, for the opening angle
+  std::vector<uint8_t> flags; ///< cluster flags set by the task, e.g. the calorimeter module
+
+  std::size_t size() const { return e.size(); }
+
+  void clear()
+  {
+    e.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    p.clear();
+    flags.clear();
+  }
+
+  void push(float energy, float momX, float momY, float momZ, uint8_t flag = 0)
+  {
+    e.push_back(energy);
+    px.push_back(momX);
+    py.push_back(momY);
+    pz.push_back(momZ);
+    p.push_back(std::sqrt(momX * momX + momY * momY + momZ * momZ));
+    flags.push_back(flag);
+  }
+
+  /// Adds a massless photon from the cluster energy and direction
+  void pushFromEtaPhi(float energy, float eta, float phi, uint8_t flag = 0)
+  {
+    const float theta = 2 * std::atan(std::exp(-eta));
+    push(energy, energy * std::sin(theta) * std::cos(phi), energy * std::sin(theta) * std::sin(phi), energy * std::cos(theta), flag);
+  }
+};
+
+/// Meson candidate passed to the callbacks of the engine
+struct MesonCandidate {
+  float mass; ///< invariant mass (GeV/c^2), negative for a negative squared mass
+  float pt;   ///< transverse momentum (GeV/c)
+  int iOne;   ///< index of the first photon in its store
+  int iTwo;   ///< index of the second photon in its store, the partner photon for the rotation background
+};
+
+class CaloMesonEngine
+{
+ public:
+  /// Invariant-mass window of the candidates
+  void setMassRange(float minMass, float maxMass)
+  {
+    mMinMass2 = minMass > 0.f ? minMass * minMass : -std::numeric_limits<float>::max();
+    mMaxMass2 = maxMass * maxMass;
+  }
+
+  /// Minimum opening angle (rad) between the two photons, no selection if <= 0
+  void setMinOpeningAngle(float angle) { mMaxCosOpeningAngle = angle > 0.f ? std::cos(angle) : 2.f; }
+
+  /// Rotation angle (rad) of the photon pairs around their momentum for the rotation background
+  void setRotationAngle(float angle)
+  {
+    mCosRotation = std::cos(angle);
+    mSinRotation = std::sin(angle);
+  }
+
+  /// Calls sameEvent with each photon pair of a collision passing the selections
+  template <typename TCallback>
+  void processSameEvent(PhotonStore const& photons, TCallback&& sameEvent)
+  {
+    const int n = photons.size();
+    for (int i = 0; i < n - 1; i++) {
+      pairWith(photons.e[i], photons.px[i], photons.py[i], photons.pz[i], photons.p[i], photons, i + 1, i, -1, -1, sameEvent);
+    }
+  }
+
+  /// Same-event pairs and, in the same pass, the rotation background: both photons of each pair are rotated
+  /// around the pair momentum and each one is paired with all the other photons of the collision
+  template <typename TCallback, typename TRotationCallback>
+  void processSameEvent(PhotonStore const& photons, TCallback&& sameEvent, TRotationCallback&& rotated)
+  {
+    const int n = photons.size();
+    for (int i = 0; i < n - 1; i++) {
+      pairWith(photons.e[i], photons.px[i], photons.py[i], photons.pz[i], photons.p[i], photons, i + 1, i, -1, -1, sameEvent);
+      if (n < 3) {
+        continue;
+      }
+      for (int j = i + 1; j < n; j++) {
+        // rotation axis along the pair momentum
+        float ax = photons.px[i] + photons.px[j];
+        float ay = photons.py[i] + photons.py[j];
+        float az = photons.pz[i] + photons.pz[j];
+        const float norm = std::sqrt(ax * ax + ay * ay + az * az);
+        if (!(norm > 0.f)) {
+          continue;
+        }
+        ax /= norm;
+        ay /= norm;
+        az /= norm;
+        for (int photon : {i, j}) {
+          float rx, ry, rz;
+          rotate(photons.px[photon], photons.py[photon], photons.pz[photon], ax, ay, az, rx, ry, rz);
+          pairWith(photons.e[photon], rx, ry, rz, photons.p[photon], photons, 0, photon, i, j, rotated);
+        }
+      }
+    }
+  }
+
+  /// Calls mixedEvent with each pair of a photon of the current collision and a photon of a pooled one
+  template <typename TCallback>
+  void processMixedEvent(PhotonStore const& current, PhotonStore const& pooled, TCallback&& mixedEvent)
+  {
+    const int n = current.size();
+    for (int i = 0; i < n; i++) {
+      pairWith(current.e[i], current.px[i], current.py[i], current.pz[i], current.p[i], pooled, 0, i, -1, -1, mixedEvent);
+    }
+  }
+
+ private:
+  /// Rodrigues rotation of (vx, vy, vz) around the unit axis (ax, ay, az)
+  void rotate(float vx, float vy, float vz, float ax, float ay, float az, float& rx, float& ry, float& rz) const
+  {
+    const float dot = (ax * vx + ay * vy + az * vz) * (1.f - mCosRotation);
+    rx = vx * mCosRotation + (ay * vz - az * vy) * mSinRotation + ax * dot;
+    ry = vy * mCosRotation + (az * vx - ax * vz) * mSinRotation + ay * dot;
+    rz = vz * mCosRotation + (ax * vy - ay * vx) * mSinRotation + az * dot;
+  }
+
+  /// Pairs one photon with the partners [first, size) of a store, skipping the partners skipOne and skipTwo
+  template <typename TCallback>
+  void pairWith(float e, float px, float py, float pz, float p, PhotonStore const& partners, int first, int index, int skipOne, int skipTwo, TCallback&& callback)
+  {
+    const int n = partners.size() - first;
+    if (n <= 0) {
+      return;
+    }
+    mMass2.resize(n);
+    mPt2.resize(n);
+    mPass.resize(n);
+    const float* pe = partners.e.data() + first;
+    const float* ppx = partners.px.data() + first;
+    const float* ppy = partners.py.data() + first;
+    const float* ppz = partners.pz.data() + first;
+    const float* pp = partners.p.data() + first;
+    float* mass2 = mMass2.data();
+    float* pt2 = mPt2.data();
+    uint8_t* pass = mPass.data();
+    for (int k = 0; k < n; k++) {
+      const float sumE = e + pe[k];
+      const float sumPx = px + ppx[k];
+      const float sumPy = py + ppy[k];
+      const float sumPz = pz + ppz[k];
+      const float dot = px * ppx[k] + py * ppy[k] + pz * ppz[k];
+      mass2[k] = sumE * sumE - sumPx * sumPx - sumPy * sumPy - sumPz * sumPz;
+      pt2[k] = sumPx * sumPx + sumPy * sumPy;
+      pass[k] = (mass2[k] >= mMinMass2) & (mass2[k] < mMaxMass2) & (dot <= mMaxCosOpeningAngle * p * pp[k]);
+    }
+    if (skipOne >= first) {
+      pass[skipOne - first] = 0;
+    }
+    if (skipTwo >= first) {
+      pass[skipTwo - first] = 0;
+    }
+    for (int k = 0; k < n; k++) {
+      if (pass[k]) {
+        callback(MesonCandidate{mass2[k] < 0.f ? -std::sqrt(-mass2[k]) : std::sqrt(mass2[k]), std::sqrt(pt2[k]), index, first + k});
+      }
+    }
+  }
+
+  float mMinMass2 = -std::numeric_limits<float>::max(); ///< squared invariant-mass window
+  float mMaxMass2 = std::numeric_limits<float>::max();  ///<
+  float mMaxCosOpeningAngle = 2.f;                      ///< cosine of the minimum opening angle, 2 for no selection
+  float mCosRotation = 0.f;                             ///< rotation of the rotation background, 90 degrees by default
+  float mSinRotation = 1.f;                             ///<
+  std::vector<float> mMass2;                            ///< squared invariant mass of the pairs of the photon being paired
+  std::vector<float> mPt2;                              ///< squared transverse momentum of the pairs
+  std::vector<uint8_t> mPass;                           ///< pairs passing the selections
+};
+
+/// Photons of the previous collisions, kept per (z-vertex, multiplicity) bin with a fixed depth
+class PhotonMixingPool
+{
+ public:
+  /// \param vtxAxis, multAxis mixing binning, in the ConfigurableAxis format ({VARIABLE_WIDTH, edges...} or {nBins, min, max})
+  /// \param depth number of collisions kept per bin
+  void init(std::vector<double> const& vtxAxis, std::vector<double> const& multAxis, int depth)
+  {
+    mVtxEdges = getEdges(vtxAxis);
+    mMultEdges = getEdges(multAxis);
+    if (mVtxEdges.size() < 2 || mMultEdges.size() < 2 || depth < 1) {
+      LOGF(fatal, "Invalid photon mixing pool: %d z-vertex edges, %d multiplicity edges, depth %d", mVtxEdges.size(), mMultEdges.size(), depth);
+    }
+    mDepth = depth;
+    const std::size_t nBins = (mVtxEdges.size() - 1) * (mMultEdges.size() - 1);
+    mStores.assign(nBins * depth, PhotonStore{});
+    mNext.assign(nBins, 0);
+    mSize.assign(nBins, 0);
+  }
+
+  /// Mixing bin of a collision, -1 outside the binning
+  int getBin(float posZ, float mult) const
+  {
+    const int iVtx = findBin(mVtxEdges, posZ);
+    const int iMult = findBin(mMultEdges, mult);
+    if (iVtx < 0 || iMult < 0) {
+      return -1;
+    }
+    return iVtx * (mMultEdges.size() - 1) + iMult;
+  }
+
+  /// Calls mixWith with each collision of the bin, from the most recent one
+  template <typename TMix>
+  void mix(int bin, TMix&& mixWith) const
+  {
+    for (int iStored = 1; iStored <= mSize[bin]; iStored++) {
+      mixWith(mStores[bin * mDepth + (mNext[bin] - iStored + mDepth) % mDepth]);
+    }
+  }
+
+  /// Keeps the photons of a collision in its bin, in place of the oldest one if the bin is full
+  void push(int bin, PhotonStore const& store)
+  {
+    if (store.size() == 0) {
+      return;
+    }
+    mStores[bin * mDepth + mNext[bin]] = store;
+    mNext[bin] = (mNext[bin] + 1) % mDepth;
+    if (mSize[bin] < mDepth) {
+      mSize[bin]++;
+    }
+  }
+
+ private:
+  static std::vector<double> getEdges(std::vector<double> const& axis)
+  {
+    if (axis.empty()) {
+      return {};
+    }
+    if (axis[0] == o2::framework::VARIABLE_WIDTH) {
+      return std::vector<double>(axis.begin() + 1, axis.end());
+    }
+    if (axis.size() != 3) {
+      return {};
+    }
+    std::vector<double> edges;
+    const int nBins = axis[0];
+    for (int iBin = 0; iBin <= nBins; iBin++) {
+      edges.push_back(axis[1] + iBin * (axis[2] - axis[1]) / nBins);
+    }
+    return edges;
+  }
+
+  static int findBin(std::vector<double> const& edges, float value)
+  {
+    if (!(value >= edges.front()) || value >= edges.back()) {
+      return -1;
+    }
+    int iBin = 0;
+    while (value >= edges[iBin + 1]) {
+      iBin++;
+    }
+    return iBin;
+  }
+
+  std::vector<double> mVtxEdges;    ///< z-vertex bin edges
+  std::vector<double> mMultEdges;   ///< multiplicity bin edges
+  int mDepth = 1;                   ///< collisions kept per bin
+  std::vector<PhotonStore> mStores; ///< stored photons, [bin][depth]
+  std::vector<int> mNext;           ///< slot of the next stored collision, per bin
+  std::vector<int> mSize;           ///< number of stored collisions, per bin
+};
+
+} // namespace o2::analysis::photonmeson
+
+#endif // PWGEM_PHOTONMESON_UTILS_CALOMESONENGINE_H_
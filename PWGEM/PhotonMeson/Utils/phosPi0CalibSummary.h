@@ -0,0 +1,268 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file phosPi0CalibSummary.h
+/// \brief Reduced summary of the PHOS cluster pairs for the iterative pi0 energy calibration
+///
+/// A pair keeps what its invariant mass and pT depend on once the cluster directions are fixed: the energies of the two
+/// clusters, the ids of their cells with their energy fractions, the cosine of the opening angle and the transverse
+/// components of the directions. With per-cell coefficients k the energy of a cluster is E * sum_c f_c k_c, hence an
+/// iteration of the calibration recomputes the masses from the summary only. The coefficient of the leading cell of a
+/// cluster is scaled by (m_pi0 / <m>)^2 using the pairs in the mass window, m^2 being proportional to the cluster energy.
+/// The pairs are written to a TTree by the task, one entry per pair, and read back for the iterations.
+
+#ifndef PWGEM_PHOTONMESON_UTILS_PHOSPI0CALIBSUMMARY_H_
+#define PWGEM_PHOTONMESON_UTILS_PHOSPI0CALIBSUMMARY_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "TTree.h"
+
+namespace o2::analysis::photonmeson
+{
+
+class PhosPi0CalibSummary
+{
+ public:
+  static constexpr int MaxCells = 64;        // cells stored per cluster, the energy of the cells beyond is not calibrated
+  static constexpr float MassPi0 = 0.134977; // GeV/c^2
+
+  void clear()
+  {
+    mEnergy.clear();
+    mLeadingCell.clear();
+    mDirection.clear();
+    mCellOffsets.assign(1, 0);
+    mCellIds.clear();
+    mCellFractions.clear();
+    mPairs.clear();
+  }
+
+  /// Adds a cluster
+  /// \param energy cluster energy with the calibration used for the summary
+  /// \param px,py,pz cluster momentum, only its direction is used
+  /// \param leadingCell absId of the most energetic cell, whose coefficient is calibrated with the cluster
+  /// \return index of the cluster, the cells are then added with addCell
+  int addCluster(float energy, float px, float py, float pz, int16_t leadingCell)
+  {
+    const float p = std::sqrt(px * px + py * py + pz * pz);
+    mEnergy.push_back(energy);
+    mLeadingCell.push_back(leadingCell);
+    mDirection.push_back(p > 0.f ? px / p : 0.f);
+    mDirection.push_back(p > 0.f ? py / p : 0.f);
+    mDirection.push_back(p > 0.f ? pz / p : 0.f);
+    mCellOffsets.push_back(mCellOffsets.back());
+    return mEnergy.size() - 1;
+  }
+
+  /// Adds a cell to the last cluster
+  /// \param fraction fraction of the cluster energy in the cell
+  void addCell(int16_t absId, float fraction)
+  {
+    if (mCellOffsets.back() - mCellOffsets[mCellOffsets.size() - 2] >= MaxCells) {
+      return;
+    }
+    mCellIds.push_back(absId);
+    mCellFractions.push_back(fraction);
+    mCellOffsets.back()++;
+  }
+
+  void addPair(int cluster1, int cluster2) { mPairs.push_back({cluster1, cluster2}); }
+
+  std::size_t nPairs() const { return mPairs.size(); }
+
+  /// Appends the pairs to a tree, created with its branches by the first call, and clears the summary
+  void flush(TTree* tree)
+  {
+    if (!tree->GetBranch("e1")) {
+      tree->Branch("e1", &mEntry.e1);
+      tree->Branch("e2", &mEntry.e2);
+      tree->Branch("cosOpening", &mEntry.cosOpening);
+      tree->Branch("sin2Theta1", &mEntry.sin2Theta1);
+      tree->Branch("sin2Theta2", &mEntry.sin2Theta2);
+      tree->Branch("cosTransverse", &mEntry.cosTransverse);
+      tree->Branch("lead1", &mEntry.lead1);
+      tree->Branch("lead2", &mEntry.lead2);
+      tree->Branch("n1", &mEntry.n1);
+      tree->Branch("cells1", mEntry.cells1, "cells1[n1]/S");
+      tree->Branch("fractions1", mEntry.fractions1, "fractions1[n1]/F");
+      tree->Branch("n2", &mEntry.n2);
+      tree->Branch("cells2", mEntry.cells2, "cells2[n2]/S");
+      tree->Branch("fractions2", mEntry.fractions2, "fractions2[n2]/F");
+    }
+    for (auto const& pair : mPairs) {
+      const float* u1 = &mDirection[3 * pair.first];
+      const float* u2 = &mDirection[3 * pair.second];
+      mEntry.e1 = mEnergy[pair.first];
+      mEntry.e2 = mEnergy[pair.second];
+      mEntry.cosOpening = u1[0] * u2[0] + u1[1] * u2[1] + u1[2] * u2[2];
+      mEntry.sin2Theta1 = u1[0] * u1[0] + u1[1] * u1[1];
+      mEntry.sin2Theta2 = u2[0] * u2[0] + u2[1] * u2[1];
+      mEntry.cosTransverse = u1[0] * u2[0] + u1[1] * u2[1];
+      mEntry.lead1 = mLeadingCell[pair.first];
+      mEntry.lead2 = mLeadingCell[pair.second];
+      mEntry.n1 = copyCells(pair.first, mEntry.cells1, mEntry.fractions1);
+      mEntry.n2 = copyCells(pair.second, mEntry.cells2, mEntry.fractions2);
+      tree->Fill();
+    }
+    clear();
+  }
+
+  /// Reads all the pairs of a tree written by flush into memory, for the iterations
+  void load(TTree* tree)
+  {
+    mLoaded.clear();
+    mLoadedCellIds.clear();
+    mLoadedCellFractions.clear();
+    PairEntry entry;
+    tree->SetBranchAddress("e1", &entry.e1);
+    tree->SetBranchAddress("e2", &entry.e2);
+    tree->SetBranchAddress("cosOpening", &entry.cosOpening);
+    tree->SetBranchAddress("sin2Theta1", &entry.sin2Theta1);
+    tree->SetBranchAddress("sin2Theta2", &entry.sin2Theta2);
+    tree->SetBranchAddress("cosTransverse", &entry.cosTransverse);
+    tree->SetBranchAddress("lead1", &entry.lead1);
+    tree->SetBranchAddress("lead2", &entry.lead2);
+    tree->SetBranchAddress("n1", &entry.n1);
+    tree->SetBranchAddress("cells1", entry.cells1);
+    tree->SetBranchAddress("fractions1", entry.fractions1);
+    tree->SetBranchAddress("n2", &entry.n2);
+    tree->SetBranchAddress("cells2", entry.cells2);
+    tree->SetBranchAddress("fractions2", entry.fractions2);
+    mLoaded.reserve(tree->GetEntries());
+    for (Long64_t i = 0; i < tree->GetEntries(); i++) {
+      tree->GetEntry(i);
+      LoadedPair pair{entry.e1, entry.e2, entry.cosOpening, entry.sin2Theta1, entry.sin2Theta2, entry.cosTransverse, entry.lead1, entry.lead2,
+                      static_cast<uint32_t>(mLoadedCellIds.size()), 0, 0};
+      for (int c = 0; c < entry.n1; c++) {
+        mLoadedCellIds.push_back(entry.cells1[c]);
+        mLoadedCellFractions.push_back(entry.fractions1[c]);
+      }
+      pair.n1 = entry.n1;
+      for (int c = 0; c < entry.n2; c++) {
+        mLoadedCellIds.push_back(entry.cells2[c]);
+        mLoadedCellFractions.push_back(entry.fractions2[c]);
+      }
+      pair.n2 = entry.n2;
+      mLoaded.push_back(pair);
+    }
+    tree->ResetBranchAddresses();
+  }
+
+  /// Iterates the per-cell coefficients on the loaded pairs
+  /// \param nIterations number of iterations
+  /// \param massMin,massMax pi0 mass window of the pairs used
+  /// \param ptMin minimum pair pT
+  /// \param minEntries minimum number of pairs for a cell to be calibrated
+  /// \return coefficients indexed by absId, 1 for the cells not calibrated
+  std::vector<float> const& iterate(int nIterations, float massMin, float massMax, float ptMin, int minEntries)
+  {
+    int16_t maxId = 0;
+    for (auto id : mLoadedCellIds) {
+      maxId = std::max(maxId, id);
+    }
+    for (auto const& pair : mLoaded) {
+      maxId = std::max({maxId, pair.lead1, pair.lead2});
+    }
+    mCoefficients.assign(maxId + 1, 1.f);
+    std::vector<double> sumM2(maxId + 1);
+    std::vector<int> entries(maxId + 1);
+    for (int iteration = 0; iteration < nIterations; iteration++) {
+      std::fill(sumM2.begin(), sumM2.end(), 0.);
+      std::fill(entries.begin(), entries.end(), 0);
+      for (auto const& pair : mLoaded) {
+        const float e1 = pair.e1 * clusterScale(pair.firstCell, pair.n1);
+        const float e2 = pair.e2 * clusterScale(pair.firstCell + pair.n1, pair.n2);
+        const float pt2 = e1 * e1 * pair.sin2Theta1 + e2 * e2 * pair.sin2Theta2 + 2.f * e1 * e2 * pair.cosTransverse;
+        if (pt2 < ptMin * ptMin) {
+          continue;
+        }
+        const float m2 = 2.f * e1 * e2 * (1.f - pair.cosOpening);
+        if (m2 < massMin * massMin || m2 > massMax * massMax) {
+          continue;
+        }
+        sumM2[pair.lead1] += m2;
+        entries[pair.lead1]++;
+        sumM2[pair.lead2] += m2;
+        entries[pair.lead2]++;
+      }
+      for (int16_t id = 0; id <= maxId; id++) {
+        if (entries[id] >= minEntries && sumM2[id] > 0.) {
+          mCoefficients[id] *= MassPi0 * MassPi0 * entries[id] / sumM2[id];
+        }
+      }
+    }
+    return mCoefficients;
+  }
+
+ private:
+  struct PairEntry {
+    float e1, e2, cosOpening, sin2Theta1, sin2Theta2, cosTransverse;
+    int16_t lead1, lead2;
+    int n1, n2;
+    int16_t cells1[MaxCells], cells2[MaxCells];
+    float fractions1[MaxCells], fractions2[MaxCells];
+  };
+
+  struct LoadedPair {
+    float e1, e2, cosOpening, sin2Theta1, sin2Theta2, cosTransverse;
+    int16_t lead1, lead2;
+    uint32_t firstCell; // cells of the first cluster in mLoadedCellIds, followed by those of the second
+    int n1, n2;
+  };
+
+  int copyCells(int cluster, int16_t* ids, float* fractions) const
+  {
+    int n = 0;
+    for (auto c = mCellOffsets[cluster]; c < mCellOffsets[cluster + 1]; c++, n++) {
+      ids[n] = mCellIds[c];
+      fractions[n] = mCellFractions[c];
+    }
+    return n;
+  }
+
+  /// Relative change of the energy of a cluster with the current coefficients
+  float clusterScale(uint32_t firstCell, int n) const
+  {
+    float scale = 0.f;
+    float sumFractions = 0.f;
+    for (uint32_t c = firstCell; c < firstCell + n; c++) {
+      scale += mLoadedCellFractions[c] * mCoefficients[mLoadedCellIds[c]];
+      sumFractions += mLoadedCellFractions[c];
+    }
+    // the energy of the dropped cells is kept uncalibrated
+    return scale + (1.f - sumFractions);
+  }
+
+  // clusters and pairs of the dataframe being summarized
+  std::vector<float> mEnergy;
+  std::vector<int16_t> mLeadingCell;
+  std::vector<float> mDirection; // unit vectors, 3 per cluster
+  std::vector<uint32_t> mCellOffsets = {0};
+  std::vector<int16_t> mCellIds;
+  std::vector<float> mCellFractions;
+  std::vector<std::pair<int, int>> mPairs;
+  PairEntry mEntry; // branch buffer of the tree
+
+  // pairs loaded for the iterations
+  std::vector<LoadedPair> mLoaded;
+  std::vector<int16_t> mLoadedCellIds;
+  std::vector<float> mLoadedCellFractions;
+  std::vector<float> mCoefficients;
+};
+
+} // namespace o2::analysis::photonmeson
+
+#endif // PWGEM_PHOTONMESON_UTILS_PHOSPI0CALIBSUMMARY_H_
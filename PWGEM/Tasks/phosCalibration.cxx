@@ -16,6 +16,7 @@
 #include <vector>
 #include "TFile.h"
 #include "TLorentzVector.h"
+#include "TTree.h"
 
 #include "DataFormatsPHOS/Cell.h"
 #include "DataFormatsPHOS/Cluster.h"
@@ -34,6 +35,8 @@
 
 #include "CommonDataFormat/InteractionRecord.h"
 
+#include "PWGEM/PhotonMeson/Utils/phosPi0CalibSummary.h"
+
 using namespace o2;
 using namespace o2::framework;
 
@@ -68,8 +71,13 @@ struct phosCalibration {
   Configurable<double> mMinCellTimeMain{"minCellTimeMain", -50.e-9, "Min. cell time of main bunch selection"};
   Configurable<double> mMaxCellTimeMain{"maxCellTimeMain", 100.e-9, "Max. cell time of main bunch selection"};
   Configurable<uint32_t> mL1{"L1", 0, "L1 phase"};
+  Configurable<bool> mFillPairSummary{"fillPairSummary", false, "Store the reduced cluster-pair summary for the iterative energy calibration"};
+  Configurable<float> mPairSummaryPtMin{"pairSummaryPtMin", 1.5, "Min. pT of the pairs stored in the summary"};
 
   HistogramRegistry mHistManager{"phosCallQAHistograms"};
+  // cluster pairs of the same BC with their cells and energy fractions, for the calibration iterations without the AODs
+  OutputObj<TTree> mPairSummaryTree{"phosCluPairSummary"};
+  o2::analysis::photonmeson::PhosPi0CalibSummary mPairSummary;
 
   std::unique_ptr<o2::phos::Geometry> geom;
   std::unique_ptr<o2::phos::Clusterer> clusterizer;
@@ -118,6 +126,9 @@ struct phosCalibration {
     mHistManager.add("cluMggRe", "Real m_{#gamma#gamma}", HistType::kTH2F, {absIdAxis, mggAxis});
     mHistManager.add("cluMggMi", "Mixed m_{#gamma#gamma}", HistType::kTH2F, {absIdAxis, mggAxis});
 
+    mPairSummaryTree.setObject(new TTree("phosCluPairSummary", "PHOS cluster pairs for the pi0 energy calibration"));
+    mPairSummary.clear();
+
     LOG(info) << "Calibration configured ...";
   }
 
@@ -243,9 +254,11 @@ struct phosCalibration {
 
         // find most energetic cluElement
         float maxE = 0;
+        float sumE = 0;
         int16_t absId = 0;
         for (uint32_t iClEl = clu.getFirstCluEl(); iClEl < clu.getLastCluEl(); iClEl++) {
           auto& el = phosCluElements[iClEl];
+          sumE += el.energy;
           if (el.energy > maxE) {
             maxE = el.energy;
             absId = el.absId;
@@ -289,6 +302,13 @@ struct phosCalibration {
         event.emplace_back(sc * globaPos.X(), sc * globaPos.Y(), sc * globaPos.Z(), e);
         event.back().setAbsId(absId);
         event.back().setBC(tr.getBCData().toLong());
+        if (mFillPairSummary) {
+          // same index as in event
+          mPairSummary.addCluster(e, event.back().Px(), event.back().Py(), event.back().Pz(), absId);
+          for (uint32_t iClEl = clu.getFirstCluEl(); iClEl < clu.getLastCluEl(); iClEl++) {
+            mPairSummary.addCell(phosCluElements[iClEl].absId, phosCluElements[iClEl].energy / sumE);
+          }
+        }
         // SetBadMap
         //  if(hBadMap[mod-1]->GetBinContent(relid[1],relid[2])>0){
         //    event.back().setBad() ;
@@ -297,11 +317,14 @@ struct phosCalibration {
     }
 
     // Make Real and Mixed
-    for (size_t i = 0; i < event.size() - 1; i++) {
+    for (size_t i = 0; i + 1 < event.size(); i++) {
       int absId1 = event[i].getAbsId();
       for (size_t j = i + 1; j < event.size(); j++) {
         TLorentzVector s = event[i] + event[j];
         int absId2 = event[j].getAbsId();
+        if (mFillPairSummary && event[i].getBC() == event[j].getBC() && s.Pt() > mPairSummaryPtMin) {
+          mPairSummary.addPair(i, j);
+        }
         if (s.Pt() > 2.) {
           if (!event[j].isBad()) {
             if (event[j].getBC() == event[j].getBC()) {
@@ -327,6 +350,10 @@ struct phosCalibration {
         }
       }
     }
+
+    if (mFillPairSummary) {
+      mPairSummary.flush(mPairSummaryTree.object.get());
+    }
   }
 
   float Nonlinearity(float en)
@@ -27,6 +27,7 @@
 
 #include "PHOSBase/Geometry.h"
 #include "CommonDataFormat/InteractionRecord.h"
+#include "PWGEM/PhotonMeson/Utils/caloMesonEngine.h"
 
 /// \struct PHOS pi0 analysis
 /// \brief Monitoring task for PHOS related quantities
@@ -37,6 +38,7 @@
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::photonmeson;
 
 struct phosPi0 {
 
@@ -47,10 +49,18 @@ struct phosPi0 {
 
   Configurable<float> mOccE{"minOccE", 0.6, "Minimum cluster energy to fill occupancy"};
 
+  Configurable<int> mMixingDepth{"mixingDepth", 5, "Number of events kept per mixing bin"};
+  ConfigurableAxis mMixingVertexBins{"mixingVertexBins", {VARIABLE_WIDTH, -10., -5., 0., 5., 10.}, "Mixing bins - z-vertex (cm)"};
+  ConfigurableAxis mMixingCentBins{"mixingCentBins", {VARIABLE_WIDTH, 0., 2., 4., 6., 8., 10., 15.}, "Mixing bins - centrality estimator log2(1 + contributors)"};
+
   using FilteredClusters = soa::Filtered<aod::CaloClusters>;
 
   HistogramRegistry mHistManager{"phosPi0Histograms"};
 
+  PhotonStore mPhotons;         // selected clusters of the current event
+  CaloMesonEngine mMesonEngine; // photon pairs of the current event and with the pooled events
+  PhotonMixingPool mMixingPool; // selected clusters of the previous events, per z-vertex and centrality bin
+
   /// \brief Create output histograms
   void init(InitContext const&)
   {
@@ -83,20 +93,29 @@ struct phosPi0 {
     mHistManager.add("cluOcc", "Cluster occupancy ", HistType::kTH2F, {cluPhiAxis, cluZAxis});
     mHistManager.add("cluE", "Cluster energy", HistType::kTH2F, {cluPhiAxis, cluZAxis});
     mHistManager.add("cluTime", "Cluster time", HistType::kTH2F, {cluPhiAxis, cluZAxis});
+
+    mMixingPool.init(mMixingVertexBins.value, mMixingCentBins.value, mMixingDepth);
   }
 
   /// \brief Process PHOS data
-  void process(aod::BCs const& bcs,
-               aod::Collisions const& collisions,
+  /// The selected clusters of each event are paired once among themselves and with the clusters of the
+  /// previous events of the same z-vertex and centrality bin, kept in memory.
+  void process(aod::Collision const& col,
                aod::CaloClusters const& clusters)
   {
-    for (const auto& col : collisions) {
-      mHistManager.fill(HIST("contributors"), col.numContrib());
-      mHistManager.fill(HIST("vertex"), col.posZ());
-      //   mHistManager.fill(HIST("centralityFT0M"), collision.centFT0M);
-      //   mHistManager.fill(HIST("centralityFDDM"), collision.centFDDM);
-      //   mHistManager.fill(HIST("centralityNTPV"), collision.centNTPV);
+    mHistManager.fill(HIST("contributors"), col.numContrib());
+    mHistManager.fill(HIST("vertex"), col.posZ());
+    //   mHistManager.fill(HIST("centralityFT0M"), collision.centFT0M);
+    //   mHistManager.fill(HIST("centralityFDDM"), collision.centFDDM);
+    //   mHistManager.fill(HIST("centralityNTPV"), collision.centNTPV);
+
+    float cen = log(1. + col.numContrib()) / log(2.);
+    int iCenBin = static_cast<int>(cen / 10);
+    if (iCenBin < 0 || iCenBin > 9) {
+      return;
     }
+
+    mPhotons.clear();
     for (const auto& clu : clusters) {
 
       mHistManager.fill(HIST("cluETime"), clu.e(), clu.time(), clu.mod());
@@ -106,12 +125,6 @@ struct phosPi0 {
         continue;
       }
 
-      float cen1 = log(1. + clu.collision_as<o2::aod::Collisions>().numContrib()) / log(2.);
-      int iCenBin1 = static_cast<int>(cen1 / 10);
-      if (iCenBin1 < 0 || iCenBin1 > 9) {
-        continue;
-      }
-
       mHistManager.fill(HIST("cluSp"), clu.e(), clu.mod());
       if (clu.e() > mOccE) {
         double phi = 6.2831853 + atan2(clu.y(), clu.x()); // Only negative phi from tan2
@@ -119,37 +132,23 @@ struct phosPi0 {
         mHistManager.fill(HIST("cluE"), phi, clu.z(), clu.e());
         mHistManager.fill(HIST("cluTime"), phi, clu.z(), clu.time());
       }
+      mPhotons.push(clu.e(), clu.px(), clu.py(), clu.pz(), clu.mod());
+    }
 
-      // inv mass
-      auto clu2 = clu;
-      ++clu2;
-      int nMix = 2; // Number of photons to mix
-      for (; clu2 != clusters.end() && nMix > 0; clu2++) {
-        if (clu2.caloType() != 0 || clu2.e() < mMinCluE || clu2.ncell() < mMinCluNcell ||
-            clu2.time() > mMaxCluTime || clu2.time() < mMinCluTime) {
-          continue;
-        }
-        float cen2 = log(1. + clu2.collision_as<o2::aod::Collisions>().numContrib()) / log(2.);
-        int iCenBin2 = static_cast<int>(cen2 / 10);
-        if (iCenBin1 != iCenBin2) {
-          continue;
-        }
-
-        double m = pow(clu.e() + clu2.e(), 2) - pow(clu.px() + clu2.px(), 2) -
-                   pow(clu.py() + clu2.py(), 2) - pow(clu.pz() + clu2.pz(), 2);
-        if (m > 0) {
-          m = sqrt(m);
-        }
-        double pt = sqrt(pow(clu.px() + clu2.px(), 2) +
-                         pow(clu.py() + clu2.py(), 2));
-        if (clu.collision().bc().globalBC() == clu2.collision().bc().globalBC()) { // Real
-          mHistManager.fill(HIST("mggRe"), m, pt, cen1);
-        } else { // Mixed
-          --nMix;
-          mHistManager.fill(HIST("mggMi"), m, pt, cen1);
-        }
-      }
+    // inv mass
+    mMesonEngine.processSameEvent(mPhotons, [&](MesonCandidate const& pair) { // Real
+      mHistManager.fill(HIST("mggRe"), pair.mass, pair.pt, cen);
+    });
+    const int bin = mMixingPool.getBin(col.posZ(), cen);
+    if (bin < 0) {
+      return;
     }
+    mMixingPool.mix(bin, [&](PhotonStore const& pooled) { // Mixed
+      mMesonEngine.processMixedEvent(mPhotons, pooled, [&](MesonCandidate const& pair) {
+        mHistManager.fill(HIST("mggMi"), pair.mass, pair.pt, cen);
+      });
+    });
+    mMixingPool.push(bin, mPhotons);
   }
 };
 
@@ -16,6 +16,10 @@
 #define HF_SELECTOR_CUTS_H_
 
 #include "Framework/Configurable.h"
+#include "Framework/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -62,6 +66,168 @@ int findBin(T1 const& binsPt, T2 value)
   return std::distance(binsPt->begin(), std::upper_bound(binsPt->begin(), binsPt->end(), value)) - 1;
 }
 
+/// Compiled pT-binned cuts of a selector, built once from the pT bins and the cut array
+/// The cuts of a pT bin are stored contiguously and addressed by the index of the cut variable,
+/// and the pT bin is found without a binary search when the bins are uniform.
+class HfPtBinnedCuts
+{
+ public:
+  /// Direction of a cut in the batch selection
+  enum CutType {
+    Lower = 0,   // passes if value >= cut
+    LowerStrict, // passes if value > cut
+    Upper,       // passes if value <= cut
+    UpperAbs     // passes if |value| <= cut
+  };
+
+  /// Builds the table
+  /// \param binsPt  pT bin edges
+  /// \param cuts  cut array with one row per pT bin
+  void build(std::vector<double> const& binsPt, o2::framework::LabeledArray<double> const& cuts)
+  {
+    nBins = static_cast<int>(binsPt.size()) - 1;
+    nCuts = cuts.cols();
+    if (nBins < 1 || static_cast<int>(cuts.rows()) < nBins) {
+      LOGF(fatal, "Inconsistent pT bins (%d) and cut rows (%d)", nBins, cuts.rows());
+    }
+    edges = binsPt;
+    labels = cuts.getLabelsCols();
+    values.resize(nBins * nCuts);
+    for (int iBin = 0; iBin < nBins; ++iBin) {
+      for (int iCut = 0; iCut < nCuts; ++iCut) {
+        values[iBin * nCuts + iCut] = cuts.get(iBin, iCut);
+      }
+    }
+    // uniform bins are looked up arithmetically
+    const double width = (edges.back() - edges.front()) / nBins;
+    isUniform = width > 0.;
+    for (int iBin = 0; iBin < nBins && isUniform; ++iBin) {
+      isUniform = std::abs(edges[iBin + 1] - edges[iBin] - width) <= 1.e-9 * width;
+    }
+    invWidth = isUniform ? 1. / width : 0.;
+    rules.clear();
+  }
+
+  /// Finds the pT bin, with the same convention as findBin
+  /// \param pt  pT
+  /// \return index of the pT bin, -1 if out of range
+  int findBin(double pt) const
+  {
+    if (pt < edges.front() || pt >= edges.back()) {
+      return -1;
+    }
+    if (isUniform) {
+      int bin = std::min(static_cast<int>((pt - edges.front()) * invWidth), nBins - 1);
+      // correct the rounding at the bin edges
+      if (pt < edges[bin]) {
+        --bin;
+      } else if (pt >= edges[bin + 1]) {
+        ++bin;
+      }
+      return bin;
+    }
+    return std::distance(edges.begin(), std::upper_bound(edges.begin(), edges.end(), pt)) - 1;
+  }
+
+  /// \param label  label of the cut variable
+  /// \return index of the cut variable in the rows of the table
+  int getIndex(std::string const& label) const
+  {
+    auto it = std::find(labels.begin(), labels.end(), label);
+    if (it == labels.end()) {
+      LOGF(fatal, "Cut variable \"%s\" not found", label.c_str());
+    }
+    return std::distance(labels.begin(), it);
+  }
+
+  /// \return the cut with index iCut in the pT bin
+  double get(int bin, int iCut) const { return values[bin * nCuts + iCut]; }
+
+  /// \return the cuts of the pT bin
+  const double* getRow(int bin) const { return &values[bin * nCuts]; }
+
+  int getNBins() const { return nBins; }
+  bool hasUniformBins() const { return isUniform; }
+
+  /// Adds a cut to the batch selection
+  /// \param label  label of the cut variable
+  /// \param type  direction of the cut
+  /// \return bit of the cut in the masks of selectBatch
+  int addRule(std::string const& label, CutType type)
+  {
+    if (rules.size() >= 32) {
+      LOGF(fatal, "Too many cuts in the batch selection");
+    }
+    rules.push_back({getIndex(label), type});
+    return rules.size() - 1;
+  }
+
+  /// \return the mask of the candidates passing all the cuts of the batch selection
+  uint32_t getMaskAll() const { return rules.empty() ? 0u : (~0u >> (32 - rules.size())); }
+
+  /// Applies the cuts of the batch selection to a batch of candidates
+  /// \param nCandidates  number of candidates
+  /// \param pt  pT of the candidates
+  /// \param inputs  per rule, in the order of addRule, the values of the candidates
+  /// \param bins  filled with the pT bins of the candidates (-1 if out of range)
+  /// \param masks  filled with the bits of the passed cuts (0 if the pT is out of range)
+  template <typename TPt, typename TValue>
+  void selectBatch(std::size_t nCandidates, const TPt* pt, std::vector<const TValue*> const& inputs, std::vector<int>& bins, std::vector<uint32_t>& masks) const
+  {
+    if (inputs.size() != rules.size()) {
+      LOGF(fatal, "Got %d inputs for %d cuts", inputs.size(), rules.size());
+    }
+    bins.resize(nCandidates);
+    masks.assign(nCandidates, 0u);
+    for (std::size_t i = 0; i < nCandidates; ++i) {
+      bins[i] = findBin(pt[i]);
+    }
+    for (std::size_t iRule = 0; iRule < rules.size(); ++iRule) {
+      const auto [iCut, type] = rules[iRule];
+      const TValue* input = inputs[iRule];
+      const uint32_t bit = 1u << iRule;
+      for (std::size_t i = 0; i < nCandidates; ++i) {
+        if (bins[i] < 0) {
+          continue;
+        }
+        const double cut = values[bins[i] * nCuts + iCut];
+        const double value = input[i];
+        bool passed = false;
+        switch (type) {
+          case Lower:
+            passed = value >= cut;
+            break;
+          case LowerStrict:
+            passed = value > cut;
+            break;
+          case Upper:
+            passed = value <= cut;
+            break;
+          case UpperAbs:
+            passed = std::abs(value) <= cut;
+            break;
+        }
+        masks[i] |= passed ? bit : 0u;
+      }
+    }
+  }
+
+ private:
+  struct Rule {
+    int iCut;
+    CutType type;
+  };
+
+  int nBins = 0;
+  int nCuts = 0;
+  bool isUniform = false;
+  double invWidth = 0.;
+  std::vector<double> edges{};
+  std::vector<double> values{}; // nBins rows of nCuts cuts
+  std::vector<std::string> labels{};
+  std::vector<Rule> rules{};
+};
+
 // namespace per channel
 
 namespace hf_cuts_single_track
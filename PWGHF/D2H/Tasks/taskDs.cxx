@@ -140,8 +140,7 @@ struct HfTaskDs {
       }
       if (std::abs(candidate.flagMcMatchRec()) == 1 << DecayType::DsToKKPi) {
         // Get the corresponding MC particle.
-        auto indexMother = RecoDecay::getMother(particlesMC, candidate.prong0_as<aod::BigTracksMC>().mcParticle_as<soa::Join<aod::McParticles, aod::HfCand3ProngMcGen>>(), pdg::Code::kDS, true);
-        auto particleMother = particlesMC.iteratorAt(indexMother);
+        auto particleMother = particlesMC.rawIteratorAt(candidate.indexMcRec());
         registry.fill(HIST("hPtGenSig"), particleMother.pt()); // gen. level pT
         auto ptRec = candidate.pt();
         auto yRec = yDs(candidate);
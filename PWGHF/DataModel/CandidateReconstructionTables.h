@@ -199,6 +199,47 @@ DECLARE_SOA_TABLE(HfPvRefit3Prong, "AOD", "HFPVREFIT3PRONG", //!
                   hf_pv_refit_cand_3prong::PvRefitSigmaYZ,
                   hf_pv_refit_cand_3prong::PvRefitSigmaZ2);
 
+// secondary-vertex fit of the skimming, to be reused by the candidate creators
+namespace hf_sv_fit_2prong
+{
+DECLARE_SOA_COLUMN(XSvFit, xSvFit, float);                     //!
+DECLARE_SOA_COLUMN(YSvFit, ySvFit, float);                     //!
+DECLARE_SOA_COLUMN(ZSvFit, zSvFit, float);                     //!
+DECLARE_SOA_COLUMN(Chi2PCASvFit, chi2PCASvFit, float);         //!
+DECLARE_SOA_COLUMN(CovSvFit, covSvFit, float[6]);              //! covariance matrix of the secondary vertex
+DECLARE_SOA_COLUMN(ParProngsSvFit, parProngsSvFit, float[14]); //! x, alpha and parameters of the prongs propagated to the secondary vertex
+DECLARE_SOA_COLUMN(CovProngsSvFit, covProngsSvFit, float[30]); //! covariance matrices of the prongs propagated to the secondary vertex
+} // namespace hf_sv_fit_2prong
+
+DECLARE_SOA_TABLE(HfSvFit2Prong, "AOD", "HFSVFIT2PRONG", //! Secondary-vertex fit of the 2-prong candidates, joinable with Hf2Prongs
+                  hf_sv_fit_2prong::XSvFit,
+                  hf_sv_fit_2prong::YSvFit,
+                  hf_sv_fit_2prong::ZSvFit,
+                  hf_sv_fit_2prong::Chi2PCASvFit,
+                  hf_sv_fit_2prong::CovSvFit,
+                  hf_sv_fit_2prong::ParProngsSvFit,
+                  hf_sv_fit_2prong::CovProngsSvFit);
+
+namespace hf_sv_fit_3prong
+{
+DECLARE_SOA_COLUMN(XSvFit, xSvFit, float);                     //!
+DECLARE_SOA_COLUMN(YSvFit, ySvFit, float);                     //!
+DECLARE_SOA_COLUMN(ZSvFit, zSvFit, float);                     //!
+DECLARE_SOA_COLUMN(Chi2PCASvFit, chi2PCASvFit, float);         //!
+DECLARE_SOA_COLUMN(CovSvFit, covSvFit, float[6]);              //! covariance matrix of the secondary vertex
+DECLARE_SOA_COLUMN(ParProngsSvFit, parProngsSvFit, float[21]); //! x, alpha and parameters of the prongs propagated to the secondary vertex
+DECLARE_SOA_COLUMN(CovProngsSvFit, covProngsSvFit, float[45]); //! covariance matrices of the prongs propagated to the secondary vertex
+} // namespace hf_sv_fit_3prong
+
+DECLARE_SOA_TABLE(HfSvFit3Prong, "AOD", "HFSVFIT3PRONG", //! Secondary-vertex fit of the 3-prong candidates, joinable with Hf3Prongs
+                  hf_sv_fit_3prong::XSvFit,
+                  hf_sv_fit_3prong::YSvFit,
+                  hf_sv_fit_3prong::ZSvFit,
+                  hf_sv_fit_3prong::Chi2PCASvFit,
+                  hf_sv_fit_3prong::CovSvFit,
+                  hf_sv_fit_3prong::ParProngsSvFit,
+                  hf_sv_fit_3prong::CovProngsSvFit);
+
 // general decay properties
 namespace hf_cand
 {
@@ -318,6 +359,7 @@ DECLARE_SOA_COLUMN(FlagMcMatchRec, flagMcMatchRec, int8_t); //! reconstruction l
 DECLARE_SOA_COLUMN(FlagMcMatchGen, flagMcMatchGen, int8_t); //! generator level
 DECLARE_SOA_COLUMN(OriginMcRec, originMcRec, int8_t);       //! particle origin, reconstruction level
 DECLARE_SOA_COLUMN(OriginMcGen, originMcGen, int8_t);       //! particle origin, generator level
+DECLARE_SOA_COLUMN(IndexMcRec, indexMcRec, int);            //! index of the matched MC particle, -1 if not matched, reconstruction level
 
 // mapping of decay types
 enum DecayType { D0ToPiK = 0,
@@ -472,7 +514,8 @@ using HfCand2Prong = HfCand2ProngExt;
 // table with results of reconstruction level MC matching
 DECLARE_SOA_TABLE(HfCand2ProngMcRec, "AOD", "HFCAND2PMCREC", //!
                   hf_cand_2prong::FlagMcMatchRec,
-                  hf_cand_2prong::OriginMcRec);
+                  hf_cand_2prong::OriginMcRec,
+                  hf_cand_2prong::IndexMcRec);
 
 // table with results of generator level MC matching
 DECLARE_SOA_TABLE(HfCand2ProngMcGen, "AOD", "HFCAND2PMCGEN", //!
@@ -694,6 +737,7 @@ DECLARE_SOA_COLUMN(OriginMcGen, originMcGen, int8_t);               //! particle
 DECLARE_SOA_COLUMN(IsCandidateSwapped, isCandidateSwapped, int8_t); //! swapping of the prongs order
 DECLARE_SOA_COLUMN(FlagMcDecayChanRec, flagMcDecayChanRec, int8_t); //! resonant decay channel flag, reconstruction level
 DECLARE_SOA_COLUMN(FlagMcDecayChanGen, flagMcDecayChanGen, int8_t); //! resonant decay channel flag, generator level
+DECLARE_SOA_COLUMN(IndexMcRec, indexMcRec, int);                    //! index of the matched MC particle, -1 if not matched, reconstruction level
 
 // mapping of decay types
 enum DecayType { DplusToPiKPi = 0,
@@ -878,7 +922,8 @@ DECLARE_SOA_TABLE(HfCand3ProngMcRec, "AOD", "HFCAND3PMCREC", //!
                   hf_cand_3prong::FlagMcMatchRec,
                   hf_cand_3prong::OriginMcRec,
                   hf_cand_3prong::IsCandidateSwapped,
-                  hf_cand_3prong::FlagMcDecayChanRec);
+                  hf_cand_3prong::FlagMcDecayChanRec,
+                  hf_cand_3prong::IndexMcRec);
 
 // table with results of generator level MC matching
 DECLARE_SOA_TABLE(HfCand3ProngMcGen, "AOD", "HFCAND3PMCGEN", //!
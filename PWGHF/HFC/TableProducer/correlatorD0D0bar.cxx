@@ -79,6 +79,11 @@ struct HfCorrelatorD0D0bar {
   Configurable<double> multMax{"multMax", 10000., "maximum multiplicity accepted"};
   Configurable<std::vector<double>> binsPt{"binsPt", std::vector<double>{o2::analysis::hf_cuts_d0_to_pi_k::vecBinsPt}, "pT bin limits for candidate mass plots and efficiency"};
   Configurable<std::vector<double>> efficiencyD{"efficiencyD", std::vector<double>{efficiencyDmeson_v}, "Efficiency values for D0 meson"};
+  Configurable<bool> fillHistoPairs{"fillHistoPairs", false, "Accumulate the pairs in histograms in the correlator, in addition to the pair tables"};
+  Configurable<double> downSamplePairs{"downSamplePairs", 1., "Fraction of pairs stored in the pair tables when the pairs are accumulated in histograms"};
+  ConfigurableAxis axisDeltaPhi{"axisDeltaPhi", {64, -o2::constants::math::PI / 2., 3. * o2::constants::math::PI / 2.}, "#Delta#varphi binning of the accumulated pairs"};
+  ConfigurableAxis axisDeltaEta{"axisDeltaEta", {40, -2., 2.}, "#Delta#eta binning of the accumulated pairs"};
+  ConfigurableAxis axisMassPairs{"axisMassPairs", {60, 1.5848, 2.1848}, "D0 inv. mass binning of the accumulated pairs, for the signal and sideband regions"};
 
   Partition<soa::Join<aod::HfCand2Prong, aod::HfSelD0>> selectedD0Candidates = aod::hf_sel_candidate_d0::isSelD0 >= selectionFlagD0 || aod::hf_sel_candidate_d0::isSelD0bar >= selectionFlagD0bar;
   Partition<soa::Join<aod::HfCand2Prong, aod::HfSelD0, aod::HfCand2ProngMcRec>> selectedD0candidatesMC = aod::hf_sel_candidate_d0::isSelD0 >= selectionFlagD0 || aod::hf_sel_candidate_d0::isSelD0bar >= selectionFlagD0bar;
@@ -127,6 +132,29 @@ struct HfCorrelatorD0D0bar {
     registry.add("hMassD0barMCRecBkg", "D0bar background candidates - MC reco;inv. mass D0bar only (#pi K) (GeV/#it{c}^{2});entries", {HistType::kTH2F, {{massAxisBins, massAxisMin, massAxisMax}, {vbins, "#it{p}_{T} (GeV/#it{c})"}}});
     registry.add("hCountD0triggersMCGen", "D0 trigger particles - MC gen;;N of trigger D0", {HistType::kTH2F, {{1, -0.5, 0.5}, {vbins, "#it{p}_{T} (GeV/#it{c})"}}});
     registry.add("hCountCtriggersMCGen", "c trigger particles - MC gen;;N of trigger c quark", {HistType::kTH2F, {{1, -0.5, 0.5}, {vbins, "#it{p}_{T} (GeV/#it{c})"}}});
+    if (fillHistoPairs) {
+      // pairs weighted with the D-meson efficiencies, the last axis is the pair signal status (always 0 in data)
+      registry.add("hCorrel2DVsPtMass", "D0,D0bar pairs;#Delta#varphi;#Delta#eta;#it{p}_{T}^{D0} (GeV/#it{c});#it{p}_{T}^{D0bar} (GeV/#it{c});inv. mass D0 (#pi K) (GeV/#it{c}^{2});inv. mass D0bar (#pi K) (GeV/#it{c}^{2});pair signal status;entries",
+                   {HistType::kTHnSparseD, {{axisDeltaPhi}, {axisDeltaEta}, {vbins}, {vbins}, {axisMassPairs}, {axisMassPairs}, {9, -0.5, 8.5}}});
+      registry.get<THnSparse>(HIST("hCorrel2DVsPtMass"))->Sumw2();
+    }
+  }
+
+  /// Fills the pair histogram and decides whether the pair is also stored in the pair tables
+  /// \return true if the pair has to be stored in the pair tables, always true when the pairs are not accumulated in histograms
+  template <typename T>
+  bool fillPair(T const& candidate1, T const& candidate2, int pairSignalStatus, double efficiencyWeight)
+  {
+    if (!fillHistoPairs) {
+      return true;
+    }
+    if (applyEfficiency) {
+      efficiencyWeight /= efficiencyD->at(o2::analysis::findBin(binsPt, candidate2.pt()));
+    }
+    registry.fill(HIST("hCorrel2DVsPtMass"), getDeltaPhi(candidate2.phi(), candidate1.phi()), candidate2.eta() - candidate1.eta(), candidate1.pt(), candidate2.pt(),
+                  invMassD0ToPiK(candidate1), invMassD0barToKPi(candidate2), pairSignalStatus, efficiencyWeight);
+    double pseudoRndm = candidate2.ptProng0() * 1000. - (long)(candidate2.ptProng0() * 1000);
+    return pseudoRndm < downSamplePairs;
   }
 
   /// D0-D0bar correlation pair builder - for real data and data-like analysis (i.e. reco-level w/o matching request via MC truth)
@@ -209,13 +237,15 @@ struct HfCorrelatorD0D0bar {
         if (candidate1.mRowIndex == candidate2.mRowIndex) {
           continue;
         }
-        entryD0D0barPair(getDeltaPhi(candidate2.phi(), candidate1.phi()),
-                         candidate2.eta() - candidate1.eta(),
-                         candidate1.pt(),
-                         candidate2.pt());
-        entryD0D0barRecoInfo(invMassD0ToPiK(candidate1),
-                             invMassD0barToKPi(candidate2),
-                             0);
+        if (fillPair(candidate1, candidate2, 0, efficiencyWeight)) {
+          entryD0D0barPair(getDeltaPhi(candidate2.phi(), candidate1.phi()),
+                           candidate2.eta() - candidate1.eta(),
+                           candidate1.pt(),
+                           candidate2.pt());
+          entryD0D0barRecoInfo(invMassD0ToPiK(candidate1),
+                               invMassD0barToKPi(candidate2),
+                               0);
+        }
         double etaCut = 0.;
         double ptCut = 0.;
         do { // fill pairs vs etaCut plot
@@ -353,13 +383,15 @@ struct HfCorrelatorD0D0bar {
         if (flagD0barReflection) {
           pairSignalStatus += 1;
         }
-        entryD0D0barPair(getDeltaPhi(candidate2.phi(), candidate1.phi()),
-                         candidate2.eta() - candidate1.eta(),
-                         candidate1.pt(),
-                         candidate2.pt());
-        entryD0D0barRecoInfo(invMassD0ToPiK(candidate1),
-                             invMassD0barToKPi(candidate2),
-                             pairSignalStatus);
+        if (fillPair(candidate1, candidate2, pairSignalStatus, efficiencyWeight)) {
+          entryD0D0barPair(getDeltaPhi(candidate2.phi(), candidate1.phi()),
+                           candidate2.eta() - candidate1.eta(),
+                           candidate1.pt(),
+                           candidate2.pt());
+          entryD0D0barRecoInfo(invMassD0ToPiK(candidate1),
+                               invMassD0barToKPi(candidate2),
+                               pairSignalStatus);
+        }
         double etaCut = 0.;
         double ptCut = 0.;
         do { // fill pairs vs etaCut plot
@@ -74,6 +74,12 @@ struct HfCorrelatorDplusHadrons {
   Configurable<double> multMax{"multMax", 10000., "maximum multiplicity accepted"};
   Configurable<std::vector<double>> binsPt{"binsPt", std::vector<double>{o2::analysis::hf_cuts_dplus_to_pi_k_pi::vecBinsPt}, "pT bin limits for candidate mass plots and efficiency"};
   Configurable<std::vector<double>> efficiencyD{"efficiencyD", std::vector<double>{efficiencyDmeson_v}, "Efficiency values for Dplus meson"};
+  Configurable<bool> fillHistoPairs{"fillHistoPairs", false, "Accumulate the pairs in histograms in the correlator, in addition to the pair tables"};
+  Configurable<double> downSamplePairs{"downSamplePairs", 1., "Fraction of pairs stored in the pair tables when the pairs are accumulated in histograms"};
+  ConfigurableAxis axisDeltaPhi{"axisDeltaPhi", {64, -o2::constants::math::PI / 2., 3. * o2::constants::math::PI / 2.}, "#Delta#varphi binning of the accumulated pairs"};
+  ConfigurableAxis axisDeltaEta{"axisDeltaEta", {40, -2., 2.}, "#Delta#eta binning of the accumulated pairs"};
+  ConfigurableAxis axisPtHadron{"axisPtHadron", {11, 0., 11.}, "hadron #it{p}_{T} binning of the accumulated pairs"};
+  ConfigurableAxis axisMassPairs{"axisMassPairs", {70, 1.7, 2.05}, "Dplus inv. mass binning of the accumulated pairs, for the signal and sideband regions"};
 
   Partition<soa::Join<aod::HfCand3Prong, aod::HfSelDplusToPiKPi>> selectedDPlusCandidates = aod::hf_sel_candidate_dplus::isSelDplusToPiKPi >= selectionFlagDplus;
   Partition<soa::Join<aod::HfCand3Prong, aod::HfSelDplusToPiKPi, aod::HfCand3ProngMcRec>> recoFlagDPlusCandidates = aod::hf_sel_candidate_dplus::isSelDplusToPiKPi > 0;
@@ -114,6 +120,24 @@ struct HfCorrelatorDplusHadrons {
     registry.add("hMassDplusMCRecSig", "Dplus signal candidates - MC reco;inv. mass (#pi K) (GeV/#it{c}^{2});entries", {HistType::kTH2F, {{massAxisBins, massAxisMin, massAxisMax}, {vbins, "#it{p}_{T} (GeV/#it{c})"}}});
     registry.add("hMassDplusMCRecBkg", "Dplus background candidates - MC reco;inv. mass (#pi K) (GeV/#it{c}^{2});entries", {HistType::kTH2F, {{massAxisBins, massAxisMin, massAxisMax}, {vbins, "#it{p}_{T} (GeV/#it{c})"}}});
     registry.add("hcountDplustriggersMCGen", "Dplus trigger particles - MC gen;;N of trigger Dplus", {HistType::kTH2F, {{1, -0.5, 0.5}, {vbins, "#it{p}_{T} (GeV/#it{c})"}}});
+    if (fillHistoPairs) {
+      // pairs weighted with the D-meson efficiency, the last axis flags the MC-matched signal (always 0 in data)
+      registry.add("hCorrel2DVsPtMass", "Dplus,Hadron pairs;#Delta#varphi;#Delta#eta;#it{p}_{T}^{D} (GeV/#it{c});#it{p}_{T}^{h} (GeV/#it{c});inv. mass (K^{-}#pi^{+}#pi^{+}) (GeV/#it{c}^{2});signal;entries",
+                   {HistType::kTHnSparseD, {{axisDeltaPhi}, {axisDeltaEta}, {vbins}, {axisPtHadron}, {axisMassPairs}, {2, -0.5, 1.5}}});
+      registry.get<THnSparse>(HIST("hCorrel2DVsPtMass"))->Sumw2();
+    }
+  }
+
+  /// Fills the pair histogram and decides whether the pair is also stored in the pair tables
+  /// \return true if the pair has to be stored in the pair tables, always true when the pairs are not accumulated in histograms
+  bool fillPair(double deltaPhi, double deltaEta, double ptD, double ptHadron, double invMass, bool isSignal, double efficiencyWeight)
+  {
+    if (!fillHistoPairs) {
+      return true;
+    }
+    registry.fill(HIST("hCorrel2DVsPtMass"), deltaPhi, deltaEta, ptD, ptHadron, invMass, (double)isSignal, efficiencyWeight);
+    double pseudoRndm = ptHadron * 1000. - (long)(ptHadron * 1000);
+    return pseudoRndm < downSamplePairs;
   }
 
   /// Dplus-hadron correlation pair builder - for real data and data-like analysis (i.e. reco-level w/o matching request via MC truth)
@@ -184,6 +208,9 @@ struct HfCorrelatorDplusHadrons {
         if ((candidate1.prong0Id() == track.mRowIndex) || (candidate1.prong1Id() == track.mRowIndex) || (candidate1.prong2Id() == track.mRowIndex)) {
           continue;
         }
+        if (!fillPair(getDeltaPhi(track.phi(), candidate1.phi()), track.eta() - candidate1.eta(), candidate1.pt(), track.pt(), invMassDplusToPiKPi(candidate1), false, efficiencyWeight)) {
+          continue;
+        }
         entryDplusHadronPair(getDeltaPhi(track.phi(), candidate1.phi()),
                              track.eta() - candidate1.eta(),
                              candidate1.pt(),
@@ -273,6 +300,9 @@ struct HfCorrelatorDplusHadrons {
         if (std::abs(track.dcaXY()) >= dcaXYTrackMax || std::abs(track.dcaZ()) >= dcaZTrackMax) {
           continue; // Remove secondary tracks
         }
+        if (!fillPair(getDeltaPhi(track.phi(), candidate1.phi()), track.eta() - candidate1.eta(), candidate1.pt(), track.pt(), invMassDplusToPiKPi(candidate1), flagDplusSignal, efficiencyWeight)) {
+          continue;
+        }
         entryDplusHadronPair(getDeltaPhi(track.phi(), candidate1.phi()),
                              track.eta() - candidate1.eta(),
                              candidate1.pt(),
@@ -40,6 +40,44 @@ namespace dq_analysis_flags
 DECLARE_SOA_COLUMN(IsEventSelected, isEventSelected, int);
 }
 DECLARE_SOA_TABLE(EventCuts, "AOD", "EVENTCUTS", dq_analysis_flags::IsEventSelected);
+
+namespace hf_single_muon
+{
+DECLARE_SOA_INDEX_COLUMN(Collision, collision);               //!
+DECLARE_SOA_COLUMN(Pt, pt, float);                            //!
+DECLARE_SOA_COLUMN(Eta, eta, float);                          //!
+DECLARE_SOA_COLUMN(P, p, float);                              //!
+DECLARE_SOA_COLUMN(Sign, sign, int8_t);                       //!
+DECLARE_SOA_COLUMN(DcaXY, dcaXY, float);                      //! DCA in the transverse plane (cm)
+DECLARE_SOA_COLUMN(PDca, pDca, float);                        //! product of the momentum and the DCA (GeV/c cm)
+DECLARE_SOA_COLUMN(Chi2MatchMCHMID, chi2MatchMCHMID, float);  //!
+DECLARE_SOA_COLUMN(TrackType, trackType, uint8_t);            //!
+DECLARE_SOA_COLUMN(IsMuonSelected, isMuonSelected, uint32_t); //! bit i set if the muon passes the i-th selection of muonCutsSkim
+DECLARE_SOA_COLUMN(McMask, mcMask, uint16_t);                 //!
+DECLARE_SOA_COLUMN(PtGen, ptGen, float);                      //!
+DECLARE_SOA_COLUMN(EtaGen, etaGen, float);                    //!
+DECLARE_SOA_COLUMN(PGen, pGen, float);                        //!
+} // namespace hf_single_muon
+
+// compact forward muons of the selected events, read instead of the full FwdTracks by the single-muon analysis
+DECLARE_SOA_TABLE(HfSingleMuons, "AOD", "HFSINGLEMUON", //!
+                  hf_single_muon::CollisionId,
+                  hf_single_muon::Pt,
+                  hf_single_muon::Eta,
+                  hf_single_muon::P,
+                  hf_single_muon::Sign,
+                  hf_single_muon::DcaXY,
+                  hf_single_muon::PDca,
+                  hf_single_muon::Chi2MatchMCHMID,
+                  hf_single_muon::TrackType,
+                  hf_single_muon::IsMuonSelected);
+
+// MC information of the compact forward muons, joinable with HfSingleMuons
+DECLARE_SOA_TABLE(HfSingleMuonsMc, "AOD", "HFSINGLEMUONMC", //!
+                  hf_single_muon::McMask,
+                  hf_single_muon::PtGen,
+                  hf_single_muon::EtaGen,
+                  hf_single_muon::PGen);
 } // namespace o2::aod
 
 using MyCollisions = o2::soa::Join<aod::Collisions, aod::EvSels>;
@@ -122,8 +160,111 @@ struct HfTaskSingleMuonEventSelection {
   PROCESS_SWITCH(HfTaskSingleMuonEventSelection, processEventMc, "run event selection with MC data", false);
 };
 
+/// Writes the forward muons of the selected events in the compact HfSingleMuons table
+/// The muon selections of muonCutsSkim are evaluated once here and stored as a bit mask, so that the analysis of the
+/// compact table applies any of them with a bit test, without reading the full FwdTracks again.
+struct HfTaskSingleMuonSkim {
+  Produces<aod::HfSingleMuons> rowMuon;
+  Produces<aod::HfSingleMuonsMc> rowMuonMc;
+
+  Configurable<std::string> muonCutsSkim{"muonCutsSkim", "muonQualityCuts", "comma-separated muon selections, each filling one bit of the selection mask"};
+  Configurable<bool> keepRejected{"keepRejected", true, "write also the muons not passing any selection"};
+
+  float* values;
+  std::vector<AnalysisCompositeCut> trackCuts;
+
+  void init(o2::framework::InitContext&)
+  {
+    VarManager::SetDefaultVarNames();
+    values = new float[VarManager::kNVars];
+
+    std::unique_ptr<TObjArray> objArray(TString(muonCutsSkim.value).Tokenize(","));
+    if (objArray->GetEntries() == 0 || objArray->GetEntries() > 32) {
+      LOGF(fatal, "Between 1 and 32 muon selections are needed for the selection mask, got %d", objArray->GetEntries());
+    }
+    trackCuts.reserve(objArray->GetEntries());
+    for (int iCut = 0; iCut < objArray->GetEntries(); ++iCut) {
+      trackCuts.emplace_back(true);
+      trackCuts.back().AddCut(dqcuts::GetAnalysisCut(objArray->At(iCut)->GetName()));
+    }
+    VarManager::SetUseVars(AnalysisCut::fgUsedVars);
+  }
+
+  /// Fills the values of the track and returns its selection mask
+  template <uint32_t TMuonFillMap, typename TMuon>
+  uint32_t fillMuonValues(TMuon const& track)
+  {
+    VarManager::FillTrack<TMuonFillMap>(track, values);
+    uint32_t mask = 0;
+    for (std::size_t iCut = 0; iCut < trackCuts.size(); ++iCut) {
+      if (trackCuts[iCut].IsSelected(values)) {
+        mask |= (1u << iCut);
+      }
+    }
+    return mask;
+  }
+
+  template <typename TMuon>
+  void writeMuon(TMuon const& track, uint32_t mask)
+  {
+    const auto dcaXY(std::sqrt(values[VarManager::kMuonDCAx] * values[VarManager::kMuonDCAx] + values[VarManager::kMuonDCAy] * values[VarManager::kMuonDCAy]));
+    rowMuon(track.collisionId(),
+            values[VarManager::kPt],
+            values[VarManager::kEta],
+            track.p(),
+            static_cast<int8_t>(values[VarManager::kCharge]),
+            dcaXY,
+            values[VarManager::kMuonPDca],
+            values[VarManager::kMuonChi2MatchMCHMID],
+            track.trackType(),
+            mask);
+  }
+
+  void processMuon(MyEventsSelected::iterator const& event, aod::BCs const& bcs,
+                   MyMuons const& tracks)
+  {
+    if (event.isEventSelected() == 0) {
+      return;
+    }
+    VarManager::ResetValues(0, VarManager::kNMuonTrackVariables, values);
+    for (auto const& track : tracks) {
+      const auto mask = fillMuonValues<gMuonFillMap>(track);
+      if (mask == 0 && !keepRejected) {
+        continue;
+      }
+      writeMuon(track, mask);
+    }
+  }
+
+  void processMuonMc(MyMcEventsSelected::iterator const& event, aod::BCs const& bcs,
+                     MyMcMuons const& tracks, aod::McParticles const& mc)
+  {
+    if (event.isEventSelected() == 0) {
+      return;
+    }
+    VarManager::ResetValues(0, VarManager::kNMuonTrackVariables, values);
+    for (auto const& track : tracks) {
+      // the muons without MC particle are skipped as in the analysis of the full tracks
+      if (!track.has_mcParticle()) {
+        continue;
+      }
+      const auto mask = fillMuonValues<gMuonFillMap>(track);
+      if (mask == 0 && !keepRejected) {
+        continue;
+      }
+      writeMuon(track, mask);
+      auto mcParticle = track.mcParticle();
+      rowMuonMc(track.mcMask(), mcParticle.pt(), mcParticle.eta(), mcParticle.p());
+    }
+  }
+
+  PROCESS_SWITCH(HfTaskSingleMuonSkim, processMuon, "write the compact muons with real data", false);
+  PROCESS_SWITCH(HfTaskSingleMuonSkim, processMuonMc, "write the compact muons with MC data", false);
+};
+
 struct HfTaskSingleMuonSelection {
   Configurable<std::string> muonCuts{"muonCuts", "muonQualityCuts", "muon selection"};
+  Configurable<int> muonCutBit{"muonCutBit", 0, "bit of the selection mask of HfSingleMuons used as muon selection when processing the compact muons"};
 
   float* values;
   AnalysisCompositeCut* trackCut;
@@ -285,14 +426,55 @@ struct HfTaskSingleMuonSelection {
     runMuonSelMC<gEventFillMap, gMuonFillMap, gTrackMCFillMap>(event, bcs, tracks, mc);
   }
 
+  void processMuonSkimmed(MyEventsSelected::iterator const& event, aod::HfSingleMuons const& muons)
+  {
+    if (event.isEventSelected() == 0) {
+      return;
+    }
+    const uint32_t maskSelected = 1u << muonCutBit;
+    for (auto const& muon : muons) {
+      // Before Muon Cuts
+      registry.fill(HIST("hMuBcuts"), muon.pt(), muon.eta(), muon.dcaXY(), muon.sign(), muon.p(), event.posZ(), muon.trackType(), 0);
+      // After Muon Cuts
+      if (muon.isMuonSelected() & maskSelected) {
+        registry.fill(HIST("hMuAcuts"), muon.pt(), muon.eta(), muon.dcaXY(), muon.sign(), muon.p(), event.posZ(), muon.trackType(), 0);
+      }
+    }
+  }
+
+  void processMuonMcSkimmed(MyMcEventsSelected::iterator const& event, soa::Join<aod::HfSingleMuons, aod::HfSingleMuonsMc> const& muons)
+  {
+    if (event.isEventSelected() == 0) {
+      return;
+    }
+    const uint32_t maskSelected = 1u << muonCutBit;
+    for (auto const& muon : muons) {
+      // Before Muon Cuts
+      registry.fill(HIST("hMuBcuts"), muon.pt(), muon.eta(), muon.dcaXY(), muon.sign(), muon.p(), event.posZ(), muon.trackType(), muon.mcMask());
+      registry.fill(HIST("hPTBcuts"), muon.pt(), muon.ptGen(), muon.ptGen() - muon.pt(), muon.trackType());
+      registry.fill(HIST("hEtaBcuts"), muon.eta(), muon.etaGen(), muon.etaGen() - muon.eta(), muon.trackType());
+      registry.fill(HIST("hPBcuts"), muon.p(), muon.pGen(), muon.pGen() - muon.p(), muon.trackType());
+      // After Muon Cuts
+      if (muon.isMuonSelected() & maskSelected) {
+        registry.fill(HIST("hMuAcuts"), muon.pt(), muon.eta(), muon.dcaXY(), muon.sign(), muon.p(), event.posZ(), muon.trackType(), muon.mcMask());
+        registry.fill(HIST("hPTAcuts"), muon.pt(), muon.ptGen(), muon.ptGen() - muon.pt(), muon.trackType());
+        registry.fill(HIST("hEtaAcuts"), muon.eta(), muon.etaGen(), muon.etaGen() - muon.eta(), muon.trackType());
+        registry.fill(HIST("hPAcuts"), muon.p(), muon.pGen(), muon.pGen() - muon.p(), muon.trackType());
+      }
+    }
+  }
+
   PROCESS_SWITCH(HfTaskSingleMuonSelection, processMuon, "run muon selection with real data", true);
   PROCESS_SWITCH(HfTaskSingleMuonSelection, processMuonMc, "run muon selection with MC data", false);
+  PROCESS_SWITCH(HfTaskSingleMuonSelection, processMuonSkimmed, "run muon selection on the compact muons with real data", false);
+  PROCESS_SWITCH(HfTaskSingleMuonSelection, processMuonMcSkimmed, "run muon selection on the compact muons with MC data", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
 {
   return WorkflowSpec{
     adaptAnalysisTask<HfTaskSingleMuonEventSelection>(cfgc),
+    adaptAnalysisTask<HfTaskSingleMuonSkim>(cfgc),
     adaptAnalysisTask<HfTaskSingleMuonSelection>(cfgc),
   };
 }
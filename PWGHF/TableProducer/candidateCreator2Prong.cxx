@@ -19,6 +19,7 @@
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/CandidateReconstructionTables.h"
 #include "PWGHF/Utils/utilsBfieldCCDB.h"
+#include "PWGHF/Utils/utilsSvFit.h"
 #include "Common/Core/trackUtilities.h"
 #include "ReconstructionDataFormats/DCA.h"
 
@@ -62,6 +63,7 @@ struct HfCandidateCreator2Prong {
   double massPiK{0.};
   double massKPi{0.};
   double bz = 0.;
+  TrackParCovCache<> trackParCovCache; // track parameters of the dataframe, shared by the candidates
 
   OutputObj<TH1F> hMass2{TH1F("hMass2", "2-prong candidates;inv. mass (#pi K) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
   OutputObj<TH1F> hCovPVXX{TH1F("hCovPVXX", "2-prong candidates;XX element of cov. matrix of prim. vtx. position (cm^{2});entries", 100, 0., 1.e-4)};
@@ -80,17 +82,21 @@ struct HfCandidateCreator2Prong {
     ccdb->setURL(ccdbUrl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(ccdbPathLut));
+    lut = o2::common::CCDBObjectCache::instance().getMatLUT(ccdb, ccdbPathLut);
     if (!o2::base::GeometryManager::isGeometryLoaded()) {
       ccdb->get<TGeoManager>(ccdbPathGeo);
     }
     runNumber = 0;
+
+    if (doprocessFit && doprocessSkimSvFit) {
+      LOGF(fatal, "Cannot enable processFit and processSkimSvFit at the same time. Please choose one.");
+    }
   }
 
-  void process(aod::Collisions const& collisions,
-               soa::Join<aod::Hf2Prongs, aod::HfPvRefit2Prong> const& rowsTrackIndexProng2,
-               aod::BigTracks const& tracks,
-               aod::BCsWithTimestamps const& bcWithTimeStamps)
+  /// Builds the candidates from the track indices of the skimming
+  /// \tparam reuseSvFit uses the secondary-vertex fits stored by the skimming instead of refitting the vertices
+  template <bool reuseSvFit, typename TRows>
+  void createCandidates(TRows const& rowsTrackIndexProng2)
   {
     // 2-prong vertex fitter
     o2::vertexing::DCAFitterN<2> df;
@@ -106,8 +112,6 @@ struct HfCandidateCreator2Prong {
     for (const auto& rowTrackIndexProng2 : rowsTrackIndexProng2) {
       auto track0 = rowTrackIndexProng2.prong0_as<aod::BigTracks>();
       auto track1 = rowTrackIndexProng2.prong1_as<aod::BigTracks>();
-      auto trackParVarPos1 = getTrackParCov(track0);
-      auto trackParVarNeg1 = getTrackParCov(track1);
       auto collision = track0.collision();
 
       /// Set the magnetic field from ccdb.
@@ -124,19 +128,27 @@ struct HfCandidateCreator2Prong {
       }
       df.setBz(bz);
 
-      // reconstruct the 2-prong secondary vertex
-      if (df.process(trackParVarPos1, trackParVarNeg1) == 0) {
-        continue;
+      // reconstruct the 2-prong secondary vertex, or take the one fitted in the skimming
+      o2::hf_sv_fit::SvFit<2> svFit;
+      if constexpr (reuseSvFit) {
+        svFit = o2::hf_sv_fit::fromTable<2>(rowTrackIndexProng2);
+      } else {
+        const auto& trackParVarPos1 = trackParCovCache.get(track0);
+        const auto& trackParVarNeg1 = trackParCovCache.get(track1);
+        if (df.process(trackParVarPos1, trackParVarNeg1) == 0) {
+          continue;
+        }
+        svFit = o2::hf_sv_fit::fromFitter<2>(df);
       }
-      const auto& secondaryVertex = df.getPCACandidate();
-      auto chi2PCA = df.getChi2AtPCACandidate();
-      auto covMatrixPCA = df.calcPCACovMatrixFlat();
+      const auto& secondaryVertex = svFit.position;
+      auto chi2PCA = svFit.chi2PCA;
+      auto covMatrixPCA = svFit.cov;
       hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
       hCovSVYY->Fill(covMatrixPCA[2]);
       hCovSVXZ->Fill(covMatrixPCA[3]);
       hCovSVZZ->Fill(covMatrixPCA[5]);
-      auto trackParVar0 = df.getTrack(0);
-      auto trackParVar1 = df.getTrack(1);
+      auto trackParVar0 = o2::hf_sv_fit::getProng(svFit, 0);
+      auto trackParVar1 = o2::hf_sv_fit::getProng(svFit, 1);
 
       // get track momenta
       array<float, 3> pvec0;
@@ -200,13 +212,35 @@ struct HfCandidateCreator2Prong {
       if (fillHistograms) {
         // calculate invariant masses
         auto arrayMomenta = array{pvec0, pvec1};
-        massPiK = RecoDecay::m(arrayMomenta, array{massPi, massK});
-        massKPi = RecoDecay::m(arrayMomenta, array{massK, massPi});
+        auto massHypos = RecoDecay::m2Hypos(arrayMomenta, array{array{massPi, massK}, array{massK, massPi}});
+        massPiK = std::sqrt(massHypos[0]);
+        massKPi = std::sqrt(massHypos[1]);
         hMass2->Fill(massPiK);
         hMass2->Fill(massKPi);
       }
     }
   }
+
+  void processFit(aod::Collisions const& collisions,
+                  soa::Join<aod::Hf2Prongs, aod::HfPvRefit2Prong> const& rowsTrackIndexProng2,
+                  aod::BigTracks const& tracks,
+                  aod::BCsWithTimestamps const& bcWithTimeStamps)
+  {
+    trackParCovCache.reset(tracks.size());
+    createCandidates<false>(rowsTrackIndexProng2);
+  }
+
+  PROCESS_SWITCH(HfCandidateCreator2Prong, processFit, "Fit the secondary vertices of the candidates", true);
+
+  void processSkimSvFit(aod::Collisions const& collisions,
+                        soa::Join<aod::Hf2Prongs, aod::HfPvRefit2Prong, aod::HfSvFit2Prong> const& rowsTrackIndexProng2,
+                        aod::BigTracks const& tracks,
+                        aod::BCsWithTimestamps const& bcWithTimeStamps)
+  {
+    createCandidates<true>(rowsTrackIndexProng2);
+  }
+
+  PROCESS_SWITCH(HfCandidateCreator2Prong, processSkimSvFit, "Reuse the secondary vertices fitted in the skimming (requires fillSvFit in the skimming, with the same fitter settings)", false);
 };
 
 /// Extends the base table with expression columns.
@@ -215,6 +249,8 @@ struct HfCandidateCreator2ProngExpressions {
   Produces<aod::HfCand2ProngMcRec> rowMcMatchRec;
   Produces<aod::HfCand2ProngMcGen> rowMcMatchGen;
 
+  RecoDecay::MCAncestry mcAncestry; // flattened MC mother tree of the dataframe
+
   void init(InitContext const&) {}
 
   /// Performs MC matching.
@@ -222,6 +258,7 @@ struct HfCandidateCreator2ProngExpressions {
                  aod::McParticles const& particlesMC)
   {
     rowCandidateProng2->bindExternalIndices(&tracks);
+    mcAncestry.fill(particlesMC);
 
     int indexRec = -1;
     int8_t sign = 0;
@@ -238,7 +275,7 @@ struct HfCandidateCreator2ProngExpressions {
 
       // D0(bar) → π± K∓
       // Printf("Checking D0(bar) → π± K∓");
-      indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kD0, array{+kPiPlus, -kKPlus}, true, &sign);
+      indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kD0, array{+kPiPlus, -kKPlus}, true, &sign, 1, &mcAncestry);
       if (indexRec > -1) {
         flag = sign * (1 << DecayType::D0ToPiK);
       }
@@ -246,7 +283,7 @@ struct HfCandidateCreator2ProngExpressions {
       // J/ψ → e+ e−
       if (flag == 0) {
         // Printf("Checking J/ψ → e+ e−");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJPsi, array{+kElectron, -kElectron}, true);
+        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJPsi, array{+kElectron, -kElectron}, true, nullptr, 1, &mcAncestry);
         if (indexRec > -1) {
           flag = 1 << DecayType::JpsiToEE;
         }
@@ -255,7 +292,7 @@ struct HfCandidateCreator2ProngExpressions {
       // J/ψ → μ+ μ−
       if (flag == 0) {
         // Printf("Checking J/ψ → μ+ μ−");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJPsi, array{+kMuonPlus, -kMuonPlus}, true);
+        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kJPsi, array{+kMuonPlus, -kMuonPlus}, true, nullptr, 1, &mcAncestry);
         if (indexRec > -1) {
           flag = 1 << DecayType::JpsiToMuMu;
         }
@@ -264,10 +301,12 @@ struct HfCandidateCreator2ProngExpressions {
       // Check whether the particle is non-prompt (from a b quark).
       if (flag != 0) {
         auto particle = particlesMC.rawIteratorAt(indexRec);
-        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle, false, &mcAncestry);
+      } else {
+        indexRec = -1;
       }
 
-      rowMcMatchRec(flag, origin);
+      rowMcMatchRec(flag, origin, indexRec);
     }
 
     // Match generated particles.
@@ -300,7 +339,7 @@ struct HfCandidateCreator2ProngExpressions {
 
       // Check whether the particle is non-prompt (from a b quark).
       if (flag != 0) {
-        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle, false, &mcAncestry);
       }
 
       rowMcMatchGen(flag, origin);
@@ -19,6 +19,7 @@
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/CandidateReconstructionTables.h"
 #include "PWGHF/Utils/utilsBfieldCCDB.h"
+#include "PWGHF/Utils/utilsSvFit.h"
 #include "Common/Core/trackUtilities.h"
 #include "ReconstructionDataFormats/DCA.h"
 
@@ -67,6 +68,7 @@ struct HfCandidateCreator3Prong {
   double massK = RecoDecay::getMassPDG(kKPlus);
   double massPiKPi{0.};
   double bz = 0.;
+  TrackParCovCache<> trackParCovCache; // track parameters of the dataframe, shared by the candidates
 
   OutputObj<TH1F> hMass3{TH1F("hMass3", "3-prong candidates;inv. mass (#pi K #pi) (GeV/#it{c}^{2});entries", 500, 1.6, 2.1)};
   OutputObj<TH1F> hCovPVXX{TH1F("hCovPVXX", "3-prong candidates;XX element of cov. matrix of prim. vtx. position (cm^{2});entries", 100, 0., 1.e-4)};
@@ -85,17 +87,21 @@ struct HfCandidateCreator3Prong {
     ccdb->setURL(ccdbUrl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(ccdbPathLut));
+    lut = o2::common::CCDBObjectCache::instance().getMatLUT(ccdb, ccdbPathLut);
     if (!o2::base::GeometryManager::isGeometryLoaded()) {
       ccdb->get<TGeoManager>(ccdbPathGeo);
     }
     runNumber = 0;
+
+    if (doprocessFit && doprocessSkimSvFit) {
+      LOGF(fatal, "Cannot enable processFit and processSkimSvFit at the same time. Please choose one.");
+    }
   }
 
-  void process(aod::Collisions const& collisions,
-               soa::Join<aod::Hf3Prongs, aod::HfPvRefit3Prong> const& rowsTrackIndexProng3,
-               aod::BigTracks const& tracks,
-               aod::BCsWithTimestamps const& bcWithTimeStamps)
+  /// Builds the candidates from the track indices of the skimming
+  /// \tparam reuseSvFit uses the secondary-vertex fits stored by the skimming instead of refitting the vertices
+  template <bool reuseSvFit, typename TRows>
+  void createCandidates(TRows const& rowsTrackIndexProng3)
   {
     // 3-prong vertex fitter
     o2::vertexing::DCAFitterN<3> df;
@@ -112,9 +118,6 @@ struct HfCandidateCreator3Prong {
       auto track0 = rowTrackIndexProng3.prong0_as<aod::BigTracks>();
       auto track1 = rowTrackIndexProng3.prong1_as<aod::BigTracks>();
       auto track2 = rowTrackIndexProng3.prong2_as<aod::BigTracks>();
-      auto trackParVar0 = getTrackParCov(track0);
-      auto trackParVar1 = getTrackParCov(track1);
-      auto trackParVar2 = getTrackParCov(track2);
       auto collision = track0.collision();
 
       /// Set the magnetic field from ccdb.
@@ -131,20 +134,29 @@ struct HfCandidateCreator3Prong {
       }
       df.setBz(bz);
 
-      // reconstruct the 3-prong secondary vertex
-      if (df.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
-        continue;
+      // reconstruct the 3-prong secondary vertex, or take the one fitted in the skimming
+      o2::hf_sv_fit::SvFit<3> svFit;
+      if constexpr (reuseSvFit) {
+        svFit = o2::hf_sv_fit::fromTable<3>(rowTrackIndexProng3);
+      } else {
+        const auto& trackParVar0 = trackParCovCache.get(track0);
+        const auto& trackParVar1 = trackParCovCache.get(track1);
+        const auto& trackParVar2 = trackParCovCache.get(track2);
+        if (df.process(trackParVar0, trackParVar1, trackParVar2) == 0) {
+          continue;
+        }
+        svFit = o2::hf_sv_fit::fromFitter<3>(df);
       }
-      const auto& secondaryVertex = df.getPCACandidate();
-      auto chi2PCA = df.getChi2AtPCACandidate();
-      auto covMatrixPCA = df.calcPCACovMatrixFlat();
+      const auto& secondaryVertex = svFit.position;
+      auto chi2PCA = svFit.chi2PCA;
+      auto covMatrixPCA = svFit.cov;
       hCovSVXX->Fill(covMatrixPCA[0]); // FIXME: Calculation of errorDecayLength(XY) gives wrong values without this line.
       hCovSVYY->Fill(covMatrixPCA[2]);
       hCovSVXZ->Fill(covMatrixPCA[3]);
       hCovSVZZ->Fill(covMatrixPCA[5]);
-      trackParVar0 = df.getTrack(0);
-      trackParVar1 = df.getTrack(1);
-      trackParVar2 = df.getTrack(2);
+      auto trackParVar0 = o2::hf_sv_fit::getProng(svFit, 0);
+      auto trackParVar1 = o2::hf_sv_fit::getProng(svFit, 1);
+      auto trackParVar2 = o2::hf_sv_fit::getProng(svFit, 2);
 
       // get track momenta
       array<float, 3> pvec0;
@@ -220,6 +232,27 @@ struct HfCandidateCreator3Prong {
       }
     }
   }
+
+  void processFit(aod::Collisions const& collisions,
+                  soa::Join<aod::Hf3Prongs, aod::HfPvRefit3Prong> const& rowsTrackIndexProng3,
+                  aod::BigTracks const& tracks,
+                  aod::BCsWithTimestamps const& bcWithTimeStamps)
+  {
+    trackParCovCache.reset(tracks.size());
+    createCandidates<false>(rowsTrackIndexProng3);
+  }
+
+  PROCESS_SWITCH(HfCandidateCreator3Prong, processFit, "Fit the secondary vertices of the candidates", true);
+
+  void processSkimSvFit(aod::Collisions const& collisions,
+                        soa::Join<aod::Hf3Prongs, aod::HfPvRefit3Prong, aod::HfSvFit3Prong> const& rowsTrackIndexProng3,
+                        aod::BigTracks const& tracks,
+                        aod::BCsWithTimestamps const& bcWithTimeStamps)
+  {
+    createCandidates<true>(rowsTrackIndexProng3);
+  }
+
+  PROCESS_SWITCH(HfCandidateCreator3Prong, processSkimSvFit, "Reuse the secondary vertices fitted in the skimming (requires fillSvFit in the skimming, with the same fitter settings)", false);
 };
 
 /// Extends the base table with expression columns.
@@ -228,6 +261,8 @@ struct HfCandidateCreator3ProngExpressions {
   Produces<aod::HfCand3ProngMcRec> rowMcMatchRec;
   Produces<aod::HfCand3ProngMcGen> rowMcMatchGen;
 
+  RecoDecay::MCAncestry mcAncestry; // flattened MC mother tree of the dataframe
+
   void init(InitContext const&) {}
 
   /// Performs MC matching.
@@ -235,6 +270,7 @@ struct HfCandidateCreator3ProngExpressions {
                  aod::McParticles const& particlesMC)
   {
     rowCandidateProng3->bindExternalIndices(&tracks);
+    mcAncestry.fill(particlesMC);
 
     int indexRec = -1;
     int8_t sign = 0;
@@ -261,7 +297,7 @@ struct HfCandidateCreator3ProngExpressions {
 
       // D± → π± K∓ π±
       // Printf("Checking D± → π± K∓ π±");
-      indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kDPlus, array{+kPiPlus, -kKPlus, +kPiPlus}, true, &sign, 2);
+      indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kDPlus, array{+kPiPlus, -kKPlus, +kPiPlus}, true, &sign, 2, &mcAncestry);
       if (indexRec > -1) {
         flag = sign * (1 << DecayType::DplusToPiKPi);
       }
@@ -269,7 +305,7 @@ struct HfCandidateCreator3ProngExpressions {
       // Ds± → K± K∓ π±
       if (flag == 0) {
         // Printf("Checking Ds± → K± K∓ π±");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kDS, array{+kKPlus, -kKPlus, +kPiPlus}, true, &sign, 2);
+        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kDS, array{+kKPlus, -kKPlus, +kPiPlus}, true, &sign, 2, &mcAncestry);
         if (indexRec > -1) {
           flag = sign * (1 << DecayType::DsToKKPi);
         }
@@ -278,7 +314,7 @@ struct HfCandidateCreator3ProngExpressions {
       // Λc± → p± K∓ π±
       if (flag == 0) {
         // Printf("Checking Λc± → p± K∓ π±");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kLambdaCPlus, array{+kProton, -kKPlus, +kPiPlus}, true, &sign, 2);
+        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kLambdaCPlus, array{+kProton, -kKPlus, +kPiPlus}, true, &sign, 2, &mcAncestry);
         if (indexRec > -1) {
           flag = sign * (1 << DecayType::LcToPKPi);
 
@@ -306,7 +342,7 @@ struct HfCandidateCreator3ProngExpressions {
       // Ξc± → p± K∓ π±
       if (flag == 0) {
         // Printf("Checking Ξc± → p± K∓ π±");
-        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kXiCPlus, array{+kProton, -kKPlus, +kPiPlus}, true, &sign, 2);
+        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kXiCPlus, array{+kProton, -kKPlus, +kPiPlus}, true, &sign, 2, &mcAncestry);
         if (indexRec > -1) {
           flag = sign * (1 << DecayType::XicToPKPi);
         }
@@ -315,10 +351,12 @@ struct HfCandidateCreator3ProngExpressions {
       // Check whether the particle is non-prompt (from a b quark).
       if (flag != 0) {
         auto particle = particlesMC.rawIteratorAt(indexRec);
-        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle, false, &mcAncestry);
+      } else {
+        indexRec = -1;
       }
 
-      rowMcMatchRec(flag, origin, swapping, channel);
+      rowMcMatchRec(flag, origin, swapping, channel, indexRec);
     }
 
     // Match generated particles.
@@ -377,7 +415,7 @@ struct HfCandidateCreator3ProngExpressions {
 
       // Check whether the particle is non-prompt (from a b quark).
       if (flag != 0) {
-        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+        origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle, false, &mcAncestry);
       }
 
       rowMcMatchGen(flag, origin, channel);
@@ -23,6 +23,7 @@
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/CandidateReconstructionTables.h"
 #include "PWGHF/DataModel/CandidateSelectionTables.h"
+#include "PWGHF/Utils/utilsBachelors.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -46,13 +47,20 @@ struct HfCandidateCreatorB0 {
   Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations is chi2/chi2old > this"};
   // selection
   Configurable<double> ptPionMin{"ptPionMin", 0.5, "minimum pion pT threshold (GeV/c)"};
+  Configurable<double> dcaXYPionMin{"dcaXYPionMin", 0., "minimum pion |DCAxy| to the primary vertex (cm)"};
+  Configurable<double> invMassWindowB0{"invMassWindowB0", 1.5, "max. |m(D pi) - m(B0)| before the B0 vertex fit, with the momenta of the D and of the pion at their reference points (<= 0 to disable)"};
   Configurable<int> selectionFlagD{"selectionFlagD", 1, "Selection Flag for D"};
   Configurable<double> yCandMax{"yCandMax", -1., "max. cand. rapidity"};
 
   double massPi = RecoDecay::getMassPDG(kPiPlus);
   double massD = RecoDecay::getMassPDG(pdg::Code::kDMinus);
+  double massB0 = RecoDecay::getMassPDG(pdg::Code::kB0);
   double massDPi = 0.;
 
+  // pion tracks of the collision, preselected once for all the D candidates
+  o2::hf_bachelor::BachelorPool bachelors;
+  std::vector<o2::hf_bachelor::Bachelor const*> selectedBachelors;
+
   Filter filterSelectCandidates = (aod::hf_sel_candidate_dplus::isSelDplusToPiKPi >= selectionFlagD); // FIXME
 
   OutputObj<TH1F> hMassDToPiKPi{TH1F("hMassB0ToPiKPi", "D^{#minus} candidates;inv. mass (p^{#minus} K^{#plus} #pi^{#minus}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
@@ -67,8 +75,14 @@ struct HfCandidateCreatorB0 {
                soa::Filtered<soa::Join<
                  aod::HfCand3Prong,
                  aod::HfSelDplusToPiKPi>> const& dCands,
-               aod::BigTracks const& tracks)
+               aod::BigTracksExtended const& tracks)
   {
+    bachelors.fill(tracks, [this](auto const& track) {
+      return track.pt() >= ptPionMin && std::abs(track.dcaXY()) >= dcaXYPionMin;
+    });
+    const double massMin = massB0 - invMassWindowB0;
+    const double massMax = invMassWindowB0 > 0. ? massB0 + invMassWindowB0 : -1.;
+
     // Initialise fitter for B vertex (2-prong vertex filter)
     o2::vertexing::DCAFitterN<2> df2;
     df2.setBz(bz);
@@ -101,9 +115,19 @@ struct HfCandidateCreatorB0 {
       hCPAD->Fill(dCand.cpa());
 
       // track0 <-> pi, track1 <-> K, track2 <-> pi
-      auto track0 = dCand.prong0_as<aod::BigTracks>();
-      auto track1 = dCand.prong1_as<aod::BigTracks>();
-      auto track2 = dCand.prong2_as<aod::BigTracks>();
+      auto track0 = dCand.prong0_as<aod::BigTracksExtended>();
+
+      // D- → π- K+ π- is combined with π+ and D+ → π+ K- π+ with π-
+      // we don't have direct access to D sign so we use the sign of the daughters (the pion track0 here)
+      // the D vertex is refitted only if there is a pion in the B0 mass window
+      selectedBachelors.clear();
+      bachelors.select(-track0.sign(), array<float, 3>{dCand.px(), dCand.py(), dCand.pz()}, massD, massPi, massMin, massMax, selectedBachelors);
+      if (selectedBachelors.empty()) {
+        continue;
+      }
+
+      auto track1 = dCand.prong1_as<aod::BigTracksExtended>();
+      auto track2 = dCand.prong2_as<aod::BigTracksExtended>();
       auto trackParVar0 = getTrackParCov(track0);
       auto trackParVar1 = getTrackParCov(track1);
       auto trackParVar2 = getTrackParCov(track2);
@@ -130,163 +154,73 @@ struct HfCandidateCreatorB0 {
       int index0D = track0.globalIndex();
       int index1D = track1.globalIndex();
       int index2D = track2.globalIndex();
-      // int charge = track0.sign() + track1.sign() + track2.sign();
 
-      // loop on D-
-      // D- → π- K+ π-
-      // we don't have direct access to D sign so we use the sign of the daughters (the pion track0 here)
-      if (track0.sign() < 0) {
-        // loop over pions
-        for (auto const& trackPion : tracks) {
-          // minimum pT selection
-          if (trackPion.pt() < ptPionMin) {
-            continue;
-          }
-          // we reject pions that are D daughters
-          if (trackPion.globalIndex() == index0D || trackPion.globalIndex() == index1D || trackPion.globalIndex() == index2D) {
-            continue;
-          }
-          // we only keep pi+ to combine them with Dminus and reconstruct B0
-          if (trackPion.sign() < 0) {
-            continue;
-          }
-
-          hPtPion->Fill(trackPion.pt());
-          array<float, 3> pVecPion;
-          auto trackParVarPi = getTrackParCov(trackPion);
-
-          // ---------------------------------
-          // reconstruct the 2-prong B0 vertex
-          if (df2.process(trackParVarD, trackParVarPi) == 0) {
-            continue;
-          }
-
-          // calculate relevant properties
-          const auto& secondaryVertexB0 = df2.getPCACandidate();
-          auto chi2PCA = df2.getChi2AtPCACandidate();
-          auto covMatrixPCA = df2.calcPCACovMatrixFlat();
-
-          df2.propagateTracksToVertex();
-          df2.getTrack(0).getPxPyPzGlo(pVecD);
-          df2.getTrack(1).getPxPyPzGlo(pVecPion);
-
-          auto primaryVertex = getPrimaryVertex(collision);
-          auto covMatrixPV = primaryVertex.getCov();
-          o2::dataformats::DCA impactParameter0;
-          o2::dataformats::DCA impactParameter1;
-          trackParVarD.propagateToDCA(primaryVertex, bz, &impactParameter0);
-          trackParVarPi.propagateToDCA(primaryVertex, bz, &impactParameter1);
-
-          hCovSVXX->Fill(covMatrixPCA[0]);
-          hCovPVXX->Fill(covMatrixPV[0]);
-
-          // get uncertainty of the decay length
-          double phi, theta;
-          getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexB0, phi, theta);
-          auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
-          auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
-
-          int hfFlag = BIT(hf_cand_b0::DecayType::B0ToDPi);
-
-          // fill the candidate table for the B0 here:
-          rowCandidateBase(collision.globalIndex(),
-                           collision.posX(), collision.posY(), collision.posZ(),
-                           secondaryVertexB0[0], secondaryVertexB0[1], secondaryVertexB0[2],
-                           errorDecayLength, errorDecayLengthXY,
-                           chi2PCA,
-                           pVecD[0], pVecD[1], pVecD[2],
-                           pVecPion[0], pVecPion[1], pVecPion[2],
-                           impactParameter0.getY(), impactParameter1.getY(),
-                           std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                           dCand.globalIndex(), trackPion.globalIndex(),
-                           hfFlag);
-
-          // calculate invariant mass
-          auto arrayMomenta = array{pVecD, pVecPion};
-          massDPi = RecoDecay::m(std::move(arrayMomenta), array{massD, massPi});
-          if (dCand.isSelDplusToPiKPi() > 0) {
-            hMassB0ToDPi->Fill(massDPi);
-          }
-        } // pi+ loop
-      }   // if D-
-
-      // loop on D+
-      // D+ → π+ K- π+
-      // we now loop on the D+
-      if (track0.sign() > 0) {
-        // loop over pions
-        for (auto const& trackPion : tracks) {
-          // minimum pT selection
-          if (trackPion.pt() < ptPionMin) {
-            continue;
-          }
-          // we reject pions that are D daughters
-          if (trackPion.globalIndex() == index0D || trackPion.globalIndex() == index1D || trackPion.globalIndex() == index2D) {
-            continue;
-          }
-          // we onnly keep pi- to combine them with D+ and reconstruct B0bar
-          if (trackPion.sign() > 0) {
-            continue;
-          }
-
-          hPtPion->Fill(trackPion.pt());
-          array<float, 3> pVecPion;
-          auto trackParVarPi = getTrackParCov(trackPion);
-
-          // ---------------------------------
-          // reconstruct the 2-prong B0bar vertex
-          if (df2.process(trackParVarD, trackParVarPi) == 0) {
-            continue;
-          }
-
-          // calculate relevant properties
-          const auto& secondaryVertexB0 = df2.getPCACandidate();
-          auto chi2PCA = df2.getChi2AtPCACandidate();
-          auto covMatrixPCA = df2.calcPCACovMatrixFlat();
-
-          df2.propagateTracksToVertex();
-          df2.getTrack(0).getPxPyPzGlo(pVecD);
-          df2.getTrack(1).getPxPyPzGlo(pVecPion);
-
-          auto primaryVertex = getPrimaryVertex(collision);
-          auto covMatrixPV = primaryVertex.getCov();
-          o2::dataformats::DCA impactParameter0;
-          o2::dataformats::DCA impactParameter1;
-          trackParVarD.propagateToDCA(primaryVertex, bz, &impactParameter0);
-          trackParVarPi.propagateToDCA(primaryVertex, bz, &impactParameter1);
-
-          hCovSVXX->Fill(covMatrixPCA[0]);
-          hCovPVXX->Fill(covMatrixPV[0]);
-
-          // get uncertainty of the decay length
-          double phi, theta;
-          getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexB0, phi, theta);
-          auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
-          auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
-
-          int hfFlag = BIT(hf_cand_b0::DecayType::B0ToDPi);
-
-          // fill the candidate table for the B0 here:
-          rowCandidateBase(collision.globalIndex(),
-                           collision.posX(), collision.posY(), collision.posZ(),
-                           secondaryVertexB0[0], secondaryVertexB0[1], secondaryVertexB0[2],
-                           errorDecayLength, errorDecayLengthXY,
-                           chi2PCA,
-                           pVecD[0], pVecD[1], pVecD[2],
-                           pVecPion[0], pVecPion[1], pVecPion[2],
-                           impactParameter0.getY(), impactParameter1.getY(),
-                           std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                           dCand.globalIndex(), trackPion.globalIndex(),
-                           hfFlag);
-
-          // calculate invariant mass
-          auto arrayMomenta = array{pVecD, pVecPion};
-          massDPi = RecoDecay::m(std::move(arrayMomenta), array{massD, massPi});
-          if (dCand.isSelDplusToPiKPi() > 0) {
-            hMassB0ToDPi->Fill(massDPi);
-          }
-        } // pi- loop
-      }   // if D+
+      // loop over the preselected pions of opposite sign
+      for (const auto* trackPion : selectedBachelors) {
+        // we reject pions that are D daughters
+        if (trackPion->globalIndex == index0D || trackPion->globalIndex == index1D || trackPion->globalIndex == index2D) {
+          continue;
+        }
+
+        hPtPion->Fill(trackPion->pt);
+        array<float, 3> pVecPion;
+
+        // ---------------------------------
+        // reconstruct the 2-prong B0 vertex
+        if (df2.process(trackParVarD, trackPion->trackParCov) == 0) {
+          continue;
+        }
+
+        // calculate relevant properties
+        const auto& secondaryVertexB0 = df2.getPCACandidate();
+        auto chi2PCA = df2.getChi2AtPCACandidate();
+        auto covMatrixPCA = df2.calcPCACovMatrixFlat();
+
+        df2.propagateTracksToVertex();
+        df2.getTrack(0).getPxPyPzGlo(pVecD);
+        df2.getTrack(1).getPxPyPzGlo(pVecPion);
+
+        // the impact parameters are computed on copies, the D and pion tracks are reused for the next pions
+        auto primaryVertex = getPrimaryVertex(collision);
+        auto covMatrixPV = primaryVertex.getCov();
+        o2::dataformats::DCA impactParameter0;
+        o2::dataformats::DCA impactParameter1;
+        auto trackParVarDAtPV = trackParVarD;
+        auto trackParVarPiAtPV = trackPion->trackParCov;
+        trackParVarDAtPV.propagateToDCA(primaryVertex, bz, &impactParameter0);
+        trackParVarPiAtPV.propagateToDCA(primaryVertex, bz, &impactParameter1);
+
+        hCovSVXX->Fill(covMatrixPCA[0]);
+        hCovPVXX->Fill(covMatrixPV[0]);
+
+        // get uncertainty of the decay length
+        double phi, theta;
+        getPointDirection(array{collision.posX(), collision.posY(), collision.posZ()}, secondaryVertexB0, phi, theta);
+        auto errorDecayLength = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, theta) + getRotatedCovMatrixXX(covMatrixPCA, phi, theta));
+        auto errorDecayLengthXY = std::sqrt(getRotatedCovMatrixXX(covMatrixPV, phi, 0.) + getRotatedCovMatrixXX(covMatrixPCA, phi, 0.));
+
+        int hfFlag = BIT(hf_cand_b0::DecayType::B0ToDPi);
+
+        // fill the candidate table for the B0 here:
+        rowCandidateBase(collision.globalIndex(),
+                         collision.posX(), collision.posY(), collision.posZ(),
+                         secondaryVertexB0[0], secondaryVertexB0[1], secondaryVertexB0[2],
+                         errorDecayLength, errorDecayLengthXY,
+                         chi2PCA,
+                         pVecD[0], pVecD[1], pVecD[2],
+                         pVecPion[0], pVecPion[1], pVecPion[2],
+                         impactParameter0.getY(), impactParameter1.getY(),
+                         std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
+                         dCand.globalIndex(), trackPion->globalIndex,
+                         hfFlag);
+
+        // calculate invariant mass
+        auto arrayMomenta = array{pVecD, pVecPion};
+        massDPi = RecoDecay::m(std::move(arrayMomenta), array{massD, massPi});
+        if (dCand.isSelDplusToPiKPi() > 0) {
+          hMassB0ToDPi->Fill(massDPi);
+        }
+      } // pion loop
     }     // D loop
   }       // process
 };        // struct
@@ -25,6 +25,7 @@
 #include "ReconstructionDataFormats/DCA.h"
 #include "PWGHF/DataModel/CandidateSelectionTables.h"
 #include "ReconstructionDataFormats/V0.h"
+#include "PWGHF/Utils/utilsBachelors.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -60,6 +61,17 @@ struct HfCandidateCreatorBplus {
   Configurable<int> selectionFlagD0bar{"selectionFlagD0bar", 1, "Selection Flag for D0bar"};
   Configurable<double> yCandMax{"yCandMax", -1., "max. cand. rapidity"};
   Configurable<double> etaTrackMax{"etaTrackMax", -1, "max. bach track. pseudorapidity"};
+  Configurable<double> ptTrackMin{"ptTrackMin", 0., "min. bach track pT (GeV/c)"};
+  Configurable<double> dcaXYTrackMin{"dcaXYTrackMin", 0., "min. |DCAxy| of the bach track to the primary vertex (cm)"};
+  Configurable<double> invMassWindowBplus{"invMassWindowBplus", 1.5, "max. |m(D0 pi) - m(B+)| before the B+ vertex fit, with the momenta of the D0 and of the bach track at their reference points (<= 0 to disable)"};
+
+  double massPi = RecoDecay::getMassPDG(kPiPlus);
+  double massD0 = RecoDecay::getMassPDG(pdg::Code::kD0);
+  double massBplus = RecoDecay::getMassPDG(pdg::Code::kBPlus);
+
+  // bachelor tracks of the collision, preselected once for all the D0 candidates
+  o2::hf_bachelor::BachelorPool bachelors;
+  std::vector<o2::hf_bachelor::Bachelor const*> selectedBachelors;
 
   Filter filterSelectCandidates = (aod::hf_sel_candidate_d0::isSelD0 >= selectionFlagD0 || aod::hf_sel_candidate_d0::isSelD0bar >= selectionFlagD0bar);
 
@@ -72,10 +84,23 @@ struct HfCandidateCreatorBplus {
   void process(aod::Collision const& collisions,
                soa::Filtered<soa::Join<aod::HfCand2Prong,
                                        aod::HfSelD0>> const& candidates,
-               aod::BigTracks const& tracks)
+               aod::BigTracksExtended const& tracks)
   {
     hNEvents->Fill(0);
 
+    bachelors.fill(tracks, [this](auto const& track) {
+      if (track.pt() < ptTrackMin || std::abs(track.dcaXY()) < dcaXYTrackMin) {
+        return false;
+      }
+      if (etaTrackMax >= 0. && std::abs(track.eta()) > etaTrackMax) {
+        return false;
+      }
+      hEtaPi->Fill(track.eta());
+      return true;
+    });
+    const double massMin = massBplus - invMassWindowBplus;
+    const double massMax = invMassWindowBplus > 0. ? massBplus + invMassWindowBplus : -1.;
+
     // Initialise fitter for B vertex
     o2::vertexing::DCAFitterN<2> bfitter;
     bfitter.setBz(bz);
@@ -108,8 +133,20 @@ struct HfCandidateCreatorBplus {
       const std::array<float, 3> vertexD0 = {candidate.xSecondaryVertex(), candidate.ySecondaryVertex(), candidate.zSecondaryVertex()};
       const std::array<float, 3> momentumD0 = {candidate.px(), candidate.py(), candidate.pz()};
 
-      auto prong0 = candidate.prong0_as<aod::BigTracks>();
-      auto prong1 = candidate.prong1_as<aod::BigTracks>();
+      // D0 pi- and D0bar pi+ pairs only, the D0 vertex is refitted only if there is a bachelor in the B+ mass window
+      selectedBachelors.clear();
+      if (candidate.isSelD0() >= selectionFlagD0) {
+        bachelors.select(-1, momentumD0, massD0, massPi, massMin, massMax, selectedBachelors);
+      }
+      if (candidate.isSelD0bar() >= selectionFlagD0bar) {
+        bachelors.select(+1, momentumD0, massD0, massPi, massMin, massMax, selectedBachelors);
+      }
+      if (selectedBachelors.empty()) {
+        continue;
+      }
+
+      auto prong0 = candidate.prong0_as<aod::BigTracksExtended>();
+      auto prong1 = candidate.prong1_as<aod::BigTracksExtended>();
       auto prong0TrackParCov = getTrackParCov(prong0);
       auto prong1TrackParCov = getTrackParCov(prong1);
       auto collision = prong0.collision();
@@ -130,37 +167,18 @@ struct HfCandidateCreatorBplus {
       // build a D0 neutral track
       auto trackD0 = o2::dataformats::V0(vertexD0, momentumD0, pCovMatrixD0, prong0TrackParCov, prong1TrackParCov, {0, 0}, {0, 0});
 
-      // loop over tracks for pi selection
-      // auto count = 0;
-      for (auto& track : tracks) {
-        // if(count % 100 == 0){
-        // LOGF(info, "Col: %d (cand); %d (track)", candidate.collisionId(), track.collisionId());
-        //   count++;
-        //  }
-
-        if (etaTrackMax >= 0. && std::abs(track.eta()) > etaTrackMax) {
-          continue;
-        }
-
-        hEtaPi->Fill(track.eta());
-
-        if (candidate.prong0Id() == track.globalIndex() || candidate.prong1Id() == track.globalIndex()) {
+      // loop over the preselected bachelors for pi selection
+      for (const auto* bachelor : selectedBachelors) {
+        if (candidate.prong0Id() == bachelor->globalIndex || candidate.prong1Id() == bachelor->globalIndex) {
           continue; // daughter track id and bachelor track id not the same
         }
 
-        // Select D0pi- and D0(bar)pi+ pairs only
-        if (!((candidate.isSelD0() >= selectionFlagD0 && track.sign() < 0) || (candidate.isSelD0bar() >= selectionFlagD0bar && track.sign() > 0))) {
-          // Printf("D0: %d, D0bar%d, sign: %d", candidate.isSelD0(), candidate.isSelD0bar(), track.sign());
-          continue;
-        }
-
-        auto trackBach = getTrackParCov(track);
         std::array<float, 3> pVecD0 = {0., 0., 0.};
         std::array<float, 3> pVecBach = {0., 0., 0.};
         std::array<float, 3> pVecBCand = {0., 0., 0.};
 
         // find the DCA between the D0 and the bachelor track, for B+
-        if (bfitter.process(trackD0, trackBach) == 0) {
+        if (bfitter.process(trackD0, bachelor->trackParCov) == 0) {
           continue;
         }
 
@@ -203,7 +221,7 @@ struct HfCandidateCreatorBplus {
                          pVecBach[0], pVecBach[1], pVecBach[2],
                          impactParameter0.getY(), impactParameter1.getY(),
                          std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                         candidate.globalIndex(), track.globalIndex(), // index D0 and bachelor
+                         candidate.globalIndex(), bachelor->globalIndex, // index D0 and bachelor
                          hfFlag);
       } // track loop
     }   // D0 cand loop
@@ -222,8 +240,10 @@ struct HfCandidateCreatorBplusMc {
   Produces<aod::HfCandBplusMcRec> rowMcMatchRec;
   Produces<aod::HfCandBplusMcGen> rowMcMatchGen;
 
+  using CandsD0Mc = soa::Join<aod::HfCand2Prong, aod::HfCand2ProngMcRec>;
+
   void process(aod::HfCandBplus const& candidates,
-               aod::HfCand2Prong const&,
+               CandsD0Mc const&,
                aod::BigTracksMC const& tracks,
                aod::McParticles const& particlesMC)
   {
@@ -237,17 +257,18 @@ struct HfCandidateCreatorBplusMc {
       // Printf("New rec. candidate");
 
       flag = 0;
-      auto candDaughterD0 = candidate.prong0_as<aod::HfCand2Prong>();
-      auto arrayDaughtersD0 = array{candDaughterD0.prong0_as<aod::BigTracksMC>(), candDaughterD0.prong1_as<aod::BigTracksMC>()};
-      auto arrayDaughters = array{candidate.prong1_as<aod::BigTracksMC>(), candDaughterD0.prong0_as<aod::BigTracksMC>(), candDaughterD0.prong1_as<aod::BigTracksMC>()};
-
-      // B± → D0bar(D0) π± → (K± π∓) π±
-      // Printf("Checking B± → D0(bar) π±");
-      indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kBPlus, array{+kPiPlus, +kKPlus, -kPiPlus}, true, &signB, 2);
-      indexRecD0 = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughtersD0, pdg::Code::kD0, array{-kKPlus, +kPiPlus}, true, &signD0, 1);
-
-      if (indexRecD0 > -1 && indexRec > -1) {
-        flag = signB * (1 << hf_cand_bplus::DecayType::BplusToD0Pi);
+      auto candDaughterD0 = candidate.prong0_as<CandsD0Mc>();
+
+      // the D0 matching is taken from the 2-prong creator, the B± is matched only if the D0 is
+      indexRecD0 = std::abs(candDaughterD0.flagMcMatchRec()) == 1 << hf_cand_2prong::DecayType::D0ToPiK ? candDaughterD0.indexMcRec() : -1;
+      if (indexRecD0 > -1) {
+        // B± → D0bar(D0) π± → (K± π∓) π±
+        // Printf("Checking B± → D0(bar) π±");
+        auto arrayDaughters = array{candidate.prong1_as<aod::BigTracksMC>(), candDaughterD0.prong0_as<aod::BigTracksMC>(), candDaughterD0.prong1_as<aod::BigTracksMC>()};
+        indexRec = RecoDecay::getMatchedMCRec(particlesMC, arrayDaughters, pdg::Code::kBPlus, array{+kPiPlus, +kKPlus, -kPiPlus}, true, &signB, 2);
+        if (indexRec > -1) {
+          flag = signB * (1 << hf_cand_bplus::DecayType::BplusToD0Pi);
+        }
       }
       rowMcMatchRec(flag);
     }
@@ -66,6 +66,7 @@ struct HfCandidateCreatorCascade {
   double massPi = RecoDecay::getMassPDG(kPiPlus);
   double massLc = RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus);
   double mass2K0sP{0.};
+  TrackParCovCache<> trackParCovCache; // track parameters of the dataframe, shared by the candidates
 
   OutputObj<TH1F> hMass2{TH1F("hMass2", "2-prong candidates;inv. mass (#pi K) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
   OutputObj<TH1F> hCovPVXX{TH1F("hCovPVXX", "2-prong candidates;XX element of cov. matrix of prim. vtx. position (cm^{2});entries", 100, 0., 1.e-4)};
@@ -73,7 +74,7 @@ struct HfCandidateCreatorCascade {
 
   void process(aod::Collisions const&,
                aod::HfCascades const& rowsTrackIndexCasc,
-               MyBigTracks const&,
+               MyBigTracks const& tracks,
                aod::V0sLinked const&,
                aod::V0Datas const&
 #ifdef MY_DEBUG
@@ -92,6 +93,8 @@ struct HfCandidateCreatorCascade {
     df.setMinRelChi2Change(minRelChi2Change);
     df.setUseAbsDCA(true);
 
+    trackParCovCache.reset(tracks.size());
+
     // loop over pairs of track indeces
     for (const auto& casc : rowsTrackIndexCasc) {
 
@@ -121,11 +124,11 @@ struct HfCandidateCreatorCascade {
 
       MY_DEBUG_MSG(isLc, LOG(info) << "Processing the Lc with proton " << indexBach << " trackV0DaughPos " << indexV0DaughPos << " trackV0DaughNeg " << indexV0DaughNeg);
 
-      auto trackParCovBach = getTrackParCov(bach);
-      auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos); // check that MyBigTracks does not need TracksDCA!
-      auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg); // check that MyBigTracks does not need TracksDCA!
-      trackParCovV0DaughPos.propagateTo(v0.posX(), bz);             // propagate the track to the X closest to the V0 vertex
-      trackParCovV0DaughNeg.propagateTo(v0.negX(), bz);             // propagate the track to the X closest to the V0 vertex
+      const auto& trackParCovBach = trackParCovCache.get(bach);
+      auto trackParCovV0DaughPos = trackParCovCache.get(trackV0DaughPos); // copy, check that MyBigTracks does not need TracksDCA!
+      auto trackParCovV0DaughNeg = trackParCovCache.get(trackV0DaughNeg); // copy, check that MyBigTracks does not need TracksDCA!
+      trackParCovV0DaughPos.propagateTo(v0.posX(), bz);                   // propagate the track to the X closest to the V0 vertex
+      trackParCovV0DaughNeg.propagateTo(v0.negX(), bz);                   // propagate the track to the X closest to the V0 vertex
       const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
       const std::array<float, 3> momentumV0 = {v0.px(), v0.py(), v0.pz()};
       // we build the neutral track to then build the cascade
@@ -14,6 +14,9 @@
 ///
 /// \author Vít Kučera <vit.kucera@cern.ch>, CERN
 
+#include <algorithm>
+#include <vector>
+
 #include "Framework/AnalysisTask.h"
 // #include "DetectorsVertexing/DCAFitterN.h"
 // #include "Common/Core/trackUtilities.h"
@@ -30,20 +33,41 @@ using namespace o2::framework;
 /// Reconstruction of D* decay candidates
 struct HfCandidateCreatorDstar {
   Configurable<bool> fillHistograms{"fillHistograms", true, "fill histograms"};
+  // combinatorial search of the soft pions
+  Configurable<double> ptSoftPionMax{"ptSoftPionMax", 2., "max. pT of the soft pions (GeV/c)"};
+  Configurable<double> deltaMassD0Max{"deltaMassD0Max", 0.1, "max. |inv. mass (K pi) - D0 mass| of the D0 candidates (GeV/c^2)"};
+  Configurable<double> deltaMassMin{"deltaMassMin", 0.135, "min. inv. mass (pi D0) - inv. mass (K pi) (GeV/c^2)"};
+  Configurable<double> deltaMassMax{"deltaMassMax", 0.16, "max. inv. mass (pi D0) - inv. mass (K pi) (GeV/c^2)"};
+  Configurable<double> deltaEtaMax{"deltaEtaMax", 0.5, "max. |eta(pi) - eta(D0)|"};
+  Configurable<double> deltaPhiMax{"deltaPhiMax", 0.5, "max. |phi(pi) - phi(D0)|"};
 
   double massPi = RecoDecay::getMassPDG(kPiPlus);
+  double massK = RecoDecay::getMassPDG(kKPlus);
   double massD0 = RecoDecay::getMassPDG(pdg::Code::kD0);
 
+  /// soft-pion candidate of the combinatorial search
+  struct SoftPion {
+    int collisionId;
+    float eta;
+    float phi;
+    std::array<float, 3> pVec;
+    int64_t globalIndex;
+    int sign;
+  };
+  std::vector<SoftPion> softPions;  // soft pions of the dataframe, sorted by collision and pseudorapidity
+  std::vector<int> softPionOffsets; // position of the first soft pion of every collision
+
   OutputObj<TH1F> hMass{TH1F("hMass", "D* candidates;inv. mass (#pi D^{0}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
   OutputObj<TH1F> hPtPi{TH1F("hPtPi", "#pi candidates;#it{p}_{T} (GeV/#it{c});entries", 500, 0., 5.)};
   OutputObj<TH1F> hPtD0Prong0{TH1F("hPtD0Prong0", "D^{0} candidates;prong 0 #it{p}_{T} (GeV/#it{c});entries", 500, 0., 5.)};
   OutputObj<TH1F> hPtD0Prong1{TH1F("hPtD0Prong1", "D^{0} candidates;prong 1 #it{p}_{T} (GeV/#it{c});entries", 500, 0., 5.)};
   OutputObj<TH1F> hPtD0{TH1F("hPtD0", "D^{0} candidates;candidate #it{p}_{T} (GeV/#it{c});entries", 500, 0., 5.)};
+  OutputObj<TH1F> hDeltaMass{TH1F("hDeltaMass", "D* candidates;inv. mass (#pi D^{0}) - inv. mass (K #pi) (GeV/#it{c}^{2});entries", 500, 0.13, 0.18)};
 
-  void process(aod::Collisions const&,
-               aod::HfDstars const& rowsTrackIndexDstar,
-               aod::BigTracks const&,
-               aod::Hf2Prongs const&)
+  void processIndices(aod::Collisions const&,
+                      aod::HfDstars const& rowsTrackIndexDstar,
+                      aod::BigTracks const&,
+                      aod::Hf2Prongs const&)
   {
     // loop over pairs of prong indices
     for (const auto& rowTrackIndexDstar : rowsTrackIndexDstar) {
@@ -73,6 +97,100 @@ struct HfCandidateCreatorDstar {
       }
     }
   }
+
+  PROCESS_SWITCH(HfCandidateCreatorDstar, processIndices, "Use the D* track indices of the skimming", true);
+
+  /// Collects the soft pions of the dataframe, sorted by collision and by pseudorapidity,
+  /// so that the pions of a collision in the eta window of a D0 are found by binary search
+  void fillSoftPions(aod::Collisions const& collisions, aod::BigTracks const& tracks)
+  {
+    softPions.clear();
+    for (const auto& track : tracks) {
+      if (!track.has_collision() || track.pt() > ptSoftPionMax) {
+        continue;
+      }
+      softPions.push_back({track.collisionId(), track.eta(), track.phi(), {track.px(), track.py(), track.pz()}, track.globalIndex(), track.sign()});
+    }
+    std::sort(softPions.begin(), softPions.end(), [](const SoftPion& a, const SoftPion& b) {
+      return a.collisionId != b.collisionId ? a.collisionId < b.collisionId : a.eta < b.eta;
+    });
+    softPionOffsets.assign(collisions.size() + 1, softPions.size());
+    for (int iPion = softPions.size() - 1; iPion >= 0; --iPion) {
+      softPionOffsets[softPions[iPion].collisionId] = iPion;
+    }
+    for (int iCollision = collisions.size() - 1; iCollision >= 0; --iCollision) {
+      softPionOffsets[iCollision] = std::min(softPionOffsets[iCollision], softPionOffsets[iCollision + 1]);
+    }
+  }
+
+  /// Combines the D0 candidates with the soft pions of their collision.
+  /// The D0 mass hypotheses are evaluated once per D0 and the pions are taken only in the (eta, phi) cone of the D0,
+  /// so that the mass difference is computed for the kinematically allowed pairs only.
+  void processCombinatorial(aod::Collisions const& collisions,
+                            aod::BigTracks const& tracks,
+                            aod::Hf2Prongs const& rowsTrackIndexProng2)
+  {
+    fillSoftPions(collisions, tracks);
+
+    for (const auto& prongD0 : rowsTrackIndexProng2) {
+      auto trackD0Prong0 = prongD0.prong0_as<aod::BigTracks>();
+      auto trackD0Prong1 = prongD0.prong1_as<aod::BigTracks>();
+      auto collisionId = trackD0Prong0.collisionId();
+      if (collisionId < 0 || collisionId >= collisions.size()) {
+        continue;
+      }
+      std::array<float, 3> pVecD0Prong0 = {trackD0Prong0.px(), trackD0Prong0.py(), trackD0Prong0.pz()};
+      std::array<float, 3> pVecD0Prong1 = {trackD0Prong1.px(), trackD0Prong1.py(), trackD0Prong1.pz()};
+      auto pVecD0 = RecoDecay::pVec(pVecD0Prong0, pVecD0Prong1);
+      auto pD0 = RecoDecay::p(pVecD0);
+
+      // D0 four-vectors of the two mass hypotheses: D0 (pi+ K-) with a pi+ and D0bar (K+ pi-) with a pi-
+      auto signProng0 = trackD0Prong0.sign();
+      std::array<double, 2> massesKPi = {RecoDecay::m(std::array{pVecD0Prong0, pVecD0Prong1}, std::array{massPi, massK}),
+                                         RecoDecay::m(std::array{pVecD0Prong0, pVecD0Prong1}, std::array{massK, massPi})};
+      std::array<bool, 2> isInWindow = {std::abs(massesKPi[0] - massD0) < deltaMassD0Max, std::abs(massesKPi[1] - massD0) < deltaMassD0Max};
+      if (!isInWindow[0] && !isInWindow[1]) {
+        continue;
+      }
+      std::array<double, 2> energiesD0 = {RecoDecay::e(pD0, massesKPi[0]), RecoDecay::e(pD0, massesKPi[1])};
+      auto etaD0 = RecoDecay::eta(pVecD0);
+      auto phiD0 = RecoDecay::phi(pVecD0[0], pVecD0[1]);
+
+      auto first = softPions.begin() + softPionOffsets[collisionId];
+      auto last = softPions.begin() + softPionOffsets[collisionId + 1];
+      auto pion = std::lower_bound(first, last, etaD0 - deltaEtaMax, [](const SoftPion& a, double eta) { return a.eta < eta; });
+      for (; pion != last && pion->eta <= etaD0 + deltaEtaMax; ++pion) {
+        if (std::abs(RecoDecay::constrainAngle(pion->phi - phiD0, -o2::constants::math::PI)) > deltaPhiMax) {
+          continue;
+        }
+        if (pion->globalIndex == trackD0Prong0.globalIndex() || pion->globalIndex == trackD0Prong1.globalIndex()) {
+          continue;
+        }
+        // the soft pion has the charge of the pion of the D0 decay
+        int hypo = (pion->sign == signProng0) ? 0 : 1;
+        if (!isInWindow[hypo]) {
+          continue;
+        }
+        auto pVecDstar = RecoDecay::pVec(pVecD0, pion->pVec);
+        auto energyDstar = energiesD0[hypo] + RecoDecay::e(pion->pVec, massPi);
+        auto massDstar = std::sqrt(std::max(0., energyDstar * energyDstar - RecoDecay::p2(pVecDstar)));
+        auto deltaMass = massDstar - massesKPi[hypo];
+        if (deltaMass < deltaMassMin || deltaMass > deltaMassMax) {
+          continue;
+        }
+        if (fillHistograms) {
+          hPtPi->Fill(RecoDecay::pt(pion->pVec));
+          hPtD0->Fill(RecoDecay::pt(pVecD0));
+          hPtD0Prong0->Fill(RecoDecay::pt(pVecD0Prong0));
+          hPtD0Prong1->Fill(RecoDecay::pt(pVecD0Prong1));
+          hMass->Fill(massDstar);
+          hDeltaMass->Fill(deltaMass);
+        }
+      }
+    }
+  }
+
+  PROCESS_SWITCH(HfCandidateCreatorDstar, processCombinatorial, "Combine the D0 candidates with the soft pions of their collision", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
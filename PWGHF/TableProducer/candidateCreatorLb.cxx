@@ -22,6 +22,7 @@
 #include "ReconstructionDataFormats/DCA.h"
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/CandidateSelectionTables.h"
+#include "PWGHF/Utils/utilsBachelors.h"
 
 using namespace o2;
 using namespace o2::aod;
@@ -53,13 +54,20 @@ struct HfCandidateCreatorLb {
   Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations is chi2/chi2old > this"};
   // selection
   Configurable<double> ptPionMin{"ptPionMin", 0.5, "minimum pion pT threshold (GeV/c)"};
+  Configurable<double> dcaXYPionMin{"dcaXYPionMin", 0., "minimum pion |DCAxy| to the primary vertex (cm)"};
+  Configurable<double> invMassWindowLb{"invMassWindowLb", 1.5, "max. |m(Lc pi) - m(Lb)| before the Lb vertex fit, with the momenta of the Lc and of the pion at their reference points (<= 0 to disable)"};
   Configurable<int> selectionFlagLc{"selectionFlagLc", 1, "Selection Flag for Lc"};
   Configurable<double> yCandMax{"yCandMax", -1., "max. cand. rapidity"};
 
   double massPi = RecoDecay::getMassPDG(kPiMinus);
   double massLc = RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus);
+  double massLb = RecoDecay::getMassPDG(pdg::Code::kLambdaB0);
   double massLcPi = 0.;
 
+  // pion tracks of the collision, preselected once for all the Lc candidates
+  o2::hf_bachelor::BachelorPool bachelors;
+  std::vector<o2::hf_bachelor::Bachelor const*> selectedBachelors;
+
   Filter filterSelectCandidates = (aod::hf_sel_candidate_lc::isSelLcToPKPi >= selectionFlagLc || aod::hf_sel_candidate_lc::isSelLcToPiKP >= selectionFlagLc);
 
   OutputObj<TH1F> hMassLcToPKPi{TH1F("hMassLcToPKPi", "#Lambda_{c}^{#plus} candidates;inv. mass (pK^{#minus} #pi^{#plus}) (GeV/#it{c}^{2});entries", 500, 0., 5.)};
@@ -74,8 +82,14 @@ struct HfCandidateCreatorLb {
                soa::Filtered<soa::Join<
                  aod::HfCand3Prong,
                  aod::HfSelLc>> const& lcCands,
-               aod::BigTracks const& tracks)
+               aod::BigTracksExtended const& tracks)
   {
+    bachelors.fill(tracks, [this](auto const& track) {
+      return track.pt() >= ptPionMin && std::abs(track.dcaXY()) >= dcaXYPionMin;
+    });
+    const double massMin = massLb - invMassWindowLb;
+    const double massMax = invMassWindowLb > 0. ? massLb + invMassWindowLb : -1.;
+
     // 2-prong vertex fitter
     o2::vertexing::DCAFitterN<2> df2;
     df2.setBz(bz);
@@ -110,9 +124,16 @@ struct HfCandidateCreatorLb {
       hPtLc->Fill(lcCand.pt());
       hCPALc->Fill(lcCand.cpa());
 
-      auto track0 = lcCand.prong0_as<aod::BigTracks>();
-      auto track1 = lcCand.prong1_as<aod::BigTracks>();
-      auto track2 = lcCand.prong2_as<aod::BigTracks>();
+      // the Lc vertex is refitted only if there is a pi- in the Lb mass window
+      selectedBachelors.clear();
+      bachelors.select(-1, array<float, 3>{lcCand.px(), lcCand.py(), lcCand.pz()}, massLc, massPi, massMin, massMax, selectedBachelors);
+      if (selectedBachelors.empty()) {
+        continue;
+      }
+
+      auto track0 = lcCand.prong0_as<aod::BigTracksExtended>();
+      auto track1 = lcCand.prong1_as<aod::BigTracksExtended>();
+      auto track2 = lcCand.prong2_as<aod::BigTracksExtended>();
       auto trackParVar0 = getTrackParCov(track0);
       auto trackParVar1 = getTrackParCov(track1);
       auto trackParVar2 = getTrackParCov(track2);
@@ -139,22 +160,15 @@ struct HfCandidateCreatorLb {
       int index2Lc = track2.globalIndex();
       // int charge = track0.sign() + track1.sign() + track2.sign();
 
-      for (auto& trackPion : tracks) {
-        if (trackPion.pt() < ptPionMin) {
-          continue;
-        }
-        if (trackPion.sign() > 0) {
-          continue;
-        }
-        if (trackPion.globalIndex() == index0Lc || trackPion.globalIndex() == index1Lc || trackPion.globalIndex() == index2Lc) {
+      for (const auto* trackPion : selectedBachelors) {
+        if (trackPion->globalIndex == index0Lc || trackPion->globalIndex == index1Lc || trackPion->globalIndex == index2Lc) {
           continue;
         }
-        hPtPion->Fill(trackPion.pt());
+        hPtPion->Fill(trackPion->pt);
         array<float, 3> pvecPion;
-        auto trackParVarPi = getTrackParCov(trackPion);
 
         // reconstruct the 3-prong Lc vertex
-        if (df2.process(trackLc, trackParVarPi) == 0) {
+        if (df2.process(trackLc, trackPion->trackParCov) == 0) {
           continue;
         }
 
@@ -167,12 +181,15 @@ struct HfCandidateCreatorLb {
         df2.getTrack(0).getPxPyPzGlo(pvecLc);
         df2.getTrack(1).getPxPyPzGlo(pvecPion);
 
+        // the impact parameters are computed on copies, the Lc and pion tracks are reused for the next pions
         auto primaryVertex = getPrimaryVertex(collision);
         auto covMatrixPV = primaryVertex.getCov();
         o2::dataformats::DCA impactParameter0;
         o2::dataformats::DCA impactParameter1;
-        trackLc.propagateToDCA(primaryVertex, bz, &impactParameter0);
-        trackParVarPi.propagateToDCA(primaryVertex, bz, &impactParameter1);
+        auto trackLcAtPV = trackLc;
+        auto trackParVarPiAtPV = trackPion->trackParCov;
+        trackLcAtPV.propagateToDCA(primaryVertex, bz, &impactParameter0);
+        trackParVarPiAtPV.propagateToDCA(primaryVertex, bz, &impactParameter1);
 
         hCovSVXX->Fill(covMatrixPCA[0]);
         hCovPVXX->Fill(covMatrixPV[0]);
@@ -195,7 +212,7 @@ struct HfCandidateCreatorLb {
                          pvecPion[0], pvecPion[1], pvecPion[2],
                          impactParameter0.getY(), impactParameter1.getY(),
                          std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                         lcCand.globalIndex(), trackPion.globalIndex(),
+                         lcCand.globalIndex(), trackPion->globalIndex,
                          hfFlag);
 
         // calculate invariant mass
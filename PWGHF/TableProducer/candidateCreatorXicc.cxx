@@ -24,6 +24,7 @@
 #include "ReconstructionDataFormats/DCA.h"
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/DataModel/CandidateSelectionTables.h"
+#include "PWGHF/Utils/utilsBachelors.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -53,11 +54,18 @@ struct HfCandidateCreatorXicc {
   // selection
   Configurable<int> selectionFlagXic{"selectionFlagXic", 1, "Selection Flag for Xic"};
   Configurable<double> cutPtPionMin{"cutPtPionMin", 1., "min. pt pion track"};
+  Configurable<double> cutDcaXYPionMin{"cutDcaXYPionMin", 0., "min. |DCAxy| of the pion track to the primary vertex (cm)"};
+  Configurable<double> invMassWindowXicc{"invMassWindowXicc", 1.5, "max. |m(Xic pi) - m(Xicc)| before the Xicc vertex fit, with the momenta of the Xic and of the pion at their reference points (<= 0 to disable)"};
 
   double massPi = RecoDecay::getMassPDG(kPiPlus);
   double massK = RecoDecay::getMassPDG(kKPlus);
   double massXic = RecoDecay::getMassPDG(int(pdg::Code::kXiCPlus));
   double massXicc{0.};
+  double massXiccPDG = RecoDecay::getMassPDG(int(pdg::Code::kXiCCPlusPlus));
+
+  // pion tracks of the collision, preselected once for all the Xic candidates
+  o2::hf_bachelor::BachelorPool bachelors;
+  std::vector<o2::hf_bachelor::Bachelor const*> selectedBachelors;
 
   Filter filterSelectCandidates = (aod::hf_sel_candidate_xic::isSelXicToPKPi >= selectionFlagXic || aod::hf_sel_candidate_xic::isSelXicToPiKP >= selectionFlagXic);
 
@@ -67,8 +75,14 @@ struct HfCandidateCreatorXicc {
 
   void process(aod::Collision const& collision,
                soa::Filtered<soa::Join<aod::HfCand3Prong, aod::HfSelXicToPKPi>> const& xicCands,
-               aod::BigTracks const& tracks)
+               aod::BigTracksExtended const& tracks)
   {
+    bachelors.fill(tracks, [this](auto const& track) {
+      return track.pt() >= cutPtPionMin && std::abs(track.dcaXY()) >= cutDcaXYPionMin;
+    });
+    const double massMin = massXiccPDG - invMassWindowXicc;
+    const double massMax = invMassWindowXicc > 0. ? massXiccPDG + invMassWindowXicc : -1.;
+
     // 3-prong vertex fitter to rebuild the Xic vertex
     o2::vertexing::DCAFitterN<3> df3;
     df3.setBz(bz);
@@ -99,9 +113,18 @@ struct HfCandidateCreatorXicc {
       if (xicCand.isSelXicToPiKP() >= selectionFlagXic) {
         hMassXic->Fill(invMassXicToPiKP(xicCand), xicCand.pt());
       }
-      auto track0 = xicCand.prong0_as<aod::BigTracks>();
-      auto track1 = xicCand.prong1_as<aod::BigTracks>();
-      auto track2 = xicCand.prong2_as<aod::BigTracks>();
+      auto track0 = xicCand.prong0_as<aod::BigTracksExtended>();
+      auto track1 = xicCand.prong1_as<aod::BigTracksExtended>();
+      auto track2 = xicCand.prong2_as<aod::BigTracksExtended>();
+      int charge = track0.sign() + track1.sign() + track2.sign();
+
+      // pions of the sign of the Xic, the Xic vertex is refitted only if there is one in the Xicc mass window
+      selectedBachelors.clear();
+      bachelors.select(charge > 0 ? +1 : -1, array<float, 3>{xicCand.px(), xicCand.py(), xicCand.pz()}, massXic, massPi, massMin, massMax, selectedBachelors);
+      if (selectedBachelors.empty()) {
+        continue;
+      }
+
       auto trackParVar0 = getTrackParCov(track0);
       auto trackParVar1 = getTrackParCov(track1);
       auto trackParVar2 = getTrackParCov(track2);
@@ -126,23 +149,15 @@ struct HfCandidateCreatorXicc {
       int index0Xic = track0.globalIndex();
       int index1Xic = track1.globalIndex();
       int index2Xic = track2.globalIndex();
-      int charge = track0.sign() + track1.sign() + track2.sign();
 
-      for (auto& trackpion : tracks) {
-        if (trackpion.pt() < cutPtPionMin) {
-          continue;
-        }
-        if (trackpion.sign() * charge < 0) {
-          continue;
-        }
-        if (trackpion.globalIndex() == index0Xic || trackpion.globalIndex() == index1Xic || trackpion.globalIndex() == index2Xic) {
+      for (const auto* trackpion : selectedBachelors) {
+        if (trackpion->globalIndex == index0Xic || trackpion->globalIndex == index1Xic || trackpion->globalIndex == index2Xic) {
           continue;
         }
         array<float, 3> pvecpion;
-        auto trackParVarPi = getTrackParCov(trackpion);
 
         // reconstruct the 3-prong X vertex
-        if (df2.process(trackxic, trackParVarPi) == 0) {
+        if (df2.process(trackxic, trackpion->trackParCov) == 0) {
           continue;
         }
 
@@ -155,12 +170,15 @@ struct HfCandidateCreatorXicc {
         df2.getTrack(0).getPxPyPzGlo(pvecxic);
         df2.getTrack(1).getPxPyPzGlo(pvecpion);
 
+        // the impact parameters are computed on copies, the Xic and pion tracks are reused for the next pions
         auto primaryVertex = getPrimaryVertex(collision);
         auto covMatrixPV = primaryVertex.getCov();
         o2::dataformats::DCA impactParameter0;
         o2::dataformats::DCA impactParameter1;
-        trackxic.propagateToDCA(primaryVertex, bz, &impactParameter0);
-        trackParVarPi.propagateToDCA(primaryVertex, bz, &impactParameter1);
+        auto trackxicAtPV = trackxic;
+        auto trackParVarPiAtPV = trackpion->trackParCov;
+        trackxicAtPV.propagateToDCA(primaryVertex, bz, &impactParameter0);
+        trackParVarPiAtPV.propagateToDCA(primaryVertex, bz, &impactParameter1);
 
         // get uncertainty of the decay length
         double phi, theta;
@@ -179,7 +197,7 @@ struct HfCandidateCreatorXicc {
                          pvecpion[0], pvecpion[1], pvecpion[2],
                          impactParameter0.getY(), impactParameter1.getY(),
                          std::sqrt(impactParameter0.getSigmaY2()), std::sqrt(impactParameter1.getSigmaY2()),
-                         xicCand.globalIndex(), trackpion.globalIndex(),
+                         xicCand.globalIndex(), trackpion->globalIndex,
                          hfFlag);
       } // if on selected Xicc
     }   // loop over candidates
@@ -0,0 +1,603 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file candidateSelector3Prong.cxx
+/// \brief Selection of the 3-prong candidates for all the D±, Ds±, Λc± and Ξc± channels in a single pass
+///
+/// The candidates and their daughter tracks are read once and the selections of all the enabled channels are applied
+/// to each of them. The per-channel selection tables are produced with the same content as the per-channel selectors
+/// (candidate-selector-dplus-to-pi-k-pi, candidate-selector-ds-to-k-k-pi, candidate-selector-lc and
+/// candidate-selector-xic-to-p-k-pi), which must not run in the same workflow.
+/// The table of a disabled channel is filled with rejected candidates, so that it stays joinable with the candidates.
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "PWGHF/DataModel/CandidateReconstructionTables.h"
+#include "PWGHF/DataModel/CandidateSelectionTables.h"
+#include "Common/Core/TrackSelectorPID.h"
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::aod::hf_cand_3prong;
+using namespace o2::analysis;
+
+/// Struct for applying the selection cuts of all the 3-prong channels
+struct HfCandidateSelector3Prong {
+  Produces<aod::HfSelDplusToPiKPi> hfSelDplusToPiKPiCandidate;
+  Produces<aod::HfSelDsToKKPi> hfSelDsToKKPiCandidate;
+  Produces<aod::HfSelLc> hfSelLcCandidate;
+  Produces<aod::HfSelXicToPKPi> hfSelXicToPKPiCandidate;
+
+  // D± → π± K∓ π±
+  Configurable<bool> selectDplus{"selectDplus", true, "Select D+ → π+ K- π+ candidates"};
+  Configurable<double> ptCandMinDplus{"ptCandMinDplus", 1., "D+: Lower bound of candidate pT"};
+  Configurable<double> ptCandMaxDplus{"ptCandMaxDplus", 36., "D+: Upper bound of candidate pT"};
+  Configurable<double> ptPidTpcMinDplus{"ptPidTpcMinDplus", 0.15, "D+: Lower bound of track pT for TPC PID"};
+  Configurable<double> ptPidTpcMaxDplus{"ptPidTpcMaxDplus", 20., "D+: Upper bound of track pT for TPC PID"};
+  Configurable<double> nSigmaTpcMaxDplus{"nSigmaTpcMaxDplus", 3., "D+: Nsigma cut on TPC"};
+  Configurable<double> ptPidTofMinDplus{"ptPidTofMinDplus", 0.15, "D+: Lower bound of track pT for TOF PID"};
+  Configurable<double> ptPidTofMaxDplus{"ptPidTofMaxDplus", 20., "D+: Upper bound of track pT for TOF PID"};
+  Configurable<double> nSigmaTofMaxDplus{"nSigmaTofMaxDplus", 3., "D+: Nsigma cut on TOF"};
+  Configurable<std::vector<double>> binsPtDplus{"binsPtDplus", std::vector<double>{hf_cuts_dplus_to_pi_k_pi::vecBinsPt}, "D+: pT bin limits"};
+  Configurable<LabeledArray<double>> cutsDplus{"cutsDplus", {hf_cuts_dplus_to_pi_k_pi::cuts[0], hf_cuts_dplus_to_pi_k_pi::nBinsPt, hf_cuts_dplus_to_pi_k_pi::nCutVars, hf_cuts_dplus_to_pi_k_pi::labelsPt, hf_cuts_dplus_to_pi_k_pi::labelsCutVar}, "D+: candidate selection per pT bin"};
+  // Ds± → K± K∓ π±
+  Configurable<bool> selectDs{"selectDs", true, "Select Ds+ → K+ K- π+ candidates"};
+  Configurable<double> ptCandMinDs{"ptCandMinDs", 1., "Ds: Lower bound of candidate pT"};
+  Configurable<double> ptCandMaxDs{"ptCandMaxDs", 36., "Ds: Upper bound of candidate pT"};
+  Configurable<double> ptPidTpcMinDs{"ptPidTpcMinDs", 0.15, "Ds: Lower bound of track pT for TPC PID"};
+  Configurable<double> ptPidTpcMaxDs{"ptPidTpcMaxDs", 20., "Ds: Upper bound of track pT for TPC PID"};
+  Configurable<double> nSigmaTpcMaxDs{"nSigmaTpcMaxDs", 3., "Ds: Nsigma cut on TPC"};
+  Configurable<double> ptPidTofMinDs{"ptPidTofMinDs", 0.15, "Ds: Lower bound of track pT for TOF PID"};
+  Configurable<double> ptPidTofMaxDs{"ptPidTofMaxDs", 20., "Ds: Upper bound of track pT for TOF PID"};
+  Configurable<double> nSigmaTofMaxDs{"nSigmaTofMaxDs", 3., "Ds: Nsigma cut on TOF"};
+  Configurable<std::vector<double>> binsPtDs{"binsPtDs", std::vector<double>{hf_cuts_ds_to_k_k_pi::vecBinsPt}, "Ds: pT bin limits"};
+  Configurable<LabeledArray<double>> cutsDs{"cutsDs", {hf_cuts_ds_to_k_k_pi::cuts[0], hf_cuts_ds_to_k_k_pi::nBinsPt, hf_cuts_ds_to_k_k_pi::nCutVars, hf_cuts_ds_to_k_k_pi::labelsPt, hf_cuts_ds_to_k_k_pi::labelsCutVar}, "Ds: candidate selection per pT bin"};
+  // Λc± → p± K∓ π±
+  Configurable<bool> selectLc{"selectLc", true, "Select Λc+ → p K- π+ candidates"};
+  Configurable<double> ptCandMinLc{"ptCandMinLc", 0., "Lc: Lower bound of candidate pT"};
+  Configurable<double> ptCandMaxLc{"ptCandMaxLc", 36., "Lc: Upper bound of candidate pT"};
+  Configurable<bool> usePidLc{"usePidLc", true, "Lc: Bool to use or not the PID based on nSigma cut at filtering level"};
+  Configurable<double> ptPidTpcMinLc{"ptPidTpcMinLc", 0.1, "Lc: Lower bound of track pT for TPC PID"};
+  Configurable<double> ptPidTpcMaxLc{"ptPidTpcMaxLc", 1., "Lc: Upper bound of track pT for TPC PID"};
+  Configurable<double> nSigmaTpcMaxLc{"nSigmaTpcMaxLc", 3., "Lc: Nsigma cut on TPC only"};
+  Configurable<double> nSigmaTpcCombinedMaxLc{"nSigmaTpcCombinedMaxLc", 5., "Lc: Nsigma cut on TPC combined with TOF"};
+  Configurable<double> ptPidTofMinLc{"ptPidTofMinLc", 0.5, "Lc: Lower bound of track pT for TOF PID"};
+  Configurable<double> ptPidTofMaxLc{"ptPidTofMaxLc", 2.5, "Lc: Upper bound of track pT for TOF PID"};
+  Configurable<double> nSigmaTofMaxLc{"nSigmaTofMaxLc", 3., "Lc: Nsigma cut on TOF only"};
+  Configurable<double> nSigmaTofCombinedMaxLc{"nSigmaTofCombinedMaxLc", 5., "Lc: Nsigma cut on TOF combined with TPC"};
+  Configurable<bool> usePidBayesLc{"usePidBayesLc", true, "Lc: Bool to use or not the PID based on Bayesian probability cut at filtering level (requires processWithBayesPid)"};
+  Configurable<double> ptPidBayesMinLc{"ptPidBayesMinLc", 0., "Lc: Lower bound of track pT for Bayesian PID"};
+  Configurable<double> ptPidBayesMaxLc{"ptPidBayesMaxLc", 100, "Lc: Upper bound of track pT for Bayesian PID"};
+  Configurable<std::vector<double>> binsPtLc{"binsPtLc", std::vector<double>{hf_cuts_lc_to_p_k_pi::vecBinsPt}, "Lc: pT bin limits"};
+  Configurable<LabeledArray<double>> cutsLc{"cutsLc", {hf_cuts_lc_to_p_k_pi::cuts[0], hf_cuts_lc_to_p_k_pi::nBinsPt, hf_cuts_lc_to_p_k_pi::nCutVars, hf_cuts_lc_to_p_k_pi::labelsPt, hf_cuts_lc_to_p_k_pi::labelsCutVar}, "Lc: candidate selection per pT bin"};
+  // Ξc± → p± K∓ π±
+  Configurable<bool> selectXic{"selectXic", true, "Select Ξc+ → p K- π+ candidates"};
+  Configurable<double> ptCandMinXic{"ptCandMinXic", 0., "Xic: Lower bound of candidate pT"};
+  Configurable<double> ptCandMaxXic{"ptCandMaxXic", 36., "Xic: Upper bound of candidate pT"};
+  Configurable<bool> usePidXic{"usePidXic", true, "Xic: Bool to use or not the PID at filtering level"};
+  Configurable<double> ptPidTpcMinXic{"ptPidTpcMinXic", 0.15, "Xic: Lower bound of track pT for TPC PID"};
+  Configurable<double> ptPidTpcMaxXic{"ptPidTpcMaxXic", 1., "Xic: Upper bound of track pT for TPC PID"};
+  Configurable<double> nSigmaTpcMaxXic{"nSigmaTpcMaxXic", 3., "Xic: Nsigma cut on TPC only"};
+  Configurable<double> nSigmaTpcCombinedMaxXic{"nSigmaTpcCombinedMaxXic", 5., "Xic: Nsigma cut on TPC combined with TOF"};
+  Configurable<double> ptPidTofMinXic{"ptPidTofMinXic", 0.5, "Xic: Lower bound of track pT for TOF PID"};
+  Configurable<double> ptPidTofMaxXic{"ptPidTofMaxXic", 4., "Xic: Upper bound of track pT for TOF PID"};
+  Configurable<double> nSigmaTofMaxXic{"nSigmaTofMaxXic", 3., "Xic: Nsigma cut on TOF only"};
+  Configurable<double> nSigmaTofCombinedMaxXic{"nSigmaTofCombinedMaxXic", 5., "Xic: Nsigma cut on TOF combined with TPC"};
+  Configurable<double> decayLengthXYNormalisedMinXic{"decayLengthXYNormalisedMinXic", 3., "Xic: Min. normalised decay length XY"};
+  Configurable<std::vector<double>> binsPtXic{"binsPtXic", std::vector<double>{hf_cuts_xic_to_p_k_pi::vecBinsPt}, "Xic: pT bin limits"};
+  Configurable<LabeledArray<double>> cutsXic{"cutsXic", {hf_cuts_xic_to_p_k_pi::cuts[0], hf_cuts_xic_to_p_k_pi::nBinsPt, hf_cuts_xic_to_p_k_pi::nCutVars, hf_cuts_xic_to_p_k_pi::labelsPt, hf_cuts_xic_to_p_k_pi::labelsCutVar}, "Xic: candidate selection per pT bin"};
+
+  using TracksPid = aod::BigTracksPID;
+  using TracksPidWithBayes = soa::Join<aod::BigTracksPID, aod::pidBayesPi, aod::pidBayesKa, aod::pidBayesPr, aod::pidBayes>;
+
+  /// Compiled cuts and PID selectors of a channel
+  struct Channel {
+    HfPtBinnedCuts cuts;
+    TrackSelectorPID selectorPion;
+    TrackSelectorPID selectorKaon;
+    TrackSelectorPID selectorProton;
+  };
+  Channel dplus;
+  Channel ds;
+  Channel lc;
+  Channel xic;
+
+  // indices of the cut variables in the compiled cuts
+  struct {
+    int deltaM, ptPi, ptK, decLen, decLenXYNorm, cpa, cpaXY, maxNormDeltaIP;
+  } iCutDplus;
+  struct {
+    int m, ptPi, ptK, decLen, decLenXYNorm, cpa, cpaXY, maxNormDeltaIP;
+  } iCutDs;
+  struct {
+    int m, ptP, ptK, ptPi, chi2PCA, decLen, cpa;
+  } iCutLc, iCutXic;
+
+  void init(InitContext const&)
+  {
+    if (doprocessWithBayesPid && doprocessWithoutBayesPid) {
+      LOGF(fatal, "Cannot enable processWithBayesPid and processWithoutBayesPid at the same time. Please choose one.");
+    }
+    if (doprocessWithoutBayesPid && selectLc && usePidBayesLc) {
+      LOGF(fatal, "The Bayesian PID of the Lc selection requires processWithBayesPid");
+    }
+
+    dplus.cuts.build(binsPtDplus.value, cutsDplus.value);
+    dplus.selectorPion.setPDG(kPiPlus);
+    dplus.selectorPion.setRangePtTPC(ptPidTpcMinDplus, ptPidTpcMaxDplus);
+    dplus.selectorPion.setRangeNSigmaTPC(-nSigmaTpcMaxDplus, nSigmaTpcMaxDplus);
+    dplus.selectorPion.setRangePtTOF(ptPidTofMinDplus, ptPidTofMaxDplus);
+    dplus.selectorPion.setRangeNSigmaTOF(-nSigmaTofMaxDplus, nSigmaTofMaxDplus);
+    dplus.selectorKaon = dplus.selectorPion;
+    dplus.selectorKaon.setPDG(kKPlus);
+    iCutDplus = {dplus.cuts.getIndex("deltaM"), dplus.cuts.getIndex("pT Pi"), dplus.cuts.getIndex("pT K"), dplus.cuts.getIndex("decay length"),
+                 dplus.cuts.getIndex("normalized decay length XY"), dplus.cuts.getIndex("cos pointing angle"), dplus.cuts.getIndex("cos pointing angle XY"), dplus.cuts.getIndex("max normalized deltaIP")};
+
+    ds.cuts.build(binsPtDs.value, cutsDs.value);
+    ds.selectorPion.setPDG(kPiPlus);
+    ds.selectorPion.setRangePtTPC(ptPidTpcMinDs, ptPidTpcMaxDs);
+    ds.selectorPion.setRangeNSigmaTPC(-nSigmaTpcMaxDs, nSigmaTpcMaxDs);
+    ds.selectorPion.setRangePtTOF(ptPidTofMinDs, ptPidTofMaxDs);
+    ds.selectorPion.setRangeNSigmaTOF(-nSigmaTofMaxDs, nSigmaTofMaxDs);
+    ds.selectorKaon = ds.selectorPion;
+    ds.selectorKaon.setPDG(kKPlus);
+    iCutDs = {ds.cuts.getIndex("m"), ds.cuts.getIndex("pT Pi"), ds.cuts.getIndex("pT K"), ds.cuts.getIndex("decay length"),
+              ds.cuts.getIndex("normalized decay length XY"), ds.cuts.getIndex("cos pointing angle"), ds.cuts.getIndex("cos pointing angle XY"), ds.cuts.getIndex("max normalized deltaIP")};
+
+    lc.cuts.build(binsPtLc.value, cutsLc.value);
+    lc.selectorPion.setPDG(kPiPlus);
+    lc.selectorPion.setRangePtTPC(ptPidTpcMinLc, ptPidTpcMaxLc);
+    lc.selectorPion.setRangeNSigmaTPC(-nSigmaTpcMaxLc, nSigmaTpcMaxLc);
+    lc.selectorPion.setRangeNSigmaTPCCondTOF(-nSigmaTpcCombinedMaxLc, nSigmaTpcCombinedMaxLc);
+    lc.selectorPion.setRangePtTOF(ptPidTofMinLc, ptPidTofMaxLc);
+    lc.selectorPion.setRangeNSigmaTOF(-nSigmaTofMaxLc, nSigmaTofMaxLc);
+    lc.selectorPion.setRangeNSigmaTOFCondTPC(-nSigmaTofCombinedMaxLc, nSigmaTofCombinedMaxLc);
+    lc.selectorPion.setRangePtBayes(ptPidBayesMinLc, ptPidBayesMaxLc);
+    lc.selectorKaon = lc.selectorPion;
+    lc.selectorKaon.setPDG(kKPlus);
+    lc.selectorProton = lc.selectorPion;
+    lc.selectorProton.setPDG(kProton);
+    iCutLc = {lc.cuts.getIndex("m"), lc.cuts.getIndex("pT p"), lc.cuts.getIndex("pT K"), lc.cuts.getIndex("pT Pi"),
+              lc.cuts.getIndex("Chi2PCA"), lc.cuts.getIndex("decay length"), lc.cuts.getIndex("cos pointing angle")};
+
+    xic.cuts.build(binsPtXic.value, cutsXic.value);
+    xic.selectorPion.setPDG(kPiPlus);
+    xic.selectorPion.setRangePtTPC(ptPidTpcMinXic, ptPidTpcMaxXic);
+    xic.selectorPion.setRangeNSigmaTPC(-nSigmaTpcMaxXic, nSigmaTpcMaxXic);
+    xic.selectorPion.setRangeNSigmaTPCCondTOF(-nSigmaTpcCombinedMaxXic, nSigmaTpcCombinedMaxXic);
+    xic.selectorPion.setRangePtTOF(ptPidTofMinXic, ptPidTofMaxXic);
+    xic.selectorPion.setRangeNSigmaTOF(-nSigmaTofMaxXic, nSigmaTofMaxXic);
+    xic.selectorPion.setRangeNSigmaTOFCondTPC(-nSigmaTofCombinedMaxXic, nSigmaTofCombinedMaxXic);
+    xic.selectorKaon = xic.selectorPion;
+    xic.selectorKaon.setPDG(kKPlus);
+    xic.selectorProton = xic.selectorPion;
+    xic.selectorProton.setPDG(kProton);
+    iCutXic = {xic.cuts.getIndex("m"), xic.cuts.getIndex("pT p"), xic.cuts.getIndex("pT K"), xic.cuts.getIndex("pT Pi"),
+               xic.cuts.getIndex("chi2PCA"), xic.cuts.getIndex("decay length"), xic.cuts.getIndex("cos pointing angle")};
+  }
+
+  /// D± topological selection, as in candidate-selector-dplus-to-pi-k-pi
+  /// \param candidate is candidate
+  /// \param trackPion1 is the first track with the pion hypothesis
+  /// \param trackKaon is the track with the kaon hypothesis
+  /// \param trackPion2 is the second track with the pion hypothesis
+  /// \return true if candidate passes all cuts
+  template <typename T1, typename T2>
+  bool selectionTopolDplus(const T1& candidate, const T2& trackPion1, const T2& trackKaon, const T2& trackPion2)
+  {
+    auto candpT = candidate.pt();
+    int pTBin = dplus.cuts.findBin(candpT);
+    if (pTBin == -1) {
+      return false;
+    }
+    if (candpT < ptCandMinDplus || candpT > ptCandMaxDplus) {
+      return false;
+    }
+    const auto* cuts = dplus.cuts.getRow(pTBin);
+    if (trackPion1.pt() < cuts[iCutDplus.ptPi] || trackKaon.pt() < cuts[iCutDplus.ptK] || trackPion2.pt() < cuts[iCutDplus.ptPi]) {
+      return false;
+    }
+    if (std::abs(invMassDplusToPiKPi(candidate) - RecoDecay::getMassPDG(pdg::Code::kDPlus)) > cuts[iCutDplus.deltaM]) {
+      return false;
+    }
+    if (candidate.decayLength() < cuts[iCutDplus.decLen]) {
+      return false;
+    }
+    if (candidate.decayLengthXYNormalised() < cuts[iCutDplus.decLenXYNorm]) {
+      return false;
+    }
+    if (candidate.cpa() < cuts[iCutDplus.cpa]) {
+      return false;
+    }
+    if (candidate.cpaXY() < cuts[iCutDplus.cpaXY]) {
+      return false;
+    }
+    if (std::abs(candidate.maxNormalisedDeltaIP()) > cuts[iCutDplus.maxNormDeltaIP]) {
+      return false;
+    }
+    return true;
+  }
+
+  /// D± selection status, as in candidate-selector-dplus-to-pi-k-pi
+  template <typename T1, typename T2>
+  int selectDplusToPiKPi(const T1& candidate, const T2& trackPos1, const T2& trackNeg, const T2& trackPos2)
+  {
+    auto statusDplusToPiKPi = 0;
+    if (!(candidate.hfflag() & 1 << DecayType::DplusToPiKPi)) {
+      return statusDplusToPiKPi;
+    }
+    SETBIT(statusDplusToPiKPi, aod::SelectionStep::RecoSkims);
+
+    if (!selectionTopolDplus(candidate, trackPos1, trackNeg, trackPos2)) {
+      return statusDplusToPiKPi;
+    }
+    SETBIT(statusDplusToPiKPi, aod::SelectionStep::RecoTopol);
+
+    int pidTrackPos1Pion = dplus.selectorPion.getStatusTrackPIDAll(trackPos1);
+    int pidTrackNegKaon = dplus.selectorKaon.getStatusTrackPIDAll(trackNeg);
+    int pidTrackPos2Pion = dplus.selectorPion.getStatusTrackPIDAll(trackPos2);
+    if (pidTrackPos1Pion == TrackSelectorPID::Status::PIDRejected ||
+        pidTrackNegKaon == TrackSelectorPID::Status::PIDRejected ||
+        pidTrackPos2Pion == TrackSelectorPID::Status::PIDRejected) {
+      return statusDplusToPiKPi;
+    }
+    SETBIT(statusDplusToPiKPi, aod::SelectionStep::RecoPID);
+    return statusDplusToPiKPi;
+  }
+
+  /// Ds± topological selection common to the KKπ and πKK hypotheses, as in candidate-selector-ds-to-k-k-pi
+  /// The invariant masses of both hypotheses are computed at once from the shared prong momenta.
+  /// \param candidate is candidate
+  /// \param pTBin is the pT bin of the candidate
+  /// \return true if candidate passes all cuts
+  template <typename T>
+  bool selectionTopolDs(const T& candidate, int pTBin)
+  {
+    auto candpT = candidate.pt();
+    if (candpT < ptCandMinDs || candpT > ptCandMaxDs) {
+      return false;
+    }
+    const auto* cuts = ds.cuts.getRow(pTBin);
+    if (candidate.decayLength() < cuts[iCutDs.decLen]) {
+      return false;
+    }
+    if (candidate.decayLengthXYNormalised() < cuts[iCutDs.decLenXYNorm]) {
+      return false;
+    }
+    if (candidate.cpa() < cuts[iCutDs.cpa]) {
+      return false;
+    }
+    if (candidate.cpaXY() < cuts[iCutDs.cpaXY]) {
+      return false;
+    }
+    if (std::abs(candidate.maxNormalisedDeltaIP()) > cuts[iCutDs.maxNormDeltaIP]) {
+      return false;
+    }
+    const double massPi = RecoDecay::getMassPDG(kPiPlus);
+    const double massK = RecoDecay::getMassPDG(kKPlus);
+    const double massDs = RecoDecay::getMassPDG(pdg::Code::kDS);
+    auto massHypos = RecoDecay::m2Hypos(array{candidate.pVectorProng0(), candidate.pVectorProng1(), candidate.pVectorProng2()},
+                                        array{array{massK, massK, massPi}, array{massPi, massK, massK}});
+    if (std::abs(std::sqrt(massHypos[0]) - massDs) > cuts[iCutDs.m] && std::abs(std::sqrt(massHypos[1]) - massDs) > cuts[iCutDs.m]) {
+      return false;
+    }
+    return true;
+  }
+
+  /// Ds± topological selection specific to one of the KKπ and πKK hypotheses
+  /// \param pTBin is the pT bin of the candidate
+  /// \param trackKaon1 is the first track with the kaon hypothesis
+  /// \param trackKaon2 is the second track with the kaon hypothesis
+  /// \param trackPion is the track with the pion hypothesis
+  /// \return true if candidate passes all cuts for the given hypothesis
+  template <typename T>
+  bool selectionTopolConjugateDs(int pTBin, const T& trackKaon1, const T& trackKaon2, const T& trackPion)
+  {
+    const auto* cuts = ds.cuts.getRow(pTBin);
+    return trackKaon1.pt() >= cuts[iCutDs.ptK] && trackKaon2.pt() >= cuts[iCutDs.ptK] && trackPion.pt() >= cuts[iCutDs.ptPi];
+  }
+
+  /// Ds± selection statuses of the KKπ and πKK mass hypotheses, as in candidate-selector-ds-to-k-k-pi
+  template <typename T1, typename T2>
+  void selectDsToKKPi(const T1& candidate, const T2& trackPos1, const T2& trackNeg, const T2& trackPos2, int& statusDsToKKPi, int& statusDsToPiKK)
+  {
+    statusDsToKKPi = 0;
+    statusDsToPiKK = 0;
+    if (!(candidate.hfflag() & 1 << DecayType::DsToKKPi)) {
+      return;
+    }
+    SETBIT(statusDsToKKPi, aod::SelectionStep::RecoSkims);
+    SETBIT(statusDsToPiKK, aod::SelectionStep::RecoSkims);
+
+    int pTBin = ds.cuts.findBin(candidate.pt());
+    if (pTBin == -1 || !selectionTopolDs(candidate, pTBin)) {
+      return;
+    }
+    bool topoDsToKKPi = selectionTopolConjugateDs(pTBin, trackPos1, trackNeg, trackPos2);
+    bool topoDsToPiKK = selectionTopolConjugateDs(pTBin, trackPos2, trackNeg, trackPos1);
+    if (!topoDsToKKPi && !topoDsToPiKK) {
+      return;
+    }
+    if (topoDsToKKPi) {
+      SETBIT(statusDsToKKPi, aod::SelectionStep::RecoTopol);
+    }
+    if (topoDsToPiKK) {
+      SETBIT(statusDsToPiKK, aod::SelectionStep::RecoTopol);
+    }
+
+    int pidTrackNegKaon = ds.selectorKaon.getStatusTrackPIDAll(trackNeg);
+    if (pidTrackNegKaon == TrackSelectorPID::Status::PIDRejected) {
+      return;
+    }
+    int pidTrackPos1Pion = ds.selectorPion.getStatusTrackPIDAll(trackPos1);
+    int pidTrackPos2Pion = ds.selectorPion.getStatusTrackPIDAll(trackPos2);
+    int pidTrackPos1Kaon = ds.selectorKaon.getStatusTrackPIDAll(trackPos1);
+    int pidTrackPos2Kaon = ds.selectorKaon.getStatusTrackPIDAll(trackPos2);
+    if (pidTrackPos1Kaon == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackNegKaon == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackPos2Pion == TrackSelectorPID::Status::PIDAccepted) {
+      SETBIT(statusDsToKKPi, aod::SelectionStep::RecoPID);
+    }
+    if (pidTrackPos1Pion == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackNegKaon == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackPos2Kaon == TrackSelectorPID::Status::PIDAccepted) {
+      SETBIT(statusDsToPiKK, aod::SelectionStep::RecoPID);
+    }
+  }
+
+  /// Conjugate-dependent topological selection of the pKπ channels (Λc± and Ξc±)
+  /// \param channel are the cuts of the channel
+  /// \param iCut are the indices of the cut variables of the channel
+  /// \param massPdg is the mass of the decaying particle
+  /// \param candidate is candidate
+  /// \param trackProton is the track with the proton hypothesis
+  /// \param trackKaon is the track with the kaon hypothesis
+  /// \param trackPion is the track with the pion hypothesis
+  /// \param invMassPKPi is the invariant mass with the proton as first daughter
+  /// \param invMassPiKP is the invariant mass with the proton as third daughter
+  /// \return true if candidate passes all cuts for the given conjugate
+  template <typename TCuts, typename T1, typename T2>
+  bool selectionTopolConjugatePKPi(Channel const& channel, TCuts const& iCut, double massPdg, int pTBin, const T1& candidate, const T2& trackProton, const T2& trackKaon, const T2& trackPion, double invMassPKPi, double invMassPiKP)
+  {
+    const auto* cuts = channel.cuts.getRow(pTBin);
+    if (trackProton.pt() < cuts[iCut.ptP] || trackKaon.pt() < cuts[iCut.ptK] || trackPion.pt() < cuts[iCut.ptPi]) {
+      return false;
+    }
+    const double invMass = trackProton.globalIndex() == candidate.prong0Id() ? invMassPKPi : invMassPiKP;
+    return std::abs(invMass - massPdg) <= cuts[iCut.m];
+  }
+
+  /// n-sigma PID of the pKπ and πKp hypotheses of the pKπ channels
+  /// \param getStatus returns the PID status of a track for a selector
+  /// \param pidPKPi is set to 1 (accepted), 0 (excluded) or left to -1 (not applicable) for the pKπ hypothesis
+  /// \param pidPiKP is the same for the πKp hypothesis
+  template <typename TStatus, typename T>
+  void selectPidPKPi(Channel& channel, TStatus getStatus, const T& trackPos1, const T& trackNeg, const T& trackPos2, int& pidPKPi, int& pidPiKP)
+  {
+    int pidTrackPos1Proton = getStatus(channel.selectorProton, trackPos1);
+    int pidTrackPos2Proton = getStatus(channel.selectorProton, trackPos2);
+    int pidTrackPos1Pion = getStatus(channel.selectorPion, trackPos1);
+    int pidTrackPos2Pion = getStatus(channel.selectorPion, trackPos2);
+    int pidTrackNegKaon = getStatus(channel.selectorKaon, trackNeg);
+
+    if (pidTrackPos1Proton == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackNegKaon == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackPos2Pion == TrackSelectorPID::Status::PIDAccepted) {
+      pidPKPi = 1;
+    } else if (pidTrackPos1Proton == TrackSelectorPID::Status::PIDRejected ||
+               pidTrackNegKaon == TrackSelectorPID::Status::PIDRejected ||
+               pidTrackPos2Pion == TrackSelectorPID::Status::PIDRejected) {
+      pidPKPi = 0;
+    }
+    if (pidTrackPos2Proton == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackNegKaon == TrackSelectorPID::Status::PIDAccepted &&
+        pidTrackPos1Pion == TrackSelectorPID::Status::PIDAccepted) {
+      pidPiKP = 1;
+    } else if (pidTrackPos1Pion == TrackSelectorPID::Status::PIDRejected ||
+               pidTrackNegKaon == TrackSelectorPID::Status::PIDRejected ||
+               pidTrackPos2Proton == TrackSelectorPID::Status::PIDRejected) {
+      pidPiKP = 0;
+    }
+  }
+
+  /// Λc± selection statuses of the pKπ and πKp mass hypotheses, as in candidate-selector-lc
+  template <bool withBayesPid, typename T1, typename T2>
+  void selectLcToPKPi(const T1& candidate, const T2& trackPos1, const T2& trackNeg, const T2& trackPos2, int& statusLcToPKPi, int& statusLcToPiKP)
+  {
+    statusLcToPKPi = 0;
+    statusLcToPiKP = 0;
+    if (!(candidate.hfflag() & 1 << DecayType::LcToPKPi)) {
+      return;
+    }
+
+    // conjugate-independent topological selection
+    auto candpT = candidate.pt();
+    int pTBin = lc.cuts.findBin(candpT);
+    if (pTBin == -1) {
+      return;
+    }
+    if (candpT < ptCandMinLc || candpT >= ptCandMaxLc) {
+      return;
+    }
+    const auto* cuts = lc.cuts.getRow(pTBin);
+    if (candidate.cpa() <= cuts[iCutLc.cpa] || candidate.chi2PCA() > cuts[iCutLc.chi2PCA] || candidate.decayLength() <= cuts[iCutLc.decLen]) {
+      return;
+    }
+
+    // conjugate-dependent topological selection
+    const double massLc = RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus);
+    const double invMassPKPi = invMassLcToPKPi(candidate);
+    const double invMassPiKP = invMassLcToPiKP(candidate);
+    bool topolLcToPKPi = selectionTopolConjugatePKPi(lc, iCutLc, massLc, pTBin, candidate, trackPos1, trackNeg, trackPos2, invMassPKPi, invMassPiKP);
+    bool topolLcToPiKP = selectionTopolConjugatePKPi(lc, iCutLc, massLc, pTBin, candidate, trackPos2, trackNeg, trackPos1, invMassPKPi, invMassPiKP);
+    if (!topolLcToPKPi && !topolLcToPiKP) {
+      return;
+    }
+
+    auto pidLcToPKPi = -1;
+    auto pidLcToPiKP = -1;
+    auto pidBayesLcToPKPi = -1;
+    auto pidBayesLcToPiKP = -1;
+    if (!usePidLc) {
+      pidLcToPKPi = 1;
+      pidLcToPiKP = 1;
+    } else {
+      selectPidPKPi(
+        lc, [](TrackSelectorPID& selector, const T2& track) { return selector.getStatusTrackPIDAll(track); }, trackPos1, trackNeg, trackPos2, pidLcToPKPi, pidLcToPiKP);
+    }
+    if constexpr (withBayesPid) {
+      if (!usePidBayesLc) {
+        pidBayesLcToPKPi = 1;
+        pidBayesLcToPiKP = 1;
+      } else {
+        selectPidPKPi(
+          lc, [](TrackSelectorPID& selector, const T2& track) { return selector.getStatusTrackBayesPID(track); }, trackPos1, trackNeg, trackPos2, pidBayesLcToPKPi, pidBayesLcToPiKP);
+      }
+    } else {
+      pidBayesLcToPKPi = 1;
+      pidBayesLcToPiKP = 1;
+    }
+
+    if (pidLcToPKPi == 0 && pidLcToPiKP == 0) {
+      return;
+    }
+    if (pidBayesLcToPKPi == 0 && pidBayesLcToPiKP == 0) {
+      return;
+    }
+    if ((pidLcToPKPi == -1 || pidLcToPKPi == 1) && (pidBayesLcToPKPi == -1 || pidBayesLcToPKPi == 1) && topolLcToPKPi) {
+      statusLcToPKPi = 1;
+    }
+    if ((pidLcToPiKP == -1 || pidLcToPiKP == 1) && (pidBayesLcToPiKP == -1 || pidBayesLcToPiKP == 1) && topolLcToPiKP) {
+      statusLcToPiKP = 1;
+    }
+  }
+
+  /// Ξc± selection statuses of the pKπ and πKp mass hypotheses, as in candidate-selector-xic-to-p-k-pi
+  template <typename T1, typename T2>
+  void selectXicToPKPi(const T1& candidate, const T2& trackPos1, const T2& trackNeg, const T2& trackPos2, int& statusXicToPKPi, int& statusXicToPiKP)
+  {
+    statusXicToPKPi = 0;
+    statusXicToPiKP = 0;
+    if (!(candidate.hfflag() & 1 << DecayType::XicToPKPi)) {
+      return;
+    }
+
+    // conjugate-independent topological selection
+    auto candpT = candidate.pt();
+    int pTBin = xic.cuts.findBin(candpT);
+    if (pTBin == -1) {
+      return;
+    }
+    if (candpT < ptCandMinXic || candpT >= ptCandMaxXic) {
+      return;
+    }
+    const auto* cuts = xic.cuts.getRow(pTBin);
+    if (candidate.cpa() <= cuts[iCutXic.cpa] || candidate.chi2PCA() > cuts[iCutXic.chi2PCA] || candidate.decayLength() <= cuts[iCutXic.decLen]) {
+      return;
+    }
+    if (candidate.decayLengthXYNormalised() < decayLengthXYNormalisedMinXic) {
+      return;
+    }
+
+    // conjugate-dependent topological selection
+    const double massXic = RecoDecay::getMassPDG(pdg::Code::kXiCPlus);
+    const double invMassPKPi = invMassXicToPKPi(candidate);
+    const double invMassPiKP = invMassXicToPiKP(candidate);
+    bool topolXicToPKPi = selectionTopolConjugatePKPi(xic, iCutXic, massXic, pTBin, candidate, trackPos1, trackNeg, trackPos2, invMassPKPi, invMassPiKP);
+    bool topolXicToPiKP = selectionTopolConjugatePKPi(xic, iCutXic, massXic, pTBin, candidate, trackPos2, trackNeg, trackPos1, invMassPKPi, invMassPiKP);
+    if (!topolXicToPKPi && !topolXicToPiKP) {
+      return;
+    }
+
+    auto pidXicToPKPi = -1;
+    auto pidXicToPiKP = -1;
+    if (!usePidXic) {
+      pidXicToPKPi = 1;
+      pidXicToPiKP = 1;
+    } else {
+      selectPidPKPi(
+        xic, [](TrackSelectorPID& selector, const T2& track) { return selector.getStatusTrackPIDAll(track); }, trackPos1, trackNeg, trackPos2, pidXicToPKPi, pidXicToPiKP);
+    }
+    if (pidXicToPKPi == 0 && pidXicToPiKP == 0) {
+      return;
+    }
+    if ((pidXicToPKPi == -1 || pidXicToPKPi == 1) && topolXicToPKPi) {
+      statusXicToPKPi = 1;
+    }
+    if ((pidXicToPiKP == -1 || pidXicToPiKP == 1) && topolXicToPiKP) {
+      statusXicToPiKP = 1;
+    }
+  }
+
+  /// Selects the candidates for all the enabled channels in a single loop
+  template <bool withBayesPid, typename TTracks>
+  void runSelections(aod::HfCand3Prong const& candidates)
+  {
+    const auto nCandidates = candidates.size();
+    hfSelDplusToPiKPiCandidate.reserve(nCandidates);
+    hfSelDsToKKPiCandidate.reserve(nCandidates);
+    hfSelLcCandidate.reserve(nCandidates);
+    hfSelXicToPKPiCandidate.reserve(nCandidates);
+
+    for (const auto& candidate : candidates) {
+      auto trackPos1 = candidate.prong0_as<TTracks>(); // positive daughter (negative for the antiparticles)
+      auto trackNeg = candidate.prong1_as<TTracks>();  // negative daughter (positive for the antiparticles)
+      auto trackPos2 = candidate.prong2_as<TTracks>(); // positive daughter (negative for the antiparticles)
+
+      int statusDplusToPiKPi = 0;
+      if (selectDplus) {
+        statusDplusToPiKPi = selectDplusToPiKPi(candidate, trackPos1, trackNeg, trackPos2);
+      }
+      hfSelDplusToPiKPiCandidate(statusDplusToPiKPi);
+
+      int statusDsToKKPi = 0;
+      int statusDsToPiKK = 0;
+      if (selectDs) {
+        selectDsToKKPi(candidate, trackPos1, trackNeg, trackPos2, statusDsToKKPi, statusDsToPiKK);
+      }
+      hfSelDsToKKPiCandidate(statusDsToKKPi, statusDsToPiKK);
+
+      int statusLcToPKPi = 0;
+      int statusLcToPiKP = 0;
+      if (selectLc) {
+        selectLcToPKPi<withBayesPid>(candidate, trackPos1, trackNeg, trackPos2, statusLcToPKPi, statusLcToPiKP);
+      }
+      hfSelLcCandidate(statusLcToPKPi, statusLcToPiKP);
+
+      int statusXicToPKPi = 0;
+      int statusXicToPiKP = 0;
+      if (selectXic) {
+        selectXicToPKPi(candidate, trackPos1, trackNeg, trackPos2, statusXicToPKPi, statusXicToPiKP);
+      }
+      hfSelXicToPKPiCandidate(statusXicToPKPi, statusXicToPiKP);
+    }
+  }
+
+  void processWithBayesPid(aod::HfCand3Prong const& candidates, TracksPidWithBayes const&)
+  {
+    runSelections<true, TracksPidWithBayes>(candidates);
+  }
+
+  PROCESS_SWITCH(HfCandidateSelector3Prong, processWithBayesPid, "Select the candidates, with the Bayesian PID of the Lc selection", true);
+
+  void processWithoutBayesPid(aod::HfCand3Prong const& candidates, TracksPid const&)
+  {
+    runSelections<false, TracksPid>(candidates);
+  }
+
+  PROCESS_SWITCH(HfCandidateSelector3Prong, processWithoutBayesPid, "Select the candidates, without the Bayesian PID tables", false);
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{
+    adaptAnalysisTask<HfCandidateSelector3Prong>(cfgc)};
+}
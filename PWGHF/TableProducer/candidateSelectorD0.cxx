@@ -46,6 +46,50 @@ struct HfCandidateSelectorD0 {
   Configurable<std::vector<double>> binsPt{"binsPt", std::vector<double>{hf_cuts_d0_to_pi_k::vecBinsPt}, "pT bin limits"};
   Configurable<LabeledArray<double>> cuts{"cuts", {hf_cuts_d0_to_pi_k::cuts[0], nBinsPt, nCutVars, labelsPt, labelsCutVar}, "D0 candidate selection per pT bin"};
 
+  HfPtBinnedCuts cutTable; // compiled binsPt and cuts
+  // indices of the cut variables in cutTable
+  int iCutMass = -1;
+  int iCutCosThetaStar = -1;
+  int iCutPtK = -1;
+  int iCutPtPi = -1;
+  int iCutD0K = -1;
+  int iCutD0Pi = -1;
+  int iCutDecLenMin = -1;
+  int iCutDecLen = -1;
+  int iCutDecLenXY = -1;
+  // batch selections of the conjugate-independent cuts that only depend on the candidate columns
+  uint32_t maskTopolBatch = 0;
+  std::vector<float> ptBatch;
+  std::vector<float> impParProductBatch;
+  std::vector<float> cpaBatch;
+  std::vector<float> cpaXYBatch;
+  std::vector<float> decLenXYNormBatch;
+  std::vector<int> binsBatch;
+  std::vector<uint32_t> masksBatch;
+  // PID statuses of all the tracks, computed once and shared by the candidates using the same tracks
+  std::vector<int8_t> statusPidPion;
+  std::vector<int8_t> statusPidKaon;
+
+  void init(InitContext const&)
+  {
+    cutTable.build(binsPt.value, cuts.value);
+    iCutMass = cutTable.getIndex("m");
+    iCutCosThetaStar = cutTable.getIndex("cos theta*");
+    iCutPtK = cutTable.getIndex("pT K");
+    iCutPtPi = cutTable.getIndex("pT Pi");
+    iCutD0K = cutTable.getIndex("d0K");
+    iCutD0Pi = cutTable.getIndex("d0pi");
+    iCutDecLenMin = cutTable.getIndex("minimum decay length");
+    iCutDecLen = cutTable.getIndex("decay length");
+    iCutDecLenXY = cutTable.getIndex("decay length XY");
+    // the order of the rules is the order of the inputs of selectBatch
+    cutTable.addRule("d0d0", HfPtBinnedCuts::Upper);
+    cutTable.addRule("cos pointing angle", HfPtBinnedCuts::Lower);
+    cutTable.addRule("cos pointing angle xy", HfPtBinnedCuts::Lower);
+    cutTable.addRule("normalized decay length XY", HfPtBinnedCuts::Lower);
+    maskTopolBatch = cutTable.getMaskAll();
+  }
+
   /*
   /// Selection on goodness of daughter tracks
   /// \note should be applied at candidate selection
@@ -63,12 +107,13 @@ struct HfCandidateSelectorD0 {
 
   /// Conjugate-independent topological cuts
   /// \param candidate is candidate
+  /// \param pTBin is the pT bin of the candidate
+  /// \param maskBatch are the cuts of the batch selection passed by the candidate
   /// \return true if candidate passes all cuts
   template <typename T>
-  bool selectionTopol(const T& candidate)
+  bool selectionTopol(const T& candidate, int pTBin, uint32_t maskBatch)
   {
     auto candpT = candidate.pt();
-    auto pTBin = findBin(binsPt, candpT);
     if (pTBin == -1) {
       return false;
     }
@@ -77,20 +122,8 @@ struct HfCandidateSelectorD0 {
     if (candpT < ptCandMin || candpT >= ptCandMax) {
       return false;
     }
-    // product of daughter impact parameters
-    if (candidate.impactParameterProduct() > cuts->get(pTBin, "d0d0")) {
-      return false;
-    }
-    // cosine of pointing angle
-    if (candidate.cpa() < cuts->get(pTBin, "cos pointing angle")) {
-      return false;
-    }
-    // cosine of pointing angle XY
-    if (candidate.cpaXY() < cuts->get(pTBin, "cos pointing angle xy")) {
-      return false;
-    }
-    // normalised decay length in XY plane
-    if (candidate.decayLengthXYNormalised() < cuts->get(pTBin, "normalized decay length XY")) {
+    // product of daughter impact parameters, cosine of pointing angle (3D and XY) and normalised decay length in XY plane
+    if (maskBatch != maskTopolBatch) {
       return false;
     }
     // candidate DCA
@@ -101,14 +134,14 @@ struct HfCandidateSelectorD0 {
     if (std::abs(candidate.impactParameterNormalised0()) < 0.5 || std::abs(candidate.impactParameterNormalised1()) < 0.5) {
       return false;
     }
-    double decayLengthCut = std::min((candidate.p() * 0.0066) + 0.01, cuts->get(pTBin, "minimum decay length"));
+    double decayLengthCut = std::min((candidate.p() * 0.0066) + 0.01, cutTable.get(pTBin, iCutDecLenMin));
     if (candidate.decayLength() * candidate.decayLength() < decayLengthCut * decayLengthCut) {
       return false;
     }
-    if (candidate.decayLength() > cuts->get(pTBin, "decay length")) {
+    if (candidate.decayLength() > cutTable.get(pTBin, iCutDecLen)) {
       return false;
     }
-    if (candidate.decayLengthXY() > cuts->get(pTBin, "decay length XY")) {
+    if (candidate.decayLengthXY() > cutTable.get(pTBin, iCutDecLenXY)) {
       return false;
     }
     if (candidate.decayLengthNormalised() * candidate.decayLengthNormalised() < 1.0) {
@@ -121,45 +154,44 @@ struct HfCandidateSelectorD0 {
   /// \param candidate is candidate
   /// \param trackPion is the track with the pion hypothesis
   /// \param trackKaon is the track with the kaon hypothesis
+  /// \param pTBin is the pT bin of the candidate
   /// \note trackPion = positive and trackKaon = negative for D0 selection and inverse for D0bar
   /// \return true if candidate passes all cuts for the given Conjugate
   template <typename T1, typename T2>
-  bool selectionTopolConjugate(const T1& candidate, const T2& trackPion, const T2& trackKaon)
+  bool selectionTopolConjugate(const T1& candidate, const T2& trackPion, const T2& trackKaon, int pTBin)
   {
-    auto candpT = candidate.pt();
-    auto pTBin = findBin(binsPt, candpT);
     if (pTBin == -1) {
       return false;
     }
 
     // invariant-mass cut
     if (trackPion.sign() > 0) {
-      if (std::abs(invMassD0ToPiK(candidate) - RecoDecay::getMassPDG(pdg::Code::kD0)) > cuts->get(pTBin, "m")) {
+      if (std::abs(invMassD0ToPiK(candidate) - RecoDecay::getMassPDG(pdg::Code::kD0)) > cutTable.get(pTBin, iCutMass)) {
         return false;
       }
     } else {
-      if (std::abs(invMassD0barToKPi(candidate) - RecoDecay::getMassPDG(pdg::Code::kD0)) > cuts->get(pTBin, "m")) {
+      if (std::abs(invMassD0barToKPi(candidate) - RecoDecay::getMassPDG(pdg::Code::kD0)) > cutTable.get(pTBin, iCutMass)) {
         return false;
       }
     }
 
     // cut on daughter pT
-    if (trackPion.pt() < cuts->get(pTBin, "pT Pi") || trackKaon.pt() < cuts->get(pTBin, "pT K")) {
+    if (trackPion.pt() < cutTable.get(pTBin, iCutPtPi) || trackKaon.pt() < cutTable.get(pTBin, iCutPtK)) {
       return false;
     }
 
     // cut on daughter DCA - need to add secondary vertex constraint here
-    if (std::abs(trackPion.dcaXY()) > cuts->get(pTBin, "d0pi") || std::abs(trackKaon.dcaXY()) > cuts->get(pTBin, "d0K")) {
+    if (std::abs(trackPion.dcaXY()) > cutTable.get(pTBin, iCutD0Pi) || std::abs(trackKaon.dcaXY()) > cutTable.get(pTBin, iCutD0K)) {
       return false;
     }
 
     // cut on cos(theta*)
     if (trackPion.sign() > 0) {
-      if (std::abs(cosThetaStarD0(candidate)) > cuts->get(pTBin, "cos theta*")) {
+      if (std::abs(cosThetaStarD0(candidate)) > cutTable.get(pTBin, iCutCosThetaStar)) {
         return false;
       }
     } else {
-      if (std::abs(cosThetaStarD0bar(candidate)) > cuts->get(pTBin, "cos theta*")) {
+      if (std::abs(cosThetaStarD0bar(candidate)) > cutTable.get(pTBin, iCutCosThetaStar)) {
         return false;
       }
     }
@@ -167,7 +199,7 @@ struct HfCandidateSelectorD0 {
     return true;
   }
 
-  void process(aod::HfCand2Prong const& candidates, aod::BigTracksPIDExtended const&)
+  void process(aod::HfCand2Prong const& candidates, aod::BigTracksPIDExtended const& tracks)
   {
     TrackSelectorPID selectorPion(kPiPlus);
     selectorPion.setRangePtTPC(ptPidTpcMin, ptPidTpcMax);
@@ -180,8 +212,30 @@ struct HfCandidateSelectorD0 {
     TrackSelectorPID selectorKaon(selectorPion);
     selectorKaon.setPDG(kKPlus);
 
+    selectorPion.fillStatusTrackPIDAll(tracks, statusPidPion);
+    selectorKaon.fillStatusTrackPIDAll(tracks, statusPidKaon);
+
+    // batch selection of the pT bins and of the cuts on the candidate columns
+    const auto nCandidates = candidates.size();
+    ptBatch.clear();
+    impParProductBatch.clear();
+    cpaBatch.clear();
+    cpaXYBatch.clear();
+    decLenXYNormBatch.clear();
+    for (const auto& candidate : candidates) {
+      ptBatch.push_back(candidate.pt());
+      impParProductBatch.push_back(candidate.impactParameterProduct());
+      cpaBatch.push_back(candidate.cpa());
+      cpaXYBatch.push_back(candidate.cpaXY());
+      decLenXYNormBatch.push_back(candidate.decayLengthXYNormalised());
+    }
+    cutTable.selectBatch(nCandidates, ptBatch.data(), std::vector<const float*>{impParProductBatch.data(), cpaBatch.data(), cpaXYBatch.data(), decLenXYNormBatch.data()}, binsBatch, masksBatch);
+
     // looping over 2-prong candidates
+    int iCandidate = -1;
     for (auto& candidate : candidates) {
+      ++iCandidate;
+      const auto pTBin = binsBatch[iCandidate];
 
       // final selection flag: 0 - rejected, 1 - accepted
       int statusD0 = 0;
@@ -208,7 +262,7 @@ struct HfCandidateSelectorD0 {
       */
 
       // conjugate-independent topological selection
-      if (!selectionTopol(candidate)) {
+      if (!selectionTopol(candidate, pTBin, masksBatch[iCandidate])) {
         hfSelD0Candidate(statusD0, statusD0bar, statusHFFlag, statusTopol, statusCand, statusPID);
         continue;
       }
@@ -218,9 +272,9 @@ struct HfCandidateSelectorD0 {
       // need to add special cuts (additional cuts on decay length and d0 norm)
 
       // conjugate-dependent topological selection for D0
-      bool topolD0 = selectionTopolConjugate(candidate, trackPos, trackNeg);
+      bool topolD0 = selectionTopolConjugate(candidate, trackPos, trackNeg, pTBin);
       // conjugate-dependent topological selection for D0bar
-      bool topolD0bar = selectionTopolConjugate(candidate, trackNeg, trackPos);
+      bool topolD0bar = selectionTopolConjugate(candidate, trackNeg, trackPos, pTBin);
 
       if (!topolD0 && !topolD0bar) {
         hfSelD0Candidate(statusD0, statusD0bar, statusHFFlag, statusTopol, statusCand, statusPID);
@@ -229,10 +283,10 @@ struct HfCandidateSelectorD0 {
       statusCand = 1;
 
       // track-level PID selection
-      int pidTrackPosKaon = selectorKaon.getStatusTrackPIDAll(trackPos);
-      int pidTrackPosPion = selectorPion.getStatusTrackPIDAll(trackPos);
-      int pidTrackNegKaon = selectorKaon.getStatusTrackPIDAll(trackNeg);
-      int pidTrackNegPion = selectorPion.getStatusTrackPIDAll(trackNeg);
+      int pidTrackPosKaon = statusPidKaon[candidate.prong0Id()];
+      int pidTrackPosPion = statusPidPion[candidate.prong0Id()];
+      int pidTrackNegKaon = statusPidKaon[candidate.prong1Id()];
+      int pidTrackNegPion = statusPidPion[candidate.prong1Id()];
 
       int pidD0 = -1;
       int pidD0bar = -1;
@@ -43,47 +43,84 @@ struct HfCandidateSelectorDsToKKPi {
   Configurable<std::vector<double>> binsPt{"binsPt", std::vector<double>{hf_cuts_ds_to_k_k_pi::vecBinsPt}, "pT bin limits"};
   Configurable<LabeledArray<double>> cuts{"cuts", {hf_cuts_ds_to_k_k_pi::cuts[0], nBinsPt, nCutVars, labelsPt, labelsCutVar}, "Ds candidate selection per pT bin"};
 
-  /// Candidate selections
+  double massPi = RecoDecay::getMassPDG(kPiPlus);
+  double massK = RecoDecay::getMassPDG(kKPlus);
+  double massDs = RecoDecay::getMassPDG(pdg::Code::kDS);
+
+  HfPtBinnedCuts cutTable; // compiled binsPt and cuts
+  // indices of the cut variables in cutTable
+  int iCutMass = -1;
+  int iCutPtPi = -1;
+  int iCutPtK = -1;
+  int iCutDecLen = -1;
+  int iCutDecLenXYNorm = -1;
+  int iCutCpa = -1;
+  int iCutCpaXY = -1;
+  int iCutMaxNormDeltaIP = -1;
+
+  void init(InitContext const&)
+  {
+    cutTable.build(binsPt.value, cuts.value);
+    iCutMass = cutTable.getIndex("m");
+    iCutPtPi = cutTable.getIndex("pT Pi");
+    iCutPtK = cutTable.getIndex("pT K");
+    iCutDecLen = cutTable.getIndex("decay length");
+    iCutDecLenXYNorm = cutTable.getIndex("normalized decay length XY");
+    iCutCpa = cutTable.getIndex("cos pointing angle");
+    iCutCpaXY = cutTable.getIndex("cos pointing angle XY");
+    iCutMaxNormDeltaIP = cutTable.getIndex("max normalized deltaIP");
+  }
+
+  /// Topological cuts common to the KKπ and πKK hypotheses
+  /// The invariant masses of both hypotheses are computed at once from the shared prong momenta.
   /// \param candidate is candidate
-  /// \param trackKaon1 is the first track with the kaon hypothesis
-  /// \param trackKaon2 is the second track with the kaon hypothesis
-  /// \param trackPion is the second track with the pion hypothesis
+  /// \param pTBin is the pT bin of the candidate
   /// \return true if candidate passes all cuts
-  template <typename T1, typename T2>
-  bool selection(const T1& candidate, const T2& trackKaon1, const T2& trackKaon2, const T2& trackPion)
+  template <typename T>
+  bool selectionTopol(const T& candidate, int pTBin)
   {
     auto candpT = candidate.pt();
-    int pTBin = findBin(binsPt, candpT);
-    if (pTBin == -1) {
-      return false;
-    }
     // check that the candidate pT is within the analysis range
     if (candpT < ptCandMin || candpT > ptCandMax) {
       return false;
     }
-    // cut on daughter pT
-    if (trackKaon1.pt() < cuts->get(pTBin, "pT K") || trackKaon2.pt() < cuts->get(pTBin, "pT K") || trackPion.pt() < cuts->get(pTBin, "pT Pi")) {
+    // decay length cut
+    if (candidate.decayLength() < cutTable.get(pTBin, iCutDecLen)) {
       return false;
     }
-    // invariant-mass cut
-    if (std::abs(invMassDsToKKPi(candidate) - RecoDecay::getMassPDG(pdg::Code::kDS)) > cuts->get(pTBin, "m") && (std::abs(invMassDsToPiKK(candidate) - RecoDecay::getMassPDG(pdg::Code::kDS)) > cuts->get(pTBin, "m"))) {
+    if (candidate.decayLengthXYNormalised() < cutTable.get(pTBin, iCutDecLenXYNorm)) {
       return false;
     }
-    // decay length cut
-    if (candidate.decayLength() < cuts->get(pTBin, "decay length")) {
+    // cos. pointing angle cut
+    if (candidate.cpa() < cutTable.get(pTBin, iCutCpa)) {
       return false;
     }
-    if (candidate.decayLengthXYNormalised() < cuts->get(pTBin, "normalized decay length XY")) {
+    if (candidate.cpaXY() < cutTable.get(pTBin, iCutCpaXY)) {
       return false;
     }
-    // cos. pointing angle cut
-    if (candidate.cpa() < cuts->get(pTBin, "cos pointing angle")) {
+    if (std::abs(candidate.maxNormalisedDeltaIP()) > cutTable.get(pTBin, iCutMaxNormDeltaIP)) {
       return false;
     }
-    if (candidate.cpaXY() < cuts->get(pTBin, "cos pointing angle XY")) {
+    // invariant-mass cut, passed if either hypothesis is in the window
+    auto massHypos = RecoDecay::m2Hypos(array{candidate.pVectorProng0(), candidate.pVectorProng1(), candidate.pVectorProng2()},
+                                        array{array{massK, massK, massPi}, array{massPi, massK, massK}});
+    if (std::abs(std::sqrt(massHypos[0]) - massDs) > cutTable.get(pTBin, iCutMass) && std::abs(std::sqrt(massHypos[1]) - massDs) > cutTable.get(pTBin, iCutMass)) {
       return false;
     }
-    if (std::abs(candidate.maxNormalisedDeltaIP()) > cuts->get(pTBin, "max normalized deltaIP")) {
+    return true;
+  }
+
+  /// Topological cuts specific to one of the KKπ and πKK hypotheses
+  /// \param pTBin is the pT bin of the candidate
+  /// \param trackKaon1 is the first track with the kaon hypothesis
+  /// \param trackKaon2 is the second track with the kaon hypothesis
+  /// \param trackPion is the track with the pion hypothesis
+  /// \return true if candidate passes all cuts for the given hypothesis
+  template <typename T>
+  bool selectionTopolConjugate(int pTBin, const T& trackKaon1, const T& trackKaon2, const T& trackPion)
+  {
+    // cut on daughter pT
+    if (trackKaon1.pt() < cutTable.get(pTBin, iCutPtK) || trackKaon2.pt() < cutTable.get(pTBin, iCutPtK) || trackPion.pt() < cutTable.get(pTBin, iCutPtPi)) {
       return false;
     }
     return true;
@@ -119,8 +156,10 @@ struct HfCandidateSelectorDsToKKPi {
       auto trackPos2 = candidate.prong2_as<aod::BigTracksPID>(); // positive daughter (negative for the antiparticles)
 
       // topological selection
-      bool topoDsToKKPi = selection(candidate, trackPos1, trackNeg, trackPos2);
-      bool topoDsToPiKK = selection(candidate, trackPos2, trackNeg, trackPos1);
+      int pTBin = cutTable.findBin(candidate.pt());
+      bool topoCommon = pTBin > -1 && selectionTopol(candidate, pTBin);
+      bool topoDsToKKPi = topoCommon && selectionTopolConjugate(pTBin, trackPos1, trackNeg, trackPos2);
+      bool topoDsToPiKK = topoCommon && selectionTopolConjugate(pTBin, trackPos2, trackNeg, trackPos1);
       if ((!topoDsToKKPi) && (!topoDsToPiKK)) {
         hfSelDsToKKPiCandidate(statusDsToKKPi, statusDsToPiKK);
         continue;
@@ -54,6 +54,28 @@ struct HfCandidateSelectorLc {
 
   using TrksPID = soa::Join<aod::BigTracksPID, aod::pidBayesPi, aod::pidBayesKa, aod::pidBayesPr, aod::pidBayes>;
 
+  HfPtBinnedCuts cutTable; // compiled binsPt and cuts
+  // indices of the cut variables in cutTable
+  int iCutMass = -1;
+  int iCutPtP = -1;
+  int iCutPtK = -1;
+  int iCutPtPi = -1;
+  int iCutChi2PCA = -1;
+  int iCutDecLen = -1;
+  int iCutCpa = -1;
+
+  void init(InitContext const&)
+  {
+    cutTable.build(binsPt.value, cuts.value);
+    iCutMass = cutTable.getIndex("m");
+    iCutPtP = cutTable.getIndex("pT p");
+    iCutPtK = cutTable.getIndex("pT K");
+    iCutPtPi = cutTable.getIndex("pT Pi");
+    iCutChi2PCA = cutTable.getIndex("Chi2PCA");
+    iCutDecLen = cutTable.getIndex("decay length");
+    iCutCpa = cutTable.getIndex("cos pointing angle");
+  }
+
   /*
   /// Selection on goodness of daughter tracks
   /// \note should be applied at candidate selection
@@ -77,7 +99,7 @@ struct HfCandidateSelectorLc {
   {
     auto candpT = candidate.pt();
 
-    int pTBin = findBin(binsPt, candpT);
+    int pTBin = cutTable.findBin(candpT);
     if (pTBin == -1) {
       return false;
     }
@@ -88,16 +110,16 @@ struct HfCandidateSelectorLc {
     }
 
     // cosine of pointing angle
-    if (candidate.cpa() <= cuts->get(pTBin, "cos pointing angle")) {
+    if (candidate.cpa() <= cutTable.get(pTBin, iCutCpa)) {
       return false;
     }
 
     // candidate chi2PCA
-    if (candidate.chi2PCA() > cuts->get(pTBin, "Chi2PCA")) {
+    if (candidate.chi2PCA() > cutTable.get(pTBin, iCutChi2PCA)) {
       return false;
     }
 
-    if (candidate.decayLength() <= cuts->get(pTBin, "decay length")) {
+    if (candidate.decayLength() <= cutTable.get(pTBin, iCutDecLen)) {
       return false;
     }
     return true;
@@ -114,22 +136,22 @@ struct HfCandidateSelectorLc {
   {
 
     auto candpT = candidate.pt();
-    int pTBin = findBin(binsPt, candpT);
+    int pTBin = cutTable.findBin(candpT);
     if (pTBin == -1) {
       return false;
     }
 
     // cut on daughter pT
-    if (trackProton.pt() < cuts->get(pTBin, "pT p") || trackKaon.pt() < cuts->get(pTBin, "pT K") || trackPion.pt() < cuts->get(pTBin, "pT Pi")) {
+    if (trackProton.pt() < cutTable.get(pTBin, iCutPtP) || trackKaon.pt() < cutTable.get(pTBin, iCutPtK) || trackPion.pt() < cutTable.get(pTBin, iCutPtPi)) {
       return false;
     }
 
     if (trackProton.globalIndex() == candidate.prong0Id()) {
-      if (std::abs(invMassLcToPKPi(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cuts->get(pTBin, "m")) {
+      if (std::abs(invMassLcToPKPi(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cutTable.get(pTBin, iCutMass)) {
         return false;
       }
     } else {
-      if (std::abs(invMassLcToPiKP(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cuts->get(pTBin, "m")) {
+      if (std::abs(invMassLcToPiKP(candidate) - RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus)) > cutTable.get(pTBin, iCutMass)) {
         return false;
       }
     }
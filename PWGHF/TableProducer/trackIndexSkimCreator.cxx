@@ -21,6 +21,9 @@
 #include "Framework/HistogramRegistry.h"
 #include "DetectorsVertexing/DCAFitterN.h"
 #include "PWGHF/DataModel/CandidateReconstructionTables.h"
+#include "Common/Core/DataframeTelemetry.h"
+#include "Common/Core/RegionTimers.h"
+#include "Common/Core/RowBuffer.h"
 #include "Common/Core/trackUtilities.h"
 #include "Common/DataModel/EventSelection.h"
 //#include "Common/DataModel/Centrality.h"
@@ -29,6 +32,8 @@
 #include "ReconstructionDataFormats/V0.h"
 #include "PWGHF/Utils/utilsDebugLcToK0sP.h"
 #include "DetectorsVertexing/PVertexer.h"      // for PV refit
+#include "Common/Core/PVContributors.h"        // for PV refit
+#include "Common/Core/PVRefitter.h"            // for PV refit
 #include "ReconstructionDataFormats/Vertex.h"  // for PV refit
 #include "CCDB/BasicCCDBManager.h"             // for PV refit
 #include "DataFormatsParameters/GRPObject.h"   // for PV refit
@@ -36,8 +41,13 @@
 #include "DetectorsBase/GeometryManager.h"     // for PV refit
 #include "DataFormatsParameters/GRPMagField.h" // for PV refit
 #include "PWGHF/Utils/utilsBfieldCCDB.h"
+#include "PWGHF/Utils/utilsSvFit.h"
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <span>
+#include <thread>
 
 using namespace o2;
 using namespace o2::framework;
@@ -259,6 +269,7 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
 
   Configurable<bool> isRun2{"isRun2", false, "enable Run 2 or Run 3 GRP objects for magnetic field"};
   Configurable<bool> doPvRefit{"doPvRefit", false, "do PV refit excluding the considered track"};
+  Configurable<bool> pvRefitDowndate{"pvRefitDowndate", false, "PV refit by removing the tracks from the linearised fit of the collision instead of rerunning the PVertexer"};
   Configurable<bool> fillHistograms{"fillHistograms", true, "fill histograms"};
   Configurable<bool> debug{"debug", true, "debug mode"};
   // Configurable<double> bz{"bz", 5., "bz field"};
@@ -341,6 +352,7 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
 
     // Needed for PV refitting
     if (doPvRefit) {
+      o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); /// remove diamond constraint (let's keep it at the moment...)
       AxisSpec axisCollisionX{100, -20.f, 20.f, "X (cm)"};
       AxisSpec axisCollisionY{100, -20.f, 20.f, "Y (cm)"};
       AxisSpec axisCollisionZ{100, -20.f, 20.f, "Z (cm)"};
@@ -369,7 +381,7 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
       ccdb->setURL(ccdbUrl);
       ccdb->setCaching(true);
       ccdb->setLocalObjectValidityChecking();
-      lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(ccdbPathLut));
+      lut = o2::common::CCDBObjectCache::instance().getMatLUT(ccdb, ccdbPathLut);
       if (!o2::base::GeometryManager::isGeometryLoaded()) {
         ccdb->get<TGeoManager>(ccdbPathGeo);
       }
@@ -398,75 +410,59 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     return true;
   }
 
+  /// Prepares the PV refits of a collision
+  /// \param collision is a collision
+  /// \param vecPvContributorGlobId is a vector containing the global ID of PV contributors for the collision
+  /// \param vecPvContributorTrackParCov is a vector containing the TrackParCov of PV contributors for the collision
+  /// \param pvRefitter receives the fit state of the collision
+  void preparePvRefit(aod::Collision const& collision,
+                      std::vector<int64_t> const& vecPvContributorGlobId,
+                      std::vector<o2::track::TrackParCov> const& vecPvContributorTrackParCov,
+                      o2::common::PVRefitter& pvRefitter)
+  {
+    // set the magnetic field from CCDB
+    auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
+    initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, lut, isRun2);
+
+    // build the VertexBase to initialize the vertexer
+    o2::dataformats::VertexBase primVtx;
+    primVtx.setX(collision.posX());
+    primVtx.setY(collision.posY());
+    primVtx.setZ(collision.posZ());
+    primVtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
+    pvRefitter.setUseDowndate(pvRefitDowndate);
+    bool pvRefitDoable = pvRefitter.prepare(primVtx, vecPvContributorGlobId, vecPvContributorTrackParCov);
+    if (debug) {
+      LOG(info) << "prepareVertexRefit = " << pvRefitDoable << " Ncontrib= " << vecPvContributorTrackParCov.size() << " Ntracks= " << collision.numContrib() << " Vtx= " << primVtx.asString();
+    }
+  }
+
   /// Method for the PV refit and DCA recalculation for tracks with a collision assigned
   /// \param collision is a collision
-  /// \param bcWithTimeStamps is a table of bunch crossing joined with timestamps used to query the CCDB for B and material budget
-  /// \param vecPvContributorGlobId is a vector containing the global ID of PV contributors for the current collision
-  /// \param vecPvContributorTrackParCov is a vector containing the TrackParCov of PV contributors for the current collision
+  /// \param pvRefitter holds the fit state of the collision, see preparePvRefit
   /// \param myTrack is the track to be removed, if contributor, from the PV refit
   /// \param pvCoord is an array containing the coordinates of the refitted PV
   /// \param pvCovMatrix is an array containing the covariance matrix values of the refitted PV
   /// \param dcaXYdcaZ is an array containing the dcaXY and dcaZ of myTrack with respect to the refitted PV
   void performPvRefitTrack(aod::Collision const& collision,
-                           aod::BCsWithTimestamps const& bcWithTimeStamps,
-                           std::vector<int64_t> vecPvContributorGlobId,
-                           std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov,
+                           o2::common::PVRefitter& pvRefitter,
                            BigTracks::iterator const& myTrack,
                            std::array<float, 3>& pvCoord,
                            std::array<float, 6>& pvCovMatrix,
                            std::array<float, 2>& dcaXYdcaZ)
   {
-    std::vector<bool> vecPvRefitContributorUsed(vecPvContributorGlobId.size(), true);
-
-    /// Prepare the vertex refitting
-    // set the magnetic field from CCDB
-    auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
-    initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, lut, isRun2);
-    /*if (runNumber != bc.runNumber()) {
-
-      if (isRun2) { // Run 2 GRP object
-        o2::parameters::GRPObject* grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(ccdbPathGrp, bc.timestamp());
-        if (grpo != nullptr) {
-          o2::base::Propagator::initFieldFromGRP(grpo);
-          o2::base::Propagator::Instance()->setMatLUT(lut);
-          LOGF(info, "Setting magnetic field to %d kG for run %d from its GRP CCDB object (type o2::parameters::GRPObject)", grpo->getNominalL3Field(), bc.runNumber());
-        } else {
-          LOGF(fatal, "Run 2 GRP object (type o2::parameters::GRPObject) is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
-        }
-      } else { // Run 3 GRP object
-        o2::parameters::GRPMagField* grpo = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(ccdbPathGrpMag, bc.timestamp());
-        if (grpo != nullptr) {
-          o2::base::Propagator::initFieldFromGRP(grpo);
-          o2::base::Propagator::Instance()->setMatLUT(lut);
-          LOG(info) << "Setting magnetic field to current" << grpo->getL3Current() << " A for run" << bc.runNumber() << " from its GRP CCDB object (type o2::parameters::GRPMagField)";
-        } else {
-          LOGF(fatal, "Run 3 GRP object (type o2::parameters::GRPMagField) is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
-        }
-      }
-
-      runNumber = bc.runNumber();
-    }*/
-
-    // build the VertexBase to initialize the vertexer
     o2::dataformats::VertexBase primVtx;
     primVtx.setX(collision.posX());
     primVtx.setY(collision.posY());
     primVtx.setZ(collision.posZ());
     primVtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
-    // configure PVertexer
-    o2::vertexing::PVertexer vertexer;
-    o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); /// remove diamond constraint (let's keep it at the moment...)
-    vertexer.init();
-    bool pvRefitDoable = vertexer.prepareVertexRefit(vecPvContributorTrackParCov, primVtx);
+    bool pvRefitDoable = pvRefitter.isPrepared();
     if (!pvRefitDoable) {
       LOG(info) << "Not enough tracks accepted for the refit";
       if (doPvRefit) {
         registry.fill(HIST("PvRefit/hNContribPvRefitNotDoable"), collision.numContrib());
       }
     }
-    if (debug) {
-      LOG(info) << "prepareVertexRefit = " << pvRefitDoable << " Ncontrib= " << vecPvContributorTrackParCov.size() << " Ntracks= " << collision.numContrib() << " Vtx= " << primVtx.asString();
-    }
 
     registry.fill(HIST("PvRefit/hVerticesPerTrack"), 1);
     if (pvRefitDoable) {
@@ -477,15 +473,10 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     bool recalcImpPar = false;
     if (doPvRefit && pvRefitDoable) {
       recalcImpPar = true;
-      auto trackIterator = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), myTrack.globalIndex()); /// track global index
-      if (trackIterator != vecPvContributorGlobId.end()) {
+      if (pvRefitter.entry(myTrack.globalIndex()) >= 0) {
 
         /// this track contributed to the PV fit: let's do the refit without it
-        const int entry = std::distance(vecPvContributorGlobId.begin(), trackIterator);
-
-        vecPvRefitContributorUsed[entry] = false; /// remove the track from the PV refitting
-
-        auto primVtxRefitted = vertexer.refitVertex(vecPvRefitContributorUsed, primVtx); // vertex refit
+        auto primVtxRefitted = pvRefitter.refitWithout(std::array<int64_t, 1>{myTrack.globalIndex()}); // vertex refit
         // LOG(info) << "refit " << cnt << "/" << ntr << " result = " << primVtxRefitted.asString();
         if (debug) {
           LOG(info) << "refit for track with global index " << (int)myTrack.globalIndex() << " " << primVtxRefitted.asString();
@@ -504,8 +495,6 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
         }
         registry.fill(HIST("PvRefit/hChi2vsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getChi2());
 
-        vecPvRefitContributorUsed[entry] = true; /// restore the track for the next PV refitting (probably not necessary here)
-
         if (recalcImpPar) {
           // fill the histograms for refitted PV with good Chi2
           const double deltaX = primVtx.getX() - primVtxRefitted.getX();
@@ -573,8 +562,8 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
     return;
   } /// end of performPvRefitTrack function
 
-  /// Partition for PV contributors
-  Partition<MY_TYPE1> pvContributors = ((aod::track::flags & (uint32_t)aod::track::PVContributor) == (uint32_t)aod::track::PVContributor);
+  /// PV contributors of all the collisions, collected once per dataframe
+  o2::common::PVContributors pvContributors;
 
   void process(aod::Collisions const& collisions,
                MY_TYPE1 const& tracks,
@@ -591,6 +580,12 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
       LOG(info) << ">>> number of collisions: " << collisions.size();
     }
 
+    if (doPvRefit) {
+      pvContributors.build(tracks, collisions.size());
+    }
+
+    o2::common::PVRefitter pvRefitter;
+    int pvRefitCollisionId = -1;
     for (auto& track : tracks) {
 
 #ifdef MY_DEBUG
@@ -612,25 +607,32 @@ struct HfTrackIndexSkimCreatorTagSelTracks {
       if (doPvRefit) {
         if (track.has_collision()) {
 
-          /// retrieve PV contributors for the current collision
-          std::vector<int64_t> vecPvContributorGlobId = {};
-          std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov = {};
+          /// the fit state is prepared once for the tracks of a collision, which are contiguous
+          if (track.collisionId() != pvRefitCollisionId) {
+            pvRefitCollisionId = track.collisionId();
 
-          /// contributors for the current collision
-          auto pvContrCollision = pvContributors->sliceByCached(aod::track::collisionId, track.collision().globalIndex());
-          for (auto contributor : pvContrCollision) {
-            vecPvContributorGlobId.push_back(contributor.globalIndex());
-            vecPvContributorTrackParCov.push_back(getTrackParCov(contributor));
-          }
-          if (debug) {
-            LOG(info) << "### vecPvContributorGlobId.size()=" << vecPvContributorGlobId.size() << ", vecPvContributorTrackParCov.size()=" << vecPvContributorTrackParCov.size() << ", N. original contributors=" << track.collision().numContrib();
+            /// retrieve PV contributors for the current collision
+            std::vector<int64_t> vecPvContributorGlobId = {};
+            std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov = {};
+
+            /// contributors for the current collision
+            auto pvContrCollision = pvContributors.of(track.collisionId());
+            vecPvContributorGlobId.assign(pvContrCollision.begin(), pvContrCollision.end());
+            vecPvContributorTrackParCov.reserve(pvContrCollision.size());
+            for (auto contributorId : pvContrCollision) {
+              vecPvContributorTrackParCov.push_back(getTrackParCov(tracks.rawIteratorAt(contributorId)));
+            }
+            if (debug) {
+              LOG(info) << "### vecPvContributorGlobId.size()=" << vecPvContributorGlobId.size() << ", vecPvContributorTrackParCov.size()=" << vecPvContributorTrackParCov.size() << ", N. original contributors=" << track.collision().numContrib();
+            }
+            preparePvRefit(track.collision(), vecPvContributorGlobId, vecPvContributorTrackParCov, pvRefitter);
           }
 
           /// Perform the PV refit only for tracks with an assigned collision
           if (debug) {
             LOG(info) << "[BEFORE performPvRefitTrack] track.collision().globalIndex(): " << track.collision().globalIndex();
           }
-          performPvRefitTrack(track.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, (BigTracks::iterator const&)track, pvRefitPvCoord, pvRefitPvCovMatrix, pvRefitDcaXYDcaZ);
+          performPvRefitTrack(track.collision(), pvRefitter, (BigTracks::iterator const&)track, pvRefitPvCoord, pvRefitPvCovMatrix, pvRefitDcaXYDcaZ);
         }
       }
       /// fill table with PV refit info
@@ -841,15 +843,27 @@ struct HfTrackIndexSkimCreator {
   Produces<aod::Hf3Prongs> rowTrackIndexProng3;
   Produces<aod::HfCutStatus3Prong> rowProng3CutStatus;
   Produces<aod::HfPvRefit3Prong> rowProng3PVrefit;
+  Produces<aod::HfSvFit2Prong> rowProng2SvFit;
+  Produces<aod::HfSvFit3Prong> rowProng3SvFit;
 
   Configurable<bool> isRun2{"isRun2", false, "enable Run 2 or Run 3 GRP objects for magnetic field"};
   Configurable<int> do3Prong{"do3Prong", 0, "do 3 prong"};
   Configurable<bool> doPvRefit{"doPvRefit", false, "do PV refit excluding the considered track"};
+  Configurable<bool> pvRefitDowndate{"pvRefitDowndate", false, "PV refit by removing the tracks from the linearised fit of the collision instead of rerunning the PVertexer"};
   Configurable<bool> debug{"debug", false, "debug mode"};
   Configurable<bool> fillHistograms{"fillHistograms", true, "fill histograms"};
+  Configurable<bool> fillSvFit{"fillSvFit", false, "store the secondary-vertex fits of the candidates, to be reused by the candidate creators"};
+  Configurable<bool> fillTimers{"fillTimers", false, "fill the histograms of the time spent in the steps of the process functions"};
+  Configurable<bool> fillTelemetry{"fillTelemetry", false, "fill the histograms of the input rows, output rows and time of the process calls"};
   // Configurable<int> nCollsMax{"nCollsMax", -1, "Max collisions per file"}; //can be added to run over limited collisions per file - for tesing purposes
   // preselection
   Configurable<double> ptTolerance{"ptTolerance", 0.1, "pT tolerance in GeV/c for applying preselections before vertex reconstruction"};
+  // pair search
+  Configurable<bool> doCellPairSearch{"doCellPairSearch", false, "combine only tracks in (eta, phi) cells neighbouring the cell of the first positive daughter"};
+  Configurable<double> cellSizeEta{"cellSizeEta", 0.8, "eta size of the cells of the pair search"};
+  Configurable<double> cellSizePhi{"cellSizePhi", 1.0, "minimum phi size of the cells of the pair search"};
+  // parallel processing
+  Configurable<int> nThreads{"nThreads", 4, "Number of threads building the candidates of the collisions of a dataframe in processParallel (output order is preserved)"};
   // vertexing
   // Configurable<double> bz{"bz", 5., "magnetic field kG"};
   Configurable<bool> propagateToPCA{"propagateToPCA", true, "create tracks version propagated to PCA"};
@@ -906,6 +920,144 @@ struct HfTrackIndexSkimCreator {
   std::array<std::vector<double>, n2ProngDecays> pTBins2Prong;
   std::array<LabeledArray<double>, n3ProngDecays> cut3Prong;
   std::array<std::vector<double>, n3ProngDecays> pTBins3Prong;
+  double minPt3Prong; // lowest pT edge of all the 3-prong decays
+
+  int nCellsPhi{0}; // number of phi cells of the pair search
+
+  /// Track lists of the pair search, filled per collision with the positions of the tracks in the collision slice
+  struct PairSearchTracks {
+    std::vector<double> ptProngs;                 // pT of the prong momenta
+    std::vector<int> cellProngs;                  // (eta, phi) cell
+    std::vector<int> pos;                         // positive tracks selected for 2- or 3-prongs
+    std::vector<int> neg;                         // negative tracks selected for 2- or 3-prongs
+    std::vector<int> pos3Prong;                   // positive tracks selected for 3-prongs
+    std::vector<int> neg3Prong;                   // negative tracks selected for 3-prongs
+    std::vector<std::vector<int>> cellsNeg;       // neg per cell
+    std::vector<std::vector<int>> cellsPos3Prong; // pos3Prong per cell
+    std::vector<std::vector<int>> cellsNeg3Prong; // neg3Prong per cell
+    std::vector<int> neighboursNeg;               // tracks of cellsNeg neighbouring the first positive daughter
+    std::vector<int> neighboursPos3Prong;         // tracks of cellsPos3Prong neighbouring the first positive daughter
+    std::vector<int> neighboursNeg3Prong;         // tracks of cellsNeg3Prong neighbouring the first positive daughter
+    int nCellsEta{0};
+  };
+  PairSearchTracks pairSearchTracks; // used by processSerial
+
+  /// Output of the candidate building written directly into the tables
+  struct TableOutput {
+    static constexpr bool fillsHistograms = true;
+    HfTrackIndexSkimCreator& task;
+    int nCand2 = 0;
+    int nCand3 = 0;
+
+    template <typename... T>
+    void prong2(T... values)
+    {
+      task.rowTrackIndexProng2(values...);
+      ++nCand2;
+    }
+    template <typename... T>
+    void prong2PvRefit(T... values)
+    {
+      task.rowProng2PVrefit(values...);
+    }
+    template <typename... T>
+    void prong2CutStatus(T... values)
+    {
+      task.rowProng2CutStatus(values...);
+    }
+    void prong2SvFit(o2::hf_sv_fit::SvFit<2> const& fit)
+    {
+      task.rowProng2SvFit(fit.position[0], fit.position[1], fit.position[2], fit.chi2PCA, fit.cov.data(), fit.parProngs.data(), fit.covProngs.data());
+    }
+    template <typename... T>
+    void prong3(T... values)
+    {
+      task.rowTrackIndexProng3(values...);
+      ++nCand3;
+    }
+    template <typename... T>
+    void prong3PvRefit(T... values)
+    {
+      task.rowProng3PVrefit(values...);
+    }
+    template <typename... T>
+    void prong3CutStatus(T... values)
+    {
+      task.rowProng3CutStatus(values...);
+    }
+    void prong3SvFit(o2::hf_sv_fit::SvFit<3> const& fit)
+    {
+      task.rowProng3SvFit(fit.position[0], fit.position[1], fit.position[2], fit.chi2PCA, fit.cov.data(), fit.parProngs.data(), fit.covProngs.data());
+    }
+  };
+
+  /// Output of the candidate building of one collision, buffered by a worker thread of processParallel
+  /// Histograms are not filled, since the registry is not thread-safe.
+  struct BufferOutput {
+    static constexpr bool fillsHistograms = false;
+    using RowBufferPvRefit = o2::common::RowBuffer<float, float, float, float, float, float, float, float, float>;
+    o2::common::RowBuffer<int64_t, int64_t, int> prongs2{};
+    RowBufferPvRefit pvRefits2{};
+    std::vector<std::array<int, n2ProngDecays>> cutStatus2{};
+    std::vector<o2::hf_sv_fit::SvFit<2>> svFits2{};
+    o2::common::RowBuffer<int64_t, int64_t, int64_t, int> prongs3{};
+    RowBufferPvRefit pvRefits3{};
+    std::vector<std::array<int, n3ProngDecays>> cutStatus3{};
+    std::vector<o2::hf_sv_fit::SvFit<3>> svFits3{};
+
+    void prong2(int64_t index0, int64_t index1, int isSelected)
+    {
+      prongs2(index0, index1, isSelected);
+    }
+    template <typename... T>
+    void prong2PvRefit(T... values)
+    {
+      pvRefits2(static_cast<float>(values)...);
+    }
+    template <typename... T>
+    void prong2CutStatus(T... values)
+    {
+      cutStatus2.push_back({values...});
+    }
+    void prong2SvFit(o2::hf_sv_fit::SvFit<2> const& fit)
+    {
+      svFits2.push_back(fit);
+    }
+    void prong3(int64_t index0, int64_t index1, int64_t index2, int isSelected)
+    {
+      prongs3(index0, index1, index2, isSelected);
+    }
+    template <typename... T>
+    void prong3PvRefit(T... values)
+    {
+      pvRefits3(static_cast<float>(values)...);
+    }
+    template <typename... T>
+    void prong3CutStatus(T... values)
+    {
+      cutStatus3.push_back({values...});
+    }
+    void prong3SvFit(o2::hf_sv_fit::SvFit<3> const& fit)
+    {
+      svFits3.push_back(fit);
+    }
+
+    void clear()
+    {
+      prongs2.clear();
+      pvRefits2.clear();
+      cutStatus2.clear();
+      svFits2.clear();
+      prongs3.clear();
+      pvRefits3.clear();
+      cutStatus3.clear();
+      svFits3.clear();
+    }
+  };
+  std::vector<BufferOutput> bufferOutputs;         // per collision of the dataframe, used by processParallel
+  std::vector<PairSearchTracks> pairSearchWorkers; // per worker thread, used by processParallel
+
+  Preslice<aod::Tracks> tracksPerCollision = aod::track::collisionId;
 
   using SelectedCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::HfSelCollision>>;
   using SelectedTracks = soa::Filtered<soa::Join<aod::BigTracks, aod::TracksDCA, aod::HfSelTrack, aod::HfPvRefitTrack>>;
@@ -974,9 +1126,27 @@ struct HfTrackIndexSkimCreator {
     // cuts for 3-prong decays retrieved by json. the order must be then one in hf_cand_3prong::DecayType
     cut3Prong = {cutsDplusToPiKPi, cutsLcToPKPi, cutsDsToKKPi, cutsXicToPKPi};
     pTBins3Prong = {binsPtDplusToPiKPi, binsPtLcToPKPi, binsPtDsToKKPi, binsPtXicToPKPi};
+    minPt3Prong = pTBins3Prong[0].front();
+    for (const auto& bins : pTBins3Prong) {
+      minPt3Prong = std::min(minPt3Prong, bins.front());
+    }
+    nCellsPhi = std::max(3, static_cast<int>(o2::constants::math::TwoPI / cellSizePhi));
+
+    if (doprocessSerial && doprocessParallel) {
+      LOGF(fatal, "Cannot enable processSerial and processParallel at the same time. Please choose one.");
+    }
+    if (doprocessParallel) {
+      if (doPvRefit) {
+        LOGF(fatal, "PV refit is not supported in processParallel");
+      }
+      if (fillHistograms) {
+        LOGF(warning, "Only the candidate-count histograms are filled in processParallel");
+      }
+    }
 
     // needed for PV refitting
     if (doPvRefit) {
+      o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); /// remove diamond constraint (let's keep it at the moment...)
       AxisSpec axisCollisionX{100, -20.f, 20.f, "X (cm)"};
       AxisSpec axisCollisionY{100, -20.f, 20.f, "Y (cm)"};
       AxisSpec axisCollisionZ{100, -20.f, 20.f, "Z (cm)"};
@@ -1007,12 +1177,117 @@ struct HfTrackIndexSkimCreator {
       ccdb->setURL(ccdbUrl);
       ccdb->setCaching(true);
       ccdb->setLocalObjectValidityChecking();
-      lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(ccdbPathLut));
+      lut = o2::common::CCDBObjectCache::instance().getMatLUT(ccdb, ccdbPathLut);
       if (!o2::base::GeometryManager::isGeometryLoaded()) {
         ccdb->get<TGeoManager>(ccdbPathGeo);
       }
       runNumber = 0;
     }
+    timers.init(registry, {"CCDB", "slicing", "candidates", "output"}, fillTimers);
+    telemetry.init(registry, {"processSerial", "processParallel"}, {"tracks", "collisions"}, {"2-prong candidates", "3-prong candidates"}, fillTelemetry);
+  }
+
+  /// Method to fill the track lists of the pair search of a collision
+  /// \param tracks are the selected tracks of the collision
+  /// \param ps is the pair-search state to fill
+  template <typename T>
+  void fillPairSearchTracks(T const& tracks, PairSearchTracks& ps)
+  {
+    const int nTracks = tracks.size();
+    ps.ptProngs.resize(nTracks);
+    ps.cellProngs.resize(nTracks);
+    ps.pos.clear();
+    ps.neg.clear();
+    ps.pos3Prong.clear();
+    ps.neg3Prong.clear();
+
+    int iEtaMin = 0;
+    int iEtaMax = 0;
+    int iTrack = 0;
+    for (const auto& track : tracks) {
+      ps.ptProngs[iTrack] = RecoDecay::pt(track.pxProng(), track.pyProng());
+      ps.cellProngs[iTrack] = static_cast<int>(std::floor(track.eta() / cellSizeEta));
+      iEtaMin = iTrack == 0 ? ps.cellProngs[iTrack] : std::min(iEtaMin, ps.cellProngs[iTrack]);
+      iEtaMax = iTrack == 0 ? ps.cellProngs[iTrack] : std::max(iEtaMax, ps.cellProngs[iTrack]);
+      bool sel2Prong = TESTBIT(track.isSelProng(), CandidateType::Cand2Prong);
+      bool sel3Prong = TESTBIT(track.isSelProng(), CandidateType::Cand3Prong);
+      // same sign convention as the combinatorics loops: tracks with signed1Pt == 0 are both positive and negative
+      if (sel2Prong || sel3Prong) {
+        if (track.signed1Pt() >= 0) {
+          ps.pos.push_back(iTrack);
+        }
+        if (track.signed1Pt() <= 0) {
+          ps.neg.push_back(iTrack);
+        }
+      }
+      if (sel3Prong) {
+        if (track.signed1Pt() >= 0) {
+          ps.pos3Prong.push_back(iTrack);
+        }
+        if (track.signed1Pt() <= 0) {
+          ps.neg3Prong.push_back(iTrack);
+        }
+      }
+      ++iTrack;
+    }
+    if (!doCellPairSearch) {
+      return;
+    }
+
+    // group the tracks in (eta, phi) cells
+    ps.nCellsEta = iEtaMax - iEtaMin + 1;
+    iTrack = 0;
+    for (const auto& track : tracks) {
+      int iPhi = static_cast<int>(track.phi() / o2::constants::math::TwoPI * nCellsPhi);
+      iPhi = std::clamp(iPhi, 0, nCellsPhi - 1);
+      ps.cellProngs[iTrack] = (ps.cellProngs[iTrack] - iEtaMin) * nCellsPhi + iPhi;
+      ++iTrack;
+    }
+    auto fillCells = [&](std::vector<int> const& list, std::vector<std::vector<int>>& cells) {
+      cells.resize(ps.nCellsEta * nCellsPhi);
+      for (auto& cell : cells) {
+        cell.clear();
+      }
+      for (const auto iTrackList : list) {
+        cells[ps.cellProngs[iTrackList]].push_back(iTrackList);
+      }
+    };
+    fillCells(ps.neg, ps.cellsNeg);
+    fillCells(ps.pos3Prong, ps.cellsPos3Prong);
+    fillCells(ps.neg3Prong, ps.cellsNeg3Prong);
+  }
+
+  /// Method to get the tracks that can be combined with the first positive daughter
+  /// \param iPos1 is the position of the first positive daughter
+  /// \param list is the list of all the tracks of the collision, in table order
+  /// \param cells is the same list grouped in (eta, phi) cells
+  /// \param neighbours is the buffer for the tracks of the neighbouring cells
+  /// \return the list of all the tracks, or the tracks of the cells neighbouring the cell of the first daughter sorted by decreasing pT if the cell pair search is enabled
+  /// \param ps is the pair-search state of the collision
+  std::vector<int> const& getPairSearchCandidates(int iPos1, std::vector<int> const& list, std::vector<std::vector<int>> const& cells, std::vector<int>& neighbours, PairSearchTracks const& ps)
+  {
+    if (!doCellPairSearch) {
+      return list;
+    }
+    neighbours.clear();
+    const int iEta = ps.cellProngs[iPos1] / nCellsPhi;
+    const int iPhi = ps.cellProngs[iPos1] % nCellsPhi;
+    for (int iEtaNeighbour = std::max(0, iEta - 1); iEtaNeighbour <= std::min(ps.nCellsEta - 1, iEta + 1); ++iEtaNeighbour) {
+      for (int deltaPhi = -1; deltaPhi <= 1; ++deltaPhi) {
+        const auto& cell = cells[iEtaNeighbour * nCellsPhi + (iPhi + deltaPhi + nCellsPhi) % nCellsPhi];
+        neighbours.insert(neighbours.end(), cell.begin(), cell.end());
+      }
+    }
+    std::sort(neighbours.begin(), neighbours.end(), [&](int i, int j) { return ps.ptProngs[i] > ps.ptProngs[j]; });
+    return neighbours;
+  }
+
+  /// Method to check whether a 3-prong combination is below the pT range of all the 3-prong decays
+  /// The pT of the candidate cannot exceed the sum of the pT of its prongs, so the combination would fail the preselection of every decay.
+  /// Never true in debug mode, where the rejected combinations are reconstructed too.
+  bool isBelowPt3Prong(int iProng0, int iProng1, int iProng2, PairSearchTracks const& ps)
+  {
+    return !debug && ps.ptProngs[iProng0] + ps.ptProngs[iProng1] + ps.ptProngs[iProng2] + ptTolerance < minPt3Prong;
   }
 
   /// Method to perform selections for 2-prong candidates before vertex reconstruction
@@ -1039,7 +1314,7 @@ struct HfTrackIndexSkimCreator {
       }
       return true;
     };
-    cacheIndices(cut2Prong, massMinIndex, massMaxIndex, d0d0Index);
+    [[maybe_unused]] static const bool isCached = cacheIndices(cut2Prong, massMinIndex, massMaxIndex, d0d0Index); // thread-safe one-time initialisation
 
     auto arrMom = array{
       array{hfTrack0.pxProng(), hfTrack0.pyProng(), hfTrack0.pzProng()},
@@ -1061,14 +1336,12 @@ struct HfTrackIndexSkimCreator {
       }
 
       // invariant mass
-      double massHypos[2];
       whichHypo[iDecay2P] = 3;
       double min2 = pow(cut2Prong[iDecay2P].get(pTBin, massMinIndex[iDecay2P]), 2);
       double max2 = pow(cut2Prong[iDecay2P].get(pTBin, massMaxIndex[iDecay2P]), 2);
 
       if ((debug || TESTBIT(isSelected, iDecay2P)) && cut2Prong[iDecay2P].get(pTBin, massMinIndex[iDecay2P]) >= 0. && cut2Prong[iDecay2P].get(pTBin, massMaxIndex[iDecay2P]) > 0.) {
-        massHypos[0] = RecoDecay::m2(arrMom, arrMass2Prong[iDecay2P][0]);
-        massHypos[1] = RecoDecay::m2(arrMom, arrMass2Prong[iDecay2P][1]);
+        auto massHypos = RecoDecay::m2Hypos(arrMom, arrMass2Prong[iDecay2P]);
         if (massHypos[0] < min2 || massHypos[0] >= max2) {
           whichHypo[iDecay2P] -= 1;
         }
@@ -1121,7 +1394,7 @@ struct HfTrackIndexSkimCreator {
       }
       return true;
     };
-    cacheIndices(cut3Prong, massMinIndex, massMaxIndex);
+    [[maybe_unused]] static const bool isCached = cacheIndices(cut3Prong, massMinIndex, massMaxIndex); // thread-safe one-time initialisation
 
     auto arrMom = array{
       array{hfTrack0.pxProng(), hfTrack0.pyProng(), hfTrack0.pzProng()},
@@ -1144,14 +1417,12 @@ struct HfTrackIndexSkimCreator {
       }
 
       // invariant mass
-      double massHypos[2];
       whichHypo[iDecay3P] = 3;
       double min2 = pow(cut3Prong[iDecay3P].get(pTBin, massMinIndex[iDecay3P]), 2);
       double max2 = pow(cut3Prong[iDecay3P].get(pTBin, massMaxIndex[iDecay3P]), 2);
 
       if ((debug || TESTBIT(isSelected, iDecay3P)) && cut3Prong[iDecay3P].get(pTBin, massMinIndex[iDecay3P]) >= 0. && cut3Prong[iDecay3P].get(pTBin, massMaxIndex[iDecay3P]) > 0.) { // no need to check isSelected but to avoid mistakes
-        massHypos[0] = RecoDecay::m2(arrMom, arrMass3Prong[iDecay3P][0]);
-        massHypos[1] = RecoDecay::m2(arrMom, arrMass3Prong[iDecay3P][1]);
+        auto massHypos = RecoDecay::m2Hypos(arrMom, arrMass3Prong[iDecay3P]);
         if (massHypos[0] < min2 || massHypos[0] >= max2) {
           whichHypo[iDecay3P] -= 1;
         }
@@ -1188,7 +1459,7 @@ struct HfTrackIndexSkimCreator {
         }
         return true;
       };
-      cacheIndices(cut2Prong, cospIndex);
+      [[maybe_unused]] static const bool isCached = cacheIndices(cut2Prong, cospIndex); // thread-safe one-time initialisation
 
       for (int iDecay2P = 0; iDecay2P < n2ProngDecays; iDecay2P++) {
 
@@ -1239,7 +1510,7 @@ struct HfTrackIndexSkimCreator {
         }
         return true;
       };
-      cacheIndices(cut3Prong, cospIndex, decLenIndex);
+      [[maybe_unused]] static const bool isCached = cacheIndices(cut3Prong, cospIndex, decLenIndex); // thread-safe one-time initialisation
 
       for (int iDecay3P = 0; iDecay3P < n3ProngDecays; iDecay3P++) {
 
@@ -1280,71 +1551,28 @@ struct HfTrackIndexSkimCreator {
 
   /// Method for the PV refit excluding the candidate daughters
   /// \param collision is a collision
-  /// \param bcWithTimeStamps is a table of bunch crossing joined with timestamps used to query the CCDB for B and material budget
-  /// \param vecPvContributorGlobId is a vector containing the global ID of PV contributors for the current collision
-  /// \param vecPvContributorTrackParCov is a vector containing the TrackParCov of PV contributors for the current collision
+  /// \param pvRefitter holds the fit state of the collision, prepared in buildCandidates
   /// \param vecCandPvContributorGlobId is a vector containing the global indices of daughter tracks that contributed to the original PV refit
   /// \param pvCoord is a vector where to store X, Y and Z values of refitted PV
   /// \param pvCovMatrix is a vector where to store the covariance matrix values of refitted PV
   void performPvRefitCandProngs(aod::Collision const& collision,
-                                aod::BCsWithTimestamps const& bcWithTimeStamps,
-                                std::vector<int64_t> vecPvContributorGlobId,
-                                std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov,
+                                o2::common::PVRefitter& pvRefitter,
                                 std::vector<int64_t> vecCandPvContributorGlobId,
                                 std::array<float, 3>& pvCoord,
                                 std::array<float, 6>& pvCovMatrix)
   {
-    std::vector<bool> vecPvRefitContributorUsed(vecPvContributorGlobId.size(), true);
-
-    /// Prepare the vertex refitting
-    // set the magnetic field from CCDB
-    auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
-    initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, lut, isRun2);
-    /*if (runNumber != bc.runNumber()) {
-
-      if (isRun2) { // Run 2 GRP object
-        o2::parameters::GRPObject* grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(ccdbPathGrp, bc.timestamp());
-        if (grpo != nullptr) {
-          o2::base::Propagator::initFieldFromGRP(grpo);
-          o2::base::Propagator::Instance()->setMatLUT(lut);
-          LOGF(info, "Setting magnetic field to %d kG for run %d from its GRP CCDB object (type o2::parameters::GRPObject)", grpo->getNominalL3Field(), bc.runNumber());
-        } else {
-          LOGF(fatal, "Run 2 GRP object (type o2::parameters::GRPObject) is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
-        }
-      } else { // Run 3 GRP object
-        o2::parameters::GRPMagField* grpo = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(ccdbPathGrpMag, bc.timestamp());
-        if (grpo != nullptr) {
-          o2::base::Propagator::initFieldFromGRP(grpo);
-          o2::base::Propagator::Instance()->setMatLUT(lut);
-          LOG(info) << "Setting magnetic field to current" << grpo->getL3Current() << " A for run" << bc.runNumber() << " from its GRP CCDB object (type o2::parameters::GRPMagField)";
-        } else {
-          LOGF(fatal, "Run 3 GRP object (type o2::parameters::GRPMagField) is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
-        }
-      }
-
-      runNumber = bc.runNumber();
-    }*/
-
-    // build the VertexBase to initialize the vertexer
     o2::dataformats::VertexBase primVtx;
     primVtx.setX(collision.posX());
     primVtx.setY(collision.posY());
     primVtx.setZ(collision.posZ());
     primVtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(), collision.covXZ(), collision.covYZ(), collision.covZZ());
-    // configure PVertexer
-    o2::vertexing::PVertexer vertexer;
-    o2::conf::ConfigurableParam::updateFromString("pvertexer.useMeanVertexConstraint=false"); /// remove diamond constraint (let's keep it at the moment...)
-    vertexer.init();
-    bool pvRefitDoable = vertexer.prepareVertexRefit(vecPvContributorTrackParCov, primVtx);
+    bool pvRefitDoable = pvRefitter.isPrepared();
     if (!pvRefitDoable) {
       LOG(info) << "Not enough tracks accepted for the refit";
       if (doPvRefit) {
         registry.fill(HIST("PvRefit/hNContribPvRefitNotDoable"), collision.numContrib());
       }
     }
-    if (debug) {
-      LOG(info) << "prepareVertexRefit = " << pvRefitDoable << " Ncontrib= " << vecPvContributorTrackParCov.size() << " Ntracks= " << collision.numContrib() << " Vtx= " << primVtx.asString();
-    }
 
     // registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
     if (pvRefitDoable) {
@@ -1357,11 +1585,8 @@ struct HfTrackIndexSkimCreator {
       recalcPvRefit = true;
       int nCandContr = 0;
       for (uint64_t myGlobalID : vecCandPvContributorGlobId) {
-        auto trackIterator = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), myGlobalID); /// track global index
-        if (trackIterator != vecPvContributorGlobId.end()) {
-          /// this is a contributor, let's remove it for the PV refit
-          const int entry = std::distance(vecPvContributorGlobId.begin(), trackIterator);
-          vecPvRefitContributorUsed[entry] = false; /// remove the track from the PV refitting
+        if (pvRefitter.entry(myGlobalID) >= 0) {
+          /// this is a contributor, it is removed for the PV refit
           nCandContr++;
         }
       }
@@ -1370,7 +1595,7 @@ struct HfTrackIndexSkimCreator {
       if (debug) {
         LOG(info) << "### PV refit after removing " << nCandContr << " tracks";
       }
-      auto primVtxRefitted = vertexer.refitVertex(vecPvRefitContributorUsed, primVtx); // vertex refit
+      auto primVtxRefitted = pvRefitter.refitWithout(vecCandPvContributorGlobId); // vertex refit
       // LOG(info) << "refit " << cnt << "/" << ntr << " result = " << primVtxRefitted.asString();
       // LOG(info) << "refit for track with global index " << (int) myTrack.globalIndex() << " " << primVtxRefitted.asString();
       if (primVtxRefitted.getChi2() < 0) {
@@ -1388,10 +1613,6 @@ struct HfTrackIndexSkimCreator {
       }
       registry.fill(HIST("PvRefit/hChi2vsNContrib"), primVtxRefitted.getNContributors(), primVtxRefitted.getChi2());
 
-      for (int i = 0; i < (int)vecPvContributorGlobId.size(); i++) {
-        vecPvRefitContributorUsed[i] = true; /// restore the tracks for the next PV refitting (probably not necessary here)
-      }
-
       if (recalcPvRefit) {
         // fill the histograms for refitted PV with good Chi2
         const double deltaX = primVtx.getX() - primVtxRefitted.getX();
@@ -1433,12 +1654,14 @@ struct HfTrackIndexSkimCreator {
     return;
   } /// end of performPvRefitCandProngs function
 
-  void process( // soa::Join<aod::Collisions, aod::CentV0Ms>::iterator const& collision, //FIXME add centrality when option for variations to the process function appears
-    SelectedCollisions::iterator const& collision,
-    aod::Collisions const&,
-    aod::BCsWithTimestamps const& bcWithTimeStamps,
-    SelectedTracks const& tracks,
-    BigTracks const& tracksUnfiltered)
+  /// Method to build the 2- and 3-prong candidates of a collision
+  /// \param collision is the collision
+  /// \param tracks are the selected tracks of the collision
+  /// \param tracksUnfiltered are all the tracks of the collision, used for the PV refit
+  /// \param ps is the pair-search state
+  /// \param output receives the table rows, written directly into the tables or buffered per collision
+  template <typename TCollision, typename TTracks, typename TTracksUnfiltered, typename TOutput>
+  void buildCandidates(TCollision const& collision, TTracks const& tracks, TTracksUnfiltered const& tracksUnfiltered, PairSearchTracks& ps, TOutput& output)
   {
 
     // can be added to run over limited collisions per file - for tesing purposes
@@ -1481,7 +1704,16 @@ struct HfTrackIndexSkimCreator {
         }
       }
     }
-    std::vector<bool> vecPvRefitContributorUsed(vecPvContributorGlobId.size(), true);
+    /// the fit state of the collision is prepared once for the refits of all its candidates
+    o2::common::PVRefitter pvRefitter;
+    /// the magnetic field of the run is set by the caller, before the collisions are dispatched to the workers
+    if (doPvRefit) {
+      pvRefitter.setUseDowndate(pvRefitDowndate);
+      bool pvRefitDoable = pvRefitter.prepare(getPrimaryVertex(collision), vecPvContributorGlobId, vecPvContributorTrackParCov);
+      if (debug) {
+        LOG(info) << "prepareVertexRefit = " << pvRefitDoable << " Ncontrib= " << vecPvContributorTrackParCov.size() << " Ntracks= " << collision.numContrib();
+      }
+    }
 
     // auto centrality = collision.centV0M(); //FIXME add centrality when option for variations to the process function appears
 
@@ -1496,10 +1728,6 @@ struct HfTrackIndexSkimCreator {
     int whichHypo2Prong[n2ProngDecays];
     int whichHypo3Prong[n3ProngDecays];
 
-    // set the magnetic field from CCDB
-    auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
-    initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, lut, isRun2);
-
     // 2-prong vertex fitter
     o2::vertexing::DCAFitterN<2> df2;
     df2.setBz(o2::base::Propagator::Instance()->getNominalBz());
@@ -1520,21 +1748,17 @@ struct HfTrackIndexSkimCreator {
     df3.setMinRelChi2Change(minRelChi2Change);
     df3.setUseAbsDCA(useAbsDCA);
 
-    // used to calculate number of candidiates per event
-    auto nCand2 = rowTrackIndexProng2.lastIndex();
-    auto nCand3 = rowTrackIndexProng3.lastIndex();
-
     // if there isn't at least a positive and a negative track, continue immediately
     // if (tracksPos.size() < 1 || tracksNeg.size() < 1) {
     //  return;
     //}
 
+    fillPairSearchTracks(tracks, ps);
+
     // first loop over positive tracks
     // for (auto trackPos1 = tracksPos.begin(); trackPos1 != tracksPos.end(); ++trackPos1) {
-    for (auto trackPos1 = tracks.begin(); trackPos1 != tracks.end(); ++trackPos1) {
-      if (trackPos1.signed1Pt() < 0) {
-        continue;
-      }
+    for (const auto iPos1 : ps.pos) {
+      auto trackPos1 = tracks.begin() + iPos1;
       bool sel2ProngStatusPos = TESTBIT(trackPos1.isSelProng(), CandidateType::Cand2Prong);
       bool sel3ProngStatusPos1 = TESTBIT(trackPos1.isSelProng(), CandidateType::Cand3Prong);
       if (!sel2ProngStatusPos && !sel3ProngStatusPos1) {
@@ -1543,12 +1767,15 @@ struct HfTrackIndexSkimCreator {
 
       auto trackParVarPos1 = getTrackParCov(trackPos1);
 
+      // tracks that can be combined with the first positive daughter
+      const auto& negCandidates = getPairSearchCandidates(iPos1, ps.neg, ps.cellsNeg, ps.neighboursNeg, ps);
+      const auto& pos3ProngCandidates = getPairSearchCandidates(iPos1, ps.pos3Prong, ps.cellsPos3Prong, ps.neighboursPos3Prong, ps);
+      const auto& neg3ProngCandidates = getPairSearchCandidates(iPos1, ps.neg3Prong, ps.cellsNeg3Prong, ps.neighboursNeg3Prong, ps);
+
       // first loop over negative tracks
       // for (auto trackNeg1 = tracksNeg.begin(); trackNeg1 != tracksNeg.end(); ++trackNeg1) {
-      for (auto trackNeg1 = tracks.begin(); trackNeg1 != tracks.end(); ++trackNeg1) {
-        if (trackNeg1.signed1Pt() > 0) {
-          continue;
-        }
+      for (const auto iNeg1 : negCandidates) {
+        auto trackNeg1 = tracks.begin() + iNeg1;
         bool sel2ProngStatusNeg = TESTBIT(trackNeg1.isSelProng(), CandidateType::Cand2Prong);
         bool sel3ProngStatusNeg1 = TESTBIT(trackNeg1.isSelProng(), CandidateType::Cand3Prong);
         if (!sel2ProngStatusNeg && !sel3ProngStatusNeg1) {
@@ -1590,11 +1817,11 @@ struct HfTrackIndexSkimCreator {
             if (doPvRefit) {
               registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
               int nCandContr = 2;
-              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
+              auto trackFirstIt = pvRefitter.entry(trackPos1.globalIndex());
+              auto trackSecondIt = pvRefitter.entry(trackNeg1.globalIndex());
               bool isTrackFirstContr = true;
               bool isTrackSecondContr = true;
-              if (trackFirstIt == vecPvContributorGlobId.end()) {
+              if (trackFirstIt < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [2 Prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
@@ -1602,7 +1829,7 @@ struct HfTrackIndexSkimCreator {
                 nCandContr--;
                 isTrackFirstContr = false;
               }
-              if (trackSecondIt == vecPvContributorGlobId.end()) {
+              if (trackSecondIt < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [2 Prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
@@ -1615,7 +1842,7 @@ struct HfTrackIndexSkimCreator {
                 if (debug) {
                   LOG(info) << "### [2 Prong] Calling performPvRefitCandProngs for HF 2 prong candidate";
                 }
-                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, {trackPos1.globalIndex(), trackNeg1.globalIndex()}, pvRefitCoord2Prong, pvRefitCovMatrix2Prong);
+                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), pvRefitter, {trackPos1.globalIndex(), trackNeg1.globalIndex()}, pvRefitCoord2Prong, pvRefitCovMatrix2Prong);
               } else if (nCandContr == 1) {
                 /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
                 if (debug) {
@@ -1652,11 +1879,15 @@ struct HfTrackIndexSkimCreator {
 
             if (isSelected2ProngCand > 0) {
               // fill table row
-              rowTrackIndexProng2(trackPos1.globalIndex(),
-                                  trackNeg1.globalIndex(), isSelected2ProngCand);
+              output.prong2(trackPos1.globalIndex(),
+                            trackNeg1.globalIndex(), isSelected2ProngCand);
               // fill table row with coordinates of PV refit
-              rowProng2PVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
-                               pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
+              output.prong2PvRefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
+                                   pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
+              // fill table row with the secondary-vertex fit
+              if (fillSvFit) {
+                output.prong2SvFit(o2::hf_sv_fit::fromFitter<2>(df2));
+              }
 
               if (debug) {
                 int Prong2CutStatus[n2ProngDecays];
@@ -1668,11 +1899,11 @@ struct HfTrackIndexSkimCreator {
                     }
                   }
                 }
-                rowProng2CutStatus(Prong2CutStatus[0], Prong2CutStatus[1], Prong2CutStatus[2]); // FIXME when we can do this by looping over n2ProngDecays
+                output.prong2CutStatus(Prong2CutStatus[0], Prong2CutStatus[1], Prong2CutStatus[2]); // FIXME when we can do this by looping over n2ProngDecays
               }
 
               // fill histograms
-              if (fillHistograms) {
+              if (TOutput::fillsHistograms && fillHistograms) {
                 registry.fill(HIST("hVtx2ProngX"), secondaryVertex2[0]);
                 registry.fill(HIST("hVtx2ProngY"), secondaryVertex2[1]);
                 registry.fill(HIST("hVtx2ProngZ"), secondaryVertex2[2]);
@@ -1717,13 +1948,17 @@ struct HfTrackIndexSkimCreator {
           }
           // second loop over positive tracks
           // for (auto trackPos2 = trackPos1 + 1; trackPos2 != tracksPos.end(); ++trackPos2) {
-          for (auto trackPos2 = trackPos1 + 1; trackPos2 != tracks.end(); ++trackPos2) {
-            if (trackPos2.signed1Pt() < 0) {
+          for (const auto iPos2 : pos3ProngCandidates) {
+            if (iPos2 <= iPos1) {
               continue;
             }
-            if (!TESTBIT(trackPos2.isSelProng(), CandidateType::Cand3Prong)) {
+            if (isBelowPt3Prong(iPos1, iNeg1, iPos2, ps)) {
+              if (doCellPairSearch) {
+                break; // candidates sorted by decreasing pT
+              }
               continue;
             }
+            auto trackPos2 = tracks.begin() + iPos2;
 
             int isSelected3ProngCand = n3ProngBit;
 
@@ -1762,13 +1997,13 @@ struct HfTrackIndexSkimCreator {
             if (doPvRefit) {
               registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
               int nCandContr = 3;
-              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-              auto it_third_trk = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos2.globalIndex());
+              auto trackFirstIt = pvRefitter.entry(trackPos1.globalIndex());
+              auto trackSecondIt = pvRefitter.entry(trackNeg1.globalIndex());
+              auto it_third_trk = pvRefitter.entry(trackPos2.globalIndex());
               bool isTrackFirstContr = true;
               bool isTrackSecondContr = true;
               bool isTrackThirdContr = true;
-              if (trackFirstIt == vecPvContributorGlobId.end()) {
+              if (trackFirstIt < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
@@ -1776,7 +2011,7 @@ struct HfTrackIndexSkimCreator {
                 nCandContr--;
                 isTrackFirstContr = false;
               }
-              if (trackSecondIt == vecPvContributorGlobId.end()) {
+              if (trackSecondIt < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
@@ -1784,7 +2019,7 @@ struct HfTrackIndexSkimCreator {
                 nCandContr--;
                 isTrackSecondContr = false;
               }
-              if (it_third_trk == vecPvContributorGlobId.end()) {
+              if (it_third_trk < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [3 prong] trackPos2 with globalIndex " << trackPos2.globalIndex() << " was not a PV contributor";
@@ -1810,7 +2045,7 @@ struct HfTrackIndexSkimCreator {
                 if (debug) {
                   LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
                 }
-                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong2Pos1Neg, pvRefitCovMatrix3Prong2Pos1Neg);
+                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), pvRefitter, vecCandPvContributorGlobId, pvRefitCoord3Prong2Pos1Neg, pvRefitCovMatrix3Prong2Pos1Neg);
               } else if (nCandContr == 1) {
                 /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
                 if (debug) {
@@ -1853,12 +2088,16 @@ struct HfTrackIndexSkimCreator {
             }
 
             // fill table row
-            rowTrackIndexProng3(trackPos1.globalIndex(),
-                                trackNeg1.globalIndex(),
-                                trackPos2.globalIndex(), isSelected3ProngCand);
+            output.prong3(trackPos1.globalIndex(),
+                          trackNeg1.globalIndex(),
+                          trackPos2.globalIndex(), isSelected3ProngCand);
             // fill table row of coordinates of PV refit
-            rowProng3PVrefit(pvRefitCoord3Prong2Pos1Neg[0], pvRefitCoord3Prong2Pos1Neg[1], pvRefitCoord3Prong2Pos1Neg[2],
-                             pvRefitCovMatrix3Prong2Pos1Neg[0], pvRefitCovMatrix3Prong2Pos1Neg[1], pvRefitCovMatrix3Prong2Pos1Neg[2], pvRefitCovMatrix3Prong2Pos1Neg[3], pvRefitCovMatrix3Prong2Pos1Neg[4], pvRefitCovMatrix3Prong2Pos1Neg[5]);
+            output.prong3PvRefit(pvRefitCoord3Prong2Pos1Neg[0], pvRefitCoord3Prong2Pos1Neg[1], pvRefitCoord3Prong2Pos1Neg[2],
+                                 pvRefitCovMatrix3Prong2Pos1Neg[0], pvRefitCovMatrix3Prong2Pos1Neg[1], pvRefitCovMatrix3Prong2Pos1Neg[2], pvRefitCovMatrix3Prong2Pos1Neg[3], pvRefitCovMatrix3Prong2Pos1Neg[4], pvRefitCovMatrix3Prong2Pos1Neg[5]);
+            // fill table row with the secondary-vertex fit
+            if (fillSvFit) {
+              output.prong3SvFit(o2::hf_sv_fit::fromFitter<3>(df3));
+            }
 
             if (debug) {
               int Prong3CutStatus[n3ProngDecays];
@@ -1870,11 +2109,11 @@ struct HfTrackIndexSkimCreator {
                   }
                 }
               }
-              rowProng3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
+              output.prong3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
             }
 
             // fill histograms
-            if (fillHistograms) {
+            if (TOutput::fillsHistograms && fillHistograms) {
               registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
               registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
               registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
@@ -1919,13 +2158,17 @@ struct HfTrackIndexSkimCreator {
 
           // second loop over negative tracks
           // for (auto trackNeg2 = trackNeg1 + 1; trackNeg2 != tracksNeg.end(); ++trackNeg2) {
-          for (auto trackNeg2 = trackNeg1 + 1; trackNeg2 != tracks.end(); ++trackNeg2) {
-            if (trackNeg2.signed1Pt() > 0) {
+          for (const auto iNeg2 : neg3ProngCandidates) {
+            if (iNeg2 <= iNeg1) {
               continue;
             }
-            if (!TESTBIT(trackNeg2.isSelProng(), CandidateType::Cand3Prong)) {
+            if (isBelowPt3Prong(iNeg1, iPos1, iNeg2, ps)) {
+              if (doCellPairSearch) {
+                break; // candidates sorted by decreasing pT
+              }
               continue;
             }
+            auto trackNeg2 = tracks.begin() + iNeg2;
 
             int isSelected3ProngCand = n3ProngBit;
 
@@ -1965,13 +2208,13 @@ struct HfTrackIndexSkimCreator {
             if (doPvRefit) {
               registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
               int nCandContr = 3;
-              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-              auto it_third_trk = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg2.globalIndex());
+              auto trackFirstIt = pvRefitter.entry(trackPos1.globalIndex());
+              auto trackSecondIt = pvRefitter.entry(trackNeg1.globalIndex());
+              auto it_third_trk = pvRefitter.entry(trackNeg2.globalIndex());
               bool isTrackFirstContr = true;
               bool isTrackSecondContr = true;
               bool isTrackThirdContr = true;
-              if (trackFirstIt == vecPvContributorGlobId.end()) {
+              if (trackFirstIt < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
@@ -1979,7 +2222,7 @@ struct HfTrackIndexSkimCreator {
                 nCandContr--;
                 isTrackFirstContr = false;
               }
-              if (trackSecondIt == vecPvContributorGlobId.end()) {
+              if (trackSecondIt < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
@@ -1987,7 +2230,7 @@ struct HfTrackIndexSkimCreator {
                 nCandContr--;
                 isTrackSecondContr = false;
               }
-              if (it_third_trk == vecPvContributorGlobId.end()) {
+              if (it_third_trk < 0) {
                 /// This track did not contribute to the original PV refit
                 if (debug) {
                   LOG(info) << "--- [3 prong] trackNeg2 with globalIndex " << trackNeg2.globalIndex() << " was not a PV contributor";
@@ -2013,7 +2256,7 @@ struct HfTrackIndexSkimCreator {
                 if (debug) {
                   LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
                 }
-                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong1Pos2Neg, pvRefitCovMatrix3Prong1Pos2Neg);
+                performPvRefitCandProngs((aod::Collision const&)trackPos1.collision(), pvRefitter, vecCandPvContributorGlobId, pvRefitCoord3Prong1Pos2Neg, pvRefitCovMatrix3Prong1Pos2Neg);
               } else if (nCandContr == 1) {
                 /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
                 if (debug) {
@@ -2056,12 +2299,16 @@ struct HfTrackIndexSkimCreator {
             }
 
             // fill table row
-            rowTrackIndexProng3(trackNeg1.globalIndex(),
-                                trackPos1.globalIndex(),
-                                trackNeg2.globalIndex(), isSelected3ProngCand);
+            output.prong3(trackNeg1.globalIndex(),
+                          trackPos1.globalIndex(),
+                          trackNeg2.globalIndex(), isSelected3ProngCand);
             // fill table row of coordinates of PV refit
-            rowProng3PVrefit(pvRefitCoord3Prong1Pos2Neg[0], pvRefitCoord3Prong1Pos2Neg[1], pvRefitCoord3Prong1Pos2Neg[2],
-                             pvRefitCovMatrix3Prong1Pos2Neg[0], pvRefitCovMatrix3Prong1Pos2Neg[1], pvRefitCovMatrix3Prong1Pos2Neg[2], pvRefitCovMatrix3Prong1Pos2Neg[3], pvRefitCovMatrix3Prong1Pos2Neg[4], pvRefitCovMatrix3Prong1Pos2Neg[5]);
+            output.prong3PvRefit(pvRefitCoord3Prong1Pos2Neg[0], pvRefitCoord3Prong1Pos2Neg[1], pvRefitCoord3Prong1Pos2Neg[2],
+                                 pvRefitCovMatrix3Prong1Pos2Neg[0], pvRefitCovMatrix3Prong1Pos2Neg[1], pvRefitCovMatrix3Prong1Pos2Neg[2], pvRefitCovMatrix3Prong1Pos2Neg[3], pvRefitCovMatrix3Prong1Pos2Neg[4], pvRefitCovMatrix3Prong1Pos2Neg[5]);
+            // fill table row with the secondary-vertex fit
+            if (fillSvFit) {
+              output.prong3SvFit(o2::hf_sv_fit::fromFitter<3>(df3));
+            }
 
             if (debug) {
               int Prong3CutStatus[n3ProngDecays];
@@ -2073,11 +2320,11 @@ struct HfTrackIndexSkimCreator {
                   }
                 }
               }
-              rowProng3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
+              output.prong3CutStatus(Prong3CutStatus[0], Prong3CutStatus[1], Prong3CutStatus[2], Prong3CutStatus[3]); // FIXME when we can do this by looping over n3ProngDecays
             }
 
             // fill histograms
-            if (fillHistograms) {
+            if (TOutput::fillsHistograms && fillHistograms) {
               registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
               registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
               registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
@@ -2123,16 +2370,193 @@ struct HfTrackIndexSkimCreator {
       }
     }
 
-    auto nTracks = tracks.size();                      // number of tracks passing 2 and 3 prong selection in this collision
-    nCand2 = rowTrackIndexProng2.lastIndex() - nCand2; // number of 2-prong candidates in this collision
-    nCand3 = rowTrackIndexProng3.lastIndex() - nCand3; // number of 3-prong candidates in this collision
+  }
 
+  /// Method to fill the histograms of the number of candidates of a collision
+  /// \param nTracks is the number of tracks passing 2 and 3 prong selection in this collision
+  /// \param nCand2 is the number of 2-prong candidates in this collision
+  /// \param nCand3 is the number of 3-prong candidates in this collision
+  void fillCandidateCounts(int nTracks, int nCand2, int nCand3)
+  {
     registry.fill(HIST("hNTracks"), nTracks);
     registry.fill(HIST("hNCand2Prong"), nCand2);
     registry.fill(HIST("hNCand3Prong"), nCand3);
     registry.fill(HIST("hNCand2ProngVsNTracks"), nTracks, nCand2);
     registry.fill(HIST("hNCand3ProngVsNTracks"), nTracks, nCand3);
   }
+
+  /// Steps of the process functions timed when fillTimers is enabled
+  enum TimerRegion {
+    kTimerCCDB = 0,
+    kTimerSlicing,
+    kTimerCandidates,
+    kTimerOutput
+  };
+  o2::common::RegionTimers timers;
+
+  /// Process functions, inputs and outputs of the telemetry filled when fillTelemetry is enabled
+  enum TelemetryProcess {
+    kProcessSerial = 0,
+    kProcessParallel
+  };
+  enum TelemetryInput {
+    kInputTracks = 0,
+    kInputCollisions
+  };
+  enum TelemetryOutput {
+    kOutput2Prong = 0,
+    kOutput3Prong
+  };
+  o2::common::DataframeTelemetry telemetry;
+
+  void processSerial( // soa::Join<aod::Collisions, aod::CentV0Ms>::iterator const& collision, //FIXME add centrality when option for variations to the process function appears
+    SelectedCollisions::iterator const& collision,
+    aod::Collisions const&,
+    aod::BCsWithTimestamps const& bcWithTimeStamps,
+    SelectedTracks const& tracks,
+    BigTracks const& tracksUnfiltered)
+  {
+    O2_DF_TELEMETRY(telemetry, kProcessSerial);
+    telemetry.setInputRows(kInputTracks, tracks.size());
+    telemetry.setInputRows(kInputCollisions, 1);
+    {
+      O2_REGION_TIMER(timers, kTimerCCDB);
+      // set the magnetic field from CCDB
+      auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
+      initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, lut, isRun2);
+    }
+
+    TableOutput output{*this};
+    {
+      O2_REGION_TIMER(timers, kTimerCandidates);
+      buildCandidates(collision, tracks, tracksUnfiltered, pairSearchTracks, output);
+    }
+    fillCandidateCounts(tracks.size(), output.nCand2, output.nCand3);
+    telemetry.addOutputRows(kOutput2Prong, output.nCand2);
+    telemetry.addOutputRows(kOutput3Prong, output.nCand3);
+    timers.flush();
+  }
+
+  PROCESS_SWITCH(HfTrackIndexSkimCreator, processSerial, "Build the candidates one collision at a time", true);
+
+  /// Builds the candidates of the collisions of a dataframe on several threads
+  /// Each thread has its own vertex fitters and pair-search state, and writes into an output buffer per collision.
+  /// The buffers are written into the tables in collision order, so the output is the same as in processSerial.
+  void processParallel(SelectedCollisions const& collisions,
+                       aod::Collisions const&,
+                       aod::BCsWithTimestamps const& bcWithTimeStamps,
+                       SelectedTracks const& tracks,
+                       BigTracks const& tracksUnfiltered)
+  {
+    O2_DF_TELEMETRY(telemetry, kProcessParallel);
+    const o2::common::RegionTimers::FlushGuard flushTimers{timers};
+    const int nCollisions = collisions.size();
+    telemetry.setInputRows(kInputTracks, tracks.size());
+    telemetry.setInputRows(kInputCollisions, nCollisions);
+    if (nCollisions == 0) {
+      return;
+    }
+    if (static_cast<int>(bufferOutputs.size()) < nCollisions) {
+      bufferOutputs.resize(nCollisions);
+    }
+    const int nWorkers = std::min(std::max(1, nThreads.value), nCollisions);
+    if (static_cast<int>(pairSearchWorkers.size()) < nWorkers) {
+      pairSearchWorkers.resize(nWorkers);
+    }
+
+    // slices are made upfront, since the slicing cache is not thread-safe
+    using TracksSlice = decltype(tracks.sliceBy(tracksPerCollision, 0));
+    using TracksUnfilteredSlice = decltype(tracksUnfiltered.sliceBy(tracksPerCollision, 0));
+    std::vector<TracksSlice> tracksSlices;
+    std::vector<TracksUnfilteredSlice> tracksUnfilteredSlices;
+    tracksSlices.reserve(nCollisions);
+    tracksUnfilteredSlices.reserve(nCollisions);
+    {
+      O2_REGION_TIMER(timers, kTimerSlicing);
+      for (const auto& collision : collisions) {
+        tracksSlices.push_back(tracks.sliceBy(tracksPerCollision, collision.globalIndex()));
+        tracksUnfilteredSlices.push_back(tracksUnfiltered.sliceBy(tracksPerCollision, collision.globalIndex()));
+      }
+    }
+
+    // consecutive collisions of the same run are processed together, after setting the magnetic field of the run
+    int nRows2 = 0;
+    int nRows3 = 0;
+    int first = 0;
+    while (first < nCollisions) {
+      auto bc = (collisions.begin() + first).bc_as<o2::aod::BCsWithTimestamps>();
+      {
+        O2_REGION_TIMER(timers, kTimerCCDB);
+        initCCDB(bc, runNumber, ccdb, isRun2 ? ccdbPathGrp : ccdbPathGrpMag, lut, isRun2);
+      }
+      int last = first + 1;
+      while (last < nCollisions && (collisions.begin() + last).bc_as<o2::aod::BCsWithTimestamps>().runNumber() == bc.runNumber()) {
+        ++last;
+      }
+      // the threads are timed together, the timers are not thread safe
+      O2_REGION_TIMER(timers, kTimerCandidates);
+
+      // workers pull collisions from a shared counter, so that faster threads pick up the remaining work
+      std::atomic<int> nextCollision{first};
+      auto worker = [&](PairSearchTracks& ps) {
+        for (int iCollision = nextCollision++; iCollision < last; iCollision = nextCollision++) {
+          auto& output = bufferOutputs[iCollision];
+          output.clear();
+          buildCandidates((collisions.begin() + iCollision), tracksSlices[iCollision], tracksUnfilteredSlices[iCollision], ps, output);
+        }
+      };
+      std::vector<std::thread> workers;
+      workers.reserve(nWorkers - 1);
+      for (int iWorker = 1; iWorker < nWorkers; ++iWorker) {
+        workers.emplace_back(worker, std::ref(pairSearchWorkers[iWorker]));
+      }
+      worker(pairSearchWorkers[0]);
+      for (auto& thread : workers) {
+        thread.join();
+      }
+      for (int iCollision = first; iCollision < last; ++iCollision) {
+        nRows2 += bufferOutputs[iCollision].prongs2.size();
+        nRows3 += bufferOutputs[iCollision].prongs3.size();
+      }
+      first = last;
+    }
+    telemetry.addOutputRows(kOutput2Prong, nRows2);
+    telemetry.addOutputRows(kOutput3Prong, nRows3);
+
+    // merge the buffers in collision order
+    O2_REGION_TIMER(timers, kTimerOutput);
+    const std::span<const BufferOutput> outputs{bufferOutputs.data(), static_cast<std::size_t>(nCollisions)};
+    o2::common::commitInOrder(rowTrackIndexProng2, outputs, [](const BufferOutput& output) -> auto& { return output.prongs2; });
+    o2::common::commitInOrder(rowProng2PVrefit, outputs, [](const BufferOutput& output) -> auto& { return output.pvRefits2; });
+    o2::common::commitInOrder(rowTrackIndexProng3, outputs, [](const BufferOutput& output) -> auto& { return output.prongs3; });
+    o2::common::commitInOrder(rowProng3PVrefit, outputs, [](const BufferOutput& output) -> auto& { return output.pvRefits3; });
+    if (debug) {
+      rowProng2CutStatus.reserve(nRows2);
+      rowProng3CutStatus.reserve(nRows3);
+    }
+    if (fillSvFit) {
+      rowProng2SvFit.reserve(nRows2);
+      rowProng3SvFit.reserve(nRows3);
+    }
+    for (int iCollision = 0; iCollision < nCollisions; ++iCollision) {
+      const auto& output = outputs[iCollision];
+      for (const auto& status : output.cutStatus2) {
+        rowProng2CutStatus(status[0], status[1], status[2]); // FIXME when we can do this by looping over n2ProngDecays
+      }
+      for (const auto& fit : output.svFits2) {
+        rowProng2SvFit(fit.position[0], fit.position[1], fit.position[2], fit.chi2PCA, fit.cov.data(), fit.parProngs.data(), fit.covProngs.data());
+      }
+      for (const auto& status : output.cutStatus3) {
+        rowProng3CutStatus(status[0], status[1], status[2], status[3]); // FIXME when we can do this by looping over n3ProngDecays
+      }
+      for (const auto& fit : output.svFits3) {
+        rowProng3SvFit(fit.position[0], fit.position[1], fit.position[2], fit.chi2PCA, fit.cov.data(), fit.parProngs.data(), fit.covProngs.data());
+      }
+      fillCandidateCounts(tracksSlices[iCollision].size(), output.prongs2.size(), output.prongs3.size());
+    }
+  }
+
+  PROCESS_SWITCH(HfTrackIndexSkimCreator, processParallel, "Build the candidates of the collisions of a dataframe on several threads", false);
 };
 
 //________________________________________________________________________________________________________________________
@@ -2205,6 +2629,21 @@ struct HfTrackIndexSkimCreatorCascades {
   double massLc = RecoDecay::getMassPDG(pdg::Code::kLambdaCPlus);
   double mass2K0sP{0.}; // WHY HERE?
 
+  /// V0 passing the selections, with the quantities reused for all the bachelors
+  struct PreselectedV0 {
+    int index;                 // position in the V0 table of the collision
+    int64_t globalIndex;       // global index of the V0
+    std::array<float, 3> pVec; // momentum from V0Datas
+    double p;                  // momentum magnitude
+    double energy;             // energy with the K0s mass
+    o2::dataformats::V0 track; // neutral track built from the daughters
+#ifdef MY_DEBUG
+    int indexDaughPos;
+    int indexDaughNeg;
+#endif
+  };
+  std::vector<PreselectedV0> preselectedV0s; // V0s of the collision passing the selections
+
   using SelectedCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::HfSelCollision>>;
 
   Filter filterSelectCollisions = (aod::hf_sel_collision::whyRejectColl == 0);
@@ -2223,7 +2662,7 @@ struct HfTrackIndexSkimCreatorCascades {
     ccdb->setURL(ccdbUrl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
-    lut = o2::base::MatLayerCylSet::rectifyPtrFromFile(ccdb->get<o2::base::MatLayerCylSet>(ccdbPathLut));
+    lut = o2::common::CCDBObjectCache::instance().getMatLUT(ccdb, ccdbPathLut);
     if (!o2::base::GeometryManager::isGeometryLoaded()) {
       ccdb->get<TGeoManager>(ccdbPathGeo);
     }
@@ -2257,7 +2696,95 @@ struct HfTrackIndexSkimCreatorCascades {
     // fitter.setMaxChi2(1e9);  // used in cascadeproducer.cxx, but not for the 2 prongs
     fitter.setUseAbsDCA(useAbsDCA);
 
-    // fist we loop over the bachelor candidate
+    // the V0 and bachelor selections do not depend on each other, they are evaluated once per collision
+    // and the combinations are then restricted to the V0s compatible with the Lc mass window
+
+    // first we select the V0s
+    preselectedV0s.clear();
+    for (const auto& v0 : V0s) {
+      MY_DEBUG_MSG(1, LOG(info) << "*** Checking next K0S");
+      // selections on the V0 daughters
+      const auto& trackV0DaughPos = v0.posTrack_as<MyTracks>();
+      const auto& trackV0DaughNeg = v0.negTrack_as<MyTracks>();
+#ifdef MY_DEBUG
+      auto indexV0DaughPos = trackV0DaughPos.mcParticleId();
+      auto indexV0DaughNeg = trackV0DaughNeg.mcParticleId();
+      bool isK0SfromLc = isK0SfromLcFunc(indexV0DaughPos, indexV0DaughNeg, indexK0Spos, indexK0Sneg);
+#endif
+      MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S from Lc found, trackV0DaughPos --> " << indexV0DaughPos << ", trackV0DaughNeg --> " << indexV0DaughNeg);
+
+      if (tpcRefitV0Daugh) {
+        if (!(trackV0DaughPos.trackType() & o2::aod::track::TPCrefit) ||
+            !(trackV0DaughNeg.trackType() & o2::aod::track::TPCrefit)) {
+          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to TPCrefit");
+          continue;
+        }
+      }
+      if (trackV0DaughPos.tpcNClsCrossedRows() < nCrossedRowsMinV0Daugh ||
+          trackV0DaughNeg.tpcNClsCrossedRows() < nCrossedRowsMinV0Daugh) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minCrossedRows");
+        continue;
+      }
+      //
+      // if (trackV0DaughPos.dcaXY() < dcaXYPosToPvMin ||   // to the filters?
+      //     trackV0DaughNeg.dcaXY() < dcaXYNegToPvMin) {
+      //   continue;
+      // }
+      //
+      if (trackV0DaughPos.pt() < ptMinV0Daugh || // to the filters? I can't for now, it is not in the tables
+          trackV0DaughNeg.pt() < ptMinV0Daugh) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minPt --> pos " << trackV0DaughPos.pt() << ", neg " << trackV0DaughNeg.pt() << " (cut " << ptMinV0Daugh << ")");
+        continue;
+      }
+      if (std::abs(trackV0DaughPos.eta()) > etaMaxV0Daugh || // to the filters? I can't for now, it is not in the tables
+          std::abs(trackV0DaughNeg.eta()) > etaMaxV0Daugh) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to eta --> pos " << trackV0DaughPos.eta() << ", neg " << trackV0DaughNeg.eta() << " (cut " << etaMaxV0Daugh << ")");
+        continue;
+      }
+
+      // V0 invariant mass selection
+      if (std::abs(v0.mK0Short() - massK0s) > cutInvMassV0) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to invMass --> " << v0.mK0Short() - massK0s << " (cut " << cutInvMassV0 << ")");
+        continue; // should go to the filter, but since it is a dynamic column, I cannot use it there
+      }
+
+      // V0 cosPointingAngle selection
+      if (v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) < cpaV0Min) {
+        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to cosPA --> " << v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) << " (cut " << cpaV0Min << ")");
+        continue;
+      }
+
+      MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "KEPT! K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg);
+
+      PreselectedV0 preselectedV0;
+      preselectedV0.index = preselectedV0s.size();
+      preselectedV0.globalIndex = v0.globalIndex();
+      preselectedV0.pVec = {v0.px(), v0.py(), v0.pz()};
+      preselectedV0.p = RecoDecay::p(preselectedV0.pVec);
+      preselectedV0.energy = RecoDecay::e(preselectedV0.p, massK0s);
+      // we build the neutral track to then build the cascade, once for all the bachelors
+      auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos);
+      trackParCovV0DaughPos.propagateTo(v0.posX(), o2::base::Propagator::Instance()->getNominalBz()); // propagate the track to the X closest to the V0 vertex
+      auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg);
+      trackParCovV0DaughNeg.propagateTo(v0.negX(), o2::base::Propagator::Instance()->getNominalBz()); // propagate the track to the X closest to the V0 vertex
+      const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
+      preselectedV0.track = o2::dataformats::V0(vertexV0, preselectedV0.pVec, {0, 0, 0, 0, 0, 0}, trackParCovV0DaughPos, trackParCovV0DaughNeg, {0, 0}, {0, 0}); // build the V0 track
+#ifdef MY_DEBUG
+      preselectedV0.indexDaughPos = indexV0DaughPos;
+      preselectedV0.indexDaughNeg = indexV0DaughNeg;
+#endif
+      preselectedV0s.push_back(preselectedV0);
+    }
+    if (preselectedV0s.empty()) {
+      return;
+    }
+    // the V0s are sorted by momentum, so that the V0s compatible with the Lc mass window for a given bachelor are contiguous
+    std::sort(preselectedV0s.begin(), preselectedV0s.end(), [](const PreselectedV0& a, const PreselectedV0& b) { return a.p < b.p; });
+
+    const double mass2Max = (massLc + cutInvMassCascLc) * (massLc + cutInvMassCascLc);
+    std::vector<int> compatibleV0s;
+
+    // then we loop over the bachelor candidates
 
     // for (const auto& bach : selectedTracks) {
     for (const auto& bach : tracks) {
@@ -2286,22 +2813,47 @@ struct HfTrackIndexSkimCreatorCascades {
       }
       MY_DEBUG_MSG(isProtonFromLc, LOG(info) << "KEPT! proton from Lc with daughters " << indexBach);
 
+      const std::array<float, 3> pVecBachOrig = {bach.px(), bach.py(), bach.pz()};
+      const double pBach = RecoDecay::p(pVecBachOrig);
+      const double energyBach = RecoDecay::e(pBach, massP);
+
+      // analytic bound on the mass: m^2 >= mP^2 + mK0s^2 + 2 (E_p E_V0 - p_p p_V0) whatever the opening angle.
+      // The bound is convex in the V0 momentum and minimal for equal velocities, p_V0 = p_p mK0s / mP,
+      // so that the V0s below the upper edge of the mass window are the contiguous range around that momentum
+      compatibleV0s.clear();
+      if (cutInvMassCascLc >= 0.) {
+        auto mass2MinOf = [&](const PreselectedV0& v0) {
+          return massP * massP + massK0s * massK0s + 2. * (energyBach * v0.energy - pBach * v0.p);
+        };
+        const double pV0EqualVelocity = pBach * massK0s / massP;
+        auto middle = std::lower_bound(preselectedV0s.begin(), preselectedV0s.end(), pV0EqualVelocity, [](const PreselectedV0& v0, double p) { return v0.p < p; });
+        for (auto it = middle; it != preselectedV0s.end() && mass2MinOf(*it) <= mass2Max; ++it) {
+          compatibleV0s.push_back(it - preselectedV0s.begin());
+        }
+        for (auto it = middle; it != preselectedV0s.begin() && mass2MinOf(*(it - 1)) <= mass2Max; --it) {
+          compatibleV0s.push_back(it - 1 - preselectedV0s.begin());
+        }
+      } else {
+        for (std::size_t iV0 = 0; iV0 < preselectedV0s.size(); ++iV0) {
+          compatibleV0s.push_back(iV0);
+        }
+      }
+      if (compatibleV0s.empty()) {
+        continue;
+      }
+      // the candidates are written in the order of the V0 table
+      std::sort(compatibleV0s.begin(), compatibleV0s.end(), [&](int a, int b) { return preselectedV0s[a].index < preselectedV0s[b].index; });
+
       auto trackBach = getTrackParCov(bach);
       // now we loop over the V0s
-      for (const auto& v0 : V0s) {
-        MY_DEBUG_MSG(1, LOG(info) << "*** Checking next K0S");
-        // selections on the V0 daughters
-        const auto& trackV0DaughPos = v0.posTrack_as<MyTracks>();
-        const auto& trackV0DaughNeg = v0.negTrack_as<MyTracks>();
+      for (auto iV0 : compatibleV0s) {
+        const auto& v0 = preselectedV0s[iV0];
 #ifdef MY_DEBUG
-        auto indexV0DaughPos = trackV0DaughPos.mcParticleId();
-        auto indexV0DaughNeg = trackV0DaughNeg.mcParticleId();
+        auto indexV0DaughPos = v0.indexDaughPos;
+        auto indexV0DaughNeg = v0.indexDaughNeg;
         bool isK0SfromLc = isK0SfromLcFunc(indexV0DaughPos, indexV0DaughNeg, indexK0Spos, indexK0Sneg);
-
         bool isLc = isLcK0SpFunc(indexBach, indexV0DaughPos, indexV0DaughNeg, indexProton, indexK0Spos, indexK0Sneg);
 #endif
-        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S from Lc found, trackV0DaughPos --> " << indexV0DaughPos << ", trackV0DaughNeg --> " << indexV0DaughNeg);
-
         MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc,
                      LOG(info) << "ACCEPTED!!!";
                      LOG(info) << "proton belonging to a Lc found: label --> " << indexBach;
@@ -2309,72 +2861,20 @@ struct HfTrackIndexSkimCreatorCascades {
 
         MY_DEBUG_MSG(isLc, LOG(info) << "Combination of K0S and p which correspond to a Lc found!");
 
-        if (tpcRefitV0Daugh) {
-          if (!(trackV0DaughPos.trackType() & o2::aod::track::TPCrefit) ||
-              !(trackV0DaughNeg.trackType() & o2::aod::track::TPCrefit)) {
-            MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to TPCrefit");
-            continue;
-          }
-        }
-        if (trackV0DaughPos.tpcNClsCrossedRows() < nCrossedRowsMinV0Daugh ||
-            trackV0DaughNeg.tpcNClsCrossedRows() < nCrossedRowsMinV0Daugh) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minCrossedRows");
-          continue;
-        }
-        //
-        // if (trackV0DaughPos.dcaXY() < dcaXYPosToPvMin ||   // to the filters?
-        //     trackV0DaughNeg.dcaXY() < dcaXYNegToPvMin) {
-        //   continue;
-        // }
-        //
-        if (trackV0DaughPos.pt() < ptMinV0Daugh || // to the filters? I can't for now, it is not in the tables
-            trackV0DaughNeg.pt() < ptMinV0Daugh) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to minPt --> pos " << trackV0DaughPos.pt() << ", neg " << trackV0DaughNeg.pt() << " (cut " << ptMinV0Daugh << ")");
-          continue;
-        }
-        if (std::abs(trackV0DaughPos.eta()) > etaMaxV0Daugh || // to the filters? I can't for now, it is not in the tables
-            std::abs(trackV0DaughNeg.eta()) > etaMaxV0Daugh) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to eta --> pos " << trackV0DaughPos.eta() << ", neg " << trackV0DaughNeg.eta() << " (cut " << etaMaxV0Daugh << ")");
-          continue;
-        }
-
-        // V0 invariant mass selection
-        if (std::abs(v0.mK0Short() - massK0s) > cutInvMassV0) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to invMass --> " << v0.mK0Short() - massK0s << " (cut " << cutInvMassV0 << ")");
-          continue; // should go to the filter, but since it is a dynamic column, I cannot use it there
-        }
-
-        // V0 cosPointingAngle selection
-        if (v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) < cpaV0Min) {
-          MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "K0S with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg << ": rejected due to cosPA --> " << v0.v0cosPA(collision.posX(), collision.posY(), collision.posZ()) << " (cut " << cpaV0Min << ")");
-          continue;
-        }
-
-        const std::array<float, 3> momentumV0 = {v0.px(), v0.py(), v0.pz()};
-
         // invariant-mass cut: we do it here, before updating the momenta of bach and V0 during the fitting to save CPU
         // TODO: but one should better check that the value here and after the fitter do not change significantly!!!
-        mass2K0sP = RecoDecay::m(array{array{bach.px(), bach.py(), bach.pz()}, momentumV0}, array{massP, massK0s});
+        const double energyCasc = energyBach + v0.energy;
+        mass2K0sP = std::sqrt(std::max(0., energyCasc * energyCasc - RecoDecay::p2(pVecBachOrig, v0.pVec)));
         if ((cutInvMassCascLc >= 0.) && (std::abs(mass2K0sP - massLc) > cutInvMassCascLc)) {
           MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc, LOG(info) << "True Lc from proton " << indexBach << " and K0S pos " << indexV0DaughPos << " and neg " << indexV0DaughNeg << " rejected due to invMass cut: " << mass2K0sP << ", mass Lc " << massLc << " (cut " << cutInvMassCascLc << ")");
           continue;
         }
 
-        MY_DEBUG_MSG(isK0SfromLc, LOG(info) << "KEPT! K0S from Lc with daughters " << indexV0DaughPos << " and " << indexV0DaughNeg);
-
-        auto trackParCovV0DaughPos = getTrackParCov(trackV0DaughPos);
-        trackParCovV0DaughPos.propagateTo(v0.posX(), o2::base::Propagator::Instance()->getNominalBz()); // propagate the track to the X closest to the V0 vertex
-        auto trackParCovV0DaughNeg = getTrackParCov(trackV0DaughNeg);
-        trackParCovV0DaughNeg.propagateTo(v0.negX(), o2::base::Propagator::Instance()->getNominalBz()); // propagate the track to the X closest to the V0 vertex
         std::array<float, 3> pVecV0 = {0., 0., 0.};
         std::array<float, 3> pVecBach = {0., 0., 0.};
 
-        const std::array<float, 3> vertexV0 = {v0.x(), v0.y(), v0.z()};
-        // we build the neutral track to then build the cascade
-        auto trackV0 = o2::dataformats::V0(vertexV0, momentumV0, {0, 0, 0, 0, 0, 0}, trackParCovV0DaughPos, trackParCovV0DaughNeg, {0, 0}, {0, 0}); // build the V0 track
-
         // now we find the DCA between the V0 and the bachelor, for the cascade
-        int nCand2 = fitter.process(trackV0, trackBach);
+        int nCand2 = fitter.process(v0.track, trackBach);
         MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc, LOG(info) << "Fitter result = " << nCand2 << " proton = " << indexBach << " and K0S pos " << indexV0DaughPos << " and neg " << indexV0DaughNeg);
         MY_DEBUG_MSG(isLc, LOG(info) << "Fitter result for true Lc = " << nCand2);
         if (nCand2 == 0) {
@@ -2403,7 +2903,7 @@ struct HfTrackIndexSkimCreatorCascades {
 
         // fill table row
         rowTrackIndexCasc(bach.globalIndex(),
-                          v0.globalIndex());
+                          v0.globalIndex);
         // fill histograms
         if (fillHistograms) {
           MY_DEBUG_MSG(isK0SfromLc && isProtonFromLc && isLc, LOG(info) << "KEPT! True Lc from proton " << indexBach << " and K0S pos " << indexV0DaughPos << " and neg " << indexV0DaughNeg);
@@ -126,6 +126,35 @@ DECLARE_SOA_TABLE(HfCand2ProngFull, "AOD", "HFCAND2PFull",
                   full::E,
                   full::MCflag);
 
+// reduced set of the candidate variables used in the ML trainings
+DECLARE_SOA_TABLE(HfCand2ProngLite, "AOD", "HFCAND2PLite",
+                  full::PtProng0,
+                  full::PtProng1,
+                  hf_cand::ImpactParameter0,
+                  hf_cand::ImpactParameter1,
+                  full::DecayLength,
+                  full::DecayLengthXY,
+                  full::DecayLengthNormalised,
+                  full::DecayLengthXYNormalised,
+                  full::NSigTPCPi0,
+                  full::NSigTPCKa0,
+                  full::NSigTOFPi0,
+                  full::NSigTOFKa0,
+                  full::NSigTPCPi1,
+                  full::NSigTPCKa1,
+                  full::NSigTOFPi1,
+                  full::NSigTOFKa1,
+                  full::CandidateSelFlag,
+                  full::M,
+                  full::ImpactParameterProduct,
+                  full::CosThetaStar,
+                  full::Pt,
+                  full::CPA,
+                  full::CPAXY,
+                  full::Ct,
+                  full::Y,
+                  full::MCflag);
+
 DECLARE_SOA_TABLE(HfCand2ProngFullEvents, "AOD", "HFCAND2PFullE",
                   collision::BCId,
                   collision::NumContrib,
@@ -150,9 +179,31 @@ struct HfTreeCreatorD0ToKPi {
   Produces<o2::aod::HfCand2ProngFull> rowCandidateFull;
   Produces<o2::aod::HfCand2ProngFullEvents> rowCandidateFullEvents;
   Produces<o2::aod::HfCand2ProngFullParticles> rowCandidateFullParticles;
+  Produces<o2::aod::HfCand2ProngLite> rowCandidateLite;
+
+  Configurable<bool> fillCandidateLiteTable{"fillCandidateLiteTable", false, "Switch to fill the lite table with the ML training variables instead of the full one"};
+  Configurable<std::vector<double>> binsPtBkg{"binsPtBkg", std::vector<double>{0., 2., 4., 8., 50.}, "pT bin limits for the downsampling of the background"};
+  Configurable<std::vector<double>> downSampleBkgFactors{"downSampleBkgFactors", std::vector<double>{1., 1., 1., 1.}, "Fraction of background candidates to store in the tree, per pT bin"};
 
   void init(InitContext const&)
   {
+    if (downSampleBkgFactors->size() != binsPtBkg->size() - 1) {
+      LOGF(fatal, "Number of background downsampling factors (%d) does not match the number of pT bins (%d)", downSampleBkgFactors->size(), binsPtBkg->size() - 1);
+    }
+  }
+
+  /// Decides whether a background candidate is stored, according to the downsampling factor of its pT bin
+  /// \param ptCand  candidate transverse momentum
+  /// \param ptProng  transverse momentum of a prong, used as pseudorandom number
+  /// \return true if the candidate is stored, candidates outside the pT bins are always stored
+  bool keepBkgCandidate(float ptCand, float ptProng)
+  {
+    auto bin = o2::analysis::findBin(binsPtBkg, ptCand);
+    if (bin == -1) {
+      return true;
+    }
+    double pseudoRndm = ptProng * 1000. - (long)(ptProng * 1000);
+    return pseudoRndm < downSampleBkgFactors->at(bin);
   }
 
   void process(aod::Collisions const& collisions,
@@ -176,7 +227,11 @@ struct HfTreeCreatorD0ToKPi {
     }
 
     // Filling candidate properties
-    rowCandidateFull.reserve(candidates.size());
+    if (fillCandidateLiteTable) {
+      rowCandidateLite.reserve(candidates.size());
+    } else {
+      rowCandidateFull.reserve(candidates.size());
+    }
     for (auto& candidate : candidates) {
       auto fillTable = [&](int CandFlag,
                            int FunctionSelection,
@@ -185,7 +240,41 @@ struct HfTreeCreatorD0ToKPi {
                            double FunctionCt,
                            double FunctionY,
                            double FunctionE) {
-        if (FunctionSelection >= 1) {
+        if (FunctionSelection < 1) {
+          return;
+        }
+        if (candidate.flagMcMatchRec() == 0 && !keepBkgCandidate(candidate.pt(), candidate.ptProng0())) {
+          return;
+        }
+        if (fillCandidateLiteTable) {
+          rowCandidateLite(
+            candidate.ptProng0(),
+            candidate.ptProng1(),
+            candidate.impactParameter0(),
+            candidate.impactParameter1(),
+            candidate.decayLength(),
+            candidate.decayLengthXY(),
+            candidate.decayLengthNormalised(),
+            candidate.decayLengthXYNormalised(),
+            candidate.prong0_as<aod::BigTracksPID>().tpcNSigmaPi(),
+            candidate.prong0_as<aod::BigTracksPID>().tpcNSigmaKa(),
+            candidate.prong0_as<aod::BigTracksPID>().tofNSigmaPi(),
+            candidate.prong0_as<aod::BigTracksPID>().tofNSigmaKa(),
+            candidate.prong1_as<aod::BigTracksPID>().tpcNSigmaPi(),
+            candidate.prong1_as<aod::BigTracksPID>().tpcNSigmaKa(),
+            candidate.prong1_as<aod::BigTracksPID>().tofNSigmaPi(),
+            candidate.prong1_as<aod::BigTracksPID>().tofNSigmaKa(),
+            1 << CandFlag,
+            FunctionInvMass,
+            candidate.impactParameterProduct(),
+            FunctionCosThetaStar,
+            candidate.pt(),
+            candidate.cpa(),
+            candidate.cpaXY(),
+            FunctionCt,
+            FunctionY,
+            candidate.flagMcMatchRec());
+        } else {
           rowCandidateFull(
             candidate.prong0_as<aod::BigTracksPID>().collision().bcId(),
             candidate.prong0_as<aod::BigTracksPID>().collision().numContrib(),
@@ -155,6 +155,47 @@ DECLARE_SOA_TABLE(HfCand3ProngFull, "AOD", "HFCAND3PFull",
                   full::MCflag,
                   full::IsCandidateSwapped);
 
+// reduced set of the candidate variables used in the ML trainings
+DECLARE_SOA_TABLE(HfCand3ProngLite, "AOD", "HFCAND3PLite",
+                  full::PtProng0,
+                  full::PtProng1,
+                  full::PtProng2,
+                  hf_cand::ImpactParameter0,
+                  hf_cand::ImpactParameter1,
+                  hf_cand::ImpactParameter2,
+                  hf_cand::Chi2PCA,
+                  full::DecayLength,
+                  full::DecayLengthXY,
+                  full::DecayLengthNormalised,
+                  full::DecayLengthXYNormalised,
+                  full::NSigTPCPi0,
+                  full::NSigTPCKa0,
+                  full::NSigTPCPr0,
+                  full::NSigTOFPi0,
+                  full::NSigTOFKa0,
+                  full::NSigTOFPr0,
+                  full::NSigTPCPi1,
+                  full::NSigTPCKa1,
+                  full::NSigTPCPr1,
+                  full::NSigTOFPi1,
+                  full::NSigTOFKa1,
+                  full::NSigTOFPr1,
+                  full::NSigTPCPi2,
+                  full::NSigTPCKa2,
+                  full::NSigTPCPr2,
+                  full::NSigTOFPi2,
+                  full::NSigTOFKa2,
+                  full::NSigTOFPr2,
+                  full::CandidateSelFlag,
+                  full::M,
+                  full::Pt,
+                  full::CPA,
+                  full::CPAXY,
+                  full::Ct,
+                  full::Y,
+                  full::MCflag,
+                  full::IsCandidateSwapped);
+
 DECLARE_SOA_TABLE(HfCand3ProngFullEvents, "AOD", "HFCAND3PFullE",
                   collision::BCId,
                   collision::NumContrib,
@@ -179,11 +220,79 @@ struct HfTreeCreatorLcToPKPi {
   Produces<o2::aod::HfCand3ProngFull> rowCandidateFull;
   Produces<o2::aod::HfCand3ProngFullEvents> rowCandidateFullEvents;
   Produces<o2::aod::HfCand3ProngFullParticles> rowCandidateFullParticles;
+  Produces<o2::aod::HfCand3ProngLite> rowCandidateLite;
 
   Configurable<double> downSampleBkgFactor{"downSampleBkgFactor", 1., "Fraction of candidates to store in the tree"};
+  Configurable<bool> fillCandidateLiteTable{"fillCandidateLiteTable", false, "Switch to fill the lite table with the ML training variables instead of the full one"};
+  Configurable<std::vector<double>> binsPtBkg{"binsPtBkg", std::vector<double>{0., 2., 4., 8., 50.}, "pT bin limits for the downsampling of the background"};
+  Configurable<std::vector<double>> downSampleBkgFactors{"downSampleBkgFactors", std::vector<double>{1., 1., 1., 1.}, "Fraction of background candidates to store in the tree per pT bin, on top of downSampleBkgFactor"};
 
   void init(InitContext const&)
   {
+    if (downSampleBkgFactors->size() != binsPtBkg->size() - 1) {
+      LOGF(fatal, "Number of background downsampling factors (%d) does not match the number of pT bins (%d)", downSampleBkgFactors->size(), binsPtBkg->size() - 1);
+    }
+  }
+
+  /// Decides whether a background candidate is stored, according to the downsampling factor of its pT bin
+  /// \param ptCand  candidate transverse momentum
+  /// \param ptProng  transverse momentum of a prong, used as pseudorandom number
+  /// \return true if the candidate is stored
+  bool keepBkgCandidate(float ptCand, float ptProng)
+  {
+    double factor = downSampleBkgFactor;
+    auto bin = o2::analysis::findBin(binsPtBkg, ptCand);
+    if (bin > -1) {
+      factor *= downSampleBkgFactors->at(bin);
+    }
+    double pseudoRndm = ptProng * 1000. - (long)(ptProng * 1000);
+    return pseudoRndm < factor;
+  }
+
+  /// Fills the lite table with the variables used in the ML trainings
+  template <typename T1, typename T2>
+  void fillLiteTable(T1 const& candidate, T2 const& trackPos1, T2 const& trackNeg, T2 const& trackPos2,
+                     int candFlag, float invMass, float ct, float y, int8_t flagMc, int8_t isSwapped)
+  {
+    rowCandidateLite(
+      candidate.ptProng0(),
+      candidate.ptProng1(),
+      candidate.ptProng2(),
+      candidate.impactParameter0(),
+      candidate.impactParameter1(),
+      candidate.impactParameter2(),
+      candidate.chi2PCA(),
+      candidate.decayLength(),
+      candidate.decayLengthXY(),
+      candidate.decayLengthNormalised(),
+      candidate.decayLengthXYNormalised(),
+      trackPos1.tpcNSigmaPi(),
+      trackPos1.tpcNSigmaKa(),
+      trackPos1.tpcNSigmaPr(),
+      trackPos1.tofNSigmaPi(),
+      trackPos1.tofNSigmaKa(),
+      trackPos1.tofNSigmaPr(),
+      trackNeg.tpcNSigmaPi(),
+      trackNeg.tpcNSigmaKa(),
+      trackNeg.tpcNSigmaPr(),
+      trackNeg.tofNSigmaPi(),
+      trackNeg.tofNSigmaKa(),
+      trackNeg.tofNSigmaPr(),
+      trackPos2.tpcNSigmaPi(),
+      trackPos2.tpcNSigmaKa(),
+      trackPos2.tpcNSigmaPr(),
+      trackPos2.tofNSigmaPi(),
+      trackPos2.tofNSigmaKa(),
+      trackPos2.tofNSigmaPr(),
+      1 << candFlag,
+      invMass,
+      candidate.pt(),
+      candidate.cpa(),
+      candidate.cpaXY(),
+      ct,
+      y,
+      flagMc,
+      isSwapped);
   }
 
   void processMc(aod::Collisions const& collisions,
@@ -207,7 +316,11 @@ struct HfTreeCreatorLcToPKPi {
     }
 
     // Filling candidate properties
-    rowCandidateFull.reserve(candidates.size());
+    if (fillCandidateLiteTable) {
+      rowCandidateLite.reserve(candidates.size());
+    } else {
+      rowCandidateFull.reserve(candidates.size());
+    }
     for (auto& candidate : candidates) {
       auto trackPos1 = candidate.prong0_as<aod::BigTracksPID>(); // positive daughter (negative for the antiparticles)
       auto trackNeg = candidate.prong1_as<aod::BigTracksPID>();  // negative daughter (positive for the antiparticles)
@@ -220,6 +333,10 @@ struct HfTreeCreatorLcToPKPi {
                            float FunctionE) {
         double pseudoRndm = trackPos1.pt() * 1000. - (long)(trackPos1.pt() * 1000);
         if (FunctionSelection >= 1 && std::abs(candidate.flagMcMatchRec()) == 1 << DecayType::LcToPKPi && pseudoRndm < downSampleBkgFactor) {
+          if (fillCandidateLiteTable) {
+            fillLiteTable(candidate, trackPos1, trackNeg, trackPos2, CandFlag, FunctionInvMass, FunctionCt, FunctionY, candidate.flagMcMatchRec(), candidate.isCandidateSwapped());
+            return;
+          }
           rowCandidateFull(
             trackPos1.collision().bcId(),
             trackPos1.collision().numContrib(),
@@ -334,7 +451,11 @@ struct HfTreeCreatorLcToPKPi {
     }
 
     // Filling candidate properties
-    rowCandidateFull.reserve(candidates.size());
+    if (fillCandidateLiteTable) {
+      rowCandidateLite.reserve(candidates.size());
+    } else {
+      rowCandidateFull.reserve(candidates.size());
+    }
     for (auto& candidate : candidates) {
       auto trackPos1 = candidate.prong0_as<aod::BigTracksPID>(); // positive daughter (negative for the antiparticles)
       auto trackNeg = candidate.prong1_as<aod::BigTracksPID>();  // negative daughter (positive for the antiparticles)
@@ -345,8 +466,11 @@ struct HfTreeCreatorLcToPKPi {
                            float FunctionCt,
                            float FunctionY,
                            float FunctionE) {
-        double pseudoRndm = trackPos1.pt() * 1000. - (long)(trackPos1.pt() * 1000);
-        if (FunctionSelection >= 1 && pseudoRndm < downSampleBkgFactor) {
+        if (FunctionSelection >= 1 && keepBkgCandidate(candidate.pt(), trackPos1.pt())) {
+          if (fillCandidateLiteTable) {
+            fillLiteTable(candidate, trackPos1, trackNeg, trackPos2, CandFlag, FunctionInvMass, FunctionCt, FunctionY, 0, 0);
+            return;
+          }
           rowCandidateFull(
             trackPos1.collision().bcId(),
             trackPos1.collision().numContrib(),
@@ -205,8 +205,7 @@ struct HfTaskD0 {
       }
       if (std::abs(candidate.flagMcMatchRec()) == 1 << DecayType::D0ToPiK) {
         // Get the corresponding MC particle.
-        auto indexMother = RecoDecay::getMother(particlesMC, candidate.prong0_as<aod::BigTracksMC>().mcParticle_as<soa::Join<aod::McParticles, aod::HfCand2ProngMcGen>>(), pdg::Code::kD0, true);
-        auto particleMother = particlesMC.rawIteratorAt(indexMother);
+        auto particleMother = particlesMC.rawIteratorAt(candidate.indexMcRec());
         registry.fill(HIST("hPtGenSig"), particleMother.pt()); // gen. level pT
         auto ptRec = candidate.pt();
         auto yRec = yD0(candidate);
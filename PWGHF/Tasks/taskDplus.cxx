@@ -142,8 +142,7 @@ struct HfTaskDplus {
       }
       if (std::abs(candidate.flagMcMatchRec()) == 1 << DecayType::DplusToPiKPi) {
         // Get the corresponding MC particle.
-        auto indexMother = RecoDecay::getMother(particlesMC, candidate.prong0_as<aod::BigTracksMC>().mcParticle_as<soa::Join<aod::McParticles, aod::HfCand3ProngMcGen>>(), pdg::Code::kDPlus, true);
-        auto particleMother = particlesMC.rawIteratorAt(indexMother);
+        auto particleMother = particlesMC.rawIteratorAt(candidate.indexMcRec());
         registry.fill(HIST("hPtGenSig"), particleMother.pt()); // gen. level pT
         auto ptRec = candidate.pt();
         auto yRec = yDplus(candidate);
@@ -55,6 +55,22 @@ DECLARE_SOA_TABLE(TracksWithAmbiguousCollisionInfo, "AOD", "TRACKSWAMBINFO",
 DECLARE_SOA_COLUMN(HasHFsignal, hasHFsignal, bool);         //!
 DECLARE_SOA_TABLE(CollWithHFSignal, "AOD", "COLLWHFSIGNAL", //!
                   HasHFsignal);
+
+// Columns to store the generator-level decay of the charm hadrons, joinable with the MC particle table
+namespace hf_mc_gen_decay
+{
+DECLARE_SOA_COLUMN(Channel, channel, int8_t);     //! index of the charm hadron in the validated channels, -1 if not a decay of interest
+DECLARE_SOA_COLUMN(Origin, origin, int8_t);       //! particle origin (prompt, non-prompt), -1 if not a decay of interest
+DECLARE_SOA_COLUMN(XDecayGen, xDecayGen, float);  //! x of the decay vertex of the validated hadrons, -999 otherwise
+DECLARE_SOA_COLUMN(YDecayGen, yDecayGen, float);  //! y of the decay vertex of the validated hadrons, -999 otherwise
+DECLARE_SOA_COLUMN(ZDecayGen, zDecayGen, float);  //! z of the decay vertex of the validated hadrons, -999 otherwise
+} // namespace hf_mc_gen_decay
+DECLARE_SOA_TABLE(HfMcGenDecays, "AOD", "HFMCGENDECAY", //!
+                  hf_mc_gen_decay::Channel,
+                  hf_mc_gen_decay::Origin,
+                  hf_mc_gen_decay::XDecayGen,
+                  hf_mc_gen_decay::YDecayGen,
+                  hf_mc_gen_decay::ZDecayGen);
 } // namespace o2::aod
 
 struct HfTaskMcValidationAddAmbiguousTrackInfo {
@@ -119,6 +135,7 @@ struct HfTaskMcValidationAddAmbiguousTrackInfo {
 
 struct HfTaskMcValidationGen {
   Produces<o2::aod::CollWithHFSignal> collWithHFSignal;
+  Produces<o2::aod::HfMcGenDecays> rowMcGenDecay;
 
   Configurable<double> xVertexMin{"xVertexMin", -100., "min. x of generated primary vertex [cm]"};
   Configurable<double> xVertexMax{"xVertexMax", 100., "max. x of generated primary vertex [cm]"};
@@ -218,13 +235,20 @@ struct HfTaskMcValidationGen {
     std::vector<int> listDaughters{};
 
     bool hasSignal = false;
+    bool isVertexSelected = selectVertex(mccollision);
 
+    // one row of the generator-level decay table per particle, the decays are walked only here
     for (auto& particle : particlesMC) {
-      if (!selectVertex(mccollision))
-        continue;
-
+      int8_t channel = -1;
+      int8_t originGen = -1;
+      std::array<float, 3> vertexDecay{-999.f, -999.f, -999.f};
       int particlePdgCode = particle.pdgCode();
-      if (!particle.has_mothers()) {
+      if (particle.has_daughters() && std::find(PDGArrayParticle.begin(), PDGArrayParticle.end(), std::abs(particlePdgCode)) != PDGArrayParticle.end()) {
+        auto daughter0 = particle.daughters_as<aod::McParticles>().begin();
+        vertexDecay = {daughter0.vx(), daughter0.vy(), daughter0.vz()};
+      }
+      if (!isVertexSelected || !particle.has_mothers()) {
+        rowMcGenDecay(channel, originGen, vertexDecay[0], vertexDecay[1], vertexDecay[2]);
         continue;
       }
       auto mother = particle.mothers_as<aod::McParticles>().front();
@@ -266,6 +290,8 @@ struct HfTaskMcValidationGen {
           if (listDaughters.size() == arrayPDGsize) {
             hasSignal = true;
             origin = RecoDecay::getCharmHadronOrigin(particlesMC, particle);
+            channel = iD;
+            originGen = origin;
             if (origin == RecoDecay::OriginType::Prompt) {
               counterPrompt[iD]++;
             } else if (origin == RecoDecay::OriginType::NonPrompt) {
@@ -286,8 +312,7 @@ struct HfTaskMcValidationGen {
           }
           double pDiff = RecoDecay::p(pxDiff, pyDiff, pzDiff);
           double ptDiff = RecoDecay::pt(pxDiff, pyDiff);
-          auto daughter0 = particle.daughters_as<aod::McParticles>().begin();
-          double vertexDau[3] = {daughter0.vx(), daughter0.vy(), daughter0.vz()};
+          double vertexDau[3] = {vertexDecay[0], vertexDecay[1], vertexDecay[2]};
           double vertexPrimary[3] = {mccollision.posX(), mccollision.posY(), mccollision.posZ()};
 
           auto decayLength = RecoDecay::distance(vertexPrimary, vertexDau);
@@ -313,6 +338,7 @@ struct HfTaskMcValidationGen {
           }
         }
       }
+      rowMcGenDecay(channel, originGen, vertexDecay[0], vertexDecay[1], vertexDecay[2]);
     } // end particles
     registry.fill(HIST("hCountAverageC"), cPerCollision);
     registry.fill(HIST("hCountAverageB"), bPerCollision);
@@ -363,6 +389,7 @@ struct HfTaskMcValidationRec {
   using CollisionsWithMCLabels = soa::Join<aod::Collisions, aod::McCollisionLabels>;
   using TracksWithSel = soa::Join<aod::BigTracksMC, aod::TrackSelection, aod::TracksWithAmbiguousCollisionInfo>;
   using mcCollisionWithHFSignalInfo = soa::Join<aod::McCollisions, aod::CollWithHFSignal>;
+  using McParticlesWithDecay = soa::Join<aod::McParticles, aod::HfMcGenDecays>;
 
   Partition<TracksWithSel> tracksFilteredGlobalTrackWoDCA = requireGlobalTrackWoDCAInFilter();
   Partition<TracksWithSel> tracksInAcc = requireTrackCutInFilter(TrackSelectionFlags::kInAcceptanceTracks);
@@ -453,7 +480,7 @@ struct HfTaskMcValidationRec {
     histContributors->GetXaxis()->SetBinLabel(2, "wrong MC collision");
   }
 
-  void process(HfCand2ProngWithMCRec const& cand2Prongs, HfCand3ProngWithMCRec const& cand3Prongs, TracksWithSel const& tracks, aod::McParticles const& particlesMC, mcCollisionWithHFSignalInfo const& mcCollisions, CollisionsWithMCLabels const& collisions, aod::BCs const&)
+  void process(HfCand2ProngWithMCRec const& cand2Prongs, HfCand3ProngWithMCRec const& cand3Prongs, TracksWithSel const& tracks, McParticlesWithDecay const& particlesMC, mcCollisionWithHFSignalInfo const& mcCollisions, CollisionsWithMCLabels const& collisions, aod::BCs const&)
   {
     // loop over collisions
     for (auto collision = collisions.begin(); collision != collisions.end(); ++collision) {
@@ -497,7 +524,7 @@ struct HfTaskMcValidationRec {
           int nFromBeautyColl1 = 0, nFromBeautyColl2 = 0;
           for (auto& trackColl1 : tracksColl1) {
             if (trackColl1.has_mcParticle() && trackColl1.isPVContributor()) {
-              auto particleColl1 = trackColl1.mcParticle();
+              auto particleColl1 = trackColl1.mcParticle_as<McParticlesWithDecay>();
               auto origin = RecoDecay::getCharmHadronOrigin(particlesMC, particleColl1, true);
               if (origin == RecoDecay::NonPrompt) {
                 nFromBeautyColl1++;
@@ -507,7 +534,7 @@ struct HfTaskMcValidationRec {
           auto tracksColl2 = tracksInAcc->sliceByCached(aod::track::collisionId, collision2.globalIndex());
           for (auto& trackColl2 : tracksColl2) {
             if (trackColl2.has_mcParticle() && trackColl2.isPVContributor()) {
-              auto particleColl2 = trackColl2.mcParticle();
+              auto particleColl2 = trackColl2.mcParticle_as<McParticlesWithDecay>();
               auto origin = RecoDecay::getCharmHadronOrigin(particlesMC, particleColl2, true);
               if (origin == RecoDecay::NonPrompt) {
                 nFromBeautyColl2++;
@@ -532,7 +559,7 @@ struct HfTaskMcValidationRec {
       }
       uint index = uint(track.collisionId() >= 0);
       if (track.has_mcParticle()) {
-        auto particle = track.mcParticle(); // get corresponding MC particle to check origin
+        auto particle = track.mcParticle_as<McParticlesWithDecay>(); // get corresponding MC particle to check origin
         if (checkAmbiguousTracksWithHfEventsOnly) {
           auto mcCollision = particle.mcCollision_as<mcCollisionWithHFSignalInfo>();
           if (!mcCollision.hasHFsignal()) {
@@ -607,18 +634,14 @@ struct HfTaskMcValidationRec {
       }
 
       if (whichHad >= 0 && whichOrigin >= 0) {
-        int indexParticle = 0;
-        if (cand2Prong.prong0_as<TracksWithSel>().has_mcParticle()) {
-          indexParticle = RecoDecay::getMother(particlesMC, cand2Prong.prong0_as<TracksWithSel>().mcParticle(), PDGArrayParticle[whichHad], true);
-        }
-        auto mother = particlesMC.rawIteratorAt(indexParticle);
+        // matched particle and decay vertex from the reconstruction- and generator-level matching tables
+        auto mother = particlesMC.rawIteratorAt(cand2Prong.indexMcRec());
         histDeltaPt[whichHad]->Fill(cand2Prong.pt() - mother.pt());
         histDeltaPx[whichHad]->Fill(cand2Prong.px() - mother.px());
         histDeltaPy[whichHad]->Fill(cand2Prong.py() - mother.py());
         histDeltaPz[whichHad]->Fill(cand2Prong.pz() - mother.pz());
         // Compare Secondary vertex and decay length with MC
-        auto daughter0 = mother.daughters_as<aod::McParticles>().begin();
-        double vertexDau[3] = {daughter0.vx(), daughter0.vy(), daughter0.vz()};
+        double vertexDau[3] = {mother.xDecayGen(), mother.yDecayGen(), mother.zDecayGen()};
         double vertexMoth[3] = {mother.vx(), mother.vy(), mother.vz()};
         auto decayLength = RecoDecay::distance(vertexMoth, vertexDau);
 
@@ -672,18 +695,14 @@ struct HfTaskMcValidationRec {
       }
 
       if (whichHad >= 0) {
-        int indexParticle = 0;
-        if (cand3Prong.prong0_as<TracksWithSel>().has_mcParticle()) {
-          indexParticle = RecoDecay::getMother(particlesMC, cand3Prong.prong0_as<TracksWithSel>().mcParticle(), PDGArrayParticle[whichHad], true);
-        }
-        auto mother = particlesMC.rawIteratorAt(indexParticle);
+        // matched particle and decay vertex from the reconstruction- and generator-level matching tables
+        auto mother = particlesMC.rawIteratorAt(cand3Prong.indexMcRec());
         histDeltaPt[whichHad]->Fill(cand3Prong.pt() - mother.pt());
         histDeltaPx[whichHad]->Fill(cand3Prong.px() - mother.px());
         histDeltaPy[whichHad]->Fill(cand3Prong.py() - mother.py());
         histDeltaPz[whichHad]->Fill(cand3Prong.pz() - mother.pz());
         // Compare Secondary vertex and decay length with MC
-        auto daughter0 = mother.daughters_as<aod::McParticles>().begin();
-        double vertexDau[3] = {daughter0.vx(), daughter0.vy(), daughter0.vz()};
+        double vertexDau[3] = {mother.xDecayGen(), mother.yDecayGen(), mother.zDecayGen()};
         double vertexMoth[3] = {mother.vx(), mother.vy(), mother.vz()};
         auto decayLength = RecoDecay::distance(vertexMoth, vertexDau);
 
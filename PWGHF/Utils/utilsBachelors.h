@@ -0,0 +1,114 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file utilsBachelors.h
+/// \brief Bachelor tracks of the beauty candidate creators, preselected once per collision
+///        The tracks passing the candidate-independent selections are stored with their momentum and track
+///        parametrisation, split by charge and sorted in momentum. For each charm candidate only the bachelors of the
+///        right charge with an invariant mass in the window of the beauty hadron are then given to the vertex fitter.
+
+#ifndef PWGHF_UTILS_UTILSBACHELORS_H_
+#define PWGHF_UTILS_UTILSBACHELORS_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "ReconstructionDataFormats/Track.h"
+#include "Common/Core/trackUtilities.h"
+
+namespace o2::hf_bachelor
+{
+
+/// Preselected bachelor track
+struct Bachelor {
+  int64_t globalIndex{-1};
+  float pt{0.};
+  float p{0.};
+  std::array<float, 3> pVec{};
+  o2::track::TrackParCov trackParCov;
+};
+
+/// Preselected bachelor tracks of a collision
+class BachelorPool
+{
+ public:
+  /// Fills the pool with the tracks of a collision passing isSelected
+  /// \param tracks are the tracks of the collision
+  /// \param isSelected is the candidate-independent selection of the bachelors
+  template <typename TTracks, typename TSelector>
+  void fill(TTracks const& tracks, TSelector&& isSelected)
+  {
+    mPositive.clear();
+    mNegative.clear();
+    for (const auto& track : tracks) {
+      if (!isSelected(track)) {
+        continue;
+      }
+      auto& bachelors = track.sign() > 0 ? mPositive : mNegative;
+      bachelors.push_back({track.globalIndex(), track.pt(), track.p(), {track.px(), track.py(), track.pz()}, getTrackParCov(track)});
+    }
+    const auto lessP = [](Bachelor const& a, Bachelor const& b) { return a.p < b.p; };
+    std::sort(mPositive.begin(), mPositive.end(), lessP);
+    std::sort(mNegative.begin(), mNegative.end(), lessP);
+  }
+
+  std::size_t size() const { return mPositive.size() + mNegative.size(); }
+
+  /// Appends to selected the bachelors of charge sign with an invariant mass with the charm candidate in [massMin, massMax]
+  /// The masses are computed with the momenta of the tracks at their reference points, massMax <= 0 accepts all masses
+  /// \param sign is the charge of the bachelors
+  /// \param pVecCharm is the momentum of the charm candidate
+  /// \param massCharm is the mass hypothesis of the charm candidate
+  /// \param massBachelor is the mass hypothesis of the bachelor
+  void select(int sign, std::array<float, 3> const& pVecCharm, double massCharm, double massBachelor,
+              double massMin, double massMax, std::vector<Bachelor const*>& selected) const
+  {
+    const auto& bachelors = sign > 0 ? mPositive : mNegative;
+    if (massMax <= 0.) {
+      for (const auto& bachelor : bachelors) {
+        selected.push_back(&bachelor);
+      }
+      return;
+    }
+    const double p2Charm = pVecCharm[0] * pVecCharm[0] + pVecCharm[1] * pVecCharm[1] + pVecCharm[2] * pVecCharm[2];
+    const double pCharm = std::sqrt(p2Charm);
+    const double eCharm = std::sqrt(p2Charm + massCharm * massCharm);
+    const double mass2Min = massMin > 0. ? massMin * massMin : 0.;
+    const double mass2Max = massMax * massMax;
+    // the smallest mass over the opening angles, for collinear momenta, increases with the momentum of the bachelor
+    // once it is faster than the charm candidate: beyond, no bachelor of higher momentum can be below massMax
+    const double pIncreasing = pCharm * massBachelor / massCharm;
+    const double mass2Sum = massCharm * massCharm + massBachelor * massBachelor;
+    for (const auto& bachelor : bachelors) {
+      const double energy = std::sqrt(bachelor.p * bachelor.p + massBachelor * massBachelor);
+      if (bachelor.p > pIncreasing && mass2Sum + 2. * (eCharm * energy - pCharm * bachelor.p) > mass2Max) {
+        break;
+      }
+      const double pDot = pVecCharm[0] * bachelor.pVec[0] + pVecCharm[1] * bachelor.pVec[1] + pVecCharm[2] * bachelor.pVec[2];
+      const double mass2 = mass2Sum + 2. * (eCharm * energy - pDot);
+      if (mass2 < mass2Min || mass2 > mass2Max) {
+        continue;
+      }
+      selected.push_back(&bachelor);
+    }
+  }
+
+ private:
+  std::vector<Bachelor> mPositive; ///< positive bachelors, sorted in momentum
+  std::vector<Bachelor> mNegative; ///< negative bachelors, sorted in momentum
+};
+
+} // namespace o2::hf_bachelor
+
+#endif // PWGHF_UTILS_UTILSBACHELORS_H_
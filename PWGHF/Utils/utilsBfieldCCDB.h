@@ -17,6 +17,7 @@
 #include "DataFormatsParameters/GRPObject.h"
 #include "DataFormatsParameters/GRPMagField.h"
 #include "DetectorsBase/GeometryManager.h"
+#include "Common/Core/CCDBObjectCache.h"
 
 /// \brief Sets up the grp object for magnetic field (w/o matCorr for propagation)
 /// \param bc is the bunch crossing
@@ -34,7 +35,7 @@ void initCCDB(o2::aod::BCsWithTimestamps::iterator const& bc, int& mRunNumber,
 
     LOGF(info, "====== initCCDB function called (isRun2==%d)", isRun2);
     if (isRun2) { // Run 2 GRP object
-      o2::parameters::GRPObject* grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(ccdbPathGrp, bc.timestamp());
+      o2::parameters::GRPObject* grpo = o2::common::CCDBObjectCache::instance().get<o2::parameters::GRPObject>(ccdb, ccdbPathGrp, bc.runNumber(), bc.timestamp(), false);
       if (grpo == nullptr) {
         LOGF(fatal, "Run 2 GRP object (type o2::parameters::GRPObject) is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
       }
@@ -42,7 +43,7 @@ void initCCDB(o2::aod::BCsWithTimestamps::iterator const& bc, int& mRunNumber,
       o2::base::Propagator::Instance()->setMatLUT(lut);
       LOGF(info, "Setting magnetic field to %d kG for run %d from its GRP CCDB object (type o2::parameters::GRPObject)", grpo->getNominalL3Field(), bc.runNumber());
     } else { // Run 3 GRP object
-      o2::parameters::GRPMagField* grpo = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(ccdbPathGrp, bc.timestamp());
+      o2::parameters::GRPMagField* grpo = o2::common::CCDBObjectCache::instance().get<o2::parameters::GRPMagField>(ccdb, ccdbPathGrp, bc.runNumber(), bc.timestamp(), false);
       if (grpo == nullptr) {
         LOGF(fatal, "Run 3 GRP object (type o2::parameters::GRPMagField) is not available in CCDB for run=%d at timestamp=%llu", bc.runNumber(), bc.timestamp());
       }
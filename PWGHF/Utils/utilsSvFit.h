@@ -0,0 +1,101 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file utilsSvFit.h
+/// \brief Utilities to store the secondary-vertex fit of the skimming in the HfSvFit2Prong and HfSvFit3Prong tables
+///        and to read it back in the candidate creators instead of refitting the vertex
+
+#ifndef PWGHF_UTILS_UTILSSVFIT_H_
+#define PWGHF_UTILS_UTILSSVFIT_H_
+
+#include <algorithm>
+#include <array>
+
+#include "ReconstructionDataFormats/Track.h"
+
+namespace o2::hf_sv_fit
+{
+constexpr int NParProng = 7;  // x, alpha and the 5 track parameters of a prong
+constexpr int NCovProng = 15; // elements of the covariance matrix of a prong
+
+/// Flattened secondary-vertex fit of an N-prong candidate, in the layout of the table columns
+/// Position and chi2 are kept in double precision, as returned by the fitter
+template <int N>
+struct SvFit {
+  std::array<double, 3> position{};
+  double chi2PCA{0.};
+  std::array<float, 6> cov{};
+  std::array<float, N * NParProng> parProngs{};
+  std::array<float, N * NCovProng> covProngs{};
+};
+
+/// Secondary-vertex fit of a DCAFitterN after a successful process call
+/// \param fitter is the vertex fitter
+/// \return the fitted vertex and the prongs propagated to it
+template <int N, typename TFitter>
+SvFit<N> fromFitter(TFitter& fitter)
+{
+  SvFit<N> fit;
+  const auto& secondaryVertex = fitter.getPCACandidate();
+  for (int i = 0; i < 3; ++i) {
+    fit.position[i] = secondaryVertex[i];
+  }
+  fit.chi2PCA = fitter.getChi2AtPCACandidate();
+  const auto covMatrixPCA = fitter.calcPCACovMatrixFlat();
+  std::copy(covMatrixPCA.begin(), covMatrixPCA.end(), fit.cov.begin());
+  for (int iProng = 0; iProng < N; ++iProng) {
+    const auto& track = fitter.getTrack(iProng);
+    auto* par = &fit.parProngs[iProng * NParProng];
+    par[0] = track.getX();
+    par[1] = track.getAlpha();
+    for (int i = 0; i < 5; ++i) {
+      par[2 + i] = track.getParam(i);
+    }
+    const auto& covProng = track.getCov();
+    std::copy(covProng.begin(), covProng.end(), fit.covProngs.begin() + iProng * NCovProng);
+  }
+  return fit;
+}
+
+/// Secondary-vertex fit read from a row of the HfSvFit2Prong or HfSvFit3Prong tables
+template <int N, typename TRow>
+SvFit<N> fromTable(TRow const& row)
+{
+  SvFit<N> fit;
+  fit.position = {row.xSvFit(), row.ySvFit(), row.zSvFit()};
+  fit.chi2PCA = row.chi2PCASvFit();
+  for (int i = 0; i < 6; ++i) {
+    fit.cov[i] = row.covSvFit()[i];
+  }
+  for (int i = 0; i < N * NParProng; ++i) {
+    fit.parProngs[i] = row.parProngsSvFit()[i];
+  }
+  for (int i = 0; i < N * NCovProng; ++i) {
+    fit.covProngs[i] = row.covProngsSvFit()[i];
+  }
+  return fit;
+}
+
+/// Prong of a secondary-vertex fit, propagated to the secondary vertex
+template <int N>
+o2::track::TrackParCov getProng(SvFit<N> const& fit, int iProng)
+{
+  const auto* par = &fit.parProngs[iProng * NParProng];
+  std::array<float, 5> params;
+  std::array<float, NCovProng> cov;
+  std::copy(par + 2, par + NParProng, params.begin());
+  std::copy(fit.covProngs.begin() + iProng * NCovProng, fit.covProngs.begin() + (iProng + 1) * NCovProng, cov.begin());
+  return o2::track::TrackParCov(par[0], par[1], params, cov);
+}
+
+} // namespace o2::hf_sv_fit
+
+#endif // PWGHF_UTILS_UTILSSVFIT_H_
@@ -0,0 +1,143 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file EventConstituentSubtractor.h
+/// \brief Event-wide constituent subtraction with the ghosts on a fixed rapidity-phi grid
+///
+/// Same algorithm as the event-wide fastjet::contrib::ConstituentSubtractor: the ghosts carry the background pT rho * A,
+/// the particle-ghost pairs closer than rMax are sorted by pT^alpha * deltaR and the pT of the closest pairs is exchanged
+/// until either of the two is exhausted. The ghosts are the centres of the cells of a grid of area about the ghost area,
+/// built once, so that the ghosts close to a particle are found from the cells within rMax of the particle instead of a
+/// search over all the ghosts. The ghosts are not scattered randomly and the mass density rho_m is not subtracted.
+/// The subtracted particles keep their rapidity and phi, their four-momentum is scaled by their remaining pT fraction.
+
+#ifndef O2_ANALYSIS_EVENTCONSTITUENTSUBTRACTOR_H
+#define O2_ANALYSIS_EVENTCONSTITUENTSUBTRACTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "fastjet/PseudoJet.hh"
+
+class EventConstituentSubtractor
+{
+ public:
+  /// Sets up the ghost grid
+  /// \param maxRap rapidity range of the ghosts, the particles outside are removed
+  /// \param ghostArea target area of the ghosts, the cells of the grid have about this size
+  /// \param rMax maximum deltaR between a particle and the ghosts it is subtracted from
+  /// \param alpha exponent of the particle pT in the pair distance
+  void setup(double maxRap, double ghostArea, double rMax, double alpha)
+  {
+    mMaxRap = maxRap;
+    mRMax = rMax;
+    mAlpha = alpha;
+    const double cellSize = std::sqrt(ghostArea);
+    mNRap = std::max(1, static_cast<int>(std::ceil(2. * maxRap / cellSize)));
+    mNPhi = std::max(1, static_cast<int>(std::ceil(2. * M_PI / cellSize)));
+    mRapStep = 2. * maxRap / mNRap;
+    mPhiStep = 2. * M_PI / mNPhi;
+  }
+
+  /// Area of the ghosts of the grid
+  double getGhostArea() const { return mRapStep * mPhiStep; }
+
+  /// Subtracts the background from the particles of an event
+  /// \param particles input particles of the event
+  /// \param rho background pT density of the event
+  /// \param subtracted vector of the subtracted particles to be filled, with the user indices of the input particles
+  void subtract(const std::vector<fastjet::PseudoJet>& particles, double rho, std::vector<fastjet::PseudoJet>& subtracted)
+  {
+    subtracted.clear();
+    ghostPt.assign(mNRap * mNPhi, rho * getGhostArea());
+    particlePt.assign(particles.size(), 0.);
+    pairs.clear();
+
+    const int nPhiCells = std::min(mNPhi / 2, static_cast<int>(std::ceil(mRMax / mPhiStep)));
+    const double rMax2 = mRMax * mRMax;
+    for (std::size_t i = 0; i < particles.size(); i++) {
+      const auto& particle = particles[i];
+      const double rap = particle.rap();
+      if (std::abs(rap) >= mMaxRap) {
+        continue;
+      }
+      particlePt[i] = particle.pt();
+      const double phi = particle.phi();
+      const double weight = mAlpha != 0. ? std::pow(particlePt[i], mAlpha) : 1.;
+      const int iRapMin = std::max(0, static_cast<int>(std::floor((rap - mRMax + mMaxRap) / mRapStep)));
+      const int iRapMax = std::min(mNRap - 1, static_cast<int>(std::floor((rap + mRMax + mMaxRap) / mRapStep)));
+      const int iPhiCentre = static_cast<int>(phi / mPhiStep);
+      // the phi cells are visited once each when rMax covers the full azimuth
+      const int iPhiMax = (2 * nPhiCells + 1 >= mNPhi) ? iPhiCentre - nPhiCells + mNPhi - 1 : iPhiCentre + nPhiCells;
+      for (int iRap = iRapMin; iRap <= iRapMax; iRap++) {
+        const double dRap = rap - (-mMaxRap + (iRap + 0.5) * mRapStep);
+        for (int iPhiCell = iPhiCentre - nPhiCells; iPhiCell <= iPhiMax; iPhiCell++) {
+          const int iPhi = ((iPhiCell % mNPhi) + mNPhi) % mNPhi;
+          double dPhi = std::abs(phi - (iPhi + 0.5) * mPhiStep);
+          if (dPhi > M_PI) {
+            dPhi = 2. * M_PI - dPhi;
+          }
+          const double dR2 = dRap * dRap + dPhi * dPhi;
+          if (dR2 <= rMax2) {
+            pairs.push_back({weight * std::sqrt(dR2), static_cast<int>(i), iRap * mNPhi + iPhi});
+          }
+        }
+      }
+    }
+
+    std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) { return a.distance < b.distance || (a.distance == b.distance && (a.particle < b.particle || (a.particle == b.particle && a.ghost < b.ghost))); });
+    for (const auto& pair : pairs) {
+      double& pt = particlePt[pair.particle];
+      double& ghost = ghostPt[pair.ghost];
+      if (pt <= 0. || ghost <= 0.) {
+        continue;
+      }
+      if (pt > ghost) {
+        pt -= ghost;
+        ghost = 0.;
+      } else {
+        ghost -= pt;
+        pt = 0.;
+      }
+    }
+
+    for (std::size_t i = 0; i < particles.size(); i++) {
+      if (particlePt[i] > 0.) {
+        subtracted.push_back(particles[i] * (particlePt[i] / particles[i].pt()));
+        subtracted.back().set_user_index(particles[i].user_index());
+      }
+    }
+  }
+
+ private:
+  /// Particle-ghost pair closer than rMax
+  struct Pair {
+    double distance; // pT^alpha * deltaR
+    int particle;
+    int ghost;
+  };
+
+  double mMaxRap = 0.9;
+  double mRMax = 0.6;
+  double mAlpha = 1.;
+  int mNRap = 1;
+  int mNPhi = 1;
+  double mRapStep = 1.8;
+  double mPhiStep = 2. * M_PI;
+
+  // buffers reused across events
+  std::vector<double> ghostPt;
+  std::vector<double> particlePt;
+  std::vector<Pair> pairs;
+};
+
+#endif
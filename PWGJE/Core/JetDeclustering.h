@@ -0,0 +1,113 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file JetDeclustering.h
+/// \brief Cambridge/Aachen declustering of jets along their primary Lund plane
+///
+/// The constituents of a jet are reclustered without area and the harder branch is followed from the jet down,
+/// recording each splitting once. Grooming observables, e.g. soft drop, are then evaluated on the recorded splittings.
+
+#ifndef O2_ANALYSIS_JETDECLUSTERING_H
+#define O2_ANALYSIS_JETDECLUSTERING_H
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "fastjet/PseudoJet.hh"
+#include "fastjet/ClusterSequence.hh"
+#include "fastjet/JetDefinition.hh"
+
+/// Splitting of the primary Lund plane of a jet
+struct LundSplitting {
+  float deltaR; // angle between the two branches
+  float kt;     // transverse momentum of the softer branch relative to the harder one, pT,soft * deltaR
+  float z;      // momentum fraction of the softer branch, pT,soft / (pT,soft + pT,hard)
+  float pt;     // transverse momentum of the splitting branch
+};
+
+/// Soft drop result of a declustered jet
+struct SoftDropResult {
+  float zg = -1.; // momentum fraction of the first splitting passing the soft drop condition, -1 if none
+  float rg = -1.; // angle of the first splitting passing the soft drop condition, -1 if none
+  int nsd = 0;    // number of splittings passing the soft drop condition
+};
+
+class JetDeclustering
+{
+ public:
+  /// \param reclusteringR jet resolution parameter of the reclustering, large enough to recluster all the constituents into one jet
+  JetDeclustering(double reclusteringR = 1.0) : jetDef(fastjet::cambridge_algorithm, reclusteringR) {}
+
+  void setReclusteringR(double reclusteringR) { jetDef = fastjet::JetDefinition(fastjet::cambridge_algorithm, reclusteringR); }
+
+  /// Reclusters the constituents of a jet and records its primary Lund plane
+  /// \param constituents vector of the jet constituents
+  /// \return splittings from the jet down, valid until the next call
+  const std::vector<LundSplitting>& decluster(const std::vector<fastjet::PseudoJet>& constituents)
+  {
+    splittings.clear();
+    if (constituents.empty()) {
+      return splittings;
+    }
+    fastjet::ClusterSequence clusterSeq(constituents, jetDef);
+    // the hardest reclustered jet, no sorting needed
+    auto reclustered = clusterSeq.inclusive_jets();
+    const fastjet::PseudoJet* jet = &reclustered[0];
+    for (const auto& candidate : reclustered) {
+      if (candidate.perp2() > jet->perp2()) {
+        jet = &candidate;
+      }
+    }
+    fastjet::PseudoJet daughterSubJet = *jet;
+    fastjet::PseudoJet parentSubJet1;
+    fastjet::PseudoJet parentSubJet2;
+    while (daughterSubJet.has_parents(parentSubJet1, parentSubJet2)) {
+      if (parentSubJet1.perp() < parentSubJet2.perp()) {
+        std::swap(parentSubJet1, parentSubJet2);
+      }
+      auto ptSoft = parentSubJet2.perp();
+      auto r = parentSubJet1.delta_R(parentSubJet2);
+      splittings.push_back({static_cast<float>(r), static_cast<float>(ptSoft * r),
+                            static_cast<float>(ptSoft / (parentSubJet1.perp() + ptSoft)), static_cast<float>(daughterSubJet.perp())});
+      daughterSubJet = parentSubJet1;
+    }
+    return splittings;
+  }
+
+  /// Recorded splittings of the last declustered jet
+  const std::vector<LundSplitting>& getSplittings() const { return splittings; }
+
+  /// Soft drop on the recorded splittings: z >= zCut (deltaR / jetR)^beta
+  /// \param zCut soft drop z cut
+  /// \param beta soft drop angular exponent
+  /// \param jetR jet resolution parameter of the jet
+  SoftDropResult softDrop(float zCut, float beta, float jetR) const
+  {
+    SoftDropResult result;
+    for (const auto& splitting : splittings) {
+      if (splitting.z >= zCut * std::pow(splitting.deltaR / jetR, beta)) {
+        if (result.nsd == 0) {
+          result.zg = splitting.z;
+          result.rg = splitting.deltaR;
+        }
+        result.nsd++;
+      }
+    }
+    return result;
+  }
+
+ private:
+  fastjet::JetDefinition jetDef;         // Cambridge/Aachen reclustering, without area
+  std::vector<LundSplitting> splittings; // primary Lund plane of the last declustered jet, reused across jets
+};
+
+#endif
@@ -15,6 +15,8 @@
 #include "PWGJE/Core/JetFinder.h"
 #include "Framework/Logger.h"
 
+#include <algorithm>
+
 /// Sets the jet finding parameters
 void JetFinder::setParams()
 {
@@ -38,8 +40,14 @@ void JetFinder::setParams()
 /// Sets the background subtraction estimater pointer
 void JetFinder::setBkgE()
 {
-  if (bkgSubMode == BkgSubMode::rhoAreaSub || bkgSubMode == BkgSubMode::constSub) {
-    bkgE = decltype(bkgE)(new fastjet::JetMedianBackgroundEstimator(selRho, jetDefBkg, areaDefBkg));
+  if ((bkgSubMode == BkgSubMode::rhoAreaSub || bkgSubMode == BkgSubMode::constSub || bkgSubMode == BkgSubMode::constSubBinned) && bkgEstimatorMode == BkgEstimatorMode::gridMedian) {
+    // the tiles outside the phi range of the background are removed by the selector, applied to the tile centres
+    fastjet::RectangularGrid grid(bkgEtaMin, bkgEtaMax, bkgGridSpacing, bkgGridSpacing, fastjet::SelectorPhiRange(bkgPhiMin, bkgPhiMax));
+    bkgE = decltype(bkgE)(new fastjet::GridMedianBackgroundEstimator(grid));
+  } else if (bkgSubMode == BkgSubMode::rhoAreaSub || bkgSubMode == BkgSubMode::constSub || bkgSubMode == BkgSubMode::constSubBinned) {
+    auto jetMedianBkgE = new fastjet::JetMedianBackgroundEstimator(selRho, jetDefBkg, areaDefBkg);
+    jetMedianBkgE->set_compute_rho_m(doRhoMassSub);
+    bkgE = decltype(bkgE)(jetMedianBkgE);
   } else {
     if (bkgSubMode != BkgSubMode::none) {
       LOGF(error, "requested subtraction mode not implemented!");
@@ -53,6 +61,7 @@ void JetFinder::setSub()
   //if rho < 1e-6 it is set to 1e-6 in AliPhysics
   if (bkgSubMode == BkgSubMode::rhoAreaSub) {
     sub = decltype(sub){new fastjet::Subtractor{bkgE.get()}};
+    sub->set_use_rho_m(doRhoMassSub);
   } else if (bkgSubMode == BkgSubMode::constSub) { //event or jetwise
     constituentSub = decltype(constituentSub){new fastjet::contrib::ConstituentSubtractor{bkgE.get()}};
     constituentSub->set_distance_type(fastjet::contrib::ConstituentSubtractor::deltaR);
@@ -60,7 +69,17 @@ void JetFinder::setSub()
     constituentSub->set_alpha(constSubAlpha);
     constituentSub->set_ghost_area(ghostArea);
     constituentSub->set_max_eta(bkgEtaMax);
-    constituentSub->set_background_estimator(bkgE.get()); //what about rho_m
+    constituentSub->set_background_estimator(bkgE.get());
+    if (doRhoMassSub) {
+      constituentSub->set_common_bge_for_rho_and_rhom(true);
+      constituentSub->set_do_mass_subtraction(true);
+    }
+  } else if (bkgSubMode == BkgSubMode::constSubBinned) {
+    binnedConstituentSub = decltype(binnedConstituentSub){new EventConstituentSubtractor};
+    binnedConstituentSub->setup(bkgEtaMax, ghostArea, constSubRMax, constSubAlpha);
+    if (doRhoMassSub) {
+      LOGF(warning, "rho_m is not subtracted by the binned constituent subtraction");
+    }
   } else {
     if (bkgSubMode != BkgSubMode::none) {
       LOGF(error, "requested subtraction mode not implemented!");
@@ -85,9 +104,73 @@ fastjet::ClusterSequenceArea JetFinder::findJets(std::vector<fastjet::PseudoJet>
   }
   if (constituentSub) {
     inputParticles = constituentSub->subtract_event(inputParticles);
+  } else if (binnedConstituentSub) {
+    binnedConstituentSub->subtract(inputParticles, bkgE->rho(), subtractedParticles);
+    inputParticles = subtractedParticles;
   }
   fastjet::ClusterSequenceArea clusterSeq(inputParticles, jetDef, areaDef);
   jets = sub ? (*sub)(clusterSeq.inclusive_jets()) : clusterSeq.inclusive_jets();
   jets = selJets(jets);
   return clusterSeq;
 }
+
+
+/// Sets up the jet finding for the event loop
+/// \param radii jet resolution parameters
+void JetFinder::setup(std::vector<double> const& radii)
+{
+  radiusDefs.clear();
+  for (auto R : radii) {
+    jetR = R;
+    setParams();
+    radiusDefs.push_back({jetR, jetDef, selJets});
+  }
+  bkgE.reset();
+  sub.reset();
+  constituentSub.reset();
+  binnedConstituentSub.reset();
+  setBkgE();
+  setSub();
+  eventParticles = nullptr;
+}
+
+/// Sets the input particles of an event
+/// \param inputParticles vector of input particles/tracks
+void JetFinder::setEvent(const std::vector<fastjet::PseudoJet>& inputParticles)
+{
+  if (bkgE) {
+    bkgE->set_particles(inputParticles);
+  }
+  if (constituentSub) {
+    subtractedParticles = constituentSub->subtract_event(inputParticles);
+    eventParticles = &subtractedParticles;
+  } else if (binnedConstituentSub) {
+    binnedConstituentSub->subtract(inputParticles, bkgE->rho(), subtractedParticles);
+    eventParticles = &subtractedParticles;
+  } else {
+    eventParticles = &inputParticles;
+  }
+}
+
+/// Performs jet finding for one of the radii set up
+/// \param iR index of the jet radius
+/// \param jets vector of jets to be filled
+/// \param clusterSeq cluster sequence needed to access constituents
+void JetFinder::findJets(std::size_t iR, std::vector<fastjet::PseudoJet>& jets, std::unique_ptr<fastjet::ClusterSequence>& clusterSeq)
+{
+  jets.clear();
+  if (iR >= radiusDefs.size() || !eventParticles) {
+    LOGF(fatal, "jet finding requested for radius %zu, but %zu radii are set up and the event is %s", iR, radiusDefs.size(), eventParticles ? "set" : "not set");
+  }
+  auto const& radiusDef = radiusDefs[iR];
+  // the previous cluster sequence is released first, its jets are not used any more
+  clusterSeq.reset();
+  if (doArea || bkgSubMode == BkgSubMode::rhoAreaSub) {
+    clusterSeq.reset(new fastjet::ClusterSequenceArea(*eventParticles, radiusDef.jetDef, areaDef));
+  } else {
+    clusterSeq.reset(new fastjet::ClusterSequence(*eventParticles, radiusDef.jetDef));
+  }
+  jets = sub ? (*sub)(clusterSeq->inclusive_jets()) : clusterSeq->inclusive_jets();
+  // the jet selection is applied jet by jet, in place
+  jets.erase(std::remove_if(jets.begin(), jets.end(), [&radiusDef](const fastjet::PseudoJet& jet) { return !radiusDef.selJets.pass(jet); }), jets.end());
+}
@@ -25,22 +25,37 @@
 #include "fastjet/AreaDefinition.hh"
 #include "fastjet/JetDefinition.hh"
 #include "fastjet/tools/JetMedianBackgroundEstimator.hh"
+#include "fastjet/tools/GridMedianBackgroundEstimator.hh"
+#include "fastjet/RectangularGrid.hh"
 #include "fastjet/tools/Subtractor.hh"
 #include "fastjet/contrib/ConstituentSubtractor.hh"
+#include "PWGJE/Core/EventConstituentSubtractor.h"
 
+#include <memory>
 #include <vector>
 
 class JetFinder
 {
 
  public:
+  /// constSubBinned is the event-wide constituent subtraction with the ghosts on a fixed grid, see EventConstituentSubtractor
   enum class BkgSubMode { none,
                           rhoAreaSub,
-                          constSub };
+                          constSub,
+                          constSubBinned };
   BkgSubMode bkgSubMode;
 
   void setBkgSubMode(BkgSubMode bSM) { bkgSubMode = bSM; }
 
+  /// Estimation of the background density rho of the subtraction modes:
+  /// jetMedian is the median of the kT jets, which clusters the event a second time,
+  /// gridMedian is the median of the cells of an eta-phi grid, filled from the particles directly
+  enum class BkgEstimatorMode { jetMedian,
+                                gridMedian };
+  BkgEstimatorMode bkgEstimatorMode;
+
+  void setBkgEstimatorMode(BkgEstimatorMode bEM) { bkgEstimatorMode = bEM; }
+
   /// Performs jet finding
   /// \note the input particle and jet lists are passed by reference
   /// \param inputParticles vector of input particles/tracks
@@ -77,10 +92,14 @@ class JetFinder
   float bkgEtaMin;
   float bkgEtaMax;
 
+  float bkgGridSpacing; // eta and phi size of the cells of the grid median estimator
+  bool doRhoMassSub;    // subtract the background mass density rho_m as well
+
   float constSubAlpha;
   float constSubRMax;
 
   bool isReclustering;
+  bool doArea; // compute the jet areas, always done for the rho area subtraction
 
   fastjet::JetAlgorithm algorithm;
   fastjet::RecombinationScheme recombScheme;
@@ -102,6 +121,7 @@ class JetFinder
 
   /// Default constructor
   JetFinder(float eta_Min = -0.9, float eta_Max = 0.9, float phi_Min = 0.0, float phi_Max = 2 * M_PI) : bkgSubMode(BkgSubMode::none),
+                                                                                                        bkgEstimatorMode(BkgEstimatorMode::jetMedian),
                                                                                                         phiMin(phi_Min),
                                                                                                         phiMax(phi_Max),
                                                                                                         etaMin(eta_Min),
@@ -125,9 +145,12 @@ class JetFinder
                                                                                                         bkgPhiMax(phi_Max),
                                                                                                         bkgEtaMin(eta_Min),
                                                                                                         bkgEtaMax(eta_Max),
+                                                                                                        bkgGridSpacing(0.2),
+                                                                                                        doRhoMassSub(false),
                                                                                                         constSubAlpha(1.0),
                                                                                                         constSubRMax(0.6),
                                                                                                         isReclustering(false),
+                                                                                                        doArea(true),
                                                                                                         algorithm(fastjet::antikt_algorithm),
                                                                                                         recombScheme(fastjet::E_scheme),
                                                                                                         strategy(fastjet::Best),
@@ -161,14 +184,49 @@ class JetFinder
   /// \return ClusterSequenceArea object needed to access constituents
   fastjet::ClusterSequenceArea findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets); // ideally find a way of passing the cluster sequence as a reeference
 
+  /// Sets up the jet finding for the event loop: the jet definitions of all the radii and the background subtraction are built once
+  /// \note to be called again whenever a parameter is changed
+  /// \param radii jet resolution parameters, the other parameters are the ones of the jet finder
+  void setup(std::vector<double> const& radii);
+
+  /// Number of jet radii set up
+  std::size_t getNRadii() const { return radiusDefs.size(); }
+
+  /// Jet resolution parameter set up at a given index
+  double getRadius(std::size_t iR) const { return radiusDefs[iR].jetR; }
+
+  /// Sets the input particles of an event, shared by the jet finding of all the radii
+  /// \note the background is estimated and the constituents are subtracted once per event. The input particles are not copied
+  /// and must stay untouched until the jets of the event are found
+  /// \param inputParticles vector of input particles/tracks
+  void setEvent(const std::vector<fastjet::PseudoJet>& inputParticles);
+
+  /// Performs jet finding for one of the radii set up, on the input particles of the event
+  /// \param iR index of the jet radius
+  /// \param jets vector of jets to be filled
+  /// \param clusterSeq cluster sequence needed to access constituents, with area only when the areas are computed
+  void findJets(std::size_t iR, std::vector<fastjet::PseudoJet>& jets, std::unique_ptr<fastjet::ClusterSequence>& clusterSeq);
+
  private:
+  /// Jet definition and jet selection of one jet radius
+  struct RadiusDefinition {
+    double jetR;
+    fastjet::JetDefinition jetDef;
+    fastjet::Selector selJets;
+  };
+
   // void setParams();
   // void setBkgSub();
   std::unique_ptr<fastjet::BackgroundEstimatorBase> bkgE;
   std::unique_ptr<fastjet::Subtractor> sub;
   std::unique_ptr<fastjet::contrib::ConstituentSubtractor> constituentSub;
+  std::unique_ptr<EventConstituentSubtractor> binnedConstituentSub;
+
+  std::vector<RadiusDefinition> radiusDefs;                //! definitions of the radii set up
+  const std::vector<fastjet::PseudoJet>* eventParticles{}; //! particles of the event being clustered
+  std::vector<fastjet::PseudoJet> subtractedParticles;     //! buffer of the constituent subtracted particles
 
-  ClassDefNV(JetFinder, 1);
+  ClassDefNV(JetFinder, 2);
 };
 
 // does this belong here?
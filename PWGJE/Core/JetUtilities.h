@@ -17,6 +17,7 @@
 #ifndef O2_ANALYSIS_JETUTILITIES_H
 #define O2_ANALYSIS_JETUTILITIES_H
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <numeric>
@@ -223,6 +224,254 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometricallyImpl(
   return std::make_tuple(baseToTagMap, tagToBaseMap);
 }
 
+/**
+ * Uniform (eta, phi) grid of points for geometrical matching, with phi periodic.
+ *
+ * The points are sorted into cells of at least the matching distance, so that a query only looks at the
+ * neighbouring cells. The grid keeps its buffers, so it can be rebuilt for every collision without allocating.
+ * Distances are sqrt(deltaEta^2 + deltaPhi^2), with deltaPhi taken across the 0 - 2pi boundary.
+ */
+template <typename T>
+class EtaPhiGrid
+{
+ public:
+  /**
+   * Builds the grid.
+   *
+   * @param eta Points eta.
+   * @param phi Points phi, any range.
+   * @param n Number of points.
+   * @param cellSize Minimum cell size in eta and phi, usually the maximum matching distance.
+   */
+  void Build(const T* eta, const T* phi, std::size_t n, double cellSize)
+  {
+    mN = n;
+    if (n == 0) {
+      return;
+    }
+    if (!(cellSize > 0.)) {
+      cellSize = 2 * M_PI;
+    }
+    T etaMin = eta[0];
+    T etaMax = eta[0];
+    for (std::size_t i = 1; i < n; i++) {
+      etaMin = std::min(etaMin, eta[i]);
+      etaMax = std::max(etaMax, eta[i]);
+    }
+    mEtaMin = etaMin;
+    // the number of cells is capped by the number of points, the cells are never smaller than cellSize
+    mNEta = std::clamp(static_cast<int>((etaMax - etaMin) / cellSize), 1, static_cast<int>(n));
+    mCellEta = etaMax > etaMin ? (etaMax - etaMin) / mNEta : cellSize;
+    mNPhi = std::max(1, static_cast<int>(2 * M_PI / cellSize));
+    mCellPhi = 2 * M_PI / mNPhi;
+
+    // counting sort of the points into the cells
+    mCellStart.assign(mNEta * mNPhi + 1, 0);
+    mCell.resize(n);
+    mPhi.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+      mPhi[i] = WrapPhi(phi[i]);
+      mCell[i] = CellEta(eta[i]) * mNPhi + CellPhi(mPhi[i]);
+      mCellStart[mCell[i] + 1]++;
+    }
+    for (std::size_t c = 1; c < mCellStart.size(); c++) {
+      mCellStart[c] += mCellStart[c - 1];
+    }
+    mSortedEta.resize(n);
+    mSortedPhi.resize(n);
+    mSortedIndex.resize(n);
+    mFill.assign(mCellStart.begin(), mCellStart.end() - 1);
+    for (std::size_t i = 0; i < n; i++) {
+      const int position = mFill[mCell[i]]++;
+      mSortedEta[position] = eta[i];
+      mSortedPhi[position] = mPhi[i];
+      mSortedIndex[position] = i;
+    }
+  }
+
+  /**
+   * Finds the k closest points within the maximum distance.
+   *
+   * @param eta Query eta.
+   * @param phi Query phi, any range.
+   * @param maxDistance Maximum distance, excluded.
+   * @param k Number of closest points.
+   * @param indices Filled with the indices of the closest points by increasing distance, -1 when fewer points are found.
+   * @param distances Filled with the distances of the closest points, if not null.
+   *
+   * @returns Number of points found.
+   */
+  int FindNearest(T eta, T phi, double maxDistance, int k, int* indices, T* distances = nullptr) const
+  {
+    std::fill_n(indices, k, -1);
+    if (mN == 0 || k <= 0) {
+      return 0;
+    }
+    // small sorted list of the k best candidates, k is typically a few
+    constexpr int kMaxMatches = 50;
+    k = std::min(k, kMaxMatches);
+    double best[kMaxMatches];
+    int found = 0;
+    phi = WrapPhi(phi);
+    const int iEta = static_cast<int>(std::floor((eta - mEtaMin) / mCellEta));
+    const int iPhi = CellPhi(phi);
+    const int ringsEta = static_cast<int>(std::ceil(maxDistance / mCellEta));
+    const int ringsPhi = static_cast<int>(std::ceil(maxDistance / mCellPhi));
+    const int eta0 = std::max(0, iEta - ringsEta);
+    const int eta1 = std::min(mNEta - 1, iEta + ringsEta);
+    // all the phi cells are visited once when the rings go around
+    const bool allPhi = 2 * ringsPhi + 1 >= mNPhi;
+    const int phi0 = allPhi ? 0 : iPhi - ringsPhi;
+    const int phi1 = allPhi ? mNPhi - 1 : iPhi + ringsPhi;
+    const double maxDistance2 = maxDistance * maxDistance;
+    for (int ie = eta0; ie <= eta1; ie++) {
+      for (int ip = phi0; ip <= phi1; ip++) {
+        const int cell = ie * mNPhi + (ip + mNPhi) % mNPhi;
+        for (int position = mCellStart[cell]; position < mCellStart[cell + 1]; position++) {
+          const double dEta = mSortedEta[position] - eta;
+          double dPhi = std::abs(mSortedPhi[position] - phi);
+          dPhi = std::min(dPhi, 2 * M_PI - dPhi);
+          const double distance2 = dEta * dEta + dPhi * dPhi;
+          if (distance2 >= maxDistance2 || (found == k && distance2 >= best[k - 1])) {
+            continue;
+          }
+          // insertion into the sorted candidates
+          int m = found < k ? found++ : k - 1;
+          while (m > 0 && best[m - 1] > distance2) {
+            best[m] = best[m - 1];
+            indices[m] = indices[m - 1];
+            m--;
+          }
+          best[m] = distance2;
+          indices[m] = mSortedIndex[position];
+        }
+      }
+    }
+    if (distances) {
+      for (int m = 0; m < found; m++) {
+        distances[m] = std::sqrt(best[m]);
+      }
+    }
+    return found;
+  }
+
+  std::size_t Size() const { return mN; }
+
+ private:
+  static T WrapPhi(T phi)
+  {
+    phi = std::fmod(phi, static_cast<T>(2 * M_PI));
+    return phi < 0 ? phi + static_cast<T>(2 * M_PI) : phi;
+  }
+  int CellEta(T eta) const { return std::clamp(static_cast<int>((eta - mEtaMin) / mCellEta), 0, mNEta - 1); }
+  int CellPhi(T phi) const { return std::clamp(static_cast<int>(phi / mCellPhi), 0, mNPhi - 1); }
+
+  std::size_t mN = 0;            // number of points
+  double mEtaMin = 0.;           // lower eta edge of the grid
+  double mCellEta = 1.;          // eta size of the cells
+  double mCellPhi = 2 * M_PI;    // phi size of the cells
+  int mNEta = 1;                 // number of eta cells
+  int mNPhi = 1;                 // number of phi cells
+  std::vector<int> mCellStart;   // first position of each cell in the sorted points, and the number of points at the end
+  std::vector<int> mFill;        // fill position of each cell while sorting
+  std::vector<int> mCell;        // cell of each point
+  std::vector<T> mPhi;           // phi of each point in [0, 2pi)
+  std::vector<T> mSortedEta;     // eta of the points in cell order
+  std::vector<T> mSortedPhi;     // phi of the points in cell order
+  std::vector<int> mSortedIndex; // input index of the points in cell order
+};
+
+/**
+ * Geometrical matching of two collections with grids, batch version.
+ *
+ * Same matching as `MatchJetsGeometrically`: each entry is matched to the closest entry of the other collection
+ * within the maximum distance, and only mutual matches are kept. The grids and the outputs are passed by
+ * the caller so that their buffers are reused across collisions.
+ *
+ * @param baseEta Base collection eta.
+ * @param basePhi Base collection phi.
+ * @param nBase Base collection size.
+ * @param tagEta Tag collection eta.
+ * @param tagPhi Tag collection phi.
+ * @param nTag Tag collection size.
+ * @param maxMatchingDistance Maximum matching distance.
+ * @param baseGrid Grid of the base collection.
+ * @param tagGrid Grid of the tag collection.
+ * @param baseToTagMap Filled with the index of the matched tag entry of each base entry, -1 if none.
+ * @param tagToBaseMap Filled with the index of the matched base entry of each tag entry, -1 if none.
+ */
+template <typename T>
+void MatchGeometrically(const T* baseEta, const T* basePhi, std::size_t nBase,
+                        const T* tagEta, const T* tagPhi, std::size_t nTag,
+                        double maxMatchingDistance, EtaPhiGrid<T>& baseGrid, EtaPhiGrid<T>& tagGrid,
+                        std::vector<int>& baseToTagMap, std::vector<int>& tagToBaseMap)
+{
+  baseToTagMap.assign(nBase, -1);
+  tagToBaseMap.assign(nTag, -1);
+  if (!(nBase && nTag)) {
+    return;
+  }
+  baseGrid.Build(baseEta, basePhi, nBase, maxMatchingDistance);
+  tagGrid.Build(tagEta, tagPhi, nTag, maxMatchingDistance);
+  // closest base entry of each tag entry, stored temporarily in tagToBaseMap
+  for (std::size_t iTag = 0; iTag < nTag; iTag++) {
+    baseGrid.FindNearest(tagEta[iTag], tagPhi[iTag], maxMatchingDistance, 1, &tagToBaseMap[iTag]);
+  }
+  for (std::size_t iBase = 0; iBase < nBase; iBase++) {
+    int iTag = -1;
+    tagGrid.FindNearest(baseEta[iBase], basePhi[iBase], maxMatchingDistance, 1, &iTag);
+    if (iTag >= 0 && tagToBaseMap[iTag] == static_cast<int>(iBase)) {
+      baseToTagMap[iBase] = iTag;
+    }
+  }
+  // only the true matches are kept, where the base entry is the closest to the tag entry and vice versa
+  for (std::size_t iTag = 0; iTag < nTag; iTag++) {
+    if (tagToBaseMap[iTag] >= 0 && baseToTagMap[tagToBaseMap[iTag]] != static_cast<int>(iTag)) {
+      tagToBaseMap[iTag] = -1;
+    }
+  }
+}
+
+/**
+ * Match clusters and tracks with grids, batch version.
+ *
+ * Same matching as `MatchClustersAndTracks`, with the matches stored flat: the matches of entry i are at
+ * [i * maxNumberMatches, (i + 1) * maxNumberMatches), by increasing distance and -1 when there are fewer.
+ *
+ * @param clusterEta Cluster collection eta.
+ * @param clusterPhi Cluster collection phi.
+ * @param nClusters Cluster collection size.
+ * @param trackEta Track collection eta.
+ * @param trackPhi Track collection phi.
+ * @param nTracks Track collection size.
+ * @param maxMatchingDistance Maximum matching distance.
+ * @param maxNumberMatches Maximum number of matches (e.g. 5 closest).
+ * @param clusterGrid Grid of the clusters.
+ * @param trackGrid Grid of the tracks.
+ * @param clusterToTrackMap Filled with the matched tracks of each cluster.
+ * @param trackToClusterMap Filled with the matched clusters of each track.
+ */
+template <typename T>
+void MatchClustersAndTracks(const T* clusterEta, const T* clusterPhi, std::size_t nClusters,
+                            const T* trackEta, const T* trackPhi, std::size_t nTracks,
+                            double maxMatchingDistance, int maxNumberMatches, EtaPhiGrid<T>& clusterGrid, EtaPhiGrid<T>& trackGrid,
+                            std::vector<int>& clusterToTrackMap, std::vector<int>& trackToClusterMap)
+{
+  clusterToTrackMap.assign(nClusters * maxNumberMatches, -1);
+  trackToClusterMap.assign(nTracks * maxNumberMatches, -1);
+  if (!(nClusters && nTracks)) {
+    return;
+  }
+  clusterGrid.Build(clusterEta, clusterPhi, nClusters, maxMatchingDistance);
+  trackGrid.Build(trackEta, trackPhi, nTracks, maxMatchingDistance);
+  for (std::size_t iCluster = 0; iCluster < nClusters; iCluster++) {
+    trackGrid.FindNearest(clusterEta[iCluster], clusterPhi[iCluster], maxMatchingDistance, maxNumberMatches, &clusterToTrackMap[iCluster * maxNumberMatches]);
+  }
+  for (std::size_t iTrack = 0; iTrack < nTracks; iTrack++) {
+    clusterGrid.FindNearest(trackEta[iTrack], trackPhi[iTrack], maxMatchingDistance, maxNumberMatches, &trackToClusterMap[iTrack * maxNumberMatches]);
+  }
+}
+
 /**
  * Geometrical jet matching.
  *
@@ -263,17 +512,11 @@ std::tuple<std::vector<int>, std::vector<int>> MatchJetsGeometrically(
     throw std::invalid_argument("Tag collection eta and phi sizes don't match. Check the inputs.");
   }
 
-  // To perform matching with periodic boundary conditions (ie. phi) with a KDTree, we need
-  // to duplicate data up to maxMatchingDistance in phi because phi is periodic.
-  // NOTE: vectors are modified in place to avoid copies.
-  auto&& [jetMapBaseToJetIndex, jetsBasePhiComparison, jetsBaseEtaComparison] = DuplicateJetsAroundPhiBoundary(jetsBasePhi, jetsBaseEta, maxMatchingDistance);
-  auto&& [jetMapTagToJetIndex, jetsTagPhiComparison, jetsTagEtaComparison] = DuplicateJetsAroundPhiBoundary(jetsTagPhi, jetsTagEta, maxMatchingDistance);
-
-  // Finally, perform the actual matching.
-  auto&& [baseToTagMap, tagToBaseMap] = MatchJetsGeometricallyImpl(
-    jetsBasePhi, jetsBaseEta, jetsBasePhiComparison, jetsBaseEtaComparison, jetMapBaseToJetIndex,
-    jetsTagPhi, jetsTagEta, jetsTagPhiComparison, jetsTagEtaComparison, jetMapTagToJetIndex,
-    maxMatchingDistance);
+  // The grids handle the periodic boundary conditions (ie. phi), no duplication of the jets is needed.
+  EtaPhiGrid<T> gridBase, gridTag;
+  std::vector<int> baseToTagMap, tagToBaseMap;
+  MatchGeometrically(jetsBaseEta.data(), jetsBasePhi.data(), nJetsBase, jetsTagEta.data(), jetsTagPhi.data(), nJetsTag,
+                     maxMatchingDistance, gridBase, gridTag, baseToTagMap, tagToBaseMap);
 
   return std::make_tuple(baseToTagMap, tagToBaseMap);
 }
@@ -319,67 +562,21 @@ std::tuple<std::vector<std::vector<int>>, std::vector<std::vector<int>>> MatchCl
     throw std::invalid_argument("track collection eta and phi sizes don't match. Check the inputs.");
   }
 
-  // for (std::size_t iTrack = 0; iTrack < nTracks; iTrack++) {
-  //   if (trackEta[iTrack] == 0)
-  //     LOG(warning) << "Track eta is 0!";
-  // }
-
-  // Build the KD-trees using vectors
-  // We build two trees:
-  // treeBase, which contains the base collection.
-  // treeTag, which contains the tag collection.
-  // The trees are built to match in two dimensions (eta, phi)
-  TKDTree<int, T> treeCluster(clusterEta.size(), 2, 1), treeTrack(trackEta.size(), 2, 1);
-  // By utilizing SetData, we can avoid having to copy the data again.
-  treeCluster.SetData(0, clusterEta.data());
-  treeCluster.SetData(1, clusterPhi.data());
-  treeCluster.Build();
-  treeTrack.SetData(0, trackEta.data());
-  treeTrack.SetData(1, trackPhi.data());
-  treeTrack.Build();
+  EtaPhiGrid<T> gridCluster, gridTrack;
+  std::vector<int> clusterToTrackMap, trackToClusterMap;
+  MatchClustersAndTracks(clusterEta.data(), clusterPhi.data(), nClusters, trackEta.data(), trackPhi.data(), nTracks,
+                         maxMatchingDistance, maxNumberMatches, gridCluster, gridTrack, clusterToTrackMap, trackToClusterMap);
 
   // Storage for the cluster matching indices.
-  std::vector<std::vector<int>> matchIndexTrack(nClusters, std::vector<int>(maxNumberMatches, -1));
-  std::vector<std::vector<int>> matchIndexCluster(nTracks, std::vector<int>(maxNumberMatches, -1));
-
-  // Find the track closest to each cluster.
+  std::vector<std::vector<int>> matchIndexTrack(nClusters);
+  std::vector<std::vector<int>> matchIndexCluster(nTracks);
   for (std::size_t iCluster = 0; iCluster < nClusters; iCluster++) {
-    T point[2] = {clusterEta[iCluster], clusterPhi[iCluster]};
-    int index[50];  // size 50 for safety
-    T distance[50]; // size 50 for safery
-    std::fill_n(index, 50, -1);
-    std::fill_n(distance, 50, std::numeric_limits<T>::max());
-    treeTrack.FindNearestNeighbors(point, maxNumberMatches, index, distance);
-    // test whether indices are matching:
-    matchIndexTrack[iCluster] = std::vector<int>(maxNumberMatches);
-    for (int m = 0; m < maxNumberMatches; m++) {
-      if (index[m] >= 0 && distance[m] < maxMatchingDistance) {
-        matchIndexTrack[iCluster][m] = index[m];
-      } else {
-        // no match or no more matches found, fill -1
-        matchIndexTrack[iCluster][m] = -1;
-      }
-    }
+    auto first = clusterToTrackMap.begin() + iCluster * maxNumberMatches;
+    matchIndexTrack[iCluster].assign(first, first + maxNumberMatches);
   }
-
-  // Find the base jet closest to each tag jet
   for (std::size_t iTrack = 0; iTrack < nTracks; iTrack++) {
-    T point[2] = {trackEta[iTrack], trackPhi[iTrack]};
-    int index[50];  // size 50 for safety
-    T distance[50]; // size 50 for safery
-    std::fill_n(index, 50, -1);
-    std::fill_n(distance, 50, std::numeric_limits<T>::max());
-    treeCluster.FindNearestNeighbors(point, maxNumberMatches, index, distance);
-    matchIndexCluster[iTrack] = std::vector<int>(maxNumberMatches);
-    // loop over maxNumberMatches closest matches
-    for (int m = 0; m < maxNumberMatches; m++) {
-      if (index[m] >= 0 && distance[m] < maxMatchingDistance) {
-        matchIndexCluster[iTrack][m] = index[m];
-      } else {
-        // no match jet or no more matches found, fill -1
-        matchIndexCluster[iTrack][m] = -1;
-      }
-    }
+    auto first = trackToClusterMap.begin() + iTrack * maxNumberMatches;
+    matchIndexCluster[iTrack].assign(first, first + maxNumberMatches);
   }
   return std::make_tuple(matchIndexTrack, matchIndexCluster);
 }
@@ -0,0 +1,77 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// Table definitions for skimmed EMCAL cells
+//
+// The EMCAL cells of aod::Calos are stored with quantized amplitude and time, sorted by tower within each BC,
+// so that the EMCAL tasks read a fraction of the calorimeter volume.
+
+#ifndef O2_ANALYSIS_DATAMODEL_EMCALCELLS
+#define O2_ANALYSIS_DATAMODEL_EMCALCELLS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace emcalcell
+{
+/// Quantization of the float columns: value = binned_min + bin_width * binned, clamped to the range of binned_t
+struct binningAmplitude {
+  typedef uint16_t binned_t;
+  static constexpr float binned_min = 0.f;
+  static constexpr float bin_width = 0.002f; // 2 MeV, up to 131 GeV
+};
+struct binningTime {
+  typedef uint16_t binned_t;
+  static constexpr float binned_min = -1638.4f;
+  static constexpr float bin_width = 0.05f; // 50 ps, from -1638.4 ns to 1638.3 ns
+};
+
+/// Quantized value of a float column
+template <typename binningType>
+typename binningType::binned_t pack(float value)
+{
+  constexpr float maxBin = static_cast<float>(std::numeric_limits<typename binningType::binned_t>::max());
+  const float bin = std::round((value - binningType::binned_min) / binningType::bin_width);
+  return static_cast<typename binningType::binned_t>(std::clamp(bin, 0.f, maxBin));
+}
+
+/// Float value of a quantized column
+template <typename binningType>
+float unpack(typename binningType::binned_t binned)
+{
+  return binningType::binned_min + binningType::bin_width * static_cast<float>(binned);
+}
+
+DECLARE_SOA_INDEX_COLUMN(BC, bc);                                               //! bunch crossing ID of the cell
+DECLARE_SOA_INDEX_COLUMN(Calo, calo);                                           //! original cell in aod::Calos
+DECLARE_SOA_COLUMN(CellNumber, cellNumber, int16_t);                            //! tower ID
+DECLARE_SOA_COLUMN(AmplitudeStore, amplitudeStore, binningAmplitude::binned_t); //! quantized cell amplitude
+DECLARE_SOA_COLUMN(TimeStore, timeStore, binningTime::binned_t);                //! quantized cell time
+DECLARE_SOA_COLUMN(CellType, cellType, int8_t);                                 //! cell type (high gain, low gain, ...)
+DECLARE_SOA_DYNAMIC_COLUMN(Amplitude, amplitude,                                //! cell amplitude (GeV)
+                           [](binningAmplitude::binned_t binned) -> float { return unpack<binningAmplitude>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(Time, time,                                          //! cell time (ns)
+                           [](binningTime::binned_t binned) -> float { return unpack<binningTime>(binned); });
+} // namespace emcalcell
+
+// EMCAL cells of aod::Calos, sorted by tower within each BC
+DECLARE_SOA_TABLE(EMCALPackedCells, "AOD", "EMCALPACKEDCELL", //!
+                  o2::soa::Index<>, emcalcell::BCId, emcalcell::CaloId, emcalcell::CellNumber,
+                  emcalcell::AmplitudeStore, emcalcell::TimeStore, emcalcell::CellType,
+                  emcalcell::Amplitude<emcalcell::AmplitudeStore>, emcalcell::Time<emcalcell::TimeStore>);
+using EMCALPackedCell = EMCALPackedCells::iterator;
+} // namespace o2::aod
+#endif
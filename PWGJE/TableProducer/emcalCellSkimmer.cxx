@@ -0,0 +1,70 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+// EMCAL cell skimmer
+//
+// Stores the EMCAL cells of aod::Calos in the EMCALPackedCells table, with quantized amplitude and time and
+// sorted by tower within each BC, for the EMCAL correction and monitoring tasks.
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/AnalysisTask.h"
+#include "Framework/AnalysisDataModel.h"
+#include "Framework/ASoA.h"
+
+#include "PWGJE/DataModel/EMCALCells.h"
+
+using namespace o2;
+using namespace o2::framework;
+
+struct EmcalCellSkimmer {
+  Produces<o2::aod::EMCALPackedCells> packedCells;
+
+  // 1 corresponds to EMCAL cells based on the Run2 definition.
+  Configurable<int> selectedCellType{"selectedCellType", 1, "EMCAL Cell type"};
+  Configurable<float> minCellAmplitude{"minCellAmplitude", 0.f, "Minimum cell amplitude (GeV) of the stored cells"};
+
+  std::vector<std::pair<int, int>> mSelected; // tower and position in the BC of the selected cells
+
+  void process(aod::BC const& bc, aod::Calos const& cells)
+  {
+    mSelected.clear();
+    int position = 0;
+    for (const auto& cell : cells) {
+      if (cell.caloType() == selectedCellType && cell.amplitude() >= minCellAmplitude) {
+        mSelected.emplace_back(cell.cellNumber(), position);
+      }
+      position++;
+    }
+    if (mSelected.empty()) {
+      return;
+    }
+    // sorted by tower, and by position for cells of the same tower
+    std::sort(mSelected.begin(), mSelected.end());
+    packedCells.reserve(mSelected.size());
+    for (const auto& [tower, selected] : mSelected) {
+      auto cell = cells.begin() + selected;
+      packedCells(bc.globalIndex(), cell.globalIndex(), tower,
+                  aod::emcalcell::pack<aod::emcalcell::binningAmplitude>(cell.amplitude()),
+                  aod::emcalcell::pack<aod::emcalcell::binningTime>(cell.time()),
+                  cell.cellType());
+    }
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{
+    adaptAnalysisTask<EmcalCellSkimmer>(cfgc, TaskName{"emcal-cell-skimmer"})};
+}
@@ -15,6 +15,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <thread>
+#include <type_traits>
 
 #include "CCDB/BasicCCDBManager.h"
 #include "Framework/runDataProcessing.h"
@@ -25,6 +28,7 @@
 #include "DetectorsBase/GeometryManager.h"
 
 #include "PWGJE/DataModel/EMCALClusters.h"
+#include "PWGJE/DataModel/EMCALCells.h"
 
 #include "DataFormatsEMCAL/Cell.h"
 #include "DataFormatsEMCAL/Constants.h"
@@ -52,6 +56,8 @@ struct EmcalCorrectionTask {
   Configurable<int> selectedCellType{"selectedCellType", 1, "EMCAL Cell type"};
   Configurable<std::string> clusterDefinitions{"clusterDefinition", "kV3Default", "cluster definition to be selected, e.g. V3Default. Multiple definitions can be specified separated by comma"};
   Configurable<float> maxMatchingDistance{"maxMatchingDistance", 0.4f, "Max matching distance track-cluster"};
+  Configurable<bool> parallelClusterDefinitions{"parallelClusterDefinitions", false, "Run the cluster definitions on separate threads, sharing the cells of the BC"};
+  Configurable<int> minCellsParallel{"minCellsParallel", 200, "Minimum number of cells of a BC to run the cluster definitions on separate threads"};
 
   // CDB service (for geometry)
   Service<o2::ccdb::BasicCCDBManager> mCcdbManager;
@@ -63,9 +69,26 @@ struct EmcalCorrectionTask {
   std::vector<std::unique_ptr<o2::emcal::ClusterFactory<o2::emcal::Cell>>> mClusterFactories;
   // Cells and clusters
   std::vector<o2::emcal::Cell> mEmcalCells;
-  // map of cellId (local in BC) to global cell index in cell table in AO2D
-  std::map<int, int64_t> mCellIdToCellGlobalIndex;
-  std::vector<o2::emcal::AnalysisCluster> mAnalysisClusters;
+  // global cell index in cell table in AO2D of each cellId (local in BC)
+  std::vector<int64_t> mCellIdToCellGlobalIndex;
+  // positions of the tracks of the collision, filled once per BC for all the cluster definitions
+  std::vector<float> mTrackEta;
+  std::vector<float> mTrackPhi;
+  std::vector<int64_t> mTrackGlobalIndex;
+  // cluster-track matching, flat with maxNumberMatches entries per cluster
+  static constexpr int maxNumberMatches = 5;
+  // Clusters of one cluster definition in the BC, built independently of the other definitions
+  struct DefinitionClusters {
+    std::vector<o2::emcal::AnalysisCluster> analysisClusters;
+    // vertex corrected cluster positions, computed once per cluster and used for the matching and the tables
+    std::vector<float> clusterEta;
+    std::vector<float> clusterPhi;
+    JetUtilities::EtaPhiGrid<float> clusterGrid;
+    JetUtilities::EtaPhiGrid<float> trackGrid;
+    std::vector<int> clusterToTrackIndexMap;
+    std::vector<int> trackToClusterIndexMap;
+  };
+  std::vector<DefinitionClusters> mDefinitionClusters; // per cluster definition
 
   std::vector<o2::aod::EMCALClusterDefinition> mClusterDefinitions;
   // QA
@@ -126,6 +149,7 @@ struct EmcalCorrectionTask {
     if (mClusterizers.size() == 0) {
       LOG(error) << "No cluster definitions specified!";
     }
+    mDefinitionClusters.resize(mClusterizers.size());
 
     LOG(debug) << "Completed init!";
 
@@ -144,18 +168,37 @@ struct EmcalCorrectionTask {
   // void process(aod::BCs const& bcs, aod::Collision const& collision, aod::Calos const& cells)
 
   //  Appears to need the BC to be accessed to be available in the collision table...
-  void process(aod::BC const& bc, aod::Collisions const& collisions, aod::Tracks const& tracks, aod::Calos const& cells)
+  void processFull(aod::BC const& bc, aod::Collisions const& collisions, aod::Tracks const& tracks, aod::Calos const& cells)
+  {
+    processImpl(bc, collisions, tracks, cells);
+  }
+  PROCESS_SWITCH(EmcalCorrectionTask, processFull, "Clusterize the EMCAL cells of aod::Calos", true);
+
+  void processPacked(aod::BC const& bc, aod::Collisions const& collisions, aod::Tracks const& tracks, aod::EMCALPackedCells const& cells)
+  {
+    processImpl(bc, collisions, tracks, cells);
+  }
+  PROCESS_SWITCH(EmcalCorrectionTask, processPacked, "Clusterize the skimmed EMCAL cells of aod::EMCALPackedCells", false);
+
+  /// \param cells are the cells of aod::Calos or the skimmed EMCAL cells of aod::EMCALPackedCells
+  template <typename TCells>
+  void processImpl(aod::BC const& bc, aod::Collisions const& collisions, aod::Tracks const& tracks, TCells const& cells)
   {
     LOG(debug) << "Starting process.";
     // Convert aod::Calo to o2::emcal::Cell which can be used with the clusterizer.
     // In particular, we need to filter only EMCAL cells.
     mEmcalCells.clear();
     mCellIdToCellGlobalIndex.clear();
+    mEmcalCells.reserve(cells.size());
+    mCellIdToCellGlobalIndex.reserve(cells.size());
     int c = 0;
     for (auto& cell : cells) {
-      if (cell.caloType() != selectedCellType) {
-        LOG(debug) << "Rejected";
-        continue;
+      // the skimmed cells are all of the selected type
+      if constexpr (std::is_same_v<TCells, aod::Calos>) {
+        if (cell.caloType() != selectedCellType) {
+          LOG(debug) << "Rejected";
+          continue;
+        }
       }
       // LOG(debug) << "Cell E: " << cell.getEnergy();
       // LOG(debug) << "Cell E: " << cell;
@@ -164,8 +207,12 @@ struct EmcalCorrectionTask {
         cell.amplitude(),
         cell.time(),
         o2::emcal::intToChannelType(cell.cellType())));
-      mCellIdToCellGlobalIndex.insert(std::make_pair(c, cell.globalIndex()));
-      LOG(debug) << "Creating map " << c << " -> " << cell.globalIndex();
+      if constexpr (std::is_same_v<TCells, aod::Calos>) {
+        mCellIdToCellGlobalIndex.push_back(cell.globalIndex());
+      } else {
+        mCellIdToCellGlobalIndex.push_back(cell.caloId());
+      }
+      LOG(debug) << "Creating map " << c << " -> " << mCellIdToCellGlobalIndex.back();
       c++;
     }
     LOG(debug) << "Number of cells (CF): " << mEmcalCells.size();
@@ -188,148 +235,169 @@ struct EmcalCorrectionTask {
       LOG(debug) << cell.getTower() << ": E: " << cell.getEnergy() << ", time: " << cell.getTimeStamp() << ", type: " << cell.getType();
     }
 
-    LOG(debug) << "Converted cells. Contains: " << mEmcalCells.size() << ". Originally " << cells.size() << ". About to run clusterizer.";
-    // this is a test
+    LOG(debug) << "Converted cells. Contains: " << mEmcalCells.size() << ". Originally " << cells.size() << ".";
+
+    // The collision and its tracks are the same for all the cluster definitions
+    float vx = 0, vy = 0, vz = 0;
+    bool hasCollision = false;
+    int64_t collisionIndex = -1;
+    mTrackEta.clear();
+    mTrackPhi.clear();
+    mTrackGlobalIndex.clear();
+    if (collisions.size() > 1) {
+      LOG(error) << "More than one collision in the bc. This is not supported.";
+    } else {
+      // dummy loop to get the first collision
+      for (const auto& col : collisions) {
+        vx = col.posX();
+        vy = col.posY();
+        vz = col.posZ();
+        hasCollision = true;
+        collisionIndex = col.globalIndex();
+
+        // store positions of all tracks of collision
+        auto groupedTracks = tracks.sliceBy(perCollision, col.globalIndex());
+        mTrackEta.reserve(groupedTracks.size());
+        mTrackPhi.reserve(groupedTracks.size());
+        mTrackGlobalIndex.reserve(groupedTracks.size());
+        for (auto& track : groupedTracks) {
+          // TODO this actually needs to use the eta phi
+          // of track propagated to EMC surface! Will be provided centrally according to Ruben
+          // TODO only consider tracks in current emcal/dcal acceptanc
+          mTrackPhi.emplace_back(TVector2::Phi_0_2pi(track.phi()));
+          mTrackEta.emplace_back(track.eta());
+          mTrackGlobalIndex.emplace_back(track.globalIndex());
+        }
+      }
+    }
+    if (!hasCollision) {
+      LOG(warning) << "No vertex found for event. Assuming (0,0,0).";
+    }
+
     // Run the clusterizers
+    // The cluster definitions only share the cells and the tracks of the BC, read-only, so they can run concurrently.
+    // The tables are written afterwards in the order of the definitions.
     LOG(debug) << "Running clusterizers";
-    Int_t i = 0;
-    for (auto& clusterizer : mClusterizers) {
-      clusterizer->findClusters(mEmcalCells);
-
-      auto emcalClusters = clusterizer->getFoundClusters();
-      auto emcalClustersInputIndices = clusterizer->getFoundClustersInputIndices();
-      LOG(debug) << "Retrieved results. About to setup cluster factory.";
-
-      // Convert to analysis clusters.
-      // First, the cluster factory requires cluster and cell information in order to build the clusters.
-      mAnalysisClusters.clear();
-      mClusterFactories.at(i)->reset();
-      mClusterFactories.at(i)->setClustersContainer(*emcalClusters);
-      mClusterFactories.at(i)->setCellsContainer(mEmcalCells);
-      mClusterFactories.at(i)->setCellsIndicesContainer(*emcalClustersInputIndices);
-
-      LOG(debug) << "Cluster factory set up.";
-      // Convert to analysis clusters.
-      for (int icl = 0; icl < mClusterFactories.at(i)->getNumberOfClusters(); icl++) {
-        auto analysisCluster = mClusterFactories.at(i)->buildCluster(icl);
-        mAnalysisClusters.emplace_back(analysisCluster);
-        LOG(debug) << "Cluster " << icl << ": E: " << analysisCluster.E() << ", NCells " << analysisCluster.getNCells();
+    const int nDefinitions = mClusterizers.size();
+    if (parallelClusterDefinitions && nDefinitions > 1 && static_cast<int>(mEmcalCells.size()) >= minCellsParallel) {
+      std::vector<std::thread> threads;
+      threads.reserve(nDefinitions - 1);
+      for (int i = 1; i < nDefinitions; i++) {
+        threads.emplace_back(&EmcalCorrectionTask::buildClusters, this, i, vx, vy, vz, hasCollision);
       }
-      LOG(debug) << "Converted to analysis clusters.";
-
-      float vx = 0, vy = 0, vz = 0;
-      bool hasCollision = false;
-      if (collisions.size() > 1) {
-        LOG(error) << "More than one collision in the bc. This is not supported.";
-      } else {
-        // dummy loop to get the first collision
-        for (const auto& col : collisions) {
-          vx = col.posX();
-          vy = col.posY();
-          vz = col.posZ();
-          hasCollision = true;
-
-          // store positions of all tracks of collision
-          auto groupedTracks = tracks.sliceBy(perCollision, col.globalIndex());
-
-          std::vector<double> trackPhi;
-          std::vector<double> trackEta;
-          std::vector<int64_t> trackGlobalIndex;
-          for (auto& track : groupedTracks) {
-            // TODO this actually needs to use the eta phi
-            // of track propagated to EMC surface! Will be provided centrally according to Ruben
-            // TODO only consider tracks in current emcal/dcal acceptanc
-            trackPhi.emplace_back(TVector2::Phi_0_2pi(track.phi()));
-            trackEta.emplace_back(track.eta());
-            trackGlobalIndex.emplace_back(track.globalIndex());
-          }
-
-          std::vector<double> clusterPhi;
-          std::vector<double> clusterEta;
-
-          // TODO one loop that could in principle be combined with the other loop to improve performance
-          for (const auto& cluster : mAnalysisClusters) {
-            // Determine the cluster eta, phi, correcting for the vertex position.
-            auto pos = cluster.getGlobalPosition();
-            pos = pos - math_utils::Point3D<float>{vx, vy, vz};
-            // Normalize the vector and rescale by energy.
-            pos *= (cluster.E() / std::sqrt(pos.Mag2()));
-            clusterPhi.emplace_back(TVector2::Phi_0_2pi(pos.Phi()));
-            clusterEta.emplace_back(pos.Eta());
-          }
-          auto&& [clusterToTrackIndexMap, trackToClusterIndexMap] = JetUtilities::MatchClustersAndTracks(clusterPhi, clusterEta, trackPhi, trackEta, maxMatchingDistance, 5);
-          // we found a collision, put the clusters into the none ambiguous table
-          clusters.reserve(mAnalysisClusters.size());
-          int cellindex = -1;
-
-          unsigned int k = 0;
-          for (const auto& cluster : mAnalysisClusters) {
-
-            // Determine the cluster eta, phi, correcting for the vertex position.
-            auto pos = cluster.getGlobalPosition();
-            pos = pos - math_utils::Point3D<float>{vx, vy, vz};
-            // Normalize the vector and rescale by energy.
-            pos *= (cluster.E() / std::sqrt(pos.Mag2()));
-
-            // save to table
-            LOG(debug) << "Writing cluster definition " << static_cast<int>(mClusterDefinitions.at(i)) << " to table.";
-            clusters(col, cluster.getID(), cluster.E(), cluster.getCoreEnergy(), pos.Eta(), TVector2::Phi_0_2pi(pos.Phi()),
-                     cluster.getM02(), cluster.getM20(), cluster.getNCells(), cluster.getClusterTime(),
-                     cluster.getIsExotic(), cluster.getDistanceToBadChannel(), cluster.getNExMax(), static_cast<int>(mClusterDefinitions.at(i)));
-
-            clustercells.reserve(cluster.getNCells());
-            // loop over cells in cluster and save to table
-            for (int ncell = 0; ncell < cluster.getNCells(); ncell++) {
-              cellindex = cluster.getCellIndex(ncell);
-              LOG(debug) << "trying to find cell index " << cellindex << " in map";
-              clustercells(clusters.lastIndex(), mCellIdToCellGlobalIndex.at(cellindex));
-            }
-            // fill histograms
-            hClusterE->Fill(cluster.E());
-            hClusterEtaPhi->Fill(pos.Eta(), TVector2::Phi_0_2pi(pos.Phi()));
-            for (unsigned int iTrack = 0; iTrack < clusterToTrackIndexMap[k].size(); iTrack++) {
-              if (clusterToTrackIndexMap[k][iTrack] >= 0) {
-                LOG(debug) << "Found track " << trackGlobalIndex[clusterToTrackIndexMap[k][iTrack]] << " in cluster " << cluster.getID();
-                matchedTracks(clusters.lastIndex(), trackGlobalIndex[clusterToTrackIndexMap[k][iTrack]]);
-              }
-            }
-            k++;
-          } // end of cluster loop
-        }   // end of collision loop
+      buildClusters(0, vx, vy, vz, hasCollision);
+      for (auto& thread : threads) {
+        thread.join();
       }
-      if (!hasCollision) {
-        LOG(warning) << "No vertex found for event. Assuming (0,0,0).";
+    } else {
+      for (int i = 0; i < nDefinitions; i++) {
+        buildClusters(i, vx, vy, vz, hasCollision);
       }
+    }
 
-      // Store the clusters in the table where a mathcing collision could
-      // be identified.
-      if (!hasCollision) { // ambiguous
-        int cellindex = -1;
-        clustersAmbiguous.reserve(mAnalysisClusters.size());
-        for (const auto& cluster : mAnalysisClusters) {
-          auto pos = cluster.getGlobalPosition();
-          pos = pos - math_utils::Point3D<float>{vx, vy, vz};
-          // Normalize the vector and rescale by energy.
-          pos *= (cluster.E() / std::sqrt(pos.Mag2()));
-
-          // We have our necessary properties. Now we store outputs
-
-          // LOG(debug) << "Cluster E: " << cluster.E();
-          clustersAmbiguous(bc, cluster.getID(), cluster.E(), cluster.getCoreEnergy(), pos.Eta(), TVector2::Phi_0_2pi(pos.Phi()),
+    for (int i = 0; i < nDefinitions; i++) {
+      const auto& definitionClusters = mDefinitionClusters[i];
+      const auto& analysisClusters = definitionClusters.analysisClusters;
+      const auto& clusterEta = definitionClusters.clusterEta;
+      const auto& clusterPhi = definitionClusters.clusterPhi;
+      const auto& clusterToTrackIndexMap = definitionClusters.clusterToTrackIndexMap;
+      const int nClusters = analysisClusters.size();
+      const int clusterDefinition = static_cast<int>(mClusterDefinitions.at(i));
+      if (hasCollision) {
+        // we found a collision, put the clusters into the none ambiguous table
+        clusters.reserve(analysisClusters.size());
+        for (int k = 0; k < nClusters; k++) {
+          const auto& cluster = analysisClusters[k];
+          // save to table
+          LOG(debug) << "Writing cluster definition " << clusterDefinition << " to table.";
+          clusters(collisionIndex, cluster.getID(), cluster.E(), cluster.getCoreEnergy(), clusterEta[k], clusterPhi[k],
+                   cluster.getM02(), cluster.getM20(), cluster.getNCells(), cluster.getClusterTime(),
+                   cluster.getIsExotic(), cluster.getDistanceToBadChannel(), cluster.getNExMax(), clusterDefinition);
+
+          clustercells.reserve(cluster.getNCells());
+          // loop over cells in cluster and save to table
+          for (int ncell = 0; ncell < cluster.getNCells(); ncell++) {
+            clustercells(clusters.lastIndex(), mCellIdToCellGlobalIndex[cluster.getCellIndex(ncell)]);
+          }
+          // fill histograms
+          hClusterE->Fill(cluster.E());
+          hClusterEtaPhi->Fill(clusterEta[k], clusterPhi[k]);
+          for (int m = 0; m < maxNumberMatches; m++) {
+            const int iTrack = clusterToTrackIndexMap[k * maxNumberMatches + m];
+            if (iTrack >= 0) {
+              LOG(debug) << "Found track " << mTrackGlobalIndex[iTrack] << " in cluster " << cluster.getID();
+              matchedTracks(clusters.lastIndex(), mTrackGlobalIndex[iTrack]);
+            }
+          }
+        } // end of cluster loop
+      } else {
+        // Store the clusters in the table where no matching collision could be identified.
+        clustersAmbiguous.reserve(analysisClusters.size());
+        for (int k = 0; k < nClusters; k++) {
+          const auto& cluster = analysisClusters[k];
+          clustersAmbiguous(bc, cluster.getID(), cluster.E(), cluster.getCoreEnergy(), clusterEta[k], clusterPhi[k],
                             cluster.getM02(), cluster.getM20(), cluster.getNCells(), cluster.getClusterTime(),
-                            cluster.getIsExotic(), cluster.getDistanceToBadChannel(), cluster.getNExMax(), static_cast<int>(mClusterDefinitions.at(i)));
+                            cluster.getIsExotic(), cluster.getDistanceToBadChannel(), cluster.getNExMax(), clusterDefinition);
           clustercellsambiguous.reserve(cluster.getNCells());
           for (int ncell = 0; ncell < cluster.getNCells(); ncell++) {
-            cellindex = cluster.getCellIndex(ncell);
-            clustercellsambiguous(clustersAmbiguous.lastIndex(), mCellIdToCellGlobalIndex.at(cellindex));
+            clustercellsambiguous(clustersAmbiguous.lastIndex(), mCellIdToCellGlobalIndex[cluster.getCellIndex(ncell)]);
           }
         }
       }
       LOG(debug) << "Cluster loop done for clusterizer " << i;
-      i++;
     } // end of clusterizer loop
     LOG(debug) << "Done with process.";
   }
+
+  /// Runs the clusterizer of a cluster definition on the cells of the BC, builds the analysis clusters with their
+  /// vertex corrected positions and matches them to the tracks of the collision
+  /// Only the buffers of the cluster definition are written, so the definitions can run on separate threads.
+  void buildClusters(int i, float vx, float vy, float vz, bool hasCollision)
+  {
+    auto& clusterizer = mClusterizers[i];
+    auto& definitionClusters = mDefinitionClusters[i];
+    clusterizer->findClusters(mEmcalCells);
+
+    auto emcalClusters = clusterizer->getFoundClusters();
+    auto emcalClustersInputIndices = clusterizer->getFoundClustersInputIndices();
+    LOG(debug) << "Retrieved results. About to setup cluster factory.";
+
+    // Convert to analysis clusters.
+    // First, the cluster factory requires cluster and cell information in order to build the clusters.
+    auto& clusterFactory = mClusterFactories[i];
+    clusterFactory->reset();
+    clusterFactory->setClustersContainer(*emcalClusters);
+    clusterFactory->setCellsContainer(mEmcalCells);
+    clusterFactory->setCellsIndicesContainer(*emcalClustersInputIndices);
+
+    LOG(debug) << "Cluster factory set up.";
+    // Convert to analysis clusters, determining the cluster eta, phi once, correcting for the vertex position.
+    const int nClusters = clusterFactory->getNumberOfClusters();
+    auto& analysisClusters = definitionClusters.analysisClusters;
+    auto& clusterEta = definitionClusters.clusterEta;
+    auto& clusterPhi = definitionClusters.clusterPhi;
+    analysisClusters.clear();
+    clusterEta.clear();
+    clusterPhi.clear();
+    analysisClusters.reserve(nClusters);
+    clusterEta.reserve(nClusters);
+    clusterPhi.reserve(nClusters);
+    for (int icl = 0; icl < nClusters; icl++) {
+      const auto& analysisCluster = analysisClusters.emplace_back(clusterFactory->buildCluster(icl));
+      auto pos = analysisCluster.getGlobalPosition();
+      pos = pos - math_utils::Point3D<float>{vx, vy, vz};
+      clusterEta.emplace_back(pos.Eta());
+      clusterPhi.emplace_back(TVector2::Phi_0_2pi(pos.Phi()));
+      LOG(debug) << "Cluster " << icl << ": E: " << analysisCluster.E() << ", NCells " << analysisCluster.getNCells();
+    }
+    LOG(debug) << "Converted to analysis clusters.";
+
+    if (hasCollision) {
+      JetUtilities::MatchClustersAndTracks(clusterEta.data(), clusterPhi.data(), clusterEta.size(), mTrackEta.data(), mTrackPhi.data(), mTrackEta.size(),
+                                           maxMatchingDistance.value, maxNumberMatches, definitionClusters.clusterGrid, definitionClusters.trackGrid,
+                                           definitionClusters.clusterToTrackIndexMap, definitionClusters.trackToClusterIndexMap);
+    }
+  }
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
@@ -23,6 +23,11 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
 #include "PWGJE/DataModel/Jet.h"
 #include "PWGJE/Core/JetFinder.h"
 
@@ -72,22 +77,63 @@ struct JetFinderTask {
   Configurable<float> trackEtaCut{"trackEtaCut", 0.9, "constituent eta cut"};
   Configurable<bool> DoRhoAreaSub{"DoRhoAreaSub", false, "do rho area subtraction"};
   Configurable<bool> DoConstSub{"DoConstSub", false, "do constituent subtraction"};
+  Configurable<bool> DoConstSubBinned{"DoConstSubBinned", false, "do the constituent subtraction with the ghosts on a fixed grid and a bounded deltaR search (faster, no rho_m subtraction)"};
+  Configurable<bool> DoGridBkg{"DoGridBkg", false, "estimate rho from an eta-phi grid of the particles instead of the kT jets"};
+  Configurable<float> bkgGridSpacing{"bkgGridSpacing", 0.2, "eta and phi size of the cells of the grid rho estimation"};
+  Configurable<bool> DoRhoMassSub{"DoRhoMassSub", false, "subtract the background mass density rho_m as well"};
   Configurable<float> jetPtMin{"jetPtMin", 10.0, "minimum jet pT"};
   Configurable<std::vector<double>> jetR{"jetR", {0.4}, "jet resolution parameters"};
+  Configurable<bool> DoJetArea{"DoJetArea", true, "compute the jet areas, stored as 0 otherwise (always computed for the rho area subtraction)"};
   // FIXME: This should be named jetType. However, as of Aug 2021, it doesn't appear possible
   //        to set both global and task level options. This should be resolved when workflow
   //        level customization is available
   Configurable<int> jetType2{"jetType2", 1, "Type of stored jets. 0 = full, 1 = charged, 2 = neutral"};
+  Configurable<int> nThreads{"nThreads", 4, "Number of threads finding the jets of the collisions of a dataframe in the parallel processes (output order is preserved)"};
 
   Filter collisionFilter = nabs(aod::collision::posZ) < vertexZCut;
   Filter trackFilter = (nabs(aod::track::eta) < trackEtaCut) && (requireGlobalTrackInFilter()) && (aod::track::pt > trackPtCut);
 
   std::vector<fastjet::PseudoJet> jets;
   std::vector<fastjet::PseudoJet> inputParticles;
+  std::unique_ptr<fastjet::ClusterSequence> clusterSeq;
   JetFinder jetFinder; //should be a configurable but for now this cant be changed on hyperloop
   // FIXME: Once configurables support enum, ideally we can
   JetType_t _jetType;
 
+  /// Found jets of one collision, written into the tables once all the radii are done
+  struct CollisionJets {
+    struct Jet {
+      float pt, eta, phi, e, m, area, r;
+      int nConstituents;
+    };
+    struct Constituent {
+      float pt, eta, phi, e, m;
+      int userIndex;
+    };
+    std::vector<Jet> jets;                 // jets of all the radii
+    std::vector<Constituent> constituents; // constituents of the jets, consecutive per jet
+
+    void clear()
+    {
+      jets.clear();
+      constituents.clear();
+    }
+  };
+  CollisionJets collisionJets; // used by the serial processes
+
+  /// Jet finder and buffers of a worker thread of the parallel processes
+  struct Worker {
+    JetFinder jetFinder;
+    std::vector<fastjet::PseudoJet> jets;
+    std::vector<fastjet::PseudoJet> inputParticles;
+    std::unique_ptr<fastjet::ClusterSequence> clusterSeq;
+  };
+  std::vector<std::unique_ptr<Worker>> workers; // per worker thread, used by the parallel processes
+  std::vector<CollisionJets> bufferJets;        // per collision of the dataframe, used by the parallel processes
+
+  Preslice<aod::Tracks> tracksPerCollision = aod::track::collisionId;
+  Preslice<aod::EMCALClusters> clustersPerCollision = aod::emcalcluster::collisionId;
+
   void init(InitContext const&)
   {
     hJetPt.setObject(new TH2F("h_jet_pt", "jet p_{T};p_{T} (GeV/#it{c})",
@@ -98,13 +144,47 @@ struct JetFinderTask {
                                70, -0.7, 0.7, 10, 0.05, 1.05));
     hJetN.setObject(new TH2F("h_jet_n", "jet n;n constituents",
                              30, 0., 30., 10, 0.05, 1.05));
+    setupJetFinder(jetFinder);
+
+    if ((doprocessDataCharged || doprocessDataFull) && (doprocessDataChargedParallel || doprocessDataFullParallel)) {
+      LOGF(fatal, "Cannot enable a serial and a parallel data process at the same time. Please choose one.");
+    }
+    if (doprocessDataChargedParallel || doprocessDataFullParallel) {
+#ifndef FASTJET_HAVE_LIMITED_THREAD_SAFETY
+      // the ghosts of the jet areas are drawn from a random generator shared by all the cluster sequences
+      LOGF(fatal, "The parallel processes need FastJet built with limited thread safety");
+#endif
+      // one jet finder per thread, the background estimator and the subtractors keep the state of the event
+      const int nWorkers = std::max(1, nThreads.value);
+      for (int iWorker = 0; iWorker < nWorkers; ++iWorker) {
+        workers.emplace_back(new Worker);
+        setupJetFinder(workers.back()->jetFinder);
+      }
+    }
+  }
+
+  /// Sets the parameters of a jet finder from the configurables
+  void setupJetFinder(JetFinder& finder)
+  {
     if (DoRhoAreaSub) {
-      jetFinder.setBkgSubMode(JetFinder::BkgSubMode::rhoAreaSub);
+      finder.setBkgSubMode(JetFinder::BkgSubMode::rhoAreaSub);
     }
     if (DoConstSub) {
-      jetFinder.setBkgSubMode(JetFinder::BkgSubMode::constSub);
+      finder.setBkgSubMode(JetFinder::BkgSubMode::constSub);
+    }
+    if (DoConstSubBinned) {
+      finder.setBkgSubMode(JetFinder::BkgSubMode::constSubBinned);
     }
-    jetFinder.jetPtMin = jetPtMin;
+    if (DoGridBkg) {
+      finder.setBkgEstimatorMode(JetFinder::BkgEstimatorMode::gridMedian);
+    }
+    finder.bkgGridSpacing = bkgGridSpacing;
+    finder.doRhoMassSub = DoRhoMassSub;
+    finder.jetPtMin = jetPtMin;
+    finder.doArea = DoJetArea;
+    // the jet definitions of all the radii and the background subtraction are built once, not per collision
+    // NOTE: Can't just iterate directly - we have to cast first
+    finder.setup(static_cast<std::vector<double>>(jetR));
   }
 
   template <typename T>
@@ -126,44 +206,70 @@ struct JetFinderTask {
     return true;
   }
 
-  template <typename T>
-  void processImplementation(T const& collision)
+  /// Finds the jets of all the radii in the input particles of a collision
+  /// \param finder is the jet finder, set up for all the radii
+  /// \param output is filled with the jets and their constituents
+  void findCollisionJets(JetFinder& finder, std::vector<fastjet::PseudoJet> const& particles, std::vector<fastjet::PseudoJet>& foundJets,
+                         std::unique_ptr<fastjet::ClusterSequence>& sequence, CollisionJets& output)
   {
-    LOG(debug) << "Process Implementation";
-    // NOTE: Can't just iterate directly - we have to cast first
-    auto jetRValues = static_cast<std::vector<double>>(jetR);
-    for (auto R : jetRValues) {
-      // Update jet finder R and find jets
-      jetFinder.jetR = R;
-      fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
-
-      for (const auto& jet : jets) {
-        jetsTable(collision, jet.pt(), jet.eta(), jet.phi(),
-                  jet.E(), jet.m(), jet.area(), std::round(R * 100));
-        hJetPt->Fill(jet.pt(), R);
-        hJetPhi->Fill(jet.phi(), R);
-        hJetEta->Fill(jet.eta(), R);
-        hJetN->Fill(jet.constituents().size(), R);
-        for (const auto& constituent : jet.constituents()) { //event or jetwise
-          if (DoConstSub) {
-            // Since we're copying the consituents, we can combine the tracks and clusters together
-            // We only have to keep the uncopied versions separated due to technical constraints.
-            constituentsSubTable(jetsTable.lastIndex(), constituent.pt(), constituent.eta(), constituent.phi(),
-                                 constituent.E(), constituent.m(), constituent.user_index());
-          }
-          if (constituent.user_index() < 0) {
-            // Cluster
-            // -1 to account for the convention of negative indices for clusters.
-            clusterConstituentsTable(jetsTable.lastIndex(), -1 * constituent.user_index());
-          } else {
-            // Tracks
-            trackConstituentsTable(jetsTable.lastIndex(), constituent.user_index());
-          }
+    // the background subtraction is done once for all the radii
+    finder.setEvent(particles);
+    for (std::size_t iR = 0; iR < finder.getNRadii(); iR++) {
+      auto R = finder.getRadius(iR);
+      finder.findJets(iR, foundJets, sequence);
+
+      for (const auto& jet : foundJets) {
+        auto constituents = jet.constituents();
+        output.jets.push_back({static_cast<float>(jet.pt()), static_cast<float>(jet.eta()), static_cast<float>(jet.phi()),
+                               static_cast<float>(jet.E()), static_cast<float>(jet.m()), static_cast<float>(jet.has_area() ? jet.area() : 0.),
+                               static_cast<float>(R), static_cast<int>(constituents.size())});
+        for (const auto& constituent : constituents) {
+          output.constituents.push_back({static_cast<float>(constituent.pt()), static_cast<float>(constituent.eta()), static_cast<float>(constituent.phi()),
+                                         static_cast<float>(constituent.E()), static_cast<float>(constituent.m()), constituent.user_index()});
+        }
+      }
+    }
+  }
+
+  /// Writes the jets of a collision into the tables and fills the histograms
+  void writeJets(int64_t collisionIndex, CollisionJets const& output)
+  {
+    auto constituent = output.constituents.begin();
+    for (const auto& jet : output.jets) {
+      jetsTable(collisionIndex, jet.pt, jet.eta, jet.phi,
+                jet.e, jet.m, jet.area, std::round(jet.r * 100));
+      hJetPt->Fill(jet.pt, jet.r);
+      hJetPhi->Fill(jet.phi, jet.r);
+      hJetEta->Fill(jet.eta, jet.r);
+      hJetN->Fill(jet.nConstituents, jet.r);
+      for (const auto last = constituent + jet.nConstituents; constituent != last; ++constituent) { //event or jetwise
+        if (DoConstSub) {
+          // Since we're copying the consituents, we can combine the tracks and clusters together
+          // We only have to keep the uncopied versions separated due to technical constraints.
+          constituentsSubTable(jetsTable.lastIndex(), constituent->pt, constituent->eta, constituent->phi,
+                               constituent->e, constituent->m, constituent->userIndex);
+        }
+        if (constituent->userIndex < 0) {
+          // Cluster
+          // -1 to account for the convention of negative indices for clusters.
+          clusterConstituentsTable(jetsTable.lastIndex(), -1 * constituent->userIndex);
+        } else {
+          // Tracks
+          trackConstituentsTable(jetsTable.lastIndex(), constituent->userIndex);
         }
       }
     }
   }
 
+  template <typename T>
+  void processImplementation(T const& collision)
+  {
+    LOG(debug) << "Process Implementation";
+    collisionJets.clear();
+    findCollisionJets(jetFinder, inputParticles, jets, clusterSeq, collisionJets);
+    writeJets(collision.globalIndex(), collisionJets);
+  }
+
   void processParticleLevel(aod::McCollision const& collision, aod::McParticles const& particles)
   {
     // Setup
@@ -221,10 +327,18 @@ struct JetFinderTask {
     }
     LOG(debug) << "Accepted event!";
 
+    fillInputParticles(tracks, clusters, inputParticles);
+    processImplementation(collision);
+  }
+
+  /// Fills the input particles of a collision from its tracks and clusters
+  template <typename U, typename C>
+  void fillInputParticles(U const& tracks, C const* clusters, std::vector<fastjet::PseudoJet>& particles)
+  {
     if (_jetType == JetType_t::full || _jetType == JetType_t::charged) {
       for (auto& track : tracks) {
-        fillConstituents(track, inputParticles);
-        inputParticles.back().set_user_index(track.globalIndex());
+        fillConstituents(track, particles);
+        particles.back().set_user_index(track.globalIndex());
       }
     }
     if (_jetType == JetType_t::full || _jetType == JetType_t::neutral) {
@@ -233,21 +347,81 @@ struct JetFinderTask {
           // The right thing to do here would be to fully calculate the momentum correcting for the vertex position.
           // However, it's not clear that this functionality exists yet (21 June 2021)
           double pt = cluster.energy() / std::cosh(cluster.eta());
-          inputParticles.emplace_back(
+          particles.emplace_back(
             fastjet::PseudoJet(
               pt * std::cos(cluster.phi()),
               pt * std::sin(cluster.phi()),
               pt * std::sinh(cluster.eta()),
               cluster.energy()));
           // Clusters are denoted with negative indices.
-          inputParticles.back().set_user_index(-1 * cluster.globalIndex());
+          particles.back().set_user_index(-1 * cluster.globalIndex());
         }
       } else {
         throw std::runtime_error("Requested clusters, but they're not available!");
       }
     }
+  }
 
-    processImplementation(collision);
+  /// Finds the jets of all the collisions of a dataframe on several threads
+  /// The input particles of each collision are gathered and clustered by a worker thread, and the jets are then written
+  /// in collision order, so the output matches the serial processes.
+  template <typename T, typename U, typename C>
+  void processDataParallel(T const& collisions, U const& tracks, C const* clusters = nullptr)
+  {
+    _jetType = static_cast<JetType_t>(static_cast<int>(jetType2));
+    const int nCollisions = collisions.size();
+    if (nCollisions == 0) {
+      return;
+    }
+    if (static_cast<int>(bufferJets.size()) < nCollisions) {
+      bufferJets.resize(nCollisions);
+    }
+    const int nWorkers = std::min(static_cast<int>(workers.size()), nCollisions);
+
+    // slices are made upfront, since the slicing cache is not thread-safe
+    using TracksSlice = decltype(tracks.sliceBy(tracksPerCollision, 0));
+    std::vector<TracksSlice> tracksSlices;
+    tracksSlices.reserve(nCollisions);
+    using ClustersSlice = decltype(clusters->sliceBy(clustersPerCollision, 0));
+    std::vector<ClustersSlice> clustersSlices;
+    if (clusters) {
+      clustersSlices.reserve(nCollisions);
+    }
+    for (const auto& collision : collisions) {
+      tracksSlices.push_back(tracks.sliceBy(tracksPerCollision, collision.globalIndex()));
+      if (clusters) {
+        clustersSlices.push_back(clusters->sliceBy(clustersPerCollision, collision.globalIndex()));
+      }
+    }
+
+    // workers pull collisions from a shared counter, so that faster threads pick up the remaining work
+    std::atomic<int> nextCollision{0};
+    auto work = [&](Worker& worker) {
+      for (int iCollision = nextCollision++; iCollision < nCollisions; iCollision = nextCollision++) {
+        auto& output = bufferJets[iCollision];
+        output.clear();
+        worker.inputParticles.clear();
+        fillInputParticles(tracksSlices[iCollision], clusters ? &clustersSlices[iCollision] : nullptr, worker.inputParticles);
+        findCollisionJets(worker.jetFinder, worker.inputParticles, worker.jets, worker.clusterSeq, output);
+      }
+      // the constituents are copied into the buffers, the cluster sequence of the last collision is not needed any more
+      worker.clusterSeq.reset();
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nWorkers - 1);
+    for (int iWorker = 1; iWorker < nWorkers; ++iWorker) {
+      threads.emplace_back(work, std::ref(*workers[iWorker]));
+    }
+    work(*workers[0]);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // write the buffers in collision order
+    int iCollision = 0;
+    for (const auto& collision : collisions) {
+      writeJets(collision.globalIndex(), bufferJets[iCollision++]);
+    }
   }
 
   void processDataCharged(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>>::iterator const& collision,
@@ -268,6 +442,25 @@ struct JetFinderTask {
   }
 
   PROCESS_SWITCH(JetFinderTask, processDataFull, "Data jet finding for full and neutral jets", false);
+
+  void processDataChargedParallel(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>> const& collisions,
+                                  soa::Filtered<soa::Join<aod::Tracks, aod::TrackSelection>> const& tracks)
+  {
+    LOG(debug) << "Process data charged in parallel!";
+    processDataParallel(collisions, tracks, static_cast<aod::EMCALClusters const*>(nullptr));
+  }
+
+  PROCESS_SWITCH(JetFinderTask, processDataChargedParallel, "Data jet finding for charged jets, collisions of a dataframe on several threads", false);
+
+  void processDataFullParallel(soa::Filtered<soa::Join<aod::Collisions, aod::EvSels>> const& collisions,
+                               soa::Filtered<soa::Join<aod::Tracks, aod::TrackSelection>> const& tracks,
+                               aod::EMCALClusters const& clusters)
+  {
+    LOG(debug) << "Process data full in parallel!";
+    processDataParallel(collisions, tracks, &clusters);
+  }
+
+  PROCESS_SWITCH(JetFinderTask, processDataFullParallel, "Data jet finding for full and neutral jets, collisions of a dataframe on several threads", false);
 };
 
 using JetFinderData = JetFinderTask<o2::aod::Jets, o2::aod::JetTrackConstituents, o2::aod::JetClusterConstituents, o2::aod::JetConstituentsSub>;
@@ -21,6 +21,10 @@
 #include "fastjet/PseudoJet.hh"
 #include "fastjet/ClusterSequenceArea.hh"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "PWGJE/DataModel/Jet.h"
 #include "PWGJE/Core/JetFinder.h"
 
@@ -29,22 +33,25 @@ using namespace o2::framework;
 using namespace o2::framework::expressions;
 
 struct JetFinderHadronRecoilTask {
-  OutputObj<TH1F> hJetPt{"h_jet_pt"};
-  OutputObj<TH1F> hHadronPt{"h_hadron_pt"};
-  OutputObj<TH1F> hJetHadronDeltaPhi{"h_jet_hadron_deltaphi"};
+  // the first axis of the histograms is the trigger track class
+  OutputObj<TH2F> hJetPt{"h_jet_pt"};
+  OutputObj<TH2F> hHadronPt{"h_hadron_pt"};
+  OutputObj<TH2F> hJetHadronDeltaPhi{"h_jet_hadron_deltaphi"};
 
-  Configurable<float> f_trackTTMin{"f_trackTTMin", 8.0, "TT hadron min pT"};
-  Configurable<float> f_trackTTMax{"f_trackTTMax", 9.0, "TT hadron max pT"};
+  Configurable<std::vector<float>> f_trackTTMin{"f_trackTTMin", {8.0}, "TT hadron min pT, one per trigger track class (e.g. reference and signal)"};
+  Configurable<std::vector<float>> f_trackTTMax{"f_trackTTMax", {9.0}, "TT hadron max pT, one per trigger track class"};
   Configurable<float> f_recoilWindow{"f_recoilWindow", 0.6, "jet finding phi window reecoilling from hadron"};
 
   Filter trackCuts = aod::track::pt >= 0.15f && aod::track::eta > -0.9f && aod::track::eta < 0.9f;
   int collisionSplit = 0; //can we partition the collisions?
   //can we also directly filter the collision based on the max track::pt?
 
-  std::vector<float> trackTTPt;
+  std::vector<float> trackTTPt;  // pT of the trigger track of every class, 0 if the class has none in the event
+  std::vector<float> trackTTPhi; // phi of the trigger track of every class
   std::vector<fastjet::PseudoJet> jets;
   std::vector<fastjet::PseudoJet> inputParticles;
   JetFinder jetFinder;
+  std::unique_ptr<fastjet::ClusterSequence> clusterSeq;
 
   template <typename T>
   T relativePhi(T phi1, T phi2)
@@ -70,12 +77,22 @@ struct JetFinderHadronRecoilTask {
 
   void init(InitContext const&)
   {
-    hJetPt.setObject(new TH1F("h_jet_pt", "jet p_{T};jet p_{T} (GeV/#it{c})",
-                              100, 0., 100.));
-    hHadronPt.setObject(new TH1F("h_hadron_pt", "hadron p_{T};hadron p_{T} (GeV/#it{c})",
-                                 120, 0., 60.));
-    hJetHadronDeltaPhi.setObject(new TH1F("h_jet_hadron_deltaphi", "jet #eta;#eta",
-                                          40, 0.0, 4.));
+    if (f_trackTTMin->size() != f_trackTTMax->size() || f_trackTTMin->empty()) {
+      LOGF(fatal, "%zu TT min and %zu TT max pT given, one of each per trigger track class expected", f_trackTTMin->size(), f_trackTTMax->size());
+    }
+    const int nClasses = f_trackTTMin->size();
+    trackTTPt.resize(nClasses);
+    trackTTPhi.resize(nClasses);
+
+    hJetPt.setObject(new TH2F("h_jet_pt", "jet p_{T};TT class;jet p_{T} (GeV/#it{c})",
+                              nClasses, -0.5, nClasses - 0.5, 100, 0., 100.));
+    hHadronPt.setObject(new TH2F("h_hadron_pt", "hadron p_{T};TT class;hadron p_{T} (GeV/#it{c})",
+                                 nClasses, -0.5, nClasses - 0.5, 120, 0., 60.));
+    hJetHadronDeltaPhi.setObject(new TH2F("h_jet_hadron_deltaphi", "jet #eta;TT class;#eta",
+                                          nClasses, -0.5, nClasses - 0.5, 40, 0.0, 4.));
+
+    // the jets of an event are found once and shared by all the trigger track classes
+    jetFinder.setup({jetFinder.jetR});
   }
 
   void process(aod::Collision const& collision,
@@ -84,17 +101,16 @@ struct JetFinderHadronRecoilTask {
 
     jets.clear();
     inputParticles.clear();
-    auto trackTTPhi = 0.0;
-    auto trackTTPt = 0.0;
-    auto comparisonPt = 0.0;
+    std::fill(trackTTPt.begin(), trackTTPt.end(), 0.f);
     bool isTT = false;
     for (auto& track : tracks) {
-      if (track.pt() >= f_trackTTMin && track.pt() < f_trackTTMax) { //can this also go into a partition?
-        isTT = true;
-        if (track.pt() >= comparisonPt) { //currently take highest pT but later to randomise
-          comparisonPt = track.pt();
-          trackTTPt = track.pt();
-          trackTTPhi = track.phi();
+      for (std::size_t iClass = 0; iClass < trackTTPt.size(); iClass++) {
+        if (track.pt() >= f_trackTTMin->at(iClass) && track.pt() < f_trackTTMax->at(iClass)) { //can this also go into a partition?
+          isTT = true;
+          if (track.pt() >= trackTTPt[iClass]) { //currently take highest pT but later to randomise
+            trackTTPt[iClass] = track.pt();
+            trackTTPhi[iClass] = track.phi();
+          }
         }
       }
       auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
@@ -104,18 +120,24 @@ struct JetFinderHadronRecoilTask {
     if (!isTT) {
       return;
     }
-    hHadronPt->Fill(trackTTPt);
 
     // you can set phi selector here for jets
-    fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
+    jetFinder.setEvent(inputParticles);
+    jetFinder.findJets(0, jets, clusterSeq);
 
-    for (const auto& jet : jets) {
-      auto deltaPhi = TMath::Abs(relativePhi(jet.phi(), trackTTPhi));
-      if (deltaPhi >= (M_PI - f_recoilWindow)) {
-        hJetPt->Fill(jet.pt());
+    for (std::size_t iClass = 0; iClass < trackTTPt.size(); iClass++) {
+      if (trackTTPt[iClass] <= 0.f) {
+        continue;
       }
-      if (deltaPhi >= M_PI / 2.0 && deltaPhi <= M_PI) {
-        hJetHadronDeltaPhi->Fill(deltaPhi);
+      hHadronPt->Fill(iClass, trackTTPt[iClass]);
+      for (const auto& jet : jets) {
+        auto deltaPhi = TMath::Abs(relativePhi(jet.phi(), static_cast<double>(trackTTPhi[iClass])));
+        if (deltaPhi >= (M_PI - f_recoilWindow)) {
+          hJetPt->Fill(iClass, jet.pt());
+        }
+        if (deltaPhi >= M_PI / 2.0 && deltaPhi <= M_PI) {
+          hJetHadronDeltaPhi->Fill(iClass, deltaPhi);
+        }
       }
     }
   }
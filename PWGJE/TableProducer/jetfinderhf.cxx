@@ -19,6 +19,10 @@
 #include "Framework/ASoA.h"
 #include "TDatabasePDG.h"
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
 #include "Common/DataModel/EventSelection.h"
@@ -65,8 +69,25 @@ struct JetFinderHFTask {
 
   std::vector<fastjet::PseudoJet> jets;
   std::vector<fastjet::PseudoJet> inputParticles;
+  std::vector<fastjet::PseudoJet> eventParticles; // selected particles of the event, shared by all its candidates
   JetFinder jetFinder;
 
+  // inputs of the jet finding for one candidate: the particles of the event without the candidate daughters, and the candidate
+  template <typename T>
+  void fillInputParticles(T const& daughterIds, float px, float py, float pz, float e)
+  {
+    inputParticles.clear();
+    inputParticles.reserve(eventParticles.size() + 1);
+    for (const auto& particle : eventParticles) {
+      if (std::find(std::begin(daughterIds), std::end(daughterIds), particle.user_index()) != std::end(daughterIds)) {
+        continue;
+      }
+      inputParticles.push_back(particle);
+    }
+    inputParticles.emplace_back(px, py, pz, e);
+    inputParticles.back().set_user_index(1);
+  }
+
   void init(InitContext const&)
   {
     // set up global tracks and adjust as necessary
@@ -101,20 +122,19 @@ struct JetFinderHFTask {
     if (!collision.sel8())
       return;
 
-    //this loop should be made more efficient
+    if (candidates.size() == 0) {
+      return;
+    }
+    eventParticles.clear();
+    for (auto& track : tracks) {
+      auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
+      eventParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
+      eventParticles.back().set_user_index(track.globalIndex());
+    }
+
     for (auto& candidate : candidates) {
       jets.clear();
-      inputParticles.clear();
-      for (auto& track : tracks) {
-        auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
-        if (candidate.prong0().globalIndex() == track.globalIndex() || candidate.prong1().globalIndex() == track.globalIndex()) { // is it global index?
-          continue;
-        }
-        inputParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
-        inputParticles.back().set_user_index(track.globalIndex());
-      }
-      inputParticles.emplace_back(candidate.px(), candidate.py(), candidate.pz(), candidate.e(RecoDecay::getMassPDG(pdgD0)));
-      inputParticles.back().set_user_index(1);
+      fillInputParticles(std::array{candidate.prong0Id(), candidate.prong1Id()}, candidate.px(), candidate.py(), candidate.pz(), candidate.e(RecoDecay::getMassPDG(pdgD0)));
 
       fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
 
@@ -149,27 +169,25 @@ struct JetFinderHFTask {
     // TODO: retrieve pion mass from somewhere
     bool isHFJet;
 
-    //this loop should be made more efficient
+    if (candidates.size() == 0) {
+      return;
+    }
+    eventParticles.clear();
+    for (auto& track : tracks) {
+      if (!globalTracks.IsSelected(track)) {
+        LOGF(debug, "Rejecting track %d with track cuts", track.globalIndex());
+        continue;
+      }
+      // LOGF(info, "Adding track %d with pt %g", track.globalIndex(), track.pt());
+      auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
+      eventParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
+      eventParticles.back().set_user_index(track.globalIndex());
+    }
+
     // TODO: should probably refine the candidate selection
     for (auto& candidate : candidates) {
       jets.clear();
-      inputParticles.clear();
-      for (auto& track : tracks) {
-        if (!globalTracks.IsSelected(track)) {
-          LOGF(info, "Rejecting track %d with track cuts", track.globalIndex());
-          continue;
-        }
-        if (candidate.prong0().globalIndex() == track.globalIndex() || candidate.prong1().globalIndex() == track.globalIndex()) {
-          LOGF(info, "Rejecting track %d as daughter of candidate %d", track.globalIndex(), candidate.globalIndex());
-          continue;
-        }
-        // LOGF(info, "Adding track %d with pt %g", track.globalIndex(), track.pt());
-        auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
-        inputParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
-        inputParticles.back().set_user_index(track.globalIndex());
-      }
-      inputParticles.emplace_back(candidate.px(), candidate.py(), candidate.pz(), candidate.e(RecoDecay::getMassPDG(pdgD0)));
-      inputParticles.back().set_user_index(1);
+      fillInputParticles(std::array{candidate.prong0Id(), candidate.prong1Id()}, candidate.px(), candidate.py(), candidate.pz(), candidate.e(RecoDecay::getMassPDG(pdgD0)));
 
       fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
 
@@ -226,34 +244,31 @@ struct JetFinderHFTask {
       }
     }
 
-    //this loop should be made more efficient
+    if (candidates.empty()) {
+      return;
+    }
+    eventParticles.clear();
+    for (auto& track : particles) {
+      // exclude neutral particles
+      // TODO: can we do this through the filter?
+      auto p = pdg->GetParticle(track.pdgCode());
+      // LOGF(info, "Checking particle %i with status %d and charge %g",
+      //   track.globalIndex(), track.getGenStatusCode(), p ? std::abs(p->Charge()) : -999.);
+      if ((track.getGenStatusCode() != 1) || (p ? std::abs(p->Charge()) : 0.) < 3.) {
+        LOGF(debug, "Rejecting particle %d with status %d and charge %g", track.globalIndex(), track.getGenStatusCode(), p ? std::abs(p->Charge()) : -999.);
+        continue;
+      }
+
+      // TODO: check what mass to use?
+      auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
+      // LOGF(info, "Adding particle %d with pt %g", track.globalIndex(), track.pt());
+      eventParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
+      eventParticles.back().set_user_index(track.globalIndex());
+    }
+
     for (auto& candidate : candidates) {
       jets.clear();
-      inputParticles.clear();
-      for (auto& track : particles) {
-        // exclude neutral particles
-        // TODO: can we do this through the filter?
-        auto p = pdg->GetParticle(track.pdgCode());
-        // LOGF(info, "Checking particle %i with status %d and charge %g",
-        //   track.globalIndex(), track.getGenStatusCode(), p ? std::abs(p->Charge()) : -999.);
-        if ((track.getGenStatusCode() != 1) || (p ? std::abs(p->Charge()) : 0.) < 3.) {
-          LOGF(info, "Rejecting particle %d with status %d and charge %g", track.globalIndex(), track.getGenStatusCode(), p ? std::abs(p->Charge()) : -999.);
-          continue;
-        }
-
-        // TODO: check what mass to use?
-        auto energy = std::sqrt(track.p() * track.p() + JetFinder::mPion * JetFinder::mPion);
-        const auto daughters = candidate.daughtersIds();
-        if (std::find(std::begin(daughters), std::end(daughters), track.globalIndex()) != std::end(daughters)) {
-          LOGF(info, "Rejecting particle %d as daughter of candidate %d", track.globalIndex(), candidate.globalIndex());
-          continue;
-        }
-        // LOGF(info, "Adding particle %d with pt %g", track.globalIndex(), track.pt());
-        inputParticles.emplace_back(track.px(), track.py(), track.pz(), energy);
-        inputParticles.back().set_user_index(track.globalIndex());
-      }
-      inputParticles.emplace_back(candidate.px(), candidate.py(), candidate.pz(), candidate.e());
-      inputParticles.back().set_user_index(1);
+      fillInputParticles(candidate.daughtersIds(), candidate.px(), candidate.py(), candidate.pz(), candidate.e());
 
       fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
 
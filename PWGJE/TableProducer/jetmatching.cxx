@@ -14,6 +14,10 @@
 ///
 /// \author Raymond Ehlers <raymond.ehlers@cern.ch>, ORNL
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 #include "Framework/AnalysisTask.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/ASoA.h"
@@ -42,13 +46,55 @@ void customize(std::vector<o2::framework::ConfigParamSpec>& workflowOptions)
 template <typename CollisionType, typename BaseJetCollection, typename BaseJetCollectionMatching, typename TagJetCollection, typename TagJetCollectionMatching>
 struct JetMatching {
   Configurable<float> maxMatchingDistance{"maxMatchingDistance", 0.4f, "Max matching distance"};
+  Configurable<bool> scaleMatchingDistanceWithR{"scaleMatchingDistanceWithR", false, "Max matching distance in units of the jet radius, i.e. maxMatchingDistance * R"};
   Produces<BaseJetCollectionMatching> jetsBaseMatching;
   Produces<TagJetCollectionMatching> jetsTagMatching;
 
+  // the jets of the collision ordered by radius, with their eta and phi in that order
+  std::vector<int> jetsBaseOrder;
+  std::vector<int> jetsBaseR;
+  std::vector<float> jetsBasePhi;
+  std::vector<float> jetsBaseEta;
+  std::vector<int> jetsTagOrder;
+  std::vector<int> jetsTagR;
+  std::vector<float> jetsTagPhi;
+  std::vector<float> jetsTagEta;
+  JetUtilities::EtaPhiGrid<float> gridBase;
+  JetUtilities::EtaPhiGrid<float> gridTag;
+  std::vector<float> jetsEta;
+  std::vector<float> jetsPhi;
+  std::vector<int> baseToTagRadiusMap;
+  std::vector<int> tagToBaseRadiusMap;
+  std::vector<int> baseToTagIndexMap;
+  std::vector<int> tagToBaseIndexMap;
+
   void init(InitContext const&)
   {
   }
 
+  template <typename JetCollection>
+  void fillByRadius(JetCollection const& jets, std::vector<int>& order, std::vector<int>& radii, std::vector<float>& eta, std::vector<float>& phi)
+  {
+    radii.clear();
+    jetsEta.clear();
+    jetsPhi.clear();
+    for (auto& jet : jets) {
+      radii.emplace_back(jet.r());
+      jetsEta.emplace_back(jet.eta());
+      jetsPhi.emplace_back(jet.phi());
+    }
+    order.resize(radii.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&radii](int i, int j) { return radii[i] < radii[j]; });
+    // eta and phi in the order of the radii, so that the jets of each radius are contiguous
+    eta.resize(order.size());
+    phi.resize(order.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      eta[i] = jetsEta[order[i]];
+      phi[i] = jetsPhi[order[i]];
+    }
+  }
+
   void process(
     //soa::Filtered<CollisionType>::iterator const& collision,
     CollisionType const& collision,
@@ -56,19 +102,47 @@ struct JetMatching {
     BaseJetCollection const& jetsBase,
     TagJetCollection const& jetsTag)
   {
-    std::vector<double> jetsBasePhi(jetsBase.size());
-    std::vector<double> jetsBaseEta(jetsBase.size());
-    for (auto jet : jetsBase) {
-      jetsBasePhi.emplace_back(jet.phi());
-      jetsBaseEta.emplace_back(jet.eta());
-    }
-    std::vector<double> jetsTagPhi(jetsTag.size());
-    std::vector<double> jetsTagEta(jetsTag.size());
-    for (auto& jet : jetsTag) {
-      jetsTagPhi.emplace_back(jet.phi());
-      jetsTagEta.emplace_back(jet.eta());
+    // the buffers and the grids are reused across collisions
+    fillByRadius(jetsBase, jetsBaseOrder, jetsBaseR, jetsBaseEta, jetsBasePhi);
+    fillByRadius(jetsTag, jetsTagOrder, jetsTagR, jetsTagEta, jetsTagPhi);
+    baseToTagIndexMap.assign(jetsBaseOrder.size(), -1);
+    tagToBaseIndexMap.assign(jetsTagOrder.size(), -1);
+
+    // jets are only matched to jets of the same radius, all the radii are matched in one pass over the ordered jets
+    std::size_t iBase = 0, iTag = 0;
+    while (iBase < jetsBaseOrder.size() && iTag < jetsTagOrder.size()) {
+      const int baseR = jetsBaseR[jetsBaseOrder[iBase]];
+      const int tagR = jetsTagR[jetsTagOrder[iTag]];
+      std::size_t endBase = iBase, endTag = iTag;
+      while (endBase < jetsBaseOrder.size() && jetsBaseR[jetsBaseOrder[endBase]] == baseR) {
+        ++endBase;
+      }
+      while (endTag < jetsTagOrder.size() && jetsTagR[jetsTagOrder[endTag]] == tagR) {
+        ++endTag;
+      }
+      if (baseR == tagR) {
+        const double matchingDistance = scaleMatchingDistanceWithR ? maxMatchingDistance * baseR / 100. : maxMatchingDistance.value;
+        JetUtilities::MatchGeometrically(jetsBaseEta.data() + iBase, jetsBasePhi.data() + iBase, endBase - iBase,
+                                         jetsTagEta.data() + iTag, jetsTagPhi.data() + iTag, endTag - iTag,
+                                         matchingDistance, gridBase, gridTag, baseToTagRadiusMap, tagToBaseRadiusMap);
+        for (std::size_t i = 0; i < endBase - iBase; ++i) {
+          if (baseToTagRadiusMap[i] >= 0) {
+            baseToTagIndexMap[jetsBaseOrder[iBase + i]] = jetsTagOrder[iTag + baseToTagRadiusMap[i]];
+          }
+        }
+        for (std::size_t i = 0; i < endTag - iTag; ++i) {
+          if (tagToBaseRadiusMap[i] >= 0) {
+            tagToBaseIndexMap[jetsTagOrder[iTag + i]] = jetsBaseOrder[iBase + tagToBaseRadiusMap[i]];
+          }
+        }
+      }
+      if (baseR <= tagR) {
+        iBase = endBase;
+      }
+      if (tagR <= baseR) {
+        iTag = endTag;
+      }
     }
-    auto&& [baseToTagIndexMap, tagToBaseIndexMap] = JetUtilities::MatchJetsGeometrically(jetsBasePhi, jetsBaseEta, jetsTagPhi, jetsTagEta, maxMatchingDistance);
 
     unsigned int i = 0;
     for (auto& jet : jetsBase) {
@@ -15,6 +15,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "Framework/runDataProcessing.h"
@@ -27,6 +28,8 @@
 #include "EMCALCalib/BadChannelMap.h"
 #include "CommonDataFormat/InteractionRecord.h"
 
+#include "PWGJE/DataModel/EMCALCells.h"
+
 /// \struct CellMonitor
 /// \brief Simple monitoring task for cell related quantities
 /// \author Markus Fasel <markus.fasel@cern.ch>, Oak Ridge National Laoratory
@@ -125,7 +128,9 @@ struct CellMonitor {
   }
 
   /// \brief Process EMCAL cells
-  void process(o2::aod::BC const& bc, o2::aod::Calos const& cells)
+  /// \param cells are the cells of aod::Calos or the skimmed EMCAL cells of aod::EMCALPackedCells
+  template <typename TCells>
+  void processCells(o2::aod::BC const& bc, TCells const& cells)
   {
     LOG(debug) << "Processing next event";
     o2::InteractionRecord eventIR;
@@ -144,8 +149,10 @@ struct CellMonitor {
       // cell.cellNumber(),
       // cell.amplitude(),
       // cell.time(),
-      if (cell.caloType() != 1)
-        continue;
+      if constexpr (std::is_same_v<TCells, o2::aod::Calos>) {
+        if (cell.caloType() != 1)
+          continue;
+      }
       if (isCellMasked(cell.cellNumber()))
         continue;
       o2::InteractionRecord cellIR;
@@ -174,6 +181,18 @@ struct CellMonitor {
     LOG(debug) << "Processing event done";
   }
 
+  void processCalos(o2::aod::BC const& bc, o2::aod::Calos const& cells)
+  {
+    processCells(bc, cells);
+  }
+  PROCESS_SWITCH(CellMonitor, processCalos, "Process the EMCAL cells of aod::Calos", true);
+
+  void processPackedCells(o2::aod::BC const& bc, o2::aod::EMCALPackedCells const& cells)
+  {
+    processCells(bc, cells);
+  }
+  PROCESS_SWITCH(CellMonitor, processPackedCells, "Process the skimmed EMCAL cells of aod::EMCALPackedCells", false);
+
   void fillSupermoduleHistograms(int supermoduleID, int col, int row, double amplitude, double celltime)
   {
     // workaround to have the histogram names per supermodule
@@ -15,6 +15,7 @@
 //
 
 #include "TH1F.h"
+#include "TH2F.h"
 #include "TTree.h"
 
 #include "Framework/runDataProcessing.h"
@@ -24,6 +25,7 @@
 
 #include "PWGJE/DataModel/Jet.h"
 #include "PWGJE/Core/JetFinder.h"
+#include "PWGJE/Core/JetDeclustering.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -45,16 +47,17 @@ struct JetSubstructure {
   OutputObj<TH1F> hZg{"h_jet_zg"};
   OutputObj<TH1F> hRg{"h_jet_rg"};
   OutputObj<TH1F> hNsd{"h_jet_nsd"};
+  OutputObj<TH2F> hLundPlane{"h_jet_lund_plane"};
 
   Configurable<float> f_jetPtMin{"f_jetPtMin", 0.0, "minimum jet pT cut"};
   Configurable<float> f_zCut{"f_zCut", 0.1, "soft drop z cut"};
   Configurable<float> f_beta{"f_beta", 0.0, "soft drop beta"};
   Configurable<float> f_jetR{"f_jetR", 0.4, "jer resolution parameter"}; //possible to get configurable from another task? jetR
   Configurable<bool> b_DoConstSub{"b_DoConstSub", false, "do constituent subtraction"};
+  Configurable<bool> b_DoLundPlane{"b_DoLundPlane", false, "fill the primary Lund plane of the jets"};
 
   std::vector<fastjet::PseudoJet> jetConstituents;
-  std::vector<fastjet::PseudoJet> jetReclustered;
-  JetFinder jetReclusterer;
+  JetDeclustering jetDeclusterer;
 
   void init(InitContext const&)
   {
@@ -64,9 +67,12 @@ struct JetSubstructure {
                            10, 0.0, 0.5));
     hNsd.setObject(new TH1F("h_jet_nsd", "nsd ;nsd",
                             7, -0.5, 6.5));
-    jetReclusterer.isReclustering = true;
-    jetReclusterer.algorithm = fastjet::JetAlgorithm::cambridge_algorithm;
-    jetReclusterer.jetR = f_jetR * 2.5;
+    if (b_DoLundPlane) {
+      hLundPlane.setObject(new TH2F("h_jet_lund_plane", "primary Lund plane;ln(1/#DeltaR);ln(k_{T}/GeV)",
+                                    40, 0., 8., 50, -6., 6.));
+    }
+    // Cambridge/Aachen reclustering without area, the splittings of the jet are walked once for all the observables
+    jetDeclusterer.setReclusteringR(f_jetR * 2.5);
   }
 
   //Filter jetCuts = aod::jet::pt > f_jetPtMin; //how does this work?
@@ -77,7 +83,6 @@ struct JetSubstructure {
                aod::JetConstituentsSub const& constituentsSub)
   {
     jetConstituents.clear();
-    jetReclustered.clear();
     if (b_DoConstSub) {
       for (const auto& constituent : constituentsSub) {
         fillConstituents(constituent, jetConstituents);
@@ -88,32 +93,21 @@ struct JetSubstructure {
         fillConstituents(constituent, jetConstituents);
       }
     }
-    fastjet::ClusterSequenceArea clusterSeq(jetReclusterer.findJets(jetConstituents, jetReclustered));
-    jetReclustered = sorted_by_pt(jetReclustered);
-    fastjet::PseudoJet daughterSubJet = jetReclustered[0];
-    fastjet::PseudoJet parentSubJet1;
-    fastjet::PseudoJet parentSubJet2;
-    bool softDropped = false;
-    int nsd = 0.0;
-    auto zg = -1.0;
-    auto rg = -1.0;
-    while (daughterSubJet.has_parents(parentSubJet1, parentSubJet2)) {
-      if (parentSubJet1.perp() < parentSubJet2.perp()) {
-        std::swap(parentSubJet1, parentSubJet2);
-      }
-      auto z = parentSubJet2.perp() / (parentSubJet1.perp() + parentSubJet2.perp());
-      auto r = parentSubJet1.delta_R(parentSubJet2);
-      if (z >= f_zCut * TMath::Power(r / f_jetR, f_beta)) {
-        if (!softDropped) {
-          zg = z;
-          rg = r;
-          hZg->Fill(zg);
-          hRg->Fill(rg);
-          softDropped = true;
+    const auto& splittings = jetDeclusterer.decluster(jetConstituents);
+    if (b_DoLundPlane) {
+      for (const auto& splitting : splittings) {
+        if (splitting.deltaR > 0. && splitting.kt > 0.) {
+          hLundPlane->Fill(std::log(1. / splitting.deltaR), std::log(splitting.kt));
         }
-        nsd++;
       }
-      daughterSubJet = parentSubJet1;
+    }
+    auto softDrop = jetDeclusterer.softDrop(f_zCut, f_beta, f_jetR);
+    auto zg = softDrop.zg;
+    auto rg = softDrop.rg;
+    auto nsd = softDrop.nsd;
+    if (nsd > 0) {
+      hZg->Fill(zg);
+      hRg->Fill(rg);
     }
     hNsd->Fill(nsd);
     jetSubstructure(zg, rg, nsd);
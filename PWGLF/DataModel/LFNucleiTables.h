@@ -15,6 +15,10 @@
 /// \author Rutuparna Rath <rutuparna.rath@cern.ch> and Giovanni Malfattore <giovanni.malfattore@cern.ch>
 ///
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/ASoAHelpers.h"
 
@@ -133,5 +137,97 @@ DECLARE_SOA_TABLE(LfCandNucleusMC, "AOD", "LFNUCLMC",
                   full::IsPhysicalPrimary,
                   full::ProducedByGenerator);
 
+namespace compact
+{
+/// Quantization of the float columns: value = bin_width * binned, clamped to the range of binned_t
+struct binningNSigma {
+  typedef int8_t binned_t;
+  static constexpr float bin_width = 0.1f; // from -12.8 to 12.7
+};
+struct binningDca {
+  typedef int16_t binned_t;
+  static constexpr float bin_width = 1.e-4f; // 1 um, from -3.2768 cm to 3.2767 cm
+};
+struct binningTPCSignal {
+  typedef uint16_t binned_t;
+  static constexpr float bin_width = 0.05f; // up to 3276.75
+};
+struct binningBeta {
+  typedef int16_t binned_t;
+  static constexpr float bin_width = 1.e-4f; // -1 without TOF
+};
+
+/// Quantized value of a float column
+template <typename binningType>
+typename binningType::binned_t pack(float value)
+{
+  constexpr float minBin = static_cast<float>(std::numeric_limits<typename binningType::binned_t>::lowest());
+  constexpr float maxBin = static_cast<float>(std::numeric_limits<typename binningType::binned_t>::max());
+  return static_cast<typename binningType::binned_t>(std::clamp(std::round(value / binningType::bin_width), minBin, maxBin));
+}
+
+/// Float value of a quantized column
+template <typename binningType>
+float unpack(typename binningType::binned_t binned)
+{
+  return binningType::bin_width * static_cast<float>(binned);
+}
+
+DECLARE_SOA_COLUMN(CandidateMask, candidateMask, uint8_t);                       //! nuclei species passing the prefilter, one bit per species of o2::analysis::nuclei::PrefilterSpecies
+DECLARE_SOA_COLUMN(Sign, sign, int8_t);                                          //! charge sign
+DECLARE_SOA_COLUMN(TPCNClsCrossedRows, tpcNClsCrossedRows, uint8_t);             //! number of TPC crossed rows
+DECLARE_SOA_COLUMN(DcaXYStore, dcaXYStore, binningDca::binned_t);                //! quantized DCAxy
+DECLARE_SOA_COLUMN(DcaZStore, dcaZStore, binningDca::binned_t);                  //! quantized DCAz
+DECLARE_SOA_COLUMN(TPCSignalStore, tpcSignalStore, binningTPCSignal::binned_t);  //! quantized TPC signal
+DECLARE_SOA_COLUMN(BetaStore, betaStore, binningBeta::binned_t);                 //! quantized TOF beta
+DECLARE_SOA_COLUMN(TPCNSigmaStoreDe, tpcNSigmaStoreDe, binningNSigma::binned_t); //! quantized TPC nsigma of deuteron
+DECLARE_SOA_COLUMN(TPCNSigmaStoreTr, tpcNSigmaStoreTr, binningNSigma::binned_t); //! quantized TPC nsigma of triton
+DECLARE_SOA_COLUMN(TPCNSigmaStoreHe, tpcNSigmaStoreHe, binningNSigma::binned_t); //! quantized TPC nsigma of helium3
+DECLARE_SOA_COLUMN(TPCNSigmaStoreAl, tpcNSigmaStoreAl, binningNSigma::binned_t); //! quantized TPC nsigma of alpha
+DECLARE_SOA_COLUMN(TOFNSigmaStoreDe, tofNSigmaStoreDe, binningNSigma::binned_t); //! quantized TOF nsigma of deuteron
+DECLARE_SOA_COLUMN(TOFNSigmaStoreTr, tofNSigmaStoreTr, binningNSigma::binned_t); //! quantized TOF nsigma of triton
+DECLARE_SOA_COLUMN(TOFNSigmaStoreHe, tofNSigmaStoreHe, binningNSigma::binned_t); //! quantized TOF nsigma of helium3
+DECLARE_SOA_COLUMN(TOFNSigmaStoreAl, tofNSigmaStoreAl, binningNSigma::binned_t); //! quantized TOF nsigma of alpha
+DECLARE_SOA_DYNAMIC_COLUMN(DcaXY, dcaXY, [](binningDca::binned_t binned) -> float { return unpack<binningDca>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(DcaZ, dcaZ, [](binningDca::binned_t binned) -> float { return unpack<binningDca>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(TPCSignal, tpcSignal, [](binningTPCSignal::binned_t binned) -> float { return unpack<binningTPCSignal>(binned); });
+DECLARE_SOA_DYNAMIC_COLUMN(Beta, beta, [](binningBeta::binned_t binned) -> float { return unpack<binningBeta>(binned); });
+#define DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(COLUMN, COLUMN_NAME) \
+  DECLARE_SOA_DYNAMIC_COLUMN(COLUMN, COLUMN_NAME, [](binningNSigma::binned_t binned) -> float { return unpack<binningNSigma>(binned); });
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TPCNSigmaDe, tpcNSigmaDe);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TPCNSigmaTr, tpcNSigmaTr);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TPCNSigmaHe, tpcNSigmaHe);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TPCNSigmaAl, tpcNSigmaAl);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TOFNSigmaDe, tofNSigmaDe);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TOFNSigmaTr, tofNSigmaTr);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TOFNSigmaHe, tofNSigmaHe);
+DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN(TOFNSigmaAl, tofNSigmaAl);
+#undef DECLARE_NUCLEI_UNWRAP_NSIGMA_COLUMN
+} // namespace compact
+
+// Nuclei candidates passing the prefilter, with quantized PID and DCA
+DECLARE_SOA_TABLE(LfCandNucleusCompact, "AOD", "LFNUCLCOMPACT",
+                  o2::soa::Index<>,
+                  full::LfCandNucleusFullEventId,
+                  compact::CandidateMask,
+                  full::Pt,
+                  full::Eta,
+                  full::Phi,
+                  compact::Sign,
+                  full::TPCInnerParam,
+                  full::HasTOF,
+                  compact::TPCNClsCrossedRows,
+                  compact::DcaXYStore, compact::DcaZStore,
+                  compact::TPCSignalStore, compact::BetaStore,
+                  compact::TPCNSigmaStoreDe, compact::TPCNSigmaStoreTr, compact::TPCNSigmaStoreHe, compact::TPCNSigmaStoreAl,
+                  compact::TOFNSigmaStoreDe, compact::TOFNSigmaStoreTr, compact::TOFNSigmaStoreHe, compact::TOFNSigmaStoreAl,
+                  compact::DcaXY<compact::DcaXYStore>, compact::DcaZ<compact::DcaZStore>,
+                  compact::TPCSignal<compact::TPCSignalStore>, compact::Beta<compact::BetaStore>,
+                  compact::TPCNSigmaDe<compact::TPCNSigmaStoreDe>, compact::TPCNSigmaTr<compact::TPCNSigmaStoreTr>,
+                  compact::TPCNSigmaHe<compact::TPCNSigmaStoreHe>, compact::TPCNSigmaAl<compact::TPCNSigmaStoreAl>,
+                  compact::TOFNSigmaDe<compact::TOFNSigmaStoreDe>, compact::TOFNSigmaTr<compact::TOFNSigmaStoreTr>,
+                  compact::TOFNSigmaHe<compact::TOFNSigmaStoreHe>, compact::TOFNSigmaAl<compact::TOFNSigmaStoreAl>);
+using LfCandNucleusCompactTrack = LfCandNucleusCompact::iterator;
+
 } // namespace o2::aod
 #endif // PWGLF_DATAMODEL_LFNUCLEITABLES_H_
@@ -19,6 +19,7 @@
 ///
 
 #include "PWGLF/DataModel/LFNucleiTables.h"
+#include "PWGLF/Utils/nucleiPrefilter.h"
 
 #include "ReconstructionDataFormats/Track.h"
 #include "Framework/runDataProcessing.h"
@@ -43,18 +44,32 @@
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
+using namespace o2::analysis::nuclei;
+
+namespace
+{
+// TPC band of +-3 sigma, TOF band of +-3 sigma required above the TPC momentum at which the TPC separation fades
+static constexpr float defaultPrefilterParameters[kNPrefilterSpecies][kNPrefilterParameters]{{1, -3, 3, 1.0, 3},
+                                                                                             {1, -3, 3, 1.4, 3},
+                                                                                             {1, -3, 3, 100, 3},
+                                                                                             {1, -3, 3, 100, 3}};
+} // namespace
 
 /// Writes the full information in an output TTree
 struct LfTreeCreatorNuclei {
   Produces<o2::aod::LfCandNucleusFullEvents> tableEvents;
   Produces<o2::aod::LfCandNucleusFull> tableCandidate;
   Produces<o2::aod::LfCandNucleusMC> tableCandidateMC;
+  Produces<o2::aod::LfCandNucleusCompact> tableCandidateCompact;
 
   void init(o2::framework::InitContext&)
   {
     if (doprocessData == true && doprocessMC == true) {
       LOGF(fatal, "Cannot enable processData and processMC at the same time. Please choose one.");
     }
+    if (usePrefilter || writeCompactTable) {
+      prefilter.setParameters(prefilterParameters);
+    }
   }
 
   // track
@@ -68,6 +83,13 @@ struct LfTreeCreatorNuclei {
   // events
   Configurable<float> cfgCutVertex{"cfgCutVertex", 10.0f, "Accepted z-vertex range"};
   Configurable<bool> useEvsel{"useEvsel", true, "Use sel8 for run3 Event Selection"};
+  // output
+  Configurable<bool> usePrefilter{"usePrefilter", false, "Write only the tracks passing the nuclei prefilter"};
+  Configurable<LabeledArray<float>> prefilterParameters{"prefilterParameters", {defaultPrefilterParameters[0], kNPrefilterSpecies, kNPrefilterParameters, prefilterSpeciesNames, prefilterParameterNames}, "Nuclei prefilter: TPC nsigma band, and TOF nsigma band above pTOF (TPC momentum)"};
+  Configurable<bool> writeFullTable{"writeFullTable", true, "Write the candidates to the full precision table"};
+  Configurable<bool> writeCompactTable{"writeCompactTable", false, "Write the candidates to the compact table with quantized PID and DCA, and their prefilter mask"};
+
+  NucleiPrefilter prefilter;
 
   Filter collisionFilter = nabs(aod::collision::posZ) < cfgCutVertex;
   // Filter trackFilter = (nabs(aod::track::eta) < cfgCutEta) && (requireGlobalTrackInFilter());
@@ -97,12 +119,48 @@ struct LfTreeCreatorNuclei {
                 collision.sel8(),
                 collision.bc().runNumber());
 
+    // Candidate species of all the tracks, in one pass over their PID columns
+    const std::vector<uint8_t>* masks = nullptr;
+    if (usePrefilter || writeCompactTable) {
+      masks = &prefilter.evaluate(tracks);
+    }
+
     // Filling candidate properties
-    tableCandidate.reserve(tracks.size());
-    if constexpr (isMC) {
-      tableCandidateMC.reserve(tracks.size());
+    if (writeFullTable) {
+      tableCandidate.reserve(tracks.size());
+      if constexpr (isMC) {
+        tableCandidateMC.reserve(tracks.size());
+      }
     }
+    std::size_t iTrack = 0;
     for (auto& track : tracks) {
+      const uint8_t mask = masks ? (*masks)[iTrack] : 0;
+      iTrack++;
+      if (usePrefilter && mask == 0) {
+        continue;
+      }
+      if (writeCompactTable) {
+        using namespace o2::aod::compact;
+        tableCandidateCompact(
+          tableEvents.lastIndex(),
+          mask,
+          track.pt(),
+          track.eta(),
+          track.phi(),
+          static_cast<int8_t>(track.sign()),
+          track.tpcInnerParam(),
+          track.hasTOF(),
+          static_cast<uint8_t>(track.tpcNClsCrossedRows()),
+          pack<binningDca>(track.dcaXY()), pack<binningDca>(track.dcaZ()),
+          pack<binningTPCSignal>(track.tpcSignal()), pack<binningBeta>(track.beta()),
+          pack<binningNSigma>(track.tpcNSigmaDe()), pack<binningNSigma>(track.tpcNSigmaTr()),
+          pack<binningNSigma>(track.tpcNSigmaHe()), pack<binningNSigma>(track.tpcNSigmaAl()),
+          pack<binningNSigma>(track.tofNSigmaDe()), pack<binningNSigma>(track.tofNSigmaTr()),
+          pack<binningNSigma>(track.tofNSigmaHe()), pack<binningNSigma>(track.tofNSigmaAl()));
+      }
+      if (!writeFullTable) {
+        continue;
+      }
       // auto const& mcParticle = track.mcParticle();
       tableCandidate(
         tableEvents.lastIndex(),
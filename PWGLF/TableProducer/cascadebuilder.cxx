@@ -34,6 +34,7 @@
 #include <cmath>
 #include <array>
 #include <cstdlib>
+#include <unordered_map>
 
 #include "Framework/runDataProcessing.h"
 #include "Framework/AnalysisTask.h"
@@ -46,6 +47,7 @@
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
+#include "PWGLF/Utils/mcAncestryIndex.h"
 #include "DetectorsBase/Propagator.h"
 #include "DetectorsBase/GeometryManager.h"
 #include "DataFormatsParameters/GRPObject.h"
@@ -113,6 +115,21 @@ struct cascadeBuilder {
   float maxSnp;  // max sine phi for propagation
   float maxStep; // max step size (cm) for propagation
   o2::base::MatLayerCylSet* lut = nullptr;
+  o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrNONE;
+
+  // Define o2 fitters, 2-prong, active memory (no need to redefine per event)
+  o2::vertexing::DCAFitterN<2> fitterV0, fitterCasc;
+
+  // V0 fit used by the cascades, kept for the other cascades sharing the same V0
+  struct V0Fit {
+    bool valid;
+    std::array<float, 3> pos;
+    std::array<float, 3> pvecpos;
+    std::array<float, 3> pvecneg;
+    float chi2PCA;
+    o2::track::TrackParCov track; // V0 at its decay vertex, without bending
+  };
+  std::unordered_map<int64_t, V0Fit> v0Cache; // V0 fits of the collision, by V0Datas index
 
   void init(InitContext& context)
   {
@@ -133,6 +150,23 @@ struct cascadeBuilder {
     if (!o2::base::GeometryManager::isGeometryLoaded()) {
       ccdb->get<TGeoManager>(geoPath);
     }
+
+    for (auto* fitter : {&fitterV0, &fitterCasc}) {
+      fitter->setPropagateToPCA(true);
+      fitter->setMaxR(200.);
+      fitter->setMinParamChange(1e-3);
+      fitter->setMinRelChi2Change(0.9);
+      fitter->setMaxDZIni(1e9);
+      fitter->setMaxChi2(1e9);
+      fitter->setUseAbsDCA(d_UseAbsDCA);
+      fitter->setWeightedFinalPCA(d_UseWeightedPCA);
+    }
+
+    // Material corrections of the propagation closer to the minimum
+    if (useMatCorrType == 1)
+      matCorr = o2::base::Propagator::MatCorrType::USEMatCorrTGeo;
+    if (useMatCorrType == 2)
+      matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
   }
 
   void initCCDB(aod::BCsWithTimestamps::iterator const& bc)
@@ -169,33 +203,94 @@ struct cascadeBuilder {
     }
     o2::base::Propagator::Instance()->setMatLUT(lut);
     mRunNumber = bc.runNumber();
+    // Set magnetic field value once known
+    fitterV0.setBz(d_bz);
+    fitterCasc.setBz(d_bz);
   }
 
+  /// Fit of the V0 of a cascade, done once per V0 and reused by all the cascades sharing it
   template <class TCascTracksTo>
-  void buildCascadeTable(aod::Collision const& collision, aod::V0Datas const& v0data, aod::Cascades const& cascades, Bool_t lRun3 = kTRUE)
+  V0Fit const& getV0Fit(int64_t v0Index, TCascTracksTo const& posTrackCast, TCascTracksTo const& negTrackCast)
   {
+    auto [cached, isNew] = v0Cache.try_emplace(v0Index);
+    V0Fit& v0Fit = cached->second;
+    if (!isNew) {
+      return v0Fit;
+    }
+    v0Fit.valid = false;
+
+    // Acquire basic tracks
+    auto pTrack = getTrackParCov(posTrackCast);
+    auto nTrack = getTrackParCov(negTrackCast);
+    // Act on copies for minimization
+    auto pTrackCopy = o2::track::TrackParCov(pTrack);
+    auto nTrackCopy = o2::track::TrackParCov(nTrack);
+
+    int nCand = fitterV0.process(pTrackCopy, nTrackCopy);
+    if (nCand == 0) {
+      return v0Fit;
+    }
+    fitterV0.propagateTracksToVertex();
+    double finalXpos = fitterV0.getTrack(0).getX();
+    double finalXneg = fitterV0.getTrack(1).getX();
 
-    // Define o2 fitter, 2-prong
-    o2::vertexing::DCAFitterN<2> fitterV0, fitterCasc;
-    fitterV0.setBz(d_bz);
-    fitterV0.setPropagateToPCA(true);
-    fitterV0.setMaxR(200.);
-    fitterV0.setMinParamChange(1e-3);
-    fitterV0.setMinRelChi2Change(0.9);
-    fitterV0.setMaxDZIni(1e9);
-    fitterV0.setMaxChi2(1e9);
-    fitterV0.setUseAbsDCA(d_UseAbsDCA);
-    fitterV0.setWeightedFinalPCA(d_UseWeightedPCA);
+    // Rotate to desired alpha
+    pTrack.rotateParam(fitterV0.getTrack(0).getAlpha());
+    nTrack.rotateParam(fitterV0.getTrack(1).getAlpha());
 
-    fitterCasc.setBz(d_bz);
-    fitterCasc.setPropagateToPCA(true);
-    fitterCasc.setMaxR(200.);
-    fitterCasc.setMinParamChange(1e-3);
-    fitterCasc.setMinRelChi2Change(0.9);
-    fitterCasc.setMaxDZIni(1e9);
-    fitterCasc.setMaxChi2(1e9);
-    fitterCasc.setUseAbsDCA(d_UseAbsDCA);
-    fitterCasc.setWeightedFinalPCA(d_UseWeightedPCA);
+    // Retry closer to minimum with material corrections
+    o2::base::Propagator::Instance()->propagateToX(pTrack, finalXpos, d_bz, maxSnp, maxStep, matCorr);
+    o2::base::Propagator::Instance()->propagateToX(nTrack, finalXneg, d_bz, maxSnp, maxStep, matCorr);
+
+    nCand = fitterV0.process(pTrack, nTrack);
+    if (nCand == 0) {
+      return v0Fit;
+    }
+
+    fitterV0.propagateTracksToVertex();
+    const auto& v0vtx = fitterV0.getPCACandidate();
+    for (int i = 0; i < 3; i++) {
+      v0Fit.pos[i] = v0vtx[i];
+    }
+
+    std::array<float, 21> cov0 = {0};
+    std::array<float, 21> cov1 = {0};
+    std::array<float, 21> covV0 = {0};
+
+    // Covariance matrix calculation
+    const int momInd[6] = {9, 13, 14, 18, 19, 20}; // cov matrix elements for momentum component
+    fitterV0.getTrack(0).getPxPyPzGlo(v0Fit.pvecpos);
+    fitterV0.getTrack(1).getPxPyPzGlo(v0Fit.pvecneg);
+    fitterV0.getTrack(0).getCovXYZPxPyPzGlo(cov0);
+    fitterV0.getTrack(1).getCovXYZPxPyPzGlo(cov1);
+    for (int i = 0; i < 6; i++) {
+      int j = momInd[i];
+      covV0[j] = cov0[j] + cov1[j];
+    }
+    auto covVtxV0 = fitterV0.calcPCACovMatrix();
+    covV0[0] = covVtxV0(0, 0);
+    covV0[1] = covVtxV0(1, 0);
+    covV0[2] = covVtxV0(1, 1);
+    covV0[3] = covVtxV0(2, 0);
+    covV0[4] = covVtxV0(2, 1);
+    covV0[5] = covVtxV0(2, 2);
+
+    const std::array<float, 3> vertex = {static_cast<float>(v0vtx[0]), static_cast<float>(v0vtx[1]), static_cast<float>(v0vtx[2])};
+    const std::array<float, 3> momentum = {v0Fit.pvecpos[0] + v0Fit.pvecneg[0], v0Fit.pvecpos[1] + v0Fit.pvecneg[1], v0Fit.pvecpos[2] + v0Fit.pvecneg[2]};
+
+    v0Fit.track = o2::track::TrackParCov(vertex, momentum, covV0, 0);
+    v0Fit.track.setQ2Pt(0); // No bending, please
+    v0Fit.chi2PCA = fitterV0.getChi2AtPCACandidate();
+    v0Fit.valid = true;
+    return v0Fit;
+  }
+
+  template <class TCascTracksTo>
+  void buildCascadeTable(aod::Collision const& collision, aod::V0Datas const& v0data, aod::Cascades const& cascades, Bool_t lRun3 = kTRUE)
+  {
+
+    // the cascades of the collision sharing a V0 reuse its fit
+    v0Cache.clear();
 
     for (auto& casc : cascades) {
       auto v0 = casc.v0_as<o2::aod::V0sLinked>();
@@ -287,122 +382,57 @@ struct cascadeBuilder {
       hCascCandidate->Fill(15.5);
 
       auto charge = -1;
-      std::array<float, 3> pos = {0.};
       std::array<float, 3> posXi = {0.};
-      std::array<float, 3> pvecpos = {0.};
-      std::array<float, 3> pvecneg = {0.};
       std::array<float, 3> pvecbach = {0.};
 
-      // Acquire basic tracks
-      auto pTrack = getTrackParCov(posTrackCast);
-      auto nTrack = getTrackParCov(negTrackCast);
+      const auto& v0Fit = getV0Fit(v0data.globalIndex(), posTrackCast, negTrackCast);
+      if (!v0Fit.valid) {
+        // cascdataLink(-1);
+        continue;
+      }
+
       auto bTrack = getTrackParCov(bachTrackCast);
       if (bachTrackCast.signed1Pt() > 0) {
         charge = +1;
       }
+      auto tV0 = o2::track::TrackParCov(v0Fit.track);
+
       // Act on copies for minimization
-      auto pTrackCopy = o2::track::TrackParCov(pTrack);
-      auto nTrackCopy = o2::track::TrackParCov(nTrack);
-
-      int nCand = fitterV0.process(pTrackCopy, nTrackCopy);
-      if (nCand != 0) {
-        fitterV0.propagateTracksToVertex();
-        double finalXpos = fitterV0.getTrack(0).getX();
-        double finalXneg = fitterV0.getTrack(1).getX();
-
-        // Rotate to desired alpha
-        pTrack.rotateParam(fitterV0.getTrack(0).getAlpha());
-        nTrack.rotateParam(fitterV0.getTrack(1).getAlpha());
-
-        // Retry closer to minimum with material corrections
-        o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrNONE;
-        if (useMatCorrType == 1)
-          matCorr = o2::base::Propagator::MatCorrType::USEMatCorrTGeo;
-        if (useMatCorrType == 2)
-          matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
-
-        o2::base::Propagator::Instance()->propagateToX(pTrack, finalXpos, d_bz, maxSnp, maxStep, matCorr);
-        o2::base::Propagator::Instance()->propagateToX(nTrack, finalXneg, d_bz, maxSnp, maxStep, matCorr);
-
-        nCand = fitterV0.process(pTrack, nTrack);
-        if (nCand == 0) {
-          continue;
-        }
+      auto tV0Copy = o2::track::TrackParCov(tV0);
+      auto bTrackCopy = o2::track::TrackParCov(bTrack);
+      int nCand2 = 0;
+      try {
+        nCand2 = fitterCasc.process(tV0Copy, bTrackCopy);
+        registry.fill(HIST("hCatchedExceptions"), 0.5f);
+      } catch (...) {
+        registry.fill(HIST("hCatchedExceptions"), 1.5f);
+        LOG(error) << "Exception caught in fitterCasc.process";
+      }
 
-        fitterV0.propagateTracksToVertex();
-        const auto& v0vtx = fitterV0.getPCACandidate();
-        for (int i = 0; i < 3; i++) {
-          pos[i] = v0vtx[i];
-        }
+      if (nCand2 == 0) {
+        continue;
+      }
+      double finalXv0 = fitterCasc.getTrack(0).getX();
+      double finalXbach = fitterCasc.getTrack(1).getX();
 
-        std::array<float, 21> cov0 = {0};
-        std::array<float, 21> cov1 = {0};
-        std::array<float, 21> covV0 = {0};
-
-        // Covariance matrix calculation
-        const int momInd[6] = {9, 13, 14, 18, 19, 20}; // cov matrix elements for momentum component
-        fitterV0.getTrack(0).getPxPyPzGlo(pvecpos);
-        fitterV0.getTrack(1).getPxPyPzGlo(pvecneg);
-        fitterV0.getTrack(0).getCovXYZPxPyPzGlo(cov0);
-        fitterV0.getTrack(1).getCovXYZPxPyPzGlo(cov1);
-        for (int i = 0; i < 6; i++) {
-          int j = momInd[i];
-          covV0[j] = cov0[j] + cov1[j];
-        }
-        auto covVtxV0 = fitterV0.calcPCACovMatrix();
-        covV0[0] = covVtxV0(0, 0);
-        covV0[1] = covVtxV0(1, 0);
-        covV0[2] = covVtxV0(1, 1);
-        covV0[3] = covVtxV0(2, 0);
-        covV0[4] = covVtxV0(2, 1);
-        covV0[5] = covVtxV0(2, 2);
-
-        const std::array<float, 3> vertex = {static_cast<float>(v0vtx[0]), static_cast<float>(v0vtx[1]), static_cast<float>(v0vtx[2])};
-        const std::array<float, 3> momentum = {pvecpos[0] + pvecneg[0], pvecpos[1] + pvecneg[1], pvecpos[2] + pvecneg[2]};
-
-        auto tV0 = o2::track::TrackParCov(vertex, momentum, covV0, 0);
-        tV0.setQ2Pt(0); // No bending, please
-
-        // Act on copies for minimization
-        auto tV0Copy = o2::track::TrackParCov(tV0);
-        auto bTrackCopy = o2::track::TrackParCov(bTrack);
-        int nCand2 = 0;
-        try {
-          nCand2 = fitterCasc.process(tV0Copy, bTrackCopy);
-          registry.fill(HIST("hCatchedExceptions"), 0.5f);
-        } catch (...) {
-          registry.fill(HIST("hCatchedExceptions"), 1.5f);
-          LOG(error) << "Exception caught in fitterCasc.process";
-        }
+      // Rotate to desired alpha
+      tV0.rotateParam(fitterCasc.getTrack(0).getAlpha());
+      bTrack.rotateParam(fitterCasc.getTrack(1).getAlpha());
+
+      o2::base::Propagator::Instance()->propagateToX(tV0, finalXv0, d_bz, maxSnp, maxStep, matCorr);
+      // No material correction in V0 backpropagation to minimum
+      o2::base::Propagator::Instance()->propagateToX(bTrack, finalXbach, d_bz, maxSnp, maxStep, o2::base::Propagator::MatCorrType::USEMatCorrNONE);
 
-        if (nCand2 == 0) {
-          continue;
+      nCand2 = fitterCasc.process(tV0, bTrack);
+      if (nCand2 != 0) {
+        fitterCasc.propagateTracksToVertex();
+        hCascCandidate->Fill(2.5);
+        const auto& cascvtx = fitterCasc.getPCACandidate();
+        for (int i = 0; i < 3; i++) {
+          posXi[i] = cascvtx[i];
         }
-        double finalXv0 = fitterCasc.getTrack(0).getX();
-        double finalXbach = fitterCasc.getTrack(1).getX();
-
-        // Rotate to desired alpha
-        tV0.rotateParam(fitterCasc.getTrack(0).getAlpha());
-        bTrack.rotateParam(fitterCasc.getTrack(1).getAlpha());
-
-        o2::base::Propagator::Instance()->propagateToX(tV0, finalXv0, d_bz, maxSnp, maxStep, matCorr);
-        // No material correction in V0 backpropagation to minimum
-        o2::base::Propagator::Instance()->propagateToX(bTrack, finalXbach, d_bz, maxSnp, maxStep, o2::base::Propagator::MatCorrType::USEMatCorrNONE);
-
-        nCand2 = fitterCasc.process(tV0, bTrack);
-        if (nCand2 != 0) {
-          fitterCasc.propagateTracksToVertex();
-          hCascCandidate->Fill(2.5);
-          const auto& cascvtx = fitterCasc.getPCACandidate();
-          for (int i = 0; i < 3; i++) {
-            posXi[i] = cascvtx[i];
-          }
-          fitterCasc.getTrack(1).getPxPyPzGlo(pvecbach);
-        } // end if cascade recoed
-      } else {
-        // cascdataLink(-1);
-        continue;
-      }
+        fitterCasc.getTrack(1).getPxPyPzGlo(pvecbach);
+      } // end if cascade recoed
 
       // Fill table, please
       hCascCandidate->Fill(16.5); // this is the master fill: if this is filled, viable candidate
@@ -416,11 +446,11 @@ struct cascadeBuilder {
         v0.globalIndex(),
         bachTrackCast.globalIndex(),
         casc.collisionId(),
-        charge, posXi[0], posXi[1], posXi[2], pos[0], pos[1], pos[2],
-        pvecpos[0], pvecpos[1], pvecpos[2],
-        pvecneg[0], pvecneg[1], pvecneg[2],
+        charge, posXi[0], posXi[1], posXi[2], v0Fit.pos[0], v0Fit.pos[1], v0Fit.pos[2],
+        v0Fit.pvecpos[0], v0Fit.pvecpos[1], v0Fit.pvecpos[2],
+        v0Fit.pvecneg[0], v0Fit.pvecneg[1], v0Fit.pvecneg[2],
         pvecbach[0], pvecbach[1], pvecbach[2],
-        fitterV0.getChi2AtPCACandidate(), fitterCasc.getChi2AtPCACandidate(),
+        v0Fit.chi2PCA, fitterCasc.getChi2AtPCACandidate(),
         posTrackCast.dcaXY(),
         negTrackCast.dcaXY(),
         bachTrackCast.dcaXY());
@@ -478,8 +508,14 @@ struct cascadeLabelBuilder {
   }
   PROCESS_SWITCH(cascadeLabelBuilder, processDoNotBuildLabels, "Do not produce MC label tables", true);
 
-  void processBuildLabels(aod::Collision const& collision, aod::CascDataExt const& casctable, aod::V0sLinked const&, aod::V0Datas const& v0table, LabeledTracks const&, aod::McParticles const&)
+  o2::analysis::strangeness::McAncestryIndex mcAncestry; // mothers of the MC particles and labels of the tracks of the dataframe
+
+  void processBuildLabels(aod::CascDataExt const& casctable, aod::V0sLinked const&, aod::V0Datas const& v0table, LabeledTracks const& tracks, aod::McParticles const& particlesMC)
   {
+    // the MC ancestry is indexed once per dataframe, the cascades of all the collisions are then labelled with array lookups
+    mcAncestry.buildMothers(particlesMC);
+    mcAncestry.buildLabels(tracks);
+
     for (auto& casc : casctable) {
       float lFillVal = 0.5f; // all considered V0s
       // Loop over those that actually have the corresponding V0 associated to them
@@ -495,41 +531,31 @@ struct cascadeLabelBuilder {
       float lPt = -1;
       lFillVal = 1.5f; // all considered V0s
 
-      // Acquire all three daughter tracks, please
-      auto lBachTrack = casc.bachelor_as<LabeledTracks>();
-      auto lNegTrack = v0data.negTrack_as<LabeledTracks>();
-      auto lPosTrack = v0data.posTrack_as<LabeledTracks>();
+      // MC particles of all three daughter tracks, please
+      auto lMCBach = mcAncestry.label(casc.bachelorId());
+      auto lMCNeg = mcAncestry.label(v0data.negTrackId());
+      auto lMCPos = mcAncestry.label(v0data.posTrackId());
 
       // Association check
-      // There might be smarter ways of doing this in the future
-      if (lNegTrack.has_mcParticle() && lPosTrack.has_mcParticle() && lBachTrack.has_mcParticle()) {
-        auto lMCBachTrack = lBachTrack.mcParticle_as<aod::McParticles>();
-        auto lMCNegTrack = lNegTrack.mcParticle_as<aod::McParticles>();
-        auto lMCPosTrack = lPosTrack.mcParticle_as<aod::McParticles>();
+      if (lMCNeg >= 0 && lMCPos >= 0 && lMCBach >= 0) {
         lFillVal = 2.5f;
 
         // Step 1: check if the mother is the same, go up a level
-        if (lMCNegTrack.has_mothers() && lMCPosTrack.has_mothers()) {
+        if (mcAncestry.hasMothers(lMCNeg) && mcAncestry.hasMothers(lMCPos)) {
           lFillVal = 3.5f;
-          for (auto& lNegMother : lMCNegTrack.mothers_as<aod::McParticles>()) {
-            for (auto& lPosMother : lMCPosTrack.mothers_as<aod::McParticles>()) {
-              if (lNegMother == lPosMother) {
-                // if we got to this level, it means the mother particle exists and is the same
-                // now we have to go one level up and compare to the bachelor mother too
-                lFillVal = 4.5f;
-                for (auto& lV0Mother : lNegMother.mothers_as<aod::McParticles>()) {
-                  for (auto& lBachMother : lMCBachTrack.mothers_as<aod::McParticles>()) {
-                    if (lV0Mother == lBachMother) {
-                      lLabel = lV0Mother.globalIndex();
-                      lPt = lV0Mother.pt();
-                      lPDG = lV0Mother.pdgCode();
-                      lFillVal = 5.5f; // v0s with the same mother
-                    }
-                  }
-                } // end conditional V0-bach pair
-              }   // end neg = pos mother conditional
+          if (mcAncestry.commonMother(lMCNeg, lMCPos) >= 0) {
+            // if we got to this level, it means the mother particle exists and is the same
+            // now we have to go one level up and compare to the bachelor mother too
+            lFillVal = 4.5f;
+            auto lMother = mcAncestry.cascadeMother(v0data.negTrackId(), v0data.posTrackId(), casc.bachelorId());
+            if (lMother >= 0) {
+              auto lMCMother = particlesMC.rawIteratorAt(lMother);
+              lLabel = lMother;
+              lPt = lMCMother.pt();
+              lPDG = lMCMother.pdgCode();
+              lFillVal = 5.5f; // v0s with the same mother
             }
-          } // end loop neg/pos mothers
+          } // end neg = pos mother conditional
         }   // end conditional of mothers existing
       }     // end association check
 
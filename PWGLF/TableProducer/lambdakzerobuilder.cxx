@@ -44,6 +44,7 @@
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
+#include "PWGLF/Utils/mcAncestryIndex.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "DetectorsBase/Propagator.h"
@@ -470,9 +471,14 @@ struct lambdakzeroLabelBuilder {
   }
   PROCESS_SWITCH(lambdakzeroLabelBuilder, processDoNotBuildLabels, "Do not produce MC label tables", true);
 
-  void processBuildLabels(aod::Collisions::iterator const& collision, aod::V0Datas const& v0table, LabeledTracks const&, aod::McParticles const& particlesMC)
+  o2::analysis::strangeness::McAncestryIndex mcAncestry; // mothers of the MC particles and labels of the tracks of the dataframe
 
+  void processBuildLabels(aod::V0Datas const& v0table, LabeledTracks const& tracks, aod::McParticles const& particlesMC)
   {
+    // the MC ancestry is indexed once per dataframe, the V0s of all the collisions are then labelled with array lookups
+    mcAncestry.buildMothers(particlesMC);
+    mcAncestry.buildLabels(tracks);
+
     for (auto& v0 : v0table) {
 
       int lLabel = -1;
@@ -480,27 +486,14 @@ struct lambdakzeroLabelBuilder {
       float lPt = -1;
       float lFillVal = 0.5f; // all considered V0s
 
-      auto lNegTrack = v0.negTrack_as<LabeledTracks>();
-      auto lPosTrack = v0.posTrack_as<LabeledTracks>();
-
       // Association check
-      // There might be smarter ways of doing this in the future
-      if (lNegTrack.has_mcParticle() && lPosTrack.has_mcParticle()) {
-        auto lMCNegTrack = lNegTrack.mcParticle_as<aod::McParticles>();
-        auto lMCPosTrack = lPosTrack.mcParticle_as<aod::McParticles>();
-        if (lMCNegTrack.has_mothers() && lMCPosTrack.has_mothers()) {
-
-          for (auto& lNegMother : lMCNegTrack.mothers_as<aod::McParticles>()) {
-            for (auto& lPosMother : lMCPosTrack.mothers_as<aod::McParticles>()) {
-              if (lNegMother.globalIndex() == lPosMother.globalIndex()) {
-                lLabel = lNegMother.globalIndex();
-                lPt = lNegMother.pt();
-                lPDG = lNegMother.pdgCode();
-                lFillVal = 1.5f; // v0s with the same mother
-              }
-            }
-          }
-        }
+      auto lMother = mcAncestry.v0Mother(v0.negTrackId(), v0.posTrackId());
+      if (lMother >= 0) {
+        auto lMCMother = particlesMC.rawIteratorAt(lMother);
+        lLabel = lMother;
+        lPt = lMCMother.pt();
+        lPDG = lMCMother.pdgCode();
+        lFillVal = 1.5f; // v0s with the same mother
       } // end association check
       registry.fill(HIST("hLabelCounter"), lFillVal);
 
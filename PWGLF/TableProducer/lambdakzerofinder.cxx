@@ -33,6 +33,7 @@
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/ASoAHelpers.h"
 #include "DetectorsVertexing/DCAFitterN.h"
+#include "DetectorsVertexing/HelixHelper.h"
 #include "ReconstructionDataFormats/Track.h"
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
@@ -56,6 +57,9 @@
 #include <cmath>
 #include <array>
 #include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -144,6 +148,26 @@ struct lambdakzerofinder {
   Configurable<float> dcav0dau{"dcav0dau", 1.0, "DCA V0 Daughters"};
   Configurable<float> v0radius{"v0radius", 5.0, "v0radius"};
 
+  // Pairing
+  Configurable<float> maxDaughterGapXY{"maxDaughterGapXY", 2.0, "max transverse gap (cm) between the helix circles of the daughters to try the fit, < 0: all pairs are fitted"};
+
+  // Daughter candidate of a collision, with the transverse circle of its helix
+  struct V0Daughter {
+    o2::track::TrackParCov track;
+    o2::track::TrackAuxPar helix;
+    int64_t globalIndex;
+    int collisionId;
+    float dcaXY;
+    float xMin; // transverse extent of the circle along x
+    float xMax;
+  };
+
+  o2::vertexing::DCAFitterN<2> fitter;
+  std::vector<V0Daughter> posDaughters;
+  std::vector<V0Daughter> negDaughters;
+  std::vector<int> negOrder; // negative daughters by increasing xMin
+  std::vector<int> partners; // negative daughters compatible with the current positive daughter
+
   void init(InitContext& context)
   {
     // using namespace analysis::lambdakzerofinder;
@@ -151,6 +175,15 @@ struct lambdakzerofinder {
     ccdb->setURL("https://alice-ccdb.cern.ch");
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
+
+    // Define o2 fitter, 2-prong
+    fitter.setPropagateToPCA(true);
+    fitter.setMaxR(200.);
+    fitter.setMinParamChange(1e-3);
+    fitter.setMinRelChi2Change(0.9);
+    fitter.setMaxDZIni(1e9);
+    fitter.setMaxChi2(1e9);
+    fitter.setUseAbsDCA(d_UseAbsDCA);
   }
 
   float getMagneticField(uint64_t timestamp)
@@ -169,6 +202,39 @@ struct lambdakzerofinder {
     return output;
   }
 
+  /// Transverse distance of closest approach of the circles of two helices, 0 if they cross
+  static float circleGapXY(o2::track::TrackAuxPar const& h0, o2::track::TrackAuxPar const& h1)
+  {
+    float dx = h1.xC - h0.xC;
+    float dy = h1.yC - h0.yC;
+    float dist = std::sqrt(dx * dx + dy * dy);
+    float gapOutside = dist - h0.rC - h1.rC;
+    if (gapOutside > 0.f) {
+      return gapOutside;
+    }
+    float gapInside = std::abs(h0.rC - h1.rC) - dist;
+    return gapInside > 0.f ? gapInside : 0.f;
+  }
+
+  /// Daughter candidates of a collision, with their track parameters computed once
+  template <typename TGoodTracks>
+  void fillDaughters(TGoodTracks const& goodTracks, float bz, std::vector<V0Daughter>& daughters)
+  {
+    daughters.clear();
+    daughters.reserve(goodTracks.size());
+    for (auto& tid : goodTracks) {
+      auto t = tid.template goodTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>();
+      auto& daughter = daughters.emplace_back();
+      daughter.track = getTrackParCov(t);
+      daughter.helix.set(daughter.track, bz);
+      daughter.globalIndex = t.globalIndex();
+      daughter.collisionId = t.collisionId();
+      daughter.dcaXY = tid.dcaXY();
+      daughter.xMin = daughter.helix.xC - daughter.helix.rC;
+      daughter.xMax = daughter.helix.xC + daughter.helix.rC;
+    }
+  }
+
   void process(aod::Collision const& collision, soa::Join<aod::FullTracks, aod::TracksCov> const& tracks,
                aod::V0GoodPosTracks const& ptracks, aod::V0GoodNegTracks const& ntracks, aod::BCsWithTimestamps const&)
   {
@@ -180,29 +246,47 @@ struct lambdakzerofinder {
     } else {
       d_bz = d_bz_input;
     }
-
-    // Define o2 fitter, 2-prong
-    o2::vertexing::DCAFitterN<2> fitter;
     fitter.setBz(d_bz);
-    fitter.setPropagateToPCA(true);
-    fitter.setMaxR(200.);
-    fitter.setMinParamChange(1e-3);
-    fitter.setMinRelChi2Change(0.9);
-    fitter.setMaxDZIni(1e9);
-    fitter.setMaxChi2(1e9);
-    fitter.setUseAbsDCA(d_UseAbsDCA);
+
+    fillDaughters(ptracks, d_bz, posDaughters);
+    fillDaughters(ntracks, d_bz, negDaughters);
+
+    // without field the helices are straight lines: no quick reject
+    const bool quickReject = maxDaughterGapXY >= 0.f && std::abs(d_bz) > 1e-3;
+    const float maxGap = maxDaughterGapXY;
+    negOrder.resize(negDaughters.size());
+    std::iota(negOrder.begin(), negOrder.end(), 0);
+    if (quickReject) {
+      std::sort(negOrder.begin(), negOrder.end(), [this](int a, int b) { return negDaughters[a].xMin < negDaughters[b].xMin; });
+    }
 
     Long_t lNCand = 0;
 
-    for (auto& t0id : ptracks) { // FIXME: turn into combination(...)
-      auto t0 = t0id.goodTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>();
-      auto Track1 = getTrackParCov(t0);
-      for (auto& t1id : ntracks) {
-        auto t1 = t1id.goodTrack_as<soa::Join<aod::FullTracks, aod::TracksCov>>();
-        auto Track2 = getTrackParCov(t1);
+    for (auto& t0 : posDaughters) {
+      // only negative daughters whose circle comes within maxGap of the positive one reach the fitter
+      if (quickReject) {
+        partners.clear();
+        for (auto iNeg : negOrder) {
+          const auto& t1 = negDaughters[iNeg];
+          if (t1.xMin > t0.xMax + maxGap) {
+            break;
+          }
+          if (t1.xMax < t0.xMin - maxGap || circleGapXY(t0.helix, t1.helix) > maxGap) {
+            continue;
+          }
+          partners.push_back(iNeg);
+        }
+        // keep the order of the negative tracks in the output
+        std::sort(partners.begin(), partners.end());
+      } else {
+        partners = negOrder;
+      }
+
+      for (auto iNeg : partners) {
+        const auto& t1 = negDaughters[iNeg];
 
         // Try to progate to dca
-        int nCand = fitter.process(Track1, Track2);
+        int nCand = fitter.process(t0.track, t1.track);
         if (nCand == 0) {
           continue;
         }
@@ -236,14 +320,14 @@ struct lambdakzerofinder {
         }
 
         lNCand++;
-        v0(t0.collisionId(), t0.globalIndex(), t1.globalIndex());
-        v0data(t0.globalIndex(), t1.globalIndex(), t0.collisionId(), 0,
+        v0(t0.collisionId, t0.globalIndex, t1.globalIndex);
+        v0data(t0.globalIndex, t1.globalIndex, t0.collisionId, 0,
                fitter.getTrack(0).getX(), fitter.getTrack(1).getX(),
                pos[0], pos[1], pos[2],
                pvec0[0], pvec0[1], pvec0[2],
                pvec1[0], pvec1[1], pvec1[2],
                fitter.getChi2AtPCACandidate(),
-               t0id.dcaXY(), t1id.dcaXY());
+               t0.dcaXY, t1.dcaXY);
         v0datalink(v0data.lastIndex());
       }
     }
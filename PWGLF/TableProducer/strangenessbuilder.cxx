@@ -42,6 +42,10 @@
 #include <map>
 #include <iterator>
 #include <utility>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "Framework/runDataProcessing.h"
 #include "Framework/RunningWorkflowInfo.h"
@@ -52,6 +56,7 @@
 #include "ReconstructionDataFormats/Track.h"
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
+#include "Common/Core/TableHelper.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
@@ -175,11 +180,9 @@ struct strangenessBuilder {
   o2::track::TrackParCov lPositiveTrack;
   o2::track::TrackParCov lNegativeTrack;
   o2::track::TrackParCov lBachelorTrack;
-  o2::track::TrackParCov lV0Track;
-  o2::track::TrackParCov lCascadeTrack;
 
   // Helper struct to pass V0 information
-  struct {
+  struct V0Candidate {
     int posTrackId;
     int negTrackId;
     int collisionId;
@@ -196,12 +199,13 @@ struct strangenessBuilder {
     float V0radius;
     float lambdaMass;
     float antilambdaMass;
+    o2::track::TrackParCov v0Track; // for a) cascade minimization and b) exporting for decay chains
   } v0candidate;
 
   // Helper struct to pass cascade information
   // N.B.: the V0 properties aren't needed
   // Processing will take place sequentially
-  struct {
+  struct CascadeCandidate {
     int v0Id;
     int bachelorId;
     int collisionId;
@@ -211,8 +215,49 @@ struct strangenessBuilder {
     float dcacascdau;
     float bachDCAxy;
     float cascradius;
+    o2::track::TrackParCov cascadeTrack; // for exporting for decay chains
   } cascadecandidate;
 
+  // Selection counters, filled into the histograms at the end of a process call
+  // so that the threads of processRun3Parallel never share the registry
+  struct BuilderCounters {
+    std::array<int64_t, 10> v0Criteria{};
+    std::array<int64_t, 10> cascadeCriteria{};
+    int64_t caughtExceptions = 0;
+  } counters;
+
+  // Dataframe-wide builder (processRun3Parallel)
+  Configurable<int> nThreads{"nThreads", 4, "Number of threads building the V0s and cascades of a dataframe in processRun3Parallel"};
+  Configurable<int> chunkSize{"chunkSize", 64, "Number of V0s or cascades a thread takes at a time in processRun3Parallel"};
+
+  // Thread-local state of the dataframe-wide builder
+  struct BuilderWorker {
+    o2::vertexing::DCAFitterN<2> fitter;
+    BuilderCounters counters;
+  };
+  std::vector<std::unique_ptr<BuilderWorker>> builderWorkers;
+
+  // Inputs of the dataframe-wide builder, read from the tables before starting the threads
+  struct V0Input {
+    o2::track::TrackParCov posTrack;
+    o2::track::TrackParCov negTrack;
+    std::array<float, 3> pv;
+  };
+  struct CascadeInput {
+    o2::track::TrackParCov bachTrack;
+    float bachDCAxy;
+    float bachSigned1Pt;
+    int v0Index;
+  };
+
+  // Builder state per row of the V0 and cascade tables, kept between dataframes to avoid reallocations
+  std::vector<V0Input> v0Inputs;
+  std::vector<V0Candidate> v0Results;
+  std::vector<char> v0Selected;
+  std::vector<CascadeInput> cascadeInputs;
+  std::vector<CascadeCandidate> cascadeResults;
+  std::vector<char> cascadeSelected;
+
   HistogramRegistry registry{
     "registry",
     {{"hEventCounter", "hEventCounter", {HistType::kTH1F, {{1, 0.0f, 1.0f}}}},
@@ -238,38 +283,37 @@ struct strangenessBuilder {
       ccdb->get<TGeoManager>(geoPath);
     }
 
-    if (doprocessRun2 == false && doprocessRun3 == false) {
-      LOGF(fatal, "Neither processRun2 nor processRun3 enabled. Please choose one.");
+    const int nProcesses = doprocessRun2 + doprocessRun3 + doprocessRun3Parallel;
+    if (nProcesses == 0) {
+      LOGF(fatal, "Neither processRun2 nor processRun3 nor processRun3Parallel enabled. Please choose one.");
     }
-    if (doprocessRun2 == true && doprocessRun3 == true) {
-      LOGF(fatal, "Cannot enable processRun2 and processRun3 at the same time. Please choose one.");
+    if (nProcesses > 1) {
+      LOGF(fatal, "Cannot enable more than one of processRun2, processRun3 and processRun3Parallel at the same time. Please choose one.");
+    }
+    if (doprocessRun3Parallel && useMatCorrType == 1) {
+      LOGF(fatal, "TGeo material corrections are not thread-safe, use the LUT (useMatCorrType = 2) with processRun3Parallel");
     }
 
     // Checking for subscriptions to:
     // - cascades
     // - covariance matrices
-    auto& workflows = context.services().get<RunningWorkflowInfo const>();
-    for (DeviceSpec const& device : workflows.devices) {
-      for (auto const& input : device.inputs) {
-        auto enable = [&input](const std::string tablename, Configurable<int>& flag) {
-          const std::string table = tablename;
-          if (input.matcher.binding == table) {
-            if (flag < 0) {
-              flag.value = 1;
-              LOGF(info, "Auto-enabling table: %s", table.c_str());
-            } else if (flag > 0) {
-              flag.value = 1;
-              LOGF(info, "Table %s already enabled", table.c_str());
-            } else {
-              LOGF(info, "Table %s disabled", table.c_str());
-            }
-          }
-        };
-        enable("CascData", createCascades);
-        enable("V0Covs", createV0CovMats);
-        enable("CascCovs", createCascCovMats);
+    auto enable = [&context](const std::string tablename, Configurable<int>& flag) {
+      const std::string table = tablename;
+      if (isTableRequiredInWorkflow(context, table)) {
+        if (flag < 0) {
+          flag.value = 1;
+          LOGF(info, "Auto-enabling table: %s", table.c_str());
+        } else if (flag > 0) {
+          flag.value = 1;
+          LOGF(info, "Table %s already enabled", table.c_str());
+        } else {
+          LOGF(info, "Table %s disabled", table.c_str());
+        }
       }
-    }
+    };
+    enable("CascData", createCascades);
+    enable("V0Covs", createV0CovMats);
+    enable("CascCovs", createCascCovMats);
 
     //*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*
     LOGF(info, "Strangeness builder configuration:");
@@ -279,6 +323,9 @@ struct strangenessBuilder {
     if (doprocessRun3 == true) {
       LOGF(info, "Run 3 processing enabled. Will subscribe to TracksIU table.");
     };
+    if (doprocessRun3Parallel == true) {
+      LOGF(info, "Run 3 dataframe-wide processing enabled on %d threads. Will subscribe to TracksIU table.", std::max(1, nThreads.value));
+    };
     if (createCascades > 0) {
       LOGF(info, "-> Will produce cascade data table");
     };
@@ -291,14 +338,28 @@ struct strangenessBuilder {
     //*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*
 
     // initialize O2 2-prong fitter (only once)
-    fitter.setPropagateToPCA(true);
-    fitter.setMaxR(200.);
-    fitter.setMinParamChange(1e-3);
-    fitter.setMinRelChi2Change(0.9);
-    fitter.setMaxDZIni(1e9);
-    fitter.setMaxChi2(1e9);
-    fitter.setUseAbsDCA(d_UseAbsDCA);
-    fitter.setWeightedFinalPCA(d_UseWeightedPCA);
+    configureFitter(fitter);
+
+    // the dataframe-wide builder has one fitter per thread
+    if (doprocessRun3Parallel) {
+      builderWorkers.clear();
+      for (int iWorker = 0; iWorker < std::max(1, nThreads.value); ++iWorker) {
+        builderWorkers.push_back(std::make_unique<BuilderWorker>());
+        configureFitter(builderWorkers.back()->fitter);
+      }
+    }
+  }
+
+  void configureFitter(o2::vertexing::DCAFitterN<2>& v0Fitter)
+  {
+    v0Fitter.setPropagateToPCA(true);
+    v0Fitter.setMaxR(200.);
+    v0Fitter.setMinParamChange(1e-3);
+    v0Fitter.setMinRelChi2Change(0.9);
+    v0Fitter.setMaxDZIni(1e9);
+    v0Fitter.setMaxChi2(1e9);
+    v0Fitter.setUseAbsDCA(d_UseAbsDCA);
+    v0Fitter.setWeightedFinalPCA(d_UseWeightedPCA);
 
     // Material correction in the DCA fitter
     o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrNONE;
@@ -306,7 +367,24 @@ struct strangenessBuilder {
       matCorr = o2::base::Propagator::MatCorrType::USEMatCorrTGeo;
     if (useMatCorrType == 2)
       matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
-    fitter.setMatCorrType(matCorr);
+    v0Fitter.setMatCorrType(matCorr);
+  }
+
+  // Fills the selection counters into the histograms and resets them
+  void flushCounters(BuilderCounters& c)
+  {
+    for (int i = 0; i < 10; i++) {
+      if (c.v0Criteria[i] > 0) {
+        registry.fill(HIST("hV0Criteria"), i + 0.5f, c.v0Criteria[i]);
+      }
+      if (c.cascadeCriteria[i] > 0) {
+        registry.fill(HIST("hCascadeCriteria"), i + 0.5f, c.cascadeCriteria[i]);
+      }
+    }
+    if (c.caughtExceptions > 0) {
+      registry.fill(HIST("hCaughtExceptions"), 0.5f, c.caughtExceptions);
+    }
+    c = BuilderCounters{};
   }
 
   void initCCDB(aod::BCsWithTimestamps::iterator const& bc)
@@ -345,13 +423,16 @@ struct strangenessBuilder {
     mRunNumber = bc.runNumber();
     // Set magnetic field value once known
     fitter.setBz(d_bz);
+    for (auto& worker : builderWorkers) {
+      worker->fitter.setBz(d_bz);
+    }
   }
 
   template <class TTracksTo>
-  bool buildV0Candidate(aod::Collision const& collision, TTracksTo const& posTrack, TTracksTo const& negTrack, Bool_t lRun3 = kTRUE)
+  bool preselectV0(TTracksTo const& posTrack, TTracksTo const& negTrack, Bool_t lRun3, BuilderCounters& c)
   {
     // value 0.5: any considered V0
-    registry.fill(HIST("hV0Criteria"), 0.5);
+    c.v0Criteria[0]++;
     if (isRun2) {
       if (!(posTrack.trackType() & o2::aod::track::TPCrefit) && !lRun3) {
         return false;
@@ -361,181 +442,240 @@ struct strangenessBuilder {
       }
     }
     // Passes TPC refit
-    registry.fill(HIST("hV0Criteria"), 1.5);
+    c.v0Criteria[1]++;
     if (posTrack.tpcNClsCrossedRows() < mincrossedrows || negTrack.tpcNClsCrossedRows() < mincrossedrows) {
       return false;
     }
     // passes crossed rows
-    registry.fill(HIST("hV0Criteria"), 2.5);
+    c.v0Criteria[2]++;
     if (fabs(posTrack.dcaXY()) < dcapostopv || fabs(negTrack.dcaXY()) < dcanegtopv) {
       return false;
     }
     // passes DCAxy
-    registry.fill(HIST("hV0Criteria"), 3.5);
-
-    // Change strangenessBuilder tracks
-    lPositiveTrack = getTrackParCov(posTrack);
-    lNegativeTrack = getTrackParCov(negTrack);
+    c.v0Criteria[3]++;
+    return true;
+  }
 
+  // V0 fit and topological selections, with the fitter and counters of the calling thread
+  bool fitV0Candidate(o2::vertexing::DCAFitterN<2>& v0Fitter, std::array<float, 3> const& pv, o2::track::TrackParCov& posTrack, o2::track::TrackParCov& negTrack, V0Candidate& candidate, BuilderCounters& c)
+  {
     //---/---/---/
     // Move close to minima
     int nCand = 0;
     try {
-      nCand = fitter.process(lPositiveTrack, lNegativeTrack);
+      nCand = v0Fitter.process(posTrack, negTrack);
     } catch (...) {
-      registry.fill(HIST("hCaughtExceptions"), 0.5f);
+      c.caughtExceptions++;
       LOG(error) << "Exception caught in DCA fitter process call!";
     }
     if (nCand == 0) {
       return false;
     }
 
-    lPositiveTrack.getPxPyPzGlo(v0candidate.posP);
-    lNegativeTrack.getPxPyPzGlo(v0candidate.negP);
+    posTrack.getPxPyPzGlo(candidate.posP);
+    negTrack.getPxPyPzGlo(candidate.negP);
+    candidate.posTrackX = v0Fitter.getTrack(0).getX();
+    candidate.negTrackX = v0Fitter.getTrack(1).getX();
 
     // get decay vertex coordinates
-    const auto& vtx = fitter.getPCACandidate();
+    const auto& vtx = v0Fitter.getPCACandidate();
     for (int i = 0; i < 3; i++) {
-      v0candidate.pos[i] = vtx[i];
+      candidate.pos[i] = vtx[i];
     }
 
-    v0candidate.dcaV0dau = TMath::Sqrt(fitter.getChi2AtPCACandidate());
+    candidate.dcaV0dau = TMath::Sqrt(v0Fitter.getChi2AtPCACandidate());
 
     // Apply selections so a skimmed table is created only
-    if (v0candidate.dcaV0dau > dcav0dau) {
+    if (candidate.dcaV0dau > dcav0dau) {
       return false;
     }
 
     // Passes DCA between daughters check
-    registry.fill(HIST("hV0Criteria"), 4.5);
+    c.v0Criteria[4]++;
 
-    v0candidate.cosPA = RecoDecay::cpa(array{collision.posX(), collision.posY(), collision.posZ()}, array{v0candidate.pos[0], v0candidate.pos[1], v0candidate.pos[2]}, array{v0candidate.posP[0] + v0candidate.negP[0], v0candidate.posP[1] + v0candidate.negP[1], v0candidate.posP[2] + v0candidate.negP[2]});
-    if (v0candidate.cosPA < v0cospa) {
+    candidate.cosPA = RecoDecay::cpa(pv, array{candidate.pos[0], candidate.pos[1], candidate.pos[2]}, array{candidate.posP[0] + candidate.negP[0], candidate.posP[1] + candidate.negP[1], candidate.posP[2] + candidate.negP[2]});
+    if (candidate.cosPA < v0cospa) {
       return false;
     }
 
     // Passes CosPA check
-    registry.fill(HIST("hV0Criteria"), 5.5);
+    c.v0Criteria[5]++;
 
-    v0candidate.V0radius = RecoDecay::sqrtSumOfSquares(v0candidate.pos[0], v0candidate.pos[1]);
-    if (v0candidate.V0radius < v0radius) {
+    candidate.V0radius = RecoDecay::sqrtSumOfSquares(candidate.pos[0], candidate.pos[1]);
+    if (candidate.V0radius < v0radius) {
       return false;
     }
 
     // Passes radius check
-    registry.fill(HIST("hV0Criteria"), 6.5);
+    c.v0Criteria[6]++;
 
     // store V0 track for a) cascade minimization and b) exporting for decay chains
-    lV0Track = fitter.createParentTrackParCov();
-    lV0Track.setAbsCharge(0); // just in case
+    candidate.v0Track = v0Fitter.createParentTrackParCov();
+    candidate.v0Track.setAbsCharge(0); // just in case
 
     // Fill in lambda masses (necessary for cascades)
-    v0candidate.lambdaMass = RecoDecay::m(array{v0candidate.posP, v0candidate.negP}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
-    v0candidate.antilambdaMass = RecoDecay::m(array{v0candidate.posP, v0candidate.negP}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
+    candidate.lambdaMass = RecoDecay::m(array{candidate.posP, candidate.negP}, array{RecoDecay::getMassPDG(kProton), RecoDecay::getMassPDG(kPiPlus)});
+    candidate.antilambdaMass = RecoDecay::m(array{candidate.posP, candidate.negP}, array{RecoDecay::getMassPDG(kPiPlus), RecoDecay::getMassPDG(kProton)});
 
     // Return OK: passed all v0 candidate selecton criteria
     return true;
   }
 
   template <class TTracksTo>
-  bool buildCascadeCandidate(aod::Collision const& collision, TTracksTo const& bachTrack, Bool_t lRun3 = kTRUE)
+  bool buildV0Candidate(aod::Collision const& collision, TTracksTo const& posTrack, TTracksTo const& negTrack, Bool_t lRun3 = kTRUE)
+  {
+    if (!preselectV0(posTrack, negTrack, lRun3, counters)) {
+      return false;
+    }
+
+    v0candidate.posTrackId = posTrack.globalIndex();
+    v0candidate.negTrackId = negTrack.globalIndex();
+    v0candidate.posDCAxy = posTrack.dcaXY();
+    v0candidate.negDCAxy = negTrack.dcaXY();
+
+    // Change strangenessBuilder tracks
+    lPositiveTrack = getTrackParCov(posTrack);
+    lNegativeTrack = getTrackParCov(negTrack);
+
+    return fitV0Candidate(fitter, array{collision.posX(), collision.posY(), collision.posZ()}, lPositiveTrack, lNegativeTrack, v0candidate, counters);
+  }
+
+  // Cascade selections and fit, with the fitter and counters of the calling thread
+  bool fitCascadeCandidate(o2::vertexing::DCAFitterN<2>& cascFitter, V0Candidate const& v0, o2::track::TrackParCov const& bachTrack, float bachDCAxy, float bachSigned1Pt, CascadeCandidate& candidate, BuilderCounters& c)
   {
     // value 0.5: any considered cascade
-    registry.fill(HIST("hCascadeCriteria"), 0.5);
+    c.cascadeCriteria[0]++;
 
     // bachelor DCA track to PV
-    cascadecandidate.bachDCAxy = bachTrack.dcaXY();
-    if (cascadecandidate.bachDCAxy < dcabachtopv)
+    candidate.bachDCAxy = bachDCAxy;
+    if (candidate.bachDCAxy < dcabachtopv)
       return false;
-    registry.fill(HIST("hCascadeCriteria"), 1.5);
+    c.cascadeCriteria[1]++;
 
     // Overall cascade charge
-    cascadecandidate.charge = bachTrack.signed1Pt() > 0 ? +1 : -1;
+    candidate.charge = bachSigned1Pt > 0 ? +1 : -1;
 
     // Better check than before: check also against charge
     // Should reduce unnecessary combinations
-    if (cascadecandidate.charge < 0 && TMath::Abs(v0candidate.lambdaMass - 1.116) > lambdaMassWindow)
+    if (candidate.charge < 0 && TMath::Abs(v0.lambdaMass - 1.116) > lambdaMassWindow)
       return false;
-    if (cascadecandidate.charge > 0 && TMath::Abs(v0candidate.antilambdaMass - 1.116) > lambdaMassWindow)
+    if (candidate.charge > 0 && TMath::Abs(v0.antilambdaMass - 1.116) > lambdaMassWindow)
       return false;
-    registry.fill(HIST("hCascadeCriteria"), 2.5);
+    c.cascadeCriteria[2]++;
 
     // Do actual minimization
-    lBachelorTrack = getTrackParCov(bachTrack);
-    auto nCand = fitter.process(lV0Track, lBachelorTrack);
+    auto nCand = cascFitter.process(v0.v0Track, bachTrack);
     if (nCand == 0)
       return false;
-    registry.fill(HIST("hCascadeCriteria"), 3.5);
+    c.cascadeCriteria[3]++;
 
-    fitter.getTrack(1).getPxPyPzGlo(cascadecandidate.bachP);
+    cascFitter.getTrack(1).getPxPyPzGlo(candidate.bachP);
 
     // get decay vertex coordinates
-    const auto& vtx = fitter.getPCACandidate();
+    const auto& vtx = cascFitter.getPCACandidate();
     for (int i = 0; i < 3; i++) {
-      cascadecandidate.pos[i] = vtx[i];
+      candidate.pos[i] = vtx[i];
     }
 
     // Cascade radius
-    cascadecandidate.cascradius = RecoDecay::sqrtSumOfSquares(cascadecandidate.pos[0], cascadecandidate.pos[1]);
-    if (cascadecandidate.cascradius < cascradius)
+    candidate.cascradius = RecoDecay::sqrtSumOfSquares(candidate.pos[0], candidate.pos[1]);
+    if (candidate.cascradius < cascradius)
       return false;
-    registry.fill(HIST("hCascadeCriteria"), 4.5);
+    c.cascadeCriteria[4]++;
 
     // DCA between cascade daughters
-    cascadecandidate.dcacascdau = TMath::Sqrt(fitter.getChi2AtPCACandidate());
-    if (cascadecandidate.cascradius < dcacascdau)
+    candidate.dcacascdau = TMath::Sqrt(cascFitter.getChi2AtPCACandidate());
+    if (candidate.cascradius < dcacascdau)
       return false;
-    registry.fill(HIST("hCascadeCriteria"), 5.5);
+    c.cascadeCriteria[5]++;
 
     // store V0 track for a) cascade minimization and b) exporting for decay chains
-    lCascadeTrack = fitter.createParentTrackParCov();
-    lCascadeTrack.setAbsCharge(cascadecandidate.charge); // just in case
+    candidate.cascadeTrack = cascFitter.createParentTrackParCov();
+    candidate.cascadeTrack.setAbsCharge(candidate.charge); // just in case
 
     return true;
   }
 
+  template <class TTracksTo>
+  bool buildCascadeCandidate(aod::Collision const& collision, TTracksTo const& bachTrack, Bool_t lRun3 = kTRUE)
+  {
+    lBachelorTrack = getTrackParCov(bachTrack);
+    return fitCascadeCandidate(fitter, v0candidate, lBachelorTrack, bachTrack.dcaXY(), bachTrack.signed1Pt(), cascadecandidate, counters);
+  }
+
+  void fillV0Tables(V0Candidate const& candidate)
+  {
+    // populates table for V0 analysis
+    v0data(candidate.posTrackId,
+           candidate.negTrackId,
+           candidate.collisionId,
+           candidate.globalIndex,
+           candidate.posTrackX, candidate.negTrackX,
+           candidate.pos[0], candidate.pos[1], candidate.pos[2],
+           candidate.posP[0], candidate.posP[1], candidate.posP[2],
+           candidate.negP[0], candidate.negP[1], candidate.negP[2],
+           candidate.dcaV0dau,
+           candidate.posDCAxy,
+           candidate.negDCAxy);
+
+    // populate V0 covariance matrices if required by any other task (experimental)
+    if (createV0CovMats) {
+      float V0CovMatrix[21];
+      std::array<float, 21> stdCovV0 = {0.};
+      candidate.v0Track.getCovXYZPxPyPzGlo(stdCovV0);
+      for (Int_t iEl = 0; iEl < 21; iEl++) {
+        V0CovMatrix[iEl] = stdCovV0[iEl];
+      }
+      v0covs(V0CovMatrix);
+    }
+  }
+
+  void fillCascadeTables(V0Candidate const& v0, CascadeCandidate const& candidate)
+  {
+    cascdata(candidate.v0Id,
+             candidate.bachelorId,
+             candidate.collisionId,
+             candidate.charge,
+             candidate.pos[0], candidate.pos[1], candidate.pos[2],
+             v0.pos[0], v0.pos[1], v0.pos[2],
+             v0.posP[0], v0.posP[1], v0.posP[2],
+             v0.negP[0], v0.negP[1], v0.negP[2],
+             candidate.bachP[0], candidate.bachP[1], candidate.bachP[2],
+             v0.dcaV0dau, candidate.dcacascdau,
+             v0.posDCAxy,
+             v0.negDCAxy,
+             candidate.bachDCAxy);
+    // populate casc covariance matrices if required by any other task (experimental)
+    if (createCascCovMats) {
+      float CascCovMatrix[21];
+      std::array<float, 21> stdCovCasc = {0.};
+      candidate.cascadeTrack.getCovXYZPxPyPzGlo(stdCovCasc);
+      for (Int_t iEl = 0; iEl < 21; iEl++) {
+        CascCovMatrix[iEl] = stdCovCasc[iEl];
+      }
+      casccovs(CascCovMatrix);
+    }
+  }
+
   template <class TTracksTo, typename TV0Objects>
   void buildStrangenessTables(aod::Collision const& collision, TV0Objects const& V0s, aod::Cascades const& cascades, TTracksTo const& tracks, Bool_t lRun3 = kTRUE)
   {
     registry.fill(HIST("hEventCounter"), 0.5);
 
-    float V0CovMatrix[21];
-    float CascCovMatrix[21];
-    std::array<float, 21> stdCovV0 = {0.};
-    std::array<float, 21> stdCovCasc = {0.};
-
     for (auto& V0 : V0s) {
       // Track preselection part
       auto posTrackCast = V0.template posTrack_as<TTracksTo>();
       auto negTrackCast = V0.template negTrack_as<TTracksTo>();
 
       // populates v0candidate struct declared inside strangenessbuilder
+      v0candidate.collisionId = V0.collisionId();
+      v0candidate.globalIndex = V0.globalIndex();
       bool validCandidate = buildV0Candidate(collision, posTrackCast, negTrackCast, lRun3);
 
       if (!validCandidate)
         continue; // doesn't pass selections
 
-      // populates table for V0 analysis
-      v0data(v0candidate.posTrackId,
-             v0candidate.negTrackId,
-             v0candidate.collisionId,
-             v0candidate.globalIndex,
-             v0candidate.posTrackX, v0candidate.negTrackX,
-             v0candidate.pos[0], v0candidate.pos[1], v0candidate.pos[2],
-             v0candidate.posP[0], v0candidate.posP[1], v0candidate.posP[2],
-             v0candidate.negP[0], v0candidate.negP[1], v0candidate.negP[2],
-             v0candidate.dcaV0dau,
-             v0candidate.posDCAxy,
-             v0candidate.negDCAxy);
-
-      // populate V0 covariance matrices if required by any other task (experimental)
-      if (createV0CovMats) {
-        lV0Track.getCovXYZPxPyPzGlo(stdCovV0);
-        for (Int_t iEl = 0; iEl < 21; iEl++) {
-          V0CovMatrix[iEl] = stdCovV0[iEl];
-        }
-        v0covs(V0CovMatrix);
-      }
+      fillV0Tables(v0candidate);
 
       if (createCascades == 0)
         continue;
@@ -546,28 +686,43 @@ struct strangenessBuilder {
         if (!validCascadeCandidate)
           continue; // doesn't pass cascade selections
 
-        cascdata(V0.globalIndex(),
-                 bachTrackCast.globalIndex(),
-                 cascade.collisionId(),
-                 cascadecandidate.charge,
-                 cascadecandidate.pos[0], cascadecandidate.pos[1], cascadecandidate.pos[2],
-                 v0candidate.pos[0], v0candidate.pos[1], v0candidate.pos[2],
-                 v0candidate.posP[0], v0candidate.posP[1], v0candidate.posP[2],
-                 v0candidate.negP[0], v0candidate.negP[1], v0candidate.negP[2],
-                 cascadecandidate.bachP[0], cascadecandidate.bachP[1], cascadecandidate.bachP[2],
-                 v0candidate.dcaV0dau, cascadecandidate.dcacascdau,
-                 v0candidate.posDCAxy,
-                 v0candidate.negDCAxy,
-                 cascadecandidate.bachDCAxy);
-        // populate casc covariance matrices if required by any other task (experimental)
-        if (createCascCovMats) {
-          lCascadeTrack.getCovXYZPxPyPzGlo(stdCovCasc);
-          for (Int_t iEl = 0; iEl < 21; iEl++) {
-            CascCovMatrix[iEl] = stdCovCasc[iEl];
-          }
-          casccovs(CascCovMatrix);
+        cascadecandidate.v0Id = V0.globalIndex();
+        cascadecandidate.bachelorId = bachTrackCast.globalIndex();
+        cascadecandidate.collisionId = cascade.collisionId();
+        fillCascadeTables(v0candidate, cascadecandidate);
+      }
+    }
+    flushCounters(counters);
+  }
+
+  /// Runs build(worker, i) for 0 <= i < n on the worker pool
+  /// Workers pull chunks of chunkSize rows from a shared counter, the first worker runs on the calling thread
+  template <typename TBuild>
+  void runOnWorkers(int n, TBuild&& build)
+  {
+    const int chunk = std::max(1, chunkSize.value);
+    const int nChunks = (n + chunk - 1) / chunk;
+    const int nWorkers = std::min(static_cast<int>(builderWorkers.size()), nChunks);
+    if (nWorkers == 0) {
+      return;
+    }
+    std::atomic<int> nextChunk{0};
+    auto worker = [&](BuilderWorker& w) {
+      for (int iChunk = nextChunk++; iChunk < nChunks; iChunk = nextChunk++) {
+        const int last = std::min(n, (iChunk + 1) * chunk);
+        for (int i = iChunk * chunk; i < last; i++) {
+          build(w, i);
         }
       }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nWorkers - 1);
+    for (int iWorker = 1; iWorker < nWorkers; ++iWorker) {
+      threads.emplace_back(worker, std::ref(*builderWorkers[iWorker]));
+    }
+    worker(*builderWorkers[0]);
+    for (auto& thread : threads) {
+      thread.join();
     }
   }
 
@@ -592,6 +747,107 @@ struct strangenessBuilder {
     buildStrangenessTables<FullTracksExtIU>(collision, V0s, cascades, tracks, kTRUE);
   }
   PROCESS_SWITCH(strangenessBuilder, processRun3, "Produce Run 3 V0 tables", false);
+
+  /// Builds all the V0s and cascades of a dataframe on nThreads threads, from the flat V0 and cascade tables
+  /// The table rows are read before starting the threads, each thread fits chunks of V0s, then of cascades,
+  /// with its own fitter. V0Datas are written in V0 index order and CascData in cascade index order.
+  void processRun3Parallel(aod::Collisions const& collisions, aod::V0s const& V0s, aod::Cascades const& cascades, FullTracksExtIU const& tracks, aod::BCsWithTimestamps const&)
+  {
+    if (collisions.size() == 0) {
+      return;
+    }
+    // a dataframe holds the collisions of a single run
+    initCCDB(collisions.begin().bc_as<aod::BCsWithTimestamps>());
+    registry.fill(HIST("hEventCounter"), 0.5, collisions.size());
+
+    // V0 inputs and preselection
+    const int nV0s = V0s.size();
+    v0Inputs.resize(nV0s);
+    v0Results.resize(nV0s);
+    v0Selected.assign(nV0s, 0);
+    int iV0 = 0;
+    for (auto& V0 : V0s) {
+      const int i = iV0++;
+      if (!V0.has_collision()) {
+        continue;
+      }
+      auto posTrackCast = V0.posTrack_as<FullTracksExtIU>();
+      auto negTrackCast = V0.negTrack_as<FullTracksExtIU>();
+      if (!preselectV0(posTrackCast, negTrackCast, kTRUE, counters)) {
+        continue;
+      }
+      auto collision = V0.collision();
+      auto& input = v0Inputs[i];
+      input.posTrack = getTrackParCov(posTrackCast);
+      input.negTrack = getTrackParCov(negTrackCast);
+      input.pv = {collision.posX(), collision.posY(), collision.posZ()};
+      auto& result = v0Results[i];
+      result.posTrackId = posTrackCast.globalIndex();
+      result.negTrackId = negTrackCast.globalIndex();
+      result.collisionId = V0.collisionId();
+      result.globalIndex = V0.globalIndex();
+      result.posDCAxy = posTrackCast.dcaXY();
+      result.negDCAxy = negTrackCast.dcaXY();
+      v0Selected[i] = 1;
+    }
+
+    runOnWorkers(nV0s, [this](BuilderWorker& w, int i) {
+      if (v0Selected[i]) {
+        v0Selected[i] = fitV0Candidate(w.fitter, v0Inputs[i].pv, v0Inputs[i].posTrack, v0Inputs[i].negTrack, v0Results[i], w.counters);
+      }
+    });
+
+    // cascade inputs, only for the cascades of a selected V0
+    const int nCascades = createCascades == 0 ? 0 : cascades.size();
+    cascadeInputs.resize(nCascades);
+    cascadeResults.resize(nCascades);
+    cascadeSelected.assign(nCascades, 0);
+    if (nCascades > 0) {
+      int iCascade = 0;
+      for (auto& cascade : cascades) {
+        const int i = iCascade++;
+        if (!v0Selected[cascade.v0Id()]) {
+          continue;
+        }
+        auto bachTrackCast = cascade.bachelor_as<FullTracksExtIU>();
+        auto& input = cascadeInputs[i];
+        input.bachTrack = getTrackParCov(bachTrackCast);
+        input.bachDCAxy = bachTrackCast.dcaXY();
+        input.bachSigned1Pt = bachTrackCast.signed1Pt();
+        input.v0Index = cascade.v0Id();
+        auto& result = cascadeResults[i];
+        result.v0Id = cascade.v0Id();
+        result.bachelorId = bachTrackCast.globalIndex();
+        result.collisionId = cascade.collisionId();
+        cascadeSelected[i] = 1;
+      }
+
+      runOnWorkers(nCascades, [this](BuilderWorker& w, int i) {
+        if (cascadeSelected[i]) {
+          const auto& input = cascadeInputs[i];
+          cascadeSelected[i] = fitCascadeCandidate(w.fitter, v0Results[input.v0Index], input.bachTrack, input.bachDCAxy, input.bachSigned1Pt, cascadeResults[i], w.counters);
+        }
+      });
+    }
+
+    // tables in the original index order
+    for (int i = 0; i < nV0s; i++) {
+      if (v0Selected[i]) {
+        fillV0Tables(v0Results[i]);
+      }
+    }
+    for (int i = 0; i < nCascades; i++) {
+      if (cascadeSelected[i]) {
+        fillCascadeTables(v0Results[cascadeInputs[i].v0Index], cascadeResults[i]);
+      }
+    }
+
+    flushCounters(counters);
+    for (auto& worker : builderWorkers) {
+      flushCounters(worker->counters);
+    }
+  }
+  PROCESS_SWITCH(strangenessBuilder, processRun3Parallel, "Produce Run 3 V0 and cascade tables of a dataframe on several threads", false);
 };
 
 //*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*+-+*
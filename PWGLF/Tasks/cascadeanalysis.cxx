@@ -36,6 +36,7 @@
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
+#include "PWGLF/Utils/strangenessSelectionKernel.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/EventSelection.h"
@@ -65,6 +66,16 @@ using FullTracksExtIU = soa::Join<aod::TracksIU, aod::TracksExtra, aod::TracksCo
 using FullTracksExtWithPID = soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksCov, aod::TracksDCA, aod::pidTPCPi, aod::pidTPCKa, aod::pidTPCPr>;
 using FullTracksExtIUWithPID = soa::Join<aod::TracksIU, aod::TracksExtra, aod::TracksCovIU, aod::TracksDCA, aod::pidTPCPi, aod::pidTPCKa, aod::pidTPCPr>;
 
+namespace
+{
+// topological selection variations, columns in the order of o2::analysis::strangeness::CascadeSelectionVariable
+static const std::vector<std::string> cascVariationNames{"default", "tight"};
+static constexpr float cascVariations[2][o2::analysis::strangeness::kNCascadeSelectionVariables]{
+  {0.95f, 0.95f, 1.0f, 2.0f, 0.05f, 0.05f, 0.05f, 0.05f, 0.5f, 0.9f, 0.008f}, /*default*/
+  {0.99f, 0.98f, 0.8f, 1.5f, 0.1f, 0.1f, 0.1f, 0.1f, 0.8f, 1.2f, 0.006f}      /*tight*/
+};
+} // namespace
+
 struct cascadeQa {
   // Basic checks
   HistogramRegistry registry{
@@ -132,6 +143,16 @@ struct cascadeAnalysis {
 
     registry.add("hCandidateCounter", "hCandidateCounter", {HistType::kTH1F, {{10, 0.0f, 10.0f}}});
 
+    if (doSelectionVariations) {
+      cascSelectionKernel.setVariations(cascSelectionVariations);
+      const int nVariations = cascSelectionKernel.getNVariations();
+      AxisSpec variationAxis = {nVariations, -0.5f, nVariations - 0.5f, "Selection variation"};
+      registry.add("Variations/h3dMassXiMinus", "h3dMassXiMinus", {HistType::kTH3F, {variationAxis, ptAxis, massAxisXi}});
+      registry.add("Variations/h3dMassXiPlus", "h3dMassXiPlus", {HistType::kTH3F, {variationAxis, ptAxis, massAxisXi}});
+      registry.add("Variations/h3dMassOmegaMinus", "h3dMassOmegaMinus", {HistType::kTH3F, {variationAxis, ptAxis, massAxisOmega}});
+      registry.add("Variations/h3dMassOmegaPlus", "h3dMassOmegaPlus", {HistType::kTH3F, {variationAxis, ptAxis, massAxisOmega}});
+    }
+
     //have registrey with 2d histograms (no centrality selection)
     if (!doCentralityStudy) {
       registry.add("h2dMassXiMinus", "h2dMassXiMinus", {HistType::kTH2F, {ptAxis, massAxisXi}});
@@ -175,6 +196,12 @@ struct cascadeAnalysis {
   //Switch for centrality
   Configurable<bool> doCentralityStudy{"doCentralityStudy", false, "do centrality percentile selection (yes/no)"};
 
+  //Topological selection variations, all evaluated in one pass over the cascades of a collision
+  Configurable<bool> doSelectionVariations{"doSelectionVariations", false, "fill the invariant mass histograms of the topological selection variations"};
+  Configurable<LabeledArray<float>> cascSelectionVariations{"cascSelectionVariations", {cascVariations[0], 2, o2::analysis::strangeness::kNCascadeSelectionVariables, cascVariationNames, o2::analysis::strangeness::cascadeSelectionVariableNames}, "topological selection variations, at most 32, tighter than the DCA pre-filter"};
+
+  o2::analysis::strangeness::CascadeSelectionKernel cascSelectionKernel;
+
   Filter preFilter =
     nabs(aod::cascdata::dcapostopv) > dcapostopv&& nabs(aod::cascdata::dcanegtopv) > dcanegtopv&& nabs(aod::cascdata::dcabachtopv) > dcabachtopv&& aod::cascdata::dcaV0daughters < dcav0dau&& aod::cascdata::dcacascdaughters < dcacascdau;
 
@@ -217,7 +244,7 @@ struct cascadeAnalysis {
   }
 
   template <class TCascTracksTo, typename TCascade>
-  void processCascadeCandidate(TCascade const& casc, float const& pvx, float const& pvy, float const& pvz, float lPercentile = 999.0f, int lPIDvalue = 3)
+  void processCascadeCandidate(TCascade const& casc, float const& pvx, float const& pvy, float const& pvz, float lPercentile = 999.0f, int lPIDvalue = 3, uint32_t variationMask = 0)
   //function to process cascades and generate corresponding invariant mass distributions
   {
     registry.fill(HIST("hCandidateCounter"), 0.5); //all candidates
@@ -282,6 +309,27 @@ struct cascadeAnalysis {
     bool lCompatiblePID_Xi = (lPIDvalue >> 0 & 1);
     bool lCompatiblePID_Om = (lPIDvalue >> 1 & 1);
 
+    //selection variations passed by the candidate
+    for (int iVariation = 0; variationMask != 0 && iVariation < cascSelectionKernel.getNVariations(); iVariation++) {
+      if (!((variationMask >> iVariation) & 1u)) {
+        continue;
+      }
+      if (TMath::Abs(casc.yXi()) < 0.5 && lCompatiblePID_Xi) {
+        if (casc.sign() < 0) {
+          registry.fill(HIST("Variations/h3dMassXiMinus"), iVariation, casc.pt(), casc.mXi());
+        } else {
+          registry.fill(HIST("Variations/h3dMassXiPlus"), iVariation, casc.pt(), casc.mXi());
+        }
+      }
+      if (TMath::Abs(casc.yOmega()) < 0.5 && lCompatiblePID_Om) {
+        if (casc.sign() < 0) {
+          registry.fill(HIST("Variations/h3dMassOmegaMinus"), iVariation, casc.pt(), casc.mOmega());
+        } else {
+          registry.fill(HIST("Variations/h3dMassOmegaPlus"), iVariation, casc.pt(), casc.mOmega());
+        }
+      }
+    }
+
     if (casc.v0radius() > v0radius &&
         casc.cascradius() > cascradius &&
         casc.v0cosPA(pvx, pvy, pvz) > v0cospa &&
@@ -323,6 +371,18 @@ struct cascadeAnalysis {
     }
   }
 
+  /// Evaluates the selection variations of the cascades of a collision
+  /// \return the bitmasks of the passed variations, one per cascade, or nullptr if the variations are disabled
+  template <typename TCascades>
+  const std::vector<uint32_t>* evaluateSelectionVariations(TCascades const& cascades, float pvx, float pvy, float pvz)
+  {
+    if (!doSelectionVariations) {
+      return nullptr;
+    }
+    cascSelectionKernel.load(cascades, pvx, pvy, pvz);
+    return &cascSelectionKernel.evaluate();
+  }
+
   void processRun3(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<aod::CascDataExt> const& Cascades, aod::V0sLinked const&, aod::V0Datas const&, FullTracksExtIU const&)
   //process function subscribing to Run 3-like analysis objects
   {
@@ -331,8 +391,11 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracksIU typecast (Run 3)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExtIU>(casc, collision.posX(), collision.posY(), collision.posZ());
+      processCascadeCandidate<FullTracksExtIU>(casc, collision.posX(), collision.posY(), collision.posZ(), 999.0f, 3, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun3, "Process Run 3 data", true);
@@ -348,8 +411,11 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracks typecast (Run 2)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExt>(casc, collision.posX(), collision.posY(), collision.posZ());
+      processCascadeCandidate<FullTracksExt>(casc, collision.posX(), collision.posY(), collision.posZ(), 999.0f, 3, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun2, "Process Run 2 data", false);
@@ -362,8 +428,11 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracksIU typecast (Run 3)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExtIU>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M());
+      processCascadeCandidate<FullTracksExtIU>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), 3, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun3VsMultiplicity, "Process Run 3 data vs multiplicity", false);
@@ -379,8 +448,11 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracks typecast (Run 2)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
-      processCascadeCandidate<FullTracksExt>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M());
+      processCascadeCandidate<FullTracksExt>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), 3, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun2VsMultiplicity, "Process Run 2 data vs multiplicity", false);
@@ -393,9 +465,12 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracksIU typecast (Run 3)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
       int lPIDvalue = checkCascadeTPCPID<FullTracksExtWithPID>(casc);
-      processCascadeCandidate<FullTracksExtIUWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), -999, lPIDvalue);
+      processCascadeCandidate<FullTracksExtIUWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), -999, lPIDvalue, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun3WithPID, "Process Run 3 data  with PID", false);
@@ -411,9 +486,12 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracks typecast (Run 2)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
       int lPIDvalue = checkCascadeTPCPID<FullTracksExtWithPID>(casc);
-      processCascadeCandidate<FullTracksExtWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), -999, lPIDvalue);
+      processCascadeCandidate<FullTracksExtWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), -999, lPIDvalue, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun2WithPID, "Process Run 2 data  with PID", false);
@@ -426,9 +504,12 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracksIU typecast (Run 3)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
       int lPIDvalue = checkCascadeTPCPID<FullTracksExtIUWithPID>(casc);
-      processCascadeCandidate<FullTracksExtIUWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), lPIDvalue);
+      processCascadeCandidate<FullTracksExtIUWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), lPIDvalue, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun3VsMultiplicityWithPID, "Process Run 3 data vs multiplicity with PID", false);
@@ -444,9 +525,12 @@ struct cascadeAnalysis {
       return;
     }
     //fill cascade information with tracks typecast (Run 2)
+    const auto* variationMasks = evaluateSelectionVariations(Cascades, collision.posX(), collision.posY(), collision.posZ());
+    std::size_t iCasc = 0;
     for (auto& casc : Cascades) {
       int lPIDvalue = checkCascadeTPCPID<FullTracksExtWithPID>(casc);
-      processCascadeCandidate<FullTracksExtWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), lPIDvalue);
+      processCascadeCandidate<FullTracksExtWithPID>(casc, collision.posX(), collision.posY(), collision.posZ(), collision.centRun2V0M(), lPIDvalue, variationMasks ? (*variationMasks)[iCasc] : 0u);
+      iCasc++;
     }
   }
   PROCESS_SWITCH(cascadeAnalysis, processRun2VsMultiplicityWithPID, "Process Run 2 data vs multiplicity with PID", false);
@@ -29,6 +29,7 @@
 #include "Common/Core/RecoDecay.h"
 #include "Common/Core/trackUtilities.h"
 #include "PWGLF/DataModel/LFStrangenessTables.h"
+#include "PWGLF/Utils/strangenessSelectionKernel.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 #include "Common/DataModel/EventSelection.h"
@@ -54,6 +55,17 @@ using std::array;
 
 using MyTracks = soa::Join<aod::Tracks, aod::TracksExtra, aod::pidTPCPr>;
 
+namespace
+{
+// topological selection variations, columns in the order of o2::analysis::strangeness::V0SelectionVariable
+static const std::vector<std::string> v0VariationNames{"default", "tight", "loose"};
+static constexpr float v0Variations[3][o2::analysis::strangeness::kNV0SelectionVariables]{
+  {0.995f, 1.0f, 0.1f, 0.1f, 5.0f},   /*default*/
+  {0.998f, 0.8f, 0.15f, 0.15f, 6.0f}, /*tight*/
+  {0.993f, 1.0f, 0.1f, 0.1f, 4.0f}    /*loose*/
+};
+} // namespace
+
 struct lambdakzeroQa {
   // Basic checks
   HistogramRegistry registry{
@@ -131,6 +143,20 @@ struct lambdakzeroAnalysis {
     registry.get<TH1>(HIST("V0loopFiltersCounts"))->GetXaxis()->SetBinLabel(9, "K0S lifetime cut");
     registry.get<TH1>(HIST("V0loopFiltersCounts"))->GetXaxis()->SetBinLabel(10, "K0S Armenteros cut");
 
+    if (doSelectionVariations) {
+      v0SelectionKernel.setVariations(v0SelectionVariations);
+      const int nVariations = v0SelectionKernel.getNVariations();
+      AxisSpec variationAxis = {nVariations, -0.5f, nVariations - 0.5f, "Selection variation"};
+      registry.add("Variations/h3dMassK0Short", "h3dMassK0Short", {HistType::kTH3F, {variationAxis, ptAxis, massAxisK0Short}});
+      registry.add("Variations/h3dMassLambda", "h3dMassLambda", {HistType::kTH3F, {variationAxis, ptAxis, massAxisLambda}});
+      registry.add("Variations/h3dMassAntiLambda", "h3dMassAntiLambda", {HistType::kTH3F, {variationAxis, ptAxis, massAxisLambda}});
+      for (int iVariation = 0; iVariation < nVariations; iVariation++) {
+        registry.get<TH3>(HIST("Variations/h3dMassK0Short"))->GetXaxis()->SetBinLabel(iVariation + 1, v0SelectionVariations->getLabelsRows()[iVariation].c_str());
+        registry.get<TH3>(HIST("Variations/h3dMassLambda"))->GetXaxis()->SetBinLabel(iVariation + 1, v0SelectionVariations->getLabelsRows()[iVariation].c_str());
+        registry.get<TH3>(HIST("Variations/h3dMassAntiLambda"))->GetXaxis()->SetBinLabel(iVariation + 1, v0SelectionVariations->getLabelsRows()[iVariation].c_str());
+      }
+    }
+
     registry.get<TH1>(HIST("hEventSelection"))->GetXaxis()->SetBinLabel(1, "All collisions");
     registry.get<TH1>(HIST("hEventSelection"))->GetXaxis()->SetBinLabel(2, "Sel8 cut");
     registry.get<TH1>(HIST("hEventSelection"))->GetXaxis()->SetBinLabel(3, "posZ cut");
@@ -160,8 +186,50 @@ struct lambdakzeroAnalysis {
   static constexpr float defaultLifetimeCuts[1][2] = {{25., 20.}};
   Configurable<LabeledArray<float>> lifetimecut{"lifetimecut", {defaultLifetimeCuts[0], 2, {"lifetimecutLambda", "lifetimecutK0S"}}, "lifetimecut"};
 
+  // Topological selection variations, all evaluated in one pass over the V0s of a collision
+  Configurable<bool> doSelectionVariations{"doSelectionVariations", false, "fill the invariant mass histograms of the topological selection variations"};
+  Configurable<LabeledArray<float>> v0SelectionVariations{"v0SelectionVariations", {v0Variations[0], 3, o2::analysis::strangeness::kNV0SelectionVariables, v0VariationNames, o2::analysis::strangeness::v0SelectionVariableNames}, "topological selection variations, at most 32, tighter than the DCA pre-filter"};
+
+  o2::analysis::strangeness::V0SelectionKernel v0SelectionKernel;
+
   Filter preFilterV0 = nabs(aod::v0data::dcapostopv) > dcapostopv&& nabs(aod::v0data::dcanegtopv) > dcanegtopv&& aod::v0data::dcaV0daughters < dcav0dau;
 
+  /// Invariant mass histograms of the selection variations, with the rapidity, lifetime, PID and Armenteros selections of the default analysis
+  template <typename TCollision, typename TV0s>
+  void fillSelectionVariations(TCollision const& collision, TV0s const& fullV0s)
+  {
+    v0SelectionKernel.load(fullV0s, collision.posX(), collision.posY(), collision.posZ());
+    const auto& masks = v0SelectionKernel.evaluate();
+    const int nVariations = v0SelectionKernel.getNVariations();
+    std::size_t iV0 = 0;
+    for (auto& v0 : fullV0s) {
+      const uint32_t mask = masks[iV0++];
+      if (mask == 0) {
+        continue;
+      }
+      const float lifetime = v0.distovertotmom(collision.posX(), collision.posY(), collision.posZ());
+      const bool isLambdaCandidate = TMath::Abs(v0.yLambda()) < rapidity && lifetime * RecoDecay::getMassPDG(kLambda0) < lifetimecut->get("lifetimecutLambda");
+      const bool isLambda = isLambdaCandidate && TMath::Abs(v0.posTrack_as<MyTracks>().tpcNSigmaPr()) < TpcPidNsigmaCut;
+      const bool isAntiLambda = isLambdaCandidate && TMath::Abs(v0.negTrack_as<MyTracks>().tpcNSigmaPr()) < TpcPidNsigmaCut;
+      const bool isK0Short = TMath::Abs(v0.yK0Short()) < rapidity && lifetime * RecoDecay::getMassPDG(kK0Short) < lifetimecut->get("lifetimecutK0S") &&
+                             ((v0.qtarm() > paramArmenterosCut * TMath::Abs(v0.alpha())) || !boolArmenterosCut);
+      for (int iVariation = 0; iVariation < nVariations; iVariation++) {
+        if (!((mask >> iVariation) & 1u)) {
+          continue;
+        }
+        if (isLambda) {
+          registry.fill(HIST("Variations/h3dMassLambda"), iVariation, v0.pt(), v0.mLambda());
+        }
+        if (isAntiLambda) {
+          registry.fill(HIST("Variations/h3dMassAntiLambda"), iVariation, v0.pt(), v0.mAntiLambda());
+        }
+        if (isK0Short) {
+          registry.fill(HIST("Variations/h3dMassK0Short"), iVariation, v0.pt(), v0.mK0Short());
+        }
+      }
+    }
+  }
+
   // void process(soa::Join<aod::Collisions, aod::EvSels, aod::CentV0Ms>::iterator const& collision, soa::Filtered<aod::V0Datas> const& fullV0s) //for now CentV0M info is not available for run 3 pp
   void processRun3(soa::Join<aod::Collisions, aod::EvSels>::iterator const& collision, soa::Filtered<aod::V0Datas> const& fullV0s, MyTracks const& tracks)
   {
@@ -175,6 +243,10 @@ struct lambdakzeroAnalysis {
     }
     registry.fill(HIST("hEventSelection"), 2.5);
 
+    if (doSelectionVariations) {
+      fillSelectionVariations(collision, fullV0s);
+    }
+
     for (auto& v0 : fullV0s) {
       // FIXME: could not find out how to filter cosPA and radius variables (dynamic columns)
       registry.fill(HIST("V0loopFiltersCounts"), 0.5);
@@ -242,6 +314,10 @@ struct lambdakzeroAnalysis {
     }
     registry.fill(HIST("hEventSelection"), 2.5);
 
+    if (doSelectionVariations) {
+      fillSelectionVariations(collision, fullV0s);
+    }
+
     for (auto& v0 : fullV0s) {
       // FIXME: could not find out how to filter cosPA and radius variables (dynamic columns)
       registry.fill(HIST("V0loopFiltersCounts"), 0.5);
@@ -0,0 +1,197 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file resonancepairing.cxx
+/// \brief Reconstruction of phi, K*0 and Lambda(1520) from a single pass over the resonance daughters
+///
+/// The daughters of each collision are reduced once and paired for all the enabled resonances together.
+/// The mixed-event pairs are built from the reduced daughters of the previous collisions of the same mixing bin,
+/// kept in memory, instead of iterating again over the tables.
+
+#include <array>
+#include <memory>
+#include <string>
+
+#include "Framework/AnalysisTask.h"
+#include "Framework/HistogramRegistry.h"
+#include "Framework/runDataProcessing.h"
+#include "PWGLF/DataModel/LFResonanceTables.h"
+#include "PWGLF/Utils/resonancePairEngine.h"
+#include <TDatabasePDG.h>
+#include <TPDGCode.h>
+#include <TH3.h>
+
+using namespace o2;
+using namespace o2::framework;
+using namespace o2::framework::expressions;
+using namespace o2::analysis::resonance;
+
+namespace
+{
+enum Resonance {
+  kPhi = 0,
+  kKstar,
+  kLambda1520,
+  kNResonances
+};
+static constexpr std::string_view resonanceNames[kNResonances] = {"Phi", "Kstar", "Lambda1520"};
+} // namespace
+
+struct resonancepairing {
+  ConfigurableAxis CfgMultBins{"CfgMultBins", {VARIABLE_WIDTH, 0.0f, 20.0f, 40.0f, 60.0f, 80.0f, 100.0f, 200.0f, 99999.f}, "Mixing bins - multiplicity"};
+  ConfigurableAxis CfgVtxBins{"CfgVtxBins", {VARIABLE_WIDTH, -10.0f, -8.f, -6.f, -4.f, -2.f, 0.f, 2.f, 4.f, 6.f, 8.f, 10.f}, "Mixing bins - z-vertex"};
+  Configurable<int> nEvtMixing{"nEvtMixing", 5, "Number of events to mix"};
+  Configurable<bool> doMixedEvent{"doMixedEvent", true, "Build the mixed-event pairs"};
+
+  HistogramRegistry histos{"histos", {}, OutputObjHandlingPolicy::AnalysisObject};
+
+  /// Event cuts
+  Configurable<float> ConfEvtZvtx{"ConfEvtZvtx", 10.f, "Evt sel: Max. z-Vertex (cm)"};
+
+  /// DCA Selections
+  // DCAr to PV
+  Configurable<double> cMaxDCArToPVcut{"cMaxDCArToPVcut", 0.5, "Track DCAr cut to PV Maximum"};
+  // DCAz to PV
+  Configurable<double> cMaxDCAzToPVcut{"cMaxDCAzToPVcut", 2.0, "Track DCAz cut to PV Maximum"};
+  Configurable<double> cMinDCAzToPVcut{"cMinDCAzToPVcut", 0.0, "Track DCAz cut to PV Minimum"};
+
+  /// Resonances
+  Configurable<bool> doPhi{"doPhi", true, "Reconstruct phi -> K+K-"};
+  Configurable<bool> doKstar{"doKstar", true, "Reconstruct K*0 -> K+pi-"};
+  Configurable<bool> doLambda1520{"doLambda1520", true, "Reconstruct Lambda(1520) -> pK-"};
+  Configurable<float> cfgMaxRapidity{"cfgMaxRapidity", 0.5f, "Max. |y| of the resonance candidates"};
+
+  Filter daughterFilter = (aod::resodaughter::partType == uint8_t(aod::resodaughter::DaughterType::kTrack)) && (nabs(aod::track::dcaZ) > static_cast<float_t>(cMinDCAzToPVcut)) && (nabs(aod::track::dcaZ) < static_cast<float_t>(cMaxDCAzToPVcut)) && (nabs(aod::track::dcaXY) < static_cast<float_t>(cMaxDCArToPVcut));
+
+  ResonancePairEngine pairEngine;
+  MixingPool mixingPool;
+  DaughterStore currentDaughters;
+  std::array<int, kNResonances> resonanceOf{}; ///< resonance of each hypothesis of the engine
+
+  // histograms of each resonance, filled through the handles to avoid the name lookup per candidate
+  std::array<std::shared_ptr<TH3>, kNResonances> hInvMass;
+  std::array<std::shared_ptr<TH3>, kNResonances> hInvMassLSPos;
+  std::array<std::shared_ptr<TH3>, kNResonances> hInvMassLSNeg;
+  std::array<std::shared_ptr<TH3>, kNResonances> hInvMassME;
+
+  void init(o2::framework::InitContext&)
+  {
+    const float massPi = TDatabasePDG::Instance()->GetParticle(kPiPlus)->Mass();
+    const float massKa = TDatabasePDG::Instance()->GetParticle(kKPlus)->Mass();
+    const float massPr = TDatabasePDG::Instance()->GetParticle(kProton)->Mass();
+
+    const std::array<bool, kNResonances> doResonance = {doPhi, doKstar, doLambda1520};
+    const std::array<std::array<float, 2>, kNResonances> massRanges = {{{0.9f, 1.1f}, {0.7f, 1.1f}, {1.3f, 1.8f}}};
+    for (int iResonance = 0; iResonance < kNResonances; iResonance++) {
+      if (!doResonance[iResonance]) {
+        continue;
+      }
+      const float minMass = massRanges[iResonance][0];
+      const float maxMass = massRanges[iResonance][1];
+      int iHypothesis = 0;
+      switch (iResonance) {
+        case kPhi:
+          iHypothesis = pairEngine.addHypothesis(massKa, aod::resodaughter::kKaon, massKa, aod::resodaughter::kKaon, minMass, maxMass);
+          break;
+        case kKstar:
+          iHypothesis = pairEngine.addHypothesis(massKa, aod::resodaughter::kKaon, massPi, aod::resodaughter::kPion, minMass, maxMass);
+          break;
+        case kLambda1520:
+          iHypothesis = pairEngine.addHypothesis(massPr, aod::resodaughter::kProton, massKa, aod::resodaughter::kKaon, minMass, maxMass);
+          break;
+      }
+      resonanceOf[iHypothesis] = iResonance;
+
+      const std::string name{resonanceNames[iResonance]};
+      AxisSpec multAxis = {100, 0.0f, 100.0f, "V0M multiplicity"};
+      AxisSpec ptAxis = {100, 0.0f, 10.0f, "#it{p}_{T} (GeV/#it{c})"};
+      AxisSpec massAxis = {500, minMass, maxMass, "Invariant Mass (GeV/#it{c}^2)"};
+      hInvMass[iResonance] = histos.add<TH3>((name + "/h3InvMass").c_str(), (name + " unlike sign").c_str(), kTH3F, {multAxis, ptAxis, massAxis});
+      hInvMassLSPos[iResonance] = histos.add<TH3>((name + "/h3InvMassLSPos").c_str(), (name + " like sign, positive").c_str(), kTH3F, {multAxis, ptAxis, massAxis});
+      hInvMassLSNeg[iResonance] = histos.add<TH3>((name + "/h3InvMassLSNeg").c_str(), (name + " like sign, negative").c_str(), kTH3F, {multAxis, ptAxis, massAxis});
+      hInvMassME[iResonance] = histos.add<TH3>((name + "/h3InvMassME").c_str(), (name + " mixed event, unlike sign").c_str(), kTH3F, {multAxis, ptAxis, massAxis});
+    }
+    if (pairEngine.getNHypotheses() == 0) {
+      LOGF(fatal, "No resonance enabled");
+    }
+    if (doMixedEvent) {
+      mixingPool.init(CfgVtxBins.value, CfgMultBins.value, nEvtMixing);
+    }
+
+    histos.add("Event/hVertexZ", "Selected events;Vertex Z (cm)", kTH1F, {{400, -20, 20}});
+    histos.add("Event/hNDaughters", "Selected events;Reduced daughters", kTH1F, {{200, 0, 200}});
+  }
+
+  /// PID bits of a daughter, with the same TPC and TOF requirements as the PID partitions of the resonance analyses
+  template <typename TDaughter>
+  static uint8_t getPidMask(TDaughter const& daughter)
+  {
+    const uint8_t tpcFlag = daughter.tpcPIDselectionFlag();
+    const uint8_t tofFlag = daughter.tofPIDselectionFlag();
+    const bool hasTOF = (tofFlag & aod::resodaughter::kHasTOF) == aod::resodaughter::kHasTOF;
+    uint8_t mask = 0;
+    for (uint8_t species : {aod::resodaughter::kPion, aod::resodaughter::kKaon, aod::resodaughter::kProton}) {
+      if ((tpcFlag & species) == species && (!hasTOF || (tofFlag & species) == species)) {
+        mask |= species;
+      }
+    }
+    return mask;
+  }
+
+  void process(aod::ResoCollision const& collision, soa::Filtered<aod::ResoDaughters> const& daughters)
+  {
+    if (!(std::abs(collision.posZ()) < ConfEvtZvtx)) {
+      return;
+    }
+    histos.fill(HIST("Event/hVertexZ"), collision.posZ());
+
+    pairEngine.load(currentDaughters, daughters, [](auto const& daughter) { return getPidMask(daughter); });
+    histos.fill(HIST("Event/hNDaughters"), currentDaughters.size());
+
+    const float mult = collision.multV0M();
+    pairEngine.processSameEvent(currentDaughters, [&](PairCandidate const& candidate) {
+      if (std::abs(candidate.y) > cfgMaxRapidity) {
+        return;
+      }
+      const int iResonance = resonanceOf[candidate.hypothesis];
+      if (candidate.signOne * candidate.signTwo < 0) {
+        hInvMass[iResonance]->Fill(mult, candidate.pt, candidate.mass);
+      } else if (candidate.signOne > 0) {
+        hInvMassLSPos[iResonance]->Fill(mult, candidate.pt, candidate.mass);
+      } else {
+        hInvMassLSNeg[iResonance]->Fill(mult, candidate.pt, candidate.mass);
+      }
+    });
+
+    if (!doMixedEvent) {
+      return;
+    }
+    // mixed-event pairs with the reduced daughters of the previous collisions of the mixing bin
+    const int bin = mixingPool.getBin(collision.posZ(), mult);
+    if (bin < 0) {
+      return;
+    }
+    mixingPool.mix(bin, [&](DaughterStore const& pooled) {
+      pairEngine.processMixedEvent(currentDaughters, pooled, [&](PairCandidate const& candidate) {
+        if (std::abs(candidate.y) > cfgMaxRapidity || candidate.signOne * candidate.signTwo > 0) {
+          return;
+        }
+        hInvMassME[resonanceOf[candidate.hypothesis]]->Fill(mult, candidate.pt, candidate.mass);
+      });
+    });
+    mixingPool.push(bin, currentDaughters);
+  }
+};
+
+WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
+{
+  return WorkflowSpec{adaptAnalysisTask<resonancepairing>(cfgc, TaskName{"lf-resonancepairing"})};
+}
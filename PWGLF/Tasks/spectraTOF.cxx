@@ -33,11 +33,22 @@
 
 #include "TPDGCode.h"
 
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
 using namespace o2;
 using namespace o2::track;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 
+namespace
+{
+static constexpr int defaultSinglePassSpecies[1][9] = {{0, 0, 1, 1, 1, 0, 0, 0, 0}};
+static const std::vector<std::string> singlePassSpeciesNames{"El", "Mu", "Pi", "Ka", "Pr", "De", "Tr", "He", "Al"};
+} // namespace
+
 // Spectra task
 struct tofSpectra {
   static constexpr PID::ID Np = 9;
@@ -55,6 +66,7 @@ struct tofSpectra {
   ConfigurableAxis binsMultiplicity{"binsMultiplicity", {100, 0, 100}, "Multiplicity"};
   ConfigurableAxis binsMultPercentile{"binsMultPercentile", {100, 0, 100}, "Multiplicity percentile"};
   Configurable<int> multiplicityEstimator{"multiplicityEstimator", 0, "Flag to use a multiplicity estimator: 0 no multiplicity, 1 MultFV0M, 2 MultFT0M, 3 MultFDDM, 4 MultTracklets, 5 MultTPC, 6 MultNTracksPV, 7 MultNTracksPVeta1"};
+  Configurable<LabeledArray<int>> singlePassSpecies{"singlePassSpecies", {defaultSinglePassSpecies[0], 1, Np, {"enabled"}, singlePassSpeciesNames}, "Species filled by processFullAll"};
 
   // Histograms
   HistogramRegistry histos{"Histos", {}, OutputObjHandlingPolicy::AnalysisObject};
@@ -174,6 +186,20 @@ struct tofSpectra {
                                                           "dcazmat/neg/ka", "dcazmat/neg/pr", "dcazmat/neg/de",
                                                           "dcazmat/neg/tr", "dcazmat/neg/he", "dcazmat/neg/al"};
 
+  std::array<bool, Np> enabledSpecies{}; // species with histograms, from the per-species or the single-pass process functions
+  std::vector<int> singlePassIds;        // species filled by the single-pass process functions
+  std::array<float, Np> mass2{};         // squared mass of each species
+
+  // Handles of the histograms filled by the single-pass process functions, [species + Np for the negative tracks]
+  std::array<std::shared_ptr<TH2>, NpCharge> hNSigmaTPC2D;
+  std::array<std::shared_ptr<TH2>, NpCharge> hNSigmaTOF2D;
+  std::array<std::shared_ptr<TH3>, NpCharge> hNSigmaTPC3D;
+  std::array<std::shared_ptr<TH3>, NpCharge> hNSigmaTOF3D;
+  std::array<std::shared_ptr<TH3>, NpCharge> hNSigmaTPCTOF;
+  std::array<std::shared_ptr<TH2>, NpCharge> hDcaXY;
+  std::array<std::shared_ptr<TH2>, NpCharge> hDcaZ;
+  std::array<std::shared_ptr<TH2>, NpCharge> hDcaXYPhi;
+
   void init(o2::framework::InitContext&)
   {
     // Standard process functions
@@ -349,6 +375,25 @@ struct tofSpectra {
         LOG(fatal) << "Cannot have doprocessTinyAl as well, please pick one";
       }
     }
+    // Single pass
+    if (doprocessFullAll) {
+      LOG(info) << "Enabling process function processFullAll";
+    }
+    // Species with histograms
+    const std::array<bool, Np> perSpeciesEnabled = {doprocessFullEl || doprocessTinyEl, doprocessFullMu || doprocessTinyMu, doprocessFullPi || doprocessTinyPi,
+                                                    doprocessFullKa || doprocessTinyKa, doprocessFullPr || doprocessTinyPr, doprocessFullDe || doprocessTinyDe,
+                                                    doprocessFullTr || doprocessTinyTr, doprocessFullHe || doprocessTinyHe, doprocessFullAl || doprocessTinyAl};
+    for (int i = 0; i < Np; i++) {
+      enabledSpecies[i] = perSpeciesEnabled[i];
+      mass2[i] = PID::getMass2(i);
+      if (doprocessFullAll && singlePassSpecies->get(0u, i)) {
+        if (perSpeciesEnabled[i]) {
+          LOGF(fatal, "Species %s is enabled both in the single-pass and in its own process function. Please choose one.", singlePassSpeciesNames[i].c_str());
+        }
+        enabledSpecies[i] = true;
+        singlePassIds.push_back(i);
+      }
+    }
     // Checking consistency
     if (doprocessRun2 == true && doprocessRun3 == true) {
       LOGF(fatal, "Cannot enable processRun2 and processRun3 at the same time. Please choose one.");
@@ -440,107 +485,25 @@ struct tofSpectra {
     }
 
     for (int i = 0; i < NpCharge; i++) {
-
-      switch (i) {
-        case 0:
-        case Np:
-          if (doprocessFullEl == false && doprocessTinyEl == false) {
-            continue;
-          }
-          break;
-        case 1:
-        case Np + 1:
-          if (doprocessFullMu == false && doprocessTinyMu == false) {
-            continue;
-          }
-          break;
-        case 2:
-        case Np + 2:
-          if (doprocessFullPi == false && doprocessTinyPi == false) {
-            continue;
-          }
-          break;
-        case 3:
-        case Np + 3:
-          if (doprocessFullKa == false && doprocessTinyKa == false) {
-            continue;
-          }
-          break;
-        case 4:
-        case Np + 4:
-          if (doprocessFullPr == false && doprocessTinyPr == false) {
-            continue;
-          }
-          break;
-        case 5:
-        case Np + 5:
-          if (doprocessFullDe == false && doprocessTinyDe == false) {
-            continue;
-          }
-          break;
-        case 6:
-        case Np + 6:
-          if (doprocessFullTr == false && doprocessTinyTr == false) {
-            continue;
-          }
-          break;
-        case 7:
-        case Np + 7:
-          if (doprocessFullHe == false && doprocessTinyHe == false) {
-            continue;
-          }
-          break;
-        case 8:
-        case Np + 8:
-          if (doprocessFullAl == false && doprocessTinyAl == false) {
-            continue;
-          }
-          break;
+      if (!enabledSpecies[i % Np]) {
+        continue;
       }
 
       const AxisSpec nsigmaTPCAxis{200, -10, 10, Form("N_{#sigma}^{TPC}(%s)", pTCharge[i])};
       const AxisSpec nsigmaTOFAxis{200, -10, 10, Form("N_{#sigma}^{TOF}(%s)", pTCharge[i])};
-      histos.add(hnsigmatpctof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, nsigmaTOFAxis});
+      hNSigmaTPCTOF[i] = histos.add<TH3>(hnsigmatpctof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, nsigmaTOFAxis});
 
-      switch (multiplicityEstimator) {
-        case 0:
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH2F, {ptAxis, nsigmaTOFAxis});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH2F, {ptAxis, nsigmaTPCAxis});
-          break;
-        case 1: // MultFV0M
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultPercentile, "MultFV0M"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultPercentile, "MultFV0M"}});
-          break;
-        case 2: // MultFT0M
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultPercentile, "MultFT0M"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultPercentile, "MultFT0M"}});
-          break;
-        case 3: // MultFDDM
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultPercentile, "MultFDDM"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultPercentile, "MultFDDM"}});
-          break;
-        case 4: // MultTracklets
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultiplicity, "MultTracklets"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultiplicity, "MultTracklets"}});
-          break;
-        case 5: // MultTPC
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultiplicity, "MultTPC"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultiplicity, "MultTPC"}});
-          break;
-        case 6: // MultNTracksPV
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultiplicity, "MultNTracksPV"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultiplicity, "MultNTracksPV"}});
-          break;
-        case 7: // MultNTracksPVeta1
-          histos.add(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, {binsMultiplicity, "MultNTracksPVeta1"}});
-          histos.add(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, {binsMultiplicity, "MultNTracksPVeta1"}});
-          break;
-        default:
-          LOG(fatal) << "Unrecognized option for multiplicity " << multiplicityEstimator;
+      if (multiplicityEstimator == 0) {
+        hNSigmaTOF2D[i] = histos.add<TH2>(hnsigmatof[i].data(), pTCharge[i], kTH2F, {ptAxis, nsigmaTOFAxis});
+        hNSigmaTPC2D[i] = histos.add<TH2>(hnsigmatpc[i].data(), pTCharge[i], kTH2F, {ptAxis, nsigmaTPCAxis});
+      } else {
+        const AxisSpec multAxis = getMultiplicityAxis();
+        hNSigmaTOF3D[i] = histos.add<TH3>(hnsigmatof[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTOFAxis, multAxis});
+        hNSigmaTPC3D[i] = histos.add<TH3>(hnsigmatpc[i].data(), pTCharge[i], kTH3F, {ptAxis, nsigmaTPCAxis, multAxis});
       }
-      histos.add(hdcaxy[i].data(), pTCharge[i], kTH2F, {ptAxis, dcaXyAxis});
-      histos.add(hdcaz[i].data(), pTCharge[i], kTH2F, {ptAxis, dcaZAxis});
-      histos.add(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pTCharge[i]), kTH2F, {phiAxis, dcaXyAxis});
+      hDcaXY[i] = histos.add<TH2>(hdcaxy[i].data(), pTCharge[i], kTH2F, {ptAxis, dcaXyAxis});
+      hDcaZ[i] = histos.add<TH2>(hdcaz[i].data(), pTCharge[i], kTH2F, {ptAxis, dcaZAxis});
+      hDcaXYPhi[i] = histos.add<TH2>(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pTCharge[i]), kTH2F, {phiAxis, dcaXyAxis});
 
       if (doprocessMC) {
         histos.add(hpt_num_prm[i].data(), pTCharge[i], kTH1F, {ptAxis});
@@ -561,17 +524,35 @@ struct tofSpectra {
     }
   }
 
-  template <bool fillFullInfo, bool useRun3Multiplicity, PID::ID id, typename T, typename C>
-  void fillParticleHistos(const T& track, const C& collision)
+  /// Axis of the configured multiplicity estimator
+  AxisSpec getMultiplicityAxis()
   {
-    if (abs(track.rapidity(PID::getMass(id))) > cfgCutY) {
-      return;
-    }
-    const auto& nsigmaTOF = o2::aod::pidutils::tofNSigma<id>(track);
-    const auto& nsigmaTPC = o2::aod::pidutils::tpcNSigma<id>(track);
-    // const auto id = track.sign() > 0 ? id : id + Np;
-    float multiplicity = 0.f;
+    switch (multiplicityEstimator) {
+      case 1: // MultFV0M
+        return {binsMultPercentile, "MultFV0M"};
+      case 2: // MultFT0M
+        return {binsMultPercentile, "MultFT0M"};
+      case 3: // MultFDDM
+        return {binsMultPercentile, "MultFDDM"};
+      case 4: // MultTracklets
+        return {binsMultiplicity, "MultTracklets"};
+      case 5: // MultTPC
+        return {binsMultiplicity, "MultTPC"};
+      case 6: // MultNTracksPV
+        return {binsMultiplicity, "MultNTracksPV"};
+      case 7: // MultNTracksPVeta1
+        return {binsMultiplicity, "MultNTracksPVeta1"};
+      default:
+        LOG(fatal) << "Unrecognized option for multiplicity " << multiplicityEstimator;
+    }
+    return {binsMultiplicity, "Multiplicity"};
+  }
 
+  /// Multiplicity of the collision with the configured estimator, 0 without estimator or for the Run 2 process functions
+  template <bool useRun3Multiplicity, typename C>
+  float getMultiplicity(const C& collision)
+  {
+    float multiplicity = 0.f;
     if constexpr (useRun3Multiplicity) {
       switch (multiplicityEstimator) {
         case 1: // MultFV0M
@@ -602,6 +583,19 @@ struct tofSpectra {
           break;
       }
     }
+    return multiplicity;
+  }
+
+  template <bool fillFullInfo, bool useRun3Multiplicity, PID::ID id, typename T, typename C>
+  void fillParticleHistos(const T& track, const C& collision)
+  {
+    if (abs(track.rapidity(PID::getMass(id))) > cfgCutY) {
+      return;
+    }
+    const auto& nsigmaTOF = o2::aod::pidutils::tofNSigma<id>(track);
+    const auto& nsigmaTPC = o2::aod::pidutils::tpcNSigma<id>(track);
+    // const auto id = track.sign() > 0 ? id : id + Np;
+    const float multiplicity = getMultiplicity<useRun3Multiplicity>(collision);
 
     if (multiplicityEstimator == 0) {
       if (track.sign() > 0) {
@@ -887,65 +881,87 @@ struct tofSpectra {
   makeProcessFunctionTinyRun2(Al, Alpha);
 #undef makeProcessFunctionTinyRun2
 
+  /// Fills the histograms of all the single-pass species, the track columns and the n sigma of each species are read once
+  template <typename T>
+  void fillAllParticleHistos(const T& track, float multiplicity)
+  {
+    const float pt = track.pt();
+    const float sinhEta = std::sinh(track.eta());
+    const float phi = track.phi();
+    const float dcaXY = track.dcaXY();
+    const float dcaZ = track.dcaZ();
+    const bool hasTOF = track.hasTOF();
+    const int chargeOffset = track.sign() > 0 ? 0 : Np;
+    std::array<float, Np> nsigmaTPC;
+    std::array<float, Np> nsigmaTOF;
+    static_for<0, Np - 1>([&](auto i) {
+      constexpr PID::ID id = i.value;
+      nsigmaTPC[id] = o2::aod::pidutils::tpcNSigma<id>(track);
+      nsigmaTOF[id] = o2::aod::pidutils::tofNSigma<id>(track);
+    });
+
+    for (const int id : singlePassIds) {
+      if (std::abs(std::asinh(pt / std::sqrt(mass2[id] + pt * pt) * sinhEta)) > cfgCutY) {
+        continue;
+      }
+      const int i = id + chargeOffset;
+      if (multiplicityEstimator == 0) {
+        hNSigmaTPC2D[i]->Fill(pt, nsigmaTPC[id]);
+      } else {
+        hNSigmaTPC3D[i]->Fill(pt, nsigmaTPC[id], multiplicity);
+      }
+      if (!hasTOF) {
+        continue;
+      }
+      if (multiplicityEstimator == 0) {
+        hNSigmaTOF2D[i]->Fill(pt, nsigmaTOF[id]);
+      } else {
+        hNSigmaTOF3D[i]->Fill(pt, nsigmaTOF[id], multiplicity);
+      }
+      hNSigmaTPCTOF[i]->Fill(pt, nsigmaTPC[id], nsigmaTOF[id]);
+
+      // Filling DCA info with the TPC+TOF PID
+      if (std::sqrt(nsigmaTOF[id] * nsigmaTOF[id] + nsigmaTPC[id] * nsigmaTPC[id]) < 2.f) {
+        hDcaXY[i]->Fill(pt, dcaXY);
+        hDcaZ[i]->Fill(pt, dcaZ);
+        if (pt < 1.1 && pt > 0.9) {
+          hDcaXYPhi[i]->Fill(phi, dcaXY);
+        }
+      }
+    }
+  }
+
+  using TrackCandidatesAllSpecies = soa::Join<TrackCandidates,
+                                              aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi,
+                                              aod::pidTOFFullKa, aod::pidTOFFullPr, aod::pidTOFFullDe,
+                                              aod::pidTOFFullTr, aod::pidTOFFullHe, aod::pidTOFFullAl,
+                                              aod::pidTPCFullEl, aod::pidTPCFullMu, aod::pidTPCFullPi,
+                                              aod::pidTPCFullKa, aod::pidTPCFullPr, aod::pidTPCFullDe,
+                                              aod::pidTPCFullTr, aod::pidTPCFullHe, aod::pidTPCFullAl>;
+
+  // Single pass over the tracks for all the species enabled in singlePassSpecies, instead of one process function per species
+  void processFullAll(CollisionCandidate::iterator const& collision,
+                      TrackCandidatesAllSpecies const& tracks)
+  {
+    if (!isEventSelected<false, false>(collision)) {
+      return;
+    }
+    const float multiplicity = getMultiplicity<true>(collision);
+    for (const auto& track : tracks) {
+      if (!isTrackSelected<false>(track)) {
+        continue;
+      }
+      fillAllParticleHistos(track, multiplicity);
+    }
+  }
+  PROCESS_SWITCH(tofSpectra, processFullAll, "Process for the species of singlePassSpecies in a single pass, from the full tables of all the species", false);
+
   template <std::size_t i, typename T1, typename T2>
   void fillHistograms_MC(T1 const& tracks, T2 const& mcParticles)
   {
 
-    switch (i) {
-      case 0:
-      case Np:
-        if (doprocessFullEl == false && doprocessTinyEl == false) {
-          return;
-        }
-        break;
-      case 1:
-      case Np + 1:
-        if (doprocessFullMu == false && doprocessTinyMu == false) {
-          return;
-        }
-        break;
-      case 2:
-      case Np + 2:
-        if (doprocessFullPi == false && doprocessTinyPi == false) {
-          return;
-        }
-        break;
-      case 3:
-      case Np + 3:
-        if (doprocessFullKa == false && doprocessTinyKa == false) {
-          return;
-        }
-        break;
-      case 4:
-      case Np + 4:
-        if (doprocessFullPr == false && doprocessTinyPr == false) {
-          return;
-        }
-        break;
-      case 5:
-      case Np + 5:
-        if (doprocessFullDe == false && doprocessTinyDe == false) {
-          return;
-        }
-        break;
-      case 6:
-      case Np + 6:
-        if (doprocessFullTr == false && doprocessTinyTr == false) {
-          return;
-        }
-        break;
-      case 7:
-      case Np + 7:
-        if (doprocessFullHe == false && doprocessTinyHe == false) {
-          return;
-        }
-        break;
-      case 8:
-      case Np + 8:
-        if (doprocessFullAl == false && doprocessTinyAl == false) {
-          return;
-        }
-        break;
+    if (!enabledSpecies[i % Np]) {
+      return;
     }
 
     for (auto& track : tracks) {
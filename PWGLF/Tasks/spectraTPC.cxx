@@ -26,6 +26,11 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/Core/TrackSelection.h"
 #include "Common/Core/TrackSelectionDefaults.h"
+#include "Framework/StaticFor.h"
+
+#include <array>
+#include <cmath>
+#include <memory>
 
 using namespace o2;
 using namespace o2::track;
@@ -71,6 +76,14 @@ struct tpcSpectra {
                                                      "dcaxyphi/Ka", "dcaxyphi/Pr", "dcaxyphi/De",
                                                      "dcaxyphi/Tr", "dcaxyphi/He", "dcaxyphi/Al"};
 
+  // Handles of the histograms, filled for all the species in a single pass over the tracks
+  std::array<std::shared_ptr<TH1>, Np> hP;
+  std::array<std::shared_ptr<TH1>, Np> hPt;
+  std::array<std::shared_ptr<TH2>, Np> hDcaXY;
+  std::array<std::shared_ptr<TH2>, Np> hDcaZ;
+  std::array<std::shared_ptr<TH2>, Np> hDcaXYPhi;
+  std::array<float, Np> mass2; // squared mass of each species
+
   TrackSelection globalTrackswoPrim; // Track without cut for primaries
 
   void init(o2::framework::InitContext&)
@@ -98,8 +111,9 @@ struct tpcSpectra {
     histos.add("p/Unselected", "Unselected", kTH1F, {pAxis});
     histos.add("pt/Unselected", "Unselected", kTH1F, {ptAxis});
     for (int i = 0; i < Np; i++) {
-      histos.add(hp[i].data(), pT[i], kTH1F, {pAxis});
-      histos.add(hpt[i].data(), pT[i], kTH1F, {ptAxis});
+      hP[i] = histos.add<TH1>(hp[i].data(), pT[i], kTH1F, {pAxis});
+      hPt[i] = histos.add<TH1>(hpt[i].data(), pT[i], kTH1F, {ptAxis});
+      mass2[i] = PID::getMass2(i);
     }
 
     // DCAxy
@@ -107,35 +121,50 @@ struct tpcSpectra {
     const AxisSpec phiAxis{200, 0, 7, "#it{#varphi} (rad)"};
     const AxisSpec dcaZAxis{600, -3.005, 2.995, "DCA_{z} (cm)"};
     for (int i = 0; i < Np; i++) {
-      histos.add(hdcaxy[i].data(), pT[i], kTH2F, {ptAxis, dcaXyAxis});
-      histos.add(hdcaz[i].data(), pT[i], kTH2F, {ptAxis, dcaZAxis});
-      histos.add(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pT[i]), kTH2F, {phiAxis, dcaXyAxis});
+      hDcaXY[i] = histos.add<TH2>(hdcaxy[i].data(), pT[i], kTH2F, {ptAxis, dcaXyAxis});
+      hDcaZ[i] = histos.add<TH2>(hdcaz[i].data(), pT[i], kTH2F, {ptAxis, dcaZAxis});
+      hDcaXYPhi[i] = histos.add<TH2>(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pT[i]), kTH2F, {phiAxis, dcaXyAxis});
     }
   }
 
-  template <PID::ID id, typename T>
+  /// Fills the histograms of all the species, the track columns and the n sigma of each species are read once
+  template <typename T>
   void fillParticleHistos(const T& track)
   {
-    const float y = TMath::ASinH(track.pt() / TMath::Sqrt(PID::getMass2(id) + track.pt() * track.pt()) * TMath::SinH(track.eta()));
-    if (abs(y) > 0.5) {
-      return;
-    }
-    const auto& nsigma = o2::aod::pidutils::tpcNSigma<id>(track);
-    if (std::abs(nsigma) < 2) {
-      histos.fill(HIST(hdcaxy[id]), track.pt(), track.dcaXY());
-      histos.fill(HIST(hdcaz[id]), track.pt(), track.dcaZ());
-      if (track.pt() < 1.1 && track.pt() > 0.9) {
-        histos.fill(HIST(hdcaxyphi[id]), track.phi(), track.dcaXY());
+    const float pt = track.pt();
+    const float p = track.p();
+    const float sinhEta = std::sinh(track.eta());
+    const float phi = track.phi();
+    const float dcaXY = track.dcaXY();
+    const float dcaZ = track.dcaZ();
+    const bool isGlobalTrack = track.isGlobalTrack();
+    std::array<float, Np> nsigma;
+    static_for<0, Np - 1>([&](auto i) {
+      constexpr PID::ID id = i.value;
+      nsigma[id] = o2::aod::pidutils::tpcNSigma<id>(track);
+    });
+
+    for (int id = 0; id < Np; id++) {
+      const float y = std::asinh(pt / std::sqrt(mass2[id] + pt * pt) * sinhEta);
+      if (std::abs(y) > 0.5) {
+        continue;
       }
+      if (std::abs(nsigma[id]) < 2) {
+        hDcaXY[id]->Fill(pt, dcaXY);
+        hDcaZ[id]->Fill(pt, dcaZ);
+        if (pt < 1.1 && pt > 0.9) {
+          hDcaXYPhi[id]->Fill(phi, dcaXY);
+        }
+      }
+      if (!isGlobalTrack) {
+        continue;
+      }
+      if (std::abs(nsigma[id]) > cfgNSigmaCut) {
+        continue;
+      }
+      hP[id]->Fill(p);
+      hPt[id]->Fill(pt);
     }
-    if (!track.isGlobalTrack()) {
-      return;
-    }
-    if (abs(nsigma) > cfgNSigmaCut) {
-      return;
-    }
-    histos.fill(HIST(hp[id]), track.p());
-    histos.fill(HIST(hpt[id]), track.pt());
   }
 
   using TrackCandidates = soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksDCA,
@@ -175,15 +204,7 @@ struct tpcSpectra {
       histos.fill(HIST("p/Unselected"), track.p());
       histos.fill(HIST("pt/Unselected"), track.pt());
 
-      fillParticleHistos<PID::Electron>(track);
-      fillParticleHistos<PID::Muon>(track);
-      fillParticleHistos<PID::Pion>(track);
-      fillParticleHistos<PID::Kaon>(track);
-      fillParticleHistos<PID::Proton>(track);
-      fillParticleHistos<PID::Deuteron>(track);
-      fillParticleHistos<PID::Triton>(track);
-      fillParticleHistos<PID::Helium3>(track);
-      fillParticleHistos<PID::Alpha>(track);
+      fillParticleHistos(track);
     }
   } // end of the process function
 };  // end of spectra task
@@ -214,6 +235,12 @@ struct tpcPidQaSignalwTof {
                                                      "dcaxyphi/Ka", "dcaxyphi/Pr", "dcaxyphi/De",
                                                      "dcaxyphi/Tr", "dcaxyphi/He", "dcaxyphi/Al"};
 
+  // Handles of the histograms, filled for all the species in a single pass over the tracks
+  std::array<std::shared_ptr<TH3>, Np> hTPCSignal;
+  std::array<std::shared_ptr<TH2>, Np> hDcaXY;
+  std::array<std::shared_ptr<TH2>, Np> hDcaZ;
+  std::array<std::shared_ptr<TH2>, Np> hDcaXYPhi;
+
   void init(o2::framework::InitContext&)
   {
     const AxisSpec vtxZAxis{100, -20, 20, "Vtx_{z} (cm)"};
@@ -240,31 +267,46 @@ struct tpcPidQaSignalwTof {
       const AxisSpec nSigmaTPCAxis{nBinsNSigma, minNSigma, maxNSigma, Form("N_{#sigma}^{TPC}(%s)", pT[i])};
       const AxisSpec nSigmaTOFAxis{nBinsNSigma, minNSigma, maxNSigma, Form("N_{#sigma}^{TOF}(%s)", pT[i])};
       // TPC Signal
-      histos.add(htpcsignal[i].data(), pT[i], kTH3D, {pAxis, axisSignal, nSigmaTOFAxis});
+      hTPCSignal[i] = histos.add<TH3>(htpcsignal[i].data(), pT[i], kTH3D, {pAxis, axisSignal, nSigmaTOFAxis});
       histos.add(hnsigmatpctof[i].data(), pT[i], kTH3F, {ptAxis, nSigmaTPCAxis, nSigmaTOFAxis});
       // DCAxy
-      histos.add(hdcaxy[i].data(), pT[i], kTH2F, {ptAxis, dcaXyAxis});
-      histos.add(hdcaz[i].data(), pT[i], kTH2F, {ptAxis, dcaZAxis});
-      histos.add(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pT[i]), kTH2F, {phiAxis, dcaXyAxis});
+      hDcaXY[i] = histos.add<TH2>(hdcaxy[i].data(), pT[i], kTH2F, {ptAxis, dcaXyAxis});
+      hDcaZ[i] = histos.add<TH2>(hdcaz[i].data(), pT[i], kTH2F, {ptAxis, dcaZAxis});
+      hDcaXYPhi[i] = histos.add<TH2>(hdcaxyphi[i].data(), Form("%s -- 0.9 < #it{p}_{T} < 1.1 GeV/#it{c}", pT[i]), kTH2F, {phiAxis, dcaXyAxis});
     }
   }
 
-  template <PID::ID id, typename T>
+  /// Fills the histograms of all the species, the track columns and the n sigma of each species are read once
+  template <typename T>
   void fillParticleHistos(const T& track)
   {
-    const auto& nsigmaTOF = o2::aod::pidutils::tofNSigma<id>(track);
-    const auto& nsigmaTPC = o2::aod::pidutils::tpcNSigma<id>(track);
-    if (std::sqrt(nsigmaTPC * nsigmaTPC + nsigmaTOF * nsigmaTOF) < 2) {
-      histos.fill(HIST(hdcaxy[id]), track.pt(), track.dcaXY());
-      if (track.pt() < 1.1 && track.pt() > 0.9) {
-        histos.fill(HIST(hdcaxyphi[id]), track.phi(), track.dcaXY());
+    const float pt = track.pt();
+    const float phi = track.phi();
+    const float dcaXY = track.dcaXY();
+    const float dcaZ = track.dcaZ();
+    const bool isGlobalTrack = track.isGlobalTrack();
+    const float tpcInnerParam = track.tpcInnerParam();
+    const float tpcSignal = track.tpcSignal();
+    std::array<float, Np> nsigmaTPC;
+    std::array<float, Np> nsigmaTOF;
+    static_for<0, Np - 1>([&](auto i) {
+      constexpr PID::ID id = i.value;
+      nsigmaTPC[id] = o2::aod::pidutils::tpcNSigma<id>(track);
+      nsigmaTOF[id] = o2::aod::pidutils::tofNSigma<id>(track);
+    });
+
+    for (int id = 0; id < Np; id++) {
+      if (std::sqrt(nsigmaTPC[id] * nsigmaTPC[id] + nsigmaTOF[id] * nsigmaTOF[id]) < 2) {
+        hDcaXY[id]->Fill(pt, dcaXY);
+        if (pt < 1.1 && pt > 0.9) {
+          hDcaXYPhi[id]->Fill(phi, dcaXY);
+        }
+        hDcaZ[id]->Fill(pt, dcaZ);
+      }
+      if (isGlobalTrack) {
+        hTPCSignal[id]->Fill(tpcInnerParam, tpcSignal, nsigmaTOF[id]);
       }
-      histos.fill(HIST(hdcaz[id]), track.pt(), track.dcaZ());
-    }
-    if (!track.isGlobalTrack()) {
-      return;
     }
-    histos.fill(HIST(htpcsignal[id]), track.tpcInnerParam(), track.tpcSignal(), nsigmaTOF);
   }
 
   using TrackCandidates = soa::Join<aod::Tracks, aod::TracksExtra, aod::TracksDCA,
@@ -300,15 +342,7 @@ struct tpcPidQaSignalwTof {
       }
       histos.fill(HIST("tracksel"), 4);
 
-      fillParticleHistos<PID::Electron>(track);
-      fillParticleHistos<PID::Muon>(track);
-      fillParticleHistos<PID::Pion>(track);
-      fillParticleHistos<PID::Kaon>(track);
-      fillParticleHistos<PID::Proton>(track);
-      fillParticleHistos<PID::Deuteron>(track);
-      fillParticleHistos<PID::Triton>(track);
-      fillParticleHistos<PID::Helium3>(track);
-      fillParticleHistos<PID::Alpha>(track);
+      fillParticleHistos(track);
     }
   }
 };
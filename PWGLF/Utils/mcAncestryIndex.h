@@ -0,0 +1,136 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file mcAncestryIndex.h
+/// \brief Flat index of the MC mothers of the particles and of the MC labels of the tracks of a dataframe
+///
+/// The mother ids of all the MC particles are copied once per dataframe into one contiguous array, with the offsets of
+/// the mothers of each particle, and the MC particle ids of the tracks into another. The common mother of the prongs of
+/// a V0 or of a cascade is then found by comparing integers of the arrays, without dereferencing the table iterators.
+/// The matching keeps the semantics of the nested loops over mothers_as: all the mother pairs are compared and the last
+/// matching pair is taken.
+
+#ifndef PWGLF_UTILS_MCANCESTRYINDEX_H_
+#define PWGLF_UTILS_MCANCESTRYINDEX_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace o2::analysis::strangeness
+{
+
+class McAncestryIndex
+{
+ public:
+  /// Copies the mother ids of the MC particles, to be called once per dataframe
+  template <typename TMcParticles>
+  void buildMothers(TMcParticles const& particlesMC)
+  {
+    mMotherOffsets.clear();
+    mMotherIds.clear();
+    mMotherOffsets.reserve(particlesMC.size() + 1);
+    mMotherIds.reserve(particlesMC.size());
+    mMotherOffsets.push_back(0);
+    for (auto const& particle : particlesMC) {
+      if (particle.has_mothers()) {
+        for (auto const& motherId : particle.mothersIds()) {
+          if (motherId >= 0) {
+            mMotherIds.push_back(motherId);
+          }
+        }
+      }
+      mMotherOffsets.push_back(mMotherIds.size());
+    }
+  }
+
+  /// Copies the MC particle ids of the tracks, -1 for the tracks without MC particle, to be called once per dataframe
+  /// with the full tracks table
+  template <typename TTracks>
+  void buildLabels(TTracks const& tracks)
+  {
+    mTrackLabels.assign(tracks.size(), -1);
+    for (auto const& track : tracks) {
+      if (track.has_mcParticle()) {
+        mTrackLabels[track.globalIndex()] = track.mcParticleId();
+      }
+    }
+  }
+
+  /// MC particle id of a track, given its index in the tracks table
+  int label(int64_t trackId) const
+  {
+    return (trackId >= 0 && trackId < static_cast<int64_t>(mTrackLabels.size())) ? mTrackLabels[trackId] : -1;
+  }
+
+  /// Whether an MC particle has mothers
+  bool hasMothers(int particle) const
+  {
+    return isValid(particle) && mMotherOffsets[particle + 1] > mMotherOffsets[particle];
+  }
+
+  /// Common mother of two MC particles, -1 if none
+  int commonMother(int particle1, int particle2) const
+  {
+    if (!isValid(particle1) || !isValid(particle2)) {
+      return -1;
+    }
+    int mother = -1;
+    for (auto i = mMotherOffsets[particle1]; i < mMotherOffsets[particle1 + 1]; i++) {
+      for (auto j = mMotherOffsets[particle2]; j < mMotherOffsets[particle2 + 1]; j++) {
+        if (mMotherIds[i] == mMotherIds[j]) {
+          mother = mMotherIds[i];
+        }
+      }
+    }
+    return mother;
+  }
+
+  /// Common mother of the prongs of a V0 given the indices of its tracks, -1 if none
+  int v0Mother(int64_t negTrackId, int64_t posTrackId) const
+  {
+    return commonMother(label(negTrackId), label(posTrackId));
+  }
+
+  /// Common mother of a V0 and the bachelor of a cascade given the indices of its tracks, -1 if none
+  /// \note all the common mothers of the V0 prongs are tried, as in the nested loops over the mothers of the prongs
+  int cascadeMother(int64_t negTrackId, int64_t posTrackId, int64_t bachTrackId) const
+  {
+    const int neg = label(negTrackId);
+    const int pos = label(posTrackId);
+    const int bach = label(bachTrackId);
+    if (!isValid(neg) || !isValid(pos) || !isValid(bach)) {
+      return -1;
+    }
+    int mother = -1;
+    for (auto i = mMotherOffsets[neg]; i < mMotherOffsets[neg + 1]; i++) {
+      for (auto j = mMotherOffsets[pos]; j < mMotherOffsets[pos + 1]; j++) {
+        if (mMotherIds[i] == mMotherIds[j]) {
+          auto v0Mother = commonMother(mMotherIds[i], bach);
+          if (v0Mother >= 0) {
+            mother = v0Mother;
+          }
+        }
+      }
+    }
+    return mother;
+  }
+
+ private:
+  bool isValid(int particle) const { return particle >= 0 && particle + 1 < static_cast<int>(mMotherOffsets.size()); }
+
+  std::vector<int> mMotherOffsets; // first mother of every particle in mMotherIds, and number of mothers at the end
+  std::vector<int> mMotherIds;     // mother ids of all the particles, particle after particle
+  std::vector<int> mTrackLabels;   // MC particle id of every track of the dataframe
+};
+
+} // namespace o2::analysis::strangeness
+
+#endif // PWGLF_UTILS_MCANCESTRYINDEX_H_
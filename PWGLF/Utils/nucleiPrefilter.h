@@ -0,0 +1,131 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file nucleiPrefilter.h
+/// \brief Prefilter of the light-nuclei candidates of a collision for several species in a single pass
+///
+/// The TPC momentum and the TPC and TOF nsigma of d, t, 3He and alpha are read once into contiguous arrays.
+/// Each species is then selected with branch-free loops: a TPC nsigma band at all momenta, and in addition a TOF nsigma
+/// band above a TPC momentum threshold. Every track gets a bitmask with bit i set if it is a candidate of species i.
+
+#ifndef PWGLF_UTILS_NUCLEIPREFILTER_H_
+#define PWGLF_UTILS_NUCLEIPREFILTER_H_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Framework/Array2D.h"
+#include "Framework/Logger.h"
+
+namespace o2::analysis::nuclei
+{
+
+/// Species of the prefilter, the rows of its parameters and the bits of the candidate mask
+enum PrefilterSpecies {
+  kPrefilterDe = 0,
+  kPrefilterTr,
+  kPrefilterHe,
+  kPrefilterAl,
+  kNPrefilterSpecies
+};
+static const std::vector<std::string> prefilterSpeciesNames{"De", "Tr", "He", "Al"};
+
+/// Parameters of a species, the columns of the prefilter parameters
+enum PrefilterParameter {
+  kPrefilterEnabled = 0, // species is selected if > 0
+  kPrefilterTPCLow,      // lower edge of the TPC nsigma band
+  kPrefilterTPCHigh,     // upper edge of the TPC nsigma band
+  kPrefilterPTOF,        // TPC momentum (GeV/c) above which a TOF match inside the TOF band is required
+  kPrefilterTOFMax,      // half width of the TOF nsigma band
+  kNPrefilterParameters
+};
+static const std::vector<std::string> prefilterParameterNames{"enabled", "nSigmaTPCLow", "nSigmaTPCHigh", "pTOF", "nSigmaTOFMax"};
+
+class NucleiPrefilter
+{
+ public:
+  /// Sets the selections, one row per species and one column per parameter, in the order of the enums
+  void setParameters(o2::framework::LabeledArray<float> const& parameters)
+  {
+    if (parameters.rows() != kNPrefilterSpecies || parameters.cols() != kNPrefilterParameters) {
+      LOGF(fatal, "Nuclei prefilter parameters of size %d x %d given, %d x %d expected", parameters.rows(), parameters.cols(), kNPrefilterSpecies, kNPrefilterParameters);
+    }
+    for (int iSpecies = 0; iSpecies < kNPrefilterSpecies; iSpecies++) {
+      for (int iPar = 0; iPar < kNPrefilterParameters; iPar++) {
+        mParameters[iSpecies][iPar] = parameters.get(iSpecies, iPar);
+      }
+    }
+  }
+
+  /// Reads the PID columns of the tracks and selects the candidates of all the enabled species
+  /// \return bitmask of the species per track, in the order of the tracks, valid until the next call
+  template <typename TTracks>
+  const std::vector<uint8_t>& evaluate(TTracks const& tracks)
+  {
+    const std::size_t n = tracks.size();
+    mP.resize(n);
+    mHasTOF.resize(n);
+    for (auto& values : mTPC) {
+      values.resize(n);
+    }
+    for (auto& values : mTOF) {
+      values.resize(n);
+    }
+    std::size_t i = 0;
+    for (auto const& track : tracks) {
+      mP[i] = track.tpcInnerParam();
+      mHasTOF[i] = track.hasTOF();
+      mTPC[kPrefilterDe][i] = track.tpcNSigmaDe();
+      mTPC[kPrefilterTr][i] = track.tpcNSigmaTr();
+      mTPC[kPrefilterHe][i] = track.tpcNSigmaHe();
+      mTPC[kPrefilterAl][i] = track.tpcNSigmaAl();
+      mTOF[kPrefilterDe][i] = track.tofNSigmaDe();
+      mTOF[kPrefilterTr][i] = track.tofNSigmaTr();
+      mTOF[kPrefilterHe][i] = track.tofNSigmaHe();
+      mTOF[kPrefilterAl][i] = track.tofNSigmaAl();
+      i++;
+    }
+
+    mMasks.assign(n, 0u);
+    uint8_t* masks = mMasks.data();
+    const float* p = mP.data();
+    const uint8_t* hasTOF = mHasTOF.data();
+    for (int iSpecies = 0; iSpecies < kNPrefilterSpecies; iSpecies++) {
+      const auto& par = mParameters[iSpecies];
+      if (!(par[kPrefilterEnabled] > 0.f)) {
+        continue;
+      }
+      const float* tpc = mTPC[iSpecies].data();
+      const float* tof = mTOF[iSpecies].data();
+      for (std::size_t j = 0; j < n; j++) {
+        const bool passTPC = (tpc[j] > par[kPrefilterTPCLow]) & (tpc[j] < par[kPrefilterTPCHigh]);
+        const bool passTOF = (p[j] < par[kPrefilterPTOF]) | (hasTOF[j] & (std::abs(tof[j]) < par[kPrefilterTOFMax]));
+        masks[j] |= static_cast<uint8_t>(passTPC & passTOF) << iSpecies;
+      }
+    }
+    return mMasks;
+  }
+
+ private:
+  std::array<std::array<float, kNPrefilterParameters>, kNPrefilterSpecies> mParameters{}; ///< selections, [species][parameter]
+  std::vector<float> mP;                                                                  ///< TPC momenta of the tracks
+  std::vector<uint8_t> mHasTOF;                                                           ///< TOF matching of the tracks
+  std::array<std::vector<float>, kNPrefilterSpecies> mTPC;                                ///< TPC nsigma, [species][track]
+  std::array<std::vector<float>, kNPrefilterSpecies> mTOF;                                ///< TOF nsigma, [species][track]
+  std::vector<uint8_t> mMasks;                                                            ///< candidate species, per track
+};
+
+} // namespace o2::analysis::nuclei
+
+#endif // PWGLF_UTILS_NUCLEIPREFILTER_H_
@@ -0,0 +1,320 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file resonancePairEngine.h
+/// \brief Same-event and mixed-event pairing of resonance daughters for several decay hypotheses in a single pass
+///
+/// The selected daughters of a collision are reduced once to contiguous arrays (momentum, charge, PID mask and the
+/// energy for each daughter mass in use). The pair momenta of a daughter with all its partners are computed once and
+/// shared by all the decay hypotheses, so that e.g. phi -> KK, K*0 -> Kpi and Lambda(1520) -> pK come out of the same loop.
+/// The reduced daughters of the previous collisions are kept in memory per mixing bin for the mixed-event pairs.
+
+#ifndef PWGLF_UTILS_RESONANCEPAIRENGINE_H_
+#define PWGLF_UTILS_RESONANCEPAIRENGINE_H_
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Framework/HistogramSpec.h"
+#include "Framework/Logger.h"
+
+namespace o2::analysis::resonance
+{
+
+/// Reduced daughters of one collision
+struct DaughterStore {
+  std::vector<float> px;                  ///< momentum components (GeV/c)
+  std::vector<float> py;                  ///<
+  std::vector<float> pz;                  ///<
+  std::vector<int8_t> sign;               ///< charge sign
+  std::vector<uint8_t> pidMask;           ///< species the daughter is selected as, one bit per species
+  std::vector<std::vector<float>> energy; ///< energy for each daughter mass of the engine, [mass][daughter]
+
+  std::size_t size() const { return px.size(); }
+
+  void clear()
+  {
+    px.clear();
+    py.clear();
+    pz.clear();
+    sign.clear();
+    pidMask.clear();
+  }
+};
+
+/// Two-body decay hypothesis
+struct PairHypothesis {
+  int massOne;    ///< index of the mass of daughter one in the engine masses
+  int massTwo;    ///< index of the mass of daughter two
+  uint8_t pidOne; ///< PID bit daughter one must carry
+  uint8_t pidTwo; ///< PID bit daughter two must carry
+  float minMass2; ///< squared invariant mass window of the candidates
+  float maxMass2; ///<
+  bool symmetric; ///< whether both daughters are of the same species, e.g. phi -> KK
+};
+
+/// Resonance candidate passed to the callbacks of the engine
+struct PairCandidate {
+  int hypothesis; ///< index of the hypothesis, as returned by addHypothesis
+  float mass;     ///< invariant mass (GeV/c^2)
+  float pt;       ///< transverse momentum (GeV/c)
+  float y;        ///< rapidity
+  int8_t signOne; ///< charge sign of daughter one
+  int8_t signTwo; ///< charge sign of daughter two
+};
+
+class ResonancePairEngine
+{
+ public:
+  /// Adds a decay hypothesis
+  /// \param massOne, massTwo masses of the two daughters
+  /// \param pidOne, pidTwo PID bits the two daughters must carry in the mask given at loading
+  /// \param minMass, maxMass invariant mass window of the candidates
+  /// \return index of the hypothesis in the candidates
+  int addHypothesis(float massOne, uint8_t pidOne, float massTwo, uint8_t pidTwo, float minMass, float maxMass)
+  {
+    PairHypothesis hypothesis;
+    hypothesis.massOne = getMassIndex(massOne);
+    hypothesis.massTwo = getMassIndex(massTwo);
+    hypothesis.pidOne = pidOne;
+    hypothesis.pidTwo = pidTwo;
+    hypothesis.minMass2 = minMass > 0.f ? minMass * minMass : 0.f;
+    hypothesis.maxMass2 = maxMass * maxMass;
+    hypothesis.symmetric = hypothesis.massOne == hypothesis.massTwo && pidOne == pidTwo;
+    mHypotheses.push_back(hypothesis);
+    return mHypotheses.size() - 1;
+  }
+
+  int getNHypotheses() const { return mHypotheses.size(); }
+
+  /// Reduces the daughters of a collision, the daughters with an empty PID mask are dropped
+  /// \param pidMask returns the PID bits of a daughter
+  template <typename TDaughters, typename TPid>
+  void load(DaughterStore& store, TDaughters const& daughters, TPid&& pidMask) const
+  {
+    store.clear();
+    for (auto const& daughter : daughters) {
+      const uint8_t mask = pidMask(daughter);
+      if (mask == 0) {
+        continue;
+      }
+      store.px.push_back(daughter.px());
+      store.py.push_back(daughter.py());
+      store.pz.push_back(daughter.pz());
+      store.sign.push_back(daughter.sign());
+      store.pidMask.push_back(mask);
+    }
+    const std::size_t n = store.size();
+    store.energy.resize(mMasses.size());
+    for (std::size_t iMass = 0; iMass < mMasses.size(); iMass++) {
+      const float mass2 = mMasses[iMass] * mMasses[iMass];
+      store.energy[iMass].resize(n);
+      float* energy = store.energy[iMass].data();
+      for (std::size_t i = 0; i < n; i++) {
+        energy[i] = std::sqrt(store.px[i] * store.px[i] + store.py[i] * store.py[i] + store.pz[i] * store.pz[i] + mass2);
+      }
+    }
+  }
+
+  /// Same-event candidates of all the hypotheses, each pair of daughters is used once
+  /// \param onCandidate called with each PairCandidate inside the mass window of its hypothesis
+  template <typename TCandidate>
+  void processSameEvent(DaughterStore const& store, TCandidate&& onCandidate)
+  {
+    pairs(store, store, true, onCandidate);
+  }
+
+  /// Mixed-event candidates of all the hypotheses, between the daughters of two collisions
+  template <typename TCandidate>
+  void processMixedEvent(DaughterStore const& current, DaughterStore const& pooled, TCandidate&& onCandidate)
+  {
+    pairs(current, pooled, false, onCandidate);
+  }
+
+ private:
+  int getMassIndex(float mass)
+  {
+    for (std::size_t iMass = 0; iMass < mMasses.size(); iMass++) {
+      if (std::abs(mMasses[iMass] - mass) < 1.e-6f) {
+        return iMass;
+      }
+    }
+    mMasses.push_back(mass);
+    return mMasses.size() - 1;
+  }
+
+  /// Pairs of daughter i of a with the daughters of b, a being daughter one if !swapped
+  template <typename TCandidate>
+  void fillCandidates(int iHypothesis, DaughterStore const& a, std::size_t i, DaughterStore const& b, std::size_t first, bool swapped, TCandidate& onCandidate)
+  {
+    const PairHypothesis& hypothesis = mHypotheses[iHypothesis];
+    const uint8_t pidA = swapped ? hypothesis.pidTwo : hypothesis.pidOne;
+    const uint8_t pidB = swapped ? hypothesis.pidOne : hypothesis.pidTwo;
+    if (!(a.pidMask[i] & pidA)) {
+      return;
+    }
+    const float energyA = a.energy[swapped ? hypothesis.massTwo : hypothesis.massOne][i];
+    const float* energyB = b.energy[swapped ? hypothesis.massOne : hypothesis.massTwo].data() + first;
+    const std::size_t n = mP2.size();
+    float* mass2 = mMass2.data();
+    for (std::size_t k = 0; k < n; k++) {
+      const float energy = energyA + energyB[k];
+      mass2[k] = energy * energy - mP2[k];
+    }
+    for (std::size_t k = 0; k < n; k++) {
+      if (!(b.pidMask[first + k] & pidB) || mass2[k] < hypothesis.minMass2 || mass2[k] > hypothesis.maxMass2) {
+        continue;
+      }
+      const float energy = energyA + energyB[k];
+      PairCandidate candidate;
+      candidate.hypothesis = iHypothesis;
+      candidate.mass = std::sqrt(mass2[k]);
+      candidate.pt = std::sqrt(mPx[k] * mPx[k] + mPy[k] * mPy[k]);
+      candidate.y = 0.5f * std::log((energy + mPz[k]) / (energy - mPz[k]));
+      candidate.signOne = swapped ? b.sign[first + k] : a.sign[i];
+      candidate.signTwo = swapped ? a.sign[i] : b.sign[first + k];
+      onCandidate(candidate);
+    }
+  }
+
+  template <typename TCandidate>
+  void pairs(DaughterStore const& a, DaughterStore const& b, bool sameEvent, TCandidate& onCandidate)
+  {
+    for (std::size_t i = 0; i < a.size(); i++) {
+      const std::size_t first = sameEvent ? i + 1 : 0;
+      if (first >= b.size()) {
+        continue;
+      }
+      // pair momentum, shared by all the hypotheses
+      const std::size_t n = b.size() - first;
+      mPx.resize(n);
+      mPy.resize(n);
+      mPz.resize(n);
+      mP2.resize(n);
+      mMass2.resize(n);
+      for (std::size_t k = 0; k < n; k++) {
+        mPx[k] = a.px[i] + b.px[first + k];
+        mPy[k] = a.py[i] + b.py[first + k];
+        mPz[k] = a.pz[i] + b.pz[first + k];
+        mP2[k] = mPx[k] * mPx[k] + mPy[k] * mPy[k] + mPz[k] * mPz[k];
+      }
+      for (int iHypothesis = 0; iHypothesis < getNHypotheses(); iHypothesis++) {
+        fillCandidates(iHypothesis, a, i, b, first, false, onCandidate);
+        if (!mHypotheses[iHypothesis].symmetric) {
+          fillCandidates(iHypothesis, a, i, b, first, true, onCandidate);
+        }
+      }
+    }
+  }
+
+  std::vector<float> mMasses;              ///< daughter masses in use, one energy array per mass in the stores
+  std::vector<PairHypothesis> mHypotheses; ///< decay hypotheses
+  std::vector<float> mPx, mPy, mPz, mP2;   ///< pair momenta of one daughter with its partners
+  std::vector<float> mMass2;               ///< squared invariant masses of one daughter with its partners
+};
+
+/// Reduced daughters of the last collisions of each mixing bin in z-vertex and multiplicity
+class MixingPool
+{
+ public:
+  /// \param vtxAxis, multAxis mixing binning, in the ConfigurableAxis format ({VARIABLE_WIDTH, edges...} or {nBins, min, max})
+  /// \param depth number of collisions kept per bin
+  void init(std::vector<double> const& vtxAxis, std::vector<double> const& multAxis, int depth)
+  {
+    mVtxEdges = getEdges(vtxAxis);
+    mMultEdges = getEdges(multAxis);
+    if (mVtxEdges.size() < 2 || mMultEdges.size() < 2 || depth < 1) {
+      LOGF(fatal, "Invalid mixing pool: %d z-vertex edges, %d multiplicity edges, depth %d", mVtxEdges.size(), mMultEdges.size(), depth);
+    }
+    mDepth = depth;
+    const std::size_t nBins = (mVtxEdges.size() - 1) * (mMultEdges.size() - 1);
+    mStores.assign(nBins * depth, DaughterStore{});
+    mNext.assign(nBins, 0);
+    mSize.assign(nBins, 0);
+  }
+
+  /// Mixing bin of a collision, -1 outside the binning
+  int getBin(float posZ, float mult) const
+  {
+    const int iVtx = findBin(mVtxEdges, posZ);
+    const int iMult = findBin(mMultEdges, mult);
+    if (iVtx < 0 || iMult < 0) {
+      return -1;
+    }
+    return iVtx * (mMultEdges.size() - 1) + iMult;
+  }
+
+  /// Calls mixWith with each collision of the bin, from the most recent one
+  template <typename TMix>
+  void mix(int bin, TMix&& mixWith) const
+  {
+    for (int iStored = 1; iStored <= mSize[bin]; iStored++) {
+      mixWith(mStores[bin * mDepth + (mNext[bin] - iStored + mDepth) % mDepth]);
+    }
+  }
+
+  /// Keeps the daughters of a collision in its bin, in place of the oldest one if the bin is full
+  void push(int bin, DaughterStore const& store)
+  {
+    if (store.size() == 0) {
+      return;
+    }
+    mStores[bin * mDepth + mNext[bin]] = store;
+    mNext[bin] = (mNext[bin] + 1) % mDepth;
+    if (mSize[bin] < mDepth) {
+      mSize[bin]++;
+    }
+  }
+
+ private:
+  static std::vector<double> getEdges(std::vector<double> const& axis)
+  {
+    if (axis.empty()) {
+      return {};
+    }
+    if (axis[0] == o2::framework::VARIABLE_WIDTH) {
+      return std::vector<double>(axis.begin() + 1, axis.end());
+    }
+    if (axis.size() != 3) {
+      return {};
+    }
+    std::vector<double> edges;
+    const int nBins = axis[0];
+    for (int iBin = 0; iBin <= nBins; iBin++) {
+      edges.push_back(axis[1] + iBin * (axis[2] - axis[1]) / nBins);
+    }
+    return edges;
+  }
+
+  static int findBin(std::vector<double> const& edges, float value)
+  {
+    if (!(value >= edges.front()) || value >= edges.back()) {
+      return -1;
+    }
+    int iBin = 0;
+    while (value >= edges[iBin + 1]) {
+      iBin++;
+    }
+    return iBin;
+  }
+
+  std::vector<double> mVtxEdges;      ///< z-vertex bin edges
+  std::vector<double> mMultEdges;     ///< multiplicity bin edges
+  int mDepth = 1;                     ///< collisions kept per bin
+  std::vector<DaughterStore> mStores; ///< stored daughters, [bin][depth]
+  std::vector<int> mNext;             ///< slot of the next stored collision, per bin
+  std::vector<int> mSize;             ///< number of stored collisions, per bin
+};
+
+} // namespace o2::analysis::resonance
+
+#endif // PWGLF_UTILS_RESONANCEPAIRENGINE_H_
@@ -0,0 +1,201 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file strangenessSelectionKernel.h
+/// \brief Topological selections of V0s and cascades for several cut sets in a single pass
+///
+/// The topological variables of the candidates of a collision are read once from the V0Datas or CascData columns
+/// into contiguous arrays. Each cut set (variation) is then applied with branch-free loops over the arrays,
+/// and every candidate gets a bitmask with bit i set if it passes variation i.
+
+#ifndef PWGLF_UTILS_STRANGENESSSELECTIONKERNEL_H_
+#define PWGLF_UTILS_STRANGENESSSELECTIONKERNEL_H_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Framework/Array2D.h"
+#include "Framework/Logger.h"
+
+namespace o2::analysis::strangeness
+{
+
+/// Selection of candidates on NVars variables for up to 32 cut sets
+/// \tparam NVars number of selection variables
+template <int NVars>
+class SelectionKernel
+{
+ public:
+  static constexpr int MaxVariations = 32;
+
+  /// \param isLowerBound whether a variable is selected above (true) or below (false) its cut
+  explicit SelectionKernel(std::array<bool, NVars> const& isLowerBound) : mIsLowerBound(isLowerBound) {}
+
+  /// Sets the cut sets, one row per variation and one column per variable, in the order of the variables
+  void setVariations(o2::framework::LabeledArray<float> const& cuts)
+  {
+    if (cuts.cols() != NVars) {
+      LOGF(fatal, "Selection variations with %d variables given, %d expected", cuts.cols(), NVars);
+    }
+    if (cuts.rows() > MaxVariations) {
+      LOGF(fatal, "%d selection variations given, at most %d supported", cuts.rows(), MaxVariations);
+    }
+    mCuts.resize(cuts.rows());
+    for (uint32_t iVariation = 0; iVariation < cuts.rows(); iVariation++) {
+      for (uint32_t iVar = 0; iVar < NVars; iVar++) {
+        mCuts[iVariation][iVar] = cuts.get(iVariation, iVar);
+      }
+    }
+  }
+
+  int getNVariations() const { return mCuts.size(); }
+  std::size_t size() const { return mValues[0].size(); }
+
+  /// Applies all the variations to the loaded candidates
+  /// \return bitmask of the passed variations per candidate, valid until the next load
+  const std::vector<uint32_t>& evaluate()
+  {
+    const std::size_t n = size();
+    mMasks.assign(n, 0u);
+    for (std::size_t iVariation = 0; iVariation < mCuts.size(); iVariation++) {
+      mPass.assign(n, 1);
+      uint8_t* pass = mPass.data();
+      for (int iVar = 0; iVar < NVars; iVar++) {
+        const float cut = mCuts[iVariation][iVar];
+        const float* values = mValues[iVar].data();
+        if (mIsLowerBound[iVar]) {
+          for (std::size_t i = 0; i < n; i++) {
+            pass[i] &= values[i] > cut;
+          }
+        } else {
+          for (std::size_t i = 0; i < n; i++) {
+            pass[i] &= values[i] < cut;
+          }
+        }
+      }
+      uint32_t* masks = mMasks.data();
+      for (std::size_t i = 0; i < n; i++) {
+        masks[i] |= static_cast<uint32_t>(pass[i]) << iVariation;
+      }
+    }
+    return mMasks;
+  }
+
+  /// Whether candidate i passed variation iVariation, after evaluate
+  bool isSelected(std::size_t i, int iVariation) const { return (mMasks[i] >> iVariation) & 1u; }
+
+ protected:
+  void resize(std::size_t n)
+  {
+    for (auto& values : mValues) {
+      values.resize(n);
+    }
+  }
+
+  std::array<std::vector<float>, NVars> mValues; ///< values of the variables, [variable][candidate]
+
+ private:
+  std::array<bool, NVars> mIsLowerBound;       ///< whether a variable is selected above its cut
+  std::vector<std::array<float, NVars>> mCuts; ///< cuts, [variation][variable]
+  std::vector<uint8_t> mPass;                  ///< candidates passing the variation being evaluated
+  std::vector<uint32_t> mMasks;                ///< passed variations, per candidate
+};
+
+/// V0 selection variables, the columns of the V0 variations
+enum V0SelectionVariable {
+  kV0CosPA = 0,
+  kV0DcaV0Dau,
+  kV0DcaPosToPV,
+  kV0DcaNegToPV,
+  kV0Radius,
+  kNV0SelectionVariables
+};
+static const std::vector<std::string> v0SelectionVariableNames{"v0cospa", "dcav0dau", "dcapostopv", "dcanegtopv", "v0radius"};
+
+/// Topological selections of the V0s of a collision, from the V0Datas columns
+class V0SelectionKernel : public SelectionKernel<kNV0SelectionVariables>
+{
+ public:
+  V0SelectionKernel() : SelectionKernel({true, false, true, true, true}) {}
+
+  /// Reads the selection variables of the V0s
+  /// \param pvx, pvy, pvz primary vertex position, for the cosine of the pointing angle
+  template <typename TV0s>
+  void load(TV0s const& v0s, float pvx, float pvy, float pvz)
+  {
+    resize(v0s.size());
+    std::size_t i = 0;
+    for (auto const& v0 : v0s) {
+      mValues[kV0CosPA][i] = v0.v0cosPA(pvx, pvy, pvz);
+      mValues[kV0DcaV0Dau][i] = v0.dcaV0daughters();
+      mValues[kV0DcaPosToPV][i] = std::abs(v0.dcapostopv());
+      mValues[kV0DcaNegToPV][i] = std::abs(v0.dcanegtopv());
+      mValues[kV0Radius][i] = v0.v0radius();
+      i++;
+    }
+  }
+};
+
+/// Cascade selection variables, the columns of the cascade variations
+enum CascadeSelectionVariable {
+  kCascCosPA = 0,
+  kCascV0CosPA,
+  kCascDcaCascDau,
+  kCascDcaV0Dau,
+  kCascDcaBachToPV,
+  kCascDcaPosToPV,
+  kCascDcaNegToPV,
+  kCascDcaV0ToPV,
+  kCascRadius,
+  kCascV0Radius,
+  kCascV0MassWindow,
+  kNCascadeSelectionVariables
+};
+static const std::vector<std::string> cascadeSelectionVariableNames{"casccospa", "v0cospa", "dcacascdau", "dcav0dau", "dcabachtopv", "dcapostopv",
+                                                                    "dcanegtopv", "dcav0topv", "cascradius", "v0radius", "v0masswindow"};
+
+/// Topological selections of the cascades of a collision, from the CascData columns
+class CascadeSelectionKernel : public SelectionKernel<kNCascadeSelectionVariables>
+{
+ public:
+  CascadeSelectionKernel() : SelectionKernel({true, true, false, false, true, true, true, true, true, true, false}) {}
+
+  /// Reads the selection variables of the cascades
+  /// \param pvx, pvy, pvz primary vertex position, for the pointing angles and the V0 DCA
+  template <typename TCascades>
+  void load(TCascades const& cascades, float pvx, float pvy, float pvz)
+  {
+    constexpr float massLambda = 1.115683;
+    resize(cascades.size());
+    std::size_t i = 0;
+    for (auto const& casc : cascades) {
+      mValues[kCascCosPA][i] = casc.casccosPA(pvx, pvy, pvz);
+      mValues[kCascV0CosPA][i] = casc.v0cosPA(pvx, pvy, pvz);
+      mValues[kCascDcaCascDau][i] = casc.dcacascdaughters();
+      mValues[kCascDcaV0Dau][i] = casc.dcaV0daughters();
+      mValues[kCascDcaBachToPV][i] = std::abs(casc.dcabachtopv());
+      mValues[kCascDcaPosToPV][i] = std::abs(casc.dcapostopv());
+      mValues[kCascDcaNegToPV][i] = std::abs(casc.dcanegtopv());
+      mValues[kCascDcaV0ToPV][i] = casc.dcav0topv(pvx, pvy, pvz);
+      mValues[kCascRadius][i] = casc.cascradius();
+      mValues[kCascV0Radius][i] = casc.v0radius();
+      mValues[kCascV0MassWindow][i] = std::abs(casc.mLambda() - massLambda);
+      i++;
+    }
+  }
+};
+
+} // namespace o2::analysis::strangeness
+
+#endif // PWGLF_UTILS_STRANGENESSSELECTIONKERNEL_H_
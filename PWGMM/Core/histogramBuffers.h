@@ -0,0 +1,121 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file histogramBuffers.h
+/// \brief Buffered histogram filling for the per-track histograms of the multiplicity tasks
+///
+/// The values of a histogram are collected per collision in contiguous arrays, one per axis, and the histogram
+/// is filled with a single FillN call. The same buffer can be filled into several histograms with the same axes,
+/// e.g. the tracks of all events and of the INEL>0 events, without iterating the tracks again.
+/// Histograms with a handful of bins (ITS layers, MC mask bits) are counted in a plain array and added once.
+
+#ifndef PWGMM_CORE_HISTOGRAMBUFFERS_H_
+#define PWGMM_CORE_HISTOGRAMBUFFERS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "TH1.h"
+#include "TH2.h"
+
+namespace o2::analysis::mm
+{
+
+/// Values of a 1D histogram
+class HistogramBuffer1D
+{
+ public:
+  void clear() { mX.clear(); }
+  void push(double x) { mX.push_back(x); }
+  std::size_t size() const { return mX.size(); }
+
+  /// Fills all the values with weight 1, the buffer is kept
+  void fill(TH1* h) const
+  {
+    if (!mX.empty()) {
+      h->FillN(static_cast<Int_t>(mX.size()), mX.data(), nullptr);
+    }
+  }
+
+ private:
+  std::vector<double> mX;
+};
+
+/// Values of a 2D histogram
+class HistogramBuffer2D
+{
+ public:
+  void clear()
+  {
+    mX.clear();
+    mY.clear();
+  }
+  void push(double x, double y)
+  {
+    mX.push_back(x);
+    mY.push_back(y);
+  }
+  std::size_t size() const { return mX.size(); }
+
+  /// Fills all the values with weight 1, the buffer is kept
+  void fill(TH2* h) const
+  {
+    if (!mX.empty()) {
+      h->FillN(static_cast<Int_t>(mX.size()), mX.data(), mY.data(), nullptr);
+    }
+  }
+
+ private:
+  std::vector<double> mX;
+  std::vector<double> mY;
+};
+
+/// Counts of the first N bins of a 1D histogram with integer bin centres
+template <int N>
+class BinCounter
+{
+ public:
+  /// Counts once every set bit of mask, bit i goes to bin i + offset
+  void addBits(uint32_t mask, int offset = 1)
+  {
+    for (; mask != 0; mask &= mask - 1) {
+      mCounts[__builtin_ctz(mask) + offset]++;
+    }
+  }
+  void add(int bin) { mCounts[bin]++; }
+
+  /// Adds the counts to h and resets them
+  void flush(TH1* h)
+  {
+    double nEntries = 0.;
+    for (int bin = 0; bin < N; bin++) {
+      if (mCounts[bin] == 0.) {
+        continue;
+      }
+      h->AddBinContent(bin, mCounts[bin]);
+      if (h->GetSumw2N() > 0) {
+        (*h->GetSumw2())[bin] += mCounts[bin];
+      }
+      nEntries += mCounts[bin];
+      mCounts[bin] = 0.;
+    }
+    h->SetEntries(h->GetEntries() + nEntries);
+  }
+
+ private:
+  std::array<double, N> mCounts{}; ///< counts per bin, including the underflow bin 0
+};
+
+} // namespace o2::analysis::mm
+
+#endif // PWGMM_CORE_HISTOGRAMBUFFERS_H_
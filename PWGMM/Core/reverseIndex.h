@@ -0,0 +1,80 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file reverseIndex.h
+/// \brief Reverse index from the MC particles to the tracks of a data frame
+///
+/// The tracks are sorted by the index of their MC particle with a counting sort: the tracks per particle are counted,
+/// the counts are summed into the offsets of the particles and the tracks are placed at the offsets of their
+/// particles. The tracks of particle i are then indices[offsets[i]] to indices[offsets[i + 1] - 1], in increasing
+/// track index, built in one pass over the labels whatever the number of particles and tracks.
+
+#ifndef PWGMM_CORE_REVERSEINDEX_H_
+#define PWGMM_CORE_REVERSEINDEX_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace o2::analysis::mm
+{
+
+class ReverseIndex
+{
+ public:
+  /// Builds the index of nParticles particles from a labelled track table, with the row numbers of the tracks in
+  /// the table. The tracks without a label or with a label outside of the particles are skipped
+  template <typename T>
+  void build(int nParticles, T const& tracks)
+  {
+    mOffsets.assign(nParticles + 1, 0);
+    mLabels.clear();
+    mLabels.reserve(tracks.size());
+    for (auto const& track : tracks) {
+      const int label = track.mcParticleId();
+      mLabels.push_back(label);
+      if (label >= 0 && label < nParticles) {
+        mOffsets[label + 1]++;
+      }
+    }
+    for (int i = 0; i < nParticles; i++) {
+      mOffsets[i + 1] += mOffsets[i];
+    }
+    mIndices.resize(mOffsets[nParticles]);
+    mNext.assign(mOffsets.begin(), mOffsets.end() - 1);
+    for (std::size_t trackId = 0; trackId < mLabels.size(); trackId++) {
+      const int label = mLabels[trackId];
+      if (label >= 0 && label < nParticles) {
+        mIndices[mNext[label]++] = trackId;
+      }
+    }
+  }
+
+  int nParticles() const { return static_cast<int>(mOffsets.size()) - 1; }
+
+  /// Number of tracks of particle i
+  int count(int i) const { return mOffsets[i + 1] - mOffsets[i]; }
+
+  int const* begin(int i) const { return mIndices.data() + mOffsets[i]; }
+  int const* end(int i) const { return mIndices.data() + mOffsets[i + 1]; }
+
+  std::vector<int> const& offsets() const { return mOffsets; }
+  std::vector<int> const& indices() const { return mIndices; }
+
+ private:
+  std::vector<int> mOffsets; ///< offsets of the tracks of the particles in mIndices, nParticles + 1
+  std::vector<int> mIndices; ///< track indices sorted by particle
+  std::vector<int> mLabels;  ///< particle index of each track
+  std::vector<int> mNext;    ///< next free slot of each particle while filling
+};
+
+} // namespace o2::analysis::mm
+
+#endif // PWGMM_CORE_REVERSEINDEX_H_
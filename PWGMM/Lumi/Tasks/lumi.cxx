@@ -15,6 +15,7 @@
 // o2-analysis-trackselection -b --isRun3 0 | o2-analysis-mm-lumi -b
 // --configuration json://./config.json
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <iostream>
@@ -25,6 +26,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/TrackSelectionTables.h"
 
+#include "CommonConstants/LHCConstants.h"
 #include "CommonUtils/NameConf.h"
 
 #include "Framework/ASoAHelpers.h"
@@ -64,6 +66,18 @@ DECLARE_SOA_COLUMN(VertexXY, vertexXY, double);
 
 DECLARE_SOA_COLUMN(VertexChi2, vertexChi2, double);
 DECLARE_SOA_COLUMN(NContrib, nContrib, int);
+
+DECLARE_SOA_COLUMN(BcId, bcId, int16_t);
+DECLARE_SOA_COLUMN(NVertices, nVertices, int);
+DECLARE_SOA_COLUMN(MeanX, meanX, float);
+DECLARE_SOA_COLUMN(MeanY, meanY, float);
+DECLARE_SOA_COLUMN(MeanZ, meanZ, float);
+DECLARE_SOA_COLUMN(CovXX, covXX, float);
+DECLARE_SOA_COLUMN(CovYY, covYY, float);
+DECLARE_SOA_COLUMN(CovZZ, covZZ, float);
+DECLARE_SOA_COLUMN(CovXY, covXY, float);
+DECLARE_SOA_COLUMN(CovXZ, covXZ, float);
+DECLARE_SOA_COLUMN(CovYZ, covYZ, float);
 } // namespace full
 DECLARE_SOA_TABLE(EventInfo, "AOD", "EventInfo", full::TimeStamp, full::VertexX,
                   full::VertexY, full::VertexZ,
@@ -71,13 +85,48 @@ DECLARE_SOA_TABLE(EventInfo, "AOD", "EventInfo", full::TimeStamp, full::VertexX,
                   full::VertexXX, full::VertexYY, full::VertexXY,
 
                   full::VertexChi2, full::NContrib);
+
+// moments of the refitted vertices per bunch crossing id and dataframe,
+// the covariances are normalised to the number of vertices so that rows
+// of the same bunch crossing id can be merged
+DECLARE_SOA_TABLE(LuminousRegion, "AOD", "LUMIREGION", full::TimeStamp, full::BcId,
+                  full::NVertices, full::MeanX, full::MeanY, full::MeanZ,
+                  full::CovXX, full::CovYY, full::CovZZ,
+                  full::CovXY, full::CovXZ, full::CovYZ);
 } // namespace o2::aod
 
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 
+// running means and covariances of vertex positions, updated one vertex at a time (Welford)
+struct VertexMoments {
+  int n = 0;
+  std::array<double, 3> mean = {0., 0., 0.};
+  // sums of products of the deviations from the mean, xx, yy, zz, xy, xz, yz
+  std::array<double, 6> m2 = {0., 0., 0., 0., 0., 0.};
+
+  void add(double x, double y, double z)
+  {
+    n++;
+    std::array<double, 3> d0 = {x - mean[0], y - mean[1], z - mean[2]};
+    for (int i = 0; i < 3; i++) {
+      mean[i] += d0[i] / n;
+    }
+    std::array<double, 3> d1 = {x - mean[0], y - mean[1], z - mean[2]};
+    m2[0] += d0[0] * d1[0];
+    m2[1] += d0[1] * d1[1];
+    m2[2] += d0[2] * d1[2];
+    m2[3] += d0[0] * d1[1];
+    m2[4] += d0[0] * d1[2];
+    m2[5] += d0[1] * d1[2];
+  }
+
+  double cov(int i) const { return n > 0 ? m2[i] / n : 0.; }
+};
+
 struct lumiTask {
   Produces<o2::aod::EventInfo> rowEventInfo;
+  Produces<o2::aod::LuminousRegion> rowLuminousRegion;
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   const char* ccdbpath_grp = "GLO/GRP/GRP";
   const char* ccdburl = "http://alice-ccdb.cern.ch";
@@ -89,6 +138,10 @@ struct lumiTask {
                                 "Maximum number of contributors"};
   Configurable<int> nContribMin{"nContribMin", 10,
                                 "Minimum number of contributors"};
+  Configurable<float> minPtContrib{"minPtContrib", 0.8,
+                                   "Minimum pT of the tracks used in the vertex refit"};
+  Configurable<int> minITSNClsContrib{"minITSNClsContrib", 5,
+                                      "Minimum number of ITS clusters of the tracks used in the vertex refit"};
 
   HistogramRegistry histos{
     "histos",
@@ -125,130 +178,144 @@ struct lumiTask {
     }};
   bool doPVrefit = true;
 
+  o2::vertexing::PVertexer vertexer;
+
+  // luminous region moments per bunch crossing id of the current dataframe
+  std::array<VertexMoments, o2::constants::lhc::LHCMaxBunches> bcMoments;
+  std::vector<int> filledBcIds;
+
   void init(InitContext&)
   {
     ccdb->setURL(ccdburl);
     ccdb->setCaching(true);
     ccdb->setLocalObjectValidityChecking();
     mRunNumber = 0;
+    o2::conf::ConfigurableParam::updateFromString(
+      "pvertexer.useMeanVertexConstraint=false"); // we want to refit w/o
+                                                  // MeanVertex constraint
   }
 
-  void process(aod::Collision const& collision, aod::BCsWithTimestamps const&,
+  void process(aod::Collisions const& collisions, aod::BCsWithTimestamps const&,
                o2::soa::Join<o2::aod::Tracks, o2::aod::TrackSelection,
                              o2::aod::TracksCov, o2::aod::TracksExtra,
                              o2::aod::TracksDCA> const& tracks,
                o2::soa::Join<o2::aod::Tracks, o2::aod::TracksCov,
                              o2::aod::TracksExtra> const& unfiltered_tracks)
   {
-
-    auto bc = collision.bc_as<aod::BCsWithTimestamps>();
-    uint64_t relTS = bc.timestamp() - ftts;
-
-    std::vector<int64_t> vec_globID_contr = {};
-    std::vector<o2::track::TrackParCov> vec_TrkContributos = {};
-
-    int nContrib = 0;
-    int nNonContrib = 0;
+    // the refit contributors are the same for all collisions of the
+    // dataframe, select them once
+    std::vector<o2::track::TrackParCov> vec_TrkContributos;
+    vec_TrkContributos.reserve(unfiltered_tracks.size());
     for (const auto& unfiltered_track : unfiltered_tracks) {
-      if (!unfiltered_track.hasITS()) {
-        nNonContrib++;
-        continue;
+      if (unfiltered_track.hasITS() && unfiltered_track.pt() >= minPtContrib &&
+          unfiltered_track.itsNCls() >= minITSNClsContrib) {
+        vec_TrkContributos.push_back(getTrackParCov(unfiltered_track));
       }
-      if (unfiltered_track.pt() < 0.8 || unfiltered_track.itsNCls() < 5) {
-        nNonContrib++;
-        continue;
-      }
-      vec_globID_contr.push_back(unfiltered_track.globalIndex());
-      vec_TrkContributos.push_back(getTrackParCov(unfiltered_track));
-      nContrib++;
     }
+    int nContrib = vec_TrkContributos.size();
+    std::vector<bool> vec_useTrk_PVrefit(nContrib, true);
+
+    uint64_t dfTS = 0;
+    for (const auto& collision : collisions) {
+      auto bc = collision.bc_as<aod::BCsWithTimestamps>();
+      uint64_t relTS = bc.timestamp() - ftts;
+      if (dfTS == 0) {
+        dfTS = relTS;
+      }
 
-    std::vector<bool> vec_useTrk_PVrefit(vec_globID_contr.size(), true);
-
-    if (mRunNumber != bc.runNumber()) {
-      auto grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(
-        ccdbpath_grp, bc.timestamp());
-      if (grpo != nullptr) {
-        o2::base::Propagator::initFieldFromGRP(grpo);
-      } else {
-        LOGF(fatal,
-             "GRP object is not available in CCDB for run=%d at timestamp=%llu",
-             bc.runNumber(), bc.timestamp());
+      if (mRunNumber != bc.runNumber()) {
+        auto grpo = ccdb->getForTimeStamp<o2::parameters::GRPObject>(
+          ccdbpath_grp, bc.timestamp());
+        if (grpo != nullptr) {
+          o2::base::Propagator::initFieldFromGRP(grpo);
+        } else {
+          LOGF(fatal,
+               "GRP object is not available in CCDB for run=%d at timestamp=%llu",
+               bc.runNumber(), bc.timestamp());
+        }
+        // configure PVertexer
+        vertexer.init();
+        mRunNumber = bc.runNumber();
       }
-      mRunNumber = bc.runNumber();
-    }
 
-    o2::dataformats::VertexBase Pvtx;
-    Pvtx.setX(collision.posX());
-    Pvtx.setY(collision.posY());
-    Pvtx.setZ(collision.posZ());
-    Pvtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(),
-                collision.covXZ(), collision.covYZ(), collision.covZZ());
-    // configure PVertexer
+      o2::dataformats::VertexBase Pvtx;
+      Pvtx.setX(collision.posX());
+      Pvtx.setY(collision.posY());
+      Pvtx.setZ(collision.posZ());
+      Pvtx.setCov(collision.covXX(), collision.covXY(), collision.covYY(),
+                  collision.covXZ(), collision.covYZ(), collision.covZZ());
+
+      bool PVrefit_doable = vertexer.prepareVertexRefit(vec_TrkContributos, Pvtx);
+      double chi2 = -1.;
+      double refitX = -9999.;
+      double refitY = -9999.;
+      double refitZ = -9999.;
+      double refitXX = -9999.;
+      double refitYY = -9999.;
+      double refitXY = -9999.;
+
+      if (doPVrefit && PVrefit_doable) {
+        auto Pvtx_refitted = vertexer.refitVertex(vec_useTrk_PVrefit, Pvtx);
+        chi2 = Pvtx_refitted.getChi2();
+        refitX = Pvtx_refitted.getX();
+        refitY = Pvtx_refitted.getY();
+        refitZ = Pvtx_refitted.getZ();
+        refitXX = Pvtx_refitted.getSigmaX2();
+        refitYY = Pvtx_refitted.getSigmaY2();
+        refitXY = Pvtx_refitted.getSigmaXY();
+      }
 
-    o2::dataformats::VertexBase PVbase_recalculated;
+      rowEventInfo(relTS, refitX, refitY, refitZ, refitXX, refitYY, refitXY, chi2,
+                   nContrib);
 
-    o2::vertexing::PVertexer vertexer;
-    o2::conf::ConfigurableParam::updateFromString(
-      "pvertexer.useMeanVertexConstraint=false"); // we want to refit w/o
-                                                  // MeanVertex constraint
-    vertexer.init();
-    bool PVrefit_doable = vertexer.prepareVertexRefit(vec_TrkContributos, Pvtx);
-    double chi2 = -1.;
-    double refitX = -9999.;
-    double refitY = -9999.;
-    double refitZ = -9999.;
-    double refitXX = -9999.;
-    double refitYY = -9999.;
-    double refitXY = -9999.;
-
-    if (doPVrefit && PVrefit_doable) {
-      auto Pvtx_refitted = vertexer.refitVertex(vec_useTrk_PVrefit, Pvtx);
-      chi2 = Pvtx_refitted.getChi2();
-      refitX = Pvtx_refitted.getX();
-      refitY = Pvtx_refitted.getY();
-      refitZ = Pvtx_refitted.getZ();
-      refitXX = Pvtx_refitted.getSigmaX2();
-      refitYY = Pvtx_refitted.getSigmaY2();
-      refitXY = Pvtx_refitted.getSigmaXY();
-    }
+      histos.fill(HIST("chisquare_Refitted"), chi2);
+      bool goodRefit = nContrib > nContribMin && nContrib < nContribMax &&
+                       (chi2 / nContrib) < 4.0 && chi2 > 0;
+      if (goodRefit) {
+        histos.fill(HIST("vertexx_Refitted"), refitX);
+        histos.fill(HIST("vertexy_Refitted"), refitY);
 
-    rowEventInfo(relTS, refitX, refitY, refitZ, refitXX, refitYY, refitXY, chi2,
-                 nContrib);
+        histos.fill(HIST("vertexx_Refitted_timestamp"), relTS, refitX);
+        histos.fill(HIST("vertexy_Refitted_timestamp"), relTS, refitY);
 
-    //    LOGP(info,"chi2: {}, Ncont: {}, nonctr:
-    //    {}",chi2,nContrib,nNonContrib);
+        int bcId = bc.globalBC() % o2::constants::lhc::LHCMaxBunches;
+        if (bcMoments[bcId].n == 0) {
+          filledBcIds.push_back(bcId);
+        }
+        bcMoments[bcId].add(refitX, refitY, refitZ);
+      }
+      histos.fill(HIST("chisquare"), collision.chi2());
+      if (collision.chi2() / collision.numContrib() > 4)
+        continue;
+      if (collision.numContrib() > nContribMax ||
+          collision.numContrib() < nContribMin)
+        continue;
 
-    histos.fill(HIST("chisquare_Refitted"), chi2);
-    if (nContrib > nContribMin && nContrib < nContribMax &&
-        (chi2 / nContrib) < 4.0 && chi2 > 0) {
-      histos.fill(HIST("vertexx_Refitted"), refitX);
-      histos.fill(HIST("vertexy_Refitted"), refitY);
+      histos.fill(HIST("vertexx"), collision.posX());
+      histos.fill(HIST("vertexy"), collision.posY());
+      histos.fill(HIST("timestamp"), relTS);
 
-      histos.fill(HIST("vertexx_Refitted_timestamp"), relTS, refitX);
-      histos.fill(HIST("vertexy_Refitted_timestamp"), relTS, refitY);
-    }
-    histos.fill(HIST("chisquare"), collision.chi2());
-    if (collision.chi2() / collision.numContrib() > 4)
-      return;
-    if (collision.numContrib() > nContribMax ||
-        collision.numContrib() < nContribMin)
-      return;
-
-    histos.fill(HIST("vertexx"), collision.posX());
-    histos.fill(HIST("vertexy"), collision.posY());
-    histos.fill(HIST("timestamp"), relTS);
-
-    histos.fill(HIST("vertexx_timestamp"), relTS, collision.posX());
-    histos.fill(HIST("vertexy_timestamp"), relTS, collision.posY());
-
-    if (nContrib > nContribMin && nContrib < nContribMax &&
-        (chi2 / nContrib) < 4.0 && chi2 > 0) {
-      histos.fill(HIST("vertexx_Refitted_vertexx"), collision.posX(), refitX);
-      histos.fill(HIST("vertexy_Refitted_vertexy"), collision.posY(), refitY);
-    }
+      histos.fill(HIST("vertexx_timestamp"), relTS, collision.posX());
+      histos.fill(HIST("vertexy_timestamp"), relTS, collision.posY());
 
-  } // need selections
+      if (goodRefit) {
+        histos.fill(HIST("vertexx_Refitted_vertexx"), collision.posX(), refitX);
+        histos.fill(HIST("vertexy_Refitted_vertexy"), collision.posY(), refitY);
+      }
+    } // need selections
+
+    // one row per bunch crossing id with refitted vertices
+    std::sort(filledBcIds.begin(), filledBcIds.end());
+    for (auto bcId : filledBcIds) {
+      auto& moments = bcMoments[bcId];
+      rowLuminousRegion(dfTS, bcId, moments.n,
+                        moments.mean[0], moments.mean[1], moments.mean[2],
+                        moments.cov(0), moments.cov(1), moments.cov(2),
+                        moments.cov(3), moments.cov(4), moments.cov(5));
+      moments = VertexMoments{};
+    }
+    filledBcIds.clear();
+  }
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
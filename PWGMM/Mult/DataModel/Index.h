@@ -19,8 +19,10 @@ namespace idx
 {
 DECLARE_SOA_ARRAY_INDEX_COLUMN(Track, tracks);
 DECLARE_SOA_ARRAY_INDEX_COLUMN(MFTTrack, mfttracks);
+DECLARE_SOA_ARRAY_INDEX_COLUMN(FwdTrack, fwdtracks);
 } // namespace idx
 DECLARE_SOA_TABLE(ParticlesToTracks, "AOD", "P2T", idx::TrackIds);
 DECLARE_SOA_TABLE(ParticlesToMftTracks, "AOD", "P2MFTT", idx::MFTTrackIds);
+DECLARE_SOA_TABLE(ParticlesToFwdTracks, "AOD", "P2FWDT", idx::FwdTrackIds);
 } // namespace o2::aod
 #endif // O2_ANALYSIS_INDEX_H_
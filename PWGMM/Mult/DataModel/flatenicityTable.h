@@ -0,0 +1,52 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef PWGMM_MULT_DATAMODEL_FLATENICITYTABLE_H_
+#define PWGMM_MULT_DATAMODEL_FLATENICITYTABLE_H_
+
+#include "Framework/AnalysisDataModel.h"
+
+namespace o2::aod
+{
+namespace flatenicity
+{
+DECLARE_SOA_INDEX_COLUMN(Collision, collision);
+DECLARE_SOA_COLUMN(FlatFV0, flatFV0, float);                 //! flatenicity of the FV0 cells
+DECLARE_SOA_COLUMN(FlatMFT, flatMFT, float);                 //! flatenicity of the MFT tracks
+DECLARE_SOA_COLUMN(FlatGlobal, flatGlobal, float);           //! flatenicity of the global tracks
+DECLARE_SOA_COLUMN(FlatFT0A, flatFT0A, float);               //! flatenicity of the FT0A sectors
+DECLARE_SOA_COLUMN(FlatFT0C, flatFT0C, float);               //! flatenicity of the FT0C sectors
+DECLARE_SOA_COLUMN(AmpFV0, ampFV0, float);                   //! calibrated FV0 amplitude
+DECLARE_SOA_COLUMN(AmpFV0Rings1to4, ampFV0Rings1to4, float); //! calibrated FV0 amplitude without the inner ring
+DECLARE_SOA_COLUMN(AmpFT0A, ampFT0A, float);                 //! FT0A amplitude
+DECLARE_SOA_COLUMN(AmpFT0C, ampFT0C, float);                 //! FT0C amplitude
+DECLARE_SOA_COLUMN(AmpFDDA, ampFDDA, float);                 //! FDDA amplitude
+DECLARE_SOA_COLUMN(AmpFDDC, ampFDDC, float);                 //! FDDC amplitude
+DECLARE_SOA_COLUMN(MultMFT, multMFT, float);                 //! MFT tracks in -3.6 < eta < -2.5
+DECLARE_SOA_COLUMN(MultMFTPartial, multMFTPartial, float);   //! MFT tracks in -3.6 < eta < -3.4
+DECLARE_SOA_COLUMN(MultGlobal, multGlobal, int);             //! global tracks
+DECLARE_SOA_COLUMN(PtTrigger, ptTrigger, float);             //! highest pT of the global tracks
+} // namespace flatenicity
+
+/// Per-detector flatenicity and multiplicity of the collisions within the vertex cut of the flatenicity task,
+/// with the channel and vertex calibrations applied as configured, from which the combined estimators are built
+DECLARE_SOA_TABLE(Flatenicities, "AOD", "FLATENICITY",
+                  flatenicity::CollisionId,
+                  flatenicity::FlatFV0, flatenicity::FlatMFT, flatenicity::FlatGlobal,
+                  flatenicity::FlatFT0A, flatenicity::FlatFT0C,
+                  flatenicity::AmpFV0, flatenicity::AmpFV0Rings1to4,
+                  flatenicity::AmpFT0A, flatenicity::AmpFT0C,
+                  flatenicity::AmpFDDA, flatenicity::AmpFDDC,
+                  flatenicity::MultMFT, flatenicity::MultMFTPartial,
+                  flatenicity::MultGlobal, flatenicity::PtTrigger);
+
+} // namespace o2::aod
+
+#endif // PWGMM_MULT_DATAMODEL_FLATENICITYTABLE_H_
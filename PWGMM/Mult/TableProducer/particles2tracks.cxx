@@ -21,6 +21,7 @@
 #include "Framework/AnalysisTask.h"
 
 #include "Index.h"
+#include "PWGMM/Core/reverseIndex.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -32,33 +33,48 @@ struct ParticlesToTracks {
   using LabeledMFTTracks = soa::Join<o2::aod::MFTTracks, aod::McMFTTrackLabels>;
   Produces<aod::ParticlesToMftTracks> p2tmft;
 
+  using LabeledFwdTracks = soa::Join<o2::aod::FwdTracks, aod::McFwdTrackLabels>;
+  Produces<aod::ParticlesToFwdTracks> p2tfwd;
+
+  o2::analysis::mm::ReverseIndex reverseIndex;
   std::vector<int> trackIds;
 
   void init(InitContext&)
   {
   }
 
-  void processIndexingCentral(aod::McParticle const&, soa::SmallGroups<LabeledTracks> const& tracks)
+  /// Fills one row per particle with its tracks, the tracks are sorted by particle once per data frame
+  template <typename P, typename T>
+  void fillIndex(P& table, aod::McParticles const& particles, T const& tracks)
   {
-    trackIds.clear();
-    for (auto& track : tracks) {
-      trackIds.push_back(track.globalIndex());
+    reverseIndex.build(particles.size(), tracks);
+    table.reserve(particles.size());
+    for (int i = 0; i < reverseIndex.nParticles(); i++) {
+      trackIds.assign(reverseIndex.begin(i), reverseIndex.end(i));
+      table(trackIds);
     }
-    p2t(trackIds);
+  }
+
+  void processIndexingCentral(aod::McParticles const& particles, LabeledTracks const& tracks)
+  {
+    fillIndex(p2t, particles, tracks);
   }
 
   PROCESS_SWITCH(ParticlesToTracks, processIndexingCentral, "Create reverse index from particles to tracks", false);
 
-  void processIndexingFwd(aod::McParticle const&, soa::SmallGroups<LabeledMFTTracks> const& tracks)
+  void processIndexingFwd(aod::McParticles const& particles, LabeledMFTTracks const& tracks)
   {
-    trackIds.clear();
-    for (auto& track : tracks) {
-      trackIds.push_back(track.globalIndex());
-    }
-    p2tmft(trackIds);
+    fillIndex(p2tmft, particles, tracks);
+  }
+
+  PROCESS_SWITCH(ParticlesToTracks, processIndexingFwd, "Create reverse index from particles to MFT tracks", false);
+
+  void processIndexingFwdTracks(aod::McParticles const& particles, LabeledFwdTracks const& tracks)
+  {
+    fillIndex(p2tfwd, particles, tracks);
   }
 
-  PROCESS_SWITCH(ParticlesToTracks, processIndexingFwd, "Create reverse index from particles to tracks", false);
+  PROCESS_SWITCH(ParticlesToTracks, processIndexingFwdTracks, "Create reverse index from particles to forward tracks", false);
 };
 
 WorkflowSpec defineDataProcessing(ConfigContext const& cfgc)
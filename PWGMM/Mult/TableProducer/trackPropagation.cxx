@@ -38,7 +38,6 @@
 
 #include "bestCollisionTable.h"
 
-using SMatrix55 = ROOT::Math::SMatrix<double, 5, 5, ROOT::Math::MatRepSym<double, 5>>;
 using SMatrix5 = ROOT::Math::SVector<Double_t, 5>;
 
 // The Run 3 AO2D stores the tracks at the point of innermost update. For a
@@ -98,11 +97,10 @@ struct AmbiguousTrackPropagation {
 
   void initCCDB(ExtBCs::iterator const& bc)
   {
-    LOG(info) << "INITIALIZING CCDB";
-
     if (runNumber == bc.runNumber()) {
       return;
     }
+    LOG(info) << "INITIALIZING CCDB";
     grpmag = ccdb->getForTimeStamp<o2::parameters::GRPMagField>(grpmagPath, bc.timestamp());
     LOG(info) << "Setting magnetic field to current " << grpmag->getL3Current()
               << " A for run " << bc.runNumber()
@@ -204,7 +202,10 @@ struct AmbiguousTrackPropagation {
     // Only on DCAxy
     float dcaInfo;
     float bestDCA;
-    o2::track::TrackParCovFwd bestTrackPar;
+    // Only the track parameters are propagated, the covariance matrix is not stored in BestCollisionsFwd
+    o2::track::TrackParFwd trackPar;
+    o2::track::TrackParFwd bestTrackPar;
+    fwdtracksBestCollisions.reserve(atracks.size());
 
     for (auto& atrack : atracks) {
       dcaInfo = 999; // DCAxy
@@ -213,10 +214,7 @@ struct AmbiguousTrackPropagation {
       auto track = atrack.mfttrack();
       auto bestCol = track.has_collision() ? track.collisionId() : -1;
 
-      std::vector<double> v1; // Temporary null vector for the computation of the covariance matrix
-      SMatrix55 tcovs(v1.begin(), v1.end());
-      SMatrix5 tpars(track.x(), track.y(), track.phi(), track.tgl(), track.signed1Pt());
-      o2::track::TrackParCovFwd trackPar{track.z(), tpars, tcovs, track.chi2()};
+      const SMatrix5 tpars(track.x(), track.y(), track.phi(), track.tgl(), track.signed1Pt());
 
       auto compatibleBCs = atrack.bc_as<ExtBCs>();
       for (auto& bc : compatibleBCs) {
@@ -225,8 +223,10 @@ struct AmbiguousTrackPropagation {
         }
         auto collisions = bc.collisions();
         for (auto const& collision : collisions) {
-
-          trackPar.propagateToZhelix(collision.posZ(), Bz); // track parameters propagation to the position of the z vertex
+          // each collision is reached from the stored track parameters with the helix in the field at the MFT center
+          trackPar.setZ(track.z());
+          trackPar.setParameters(tpars);
+          trackPar.propagateParamToZhelix(collision.posZ(), Bz); // track parameters propagation to the position of the z vertex
 
           const auto dcaX(trackPar.getX() - collision.posX());
           const auto dcaY(trackPar.getY() - collision.posY());
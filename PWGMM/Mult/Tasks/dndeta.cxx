@@ -9,6 +9,7 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#include <algorithm>
 #include <cmath>
 
 #include "Common/CCDB/EventSelectionParams.h"
@@ -21,12 +22,14 @@
 #include "Index.h"
 #include "TDatabasePDG.h"
 
+#include "PWGMM/Core/histogramBuffers.h"
 #include "bestCollisionTable.h"
 
 using namespace o2;
 using namespace o2::framework;
 using namespace o2::framework::expressions;
 using namespace o2::aod::track;
+using namespace o2::analysis::mm;
 
 AxisSpec ZAxis = {301, -30.1, 30.1};
 AxisSpec DeltaZAxis = {61, -6.1, 6.1};
@@ -85,6 +88,23 @@ struct MultiplicityCounter {
 
   std::vector<int> usedTracksIds;
 
+  // per-collision buffers of the track histograms
+  HistogramBuffer2D bufEtaZvtx;
+  HistogramBuffer2D bufPhiEta;
+  HistogramBuffer2D bufPtEta;
+  HistogramBuffer2D bufDCAXYPt;
+  HistogramBuffer2D bufDCAZPt;
+  HistogramBuffer1D bufPtEfficiency;
+  HistogramBuffer1D bufPtEfficiencySecondaries;
+  BinCounter<9> cntITSClusters; // bins of Tracks/Control/ITSClusters
+  BinCounter<18> cntMask;       // bins of Tracks/Control/Mask
+
+  // usedTracksIds is sorted before the lookups
+  bool isUsed(int64_t trackId) const
+  {
+    return std::binary_search(usedTracksIds.begin(), usedTracksIds.end(), trackId);
+  }
+
   void init(InitContext&)
   {
     AxisSpec MultAxis = {multBinning, "N_{trk}"};
@@ -206,57 +226,66 @@ struct MultiplicityCounter {
       registry.fill(HIST("Events/Selection"), 2.);
       auto z = collision.posZ();
       usedTracksIds.clear();
+      bufEtaZvtx.clear();
+      bufPhiEta.clear();
+      bufPtEta.clear();
+      bufDCAXYPt.clear();
+      bufDCAZPt.clear();
 
       auto Ntrks = 0;
       for (auto& track : atracks) {
         auto otrack = track.track_as<FiTracks>();
         usedTracksIds.emplace_back(track.trackId());
-        if (std::abs(otrack.eta()) < estimatorEta) {
+        const float eta = otrack.eta();
+        const float phi = otrack.phi();
+        const float pt = otrack.pt();
+        if (std::abs(eta) < estimatorEta) {
           ++Ntrks;
         }
-        registry.fill(HIST("Tracks/EtaZvtx"), otrack.eta(), z);
-        registry.fill(HIST("Tracks/PhiEta"), otrack.phi(), otrack.eta());
+        bufEtaZvtx.push(eta, z);
+        bufPhiEta.push(phi, eta);
         if (!otrack.has_collision()) {
-          registry.fill(HIST("Tracks/Control/ExtraTracksEtaZvtx"), otrack.eta(), z);
-          registry.fill(HIST("Tracks/Control/ExtraTracksPhiEta"), otrack.phi(), otrack.eta());
-          registry.fill(HIST("Tracks/Control/ExtraDCAXYPt"), otrack.pt(), track.bestDCAXY());
-          registry.fill(HIST("Tracks/Control/ExtraDCAZPt"), otrack.pt(), track.bestDCAZ());
+          registry.fill(HIST("Tracks/Control/ExtraTracksEtaZvtx"), eta, z);
+          registry.fill(HIST("Tracks/Control/ExtraTracksPhiEta"), phi, eta);
+          registry.fill(HIST("Tracks/Control/ExtraDCAXYPt"), pt, track.bestDCAXY());
+          registry.fill(HIST("Tracks/Control/ExtraDCAZPt"), pt, track.bestDCAZ());
         } else if (otrack.collisionId() != track.bestCollisionId()) {
-          registry.fill(HIST("Tracks/Control/ReassignedTracksEtaZvtx"), otrack.eta(), z);
-          registry.fill(HIST("Tracks/Control/ReassignedTracksPhiEta"), otrack.phi(), otrack.eta());
+          registry.fill(HIST("Tracks/Control/ReassignedTracksEtaZvtx"), eta, z);
+          registry.fill(HIST("Tracks/Control/ReassignedTracksPhiEta"), phi, eta);
           registry.fill(HIST("Tracks/Control/ReassignedVertexCorr"), otrack.collision_as<ExCols>().posZ(), z);
-          registry.fill(HIST("Tracks/Control/ReassignedDCAXYPt"), otrack.pt(), track.bestDCAXY());
-          registry.fill(HIST("Tracks/Control/ReassignedDCAZPt"), otrack.pt(), track.bestDCAZ());
+          registry.fill(HIST("Tracks/Control/ReassignedDCAXYPt"), pt, track.bestDCAXY());
+          registry.fill(HIST("Tracks/Control/ReassignedDCAZPt"), pt, track.bestDCAZ());
         }
-        registry.fill(HIST("Tracks/Control/PtEta"), otrack.pt(), otrack.eta());
-        registry.fill(HIST("Tracks/Control/DCAXYPt"), otrack.pt(), track.bestDCAXY());
-        registry.fill(HIST("Tracks/Control/DCAZPt"), otrack.pt(), track.bestDCAZ());
+        bufPtEta.push(pt, eta);
+        bufDCAXYPt.push(pt, track.bestDCAXY());
+        bufDCAZPt.push(pt, track.bestDCAZ());
       }
+      std::sort(usedTracksIds.begin(), usedTracksIds.end());
       for (auto& track : tracks) {
-        if (std::find(usedTracksIds.begin(), usedTracksIds.end(), track.globalIndex()) != usedTracksIds.end()) {
+        if (isUsed(track.globalIndex())) {
           continue;
         }
-        if (std::abs(track.eta()) < estimatorEta) {
+        const float eta = track.eta();
+        const float pt = track.pt();
+        if (std::abs(eta) < estimatorEta) {
           ++Ntrks;
         }
-        registry.fill(HIST("Tracks/EtaZvtx"), track.eta(), z);
-        registry.fill(HIST("Tracks/PhiEta"), track.phi(), track.eta());
-        registry.fill(HIST("Tracks/Control/PtEta"), track.pt(), track.eta());
-        registry.fill(HIST("Tracks/Control/DCAXYPt"), track.pt(), track.dcaXY());
-        registry.fill(HIST("Tracks/Control/DCAZPt"), track.pt(), track.dcaZ());
+        bufEtaZvtx.push(eta, z);
+        bufPhiEta.push(track.phi(), eta);
+        bufPtEta.push(pt, eta);
+        bufDCAXYPt.push(pt, track.dcaXY());
+        bufDCAZPt.push(pt, track.dcaZ());
       }
+      bufEtaZvtx.fill(registry.get<TH2>(HIST("Tracks/EtaZvtx")).get());
+      bufPhiEta.fill(registry.get<TH2>(HIST("Tracks/PhiEta")).get());
+      bufPtEta.fill(registry.get<TH2>(HIST("Tracks/Control/PtEta")).get());
+      bufDCAXYPt.fill(registry.get<TH2>(HIST("Tracks/Control/DCAXYPt")).get());
+      bufDCAZPt.fill(registry.get<TH2>(HIST("Tracks/Control/DCAZPt")).get());
 
       if (Ntrks > 0) {
         registry.fill(HIST("Events/Selection"), 3.);
-        for (auto& track : atracks) {
-          registry.fill(HIST("Tracks/EtaZvtx_gt0"), track.track_as<FiTracks>().eta(), z);
-        }
-        for (auto& track : tracks) {
-          if (std::find(usedTracksIds.begin(), usedTracksIds.end(), track.globalIndex()) != usedTracksIds.end()) {
-            continue;
-          }
-          registry.fill(HIST("Tracks/EtaZvtx_gt0"), track.eta(), z);
-        }
+        // same tracks as Tracks/EtaZvtx
+        bufEtaZvtx.fill(registry.get<TH2>(HIST("Tracks/EtaZvtx_gt0")).get());
       }
       registry.fill(HIST("Events/NtrkZvtx"), Ntrks, z);
     } else {
@@ -330,20 +359,13 @@ struct MultiplicityCounter {
               if ((track.trackCutFlag() & TrackSelectionFlags::kDCAz) != TrackSelectionFlags::kDCAz) {
                 continue;
               }
-              for (auto layer = 0; layer < 7; ++layer) {
-                if (track.itsClusterMap() & (uint8_t(1) << layer)) {
-                  registry.fill(HIST("Tracks/Control/ITSClusters"), layer + 1);
-                }
-              }
-              auto hasbit = false;
-              for (auto bit = 0; bit < 16; ++bit) {
-                if (track.mcMask() & (uint8_t(1) << bit)) {
-                  registry.fill(HIST("Tracks/Control/Mask"), bit);
-                  hasbit = true;
-                }
-              }
-              if (!hasbit) {
-                registry.fill(HIST("Tracks/Control/Mask"), 16);
+              // layer i is value i + 1, bin i + 1
+              cntITSClusters.addBits(track.itsClusterMap() & 0x7F);
+              // bit i is value i, bin i + 1, no bit is value 16
+              if (track.mcMask() != 0) {
+                cntMask.addBits(track.mcMask());
+              } else {
+                cntMask.add(17);
               }
             }
           }
@@ -359,6 +381,8 @@ struct MultiplicityCounter {
         }
       }
     }
+    cntITSClusters.flush(registry.get<TH1>(HIST("Tracks/Control/ITSClusters")).get());
+    cntMask.flush(registry.get<TH1>(HIST("Tracks/Control/Mask")).get());
   }
 
   PROCESS_SWITCH(MultiplicityCounter, processTrackEfficiencyIndexed, "Calculate tracking efficiency vs pt (indexed)", false);
@@ -383,25 +407,30 @@ struct MultiplicityCounter {
       tracks.bindExternalIndices(&mcParticles);
 
       usedTracksIds.clear();
+      bufPtEfficiency.clear();
+      bufPtEfficiencySecondaries.clear();
       for (auto& track : atracks) {
         auto ttrack = track.track_as<soa::Filtered<LabeledTracksEx>>();
         usedTracksIds.emplace_back(ttrack.globalIndex());
         if (ttrack.has_mcParticle()) {
-          registry.fill(HIST("Tracks/Control/PtEfficiency"), ttrack.mcParticle_as<Particles>().pt());
+          bufPtEfficiency.push(ttrack.mcParticle_as<Particles>().pt());
         } else {
-          registry.fill(HIST("Tracks/Control/PtEfficiencySecondaries"), ttrack.pt());
+          bufPtEfficiencySecondaries.push(ttrack.pt());
         }
       }
+      std::sort(usedTracksIds.begin(), usedTracksIds.end());
       for (auto& track : tracks) {
-        if (std::find(usedTracksIds.begin(), usedTracksIds.end(), track.globalIndex()) != usedTracksIds.end()) {
+        if (isUsed(track.globalIndex())) {
           continue;
         }
         if (track.has_mcParticle()) {
-          registry.fill(HIST("Tracks/Control/PtEfficiency"), track.mcParticle_as<Particles>().pt());
+          bufPtEfficiency.push(track.mcParticle_as<Particles>().pt());
         } else {
-          registry.fill(HIST("Tracks/Control/PtEfficiencySecondaries"), track.pt());
+          bufPtEfficiencySecondaries.push(track.pt());
         }
       }
+      bufPtEfficiency.fill(registry.get<TH1>(HIST("Tracks/Control/PtEfficiency")).get());
+      bufPtEfficiencySecondaries.fill(registry.get<TH1>(HIST("Tracks/Control/PtEfficiencySecondaries")).get());
 
       for (auto& particle : particles) {
         if (!particle.producedByGenerator()) {
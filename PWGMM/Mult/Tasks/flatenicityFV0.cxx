@@ -14,6 +14,7 @@
 #include "Common/DataModel/EventSelection.h"
 #include "Common/DataModel/Multiplicity.h"
 #include "Common/DataModel/TrackSelectionTables.h"
+#include "PWGMM/Mult/DataModel/flatenicityTable.h"
 #include "Framework/ASoAHelpers.h"
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/AnalysisTask.h"
@@ -24,8 +25,9 @@
 #include <TF1.h>
 #include <TH1F.h>
 #include <TH2F.h>
-#include <TGraph.h>
+#include <TProfile.h>
 #include <TRandom.h>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -58,6 +60,35 @@ struct flatenictyFV0 {
   static constexpr std::string_view nhPtEst[17] = {
     "ptVsGlobaltrack", "ptVsFDDAFDDCFT0CFV0MFT", "ptVsFDDAFDDCFV0MFT", "ptVsFV0MFT", "ptVsFV0", "ptVsMFTmult", "ptVs1flatencityFV0", "ptVs1flatencitytrkMFT", "ptVs1flatencitytrkMFTFV0", "ptVs1flatencityMFTFV0", "ptVsMFTmultFT0A", "ptVsFT0", "ptVs1flatencityFT0", "ptVs1flatencityMFTFT0A", "ptVsFV0FT0C", "ptVs1flatencityFV0FT0C", "pTVsPtTrig"};
 
+  Produces<aod::Flatenicities> flatenicities;
+
+  // channel calibrations
+  static constexpr float calibFV0[48] = {1.01697, 1.122, 1.03854, 1.108, 1.11634, 1.14971, 1.19321, 1.06866, 0.954675, 0.952695, 0.969853, 0.957557, 0.989784, 1.01549, 1.02182, 0.976005, 1.01865, 1.06871, 1.06264, 1.02969, 1.07378, 1.06622, 1.15057, 1.0433, 0.83654, 0.847178, 0.890027, 0.920814, 0.888271, 1.04662, 0.8869, 0.856348, 0.863181, 0.906312, 0.902166, 1.00122, 1.03303, 0.887866, 0.892437, 0.906278, 0.884976, 0.864251, 0.917221, 1.10618, 1.04028, 0.893184, 0.915734, 0.892676};
+  static constexpr float calibT0C[28] = {0.949829, 1.05408, 1.00681, 1.00724, 0.990663, 0.973571, 0.9855, 1.03726, 1.02526, 1.00467, 0.983008, 0.979349, 0.952352, 0.985775, 1.013, 1.01721, 0.993948, 0.996421, 0.971871, 1.02921, 0.989641, 1.01885, 1.01259, 0.929502, 1.03969, 1.02496, 1.01385, 1.01711};
+  static constexpr float calibT0A[24] = {0.86041, 1.10607, 1.17724, 0.756397, 1.14954, 1.0879, 0.829438, 1.09014, 1.16515, 0.730077, 1.06722, 0.906344, 0.824167, 1.14716, 1.20692, 0.755034, 1.11734, 1.00556, 0.790522, 1.09138, 1.16225, 0.692458, 1.12428, 1.01127};
+  static constexpr float calibFDA[8] = {0.933485, 1.00743, 0.768484, 0.837354, 1.26397, 1.2159, 0.876259, 1.00434};
+  static constexpr float calibFDC[8] = {0.772909, 1.95841, 0.966258, 0.913508, 0.96176, 0.650286, 0.619638, 0.694932};
+  // vertex calibrations, at the centres of the 1 cm bins from -15 to 15 cm
+  static constexpr int nBinsVtx = 30;
+  static constexpr float vtxFirstBinCentre = -14.5;
+  static constexpr float calibMFTvtx[nBinsVtx] = {1.27106, 1.239, 1.23555, 1.21115, 1.18538, 1.16585, 1.15052, 1.11002, 1.09909, 1.07341, 1.05511, 1.04538, 1.02291, 1.01254, 0.994646, 0.981465, 0.962609, 0.955254, 0.942117, 0.932826, 0.925284, 0.906386, 0.904621, 0.887349, 0.884237, 0.860509, 0.853699, 0.836858, 0.819485, 0.802514};
+  static constexpr float calibFV0vtx[nBinsVtx] = {0.907962, 0.934607, 0.938929, 0.950987, 0.950817, 0.966362, 0.968509, 0.972741, 0.982412, 0.984872, 0.994543, 0.996003, 0.99435, 1.00266, 0.998245, 1.00584, 1.01078, 1.01003, 1.00726, 1.00872, 1.01726, 1.02015, 1.0193, 1.01106, 1.02229, 1.02104, 1.03435, 1.00822, 1.01921, 1.01736};
+  static constexpr float calibFT0Avtx[nBinsVtx] = {0.924334, 0.950988, 0.959604, 0.965607, 0.970016, 0.979057, 0.978384, 0.982005, 0.992825, 0.990048, 0.998588, 0.997338, 1.00102, 1.00385, 0.99492, 1.01083, 1.00703, 1.00494, 1.00063, 1.0013, 1.00777, 1.01238, 1.01179, 1.00577, 1.01028, 1.017, 1.02975, 1.0085, 1.00856, 1.01662};
+  static constexpr float calibFT0Cvtx[nBinsVtx] = {1.02096, 1.01245, 1.02148, 1.03605, 1.03561, 1.03667, 1.04229, 1.0327, 1.03674, 1.02764, 1.01828, 1.02331, 1.01864, 1.015, 1.01197, 1.00615, 0.996845, 0.993051, 0.985635, 0.982883, 0.981914, 0.964635, 0.967812, 0.95475, 0.956687, 0.932816, 0.92773, 0.914892, 0.891724, 0.872382};
+  static constexpr float calibFDAvtx[nBinsVtx] = {1.05852, 1.07943, 1.03542, 1.02851, 1.00617, 1.01377, 0.997411, 1.00899, 0.98556, 0.994506, 0.999267, 0.997915, 0.993361, 0.988509, 0.993386, 0.992661, 0.997844, 1.00428, 0.991939, 0.995139, 0.999882, 1.00976, 1.01239, 0.989125, 1.01432, 1.00652, 1.02114, 1.00582, 0.996546, 1.05708};
+  static constexpr float calibFDCvtx[nBinsVtx] = {0.965937, 0.924875, 0.903078, 0.901217, 0.914662, 0.933606, 0.899319, 0.912335, 0.900467, 0.928819, 0.943352, 0.955755, 0.954358, 0.939799, 0.973757, 0.972073, 1.00221, 0.997195, 1.01809, 1.02407, 1.02722, 1.05898, 1.09503, 1.13893, 1.12981, 1.15516, 1.17394, 1.28468, 1.37351, 1.24345};
+
+  // FV0 geometry per channel: lattice cell, centre of the cell and weight of the channel in the cell
+  static constexpr int nCellsFV0 = 48;
+  int fv0Cell[nCellsFV0];
+  float fv0Eta[nCellsFV0];
+  float fv0Phi[nCellsFV0];
+  float fv0LatticeWeight[nCellsFV0];
+
+  // pT of the global tracks of the event and estimator values of the pT profiles
+  std::vector<double> ptGlobal;
+  std::vector<double> estimatorValues;
+
   void init(o2::framework::InitContext&)
   {
     int nBinsEst[17] = {100, 500, 500, 800, 5000, 500, 102, 102, 102, 102, 400, 400, 102, 102, 600, 102, 600};
@@ -199,6 +230,24 @@ struct flatenictyFV0 {
     flatenicity.add("hAmpFDCvsVtx", "", HistType::kTH2F,
                     {{30, -15.0, +15.0, "Vtx_z"},
                      {6000, -0.5, 7999.5, "Ampl. FDC"}});
+
+    const float maxEtaFV0 = 5.1;
+    const float minEtaFV0 = 2.2;
+    const float detaFV0 = (maxEtaFV0 - minEtaFV0) / 5.0;
+    const int innerFV0 = 32;
+    for (int channelv0 = 0; channelv0 < nCellsFV0; ++channelv0) {
+      int ringindex = getFV0Ring(channelv0);
+      int channelv0phi = getFV0IndexPhi(channelv0);
+      fv0Cell[channelv0] = channelv0phi;
+      fv0Eta[channelv0] = maxEtaFV0 - (detaFV0 / 2.0) * (2.0 * ringindex + 1);
+      if (channelv0 < innerFV0) {
+        fv0Phi[channelv0] = (2.0 * (channelv0phi - 8 * ringindex) + 1) * M_PI / (8.0);
+        fv0LatticeWeight[channelv0] = 1.0;
+      } else {
+        fv0Phi[channelv0] = ((2.0 * channelv0phi) + 1 - 64.0) * 2.0 * M_PI / (32.0);
+        fv0LatticeWeight[channelv0] = 0.5; // two channels per bin
+      }
+    }
   }
   int getT0ASector(int i_ch)
   {
@@ -356,6 +405,56 @@ struct flatenictyFV0 {
     return flat;
   }
 
+  /// Vertex calibration factor at vtxZ: linear interpolation between the bin centres, as TGraph::Eval
+  static float getVtxCalibration(const float (&factors)[nBinsVtx], float vtxZ)
+  {
+    int i = std::clamp(static_cast<int>(std::floor(vtxZ - vtxFirstBinCentre)), 0, nBinsVtx - 2);
+    return factors[i] + (vtxZ - (vtxFirstBinCentre + i)) * (factors[i + 1] - factors[i]);
+  }
+
+  static double getSectorEdge(int is, int nSectors) { return is * 2.0 * M_PI / (1.0 * nSectors); }
+
+  /// Cell of the eta-phi lattice with nRings rings and nSectors azimuthal sectors, -1 if outside
+  /// The sector is computed from phi and then checked against the same edges as a scan of all the cells
+  template <int nRings, int nSectors>
+  static int getLatticeCell(float eta, float phi, const float (&minEta)[nRings], const float (&maxEta)[nRings])
+  {
+    int ir = 0;
+    while (ir < nRings && !(eta >= minEta[ir] && eta < maxEta[ir])) {
+      ir++;
+    }
+    if (ir == nRings || phi < getSectorEdge(0, nSectors) || !(phi < getSectorEdge(nSectors, nSectors))) {
+      return -1;
+    }
+    int is = std::min(static_cast<int>(phi * nSectors / (2.0 * M_PI)), nSectors - 1);
+    if (phi < getSectorEdge(is, nSectors)) {
+      is--;
+    } else if (phi >= getSectorEdge(is + 1, nSectors)) {
+      is++;
+    }
+    return ir * nSectors + is;
+  }
+
+  /// Weighted sum of the amplitudes of a combined estimator, normalised to the eta coverage with applyNorm
+  template <int nEta>
+  float getCombinedEstimator(const float (&ampl)[nEta], const float (&weights)[nEta], const float (&deltaEta)[nEta])
+  {
+    float combined = 0;
+    if (applyNorm) {
+      float all_weights = 0;
+      for (int i_e = 0; i_e < nEta; ++i_e) {
+        combined += ampl[i_e] * weights[i_e] / deltaEta[i_e];
+        all_weights += weights[i_e];
+      }
+      combined /= all_weights;
+    } else {
+      for (int i_e = 0; i_e < nEta; ++i_e) {
+        combined += ampl[i_e] * weights[i_e];
+      }
+    }
+    return combined;
+  }
+
   Filter trackFilter = (nabs(aod::track::eta) < cfgTrkEtaCut) &&
                        (aod::track::pt > cfgTrkLowPtCut);
   using TrackCandidates =
@@ -418,69 +517,10 @@ struct flatenictyFV0 {
     float ampl6[nEta6] = {0, 0};
 
     // V0A signal and flatenicity calculation
-    float flatenicity_fv0;
-    float calib[48] = {1.01697, 1.122, 1.03854, 1.108, 1.11634, 1.14971, 1.19321, 1.06866, 0.954675, 0.952695, 0.969853, 0.957557, 0.989784, 1.01549, 1.02182, 0.976005, 1.01865, 1.06871, 1.06264, 1.02969, 1.07378, 1.06622, 1.15057, 1.0433, 0.83654, 0.847178, 0.890027, 0.920814, 0.888271, 1.04662, 0.8869, 0.856348, 0.863181, 0.906312, 0.902166, 1.00122, 1.03303, 0.887866, 0.892437, 0.906278, 0.884976, 0.864251, 0.917221, 1.10618, 1.04028, 0.893184, 0.915734, 0.892676};
-    // calibration T0C
-    float calibT0C[28] = {0.949829, 1.05408, 1.00681, 1.00724, 0.990663, 0.973571, 0.9855, 1.03726, 1.02526, 1.00467, 0.983008, 0.979349, 0.952352, 0.985775, 1.013, 1.01721, 0.993948, 0.996421, 0.971871, 1.02921, 0.989641, 1.01885, 1.01259, 0.929502, 1.03969, 1.02496, 1.01385, 1.01711};
-    // calibration T0A
-    float calibT0A[24] = {0.86041, 1.10607, 1.17724, 0.756397, 1.14954, 1.0879, 0.829438, 1.09014, 1.16515, 0.730077, 1.06722, 0.906344, 0.824167, 1.14716, 1.20692, 0.755034, 1.11734, 1.00556, 0.790522, 1.09138, 1.16225, 0.692458, 1.12428, 1.01127};
-    // calibration FDA
-    float calibFDA[8] = {0.933485, 1.00743, 0.768484, 0.837354, 1.26397, 1.2159, 0.876259, 1.00434};
-    // calibration FDC
-    float calibFDC[8] = {0.772909, 1.95841, 0.966258, 0.913508, 0.96176, 0.650286, 0.619638, 0.694932};
-    // calibration factor MFT vs vtx
-    float biningVtxt[30] = {-14.5, -13.5, -12.5, -11.5, -10.5, -9.5, -8.5, -7.5, -6.5, -5.5, -4.5, -3.5, -2.5, -1.5, -0.5, 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5, 10.5, 11.5, 12.5, 13.5, 14.5};
-    float calibMFTvtx[30] = {1.27106, 1.239, 1.23555, 1.21115, 1.18538, 1.16585, 1.15052, 1.11002, 1.09909, 1.07341, 1.05511, 1.04538, 1.02291, 1.01254, 0.994646, 0.981465, 0.962609, 0.955254, 0.942117, 0.932826, 0.925284, 0.906386, 0.904621, 0.887349, 0.884237, 0.860509, 0.853699, 0.836858, 0.819485, 0.802514};
-
-    // calibration factor FV0 vs vtx
-    float calibFV0vtx[30] = {0.907962, 0.934607, 0.938929, 0.950987, 0.950817, 0.966362, 0.968509, 0.972741, 0.982412, 0.984872, 0.994543, 0.996003, 0.99435, 1.00266, 0.998245, 1.00584, 1.01078, 1.01003, 1.00726, 1.00872, 1.01726, 1.02015, 1.0193, 1.01106, 1.02229, 1.02104, 1.03435, 1.00822, 1.01921, 1.01736};
-    // calibration FT0A vs vtx
-    float calibFT0Avtx[30] = {0.924334, 0.950988, 0.959604, 0.965607, 0.970016, 0.979057, 0.978384, 0.982005, 0.992825, 0.990048, 0.998588, 0.997338, 1.00102, 1.00385, 0.99492, 1.01083, 1.00703, 1.00494, 1.00063, 1.0013, 1.00777, 1.01238, 1.01179, 1.00577, 1.01028, 1.017, 1.02975, 1.0085, 1.00856, 1.01662};
-    // calibration FT0C vs vtx
-    float calibFT0Cvtx[30] = {1.02096, 1.01245, 1.02148, 1.03605, 1.03561, 1.03667, 1.04229, 1.0327, 1.03674, 1.02764, 1.01828, 1.02331, 1.01864, 1.015, 1.01197, 1.00615, 0.996845, 0.993051, 0.985635, 0.982883, 0.981914, 0.964635, 0.967812, 0.95475, 0.956687, 0.932816, 0.92773, 0.914892, 0.891724, 0.872382};
-    // calibration FDA vs vtx
-    float calibFDAvtx[30] = {1.05852, 1.07943, 1.03542, 1.02851, 1.00617, 1.01377, 0.997411, 1.00899, 0.98556, 0.994506, 0.999267, 0.997915, 0.993361, 0.988509, 0.993386, 0.992661, 0.997844, 1.00428, 0.991939, 0.995139, 0.999882, 1.00976, 1.01239, 0.989125, 1.01432, 1.00652, 1.02114, 1.00582, 0.996546, 1.05708};
-    // calibration FDC vs vtx
-    float calibFDCvtx[30] = {0.965937, 0.924875, 0.903078, 0.901217, 0.914662, 0.933606, 0.899319, 0.912335, 0.900467, 0.928819, 0.943352, 0.955755, 0.954358, 0.939799, 0.973757, 0.972073, 1.00221, 0.997195, 1.01809, 1.02407, 1.02722, 1.05898, 1.09503, 1.13893, 1.12981, 1.15516, 1.17394, 1.28468, 1.37351, 1.24345};
-
-    const int nDetVtx = 6;
-    TGraph* gVtx[nDetVtx];
-    const char* nameDet[nDetVtx] = {"AmpV0", "AmpT0A", "AmpT0C", "MFT", "AmpFDA", "AmpFDC"};
-    for (int i_d = 0; i_d < nDetVtx; ++i_d) {
-      gVtx[i_d] = 0;
-      gVtx[i_d] = new TGraph();
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[0]->SetPoint(i_v, biningVtxt[i_v], calibFV0vtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[1]->SetPoint(i_v, biningVtxt[i_v], calibFT0Avtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[2]->SetPoint(i_v, biningVtxt[i_v], calibFT0Cvtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[3]->SetPoint(i_v, biningVtxt[i_v], calibMFTvtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[4]->SetPoint(i_v, biningVtxt[i_v], calibFDAvtx[i_v]);
-    }
-    for (int i_v = 0; i_v < 30; ++i_v) {
-      gVtx[5]->SetPoint(i_v, biningVtxt[i_v], calibFDCvtx[i_v]);
-    }
-
-    for (int i_d = 0; i_d < nDetVtx; ++i_d) {
-      gVtx[i_d]->SetName(Form("g%s", nameDet[i_d]));
-    }
-
+    float flatenicity_fv0 = 9999;
     float sumAmpFV0 = 0;
     float sumAmpFV01to4Ch = 0;
-    int innerFV0 = 32;
-    float maxEtaFV0 = 5.1;
-    float minEtaFV0 = 2.2;
-    float detaFV0 = (maxEtaFV0 - minEtaFV0) / 5.0;
-
-    const int nCells = 48; // 48 sectors in FV0
+    const int nCells = nCellsFV0; // 48 sectors in FV0
     float amp_channel[nCells];
     for (int iCell = 0; iCell < nCells; ++iCell) {
       amp_channel[iCell] = 0.0;
@@ -497,41 +537,34 @@ struct flatenictyFV0 {
         RhoLattice[iCh] = 0;
       }
       auto fv0 = collision.foundFV0();
-      for (std::size_t ich = 0; ich < fv0.amplitude().size(); ich++) {
-        float phiv0 = -999.0;
-        float etav0 = -999.0;
-        int channelv0 = fv0.channel()[ich];
-        float ampl_ch = fv0.amplitude()[ich];
-        int ringindex = getFV0Ring(channelv0);
-        int channelv0phi = getFV0IndexPhi(channelv0);
-        etav0 = maxEtaFV0 - (detaFV0 / 2.0) * (2.0 * ringindex + 1);
-        if (channelv0 < innerFV0) {
-          phiv0 = (2.0 * (channelv0phi - 8 * ringindex) + 1) * M_PI / (8.0);
-        } else {
-          phiv0 = ((2.0 * channelv0phi) + 1 - 64.0) * 2.0 * M_PI / (32.0);
+      auto amplitudes = fv0.amplitude();
+      auto channels = fv0.channel();
+      for (std::size_t ich = 0; ich < amplitudes.size(); ich++) {
+        int channelv0 = channels[ich];
+        if (channelv0 >= nCells) {
+          continue;
         }
+        float ampl_ch = amplitudes[ich];
+        int channelv0phi = fv0Cell[channelv0];
         amp_channelBefore[channelv0phi] = ampl_ch;
         if (applyCalibCh) {
-          ampl_ch *= calib[channelv0phi];
+          ampl_ch *= calibFV0[channelv0phi];
         }
         sumAmpFV0 += ampl_ch;
 
         if (channelv0 >= 8) { // exclude the 1st ch, eta 2.2,4.52
           sumAmpFV01to4Ch += ampl_ch;
         }
-        flatenicity.fill(HIST("fEtaPhiFv0"), phiv0, etav0, ampl_ch);
+        flatenicity.fill(HIST("fEtaPhiFv0"), fv0Phi[channelv0], fv0Eta[channelv0], ampl_ch);
         amp_channel[channelv0phi] = ampl_ch;
-        if (channelv0 < innerFV0) {
-          RhoLattice[channelv0phi] = ampl_ch;
-        } else {
-          RhoLattice[channelv0phi] = ampl_ch / 2.0; // two channels per bin
-        }
+        RhoLattice[channelv0phi] = ampl_ch * fv0LatticeWeight[channelv0];
       }
       flatenicity_fv0 = GetFlatenicity(RhoLattice, nCells);
       flatenicity.fill(HIST("hAmpV0vsVtxBeforeCalibration"), vtxZ, sumAmpFV0);
       if (applyCalibVtx) {
-        sumAmpFV0 *= gVtx[0]->Eval(vtxZ);
-        sumAmpFV01to4Ch *= gVtx[0]->Eval(vtxZ);
+        float calibVtx = getVtxCalibration(calibFV0vtx, vtxZ);
+        sumAmpFV0 *= calibVtx;
+        sumAmpFV01to4Ch *= calibVtx;
       }
       flatenicity.fill(HIST("hAmpV0vsVtx"), vtxZ, sumAmpFV0);
     }
@@ -545,8 +578,6 @@ struct flatenictyFV0 {
     const int nCells1 = nRings1 * nSectors1;
     float maxEta1[nRings1] = {-3.05, -2.50};
     float minEta1[nRings1] = {-3.60, -3.05};
-    float maxPhi1[nSectors1] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
-    float minPhi1[nSectors1] = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
     float RhoLattice1[nCells1];
     for (int iCh = 0; iCh < nCells1; iCh++) {
       RhoLattice1[iCh] = 0.0;
@@ -563,16 +594,9 @@ struct flatenictyFV0 {
         continue;
       }
 
-      int i_ch = 0;
-      for (int ir = 0; ir < nRings1; ir++) {
-        for (int is = 0; is < nSectors1; is++) {
-          if (eta_a >= minEta1[ir] && eta_a < maxEta1[ir] &&
-              phi_a >= minPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1) &&
-              phi_a < maxPhi1[is] * 2.0 * M_PI / (1.0 * nSectors1)) {
-            RhoLattice1[i_ch]++;
-          }
-          i_ch++;
-        }
+      int i_ch = getLatticeCell<nRings1, nSectors1>(eta_a, phi_a, minEta1, maxEta1);
+      if (i_ch >= 0) {
+        RhoLattice1[i_ch]++;
       }
 
       multMFTTrack++;
@@ -584,8 +608,9 @@ struct flatenictyFV0 {
     }
     flatenicity.fill(HIST("hMFTvsVtxBeforeCalibration"), vtxZ, multMFTTrack);
     if (applyCalibVtx) {
-      multMFTTrack *= gVtx[3]->Eval(vtxZ);
-      multMFTTrackParc *= gVtx[3]->Eval(vtxZ);
+      float calibVtx = getVtxCalibration(calibMFTvtx, vtxZ);
+      multMFTTrack *= calibVtx;
+      multMFTTrackParc *= calibVtx;
     }
     flatenicity.fill(HIST("hMFTvsVtx"), vtxZ, multMFTTrack);
 
@@ -598,14 +623,13 @@ struct flatenictyFV0 {
     const int nCells2 = nRings2 * nSectors2;
     float maxEta2[nRings2] = {-0.4, 0.0, +0.4, +0.8};
     float minEta2[nRings2] = {-0.8, -0.4, +0.0, +0.4};
-    float maxPhi2[nSectors2] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
-    float minPhi2[nSectors2] = {0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
     float RhoLattice2[nCells2];
     for (int iCh = 0; iCh < nCells2; iCh++) {
       RhoLattice2[iCh] = 0.0;
     }
     float ptT = 0.;
     int multGlob = 0;
+    ptGlobal.clear();
     for (auto& track : tracks) {
       if (!track.isGlobalTrack()) {
         continue;
@@ -616,17 +640,11 @@ struct flatenictyFV0 {
         ptT = track.pt();
       }
       multGlob++;
+      ptGlobal.push_back(track.pt());
 
-      int i_ch = 0;
-      for (int ir = 0; ir < nRings2; ir++) {
-        for (int is = 0; is < nSectors2; is++) {
-          if (eta_a >= minEta2[ir] && eta_a < maxEta2[ir] &&
-              phi_a >= minPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2) &&
-              phi_a < maxPhi2[is] * 2.0 * M_PI / (1.0 * nSectors2)) {
-            RhoLattice2[i_ch]++;
-          }
-          i_ch++;
-        }
+      int i_ch = getLatticeCell<nRings2, nSectors2>(eta_a, phi_a, minEta2, maxEta2);
+      if (i_ch >= 0) {
+        RhoLattice2[i_ch]++;
       }
     }
 
@@ -683,8 +701,8 @@ struct flatenictyFV0 {
       flatenicity.fill(HIST("hAmpT0AvsVtxBeforeCalibration"), vtxZ, sumAmpFT0A);
       flatenicity.fill(HIST("hAmpT0CvsVtxBeforeCalibration"), vtxZ, sumAmpFT0C);
       if (applyCalibVtx) {
-        sumAmpFT0A *= gVtx[1]->Eval(vtxZ);
-        sumAmpFT0C *= gVtx[2]->Eval(vtxZ);
+        sumAmpFT0A *= getVtxCalibration(calibFT0Avtx, vtxZ);
+        sumAmpFT0C *= getVtxCalibration(calibFT0Cvtx, vtxZ);
       }
       flatenicity.fill(HIST("hAmpT0AvsVtx"), vtxZ, sumAmpFT0A);
       flatenicity.fill(HIST("hAmpT0CvsVtx"), vtxZ, sumAmpFT0C);
@@ -722,19 +740,17 @@ struct flatenictyFV0 {
       flatenicity.fill(HIST("hAmpFDAvsVtxBeforeCalibration"), vtxZ, sumAmpFDDA);
       flatenicity.fill(HIST("hAmpFDCvsVtxBeforeCalibration"), vtxZ, sumAmpFDDC);
       if (applyCalibVtx) {
-        sumAmpFDDA *= gVtx[4]->Eval(vtxZ);
-        sumAmpFDDC *= gVtx[5]->Eval(vtxZ);
+        sumAmpFDDA *= getVtxCalibration(calibFDAvtx, vtxZ);
+        sumAmpFDDC *= getVtxCalibration(calibFDCvtx, vtxZ);
       }
       flatenicity.fill(HIST("hAmpFDAvsVtx"), vtxZ, sumAmpFDDA);
       flatenicity.fill(HIST("hAmpFDCvsVtx"), vtxZ, sumAmpFDDC);
     }
 
-    bool isOK_estimator1 = false;
-    bool isOK_estimator2 = false;
-    bool isOK_estimator3 = false;
-    bool isOK_estimator4 = false;
-    bool isOK_estimator5 = false;
-    bool isOK_estimator6 = false;
+    flatenicities(collision.globalIndex(), flatenicity_fv0, flatenicity_mft, flatenicity_glob, flatenicity_t0a, flatenicity_t0c,
+                  sumAmpFV0, sumAmpFV01to4Ch, sumAmpFT0A, sumAmpFT0C, sumAmpFDDA, sumAmpFDDC,
+                  multMFTTrack, multMFTTrackParc, multGlob, ptT);
+
     float combined_estimator1 = 0;
     float combined_estimator2 = 0;
     float combined_estimator3 = 0;
@@ -754,24 +770,8 @@ struct flatenictyFV0 {
       ampl1[2] = sumAmpFT0C;
       ampl1[3] = sumAmpFV01to4Ch;
       ampl1[4] = sumAmpFDDA;
-      float all_weights = 0;
       if (sumAmpFDDC > 0 && multMFTTrack > 0 && sumAmpFT0C > 0 && sumAmpFV0 > 0 && sumAmpFDDA > 0) {
-        isOK_estimator1 = true;
-      }
-      if (isOK_estimator1) {
-        if (applyNorm) {
-          all_weights = 0;
-          for (int i_1 = 0; i_1 < nEta1; ++i_1) {
-            combined_estimator1 +=
-              ampl1[i_1] * weigthsEta1[i_1] / deltaEeta1[i_1];
-            all_weights += weigthsEta1[i_1];
-          }
-          combined_estimator1 /= all_weights;
-        } else {
-          for (int i_1 = 0; i_1 < nEta1; ++i_1) {
-            combined_estimator1 += ampl1[i_1] * weigthsEta1[i_1];
-          }
-        }
+        combined_estimator1 = getCombinedEstimator(ampl1, weigthsEta1, deltaEeta1);
       }
       // option 2
       ampl2[0] = sumAmpFDDC;
@@ -779,106 +779,31 @@ struct flatenictyFV0 {
       ampl2[2] = sumAmpFV01to4Ch;
       ampl2[3] = sumAmpFDDA;
       if (sumAmpFDDC > 0 && multMFTTrack > 0 && sumAmpFV0 > 0 && sumAmpFDDA > 0) {
-        isOK_estimator2 = true;
-      }
-      if (isOK_estimator2) {
-        if (applyNorm) {
-          all_weights = 0;
-          for (int i_2 = 0; i_2 < nEta2; ++i_2) {
-            combined_estimator2 +=
-              ampl2[i_2] * weigthsEta2[i_2] / deltaEeta2[i_2];
-            all_weights += weigthsEta2[i_2];
-          }
-          combined_estimator2 /= all_weights;
-        } else {
-          for (int i_2 = 0; i_2 < nEta2; ++i_2) {
-            combined_estimator2 += ampl2[i_2] * weigthsEta2[i_2];
-          }
-        }
+        combined_estimator2 = getCombinedEstimator(ampl2, weigthsEta2, deltaEeta2);
       }
       // option 3
       ampl3[0] = multMFTTrack;
       ampl3[1] = sumAmpFV0;
       if (multMFTTrack > 0 && sumAmpFV0 > 0) {
-        isOK_estimator3 = true;
-      }
-      if (isOK_estimator3) {
-        if (applyNorm) {
-          all_weights = 0;
-          for (int i_3 = 0; i_3 < nEta3; ++i_3) {
-            combined_estimator3 +=
-              ampl3[i_3] * weigthsEta3[i_3] / deltaEeta3[i_3];
-            all_weights += weigthsEta3[i_3];
-          }
-          combined_estimator3 /= all_weights;
-        } else {
-          for (int i_3 = 0; i_3 < nEta3; ++i_3) {
-            combined_estimator3 += ampl3[i_3] * weigthsEta3[i_3];
-          }
-        }
+        combined_estimator3 = getCombinedEstimator(ampl3, weigthsEta3, deltaEeta3);
       }
       // option 4
       ampl4[0] = multMFTTrack;
       ampl4[1] = sumAmpFT0A;
       if (multMFTTrack > 0 && sumAmpFT0A > 0) {
-        isOK_estimator4 = true;
-      }
-      if (isOK_estimator4) {
-        if (applyNorm) {
-          all_weights = 0;
-          for (int i_4 = 0; i_4 < nEta4; ++i_4) {
-            combined_estimator4 +=
-              ampl4[i_4] * weigthsEta4[i_4] / deltaEeta4[i_4];
-            all_weights += weigthsEta4[i_4];
-          }
-          combined_estimator4 /= all_weights;
-        } else {
-          for (int i_4 = 0; i_4 < nEta4; ++i_4) {
-            combined_estimator4 += ampl4[i_4] * weigthsEta4[i_4];
-          }
-        }
+        combined_estimator4 = getCombinedEstimator(ampl4, weigthsEta4, deltaEeta4);
       }
       // option 5
       ampl5[0] = sumAmpFT0C;
       ampl5[1] = sumAmpFT0A;
       if (sumAmpFT0C > 0 && sumAmpFT0A > 0) {
-        isOK_estimator5 = true;
-      }
-      if (isOK_estimator5) {
-        if (applyNorm) {
-          all_weights = 0;
-          for (int i_5 = 0; i_5 < nEta5; ++i_5) {
-            combined_estimator5 +=
-              ampl5[i_5] * weigthsEta5[i_5] / deltaEeta5[i_5];
-            all_weights += weigthsEta5[i_5];
-          }
-          combined_estimator5 /= all_weights;
-        } else {
-          for (int i_5 = 0; i_5 < nEta5; ++i_5) {
-            combined_estimator5 += ampl5[i_5] * weigthsEta5[i_5];
-          }
-        }
+        combined_estimator5 = getCombinedEstimator(ampl5, weigthsEta5, deltaEeta5);
       }
       // option 6: FT0C + FV0
       ampl6[0] = sumAmpFT0C;
       ampl6[1] = sumAmpFV0;
       if (sumAmpFT0C > 0 && sumAmpFV0 > 0) {
-        isOK_estimator6 = true;
-      }
-      if (isOK_estimator6) {
-        if (applyNorm) {
-          all_weights = 0;
-          for (int i_6 = 0; i_6 < nEta6; ++i_6) {
-            combined_estimator6 +=
-              ampl6[i_6] * weigthsEta6[i_6] / deltaEeta6[i_6];
-            all_weights += weigthsEta6[i_6];
-          }
-          combined_estimator6 /= all_weights;
-        } else {
-          for (int i_6 = 0; i_6 < nEta6; ++i_6) {
-            combined_estimator6 += ampl6[i_6] * weigthsEta6[i_6];
-          }
-        }
+        combined_estimator6 = getCombinedEstimator(ampl6, weigthsEta6, deltaEeta6);
       }
       flatenicity.fill(HIST("hMFTmult"), multMFTTrackParc);
       flatenicity.fill(HIST("hMFTmultAll"), multMFTTrack);
@@ -919,15 +844,13 @@ struct flatenictyFV0 {
                        flatenicity_glob);
       flatenicity.fill(HIST("hFlatMFTvsFlatFV0"), flatenicity_mft,
                        flatenicity_fv0);
-      // plot pt vs estimators
-      for (auto& track : tracks) {
-        if (!track.isGlobalTrack()) {
-          continue;
-        }
-        float pt = track.pt();
+      // plot pt vs estimators, the estimators are the same for all the tracks of the event
+      if (!ptGlobal.empty()) {
+        estimatorValues.resize(ptGlobal.size());
         static_for<0, 16>([&](auto i) {
           constexpr int index = i.value;
-          flatenicity.fill(HIST(nhPtEst[index]), estimator[index], pt);
+          std::fill(estimatorValues.begin(), estimatorValues.end(), estimator[index]);
+          flatenicity.get<TProfile>(HIST(nhPtEst[index]))->FillN(static_cast<Int_t>(ptGlobal.size()), estimatorValues.data(), ptGlobal.data(), nullptr);
         });
       }
 
@@ -16,7 +16,10 @@
 // \brief This code loops over every ambiguous MFT tracks and associates
 // them to a collision that has the smallest DCAxy
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 #include "ReconstructionDataFormats/TrackFwd.h"
 #include "Math/MatrixFunctions.h"
 #include "Math/SMatrix.h"
@@ -28,6 +31,7 @@
 
 #include "CommonConstants/MathConstants.h"
 #include "CommonConstants/LHCConstants.h"
+#include "Common/Core/CollisionBCIndex.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -55,6 +59,9 @@ struct vertexingfwd {
   std::vector<double> vecAmbTrack;       // vector for ambiguous track quantities like chi2 and z
   std::vector<double> vecZposCollForAmb; // vector for z vertex of collisions associated to an ambiguous track
 
+  o2::common::CollisionBCIndex collisionBCIndex; // collisions sorted in BC, to find those in the BCs of an ambiguous track
+  std::vector<int64_t> collisionCandidates;      // collisions in the BCs of the current ambiguous track
+
   Configurable<float> maxDCAXY{"maxDCAXY", 6.0, "max allowed transverse DCA"}; // To be used when associating ambitrack to collision using best DCA
 
   HistogramRegistry registry{
@@ -114,6 +121,8 @@ struct vertexingfwd {
     registry.fill(HIST("AmbiguousTracksStatus"), 0.0, ntracks);
     registry.fill(HIST("AmbiguousTracksStatus"), 1.0, nambitracks);
 
+    collisionBCIndex.build(collisions);
+
     for (auto& ambitrack : ambitracks) {
       vecCollForAmb.clear();
       vecDCACollForAmb.clear();
@@ -152,61 +161,62 @@ struct vertexingfwd {
 
       auto bcambis = ambitrack.bc();
 
+      // the compatible BCs of the ambiguous track are a contiguous slice of the BCs table, so that the collisions
+      // in one of these BCs are those with a BC in the window between the first and the last compatible BC
+      uint64_t bcMin = UINT64_MAX;
+      uint64_t bcMax = 0;
+      for (auto& bcambi : bcambis) {
+        bcMin = std::min<uint64_t>(bcMin, bcambi.globalBC());
+        bcMax = std::max<uint64_t>(bcMax, bcambi.globalBC());
+      }
+
       int collCounter = 0;
-      for (auto& collision : collisions) {
-        uint64_t mostProbableBC = collision.bc().globalBC();
+      for (auto collisionId : collisionBCIndex.collisionsInWindow(bcMin, bcMax, collisionCandidates)) {
+        auto collision = collisions.iteratorAt(collisionId);
         //uint64_t meanBC = mostProbableBC - std::lround(collision.collisionTime() / (o2::constants::lhc::LHCBunchSpacingNS / 1000));
         //int deltaBC = std::ceil(collision.collisionTimeRes() / (o2::constants::lhc::LHCBunchSpacingNS / 1000) * 4);
 
-        for (auto& bcambi : bcambis) {
+        //here the bc of the ambitrack is the bc of the collision we are looking at
+        collCounter++;
 
-          if (bcambi.globalBC() != mostProbableBC) {
-            continue;
-          }
-          //here the bc of the ambitrack is the bc of the collision we are looking at
-          collCounter++;
+        // We compute the DCAxy of this track wrt the primary vertex of the current collision
+        SMatrix5 tpars(vecAmbTrack[0], vecAmbTrack[1], vecAmbTrack[2], vecAmbTrack[3], vecAmbTrack[4]);
+        //            std::vector<double> v1{extAmbiTrack.cXX(), extAmbiTrack.cXY(), extAmbiTrack.cYY(), extAmbiTrack.cPhiX(), extAmbiTrack.cPhiY(),
+        //                                   extAmbiTrack.cPhiPhi(), extAmbiTrack.cTglX(), extAmbiTrack.cTglY(), extAmbiTrack.cTglPhi(), extAmbiTrack.cTglTgl(),
+        //                                   extAmbiTrack.c1PtX(), extAmbiTrack.c1PtY(), extAmbiTrack.c1PtPhi(), extAmbiTrack.c1PtTgl(), extAmbiTrack.c1Pt21Pt2()};
 
-          // We compute the DCAxy of this track wrt the primary vertex of the current collision
-          SMatrix5 tpars(vecAmbTrack[0], vecAmbTrack[1], vecAmbTrack[2], vecAmbTrack[3], vecAmbTrack[4]);
-          //            std::vector<double> v1{extAmbiTrack.cXX(), extAmbiTrack.cXY(), extAmbiTrack.cYY(), extAmbiTrack.cPhiX(), extAmbiTrack.cPhiY(),
-          //                                   extAmbiTrack.cPhiPhi(), extAmbiTrack.cTglX(), extAmbiTrack.cTglY(), extAmbiTrack.cTglPhi(), extAmbiTrack.cTglTgl(),
-          //                                   extAmbiTrack.c1PtX(), extAmbiTrack.c1PtY(), extAmbiTrack.c1PtPhi(), extAmbiTrack.c1PtTgl(), extAmbiTrack.c1Pt21Pt2()};
+        std::vector<double> v1; // Temporary null vector for the computation of the covariance matrix
+        SMatrix55 tcovs(v1.begin(), v1.end());
+        o2::track::TrackParCovFwd pars1{vecAmbTrack[5], tpars, tcovs, vecAmbTrack[6]};
 
-          std::vector<double> v1; // Temporary null vector for the computation of the covariance matrix
-          SMatrix55 tcovs(v1.begin(), v1.end());
-          o2::track::TrackParCovFwd pars1{vecAmbTrack[5], tpars, tcovs, vecAmbTrack[6]};
+        // o2::track::TrackParCovFwd pars1{extAmbiTrack.z(), tpars, tcovs, chi2};
+        pars1.propagateToZlinear(collision.posZ()); // track parameters propagation to the position of the z vertex
 
-          // o2::track::TrackParCovFwd pars1{extAmbiTrack.z(), tpars, tcovs, chi2};
-          pars1.propagateToZlinear(collision.posZ()); // track parameters propagation to the position of the z vertex
+        const auto dcaX(pars1.getX() - collision.posX());
+        const auto dcaY(pars1.getY() - collision.posY());
+        auto dcaXY = std::sqrt(dcaX * dcaX + dcaY * dcaY);
 
-          const auto dcaX(pars1.getX() - collision.posX());
-          const auto dcaY(pars1.getY() - collision.posY());
-          auto dcaXY = std::sqrt(dcaX * dcaX + dcaY * dcaY);
+        registry.fill(HIST("TracksDCAXY"), dcaXY);
+        registry.fill(HIST("TracksDCAX"), dcaX);
+        registry.fill(HIST("TracksDCAY"), dcaY);
+        registry.fill(HIST("NumberOfContributors"), collision.numContrib());
 
-          registry.fill(HIST("TracksDCAXY"), dcaXY);
-          registry.fill(HIST("TracksDCAX"), dcaX);
-          registry.fill(HIST("TracksDCAY"), dcaY);
-          registry.fill(HIST("NumberOfContributors"), collision.numContrib());
-
-          if (dcaXY > maxDCAXY) {
-            continue;
-          }
+        if (dcaXY > maxDCAXY) {
+          continue;
+        }
 
-          vecDCACollForAmb.push_back(dcaXY);
+        vecDCACollForAmb.push_back(dcaXY);
 
-          if (!collision.has_mcCollision()) {
-            continue;
-          }
+        if (!collision.has_mcCollision()) {
+          continue;
+        }
 
-          int mcCollindex = collision.mcCollision().globalIndex();
-          vecCollForAmb.push_back(mcCollindex);
+        int mcCollindex = collision.mcCollision().globalIndex();
+        vecCollForAmb.push_back(mcCollindex);
 
-          vecZposCollForAmb.push_back(collision.mcCollision().posZ());
+        vecZposCollForAmb.push_back(collision.mcCollision().posZ());
 
-          registry.fill(HIST("DeltaZvtx"), collision.mcCollision().posZ() - zVtxMCAmbi);
-          break; //once we found a bc that corresponds to the bc of the collision we are working on, go out of the bcambi loop
-          //We then look at the next collision
-        }
+        registry.fill(HIST("DeltaZvtx"), collision.mcCollision().posZ() - zVtxMCAmbi);
       }
 
       registry.fill(HIST("NbCollComp"), collCounter);
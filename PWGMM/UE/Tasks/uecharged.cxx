@@ -86,6 +86,71 @@ struct ueCharged {
   template <typename C, typename P>
   void processTrue(const C& collision, const P& particles);
 
+  // Selected tracks or particles of an event, stored as arrays for the leading-particle search and the classification
+  // into the topological regions, which then run over contiguous values instead of the table iterators
+  struct UeParticles {
+    std::vector<float> pt;
+    std::vector<float> phi;
+    std::vector<int> index;
+    void clear()
+    {
+      pt.clear();
+      phi.clear();
+      index.clear();
+    }
+    void add(float ptValue, float phiValue, int indexValue)
+    {
+      pt.push_back(ptValue);
+      phi.push_back(phiValue);
+      index.push_back(indexValue);
+    }
+    std::size_t size() const { return pt.size(); }
+  };
+  // Leading particle, nUpdates is the number of times it changed in the search
+  struct UeLeading {
+    float pt = 0.f;
+    float phi = 0.f;
+    int index = 0;
+    int nUpdates = 0;
+  };
+  // Number of particles, sum pT and particle arrays in the near (0), away (1) and transverse (2) side, 3 is the leading particle
+  struct UeRegions {
+    int nch[4];
+    double sumPt[4];
+    std::vector<double> pt[4];
+    std::vector<double> dPhi[4];
+    void clear()
+    {
+      for (int i = 0; i < 4; ++i) {
+        nch[i] = 0;
+        sumPt[i] = 0.;
+        pt[i].clear();
+        dPhi[i].clear();
+      }
+    }
+  };
+  // region of a particle from its delta phi to the leading particle, computed without branches
+  static int regionCode(float DPhi)
+  {
+    int nearSide = TMath::Abs(DPhi) < M_PI / 3.0;
+    int awaySide = TMath::Abs(DPhi - M_PI) < M_PI / 3.0;
+    return 2 - 2 * nearSide - awaySide;
+  }
+  UeLeading findLeading(const UeParticles& particles);
+  void classify(const UeParticles& particles, const UeLeading& leading, UeRegions& regions, bool fillArrays);
+  template <typename H1, typename H2>
+  void fillRegion(const H1& hPhiName, const H2& hPtVsPtLeadingName, const UeRegions& regions, float ptLeading, int region);
+  template <typename P>
+  void selectTrueParticles(const P& particles);
+  template <bool IS_MC, typename T>
+  void fillMeasured(const T& tracks, float vtxZ);
+
+  // buffers reused across the events
+  UeParticles recTracks, ddTracks, trueParticles;
+  UeRegions recRegions, ddRegions, trueRegions;
+  std::vector<double> ptLeadingValues;
+  TrackSelection dcaTrackSelection;
+
   Filter trackFilter = (nabs(aod::track::eta) < cfgTrkEtaCut) && (aod::track::pt > cfgTrkLowPtCut);
 
   using CollisionTableMCTrue = aod::McCollisions;
@@ -149,6 +214,8 @@ void ueCharged::init(InitContext const&)
   ConfigurableAxis ptBinning{"ptBinning", {0, 0.0, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35, 0.4, 0.45, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.5, 2.0, 2.5, 3.0, 3.5, 4.0, 4.5, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 12.0, 14.0, 16.0, 18.0, 20.0, 25.0, 30.0, 40.0, 50.0}, "pTassoc bin limits"};
   AxisSpec ptAxis = {ptBinning, "#it{p}_{T}^{assoc} (GeV/#it{c})"};
 
+  dcaTrackSelection = myTrackSelection();
+
   f_Eff.setObject(new TF1("fpara",
                           "(x<0.9)*((-6.67648e-02)+x*(1.78170e+00)+x*x*(-1.12962e+00))+"
                           "(x>=0.9&&x<4.5)*((5.48165e-01)+(1.35818e-01)*x+(-4.87156e-02)*x*x+(5.97039e-03)*x*x*x)+(x>=4.5)*(6.90314e-01)",
@@ -240,41 +307,53 @@ void ueCharged::processData(CollisionTableData::iterator const& collision, Track
   processMeas(collision, tracks);
 }
 
-template <typename C, typename P>
-void ueCharged::processTrue(const C& collision, const P& particles)
+ueCharged::UeLeading ueCharged::findLeading(const UeParticles& particles)
 {
-  int multTrue = 0;
-  int multTrueINEL = 0;
-  for (auto& particle : particles) {
-    auto pdgParticle = pdg->GetParticle(particle.pdgCode());
-    if (!pdgParticle || pdgParticle->Charge() == 0.) {
-      continue;
-    }
-    if (!particle.isPhysicalPrimary()) {
-      continue;
+  // the first particle of highest pT, nUpdates counts the changes of leading particle as the loop goes
+  UeLeading leading;
+  for (std::size_t i = 0; i < particles.size(); ++i) {
+    if (leading.pt < particles.pt[i]) {
+      leading.pt = particles.pt[i];
+      leading.phi = particles.phi[i];
+      leading.index = particles.index[i];
+      leading.nUpdates++;
     }
-    if (std::abs(particle.eta()) <= 1.0) {
-      multTrueINEL++;
-    }
-    if (std::abs(particle.eta()) >= cfgTrkEtaCut) {
-      continue;
-    }
-    multTrue++;
-    if (particle.pt() < cfgTrkLowPtCut) {
-      continue;
+  }
+  return leading;
+}
+
+void ueCharged::classify(const UeParticles& particles, const UeLeading& leading, UeRegions& regions, bool fillArrays)
+{
+  regions.clear();
+  for (std::size_t i = 0; i < particles.size(); ++i) {
+    float DPhi = DeltaPhi(particles.phi[i], leading.phi);
+    // the leading particle goes to the unused 4th region (removal of the autocorrelation)
+    int region = particles.index[i] == leading.index ? 3 : regionCode(DPhi);
+    regions.nch[region]++;
+    regions.sumPt[region] += particles.pt[i];
+    if (fillArrays) {
+      regions.pt[region].push_back(particles.pt[i]);
+      regions.dPhi[region].push_back(DPhi);
     }
-    ue.fill(HIST("hPtInPrimGen"), particle.pt());
   }
-  ue.fill(HIST("hmultTrueGen"), multTrue);
-  ue.fill(HIST("hvtxZmc"), collision.posZ());
-  if (std::abs(collision.posZ()) > 10.f && multTrueINEL <= 0) {
+}
+
+template <typename H1, typename H2>
+void ueCharged::fillRegion(const H1& hPhiName, const H2& hPtVsPtLeadingName, const UeRegions& regions, float ptLeading, int region)
+{
+  int n = regions.pt[region].size();
+  if (n == 0) {
     return;
   }
+  ptLeadingValues.assign(n, ptLeading);
+  ue.get<TH1>(hPhiName)->FillN(n, regions.dPhi[region].data(), nullptr);
+  ue.get<TH2>(hPtVsPtLeadingName)->FillN(n, ptLeadingValues.data(), regions.pt[region].data(), nullptr);
+}
 
-  double flPtTrue = 0; // leading pT
-  double flPhiTrue = 0;
-  int flIndexTrue = 0;
-
+template <typename P>
+void ueCharged::selectTrueParticles(const P& particles)
+{
+  trueParticles.clear();
   for (auto& particle : particles) {
     auto pdgParticle = pdg->GetParticle(particle.pdgCode());
     if (!pdgParticle || pdgParticle->Charge() == 0.) {
@@ -286,34 +365,20 @@ void ueCharged::processTrue(const C& collision, const P& particles)
     if (std::abs(particle.eta()) >= cfgTrkEtaCut) {
       continue;
     }
-
     if (particle.pt() < cfgTrkLowPtCut) {
       continue;
     }
-
-    // ue.fill(HIST("hPtInPrim"), particle.pt());
-
-    if (flPtTrue < particle.pt()) {
-      flPtTrue = particle.pt();
-      flPhiTrue = particle.phi();
-      flIndexTrue = particle.globalIndex();
-    }
+    trueParticles.add(particle.pt(), particle.phi(), particle.globalIndex());
   }
-  ue.fill(HIST("hPtLeadingTrue"), flPtTrue);
-  std::vector<double> ue_true;
-  ue_true.clear();
-  int nchm_toptrue[3];
-  double sumptm_toptrue[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_toptrue[i] = 0;
-    sumptm_toptrue[i] = 0;
-  }
-  std::vector<Float_t> ptArrayTrue;
-  std::vector<Float_t> phiArrayTrue;
-  std::vector<int> indexArrayTrue;
+}
 
+template <typename C, typename P>
+void ueCharged::processTrue(const C& collision, const P& particles)
+{
+  int multTrue = 0;
+  int multTrueINEL = 0;
+  trueParticles.clear();
   for (auto& particle : particles) {
-
     auto pdgParticle = pdg->GetParticle(particle.pdgCode());
     if (!pdgParticle || pdgParticle->Charge() == 0.) {
       continue;
@@ -321,65 +386,133 @@ void ueCharged::processTrue(const C& collision, const P& particles)
     if (!particle.isPhysicalPrimary()) {
       continue;
     }
+    if (std::abs(particle.eta()) <= 1.0) {
+      multTrueINEL++;
+    }
     if (std::abs(particle.eta()) >= cfgTrkEtaCut) {
       continue;
     }
+    multTrue++;
     if (particle.pt() < cfgTrkLowPtCut) {
       continue;
     }
-    // remove the autocorrelation
-    if (flIndexTrue == particle.globalIndex()) {
-      continue;
+    ue.fill(HIST("hPtInPrimGen"), particle.pt());
+    trueParticles.add(particle.pt(), particle.phi(), particle.globalIndex());
+  }
+  ue.fill(HIST("hmultTrueGen"), multTrue);
+  ue.fill(HIST("hvtxZmc"), collision.posZ());
+  if (std::abs(collision.posZ()) > 10.f && multTrueINEL <= 0) {
+    return;
+  }
+
+  auto leading = findLeading(trueParticles);
+  ue.fill(HIST("hPtLeadingTrue"), leading.pt);
+  classify(trueParticles, leading, trueRegions, true);
+
+  static_for<0, 2>([&](auto i) {
+    constexpr int region = i.value;
+    fillRegion(HIST(hPhiTrue[region]), HIST(hPtVsPtLeadingTrue[region]), trueRegions, leading.pt, region);
+    ue.fill(HIST(pNumDenTrueAll[region]), leading.pt, 1.0 * trueRegions.nch[region]);
+    ue.fill(HIST(pSumPtTrueAll[region]), leading.pt, trueRegions.sumPt[region]);
+    ue.fill(HIST(pNumDenTrue[region]), leading.pt, 1.0 * trueRegions.nch[region]);
+    ue.fill(HIST(pSumPtTrue[region]), leading.pt, trueRegions.sumPt[region]);
+  });
+}
+
+template <bool IS_MC, typename T>
+void ueCharged::fillMeasured(const T& tracks, float vtxZ)
+{
+  // single loop over the tracks for the track histograms and the arrays of the selected tracks,
+  // the leading track and the regions are then found from the arrays
+  recTracks.clear();
+  ddTracks.clear();
+  for (auto& track : tracks) {
+
+    if (dcaTrackSelection.IsSelected(track)) { // TODO: set cuts w/o DCA cut
+      ue.fill(HIST("hPTVsDCAData"), track.pt(), track.dcaXY());
     }
-    double DPhi = DeltaPhi(particle.phi(), flPhiTrue);
-
-    // definition of the topological regions
-    if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-      ue.fill(HIST(hPhiTrue[0]), DPhi);
-      ue.fill(HIST(hPtVsPtLeadingTrue[0]), flPtTrue, particle.pt());
-      nchm_toptrue[0]++;
-      sumptm_toptrue[0] += particle.pt();
-    } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-      ue.fill(HIST(hPhiTrue[1]), DPhi);
-      ue.fill(HIST(hPtVsPtLeadingTrue[1]), flPtTrue, particle.pt());
-      nchm_toptrue[1]++;
-      sumptm_toptrue[1] += particle.pt();
-    } else { // transverse side
-      ue.fill(HIST(hPhiTrue[2]), DPhi);
-      ue.fill(HIST(hPtVsPtLeadingTrue[2]), flPtTrue, particle.pt());
-      nchm_toptrue[2]++;
-      sumptm_toptrue[2] += particle.pt();
+    if constexpr (IS_MC) {
+      if (track.has_mcParticle()) {
+        if (track.isGlobalTrack()) {
+          ue.fill(HIST("hPtOut"), track.pt());
+        }
+        if (dcaTrackSelection.IsSelected(track)) {
+          ue.fill(HIST("hPtDCAall"), track.pt(), track.dcaXY());
+        }
+        const auto& particle = track.template mcParticle_as<aod::McParticles>();
+        if (particle.isPhysicalPrimary()) {
+
+          if (track.isGlobalTrack()) {
+            // ue.fill(HIST("hPtOutPrim"), track.pt());
+            ue.fill(HIST("hPtOutPrim"), particle.pt());
+          }
+          if (dcaTrackSelection.IsSelected(track)) {
+            ue.fill(HIST("hPtDCAPrimary"), track.pt(), track.dcaXY());
+          }
+          // LOGP(info, "this track has MC particle {}", 1);
+        } else {
+          if (track.isGlobalTrack()) {
+            ue.fill(HIST("hPtOutSec"), track.pt());
+          }
+          if (dcaTrackSelection.IsSelected(track)) {
+            if (particle.getGenStatusCode() >= 0) { // i guess these are decays
+              ue.fill(HIST("hPtDCAWeak"), track.pt(), track.dcaXY());
+            } else { // i guess these are from material
+              ue.fill(HIST("hPtDCAMat"), track.pt(), track.dcaXY());
+            }
+          }
+        }
+      }
     }
-  }
 
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_true.push_back(1.0 * nchm_toptrue[i_reg]);
-  }
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_true.push_back(sumptm_toptrue[i_reg]);
-  }
-  ue.fill(HIST(pNumDenTrueAll[0]), flPtTrue, ue_true[0]);
-  ue.fill(HIST(pSumPtTrueAll[0]), flPtTrue, ue_true[3]);
+    if (!track.isGlobalTrack()) {
+      continue;
+    }
 
-  ue.fill(HIST(pNumDenTrueAll[1]), flPtTrue, ue_true[1]);
-  ue.fill(HIST(pSumPtTrueAll[1]), flPtTrue, ue_true[4]);
+    ue.fill(HIST("hdNdeta"), track.eta());
+    ue.fill(HIST("vtxZEta"), track.eta(), vtxZ);
+    ue.fill(HIST("phiEta"), track.eta(), track.phi());
 
-  ue.fill(HIST(pNumDenTrueAll[2]), flPtTrue, ue_true[2]);
-  ue.fill(HIST(pSumPtTrueAll[2]), flPtTrue, ue_true[5]);
+    recTracks.add(track.pt(), track.phi(), track.globalIndex());
+    // applying the efficiency twice for the misrec of leading particle
+    if (f_Eff->Eval(track.pt()) > gRandom->Uniform(0, 1)) {
+      ddTracks.add(track.pt(), track.phi(), track.globalIndex());
+    }
+  }
 
-  ue.fill(HIST(pNumDenTrue[0]), flPtTrue, ue_true[0]);
-  ue.fill(HIST(pSumPtTrue[0]), flPtTrue, ue_true[3]);
+  auto leading = findLeading(recTracks);
+  ue.fill(HIST("hmultRec"), leading.nUpdates);
+  ue.fill(HIST("hPtLeadingMeasured"), leading.pt);
+  ue.fill(HIST("hPtLeadingRecPS"), leading.pt);
+  classify(recTracks, leading, recRegions, true);
 
-  ue.fill(HIST(pNumDenTrue[1]), flPtTrue, ue_true[1]);
-  ue.fill(HIST(pSumPtTrue[1]), flPtTrue, ue_true[4]);
+  // add flags for Vtx, PS, ev sel
+  static_for<0, 2>([&](auto i) {
+    constexpr int region = i.value;
+    fillRegion(HIST(hPhi[region]), HIST(hPtVsPtLeadingData[region]), recRegions, leading.pt, region);
+    ue.fill(HIST(pNumDenMeasuredPS[region]), leading.pt, 1.0 * recRegions.nch[region]);
+    ue.fill(HIST(pNumDenData[region]), leading.pt, 1.0 * recRegions.nch[region]);
+    ue.fill(HIST(pSumPtMeasuredPS[region]), leading.pt, recRegions.sumPt[region]);
+    ue.fill(HIST(pSumPtData[region]), leading.pt, recRegions.sumPt[region]);
+  });
 
-  ue.fill(HIST(pNumDenTrue[2]), flPtTrue, ue_true[2]);
-  ue.fill(HIST(pSumPtTrue[2]), flPtTrue, ue_true[5]);
+  ue.fill(HIST("hPtLeadingData"), leading.pt);
 
-  ptArrayTrue.clear();
-  phiArrayTrue.clear();
-  indexArrayTrue.clear();
+  // Compute data driven (DD) missidentification correction
+  auto leadingDd = findLeading(ddTracks);
+  classify(ddTracks, leadingDd, ddRegions, false);
+
+  static_for<0, 2>([&](auto i) {
+    constexpr int region = i.value;
+    ue.fill(HIST(hNumDenMCDd[region]), leadingDd.pt, ddRegions.nch[region]);
+    ue.fill(HIST(hSumPtMCDd[region]), leadingDd.pt, ddRegions.sumPt[region]);
+    if (leadingDd.index == leading.index) {
+      ue.fill(HIST(hNumDenMCMatchDd[region]), leadingDd.pt, ddRegions.nch[region]);
+      ue.fill(HIST(hSumPtMCMatchDd[region]), leadingDd.pt, ddRegions.sumPt[region]);
+    }
+  });
 }
+
 template <typename C, typename T>
 void ueCharged::processMeas(const C& collision, const T& tracks)
 {
@@ -420,165 +553,7 @@ void ueCharged::processMeas(const C& collision, const T& tracks)
 
   ue.fill(HIST("hvtxZ"), vtxZ);
 
-  // loop over selected tracks
-  double flPt = 0; // leading pT
-  double flPhi = 0;
-  int flIndex = 0;
-  int multRec = 0;
-  for (auto& track : tracks) {
-    if (!track.isGlobalTrack()) {
-      continue;
-    }
-
-    ue.fill(HIST("hdNdeta"), track.eta());
-    ue.fill(HIST("vtxZEta"), track.eta(), vtxZ);
-    ue.fill(HIST("phiEta"), track.eta(), track.phi());
-
-    if (flPt < track.pt()) {
-      multRec++;
-      flPt = track.pt();
-      flPhi = track.phi();
-      flIndex = track.globalIndex();
-    }
-  }
-  ue.fill(HIST("hmultRec"), multRec);
-  ue.fill(HIST("hPtLeadingMeasured"), flPt);
-  ue.fill(HIST("hPtLeadingRecPS"), flPt);
-  std::vector<double> ue_rec;
-  ue_rec.clear();
-  int nchm_top[3];
-  double sumptm_top[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_top[i] = 0;
-    sumptm_top[i] = 0;
-  }
-  std::vector<Float_t> ptArray;
-  std::vector<Float_t> phiArray;
-  std::vector<int> indexArray;
-
-  for (auto& track : tracks) {
-
-    if (myTrackSelection().IsSelected(track)) { // TODO: set cuts w/o DCA cut
-      ue.fill(HIST("hPTVsDCAData"), track.pt(), track.dcaXY());
-    }
-
-    if (track.isGlobalTrack()) {
-      // applying the efficiency twice for the misrec of leading particle
-      if (f_Eff->Eval(track.pt()) > gRandom->Uniform(0, 1)) {
-        ptArray.push_back(track.pt());
-        phiArray.push_back(track.phi());
-        indexArray.push_back(track.globalIndex());
-      }
-
-      // remove the autocorrelation
-      if (flIndex == track.globalIndex()) {
-        continue;
-      }
-
-      double DPhi = DeltaPhi(track.phi(), flPhi);
-
-      // definition of the topological regions
-      if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-        ue.fill(HIST(hPhi[0]), DPhi);
-        ue.fill(HIST(hPtVsPtLeadingData[0]), flPt, track.pt());
-        nchm_top[0]++;
-        sumptm_top[0] += track.pt();
-      } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-        ue.fill(HIST(hPhi[1]), DPhi);
-        ue.fill(HIST(hPtVsPtLeadingData[1]), flPt, track.pt());
-        nchm_top[1]++;
-        sumptm_top[1] += track.pt();
-      } else { // transverse side
-        ue.fill(HIST(hPhi[2]), DPhi);
-        ue.fill(HIST(hPtVsPtLeadingData[2]), flPt, track.pt());
-        nchm_top[2]++;
-        sumptm_top[2] += track.pt();
-      }
-    }
-  }
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_rec.push_back(1.0 * nchm_top[i_reg]);
-  }
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_rec.push_back(sumptm_top[i_reg]);
-  }
-
-  // add flags for Vtx, PS, ev sel
-  ue.fill(HIST(pNumDenMeasuredPS[0]), flPt, ue_rec[0]);
-  ue.fill(HIST(pNumDenData[0]), flPt, ue_rec[0]);
-  ue.fill(HIST(pSumPtMeasuredPS[0]), flPt, ue_rec[3]);
-  ue.fill(HIST(pSumPtData[0]), flPt, ue_rec[3]);
-
-  ue.fill(HIST(pNumDenMeasuredPS[1]), flPt, ue_rec[1]);
-  ue.fill(HIST(pNumDenData[1]), flPt, ue_rec[1]);
-  ue.fill(HIST(pSumPtMeasuredPS[1]), flPt, ue_rec[4]);
-  ue.fill(HIST(pSumPtData[1]), flPt, ue_rec[4]);
-
-  ue.fill(HIST(pNumDenMeasuredPS[2]), flPt, ue_rec[2]);
-  ue.fill(HIST(pNumDenData[2]), flPt, ue_rec[2]);
-  ue.fill(HIST(pSumPtMeasuredPS[2]), flPt, ue_rec[5]);
-  ue.fill(HIST(pSumPtData[2]), flPt, ue_rec[5]);
-
-  ue.fill(HIST("hPtLeadingData"), flPt);
-
-  // Compute data driven (DD) missidentification correction
-  Float_t flPtdd = 0; // leading pT
-  Float_t flPhidd = 0;
-  int flIndexdd = 0;
-  int ntrkdd = ptArray.size();
-
-  for (int i = 0; i < ntrkdd; ++i) {
-    if (flPtdd < ptArray[i]) {
-      flPtdd = ptArray[i];
-      flPhidd = phiArray[i];
-      flIndexdd = indexArray[i];
-    }
-  }
-  int nchm_topdd[3];
-  double sumptm_topdd[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_topdd[i] = 0;
-    sumptm_topdd[i] = 0;
-  }
-  for (int i = 0; i < ntrkdd; ++i) {
-    if (indexArray[i] == flIndexdd) {
-      continue;
-    }
-    double DPhi = DeltaPhi(phiArray[i], flPhidd);
-    if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-      nchm_topdd[0]++;
-      sumptm_topdd[0] += ptArray[i];
-    } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-      nchm_topdd[1]++;
-      sumptm_topdd[1] += ptArray[i];
-    } else { // transverse side
-      nchm_topdd[2]++;
-      sumptm_topdd[2] += ptArray[i];
-    }
-  }
-
-  ue.fill(HIST(hNumDenMCDd[0]), flPtdd, nchm_topdd[0]);
-  ue.fill(HIST(hSumPtMCDd[0]), flPtdd, sumptm_topdd[0]);
-
-  ue.fill(HIST(hNumDenMCDd[1]), flPtdd, nchm_topdd[1]);
-  ue.fill(HIST(hSumPtMCDd[1]), flPtdd, sumptm_topdd[1]);
-
-  ue.fill(HIST(hNumDenMCDd[2]), flPtdd, nchm_topdd[2]);
-  ue.fill(HIST(hSumPtMCDd[2]), flPtdd, sumptm_topdd[2]);
-
-  if (flIndexdd == flIndex) {
-    ue.fill(HIST(hNumDenMCMatchDd[0]), flPtdd, nchm_topdd[0]);
-    ue.fill(HIST(hSumPtMCMatchDd[0]), flPtdd, sumptm_topdd[0]);
-
-    ue.fill(HIST(hNumDenMCMatchDd[1]), flPtdd, nchm_topdd[1]);
-    ue.fill(HIST(hSumPtMCMatchDd[1]), flPtdd, sumptm_topdd[1]);
-
-    ue.fill(HIST(hNumDenMCMatchDd[2]), flPtdd, nchm_topdd[2]);
-    ue.fill(HIST(hSumPtMCMatchDd[2]), flPtdd, sumptm_topdd[2]);
-  }
-  ptArray.clear();
-  phiArray.clear();
-  indexArray.clear();
+  fillMeasured<false>(tracks, vtxZ);
 }
 
 template <bool IS_MC, typename C, typename T, typename P>
@@ -603,102 +578,16 @@ void ueCharged::processMeasMC(const C& collision, const T& tracks, const P& part
   ue.fill(HIST("hStat"), collision.size());
   auto vtxZ = collision.posZ();
 
-  // int multTrue = 0;
-  double flPtTrue = 0; // leading pT
-  double flPhiTrue = 0;
-  int flIndexTrue = 0;
-
-  for (auto& particle : particles) {
-    auto pdgParticle = pdg->GetParticle(particle.pdgCode());
-    if (!pdgParticle || pdgParticle->Charge() == 0.) {
-      continue;
-    }
-    if (!particle.isPhysicalPrimary()) {
-      continue;
-    }
-    if (std::abs(particle.eta()) >= cfgTrkEtaCut) {
-      continue;
-    }
-    // multTrue++;
-    if (particle.pt() < cfgTrkLowPtCut) {
-      continue;
-    }
-    // ue.fill(HIST("hPtInPrim"), particle.pt());
-
-    if (flPtTrue < particle.pt()) {
-      flPtTrue = particle.pt();
-      flPhiTrue = particle.phi();
-      flIndexTrue = particle.globalIndex();
-    }
-  }
-  // ue.fill(HIST("hmultTrue"), multTrue);
-  std::vector<double> ue_true;
-  ue_true.clear();
-  int nchm_toptrue[3];
-  double sumptm_toptrue[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_toptrue[i] = 0;
-    sumptm_toptrue[i] = 0;
-  }
-  std::vector<Float_t> ptArrayTrue;
-  std::vector<Float_t> phiArrayTrue;
-  std::vector<int> indexArrayTrue;
-
-  for (auto& particle : particles) {
-
-    auto pdgParticle = pdg->GetParticle(particle.pdgCode());
-    if (!pdgParticle || pdgParticle->Charge() == 0.) {
-      continue;
-    }
-    if (!particle.isPhysicalPrimary()) {
-      continue;
-    }
-    if (std::abs(particle.eta()) >= cfgTrkEtaCut) {
-      continue;
-    }
-    if (particle.pt() < cfgTrkLowPtCut) {
-      continue;
-    }
-    // remove the autocorrelation
-    if (flIndexTrue == particle.globalIndex()) {
-      continue;
-    }
-    double DPhi = DeltaPhi(particle.phi(), flPhiTrue);
-
-    // definition of the topological regions
-    if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-      nchm_toptrue[0]++;
-      sumptm_toptrue[0] += particle.pt();
-    } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-      nchm_toptrue[1]++;
-      sumptm_toptrue[1] += particle.pt();
-    } else { // transverse side
-      nchm_toptrue[2]++;
-      sumptm_toptrue[2] += particle.pt();
-    }
-  }
-
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_true.push_back(1.0 * nchm_toptrue[i_reg]);
-  }
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_true.push_back(sumptm_toptrue[i_reg]);
-  }
+  selectTrueParticles(particles);
+  auto leadingTrue = findLeading(trueParticles);
+  classify(trueParticles, leadingTrue, trueRegions, false);
 
   // add flags for Vtx, PS, ev sel
-
-  ue.fill(HIST(pNumDenTruePS[0]), flPtTrue, ue_true[0]);
-  ue.fill(HIST(pSumPtTruePS[0]), flPtTrue, ue_true[3]);
-
-  ue.fill(HIST(pNumDenTruePS[1]), flPtTrue, ue_true[1]);
-  ue.fill(HIST(pSumPtTruePS[1]), flPtTrue, ue_true[4]);
-
-  ue.fill(HIST(pNumDenTruePS[2]), flPtTrue, ue_true[2]);
-  ue.fill(HIST(pSumPtTruePS[2]), flPtTrue, ue_true[5]);
-
-  ptArrayTrue.clear();
-  phiArrayTrue.clear();
-  indexArrayTrue.clear();
+  static_for<0, 2>([&](auto i) {
+    constexpr int region = i.value;
+    ue.fill(HIST(pNumDenTruePS[region]), leadingTrue.pt, 1.0 * trueRegions.nch[region]);
+    ue.fill(HIST(pSumPtTruePS[region]), leadingTrue.pt, trueRegions.sumPt[region]);
+  });
 
   isAcceptedEvent = false;
   if (std::abs(collision.posZ()) < 10.f) {
@@ -738,198 +627,7 @@ void ueCharged::processMeasMC(const C& collision, const T& tracks, const P& part
   }
   ue.fill(HIST("hmultTrue"), multTrue);
 
-  // loop over selected tracks
-  double flPt = 0; // leading pT
-  double flPhi = 0;
-  int flIndex = 0;
-  int multRec = 0;
-  for (auto& track : tracks) {
-    if (!track.isGlobalTrack()) {
-      continue;
-    }
-
-    ue.fill(HIST("hdNdeta"), track.eta());
-    ue.fill(HIST("vtxZEta"), track.eta(), vtxZ);
-    ue.fill(HIST("phiEta"), track.eta(), track.phi());
-
-    if (flPt < track.pt()) {
-      multRec++;
-      flPt = track.pt();
-      flPhi = track.phi();
-      flIndex = track.globalIndex();
-    }
-  }
-  ue.fill(HIST("hmultRec"), multRec);
-  ue.fill(HIST("hPtLeadingMeasured"), flPt);
-  ue.fill(HIST("hPtLeadingRecPS"), flPt);
-  std::vector<double> ue_rec;
-  ue_rec.clear();
-  int nchm_top[3];
-  double sumptm_top[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_top[i] = 0;
-    sumptm_top[i] = 0;
-  }
-  std::vector<Float_t> ptArray;
-  std::vector<Float_t> phiArray;
-  std::vector<int> indexArray;
-
-  for (auto& track : tracks) {
-
-    if (myTrackSelection().IsSelected(track)) { // TODO: set cuts w/o DCA cut
-      ue.fill(HIST("hPTVsDCAData"), track.pt(), track.dcaXY());
-    }
-    if constexpr (IS_MC) {
-      if (track.has_mcParticle()) {
-        if (track.isGlobalTrack()) {
-          ue.fill(HIST("hPtOut"), track.pt());
-        }
-        if (myTrackSelection().IsSelected(track)) {
-          ue.fill(HIST("hPtDCAall"), track.pt(), track.dcaXY());
-        }
-        const auto& particle = track.template mcParticle_as<aod::McParticles>();
-        if (particle.isPhysicalPrimary()) {
-
-          if (track.isGlobalTrack()) {
-            // ue.fill(HIST("hPtOutPrim"), track.pt());
-            ue.fill(HIST("hPtOutPrim"), particle.pt());
-          }
-          if (myTrackSelection().IsSelected(track)) {
-            ue.fill(HIST("hPtDCAPrimary"), track.pt(), track.dcaXY());
-          }
-          // LOGP(info, "this track has MC particle {}", 1);
-        } else {
-          if (track.isGlobalTrack()) {
-            ue.fill(HIST("hPtOutSec"), track.pt());
-          }
-          if (myTrackSelection().IsSelected(track)) {
-            if (particle.getGenStatusCode() >= 0) { // i guess these are decays
-              ue.fill(HIST("hPtDCAWeak"), track.pt(), track.dcaXY());
-            } else { // i guess these are from material
-              ue.fill(HIST("hPtDCAMat"), track.pt(), track.dcaXY());
-            }
-          }
-        }
-      }
-    }
-
-    if (track.isGlobalTrack()) {
-      // applying the efficiency twice for the misrec of leading particle
-      if (f_Eff->Eval(track.pt()) > gRandom->Uniform(0, 1)) {
-        ptArray.push_back(track.pt());
-        phiArray.push_back(track.phi());
-        indexArray.push_back(track.globalIndex());
-      }
-
-      // remove the autocorrelation
-      if (flIndex == track.globalIndex()) {
-        continue;
-      }
-
-      double DPhi = DeltaPhi(track.phi(), flPhi);
-
-      // definition of the topological regions
-      if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-        ue.fill(HIST(hPhi[0]), DPhi);
-        ue.fill(HIST(hPtVsPtLeadingData[0]), flPt, track.pt());
-        nchm_top[0]++;
-        sumptm_top[0] += track.pt();
-      } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-        ue.fill(HIST(hPhi[1]), DPhi);
-        ue.fill(HIST(hPtVsPtLeadingData[1]), flPt, track.pt());
-        nchm_top[1]++;
-        sumptm_top[1] += track.pt();
-      } else { // transverse side
-        ue.fill(HIST(hPhi[2]), DPhi);
-        ue.fill(HIST(hPtVsPtLeadingData[2]), flPt, track.pt());
-        nchm_top[2]++;
-        sumptm_top[2] += track.pt();
-      }
-    }
-  }
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_rec.push_back(1.0 * nchm_top[i_reg]);
-  }
-  for (int i_reg = 0; i_reg < 3; ++i_reg) {
-    ue_rec.push_back(sumptm_top[i_reg]);
-  }
-
-  // add flags for Vtx, PS, ev sel
-  ue.fill(HIST(pNumDenMeasuredPS[0]), flPt, ue_rec[0]);
-  ue.fill(HIST(pNumDenData[0]), flPt, ue_rec[0]);
-  ue.fill(HIST(pSumPtMeasuredPS[0]), flPt, ue_rec[3]);
-  ue.fill(HIST(pSumPtData[0]), flPt, ue_rec[3]);
-
-  ue.fill(HIST(pNumDenMeasuredPS[1]), flPt, ue_rec[1]);
-  ue.fill(HIST(pNumDenData[1]), flPt, ue_rec[1]);
-  ue.fill(HIST(pSumPtMeasuredPS[1]), flPt, ue_rec[4]);
-  ue.fill(HIST(pSumPtData[1]), flPt, ue_rec[4]);
-
-  ue.fill(HIST(pNumDenMeasuredPS[2]), flPt, ue_rec[2]);
-  ue.fill(HIST(pNumDenData[2]), flPt, ue_rec[2]);
-  ue.fill(HIST(pSumPtMeasuredPS[2]), flPt, ue_rec[5]);
-  ue.fill(HIST(pSumPtData[2]), flPt, ue_rec[5]);
-
-  ue.fill(HIST("hPtLeadingData"), flPt);
-
-  // Compute data driven (DD) missidentification correction
-  Float_t flPtdd = 0; // leading pT
-  Float_t flPhidd = 0;
-  int flIndexdd = 0;
-  int ntrkdd = ptArray.size();
-
-  for (int i = 0; i < ntrkdd; ++i) {
-    if (flPtdd < ptArray[i]) {
-      flPtdd = ptArray[i];
-      flPhidd = phiArray[i];
-      flIndexdd = indexArray[i];
-    }
-  }
-  int nchm_topdd[3];
-  double sumptm_topdd[3];
-  for (int i = 0; i < 3; ++i) {
-    nchm_topdd[i] = 0;
-    sumptm_topdd[i] = 0;
-  }
-  for (int i = 0; i < ntrkdd; ++i) {
-    if (indexArray[i] == flIndexdd) {
-      continue;
-    }
-    double DPhi = DeltaPhi(phiArray[i], flPhidd);
-    if (TMath::Abs(DPhi) < M_PI / 3.0) { // near side
-      nchm_topdd[0]++;
-      sumptm_topdd[0] += ptArray[i];
-    } else if (TMath::Abs(DPhi - M_PI) < M_PI / 3.0) { // away side
-      nchm_topdd[1]++;
-      sumptm_topdd[1] += ptArray[i];
-    } else { // transverse side
-      nchm_topdd[2]++;
-      sumptm_topdd[2] += ptArray[i];
-    }
-  }
-
-  ue.fill(HIST(hNumDenMCDd[0]), flPtdd, nchm_topdd[0]);
-  ue.fill(HIST(hSumPtMCDd[0]), flPtdd, sumptm_topdd[0]);
-
-  ue.fill(HIST(hNumDenMCDd[1]), flPtdd, nchm_topdd[1]);
-  ue.fill(HIST(hSumPtMCDd[1]), flPtdd, sumptm_topdd[1]);
-
-  ue.fill(HIST(hNumDenMCDd[2]), flPtdd, nchm_topdd[2]);
-  ue.fill(HIST(hSumPtMCDd[2]), flPtdd, sumptm_topdd[2]);
-
-  if (flIndexdd == flIndex) {
-    ue.fill(HIST(hNumDenMCMatchDd[0]), flPtdd, nchm_topdd[0]);
-    ue.fill(HIST(hSumPtMCMatchDd[0]), flPtdd, sumptm_topdd[0]);
-
-    ue.fill(HIST(hNumDenMCMatchDd[1]), flPtdd, nchm_topdd[1]);
-    ue.fill(HIST(hSumPtMCMatchDd[1]), flPtdd, sumptm_topdd[1]);
-
-    ue.fill(HIST(hNumDenMCMatchDd[2]), flPtdd, nchm_topdd[2]);
-    ue.fill(HIST(hSumPtMCMatchDd[2]), flPtdd, sumptm_topdd[2]);
-  }
-  ptArray.clear();
-  phiArray.clear();
-  indexArray.clear();
+  fillMeasured<IS_MC>(tracks, vtxZ);
 }
 TrackSelection ueCharged::myTrackSelection()
 {
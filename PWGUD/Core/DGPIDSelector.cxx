@@ -9,6 +9,8 @@
 // granted to it by virtue of its status as an Intergovernmental Organization
 // or submit itself to any jurisdiction.
 
+#include <algorithm>
+#include <cmath>
 #include "CommonConstants/PhysicsConstants.h"
 #include "DGPIDSelector.h"
 
@@ -279,6 +281,10 @@ DGParticle::DGParticle(TDatabasePDG* pdg, DGAnaparHolder anaPars, UDTracksFull c
   mtrkinds = comb;
 }
 
+DGParticle::DGParticle(TLorentzVector const& ivm, std::vector<uint> const& comb) : mIVM{ivm}, mtrkinds{comb}
+{
+}
+
 DGParticle::~DGParticle()
 {
   mtrkinds.clear();
@@ -316,6 +322,17 @@ void DGPIDSelector::init(DGAnaparHolder anaPars)
 {
   mAnaPars = anaPars;
   mIVMs.clear();
+
+  // the combinations and masses depend on the analysis parameters only
+  mCombinations.clear();
+  mMasses.clear();
+  auto pids = mAnaPars.PIDs();
+  for (auto cnt = 0; cnt < mAnaPars.nCombine(); cnt++) {
+    mMasses.push_back(particleMass(fPDG, pids[cnt]));
+  }
+  if (mAnaPars.nCombine() > 32) {
+    LOGF(fatal, "DGPIDSelector supports at most 32 particles per combination, but nCombine is %i", mAnaPars.nCombine());
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -474,31 +491,79 @@ int DGPIDSelector::computeIVMs(UDTracksFull const& tracks)
   // reset
   mIVMs.clear();
 
-  // create combinations including permutations
-  auto combs = combinations(tracks.size());
+  auto nCombine = mAnaPars.nCombine();
+  auto ntracks = tracks.size();
+  if (nCombine <= 0 || ntracks < nCombine) {
+    return 0;
+  }
+
+  // evaluate the PID cuts of every particle of a combination once per track
+  // and keep the results as bit masks
+  mTrackMasks.assign(ntracks, 0);
+  mSigns.resize(ntracks);
+  mPx.resize(ntracks);
+  mPy.resize(ntracks);
+  mPz.resize(ntracks);
+  uint32_t anyMask = 0;
+  for (auto ind = 0; ind < ntracks; ind++) {
+    auto track = tracks.rawIteratorAt(ind);
+    mSigns[ind] = track.sign();
+    mPx[ind] = track.px();
+    mPy[ind] = track.py();
+    mPz[ind] = track.pz();
+    for (auto cnt = 0; cnt < nCombine; cnt++) {
+      if (isGoodTrack(track, cnt)) {
+        mTrackMasks[ind] |= (1u << cnt);
+      }
+    }
+    anyMask |= mTrackMasks[ind];
+  }
+
+  // no combination is possible if a particle has no compatible track
+  auto fullMask = nCombine == 32 ? ~0u : (1u << nCombine) - 1u;
+  if (anyMask != fullMask) {
+    return 0;
+  }
+
+  // energies of the tracks for the mass hypotheses of all particles
+  mEnergies.resize(nCombine * ntracks);
+  for (auto cnt = 0; cnt < nCombine; cnt++) {
+    auto m2 = mMasses[cnt] * mMasses[cnt];
+    auto energies = mEnergies.data() + cnt * ntracks;
+    for (auto ind = 0; ind < ntracks; ind++) {
+      energies[ind] = std::sqrt(mPx[ind] * mPx[ind] + mPy[ind] * mPy[ind] + mPz[ind] * mPz[ind] + m2);
+    }
+  }
 
   // loop over unique combinations
-  for (auto comb : combs) {
-    // is combination compatible with netCharge requirements?
-    if (!isGoodCombination(comb, tracks)) {
+  auto netCharges = mAnaPars.netCharges();
+  for (auto const& comb : cachedCombinations(ntracks)) {
+    // are the tracks compatible with the PID requirements?
+    uint32_t combMask = 0;
+    int netCharge = 0;
+    for (auto cnt = 0; cnt < nCombine; cnt++) {
+      combMask |= mTrackMasks[comb[cnt]] & (1u << cnt);
+      netCharge += mSigns[comb[cnt]];
+    }
+    if (combMask != fullMask) {
       continue;
     }
-    // is tracks compatible with PID requirements?
-    bool isGoodComb = true;
-    auto cnt = -1;
-    for (auto ind : comb) {
-      cnt++;
-      if (!isGoodTrack(tracks.rawIteratorAt(ind), cnt)) {
-        isGoodComb = false;
-        break;
-      }
+
+    // is combination compatible with netCharge requirements?
+    if (std::find(netCharges.begin(), netCharges.end(), netCharge) == netCharges.end()) {
+      continue;
     }
 
     // update list of IVMs
-    if (isGoodComb) {
-      DGParticle IVM(fPDG, mAnaPars, tracks, comb);
-      mIVMs.push_back(IVM);
+    float px = 0., py = 0., pz = 0., e = 0.;
+    for (auto cnt = 0; cnt < nCombine; cnt++) {
+      auto ind = comb[cnt];
+      px += mPx[ind];
+      py += mPy[ind];
+      pz += mPz[ind];
+      e += mEnergies[cnt * ntracks + ind];
     }
+    mIVMs.emplace_back(TLorentzVector(px, py, pz, e), comb);
   }
 
   return mIVMs.size();
@@ -523,6 +588,17 @@ int DGPIDSelector::pid2ind(int pid)
   }
 };
 
+// -----------------------------------------------------------------------------
+// combinations of nPool tracks, computed once per number of tracks
+std::vector<std::vector<uint>> const& DGPIDSelector::cachedCombinations(int nPool)
+{
+  auto combs = mCombinations.find(nPool);
+  if (combs == mCombinations.end()) {
+    combs = mCombinations.emplace(nPool, combinations(nPool)).first;
+  }
+  return combs->second;
+}
+
 // -----------------------------------------------------------------------------
 // find selections of np out of n0
 void DGPIDSelector::combinations(int n0, std::vector<uint>& pool, int np, std::vector<uint>& inds, int n,
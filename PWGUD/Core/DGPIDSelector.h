@@ -13,6 +13,8 @@
 #define PWGUD_CORE_DGPIDSELECTOR_H_
 
 #include <gandiva/projector.h>
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 #include "TDatabasePDG.h"
@@ -160,6 +162,7 @@ struct DGParticle {
  public:
   DGParticle();
   DGParticle(TDatabasePDG* pdg, DGAnaparHolder anaPars, UDTracksFull const& tracks, std::vector<uint> comb);
+  DGParticle(TLorentzVector const& ivm, std::vector<uint> const& comb);
   ~DGParticle();
 
   // getter
@@ -211,11 +214,26 @@ struct DGPIDSelector {
   // particle properties
   TDatabasePDG* fPDG;
 
+  // masses of the particles of a combination, set in init
+  std::vector<float> mMasses;
+
+  // combinations (including permutations) per number of tracks, they only depend on mAnaPars
+  std::map<int, std::vector<std::vector<uint>>> mCombinations;
+
+  // per track quantities of the current event, filled once in computeIVMs
+  // mTrackMasks: bit cnt is set if the track passes the cuts of particle cnt
+  // mEnergies: energy of track ind with the mass of particle cnt at cnt * ntracks + ind
+  std::vector<uint32_t> mTrackMasks;
+  std::vector<int> mSigns;
+  std::vector<float> mPx, mPy, mPz;
+  std::vector<float> mEnergies;
+
   // helper functions for computeIVMs
   void combinations(int n0, std::vector<uint>& pool, int np, std::vector<uint>& inds, int n,
                     std::vector<std::vector<uint>>& combs);
   int combinations(int n0, int np, std::vector<std::vector<uint>>& combs);
   std::vector<std::vector<uint>> combinations(int nPool);
+  std::vector<std::vector<uint>> const& cachedCombinations(int nPool);
 
   // ClassDefNV(DGPIDSelector, 1);
 };
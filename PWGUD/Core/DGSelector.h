@@ -12,8 +12,9 @@
 #ifndef PWGUD_CORE_DGSELECTOR_H_
 #define PWGUD_CORE_DGSELECTOR_H_
 
+#include <algorithm>
+#include <cmath>
 #include "TDatabasePDG.h"
-#include "TLorentzVector.h"
 #include "Framework/Logger.h"
 #include "Framework/AnalysisTask.h"
 #include "PWGUD/Core/UDHelpers.h"
@@ -56,11 +57,144 @@ class DGSelector
            bc.has_foundFDD() ? udhelpers::FDDAmplitudeC(bc.foundFDD()) : -1);
       LOGF(debug, "  clean FV0A %i FT0 %i FDD %i", udhelpers::cleanFV0(bc, lims[0]), udhelpers::cleanFT0(bc, lims[1], lims[2]), udhelpers::cleanFDD(bc, lims[3], lims[4]));
 
-      if (!udhelpers::cleanFIT(bc, diffCuts.FITAmpLimits())) {
+      if (!udhelpers::cleanFIT(bc, lims)) {
         return 1;
       }
     }
 
+    return IsSelectedTracks(diffCuts, collision, tracks, fwdtracks);
+  };
+
+  // Same as above but the FIT activity of the compatible BCs is taken from the
+  // precomputed bitmasks of fitActivity. fitActivity must be built from the BCs
+  // table which bcRange is a slice of.
+  template <typename CC, typename BCs, typename TCs, typename FWs>
+  int IsSelected(DGCutparHolder diffCuts, udhelpers::FITActivity& fitActivity, CC& collision, BCs& bcRange, TCs& tracks, FWs& fwdtracks)
+  {
+    LOGF(debug, "Collision %f", collision.collisionTime());
+    LOGF(debug, "Number of close BCs: %i", bcRange.size());
+
+    // Double Gap (DG) condition
+    if (!fitActivity.isClean(bcRange, diffCuts.FITAmpLimits())) {
+      return 1;
+    }
+
+    return IsSelectedTracks(diffCuts, collision, tracks, fwdtracks);
+  };
+
+  // Function to check if BC passes DG filter (without associated collision)
+  template <typename BCs, typename TCs, typename FWs>
+  int IsSelected(DGCutparHolder diffCuts, BCs& bcRange, TCs& tracks, FWs& fwdtracks)
+  {
+    // check that there are no FIT signals in bcRange
+    // Double Gap (DG) condition
+    auto lims = diffCuts.FITAmpLimits();
+    for (auto const& bc : bcRange) {
+      if (!udhelpers::cleanFIT(bc, lims)) {
+        return 1;
+      }
+    }
+
+    return IsSelectedTracks(diffCuts, tracks, fwdtracks);
+  };
+
+  // Same as above with the FIT activity taken from fitActivity
+  template <typename BCs, typename TCs, typename FWs>
+  int IsSelected(DGCutparHolder diffCuts, udhelpers::FITActivity& fitActivity, BCs& bcRange, TCs& tracks, FWs& fwdtracks)
+  {
+    // Double Gap (DG) condition
+    if (!fitActivity.isClean(bcRange, diffCuts.FITAmpLimits())) {
+      return 1;
+    }
+
+    return IsSelectedTracks(diffCuts, tracks, fwdtracks);
+  };
+
+ private:
+  // selections of the tracks, copied once per call from the DGCutparHolder
+  struct TrackCuts {
+    explicit TrackCuts(DGCutparHolder const& diffCuts, double mass) : mass{mass}, minPt{diffCuts.minPt()}, maxPt{diffCuts.maxPt()}, minEta{diffCuts.minEta()}, maxEta{diffCuts.maxEta()} {}
+    double mass;
+    float minPt, maxPt;
+    float minEta, maxEta;
+  };
+
+  // sum of the 4-momenta and of the charges of the selected tracks
+  struct TrackSums {
+    double e = 0., px = 0., py = 0., pz = 0.;
+    int netCharge = 0;
+    double mass() const
+    {
+      auto m2 = e * e - px * px - py * py - pz * pz;
+      return m2 < 0. ? -std::sqrt(-m2) : std::sqrt(m2);
+    }
+  };
+
+  // mass of the particle hypothesis
+  double hypothesisMass(DGCutparHolder const& diffCuts)
+  {
+    TParticlePDG* pdgparticle = fPDG->GetParticle(diffCuts.pidHypothesis());
+    return pdgparticle != nullptr ? pdgparticle->Mass() : 0.;
+  }
+
+  // PID, pt, and eta of a track
+  // returns 0 and adds the track to sums if the track is accepted, else the rejection code
+  template <typename TC>
+  int selectTrack(DGCutparHolder const& diffCuts, TrackCuts const& cuts, TC const& track, TrackSums& sums)
+  {
+    // PID
+    if (!udhelpers::hasGoodPID(diffCuts, track)) {
+      return 7;
+    }
+
+    // pt
+    const double px = track.px(), py = track.py(), pz = track.pz();
+    const double pt = std::sqrt(px * px + py * py);
+    if (pt < cuts.minPt || pt > cuts.maxPt) {
+      return 8;
+    }
+
+    // eta, as TLorentzVector::Eta
+    const double eta = pt > 0. ? std::asinh(pz / pt) : (pz >= 0. ? 10e10 : -10e10);
+    if (eta < cuts.minEta || eta > cuts.maxEta) {
+      return 9;
+    }
+    sums.e += std::sqrt(pt * pt + pz * pz + cuts.mass * cuts.mass);
+    sums.px += px;
+    sums.py += py;
+    sums.pz += pz;
+    sums.netCharge += track.sign();
+    return 0;
+  }
+
+  // net charge and invariant mass of the selected tracks
+  int selectSums(DGCutparHolder const& diffCuts, TrackSums const& sums)
+  {
+    // net charge
+    auto netChargeValues = diffCuts.netCharges();
+    if (std::find(netChargeValues.begin(), netChargeValues.end(), sums.netCharge) == netChargeValues.end()) {
+      return 10;
+    }
+
+    // invariant mass
+    auto ivm = sums.mass();
+    if (ivm < diffCuts.minIVM() || ivm > diffCuts.maxIVM()) {
+      return 11;
+    }
+
+    // if we arrive here then the event is good!
+    return 0;
+  }
+
+  // track selections of a collision
+  // All tracks are evaluated in a single pass. The rejection codes are the same as
+  // when checking the selections one after the other: the first track failing the
+  // global/vertex track requirement, then the fraction of tracks with TOF hit and
+  // the number of vertex tracks, then the first vertex track failing the PID or
+  // kinematic selections.
+  template <typename CC, typename TCs, typename FWs>
+  int IsSelectedTracks(DGCutparHolder const& diffCuts, CC& collision, TCs& tracks, FWs& fwdtracks)
+  {
     // no activity in muon arm
     LOGF(debug, "FwdTracks %i", fwdtracks.size());
     for (auto& fwdtrack : fwdtracks) {
@@ -72,18 +206,32 @@ class DGSelector
 
     // no global tracks which are not vtx tracks
     // no vtx tracks which are not global tracks
+    // PID, pt, and eta of tracks, invariant mass, and net charge
+    // consider only vertex tracks
+    const bool globalTracksOnly = diffCuts.globalTracksOnly();
+    const TrackCuts cuts(diffCuts, hypothesisMass(diffCuts));
+    TrackSums sums;
+    int trackCode = 0;
     auto rgtrwTOF = 0.;
     for (auto& track : tracks) {
-      if (track.isGlobalTrack() && !track.isPVContributor()) {
+      const bool isGlobal = track.isGlobalTrack();
+      const bool isPV = track.isPVContributor();
+      if (isGlobal && !isPV) {
         return 3;
       }
-      if (diffCuts.globalTracksOnly() && !track.isGlobalTrack() && track.isPVContributor()) {
+      if (globalTracksOnly && !isGlobal && isPV) {
         return 4;
       }
+      if (!isPV) {
+        continue;
+      }
 
       // update fraction of PV tracks with TOF hit
-      if (track.isPVContributor() && track.hasTOF()) {
-        rgtrwTOF += 1.;
+      rgtrwTOF += track.hasTOF();
+
+      // the first failing vertex track defines the rejection code
+      if (trackCode == 0) {
+        trackCode = selectTrack(diffCuts, cuts, track, sums);
       }
     }
     if (collision.numContrib() > 0) {
@@ -98,68 +246,16 @@ class DGSelector
       return 6;
     }
 
-    // PID, pt, and eta of tracks, invariant mass, and net charge
-    // consider only vertex tracks
-
-    // which particle hypothesis?
-    auto mass2Use = 0.;
-    TParticlePDG* pdgparticle = fPDG->GetParticle(diffCuts.pidHypothesis());
-    if (pdgparticle != nullptr) {
-      mass2Use = pdgparticle->Mass();
+    if (trackCode != 0) {
+      return trackCode;
     }
+    return selectSums(diffCuts, sums);
+  }
 
-    auto netCharge = 0;
-    auto lvtmp = TLorentzVector();
-    auto ivm = TLorentzVector();
-    for (auto& track : tracks) {
-      if (track.isPVContributor()) {
-
-        // PID
-        if (!udhelpers::hasGoodPID(diffCuts, track)) {
-          return 7;
-        }
-
-        // pt
-        lvtmp.SetXYZM(track.px(), track.py(), track.pz(), mass2Use);
-        if (lvtmp.Perp() < diffCuts.minPt() || lvtmp.Perp() > diffCuts.maxPt()) {
-          return 8;
-        }
-
-        // eta
-        if (lvtmp.Eta() < diffCuts.minEta() || lvtmp.Eta() > diffCuts.maxEta()) {
-          return 9;
-        }
-        netCharge += track.sign();
-        ivm += lvtmp;
-      }
-    }
-
-    // net charge
-    auto netChargeValues = diffCuts.netCharges();
-    if (std::find(netChargeValues.begin(), netChargeValues.end(), netCharge) == netChargeValues.end()) {
-      return 10;
-    }
-    // invariant mass
-    if (ivm.M() < diffCuts.minIVM() || ivm.M() > diffCuts.maxIVM()) {
-      return 11;
-    }
-
-    // if we arrive here then the event is good!
-    return 0;
-  };
-
-  // Function to check if BC passes DG filter (without associated collision)
-  template <typename BCs, typename TCs, typename FWs>
-  int IsSelected(DGCutparHolder diffCuts, BCs& bcRange, TCs& tracks, FWs& fwdtracks)
+  // track selections of a BC without associated collision
+  template <typename TCs, typename FWs>
+  int IsSelectedTracks(DGCutparHolder const& diffCuts, TCs& tracks, FWs& fwdtracks)
   {
-    // check that there are no FIT signals in bcRange
-    // Double Gap (DG) condition
-    for (auto const& bc : bcRange) {
-      if (!udhelpers::cleanFIT(bc, diffCuts.FITAmpLimits())) {
-        return 1;
-      }
-    }
-
     // no activity in muon arm
     LOGF(debug, "FwdTracks %i", fwdtracks.size());
     for (auto& fwdtrack : fwdtracks) {
@@ -175,52 +271,17 @@ class DGSelector
     }
 
     // PID, pt, and eta of tracks, invariant mass, and net charge
-    // which particle hypothesis?
-    auto mass2Use = 0.;
-    TParticlePDG* pdgparticle = fPDG->GetParticle(diffCuts.pidHypothesis());
-    if (pdgparticle != nullptr) {
-      mass2Use = pdgparticle->Mass();
-    }
-
-    auto netCharge = 0;
-    auto lvtmp = TLorentzVector();
-    auto ivm = TLorentzVector();
+    const TrackCuts cuts(diffCuts, hypothesisMass(diffCuts));
+    TrackSums sums;
     for (auto& track : tracks) {
-      // PID
-      if (!udhelpers::hasGoodPID(diffCuts, track)) {
-        return 7;
-      }
-
-      // pt
-      lvtmp.SetXYZM(track.px(), track.py(), track.pz(), mass2Use);
-      if (lvtmp.Perp() < diffCuts.minPt() || lvtmp.Perp() > diffCuts.maxPt()) {
-        return 8;
-      }
-
-      // eta
-      if (lvtmp.Eta() < diffCuts.minEta() || lvtmp.Eta() > diffCuts.maxEta()) {
-        return 9;
+      auto trackCode = selectTrack(diffCuts, cuts, track, sums);
+      if (trackCode != 0) {
+        return trackCode;
       }
-      netCharge += track.sign();
-      ivm += lvtmp;
     }
+    return selectSums(diffCuts, sums);
+  }
 
-    // net charge
-    auto netChargeValues = diffCuts.netCharges();
-    if (std::find(netChargeValues.begin(), netChargeValues.end(), netCharge) == netChargeValues.end()) {
-      return 10;
-    }
-
-    // invariant mass
-    if (ivm.M() < diffCuts.minIVM() || ivm.M() > diffCuts.maxIVM()) {
-      return 11;
-    }
-
-    // if we arrive here then the event is good!
-    return 0;
-  };
-
- private:
   TDatabasePDG* fPDG;
 
   ClassDefNV(DGSelector, 1);
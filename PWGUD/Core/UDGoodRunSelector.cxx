@@ -33,6 +33,7 @@ void UDGoodRunSelector::clear()
 {
   mgoodRuns.clear();
   mrunMap.clear();
+  mgoodRunFlags.clear();
   mrnMin = -1;
   mrnMax = -1;
   misActive = false;
@@ -59,17 +60,23 @@ bool UDGoodRunSelector::isGoodRun(int runNumber)
   if (!misActive) {
     return true;
   } else {
-    return std::find(mgoodRuns.begin(), mgoodRuns.end(), runNumber) != mgoodRuns.end();
+    if (runNumber < mrnMin || runNumber > mrnMax) {
+      return false;
+    }
+    if (!mgoodRunFlags.empty()) {
+      return mgoodRunFlags[runNumber - mrnMin];
+    }
+    return std::binary_search(mgoodRuns.begin(), mgoodRuns.end(), runNumber);
   }
 }
 
-std::vector<int> UDGoodRunSelector::goodRuns(std::string runPeriod)
+std::vector<int> const& UDGoodRunSelector::goodRuns(std::string const& runPeriod)
 {
-  auto it = mrunMap.find(runPeriod.c_str());
+  auto it = mrunMap.find(runPeriod);
   if (it != mrunMap.end()) {
     return it->second;
   } else {
-    return std::vector<int>{};
+    return mnoRuns;
   }
 }
 
@@ -158,11 +165,6 @@ bool UDGoodRunSelector::init(std::string const& goodRunsFile)
       // update goodRuns and mrunMap
       for (auto& item2 : item1[itemName].GetArray()) {
         runNumber = item2.GetInt();
-        if (runNumber < mrnMin) {
-          mrnMin = runNumber;
-        } else if (runNumber > mrnMax) {
-          mrnMax = runNumber;
-        }
         mgoodRuns.push_back(runNumber);
         mrunMap[runPeriod].push_back(runNumber);
         misActive = true;
@@ -174,6 +176,18 @@ bool UDGoodRunSelector::init(std::string const& goodRunsFile)
   auto last = std::unique(mgoodRuns.begin(), mgoodRuns.end());
   mgoodRuns.erase(last, mgoodRuns.end());
 
+  // range of run numbers and flags of the good runs
+  if (!mgoodRuns.empty()) {
+    mrnMin = mgoodRuns.front();
+    mrnMax = mgoodRuns.back();
+    if (mrnMax - mrnMin < mmaxRunRange) {
+      mgoodRunFlags.assign(mrnMax - mrnMin + 1, false);
+      for (const auto& goodRun : mgoodRuns) {
+        mgoodRunFlags[goodRun - mrnMin] = true;
+      }
+    }
+  }
+
   // clean up
   fclose(fjson);
 
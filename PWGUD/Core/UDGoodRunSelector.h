@@ -32,8 +32,8 @@ struct UDGoodRunSelector {
   // getters
   void Print();
   bool isGoodRun(int runNumber);
-  std::vector<int> goodRuns() { return mgoodRuns; }
-  std::vector<int> goodRuns(std::string runPeriod);
+  std::vector<int> const& goodRuns() { return mgoodRuns; }
+  std::vector<int> const& goodRuns(std::string const& runPeriod);
   int rnumMin() { return mrnMin; }
   int rnumMax() { return mrnMax; }
 
@@ -41,8 +41,13 @@ struct UDGoodRunSelector {
   bool misActive;
   std::string mgoodRunsFile;
   int mrnMin = -1, mrnMax = -1;
-  std::vector<int> mgoodRuns;
+  std::vector<int> mgoodRuns; // sorted
   std::map<std::string, std::vector<int>> mrunMap;
+  std::vector<int> mnoRuns;
+
+  // flags of the good runs in [mrnMin, mrnMax], for a lookup without search
+  std::vector<bool> mgoodRunFlags;
+  static constexpr int mmaxRunRange = 1000000;
 };
 
 #endif // PWGUD_CORE_UDGOODRUNSELECTOR_H_
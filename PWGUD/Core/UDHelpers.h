@@ -16,6 +16,9 @@
 #ifndef PWGUD_CORE_UDHELPERS_H_
 #define PWGUD_CORE_UDHELPERS_H_
 
+#include <algorithm>
+#include <array>
+#include <utility>
 #include <vector>
 #include "Framework/Logger.h"
 #include "CommonConstants/LHCConstants.h"
@@ -204,6 +207,168 @@ T compatibleBCs(uint64_t meanBC, int deltaBC, T const& bcs)
   return compatibleBCs(bcIter, meanBC, deltaBC, bcs);
 }
 
+// -----------------------------------------------------------------------------
+// Sorted index of the BCs of a data frame.
+// The BCs table is sorted in globalBC. The globalBCs are copied once per data frame
+// into a flat array, which is binary searched for the row of a given BC and for the
+// rows of a BC window. This replaces the iterator walks of compatibleBCs and the
+// Partitions on globalBC when many lookups are done in the same data frame.
+class BCIndex
+{
+ public:
+  // fill the index with the globalBCs of bcs
+  template <typename T>
+  void build(T const& bcs)
+  {
+    build(bcs, [](auto const& bc) { return (uint64_t)bc.globalBC(); });
+  }
+
+  // fill the index with the BC numbers of any table sorted in BC, e.g. TracksWGTInBCs
+  template <typename T, typename F>
+  void build(T const& table, F&& bcOf)
+  {
+    mBCs.resize(table.size());
+    std::size_t ind = 0;
+    for (auto const& row : table) {
+      mBCs[ind++] = bcOf(row);
+    }
+    if (!std::is_sorted(mBCs.begin(), mBCs.end())) {
+      LOGF(error, "BCIndex: the table is not sorted in BC, lookups are not reliable");
+    }
+    mTable = table.asArrowTable().get();
+  }
+
+  // the process functions which are called per row receive the same tables for all rows
+  // of a data frame, this allows to build the index only once per data frame
+  template <typename T>
+  bool isBuiltFor(T const& table) const
+  {
+    return mTable == table.asArrowTable().get() && mBCs.size() == (std::size_t)table.size();
+  }
+
+  std::size_t size() const { return mBCs.size(); }
+  uint64_t bc(int64_t row) const { return mBCs[row]; }
+
+  // row with BC = bcnum, -1 if the BC is not in the table
+  int64_t find(uint64_t bcnum) const
+  {
+    auto it = std::lower_bound(mBCs.begin(), mBCs.end(), bcnum);
+    return (it != mBCs.end() && *it == bcnum) ? std::distance(mBCs.begin(), it) : -1;
+  }
+
+  // rows [first, last) with BC in [minBC, maxBC]
+  std::pair<int64_t, int64_t> range(uint64_t minBC, uint64_t maxBC) const
+  {
+    auto first = std::lower_bound(mBCs.begin(), mBCs.end(), minBC);
+    auto last = std::upper_bound(first, mBCs.end(), maxBC);
+    return {std::distance(mBCs.begin(), first), std::distance(mBCs.begin(), last)};
+  }
+
+  // slice of table with BC in [meanBC - deltaBC, meanBC + deltaBC]
+  template <typename T>
+  T slice(T const& table, uint64_t meanBC, int deltaBC) const
+  {
+    uint64_t minBC = (uint64_t)deltaBC < meanBC ? meanBC - (uint64_t)deltaBC : 0;
+    uint64_t maxBC = meanBC + (uint64_t)deltaBC;
+    auto [first, last] = range(minBC, maxBC);
+    LOGF(debug, "  BC range: %llu (%d) - %llu (%d)", minBC, first, maxBC, last - 1);
+
+    T slice{{table.asArrowTable()->Slice(first, last - first)}, (uint64_t)first};
+    table.copyIndexBindings(slice);
+    return slice;
+  }
+
+ private:
+  std::vector<uint64_t> mBCs;   // BC numbers in the order of the rows
+  const void* mTable = nullptr; // table the index was built from
+};
+
+// -----------------------------------------------------------------------------
+// Same as compatibleBCs(collision, ndt, bcs, nMinBCs) but with the BC window being
+// found in the sorted index of the BCs
+template <typename C, typename T>
+T compatibleBCs(BCIndex const& bcIndex, C const& collision, int ndt, T const& bcs, int nMinBCs = 7)
+{
+  // return if collisions has no associated BC
+  if (!collision.has_foundBC()) {
+    return T{{bcs.asArrowTable()->Slice(0, 0)}, (uint64_t)0};
+  }
+
+  // due to the filling scheme the most probable BC may not be the one estimated from the collision time
+  uint64_t mostProbableBC = bcIndex.bc(collision.foundBCId());
+  uint64_t meanBC = mostProbableBC + std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
+
+  // enforce minimum number for deltaBC
+  int deltaBC = std::ceil(collision.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * ndt);
+  if (deltaBC < nMinBCs) {
+    deltaBC = nMinBCs;
+  }
+
+  return bcIndex.slice(bcs, meanBC, deltaBC);
+}
+
+// -----------------------------------------------------------------------------
+// Same as compatibleBCs(meanBC, deltaBC, bcs) but with the BC window being found in
+// the sorted index of the BCs
+template <typename T>
+T compatibleBCs(BCIndex const& bcIndex, uint64_t meanBC, int deltaBC, T const& bcs)
+{
+  return bcIndex.slice(bcs, meanBC, deltaBC);
+}
+
+// -----------------------------------------------------------------------------
+// Track indices grouped by BC in compressed rows.
+// The (BC, track) pairs of a data frame are collected, sorted once, and the tracks
+// of the i-th BC are tracks[offsets[i], offsets[i+1]). This replaces a map of
+// vectors with one allocation per BC.
+class TracksPerBC
+{
+ public:
+  void clear()
+  {
+    mPairs.clear();
+    mBCs.clear();
+    mOffsets.clear();
+    mTracks.clear();
+  }
+
+  void add(uint64_t bcnum, int32_t track) { mPairs.emplace_back(bcnum, track); }
+
+  // sort the pairs in BC and track index and fill the compressed rows
+  void finalize()
+  {
+    std::sort(mPairs.begin(), mPairs.end());
+    mBCs.clear();
+    mOffsets.clear();
+    mTracks.resize(mPairs.size());
+    for (std::size_t ind = 0; ind < mPairs.size(); ind++) {
+      if (ind == 0 || mPairs[ind].first != mPairs[ind - 1].first) {
+        mBCs.push_back(mPairs[ind].first);
+        mOffsets.push_back(ind);
+      }
+      mTracks[ind] = mPairs[ind].second;
+    }
+    mOffsets.push_back(mPairs.size());
+  }
+
+  // number of BCs with tracks
+  std::size_t size() const { return mBCs.size(); }
+  uint64_t bc(std::size_t ind) const { return mBCs[ind]; }
+  std::size_t nTracks(std::size_t ind) const { return mOffsets[ind + 1] - mOffsets[ind]; }
+
+  // copy the tracks of the ind-th BC into tracks, which can be reused between calls
+  void tracks(std::size_t ind, std::vector<int32_t>& tracks) const
+  {
+    tracks.assign(mTracks.begin() + mOffsets[ind], mTracks.begin() + mOffsets[ind + 1]);
+  }
+
+ private:
+  std::vector<std::pair<uint64_t, int32_t>> mPairs; // (BC, track) as collected
+  std::vector<uint64_t> mBCs;                       // BCs with tracks, sorted
+  std::vector<std::size_t> mOffsets;                // first track of each BC, size() + 1 entries
+  std::vector<int32_t> mTracks;                     // tracks of all BCs
+};
+
 // -----------------------------------------------------------------------------
 // function to check if track provides good PID information
 // Checks the nSigma for any particle assumption to be within limits.
@@ -371,6 +536,117 @@ bool cleanFITCollision(T& col, std::vector<float> lims)
   }
   return (isCleanFV0 && isCleanFT0 && isCleanFDD);
 }
+// -----------------------------------------------------------------------------
+// FIT activity of the BCs of a data frame.
+// The FV0A, FT0A/C, and FDDA/C amplitudes of all BCs are summed once per data frame
+// and stored in flat arrays in the order of the BCs table. For a given set of FIT
+// amplitude limits, as given by DGCutparHolder::FITAmpLimits, every BC gets a bitmask
+// with bit i set if detector i is above its limit. The bitmasks are computed once
+// per set of limits, tasks using several cut sets keep one set of bitmasks each.
+// A window of compatible BCs is then clean if the OR of the bitmasks of its rows
+// is 0. The result is the same as checking cleanFIT for each BC of the window.
+class FITActivity
+{
+ public:
+  enum Detector {
+    kFV0A = 0,
+    kFT0A,
+    kFT0C,
+    kFDDA,
+    kFDDC,
+    kNDetectors
+  };
+
+  // sum the FIT amplitudes of all bcs
+  template <typename T>
+  void build(T const& bcs)
+  {
+    const std::size_t n = bcs.size();
+    mHasSignal.assign(n, 0);
+    for (auto& amps : mAmplitudes) {
+      amps.assign(n, 0.);
+    }
+    std::size_t ind = 0;
+    for (auto const& bc : bcs) {
+      if (bc.has_foundFV0()) {
+        mHasSignal[ind] |= 1 << kFV0A;
+        mAmplitudes[kFV0A][ind] = FV0AmplitudeA(bc.foundFV0());
+      }
+      if (bc.has_foundFT0()) {
+        mHasSignal[ind] |= (1 << kFT0A) | (1 << kFT0C);
+        mAmplitudes[kFT0A][ind] = FT0AmplitudeA(bc.foundFT0());
+        mAmplitudes[kFT0C][ind] = FT0AmplitudeC(bc.foundFT0());
+      }
+      if (bc.has_foundFDD()) {
+        mHasSignal[ind] |= (1 << kFDDA) | (1 << kFDDC);
+        mAmplitudes[kFDDA][ind] = FDDAmplitudeA(bc.foundFDD());
+        mAmplitudes[kFDDC][ind] = FDDAmplitudeC(bc.foundFDD());
+      }
+      ind++;
+    }
+    mMaskSets.clear();
+    mTable = bcs.asArrowTable().get();
+  }
+
+  // see BCIndex::isBuiltFor
+  template <typename T>
+  bool isBuiltFor(T const& bcs) const
+  {
+    return mTable == bcs.asArrowTable().get() && mHasSignal.size() == (std::size_t)bcs.size();
+  }
+
+  // OR of the activity bitmasks of the rows [first, first + n)
+  uint8_t activity(int64_t first, int64_t n, std::vector<float> const& lims)
+  {
+    const uint8_t* masks = masksFor(lims) + first;
+    uint8_t mask = 0;
+    for (int64_t ind = 0; ind < n; ind++) {
+      mask |= masks[ind];
+    }
+    return mask;
+  }
+
+  // true if all BCs of bcRange, a slice of the BCs table, have no FIT activity
+  template <typename T>
+  bool isClean(T const& bcRange, std::vector<float> const& lims)
+  {
+    if (bcRange.size() == 0) {
+      return true;
+    }
+    return activity(bcRange.begin().globalIndex(), bcRange.size(), lims) == 0;
+  }
+
+ private:
+  // bitmasks for the limits lims, computed at the first call with these limits
+  const uint8_t* masksFor(std::vector<float> const& lims)
+  {
+    for (auto const& maskSet : mMaskSets) {
+      if (maskSet.first == lims) {
+        return maskSet.second.data();
+      }
+    }
+    const std::size_t n = mHasSignal.size();
+    auto& maskSet = mMaskSets.emplace_back(lims, mHasSignal);
+    uint8_t* masks = maskSet.second.data();
+    for (int det = 0; det < kNDetectors; det++) {
+      const float* amps = mAmplitudes[det].data();
+      const float lim = lims[det];
+      const uint8_t otherBits = ~(uint8_t)(1 << det);
+      for (std::size_t ind = 0; ind < n; ind++) {
+        masks[ind] &= otherBits | (uint8_t)(!(amps[ind] < lim) << det);
+      }
+    }
+    return masks;
+  }
+
+  std::array<std::vector<float>, kNDetectors> mAmplitudes; // summed amplitudes, [detector][BC]
+  std::vector<uint8_t> mHasSignal;                         // bit i set if detector i has a signal in the BC
+  const void* mTable = nullptr;                            // table the arrays were built from
+
+  // (limits, bitmasks) per set of limits, bit i set if detector i is above its limit in the BC
+  std::vector<std::pair<std::vector<float>, std::vector<uint8_t>>> mMaskSets;
+};
+
 // -----------------------------------------------------------------------------
 template <typename T>
 bool cleanZDC(T const& bc, aod::Zdcs& zdcs, std::vector<float>& lims)
@@ -46,6 +46,11 @@ struct tracksWGTInBCs {
   Preslice<aod::AmbiguousTracks> perTrack = aod::ambiguous::trackId;
   Preslice<aod::AmbiguousFwdTracks> perFwdTrack = aod::ambiguous::fwdtrackId;
 
+  // sorted BC index and tracks grouped by BC, reused for all data frames
+  udhelpers::BCIndex bcIndex;
+  udhelpers::TracksPerBC tracksPerBC;
+  std::vector<int32_t> trackIds;
+
   void init(InitContext& context)
   {
     if (context.mOptions.get<bool>("processBarrel")) {
@@ -62,10 +67,10 @@ struct tracksWGTInBCs {
     int rnum = bcs.iteratorAt(0).runNumber();
 
     // container to sort tracks with good timing according to their matching/closest BC
-    std::map<uint64_t, std::vector<int32_t>> tracksInBCList{};
+    tracksPerBC.clear();
     uint64_t closestBC = 0;
 
-    // loop over all tracks and fill tracksInBCList
+    // loop over all tracks and fill tracksPerBC
     for (auto const& track : tracks) {
       registry.get<TH1>(HIST("barrelTracks"))->Fill(0., 1.);
       auto ambTracksSlice = ambTracks.sliceBy(perTrack, track.globalIndex());
@@ -95,32 +100,20 @@ struct tracksWGTInBCs {
           closestBC = track.collision_as<CCs>().foundBC_as<BCs>().globalBC();
         }
 
-        // update tracksInBCList
-        tracksInBCList[closestBC].emplace_back((int32_t)track.globalIndex());
+        // update tracksPerBC
+        tracksPerBC.add(closestBC, (int32_t)track.globalIndex());
       }
     }
+    tracksPerBC.finalize();
 
     // fill tracksWGTInBCs
-    int indBCToStart = 0;
-    int indBCToSave;
-    for (auto const& tracksInBC : tracksInBCList) {
-      indBCToSave = -1;
-      if (tracksInBC.second.size() > 0) {
-        // find corresponding BC
-        for (auto ind = indBCToStart; ind < bcs.size(); ind++) {
-          auto bc = bcs.rawIteratorAt(ind);
-          if (bc.globalBC() == tracksInBC.first) {
-            indBCToSave = ind;
-            indBCToStart = ind;
-            break;
-          }
-          if (bc.globalBC() > tracksInBC.first) {
-            break;
-          }
-        }
-        tracksWGTInBCs(indBCToSave, rnum, tracksInBC.first, tracksInBC.second);
-        LOGF(debug, " BC %i/%u with %i tracks with good timing", indBCToSave, tracksInBC.first, tracksInBC.second.size());
-      }
+    bcIndex.build(bcs);
+    for (std::size_t ind = 0; ind < tracksPerBC.size(); ind++) {
+      // find corresponding BC
+      auto indBCToSave = bcIndex.find(tracksPerBC.bc(ind));
+      tracksPerBC.tracks(ind, trackIds);
+      tracksWGTInBCs(indBCToSave, rnum, tracksPerBC.bc(ind), trackIds);
+      LOGF(debug, " BC %i/%u with %i tracks with good timing", indBCToSave, tracksPerBC.bc(ind), trackIds.size());
     }
   }
   PROCESS_SWITCH(tracksWGTInBCs, processBarrel, "Process barrel tracks", true);
@@ -131,10 +124,10 @@ struct tracksWGTInBCs {
     int rnum = bcs.iteratorAt(0).runNumber();
 
     // container to sort forward tracks according to their matching/closest BC
-    std::map<uint64_t, std::vector<int32_t>> fwdTracksWGTInBCList{};
+    tracksPerBC.clear();
     uint64_t closestBC = 0;
 
-    // loop over all forward tracks and fill fwdTracksWGTInBCList
+    // loop over all forward tracks and fill tracksPerBC
     for (auto const& fwdTrack : fwdTracks) {
       registry.get<TH1>(HIST("forwardTracks"))->Fill(0., 1.);
       auto ambFwdTracksSlice = ambFwdTracks.sliceBy(perFwdTrack, fwdTrack.globalIndex());
@@ -165,32 +158,20 @@ struct tracksWGTInBCs {
           closestBC = fwdTrack.collision_as<CCs>().bc_as<BCs>().globalBC();
         }
 
-        // update tracksInBCList
-        fwdTracksWGTInBCList[closestBC].emplace_back((int32_t)fwdTrack.globalIndex());
+        // update tracksPerBC
+        tracksPerBC.add(closestBC, (int32_t)fwdTrack.globalIndex());
       }
     }
+    tracksPerBC.finalize();
 
     // fill fwdTracksWGTInBCs
-    int indBCToStart = 0;
-    int indBCToSave;
-    for (auto const& fwdTracksWGTInBC : fwdTracksWGTInBCList) {
-      indBCToSave = -1;
-      if (fwdTracksWGTInBC.second.size() > 0) {
-        // find corresponding BC
-        for (auto ind = indBCToStart; ind < bcs.size(); ind++) {
-          auto bc = bcs.rawIteratorAt(ind);
-          if (bc.globalBC() == fwdTracksWGTInBC.first) {
-            indBCToSave = ind;
-            indBCToStart = ind;
-            break;
-          }
-          if (bc.globalBC() > fwdTracksWGTInBC.first) {
-            break;
-          }
-        }
-        fwdTracksWGTInBCs(indBCToSave, rnum, fwdTracksWGTInBC.first, fwdTracksWGTInBC.second);
-        LOGF(debug, " BC %i/%u with %i forward tracks with good timing", indBCToSave, fwdTracksWGTInBC.first, fwdTracksWGTInBC.second.size());
-      }
+    bcIndex.build(bcs);
+    for (std::size_t ind = 0; ind < tracksPerBC.size(); ind++) {
+      // find corresponding BC
+      auto indBCToSave = bcIndex.find(tracksPerBC.bc(ind));
+      tracksPerBC.tracks(ind, trackIds);
+      fwdTracksWGTInBCs(indBCToSave, rnum, tracksPerBC.bc(ind), trackIds);
+      LOGF(debug, " BC %i/%u with %i forward tracks with good timing", indBCToSave, tracksPerBC.bc(ind), trackIds.size());
     }
   }
   PROCESS_SWITCH(tracksWGTInBCs, processForward, "Process forward tracks", true);
@@ -236,6 +217,11 @@ struct DGBCCandProducer {
   Preslice<TIBCs> TIBCperBC = aod::dgbcandidate::bcId;
   Preslice<FTIBCs> FTIBCperBC = aod::dgbcandidate::bcId;
 
+  // sorted indices of the BCs and of the FTIBCs, and FIT activity of the BCs, built once per data frame
+  udhelpers::BCIndex bcIndex;
+  udhelpers::BCIndex ftibcIndex;
+  udhelpers::FITActivity fitActivity;
+
   // fill BB and BG information into FITInfo
   template <typename BCR>
   void fillBGBBFlags(upchelpers::FITInfo& info, uint64_t const& minbc, BCR const& bcrange)
@@ -275,12 +261,11 @@ struct DGBCCandProducer {
     uint64_t minbc = bcnum > 15 ? bcnum - 15 : 0;
 
     // find bc with globalBC = bcnum
-    Partition<BCs> selbc = aod::bc::globalBC == bcnum;
-    selbc.bindTable(bcs);
+    auto indBC = bcIndex.find(bcnum);
 
     // if BC exists then update FIT information for this BC
-    if (selbc.size() > 0) {
-      auto bc = bcs.iteratorAt(selbc.begin().globalIndex());
+    if (indBC >= 0) {
+      auto bc = bcs.iteratorAt(indBC);
 
       // FT0
       if (bc.has_foundFT0()) {
@@ -329,13 +314,10 @@ struct DGBCCandProducer {
         }
         info.triggerMaskFDD = fdd.triggerMask();
       }
-
-      auto bcrange = udhelpers::compatibleBCs(bc, bcnum, 15, bcs);
-      fillBGBBFlags(info, minbc, bcrange);
-    } else {
-      auto bcrange = udhelpers::compatibleBCs(bcnum, 15, bcs);
-      fillBGBBFlags(info, minbc, bcrange);
     }
+
+    auto bcrange = udhelpers::compatibleBCs(bcIndex, bcnum, 15, bcs);
+    fillBGBBFlags(info, minbc, bcrange);
     return info;
   }
 
@@ -422,6 +404,15 @@ struct DGBCCandProducer {
                     TCs const& tracks, aod::FwdTracks const& fwdtracks, FTIBCs const& ftibcs,
                     aod::Zdcs const& zdcs, aod::FT0s const& ft0s, aod::FV0As const& fv0as, aod::FDDs const& fdds)
   {
+    // processTable is called per TIBC, update the indices only for a new data frame
+    if (!bcIndex.isBuiltFor(bcs)) {
+      bcIndex.build(bcs);
+      fitActivity.build(bcs);
+    }
+    if (!ftibcIndex.isBuiltFor(ftibcs)) {
+      ftibcIndex.build(ftibcs, [](auto const& ftibc) { return (uint64_t)ftibc.bcnum(); });
+    }
+
     // fill FITInfo
     auto bcnum = tibc.bcnum();
     upchelpers::FITInfo fitInfo = getFITinfo(bcnum, bcs, ft0s, fv0as, fdds);
@@ -447,8 +438,8 @@ struct DGBCCandProducer {
         auto col = colSlize.rawIteratorAt(0);
         auto colTracks = tracks.sliceBy(TCperCollision, col.globalIndex());
         auto colFwdTracks = fwdtracks.sliceBy(FWperCollision, col.globalIndex());
-        auto bcRange = udhelpers::compatibleBCs(col, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
-        isDG = dgSelector.IsSelected(diffCuts, col, bcRange, colTracks, colFwdTracks);
+        auto bcRange = udhelpers::compatibleBCs(bcIndex, col, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+        isDG = dgSelector.IsSelected(diffCuts, fitActivity, col, bcRange, colTracks, colFwdTracks);
 
         // update UDTables
         if (isDG == 0) {
@@ -479,21 +470,21 @@ struct DGBCCandProducer {
       } else {
         LOGF(debug, "  2. BC has NO collision");
         auto tracksArray = tibc.track_as<TCs>();
-        auto bcRange = udhelpers::compatibleBCs(bc, bc.globalBC(), diffCuts.minNBCs(), bcs);
+        auto bcRange = udhelpers::compatibleBCs(bcIndex, bc.globalBC(), diffCuts.minNBCs(), bcs);
 
         // does BC have fwdTracks?
         if (ftibcs.size() > 0) {
           auto ftibcSlice = ftibcs.sliceBy(FTIBCperBC, bc.globalIndex());
           if (ftibcSlice.size() > 0) {
             auto fwdTracksArray = ftibcSlice.begin().fwdtrack_as<FTCs>();
-            isDG = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+            isDG = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
           } else {
             auto fwdTracksArray = FTCs{{fwdtracks.asArrowTable()->Slice(0, 0)}, (uint64_t)0};
-            isDG = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+            isDG = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
           }
         } else {
           auto fwdTracksArray = FTCs{{fwdtracks.asArrowTable()->Slice(0, 0)}, (uint64_t)0};
-          isDG = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+          isDG = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
         }
 
         // update UDTables
@@ -526,23 +517,21 @@ struct DGBCCandProducer {
 
       // the BC is not contained in the BCs table
       auto tracksArray = tibc.track_as<TCs>();
-      auto bcRange = udhelpers::compatibleBCs(bcnum, diffCuts.minNBCs(), bcs);
+      auto bcRange = udhelpers::compatibleBCs(bcIndex, bcnum, diffCuts.minNBCs(), bcs);
 
       // does BC have fwdTracks?
       if (ftibcs.size() > 0) {
-        Partition<FTIBCs> ftibcPart = aod::dgbcandidate::bcnum == bcnum;
-        ftibcPart.bindTable(ftibcs);
-
-        if (ftibcPart.size() > 0) {
-          auto fwdTracksArray = ftibcPart.begin().fwdtrack_as<FTCs>();
-          isDG = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+        auto indFTIBC = ftibcIndex.find(bcnum);
+        if (indFTIBC >= 0) {
+          auto fwdTracksArray = ftibcs.iteratorAt(indFTIBC).fwdtrack_as<FTCs>();
+          isDG = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
         } else {
           auto fwdTracksArray = FTCs{{fwdtracks.asArrowTable()->Slice(0, 0)}, (uint64_t)0};
-          isDG = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+          isDG = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
         }
       } else {
         auto fwdTracksArray = FTCs{{fwdtracks.asArrowTable()->Slice(0, 0)}, (uint64_t)0};
-        isDG = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+        isDG = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
       }
 
       // update UDTables
@@ -593,6 +582,8 @@ struct DGBCCandProducer {
     if (bcs.size() <= 0) {
       return;
     }
+    bcIndex.build(bcs);
+    fitActivity.build(bcs);
 
     // run over globalBC [minGlobalBC, maxGlobalBC] ...
     uint64_t minGlobalBC = bcs.iteratorAt(0).globalBC();
@@ -630,8 +621,8 @@ struct DGBCCandProducer {
           ntr1 = col.numContrib();
           auto colTracks = tracks.sliceBy(TCperCollision, col.globalIndex());
           auto colFwdTracks = fwdtracks.sliceBy(FWperCollision, col.globalIndex());
-          auto bcRange = udhelpers::compatibleBCs(col, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
-          isDG1 = dgSelector.IsSelected(diffCuts, col, bcRange, colTracks, colFwdTracks);
+          auto bcRange = udhelpers::compatibleBCs(bcIndex, col, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+          isDG1 = dgSelector.IsSelected(diffCuts, fitActivity, col, bcRange, colTracks, colFwdTracks);
           if (isDG1 == 0) {
             // this is a DG candidate with proper collision vertex
             SETBIT(bcFlag, 3);
@@ -653,7 +644,7 @@ struct DGBCCandProducer {
       if (tibc.bcnum() == bcnum) {
         SETBIT(bcFlag, 4);
 
-        auto bcRange = udhelpers::compatibleBCs(bc, bcnum, diffCuts.minNBCs(), bcs);
+        auto bcRange = udhelpers::compatibleBCs(bcIndex, bcnum, diffCuts.minNBCs(), bcs);
         auto tracksArray = tibc.track_as<TCs>();
         ntr2 = tracksArray.size();
 
@@ -663,10 +654,10 @@ struct DGBCCandProducer {
         }
         if (ftibc.bcnum() == bcnum) {
           auto fwdTracksArray = ftibc.fwdtrack_as<FTCs>();
-          isDG2 = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+          isDG2 = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
         } else {
           auto fwdTracksArray = FTCs{{fwdtracks.asArrowTable()->Slice(0, 0)}, (uint64_t)0};
-          isDG2 = dgSelector.IsSelected(diffCuts, bcRange, tracksArray, fwdTracksArray);
+          isDG2 = dgSelector.IsSelected(diffCuts, fitActivity, bcRange, tracksArray, fwdTracksArray);
         }
         if (isDG2 == 0) {
           // this is a DG candidate with tracks-in-BC
@@ -106,6 +106,11 @@ struct DGCandProducer {
                           aod::TOFSignal, aod::pidTOFFullEl, aod::pidTOFFullMu, aod::pidTOFFullPi, aod::pidTOFFullKa, aod::pidTOFFullPr>;
   using MCTC = MCTCs::iterator;
 
+  // sorted index and FIT activity of the BCs, the process functions are called per
+  // collision and both are built once per data frame
+  udhelpers::BCIndex bcIndex;
+  udhelpers::FITActivity fitActivity;
+
   // extract FIT information
   upchelpers::FITInfo getFITinfo(uint64_t const& bcnum, BCs const& bcs, aod::FT0s const& ft0s, aod::FV0As const& fv0as, aod::FDDs const& fdds)
   {
@@ -113,12 +118,11 @@ struct DGCandProducer {
     upchelpers::FITInfo info{};
 
     // find bc with globalBC = bcnum
-    Partition<BCs> selbc = aod::bc::globalBC == bcnum;
-    selbc.bindTable(bcs);
+    auto indBC = bcIndex.find(bcnum);
 
     // if BC exists then update FIT information for this BC
-    if (selbc.size() > 0) {
-      auto bc = selbc.begin();
+    if (indBC >= 0) {
+      auto bc = bcs.iteratorAt(indBC);
 
       // FT0
       if (bc.has_foundFT0()) {
@@ -324,10 +328,14 @@ struct DGCandProducer {
     auto bc = collision.bc_as<BCs>();
 
     // obtain slice of compatible BCs
-    auto bcRange = udhelpers::compatibleBCs(collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+    if (!bcIndex.isBuiltFor(bcs)) {
+      bcIndex.build(bcs);
+      fitActivity.build(bcs);
+    }
+    auto bcRange = udhelpers::compatibleBCs(bcIndex, collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
 
     // apply DG selection
-    auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bcRange, tracks, fwdtracks);
+    auto isDGEvent = dgSelector.IsSelected(diffCuts, fitActivity, collision, bcRange, tracks, fwdtracks);
 
     // save DG candidates
     if (isDGEvent == 0) {
@@ -398,6 +406,10 @@ struct DGCandProducer {
 
     // MC BC
     auto mcbc = McCol.bc_as<BCs>();
+    if (!bcIndex.isBuiltFor(bcs)) {
+      bcIndex.build(bcs);
+      fitActivity.build(bcs);
+    }
 
     // save MCTruth of all diffractive events
     bool mcColIsSaved = false;
@@ -421,10 +433,10 @@ struct DGCandProducer {
 
       // is this a collision to be saved?
       // obtain slice of compatible BCs
-      auto bcRange = udhelpers::MCcompatibleBCs(collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+      auto bcRange = udhelpers::compatibleBCs(bcIndex, collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
 
       // apply DG selection
-      auto isDGEvent = dgSelector.IsSelected(diffCuts, collision, bcRange, collisionTracks, collisionFwdTracks);
+      auto isDGEvent = dgSelector.IsSelected(diffCuts, fitActivity, collision, bcRange, collisionTracks, collisionFwdTracks);
       LOGF(debug, "  isDG %i", (int)isDGEvent);
 
       // save information of DG events
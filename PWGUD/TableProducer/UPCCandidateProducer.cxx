@@ -127,31 +127,40 @@ struct UpcCandProducerQa {
 
   void process(o2::aod::Collisions const& collisions, BarrelTracks const& tracks, o2::aod::AmbiguousTracks const& ambTracks)
   {
-    std::unordered_set<int64_t> ambTrIds;
+    // flags of ambiguous tracks, indexed by track ID
+    fIsAmbiguous.assign(tracks.size(), 0);
     for (const auto& ambTrk : ambTracks) {
-      auto trkId = ambTrk.trackId();
-      ambTrIds.insert(trkId);
+      fIsAmbiguous[ambTrk.trackId()] = 1;
     }
 
     for (const auto& track : tracks) {
       int32_t nContrib = -1;
-      if (ambTrIds.find(track.globalIndex()) == ambTrIds.end()) {
+      if (!fIsAmbiguous[track.globalIndex()]) {
         const auto& col = track.collision();
         nContrib = col.numContrib();
       }
       updateBarrelTrackQA(track, nContrib);
     }
-
-    ambTrIds.clear();
   }
+
+  std::vector<uint8_t> fIsAmbiguous; // per-dataframe scratch, kept to reuse the allocation
 };
 
 struct UpcCandProducer {
   bool fDoMC{false};
 
-  std::map<int32_t, int32_t> fNewPartIDs;
   uint64_t fMaxBC{0}; // max BC for ITS-TPC search
 
+  // per-dataframe scratch
+  // tracks and MC particles are contiguous in a dataframe, hence the ID maps are dense
+  // arrays sized from the table lengths. They are kept as members to reuse the allocations
+  std::vector<int32_t> fNewPartIDs;                       // MC particle ID -> new MC particle ID, -1 if not stored
+  std::vector<int64_t> fAmbBarrelTrIds;                   // barrel track ID -> index in amb. track table, -1 if not ambiguous
+  std::vector<int64_t> fAmbFwdTrIds;                      // forward track ID -> index in amb. track table, -1 if not ambiguous
+  std::vector<std::pair<uint64_t, int64_t>> fTrIdsTOF;    // (BC, track ID) of collected TOF tracks
+  std::vector<std::pair<uint64_t, int64_t>> fTrIdsITSTPC; // (BC, track ID) of collected ITS-TPC tracks
+  std::vector<std::pair<uint64_t, int64_t>> fTrIdsMID;    // (BC, track ID) of collected MID tracks
+
   Produces<o2::aod::UDMcCollisions> udMCCollisions;
   Produces<o2::aod::UDMcParticles> udMCParticles;
 
@@ -311,6 +320,7 @@ struct UpcCandProducer {
     int32_t newPartID = 0;
     int32_t newEventID = 0;
     int32_t nMCParticles = mcParticles.size();
+    fNewPartIDs.assign(nMCParticles, -1);
     // loop over MC particles to select only the ones from signal events
     // and calculate new MC table IDs
     for (int32_t mcPartID = 0; mcPartID < nMCParticles; mcPartID++) {
@@ -330,8 +340,10 @@ struct UpcCandProducer {
     }
 
     // storing MC particles
-    for (const auto& item : fNewPartIDs) {
-      int32_t mcPartID = item.first;
+    for (int32_t mcPartID = 0; mcPartID < nMCParticles; mcPartID++) {
+      if (fNewPartIDs[mcPartID] == -1) {
+        continue;
+      }
       const auto& mcPart = mcParticles.iteratorAt(mcPartID);
       int32_t mcEventID = mcPart.mcCollisionId();
       int32_t newEventID = newEventIDs[mcEventID];
@@ -343,9 +355,9 @@ struct UpcCandProducer {
         if (motherID >= nMCParticles) {
           continue;
         }
-        auto it = fNewPartIDs.find(motherID);
-        if (it != fNewPartIDs.end()) {
-          newMotherIDs.push_back(it->second);
+        int32_t newMotherID = getNewPartID(motherID);
+        if (newMotherID != -1) {
+          newMotherIDs.push_back(newMotherID);
         }
       }
       // collecting new daughter IDs
@@ -357,11 +369,11 @@ struct UpcCandProducer {
         if (firstDaughter >= nMCParticles || lastDaughter >= nMCParticles) {
           continue;
         }
-        auto itFirst = fNewPartIDs.find(firstDaughter);
-        auto itLast = fNewPartIDs.find(lastDaughter);
-        if (itFirst != fNewPartIDs.end() && itLast != fNewPartIDs.end()) {
-          newDaughterIDs[0] = fNewPartIDs.at(daughterIDs.front());
-          newDaughterIDs[1] = fNewPartIDs.at(daughterIDs.back());
+        int32_t newFirst = getNewPartID(firstDaughter);
+        int32_t newLast = getNewPartID(lastDaughter);
+        if (newFirst != -1 && newLast != -1) {
+          newDaughterIDs[0] = newFirst;
+          newDaughterIDs[1] = newLast;
         }
       }
       udMCParticles(newEventID, mcPart.pdgCode(), mcPart.statusCode(), mcPart.flags(), newMotherIDs, newDaughterIDs,
@@ -382,6 +394,15 @@ struct UpcCandProducer {
     newEventIDs.clear();
   }
 
+  // new ID of a stored MC particle, -1 for particles which are not stored and for invalid IDs
+  int32_t getNewPartID(int32_t mcPartID) const
+  {
+    if (mcPartID < 0 || mcPartID >= static_cast<int32_t>(fNewPartIDs.size())) {
+      return -1;
+    }
+    return fNewPartIDs[mcPartID];
+  }
+
   template <typename TTrack, typename TAmbTracks>
   uint64_t getTrackBC(TTrack track,
                       TAmbTracks const& ambTracks,
@@ -420,10 +441,9 @@ struct UpcCandProducer {
       if (fDoMC) {
         const auto& label = mcTrackLabels->iteratorAt(trackID);
         uint16_t mcMask = label.mcMask();
-        auto it = fNewPartIDs.find(label.mcParticleId());
         // signal tracks should always have an MC particle
         // background tracks have label == -1
-        int32_t newPartID = it != fNewPartIDs.end() ? it->second : -1;
+        int32_t newPartID = getNewPartID(label.mcParticleId());
         udFwdTrackLabels(newPartID, mcMask);
       }
     }
@@ -434,13 +454,13 @@ struct UpcCandProducer {
                         int32_t candID,
                         uint64_t bc,
                         const o2::aod::McTrackLabels* mcTrackLabels,
-                        std::unordered_map<int64_t, int64_t>& ambBarrelTrIds)
+                        std::vector<int64_t> const& ambBarrelTrIds)
   {
     for (auto trackID : trackIDs) {
       const auto& track = tracks.iteratorAt(trackID);
       double trTime = track.trackTime() - std::round(track.trackTime() / o2::constants::lhc::LHCBunchSpacingNS) * o2::constants::lhc::LHCBunchSpacingNS;
       int64_t colId = -1;
-      if (ambBarrelTrIds.find(trackID) == ambBarrelTrIds.end()) {
+      if (ambBarrelTrIds[trackID] == -1) {
         colId = track.collisionId();
       }
       udTracks(candID, track.px(), track.py(), track.pz(), track.sign(), bc, trTime, track.trackTimeRes());
@@ -455,11 +475,9 @@ struct UpcCandProducer {
       if (fDoMC) {
         const auto& label = mcTrackLabels->iteratorAt(trackID);
         uint16_t mcMask = label.mcMask();
-        int32_t mcPartID = label.mcParticleId();
-        auto it = fNewPartIDs.find(mcPartID);
         // signal tracks should always have an MC particle
         // background tracks have label == -1
-        int32_t newPartID = it != fNewPartIDs.end() ? it->second : -1;
+        int32_t newPartID = getNewPartID(label.mcParticleId());
         udTrackLabels(newPartID, mcMask);
       }
     }
@@ -592,23 +610,28 @@ struct UpcCandProducer {
   }
 
   template <int32_t tracksSwitch, typename TAmbTracks>
-  void collectAmbTracks(std::unordered_map<int64_t, int64_t>& ambTrIds,
+  void collectAmbTracks(std::vector<int64_t>& ambTrIds,
+                        int64_t nTracks,
                         TAmbTracks const& ambTracks)
   {
+    ambTrIds.assign(nTracks, -1);
     for (const auto& ambTrk : ambTracks) {
       auto trkId = getAmbTrackId<tracksSwitch>(ambTrk);
       ambTrIds[trkId] = ambTrk.globalIndex();
     }
   }
 
-  void addTrack(std::vector<BCTracksPair>& v, uint64_t bc, int64_t trkId)
+  // group the collected (BC, track ID) pairs by BC
+  // v is sorted in BC, the tracks of a BC are in the order of the track IDs
+  void groupTracks(std::vector<std::pair<uint64_t, int64_t>>& trIds, std::vector<BCTracksPair>& v)
   {
-    auto it = std::find_if(v.begin(), v.end(),
-                           [bc](const BCTracksPair& element) { return element.first == bc; });
-    if (it != v.end())
-      it->second.push_back(trkId);
-    else
-      v.emplace_back(std::make_pair(bc, std::vector<int64_t>({trkId})));
+    std::sort(trIds.begin(), trIds.end());
+    for (std::size_t i = 0; i < trIds.size(); i++) {
+      if (i == 0 || trIds[i].first != trIds[i - 1].first)
+        v.emplace_back(trIds[i].first, std::vector<int64_t>{});
+      v.back().second.push_back(trIds[i].second);
+    }
+    trIds.clear();
   }
 
   void collectBarrelTracks(std::vector<BCTracksPair>& bcsMatchedTrIdsTOF,
@@ -617,31 +640,33 @@ struct UpcCandProducer {
                            o2::aod::Collisions const& collisions,
                            BarrelTracks const& barrelTracks,
                            o2::aod::AmbiguousTracks const& ambBarrelTracks,
-                           std::unordered_map<int64_t, int64_t>& ambBarrelTrIds)
+                           std::vector<int64_t> const& ambBarrelTrIds)
   {
+    fTrIdsTOF.clear();
+    fTrIdsITSTPC.clear();
     for (const auto& trk : barrelTracks) {
       if (!applyBarCuts(trk))
         continue;
       int64_t trkId = trk.globalIndex();
       int64_t ambTrId = -1;
       int32_t nContrib = -1;
-      auto ambIter = ambBarrelTrIds.find(trkId);
-      if (ambIter == ambBarrelTrIds.end()) {
+      ambTrId = ambBarrelTrIds[trkId];
+      if (ambTrId == -1) {
         const auto& col = trk.collision();
         nContrib = col.numContrib();
-      } else {
-        ambTrId = ambIter->second;
       }
       uint64_t bc = getTrackBC(trk, ambBarrelTracks, ambTrId, collisions, bcs);
       if (bc > fMaxBC)
         continue;
       if (!upcCuts.getRequireITSTPC() && trk.hasTOF() && nContrib <= upcCuts.getMaxNContrib())
-        addTrack(bcsMatchedTrIdsTOF, bc, trkId);
+        fTrIdsTOF.emplace_back(bc, trkId);
       if (upcCuts.getRequireITSTPC() && trk.hasTOF() && trk.hasITS() && trk.hasTPC() && nContrib <= upcCuts.getMaxNContrib())
-        addTrack(bcsMatchedTrIdsTOF, bc, trkId);
+        fTrIdsTOF.emplace_back(bc, trkId);
       if (fSearchITSTPC == 1 && !trk.hasTOF() && trk.hasITS() && trk.hasTPC())
-        addTrack(bcsMatchedTrIdsITSTPC, bc, trkId);
+        fTrIdsITSTPC.emplace_back(bc, trkId);
     }
+    groupTracks(fTrIdsTOF, bcsMatchedTrIdsTOF);
+    groupTracks(fTrIdsITSTPC, bcsMatchedTrIdsITSTPC);
   }
 
   void collectForwardTracks(std::vector<BCTracksPair>& bcsMatchedTrIdsMID,
@@ -649,28 +674,28 @@ struct UpcCandProducer {
                             o2::aod::Collisions const& collisions,
                             ForwardTracks const& fwdTracks,
                             o2::aod::AmbiguousFwdTracks const& ambFwdTracks,
-                            std::unordered_map<int64_t, int64_t>& ambFwdTrIds)
+                            std::vector<int64_t> const& ambFwdTrIds)
   {
+    fTrIdsMID.clear();
     for (const auto& trk : fwdTracks) {
       if (!applyFwdCuts(trk))
         continue;
       int64_t trkId = trk.globalIndex();
       int64_t ambTrId = -1;
       int32_t nContrib = -1;
-      auto ambIter = ambFwdTrIds.find(trkId);
-      if (ambIter == ambFwdTrIds.end()) {
+      ambTrId = ambFwdTrIds[trkId];
+      if (ambTrId == -1) {
         const auto& col = trk.collision();
         nContrib = col.numContrib();
-      } else {
-        ambTrId = ambIter->second;
       }
       uint64_t bc = getTrackBC(trk, ambFwdTracks, ambTrId, collisions, bcs);
       if (bc > fMaxBC)
         continue;
       auto trkType = trk.trackType();
       if (trkType == o2::aod::fwdtrack::ForwardTrackTypeEnum::MuonStandaloneTrack && nContrib <= upcCuts.getMaxNContrib())
-        addTrack(bcsMatchedTrIdsMID, bc, trkId);
+        fTrIdsMID.emplace_back(bc, trkId);
     }
+    groupTracks(fTrIdsMID, bcsMatchedTrIdsMID);
   }
 
   int32_t searchTracks(uint64_t midbc, uint64_t range, uint32_t tracksToFind,
@@ -720,20 +745,15 @@ struct UpcCandProducer {
     std::vector<BCTracksPair> bcsMatchedTrIdsITSTPC;
 
     // trackID -> index in amb. track table
-    std::unordered_map<int64_t, int64_t> ambBarrelTrIds;
-    collectAmbTracks<0>(ambBarrelTrIds, ambBarrelTracks);
+    collectAmbTracks<0>(fAmbBarrelTrIds, barrelTracks.size(), ambBarrelTracks);
 
+    // both lists are sorted in BC
     collectBarrelTracks(bcsMatchedTrIdsTOF, bcsMatchedTrIdsITSTPC,
                         bcs, collisions,
-                        barrelTracks, ambBarrelTracks, ambBarrelTrIds);
+                        barrelTracks, ambBarrelTracks, fAmbBarrelTrIds);
 
     uint32_t nBCsWithITSTPC = bcsMatchedTrIdsITSTPC.size();
 
-    std::sort(bcsMatchedTrIdsTOF.begin(), bcsMatchedTrIdsTOF.end(),
-              [](const auto& left, const auto& right) { return left.first < right.first; });
-    std::sort(bcsMatchedTrIdsITSTPC.begin(), bcsMatchedTrIdsITSTPC.end(),
-              [](const auto& left, const auto& right) { return left.first < right.first; });
-
     if (nBCsWithITSTPC > 0 && fSearchITSTPC == 1) {
       for (auto& pair : bcsMatchedTrIdsTOF) {
         uint64_t bc = pair.first;
@@ -806,7 +826,7 @@ struct UpcCandProducer {
       }
       RgtrwTOF = RgtrwTOF / static_cast<float>(numContrib);
       // store used tracks
-      fillBarrelTracks(barrelTracks, barrelTrackIDs, candID, bc, mcBarrelTrackLabels, ambBarrelTrIds);
+      fillBarrelTracks(barrelTracks, barrelTrackIDs, candID, bc, mcBarrelTrackLabels, fAmbBarrelTrIds);
       eventCandidates(bc, runNumber, dummyX, dummyY, dummyZ, numContrib, netCharge, RgtrwTOF);
       eventCandidatesSels(fitInfo.ampFT0A, fitInfo.ampFT0C, fitInfo.timeFT0A, fitInfo.timeFT0C, fitInfo.triggerMaskFT0,
                           fitInfo.ampFDDA, fitInfo.ampFDDC, fitInfo.timeFDDA, fitInfo.timeFDDC, fitInfo.triggerMaskFDD,
@@ -818,7 +838,6 @@ struct UpcCandProducer {
     }
 
     indexBCglId.clear();
-    ambBarrelTrIds.clear();
     bcsMatchedTrIdsTOF.clear();
   }
 
@@ -842,46 +861,36 @@ struct UpcCandProducer {
     std::vector<BCTracksPair> bcsMatchedTrIdsMID;
 
     // trackID -> index in amb. track table
-    std::unordered_map<int64_t, int64_t> ambBarrelTrIds;
-    collectAmbTracks<0>(ambBarrelTrIds, ambBarrelTracks);
-
-    std::unordered_map<int64_t, int64_t> ambFwdTrIds;
-    collectAmbTracks<1>(ambFwdTrIds, ambFwdTracks);
+    collectAmbTracks<0>(fAmbBarrelTrIds, barrelTracks.size(), ambBarrelTracks);
+    collectAmbTracks<1>(fAmbFwdTrIds, fwdTracks.size(), ambFwdTracks);
 
+    // all lists are sorted in BC
     collectForwardTracks(bcsMatchedTrIdsMID,
                          bcs, collisions,
-                         fwdTracks, ambFwdTracks, ambFwdTrIds);
+                         fwdTracks, ambFwdTracks, fAmbFwdTrIds);
 
     collectBarrelTracks(bcsMatchedTrIdsTOF, bcsMatchedTrIdsITSTPC,
                         bcs, collisions,
-                        barrelTracks, ambBarrelTracks, ambBarrelTrIds);
+                        barrelTracks, ambBarrelTracks, fAmbBarrelTrIds);
 
     uint32_t nBCsWithITSTPC = bcsMatchedTrIdsITSTPC.size();
     uint32_t nBCsWithMID = bcsMatchedTrIdsMID.size();
 
-    // tag TOF tracks to MID tracks
-    std::unordered_set<uint64_t> bcsWithMID;
-    for (const auto& pair : bcsMatchedTrIdsMID) {
-      bcsWithMID.insert(pair.first);
-    }
-
+    // tag TOF tracks to MID tracks: merge of the two sorted lists
     std::vector<BCTracksPair> bcsMatchedTrIdsTOFTagged;
     bcsMatchedTrIdsTOFTagged.reserve(nBCsWithMID);
-    for (const auto& pair : bcsMatchedTrIdsTOF) {
-      if (bcsWithMID.find(pair.first) != bcsWithMID.end())
-        bcsMatchedTrIdsTOFTagged.emplace_back(pair);
+    auto itMID = bcsMatchedTrIdsMID.begin();
+    for (auto& pair : bcsMatchedTrIdsTOF) {
+      while (itMID != bcsMatchedTrIdsMID.end() && itMID->first < pair.first)
+        ++itMID;
+      if (itMID == bcsMatchedTrIdsMID.end())
+        break;
+      if (itMID->first == pair.first)
+        bcsMatchedTrIdsTOFTagged.emplace_back(std::move(pair));
     }
 
-    bcsWithMID.clear();
     bcsMatchedTrIdsTOF.clear();
 
-    std::sort(bcsMatchedTrIdsTOFTagged.begin(), bcsMatchedTrIdsTOFTagged.end(),
-              [](const auto& left, const auto& right) { return left.first < right.first; });
-    std::sort(bcsMatchedTrIdsITSTPC.begin(), bcsMatchedTrIdsITSTPC.end(),
-              [](const auto& left, const auto& right) { return left.first < right.first; });
-    std::sort(bcsMatchedTrIdsMID.begin(), bcsMatchedTrIdsMID.end(),
-              [](const auto& left, const auto& right) { return left.first < right.first; });
-
     if (nBCsWithITSTPC > 0 && fSearchITSTPC == 1) {
       for (uint32_t ibc = 0; ibc < nBCsWithMID; ++ibc) {
         auto& pairMID = bcsMatchedTrIdsMID[ibc];
@@ -964,7 +973,7 @@ struct UpcCandProducer {
       RgtrwTOF = RgtrwTOF / static_cast<float>(numContrib);
       // store used tracks
       fillFwdTracks(fwdTracks, fwdTrackIDs, candID, bc, mcFwdTrackLabels);
-      fillBarrelTracks(barrelTracks, barrelTrackIDs, candID, bc, mcBarrelTrackLabels, ambBarrelTrIds);
+      fillBarrelTracks(barrelTracks, barrelTrackIDs, candID, bc, mcBarrelTrackLabels, fAmbBarrelTrIds);
       eventCandidates(bc, runNumber, dummyX, dummyY, dummyZ, numContrib, netCharge, RgtrwTOF);
       eventCandidatesSels(fitInfo.ampFT0A, fitInfo.ampFT0C, fitInfo.timeFT0A, fitInfo.timeFT0C, fitInfo.triggerMaskFT0,
                           fitInfo.ampFDDA, fitInfo.ampFDDC, fitInfo.timeFDDA, fitInfo.timeFDDC, fitInfo.triggerMaskFDD,
@@ -976,9 +985,7 @@ struct UpcCandProducer {
     }
 
     indexBCglId.clear();
-    ambFwdTrIds.clear();
     bcsMatchedTrIdsMID.clear();
-    ambBarrelTrIds.clear();
     bcsMatchedTrIdsTOFTagged.clear();
   }
 
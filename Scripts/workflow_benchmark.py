@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+
+# Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+# See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+# All rights not expressly granted are reserved.
+#
+# This software is distributed under the terms of the GNU General Public
+# License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+#
+# In applying this license CERN does not waive the privileges and immunities
+# granted to it by virtue of its status as an Intergovernmental Organization
+# or submit itself to any jurisdiction.
+
+"""
+Script to benchmark chains of analysis workflows on reference AO2D samples.
+The chains and samples are defined in a JSON file (see workflow_benchmark_chains.json):
+each chain is a list of workflows, with their options, piped together and run on the
+AO2D slices of a sample. The checksums of the samples are verified before running, so
+that the numbers of two reports refer to the same input.
+For each chain and sample the report records the wall time, the CPU time and peak RSS
+of the processes, the per-device metrics of the DPL resource monitoring when available
+and the size of the output files. The report is written in JSON and can be compared
+with the report of a baseline, a chain slower than the tolerance makes the script exit
+with a non-zero code.
+Example:
+  ./workflow_benchmark.py --chains workflow_benchmark_chains.json --report today.json --baseline yesterday.json
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import resource
+import shutil
+import subprocess
+import sys
+import time
+
+
+def sha256(path):
+    """
+    Returns the SHA-256 checksum of the file in 'path'
+    """
+    digest = hashlib.sha256()
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 20), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def check_sample(sample, base_dir):
+    """
+    Returns the paths of the AO2D files of the sample, after verifying their checksums
+    """
+    paths = []
+    for entry in sample["files"]:
+        path = os.path.join(base_dir, entry["path"])
+        if not os.path.isfile(path):
+            raise FileNotFoundError(f"Missing file {path} of sample {sample['name']}")
+        if "sha256" in entry and sha256(path) != entry["sha256"]:
+            raise ValueError(f"Checksum mismatch for {path} of sample {sample['name']}, version {sample.get('version', '?')}")
+        paths.append(os.path.abspath(path))
+    return paths
+
+
+def build_command(chain, aod_files, monitoring_interval):
+    """
+    Builds the shell command piping the workflows of the chain
+    """
+    commands = []
+    for i, workflow in enumerate(chain["workflows"]):
+        command = [workflow["name"], "-b"] + workflow.get("options", [])
+        if i == 0:
+            command += ["--aod-file", "@input_files.txt"]
+            if monitoring_interval > 0:
+                command += ["--resources-monitoring", str(monitoring_interval)]
+        commands.append(" ".join(command))
+    return " | ".join(commands), aod_files
+
+
+def read_device_metrics(run_dir):
+    """
+    Returns the per-device CPU and memory metrics of the DPL resource monitoring, if written
+    """
+    path = os.path.join(run_dir, "performanceMetrics.json")
+    if not os.path.isfile(path):
+        return {}
+    with open(path) as f:
+        metrics = json.load(f)
+    devices = {}
+    for device, values in metrics.items():
+        summary = {}
+        for key, name in (("cpuUsageFraction", "cpu_fraction"), ("proportionalSetSize", "pss_kb"), ("resident-set-size", "rss_kb")):
+            if key in values:
+                series = [float(v["value"]) for v in values[key] if "value" in v]
+                if series:
+                    summary[f"{name}_max"] = max(series)
+                    summary[f"{name}_mean"] = sum(series) / len(series)
+        devices[device] = summary
+    return devices
+
+
+def run_chain(chain, sample_name, aod_files, work_dir, monitoring_interval, verbose):
+    """
+    Runs the chain in its own directory and returns its measurements
+    """
+    run_dir = os.path.join(work_dir, f"{chain['name']}_{sample_name}")
+    shutil.rmtree(run_dir, ignore_errors=True)
+    os.makedirs(run_dir)
+    with open(os.path.join(run_dir, "input_files.txt"), "w") as f:
+        f.write("\n".join(aod_files) + "\n")
+    for config in chain.get("configurations", []):
+        shutil.copy(config, run_dir)
+    command, _ = build_command(chain, aod_files, monitoring_interval)
+    if verbose:
+        print("Running", command, "in", run_dir)
+
+    usage_before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    start = time.monotonic()
+    with open(os.path.join(run_dir, "log.txt"), "w") as log:
+        process = subprocess.run(command, shell=True, cwd=run_dir, stdout=log, stderr=subprocess.STDOUT)
+    wall_time = time.monotonic() - start
+    usage_after = resource.getrusage(resource.RUSAGE_CHILDREN)
+
+    outputs = {}
+    for name in sorted(os.listdir(run_dir)):
+        if name.endswith(".root"):
+            outputs[name] = os.path.getsize(os.path.join(run_dir, name))
+    return {
+        "chain": chain["name"],
+        "sample": sample_name,
+        "return_code": process.returncode,
+        "wall_time_s": wall_time,
+        "user_cpu_s": usage_after.ru_utime - usage_before.ru_utime,
+        "system_cpu_s": usage_after.ru_stime - usage_before.ru_stime,
+        # ru_maxrss is the peak of the largest process run so far, in kB on Linux
+        "peak_rss_kb": usage_after.ru_maxrss,
+        "devices": read_device_metrics(run_dir),
+        "output_bytes": outputs,
+    }
+
+
+def compare(report, baseline, tolerance):
+    """
+    Prints the relative change of the wall and CPU times with respect to the baseline,
+    returns the number of chains slower than the tolerance
+    """
+    reference = {(r["chain"], r["sample"]): r for r in baseline["results"]}
+    n_slower = 0
+    for result in report["results"]:
+        key = (result["chain"], result["sample"])
+        if key not in reference:
+            print(f"{key[0]} on {key[1]}: not in the baseline")
+            continue
+        ref = reference[key]
+        cpu = result["user_cpu_s"] + result["system_cpu_s"]
+        ref_cpu = ref["user_cpu_s"] + ref["system_cpu_s"]
+        wall_change = result["wall_time_s"] / ref["wall_time_s"] - 1.0 if ref["wall_time_s"] > 0 else 0.0
+        cpu_change = cpu / ref_cpu - 1.0 if ref_cpu > 0 else 0.0
+        rss_change = result["peak_rss_kb"] / ref["peak_rss_kb"] - 1.0 if ref["peak_rss_kb"] > 0 else 0.0
+        slower = cpu_change > tolerance
+        n_slower += slower
+        print(f"{key[0]} on {key[1]}: wall {wall_change:+.1%}, CPU {cpu_change:+.1%}, peak RSS {rss_change:+.1%}" + (" SLOWER" if slower else ""))
+    return n_slower
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark of analysis workflow chains on reference AO2D samples")
+    parser.add_argument("--chains", required=True, help="JSON file with the chains and samples")
+    parser.add_argument("--samples-dir", default=".", help="Directory of the sample files, their paths are relative to it")
+    parser.add_argument("--work-dir", default="workflow_benchmark", help="Directory of the runs")
+    parser.add_argument("--report", default="workflow_benchmark_report.json", help="Output report")
+    parser.add_argument("--baseline", default=None, help="Report to compare with")
+    parser.add_argument("--tolerance", type=float, default=0.1, help="Relative CPU time increase above which a chain is slower than the baseline")
+    parser.add_argument("--only", nargs="*", default=None, help="Names of the chains to run, all if not given")
+    parser.add_argument("--resources-monitoring", type=int, default=1, help="Interval in s of the DPL resource monitoring, 0 to disable it")
+    parser.add_argument("--verbose", "-v", action="store_true", help="Verbose mode")
+    args = parser.parse_args()
+
+    with open(args.chains) as f:
+        definitions = json.load(f)
+    samples = {s["name"]: s for s in definitions["samples"]}
+
+    os.makedirs(args.work_dir, exist_ok=True)
+    results = []
+    for chain in definitions["chains"]:
+        if args.only is not None and chain["name"] not in args.only:
+            continue
+        for sample_name in chain["samples"]:
+            aod_files = check_sample(samples[sample_name], args.samples_dir)
+            result = run_chain(chain, sample_name, aod_files, args.work_dir, args.resources_monitoring, args.verbose)
+            print(f"{chain['name']} on {sample_name}: {result['wall_time_s']:.1f} s wall, {result['user_cpu_s'] + result['system_cpu_s']:.1f} s CPU, {result['peak_rss_kb'] / 1024:.0f} MB peak RSS, return code {result['return_code']}")
+            results.append(result)
+
+    report = {
+        "date": time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime()),
+        "host": os.uname().nodename,
+        "samples": {name: samples[name].get("version", "") for name in {r["sample"] for r in results}},
+        "results": results,
+    }
+    with open(args.report, "w") as f:
+        json.dump(report, f, indent=2)
+
+    failed = sum(r["return_code"] != 0 for r in results)
+    n_slower = 0
+    if args.baseline is not None:
+        with open(args.baseline) as f:
+            n_slower = compare(report, json.load(f), args.tolerance)
+    if failed or n_slower:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -22,6 +22,7 @@
 
 #include <string>
 #include <array>
+#include <vector>
 
 namespace pidml_pt_cuts
 {
@@ -47,7 +48,7 @@ using namespace pidml_pt_cuts;
 using namespace o2::framework;
 
 struct PidONNXInterface {
-  PidONNXInterface(std::string& localPath, std::string& ccdbPath, bool useCCDB, o2::ccdb::CcdbApi& ccdbApi, uint64_t timestamp, std::vector<int> const& pids, LabeledArray<double> const& pTLimits, std::vector<double> const& minCertainties, bool autoMode) : mNPids{pids.size()}, mPTLimits{pTLimits}
+  PidONNXInterface(std::string& localPath, std::string& ccdbPath, bool useCCDB, o2::ccdb::CcdbApi& ccdbApi, uint64_t timestamp, std::vector<int> const& pids, LabeledArray<double> const& pTLimits, std::vector<double> const& minCertainties, bool autoMode, o2::common::OnnxSessionConfig const& sessionConfig = {}) : mNPids{pids.size()}, mPTLimits{pTLimits}
   {
     if (pids.size() == 0) {
       LOG(fatal) << "PID ML Interface needs at least 1 output pid to predict";
@@ -70,7 +71,7 @@ struct PidONNXInterface {
     }
     for (std::size_t i = 0; i < mNPids; i++) {
       for (uint32_t j = 0; j < kNDetectors; j++) {
-        mModels.emplace_back(localPath, ccdbPath, useCCDB, ccdbApi, timestamp, pids[i], (PidMLDetector)(kTPCOnly + j), minCertaintiesFilled[i]);
+        mModels.emplace_back(localPath, ccdbPath, useCCDB, ccdbApi, timestamp, pids[i], (PidMLDetector)(kTPCOnly + j), minCertaintiesFilled[i], sessionConfig);
       }
     }
   }
@@ -113,6 +114,70 @@ struct PidONNXInterface {
     return false;
   }
 
+  /// Evaluates the model selected by the pT of each track for all the tracks at once:
+  /// tracks are accumulated per model and each model runs a single batched inference.
+  /// \param tracks Tracks of interest
+  /// \param pid Expected pid
+  /// \param certainties Output, one certainty per track in the order of the tracks (-1 if no model is found)
+  template <typename T>
+  void applyModel(const T& tracks, int pid, std::vector<float>& certainties)
+  {
+    certainties.assign(tracks.size(), -1.0f);
+    std::size_t iPid = 0;
+    while (iPid < mNPids && mModels[iPid * kNDetectors].mPid != pid) {
+      iPid++;
+    }
+    if (iPid == mNPids) {
+      LOG(error) << "No suitable PID ML model found for expected pid: " << pid;
+      return;
+    }
+
+    mModelOfTrack.assign(tracks.size(), -1);
+    std::size_t iTrack = 0;
+    for (auto const& track : tracks) {
+      for (uint32_t j = 0; j < kNDetectors; j++) {
+        if (track.pt() >= mPTLimits[iPid][j] && (j == kNDetectors - 1 || track.pt() < mPTLimits[iPid][j + 1])) {
+          mModels[iPid * kNDetectors + j].addToBatch(track);
+          mModelOfTrack[iTrack] = j;
+          break;
+        }
+      }
+      iTrack++;
+    }
+
+    for (uint32_t j = 0; j < kNDetectors; j++) {
+      mBatchCertainties[j].clear();
+      mModels[iPid * kNDetectors + j].evaluateBatch(mBatchCertainties[j]);
+    }
+    // Scatter back the certainties: each model returns them in the order the tracks were added
+    std::array<std::size_t, kNDetectors> next{};
+    for (std::size_t i = 0; i < mModelOfTrack.size(); i++) {
+      const int j = mModelOfTrack[i];
+      if (j >= 0 && next[j] < mBatchCertainties[j].size()) {
+        certainties[i] = mBatchCertainties[j][next[j]++];
+      }
+    }
+  }
+
+  /// Batched version of applyModelBoolean, see applyModel
+  template <typename T>
+  void applyModelBoolean(const T& tracks, int pid, std::vector<bool>& accepted)
+  {
+    applyModel(tracks, pid, mCertainties);
+    accepted.assign(mCertainties.size(), false);
+    std::size_t iPid = 0;
+    while (iPid < mNPids && mModels[iPid * kNDetectors].mPid != pid) {
+      iPid++;
+    }
+    if (iPid == mNPids) {
+      return;
+    }
+    for (std::size_t i = 0; i < mCertainties.size(); i++) {
+      const int j = mModelOfTrack[i];
+      accepted[i] = j >= 0 && mCertainties[i] >= mModels[iPid * kNDetectors + j].mMinCertainty;
+    }
+  }
+
  private:
   void fillDefaultConfiguration(std::vector<double>& minCertainties)
   {
@@ -124,5 +189,10 @@ struct PidONNXInterface {
   std::vector<PidONNXModel> mModels;
   std::size_t mNPids;
   LabeledArray<double> mPTLimits;
+
+  // Buffers of the batched evaluation
+  std::vector<int> mModelOfTrack;
+  std::array<std::vector<float>, kNDetectors> mBatchCertainties;
+  std::vector<float> mCertainties;
 };
 #endif // O2_ANALYSIS_PIDONNXINTERFACE_H_
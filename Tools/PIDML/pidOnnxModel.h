@@ -20,9 +20,15 @@
 #include "CCDB/CcdbApi.h"
 
 #include <onnxruntime/core/session/experimental_onnxruntime_cxx_api.h>
+#include "Common/Core/OnnxSessionConfig.h"
 #include <rapidjson/document.h>
 #include <rapidjson/filereadstream.h>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 enum PidMLDetector {
   kTPCOnly = 0,
@@ -51,18 +57,54 @@ bool readJsonFile(const std::string& config, rapidjson::Document& d)
 }
 } // namespace
 
-struct PidONNXModel {
+/// \brief Process-wide registry of the ONNX sessions: each model is loaded once per process and shared by all its users.
+/// Sessions are keyed by model file, timestamp of the CCDB object and session options.
+class PidONNXSessionRegistry
+{
  public:
-  PidONNXModel(std::string& localPath, std::string& ccdbPath, bool useCCDB, o2::ccdb::CcdbApi& ccdbApi, uint64_t timestamp, int pid, PidMLDetector detector, double minCertainty) : mDetector(detector), mPid(pid), mMinCertainty(minCertainty)
+  static PidONNXSessionRegistry& instance()
   {
-    std::string modelFile;
-    loadInputFiles(localPath, ccdbPath, useCCDB, ccdbApi, timestamp, pid, modelFile);
+    static PidONNXSessionRegistry registry;
+    return registry;
+  }
+
+  std::shared_ptr<Ort::Env> getEnv() const { return mEnv; }
 
-    Ort::SessionOptions sessionOptions;
-    mEnv = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "pid-onnx-inferer");
+  std::shared_ptr<Ort::Experimental::Session> getSession(std::string const& modelFile, uint64_t timestamp, o2::common::OnnxSessionConfig const& sessionConfig)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& session = mSessions[modelFile + "@" + std::to_string(timestamp) + "#" + sessionConfig.key()];
+    if (auto existing = session.lock()) {
+      LOG(info) << "Reusing ONNX model loaded from file: " << modelFile;
+      return existing;
+    }
+    Ort::SessionOptions sessionOptions = sessionConfig.makeSessionOptions();
     LOG(info) << "Loading ONNX model from file: " << modelFile;
-    mSession.reset(new Ort::Experimental::Session{*mEnv, modelFile, sessionOptions});
+    std::string modelPath = modelFile;
+    auto created = std::make_shared<Ort::Experimental::Session>(*mEnv, modelPath, sessionOptions);
     LOG(info) << "ONNX model loaded";
+    session = created;
+    return created;
+  }
+
+ private:
+  PidONNXSessionRegistry() = default;
+
+  std::shared_ptr<Ort::Env> mEnv = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "pid-onnx-inferer");
+  std::map<std::string, std::weak_ptr<Ort::Experimental::Session>> mSessions;
+  std::mutex mMutex;
+};
+
+struct PidONNXModel {
+ public:
+  PidONNXModel(std::string& localPath, std::string& ccdbPath, bool useCCDB, o2::ccdb::CcdbApi& ccdbApi, uint64_t timestamp, int pid, PidMLDetector detector, double minCertainty, o2::common::OnnxSessionConfig const& sessionConfig = {}) : mDetector(detector), mPid(pid), mMinCertainty(minCertainty)
+  {
+    std::string modelFile;
+    loadInputFiles(localPath, ccdbPath, useCCDB, ccdbApi, timestamp, pid, sessionConfig, modelFile);
+    fillScalingCache();
+
+    mEnv = PidONNXSessionRegistry::instance().getEnv();
+    mSession = PidONNXSessionRegistry::instance().getSession(modelFile, useCCDB ? timestamp : 0, sessionConfig);
 
     mInputNames = mSession->GetInputNames();
     mInputShapes = mSession->GetInputShapes();
@@ -101,6 +143,47 @@ struct PidONNXModel {
     return getModelOutput(track) >= mMinCertainty;
   }
 
+  /// Batching front-end: tracks are accumulated with addToBatch and evaluated together by evaluateBatch
+  template <typename T>
+  void addToBatch(const T& track)
+  {
+    appendInputs(track, mBatchInputs);
+    mNBatched++;
+  }
+
+  std::size_t getBatchSize() const { return mNBatched; }
+
+  /// Evaluates all the accumulated tracks in one inference call (one call per track if the model has a fixed batch dimension).
+  /// The certainties are appended to the output in the order the tracks were added, the batch is emptied.
+  void evaluateBatch(std::vector<float>& certainties)
+  {
+    if (mNBatched == 0) {
+      return;
+    }
+    const int64_t nInputs = mBatchInputs.size() / mNBatched;
+    const bool dynamicBatch = mInputShapes[0][0] < 0;
+    const int64_t rowsPerRun = dynamicBatch ? mNBatched : 1;
+    std::vector<int64_t> inputShape{rowsPerRun, nInputs};
+
+    certainties.reserve(certainties.size() + mNBatched);
+    try {
+      for (std::size_t first = 0; first < mNBatched; first += rowsPerRun) {
+        std::vector<Ort::Value> inputTensors;
+        inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(mBatchInputs.data() + first * nInputs, rowsPerRun * nInputs, inputShape));
+        auto outputTensors = mSession->Run(mInputNames, inputTensors, mOutputNames);
+        const float* outputValues = outputTensors[0].GetTensorData<float>();
+        const int64_t outputStride = outputTensors[0].GetTensorTypeAndShapeInfo().GetElementCount() / rowsPerRun;
+        for (int64_t i = 0; i < rowsPerRun; i++) {
+          certainties.push_back(sigmoid(outputValues[i * outputStride])); // FIXME: Temporary, sigmoid will be added as network layer
+        }
+      }
+    } catch (const Ort::Exception& exception) {
+      LOG(error) << "Error running model inference: " << exception.what();
+    }
+    mBatchInputs.clear();
+    mNBatched = 0;
+  }
+
   PidMLDetector mDetector;
   int mPid;
   double mMinCertainty;
@@ -138,7 +221,8 @@ struct PidONNXModel {
     }
   }
 
-  void loadInputFiles(std::string const& localPath, std::string const& ccdbPath, bool useCCDB, o2::ccdb::CcdbApi& ccdbApi, uint64_t timestamp, int pid, std::string& modelPath)
+  /// The model file is the one of the model variant of the session configuration, if any
+  void loadInputFiles(std::string const& localPath, std::string const& ccdbPath, bool useCCDB, o2::ccdb::CcdbApi& ccdbApi, uint64_t timestamp, int pid, o2::common::OnnxSessionConfig const& sessionConfig, std::string& modelPath)
   {
     rapidjson::Document trainColumnsDoc;
     rapidjson::Document scalingParamsDoc;
@@ -147,6 +231,8 @@ struct PidONNXModel {
     std::string trainColumnsFile = "columns_for_training";
     std::string scalingParamsFile = "scaling_params";
     getModelPaths(localPath, localDir, localModelFile, modelPath, pid, ".onnx");
+    localModelFile = sessionConfig.variantPath(localModelFile);
+    modelPath = sessionConfig.variantPath(modelPath);
     std::string localTrainColumnsPath = localDir + "/" + trainColumnsFile + ".json";
     std::string localScalingParamsPath = localDir + "/" + scalingParamsFile + ".json";
 
@@ -155,7 +241,7 @@ struct PidONNXModel {
       getModelPaths(ccdbPath, ccdbDir, ccdbModelFile, ccdbModelPath, pid, "");
       std::string ccdbTrainColumnsPath = ccdbDir + "/" + trainColumnsFile;
       std::string ccdbScalingParamsPath = ccdbDir + "/" + scalingParamsFile;
-      downloadFromCCDB(ccdbApi, ccdbModelPath, timestamp, localDir, localModelFile);
+      downloadFromCCDB(ccdbApi, sessionConfig.variantPath(ccdbModelPath), timestamp, localDir, localModelFile);
       downloadFromCCDB(ccdbApi, ccdbTrainColumnsPath, timestamp, localDir, "columns_for_training.json");
       downloadFromCCDB(ccdbApi, ccdbScalingParamsPath, timestamp, localDir, "scaling_params.json");
     }
@@ -173,38 +259,54 @@ struct PidONNXModel {
     }
   }
 
+  // Indices of the scaled input variables in mScaling
+  enum ScaledInput {
+    kX = 0,
+    kY,
+    kZ,
+    kAlpha,
+    kTPCNClsShared,
+    kDcaXY,
+    kDcaZ,
+    kTPCSignal,
+    kTOFSignal,
+    kBeta,
+    kTRDSignal,
+    kTRDPattern,
+    kNScaledInputs
+  };
+
+  // Caches the scaling parameters of the inputs, so that they are not searched by name for every track
+  void fillScalingCache()
+  {
+    static const std::array<std::string, kNScaledInputs> names = {"fX", "fY", "fZ", "fAlpha", "fTPCNClsShared", "fDcaXY", "fDcaZ", "fTPCSignal", "fTOFSignal", "fBeta", "fTRDSignal", "fTRDPattern"};
+    const int nUsed = mDetector >= kTPCTOFTRD ? kNScaledInputs : (mDetector >= kTPCTOF ? kTRDSignal : kTOFSignal);
+    for (int i = 0; i < nUsed; i++) {
+      mScaling[i] = mScalingParams.at(names[i]);
+    }
+  }
+
+  float scale(float value, ScaledInput input) const { return (value - mScaling[input].first) / mScaling[input].second; }
+
   template <typename T>
-  std::vector<float> createInputsSingle(const T& track)
+  void appendInputs(const T& track, std::vector<float>& inputValues)
   {
     // TODO: Hardcoded for now. Planning to implement RowView extension to get runtime access to selected columns
     // sign is short, trackType and tpcNClsShared uint8_t
-    float scaledX = (track.x() - mScalingParams.at("fX").first) / mScalingParams.at("fX").second;
-    float scaledY = (track.y() - mScalingParams.at("fY").first) / mScalingParams.at("fY").second;
-    float scaledZ = (track.z() - mScalingParams.at("fZ").first) / mScalingParams.at("fZ").second;
-    float scaledAlpha = (track.alpha() - mScalingParams.at("fAlpha").first) / mScalingParams.at("fAlpha").second;
-    float scaledTPCNClsShared = ((float)track.tpcNClsShared() - mScalingParams.at("fTPCNClsShared").first) / mScalingParams.at("fTPCNClsShared").second;
-    float scaledDcaXY = (track.dcaXY() - mScalingParams.at("fDcaXY").first) / mScalingParams.at("fDcaXY").second;
-    float scaledDcaZ = (track.dcaZ() - mScalingParams.at("fDcaZ").first) / mScalingParams.at("fDcaZ").second;
-
-    float scaledTPCSignal = (track.tpcSignal() - mScalingParams.at("fTPCSignal").first) / mScalingParams.at("fTPCSignal").second;
-
-    std::vector<float> inputValues{track.px(), track.py(), track.pz(), (float)track.sign(), scaledX, scaledY, scaledZ, scaledAlpha, (float)track.trackType(), scaledTPCNClsShared, scaledDcaXY, scaledDcaZ, track.p(), scaledTPCSignal};
+    inputValues.insert(inputValues.end(), {track.px(), track.py(), track.pz(), (float)track.sign(),
+                                           scale(track.x(), kX), scale(track.y(), kY), scale(track.z(), kZ), scale(track.alpha(), kAlpha),
+                                           (float)track.trackType(), scale((float)track.tpcNClsShared(), kTPCNClsShared),
+                                           scale(track.dcaXY(), kDcaXY), scale(track.dcaZ(), kDcaZ), track.p(), scale(track.tpcSignal(), kTPCSignal)});
 
     if (mDetector >= kTPCTOF) {
-      float scaledTOFSignal = (track.tofSignal() - mScalingParams.at("fTOFSignal").first) / mScalingParams.at("fTOFSignal").second;
-      float scaledBeta = (track.beta() - mScalingParams.at("fBeta").first) / mScalingParams.at("fBeta").second;
-      inputValues.push_back(scaledTOFSignal);
-      inputValues.push_back(scaledBeta);
+      inputValues.push_back(scale(track.tofSignal(), kTOFSignal));
+      inputValues.push_back(scale(track.beta(), kBeta));
     }
 
     if (mDetector >= kTPCTOFTRD) {
-      float scaledTRDSignal = (track.trdSignal() - mScalingParams.at("fTRDSignal").first) / mScalingParams.at("fTRDSignal").second;
-      float scaledTRDPattern = (track.trdPattern() - mScalingParams.at("fTRDPattern").first) / mScalingParams.at("fTRDPattern").second;
-      inputValues.push_back(scaledTRDSignal);
-      inputValues.push_back(scaledTRDPattern);
+      inputValues.push_back(scale(track.trdSignal(), kTRDSignal));
+      inputValues.push_back(scale(track.trdPattern(), kTRDPattern));
     }
-
-    return inputValues;
   }
 
   // FIXME: Temporary solution, new networks will have sigmoid layer added
@@ -218,9 +320,10 @@ struct PidONNXModel {
   float getModelOutput(const T& track)
   {
     auto input_shape = mInputShapes[0];
-    std::vector<float> inputTensorValues = createInputsSingle(track);
+    mSingleInputs.clear();
+    appendInputs(track, mSingleInputs);
     std::vector<Ort::Value> inputTensors;
-    inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(inputTensorValues.data(), inputTensorValues.size(), input_shape));
+    inputTensors.emplace_back(Ort::Experimental::Value::CreateTensor<float>(mSingleInputs.data(), mSingleInputs.size(), input_shape));
 
     // Double-check the dimensions of the input tensor
     assert(inputTensors[0].IsTensor() &&
@@ -256,7 +359,14 @@ struct PidONNXModel {
 
   std::vector<std::string> mTrainColumns;
   std::map<std::string, std::pair<float, float>> mScalingParams;
+  std::array<std::pair<float, float>, kNScaledInputs> mScaling{};
+
+  // Input buffers, reused across tracks
+  std::vector<float> mSingleInputs;
+  std::vector<float> mBatchInputs;
+  std::size_t mNBatched = 0;
 
+  // Shared with the other users of the same model, see PidONNXSessionRegistry
   std::shared_ptr<Ort::Env> mEnv = nullptr;
   // No empty constructors for Session, we need a pointer
   std::shared_ptr<Ort::Experimental::Session> mSession = nullptr;
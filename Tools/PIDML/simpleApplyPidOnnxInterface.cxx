@@ -53,6 +53,13 @@ struct SimpleApplyOnnxInterface {
 
   Configurable<bool> cfgUseFixedTimestamp{"use-fixed-timestamp", false, "Whether to use fixed timestamp from configurable instead of timestamp calculated from the data"};
   Configurable<uint64_t> cfgTimestamp{"timestamp", 1524176895000, "Hardcoded timestamp for tests"};
+  Configurable<int> cfgIntraOpNumThreads{"intraOpNumThreads", 0, "Number of threads used by ONNX runtime inside one inference call (0: ONNX runtime default)"};
+  Configurable<int> cfgOptimizationLevel{"optimizationLevel", 99, "ONNX graph optimisation level: 0 disabled, 1 basic, 2 extended, 99 all"};
+  Configurable<int> cfgInterOpNumThreads{"interOpNumThreads", 0, "Number of threads used by ONNX runtime to run independent operators in parallel (0: sequential execution)"};
+  Configurable<std::string> cfgExecutionProviders{"executionProviders", "", "Comma-separated ONNX execution providers to try, e.g. XNNPACK, the unavailable ones are skipped"};
+  Configurable<std::string> cfgModelVariant{"modelVariant", "", "Quantised variant of the models, e.g. int8 or fp16, read from the files and CCDB paths with the _<variant> suffix (empty for FP32)"};
+
+  o2::common::OnnxSessionConfig sessionConfig;
 
   o2::ccdb::CcdbApi ccdbApi;
   int currentRunNumber = -1;
@@ -67,42 +74,57 @@ struct SimpleApplyOnnxInterface {
 
   void init(InitContext const&)
   {
+    sessionConfig.optimizationLevel = cfgOptimizationLevel;
+    sessionConfig.intraOpNumThreads = cfgIntraOpNumThreads;
+    sessionConfig.interOpNumThreads = cfgInterOpNumThreads;
+    sessionConfig.executionProviders = cfgExecutionProviders;
+    sessionConfig.modelVariant = cfgModelVariant;
     if (cfgUseCCDB) {
       ccdbApi.init(cfgCCDBURL);
     } else {
-      pidInterface = PidONNXInterface(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, -1, cfgPids.value, cfgPTCuts.value, cfgCertainties.value, cfgAutoMode.value);
+      pidInterface = PidONNXInterface(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, -1, cfgPids.value, cfgPTCuts.value, cfgCertainties.value, cfgAutoMode.value, sessionConfig);
     }
   }
 
-  void processCollisions(aod::Collisions const& collisions, BigTracks const& tracks, aod::BCsWithTimestamps const&)
+  // Decisions of the batched evaluation, one vector per pid
+  std::vector<std::vector<bool>> acceptedPerPid;
+
+  template <typename T>
+  void fillResults(const T& tracks)
   {
-    auto bc = collisions.iteratorAt(0).bc_as<aod::BCsWithTimestamps>();
-    if (cfgUseCCDB && bc.runNumber() != currentRunNumber) {
-      uint64_t timestamp = cfgUseFixedTimestamp ? cfgTimestamp.value : bc.timestamp();
-      pidInterface = PidONNXInterface(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, timestamp, cfgPids.value, cfgPTCuts.value, cfgCertainties.value, cfgAutoMode.value);
+    // All the tracks are evaluated at once for each pid, the results are then written per track as before
+    acceptedPerPid.resize(cfgPids.value.size());
+    for (std::size_t iPid = 0; iPid < cfgPids.value.size(); iPid++) {
+      pidInterface.applyModelBoolean(tracks, cfgPids.value[iPid], acceptedPerPid[iPid]);
     }
-
+    std::size_t iTrack = 0;
     for (auto& track : tracks) {
-      for (int pid : cfgPids.value) {
-        bool accepted = pidInterface.applyModelBoolean(track, pid);
+      for (std::size_t iPid = 0; iPid < cfgPids.value.size(); iPid++) {
+        int pid = cfgPids.value[iPid];
+        bool accepted = acceptedPerPid[iPid][iTrack];
         LOGF(info, "collision id: %d track id: %d pid: %d accepted: %d p: %.3f; x: %.3f, y: %.3f, z: %.3f",
              track.collisionId(), track.index(), pid, accepted, track.p(), track.x(), track.y(), track.z());
         pidMLResults(track.index(), pid, accepted);
       }
+      iTrack++;
+    }
+  }
+
+  void processCollisions(aod::Collisions const& collisions, BigTracks const& tracks, aod::BCsWithTimestamps const&)
+  {
+    auto bc = collisions.iteratorAt(0).bc_as<aod::BCsWithTimestamps>();
+    if (cfgUseCCDB && bc.runNumber() != currentRunNumber) {
+      uint64_t timestamp = cfgUseFixedTimestamp ? cfgTimestamp.value : bc.timestamp();
+      pidInterface = PidONNXInterface(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, timestamp, cfgPids.value, cfgPTCuts.value, cfgCertainties.value, cfgAutoMode.value, sessionConfig);
     }
+
+    fillResults(tracks);
   }
   PROCESS_SWITCH(SimpleApplyOnnxInterface, processCollisions, "Process with collisions and bcs for CCDB", true);
 
   void processTracksOnly(BigTracks const& tracks)
   {
-    for (auto& track : tracks) {
-      for (int pid : cfgPids.value) {
-        bool accepted = pidInterface.applyModelBoolean(track, pid);
-        LOGF(info, "collision id: %d track id: %d pid: %d accepted: %d p: %.3f; x: %.3f, y: %.3f, z: %.3f",
-             track.collisionId(), track.index(), pid, accepted, track.p(), track.x(), track.y(), track.z());
-        pidMLResults(track.index(), pid, accepted);
-      }
-    }
+    fillResults(tracks);
   }
   PROCESS_SWITCH(SimpleApplyOnnxInterface, processTracksOnly, "Process with tracks only -- faster but no CCDB", false);
 };
@@ -51,6 +51,13 @@ struct SimpleApplyOnnxModel {
 
   Configurable<bool> cfgUseFixedTimestamp{"use-fixed-timestamp", false, "Whether to use fixed timestamp from configurable instead of timestamp calculated from the data"};
   Configurable<uint64_t> cfgTimestamp{"timestamp", 1524176895000, "Hardcoded timestamp for tests"};
+  Configurable<int> cfgIntraOpNumThreads{"intraOpNumThreads", 0, "Number of threads used by ONNX runtime inside one inference call (0: ONNX runtime default)"};
+  Configurable<int> cfgOptimizationLevel{"optimizationLevel", 99, "ONNX graph optimisation level: 0 disabled, 1 basic, 2 extended, 99 all"};
+  Configurable<int> cfgInterOpNumThreads{"interOpNumThreads", 0, "Number of threads used by ONNX runtime to run independent operators in parallel (0: sequential execution)"};
+  Configurable<std::string> cfgExecutionProviders{"executionProviders", "", "Comma-separated ONNX execution providers to try, e.g. XNNPACK, the unavailable ones are skipped"};
+  Configurable<std::string> cfgModelVariant{"modelVariant", "", "Quantised variant of the models, e.g. int8 or fp16, read from the files and CCDB paths with the _<variant> suffix (empty for FP32)"};
+
+  o2::common::OnnxSessionConfig sessionConfig;
 
   o2::ccdb::CcdbApi ccdbApi;
   int currentRunNumber = -1;
@@ -65,10 +72,15 @@ struct SimpleApplyOnnxModel {
 
   void init(InitContext const&)
   {
+    sessionConfig.optimizationLevel = cfgOptimizationLevel;
+    sessionConfig.intraOpNumThreads = cfgIntraOpNumThreads;
+    sessionConfig.interOpNumThreads = cfgInterOpNumThreads;
+    sessionConfig.executionProviders = cfgExecutionProviders;
+    sessionConfig.modelVariant = cfgModelVariant;
     if (cfgUseCCDB) {
       ccdbApi.init(cfgCCDBURL);
     } else {
-      pidModel = PidONNXModel(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, -1, cfgPid.value, static_cast<PidMLDetector>(cfgDetector.value), cfgCertainty.value);
+      pidModel = PidONNXModel(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, -1, cfgPid.value, static_cast<PidMLDetector>(cfgDetector.value), cfgCertainty.value, sessionConfig);
     }
   }
 
@@ -77,7 +89,7 @@ struct SimpleApplyOnnxModel {
     auto bc = collisions.iteratorAt(0).bc_as<aod::BCsWithTimestamps>();
     if (cfgUseCCDB && bc.runNumber() != currentRunNumber) {
       uint64_t timestamp = cfgUseFixedTimestamp ? cfgTimestamp.value : bc.timestamp();
-      pidModel = PidONNXModel(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, timestamp, cfgPid.value, static_cast<PidMLDetector>(cfgDetector.value), cfgCertainty.value);
+      pidModel = PidONNXModel(cfgPathLocal.value, cfgPathCCDB.value, cfgUseCCDB.value, ccdbApi, timestamp, cfgPid.value, static_cast<PidMLDetector>(cfgDetector.value), cfgCertainty.value, sessionConfig);
     }
 
     for (auto& track : tracks) {
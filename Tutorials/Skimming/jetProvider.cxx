@@ -19,6 +19,7 @@
 #include "DataModel/JEDerived.h"
 #include "PWGJE/DataModel/Jet.h"
 #include "PWGJE/Core/JetFinder.h"
+#include "Common/Core/Skimmer.h"
 
 using namespace o2;
 using namespace o2::framework;
@@ -36,24 +37,30 @@ struct JetProviderTask {
   Configurable<bool> DoConstSub{"DoConstSub", false, "do constituent subtraction"};
   Filter jetCuts = aod::jet::pt > jetPtMin;
 
-  void process(soa::Filtered<aod::Jets>::iterator const& jet,
+  o2::common::SkimIndex jetIndex;
+
+  // the jets of the dataframe are selected by the filter and written in one block,
+  // the constituents follow the kept jets with their index in the derived table
+  void process(soa::Filtered<aod::Jets> const& jets,
                aod::Tracks const& tracks,
                aod::JetTrackConstituents const& constituents,
                aod::JetConstituentsSub const& constituentsSub)
   {
-    outputJets(jet.pt(), jet.eta(), jet.phi(), jet.energy(), jet.mass(), jet.area());
+    o2::common::skim(
+      outputJets, jets, [](const auto&) { return true; },
+      [](const auto& jet) { return std::make_tuple(jet.pt(), jet.eta(), jet.phi(), jet.energy(), jet.mass(), jet.area()); },
+      jetIndex);
     if (keepConstituents) {
+      auto jetId = [](const auto& constituent) { return constituent.jetId(); };
       if (DoConstSub) {
-        outputConstituents.reserve(constituentsSub.size());
-        for (const auto& constituent : constituentsSub) {
-          outputConstituents(outputJets.lastIndex(), constituent.pt(), constituent.eta(), constituent.phi());
-        }
+        o2::common::skimChildren(outputConstituents, constituentsSub, jetIndex, jetId,
+                                 [](const auto& constituent, int newJetId) { return std::make_tuple(newJetId, constituent.pt(), constituent.eta(), constituent.phi()); });
       } else {
-        outputConstituents.reserve(constituents.size());
-        for (const auto& constituentIndex : constituents) {
-          auto constituent = constituentIndex.track();
-          outputConstituents(outputJets.lastIndex(), constituent.pt(), constituent.eta(), constituent.phi());
-        }
+        o2::common::skimChildren(outputConstituents, constituents, jetIndex, jetId,
+                                 [](const auto& constituentIndex, int newJetId) {
+                                   auto constituent = constituentIndex.track();
+                                   return std::make_tuple(newJetId, constituent.pt(), constituent.eta(), constituent.phi());
+                                 });
       }
     }
   }